@@ -57,11 +57,13 @@ except ImportError:
 LEADER_ONLY = ReplicaSelection_Leader
 CLOSEST_REPLICA = ReplicaSelection_Closest
 FIRST_REPLICA = ReplicaSelection_First
+CLOSEST_NON_VOTER = ReplicaSelection_ClosestNonVoter
 
 cdef dict _replica_selection_policies = {
     'leader': ReplicaSelection_Leader,
     'closest': ReplicaSelection_Closest,
-    'first': ReplicaSelection_First
+    'first': ReplicaSelection_First,
+    'non_voter': ReplicaSelection_ClosestNonVoter
 }
 
 # Read mode enums
@@ -2069,9 +2071,9 @@ cdef class Scanner:
 
         Parameters
         ----------
-        replica_selection : {'leader', 'closest', 'first'}
+        replica_selection : {'leader', 'closest', 'first', 'non_voter'}
           You can also use the constants LEADER_ONLY, CLOSEST_REPLICA,
-          and FIRST_REPLICA
+          FIRST_REPLICA and CLOSEST_NON_VOTER
 
         Returns
         -------
@@ -2758,9 +2760,9 @@ cdef class ScanTokenBuilder:
 
         Parameters
         ----------
-        replica_selection : {'leader', 'closest', 'first'}
+        replica_selection : {'leader', 'closest', 'first', 'non_voter'}
           You can also use the constants LEADER_ONLY, CLOSEST_REPLICA,
-          and FIRST_REPLICA
+          FIRST_REPLICA and CLOSEST_NON_VOTER
 
         Returns
         -------
@@ -542,6 +542,7 @@ cdef extern from "kudu/client/client.h" namespace "kudu::client" nogil:
         ReplicaSelection_Leader " kudu::client::KuduClient::LEADER_ONLY"
         ReplicaSelection_Closest " kudu::client::KuduClient::CLOSEST_REPLICA"
         ReplicaSelection_First " kudu::client::KuduClient::FIRST_REPLICA"
+        ReplicaSelection_ClosestNonVoter " kudu::client::KuduClient::CLOSEST_NON_VOTER"
 
     enum ReadMode" kudu::client::KuduScanner::ReadMode":
         ReadMode_Latest " kudu::client::KuduScanner::READ_LATEST"
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+# Compares two JSON outputs of microbench, e.g. of a baseline build and of a
+# build with a change, and prints the change of the CPU time of each benchmark
+# run by both. Exits with 1 if any benchmark got slower by more than the
+# threshold, so that it can be used to catch regressions in a CI job.
+#
+#   microbench-compare.py [--threshold=0.1] <baseline.json> <new.json>
+
+import argparse
+import json
+import sys
+
+def load(path):
+    with open(path, "r") as f:
+        results = json.load(f)
+    return dict((b["name"], b) for b in results["benchmarks"])
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare the results of two microbench runs.")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="Relative increase of the CPU time considered a regression")
+    parser.add_argument("baseline")
+    parser.add_argument("new")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    new = load(args.new)
+    regressions = []
+    print("%-36s %14s %14s %9s" % ("benchmark", "baseline ns", "new ns", "change"))
+    for name in sorted(baseline.keys()):
+        if name not in new:
+            continue
+        old_ns = baseline[name]["cpu_time"]
+        new_ns = new[name]["cpu_time"]
+        change = (new_ns - old_ns) / old_ns if old_ns > 0 else 0
+        marker = ""
+        if change > args.threshold:
+            regressions.append(name)
+            marker = " REGRESSION"
+        print("%-36s %14.0f %14.0f %+8.1f%%%s" % (name, old_ns, new_ns, change * 100, marker))
+    for name in sorted(set(baseline.keys()) ^ set(new.keys())):
+        print("%-36s only in %s" % (name, args.baseline if name in baseline else args.new))
+
+    if regressions:
+        print("%d benchmark(s) regressed by more than %.0f%%: %s" %
+              (len(regressions), args.threshold * 100, ", ".join(regressions)))
+        return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,723 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Microbenchmarks of the storage kernels: cfile block encoders and decoders,
+// column predicates, bloom filter probes, key encoding, the concurrent B-tree
+// of the MemRowSet, and the serialization of row blocks.
+//
+// Each benchmark runs enough iterations to last --microbench_min_time_sec,
+// and reports the wall and CPU time per iteration along with the throughput.
+// With --microbench_out, the results are also written as JSON in the format
+// of Google Benchmark, so that the results of two versions can be compared
+// with microbench-compare.py or any tool consuming that format.
+//
+//   microbench --microbench_filter='cfile/.*' --microbench_out=before.json
+//   microbench --microbench_filter='cfile/.*' --microbench_out=after.json
+//   microbench-compare.py before.json after.json
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/block_handle.h"
+#include "kudu/cfile/cfile_writer.h"
+#include "kudu/cfile/type_encodings.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/key_encoder.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/rowblock_memory.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/common/wire_protocol.h"
+#include "kudu/gutil/endian.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/walltime.h"
+#include "kudu/tablet/concurrent_btree.h"
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/env.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/flags.h"
+#include "kudu/util/hash.pb.h"
+#include "kudu/util/jsonwriter.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/random.h"
+#include "kudu/util/rle-encoding.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/version_info.h"
+
+DEFINE_string(microbench_filter, ".*",
+              "Regular expression matching the names of the benchmarks to run");
+DEFINE_double(microbench_min_time_sec, 0.5,
+              "Minimum time to run each benchmark for, in seconds");
+DEFINE_string(microbench_out, "",
+              "If set, the path of a file to write the results to, as JSON");
+DEFINE_bool(microbench_list, false,
+            "List the names of the benchmarks instead of running them");
+
+using kudu::cfile::BlockBuilder;
+using kudu::cfile::BlockDecoder;
+using kudu::cfile::BlockHandle;
+using kudu::cfile::TypeEncodingInfo;
+using kudu::cfile::WriterOptions;
+using kudu::tablet::btree::BTreeTraits;
+using kudu::tablet::btree::CBTree;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+namespace {
+
+// The number of values processed by each iteration of most benchmarks.
+constexpr int kNumValues = 64 * 1024;
+
+// The state of a benchmark, which runs 'iterations()' iterations of the
+// kernel it measures.
+class BenchmarkState {
+ public:
+  explicit BenchmarkState(int64_t iterations)
+      : iterations_(iterations),
+        sw_(Stopwatch::THIS_THREAD) {
+    sw_.start();
+  }
+
+  int64_t iterations() const {
+    return iterations_;
+  }
+
+  // Restarts the timer, e.g. once the data of the benchmark is set up.
+  void ResetTimer() {
+    sw_.stop();
+    sw_.start();
+  }
+
+  // Sets the number of items or bytes processed by each iteration.
+  void SetItemsPerIteration(int64_t items) {
+    items_per_iteration_ = items;
+  }
+  void SetBytesPerIteration(int64_t bytes) {
+    bytes_per_iteration_ = bytes;
+  }
+
+  void Stop() {
+    sw_.stop();
+  }
+
+  CpuTimes elapsed() const {
+    return sw_.elapsed();
+  }
+  int64_t items_per_iteration() const {
+    return items_per_iteration_;
+  }
+  int64_t bytes_per_iteration() const {
+    return bytes_per_iteration_;
+  }
+
+ private:
+  const int64_t iterations_;
+  Stopwatch sw_;
+  int64_t items_per_iteration_ = 0;
+  int64_t bytes_per_iteration_ = 0;
+};
+
+struct Benchmark {
+  string name;
+  std::function<void(BenchmarkState*)> func;
+};
+
+struct BenchmarkResult {
+  string name;
+  int64_t iterations;
+  double real_time_ns;
+  double cpu_time_ns;
+  double items_per_second;
+  double bytes_per_second;
+};
+
+// Keeps the compiler from optimizing away the computation of 'value'.
+template <class T>
+void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+////////////////////////////////////////////////////////////
+// Block encoders and decoders.
+////////////////////////////////////////////////////////////
+
+template <DataType Type>
+vector<typename TypeTraits<Type>::cpp_type> MakeIntValues() {
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  // Small deltas and runs, as in typical timestamp or counter columns.
+  Random rng(1);
+  vector<CppType> values(kNumValues);
+  CppType v = 1000000;
+  for (auto& value : values) {
+    if (!rng.OneIn(4)) {
+      v += rng.Uniform(100);
+    }
+    value = v;
+  }
+  return values;
+}
+
+vector<string> MakeStringValues() {
+  vector<string> values(kNumValues);
+  for (int i = 0; i < kNumValues; i++) {
+    values[i] = Substitute("user$0@example.com", i * 7919 % 100000);
+  }
+  return values;
+}
+
+unique_ptr<BlockBuilder> CreateBlockBuilder(DataType type, EncodingType encoding,
+                                            const WriterOptions* options) {
+  const TypeEncodingInfo* tei;
+  CHECK_OK(TypeEncodingInfo::Get(GetTypeInfo(type), encoding, &tei));
+  unique_ptr<BlockBuilder> bb;
+  CHECK_OK(tei->CreateBlockBuilder(&bb, options));
+  return bb;
+}
+
+unique_ptr<BlockDecoder> CreateBlockDecoder(DataType type, EncodingType encoding,
+                                            scoped_refptr<BlockHandle> block) {
+  const TypeEncodingInfo* tei;
+  CHECK_OK(TypeEncodingInfo::Get(GetTypeInfo(type), encoding, &tei));
+  unique_ptr<BlockDecoder> bd;
+  CHECK_OK(tei->CreateBlockDecoder(&bd, std::move(block), /*parent_cfile_iter=*/nullptr));
+  return bd;
+}
+
+// Adds 'count' cells of 'type' at 'cells' to new blocks, as many as needed,
+// and returns them.
+vector<scoped_refptr<BlockHandle>> EncodeBlocks(DataType type, EncodingType encoding,
+                                                const uint8_t* cells, size_t count) {
+  WriterOptions options;
+  const size_t cell_size = GetTypeInfo(type)->size();
+  vector<scoped_refptr<BlockHandle>> blocks;
+  size_t added = 0;
+  while (added < count) {
+    auto bb = CreateBlockBuilder(type, encoding, &options);
+    while (added < count && !bb->IsBlockFull()) {
+      added += bb->Add(cells + added * cell_size, count - added);
+    }
+    vector<Slice> slices;
+    bb->Finish(0, &slices);
+    faststring buf;
+    for (const auto& s : slices) {
+      buf.append(s.data(), s.size());
+    }
+    const size_t size = buf.size();
+    blocks.emplace_back(BlockHandle::WithOwnedData(Slice(buf.release(), size)));
+  }
+  return blocks;
+}
+
+void BM_Encode(BenchmarkState* state, DataType type, EncodingType encoding,
+               const uint8_t* cells, int64_t bytes) {
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    auto blocks = EncodeBlocks(type, encoding, cells, kNumValues);
+    DoNotOptimize(blocks.size());
+  }
+  state->SetItemsPerIteration(kNumValues);
+  state->SetBytesPerIteration(bytes);
+}
+
+void BM_Decode(BenchmarkState* state, DataType type, EncodingType encoding,
+               const uint8_t* cells, int64_t bytes) {
+  const auto blocks = EncodeBlocks(type, encoding, cells, kNumValues);
+  const TypeInfo* type_info = GetTypeInfo(type);
+  RowBlockMemory memory;
+  faststring dst;
+  dst.resize(type_info->size() * kNumValues);
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    memory.Reset();
+    ColumnBlock cb(type_info, nullptr, dst.data(), kNumValues, &memory);
+    ColumnDataView view(&cb);
+    for (const auto& block : blocks) {
+      auto bd = CreateBlockDecoder(type, encoding, block);
+      CHECK_OK(bd->ParseHeader());
+      while (bd->HasNext()) {
+        size_t n = view.nrows();
+        CHECK_OK(bd->CopyNextValues(&n, &view));
+        view.Advance(n);
+      }
+    }
+    DoNotOptimize(dst.data()[0]);
+  }
+  state->SetItemsPerIteration(kNumValues);
+  state->SetBytesPerIteration(bytes);
+}
+
+template <DataType Type>
+void BM_EncodeInts(BenchmarkState* state, EncodingType encoding) {
+  const auto values = MakeIntValues<Type>();
+  BM_Encode(state, Type, encoding, reinterpret_cast<const uint8_t*>(values.data()),
+            values.size() * sizeof(values[0]));
+}
+
+template <DataType Type>
+void BM_DecodeInts(BenchmarkState* state, EncodingType encoding) {
+  const auto values = MakeIntValues<Type>();
+  BM_Decode(state, Type, encoding, reinterpret_cast<const uint8_t*>(values.data()),
+            values.size() * sizeof(values[0]));
+}
+
+void BM_EncodeStrings(BenchmarkState* state, EncodingType encoding) {
+  const auto values = MakeStringValues();
+  vector<Slice> slices(values.begin(), values.end());
+  int64_t bytes = 0;
+  for (const auto& v : values) {
+    bytes += v.size();
+  }
+  BM_Encode(state, BINARY, encoding, reinterpret_cast<const uint8_t*>(slices.data()), bytes);
+}
+
+void BM_DecodeStrings(BenchmarkState* state, EncodingType encoding) {
+  const auto values = MakeStringValues();
+  vector<Slice> slices(values.begin(), values.end());
+  int64_t bytes = 0;
+  for (const auto& v : values) {
+    bytes += v.size();
+  }
+  BM_Decode(state, BINARY, encoding, reinterpret_cast<const uint8_t*>(slices.data()), bytes);
+}
+
+void BM_RleEncodeBool(BenchmarkState* state) {
+  Random rng(1);
+  vector<bool> values(kNumValues);
+  for (int i = 0; i < kNumValues; i++) {
+    // Runs of random lengths.
+    values[i] = i == 0 ? false : (rng.OneIn(16) ? !values[i - 1] : values[i - 1]);
+  }
+  faststring buf;
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    buf.clear();
+    RleEncoder<bool> encoder(&buf, 1);
+    for (bool v : values) {
+      encoder.Put(v);
+    }
+    DoNotOptimize(encoder.Flush());
+  }
+  state->SetItemsPerIteration(kNumValues);
+}
+
+void BM_RleDecodeBool(BenchmarkState* state) {
+  Random rng(1);
+  faststring buf;
+  RleEncoder<bool> encoder(&buf, 1);
+  bool v = false;
+  for (int i = 0; i < kNumValues; i++) {
+    if (rng.OneIn(16)) {
+      v = !v;
+    }
+    encoder.Put(v);
+  }
+  const int len = encoder.Flush();
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    RleDecoder<bool> decoder(buf.data(), len, 1);
+    size_t decoded = 0;
+    bool val;
+    while (decoded < kNumValues) {
+      const size_t n = decoder.GetNextRun(&val, kNumValues - decoded);
+      if (n == 0) {
+        break;
+      }
+      decoded += n;
+    }
+    DoNotOptimize(decoded);
+  }
+  state->SetItemsPerIteration(kNumValues);
+}
+
+////////////////////////////////////////////////////////////
+// Column predicates.
+////////////////////////////////////////////////////////////
+
+void BM_EvaluatePredicate(BenchmarkState* state, DataType type,
+                          const ColumnPredicate& pred, void* cells) {
+  RowBlockMemory memory;
+  ColumnBlock cb(GetTypeInfo(type), nullptr, cells, kNumValues, &memory);
+  SelectionVector sel(kNumValues);
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    sel.SetAllTrue();
+    pred.Evaluate(cb, &sel);
+    DoNotOptimize(sel.CountSelected());
+  }
+  state->SetItemsPerIteration(kNumValues);
+}
+
+void BM_RangePredicateInt32(BenchmarkState* state) {
+  auto values = MakeIntValues<INT32>();
+  // Select about half of the values.
+  const int32_t lower = values[kNumValues / 4];
+  const int32_t upper = values[kNumValues * 3 / 4];
+  const auto pred = ColumnPredicate::Range(ColumnSchema("c", INT32), &lower, &upper);
+  BM_EvaluatePredicate(state, INT32, pred, values.data());
+}
+
+void BM_EqualityPredicateString(BenchmarkState* state) {
+  const auto values = MakeStringValues();
+  vector<Slice> slices(values.begin(), values.end());
+  const Slice value = slices[kNumValues / 2];
+  const auto pred = ColumnPredicate::Equality(ColumnSchema("c", STRING), &value);
+  BM_EvaluatePredicate(state, STRING, pred, slices.data());
+}
+
+////////////////////////////////////////////////////////////
+// Bloom filters.
+////////////////////////////////////////////////////////////
+
+void BM_BloomFilterProbe(BenchmarkState* state) {
+  // A filter sized for 64K keys, probed half for keys it contains and half for
+  // keys it doesn't.
+  BlockBloomFilter bf(DefaultBlockBloomFilterBufferAllocator::GetSingleton());
+  CHECK_OK(bf.Init(BlockBloomFilter::MinLogSpace(kNumValues, 0.01), FAST_HASH, 0));
+  Random rng(1);
+  vector<uint32_t> hashes(kNumValues);
+  for (int i = 0; i < kNumValues; i++) {
+    hashes[i] = rng.Next32();
+    if (i % 2 == 0) {
+      bf.Insert(hashes[i]);
+    }
+  }
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    int found = 0;
+    for (uint32_t h : hashes) {
+      found += bf.Find(h);
+    }
+    DoNotOptimize(found);
+  }
+  state->SetItemsPerIteration(kNumValues);
+}
+
+////////////////////////////////////////////////////////////
+// Key encoding.
+////////////////////////////////////////////////////////////
+
+void BM_EncodeInt64Keys(BenchmarkState* state) {
+  const auto values = MakeIntValues<INT64>();
+  const auto& encoder = GetKeyEncoder<faststring>(GetTypeInfo(INT64));
+  faststring buf;
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    for (const auto& v : values) {
+      buf.clear();
+      encoder.Encode(&v, &buf);
+    }
+    DoNotOptimize(buf.data()[0]);
+  }
+  state->SetItemsPerIteration(kNumValues);
+}
+
+void BM_EncodeCompositeKeys(BenchmarkState* state) {
+  const auto ints = MakeIntValues<INT64>();
+  const auto strings = MakeStringValues();
+  const auto& string_encoder = GetKeyEncoder<faststring>(GetTypeInfo(STRING));
+  const auto& int_encoder = GetKeyEncoder<faststring>(GetTypeInfo(INT64));
+  faststring buf;
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    for (int j = 0; j < kNumValues; j++) {
+      buf.clear();
+      const Slice s(strings[j]);
+      string_encoder.Encode(&s, /*is_last=*/false, &buf);
+      int_encoder.Encode(&ints[j], /*is_last=*/true, &buf);
+    }
+    DoNotOptimize(buf.data()[0]);
+  }
+  state->SetItemsPerIteration(kNumValues);
+}
+
+////////////////////////////////////////////////////////////
+// Concurrent B-tree.
+////////////////////////////////////////////////////////////
+
+vector<string> MakeBTreeKeys() {
+  Random rng(1);
+  vector<string> keys(kNumValues);
+  for (auto& key : keys) {
+    const uint64_t k = BigEndian::FromHost64(rng.Next64());
+    key.assign(reinterpret_cast<const char*>(&k), sizeof(k));
+  }
+  return keys;
+}
+
+void BM_BTreeInsert(BenchmarkState* state) {
+  const auto keys = MakeBTreeKeys();
+  const string value(16, 'x');
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    CBTree<BTreeTraits> tree;
+    for (const auto& key : keys) {
+      tree.Insert(key, value);
+    }
+  }
+  state->SetItemsPerIteration(kNumValues);
+}
+
+void BM_BTreeLookup(BenchmarkState* state) {
+  const auto keys = MakeBTreeKeys();
+  const string value(16, 'x');
+  CBTree<BTreeTraits> tree;
+  for (const auto& key : keys) {
+    tree.Insert(key, value);
+  }
+  char buf[16];
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    int found = 0;
+    for (const auto& key : keys) {
+      size_t len = sizeof(buf);
+      found += tree.GetCopy(key, buf, &len) == CBTree<BTreeTraits>::GET_SUCCESS;
+    }
+    DoNotOptimize(found);
+  }
+  state->SetItemsPerIteration(kNumValues);
+}
+
+////////////////////////////////////////////////////////////
+// Row block serialization.
+////////////////////////////////////////////////////////////
+
+void BM_SerializeRowBlock(BenchmarkState* state) {
+  constexpr int kNumRows = 8 * 1024;
+  const Schema schema({ ColumnSchema("key", INT64),
+                        ColumnSchema("int_val", INT32),
+                        ColumnSchema("string_val", STRING) }, 1);
+  RowBlockMemory memory;
+  RowBlock block(&schema, kNumRows, &memory);
+  const auto strings = MakeStringValues();
+  int64_t bytes = 0;
+  for (int i = 0; i < kNumRows; i++) {
+    RowBlockRow row = block.row(i);
+    const int64_t key = i;
+    const int32_t int_val = i * 3;
+    memcpy(row.mutable_cell_ptr(0), &key, sizeof(key));
+    memcpy(row.mutable_cell_ptr(1), &int_val, sizeof(int_val));
+    const Slice s(strings[i]);
+    memcpy(row.mutable_cell_ptr(2), &s, sizeof(s));
+    bytes += sizeof(key) + sizeof(int_val) + s.size();
+  }
+  block.selection_vector()->SetAllTrue();
+  faststring data;
+  faststring indirect;
+  state->ResetTimer();
+  for (int64_t i = 0; i < state->iterations(); i++) {
+    data.clear();
+    indirect.clear();
+    DoNotOptimize(SerializeRowBlock(block, &schema, &data, &indirect));
+  }
+  state->SetItemsPerIteration(kNumRows);
+  state->SetBytesPerIteration(bytes);
+}
+
+vector<Benchmark> AllBenchmarks() {
+  vector<Benchmark> benchmarks;
+  const std::pair<EncodingType, const char*> kIntEncodings[] = {
+    { PLAIN_ENCODING, "plain" },
+    { BIT_SHUFFLE, "bitshuffle" },
+    { RLE, "rle" },
+  };
+  for (const auto& e : kIntEncodings) {
+    const EncodingType encoding = e.first;
+    benchmarks.push_back({ Substitute("cfile/encode/int32/$0", e.second),
+                           [=](BenchmarkState* s) { BM_EncodeInts<INT32>(s, encoding); } });
+    benchmarks.push_back({ Substitute("cfile/decode/int32/$0", e.second),
+                           [=](BenchmarkState* s) { BM_DecodeInts<INT32>(s, encoding); } });
+    benchmarks.push_back({ Substitute("cfile/encode/int64/$0", e.second),
+                           [=](BenchmarkState* s) { BM_EncodeInts<INT64>(s, encoding); } });
+    benchmarks.push_back({ Substitute("cfile/decode/int64/$0", e.second),
+                           [=](BenchmarkState* s) { BM_DecodeInts<INT64>(s, encoding); } });
+  }
+  const std::pair<EncodingType, const char*> kStringEncodings[] = {
+    { PLAIN_ENCODING, "plain" },
+    { PREFIX_ENCODING, "prefix" },
+  };
+  for (const auto& e : kStringEncodings) {
+    const EncodingType encoding = e.first;
+    benchmarks.push_back({ Substitute("cfile/encode/binary/$0", e.second),
+                           [=](BenchmarkState* s) { BM_EncodeStrings(s, encoding); } });
+    benchmarks.push_back({ Substitute("cfile/decode/binary/$0", e.second),
+                           [=](BenchmarkState* s) { BM_DecodeStrings(s, encoding); } });
+  }
+  benchmarks.push_back({ "rle/encode/bool", &BM_RleEncodeBool });
+  benchmarks.push_back({ "rle/decode/bool", &BM_RleDecodeBool });
+  benchmarks.push_back({ "predicate/range/int32", &BM_RangePredicateInt32 });
+  benchmarks.push_back({ "predicate/equality/string", &BM_EqualityPredicateString });
+  benchmarks.push_back({ "bloom/probe", &BM_BloomFilterProbe });
+  benchmarks.push_back({ "key_encoding/int64", &BM_EncodeInt64Keys });
+  benchmarks.push_back({ "key_encoding/string_int64", &BM_EncodeCompositeKeys });
+  benchmarks.push_back({ "cbtree/insert", &BM_BTreeInsert });
+  benchmarks.push_back({ "cbtree/lookup", &BM_BTreeLookup });
+  benchmarks.push_back({ "serialization/rowwise", &BM_SerializeRowBlock });
+  return benchmarks;
+}
+
+// Runs 'benchmark' with increasing numbers of iterations until a run lasts
+// at least --microbench_min_time_sec.
+BenchmarkResult RunBenchmark(const Benchmark& benchmark) {
+  int64_t iterations = 1;
+  while (true) {
+    BenchmarkState state(iterations);
+    benchmark.func(&state);
+    state.Stop();
+    const CpuTimes elapsed = state.elapsed();
+    const double wall_sec = elapsed.wall_seconds();
+    if (wall_sec >= FLAGS_microbench_min_time_sec || iterations >= 1000000000) {
+      BenchmarkResult r;
+      r.name = benchmark.name;
+      r.iterations = iterations;
+      r.real_time_ns = wall_sec * 1e9 / iterations;
+      r.cpu_time_ns =
+          (elapsed.user_cpu_seconds() + elapsed.system_cpu_seconds()) * 1e9 / iterations;
+      r.items_per_second = wall_sec > 0 ? state.items_per_iteration() * iterations / wall_sec : 0;
+      r.bytes_per_second = wall_sec > 0 ? state.bytes_per_iteration() * iterations / wall_sec : 0;
+      return r;
+    }
+    // Aim a little past the minimum time, growing by at most 10x at a time.
+    const double multiplier = wall_sec > 0
+        ? FLAGS_microbench_min_time_sec * 1.4 / wall_sec
+        : 10;
+    iterations = std::max<int64_t>(iterations + 1,
+                                   iterations * std::min(multiplier, 10.0));
+  }
+}
+
+// Writes 'results' in the JSON format of Google Benchmark.
+Status WriteJson(const vector<BenchmarkResult>& results, const string& path) {
+  std::ostringstream out;
+  JsonWriter jw(&out, JsonWriter::PRETTY);
+  jw.StartObject();
+  jw.String("context");
+  jw.StartObject();
+  jw.String("date");
+  string date;
+  StringAppendStrftime(&date, "%Y-%m-%dT%H:%M:%SZ", time(nullptr), /*local=*/false);
+  jw.String(date);
+  jw.String("kudu_version");
+  jw.String(VersionInfo::GetShortVersionInfo());
+  jw.String("kudu_git_hash");
+  jw.String(VersionInfo::GetGitHash());
+  jw.String("min_time_sec");
+  jw.Double(FLAGS_microbench_min_time_sec);
+  jw.EndObject();
+  jw.String("benchmarks");
+  jw.StartArray();
+  for (const auto& r : results) {
+    jw.StartObject();
+    jw.String("name");
+    jw.String(r.name);
+    jw.String("run_type");
+    jw.String("iteration");
+    jw.String("iterations");
+    jw.Int64(r.iterations);
+    jw.String("real_time");
+    jw.Double(r.real_time_ns);
+    jw.String("cpu_time");
+    jw.Double(r.cpu_time_ns);
+    jw.String("time_unit");
+    jw.String("ns");
+    if (r.items_per_second > 0) {
+      jw.String("items_per_second");
+      jw.Double(r.items_per_second);
+    }
+    if (r.bytes_per_second > 0) {
+      jw.String("bytes_per_second");
+      jw.Double(r.bytes_per_second);
+    }
+    jw.EndObject();
+  }
+  jw.EndArray();
+  jw.EndObject();
+  return WriteStringToFile(Env::Default(), out.str(), path);
+}
+
+int RunMain() {
+  const auto benchmarks = AllBenchmarks();
+  const std::regex filter(FLAGS_microbench_filter);
+  vector<BenchmarkResult> results;
+  for (const auto& benchmark : benchmarks) {
+    if (!std::regex_match(benchmark.name, filter)) {
+      continue;
+    }
+    if (FLAGS_microbench_list) {
+      std::cout << benchmark.name << std::endl;
+      continue;
+    }
+    const BenchmarkResult r = RunBenchmark(benchmark);
+    std::cout << std::left << std::setw(36) << r.name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(0)
+              << r.real_time_ns << " ns"
+              << std::setw(14) << r.cpu_time_ns << " ns cpu"
+              << std::setw(12) << r.iterations << " iters";
+    if (r.items_per_second > 0) {
+      std::cout << std::setw(12) << std::setprecision(2)
+                << r.items_per_second / 1e6 << " M items/s";
+    }
+    if (r.bytes_per_second > 0) {
+      std::cout << std::setw(12) << std::setprecision(2)
+                << r.bytes_per_second / (1024 * 1024) << " MiB/s";
+    }
+    std::cout << std::endl;
+    results.emplace_back(r);
+  }
+  if (!FLAGS_microbench_out.empty() && !FLAGS_microbench_list) {
+    Status s = WriteJson(results, FLAGS_microbench_out);
+    if (!s.ok()) {
+      LOG(ERROR) << "could not write the results: " << s.ToString();
+      return 1;
+    }
+  }
+  return 0;
+}
+
+} // anonymous namespace
+} // namespace kudu
+
+int main(int argc, char** argv) {
+  FLAGS_logtostderr = 1;
+  kudu::ParseCommandLineFlags(&argc, &argv, true);
+  kudu::InitGoogleLoggingSafe(argv[0]);
+  return kudu::RunMain();
+}
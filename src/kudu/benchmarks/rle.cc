@@ -22,6 +22,7 @@
 //
 
 #include <cstddef>
+#include <cstdint>
 #include <ostream>
 
 #include <gflags/gflags.h>
@@ -93,6 +94,41 @@ int BooleanRLE(faststring* buffer) {
   return bytes_written;
 }
 
+// Measure decoding mostly literal runs of RLE values, either a value at a time
+// or in batches as the RLE block decoders do. Returns the sum of the values.
+template<typename T>
+uint64_t RLEValues(int bit_width, bool batch) {
+  constexpr int kNumValues = 1024 * 1024;
+  constexpr int kBatchSize = 1024;
+  constexpr int kNumIters = 100;
+
+  // Reserve the buffer up front: BitWriter grows it by the bytes it writes.
+  faststring buffer(kNumValues * (sizeof(T) + 1));
+  RleEncoder<T> encoder(&buffer, bit_width);
+  for (auto i = 0; i < kNumValues; ++i) {
+    // Short runs only, so that the values are literal-encoded.
+    encoder.Put(static_cast<T>((i * 7 / 3) & ((1ULL << bit_width) - 1)));
+  }
+  encoder.Flush();
+
+  uint64_t sum = 0;
+  T values[kBatchSize];
+  for (auto iter = 0; iter < kNumIters; ++iter) {
+    RleDecoder<T> decoder(buffer.data(), encoder.len(), bit_width);
+    for (auto i = 0; i < kNumValues; i += kBatchSize) {
+      if (batch) {
+        CHECK_EQ(kBatchSize, decoder.GetValues(values, kBatchSize));
+      } else {
+        for (auto j = 0; j < kBatchSize; ++j) {
+          CHECK(decoder.Get(&values[j]));
+        }
+      }
+      sum += values[kBatchSize - 1];
+    }
+  }
+  return sum;
+}
+
 int BitUtilCeil(int num_iter) {
   volatile int res = 0;
   for (int i = 0; i < num_iter; ++i) {
@@ -138,6 +174,22 @@ int main(int argc, char** argv) {
     LOG(INFO) << "Wrote " << bytes_written << " bytes";
   }
 
+  for (bool batch : { false, true }) {
+    uint64_t res = 0;
+    LOG_TIMING(INFO, batch ? "BooleanRLEGetValues" : "BooleanRLEGet") {
+      res = kudu::RLEValues<bool>(1, batch);
+    }
+    LOG(INFO) << "Result: " << res;
+    LOG_TIMING(INFO, batch ? "Int32RLEGetValues(bit width 32)" : "Int32RLEGet(bit width 32)") {
+      res = kudu::RLEValues<int32_t>(32, batch);
+    }
+    LOG(INFO) << "Result: " << res;
+    LOG_TIMING(INFO, batch ? "UInt32RLEGetValues(bit width 11)" : "UInt32RLEGet(bit width 11)") {
+      res = kudu::RLEValues<uint32_t>(11, batch);
+    }
+    LOG(INFO) << "Result: " << res;
+  }
+
   {
     int res = 0;
     LOG_TIMING(INFO, "BitUtil::Ceil(..., 8)") {
@@ -30,6 +30,7 @@
 #include "kudu/benchmarks/tpch/tpch-schemas.h"
 #include "kudu/client/callbacks.h"
 #include "kudu/client/client.h"
+#include "kudu/client/resource_metrics.h"
 #include "kudu/client/scan_predicate.h"
 #include "kudu/client/schema.h"
 #include "kudu/client/value.h"
@@ -190,6 +191,12 @@ void RpcLineItemDAO::OpenScanner(const vector<string>& columns,
   OpenScannerImpl(columns, preds, out_scanner);
 }
 
+void RpcLineItemDAO::OpenScanner(const vector<string>& columns,
+                                 const vector<KuduPredicate*>& preds,
+                                 unique_ptr<Scanner>* out_scanner) {
+  OpenScannerImpl(columns, preds, out_scanner);
+}
+
 void RpcLineItemDAO::OpenTpch1Scanner(unique_ptr<Scanner>* out_scanner) {
   vector<KuduPredicate*> preds;
   preds.push_back(client_table_->NewComparisonPredicate(
@@ -262,4 +269,8 @@ void RpcLineItemDAO::Scanner::GetNext(vector<KuduRowResult> *rows) {
 #pragma GCC diagnostic pop
 }
 
+const client::ResourceMetrics& RpcLineItemDAO::Scanner::resource_metrics() const {
+  return scanner_->GetResourceMetrics();
+}
+
 } // namespace kudu
@@ -33,6 +33,7 @@ namespace kudu {
 
 namespace client {
 class KuduPredicate;
+class ResourceMetrics;
 }
 
 class KuduPartialRow;
@@ -63,6 +64,11 @@ class RpcLineItemDAO {
   // Projects only those column names listed in 'columns'.
   void OpenScanner(const std::vector<std::string>& columns,
                    std::unique_ptr<Scanner>* scanner);
+  // Like above, but also filters with the predicates 'preds', taking
+  // ownership of them.
+  void OpenScanner(const std::vector<std::string>& columns,
+                   const std::vector<client::KuduPredicate*>& preds,
+                   std::unique_ptr<Scanner>* scanner);
   // Calls OpenScanner with the tpch1 query parameters.
   void OpenTpch1Scanner(std::unique_ptr<Scanner>* scanner);
 
@@ -72,6 +78,9 @@ class RpcLineItemDAO {
                                         std::unique_ptr<Scanner>* scanner);
   bool IsTableEmpty();
 
+  // The table, e.g. to build predicates on its columns.
+  client::KuduTable* table() const { return client_table_.get(); }
+
   // TODO(unknown): this wrapper class is of limited utility now that we only
   // have a single "DAO" implementation -- we could just return the KuduScanner
   // to users directly.
@@ -85,6 +94,10 @@ class RpcLineItemDAO {
     // Return the next batch of rows into '*rows'. Any existing data is cleared.
     void GetNext(std::vector<client::KuduRowResult> *rows);
 
+    // The resource metrics of the scan so far, as reported by the tablet
+    // servers.
+    const client::ResourceMetrics& resource_metrics() const;
+
    private:
     friend class RpcLineItemDAO;
     Scanner() {}
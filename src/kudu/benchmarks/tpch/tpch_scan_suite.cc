@@ -0,0 +1,406 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Benchmarking tool running a suite of scan-heavy queries, modeled after
+// TPC-H queries, against the lineitem table, e.g. to compare the scan
+// performance of Kudu versions.
+//
+// The data is loaded from dbgen's lineitem.tbl if the table is empty, then
+// each query is run tpch_num_query_iterations times. For each run, the tool
+// reports the rows returned per second, the bytes the tablet servers read per
+// second, and the CPU time spent by the tablet servers and by the client.
+//
+// Aggregations aren't pushed down to the tablet servers: the queries with a
+// GROUP BY or aggregates compute them on the client side, which adds to the
+// client CPU time.
+//
+// Usage:
+//   tpch_scan_suite -tpch_path_to_data=/tmp/lineitem.tbl
+//                   -tpch_num_tablet_servers=3
+//                   -tpch_num_query_iterations=3
+//                   -tpch_queries=q1,q6
+//
+// By default, it starts its own external mini cluster. Use
+// -tpch_use_mini_cluster=false and -tpch_master_addresses to run against an
+// existing cluster.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/benchmarks/tpch/line_item_tsv_importer.h"
+#include "kudu/benchmarks/tpch/rpc_line_item_dao.h"
+#include "kudu/benchmarks/tpch/tpch-schemas.h"
+#include "kudu/client/client.h"
+#include "kudu/client/resource_metrics.h"
+#include "kudu/client/row_result.h"
+#include "kudu/client/scan_predicate.h"
+#include "kudu/client/schema.h"
+#include "kudu/client/value.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/mini-cluster/external_mini_cluster.h"
+#include "kudu/util/env.h"
+#include "kudu/util/flags.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
+
+namespace kudu {
+class KuduPartialRow;
+}  // namespace kudu
+
+DEFINE_string(tpch_path_to_data, "/tmp/lineitem.tbl",
+              "The full path to the '|' separated file containing the lineitem table.");
+DEFINE_bool(tpch_use_mini_cluster, true,
+            "Create an external mini cluster for the work to be performed against.");
+DEFINE_string(tpch_mini_cluster_base_dir, "/tmp/tpch_scan_suite",
+              "If using a mini cluster, directory for master/ts data.");
+DEFINE_int32(tpch_num_tablet_servers, 3,
+             "If using a mini cluster, the number of tablet servers to start.");
+DEFINE_string(tpch_path_to_ts_flags_file, "",
+              "Path to the file that contains extra flags for the tablet servers if using "
+              "a mini cluster. Doesn't use one by default.");
+DEFINE_string(tpch_master_addresses, "localhost",
+              "Addresses of masters for the cluster to operate on if not using a mini cluster.");
+DEFINE_string(tpch_table_name, "tpch_scan_suite",
+              "Table name to use during the test.");
+DEFINE_int32(tpch_num_buckets, 6,
+             "Number of hash buckets of the lineitem table, if it needs to be created.");
+DEFINE_int32(tpch_max_batch_size, 1000,
+             "Maximum number of inserts/updates to batch at once.  Set to 0 "
+             "to delegate the batching control to the logic of the "
+             "KuduSession running in AUTO_BACKGROUND_MODE flush mode.");
+DEFINE_int32(tpch_test_client_timeout_msec, 30000,
+             "Timeout that will be used for all operations and RPCs.");
+DEFINE_int32(tpch_num_query_iterations, 1, "Number of times each query will be run.");
+DEFINE_string(tpch_queries, "",
+              "Comma-separated list of the queries to run. If empty, runs all of them.");
+
+using kudu::client::KuduPredicate;
+using kudu::client::KuduRowResult;
+using kudu::client::KuduTable;
+using kudu::client::KuduValue;
+using kudu::cluster::ExternalMiniCluster;
+using kudu::cluster::ExternalMiniClusterOptions;
+using std::cout;
+using std::endl;
+using std::string;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+namespace {
+
+// A query of the suite: a scan of the lineitem table, whose rows may be
+// aggregated on the client side.
+struct Query {
+  string name;
+  // The query, in SQL.
+  string sql;
+  vector<string> columns;
+  // Builds the predicates of the query on the columns of 'table'.
+  std::function<vector<KuduPredicate*>(KuduTable* table)> make_predicates;
+  // If set, called on each row returned, to aggregate it.
+  std::function<void(const KuduRowResult& row)> aggregate;
+  // If set, returns the result of the aggregation of the rows, and resets it.
+  std::function<string()> take_result;
+};
+
+vector<Query> BuildQueries() {
+  vector<Query> queries;
+
+  // Pricing summary report: most of the rows, grouped by two low-cardinality
+  // columns.
+  {
+    struct Sums {
+      int64_t quantity = 0;
+      double extended_price = 0;
+      double discounted_price = 0;
+      int64_t count = 0;
+    };
+    auto groups = std::make_shared<unordered_map<string, Sums>>();
+    Query q;
+    q.name = "q1";
+    q.sql = "SELECT l_returnflag, l_linestatus, sum(l_quantity), sum(l_extendedprice), "
+            "sum(l_extendedprice * (1 - l_discount)), count(*) FROM lineitem "
+            "WHERE l_shipdate <= '1998-09-02' GROUP BY l_returnflag, l_linestatus";
+    q.columns = tpch::GetTpchQ1QueryColumns();
+    q.make_predicates = [](KuduTable* table) {
+      return vector<KuduPredicate*>{ table->NewComparisonPredicate(
+          tpch::kShipDateColName, KuduPredicate::LESS_EQUAL,
+          KuduValue::CopyString("1998-09-02")) };
+    };
+    q.aggregate = [groups](const KuduRowResult& row) {
+      Slice return_flag;
+      Slice line_status;
+      int32_t quantity;
+      double extended_price;
+      double discount;
+      CHECK_OK(row.GetString(tpch::kReturnFlagColName, &return_flag));
+      CHECK_OK(row.GetString(tpch::kLineStatusColName, &line_status));
+      CHECK_OK(row.GetInt32(tpch::kQuantityColName, &quantity));
+      CHECK_OK(row.GetDouble(tpch::kExtendedPriceColName, &extended_price));
+      CHECK_OK(row.GetDouble(tpch::kDiscountColName, &discount));
+      auto& sums = (*groups)[return_flag.ToString() + line_status.ToString()];
+      sums.quantity += quantity;
+      sums.extended_price += extended_price;
+      sums.discounted_price += extended_price * (1 - discount);
+      sums.count++;
+    };
+    q.take_result = [groups]() {
+      string result = Substitute("$0 groups", groups->size());
+      groups->clear();
+      return result;
+    };
+    queries.emplace_back(std::move(q));
+  }
+
+  // Forecasting revenue change: selective range filters on three columns.
+  {
+    auto revenue = std::make_shared<double>(0);
+    Query q;
+    q.name = "q6";
+    q.sql = "SELECT sum(l_extendedprice * l_discount) FROM lineitem "
+            "WHERE l_shipdate >= '1994-01-01' AND l_shipdate < '1995-01-01' "
+            "AND l_discount BETWEEN 0.05 AND 0.07 AND l_quantity < 24";
+    q.columns = { tpch::kExtendedPriceColName, tpch::kDiscountColName };
+    q.make_predicates = [](KuduTable* table) {
+      return vector<KuduPredicate*>{
+        table->NewComparisonPredicate(tpch::kShipDateColName, KuduPredicate::GREATER_EQUAL,
+                                      KuduValue::CopyString("1994-01-01")),
+        table->NewComparisonPredicate(tpch::kShipDateColName, KuduPredicate::LESS,
+                                      KuduValue::CopyString("1995-01-01")),
+        table->NewComparisonPredicate(tpch::kDiscountColName, KuduPredicate::GREATER_EQUAL,
+                                      KuduValue::FromDouble(0.05)),
+        table->NewComparisonPredicate(tpch::kDiscountColName, KuduPredicate::LESS_EQUAL,
+                                      KuduValue::FromDouble(0.07)),
+        table->NewComparisonPredicate(tpch::kQuantityColName, KuduPredicate::LESS,
+                                      KuduValue::FromInt(24)),
+      };
+    };
+    q.aggregate = [revenue](const KuduRowResult& row) {
+      double extended_price;
+      double discount;
+      CHECK_OK(row.GetDouble(tpch::kExtendedPriceColName, &extended_price));
+      CHECK_OK(row.GetDouble(tpch::kDiscountColName, &discount));
+      *revenue += extended_price * discount;
+    };
+    q.take_result = [revenue]() {
+      string result = Substitute("revenue $0", *revenue);
+      *revenue = 0;
+      return result;
+    };
+    queries.emplace_back(std::move(q));
+  }
+
+  // Shipping modes: an IN-list filter on a string column.
+  {
+    Query q;
+    q.name = "q12_scan";
+    q.sql = "SELECT l_orderkey, l_shipmode, l_commitdate, l_receiptdate FROM lineitem "
+            "WHERE l_shipmode IN ('MAIL', 'SHIP') AND l_receiptdate >= '1994-01-01' "
+            "AND l_receiptdate < '1995-01-01'";
+    q.columns = { tpch::kOrderKeyColName, tpch::kShipModeColName,
+                  tpch::kCommitDateColName, tpch::kReceiptDateColName };
+    q.make_predicates = [](KuduTable* table) {
+      vector<KuduValue*> modes = { KuduValue::CopyString("MAIL"),
+                                   KuduValue::CopyString("SHIP") };
+      return vector<KuduPredicate*>{
+        table->NewInListPredicate(tpch::kShipModeColName, &modes),
+        table->NewComparisonPredicate(tpch::kReceiptDateColName, KuduPredicate::GREATER_EQUAL,
+                                      KuduValue::CopyString("1994-01-01")),
+        table->NewComparisonPredicate(tpch::kReceiptDateColName, KuduPredicate::LESS,
+                                      KuduValue::CopyString("1995-01-01")),
+      };
+    };
+    queries.emplace_back(std::move(q));
+  }
+
+  // A primary key range: only reads a small part of the tablets.
+  {
+    Query q;
+    q.name = "key_range";
+    q.sql = "SELECT * FROM lineitem WHERE l_orderkey BETWEEN 1 AND 60000";
+    const auto schema = tpch::CreateLineItemSchema();
+    for (int i = 0; i < schema.num_columns(); i++) {
+      q.columns.emplace_back(schema.Column(i).name());
+    }
+    q.make_predicates = [](KuduTable* table) {
+      return vector<KuduPredicate*>{
+        table->NewComparisonPredicate(tpch::kOrderKeyColName, KuduPredicate::GREATER_EQUAL,
+                                      KuduValue::FromInt(1)),
+        table->NewComparisonPredicate(tpch::kOrderKeyColName, KuduPredicate::LESS_EQUAL,
+                                      KuduValue::FromInt(60000)),
+      };
+    };
+    queries.emplace_back(std::move(q));
+  }
+
+  // A full scan of all the columns.
+  {
+    Query q;
+    q.name = "wide";
+    q.sql = "SELECT * FROM lineitem";
+    const auto schema = tpch::CreateLineItemSchema();
+    for (int i = 0; i < schema.num_columns(); i++) {
+      q.columns.emplace_back(schema.Column(i).name());
+    }
+    q.make_predicates = [](KuduTable* /*table*/) { return vector<KuduPredicate*>(); };
+    queries.emplace_back(std::move(q));
+  }
+
+  // A full scan of none of the columns, i.e. counting the rows.
+  {
+    Query q;
+    q.name = "count";
+    q.sql = "SELECT count(*) FROM lineitem";
+    q.make_predicates = [](KuduTable* /*table*/) { return vector<KuduPredicate*>(); };
+    queries.emplace_back(std::move(q));
+  }
+
+  return queries;
+}
+
+void LoadLineItems(const string& path, RpcLineItemDAO* dao) {
+  LineItemTsvImporter importer(path);
+
+  auto f = [&importer](KuduPartialRow* row) { importer.GetNextLine(row); };
+  while (importer.HasNextLine()) {
+    dao->WriteLine(f);
+  }
+  dao->FinishWriting();
+}
+
+void RunQuery(const Query& query, int iteration, RpcLineItemDAO* dao) {
+  unique_ptr<RpcLineItemDAO::Scanner> scanner;
+  int64_t num_rows = 0;
+  Stopwatch sw;
+  sw.start();
+  dao->OpenScanner(query.columns, query.make_predicates(dao->table()), &scanner);
+  vector<KuduRowResult> rows;
+  while (scanner->HasMore()) {
+    scanner->GetNext(&rows);
+    num_rows += rows.size();
+    if (query.aggregate) {
+      for (const auto& row : rows) {
+        query.aggregate(row);
+      }
+    }
+  }
+  sw.stop();
+
+  const CpuTimes client_times = sw.elapsed();
+  const auto& metrics = scanner->resource_metrics();
+  const double wall_sec = std::max(client_times.wall_seconds(), 1e-9);
+  const int64_t bytes_read = metrics.GetMetric("bytes_read");
+  const double server_cpu_sec =
+      static_cast<double>(metrics.GetMetric("cpu_user_nanos") +
+                          metrics.GetMetric("cpu_system_nanos")) / 1e9;
+  cout << Substitute("$0 iter $1: $2 rows in $3 s, $4 rows/s, $5 MB/s read, "
+                     "tserver CPU $6 s, client CPU $7 s, cache hit $8 MB, miss $9 MB",
+                     query.name, iteration, num_rows, wall_sec, num_rows / wall_sec,
+                     bytes_read / wall_sec / (1024 * 1024), server_cpu_sec,
+                     client_times.user_cpu_seconds() + client_times.system_cpu_seconds(),
+                     metrics.GetMetric("cfile_cache_hit_bytes") / (1024 * 1024),
+                     metrics.GetMetric("cfile_cache_miss_bytes") / (1024 * 1024));
+  if (query.take_result) {
+    cout << " (" << query.take_result() << ")";
+  }
+  cout << endl;
+}
+
+} // anonymous namespace
+
+int Run() {
+  unique_ptr<ExternalMiniCluster> cluster;
+  string master_addresses;
+  if (FLAGS_tpch_use_mini_cluster) {
+    Env* env = Env::Default();
+    Status s = env->CreateDir(FLAGS_tpch_mini_cluster_base_dir);
+    CHECK(s.IsAlreadyPresent() || s.ok()) << s.ToString();
+    ExternalMiniClusterOptions opts;
+    opts.num_tablet_servers = FLAGS_tpch_num_tablet_servers;
+    opts.cluster_root = FLAGS_tpch_mini_cluster_base_dir;
+    if (!FLAGS_tpch_path_to_ts_flags_file.empty()) {
+      opts.extra_tserver_flags.push_back("--flagfile=" + FLAGS_tpch_path_to_ts_flags_file);
+    }
+    cluster.reset(new ExternalMiniCluster(std::move(opts)));
+    CHECK_OK(cluster->Start());
+    master_addresses = cluster->leader_master()->bound_rpc_hostport().ToString();
+  } else {
+    master_addresses = FLAGS_tpch_master_addresses;
+  }
+
+  unique_ptr<RpcLineItemDAO> dao(new RpcLineItemDAO(
+      master_addresses, FLAGS_tpch_table_name, FLAGS_tpch_max_batch_size,
+      FLAGS_tpch_test_client_timeout_msec, RpcLineItemDAO::HASH,
+      FLAGS_tpch_num_buckets));
+  dao->Init();
+  if (dao->IsTableEmpty()) {
+    LOG_TIMING(INFO, "loading") {
+      LoadLineItems(FLAGS_tpch_path_to_data, dao.get());
+    }
+  } else {
+    LOG(INFO) << "Data already in place";
+  }
+
+  const vector<string> names = strings::Split(FLAGS_tpch_queries, ",", strings::SkipEmpty());
+  vector<Query> queries = BuildQueries();
+  for (const auto& name : names) {
+    if (std::none_of(queries.begin(), queries.end(),
+                     [&](const Query& q) { return q.name == name; })) {
+      LOG(ERROR) << "Unknown query: " << name;
+      return 1;
+    }
+  }
+  for (const auto& query : queries) {
+    if (!names.empty() && std::find(names.begin(), names.end(), query.name) == names.end()) {
+      continue;
+    }
+    LOG(INFO) << query.name << ": " << query.sql;
+    for (int i = 0; i < FLAGS_tpch_num_query_iterations; i++) {
+      RunQuery(query, i, dao.get());
+    }
+  }
+
+  if (cluster) {
+    cluster->Shutdown();
+  }
+  return 0;
+}
+
+} // namespace kudu
+
+int main(int argc, char** argv) {
+  kudu::ParseCommandLineFlags(&argc, &argv, true);
+  kudu::InitGoogleLoggingSafe(argv[0]);
+  return kudu::Run();
+}
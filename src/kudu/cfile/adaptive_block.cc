@@ -0,0 +1,242 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/adaptive_block.h"
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include "kudu/cfile/cfile.pb.h"
+#include "kudu/cfile/type_encodings.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+const vector<EncodingType>& AdaptiveCandidateEncodings(DataType type) {
+  static const vector<EncodingType> kIntEncodings =
+      { BIT_SHUFFLE, RLE, FRAME_OF_REFERENCE, PLAIN_ENCODING };
+  static const vector<EncodingType> kFixedSizeEncodings = { BIT_SHUFFLE, PLAIN_ENCODING };
+  static const vector<EncodingType> kBoolEncodings = { PLAIN_ENCODING, RLE };
+  static const vector<EncodingType> kBinaryEncodings = { PLAIN_ENCODING, PREFIX_ENCODING, FSST };
+  static const vector<EncodingType> kNoEncodings;
+  switch (type) {
+    case UINT8:
+    case INT8:
+    case UINT16:
+    case INT16:
+    case UINT32:
+    case INT32:
+    case UINT64:
+    case INT64:
+      return kIntEncodings;
+    case INT128:
+    case FLOAT:
+    case DOUBLE:
+      return kFixedSizeEncodings;
+    case BOOL:
+      return kBoolEncodings;
+    case BINARY:
+      return kBinaryEncodings;
+    default:
+      return kNoEncodings;
+  }
+}
+
+////////////////////////////////////////////////////////////
+// Builder
+////////////////////////////////////////////////////////////
+
+AdaptiveBlockBuilder::AdaptiveBlockBuilder(DataType type, const WriterOptions* options)
+    : chosen_(-1) {
+  const TypeInfo* type_info = GetTypeInfo(type);
+  for (EncodingType encoding : AdaptiveCandidateEncodings(type)) {
+    const TypeEncodingInfo* encoding_info;
+    CHECK_OK(TypeEncodingInfo::Get(type_info, encoding, &encoding_info));
+    Candidate candidate;
+    candidate.encoding = encoding;
+    CHECK_OK(encoding_info->CreateBlockBuilder(&candidate.builder, options));
+    candidate.eligible = true;
+    candidates_.emplace_back(std::move(candidate));
+  }
+  CHECK(!candidates_.empty()) << "no encodings to choose from for type " << DataType_Name(type);
+}
+
+AdaptiveBlockBuilder::~AdaptiveBlockBuilder() = default;
+
+Status AdaptiveBlockBuilder::AppendExtraInfo(CFileWriter* /*c_writer*/, CFileFooterPB* footer) {
+  for (const auto& count : block_counts_) {
+    auto* count_pb = footer->add_block_encoding_counts();
+    count_pb->set_encoding(count.first);
+    count_pb->set_num_blocks(count.second);
+  }
+  return Status::OK();
+}
+
+bool AdaptiveBlockBuilder::IsBlockFull() const {
+  return candidates_[0].builder->IsBlockFull();
+}
+
+int AdaptiveBlockBuilder::Add(const uint8_t* vals, size_t count) {
+  DCHECK_EQ(chosen_, -1);
+  const int added = candidates_[0].builder->Add(vals, count);
+  if (PREDICT_FALSE(added == 0)) {
+    return 0;
+  }
+  for (size_t i = 1; i < candidates_.size(); i++) {
+    Candidate& candidate = candidates_[i];
+    // A builder which didn't take some of the values can't encode the block.
+    if (candidate.eligible && candidate.builder->Add(vals, added) != added) {
+      candidate.eligible = false;
+    }
+  }
+  return added;
+}
+
+void AdaptiveBlockBuilder::Finish(rowid_t ordinal_pos, vector<Slice>* slices) {
+  DCHECK_EQ(chosen_, -1);
+  size_t chosen_size = 0;
+  for (size_t i = 0; i < candidates_.size(); i++) {
+    Candidate& candidate = candidates_[i];
+    if (!candidate.eligible) {
+      continue;
+    }
+    candidate.builder->Finish(ordinal_pos, &candidate.slices);
+    size_t size = 0;
+    for (const Slice& s : candidate.slices) {
+      size += s.size();
+    }
+    // On ties, keep the encoding listed first.
+    if (chosen_ == -1 || size < chosen_size) {
+      chosen_ = static_cast<int>(i);
+      chosen_size = size;
+    }
+  }
+  // The first candidate takes all the values, so it is always eligible.
+  DCHECK_EQ(candidates_[0].eligible, true);
+
+  const Candidate& chosen = candidates_[chosen_];
+  header_[0] = static_cast<uint8_t>(chosen.encoding);
+  slices->clear();
+  slices->reserve(chosen.slices.size() + 1);
+  slices->emplace_back(header_, kHeaderSize);
+  slices->insert(slices->end(), chosen.slices.begin(), chosen.slices.end());
+  ++block_counts_[chosen.encoding];
+}
+
+void AdaptiveBlockBuilder::Reset() {
+  for (Candidate& candidate : candidates_) {
+    candidate.builder->Reset();
+    candidate.eligible = true;
+    candidate.slices.clear();
+  }
+  chosen_ = -1;
+}
+
+size_t AdaptiveBlockBuilder::Count() const {
+  return candidates_[0].builder->Count();
+}
+
+Status AdaptiveBlockBuilder::GetFirstKey(void* key) const {
+  DCHECK_GE(chosen_, 0);
+  return candidates_[chosen_].builder->GetFirstKey(key);
+}
+
+Status AdaptiveBlockBuilder::GetLastKey(void* key) const {
+  DCHECK_GE(chosen_, 0);
+  return candidates_[chosen_].builder->GetLastKey(key);
+}
+
+////////////////////////////////////////////////////////////
+// Decoder
+////////////////////////////////////////////////////////////
+
+AdaptiveBlockDecoder::AdaptiveBlockDecoder(DataType type,
+                                           scoped_refptr<BlockHandle> block,
+                                           CFileIterator* parent_cfile_iter)
+    : type_(type),
+      block_(std::move(block)),
+      parent_cfile_iter_(parent_cfile_iter),
+      encoding_(AUTO_ENCODING) {
+}
+
+AdaptiveBlockDecoder::~AdaptiveBlockDecoder() = default;
+
+Status AdaptiveBlockDecoder::ParseHeader() {
+  const Slice data = block_->data();
+  if (PREDICT_FALSE(data.size() < AdaptiveBlockBuilder::kHeaderSize)) {
+    return Status::Corruption(
+        Substitute("not enough bytes for header: adaptive block header "
+                   "size ($0) less than expected header length ($1)",
+                   data.size(), AdaptiveBlockBuilder::kHeaderSize));
+  }
+  const auto& encodings = AdaptiveCandidateEncodings(type_);
+  const auto encoding = static_cast<EncodingType>(data[0]);
+  if (PREDICT_FALSE(std::find(encodings.begin(), encodings.end(), encoding) ==
+                    encodings.end())) {
+    return Status::Corruption(
+        Substitute("unexpected encoding $0 in adaptive block of type $1",
+                   static_cast<int>(data[0]), DataType_Name(type_)));
+  }
+
+  const TypeEncodingInfo* encoding_info;
+  RETURN_NOT_OK(TypeEncodingInfo::Get(GetTypeInfo(type_), encoding, &encoding_info));
+  unique_ptr<BlockDecoder> inner;
+  RETURN_NOT_OK(encoding_info->CreateBlockDecoder(
+      &inner,
+      block_->SubrangeBlock(AdaptiveBlockBuilder::kHeaderSize,
+                            data.size() - AdaptiveBlockBuilder::kHeaderSize),
+      parent_cfile_iter_));
+  RETURN_NOT_OK(inner->ParseHeader());
+  inner_ = std::move(inner);
+  encoding_ = encoding;
+  return Status::OK();
+}
+
+Status AdaptiveBlockDecoder::CopyNextAndEval(size_t* n,
+                                             ColumnMaterializationContext* ctx,
+                                             SelectionVectorView* sel,
+                                             ColumnDataView* dst) {
+  DCHECK(inner_);
+  ctx->SetDecoderEvalSupported();
+  ColumnMaterializationContext inner_ctx(ctx->col_idx(), ctx->pred(), ctx->block(), ctx->sel());
+  RETURN_NOT_OK(inner_->CopyNextAndEval(n, &inner_ctx, sel, dst));
+  if (inner_ctx.DecoderEvalNotSupported()) {
+    const ColumnPredicate* pred = ctx->pred();
+    const uint8_t* cell = dst->data();
+    for (size_t i = 0; i < *n; i++, cell += dst->stride()) {
+      if (sel->TestBit(i) && !pred->EvaluateCell(type_, cell)) {
+        sel->ClearBit(i);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,190 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Adaptive block encoding.
+//
+// Each block is encoded with every encoding that can be chosen for the
+// column's type, and the smallest of the encoded blocks is written. The
+// encodings needing state shared by the blocks of a cfile, such as the
+// dictionary of DICT_ENCODING, can't be chosen.
+//
+// The block consists of:
+// Header:
+//   encoding (8-bit): the EncodingType of the rest of the block
+// Data:
+//   the block, as encoded with that encoding.
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/block_handle.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowid.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ColumnDataView;
+class ColumnMaterializationContext;
+class SelectionVectorView;
+
+namespace cfile {
+
+class CFileIterator;
+class CFileWriter;
+struct WriterOptions;
+
+// Returns the encodings which may be chosen for the blocks of a column with
+// the physical type 'type'. The first one decides when a block is full.
+const std::vector<EncodingType>& AdaptiveCandidateEncodings(DataType type);
+
+class AdaptiveBlockBuilder final : public BlockBuilder {
+ public:
+  AdaptiveBlockBuilder(DataType type, const WriterOptions* options);
+  ~AdaptiveBlockBuilder() override;
+
+  // Records the number of blocks written with each encoding in the footer.
+  Status AppendExtraInfo(CFileWriter* c_writer, CFileFooterPB* footer) override;
+
+  bool IsBlockFull() const override;
+
+  int Add(const uint8_t* vals, size_t count) override;
+
+  void Finish(rowid_t ordinal_pos, std::vector<Slice>* slices) override;
+
+  void Reset() override;
+
+  size_t Count() const override;
+
+  Status GetFirstKey(void* key) const override;
+
+  Status GetLastKey(void* key) const override;
+
+  // Length of a header.
+  static constexpr size_t kHeaderSize = 1;
+
+ private:
+  struct Candidate {
+    EncodingType encoding;
+    std::unique_ptr<BlockBuilder> builder;
+
+    // Whether all the values added to the block were added to this builder.
+    bool eligible;
+
+    // The block encoded by Finish().
+    std::vector<Slice> slices;
+  };
+
+  std::vector<Candidate> candidates_;
+
+  // Index in 'candidates_' of the encoding chosen by Finish(), or -1 if the
+  // block isn't finished.
+  int chosen_;
+
+  uint8_t header_[kHeaderSize];
+
+  // Number of blocks written with each encoding.
+  std::map<EncodingType, uint32_t> block_counts_;
+};
+
+class AdaptiveBlockDecoder final : public BlockDecoder {
+ public:
+  AdaptiveBlockDecoder(DataType type,
+                       scoped_refptr<BlockHandle> block,
+                       CFileIterator* parent_cfile_iter);
+  ~AdaptiveBlockDecoder() override;
+
+  Status ParseHeader() override;
+
+  void SeekToPositionInBlock(uint pos) override {
+    DCHECK(inner_);
+    inner_->SeekToPositionInBlock(pos);
+  }
+
+  Status SeekAtOrAfterValue(const void* value, bool* exact_match) override {
+    DCHECK(inner_);
+    return inner_->SeekAtOrAfterValue(value, exact_match);
+  }
+
+  void SeekForward(int* n) override {
+    DCHECK(inner_);
+    inner_->SeekForward(n);
+  }
+
+  Status CopyNextValues(size_t* n, ColumnDataView* dst) override {
+    DCHECK(inner_);
+    return inner_->CopyNextValues(n, dst);
+  }
+
+  // Evaluates the predicate with the block's decoder if it supports it, or
+  // on the copied values otherwise: whether the decoder evaluates predicates
+  // must not change from one block of the column to the next.
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) override;
+
+  bool HasNext() const override {
+    DCHECK(inner_);
+    return inner_->HasNext();
+  }
+
+  size_t Count() const override {
+    DCHECK(inner_);
+    return inner_->Count();
+  }
+
+  size_t GetCurrentIndex() const override {
+    DCHECK(inner_);
+    return inner_->GetCurrentIndex();
+  }
+
+  rowid_t GetFirstRowId() const override {
+    DCHECK(inner_);
+    return inner_->GetFirstRowId();
+  }
+
+  // The encoding of the block, once the header is parsed.
+  EncodingType encoding() const {
+    DCHECK(inner_);
+    return encoding_;
+  }
+
+ private:
+  const DataType type_;
+  scoped_refptr<BlockHandle> block_;
+  CFileIterator* parent_cfile_iter_;
+
+  EncodingType encoding_;
+
+  // The decoder of the block's encoding, created by ParseHeader().
+  std::unique_ptr<BlockDecoder> inner_;
+};
+
+} // namespace cfile
+} // namespace kudu
@@ -293,20 +293,53 @@ Status BinaryDictBlockDecoder::CopyNextAndEval(size_t* n,
     return CopyNextDecodeStrings(n, dst);
   }
 
+  // Predicates that match every word in the dictionary return all data too.
+  const size_t num_matching = parent_cfile_iter_->GetNumCodeWordsMatchingPredicate();
+  if (num_matching == dict_decoder_->Count()) {
+    return CopyNextDecodeStrings(n, dst);
+  }
+
   bool retain_dict = false;
 
   // Load the rows' codeword values into a buffer for scanning.
   BShufBlockDecoder<UINT32>* d_bptr = down_cast<BShufBlockDecoder<UINT32>*>(data_decoder_.get());
   codeword_buf_.resize(*n * sizeof(uint32_t));
   d_bptr->CopyNextValuesToArray(n, codeword_buf_.data());
+  const uint32_t* codewords = reinterpret_cast<const uint32_t*>(codeword_buf_.data());
   Slice* out = reinterpret_cast<Slice*>(dst->data());
+
+  if (num_matching == 1) {
+    // A single word matches, as is the case for equality predicates: compare
+    // the codewords against it instead of looking each of them up in the set
+    // of matching codewords, and point every selected cell at the same string.
+    size_t match;
+    CHECK(BitmapFindFirstSet(codewords_matching_pred->bitmap(), 0,
+                             codewords_matching_pred->nrows(), &match));
+    const Slice match_str = dict_decoder_->string_at_index(match);
+    for (size_t i = 0; i < *n; i++) {
+      if (!sel->TestBit(i)) {
+        continue;
+      }
+      if (codewords[i] == match) {
+        out[i] = match_str;
+        retain_dict = true;
+      } else {
+        sel->ClearBit(i);
+      }
+    }
+    if (retain_dict) {
+      dst->memory()->RetainReference(dict_decoder_->block_handle());
+    }
+    return Status::OK();
+  }
+
   for (size_t i = 0; i < *n; i++, out++) {
     // Check with the SelectionVectorView to see whether the data has already
     // been cleared, in which case we can skip evaluation.
     if (!sel->TestBit(i)) {
       continue;
     }
-    uint32_t codeword = *reinterpret_cast<uint32_t*>(&codeword_buf_[i*sizeof(uint32_t)]);
+    uint32_t codeword = codewords[i];
     if (BitmapTest(codewords_matching_pred->bitmap(), codeword)) {
       // Row is included in predicate: point the cell in the block
       // to the entry in the dictionary.
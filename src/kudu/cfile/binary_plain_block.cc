@@ -204,50 +204,13 @@ Status BinaryPlainBlockDecoder::ParseHeader() {
   // with an offset past the last element.
   offsets_buf_.resize(sizeof(uint32_t) * (num_elems_ + 1));
   uint32_t* dst_ptr = reinterpret_cast<uint32_t*>(offsets_buf_.data());
-  size_t rem = num_elems_;
-  while (rem >= 4) {
-    if (PREDICT_TRUE(p + 16 < limit)) {
-      #ifndef __aarch64__
-      p = coding::DecodeGroupVarInt32_SSE(
-          p, &dst_ptr[0], &dst_ptr[1], &dst_ptr[2], &dst_ptr[3]);
-      #else
-      p = coding::DecodeGroupVarInt32_SlowButSafe(
-          p, &dst_ptr[0], &dst_ptr[1], &dst_ptr[2], &dst_ptr[3]);
-      #endif //__aarch64__
-      // The above function should add at most 17 (4 32-bit ints plus a selector byte) to
-      // 'p'. Thus, since we checked that (p + 16 < limit) above, we are guaranteed that
-      // (p <= limit) now.
-
-      DCHECK_LE(p, limit);
-    } else {
-      p = coding::DecodeGroupVarInt32_SlowButSafe(
-          p, &dst_ptr[0], &dst_ptr[1], &dst_ptr[2], &dst_ptr[3]);
-      if (PREDICT_FALSE(p > limit)) {
-        // Only need to check 'p' overrun in the slow path, because 'p' may have
-        // been within 16 bytes of 'limit'.
-        LOG(WARNING) << "bad block: " << HexDump(data_);
-        return Status::Corruption("unable to decode offsets in block");
-      }
-    }
-    dst_ptr += 4;
-    rem -= 4;
-  }
-
-  if (rem > 0) {
-    uint32_t ints[4];
-    p = coding::DecodeGroupVarInt32_SlowButSafe(p, &ints[0], &ints[1], &ints[2], &ints[3]);
-    if (PREDICT_FALSE(p > limit)) {
-      LOG(WARNING) << "bad block: " << HexDump(data_);
-      return Status::Corruption("unable to decode offsets in block");
-    }
-
-    for (int i = 0; i < rem; i++) {
-      *dst_ptr++ = ints[i];
-    }
+  if (PREDICT_FALSE(!coding::DecodeGroupVarInt32Sequence(p, limit, dst_ptr, num_elems_))) {
+    LOG(WARNING) << "bad block: " << HexDump(data_);
+    return Status::Corruption("unable to decode offsets in block");
   }
 
   // Add one extra entry pointing after the last item to make the indexing easier.
-  *dst_ptr++ = offsets_pos;
+  dst_ptr[num_elems_] = offsets_pos;
 
   parsed_ = true;
 
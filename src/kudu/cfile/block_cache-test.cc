@@ -17,19 +17,24 @@
 
 #include "kudu/cfile/block_cache.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <ostream>
 
-#include <gflags/gflags_declare.h>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include "kudu/fs/io_context.h"
 #include "kudu/util/cache.h"
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/slice.h"
 
 DECLARE_double(cache_memtracker_approximation_ratio);
+DECLARE_int32(block_cache_index_capacity_pct);
+DECLARE_string(block_cache_table_partitions);
 
 namespace kudu {
 namespace cfile {
@@ -85,6 +90,118 @@ TEST(TestBlockCache, TestBasics) {
   ASSERT_FALSE(cache.Lookup(key1, Cache::EXPECT_IN_CACHE, &retrieved_handle));
 }
 
+// Insert an index block, then many more data blocks than the cache can hold,
+// and return whether the index block is still cached.
+bool IndexBlockSurvivesDataBlocks(BlockCache* cache) {
+  constexpr size_t kBlockSize = 4096;
+  const BlockCache::FileId id(1234);
+  {
+    const BlockCache::CacheKey key(id, 0);
+    BlockCache::PendingEntry entry =
+        cache->Allocate(key, kBlockSize, BlockCache::BlockType::kIndex);
+    CHECK(entry.valid());
+    memset(entry.val_ptr(), 1, kBlockSize);
+    BlockCacheHandle handle;
+    cache->Insert(&entry, &handle);
+  }
+  for (uint64_t offset = 1; offset <= 8192; ++offset) {
+    const BlockCache::CacheKey key(id, offset * kBlockSize);
+    BlockCache::PendingEntry entry = cache->Allocate(key, kBlockSize);
+    CHECK(entry.valid());
+    memset(entry.val_ptr(), 2, kBlockSize);
+    BlockCacheHandle handle;
+    cache->Insert(&entry, &handle);
+  }
+  BlockCacheHandle handle;
+  return cache->Lookup(BlockCache::CacheKey(id, 0), Cache::EXPECT_IN_CACHE, &handle,
+                       BlockCache::BlockType::kIndex);
+}
+
+// Test that the blocks of indexes and blooms can't be evicted by data blocks
+// when the cache has a partition reserved for them.
+TEST(TestBlockCache, TestIndexPartition) {
+  gflags::FlagSaver saver;
+  // IndexBlockSurvivesDataBlocks() inserts 4 times the capacity of the cache.
+  constexpr size_t kCapacity = 8 * 1024 * 1024;
+  {
+    FLAGS_block_cache_index_capacity_pct = 0;
+    BlockCache cache(kCapacity);
+    ASSERT_FALSE(IndexBlockSurvivesDataBlocks(&cache));
+  }
+  {
+    FLAGS_block_cache_index_capacity_pct = 10;
+    BlockCache cache(kCapacity);
+    ASSERT_TRUE(IndexBlockSurvivesDataBlocks(&cache));
+
+    // The blocks are looked up in the partition of their type.
+    BlockCacheHandle handle;
+    ASSERT_FALSE(cache.Lookup(BlockCache::CacheKey(BlockCache::FileId(1234), 0),
+                              Cache::EXPECT_IN_CACHE, &handle));
+  }
+}
+
+// Test that the blocks of a table with a partition of its own can't be
+// evicted by the blocks of other tables, and can't evict them either.
+TEST(TestBlockCache, TestTablePartitions) {
+  gflags::FlagSaver saver;
+  constexpr size_t kCapacity = 16 * 1024 * 1024;
+  constexpr size_t kBlockSize = 4096;
+  FLAGS_block_cache_table_partitions = "serving:1,scanned+other:2";
+  BlockCache cache(kCapacity);
+  cache.RegisterTablet("serving-tablet", "serving");
+  cache.RegisterTablet("scanned-tablet", "scanned");
+  cache.RegisterTablet("unlisted-tablet", "unlisted");
+  const fs::IOContext serving({ "serving-tablet" });
+  const fs::IOContext scanned({ "scanned-tablet" });
+  const fs::IOContext unlisted({ "unlisted-tablet" });
+
+  const auto insert = [&](uint64_t file_id, uint64_t offset, const fs::IOContext* io_context) {
+    BlockCache::PendingEntry entry = cache.Allocate(
+        BlockCache::CacheKey(BlockCache::FileId(file_id), offset), kBlockSize,
+        BlockCache::BlockType::kData, io_context);
+    CHECK(entry.valid());
+    memset(entry.val_ptr(), 1, kBlockSize);
+    BlockCacheHandle handle;
+    cache.Insert(&entry, &handle);
+  };
+  const auto cached = [&](uint64_t file_id, uint64_t offset, const fs::IOContext* io_context) {
+    BlockCacheHandle handle;
+    return cache.Lookup(BlockCache::CacheKey(BlockCache::FileId(file_id), offset),
+                        Cache::EXPECT_IN_CACHE, &handle, BlockCache::BlockType::kData,
+                        io_context);
+  };
+
+  insert(1, 0, &serving);
+  insert(3, 0, &unlisted);
+  // Scan through 4 times the capacity of the whole cache in the partition
+  // of the 'scanned' table.
+  for (uint64_t offset = 1; offset <= 4 * kCapacity / kBlockSize; ++offset) {
+    insert(2, offset * kBlockSize, &scanned);
+  }
+  ASSERT_TRUE(cached(1, 0, &serving));
+  ASSERT_TRUE(cached(3, 0, &unlisted));
+  // The blocks are looked up in the partition of their table.
+  ASSERT_FALSE(cached(1, 0, &unlisted));
+  ASSERT_TRUE(cached(3, 0, nullptr));
+  ASSERT_FALSE(cached(3, 0, &serving));
+  // The scanned table only kept as many blocks as its partition holds.
+  int num_cached = 0;
+  for (uint64_t offset = 1; offset <= 4 * kCapacity / kBlockSize; ++offset) {
+    num_cached += cached(2, offset * kBlockSize, &scanned) ? 1 : 0;
+  }
+  ASSERT_GT(num_cached, 0);
+  ASSERT_LE(num_cached, 2 * 1024 * 1024 / kBlockSize);
+}
+
+TEST(TestBlockCache, TestInvalidTablePartitions) {
+  for (const char* value : { "t", "t:0", "t:x", ":1", "t:1,t:2", "t+u:1:2" }) {
+    SCOPED_TRACE(value);
+    ASSERT_TRUE(gflags::SetCommandLineOption("block_cache_table_partitions", value).empty());
+  }
+  ASSERT_FALSE(gflags::SetCommandLineOption("block_cache_table_partitions", "t+u:1,v:2").empty());
+  ASSERT_FALSE(gflags::SetCommandLineOption("block_cache_table_partitions", "").empty());
+}
+
 
 } // namespace cfile
 } // namespace kudu
@@ -19,22 +19,35 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <shared_mutex>
 #include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/cfile/secondary_block_cache.h"
+#include "kudu/fs/io_context.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/block_cache_metrics.h"
 #include "kudu/util/cache.h"
 #include "kudu/util/cache_metrics.h"
+#include "kudu/util/env.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
 #include "kudu/util/process_memory.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 #include "kudu/util/string_case.h"
 
 DEFINE_int64(block_cache_capacity_mb, 512, "block cache capacity in MB");
@@ -57,8 +70,155 @@ DEFINE_string(block_cache_type, "DRAM",
               "libmemkind 1.8.0 or newer must be available on the system; "
               "otherwise Kudu will crash.");
 
+DEFINE_string(block_cache_eviction_policy, "LRU",
+              "Which eviction policy to use for the block cache. Valid choices "
+              "are 'LRU' or 'TINYLFU'. 'TINYLFU' only admits the blocks read "
+              "repeatedly into the cache once it's full, so that large scans "
+              "don't evict the working set of the other workloads. Only "
+              "supported with --block_cache_type=DRAM.");
+TAG_FLAG(block_cache_eviction_policy, experimental);
+
+static bool ValidateBlockCacheEvictionPolicy(const char* /*flagname*/,
+                                             const std::string& value) {
+  if (kudu::iequals(value, "LRU") || kudu::iequals(value, "TINYLFU")) {
+    return true;
+  }
+  LOG(ERROR) << "Unknown block cache eviction policy: '" << value
+             << "' (expected 'LRU' or 'TINYLFU')";
+  return false;
+}
+DEFINE_validator(block_cache_eviction_policy, &ValidateBlockCacheEvictionPolicy);
+
+DEFINE_string(block_cache_secondary_path, "",
+              "Path of a file on a fast local device, such as an SSD, to which "
+              "the blocks evicted from the block cache are written, and from which "
+              "they are read back instead of from the data directories. The file "
+              "is truncated on startup. If empty, there is no secondary block cache.");
+TAG_FLAG(block_cache_secondary_path, experimental);
+
+DEFINE_int64(block_cache_secondary_capacity_mb, 16384,
+             "Capacity of the secondary block cache in MB. Only used if "
+             "--block_cache_secondary_path is set.");
+TAG_FLAG(block_cache_secondary_capacity_mb, experimental);
+
+DEFINE_int64(block_cache_secondary_max_pending_mb, 64,
+             "Maximum size in MB of the blocks waiting to be written to the "
+             "secondary block cache. The blocks evicted from the block cache "
+             "while this many are pending are not written.");
+TAG_FLAG(block_cache_secondary_max_pending_mb, advanced);
+TAG_FLAG(block_cache_secondary_max_pending_mb, experimental);
+
+DEFINE_int32(block_cache_index_capacity_pct, 0,
+             "Percentage of the block cache capacity reserved for the blocks "
+             "of CFile indexes and bloom filters. Those blocks are kept in a "
+             "partition of their own, so that data blocks can't evict them, "
+             "e.g. when large scans go through the cache: point lookups and "
+             "insert presence checks read them for almost every operation. "
+             "If 0, the blocks of all types share the whole cache.");
+TAG_FLAG(block_cache_index_capacity_pct, experimental);
+
+static bool ValidateBlockCacheIndexCapacityPct(const char* flagname, int32_t value) {
+  if (value < 0 || value > 90) {
+    LOG(ERROR) << strings::Substitute("$0: invalid value for --$1: must be between 0 and 90",
+                                      value, flagname);
+    return false;
+  }
+  return true;
+}
+DEFINE_validator(block_cache_index_capacity_pct, &ValidateBlockCacheIndexCapacityPct);
+
+DEFINE_string(block_cache_table_partitions, "",
+              "Comma-separated list of partitions of the block cache reserved "
+              "for the blocks of given tables, in the form "
+              "<table id>[+<table id>...]:<capacity in MB>. The blocks of "
+              "the tables of a partition are kept there, so that the other "
+              "tables can't evict them, e.g. to keep the cache warm for "
+              "latency-sensitive tables, and can't take more memory than its "
+              "capacity, e.g. to keep tables read by large scans from taking "
+              "over the cache. The capacity of the partitions is taken from "
+              "the block cache capacity, of which they, together with "
+              "--block_cache_index_capacity_pct, may take at most 90%.");
+TAG_FLAG(block_cache_table_partitions, experimental);
+
+using std::shared_lock;
+using std::string;
+using std::unique_ptr;
+using std::vector;
 using strings::Substitute;
 
+namespace {
+
+// A partition of --block_cache_table_partitions.
+struct TablePartitionSpec {
+  vector<string> table_ids;
+  int64_t capacity_mb;
+};
+
+kudu::Status ParseTablePartitions(const string& value, vector<TablePartitionSpec>* specs) {
+  std::unordered_set<string> table_ids;
+  for (const string& entry : strings::Split(value, ",", strings::SkipEmpty())) {
+    const vector<string> fields = strings::Split(entry, ":");
+    TablePartitionSpec spec;
+    if (fields.size() != 2 || !safe_strto64(fields[1], &spec.capacity_mb) ||
+        spec.capacity_mb <= 0) {
+      return kudu::Status::InvalidArgument(Substitute(
+          "invalid partition '$0': expected <table id>[+<table id>...]:<capacity in MB>",
+          entry));
+    }
+    spec.table_ids = strings::Split(fields[0], "+", strings::SkipEmpty());
+    if (spec.table_ids.empty()) {
+      return kudu::Status::InvalidArgument(Substitute(
+          "invalid partition '$0': no table", entry));
+    }
+    for (const auto& table_id : spec.table_ids) {
+      if (!table_ids.insert(table_id).second) {
+        return kudu::Status::InvalidArgument(Substitute(
+            "table $0 is in more than one partition", table_id));
+      }
+    }
+    specs->emplace_back(std::move(spec));
+  }
+  return kudu::Status::OK();
+}
+
+// Returns the capacity taken by --block_cache_table_partitions, in MB.
+int64_t TablePartitionsCapacityMb() {
+  vector<TablePartitionSpec> specs;
+  CHECK_OK(ParseTablePartitions(FLAGS_block_cache_table_partitions, &specs));
+  int64_t capacity_mb = 0;
+  for (const auto& spec : specs) {
+    capacity_mb += spec.capacity_mb;
+  }
+  return capacity_mb;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(block_cache_table_partitions, [](const char* flagname, const string& value) {
+  vector<TablePartitionSpec> specs;
+  kudu::Status s = ParseTablePartitions(value, &specs);
+  if (!s.ok()) {
+    LOG(ERROR) << Substitute("invalid value for --$0: $1", flagname, s.ToString());
+    return false;
+  }
+  return true;
+});
+
+static bool ValidateBlockCachePartitions() {
+  const int64_t reserved_mb =
+      FLAGS_block_cache_capacity_mb * FLAGS_block_cache_index_capacity_pct / 100 +
+      TablePartitionsCapacityMb();
+  if (reserved_mb * 10 > FLAGS_block_cache_capacity_mb * 9) {
+    LOG(ERROR) << Substitute(
+        "--block_cache_table_partitions and --block_cache_index_capacity_pct reserve "
+        "$0 MB of the block cache, more than 90% of --block_cache_capacity_mb ($1 MB)",
+        reserved_mb, FLAGS_block_cache_capacity_mb);
+    return false;
+  }
+  return true;
+}
+GROUP_FLAG_VALIDATOR(block_cache_table_partitions, ValidateBlockCachePartitions);
+
 template <class T> class scoped_refptr;
 
 namespace kudu {
@@ -69,21 +229,45 @@ namespace cfile {
 
 namespace {
 
-Cache* CreateCache(int64_t capacity) {
+Cache* CreateCache(int64_t capacity, const char* id) {
   const auto mem_type = BlockCache::GetConfiguredCacheMemoryTypeOrDie();
   switch (mem_type) {
     case Cache::MemoryType::DRAM:
+      if (iequals(FLAGS_block_cache_eviction_policy, "TINYLFU")) {
+        return NewCache<Cache::EvictionPolicy::TINYLFU, Cache::MemoryType::DRAM>(
+            capacity, id);
+      }
       return NewCache<Cache::EvictionPolicy::LRU, Cache::MemoryType::DRAM>(
-          capacity, "block_cache");
+          capacity, id);
     case Cache::MemoryType::NVM:
       return NewCache<Cache::EvictionPolicy::LRU, Cache::MemoryType::NVM>(
-          capacity, "block_cache");
+          capacity, id);
     default:
       LOG(FATAL) << "unsupported LRU cache memory type: " << mem_type;
       return nullptr;
   }
 }
 
+unique_ptr<SecondaryBlockCache> CreateSecondaryCache() {
+  if (FLAGS_block_cache_secondary_path.empty()) {
+    return nullptr;
+  }
+  SecondaryBlockCache::Options opts;
+  opts.path = FLAGS_block_cache_secondary_path;
+  opts.capacity_bytes = FLAGS_block_cache_secondary_capacity_mb * 1024 * 1024;
+  opts.max_pending_bytes = FLAGS_block_cache_secondary_max_pending_mb * 1024 * 1024;
+  unique_ptr<SecondaryBlockCache> secondary;
+  Status s = SecondaryBlockCache::Open(Env::Default(), opts, &secondary);
+  if (!s.ok()) {
+    LOG(WARNING) << "Unable to open the secondary block cache, continuing without it: "
+                 << s.ToString();
+    return nullptr;
+  }
+  LOG(INFO) << Substitute("Opened a secondary block cache of $0 MB at $1",
+                          FLAGS_block_cache_secondary_capacity_mb, opts.path);
+  return secondary;
+}
+
 } // anonymous namespace
 
 bool ValidateBlockCacheCapacity() {
@@ -133,32 +317,94 @@ Cache::MemoryType BlockCache::GetConfiguredCacheMemoryTypeOrDie() {
 }
 
 BlockCache::BlockCache()
-    : BlockCache(FLAGS_block_cache_capacity_mb * 1024 * 1024) {
+    : BlockCache(FLAGS_block_cache_capacity_mb * 1024 * 1024, CreateSecondaryCache()) {
 }
 
 BlockCache::BlockCache(size_t capacity)
-    : cache_(CreateCache(capacity)) {
+    : BlockCache(capacity, nullptr) {
+}
+
+BlockCache::BlockCache(size_t capacity, unique_ptr<SecondaryBlockCache> secondary)
+    : secondary_(std::move(secondary)),
+      spill_callback_(secondary_ ? new SpillCallback(secondary_.get()) : nullptr) {
+  const size_t index_capacity = capacity * FLAGS_block_cache_index_capacity_pct / 100;
+  size_t table_capacity = 0;
+  vector<TablePartitionSpec> specs;
+  CHECK_OK(ParseTablePartitions(FLAGS_block_cache_table_partitions, &specs));
+  for (const auto& spec : specs) {
+    const size_t partition_capacity = spec.capacity_mb * 1024 * 1024;
+    table_caches_.emplace_back(CreateCache(partition_capacity, "block_cache_table"));
+    for (const auto& table_id : spec.table_ids) {
+      EmplaceOrDie(&cache_by_table_, table_id, table_caches_.back().get());
+    }
+    table_capacity += partition_capacity;
+  }
+  CHECK_LE((index_capacity + table_capacity) * 10, capacity * 9)
+      << "the block cache partitions take more than 90% of its capacity";
+  cache_.reset(CreateCache(capacity - index_capacity - table_capacity, "block_cache"));
+  if (index_capacity > 0) {
+    index_cache_.reset(CreateCache(index_capacity, "block_cache_index"));
+  }
+}
+
+BlockCache::~BlockCache() = default;
+
+void BlockCache::SpillCallback::EvictedEntry(Slice key, Slice value) {
+  DCHECK_EQ(sizeof(CacheKey), key.size());
+  CacheKey cache_key(FileId(0), 0);
+  memcpy(&cache_key, key.data(), sizeof(cache_key));
+  secondary_->Insert(cache_key, value);
+}
+
+void BlockCache::RegisterTablet(const string& tablet_id, const string& table_id) {
+  Cache* cache = FindPtrOrNull(cache_by_table_, table_id);
+  if (!cache) {
+    return;
+  }
+  std::lock_guard<rw_spinlock> l(tablets_lock_);
+  InsertOrUpdate(&cache_by_tablet_, tablet_id, cache);
+}
+
+Cache* BlockCache::table_cache_for(const fs::IOContext& io_context) const {
+  shared_lock<rw_spinlock> l(tablets_lock_);
+  return FindPtrOrNull(cache_by_tablet_, io_context.tablet_id);
 }
 
-BlockCache::PendingEntry BlockCache::Allocate(const CacheKey& key, size_t block_size) {
+BlockCache::PendingEntry BlockCache::Allocate(const CacheKey& key, size_t block_size,
+                                             BlockType type,
+                                             const fs::IOContext* io_context) {
   Slice key_slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key));
-  return PendingEntry(cache_->Allocate(key_slice, block_size));
+  return PendingEntry(cache_for(type, io_context)->Allocate(key_slice, block_size));
 }
 
 bool BlockCache::Lookup(const CacheKey& key, Cache::CacheBehavior behavior,
-                        BlockCacheHandle* handle) {
-  auto h(cache_->Lookup(
+                        BlockCacheHandle* handle, BlockType type,
+                        const fs::IOContext* io_context) {
+  auto h(cache_for(type, io_context)->Lookup(
       Slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key)), behavior));
   if (h) {
     handle->SetHandle(std::move(h));
     return true;
   }
-  return false;
+  if (!secondary_) {
+    return false;
+  }
+  PendingEntry entry;
+  bool found = secondary_->Lookup(key, [&](size_t block_size) -> uint8_t* {
+    entry = Allocate(key, block_size, type, io_context);
+    return entry.valid() ? entry.val_ptr() : nullptr;
+  });
+  if (!found) {
+    return false;
+  }
+  Insert(&entry, handle);
+  return true;
 }
 
 void BlockCache::Insert(BlockCache::PendingEntry* entry, BlockCacheHandle* inserted) {
-  auto h(cache_->Insert(std::move(entry->handle_),
-                        /* eviction_callback= */ nullptr));
+  // The entry is inserted into the partition it was allocated from.
+  Cache* cache = entry->handle_.get_deleter().cache();
+  auto h(cache->Insert(std::move(entry->handle_), spill_callback_.get()));
   inserted->SetHandle(std::move(h));
 }
 
@@ -166,6 +412,14 @@ void BlockCache::StartInstrumentation(const scoped_refptr<MetricEntity>& metric_
                                       Cache::ExistingMetricsPolicy metrics_policy) {
   std::unique_ptr<BlockCacheMetrics> metrics(new BlockCacheMetrics(metric_entity));
   cache_->SetMetrics(std::move(metrics), metrics_policy);
+  if (index_cache_) {
+    index_cache_->SetMetrics(unique_ptr<IndexBlockCacheMetrics>(
+        new IndexBlockCacheMetrics(metric_entity)), metrics_policy);
+  }
+  if (secondary_) {
+    secondary_->SetMetrics(unique_ptr<SecondaryBlockCacheMetrics>(
+        new SecondaryBlockCacheMetrics(metric_entity)));
+  }
 }
 
 } // namespace cfile
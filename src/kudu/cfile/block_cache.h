@@ -19,13 +19,17 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "kudu/fs/block_id.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/singleton.h"
 #include "kudu/util/cache.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/slice.h"
 
 template <class T> class scoped_refptr;
@@ -34,12 +38,28 @@ namespace kudu {
 
 class MetricEntity;
 
+namespace fs {
+struct IOContext;
+} // namespace fs
+
 namespace cfile {
 
 class BlockCacheHandle;
+class SecondaryBlockCache;
 
 // Wrapper around kudu::Cache specifically for caching blocks of CFiles.
 // Provides a singleton and LRU cache for CFile blocks.
+//
+// If --block_cache_secondary_path is set, the blocks evicted from the cache
+// are spilled to a SecondaryBlockCache on a local device, and the blocks
+// missing from the cache are looked up there before being read from disk.
+//
+// If --block_cache_table_partitions is set, the blocks of the listed tables
+// are kept in partitions of their own, carved out of the capacity of the
+// cache: each partition is both reserved for its tables and the limit on
+// the memory they may use. The tablets of such tables must be registered
+// with RegisterTablet(), and the blocks are looked up and allocated per the
+// tablet of the fs::IOContext of the IO.
 class BlockCache {
  public:
   // Parse the gflag which configures the block cache. FATALs if the flag is
@@ -113,21 +133,46 @@ class BlockCache {
     Cache::UniquePendingHandle handle_;
   };
 
+  // The kind of a cached block, which determines the partition of the cache
+  // holding it. See --block_cache_index_capacity_pct.
+  enum class BlockType {
+    // The blocks of column data, including delta files.
+    kData,
+    // The blocks of CFile indexes and of bloom filters, read by nearly every
+    // point lookup and insert presence check.
+    kIndex,
+  };
+
   static BlockCache* GetSingleton() {
     return Singleton<BlockCache>::get();
   }
 
   explicit BlockCache(size_t capacity);
 
+  // Creates a cache of 'capacity' bytes, spilling its evicted blocks to
+  // 'secondary' if it's not null.
+  BlockCache(size_t capacity, std::unique_ptr<SecondaryBlockCache> secondary);
+
+  ~BlockCache();
+
   // Lookup the given block in the cache.
   //
   // If the entry is found, then sets *handle to refer to the entry.
   // This object's destructor will release the cache entry so it may be freed again.
   // Alternatively,  handle->Release() may be used to explicitly release it.
   //
+  // If the entry is missing from the cache but found in the secondary cache,
+  // it's read back into the cache.
+  //
+  // 'type' must be the type the block was allocated with.
+  //
   // Returns true to indicate that the entry was found, false otherwise.
+  //
+  // 'io_context', if not null, determines the partition of the table
+  // the block belongs to, if any.
   bool Lookup(const CacheKey& key, Cache::CacheBehavior behavior,
-              BlockCacheHandle* handle);
+              BlockCacheHandle* handle, BlockType type = BlockType::kData,
+              const fs::IOContext* io_context = nullptr);
 
   // Pass a metric entity to the cache to start recording metrics.
   // This should be called before the block cache starts serving blocks.
@@ -155,20 +200,78 @@ class BlockCache {
   //   BlockCacheHandle bch;
   //   cache->Insert(&entry, &bch);
 
-  // Allocate a new entry to be inserted into the cache.
-  PendingEntry Allocate(const CacheKey& key, size_t block_size);
+  // Allocate a new entry to be inserted into the cache, in the partition
+  // corresponding to 'type', or to the table of the tablet of 'io_context'.
+  PendingEntry Allocate(const CacheKey& key, size_t block_size,
+                        BlockType type = BlockType::kData,
+                        const fs::IOContext* io_context = nullptr);
 
-  // Insert the given block into the cache. 'inserted' is set to refer to the
-  // entry in the cache.
+  // Insert the given block into the cache, in the partition it was allocated
+  // from. 'inserted' is set to refer to the entry in the cache.
   void Insert(PendingEntry* entry, BlockCacheHandle* inserted);
 
+  // Returns the secondary cache, or nullptr if there is none.
+  SecondaryBlockCache* secondary_cache() const {
+    return secondary_.get();
+  }
+
+  // Records that the tablet 'tablet_id' belongs to the table 'table_id', so
+  // that its blocks go to the partition of the table, if it has one.
+  // Otherwise, this is a no-op.
+  void RegisterTablet(const std::string& tablet_id, const std::string& table_id);
+
  private:
   friend class Singleton<BlockCache>;
   BlockCache();
 
+  // Writes the blocks evicted from 'cache_' to the secondary cache.
+  class SpillCallback : public Cache::EvictionCallback {
+   public:
+    explicit SpillCallback(SecondaryBlockCache* secondary)
+        : secondary_(secondary) {
+    }
+    void EvictedEntry(Slice key, Slice value) override;
+
+   private:
+    SecondaryBlockCache* const secondary_;
+  };
+
   DISALLOW_COPY_AND_ASSIGN(BlockCache);
 
+  // Returns the partition of the cache holding the blocks of type 'type'
+  // read on behalf of 'io_context'.
+  Cache* cache_for(BlockType type, const fs::IOContext* io_context) const {
+    if (PREDICT_FALSE(!table_caches_.empty()) && io_context) {
+      Cache* table_cache = table_cache_for(*io_context);
+      if (table_cache) {
+        return table_cache;
+      }
+    }
+    return type == BlockType::kIndex && index_cache_ ? index_cache_.get() : cache_.get();
+  }
+
+  // Returns the partition of the table of the tablet of 'io_context',
+  // or nullptr if it has none.
+  Cache* table_cache_for(const fs::IOContext& io_context) const;
+
+  // The secondary cache and the eviction callback must outlive 'cache_',
+  // whose destruction evicts all of its entries.
+  std::unique_ptr<SecondaryBlockCache> secondary_;
+  std::unique_ptr<SpillCallback> spill_callback_;
   std::unique_ptr<Cache> cache_;
+  // The partition for index and bloom blocks, so that data blocks, e.g.
+  // read by large scans, can't evict them. Null if the blocks of all types
+  // share 'cache_'.
+  std::unique_ptr<Cache> index_cache_;
+
+  // The partitions of --block_cache_table_partitions, and the partition of
+  // each of their tables, keyed by table ID. Constant after construction.
+  std::vector<std::unique_ptr<Cache>> table_caches_;
+  std::unordered_map<std::string, Cache*> cache_by_table_;
+
+  // The partition of each registered tablet of the tables above.
+  mutable rw_spinlock tablets_lock_;
+  std::unordered_map<std::string, Cache*> cache_by_tablet_;
 };
 
 // Scoped reference to a block from the block cache.
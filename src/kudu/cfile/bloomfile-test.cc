@@ -44,6 +44,7 @@ DECLARE_double(fp_rate);
 
 DECLARE_int64(benchmark_queries);
 DECLARE_bool(benchmark_should_hit);
+DECLARE_bool(cfile_split_block_bloom_filters);
 
 using kudu::fs::CountingReadableBlock;
 using kudu::fs::ReadableBlock;
@@ -94,6 +95,23 @@ TEST_F(BloomFileTest, TestWriteAndRead) {
   VerifyBloomFile();
 }
 
+// Test that split-block bloom files are sized to the same false positive rate,
+// and that files of either format can be read regardless of the flag.
+TEST_F(BloomFileTest, TestSplitBlockWriteAndRead) {
+  FLAGS_cfile_split_block_bloom_filters = true;
+  NO_FATALS(WriteTestBloomFile());
+  ASSERT_OK(OpenBloomFile());
+  NO_FATALS(VerifyBloomFile());
+
+  FLAGS_cfile_split_block_bloom_filters = false;
+  ASSERT_OK(OpenBloomFile());
+  NO_FATALS(VerifyBloomFile());
+  NO_FATALS(WriteTestBloomFile());
+  FLAGS_cfile_split_block_bloom_filters = true;
+  ASSERT_OK(OpenBloomFile());
+  NO_FATALS(VerifyBloomFile());
+}
+
 #ifdef NDEBUG
 TEST_F(BloomFileTest, Benchmark) {
   NO_FATALS(WriteTestBloomFile());
@@ -16,6 +16,8 @@
 // under the License.
 #include "kudu/cfile/bloomfile.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <memory>
 #include <ostream>
@@ -23,9 +25,10 @@
 #include <utility>
 #include <vector>
 
-#include <gflags/gflags_declare.h>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/cfile/block_cache.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/block_pointer.h"
 #include "kudu/cfile/cfile.pb.h"
@@ -37,11 +40,14 @@
 #include "kudu/common/types.h"
 #include "kudu/fs/block_manager.h"
 #include "kudu/gutil/atomicops.h"
+#include "kudu/gutil/bits.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/hash.pb.h"
 #include "kudu/util/hexdump.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/malloc.h"
@@ -50,6 +56,16 @@
 
 DECLARE_bool(cfile_lazy_open);
 
+DEFINE_bool(cfile_split_block_bloom_filters, false,
+            "Whether to write the bloom filters of new CFiles, e.g. those of "
+            "the primary keys of DiskRowSets, as split-block bloom filters. "
+            "A lookup in a split-block filter reads a single cache line, "
+            "checked with SIMD instructions where available, instead of one "
+            "cache line per hash function. Both formats can always be read, "
+            "but versions which predate this flag can't read files written "
+            "with it enabled.");
+TAG_FLAG(cfile_split_block_bloom_filters, experimental);
+
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -87,6 +103,9 @@ class BloomCacheItem {
   // The block handle and parsed BloomFilter corresponding to cur_block_pointer.
   scoped_refptr<BlockHandle> cur_block_handle;
   BloomFilter cur_bloom;
+  // Used instead of 'cur_bloom' if the block is a SPLIT_BLOCK filter.
+  BlockBloomFilter cur_block_bloom{DefaultBlockBloomFilterBufferAllocator::GetSingleton()};
+  bool cur_is_split_block = false;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BloomCacheItem);
@@ -100,7 +119,27 @@ using BloomCacheTLC = ThreadLocalCache<uint64_t, BloomCacheItem>;
 
 BloomFileWriter::BloomFileWriter(unique_ptr<WritableBlock> block,
                                  const BloomFilterSizing &sizing)
-  : bloom_builder_(sizing) {
+  : bloom_builder_(sizing),
+    block_bloom_log_space_bytes_(0),
+    block_bloom_expected_count_(0),
+    block_bloom_count_(0) {
+  if (FLAGS_cfile_split_block_bloom_filters) {
+    // Give the split-block filters the space of the legacy ones, rounded up
+    // to a power of two, and fill them up to the same false positive rate.
+    // The latter follows from the legacy sizing: see BloomFilterSizing.
+    static constexpr double kNaturalLog2 = 0.69314718056;
+    const double fp_rate = std::clamp(
+        exp(-static_cast<double>(sizing.n_bytes()) * 8 * kNaturalLog2 * kNaturalLog2 /
+            std::max<size_t>(1, sizing.expected_count())),
+        1e-9, 0.5);
+    block_bloom_log_space_bytes_ = std::max(Bits::Log2Ceiling64(sizing.n_bytes()), 6);
+    block_bloom_expected_count_ = std::max<size_t>(
+        1, BlockBloomFilter::MaxNdv(block_bloom_log_space_bytes_, fp_rate));
+    block_bloom_.reset(new BlockBloomFilter(
+        DefaultBlockBloomFilterBufferAllocator::GetSingleton()));
+    // The hash algorithm isn't used: the keys are inserted by their hash.
+    CHECK_OK(block_bloom_->Init(block_bloom_log_space_bytes_, FAST_HASH, 0));
+  }
   cfile::WriterOptions opts;
   opts.write_posidx = false;
   opts.write_validx = true;
@@ -126,7 +165,7 @@ Status BloomFileWriter::Finish() {
 }
 
 Status BloomFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction) {
-  if (bloom_builder_.count() > 0) {
+  if (count() > 0) {
     RETURN_NOT_OK(FinishCurrentBloomBlock());
   }
   return writer_->FinishAndReleaseBlock(transaction);
@@ -140,16 +179,22 @@ Status BloomFileWriter::AppendKeys(
   const Slice *keys, size_t n_keys) {
 
   // If this is the call on a new bloom, copy the first key.
-  if (bloom_builder_.count() == 0 && n_keys > 0) {
+  if (count() == 0 && n_keys > 0) {
     first_key_.assign_copy(keys[0].data(), keys[0].size());
   }
 
   for (size_t i = 0; i < n_keys; i++) {
 
-    bloom_builder_.AddKey(BloomKeyProbe(keys[i]));
+    const BloomKeyProbe probe(keys[i]);
+    if (block_bloom_) {
+      block_bloom_->Insert(probe.initial_hash());
+      ++block_bloom_count_;
+    } else {
+      bloom_builder_.AddKey(probe);
+    }
 
     // Bloom has reached optimal occupancy: flush it to the file
-    if (PREDICT_FALSE(bloom_builder_.count() >= bloom_builder_.expected_count())) {
+    if (PREDICT_FALSE(count() >= expected_count())) {
       RETURN_NOT_OK(FinishCurrentBloomBlock());
 
       // Update the last key and set the next key as the first key of the next block.
@@ -171,13 +216,22 @@ Status BloomFileWriter::FinishCurrentBloomBlock() {
 
   // Encode the header.
   BloomBlockHeaderPB hdr;
-  hdr.set_num_hash_functions(bloom_builder_.n_hashes());
+  Slice bloom_data;
+  if (block_bloom_) {
+    hdr.set_num_hash_functions(0);
+    hdr.set_format(BloomBlockHeaderPB::SPLIT_BLOCK);
+    hdr.set_log_space_bytes(block_bloom_->log_space_bytes());
+    bloom_data = block_bloom_->directory();
+  } else {
+    hdr.set_num_hash_functions(bloom_builder_.n_hashes());
+    bloom_data = bloom_builder_.slice();
+  }
   faststring hdr_str;
   PutFixed32(&hdr_str, static_cast<uint32_t>(hdr.ByteSizeLong()));
   pb_util::AppendToString(hdr, &hdr_str);
 
   // The data is the concatenation of the header and the bloom itself.
-  vector<Slice> slices { Slice(hdr_str), bloom_builder_.slice() };
+  vector<Slice> slices { Slice(hdr_str), bloom_data };
 
   // Append to the file.
   Slice start_key(first_key_);
@@ -185,7 +239,12 @@ Status BloomFileWriter::FinishCurrentBloomBlock() {
   RETURN_NOT_OK(writer_->AppendRawBlock(
       std::move(slices), 0, &start_key, last_key, "bloom block"));
 
-  bloom_builder_.Clear();
+  if (block_bloom_) {
+    RETURN_NOT_OK(block_bloom_->Init(block_bloom_log_space_bytes_, FAST_HASH, 0));
+    block_bloom_count_ = 0;
+  } else {
+    bloom_builder_.Clear();
+  }
 
   #ifndef NDEBUG
   first_key_.assign_copy("POST_RESET");
@@ -325,21 +384,36 @@ Status BloomFileReader::CheckKeyPresent(const BloomKeyProbe &probe,
   if (bblk_ptr != bci->cur_block_pointer) {
     scoped_refptr<BlockHandle> dblk_data;
     RETURN_NOT_OK(reader_->ReadBlock(io_context, bblk_ptr,
-                                     CFileReader::CACHE_BLOCK, &dblk_data));
+                                     CFileReader::CACHE_BLOCK, &dblk_data,
+                                     BlockCache::BlockType::kIndex));
 
     // Parse the header in the block.
     BloomBlockHeaderPB hdr;
     Slice bloom_data;
     RETURN_NOT_OK(ParseBlockHeader(dblk_data->data(), &hdr, &bloom_data));
 
-    // Save the data back into our threadlocal cache.
-    bci->cur_bloom = BloomFilter(bloom_data, hdr.num_hash_functions());
+    // Save the data back into our threadlocal cache. The split-block filter
+    // copies the data into a buffer aligned for its SIMD loads; the handle
+    // is kept anyway so that the block stays hot in the block cache.
+    bci->cur_is_split_block = hdr.format() == BloomBlockHeaderPB::SPLIT_BLOCK;
+    if (bci->cur_is_split_block) {
+      // Invalidate the cached state until the filter is successfully parsed.
+      bci->cur_block_pointer = BlockPointer(0, 0);
+      RETURN_NOT_OK_PREPEND(bci->cur_block_bloom.InitFromDirectory(
+                                hdr.log_space_bytes(), bloom_data, /*always_false=*/false,
+                                FAST_HASH, 0),
+                            "invalid split-block bloom filter");
+    } else {
+      bci->cur_bloom = BloomFilter(bloom_data, hdr.num_hash_functions());
+    }
     bci->cur_block_pointer = bblk_ptr;
     bci->cur_block_handle = std::move(dblk_data);
   }
 
   // Actually check the bloom filter.
-  *maybe_present = bci->cur_bloom.MayContainKey(probe);
+  *maybe_present = bci->cur_is_split_block
+      ? bci->cur_block_bloom.Find(probe.initial_hash())
+      : bci->cur_bloom.MayContainKey(probe);
   return Status::OK();
 }
 
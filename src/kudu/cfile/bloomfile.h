@@ -24,6 +24,7 @@
 #include "kudu/cfile/cfile_reader.h"
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/util/block_bloom_filter.h"
 #include "kudu/util/bloom_filter.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/mem_tracker.h"
@@ -68,10 +69,27 @@ class BloomFileWriter {
 
   Status FinishCurrentBloomBlock();
 
+  // The number of keys in the current bloom block, and the number of keys
+  // after which the block is full.
+  size_t count() const {
+    return block_bloom_ ? block_bloom_count_ : bloom_builder_.count();
+  }
+  size_t expected_count() const {
+    return block_bloom_ ? block_bloom_expected_count_ : bloom_builder_.expected_count();
+  }
+
   std::unique_ptr<cfile::CFileWriter> writer_;
 
   BloomFilterBuilder bloom_builder_;
 
+  // The split-block bloom filter of the current block, if the file is written
+  // in the SPLIT_BLOCK format (see --cfile_split_block_bloom_filters).
+  // Otherwise null, and 'bloom_builder_' is used.
+  std::unique_ptr<BlockBloomFilter> block_bloom_;
+  int block_bloom_log_space_bytes_;
+  size_t block_bloom_expected_count_;
+  size_t block_bloom_count_;
+
   // first key inserted in the current block.
   faststring first_key_;
 
@@ -23,9 +23,11 @@
 #include <functional>
 #include <initializer_list>
 #include <memory>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -43,6 +45,7 @@
 #include "kudu/cfile/index_btree.h"
 #include "kudu/cfile/type_encodings.h"
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock-test-util.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
@@ -81,8 +84,13 @@ namespace kudu {
 class Arena;
 }  // namespace kudu
 
+DECLARE_bool(cfile_cache_compressed_blocks);
+DECLARE_bool(cfile_skip_blocks_with_zone_maps);
+DECLARE_int32(cfile_read_ahead_blocks);
+DECLARE_int32(cfile_read_ahead_max_bytes);
 DECLARE_bool(cfile_write_checksums);
 DECLARE_bool(cfile_verify_checksums);
+DECLARE_bool(cfile_write_zone_maps);
 DECLARE_string(block_cache_type);
 DECLARE_bool(force_block_cache_capacity);
 DECLARE_int64(block_cache_capacity_mb);
@@ -547,21 +555,21 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestReadWriteUInt32) {
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestReadWriteInt32) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
-  for (auto enc : { PLAIN_ENCODING, RLE }) {
+  for (auto enc : { PLAIN_ENCODING, RLE, FRAME_OF_REFERENCE }) {
     TestReadWriteFixedSizeTypes<Int32DataGenerator<false>>(enc);
   }
 }
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestReadWriteUInt64) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
-  for (auto enc : { PLAIN_ENCODING, RLE, BIT_SHUFFLE }) {
+  for (auto enc : { PLAIN_ENCODING, RLE, BIT_SHUFFLE, FRAME_OF_REFERENCE }) {
     TestReadWriteFixedSizeTypes<UInt64DataGenerator<false>>(enc);
   }
 }
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestReadWriteInt64) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
-  for (auto enc : { PLAIN_ENCODING, RLE, BIT_SHUFFLE }) {
+  for (auto enc : { PLAIN_ENCODING, RLE, BIT_SHUFFLE, FRAME_OF_REFERENCE }) {
     TestReadWriteFixedSizeTypes<Int64DataGenerator<false>>(enc);
   }
 }
@@ -868,6 +876,7 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestAppendRaw) {
   TestReadWriteRawBlocks(SNAPPY, 1000);
   TestReadWriteRawBlocks(LZ4, 1000);
   TestReadWriteRawBlocks(ZLIB, 1000);
+  TestReadWriteRawBlocks(ZSTD, 1000);
 }
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestChecksumFlags) {
@@ -882,6 +891,197 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestChecksumFlags) {
   }
 }
 
+// Test that scans with predicates skip the blocks excluded by zone maps
+// without affecting the results.
+TEST_P(TestCFileBothCacheMemoryTypes, TestZoneMaps) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+  FLAGS_cfile_write_zone_maps = true;
+  constexpr int kNumRows = 10000;
+  for (bool nullable : { false, true }) {
+    SCOPED_TRACE(nullable);
+    BlockId block_id;
+    if (nullable) {
+      UInt32DataGenerator<true> generator;
+      WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows, SMALL_BLOCKSIZE,
+                    &block_id);
+    } else {
+      UInt32DataGenerator<false> generator;
+      WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows, SMALL_BLOCKSIZE,
+                    &block_id);
+    }
+
+    unique_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+    ASSERT_TRUE(reader->footer().has_zone_maps_block_ptr());
+
+    // The values are ten times the row index, so only rows 5000 to 5009 match.
+    ColumnSchema col("c", UINT32, nullable);
+    uint32_t lower = 50000;
+    uint32_t upper = 50100;
+    const auto pred = ColumnPredicate::Range(col, &lower, &upper);
+    UInt32DataGenerator<true> expected_generator;
+
+    for (bool skip_blocks : { false, true }) {
+      SCOPED_TRACE(skip_blocks);
+      FLAGS_cfile_skip_blocks_with_zone_maps = skip_blocks;
+      unique_ptr<CFileIterator> iter;
+      ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK, nullptr));
+      ASSERT_OK(iter->SeekToOrdinal(0));
+
+      // Scan in batches of random sizes so that blocks get skipped partially.
+      SelectionVector sel(kNumRows);
+      sel.SetAllTrue();
+      size_t fetched = 0;
+      while (fetched < kNumRows) {
+        ScopedColumnBlock<UINT32> out(kNumRows - fetched, nullable);
+        SelectionVector batch_sel(kNumRows - fetched);
+        batch_sel.SetAllTrue();
+        ColumnMaterializationContext ctx(0, &pred, &out, &batch_sel);
+        size_t n = random() % 500 + 1;
+        ASSERT_OK(iter->CopyNextValues(&n, &ctx));
+        for (size_t i = 0; i < n; i++) {
+          // The plain decoder doesn't evaluate predicates: whatever is still
+          // selected must be evaluated here.
+          if (!batch_sel.IsRowSelected(i) ||
+              (nullable && out.is_null(i)) ||
+              !pred.EvaluateCell<UINT32>(&out[i])) {
+            sel.SetRowUnselected(fetched + i);
+          }
+        }
+        fetched += n;
+      }
+      ASSERT_FALSE(iter->HasNext());
+
+      for (int i = 0; i < kNumRows; i++) {
+        bool expected = i >= 5000 && i < 5010 &&
+            !(nullable && expected_generator.TestValueShouldBeNull(i));
+        ASSERT_EQ(expected, sel.IsRowSelected(i)) << "row " << i;
+      }
+    }
+  }
+}
+
+// Test that the bloom filter of the values of a cfile finds the values which
+// were written, and few of those which weren't.
+TEST_P(TestCFileBothCacheMemoryTypes, TestBloomFilter) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+  constexpr int kNumRows = 10000;
+
+  BlockId block_id;
+  {
+    unique_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+    block_id = sink->id();
+    WriterOptions opts;
+    opts.write_bloom_filter = true;
+    CFileWriter w(opts, GetTypeInfo(UINT32), true, std::move(sink));
+    ASSERT_OK(w.Start());
+    // Even values only, with a NULL in every other batch.
+    for (uint32_t i = 0; i < kNumRows; i += 100) {
+      vector<uint32_t> vals;
+      for (uint32_t j = i; j < i + 100; j++) {
+        vals.push_back(j * 2);
+      }
+      vector<uint8_t> non_null(BitmapSize(vals.size()), 0xff);
+      if (i % 200 == 0) {
+        BitmapClear(non_null.data(), 0);
+      }
+      ASSERT_OK(w.AppendNullableEntries(non_null.data(), vals.data(), vals.size()));
+    }
+    ASSERT_OK(w.Finish());
+  }
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+  ASSERT_TRUE(reader->has_bloom_filter());
+
+  int false_positives = 0;
+  for (uint32_t i = 1; i < kNumRows; i++) {
+    uint32_t val = i * 2;
+    bool may_be_present;
+    ASSERT_OK(reader->ValuesMayBePresent(nullptr, { &val }, &may_be_present));
+    // Row 0 of every other batch is NULL, so its value was never written.
+    if (i % 200 != 0) {
+      ASSERT_TRUE(may_be_present) << val;
+    }
+    val++;
+    ASSERT_OK(reader->ValuesMayBePresent(nullptr, { &val }, &may_be_present));
+    if (may_be_present) {
+      false_positives++;
+    }
+  }
+  // The filter is sized for a 1% false positive rate.
+  ASSERT_LT(false_positives, kNumRows / 20);
+
+  // A list of values may be present as soon as one of them may be.
+  uint32_t absent = kNumRows * 2 + 1;
+  uint32_t present = 2;
+  bool may_be_present;
+  ASSERT_OK(reader->ValuesMayBePresent(nullptr, { &absent, &present }, &may_be_present));
+  ASSERT_TRUE(may_be_present);
+}
+
+// Test reading a nullable column whose first half of the blocks have no nulls,
+// and whose null bitmaps aren't decoded.
+TEST_P(TestCFileBothCacheMemoryTypes, TestNullableBlocksWithoutNulls) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+  constexpr int kNumRows = 10000;
+  const auto is_null = [](uint32_t i) { return i >= kNumRows / 2 && i % 7 == 0; };
+
+  BlockId block_id;
+  {
+    unique_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+    block_id = sink->id();
+    WriterOptions opts;
+    opts.write_posidx = true;
+    opts.storage_attributes.cfile_block_size = 256;
+    CFileWriter w(opts, GetTypeInfo(UINT32), true, std::move(sink));
+    ASSERT_OK(w.Start());
+    for (uint32_t i = 0; i < kNumRows; i += 100) {
+      vector<uint32_t> vals;
+      vector<uint8_t> non_null(BitmapSize(100), 0);
+      for (uint32_t j = i; j < i + 100; j++) {
+        vals.push_back(j);
+        BitmapChange(non_null.data(), j - i, !is_null(j));
+      }
+      ASSERT_OK(w.AppendNullableEntries(non_null.data(), vals.data(), vals.size()));
+    }
+    ASSERT_OK(w.Finish());
+  }
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+  unique_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK, nullptr));
+
+  // Seek to random rows, then read batches of random sizes from them, across
+  // the blocks with and without nulls.
+  for (int attempt = 0; attempt < 100; attempt++) {
+    rowid_t start = random() % kNumRows;
+    ASSERT_OK(iter->SeekToOrdinal(start));
+    size_t n = std::min<size_t>(random() % 2000 + 1, kNumRows - start);
+    ScopedColumnBlock<UINT32> out(n, true);
+    SelectionVector sel(n);
+    sel.SetAllTrue();
+    ColumnMaterializationContext ctx(0, nullptr, &out, &sel);
+    ASSERT_OK(iter->CopyNextValues(&n, &ctx));
+    for (size_t i = 0; i < n; i++) {
+      const uint32_t row = start + i;
+      ASSERT_EQ(is_null(row), out.is_null(i)) << "row " << row;
+      if (!is_null(row)) {
+        ASSERT_EQ(row, out[i]);
+      }
+    }
+  }
+}
+
 TEST_P(TestCFileBothCacheMemoryTypes, TestDataCorruption) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
   FLAGS_cfile_write_checksums = true;
@@ -978,6 +1178,67 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestReleaseBlock) {
   ASSERT_OK(transaction->CommitCreatedBlocks());
 }
 
+// Test reading a file sequentially and from random positions with the data
+// blocks read ahead, including with reads limited to part of the blocks.
+TEST_P(TestCFileBothCacheMemoryTypes, TestReadAhead) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+  constexpr int kNumRows = 20000;
+
+  BlockId block_id;
+  {
+    unique_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+    block_id = sink->id();
+    WriterOptions opts;
+    opts.write_posidx = true;
+    opts.storage_attributes.cfile_block_size = 256;
+    CFileWriter w(opts, GetTypeInfo(UINT32), false, std::move(sink));
+    ASSERT_OK(w.Start());
+    vector<uint32_t> vals(kNumRows);
+    std::iota(vals.begin(), vals.end(), 0);
+    ASSERT_OK(w.AppendEntries(vals.data(), vals.size()));
+    ASSERT_OK(w.Finish());
+  }
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+
+  const auto read_rows = [&](CFileIterator* iter, rowid_t start, size_t n) {
+    ASSERT_OK(iter->SeekToOrdinal(start));
+    while (n > 0) {
+      size_t batch = std::min<size_t>(n, 1000);
+      ScopedColumnBlock<UINT32> out(batch, false);
+      SelectionVector sel(batch);
+      sel.SetAllTrue();
+      ColumnMaterializationContext ctx(0, nullptr, &out, &sel);
+      ASSERT_OK(iter->CopyNextValues(&batch, &ctx));
+      ASSERT_GT(batch, 0);
+      for (size_t i = 0; i < batch; i++) {
+        ASSERT_EQ(start + i, out[i]);
+      }
+      start += batch;
+      n -= batch;
+    }
+  };
+
+  for (const auto& [read_ahead_blocks, max_bytes] :
+       vector<std::pair<int32_t, int32_t>>{ { 8, 4 * 1024 * 1024 }, { 64, 1024 } }) {
+    SCOPED_TRACE(Substitute("$0 blocks, up to $1 bytes", read_ahead_blocks, max_bytes));
+    FLAGS_cfile_read_ahead_blocks = read_ahead_blocks;
+    FLAGS_cfile_read_ahead_max_bytes = max_bytes;
+    unique_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::DONT_CACHE_BLOCK, nullptr));
+    NO_FATALS(read_rows(iter.get(), 0, kNumRows));
+    for (int attempt = 0; attempt < 100; attempt++) {
+      rowid_t start = random() % kNumRows;
+      NO_FATALS(read_rows(iter.get(), start,
+                          std::min<size_t>(random() % 3000 + 1, kNumRows - start)));
+    }
+  }
+}
+
 TEST_P(TestCFileBothCacheMemoryTypes, TestLazyInit) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
 
@@ -1107,7 +1368,7 @@ class TestCFileDifferentCodecs : public TestCFile,
 };
 
 INSTANTIATE_TEST_SUITE_P(Codecs, TestCFileDifferentCodecs,
-                         ::testing::Values(NO_COMPRESSION, SNAPPY, LZ4, ZLIB));
+                         ::testing::Values(NO_COMPRESSION, SNAPPY, LZ4, ZLIB, ZSTD));
 
 // Read/write a file with uncompressible data (random int32s)
 TEST_P(TestCFileDifferentCodecs, TestUncompressible) {
@@ -1128,5 +1389,57 @@ TEST_P(TestCFileDifferentCodecs, TestUncompressible) {
   }
 }
 
+// Compressed blocks may be cached as they're stored, and be decompressed on
+// every read.
+TEST_P(TestCFileDifferentCodecs, TestCacheCompressedBlocks) {
+  FLAGS_cfile_cache_compressed_blocks = true;
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity(METRIC_ENTITY_server.Instantiate(&registry, "test_entity"));
+  BlockCache::GetSingleton()->StartInstrumentation(entity);
+  const auto hits = [&]() {
+    return down_cast<Counter*>(
+        entity->FindOrNull(METRIC_block_cache_hits_caching).get())->value();
+  };
+
+  BlockId block_id;
+  {
+    UInt32DataGenerator<false> generator;
+    WriteTestFile(&generator, PLAIN_ENCODING, GetParam(), 10000,
+                  SMALL_BLOCKSIZE, &block_id);
+  }
+  const auto read_first_block = [&](string* data) {
+    unique_ptr<ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+    unique_ptr<IndexTreeIterator> iter(
+        IndexTreeIterator::Create(nullptr, reader.get(), reader->posidx_root()));
+    ASSERT_OK(iter->SeekToFirst());
+    scoped_refptr<BlockHandle> bh;
+    ASSERT_OK(reader->ReadBlock(nullptr, iter->GetCurrentBlockPointer(),
+                                CFileReader::CACHE_BLOCK, &bh));
+    *data = bh->data().ToString();
+  };
+
+  // The second read hits in the cache for both the index and the data block.
+  string first;
+  NO_FATALS(read_first_block(&first));
+  int64_t hits_before = hits();
+  string second;
+  NO_FATALS(read_first_block(&second));
+  ASSERT_EQ(hits_before + 2, hits());
+  ASSERT_EQ(first, second);
+
+  // Turning the option off doesn't return the compressed blocks as they're
+  // cached, but reads the blocks again.
+  FLAGS_cfile_cache_compressed_blocks = false;
+  string third;
+  NO_FATALS(read_first_block(&third));
+  ASSERT_EQ(first, third);
+  size_t n;
+  NO_FATALS(TimeReadFile(fs_manager_.get(), block_id, &n));
+  ASSERT_EQ(10000, n);
+}
+
 } // namespace cfile
 } // namespace kudu
@@ -18,6 +18,7 @@
 #include "kudu/cfile/cfile_reader.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <ostream>
@@ -53,6 +54,8 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/array_view.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/block_bloom_filter.pb.h"
 #include "kudu/util/cache.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/compression/compression_codec.h"
@@ -64,6 +67,7 @@
 #include "kudu/util/malloc.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/memory/overwrite.h"
+#include "kudu/util/metrics.h"
 #include "kudu/util/object_pool.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/rle-encoding.h"
@@ -80,11 +84,47 @@ DEFINE_bool(cfile_verify_checksums, true,
 TAG_FLAG(cfile_verify_checksums, evolving);
 TAG_FLAG(cfile_verify_checksums, runtime);
 
+DEFINE_bool(cfile_skip_blocks_with_zone_maps, true,
+            "Whether scans skip decoding the data blocks whose zone maps show "
+            "that none of their values can match the scan's predicates");
+TAG_FLAG(cfile_skip_blocks_with_zone_maps, advanced);
+TAG_FLAG(cfile_skip_blocks_with_zone_maps, runtime);
+
+DEFINE_int32(cfile_read_ahead_blocks, 0,
+             "Number of data blocks following the one being read that CFile "
+             "iterators read along with it when it isn't in the block cache. "
+             "Nearby blocks are read with a single I/O, so that sequential scans "
+             "of each column don't issue a read, i.e. a seek on spinning disks, "
+             "per block. Each CFile iterator buffers up to this many blocks, "
+             "and up to --cfile_read_ahead_max_bytes. 0 disables read-ahead.");
+TAG_FLAG(cfile_read_ahead_blocks, advanced);
+TAG_FLAG(cfile_read_ahead_blocks, runtime);
+DEFINE_validator(cfile_read_ahead_blocks, [](const char* flagname, int32_t value) {
+  if (value >= 0 && value <= 1024) {
+    return true;
+  }
+  LOG(ERROR) << Substitute("$0 must be between 0 and 1024, got $1", flagname, value);
+  return false;
+});
+
+DEFINE_int32(cfile_read_ahead_max_bytes, 4 * 1024 * 1024,
+             "Maximum number of bytes each CFile iterator reads ahead: see "
+             "--cfile_read_ahead_blocks.");
+TAG_FLAG(cfile_read_ahead_max_bytes, advanced);
+TAG_FLAG(cfile_read_ahead_max_bytes, runtime);
+
 DEFINE_double(cfile_inject_corruption, 0,
               "Fraction of the time that read operations on CFiles will fail "
               "with a corruption status");
 TAG_FLAG(cfile_inject_corruption, hidden);
 
+DEFINE_bool(cfile_cache_compressed_blocks, false,
+            "Whether to keep the blocks of compressed CFiles compressed in the block "
+            "cache, decompressing them on every read. This fits more blocks in the "
+            "block cache at the expense of CPU.");
+TAG_FLAG(cfile_cache_compressed_blocks, experimental);
+TAG_FLAG(cfile_cache_compressed_blocks, runtime);
+
 using kudu::fault_injection::MaybeTrue;
 using kudu::fs::ErrorHandlerType;
 using kudu::fs::IOContext;
@@ -102,6 +142,11 @@ namespace cfile {
 const char* CFILE_CACHE_MISS_BYTES_METRIC_NAME = "cfile_cache_miss_bytes";
 const char* CFILE_CACHE_HIT_BYTES_METRIC_NAME = "cfile_cache_hit_bytes";
 
+// Set in the offset of the cache keys of compressed blocks, so that they can't
+// be mistaken for uncompressed blocks if --cfile_cache_compressed_blocks is
+// changed at runtime.
+static const uint64_t kCompressedBlockKeyTag = 1ULL << 63;
+
 // Magic+Length: 8-byte magic, followed by 4-byte header size
 static const size_t kMagicAndLengthSize = 12;
 static const size_t kMaxHeaderFooterPBSize = 64*1024;
@@ -144,6 +189,9 @@ CFileReader::CFileReader(ReaderOptions options,
                    memory_footprint()) {
 }
 
+CFileReader::~CFileReader() {
+}
+
 Status CFileReader::Open(unique_ptr<ReadableBlock> block,
                          ReaderOptions options,
                          unique_ptr<CFileReader>* reader) {
@@ -213,6 +261,45 @@ Status CFileReader::Init(const IOContext* io_context) {
   return Status::OK();
 }
 
+Status CFileReader::ValuesMayBePresent(const IOContext* io_context,
+                                       const vector<const void*>& values,
+                                       bool* may_be_present) {
+  DCHECK(has_bloom_filter());
+  RETURN_NOT_OK(bloom_filter_once_.Init([this, io_context] {
+    return LoadBloomFilterOnce(io_context);
+  }));
+  for (const void* value : values) {
+    if (bloom_filter_->Find(BloomFilterKeyForCell(type_info_, value))) {
+      *may_be_present = true;
+      return Status::OK();
+    }
+  }
+  *may_be_present = false;
+  return Status::OK();
+}
+
+Status CFileReader::LoadBloomFilterOnce(const IOContext* io_context) {
+  BlockPointer bp(footer().bloom_filter_block_ptr());
+  scoped_refptr<BlockHandle> handle;
+  // The filter is copied out of the block, so there's no point in caching it.
+  RETURN_NOT_OK_PREPEND(ReadBlock(io_context, bp, DONT_CACHE_BLOCK, &handle),
+                        "couldn't read bloom filter block");
+  BlockBloomFilterPB bf_pb;
+  RETURN_NOT_OK_PREPEND(pb_util::ParseFromArray(&bf_pb,
+                                                handle->data().data(),
+                                                handle->data().size()),
+                        Substitute("couldn't parse bloom filter in block $0 ($1)",
+                                   block_id().ToString(), bp.ToString()));
+  unique_ptr<BlockBloomFilter> bf(
+      new BlockBloomFilter(DefaultBlockBloomFilterBufferAllocator::GetSingleton()));
+  RETURN_NOT_OK(bf->InitFromPB(bf_pb));
+  bloom_filter_ = std::move(bf);
+
+  // The filter is kept in memory from now on.
+  mem_consumption_.Reset(memory_footprint());
+  return Status::OK();
+}
+
 Status CFileReader::ReadAndParseHeader() {
   TRACE_EVENT1("io", "CFileReader::ReadAndParseHeader",
                "cfile", ToString());
@@ -381,10 +468,11 @@ class ScratchMemory {
   // no capacity and cannot evict to make room, this will fall back
   // to allocating from the heap. In that case, IsFromCache() will
   // return false.
-  void TryAllocateFromCache(BlockCache* cache, const BlockCache::CacheKey& key, int size) {
+  void TryAllocateFromCache(BlockCache* cache, const BlockCache::CacheKey& key, int size,
+                            BlockCache::BlockType type, const fs::IOContext* io_context) {
     DCHECK(!from_cache_.valid());
     DCHECK(!ptr_);
-    from_cache_ = cache->Allocate(key, size);
+    from_cache_ = cache->Allocate(key, size, type, io_context);
     if (!from_cache_.valid()) {
       return AllocateFromHeap(size);
     }
@@ -441,7 +529,9 @@ class ScratchMemory {
 Status CFileReader::ReadBlock(const IOContext* io_context,
                               const BlockPointer& ptr,
                               CacheControl cache_control,
-                              scoped_refptr<BlockHandle>* ret) const {
+                              scoped_refptr<BlockHandle>* ret,
+                              BlockCache::BlockType block_type,
+                              ReadAheadBuffer* read_ahead) const {
   DCHECK(init_once_.init_succeeded());
 
   if (PREDICT_FALSE(ptr.offset() == 0 ||
@@ -454,10 +544,22 @@ Status CFileReader::ReadBlock(const IOContext* io_context,
   Cache::CacheBehavior cache_behavior = cache_control == CACHE_BLOCK ?
       Cache::EXPECT_IN_CACHE : Cache::NO_EXPECT_IN_CACHE;
   BlockCache* cache = BlockCache::GetSingleton();
-  BlockCache::CacheKey key(block_->id(), ptr.offset());
-  if (cache->Lookup(key, cache_behavior, &bc_handle)) {
+  const bool cache_compressed = codec_ != nullptr && FLAGS_cfile_cache_compressed_blocks;
+  // The CFiles of a column group share the ID of their block.
+  const uint64_t offset = block_->offset_in_block() + ptr.offset();
+  BlockCache::CacheKey key(block_->id(), cache_compressed ? offset | kCompressedBlockKeyTag
+                                                          : offset);
+  const fs::IOMetrics* io_metrics = io_context ? io_context->metrics : nullptr;
+  if (cache->Lookup(key, cache_behavior, &bc_handle, block_type, io_context)) {
     TRACE_COUNTER_INCREMENT("cfile_cache_hit", 1);
+    if (io_metrics) {
+      io_metrics->cfile_cache_hits->Increment();
+    }
     TRACE_COUNTER_INCREMENT(CFILE_CACHE_HIT_BYTES_METRIC_NAME, ptr.size());
+    if (cache_compressed) {
+      TRACE_COUNTER_INCREMENT("cfile_cache_compressed_hit", 1);
+      return DecompressIntoOwnedBlock(ptr, bc_handle.data(), ret);
+    }
     *ret = BlockHandle::WithDataFromCache(std::move(bc_handle));
     // Cache hit
     return Status::OK();
@@ -471,6 +573,9 @@ Status CFileReader::ReadBlock(const IOContext* io_context,
                "cfile", ToString());
   TRACE_COUNTER_INCREMENT("cfile_cache_miss", 1);
   TRACE_COUNTER_INCREMENT(CFILE_CACHE_MISS_BYTES_METRIC_NAME, ptr.size());
+  if (io_metrics) {
+    io_metrics->cfile_cache_misses->Increment();
+  }
 
   uint32_t data_size = ptr.size();
   if (has_checksum()) {
@@ -482,11 +587,11 @@ Status CFileReader::ReadBlock(const IOContext* io_context,
   }
 
   ScratchMemory scratch;
-  // If we are reading uncompressed data and plan to cache the result,
-  // then we should allocate our scratch memory directly from the cache.
-  // This avoids an extra memory copy in the case of an NVM cache.
-  if (codec_ == nullptr && cache_control == CACHE_BLOCK) {
-    scratch.TryAllocateFromCache(cache, key, data_size);
+  // If we are reading data which will be cached as it's stored and plan to
+  // cache the result, then we should allocate our scratch memory directly from
+  // the cache. This avoids an extra memory copy in the case of an NVM cache.
+  if ((codec_ == nullptr || cache_compressed) && cache_control == CACHE_BLOCK) {
+    scratch.TryAllocateFromCache(cache, key, data_size, block_type, io_context);
   } else {
     scratch.AllocateFromHeap(data_size);
   }
@@ -496,11 +601,28 @@ Status CFileReader::ReadBlock(const IOContext* io_context,
   Slice checksum(checksum_scratch, kChecksumSize);
 
   // Read the data and checksum if needed.
-  Slice results_backing[] = { block, checksum };
-  ArrayView<Slice> results(results_backing, do_verify_checksum() ? 2 : 1);
-  RETURN_NOT_OK_PREPEND(block_->ReadV(ptr.offset(), results),
-                        Substitute("failed to read CFile block $0 at $1",
-                                   block_id().ToString(), ptr.ToString()));
+  if (read_ahead && !read_ahead->Contains(ptr)) {
+    RETURN_NOT_OK(FillReadAhead(io_context, ptr, read_ahead));
+  }
+  if (read_ahead) {
+    const uint8_t* src = read_ahead->data.data() + (ptr.offset() - read_ahead->offset);
+    memcpy(block.mutable_data(), src, data_size);
+    if (do_verify_checksum()) {
+      memcpy(checksum.mutable_data(), src + data_size, kChecksumSize);
+    }
+  } else {
+    Slice results_backing[] = { block, checksum };
+    ArrayView<Slice> results(results_backing, do_verify_checksum() ? 2 : 1);
+    if (io_context) {
+      fs::SetThreadIOPriority(io_context->priority);
+    }
+    RETURN_NOT_OK_PREPEND(block_->ReadV(ptr.offset(), results),
+                          Substitute("failed to read CFile block $0 at $1",
+                                     block_id().ToString(), ptr.ToString()));
+    if (io_metrics) {
+      io_metrics->cfile_bytes_read->IncrementBy(ptr.size());
+    }
+  }
 
   if (do_verify_checksum()) {
     if (auto s = VerifyChecksum(ArrayView<const Slice>(&block, 1), checksum);
@@ -512,6 +634,16 @@ Status CFileReader::ReadBlock(const IOContext* io_context,
     }
   }
 
+  if (cache_compressed) {
+    if (cache_control == CACHE_BLOCK && scratch.IsFromCache()) {
+      cache->Insert(scratch.mutable_pending_entry(), &bc_handle);
+      // The cache now has ownership over the memory.
+      ignore_result(scratch.release());
+      return DecompressIntoOwnedBlock(ptr, bc_handle.data(), ret);
+    }
+    return DecompressIntoOwnedBlock(ptr, block, ret);
+  }
+
   // Decompress the block
   if (codec_ != nullptr) {
     // Init the decompressor and get the size required for the uncompressed buffer.
@@ -528,7 +660,8 @@ Status CFileReader::ReadBlock(const IOContext* io_context,
     // decompress directly into the cache's memory (to avoid a memcpy for NVM).
     ScratchMemory decompressed_scratch;
     if (cache_control == CACHE_BLOCK) {
-      decompressed_scratch.TryAllocateFromCache(cache, key, uncompressed_size);
+      decompressed_scratch.TryAllocateFromCache(cache, key, uncompressed_size, block_type,
+                                                io_context);
     } else {
       decompressed_scratch.AllocateFromHeap(uncompressed_size);
     }
@@ -573,6 +706,67 @@ Status CFileReader::ReadBlock(const IOContext* io_context,
   return Status::OK();
 }
 
+Status CFileReader::FillReadAhead(const IOContext* io_context,
+                                  const BlockPointer& ptr,
+                                  ReadAheadBuffer* read_ahead) const {
+  // Also read the gaps between the blocks, e.g. the index blocks written
+  // between data blocks, as long as that's cheaper than seeking over them.
+  static constexpr uint64_t kMaxGapBytes = 64 * 1024;
+  const uint64_t max_bytes = std::max<uint64_t>(FLAGS_cfile_read_ahead_max_bytes, ptr.size());
+  uint64_t end = ptr.offset() + ptr.size();
+  for (const auto& next : read_ahead->next_blocks) {
+    const uint64_t next_end = next.offset() + next.size();
+    if (next.offset() < end || next.offset() - end > kMaxGapBytes ||
+        next_end - ptr.offset() > max_bytes || file_size_ <= next_end) {
+      break;
+    }
+    end = next_end;
+  }
+
+  read_ahead->offset = ptr.offset();
+  read_ahead->data.clear();
+  read_ahead->data.resize(end - ptr.offset());
+  if (io_context) {
+    fs::SetThreadIOPriority(io_context->priority);
+  }
+  if (auto s = block_->Read(ptr.offset(), Slice(read_ahead->data));
+      PREDICT_FALSE(!s.ok())) {
+    read_ahead->data.clear();
+    return s.CloneAndPrepend(Substitute("failed to read CFile block $0 at $1",
+                                        block_id().ToString(), ptr.ToString()));
+  }
+  TRACE_COUNTER_INCREMENT("cfile_read_ahead_bytes", end - ptr.offset() - ptr.size());
+  const fs::IOMetrics* io_metrics = io_context ? io_context->metrics : nullptr;
+  if (io_metrics) {
+    io_metrics->cfile_bytes_read->IncrementBy(read_ahead->data.size());
+  }
+  return Status::OK();
+}
+
+Status CFileReader::DecompressIntoOwnedBlock(const BlockPointer& ptr,
+                                             Slice compressed,
+                                             scoped_refptr<BlockHandle>* ret) const {
+  DCHECK(codec_);
+  CompressedBlockDecoder uncompressor(codec_, cfile_version_, compressed);
+  if (auto s = uncompressor.Init(); PREDICT_FALSE(!s.ok())) {
+    LOG(WARNING) << Substitute(
+        "unable to validate compressed block $0 of size $1 at offset $2: $3",
+        block_id().ToString(), compressed.size(), ptr.offset(), s.ToString());
+    return s;
+  }
+  int uncompressed_size = uncompressor.uncompressed_size();
+  unique_ptr<uint8_t[]> buf(new uint8_t[uncompressed_size]);
+  if (auto s = uncompressor.UncompressIntoBuffer(buf.get()); PREDICT_FALSE(!s.ok())) {
+    LOG(WARNING) << Substitute(
+        "unable to uncompress block $0 of size $1 at offset $2: $3",
+        block_id().ToString(), compressed.size(), ptr.offset(), s.ToString());
+    return s;
+  }
+  TRACE_COUNTER_INCREMENT("cfile_decompressed_bytes", uncompressed_size);
+  *ret = BlockHandle::WithOwnedData(Slice(buf.release(), uncompressed_size));
+  return Status::OK();
+}
+
 Status CFileReader::CountRows(rowid_t* count) const {
   *count = footer().num_values();
   return Status::OK();
@@ -625,6 +819,10 @@ size_t CFileReader::memory_footprint() const {
   if (footer_) {
     size += footer_->SpaceUsedLong();
   }
+  if (bloom_filter_) {
+    size += kudu_malloc_usable_size(bloom_filter_.get()) +
+        (1ULL << bloom_filter_->log_space_bytes());
+  }
   return size;
 }
 
@@ -700,6 +898,7 @@ CFileIterator::CFileIterator(CFileReader* reader,
                              CFileReader::CacheControl cache_control,
                              const IOContext* io_context)
   : reader_(reader),
+    num_codewords_matching_pred_(0),
     seeked_(nullptr),
     prepared_(false),
     cache_control_(cache_control),
@@ -776,7 +975,7 @@ void CFileIterator::SeekToPositionInBlock(PreparedBlock* pb, uint32_t idx_in_blo
   // we need to translate from 'ord_idx' (the absolute row id)
   // to the index within the non-null entries.
   uint32_t index_within_nonnulls;
-  if (reader_->is_nullable()) {
+  if (pb->has_nulls_) {
     if (PREDICT_TRUE(pb->idx_in_block_ <= idx_in_block)) {
       // We are seeking forward. Skip from the current position in the RLE decoder
       // instead of going back to the beginning of the block.
@@ -927,6 +1126,56 @@ Status CFileIterator::PrepareForNewSeek() {
   return Status::OK();
 }
 
+Status CFileIterator::LoadZoneMaps() {
+  DCHECK(!zone_maps_);
+  BlockPointer bp(reader_->footer().zone_maps_block_ptr());
+  scoped_refptr<BlockHandle> handle;
+  RETURN_NOT_OK_PREPEND(
+      reader_->ReadBlock(io_context_, bp, CFileReader::CACHE_BLOCK, &handle),
+      "couldn't read zone maps block");
+  unique_ptr<ZoneMapsPB> zone_maps(new ZoneMapsPB);
+  RETURN_NOT_OK_PREPEND(pb_util::ParseFromArray(zone_maps.get(),
+                                                handle->data().data(),
+                                                handle->data().size()),
+                        Substitute("couldn't parse zone maps in block $0 ($1)",
+                                   reader_->block_id().ToString(), bp.ToString()));
+  zone_maps_ = std::move(zone_maps);
+  return Status::OK();
+}
+
+bool CFileIterator::CanSkipBlock(const PreparedBlock& pb, const ColumnPredicate& pred) const {
+  DCHECK(zone_maps_);
+  const auto& zone_maps = zone_maps_->zone_maps();
+  const rowid_t first_row_idx = pb.first_row_idx();
+  // Find the zone map of the block: the last one starting at or before the
+  // block's first row.
+  auto it = std::upper_bound(zone_maps.begin(), zone_maps.end(), first_row_idx,
+                             [](rowid_t ord, const ZoneMapsPB::ZoneMapPB& zone_map) {
+                               return ord < zone_map.first_ordinal();
+                             });
+  if (it == zone_maps.begin()) {
+    return false;
+  }
+  const auto& zone_map = *(--it);
+  if (PREDICT_FALSE(zone_map.first_ordinal() != first_row_idx ||
+                    zone_map.num_rows() != pb.num_rows_in_block_)) {
+    return false;
+  }
+  if (pred.predicate_type() == PredicateType::IsNull) {
+    return zone_map.null_count() == 0;
+  }
+  if (!zone_map.has_min_value()) {
+    // All the cells of the block are NULL.
+    return true;
+  }
+  const size_t size = reader_->type_info()->size();
+  if (PREDICT_FALSE(zone_map.min_value().size() != size ||
+                    zone_map.max_value().size() != size)) {
+    return false;
+  }
+  return !pred.MayMatchRange(zone_map.min_value().data(), zone_map.max_value().data());
+}
+
 rowid_t CFileIterator::GetCurrentOrdinal() const {
   CHECK(seeked_) << "not seeked";
   return last_prepare_idx_;
@@ -966,8 +1215,19 @@ Status DecodeNullInfo(scoped_refptr<BlockHandle>* data_block_handle,
 Status CFileIterator::ReadCurrentDataBlock(const IndexTreeIterator& idx_iter,
                                            PreparedBlock* prep_block) {
   prep_block->dblk_ptr_ = idx_iter.GetCurrentBlockPointer();
+  ReadAheadBuffer* read_ahead = nullptr;
+  if (const int32_t read_ahead_blocks = FLAGS_cfile_read_ahead_blocks;
+      read_ahead_blocks > 0) {
+    read_ahead = &read_ahead_;
+    read_ahead->next_blocks.clear();
+    if (!read_ahead->Contains(prep_block->dblk_ptr_)) {
+      RETURN_NOT_OK(idx_iter.GetNextBlockPointers(read_ahead_blocks,
+                                                  &read_ahead->next_blocks));
+    }
+  }
   RETURN_NOT_OK(reader_->ReadBlock(
-      io_context_, prep_block->dblk_ptr_, cache_control_, &prep_block->dblk_handle_));
+      io_context_, prep_block->dblk_ptr_, cache_control_, &prep_block->dblk_handle_,
+      BlockCache::BlockType::kData, read_ahead));
 
   uint32_t num_rows_in_block = 0;
   scoped_refptr<BlockHandle> data_block = prep_block->dblk_handle_;
@@ -992,6 +1252,10 @@ Status CFileIterator::ReadCurrentDataBlock(const IndexTreeIterator& idx_iter,
   if (!reader_->is_nullable()) {
     num_rows_in_block = prep_block->dblk_->Count();
   }
+  // The data block only holds the non-null values, so a block holding as
+  // many values as rows has no null cells.
+  prep_block->has_nulls_ = reader_->is_nullable() &&
+      prep_block->dblk_->Count() != num_rows_in_block;
 
   io_stats_.cells_read += num_rows_in_block;
   io_stats_.blocks_read++;
@@ -1134,10 +1398,21 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
         Slice cur_string = dict_decoder_->string_at_index(i);
         if (ctx->pred()->EvaluateCell<BINARY>(static_cast<const void*>(&cur_string))) {
           BitmapSet(codewords_matching_pred_->mutable_bitmap(), i);
+          num_codewords_matching_pred_++;
         }
       }
     }
   }
+
+  // Zone maps may be used to skip whole blocks only when the results of the
+  // predicate are up to the decoders, i.e. there are no deltas to apply.
+  const bool use_zone_maps = FLAGS_cfile_skip_blocks_with_zone_maps &&
+      ctx->DecoderEvalNotDisabled() &&
+      reader_->footer().has_zone_maps_block_ptr();
+  if (use_zone_maps && !zone_maps_) {
+    RETURN_NOT_OK(LoadZoneMaps());
+  }
+
   for (PreparedBlock* pb : prepared_blocks_) {
     if (pb->needs_rewind_) {
       // Seek back to the saved position.
@@ -1146,7 +1421,31 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
       // that might be more efficient (allowing the decoder to save internal state
       // instead of having to reconstruct it)
     }
-    if (reader_->is_nullable()) {
+
+    if (use_zone_maps && CanSkipBlock(*pb, *ctx->pred())) {
+      // None of the rows of this block match the predicate: deselect them
+      // without decoding anything.
+      size_t nrows = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
+      remaining_sel.ClearBits(nrows);
+      if (ctx->block()->is_nullable()) {
+        remaining_dst.SetNullBits(nrows, false);
+      }
+      if (pb->idx_in_block_ + nrows < pb->num_rows_in_block_) {
+        // The rest of the block belongs to the next batch.
+        SeekToPositionInBlock(pb, pb->idx_in_block_ + nrows);
+      } else {
+        pb->idx_in_block_ = pb->num_rows_in_block_;
+      }
+      pb->needs_rewind_ = true;
+      rem -= nrows;
+      remaining_dst.Advance(nrows);
+      remaining_sel.Advance(nrows);
+      if (rem == 0) {
+        break;
+      }
+      continue;
+    }
+    if (pb->has_nulls_) {
       DCHECK(ctx->block()->is_nullable());
 
       size_t nrows = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
@@ -1205,7 +1504,8 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
       pb->needs_rewind_ = true;
       DCHECK_LE(this_batch, rem);
 
-      // If the column is nullable, set all bits to true
+      // If the column is nullable (and the block has no nulls), set all bits
+      // to true
       if (ctx->block()->is_nullable()) {
         remaining_dst.SetNullBits(this_batch, true);
       }
@@ -24,6 +24,7 @@
 
 #include <glog/logging.h>
 
+#include "kudu/cfile/block_cache.h"
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/block_pointer.h"
@@ -45,7 +46,9 @@
 
 namespace kudu {
 
+class BlockBloomFilter;
 class ColumnMaterializationContext;
+class ColumnPredicate;
 class CompressionCodec;
 class EncodedKey;
 class SelectionVector;
@@ -65,6 +68,24 @@ class IndexTreeIterator;
 class TypeEncodingInfo;
 struct ReaderOptions;
 
+// The raw bytes of a range of a CFile, holding consecutive blocks read with a
+// single I/O, so that sequential scans don't issue one read per block: see
+// CFileReader::ReadBlock().
+struct ReadAheadBuffer {
+  // Whether the block pointed to by 'ptr' is entirely within the buffer.
+  bool Contains(const BlockPointer& ptr) const {
+    return ptr.offset() >= offset && ptr.offset() + ptr.size() <= offset + data.size();
+  }
+
+  // The pointers of the blocks expected to be read after the one passed to
+  // ReadBlock(), in order. Set by the caller before each ReadBlock().
+  std::vector<BlockPointer> next_blocks;
+
+  // The offset in the CFile of the first byte of 'data'.
+  uint64_t offset = 0;
+  faststring data;
+};
+
 class CFileReader {
  public:
   // Fully open a cfile using a previously opened block.
@@ -84,6 +105,8 @@ class CFileReader {
                            ReaderOptions options,
                            std::unique_ptr<CFileReader>* reader);
 
+  ~CFileReader();
+
   // Fully opens a previously lazily opened cfile, parsing and validating
   // its contents.
   //
@@ -103,10 +126,25 @@ class CFileReader {
   // Reads the data block pointed to by `ptr`. Will pull the data block from
   // the block cache if it exists, and reads from the filesystem block
   // otherwise.
+  //
+  // If --cfile_cache_compressed_blocks is set, the blocks of compressed files
+  // are cached as they are stored, and decompressed into a buffer owned by
+  // 'ret' on every read.
+  //
+  // 'block_type' selects the partition of the block cache the block is looked
+  // up from and inserted into: index and bloom blocks are read with
+  // BlockCache::BlockType::kIndex.
+  //
+  // If 'read_ahead' is set and the block isn't in the block cache, it's copied
+  // from 'read_ahead' if possible. Otherwise, the block is read along with the
+  // blocks of 'read_ahead->next_blocks' which are nearby in a single I/O,
+  // refilling 'read_ahead'.
   Status ReadBlock(const fs::IOContext* io_context,
                    const BlockPointer& ptr,
                    CacheControl cache_control,
-                   scoped_refptr<BlockHandle>* ret) const;
+                   scoped_refptr<BlockHandle>* ret,
+                   BlockCache::BlockType block_type = BlockCache::BlockType::kData,
+                   ReadAheadBuffer* read_ahead = nullptr) const;
 
   // Return the number of rows in this cfile.
   // This is assumed to be reasonably fast (i.e does not scan
@@ -176,6 +214,19 @@ class CFileReader {
     return BlockPointer(footer().validx_info().root_block());
   }
 
+  // Return true if there is a bloom filter of the values of this file.
+  bool has_bloom_filter() const { return footer().has_bloom_filter_block_ptr(); }
+
+  // Sets '*may_be_present' to false if the bloom filter of the values of this
+  // file shows that none of the cells in 'values' (in their in-memory format)
+  // are in the file, and to true otherwise. The bloom filter is read on the
+  // first call and kept for the lifetime of the reader.
+  //
+  // REQUIRES: has_bloom_filter()
+  Status ValuesMayBePresent(const fs::IOContext* io_context,
+                            const std::vector<const void*>& values,
+                            bool* may_be_present);
+
   // Can be called before Init().
   std::string ToString() const { return block_->id().ToString(); }
 
@@ -202,6 +253,10 @@ class CFileReader {
   // is requested.
   bool do_verify_checksum() const;
 
+  // Callback used in 'bloom_filter_once_' to read the bloom filter of the
+  // values of this cfile.
+  Status LoadBloomFilterOnce(const fs::IOContext* io_context);
+
   // Returns the memory usage of the object including the object itself.
   size_t memory_footprint() const;
 
@@ -209,6 +264,18 @@ class CFileReader {
   // corruption should call this method before returning.
   void HandleCorruption(const fs::IOContext* io_context) const;
 
+  // Decompresses the block 'compressed' read from 'ptr' into a buffer owned
+  // by 'ret'.
+  Status DecompressIntoOwnedBlock(const BlockPointer& ptr,
+                                  Slice compressed,
+                                  scoped_refptr<BlockHandle>* ret) const;
+
+  // Refills 'read_ahead' with a single read of the block pointed to by 'ptr'
+  // and of the blocks of 'read_ahead->next_blocks' which follow it closely.
+  Status FillReadAhead(const fs::IOContext* io_context,
+                       const BlockPointer& ptr,
+                       ReadAheadBuffer* read_ahead) const;
+
   const std::unique_ptr<fs::ReadableBlock> block_;
   const uint64_t file_size_;
 
@@ -224,6 +291,10 @@ class CFileReader {
 
   KuduOnceLambda init_once_;
 
+  // The bloom filter of the values of this cfile, once loaded.
+  KuduOnceLambda bloom_filter_once_;
+  std::unique_ptr<BlockBloomFilter> bloom_filter_;
+
   ScopedTrackedConsumption mem_consumption_;
 };
 
@@ -410,6 +481,11 @@ class CFileIterator final : public ColumnIterator {
     return codewords_matching_pred_.get();
   }
 
+  // Returns the number of codewords set in GetCodeWordsMatchingPredicate().
+  size_t GetNumCodeWordsMatchingPredicate() const {
+    return num_codewords_matching_pred_;
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(CFileIterator);
 
@@ -446,6 +522,11 @@ class CFileIterator final : public ColumnIterator {
     Slice rle_bitmap;
     RleDecoder<bool> rle_decoder_;
 
+    // Whether the block has null cells. The blocks of a nullable column
+    // whose cells are all non-null are read like the blocks of non-nullable
+    // columns, without decoding their null bitmap.
+    bool has_nulls_;
+
     rowid_t last_row_idx() const {
       return first_row_idx() + num_rows_in_block_ - 1;
     }
@@ -471,6 +552,15 @@ class CFileIterator final : public ColumnIterator {
   // seek-related state.
   Status PrepareForNewSeek();
 
+  // Read and parse the zone maps of the cfile's data blocks.
+  Status LoadZoneMaps();
+
+  // Returns true if the zone map of the given block shows that none of the
+  // block's rows can satisfy 'pred'.
+  //
+  // REQUIRES: the zone maps are loaded.
+  bool CanSkipBlock(const PreparedBlock& pb, const ColumnPredicate& pred) const;
+
   CFileReader* reader_;
 
   std::unique_ptr<IndexTreeIterator> posidx_iter_;
@@ -482,6 +572,11 @@ class CFileIterator final : public ColumnIterator {
 
   // Set containing the codewords that match the predicate in a dictionary.
   std::unique_ptr<SelectionVector> codewords_matching_pred_;
+  size_t num_codewords_matching_pred_;
+
+  // Zone maps of the cfile's data blocks, loaded on the first scan which
+  // may use them.
+  std::unique_ptr<ZoneMapsPB> zone_maps_;
 
   // The currently in-use index iterator. This is equal to either
   // posidx_iter_.get(), validx_iter_.get(), or NULL if not seeked.
@@ -515,6 +610,9 @@ class CFileIterator final : public ColumnIterator {
 
   // a temporary buffer for encoding
   faststring tmp_buf_;
+
+  // The data blocks read ahead of the iterator: see --cfile_read_ahead_blocks.
+  ReadAheadBuffer read_ahead_;
 };
 
 } // namespace cfile
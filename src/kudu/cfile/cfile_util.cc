@@ -47,7 +47,16 @@ WriterOptions::WriterOptions()
     write_posidx(false),
     write_validx(false),
     optimize_index_keys(true),
-    validx_key_encoder(std::nullopt) {
+    validx_key_encoder(std::nullopt),
+    write_bloom_filter(false),
+    collect_value_stats(false) {
+}
+
+Slice BloomFilterKeyForCell(const TypeInfo* type_info, const void* cell) {
+  if (type_info->physical_type() == BINARY) {
+    return *reinterpret_cast<const Slice*>(cell);
+  }
+  return Slice(reinterpret_cast<const uint8_t*>(cell), type_info->size());
 }
 
 Status DumpIterator(const CFileReader& reader,
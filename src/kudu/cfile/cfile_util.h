@@ -52,6 +52,11 @@ enum IncompatibleFeatures {
 
 typedef std::function<void(const void*, faststring*)> ValidxKeyEncoder;
 
+// Returns the bytes of the cell at 'cell' which are hashed into the bloom
+// filter of a cfile's values: the referenced data for BINARY cells, and the
+// cell itself otherwise.
+Slice BloomFilterKeyForCell(const TypeInfo* type_info, const void* cell);
+
 struct WriterOptions {
   // Approximate size of index blocks.
   //
@@ -87,6 +92,18 @@ struct WriterOptions {
   // encodes the entire value.
   std::optional<ValidxKeyEncoder> validx_key_encoder;
 
+  // Whether to write a bloom filter of the file's non-NULL values, allowing
+  // readers to rule out the presence of values without reading data blocks.
+  //
+  // Default: false
+  bool write_bloom_filter;
+
+  // Whether to collect statistics of the file's values while it's written:
+  // see CFileWriter::GetValueStats().
+  //
+  // Default: false
+  bool collect_value_stats;
+
   WriterOptions();
 };
 
@@ -17,6 +17,7 @@
 
 #include "kudu/cfile/cfile_writer.h"
 
+#include <algorithm>
 #include <functional>
 #include <iterator>
 #include <numeric>
@@ -40,13 +41,18 @@
 #include "kudu/common/types.h"
 #include "kudu/gutil/port.h"
 #include "kudu/util/array_view.h" // IWYU pragma: keep
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/block_bloom_filter.pb.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/coding-inl.h"
 #include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/hash.pb.h"
+#include "kudu/util/hash_util.h"
 #include "kudu/util/hexdump.h"
+#include "kudu/util/hyperloglog.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/pb_util.h"
 
@@ -61,6 +67,24 @@ DEFINE_bool(cfile_write_checksums, true,
             "Write CRC32 checksums for each block");
 TAG_FLAG(cfile_write_checksums, evolving);
 
+DEFINE_bool(cfile_write_zone_maps, false,
+            "Whether to record the smallest and the largest value of each data "
+            "block of fixed-width columns, allowing scans to skip the data blocks "
+            "which can't match their predicates");
+TAG_FLAG(cfile_write_zone_maps, experimental);
+
+DEFINE_double(cfile_bloom_filter_fp_rate, 0.01,
+              "Target false positive rate of the bloom filters of the values of "
+              "the columns which are written with one");
+TAG_FLAG(cfile_bloom_filter_fp_rate, advanced);
+DEFINE_validator(cfile_bloom_filter_fp_rate, [](const char* flagname, double value) {
+  if (value > 0 && value < 1) {
+    return true;
+  }
+  LOG(ERROR) << flagname << " must be within (0, 1): " << value;
+  return false;
+});
+
 using google::protobuf::RepeatedPtrField;
 using kudu::fs::BlockCreationTransaction;
 using kudu::fs::BlockManager;
@@ -96,6 +120,10 @@ CFileWriter::CFileWriter(WriterOptions options,
     options_(std::move(options)),
     is_nullable_(is_nullable),
     typeinfo_(typeinfo),
+    zone_map_has_values_(false),
+    zone_map_null_count_(0),
+    stats_has_values_(false),
+    stats_null_count_(0),
     state_(kWriterInitialized) {
   EncodingType encoding = options_.storage_attributes.encoding;
   Status s = TypeEncodingInfo::Get(typeinfo_, encoding, &type_encoding_info_);
@@ -138,6 +166,17 @@ CFileWriter::CFileWriter(WriterOptions options,
 
     validx_builder_.reset(new IndexTreeBuilder(&options_, this));
   }
+
+  // Zone maps are only useful for files which are read through the
+  // positional index, and they aren't recorded for variable-length values
+  // which may be arbitrarily large.
+  if (FLAGS_cfile_write_zone_maps && options_.write_posidx &&
+      typeinfo_->physical_type() != BINARY) {
+    zone_maps_.reset(new ZoneMapsPB);
+  }
+  if (options_.collect_value_stats) {
+    stats_distinct_values_.reset(new HyperLogLog);
+  }
 }
 
 CFileWriter::~CFileWriter() {
@@ -150,7 +189,8 @@ Status CFileWriter::Start() {
 
   if (compression_ != NO_COMPRESSION) {
     const CompressionCodec* codec;
-    RETURN_NOT_OK(GetCompressionCodec(compression_, &codec));
+    RETURN_NOT_OK(GetCompressionCodec(
+        compression_, options_.storage_attributes.compression_level, &codec));
     block_compressor_.reset(new CompressedBlockBuilder(codec));
   }
 
@@ -237,6 +277,21 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
     footer.mutable_validx_info()->CopyFrom(validx_info);
   }
 
+  if (zone_maps_ && zone_maps_->zone_maps_size() > 0) {
+    faststring buf;
+    pb_util::SerializeToString(*zone_maps_, &buf);
+    BlockPointer ptr;
+    RETURN_NOT_OK_PREPEND(AddBlock({ Slice(buf) }, &ptr, "zone maps block"),
+                          "Couldn't write zone maps");
+    ptr.CopyToPB(footer.mutable_zone_maps_block_ptr());
+  }
+
+  if (options_.write_bloom_filter) {
+    BlockPointer ptr;
+    RETURN_NOT_OK_PREPEND(WriteBloomFilter(&ptr), "Couldn't write bloom filter");
+    ptr.CopyToPB(footer.mutable_bloom_filter_block_ptr());
+  }
+
   // Optionally append extra information to the end of cfile.
   // Example: dictionary block for dictionary encoding
   RETURN_NOT_OK(data_block_->AppendExtraInfo(this, &footer));
@@ -304,6 +359,15 @@ Status CFileWriter::AppendEntries(const void *entries, size_t count) {
   while (rem > 0) {
     int n = data_block_->Add(ptr, rem);
     DCHECK_GE(n, 0);
+    if (zone_maps_) {
+      UpdateZoneMap(ptr, n);
+    }
+    if (options_.write_bloom_filter) {
+      AddToBloomFilter(ptr, n);
+    }
+    if (stats_distinct_values_) {
+      UpdateValueStats(ptr, n);
+    }
 
     ptr += typeinfo_->size() * n;
     rem -= n;
@@ -334,6 +398,15 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
       do {
         int n = data_block_->Add(ptr, rem);
         DCHECK_GE(n, 0);
+        if (zone_maps_) {
+          UpdateZoneMap(ptr, n);
+        }
+        if (options_.write_bloom_filter) {
+          AddToBloomFilter(ptr, n);
+        }
+        if (stats_distinct_values_) {
+          UpdateValueStats(ptr, n);
+        }
 
         non_null_bitmap_builder_->AddRun(true, n);
         ptr += n * typeinfo_->size();
@@ -347,6 +420,8 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
       } while (rem > 0);
     } else {
       non_null_bitmap_builder_->AddRun(false, nitems);
+      zone_map_null_count_ += nitems;
+      stats_null_count_ += nitems;
       ptr += nitems * typeinfo_->size();
       value_count_ += nitems;
     }
@@ -407,6 +482,19 @@ Status CFileWriter::FinishCurDataBlock() {
     non_null_bitmap_builder_->Reset();
   }
 
+  if (zone_maps_) {
+    auto* zone_map = zone_maps_->add_zone_maps();
+    zone_map->set_first_ordinal(first_elem_ord);
+    zone_map->set_num_rows(num_elems_in_block);
+    zone_map->set_null_count(zone_map_null_count_);
+    if (zone_map_has_values_) {
+      zone_map->set_min_value(zone_map_min_.data(), zone_map_min_.size());
+      zone_map->set_max_value(zone_map_max_.data(), zone_map_max_.size());
+    }
+    zone_map_has_values_ = false;
+    zone_map_null_count_ = 0;
+  }
+
   if (validx_builder_ != nullptr) {
     RETURN_NOT_OK(data_block_->GetLastKey(key_tmp_space));
     (*options_.validx_key_encoder)(key_tmp_space, &last_key_);
@@ -416,6 +504,89 @@ Status CFileWriter::FinishCurDataBlock() {
   return s;
 }
 
+void CFileWriter::UpdateZoneMap(const uint8_t* entries, size_t count) {
+  const size_t size = typeinfo_->size();
+  for (const uint8_t* cell = entries; cell < entries + count * size; cell += size) {
+    if (!zone_map_has_values_) {
+      zone_map_min_.assign_copy(cell, size);
+      zone_map_max_.assign_copy(cell, size);
+      zone_map_has_values_ = true;
+      continue;
+    }
+    if (typeinfo_->Compare(cell, zone_map_min_.data()) < 0) {
+      zone_map_min_.assign_copy(cell, size);
+    } else if (typeinfo_->Compare(cell, zone_map_max_.data()) > 0) {
+      zone_map_max_.assign_copy(cell, size);
+    }
+  }
+}
+
+void CFileWriter::UpdateValueStats(const uint8_t* entries, size_t count) {
+  const size_t size = typeinfo_->size();
+  const bool track_range = typeinfo_->physical_type() != BINARY;
+  for (const uint8_t* cell = entries; cell < entries + count * size; cell += size) {
+    const Slice key = BloomFilterKeyForCell(typeinfo_, cell);
+    stats_distinct_values_->AddHash(HashUtil::FastHash64(key.data(), key.size(), 0));
+    if (!track_range) {
+      continue;
+    }
+    if (!stats_has_values_) {
+      stats_min_.assign_copy(cell, size);
+      stats_max_.assign_copy(cell, size);
+      stats_has_values_ = true;
+    } else if (typeinfo_->Compare(cell, stats_min_.data()) < 0) {
+      stats_min_.assign_copy(cell, size);
+    } else if (typeinfo_->Compare(cell, stats_max_.data()) > 0) {
+      stats_max_.assign_copy(cell, size);
+    }
+  }
+}
+
+CFileValueStats CFileWriter::GetValueStats() const {
+  DCHECK(stats_distinct_values_);
+  CFileValueStats stats;
+  if (stats_has_values_) {
+    stats.min_value = stats_min_.ToString();
+    stats.max_value = stats_max_.ToString();
+  }
+  stats.null_count = stats_null_count_;
+  stats.distinct_count_estimate = stats_distinct_values_->Estimate();
+  return stats;
+}
+
+void CFileWriter::AddToBloomFilter(const uint8_t* entries, size_t count) {
+  const size_t size = typeinfo_->size();
+  for (const uint8_t* cell = entries; cell < entries + count * size; cell += size) {
+    bloom_filter_hashes_.push_back(HashUtil::ComputeHash32(
+        BloomFilterKeyForCell(typeinfo_, cell), FAST_HASH, 0));
+  }
+}
+
+Status CFileWriter::WriteBloomFilter(BlockPointer* ptr) {
+  // Size the filter for the number of distinct hashes: columns which are
+  // worth a bloom filter have many distinct values, but not necessarily as
+  // many as rows.
+  std::sort(bloom_filter_hashes_.begin(), bloom_filter_hashes_.end());
+  bloom_filter_hashes_.erase(std::unique(bloom_filter_hashes_.begin(),
+                                         bloom_filter_hashes_.end()),
+                             bloom_filter_hashes_.end());
+  BlockBloomFilter bf(DefaultBlockBloomFilterBufferAllocator::GetSingleton());
+  RETURN_NOT_OK(bf.Init(BlockBloomFilter::MinLogSpace(
+                            std::max<size_t>(1, bloom_filter_hashes_.size()),
+                            FLAGS_cfile_bloom_filter_fp_rate),
+                        FAST_HASH, 0));
+  for (uint32_t hash : bloom_filter_hashes_) {
+    bf.Insert(hash);
+  }
+  vector<uint32_t>().swap(bloom_filter_hashes_);
+
+  BlockBloomFilterPB bf_pb;
+  bf.CopyToPB(&bf_pb);
+  faststring buf;
+  pb_util::SerializeToString(bf_pb, &buf);
+  return AddBlock({ Slice(buf) }, ptr, "bloom filter block");
+}
+
 Status CFileWriter::AppendRawBlock(vector<Slice> data_slices,
                                    size_t ordinal_pos,
                                    const void* validx_curr,
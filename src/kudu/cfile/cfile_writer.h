@@ -19,6 +19,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -37,6 +38,7 @@
 
 namespace kudu {
 
+class HyperLogLog;
 class TypeInfo;
 
 namespace cfile {
@@ -47,6 +49,7 @@ class CompressedBlockBuilder;
 class FileMetadataPairPB;
 class IndexTreeBuilder;
 class TypeEncodingInfo;
+class ZoneMapsPB;
 
 // Magic used in header/footer
 extern const char kMagicStringV1[];
@@ -89,6 +92,20 @@ class NullBitmapBuilder {
   RleEncoder<bool> rle_encoder_;
 };
 
+// Statistics of the values appended to a CFileWriter.
+struct CFileValueStats {
+  // The smallest and largest non-NULL values, in the in-memory format of their
+  // cells. Not set if all the values are NULL, or for variable-length types.
+  std::optional<std::string> min_value;
+  std::optional<std::string> max_value;
+
+  // The number of NULL cells.
+  uint64_t null_count = 0;
+
+  // An estimate of the number of distinct non-NULL values.
+  uint64_t distinct_count_estimate = 0;
+};
+
 // Main class used to write a CFile.
 class CFileWriter {
  public:
@@ -164,6 +181,11 @@ class CFileWriter {
     return value_count_;
   }
 
+  // Returns the statistics of the values appended so far.
+  //
+  // REQUIRES: the writer was created with WriterOptions::collect_value_stats.
+  CFileValueStats GetValueStats() const;
+
   std::string ToString() const { return block_->id().ToString(); }
 
   fs::WritableBlock* block() const { return block_.get(); }
@@ -191,6 +213,22 @@ class CFileWriter {
 
   Status FinishCurDataBlock();
 
+  // Accounts the 'count' non-NULL cells at 'entries' in the zone map of the
+  // current data block.
+  void UpdateZoneMap(const uint8_t* entries, size_t count);
+
+  // Accounts the 'count' non-NULL cells at 'entries' in the statistics of the
+  // file's values.
+  void UpdateValueStats(const uint8_t* entries, size_t count);
+
+  // Accounts the 'count' non-NULL cells at 'entries' in the bloom filter of
+  // the file's values.
+  void AddToBloomFilter(const uint8_t* entries, size_t count);
+
+  // Builds the bloom filter of the file's values and appends it to the file,
+  // setting '*ptr' to its block.
+  Status WriteBloomFilter(BlockPointer* ptr);
+
   // Flush the current unflushed_metadata_ entries into the given protobuf
   // field, clearing the buffer.
   void FlushMetadataToPB(google::protobuf::RepeatedPtrField<FileMetadataPairPB> *field);
@@ -228,6 +266,31 @@ class CFileWriter {
   std::unique_ptr<NullBitmapBuilder> non_null_bitmap_builder_;
   std::unique_ptr<CompressedBlockBuilder> block_compressor_;
 
+  // Zone maps of the data blocks written so far, if the writer records them.
+  std::unique_ptr<ZoneMapsPB> zone_maps_;
+
+  // The zone map of the current data block: its smallest and largest values
+  // (if 'zone_map_has_values_' is true), and the number of NULL cells.
+  faststring zone_map_min_;
+  faststring zone_map_max_;
+  bool zone_map_has_values_;
+  uint32_t zone_map_null_count_;
+
+  // The hashes of the non-NULL values written so far, if the writer writes a
+  // bloom filter. The filter is only built when the file is finished, once
+  // the number of distinct values is known.
+  std::vector<uint32_t> bloom_filter_hashes_;
+
+  // The statistics of the values appended so far, if the writer collects
+  // them: the sketch of their distinct values, their smallest and largest
+  // values (if 'stats_has_values_' is true and they're fixed-size), and the
+  // number of NULL cells.
+  std::unique_ptr<HyperLogLog> stats_distinct_values_;
+  faststring stats_min_;
+  faststring stats_max_;
+  bool stats_has_values_;
+  uint64_t stats_null_count_;
+
   enum State {
     kWriterInitialized,
     kWriterWriting,
@@ -34,10 +34,12 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include "kudu/cfile/adaptive_block.h"
 #include "kudu/cfile/binary_plain_block.h"
 #include "kudu/cfile/binary_prefix_block.h"
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/block_handle.h"
+#include "kudu/cfile/cfile.pb.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/type_encodings.h"
 #include "kudu/common/columnblock-test-util.h"
@@ -46,6 +48,7 @@
 #include "kudu/common/rowblock_memory.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
+#include "kudu/gutil/casts.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -783,6 +786,36 @@ TEST_F(TestEncoding, TestBShufDoubleBlockEncoder) {
   TestEncodeDecodeTemplateBlockEncoder<DOUBLE>(doubles.get(), kSize, BIT_SHUFFLE);
 }
 
+TEST_F(TestEncoding, TestFrameOfReferenceInt64BlockEncoder) {
+  // Increasing timestamps with some jitter: each miniblock should be encoded
+  // with few bits per value.
+  Random rng(SeedRandom());
+  vector<int64_t> ints(10000);
+  int64_t ts = 1600000000000000L;
+  for (auto& v : ints) {
+    ts += 1000 + rng.Uniform(16);
+    v = ts;
+  }
+  TestEncodeDecodeTemplateBlockEncoder<INT64>(ints.data(), ints.size(), FRAME_OF_REFERENCE);
+
+  auto bb = CreateBlockBuilderOrDie(INT64, FRAME_OF_REFERENCE);
+  bb->Add(reinterpret_cast<const uint8_t*>(ints.data()), ints.size());
+  scoped_refptr<BlockHandle> block = FinishAndMakeContiguous(bb.get(), 0);
+  ASSERT_LT(block->data().size(), ints.size() * sizeof(int64_t) / 4);
+
+  // Also exercise the extremes of the type's range.
+  for (auto& v : ints) {
+    v = static_cast<int64_t>(rng.Next64());
+  }
+  ints[0] = std::numeric_limits<int64_t>::min();
+  ints[1] = std::numeric_limits<int64_t>::max();
+  TestEncodeDecodeTemplateBlockEncoder<INT64>(ints.data(), ints.size(), FRAME_OF_REFERENCE);
+}
+
+TEST_F(TestEncoding, TestFrameOfReferenceEmptyBlockEncodeDecode) {
+  TestEmptyBlockEncodeDecode(INT32, FRAME_OF_REFERENCE);
+}
+
 TEST_F(TestEncoding, TestRleIntBlockEncoder) {
   auto ibb = CreateBlockBuilderOrDie(UINT32, RLE);
   Random rand(SeedRandom());
@@ -811,6 +844,10 @@ TEST_F(TestEncoding, TestRleBitMapRoundTrip) {
   TestBoolBlockRoundTrip(RLE);
 }
 
+TEST_F(TestEncoding, TestAdaptiveBitMapRoundTrip) {
+  TestBoolBlockRoundTrip(ADAPTIVE);
+}
+
 // Test seeking to a value in a small block.
 // Regression test for a bug seen in development where this would
 // infinite loop when there are no 'restarts' in a given block.
@@ -859,6 +896,127 @@ TEST_F(TestEncoding, TestBinaryPrefixBlockBuilderTruncation) {
   TestBinaryBlockTruncation<BinaryPrefixBlockDecoder>(PREFIX_ENCODING);
 }
 
+TEST_F(TestEncoding, TestBinaryFsstBlockBuilderSeekByValueSmallBlock) {
+  TestBinarySeekByValueSmallBlock(FSST);
+}
+
+TEST_F(TestEncoding, TestBinaryFsstBlockBuilderSeekByValueLargeBlock) {
+  TestStringSeekByValueLargeBlock(FSST);
+}
+
+TEST_F(TestEncoding, TestBinaryFsstBlockBuilderRoundTrip) {
+  TestBinaryBlockRoundTrip(FSST);
+}
+
+TEST_F(TestEncoding, TestBinaryFsstEmptyBlockEncodeDecode) {
+  TestEmptyBlockEncodeDecode(BINARY, FSST);
+}
+
+// Any truncation of an FSST block should be detected as corruption.
+TEST_F(TestEncoding, TestBinaryFsstBlockBuilderTruncation) {
+  auto sbb = CreateBlockBuilderOrDie(BINARY, FSST);
+  scoped_refptr<BlockHandle> block = CreateBinaryBlock(
+      sbb.get(), 10, [](int item) { return StringPrintf("hello %d", item); });
+  ASSERT_OK(CreateBlockDecoderOrDie(BINARY, FSST, block)->ParseHeader());
+  for (size_t size = block->data().size() - 1; size > 0; size--) {
+    SCOPED_TRACE(size);
+    auto sbd = CreateBlockDecoderOrDie(BINARY, FSST, block->SubrangeBlock(0, size));
+    Status s = sbd->ParseHeader();
+    ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+  }
+}
+
+// URL-like strings share many substrings, which the symbol table captures.
+TEST_F(TestEncoding, TestBinaryFsstCompressesUrls) {
+  const vector<string> kHosts = { "www.example.com", "cdn.images.example.net", "api.example.io" };
+  const vector<string> kPaths = { "/index.html", "/products/item?id=", "/search?q=", "/user/" };
+  Random r(SeedRandom());
+  size_t raw_size = 0;
+  auto sbb = CreateBlockBuilderOrDie(BINARY, FSST);
+  scoped_refptr<BlockHandle> block = CreateBinaryBlock(
+      sbb.get(), 5000, [&](int /*item*/) {
+        string url = "https://" + kHosts[r.Uniform(kHosts.size())] +
+            kPaths[r.Uniform(kPaths.size())] + std::to_string(r.Uniform(100000));
+        raw_size += url.size();
+        return url;
+      });
+  LOG(INFO) << "FSST encoded " << raw_size << " bytes of URLs in "
+            << block->data().size() << " bytes";
+  ASSERT_LT(block->data().size(), raw_size / 2);
+}
+
+TEST_F(TestEncoding, TestBinaryAdaptiveBlockBuilderSeekByValueSmallBlock) {
+  TestBinarySeekByValueSmallBlock(ADAPTIVE);
+}
+
+TEST_F(TestEncoding, TestBinaryAdaptiveBlockBuilderSeekByValueLargeBlock) {
+  TestStringSeekByValueLargeBlock(ADAPTIVE);
+}
+
+TEST_F(TestEncoding, TestBinaryAdaptiveBlockBuilderRoundTrip) {
+  TestBinaryBlockRoundTrip(ADAPTIVE);
+}
+
+TEST_F(TestEncoding, TestAdaptiveEmptyBlockEncodeDecode) {
+  TestEmptyBlockEncodeDecode(INT32, ADAPTIVE);
+  TestEmptyBlockEncodeDecode(BINARY, ADAPTIVE);
+}
+
+// Adaptive encoding chooses the smallest encoding for each block, and records
+// its choices in the footer.
+TEST_F(TestEncoding, TestAdaptiveChoosesEncodingPerBlock) {
+  const int kCount = 1000;
+  Random r(SeedRandom());
+  vector<uint32_t> runs(kCount, 42);
+  vector<uint32_t> random_ints(kCount);
+  for (auto& v : random_ints) {
+    v = r.Next32();
+  }
+
+  auto bb = CreateBlockBuilderOrDie(UINT32, ADAPTIVE);
+  vector<EncodingType> chosen;
+  for (const auto* ints : { &runs, &random_ints }) {
+    ASSERT_EQ(kCount, bb->Add(reinterpret_cast<const uint8_t*>(ints->data()), kCount));
+    auto bd = CreateBlockDecoderOrDie(UINT32, ADAPTIVE, FinishAndMakeContiguous(bb.get(), 0));
+    ASSERT_OK(bd->ParseHeader());
+    chosen.emplace_back(down_cast<AdaptiveBlockDecoder*>(bd.get())->encoding());
+
+    vector<uint32_t> decoded(kCount);
+    ColumnBlock cb(GetTypeInfo(UINT32), nullptr, decoded.data(), kCount, &memory_);
+    ColumnDataView cdv(&cb);
+    size_t n = kCount;
+    ASSERT_OK(bd->CopyNextValues(&n, &cdv));
+    ASSERT_EQ(kCount, n);
+    ASSERT_EQ(*ints, decoded);
+    bb->Reset();
+  }
+  ASSERT_EQ(RLE, chosen[0]);
+  ASSERT_NE(RLE, chosen[1]);
+
+  CFileFooterPB footer;
+  ASSERT_OK(bb->AppendExtraInfo(nullptr, &footer));
+  int num_blocks = 0;
+  for (const auto& count : footer.block_encoding_counts()) {
+    num_blocks += count.num_blocks();
+  }
+  ASSERT_EQ(2, num_blocks);
+}
+
+// A block whose header names an encoding which can't be chosen for the type
+// is corrupt.
+TEST_F(TestEncoding, TestAdaptiveBadHeader) {
+  for (uint8_t encoding : { static_cast<uint8_t>(DICT_ENCODING), static_cast<uint8_t>(255) }) {
+    auto bd = CreateBlockDecoderOrDie(
+        UINT32, ADAPTIVE, BlockHandle::WithOwnedData(Slice(new uint8_t[1]{encoding}, 1)));
+    Status s = bd->ParseHeader();
+    ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+  }
+  auto bd = CreateBlockDecoderOrDie(UINT32, ADAPTIVE, BlockHandle::WithOwnedData(Slice()));
+  Status s = bd->ParseHeader();
+  ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "not enough bytes for header");
+}
+
 class IntEncodingTest : public TestEncoding, public ::testing::WithParamInterface<EncodingType> {
  public:
   template <DataType IntType>
@@ -879,7 +1037,8 @@ class IntEncodingTest : public TestEncoding, public ::testing::WithParamInterfac
   }
 };
 INSTANTIATE_TEST_SUITE_P(Encodings, IntEncodingTest,
-                         ::testing::Values(RLE, PLAIN_ENCODING, BIT_SHUFFLE));
+                         ::testing::Values(RLE, PLAIN_ENCODING, BIT_SHUFFLE,
+                                           FRAME_OF_REFERENCE, ADAPTIVE));
 
 TEST_P(IntEncodingTest, TestSeekAllTypes) {
   this->template DoIntSeekTest<UINT8>(100, 1000, true);
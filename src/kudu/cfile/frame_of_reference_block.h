@@ -0,0 +1,534 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/block_handle.h"
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/coding-inl.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace cfile {
+
+// Frame-of-reference encoding for integer types.
+//
+// The values of a block are split into miniblocks of up to
+// kForMiniBlockSize values, each of which is bit-packed on the smallest
+// width which fits either:
+//  - (FOR mode) the difference of each value with the miniblock's minimum, or
+//  - (DELTA mode, only for non-decreasing miniblocks) the difference of each
+//    value with the previous one, minus the smallest such difference.
+//
+// Block layout:
+//   num_elems (uint32), ordinal_pos (uint32)
+//   miniblock 0 ... miniblock N-1
+//   kForBlockPadding zero bytes, so that the decoder may use unaligned 64-bit
+//   loads past the end of the packed data.
+//
+// Miniblock layout:
+//   header byte: kForDeltaModeBit | bit width
+//   min (CppType): the smallest (and, in DELTA mode, the first) value
+//   max (CppType): the largest (and, in DELTA mode, the last) value
+//   min_delta (CppType): only in DELTA mode
+//   packed data: ceil(count * width / 8) bytes, LSB first. In DELTA mode the
+//   slot of the first value is always zero.
+//
+// Since each miniblock header stores its value range, the decoder can skip
+// whole miniblocks when seeking by value or when evaluating predicates,
+// without unpacking them.
+static const size_t kForBlockHeaderSize = sizeof(uint32_t) * 2;
+static const size_t kForMiniBlockSize = 128;
+static const size_t kForBlockPadding = sizeof(uint64_t) * 2;
+static const uint8_t kForDeltaModeBit = 0x80;
+static const uint8_t kForWidthMask = 0x7f;
+
+namespace for_internal {
+
+// Returns the number of bits needed to represent 'v'.
+inline int BitWidth(uint64_t v) {
+  return v == 0 ? 0 : 64 - __builtin_clzll(v);
+}
+
+// Appends 'count' values of 'vals' packed on 'width' bits each to 'buf'.
+template<typename U>
+void PackBits(const U* vals, size_t count, int width, faststring* buf) {
+  const size_t nbytes = (count * width + 7) / 8;
+  const size_t old_size = buf->size();
+  buf->resize(old_size + nbytes);
+  uint8_t* out = buf->data() + old_size;
+  memset(out, 0, nbytes);
+  size_t bit = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t v = vals[i];
+    int written = 0;
+    while (written < width) {
+      const int shift = bit & 7;
+      const int nbits = std::min(8 - shift, width - written);
+      out[bit >> 3] |= static_cast<uint8_t>((v & ((1U << nbits) - 1)) << shift);
+      v >>= nbits;
+      bit += nbits;
+      written += nbits;
+    }
+  }
+}
+
+// Unpacks 'count' values of 'width' bits each from 'in' into 'out'.
+//
+// Reads up to kForBlockPadding bytes past the end of the packed data. The
+// loops have no data-dependent branches so that the compiler can unroll and
+// vectorize them.
+template<typename U>
+void UnpackBits(const uint8_t* in, size_t count, int width, U* out) {
+  if (width == 0) {
+    std::fill(out, out + count, 0);
+    return;
+  }
+  const uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+  if (width <= 56) {
+    // Any value fits in the 64 bits starting at its first byte.
+    for (size_t i = 0; i < count; i++) {
+      const size_t bit = i * width;
+      out[i] = static_cast<U>(
+          (UnalignedLoad<uint64_t>(in + (bit >> 3)) >> (bit & 7)) & mask);
+    }
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      const size_t bit = i * width;
+      const int shift = bit & 7;
+      const uint64_t lo = UnalignedLoad<uint64_t>(in + (bit >> 3)) >> shift;
+      // Split the shift so that it is well-defined when 'shift' is 0.
+      const uint64_t hi = (UnalignedLoad<uint64_t>(in + (bit >> 3) + 8) << 1) << (63 - shift);
+      out[i] = static_cast<U>((lo | hi) & mask);
+    }
+  }
+}
+
+} // namespace for_internal
+
+//
+// A frame-of-reference encoder for integer types.
+//
+template<DataType Type>
+class FrameOfReferenceBlockBuilder final : public BlockBuilder {
+ public:
+  explicit FrameOfReferenceBlockBuilder(const WriterOptions* options)
+      : options_(options) {
+    buffer_.reserve(kForBlockHeaderSize + options_->storage_attributes.cfile_block_size + 1024);
+    pending_.reserve(kForMiniBlockSize);
+    Reset();
+  }
+
+  int Add(const uint8_t* vals_void, size_t count) override {
+    DCHECK(!finished_);
+    const CppType* vals = reinterpret_cast<const CppType*>(vals_void);
+    for (size_t i = 0; i < count; i++) {
+      CppType v = UnalignedLoad<CppType>(&vals[i]);
+      if (count_ == 0) {
+        first_ = v;
+      }
+      last_ = v;
+      pending_.push_back(v);
+      count_++;
+      if (pending_.size() == kForMiniBlockSize) {
+        FlushMiniBlock();
+      }
+    }
+    return count;
+  }
+
+  bool IsBlockFull() const override {
+    return buffer_.size() + pending_.size() * sizeof(CppType) >
+        options_->storage_attributes.cfile_block_size;
+  }
+
+  void Finish(rowid_t ordinal_pos, std::vector<Slice>* slices) override {
+    DCHECK(!finished_);
+    FlushMiniBlock();
+    buffer_.resize(buffer_.size() + kForBlockPadding);
+    memset(buffer_.data() + buffer_.size() - kForBlockPadding, 0, kForBlockPadding);
+    InlineEncodeFixed32(&buffer_[0], count_);
+    InlineEncodeFixed32(&buffer_[4], ordinal_pos);
+    finished_ = true;
+    *slices = { Slice(buffer_) };
+  }
+
+  void Reset() override {
+    count_ = 0;
+    finished_ = false;
+    pending_.clear();
+    buffer_.clear();
+    buffer_.resize(kForBlockHeaderSize);
+  }
+
+  size_t Count() const override {
+    return count_;
+  }
+
+  Status GetFirstKey(void* key) const override {
+    if (count_ == 0) {
+      return Status::NotFound("no keys in data block");
+    }
+    UnalignedStore(key, first_);
+    return Status::OK();
+  }
+
+  Status GetLastKey(void* key) const override {
+    if (count_ == 0) {
+      return Status::NotFound("no keys in data block");
+    }
+    UnalignedStore(key, last_);
+    return Status::OK();
+  }
+
+ private:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  typedef typename std::make_unsigned<CppType>::type UnsignedType;
+
+  void AppendValue(CppType v) {
+    buffer_.append(&v, sizeof(v));
+  }
+
+  // Encodes the pending values as a miniblock.
+  void FlushMiniBlock() {
+    const size_t n = pending_.size();
+    if (n == 0) {
+      return;
+    }
+    CppType min = pending_[0];
+    CppType max = pending_[0];
+    bool sorted = true;
+    for (size_t i = 1; i < n; i++) {
+      min = std::min(min, pending_[i]);
+      max = std::max(max, pending_[i]);
+      sorted &= pending_[i - 1] <= pending_[i];
+    }
+    const int for_width = for_internal::BitWidth(
+        static_cast<UnsignedType>(static_cast<UnsignedType>(max) -
+                                  static_cast<UnsignedType>(min)));
+
+    // In DELTA mode, the deltas of a non-decreasing sequence are the exact
+    // (non-negative) differences of consecutive values.
+    UnsignedType min_delta = 0;
+    int delta_width = for_width;
+    if (sorted && n > 1) {
+      min_delta = static_cast<UnsignedType>(-1);
+      UnsignedType max_delta = 0;
+      for (size_t i = 1; i < n; i++) {
+        packed_[i] = static_cast<UnsignedType>(static_cast<UnsignedType>(pending_[i]) -
+                                               static_cast<UnsignedType>(pending_[i - 1]));
+        min_delta = std::min(min_delta, packed_[i]);
+        max_delta = std::max(max_delta, packed_[i]);
+      }
+      delta_width = for_internal::BitWidth(static_cast<UnsignedType>(max_delta - min_delta));
+    }
+
+    if (delta_width < for_width) {
+      buffer_.push_back(static_cast<char>(kForDeltaModeBit | delta_width));
+      AppendValue(min);
+      AppendValue(max);
+      AppendValue(static_cast<CppType>(min_delta));
+      packed_[0] = 0;
+      for (size_t i = 1; i < n; i++) {
+        packed_[i] -= min_delta;
+      }
+      for_internal::PackBits(packed_, n, delta_width, &buffer_);
+    } else {
+      buffer_.push_back(static_cast<char>(for_width));
+      AppendValue(min);
+      AppendValue(max);
+      for (size_t i = 0; i < n; i++) {
+        packed_[i] = static_cast<UnsignedType>(static_cast<UnsignedType>(pending_[i]) -
+                                               static_cast<UnsignedType>(min));
+      }
+      for_internal::PackBits(packed_, n, for_width, &buffer_);
+    }
+    pending_.clear();
+  }
+
+  const WriterOptions* options_;
+  faststring buffer_;
+  std::vector<CppType> pending_;
+  UnsignedType packed_[kForMiniBlockSize];
+  size_t count_;
+  bool finished_;
+  CppType first_;
+  CppType last_;
+};
+
+//
+// A frame-of-reference decoder for integer types.
+//
+template<DataType Type>
+class FrameOfReferenceBlockDecoder final : public BlockDecoder {
+ public:
+  explicit FrameOfReferenceBlockDecoder(scoped_refptr<BlockHandle> block)
+      : block_(std::move(block)),
+        data_(block_->data()),
+        parsed_(false),
+        num_elems_(0),
+        ordinal_pos_base_(0),
+        cur_idx_(0),
+        decoded_mini_block_(-1) {
+  }
+
+  Status ParseHeader() override {
+    CHECK(!parsed_);
+
+    if (data_.size() < kForBlockHeaderSize + kForBlockPadding) {
+      return Status::Corruption(
+          "not enough bytes for header in FrameOfReferenceBlockDecoder");
+    }
+    num_elems_ = DecodeFixed32(&data_[0]);
+    ordinal_pos_base_ = DecodeFixed32(&data_[4]);
+
+    const size_t data_end = data_.size() - kForBlockPadding;
+    const size_t num_mini_blocks = (num_elems_ + kForMiniBlockSize - 1) / kForMiniBlockSize;
+    mini_block_offsets_.clear();
+    mini_block_mins_.clear();
+    mini_block_maxes_.clear();
+    mini_block_offsets_.reserve(num_mini_blocks);
+    mini_block_mins_.reserve(num_mini_blocks);
+    mini_block_maxes_.reserve(num_mini_blocks);
+    size_t offset = kForBlockHeaderSize;
+    for (size_t i = 0; i < num_mini_blocks; i++) {
+      if (offset + 1 + 2 * sizeof(CppType) > data_end) {
+        return Status::Corruption(strings::Substitute(
+            "miniblock $0 header past the end of the block", i));
+      }
+      const uint8_t mode = data_[offset];
+      const int width = mode & kForWidthMask;
+      const size_t header_size = 1 + sizeof(CppType) *
+          ((mode & kForDeltaModeBit) ? 3 : 2);
+      if (width > kTypeBits) {
+        return Status::Corruption(strings::Substitute(
+            "invalid bit width $0 in miniblock $1", width, i));
+      }
+      const size_t count = MiniBlockCount(i);
+      const size_t packed_size = (count * width + 7) / 8;
+      if (offset + header_size + packed_size > data_end) {
+        return Status::Corruption(strings::Substitute(
+            "miniblock $0 data past the end of the block", i));
+      }
+      mini_block_offsets_.push_back(offset);
+      mini_block_mins_.push_back(UnalignedLoad<CppType>(&data_[offset + 1]));
+      mini_block_maxes_.push_back(
+          UnalignedLoad<CppType>(&data_[offset + 1 + sizeof(CppType)]));
+      offset += header_size + packed_size;
+    }
+    if (offset != data_end) {
+      return Status::Corruption(strings::Substitute(
+          "unexpected data size: $0 bytes of miniblocks for $1 bytes of data",
+          offset - kForBlockHeaderSize, data_end - kForBlockHeaderSize));
+    }
+
+    parsed_ = true;
+    SeekToPositionInBlock(0);
+    return Status::OK();
+  }
+
+  void SeekToPositionInBlock(uint pos) override {
+    CHECK(parsed_) << "Must call ParseHeader()";
+    DCHECK_LE(pos, num_elems_);
+    cur_idx_ = pos;
+  }
+
+  // Assumes the values of the block are sorted, like all the other decoders.
+  Status SeekAtOrAfterValue(const void* value, bool* exact_match) override {
+    DCHECK(value != nullptr);
+    const CppType target = UnalignedLoad<CppType>(value);
+
+    // Find the first miniblock whose largest value isn't less than 'target'.
+    auto it = std::lower_bound(mini_block_maxes_.begin(), mini_block_maxes_.end(), target);
+    if (it == mini_block_maxes_.end()) {
+      cur_idx_ = num_elems_;
+      *exact_match = false;
+      return Status::NotFound("after last key in block");
+    }
+    const size_t mb = it - mini_block_maxes_.begin();
+    const CppType* vals = DecodeMiniBlock(mb);
+    const CppType* end = vals + MiniBlockCount(mb);
+    const CppType* pos = std::lower_bound(vals, end, target);
+    *exact_match = pos != end && *pos == target;
+    cur_idx_ = mb * kForMiniBlockSize + (pos - vals);
+    if (PREDICT_FALSE(cur_idx_ == num_elems_)) {
+      return Status::NotFound("after last key in block");
+    }
+    return Status::OK();
+  }
+
+  Status CopyNextValues(size_t* n, ColumnDataView* dst) override {
+    DCHECK(parsed_);
+    DCHECK_LE(*n, dst->nrows());
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+
+    const size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    CppType* out = reinterpret_cast<CppType*>(dst->data());
+    size_t copied = 0;
+    while (copied < max_fetch) {
+      const size_t mb = cur_idx_ / kForMiniBlockSize;
+      const size_t off = cur_idx_ % kForMiniBlockSize;
+      const size_t count = MiniBlockCount(mb);
+      const size_t take = std::min(max_fetch - copied, count - off);
+      if (off == 0 && take == count && mb != decoded_mini_block_) {
+        // The whole miniblock is consumed: unpack it in place.
+        DecodeMiniBlockTo(mb, out + copied);
+      } else {
+        memcpy(out + copied, DecodeMiniBlock(mb) + off, take * sizeof(CppType));
+      }
+      copied += take;
+      cur_idx_ += take;
+    }
+    *n = max_fetch;
+    return Status::OK();
+  }
+
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) override {
+    DCHECK(parsed_);
+    DCHECK_LE(*n, dst->nrows());
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    ctx->SetDecoderEvalSupported();
+
+    const ColumnPredicate* pred = ctx->pred();
+    const size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    CppType* out = reinterpret_cast<CppType*>(dst->data());
+    size_t copied = 0;
+    while (copied < max_fetch) {
+      const size_t mb = cur_idx_ / kForMiniBlockSize;
+      const size_t off = cur_idx_ % kForMiniBlockSize;
+      const size_t take = std::min(max_fetch - copied, MiniBlockCount(mb) - off);
+      if (!pred->MayMatchRange(&mini_block_mins_[mb], &mini_block_maxes_[mb])) {
+        // None of the values of the miniblock can match: skip it without
+        // unpacking it. The cells of deselected rows are never read.
+        sel->ClearBits(take, copied);
+      } else {
+        memcpy(out + copied, DecodeMiniBlock(mb) + off, take * sizeof(CppType));
+        for (size_t i = copied; i < copied + take; i++) {
+          if (sel->TestBit(i) && !pred->EvaluateCell<Type>(out + i)) {
+            sel->ClearBit(i);
+          }
+        }
+      }
+      copied += take;
+      cur_idx_ += take;
+    }
+    *n = max_fetch;
+    return Status::OK();
+  }
+
+  bool HasNext() const override {
+    return cur_idx_ < num_elems_;
+  }
+
+  size_t Count() const override {
+    return num_elems_;
+  }
+
+  size_t GetCurrentIndex() const override {
+    return cur_idx_;
+  }
+
+  rowid_t GetFirstRowId() const override {
+    return ordinal_pos_base_;
+  }
+
+ private:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  typedef typename std::make_unsigned<CppType>::type UnsignedType;
+  enum {
+    kTypeBits = sizeof(CppType) * 8
+  };
+
+  size_t MiniBlockCount(size_t mb) const {
+    return std::min(kForMiniBlockSize, num_elems_ - mb * kForMiniBlockSize);
+  }
+
+  // Returns the values of miniblock 'mb', unpacking them into the decoder's
+  // cache unless they're already there.
+  const CppType* DecodeMiniBlock(size_t mb) {
+    if (mb != decoded_mini_block_) {
+      DecodeMiniBlockTo(mb, decoded_);
+      decoded_mini_block_ = mb;
+    }
+    return decoded_;
+  }
+
+  void DecodeMiniBlockTo(size_t mb, CppType* out_typed) const {
+    const uint8_t* p = &data_[mini_block_offsets_[mb]];
+    const uint8_t mode = *p;
+    const int width = mode & kForWidthMask;
+    const size_t count = MiniBlockCount(mb);
+    const UnsignedType base = UnalignedLoad<UnsignedType>(p + 1);
+    UnsignedType* out = reinterpret_cast<UnsignedType*>(out_typed);
+    if (mode & kForDeltaModeBit) {
+      const UnsignedType min_delta = UnalignedLoad<UnsignedType>(p + 1 + 2 * sizeof(CppType));
+      for_internal::UnpackBits(p + 1 + 3 * sizeof(CppType), count, width, out);
+      UnsignedType v = base;
+      out[0] = v;
+      for (size_t i = 1; i < count; i++) {
+        v += min_delta + out[i];
+        out[i] = v;
+      }
+    } else {
+      for_internal::UnpackBits(p + 1 + 2 * sizeof(CppType), count, width, out);
+      for (size_t i = 0; i < count; i++) {
+        out[i] += base;
+      }
+    }
+  }
+
+  scoped_refptr<BlockHandle> block_;
+  Slice data_;
+  bool parsed_;
+  uint32_t num_elems_;
+  rowid_t ordinal_pos_base_;
+  uint32_t cur_idx_;
+
+  // Offsets of the miniblocks in the block, and their value ranges.
+  std::vector<uint32_t> mini_block_offsets_;
+  std::vector<CppType> mini_block_mins_;
+  std::vector<CppType> mini_block_maxes_;
+
+  // The values of the last unpacked miniblock.
+  size_t decoded_mini_block_;
+  CppType decoded_[kForMiniBlockSize];
+};
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,605 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/fsst_block.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_handle.h"
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/rowblock_memory.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/coding-inl.h"
+#include "kudu/util/group_varint-inl.h"
+#include "kudu/util/memory/arena.h"
+
+using std::pair;
+using std::string;
+using std::unordered_map;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+namespace {
+
+// The number of bytes of strings a symbol table is built from.
+constexpr size_t kSampleBytes = 16 * 1024;
+
+// The number of rounds of the construction of a symbol table.
+constexpr int kBuildRounds = 5;
+
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////
+// Symbol table
+////////////////////////////////////////////////////////////
+
+FsstSymbolTable::FsstSymbolTable()
+    : num_symbols_(0) {
+  memset(symbols_, 0, sizeof(symbols_));
+  memset(lengths_, 0, sizeof(lengths_));
+  BuildIndex();
+}
+
+FsstSymbolTable FsstSymbolTable::Build(const vector<Slice>& sample) {
+  // Each round compresses the sample with the table of the previous round,
+  // counting how many times each symbol (or escaped byte) is used, and how
+  // many times each pair of consecutive symbols is. The symbols of the next
+  // table are the ones of these, and of their concatenations when not
+  // longer than kMaxSymbolLength, which would have saved the most bytes.
+  FsstSymbolTable table;
+  for (int round = 0; round < kBuildRounds; round++) {
+    unordered_map<string, uint64_t> counts;
+    for (const auto& s : sample) {
+      const uint8_t* p = s.data();
+      size_t rem = s.size();
+      Slice prev;
+      while (rem > 0) {
+        const uint8_t code = table.FindLongestSymbol(p, rem);
+        const size_t len = code == kEscapeCode ? 1 : table.lengths_[code];
+        counts[string(reinterpret_cast<const char*>(p), len)]++;
+        if (!prev.empty() && prev.size() + len <= kMaxSymbolLength) {
+          // 'prev' immediately precedes the current symbol in 's'.
+          counts[string(reinterpret_cast<const char*>(prev.data()), prev.size() + len)]++;
+        }
+        prev = Slice(p, len);
+        p += len;
+        rem -= len;
+      }
+    }
+
+    vector<pair<uint64_t, string>> candidates;
+    candidates.reserve(counts.size());
+    for (const auto& e : counts) {
+      candidates.emplace_back(e.second * e.first.size(), e.first);
+    }
+    // Sort by decreasing gain, breaking ties by symbol so that the table
+    // doesn't depend on the iteration order of the map.
+    const auto by_gain = [](const pair<uint64_t, string>& a, const pair<uint64_t, string>& b) {
+      return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    if (candidates.size() > static_cast<size_t>(kMaxSymbols)) {
+      std::nth_element(candidates.begin(), candidates.begin() + kMaxSymbols,
+                       candidates.end(), by_gain);
+      candidates.resize(kMaxSymbols);
+    }
+    std::sort(candidates.begin(), candidates.end(), by_gain);
+
+    FsstSymbolTable next;
+    for (const auto& c : candidates) {
+      next.AddSymbol(Slice(c.second));
+    }
+    next.BuildIndex();
+    table = next;
+  }
+  return table;
+}
+
+void FsstSymbolTable::AddSymbol(const Slice& symbol) {
+  DCHECK_LT(num_symbols_, kMaxSymbols);
+  DCHECK_GT(symbol.size(), 0);
+  DCHECK_LE(symbol.size(), kMaxSymbolLength);
+  symbols_[num_symbols_] = 0;
+  memcpy(&symbols_[num_symbols_], symbol.data(), symbol.size());
+  lengths_[num_symbols_] = symbol.size();
+  num_symbols_++;
+}
+
+void FsstSymbolTable::BuildIndex() {
+  for (int i = 0; i < num_symbols_; i++) {
+    sorted_codes_[i] = i;
+  }
+  const auto first_byte = [this](uint8_t code) {
+    return *reinterpret_cast<const uint8_t*>(&symbols_[code]);
+  };
+  std::sort(sorted_codes_, sorted_codes_ + num_symbols_,
+            [&](uint8_t a, uint8_t b) {
+              if (first_byte(a) != first_byte(b)) {
+                return first_byte(a) < first_byte(b);
+              }
+              if (lengths_[a] != lengths_[b]) {
+                return lengths_[a] > lengths_[b];
+              }
+              return a < b;
+            });
+  int i = 0;
+  for (int b = 0; b < 256; b++) {
+    first_byte_start_[b] = i;
+    while (i < num_symbols_ && first_byte(sorted_codes_[i]) == b) {
+      i++;
+    }
+  }
+  first_byte_start_[256] = i;
+}
+
+uint8_t FsstSymbolTable::FindLongestSymbol(const uint8_t* p, size_t len) const {
+  DCHECK_GT(len, 0);
+  for (int i = first_byte_start_[*p]; i < first_byte_start_[*p + 1]; i++) {
+    const uint8_t code = sorted_codes_[i];
+    const size_t sym_len = lengths_[code];
+    if (sym_len <= len && memcmp(&symbols_[code], p, sym_len) == 0) {
+      return code;
+    }
+  }
+  return kEscapeCode;
+}
+
+void FsstSymbolTable::Serialize(faststring* dst) const {
+  dst->push_back(static_cast<char>(num_symbols_));
+  for (int i = 0; i < num_symbols_; i++) {
+    dst->push_back(static_cast<char>(lengths_[i]));
+    dst->append(&symbols_[i], lengths_[i]);
+  }
+}
+
+Status FsstSymbolTable::Deserialize(const uint8_t** p, const uint8_t* limit) {
+  const uint8_t* ptr = *p;
+  if (PREDICT_FALSE(ptr >= limit)) {
+    return Status::Corruption("no symbol table in FSST block");
+  }
+  const int num_symbols = *ptr++;
+  if (PREDICT_FALSE(num_symbols > kMaxSymbols)) {
+    return Status::Corruption(Substitute("too many symbols in FSST block: $0", num_symbols));
+  }
+  *this = FsstSymbolTable();
+  for (int i = 0; i < num_symbols; i++) {
+    if (PREDICT_FALSE(ptr >= limit)) {
+      return Status::Corruption("truncated symbol table in FSST block");
+    }
+    const size_t len = *ptr++;
+    if (PREDICT_FALSE(len == 0 || len > kMaxSymbolLength || ptr + len > limit)) {
+      return Status::Corruption(Substitute("bad symbol $0 in FSST block", i));
+    }
+    AddSymbol(Slice(ptr, len));
+    ptr += len;
+  }
+  BuildIndex();
+  *p = ptr;
+  return Status::OK();
+}
+
+void FsstSymbolTable::Compress(const Slice& src, faststring* dst) const {
+  const uint8_t* p = src.data();
+  size_t rem = src.size();
+  while (rem > 0) {
+    const uint8_t code = FindLongestSymbol(p, rem);
+    if (code == kEscapeCode) {
+      dst->push_back(static_cast<char>(kEscapeCode));
+      dst->push_back(static_cast<char>(*p));
+      p++;
+      rem--;
+    } else {
+      dst->push_back(static_cast<char>(code));
+      p += lengths_[code];
+      rem -= lengths_[code];
+    }
+  }
+}
+
+size_t FsstSymbolTable::DecompressedLength(const Slice& src) const {
+  size_t len = 0;
+  for (size_t i = 0; i < src.size();) {
+    const uint8_t code = src[i];
+    if (PREDICT_TRUE(code != kEscapeCode)) {
+      len += lengths_[code];
+      i++;
+    } else {
+      // A trailing escape code (only in a corrupt block) is ignored.
+      len += i + 1 < src.size() ? 1 : 0;
+      i += 2;
+    }
+  }
+  return len;
+}
+
+void FsstSymbolTable::Decompress(const Slice& src, uint8_t* dst) const {
+  for (size_t i = 0; i < src.size();) {
+    const uint8_t code = src[i];
+    if (PREDICT_TRUE(code != kEscapeCode)) {
+      // Always copy the 8 bytes of the symbol, which is cheaper than copying
+      // exactly its length.
+      UnalignedStore(dst, symbols_[code]);
+      dst += lengths_[code];
+      i++;
+    } else {
+      if (i + 1 < src.size()) {
+        *dst++ = src[i + 1];
+      }
+      i += 2;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////
+// Encoding
+////////////////////////////////////////////////////////////
+
+BinaryFsstBlockBuilder::BinaryFsstBlockBuilder(const WriterOptions* options)
+    : finished_(false),
+      options_(options) {
+  Reset();
+}
+
+BinaryFsstBlockBuilder::~BinaryFsstBlockBuilder() = default;
+
+void BinaryFsstBlockBuilder::Reset() {
+  raw_buffer_.clear();
+  raw_buffer_.reserve(options_->storage_attributes.cfile_block_size);
+  raw_offsets_.assign(1, 0);
+  buffer_.clear();
+  finished_ = false;
+}
+
+bool BinaryFsstBlockBuilder::IsBlockFull() const {
+  return raw_buffer_.size() > options_->storage_attributes.cfile_block_size;
+}
+
+int BinaryFsstBlockBuilder::Add(const uint8_t* vals, size_t count) {
+  DCHECK(!finished_);
+  DCHECK_GT(count, 0);
+  size_t i = 0;
+
+  // If the block is full, should stop adding more items.
+  while (!IsBlockFull() && i < count) {
+    const Slice* src = reinterpret_cast<const Slice*>(vals);
+    raw_buffer_.append(src->data(), src->size());
+    raw_offsets_.push_back(raw_buffer_.size());
+    i++;
+    vals += sizeof(Slice);
+  }
+  return i;
+}
+
+void BinaryFsstBlockBuilder::Finish(rowid_t ordinal_pos, vector<Slice>* slices) {
+  finished_ = true;
+  const size_t count = Count();
+
+  // Build the symbol table from strings spread over the block.
+  vector<Slice> sample;
+  const size_t stride = raw_buffer_.size() / kSampleBytes + 1;
+  for (size_t i = 0; i < count; i += stride) {
+    sample.emplace_back(raw_string(i));
+  }
+  const FsstSymbolTable table = FsstSymbolTable::Build(sample);
+
+  buffer_.clear();
+  buffer_.reserve(kHeaderSize + raw_buffer_.size() + count * sizeof(uint32_t));
+  buffer_.resize(kHeaderSize);
+  table.Serialize(&buffer_);
+
+  vector<uint32_t> offsets;
+  offsets.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    offsets.push_back(buffer_.size());
+    table.Compress(raw_string(i), &buffer_);
+  }
+  const size_t offsets_pos = buffer_.size();
+
+  // Set up the header
+  InlineEncodeFixed32(&buffer_[0], ordinal_pos);
+  InlineEncodeFixed32(&buffer_[4], count);
+  InlineEncodeFixed32(&buffer_[8], offsets_pos);
+
+  // append the offsets, if non-empty
+  if (!offsets.empty()) {
+    coding::AppendGroupVarInt32Sequence(&buffer_, 0, &offsets[0], offsets.size());
+  }
+
+  *slices = { Slice(buffer_) };
+}
+
+size_t BinaryFsstBlockBuilder::Count() const {
+  return raw_offsets_.size() - 1;
+}
+
+Status BinaryFsstBlockBuilder::GetFirstKey(void* key_void) const {
+  if (Count() == 0) {
+    return Status::NotFound("no keys in data block");
+  }
+  *reinterpret_cast<Slice*>(key_void) = raw_string(0);
+  return Status::OK();
+}
+
+Status BinaryFsstBlockBuilder::GetLastKey(void* key_void) const {
+  if (Count() == 0) {
+    return Status::NotFound("no keys in data block");
+  }
+  *reinterpret_cast<Slice*>(key_void) = raw_string(Count() - 1);
+  return Status::OK();
+}
+
+////////////////////////////////////////////////////////////
+// Decoding
+////////////////////////////////////////////////////////////
+
+BinaryFsstBlockDecoder::BinaryFsstBlockDecoder(scoped_refptr<BlockHandle> block)
+    : block_(std::move(block)),
+      data_(block_->data()),
+      parsed_(false),
+      num_elems_(0),
+      ordinal_pos_base_(0),
+      cur_idx_(0),
+      compressed_pred_(nullptr) {
+}
+
+BinaryFsstBlockDecoder::~BinaryFsstBlockDecoder() = default;
+
+Status BinaryFsstBlockDecoder::ParseHeader() {
+  CHECK(!parsed_);
+
+  if (data_.size() < kMinHeaderSize) {
+    return Status::Corruption(
+        Substitute("not enough bytes for header: FSST block header "
+                   "size ($0) less than minimum possible header length ($1)",
+                   data_.size(), kMinHeaderSize));
+  }
+
+  // Decode header.
+  ordinal_pos_base_  = DecodeFixed32(&data_[0]);
+  num_elems_         = DecodeFixed32(&data_[4]);
+  size_t offsets_pos = DecodeFixed32(&data_[8]);
+
+  // Sanity check.
+  if (offsets_pos > data_.size() || offsets_pos < BinaryFsstBlockBuilder::kHeaderSize) {
+    return Status::Corruption(
+        Substitute("offsets_pos $0 out of bounds of FSST block of $1 bytes",
+                   offsets_pos, data_.size()));
+  }
+
+  const uint8_t* p = data_.data() + BinaryFsstBlockBuilder::kHeaderSize;
+  RETURN_NOT_OK(table_.Deserialize(&p, data_.data() + offsets_pos));
+  const uint32_t strings_pos = p - data_.data();
+
+  // Decode the string offsets themselves, plus one extra entry pointing
+  // after the last string.
+  offsets_.resize(num_elems_ + 1);
+  p = data_.data() + offsets_pos;
+  const uint8_t* limit = data_.data() + data_.size();
+  if (PREDICT_FALSE(!coding::DecodeGroupVarInt32Sequence(p, limit, offsets_.data(),
+                                                         num_elems_))) {
+    return Status::Corruption("unable to decode offsets in FSST block");
+  }
+  offsets_[num_elems_] = offsets_pos;
+
+  uint32_t prev = strings_pos;
+  for (uint32_t offset : offsets_) {
+    if (PREDICT_FALSE(offset < prev || offset > offsets_pos)) {
+      return Status::Corruption(Substitute("bad string offset $0 in FSST block", offset));
+    }
+    prev = offset;
+  }
+
+  parsed_ = true;
+  return Status::OK();
+}
+
+void BinaryFsstBlockDecoder::SeekToPositionInBlock(uint pos) {
+  if (PREDICT_FALSE(num_elems_ == 0)) {
+    DCHECK_EQ(0, pos);
+    return;
+  }
+
+  DCHECK_LE(pos, num_elems_);
+  cur_idx_ = pos;
+}
+
+Slice BinaryFsstBlockDecoder::DecompressToScratch(size_t idx) {
+  const Slice compressed = compressed_string_at_index(idx);
+  const size_t len = table_.DecompressedLength(compressed);
+  scratch_.resize(len + FsstSymbolTable::kMaxSymbolLength - 1);
+  table_.Decompress(compressed, scratch_.data());
+  return Slice(scratch_.data(), len);
+}
+
+Status BinaryFsstBlockDecoder::SeekAtOrAfterValue(const void* value_void, bool* exact) {
+  DCHECK(value_void != nullptr);
+
+  const Slice& target = *reinterpret_cast<const Slice*>(value_void);
+
+  uint32_t left = 0;
+  uint32_t right = num_elems_;
+  while (left != right) {
+    uint32_t mid = (left + right) / 2;
+    int c = DecompressToScratch(mid).compare(target);
+    if (c < 0) {
+      left = mid + 1;
+    } else if (c > 0) {
+      right = mid;
+    } else {
+      cur_idx_ = mid;
+      *exact = true;
+      return Status::OK();
+    }
+  }
+  *exact = false;
+  cur_idx_ = left;
+  if (cur_idx_ == num_elems_) {
+    return Status::NotFound("after last key in block");
+  }
+
+  return Status::OK();
+}
+
+Status BinaryFsstBlockDecoder::DecompressNext(size_t n, ColumnDataView* dst) {
+  // Allocate the strings of the whole batch at once.
+  size_t total_len = 0;
+  for (size_t i = 0; i < n; i++) {
+    total_len += table_.DecompressedLength(compressed_string_at_index(cur_idx_ + i));
+  }
+  const size_t alloc_len = total_len + FsstSymbolTable::kMaxSymbolLength - 1;
+  uint8_t* buf = reinterpret_cast<uint8_t*>(dst->arena()->AllocateBytes(alloc_len));
+  if (PREDICT_FALSE(buf == nullptr)) {
+    return Status::IOError("Out of memory",
+                           Substitute("Failed to allocate $0 bytes in output arena", alloc_len));
+  }
+  Slice* out = reinterpret_cast<Slice*>(dst->data());
+  for (size_t i = 0; i < n; i++) {
+    const Slice compressed = compressed_string_at_index(cur_idx_ + i);
+    const size_t len = table_.DecompressedLength(compressed);
+    table_.Decompress(compressed, buf);
+    out[i] = Slice(buf, len);
+    buf += len;
+  }
+  cur_idx_ += n;
+  return Status::OK();
+}
+
+Status BinaryFsstBlockDecoder::DecompressToArena(size_t idx, ColumnDataView* dst, Slice* out) {
+  const Slice compressed = compressed_string_at_index(idx);
+  const size_t len = table_.DecompressedLength(compressed);
+  const size_t alloc_len = len + FsstSymbolTable::kMaxSymbolLength - 1;
+  uint8_t* buf = reinterpret_cast<uint8_t*>(dst->arena()->AllocateBytes(alloc_len));
+  if (PREDICT_FALSE(buf == nullptr)) {
+    return Status::IOError("Out of memory",
+                           Substitute("Failed to allocate $0 bytes in output arena", alloc_len));
+  }
+  table_.Decompress(compressed, buf);
+  *out = Slice(buf, len);
+  return Status::OK();
+}
+
+Status BinaryFsstBlockDecoder::CopyNextValues(size_t* n, ColumnDataView* dst) {
+  DCHECK(parsed_);
+  CHECK_EQ(dst->type_info()->physical_type(), BINARY);
+  DCHECK_LE(*n, dst->nrows());
+  DCHECK_EQ(dst->stride(), sizeof(Slice));
+  if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+    *n = 0;
+    return Status::OK();
+  }
+  size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+  RETURN_NOT_OK(DecompressNext(max_fetch, dst));
+  *n = max_fetch;
+  return Status::OK();
+}
+
+void BinaryFsstBlockDecoder::CompressPredicateValues(const ColumnPredicate* pred) {
+  if (pred == compressed_pred_) {
+    return;
+  }
+  compressed_pred_values_.clear();
+  const auto add = [&](const void* value) {
+    faststring buf;
+    table_.Compress(*reinterpret_cast<const Slice*>(value), &buf);
+    compressed_pred_values_.emplace_back(buf.ToString());
+  };
+  if (pred->predicate_type() == PredicateType::Equality) {
+    add(pred->raw_lower());
+  } else {
+    DCHECK(pred->predicate_type() == PredicateType::InList);
+    for (const void* value : pred->raw_values()) {
+      add(value);
+    }
+  }
+  std::sort(compressed_pred_values_.begin(), compressed_pred_values_.end());
+  compressed_pred_ = pred;
+}
+
+Status BinaryFsstBlockDecoder::CopyNextAndEval(size_t* n,
+                                               ColumnMaterializationContext* ctx,
+                                               SelectionVectorView* sel,
+                                               ColumnDataView* dst) {
+  DCHECK(parsed_);
+  CHECK_EQ(dst->type_info()->physical_type(), BINARY);
+  DCHECK_LE(*n, dst->nrows());
+  DCHECK_EQ(dst->stride(), sizeof(Slice));
+  ctx->SetDecoderEvalSupported();
+  if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+    *n = 0;
+    return Status::OK();
+  }
+  size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+
+  // Equal strings have equal compressed forms: evaluate equality and IN list
+  // predicates without decompressing.
+  const ColumnPredicate* pred = ctx->pred();
+  const bool eval_compressed = pred->predicate_type() == PredicateType::Equality ||
+                               pred->predicate_type() == PredicateType::InList;
+  if (eval_compressed) {
+    CompressPredicateValues(pred);
+  }
+
+  Slice* out = reinterpret_cast<Slice*>(dst->data());
+  for (size_t i = 0; i < max_fetch; i++) {
+    if (!sel->TestBit(i)) {
+      continue;
+    }
+    const size_t idx = cur_idx_ + i;
+    if (eval_compressed) {
+      const Slice compressed = compressed_string_at_index(idx);
+      if (std::binary_search(compressed_pred_values_.begin(), compressed_pred_values_.end(),
+                             compressed, [](const Slice& a, const Slice& b) {
+                               return a.compare(b) < 0;
+                             })) {
+        RETURN_NOT_OK(DecompressToArena(idx, dst, &out[i]));
+      } else {
+        sel->ClearBit(i);
+      }
+    } else {
+      Slice value = DecompressToScratch(idx);
+      if (pred->EvaluateCell<BINARY>(&value)) {
+        RETURN_NOT_OK(DecompressToArena(idx, dst, &out[i]));
+      } else {
+        sel->ClearBit(i);
+      }
+    }
+  }
+  cur_idx_ += max_fetch;
+  *n = max_fetch;
+  return Status::OK();
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,267 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// FSST (Fast Static Symbol Table) block encoding for strings.
+//
+// Each block has its own table of up to 255 symbols of 1 to 8 bytes, built
+// from a sample of the block's strings. Each string is compressed on its own
+// by greedily replacing the longest symbol matching at each position by its
+// one-byte code; bytes which aren't covered by any symbol are escaped. Since
+// strings are compressed independently, any string of the block can be
+// decompressed without touching the others.
+//
+// The compression is deterministic for a given table, so that two strings are
+// equal if and only if their compressed forms are: equality and IN list
+// predicates are evaluated on the compressed strings, only decompressing the
+// matching ones.
+//
+// The block consists of:
+// Header:
+//   ordinal_pos (32-bit fixed)
+//   num_elems (32-bit fixed)
+//   offsets_pos (32-bit fixed): position of the first offset, relative to block start
+// Symbol table:
+//   num_symbols (8-bit), then for each symbol its length (8-bit) and its bytes
+// Strings:
+//   the compressed strings
+// Offsets:  [pointed to by offsets_pos]
+//   gvint-encoded offsets pointing to the beginning of each compressed string.
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/block_handle.h"
+#include "kudu/common/rowid.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ColumnDataView;
+class ColumnMaterializationContext;
+class ColumnPredicate;
+class SelectionVectorView;
+
+namespace cfile {
+
+struct WriterOptions;
+
+// A table of symbols, and the compression and decompression of strings with
+// it.
+class FsstSymbolTable {
+ public:
+  static constexpr int kMaxSymbols = 255;
+  static constexpr size_t kMaxSymbolLength = 8;
+  static constexpr uint8_t kEscapeCode = 255;
+
+  // Creates an empty table, with which every byte is escaped.
+  FsstSymbolTable();
+
+  // Builds a table fit for compressing strings like the ones in 'sample'.
+  static FsstSymbolTable Build(const std::vector<Slice>& sample);
+
+  // Appends the serialized table to 'dst'.
+  void Serialize(faststring* dst) const;
+
+  // Parses a serialized table starting at '*p' and ending before 'limit'.
+  // On success, advances '*p' past the table.
+  Status Deserialize(const uint8_t** p, const uint8_t* limit);
+
+  // Appends the compressed form of 'src' to 'dst'.
+  void Compress(const Slice& src, faststring* dst) const;
+
+  // Returns the length of the string compressed as 'src'.
+  size_t DecompressedLength(const Slice& src) const;
+
+  // Decompresses 'src' into 'dst', which must have room for
+  // DecompressedLength(src) + kMaxSymbolLength - 1 bytes.
+  void Decompress(const Slice& src, uint8_t* dst) const;
+
+  int num_symbols() const {
+    return num_symbols_;
+  }
+
+ private:
+  // Adds a symbol. The index must be rebuilt before the table is used.
+  void AddSymbol(const Slice& symbol);
+
+  // Rebuilds 'first_byte_start_' and 'sorted_codes_' from the symbols.
+  void BuildIndex();
+
+  // Returns the code of the longest symbol which is a prefix of
+  // [p, p + len), or kEscapeCode if there is none.
+  uint8_t FindLongestSymbol(const uint8_t* p, size_t len) const;
+
+  int num_symbols_;
+
+  // The bytes of each symbol, zero-padded to 8 bytes, and their lengths.
+  // Unused codes have a length of zero.
+  uint64_t symbols_[256];
+  uint8_t lengths_[256];
+
+  // The codes of the symbols, sorted by first byte, then by decreasing
+  // length. The symbols starting with byte 'b' are at
+  // [first_byte_start_[b], first_byte_start_[b + 1]).
+  uint8_t sorted_codes_[kMaxSymbols];
+  uint16_t first_byte_start_[257];
+};
+
+class BinaryFsstBlockBuilder final : public BlockBuilder {
+ public:
+  explicit BinaryFsstBlockBuilder(const WriterOptions* options);
+  ~BinaryFsstBlockBuilder() override;
+
+  // The block is full once the uncompressed strings reach the block size:
+  // the compressed block is therefore smaller than the configured size.
+  bool IsBlockFull() const override;
+
+  int Add(const uint8_t* vals, size_t count) override;
+
+  void Finish(rowid_t ordinal_pos, std::vector<Slice>* slices) override;
+
+  void Reset() override;
+
+  size_t Count() const override;
+
+  // Return the first added key.
+  // key should be a Slice*
+  Status GetFirstKey(void* key) const override;
+
+  // Return the last added key.
+  // key should be a Slice*
+  Status GetLastKey(void* key) const override;
+
+  // Length of a header.
+  static constexpr size_t kHeaderSize = sizeof(uint32_t) * 3;
+
+ private:
+  Slice raw_string(size_t idx) const {
+    return Slice(&raw_buffer_[raw_offsets_[idx]],
+                 raw_offsets_[idx + 1] - raw_offsets_[idx]);
+  }
+
+  // The strings added to the block, uncompressed, and their offsets in it.
+  // 'raw_offsets_' has one extra entry pointing past the last string.
+  faststring raw_buffer_;
+  std::vector<uint32_t> raw_offsets_;
+
+  // The encoded block, built by Finish().
+  faststring buffer_;
+
+  bool finished_;
+
+  const WriterOptions* options_;
+};
+
+class BinaryFsstBlockDecoder final : public BlockDecoder {
+ public:
+  explicit BinaryFsstBlockDecoder(scoped_refptr<BlockHandle> block);
+  ~BinaryFsstBlockDecoder() override;
+
+  Status ParseHeader() override;
+  void SeekToPositionInBlock(uint pos) override;
+  Status SeekAtOrAfterValue(const void* value,
+                            bool* exact_match) override;
+  Status CopyNextValues(size_t* n, ColumnDataView* dst) override;
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) override;
+
+  bool HasNext() const override {
+    DCHECK(parsed_);
+    return cur_idx_ < num_elems_;
+  }
+
+  size_t Count() const override {
+    DCHECK(parsed_);
+    return num_elems_;
+  }
+
+  size_t GetCurrentIndex() const override {
+    DCHECK(parsed_);
+    return cur_idx_;
+  }
+
+  rowid_t GetFirstRowId() const override {
+    return ordinal_pos_base_;
+  }
+
+  // Minimum length of a header.
+  static const size_t kMinHeaderSize = sizeof(uint32_t) * 3 + 1;
+
+ private:
+  // Return the compressed form of the string with index 'idx'.
+  Slice compressed_string_at_index(size_t idx) const {
+    return Slice(&data_[offsets_[idx]], offsets_[idx + 1] - offsets_[idx]);
+  }
+
+  // Decompress the string with index 'idx' into 'scratch_'.
+  Slice DecompressToScratch(size_t idx);
+
+  // Decompress the strings with indexes [cur_idx_, cur_idx_ + n) into the
+  // cells of 'dst', allocated in its arena.
+  Status DecompressNext(size_t n, ColumnDataView* dst);
+
+  // Decompress the string with index 'idx' into '*out', allocated in the
+  // arena of 'dst'.
+  Status DecompressToArena(size_t idx, ColumnDataView* dst, Slice* out);
+
+  // Compress the values of the equality or IN list predicate 'pred' with
+  // this block's table into 'compressed_pred_values_', if not done already.
+  void CompressPredicateValues(const ColumnPredicate* pred);
+
+  scoped_refptr<BlockHandle> block_;
+  Slice data_;
+  bool parsed_;
+
+  FsstSymbolTable table_;
+
+  // Offsets of the compressed strings in 'data_', plus one extra entry
+  // pointing after the last one.
+  std::vector<uint32_t> offsets_;
+
+  uint32_t num_elems_;
+  rowid_t ordinal_pos_base_;
+
+  // Index of the next row to be returned by CopyNextValues, relative to
+  // the block's base offset.
+  // When the index is equal to num_elems_, it means there are no more
+  // elements to be returned.
+  uint32_t cur_idx_;
+
+  // The predicate whose values are compressed in 'compressed_pred_values_',
+  // sorted.
+  const ColumnPredicate* compressed_pred_;
+  std::vector<std::string> compressed_pred_values_;
+
+  // A buffer for the decompressed strings used when seeking by value.
+  faststring scratch_;
+};
+
+} // namespace cfile
+} // namespace kudu
@@ -166,6 +166,11 @@ class IndexBlockIterator {
 
   const Slice& GetCurrentKey() const;
 
+  // The index of the current entry within the block.
+  size_t GetCurrentIndex() const {
+    return cur_idx_;
+  }
+
  private:
   const IndexBlockReader* reader_;
   size_t cur_idx_;
@@ -17,6 +17,7 @@
 
 #include "kudu/cfile/index_btree.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <memory>
 #include <ostream>
@@ -25,6 +26,7 @@
 
 #include <glog/logging.h>
 
+#include "kudu/cfile/block_cache.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/block_pointer.h"
 #include "kudu/cfile/cfile.pb.h"
@@ -251,6 +253,21 @@ const BlockPointer& IndexTreeIterator::GetCurrentBlockPointer() const {
   return seeked_indexes_.back()->iter.GetCurrentBlockPointer();
 }
 
+Status IndexTreeIterator::GetNextBlockPointers(size_t max_count,
+                                               vector<BlockPointer>* ptrs) const {
+  DCHECK(!seeked_indexes_.empty()) << "not seeked";
+  const auto& bottom = seeked_indexes_.back();
+  const size_t end = std::min(bottom->reader.Count(),
+                              bottom->iter.GetCurrentIndex() + 1 + max_count);
+  for (size_t idx = bottom->iter.GetCurrentIndex() + 1; idx < end; idx++) {
+    Slice key;
+    BlockPointer ptr;
+    RETURN_NOT_OK(bottom->reader.ReadEntry(idx, &key, &ptr));
+    ptrs->emplace_back(ptr);
+  }
+  return Status::OK();
+}
+
 IndexBlockIterator* IndexTreeIterator::BottomIter() {
   return &seeked_indexes_.back()->iter;
 }
@@ -293,7 +310,8 @@ Status IndexTreeIterator::LoadBlock(const BlockPointer& block, size_t depth) {
   }
 
   RETURN_NOT_OK(reader_->ReadBlock(io_context_, block,
-                                   CFileReader::CACHE_BLOCK, &seeked->data));
+                                   CFileReader::CACHE_BLOCK, &seeked->data,
+                                   BlockCache::BlockType::kIndex));
   seeked->block_ptr = block;
 
   // Parse the new block.
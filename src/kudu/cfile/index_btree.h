@@ -91,6 +91,12 @@ class IndexTreeIterator {
   const Slice& GetCurrentKey() const;
   const BlockPointer& GetCurrentBlockPointer() const;
 
+  // Appends to 'ptrs' the pointers of up to 'max_count' blocks following the
+  // current one, i.e. those the following calls to Next() would seek to,
+  // without reading any index block. Only the blocks indexed by the current
+  // leaf index block are appended.
+  Status GetNextBlockPointers(size_t max_count, std::vector<BlockPointer>* ptrs) const;
+
   static IndexTreeIterator* Create(
     const fs::IOContext* io_context,
     const CFileReader* reader,
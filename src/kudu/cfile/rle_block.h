@@ -179,15 +179,9 @@ class RleBitMapBlockDecoder final : public BlockDecoder {
     }
 
     size_t bits_to_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
-    size_t remaining = bits_to_fetch;
-    uint8_t* data_ptr = dst->data();
-    // TODO : do this a word/byte at a time as opposed bit at a time
-    while (remaining > 0) {
-      bool result = rle_decoder_.Get(reinterpret_cast<bool*>(data_ptr));
-      DCHECK(result);
-      remaining--;
-      data_ptr++;
-    }
+    const size_t num_read = rle_decoder_.GetValues(reinterpret_cast<bool*>(dst->data()),
+                                                   bits_to_fetch);
+    DCHECK_EQ(bits_to_fetch, num_read);
 
     cur_idx_ += bits_to_fetch;
     *n = bits_to_fetch;
@@ -414,14 +408,9 @@ class RleIntBlockDecoder final : public BlockDecoder {
     }
 
     size_t to_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
-    size_t remaining = to_fetch;
-    uint8_t* data_ptr = dst->data();
-    while (remaining > 0) {
-      bool result = rle_decoder_.Get(reinterpret_cast<CppType*>(data_ptr));
-      DCHECK(result);
-      remaining--;
-      data_ptr += kCppTypeSize;
-    }
+    const size_t num_read = rle_decoder_.GetValues(reinterpret_cast<CppType*>(dst->data()),
+                                                   to_fetch);
+    DCHECK_EQ(to_fetch, num_read);
 
     cur_idx_ += to_fetch;
     *n = to_fetch;
@@ -0,0 +1,167 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/secondary_block_cache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "kudu/cfile/block_cache.h"
+#include "kudu/fs/block_id.h"
+#include "kudu/util/cache.h"
+#include "kudu/util/env.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+namespace cfile {
+
+class SecondaryBlockCacheTest : public KuduTest {
+ protected:
+  static constexpr int kBlockSize = 4096;
+
+  void OpenCache(int64_t capacity_bytes, unique_ptr<SecondaryBlockCache>* cache) {
+    SecondaryBlockCache::Options opts;
+    opts.path = GetTestPath("secondary_block_cache");
+    opts.capacity_bytes = capacity_bytes;
+    opts.max_pending_bytes = 1024 * 1024 * 1024;
+    ASSERT_OK(SecondaryBlockCache::Open(env_, opts, cache));
+  }
+
+  static string MakeBlock(int i) {
+    return string(kBlockSize, static_cast<char>('a' + i % 26));
+  }
+
+  // Looks up the block with key 'i' in 'cache', returning it in 'block'.
+  static bool Lookup(SecondaryBlockCache* cache, int i, string* block) {
+    BlockCache::CacheKey key(BlockId(1), i);
+    return cache->Lookup(key, [&](size_t size) {
+      block->resize(size);
+      return reinterpret_cast<uint8_t*>(&(*block)[0]);
+    });
+  }
+};
+
+TEST_F(SecondaryBlockCacheTest, TestInsertAndLookup) {
+  unique_ptr<SecondaryBlockCache> cache;
+  NO_FATALS(OpenCache(1024 * 1024, &cache));
+  for (int i = 0; i < 10; i++) {
+    cache->Insert(BlockCache::CacheKey(BlockId(1), i), MakeBlock(i));
+  }
+  cache->WaitForPendingWritesForTests();
+  for (int i = 0; i < 10; i++) {
+    string block;
+    ASSERT_TRUE(Lookup(cache.get(), i, &block));
+    ASSERT_EQ(MakeBlock(i), block);
+  }
+  string block;
+  ASSERT_FALSE(Lookup(cache.get(), 10, &block));
+
+  // A lookup may be abandoned by the caller.
+  ASSERT_FALSE(cache->Lookup(BlockCache::CacheKey(BlockId(1), 0),
+                             [](size_t /* size */) { return nullptr; }));
+}
+
+// Once the file is full, the oldest blocks are overwritten.
+TEST_F(SecondaryBlockCacheTest, TestWrapAround) {
+  constexpr int kNumBlocks = 100;
+  unique_ptr<SecondaryBlockCache> cache;
+  // Room for a little more than 10 blocks.
+  NO_FATALS(OpenCache(10 * kBlockSize + 1024, &cache));
+  for (int i = 0; i < kNumBlocks; i++) {
+    cache->Insert(BlockCache::CacheKey(BlockId(1), i), MakeBlock(i));
+  }
+  cache->WaitForPendingWritesForTests();
+
+  int num_found = 0;
+  for (int i = 0; i < kNumBlocks; i++) {
+    string block;
+    if (Lookup(cache.get(), i, &block)) {
+      ASSERT_EQ(MakeBlock(i), block);
+      // Only the most recent blocks are left.
+      ASSERT_GE(i, kNumBlocks - 10);
+      num_found++;
+    }
+  }
+  ASSERT_GT(num_found, 0);
+  ASSERT_LE(num_found, 10);
+}
+
+// Blocks which were corrupted on the device are detected and dropped.
+TEST_F(SecondaryBlockCacheTest, TestCorruption) {
+  unique_ptr<SecondaryBlockCache> cache;
+  NO_FATALS(OpenCache(1024 * 1024, &cache));
+  cache->Insert(BlockCache::CacheKey(BlockId(1), 0), MakeBlock(0));
+  cache->WaitForPendingWritesForTests();
+
+  // Flip a byte in the middle of the only block.
+  RWFileOptions opts;
+  opts.mode = Env::MUST_EXIST;
+  unique_ptr<RWFile> file;
+  ASSERT_OK(env_->NewRWFile(opts, GetTestPath("secondary_block_cache"), &file));
+  const uint64_t offset = file->GetEncryptionHeaderSize() + kBlockSize / 2;
+  uint8_t byte;
+  ASSERT_OK(file->Read(offset, Slice(&byte, 1)));
+  byte ^= 0xff;
+  ASSERT_OK(file->Write(offset, Slice(&byte, 1)));
+
+  string block;
+  ASSERT_FALSE(Lookup(cache.get(), 0, &block));
+}
+
+// The blocks evicted from the block cache are read back from the secondary
+// cache.
+TEST_F(SecondaryBlockCacheTest, TestSpillFromBlockCache) {
+  constexpr int kNumBlocks = 256;
+  unique_ptr<SecondaryBlockCache> secondary;
+  NO_FATALS(OpenCache(16 * 1024 * 1024, &secondary));
+  SecondaryBlockCache* secondary_ptr = secondary.get();
+  BlockCache cache(64 * 1024, std::move(secondary));
+
+  for (int i = 0; i < kNumBlocks; i++) {
+    BlockCache::CacheKey key(BlockId(1), i);
+    BlockCache::PendingEntry entry = cache.Allocate(key, kBlockSize);
+    ASSERT_TRUE(entry.valid());
+    string data = MakeBlock(i);
+    memcpy(entry.val_ptr(), data.data(), data.size());
+    BlockCacheHandle handle;
+    cache.Insert(&entry, &handle);
+  }
+
+  for (int i = 0; i < kNumBlocks; i++) {
+    // Reading a block back may evict others, which are written asynchronously.
+    secondary_ptr->WaitForPendingWritesForTests();
+    BlockCacheHandle handle;
+    ASSERT_TRUE(cache.Lookup(BlockCache::CacheKey(BlockId(1), i),
+                             Cache::EXPECT_IN_CACHE, &handle)) << i;
+    ASSERT_EQ(Slice(MakeBlock(i)), handle.data());
+  }
+}
+
+} // namespace cfile
+} // namespace kudu
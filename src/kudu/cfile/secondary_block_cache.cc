@@ -0,0 +1,317 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/secondary_block_cache.h"
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/array_view.h"
+#include "kudu/util/block_cache_metrics.h"
+#include "kudu/util/crc.h"
+#include "kudu/util/env.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/threadpool.h"
+
+using std::unique_ptr;
+
+namespace kudu {
+namespace cfile {
+
+namespace {
+
+// The header of each record of the log. Its layout is persisted, so it must be
+// kept fixed.
+struct RecordHeader {
+  uint64_t file_id;
+  uint64_t offset;
+  uint32_t length;
+
+  // CRC32C of the above fields and of the contents of the block.
+  uint32_t checksum;
+} PACKED;
+
+uint32_t RecordChecksum(const RecordHeader& header, const uint8_t* data) {
+  uint32_t crc = crc::Crc32c(&header, offsetof(RecordHeader, checksum));
+  return crc::Crc32c(data, header.length, crc);
+}
+
+} // anonymous namespace
+
+Status SecondaryBlockCache::Open(Env* env, const Options& options,
+                                 unique_ptr<SecondaryBlockCache>* cache) {
+  if (options.capacity_bytes <= static_cast<int64_t>(sizeof(RecordHeader))) {
+    return Status::InvalidArgument("secondary block cache capacity is too small",
+                                   std::to_string(options.capacity_bytes));
+  }
+  RWFileOptions opts;
+  opts.mode = Env::CREATE_OR_OPEN_WITH_TRUNCATE;
+  // The blocks are user data.
+  opts.is_sensitive = true;
+  unique_ptr<RWFile> file;
+  RETURN_NOT_OK_PREPEND(env->NewRWFile(opts, options.path, &file),
+                        "unable to open the secondary block cache file");
+  unique_ptr<ThreadPool> writer_pool;
+  RETURN_NOT_OK(ThreadPoolBuilder("block-cache-writer")
+                .set_max_threads(1)
+                .Build(&writer_pool));
+  cache->reset(new SecondaryBlockCache(options, std::move(file), std::move(writer_pool)));
+  return Status::OK();
+}
+
+SecondaryBlockCache::SecondaryBlockCache(Options options, unique_ptr<RWFile> file,
+                                         unique_ptr<ThreadPool> writer_pool)
+    : options_(std::move(options)),
+      file_(std::move(file)),
+      base_offset_(file_->GetEncryptionHeaderSize()),
+      writer_pool_(std::move(writer_pool)),
+      write_offset_(0),
+      pending_bytes_(0),
+      writer_scheduled_(false) {
+}
+
+SecondaryBlockCache::~SecondaryBlockCache() {
+  writer_pool_->Shutdown();
+}
+
+void SecondaryBlockCache::SetMetrics(unique_ptr<SecondaryBlockCacheMetrics> metrics) {
+  metrics_ = std::move(metrics);
+}
+
+void SecondaryBlockCache::Insert(const CacheKey& key, Slice value) {
+  if (PREDICT_FALSE(value.size() > std::numeric_limits<uint32_t>::max())) {
+    return;
+  }
+  const int64_t length = value.size();
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    // A block read back from this cache would otherwise be written again
+    // whenever it's evicted from the block cache.
+    if (ContainsKey(index_, key)) {
+      return;
+    }
+    if (pending_bytes_ + length > options_.max_pending_bytes) {
+      if (metrics_) {
+        metrics_->inserts_dropped->Increment();
+      }
+      return;
+    }
+    pending_bytes_ += length;
+  }
+
+  // Copy the block outside of the lock.
+  PendingWrite w{ key, unique_ptr<uint8_t[]>(new uint8_t[length]),
+                  static_cast<uint32_t>(length) };
+  memcpy(w.data.get(), value.data(), length);
+
+  bool schedule_writer;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    pending_writes_.emplace_back(std::move(w));
+    schedule_writer = !writer_scheduled_;
+    writer_scheduled_ = true;
+  }
+  if (schedule_writer) {
+    Status s = writer_pool_->Submit([this]() { WritePendingBlocks(); });
+    if (PREDICT_FALSE(!s.ok())) {
+      // Only when shutting down: the pending blocks are lost anyway.
+      std::lock_guard<simple_spinlock> l(lock_);
+      writer_scheduled_ = false;
+    }
+  }
+}
+
+void SecondaryBlockCache::WritePendingBlocks() {
+  while (true) {
+    std::deque<PendingWrite> batch;
+    {
+      std::lock_guard<simple_spinlock> l(lock_);
+      if (pending_writes_.empty()) {
+        writer_scheduled_ = false;
+        return;
+      }
+      batch.swap(pending_writes_);
+    }
+    int64_t written_bytes = 0;
+    for (const auto& w : batch) {
+      Status s = WriteBlock(w);
+      if (PREDICT_FALSE(!s.ok())) {
+        KLOG_EVERY_N_SECS(WARNING, 60) << "unable to write to the secondary block cache: "
+                                       << s.ToString();
+        if (metrics_) {
+          metrics_->write_errors->Increment();
+        }
+      }
+      written_bytes += w.length;
+    }
+    std::lock_guard<simple_spinlock> l(lock_);
+    pending_bytes_ -= written_bytes;
+  }
+}
+
+Status SecondaryBlockCache::WriteBlock(const PendingWrite& w) {
+  const uint64_t capacity = options_.capacity_bytes;
+  const uint64_t record_length = sizeof(RecordHeader) + w.length;
+  if (PREDICT_FALSE(record_length > capacity)) {
+    return Status::OK();
+  }
+
+  uint64_t offset;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    if (write_offset_ + record_length > capacity) {
+      write_offset_ = 0;
+    }
+    offset = write_offset_;
+    // Make the overwritten blocks unreachable before overwriting them. The
+    // lookups which already found them fail the verification of the header.
+    EvictRangeUnlocked(offset, record_length);
+  }
+
+  RecordHeader header;
+  header.file_id = w.key.file_id_;
+  header.offset = w.key.offset_;
+  header.length = w.length;
+  header.checksum = RecordChecksum(header, w.data.get());
+  const Slice data[] = {
+    Slice(reinterpret_cast<const uint8_t*>(&header), sizeof(header)),
+    Slice(w.data.get(), w.length),
+  };
+  RETURN_NOT_OK(file_->WriteV(base_offset_ + offset, data));
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  write_offset_ = offset + record_length;
+  // The block may have been written again while this one was pending.
+  auto it = index_.find(w.key);
+  if (it != index_.end()) {
+    EraseUnlocked(w.key, it->second.offset);
+  }
+  InsertOrDieNoPrint(&index_, w.key, Entry{ offset, w.length });
+  InsertOrDie(&index_by_offset_, offset, w.key);
+  if (metrics_) {
+    metrics_->inserts->Increment();
+    metrics_->usage->IncrementBy(record_length);
+  }
+  return Status::OK();
+}
+
+void SecondaryBlockCache::EvictRangeUnlocked(uint64_t offset, uint64_t length) {
+  DCHECK(lock_.is_locked());
+  auto it = index_by_offset_.lower_bound(offset);
+  // A record starting before 'offset' may extend into the range.
+  if (it != index_by_offset_.begin()) {
+    auto prev = std::prev(it);
+    const Entry& e = FindOrDieNoPrint(index_, prev->second);
+    if (e.offset + sizeof(RecordHeader) + e.length > offset) {
+      it = prev;
+    }
+  }
+  while (it != index_by_offset_.end() && it->first < offset + length) {
+    const Entry& e = FindOrDieNoPrint(index_, it->second);
+    if (metrics_) {
+      metrics_->evictions->Increment();
+      metrics_->usage->DecrementBy(sizeof(RecordHeader) + e.length);
+    }
+    index_.erase(it->second);
+    it = index_by_offset_.erase(it);
+  }
+}
+
+void SecondaryBlockCache::EraseUnlocked(const CacheKey& key, uint64_t offset) {
+  DCHECK(lock_.is_locked());
+  auto it = index_.find(key);
+  if (it == index_.end() || it->second.offset != offset) {
+    return;
+  }
+  if (metrics_) {
+    metrics_->usage->DecrementBy(sizeof(RecordHeader) + it->second.length);
+  }
+  index_by_offset_.erase(offset);
+  index_.erase(it);
+}
+
+bool SecondaryBlockCache::Lookup(const CacheKey& key,
+                                 const std::function<uint8_t*(size_t)>& alloc) {
+  if (metrics_) {
+    metrics_->lookups->Increment();
+  }
+  Entry e;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    const Entry* found = FindOrNull(index_, key);
+    if (!found) {
+      if (metrics_) {
+        metrics_->misses->Increment();
+      }
+      return false;
+    }
+    e = *found;
+  }
+
+  uint8_t* buf = alloc(e.length);
+  if (!buf) {
+    return false;
+  }
+  RecordHeader header;
+  Slice results[] = {
+    Slice(reinterpret_cast<uint8_t*>(&header), sizeof(header)),
+    Slice(buf, e.length),
+  };
+  Status s = file_->ReadV(base_offset_ + e.offset, results);
+  const bool verified = s.ok() &&
+      header.file_id == key.file_id_ &&
+      header.offset == key.offset_ &&
+      header.length == e.length &&
+      header.checksum == RecordChecksum(header, buf);
+  if (PREDICT_FALSE(!verified)) {
+    if (!s.ok()) {
+      KLOG_EVERY_N_SECS(WARNING, 60) << "unable to read from the secondary block cache: "
+                                     << s.ToString();
+    }
+    std::lock_guard<simple_spinlock> l(lock_);
+    EraseUnlocked(key, e.offset);
+    if (metrics_) {
+      if (s.ok()) {
+        metrics_->checksum_failures->Increment();
+      }
+      metrics_->misses->Increment();
+    }
+    return false;
+  }
+  if (metrics_) {
+    metrics_->hits->Increment();
+  }
+  return true;
+}
+
+void SecondaryBlockCache::WaitForPendingWritesForTests() {
+  writer_pool_->Wait();
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,176 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "kudu/cfile/block_cache.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Env;
+class RWFile;
+class ThreadPool;
+struct SecondaryBlockCacheMetrics;
+
+namespace cfile {
+
+// A victim cache for the block cache, backed by a file on a fast local device
+// such as an SSD: blocks evicted from the block cache are written to the file,
+// and looked up there before being read from the data directories.
+//
+// The file is a circular log of records, each made of a header (the key of the
+// block, its length and a CRC32C checksum of its contents) followed by the
+// contents of the block. Once the log is full, writing wraps around to the
+// beginning of the file, evicting the oldest blocks. The index of the blocks
+// is kept in memory only: the file is truncated when the cache is opened.
+//
+// The blocks are written asynchronously by a background thread, so that the
+// threads evicting blocks from the block cache don't wait for the device.
+// If the device can't keep up, the blocks which don't fit in the queue of
+// pending writes are dropped.
+//
+// Lookups don't hold any lock while reading from the file: a block may be
+// overwritten while it's being read, which the key and checksum in the
+// record's header detect.
+//
+// This class is thread-safe.
+class SecondaryBlockCache {
+ public:
+  typedef BlockCache::CacheKey CacheKey;
+
+  struct Options {
+    // The path of the backing file, which is created if it doesn't exist.
+    std::string path;
+
+    // The maximum size of the backing file.
+    int64_t capacity_bytes = 0;
+
+    // The maximum total size of the blocks queued to be written.
+    int64_t max_pending_bytes = 0;
+  };
+
+  // Opens the cache described by 'options' in 'env', truncating its file.
+  static Status Open(Env* env, const Options& options,
+                     std::unique_ptr<SecondaryBlockCache>* cache);
+
+  ~SecondaryBlockCache();
+
+  // Queues the block 'value' to be written under 'key', unless it's already
+  // in the cache or the queue of pending writes is full.
+  void Insert(const CacheKey& key, Slice value);
+
+  // Looks up the block with the given key. If it's found, calls 'alloc' with
+  // the length of the block to get the buffer to read it into, and returns
+  // true if the block could be read and verified. 'alloc' may return nullptr,
+  // in which case the lookup is abandoned.
+  bool Lookup(const CacheKey& key, const std::function<uint8_t*(size_t)>& alloc);
+
+  // Starts recording metrics with 'metrics'.
+  void SetMetrics(std::unique_ptr<SecondaryBlockCacheMetrics> metrics);
+
+  // Waits until the blocks queued so far have been written.
+  void WaitForPendingWritesForTests();
+
+ private:
+  // The location of a block in the backing file.
+  struct Entry {
+    // The offset of the record, relative to the beginning of the log.
+    uint64_t offset;
+    uint32_t length;
+  };
+
+  // A block waiting to be written.
+  struct PendingWrite {
+    CacheKey key;
+    std::unique_ptr<uint8_t[]> data;
+    uint32_t length;
+  };
+
+  struct CacheKeyHash {
+    size_t operator()(const CacheKey& key) const {
+      return key.file_id_ * 0x9E3779B97F4A7C15ULL ^ key.offset_;
+    }
+  };
+
+  struct CacheKeyEqual {
+    bool operator()(const CacheKey& a, const CacheKey& b) const {
+      return a.file_id_ == b.file_id_ && a.offset_ == b.offset_;
+    }
+  };
+
+  SecondaryBlockCache(Options options, std::unique_ptr<RWFile> file,
+                      std::unique_ptr<ThreadPool> writer_pool);
+
+  // Writes all the pending blocks. Runs on the writer thread.
+  void WritePendingBlocks();
+
+  // Writes the given block at the end of the log.
+  Status WriteBlock(const PendingWrite& w);
+
+  // Removes the entries whose records overlap with [offset, offset + length)
+  // of the log. 'lock_' must be held.
+  void EvictRangeUnlocked(uint64_t offset, uint64_t length);
+
+  // Removes the given entry if it's still at 'offset'. 'lock_' must be held.
+  void EraseUnlocked(const CacheKey& key, uint64_t offset);
+
+  const Options options_;
+  const std::unique_ptr<RWFile> file_;
+
+  // The offset in 'file_' of the beginning of the log, after the encryption
+  // header, if any.
+  const uint64_t base_offset_;
+
+  // A single thread which writes the blocks.
+  const std::unique_ptr<ThreadPool> writer_pool_;
+
+  std::unique_ptr<SecondaryBlockCacheMetrics> metrics_;
+
+  // Protects all of the below.
+  simple_spinlock lock_;
+
+  // The index of the blocks in the log, by key and by offset.
+  std::unordered_map<CacheKey, Entry, CacheKeyHash, CacheKeyEqual> index_;
+  std::map<uint64_t, CacheKey> index_by_offset_;
+
+  // The offset of the next record, relative to the beginning of the log.
+  // Only modified by the writer thread.
+  uint64_t write_offset_;
+
+  std::deque<PendingWrite> pending_writes_;
+  int64_t pending_bytes_;
+
+  // Whether a task is scheduled on 'writer_pool_' to write the pending blocks.
+  bool writer_scheduled_;
+
+  DISALLOW_COPY_AND_ASSIGN(SecondaryBlockCache);
+};
+
+} // namespace cfile
+} // namespace kudu
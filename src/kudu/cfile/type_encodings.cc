@@ -21,12 +21,15 @@
 #include <unordered_map>
 #include <utility>
 
+#include "kudu/cfile/adaptive_block.h"
 #include "kudu/cfile/binary_dict_block.h" // IWYU pragma: keep
 #include "kudu/cfile/binary_plain_block.h" // IWYU pragma: keep
 #include "kudu/cfile/binary_prefix_block.h" // IWYU pragma: keep
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/bshuf_block.h" // IWYU pragma: keep
+#include "kudu/cfile/frame_of_reference_block.h" // IWYU pragma: keep
+#include "kudu/cfile/fsst_block.h" // IWYU pragma: keep
 #include "kudu/cfile/plain_bitmap_block.h" // IWYU pragma: keep
 #include "kudu/cfile/plain_block.h" // IWYU pragma: keep
 #include "kudu/cfile/rle_block.h" // IWYU pragma: keep
@@ -107,6 +110,11 @@ template<>
 struct DataTypeEncodingTraits<BINARY, PREFIX_ENCODING>
     : public EncodingTraits<BinaryPrefixBlockBuilder, BinaryPrefixBlockDecoder> {};
 
+// Template specialization for FSST compressed strings.
+template<>
+struct DataTypeEncodingTraits<BINARY, FSST>
+    : public EncodingTraits<BinaryFsstBlockBuilder, BinaryFsstBlockDecoder> {};
+
 // Template for dictionary encoding
 template<>
 struct DataTypeEncodingTraits<BINARY, DICT_ENCODING>
@@ -123,6 +131,30 @@ template<DataType IntType>
 struct DataTypeEncodingTraits<IntType, RLE>
     : public EncodingTraits<RleIntBlockBuilder<IntType>, RleIntBlockDecoder<IntType>> {};
 
+template<DataType IntType>
+struct DataTypeEncodingTraits<IntType, FRAME_OF_REFERENCE>
+    : public EncodingTraits<FrameOfReferenceBlockBuilder<IntType>,
+                            FrameOfReferenceBlockDecoder<IntType>> {};
+
+// Adaptive encoding chooses among the type's other encodings for each block,
+// so its builder and decoder need to know the type.
+template<DataType Type>
+struct DataTypeEncodingTraits<Type, ADAPTIVE> {
+  static Status CreateBlockBuilder(unique_ptr<BlockBuilder>* bb, const WriterOptions* options) {
+    bb->reset(new AdaptiveBlockBuilder(Type, options));
+    return Status::OK();
+  }
+
+  static Status CreateBlockDecoder(unique_ptr<BlockDecoder>* bd,
+                                   // https://bugs.llvm.org/show_bug.cgi?id=44598
+                                   // NOLINTNEXTLINE(performance-unnecessary-value-param)
+                                   scoped_refptr<BlockHandle> block,
+                                   CFileIterator* parent_cfile_iter) {
+    bd->reset(new AdaptiveBlockDecoder(Type, std::move(block), parent_cfile_iter));
+    return Status::OK();
+  }
+};
+
 template<typename TypeEncodingTraitsClass>
 TypeEncodingInfo::TypeEncodingInfo(TypeEncodingTraitsClass /*t*/)
     : encoding_type_(TypeEncodingTraitsClass::kEncodingType),
@@ -212,6 +244,28 @@ class TypeEncodingResolver {
     AddMapping<BOOL, PLAIN_ENCODING>();
     AddMapping<INT128, BIT_SHUFFLE>();
     AddMapping<INT128, PLAIN_ENCODING>();
+    AddMapping<UINT8, FRAME_OF_REFERENCE>();
+    AddMapping<INT8, FRAME_OF_REFERENCE>();
+    AddMapping<UINT16, FRAME_OF_REFERENCE>();
+    AddMapping<INT16, FRAME_OF_REFERENCE>();
+    AddMapping<UINT32, FRAME_OF_REFERENCE>();
+    AddMapping<INT32, FRAME_OF_REFERENCE>();
+    AddMapping<UINT64, FRAME_OF_REFERENCE>();
+    AddMapping<INT64, FRAME_OF_REFERENCE>();
+    AddMapping<BINARY, FSST>();
+    AddMapping<UINT8, ADAPTIVE>();
+    AddMapping<INT8, ADAPTIVE>();
+    AddMapping<UINT16, ADAPTIVE>();
+    AddMapping<INT16, ADAPTIVE>();
+    AddMapping<UINT32, ADAPTIVE>();
+    AddMapping<INT32, ADAPTIVE>();
+    AddMapping<UINT64, ADAPTIVE>();
+    AddMapping<INT64, ADAPTIVE>();
+    AddMapping<FLOAT, ADAPTIVE>();
+    AddMapping<DOUBLE, ADAPTIVE>();
+    AddMapping<BINARY, ADAPTIVE>();
+    AddMapping<BOOL, ADAPTIVE>();
+    AddMapping<INT128, ADAPTIVE>();
     // TODO: Add 128 bit support to RLE
     // AddMapping<INT128, RLE>();
   }
@@ -27,6 +27,7 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/client/callbacks.h"
@@ -37,6 +38,7 @@
 #include "kudu/client/schema.h"
 #include "kudu/client/session-internal.h"
 #include "kudu/client/shared_ptr.h" // IWYU pragma: keep
+#include "kudu/client/write_flow_controller.h"
 #include "kudu/client/write_op-internal.h"
 #include "kudu/client/write_op.h"
 #include "kudu/common/common.pb.h"
@@ -56,11 +58,15 @@
 #include "kudu/rpc/rpc.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/rpc/rpc_sidecar.h"
 #include "kudu/security/token.pb.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_service.proxy.h" // IWYU pragma: keep
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/pb_util.h"
+#include "kudu/util/slice.h"
 
 namespace kudu {
 namespace rpc {
@@ -68,6 +74,14 @@ class Messenger;
 }  // namespace rpc
 }  // namespace kudu
 
+DEFINE_bool(client_write_row_data_in_sidecars, false,
+            "Whether to send the row data of write requests in RPC sidecars "
+            "rather than in the requests themselves, which saves copying it on "
+            "both ends. Writes to tablet servers which don't support it fail, "
+            "so only enable this once all of them do.");
+TAG_FLAG(client_write_row_data_in_sidecars, advanced);
+TAG_FLAG(client_write_row_data_in_sidecars, experimental);
+
 using kudu::pb_util::SecureDebugString;
 using kudu::pb_util::SecureShortDebugString;
 using kudu::rpc::CredentialsPolicy;
@@ -266,6 +280,19 @@ class WriteRpc : public RetriableRpc<RemoteTabletServer, WriteRequestPB, WriteRe
 
   // The id of the tablet being written to.
   string tablet_id_;
+
+  // The row data of the request, moved out of 'req_' to be sent as sidecars
+  // if --client_write_row_data_in_sidecars is set.
+  string rows_;
+  string indirect_data_;
+
+  // The server and the size of the attempt in flight under the batcher's
+  // WriteFlowController, if any; 'flow_control_bytes_' is 0 otherwise.
+  string flow_control_server_;
+  int64_t flow_control_bytes_ = 0;
+
+  // When the attempt in flight was sent.
+  MonoTime send_time_;
 };
 
 WriteRpc::WriteRpc(const scoped_refptr<Batcher>& batcher,
@@ -338,6 +365,16 @@ WriteRpc::WriteRpc(const scoped_refptr<Batcher>& batcher,
     VLOG(4) << ++ctr << ". Encoded row " << op->ToString();
   }
 
+  if (FLAGS_client_write_row_data_in_sidecars) {
+    // The sidecars are added anew on every attempt, see Try().
+    rows_.swap(*requested->mutable_rows());
+    indirect_data_.swap(*requested->mutable_indirect_data());
+    requested->clear_rows();
+    requested->clear_indirect_data();
+    requested->set_rows_sidecar(0);
+    requested->set_indirect_data_sidecar(1);
+  }
+
   VLOG(3) << Substitute("Created batch for $0:\n$1",
                         tablet_id, SecureShortDebugString(req_));
 }
@@ -401,6 +438,8 @@ WriteRpc::~WriteRpc() {
       }
     }
     if (i >= 0) {
+      // The ops taken from a session's pool go back there to be reused.
+      internal::ReleaseWriteOp(std::move(ops_[i]->write_op));
       ops_[i]->~InFlightOp();
     }
   };
@@ -426,9 +465,34 @@ string WriteRpc::ToString() const {
 
 void WriteRpc::Try(RemoteTabletServer* replica, const ResponseCallback& callback) {
   VLOG(2) << "Tablet " << tablet_id_ << ": Writing batch to replica " << replica->ToString();
-  replica->proxy()->WriteAsync(req_, &resp_,
-                               mutable_retrier()->mutable_controller(),
-                               callback);
+  if (req_.row_operations().has_rows_sidecar()) {
+    auto* controller = mutable_retrier()->mutable_controller();
+    controller->RequireServerFeature(tserver::TabletServerFeatures::ROW_OPERATIONS_SIDECARS);
+    int idx;
+    CHECK_OK(controller->AddOutboundSidecar(rpc::RpcSidecar::FromSlice(rows_), &idx));
+    DCHECK_EQ(req_.row_operations().rows_sidecar(), idx);
+    CHECK_OK(controller->AddOutboundSidecar(rpc::RpcSidecar::FromSlice(indirect_data_), &idx));
+    DCHECK_EQ(req_.row_operations().indirect_data_sidecar(), idx);
+  }
+  WriteFlowController* flow_controller = batcher_->flow_controller_;
+  if (!flow_controller) {
+    replica->proxy()->WriteAsync(req_, &resp_,
+                                 mutable_retrier()->mutable_controller(),
+                                 callback);
+    return;
+  }
+  DCHECK_EQ(0, flow_control_bytes_);
+  flow_control_server_ = replica->permanent_uuid();
+  flow_control_bytes_ = req_.ByteSizeLong() + rows_.size() + indirect_data_.size();
+  flow_controller->Send(flow_control_server_, flow_control_bytes_, [this, replica, callback]() {
+    // The write may have waited for room in the window: don't let it
+    // outlive the deadline of the RPC.
+    mutable_retrier()->mutable_controller()->set_deadline(retrier().deadline());
+    send_time_ = MonoTime::Now();
+    replica->proxy()->WriteAsync(req_, &resp_,
+                                 mutable_retrier()->mutable_controller(),
+                                 callback);
+  });
 }
 
 void WriteRpc::Finish(const Status& status) {
@@ -453,6 +517,24 @@ RetriableRpcStatus WriteRpc::AnalyzeResponse(const Status& rpc_cb_status) {
     result.status = mutable_retrier()->controller().status();
   }
 
+  if (flow_control_bytes_ > 0) {
+    WriteFlowController::WriteFeedback feedback;
+    feedback.latency = MonoTime::Now() - send_time_;
+    if (resp_.has_resource_metrics() && resp_.resource_metrics().has_queue_duration_nanos()) {
+      feedback.queue_time = MonoDelta::FromNanoseconds(
+          resp_.resource_metrics().queue_duration_nanos());
+    }
+    const ErrorStatusPB* err = mutable_retrier()->controller().error_response();
+    feedback.rejected =
+        (result.status.IsRemoteError() && err && err->has_code() &&
+         (err->code() == ErrorStatusPB::ERROR_SERVER_TOO_BUSY ||
+          err->code() == ErrorStatusPB::ERROR_UNAVAILABLE)) ||
+        (resp_.has_error() && resp_.error().code() == tserver::TabletServerErrorPB::THROTTLED);
+    const int64_t bytes = flow_control_bytes_;
+    flow_control_bytes_ = 0;
+    batcher_->flow_controller_->Finished(flow_control_server_, bytes, feedback);
+  }
+
   // Check for specific RPC errors.
   if (result.status.IsRemoteError()) {
     const ErrorStatusPB* err = mutable_retrier()->controller().error_response();
@@ -613,12 +695,14 @@ Batcher::Batcher(KuduClient* client,
                  scoped_refptr<ErrorCollector> error_collector,
                  sp::weak_ptr<KuduSession> session,
                  kudu::client::KuduSession::ExternalConsistencyMode consistency_mode,
-                 const TxnId& txn_id)
+                 const TxnId& txn_id,
+                 WriteFlowController* flow_controller)
   : state_(kGatheringOps),
     client_(client),
     weak_session_(std::move(session)),
     consistency_mode_(consistency_mode),
     txn_id_(txn_id),
+    flow_controller_(flow_controller),
     error_collector_(std::move(error_collector)),
     flush_callback_(nullptr),
     next_op_sequence_number_(0),
@@ -46,6 +46,7 @@ namespace internal {
 
 class ErrorCollector;
 class RemoteTablet;
+class WriteFlowController;
 class WriteRpc;
 struct InFlightOp;
 
@@ -67,11 +68,15 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   // is to break circular dependencies (a session keeps a reference to its
   // current batcher) and make it possible to call notify a session
   // (if it's around) from a batcher which does its job using other threads.
+  //
+  // If 'flow_controller' is not null, the write RPCs are sent under it.
+  // It must outlive the batcher.
   Batcher(KuduClient* client,
           scoped_refptr<ErrorCollector> error_collector,
           client::sp::weak_ptr<KuduSession> session,
           kudu::client::KuduSession::ExternalConsistencyMode consistency_mode,
-          const kudu::TxnId& txn_id);
+          const kudu::TxnId& txn_id,
+          WriteFlowController* flow_controller = nullptr);
 
   // Abort the current batch. Any writes that were buffered and not yet sent are
   // discarded. Those that were sent may still be delivered.  If there is a pending Flush
@@ -197,6 +202,9 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   // txn_id_.IsValid() would return 'false'.
   const TxnId txn_id_;
 
+  // Limits the write RPCs in flight to each tablet server, if not null.
+  WriteFlowController* const flow_controller_;
+
   // Errors are reported into this error collector.
   scoped_refptr<ErrorCollector> error_collector_;
 
@@ -47,11 +47,13 @@
 #include "kudu/common/partition.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/wire_protocol.h"
+#include "kudu/consensus/metadata.pb.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/human_readable.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/master/master.h"
 #include "kudu/master/master.pb.h"
 #include "kudu/master/master.proxy.h"
@@ -69,6 +71,7 @@
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/openssl_util.h"
 #include "kudu/util/thread_restrictions.h"
+#include "kudu/util/threadpool.h"
 
 DECLARE_int32(dns_resolver_max_threads_num);
 DECLARE_uint32(dns_resolver_cache_capacity_mb);
@@ -185,6 +188,9 @@ KuduClient::Data::~Data() {
   // jitter on the reactor is not a big deal (and DNS resolutions are not in flight).
   ThreadRestrictions::ScopedAllowWait allow_wait;
   dns_resolver_.reset();
+  if (scan_pool_) {
+    scan_pool_->Shutdown();
+  }
 }
 
 namespace {
@@ -227,6 +233,7 @@ RemoteTabletServer* KuduClient::Data::SelectTServer(
       break;
     }
     case CLOSEST_REPLICA:
+    case CLOSEST_NON_VOTER:
     case FIRST_REPLICA: {
       rt->GetRemoteTabletServers(candidates);
       // Exclude all the blacklisted candidates.
@@ -238,6 +245,21 @@ RemoteTabletServer* KuduClient::Data::SelectTServer(
           VLOG(1) << "Excluding blacklisted tserver " << rts->permanent_uuid();
         }
       }
+      if (selection == CLOSEST_NON_VOTER) {
+        // Choose among the non-voters, if there are any.
+        vector<RemoteReplica> replicas;
+        rt->GetRemoteReplicas(&replicas);
+        vector<RemoteTabletServer*> non_voters;
+        for (const RemoteReplica& r : replicas) {
+          if (r.role == consensus::RaftPeerPB::LEARNER &&
+              !ContainsKey(blacklist, r.ts->permanent_uuid())) {
+            non_voters.push_back(r.ts);
+          }
+        }
+        if (!non_voters.empty()) {
+          filtered.swap(non_voters);
+        }
+      }
       if (selection == FIRST_REPLICA) {
         if (!filtered.empty()) {
           ret = filtered[0];
@@ -974,5 +996,19 @@ void KuduClient::Data::UpdateLatestObservedTimestamp(uint64_t timestamp) {
   latest_observed_timestamp_.StoreMax(timestamp);
 }
 
+Status KuduClient::Data::SubmitScanTask(std::function<void()> task) {
+  ThreadPool* pool;
+  {
+    std::lock_guard<simple_spinlock> l(scan_pool_lock_);
+    if (!scan_pool_) {
+      RETURN_NOT_OK(ThreadPoolBuilder("client-scan")
+                    .set_max_threads(base::NumCPUs())
+                    .Build(&scan_pool_));
+    }
+    pool = scan_pool_.get();
+  }
+  return pool->Submit(std::move(task));
+}
+
 } // namespace client
 } // namespace kudu
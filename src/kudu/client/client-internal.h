@@ -29,6 +29,7 @@
 
 #include "kudu/client/authz_token_cache.h"
 #include "kudu/client/client.h"
+#include "kudu/client/write_flow_controller.h"
 #include "kudu/common/partition.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -45,6 +46,7 @@ namespace kudu {
 
 class DnsResolver;
 class Sockaddr;
+class ThreadPool;
 
 namespace security {
 class SignedTokenPB;
@@ -282,6 +284,11 @@ class KuduClient::Data {
 
   void UpdateLatestObservedTimestamp(uint64_t timestamp);
 
+  // Runs 'task' on the pool of the client which runs the steps of the
+  // asynchronous scans which may block, like opening a scanner on the next
+  // tablet. The pool is created on first use.
+  Status SubmitScanTask(std::function<void()> task);
+
   // The unique id of this client.
   std::string client_id_;
 
@@ -309,6 +316,9 @@ class KuduClient::Data {
   // upon learning of its expiration.
   internal::AuthzTokenCache authz_token_cache_;
 
+  // Paces the write RPCs of the sessions using adaptive flushing.
+  internal::WriteFlowController write_flow_controller_;
+
   // Set of hostnames and IPs on the local host.
   // This is initialized at client startup.
   std::unordered_set<std::string> local_host_names_;
@@ -363,6 +373,10 @@ class KuduClient::Data {
 
   AtomicInt<uint64_t> latest_observed_timestamp_;
 
+  // Protects 'scan_pool_'.
+  simple_spinlock scan_pool_lock_;
+  std::unique_ptr<ThreadPool> scan_pool_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(Data);
 };
@@ -144,6 +144,7 @@ DECLARE_bool(allow_unsafe_replication_factor);
 DECLARE_bool(catalog_manager_support_live_row_count);
 DECLARE_bool(catalog_manager_support_on_disk_size);
 DECLARE_bool(client_use_unix_domain_sockets);
+DECLARE_bool(client_write_row_data_in_sidecars);
 DECLARE_bool(enable_rowset_compaction);
 DECLARE_bool(enable_txn_system_client_init);
 DECLARE_bool(fail_dns_resolution);
@@ -185,6 +186,7 @@ DECLARE_int32(table_locations_ttl_ms);
 DECLARE_int32(txn_status_manager_inject_latency_load_from_tablet_ms);
 DECLARE_int64(live_row_count_for_testing);
 DECLARE_int64(on_disk_size_for_testing);
+DECLARE_int64(scanner_prefetch_max_bytes);
 DECLARE_string(location_mapping_cmd);
 DECLARE_string(superuser_acl);
 DECLARE_string(user_acl);
@@ -689,6 +691,9 @@ class ClientTest : public KuduTest {
 
       ASSERT_TRUE(ContainsKey(metrics, "bytes_read"));
       ASSERT_GT(metrics["bytes_read"], 0);
+
+      ASSERT_TRUE(ContainsKey(metrics, "tablets_scanned"));
+      ASSERT_GT(metrics["tablets_scanned"], 0);
     }
   }
 
@@ -1335,6 +1340,71 @@ TEST_F(ClientTest, TestScanWithQueryId) {
   DoTestScanWithStringPredicate();
 }
 
+// Test that all the rows are returned when the batches are prefetched, both
+// by NextBatch() and NextBatchAsync(), whatever the prefetch depth.
+TEST_F(ClientTest, TestScanWithPrefetching) {
+  NO_FATALS(InsertTestRows(client_table_.get(), FLAGS_test_scan_num_rows));
+
+  const auto scan = [&](int depth, bool async) {
+    SCOPED_TRACE(Substitute("depth $0, $1", depth, async ? "NextBatchAsync" : "NextBatch"));
+    KuduScanner scanner(client_table_.get());
+    ASSERT_OK(scanner.SetPrefetchDepth(depth));
+    // Set a small batch size so it reads in multiple batches.
+    ASSERT_OK(scanner.SetBatchSizeBytes(1024));
+    ASSERT_OK(scanner.Open());
+    ASSERT_TRUE(scanner.SetPrefetching(false).IsIllegalState());
+
+    KuduScanBatch batch;
+    int num_batches = 0;
+    int num_rows = 0;
+    int64_t sum = 0;
+    while (scanner.HasMoreRows()) {
+      if (async) {
+        Synchronizer s;
+        KuduStatusMemberCallback<Synchronizer> cb(&s, &Synchronizer::StatusCB);
+        scanner.NextBatchAsync(&batch, &cb);
+        ASSERT_OK(s.Wait());
+      } else {
+        ASSERT_OK(scanner.NextBatch(&batch));
+      }
+      num_batches++;
+      for (const auto& row : batch) {
+        int32_t key;
+        ASSERT_OK(row.GetInt32(0, &key));
+        sum += key;
+        num_rows++;
+      }
+      // Give the batches time to be prefetched.
+      SleepFor(MonoDelta::FromMilliseconds(1));
+    }
+    ASSERT_EQ(FLAGS_test_scan_num_rows, num_rows);
+    // The keys are 0..FLAGS_test_scan_num_rows-1.
+    ASSERT_EQ(static_cast<int64_t>(FLAGS_test_scan_num_rows) * (FLAGS_test_scan_num_rows - 1) / 2,
+              sum);
+    ASSERT_GT(num_batches, 1);
+
+    // Closing the scanner with batches prefetched is fine.
+    KuduScanner partial(client_table_.get());
+    ASSERT_OK(partial.SetPrefetchDepth(depth));
+    ASSERT_OK(partial.SetBatchSizeBytes(1024));
+    ASSERT_OK(partial.Open());
+    ASSERT_OK(partial.NextBatch(&batch));
+    ASSERT_OK(partial.NextBatch(&batch));
+    ASSERT_TRUE(partial.HasMoreRows());
+    partial.Close();
+  };
+  ASSERT_TRUE(KuduScanner(client_table_.get()).SetPrefetchDepth(-1).IsInvalidArgument());
+  for (int depth : { 1, 4 }) {
+    for (bool async : { false, true }) {
+      NO_FATALS(scan(depth, async));
+    }
+  }
+
+  // The memory of the batches prefetched is bounded.
+  FLAGS_scanner_prefetch_max_bytes = 1;
+  NO_FATALS(scan(4, false));
+}
+
 TEST_F(ClientTest, TestScanAtSnapshot) {
   int half_the_rows = FLAGS_test_scan_num_rows / 2;
 
@@ -1401,6 +1471,30 @@ TEST_F(ClientTest, TestScanAtFutureTimestamp) {
   ASSERT_STR_CONTAINS(s.ToString(), "in the future.");
 }
 
+// Test scanning with bounded staleness: the replica scans at its safe time
+// without waiting, and sees the rows written before it.
+TEST_F(ClientTest, TestScanWithMaxStaleness) {
+  NO_FATALS(InsertTestRows(client_table_.get(), FLAGS_test_scan_num_rows));
+
+  KuduScanner scanner(client_table_.get());
+  Status s = scanner.SetMaxStalenessMillis(-1);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  ASSERT_OK(scanner.SetReadMode(KuduScanner::READ_AT_SNAPSHOT));
+  ASSERT_OK(scanner.SetMaxStalenessMillis(60 * 1000));
+  ASSERT_OK(scanner.Open());
+
+  uint64_t count = 0;
+  KuduScanBatch batch;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    count += batch.NumRows();
+  }
+  ASSERT_EQ(FLAGS_test_scan_num_rows, count);
+
+  // Unless the scan is fault-tolerant, each tablet picks its own timestamp.
+  ASSERT_FALSE(scanner.data_->configuration().has_snapshot_timestamp());
+}
+
 TEST_F(ClientTest, TestColumnarScan) {
   // Set the batch size such that a full scan could yield either multi-batch
   // or single-batch scans.
@@ -1409,45 +1503,61 @@ TEST_F(ClientTest, TestColumnarScan) {
   FLAGS_scanner_batch_size_rows = batch_size;
 
   NO_FATALS(InsertTestRows(client_table_.get(), num_rows));
-  KuduScanner scanner(client_table_.get());
-  ASSERT_OK(scanner.SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
-
-  ASSERT_OK(scanner.Open());
-  KuduColumnarScanBatch batch;
-  int total_rows = 0;
-  while (scanner.HasMoreRows()) {
-    ASSERT_OK(scanner.NextBatch(&batch));
-
-    // Verify the data.
-    Slice col_data[4];
-    Slice string_indir_data;
-    ASSERT_OK(batch.GetFixedLengthColumn(0, &col_data[0]));
-    ASSERT_OK(batch.GetFixedLengthColumn(1, &col_data[1]));
-    ASSERT_OK(batch.GetVariableLengthColumn(2, &col_data[2], &string_indir_data));
-    ASSERT_OK(batch.GetFixedLengthColumn(3, &col_data[3]));
+  for (uint64_t flags : { KuduScanner::COLUMNAR_LAYOUT,
+                          KuduScanner::COLUMNAR_LAYOUT | KuduScanner::ARROW_LAYOUT,
+                          KuduScanner::COLUMNAR_LAYOUT | KuduScanner::UNDEFINED_NULL_VALUES,
+                          KuduScanner::COLUMNAR_LAYOUT | KuduScanner::COMPRESSED_COLUMNS,
+                          KuduScanner::COLUMNAR_LAYOUT | KuduScanner::ARROW_LAYOUT |
+                              KuduScanner::COMPRESSED_COLUMNS }) {
+    SCOPED_TRACE(flags);
+    const bool arrow_layout = flags & KuduScanner::ARROW_LAYOUT;
+    KuduScanner scanner(client_table_.get());
+    ASSERT_OK(scanner.SetRowFormatFlags(flags));
 
-    ArrayView<const int32_t> c0(reinterpret_cast<const int32_t*>(col_data[0].data()),
-                                batch.NumRows());
-    ArrayView<const int32_t> c1(reinterpret_cast<const int32_t*>(col_data[1].data()),
-                                batch.NumRows());
-    ArrayView<const uint32_t> c2_offsets(reinterpret_cast<const uint32_t*>(col_data[2].data()),
-                                         batch.NumRows() + 1);
-    ArrayView<const int32_t> c3(reinterpret_cast<const int32_t*>(col_data[3].data()),
-                                batch.NumRows());
+    ASSERT_OK(scanner.Open());
+    KuduColumnarScanBatch batch;
+    int total_rows = 0;
+    while (scanner.HasMoreRows()) {
+      ASSERT_OK(scanner.NextBatch(&batch));
 
-    for (int i = 0; i < batch.NumRows(); i++) {
-      int row_idx = total_rows + i;
-      EXPECT_EQ(row_idx, c0[i]);
-      EXPECT_EQ(row_idx * 2, c1[i]);
+      // Verify the data.
+      Slice col_data[4];
+      Slice string_indir_data;
+      ASSERT_OK(batch.GetFixedLengthColumn(0, &col_data[0]));
+      ASSERT_OK(batch.GetFixedLengthColumn(1, &col_data[1]));
+      ASSERT_OK(batch.GetVariableLengthColumn(2, &col_data[2], &string_indir_data));
+      ASSERT_OK(batch.GetFixedLengthColumn(3, &col_data[3]));
+      if (arrow_layout) {
+        // Every buffer is padded to a multiple of 8 bytes.
+        for (const auto& data : col_data) {
+          EXPECT_EQ(0, data.size() % 8);
+        }
+        EXPECT_EQ(0, string_indir_data.size() % 8);
+      }
 
-      Slice str(&string_indir_data[c2_offsets[i]],
-                c2_offsets[i + 1] - c2_offsets[i]);
-      EXPECT_EQ(Substitute("hello $0", row_idx), str);
-      EXPECT_EQ(row_idx * 3, c3[i]);
+      ArrayView<const int32_t> c0(reinterpret_cast<const int32_t*>(col_data[0].data()),
+                                  batch.NumRows());
+      ArrayView<const int32_t> c1(reinterpret_cast<const int32_t*>(col_data[1].data()),
+                                  batch.NumRows());
+      ArrayView<const uint32_t> c2_offsets(reinterpret_cast<const uint32_t*>(col_data[2].data()),
+                                           batch.NumRows() + 1);
+      ArrayView<const int32_t> c3(reinterpret_cast<const int32_t*>(col_data[3].data()),
+                                  batch.NumRows());
+
+      for (int i = 0; i < batch.NumRows(); i++) {
+        int row_idx = total_rows + i;
+        EXPECT_EQ(row_idx, c0[i]);
+        EXPECT_EQ(row_idx * 2, c1[i]);
+
+        Slice str(&string_indir_data[c2_offsets[i]],
+                  c2_offsets[i + 1] - c2_offsets[i]);
+        EXPECT_EQ(Substitute("hello $0", row_idx), str);
+        EXPECT_EQ(row_idx * 3, c3[i]);
+      }
+      total_rows += batch.NumRows();
     }
-    total_rows += batch.NumRows();
+    ASSERT_EQ(num_rows, total_rows);
   }
-  ASSERT_EQ(num_rows, total_rows);
 }
 
 const KuduScanner::ReadMode read_modes[] = {
@@ -3291,6 +3401,91 @@ static unique_ptr<KuduError> GetSingleErrorFromSession(KuduSession* session) {
   return unique_ptr<KuduError>(errors[0]);
 }
 
+// Test writing with the row data sent in RPC sidecars rather than in the
+// write requests.
+TEST_F(ClientTest, TestWriteRowDataInSidecars) {
+  FLAGS_client_write_row_data_in_sidecars = true;
+  constexpr int kNumRows = 1000;
+  NO_FATALS(InsertTestRows(client_table_.get(), kNumRows));
+  ASSERT_EQ(kNumRows, CountRowsFromClient(client_table_.get()));
+
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  ASSERT_OK(session->Apply(UpdateTestRow(client_table_.get(), 1).release()));
+  ASSERT_OK(session->Apply(DeleteTestRow(client_table_.get(), 2).release()));
+  FlushSessionOrDie(session);
+
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.AddConjunctPredicate(client_table_->NewComparisonPredicate(
+      "key", KuduPredicate::LESS_EQUAL, KuduValue::FromInt(3))));
+  vector<string> rows;
+  ASSERT_OK(ScanToStrings(&scanner, &rows));
+  std::sort(rows.begin(), rows.end());
+  ASSERT_EQ(vector<string>({
+      R"((int32 key=0, int32 int_val=0, string string_val="hello 0", )"
+      R"(int32 non_null_with_default=0))",
+      R"((int32 key=1, int32 int_val=3, string string_val="hello again 1", )"
+      R"(int32 non_null_with_default=3))",
+      R"((int32 key=3, int32 int_val=6, string string_val="hello 3", )"
+      R"(int32 non_null_with_default=9))" }), rows);
+}
+
+// Test writing in AUTO_FLUSH_BACKGROUND mode with adaptive flushing, with
+// several small mutation buffers flushed concurrently.
+TEST_F(ClientTest, TestAdaptiveFlush) {
+  constexpr int kNumRows = 10000;
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+  ASSERT_OK(session->SetMutationBufferAdaptiveFlush(true));
+  ASSERT_OK(session->SetMutationBufferSpace(64 * 1024));
+  ASSERT_OK(session->SetMutationBufferMaxNum(4));
+  ASSERT_OK(session->SetMutationBufferFlushInterval(10));
+  for (int i = 0; i < kNumRows; i++) {
+    ASSERT_OK(session->Apply(BuildTestInsert(client_table_.get(), i).release()));
+  }
+  // The setting can't change while writes are buffered.
+  if (session->HasPendingOperations()) {
+    ASSERT_TRUE(session->SetMutationBufferAdaptiveFlush(false).IsIllegalState());
+  }
+  FlushSessionOrDie(session);
+  ASSERT_EQ(kNumRows, CountRowsFromClient(client_table_.get()));
+  ASSERT_OK(session->SetMutationBufferAdaptiveFlush(false));
+}
+
+// Test that the write operations created by a session are reused once flushed.
+TEST_F(ClientTest, TestReuseWriteOperations) {
+  constexpr int kNumRows = 100;
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  set<KuduWriteOperation*> flushed_ops;
+  for (int i = 0; i < kNumRows; i++) {
+    KuduWriteOperation* op = session->NewWriteOperation(client_table_,
+                                                        KuduWriteOperation::INSERT);
+    ASSERT_OK(op->mutable_row()->SetInt32("key", i));
+    ASSERT_OK(op->mutable_row()->SetInt32("int_val", i));
+    ASSERT_OK(op->mutable_row()->SetStringCopy("string_val", "hello"));
+    flushed_ops.insert(op);
+    ASSERT_OK(session->Apply(op));
+  }
+  FlushSessionOrDie(session);
+
+  // The ops are put back into the pool once their RPCs are destroyed, which
+  // may be just after the flush completes.
+  unique_ptr<KuduWriteOperation> op;
+  ASSERT_EVENTUALLY([&] {
+    op.reset(session->NewWriteOperation(client_table_, KuduWriteOperation::INSERT));
+    ASSERT_EQ(1, flushed_ops.count(op.get()));
+  });
+  for (int i = 0; i < client_table_->schema().num_columns(); i++) {
+    ASSERT_FALSE(op->row().IsColumnSet(i));
+  }
+  ASSERT_OK(op->mutable_row()->SetInt32("key", kNumRows));
+  ASSERT_OK(op->mutable_row()->SetInt32("int_val", kNumRows));
+  ASSERT_OK(session->Apply(op.release()));
+  FlushSessionOrDie(session);
+  ASSERT_EQ(kNumRows + 1, CountRowsFromClient(client_table_.get()));
+}
+
 // Simplest case of inserting through the client API: a single row
 // with manual batching.
 TEST_F(ClientTest, TestInsertSingleRowManualBatch) {
@@ -6090,6 +6285,80 @@ TEST_F(ClientTest, TestSeveralRowMutatesPerBatch) {
 
 // Tests that master permits are properly released after a whole bunch of
 // rows are inserted.
+// Prefetching the locations of a table's tablets takes a single lookup, after
+// which writes to any of its tablets don't need the master anymore.
+TEST_F(ClientTest, TestPrefetchTabletLocations) {
+  constexpr const char* const kTable = "prefetch_table";
+  constexpr int kNumTablets = 20;
+  vector<unique_ptr<KuduPartialRow>> split_rows;
+  for (int i = 1; i < kNumTablets; ++i) {
+    unique_ptr<KuduPartialRow> row(schema_.NewRow());
+    ASSERT_OK(row->SetInt32("key", i * 10));
+    split_rows.emplace_back(std::move(row));
+  }
+  shared_ptr<KuduTable> table;
+  ASSERT_OK(CreateTable(kTable, 1, std::move(split_rows), {}, &table));
+
+  // Use a new client, so its meta cache is empty.
+  shared_ptr<KuduClient> client;
+  ASSERT_OK(cluster_->CreateClient(nullptr, &client));
+  ASSERT_OK(client->OpenTable(kTable, &table));
+
+  int master_rpcs_before = CountMasterLookupRPCs();
+  ASSERT_OK(table->PrefetchTabletLocations());
+  ASSERT_EQ(1, CountMasterLookupRPCs() - master_rpcs_before);
+
+  master_rpcs_before = CountMasterLookupRPCs();
+  NO_FATALS(InsertTestRows(client.get(), table.get(), kNumTablets * 10));
+  ASSERT_EQ(0, CountMasterLookupRPCs() - master_rpcs_before);
+}
+
+TEST_F(ClientTest, TestLookup) {
+  NO_FATALS(InsertTestRows(client_table_.get(), FLAGS_test_scan_num_rows));
+
+  // Look up keys of both tablets, along with a missing and a repeated key.
+  const vector<int> key_values = { 7, FLAGS_test_scan_num_rows + 1, 1,
+                                   FLAGS_test_scan_num_rows - 1, 7 };
+  vector<unique_ptr<KuduPartialRow>> rows;
+  vector<const KuduPartialRow*> keys;
+  for (int v : key_values) {
+    unique_ptr<KuduPartialRow> row(schema_.NewRow());
+    ASSERT_OK(row->SetInt32("key", v));
+    keys.push_back(row.get());
+    rows.emplace_back(std::move(row));
+  }
+  vector<KuduScanBatch*> batches;
+  ElementDeleter deleter(&batches);
+  vector<int> key_indexes;
+  ASSERT_OK(client_table_->Lookup(keys, { "key", "int_val" }, &batches, &key_indexes));
+
+  // The rows are reported along with the index of their key.
+  int num_rows = 0;
+  for (const KuduScanBatch* batch : batches) {
+    for (const KuduScanBatch::RowPtr& row : *batch) {
+      int32_t key;
+      int32_t int_val;
+      ASSERT_OK(row.GetInt32(0, &key));
+      ASSERT_OK(row.GetInt32(1, &int_val));
+      ASSERT_LT(num_rows, key_indexes.size());
+      ASSERT_EQ(key_values[key_indexes[num_rows]], key);
+      ASSERT_EQ(key * 2, int_val);
+      num_rows++;
+    }
+  }
+  ASSERT_EQ(num_rows, key_indexes.size());
+  std::sort(key_indexes.begin(), key_indexes.end());
+  ASSERT_EQ(vector<int>({ 0, 2, 3 }), key_indexes);
+
+  // The keys must set all the primary key columns.
+  unique_ptr<KuduPartialRow> unset_key(schema_.NewRow());
+  Status s = client_table_->Lookup({ unset_key.get() }, { "key" }, &batches);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+
+  s = client_table_->Lookup(keys, { "no_such_column" }, &batches);
+  ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+}
+
 TEST_F(ClientTest, TestMasterLookupPermits) {
   int initial_value = client_->data_->meta_cache_->master_lookup_sem_.GetValue();
   NO_FATALS(InsertTestRows(client_table_.get(), FLAGS_test_scan_num_rows));
@@ -7643,6 +7912,28 @@ TEST_F(ClientTest, TestPartitioner) {
     counts_by_partition.at(part_index)++;
   }
 
+  // Partitioning the rows in a batch should give the same partitions.
+  {
+    vector<unique_ptr<KuduPartialRow>> rows;
+    vector<const KuduPartialRow*> row_ptrs;
+    for (int i = 0; i < kNumRowsToPartition; i++) {
+      rows.emplace_back(table->schema().NewRow());
+      ASSERT_OK(rows.back()->SetInt32(0, i));
+      row_ptrs.emplace_back(rows.back().get());
+    }
+    vector<int> partitions;
+    ASSERT_OK(part->PartitionRows(row_ptrs, &partitions));
+    ASSERT_EQ(kNumRowsToPartition, partitions.size());
+    vector<int> batch_counts_by_partition(part->NumPartitions());
+    for (int i = 0; i < kNumRowsToPartition; i++) {
+      int part_index;
+      ASSERT_OK(part->PartitionRow(*rows[i], &part_index));
+      ASSERT_EQ(part_index, partitions[i]) << "row " << i;
+      batch_counts_by_partition.at(partitions[i])++;
+    }
+    ASSERT_EQ(counts_by_partition, batch_counts_by_partition);
+  }
+
   // We don't expect a completely even division of rows into partitions, but
   // we should be within 10% of that.
   int expected_per_partition = kNumRowsToPartition / part->NumPartitions();
@@ -22,6 +22,7 @@
 #include <openssl/crypto.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -32,6 +33,7 @@
 #include "kudu/client/error_collector.h"
 #include "kudu/client/schema.h"
 #include "kudu/client/value.h"
+#include "kudu/client/write_flow_controller.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/schema.h"
 #include "kudu/gutil/ref_counted.h"
@@ -41,6 +43,7 @@
 #include "kudu/util/test_macros.h"
 
 using kudu::client::internal::ErrorCollector;
+using kudu::client::internal::WriteFlowController;
 using std::string;
 using std::vector;
 using strings::Substitute;
@@ -437,6 +440,69 @@ TEST(ClientUnitTest, TestErrorCollector) {
   }
 }
 
+TEST(ClientUnitTest, TestWriteFlowController) {
+  constexpr const char* const kServer = "ts-1";
+  constexpr int64_t kWrite = 1024 * 1024;
+  WriteFlowController fc;
+  WriteFlowController::WriteFeedback fast;
+  fast.latency = MonoDelta::FromMilliseconds(10);
+
+  // The writes fitting into the initial window are sent right away, and
+  // the next one is queued until a write finishes.
+  vector<size_t> sent;
+  const size_t num_fitting = WriteFlowController::kInitialWindowBytes / kWrite;
+  for (size_t i = 0; i <= num_fitting; i++) {
+    fc.Send(kServer, kWrite, [&sent, i]() { sent.push_back(i); });
+  }
+  ASSERT_EQ(num_fitting, sent.size());
+  ASSERT_EQ(static_cast<int64_t>(num_fitting) * kWrite, fc.in_flight_bytes(kServer));
+  fc.Finished(kServer, kWrite, fast);
+  ASSERT_EQ(num_fitting + 1, sent.size());
+  ASSERT_EQ(num_fitting, sent.back());
+  ASSERT_GT(fc.window_bytes(kServer), WriteFlowController::kInitialWindowBytes);
+  ASSERT_EQ(10, fc.latency(kServer).ToMilliseconds());
+  for (size_t i = 0; i < num_fitting; i++) {
+    fc.Finished(kServer, kWrite, fast);
+  }
+  ASSERT_EQ(0, fc.in_flight_bytes(kServer));
+
+  // Every sign of overload halves the window, down to its minimum.
+  const int64_t window = fc.window_bytes(kServer);
+  WriteFlowController::WriteFeedback rejected;
+  rejected.latency = MonoDelta::FromMilliseconds(1);
+  rejected.rejected = true;
+  fc.Send(kServer, kWrite, []() {});
+  fc.Finished(kServer, kWrite, rejected);
+  ASSERT_EQ(window / 2, fc.window_bytes(kServer));
+
+  WriteFlowController::WriteFeedback queued = fast;
+  queued.queue_time = MonoDelta::FromMilliseconds(8);
+  fc.Send(kServer, kWrite, []() {});
+  fc.Finished(kServer, kWrite, queued);
+  ASSERT_EQ(window / 4, fc.window_bytes(kServer));
+
+  WriteFlowController::WriteFeedback slow;
+  slow.latency = MonoDelta::FromSeconds(1);
+  fc.Send(kServer, kWrite, []() {});
+  fc.Finished(kServer, kWrite, slow);
+  ASSERT_EQ(window / 8, fc.window_bytes(kServer));
+
+  for (int i = 0; i < 16; i++) {
+    fc.Send(kServer, kWrite, []() {});
+    fc.Finished(kServer, kWrite, rejected);
+  }
+  ASSERT_EQ(WriteFlowController::kMinWindowBytes, fc.window_bytes(kServer));
+
+  // A write larger than the window is let through when nothing else is in
+  // flight, and the windows of the servers are independent.
+  sent.clear();
+  fc.Send(kServer, 2 * WriteFlowController::kMinWindowBytes, [&sent]() { sent.push_back(0); });
+  ASSERT_EQ(1, sent.size());
+  fc.Send("ts-2", kWrite, [&sent]() { sent.push_back(1); });
+  ASSERT_EQ(2, sent.size());
+  ASSERT_EQ(WriteFlowController::kInitialWindowBytes, fc.window_bytes("ts-2"));
+}
+
 TEST(KuduSchemaTest, TestToString_OneUniquePrimaryKey) {
   // Test on unique PK.
   KuduSchema s;
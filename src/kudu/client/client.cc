@@ -29,6 +29,7 @@
 #include <set>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -43,6 +44,7 @@
 #include "kudu/client/error_collector.h"
 #include "kudu/client/master_proxy_rpc.h"
 #include "kudu/client/meta_cache.h"
+#include "kudu/client/parallel_scanner-internal.h"
 #include "kudu/client/partitioner-internal.h"
 #include "kudu/client/replica-internal.h"
 #include "kudu/client/row_result.h"
@@ -83,8 +85,10 @@
 #include "kudu/master/master.proxy.h"
 #include "kudu/rpc/messenger.h"
 #include "kudu/rpc/request_tracker.h"
+#include "kudu/rpc/response_callback.h"
 #include "kudu/rpc/rpc.h"
 #include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/sasl_common.h"
 #include "kudu/rpc/user_credentials.h"
 #include "kudu/security/cert.h"
@@ -93,11 +97,13 @@
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_service.proxy.h" // IWYU pragma: keep
 #include "kudu/util/async_util.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/debug-util.h"
 #include "kudu/util/init.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/logging_callback.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/oid_generator.h"
 #include "kudu/util/openssl_util.h"
@@ -1294,6 +1300,273 @@ const PartitionSchema& KuduTable::partition_schema() const {
   return data_->partition_schema_;
 }
 
+Status KuduTable::PrefetchTabletLocations() {
+  const MonoTime deadline = MonoTime::Now() + client()->default_admin_operation_timeout();
+  return client()->data_->meta_cache_->PrefetchTableLocations(this, deadline);
+}
+
+namespace {
+
+// The keys of a KuduTable::Lookup() call which belong to the same tablet,
+// and the state of the lookup RPC to the tablet.
+struct TabletLookup {
+  scoped_refptr<internal::RemoteTablet> tablet;
+  // The encoded keys, sorted, with their indexes in the keys passed to
+  // KuduTable::Lookup().
+  vector<std::pair<string, int>> keys;
+
+  tserver::LookupRowsRequestPB req;
+  tserver::LookupRowsResponsePB resp;
+  RpcController controller;
+  internal::RemoteTabletServer* ts = nullptr;
+  set<string> blacklist;
+  int attempts = 0;
+};
+
+// Sends the lookup RPC of 'l' to the leader of its tablet. On success,
+// 'callback' is called once the RPC completes.
+Status SendLookupRpc(KuduClient* client,
+                     const MonoTime& deadline,
+                     TabletLookup* l,
+                     rpc::ResponseCallback callback) {
+  vector<internal::RemoteTabletServer*> candidates;
+  RETURN_NOT_OK(client->data_->GetTabletServer(
+      client, l->tablet, KuduClient::LEADER_ONLY, l->blacklist, &candidates, &l->ts));
+  l->controller.Reset();
+  l->controller.set_deadline(deadline);
+  l->controller.RequireServerFeature(tserver::TabletServerFeatures::LOOKUP_ROWS);
+  l->resp.Clear();
+  l->ts->proxy()->LookupRowsAsync(l->req, &l->resp, &l->controller, std::move(callback));
+  return Status::OK();
+}
+
+// Handles the outcome of 'send_status', the status of sending the lookup RPC
+// of 'l', and of the RPC itself if it was sent. Sets 'retry' if the lookup
+// should be sent again, after backing off if needed. Returns an error if the
+// lookup failed for good.
+Status HandleLookupRpcResult(KuduTable* table,
+                             const MonoTime& deadline,
+                             const Status& send_status,
+                             TabletLookup* l,
+                             bool* retry) {
+  *retry = false;
+  KuduClient* client = table->client();
+  bool backoff = false;
+  Status s = send_status.ok() ? l->controller.status() : send_status;
+  if (!send_status.ok()) {
+    // There is no known leader for the tablet, which is likely undergoing an
+    // election: all the replicas may be tried again.
+    if (!s.IsServiceUnavailable()) {
+      return s;
+    }
+    l->blacklist.clear();
+    backoff = true;
+  } else if (!s.ok()) {
+    const rpc::ErrorStatusPB* err = l->controller.error_response();
+    if (s.IsRemoteError() && err) {
+      switch (err->code()) {
+        case rpc::ErrorStatusPB::ERROR_SERVER_TOO_BUSY:
+        case rpc::ErrorStatusPB::ERROR_UNAVAILABLE:
+          backoff = true;
+          break;
+        case rpc::ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN: {
+          RETURN_NOT_OK(client->data_->RetrieveAuthzToken(table, deadline));
+          security::SignedTokenPB authz_token;
+          if (client->data_->FetchCachedAuthzToken(table->id(), &authz_token)) {
+            *l->req.mutable_authz_token() = std::move(authz_token);
+          }
+          break;
+        }
+        default:
+          return s;
+      }
+    } else if (s.IsNetworkError() || s.IsServiceUnavailable()) {
+      client->data_->meta_cache_->MarkTSFailed(l->ts, s);
+      l->blacklist.insert(l->ts->permanent_uuid());
+    } else {
+      return s;
+    }
+  } else if (l->resp.has_error()) {
+    s = StatusFromPB(l->resp.error().status());
+    switch (l->resp.error().code()) {
+      case tserver::TabletServerErrorPB::TABLET_NOT_FOUND:
+        l->tablet->MarkStale();
+        l->blacklist.insert(l->ts->permanent_uuid());
+        break;
+      case tserver::TabletServerErrorPB::TABLET_NOT_RUNNING:
+      case tserver::TabletServerErrorPB::TABLET_FAILED:
+        l->blacklist.insert(l->ts->permanent_uuid());
+        break;
+      case tserver::TabletServerErrorPB::THROTTLED:
+        backoff = true;
+        break;
+      default:
+        return s;
+    }
+  } else {
+    return Status::OK();
+  }
+
+  l->attempts++;
+  if (backoff) {
+    const MonoDelta sleep = rpc::ComputeExponentialBackoff(l->attempts);
+    if (MonoTime::Now() + sleep > deadline) {
+      return Status::TimedOut(Substitute("unable to retry the lookup of tablet $0 "
+                                         "before timeout", l->tablet->tablet_id()),
+                              s.ToString());
+    }
+    SleepFor(sleep);
+  }
+  if (MonoTime::Now() > deadline) {
+    return Status::TimedOut(Substitute("lookup of tablet $0 timed out",
+                                       l->tablet->tablet_id()),
+                            s.ToString());
+  }
+  VLOG(1) << "Retrying the lookup of tablet " << l->tablet->tablet_id()
+          << " after error: " << s.ToString();
+  *retry = true;
+  return Status::OK();
+}
+
+} // anonymous namespace
+
+Status KuduTable::Lookup(const vector<const KuduPartialRow*>& keys,
+                         const vector<string>& projected_column_names,
+                         vector<KuduScanBatch*>* batches,
+                         vector<int>* key_indexes) {
+  KuduClient* c = client();
+  const MonoTime deadline = MonoTime::Now() + c->default_rpc_timeout();
+  const Schema& schema = *data_->schema_.schema_;
+
+  vector<ColumnSchema> cols;
+  cols.reserve(projected_column_names.size());
+  for (const auto& name : projected_column_names) {
+    const int idx = schema.find_column(name);
+    if (idx == Schema::kColumnNotFound) {
+      return Status::NotFound(Substitute(
+          "Column: \"$0\" was not found in the table schema.", name));
+    }
+    cols.push_back(schema.column(idx));
+  }
+  Schema projection;
+  RETURN_NOT_OK(projection.Reset(cols, 0));
+
+  // Group the keys by tablet.
+  map<string, TabletLookup> lookups;
+  for (int i = 0; i < keys.size(); i++) {
+    const KuduPartialRow* key = keys[i];
+    if (!key->IsKeySet()) {
+      return Status::InvalidArgument(Substitute(
+          "key $0 doesn't set all the primary key columns", i), key->ToString());
+    }
+    string encoded_key;
+    RETURN_NOT_OK(key->EncodeRowKey(&encoded_key));
+    scoped_refptr<internal::RemoteTablet> tablet;
+    Synchronizer sync;
+    c->data_->meta_cache_->LookupTabletByKey(this,
+                                             data_->partition_schema_.EncodeKey(*key),
+                                             deadline,
+                                             MetaCache::LookupType::kPoint,
+                                             &tablet,
+                                             sync.AsStatusCallback());
+    RETURN_NOT_OK(sync.Wait());
+    TabletLookup& l = lookups[tablet->tablet_id()];
+    l.tablet = std::move(tablet);
+    l.keys.emplace_back(std::move(encoded_key), i);
+  }
+  if (lookups.empty()) {
+    return Status::OK();
+  }
+
+  security::SignedTokenPB authz_token;
+  const bool has_authz_token = c->data_->FetchCachedAuthzToken(id(), &authz_token);
+  for (auto& [tablet_id, l] : lookups) {
+    // The tablet servers require the keys sorted and unique. Sorting the
+    // pairs puts the first index of a repeated key first.
+    std::sort(l.keys.begin(), l.keys.end());
+    l.keys.erase(std::unique(l.keys.begin(), l.keys.end(),
+                             [](const auto& a, const auto& b) { return a.first == b.first; }),
+                 l.keys.end());
+    l.req.set_tablet_id(tablet_id);
+    for (const auto& key : l.keys) {
+      l.req.add_primary_keys(key.first);
+    }
+    RETURN_NOT_OK(SchemaToColumnPBs(projection, l.req.mutable_projected_columns(),
+                                    SCHEMA_PB_WITHOUT_STORAGE_ATTRIBUTES |
+                                    SCHEMA_PB_WITHOUT_IDS));
+    if (has_authz_token) {
+      *l.req.mutable_authz_token() = authz_token;
+    }
+  }
+
+  // Send the lookups of all the tablets at once, and retry the failed ones,
+  // which should be rare, one at a time.
+  vector<Status> send_statuses;
+  send_statuses.reserve(lookups.size());
+  CountDownLatch latch(lookups.size());
+  for (auto& [_, l] : lookups) {
+    send_statuses.emplace_back(SendLookupRpc(c, deadline, &l, [&latch]() { latch.CountDown(); }));
+    if (!send_statuses.back().ok()) {
+      latch.CountDown();
+    }
+  }
+  latch.Wait();
+  int i = 0;
+  for (auto& [_, l] : lookups) {
+    Status send_status = send_statuses[i++];
+    for (;;) {
+      bool retry;
+      RETURN_NOT_OK(HandleLookupRpcResult(this, deadline, send_status, &l, &retry));
+      if (!retry) {
+        break;
+      }
+      CountDownLatch done(1);
+      send_status = SendLookupRpc(c, deadline, &l, [&done]() { done.CountDown(); });
+      if (send_status.ok()) {
+        done.Wait();
+      }
+    }
+  }
+
+  // Hand the rows found over to the caller.
+  vector<unique_ptr<KuduScanBatch>> found;
+  vector<int> found_indexes;
+  for (auto& [_, l] : lookups) {
+    if (l.resp.has_propagated_timestamp()) {
+      c->data_->UpdateLatestObservedTimestamp(l.resp.propagated_timestamp());
+    }
+    if (l.resp.found_key_indexes_size() == 0) {
+      continue;
+    }
+    for (const auto idx : l.resp.found_key_indexes()) {
+      if (PREDICT_FALSE(idx >= l.keys.size())) {
+        return Status::Corruption(Substitute("server sent invalid key index $0", idx));
+      }
+      found_indexes.push_back(l.keys[idx].second);
+    }
+    unique_ptr<KuduScanBatch> batch(new KuduScanBatch);
+    KuduScanBatch::Data* batch_data = batch->data_;
+    batch_data->owned_projection_.reset(new Schema(projection));
+    batch_data->owned_client_projection_.reset(
+        new KuduSchema(KuduSchema::FromSchema(projection)));
+    ScanResponsePB scan_resp;
+    scan_resp.mutable_data()->Swap(l.resp.mutable_data());
+    RETURN_NOT_OK(batch_data->Reset(&l.controller,
+                                    batch_data->owned_projection_.get(),
+                                    batch_data->owned_client_projection_.get(),
+                                    KuduScanner::NO_FLAGS,
+                                    &scan_resp));
+    found.emplace_back(std::move(batch));
+  }
+  for (auto& batch : found) {
+    batches->push_back(batch.release());
+  }
+  if (key_indexes) {
+    key_indexes->insert(key_indexes->end(), found_indexes.begin(), found_indexes.end());
+  }
+  return Status::OK();
+}
+
 const map<string, string>& KuduTable::extra_configs() const {
   return data_->extra_configs_;
 }
@@ -1514,6 +1787,15 @@ Status KuduSession::SetMutationBufferMaxNum(unsigned int max_num) {
   return data_->SetMaxBatchersNum(max_num);
 }
 
+Status KuduSession::SetMutationBufferAdaptiveFlush(bool enable) {
+  return data_->SetAdaptiveFlush(enable);
+}
+
+KuduWriteOperation* KuduSession::NewWriteOperation(const sp::shared_ptr<KuduTable>& table,
+                                                   KuduWriteOperation::Type type) {
+  return data_->write_op_pool_->Get(table, type);
+}
+
 void KuduSession::SetTimeoutMillis(int timeout_ms) {
   data_->SetTimeoutMillis(timeout_ms);
 }
@@ -1852,6 +2134,8 @@ Status KuduScanner::SetProjectedColumnIndexes(const vector<int>& col_indexes) {
 }
 
 Status KuduScanner::SetBatchSizeBytes(uint32_t batch_size) {
+  // The batches prefetched are requested by the reactor threads.
+  MutexLock l(data_->prefetch_lock_);
   return data_->mutable_configuration()->SetBatchSizeBytes(batch_size);
 }
 
@@ -1901,6 +2185,13 @@ Status KuduScanner::SetSnapshotRaw(uint64_t snapshot_timestamp) {
   return Status::OK();
 }
 
+Status KuduScanner::SetMaxStalenessMillis(int max_staleness_ms) {
+  if (data_->open_) {
+    return Status::IllegalState("Maximum staleness must be set before Open()");
+  }
+  return data_->mutable_configuration()->SetMaxStalenessMillis(max_staleness_ms);
+}
+
 Status KuduScanner::SetDiffScan(uint64_t start_timestamp, uint64_t end_timestamp) {
   if (data_->open_) {
     return Status::IllegalState("Diff scan must be set before Open()");
@@ -1923,6 +2214,21 @@ Status KuduScanner::SetTimeoutMillis(int millis) {
   return Status::OK();
 }
 
+Status KuduScanner::SetPrefetching(bool prefetching) {
+  if (data_->open_) {
+    return Status::IllegalState("Prefetching must be set before Open()");
+  }
+  data_->mutable_configuration()->SetPrefetching(prefetching);
+  return Status::OK();
+}
+
+Status KuduScanner::SetPrefetchDepth(int depth) {
+  if (data_->open_) {
+    return Status::IllegalState("Prefetch depth must be set before Open()");
+  }
+  return data_->mutable_configuration()->SetPrefetchDepth(depth);
+}
+
 Status KuduScanner::AddConjunctPredicate(KuduPredicate* pred) {
   // Take ownership even if returning non-OK status.
   unique_ptr<KuduPredicate> p(pred);
@@ -1994,13 +2300,14 @@ shared_ptr<KuduTable> KuduScanner::GetKuduTable() {
 }
 
 Status KuduScanner::SetRowFormatFlags(uint64_t flags) {
-  switch (flags) {
-    case NO_FLAGS:
-    case PAD_UNIXTIME_MICROS_TO_16_BYTES:
-    case COLUMNAR_LAYOUT:
-      break;
-    default:
-      return Status::InvalidArgument(Substitute("Invalid row format flags: $0", flags));
+  // The modifiers of the columnar layout may be combined freely.
+  static constexpr uint64_t kColumnarFlags =
+      COLUMNAR_LAYOUT | ARROW_LAYOUT | UNDEFINED_NULL_VALUES | COMPRESSED_COLUMNS;
+  const bool valid = (flags & COLUMNAR_LAYOUT) ?
+      (flags & ~kColumnarFlags) == 0 :
+      (flags == NO_FLAGS || flags == PAD_UNIXTIME_MICROS_TO_16_BYTES);
+  if (!valid) {
+    return Status::InvalidArgument(Substitute("Invalid row format flags: $0", flags));
   }
   if (data_->open_) {
     return Status::IllegalState("Row format flags must be set before Open()");
@@ -2113,6 +2420,8 @@ void KuduScanner::Close() {
 
   VLOG(2) << "Ending " << data_->DebugString();
 
+  data_->DiscardPrefetchedBatches();
+
   // Close the scanner on the server-side, if necessary.
   //
   // If the scan did not match any rows, the tserver will not assign a scanner ID.
@@ -2139,6 +2448,7 @@ bool KuduScanner::HasMoreRows() const {
   CHECK(data_->open_);
   bool has_more = !data_->short_circuit_ &&        // The scan is not short circuited
       (data_->data_in_open_ ||                     // more data in hand
+       data_->async_rpc_pending_ ||                // more data being fetched
        data_->last_response_.has_more_results() || // more data in this tablet
        data_->MoreTablets());                      // more tablets to scan, possibly with more data
   if (!has_more) {
@@ -2167,11 +2477,6 @@ Status KuduScanner::NextBatch(KuduColumnarScanBatch* batch) {
 }
 
 Status KuduScanner::NextBatch(internal::ScanBatchDataInterface* batch_data) {
-
-  // TODO: do some double-buffering here -- when we return this batch
-  // we should already have fired off the RPC for the next batch, but
-  // need to do some swapping of the response objects around to avoid
-  // stomping on the memory the user is looking at.
   CHECK(data_->open_);
 
   batch_data->Clear();
@@ -2185,11 +2490,15 @@ Status KuduScanner::NextBatch(internal::ScanBatchDataInterface* batch_data) {
     CHECK(data_->proxy_);
     VLOG(2) << "Extracting data from " << data_->DebugString();
     data_->data_in_open_ = false;
-    return batch_data->Reset(&data_->controller_,
-                             data_->configuration().projection(),
-                             data_->configuration().client_projection(),
-                             data_->configuration().row_format_flags(),
-                             &data_->last_response_);
+    return data_->ResetBatch(batch_data);
+  }
+
+  if (data_->async_rpc_pending_) {
+    // The next batch was prefetched, or is being fetched.
+    VLOG(2) << "Taking prefetched batch of " << data_->DebugString();
+    ScanRpcStatus result = data_->TakeAsyncRpcResult();
+    return data_->HandleContinueResult(
+        result, MonoTime::Now() + data_->configuration().timeout(), batch_data);
   }
 
   if (data_->last_response_.has_more_results()) {
@@ -2199,50 +2508,10 @@ Status KuduScanner::NextBatch(internal::ScanBatchDataInterface* batch_data) {
 
     MonoTime batch_deadline = MonoTime::Now() + data_->configuration().timeout();
     data_->PrepareRequest(KuduScanner::Data::CONTINUE);
-
-    while (true) {
-      bool allow_time_for_failover = data_->configuration().is_fault_tolerant();
-      ScanRpcStatus result = data_->SendScanRpc(batch_deadline, allow_time_for_failover);
-
-      // Success case.
-      if (result.result == ScanRpcStatus::OK) {
-        if (data_->last_response_.has_last_primary_key()) {
-          data_->last_primary_key_ = data_->last_response_.last_primary_key();
-        }
-        data_->scan_attempts_ = 0;
-        return batch_data->Reset(&data_->controller_,
-                                 data_->configuration().projection(),
-                                 data_->configuration().client_projection(),
-                                 data_->configuration().row_format_flags(),
-                                 &data_->last_response_);
-      }
-
-      data_->scan_attempts_++;
-
-      // Error handling.
-      set<string> blacklist;
-      bool needs_reopen = false;
-      Status s = data_->HandleError(result, batch_deadline, &blacklist, &needs_reopen);
-      if (!s.ok()) {
-        LOG(WARNING) << "Scan on tablet server " << data_->ts_->ToString() << " with "
-                     << data_->DebugString() << " failed: " << result.status.ToString();
-        return s;
-      }
-
-      if (data_->configuration().is_fault_tolerant()) {
-        LOG(WARNING) << "Attempting to retry " << data_->DebugString()
-                     << " elsewhere.";
-        return data_->ReopenCurrentTablet(batch_deadline, &blacklist);
-      }
-
-      if (blacklist.empty() && !needs_reopen) {
-        // If we didn't blacklist the current server, we can just retry again.
-        continue;
-      }
-      // If we blacklisted the current server, and it's not fault-tolerant, we can't
-      // retry anywhere, so just propagate the error.
-      return result.status;
-    }
+    bool allow_time_for_failover = data_->configuration().is_fault_tolerant();
+    return data_->HandleContinueResult(
+        data_->SendScanRpc(batch_deadline, allow_time_for_failover),
+        batch_deadline, batch_data);
   } else if (data_->MoreTablets()) {
     // More data may be available in other tablets.
     // No need to close the current tablet; we scanned all the data so the
@@ -2265,6 +2534,63 @@ Status KuduScanner::NextBatch(internal::ScanBatchDataInterface* batch_data) {
   }
 }
 
+void KuduScanner::NextBatchAsync(KuduScanBatch* batch, KuduStatusCallback* cb) {
+  NextBatchAsync(batch->data_, cb);
+}
+
+void KuduScanner::NextBatchAsync(KuduColumnarScanBatch* batch, KuduStatusCallback* cb) {
+  NextBatchAsync(batch->data_, cb);
+}
+
+void KuduScanner::NextBatchAsync(internal::ScanBatchDataInterface* batch_data,
+                                 KuduStatusCallback* cb) {
+  CHECK(data_->open_);
+  KuduClient::Data* client_data = data_->table_->client()->data_;
+
+  if (data_->short_circuit_ || data_->data_in_open_) {
+    // The batch is at hand.
+    cb->Run(NextBatch(batch_data));
+    return;
+  }
+
+  if (!data_->async_rpc_pending_ && data_->last_response_.has_more_results()) {
+    CHECK(data_->proxy_);
+    VLOG(2) << "Continuing " << data_->DebugString();
+    batch_data->Clear();
+    data_->SendContinueRpcAsync();
+  }
+
+  if (data_->async_rpc_pending_) {
+    // The batch is collected on the reactor thread which completes its RPC,
+    // unless the RPC has to be retried, which may block.
+    data_->WhenAsyncRpcDone([this, client_data, batch_data, cb]() {
+      batch_data->Clear();
+      ScanRpcStatus result = data_->TakeAsyncRpcResult();
+      const MonoTime batch_deadline = MonoTime::Now() + data_->configuration().timeout();
+      if (result.result == ScanRpcStatus::OK) {
+        cb->Run(data_->HandleContinueResult(result, batch_deadline, batch_data));
+        return;
+      }
+      Status s = client_data->SubmitScanTask(
+          [this, result, batch_deadline, batch_data, cb]() {
+            cb->Run(data_->HandleContinueResult(result, batch_deadline, batch_data));
+          });
+      if (!s.ok()) {
+        cb->Run(s);
+      }
+    });
+    return;
+  }
+
+  // Opening the scanner on the next tablet blocks.
+  Status s = client_data->SubmitScanTask([this, batch_data, cb]() {
+    cb->Run(NextBatch(batch_data));
+  });
+  if (!s.ok()) {
+    cb->Run(s);
+  }
+}
+
 Status KuduScanner::GetCurrentServer(KuduTabletServer** server) {
   CHECK(data_->open_);
   internal::RemoteTabletServer* rts = data_->ts_;
@@ -2415,6 +2741,55 @@ void KuduScanTokenBuilder::SetSplitSizeBytes(uint64_t split_size_bytes) {
   return data_->SplitSizeBytes(split_size_bytes);
 }
 
+////////////////////////////////////////////////////////////
+// KuduParallelScanner
+////////////////////////////////////////////////////////////
+
+KuduParallelScanner::KuduParallelScanner(const vector<KuduScanToken*>& tokens)
+    : data_(new KuduParallelScanner::Data(tokens)) {
+}
+
+KuduParallelScanner::~KuduParallelScanner() {
+  delete data_;
+}
+
+Status KuduParallelScanner::SetMaxConcurrency(int max_concurrency) {
+  return data_->SetMaxConcurrency(max_concurrency);
+}
+
+Status KuduParallelScanner::SetMaxConcurrencyPerTabletServer(int max_concurrency) {
+  return data_->SetMaxConcurrencyPerTabletServer(max_concurrency);
+}
+
+Status KuduParallelScanner::SetMaxBufferedBatches(int max_batches) {
+  return data_->SetMaxBufferedBatches(max_batches);
+}
+
+Status KuduParallelScanner::Open() {
+  return data_->Open();
+}
+
+bool KuduParallelScanner::HasMoreRows() const {
+  return data_->HasMoreRows();
+}
+
+Status KuduParallelScanner::NextBatch(KuduScanBatch* batch) {
+  unique_ptr<KuduScanBatch> next;
+  RETURN_NOT_OK(data_->NextBatch(&next));
+  if (!next) {
+    batch->data_->Clear();
+    return Status::OK();
+  }
+  // The queued batch owns the RPC response its rows point into, so taking
+  // over its data doesn't copy any row.
+  std::swap(batch->data_, next->data_);
+  return Status::OK();
+}
+
+void KuduParallelScanner::Close() {
+  data_->Close();
+}
+
 ////////////////////////////////////////////////////////////
 // KuduReplica
 ////////////////////////////////////////////////////////////
@@ -2522,5 +2897,10 @@ Status KuduPartitioner::PartitionRow(const KuduPartialRow& row, int* partition)
   return data_->PartitionRow(row, partition);
 }
 
+Status KuduPartitioner::PartitionRows(const vector<const KuduPartialRow*>& rows,
+                                      vector<int>* partitions) {
+  return data_->PartitionRows(rows, partitions);
+}
+
 } // namespace client
 } // namespace kudu
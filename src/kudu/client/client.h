@@ -39,6 +39,7 @@
 #include "kudu/client/scan_predicate.h"
 #include "kudu/client/schema.h"
 #include "kudu/client/shared_ptr.h" // IWYU pragma: keep
+#include "kudu/client/write_op.h"
 #ifdef KUDU_HEADERS_NO_STUBS
 #include <gtest/gtest_prod.h>
 
@@ -948,7 +949,13 @@ class KUDU_EXPORT KuduClient : public sp::enable_shared_from_this<KuduClient> {
                       ///< client, followed by all other replicas. If there are
                       ///< multiple closest replicas, one is chosen randomly.
 
-    FIRST_REPLICA     ///< Select the first replica in the list.
+    FIRST_REPLICA,    ///< Select the first replica in the list.
+
+    CLOSEST_NON_VOTER ///< Select the closest NON_VOTER replica, as
+                      ///< CLOSEST_REPLICA does among the non-voters, e.g. to
+                      ///< direct the scans at the read replicas of the
+                      ///< tablets. If there is no non-voter available, select
+                      ///< the closest replica.
   };
 
   /// @return @c true iff client is configured to talk to multiple
@@ -1858,6 +1865,57 @@ class KUDU_EXPORT KuduTable : public sp::enable_shared_from_this<KuduTable> {
   /// @return The table's extra configuration properties.
   const std::map<std::string, std::string>& extra_configs() const;
 
+  /// Fetch the locations of all the tablets of the table into the client's
+  /// cache of tablet locations.
+  ///
+  /// By default, the client looks up the location of a tablet the first time
+  /// it is accessed, fetching the locations of a few neighbouring tablets
+  /// along the way. A client writing or reading at random across many
+  /// tablets thus sends many lookups to the masters until its cache is warm.
+  /// This method warms up the cache in as few lookups as possible instead,
+  /// i.e. one per thousand tablets. The cached locations expire like those
+  /// fetched on demand.
+  ///
+  /// This operation has a timeout equal to the default admin operation
+  /// timeout of the table's client instance.
+  ///
+  /// @return Operation result status.
+  Status PrefetchTabletLocations() WARN_UNUSED_RESULT;
+
+  /// Look up the rows of the table with the given primary keys.
+  ///
+  /// The keys are grouped by tablet, and each tablet is sent a single
+  /// request for all its keys, concurrently with the other tablets. Compared
+  /// to a scan per key, this saves a round trip to open and close a scanner
+  /// for each key, and lets the tablet servers check the presence of all the
+  /// keys of a rowset at once.
+  ///
+  /// The lookups read the latest data committed at the leader of each tablet,
+  /// like a scan in the @c READ_LATEST mode. The rows aren't read at the same
+  /// snapshot across tablets.
+  ///
+  /// This operation has a timeout equal to the default RPC timeout of the
+  /// table's client instance.
+  ///
+  /// @param [in] keys
+  ///   The primary keys of the rows to look up. The rows must be created
+  ///   from the schema of this table, and have all their key columns set.
+  ///   The caller retains ownership of the rows.
+  /// @param [in] projected_column_names
+  ///   The names of the columns to return for each row found.
+  /// @param [out] batches
+  ///   The rows found, in batches. It is the caller's responsibility to free
+  ///   the batches, which remain valid after the table is destroyed.
+  /// @param [out] key_indexes
+  ///   If not null, the index in @c keys of each row found, in the order of
+  ///   the rows in @c batches. The keys not found are missing from it. For
+  ///   a key passed more than once, only its first index is reported.
+  /// @return Operation result status.
+  Status Lookup(const std::vector<const KuduPartialRow*>& keys,
+                const std::vector<std::string>& projected_column_names,
+                std::vector<KuduScanBatch*>* batches,
+                std::vector<int>* key_indexes = NULL) WARN_UNUSED_RESULT;
+
   /// @cond PRIVATE_API
 
   /// List the partitions of this table in 'partitions'. This operation may
@@ -2510,6 +2568,55 @@ class KUDU_EXPORT KuduSession : public sp::enable_shared_from_this<KuduSession>
   /// @return Operation result status.
   Status SetMutationBufferMaxNum(unsigned int max_num) WARN_UNUSED_RESULT;
 
+  /// Enable or disable adaptive flushing of the mutation buffers.
+  ///
+  /// With adaptive flushing, the write RPCs of the session are paced per
+  /// tablet server: the number of bytes in flight to each server is limited
+  /// to a window which grows while the server handles the writes promptly
+  /// and shrinks as soon as the server reports being overloaded or its
+  /// write latency spikes. The window of a server is shared by all
+  /// the sessions of the client using adaptive flushing. In addition, in
+  /// the AUTO_FLUSH_BACKGROUND mode, a mutation buffer which reaches its
+  /// flush interval (see KuduSession::SetMutationBufferFlushInterval())
+  /// while earlier buffers are still being flushed keeps accumulating
+  /// operations until they are done, for at most 4 flush intervals, so that
+  /// small batches get coalesced rather than queued behind each other.
+  ///
+  /// Adaptive flushing is disabled by default.
+  ///
+  /// @param [in] enable
+  ///   Whether to enable adaptive flushing.
+  /// @return Operation result status. Changing the setting is not allowed
+  ///   while there are pending operations.
+  Status SetMutationBufferAdaptiveFlush(bool enable) WARN_UNUSED_RESULT;
+
+  /// Create a new write operation, reusing one created by the session earlier.
+  ///
+  /// The operations created with KuduTable::NewInsert() and alike are
+  /// allocated anew along with their rows for every write, and freed once
+  /// flushed. The operations created with this method are instead kept by
+  /// the session once successfully flushed, and handed out again by this
+  /// method with all the columns of their rows unset. So a steady stream of
+  /// writes of a producer does not allocate memory per operation.
+  ///
+  /// Apart from that, the returned operation is the same as one created with
+  /// KuduTable::NewInsert() and alike: it's normally passed to Apply(), and
+  /// it may be applied to any session or deleted.
+  ///
+  /// @note The values of string and binary columns set with
+  ///   KuduPartialRow::SetStringCopy() and alike are still copied into memory
+  ///   allocated per value. Set them with KuduPartialRow::SetStringNoCopy()
+  ///   and alike, using data which outlives the flush of the operation,
+  ///   to avoid that.
+  ///
+  /// @param [in] table
+  ///   The table to write to.
+  /// @param [in] type
+  ///   The type of the operation.
+  /// @return Pointer to the new operation; the caller takes its ownership.
+  KuduWriteOperation* NewWriteOperation(const sp::shared_ptr<KuduTable>& table,
+                                        KuduWriteOperation::Type type);
+
   /// Set the timeout for writes made in this session.
   ///
   /// @param [in] millis
@@ -3044,6 +3151,32 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status NextBatch(KuduColumnarScanBatch* batch);
 
+  /// Fetch the next batch of results for this scanner asynchronously.
+  ///
+  /// Like NextBatch(KuduScanBatch*), but returns right away and invokes
+  /// @c cb with the result of the operation once @c batch holds the next
+  /// batch. A single call may be outstanding per scanner at any time, and
+  /// no other method of the scanner may be called until @c cb is invoked.
+  ///
+  /// As in all other async functions in Kudu, the callback may be called
+  /// either from an IO thread, a thread of the client or the same thread
+  /// which calls NextBatchAsync(). The callback should not block, nor
+  /// destroy the scanner.
+  ///
+  /// @param [out] batch
+  ///   Placeholder for the result. It must remain valid until @c cb is
+  ///   invoked.
+  /// @param [in] cb
+  ///   Callback to call once the batch is fetched. The @c cb must remain
+  ///   valid until it is invoked.
+  void NextBatchAsync(KuduScanBatch* batch, KuduStatusCallback* cb);
+
+  /// Fetch the next batch of columnar results for this scanner
+  /// asynchronously.
+  ///
+  /// @copydetails NextBatchAsync(KuduScanBatch*, KuduStatusCallback*)
+  void NextBatchAsync(KuduColumnarScanBatch* batch, KuduStatusCallback* cb);
+
   /// Get the KuduTabletServer that is currently handling the scan.
   ///
   /// More concretely, this is the server that handled the most recent
@@ -3055,6 +3188,12 @@ class KUDU_EXPORT KuduScanner {
   Status GetCurrentServer(KuduTabletServer** server);
 
   /// @return Cumulative resource metrics since the scan was started.
+  ///   Besides the metrics reported by the tablet servers, they include
+  ///   'tablets_scanned', the number of tablets the scan was sent to, and
+  ///   'tablets_pruned', the number of tablets looked up but skipped because
+  ///   of the predicates. The tablets outside of the partition key ranges of
+  ///   the scan, e.g. the hash buckets unreachable from its equality and
+  ///   IN-list predicates, aren't even looked up.
   const ResourceMetrics& GetResourceMetrics() const;
 
   /// Set the hint for the size of the next batch in bytes.
@@ -3122,6 +3261,26 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status SetSnapshotRaw(uint64_t snapshot_timestamp) WARN_UNUSED_RESULT;
 
+  /// Bound the staleness of a scan in @c READ_AT_SNAPSHOT mode without
+  /// a snapshot timestamp.
+  ///
+  /// Instead of picking the current time and waiting for the replica to catch
+  /// up to it, each replica scans at the latest timestamp for which it has
+  /// applied all the operations, provided that it is no older than
+  /// @c max_staleness_ms. Otherwise the replica rejects the scan, which is
+  /// retried on another replica. This lets followers serve the scans without
+  /// waiting, at the price of reading slightly stale data.
+  ///
+  /// Unless the scan is fault-tolerant, different tablets may be scanned at
+  /// different timestamps.
+  ///
+  /// @note This method is experimental and may change in a future release.
+  ///
+  /// @param [in] max_staleness_ms
+  ///   The maximum staleness of the scanned data, in milliseconds.
+  /// @return Operation result status.
+  Status SetMaxStalenessMillis(int max_staleness_ms) WARN_UNUSED_RESULT;
+
   /// @cond PRIVATE_API
 
   /// Set the start and end timestamp for a diff scan. The timestamps should be
@@ -3150,6 +3309,32 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status SetTimeoutMillis(int millis);
 
+  /// Set whether the scanner fetches the next batch of a tablet while the
+  /// current batch is processed.
+  ///
+  /// When enabled, the RPC for the next batch is sent as soon as a batch is
+  /// returned by NextBatch() or NextBatchAsync(), so that the batches are
+  /// processed while the next ones are transferred. It's disabled by
+  /// default.
+  ///
+  /// @param [in] prefetching
+  ///   Whether to prefetch the next batch.
+  /// @return Operation result status.
+  Status SetPrefetching(bool prefetching) WARN_UNUSED_RESULT;
+
+  /// Set the number of batches of a tablet the scanner fetches ahead of the
+  /// calls to NextBatch() or NextBatchAsync().
+  ///
+  /// Once a batch arrives, the RPC for the next one is sent right away until
+  /// as many batches as the depth are buffered, or their memory reaches
+  /// --scanner_prefetch_max_bytes. A depth of 1 is what SetPrefetching()
+  /// enables, and a depth of 0 disables prefetching.
+  ///
+  /// @param [in] depth
+  ///   The number of batches to prefetch. Must not be negative.
+  /// @return Operation result status.
+  Status SetPrefetchDepth(int depth) WARN_UNUSED_RESULT;
+
   /// @return Schema of the projection being scanned.
   KuduSchema GetProjectionSchema() const;
 
@@ -3183,6 +3368,32 @@ class KUDU_EXPORT KuduScanner {
   /// code path.
   static const uint64_t COLUMNAR_LAYOUT = 1 << 1;
 
+  /// Lay out the columnar data following the Apache Arrow columnar format, so that the
+  /// buffers returned by KuduColumnarScanBatch can be used as Arrow buffers without
+  /// copying them: BOOL cells are bit-packed rather than stored as one byte each, and
+  /// every buffer is zero-padded to a multiple of 8 bytes. The buffers are not
+  /// guaranteed to be aligned in memory. Must be combined with COLUMNAR_LAYOUT.
+  ///
+  /// NOTE: older versions of the Kudu server do not support this feature.
+  static const uint64_t ARROW_LAYOUT = 1 << 2;
+
+  /// Leave the data of the null cells of the fixed-length columns undefined rather
+  /// than zeroing them, which spares the server a pass over the data of the nullable
+  /// columns. The non-null bitmaps must then be checked before reading the cells.
+  /// Must be combined with COLUMNAR_LAYOUT, and optionally with ARROW_LAYOUT.
+  ///
+  /// NOTE: older versions of the Kudu server do not support this feature.
+  static const uint64_t UNDEFINED_NULL_VALUES = 1 << 3;
+
+  /// Compress the columnar data with LZ4 on the server, and decompress it in the
+  /// client library when the batches are received. This trades some CPU on both
+  /// ends for fewer bytes on the network, e.g. for bulk exports over slow links.
+  /// Must be combined with COLUMNAR_LAYOUT, and optionally with the other columnar
+  /// flags.
+  ///
+  /// NOTE: older versions of the Kudu server do not support this feature.
+  static const uint64_t COMPRESSED_COLUMNS = 1 << 4;
+
   /// Optionally set row format modifier flags.
   ///
   /// If flags is RowFormatFlags::NO_FLAGS, then no modifications will be made to the row
@@ -3231,6 +3442,7 @@ class KUDU_EXPORT KuduScanner {
   class KUDU_NO_EXPORT Data;
 
   Status NextBatch(internal::ScanBatchDataInterface* batch);
+  void NextBatchAsync(internal::ScanBatchDataInterface* batch, KuduStatusCallback* cb);
 
   friend class KuduScanToken;
   friend class FlexPartitioningTest;
@@ -3481,6 +3693,106 @@ class KUDU_EXPORT KuduScanTokenBuilder {
   DISALLOW_COPY_AND_ASSIGN(KuduScanTokenBuilder);
 };
 
+/// @brief Scans a set of scan tokens concurrently.
+///
+/// The parallel scanner opens a scanner per token and runs several of them at
+/// once, returning the batches they produce in no particular order. The scans
+/// are spread over the tablet servers hosting the tablets of the tokens, and
+/// the number of concurrent scans per tablet server is bounded so that a few
+/// servers don't get all the scans at once.
+///
+/// Example usage:
+/// @code
+///   KuduParallelScanner scanner(tokens);
+///   KUDU_RETURN_NOT_OK(scanner.Open());
+///   KuduScanBatch batch;
+///   while (scanner.HasMoreRows()) {
+///     KUDU_RETURN_NOT_OK(scanner.NextBatch(&batch));
+///     for (const KuduScanBatch::RowPtr& row : batch) {
+///       // Process the row.
+///     }
+///   }
+/// @endcode
+///
+/// @note This class is not thread-safe: a single thread is to consume its
+///   batches, while the scans run on threads of its own.
+class KUDU_EXPORT KuduParallelScanner {
+ public:
+  /// Construct an instance of the class.
+  ///
+  /// @param [in] tokens
+  ///   The tokens to scan. The parallel scanner doesn't take ownership of the
+  ///   tokens, which must remain valid for the lifetime of the scanner.
+  explicit KuduParallelScanner(const std::vector<KuduScanToken*>& tokens);
+  ~KuduParallelScanner();
+
+  /// Set the maximum number of tokens scanned concurrently.
+  ///
+  /// @param [in] max_concurrency
+  ///   The maximum number of concurrent scans. The default is 8.
+  /// @return Operation result status.
+  Status SetMaxConcurrency(int max_concurrency) WARN_UNUSED_RESULT;
+
+  /// Set the maximum number of tokens scanned concurrently from the same
+  /// tablet server.
+  ///
+  /// The tablet server of a token is the one hosting the leader replica of
+  /// its tablet according to the tablet locations cached when the token was
+  /// built, if known, or else the first of its replicas.
+  ///
+  /// @param [in] max_concurrency
+  ///   The maximum number of concurrent scans per tablet server.
+  ///   The default is 2.
+  /// @return Operation result status.
+  Status SetMaxConcurrencyPerTabletServer(int max_concurrency) WARN_UNUSED_RESULT;
+
+  /// Set the maximum number of batches scanned but not returned by
+  /// NextBatch() yet. Once that many batches are buffered, the scans wait for
+  /// the batches to be consumed.
+  ///
+  /// @param [in] max_batches
+  ///   The maximum number of buffered batches. The default is 16.
+  /// @return Operation result status.
+  Status SetMaxBufferedBatches(int max_batches) WARN_UNUSED_RESULT;
+
+  /// Start scanning the tokens.
+  ///
+  /// @return Operation result status.
+  Status Open() WARN_UNUSED_RESULT;
+
+  /// Check if there may be rows to be fetched.
+  ///
+  /// @return @c true if there are batches left to return, tokens left to
+  ///   scan, or an error of a scan to report with NextBatch().
+  bool HasMoreRows() const;
+
+  /// Get the next batch of rows, from any of the tokens.
+  ///
+  /// Waits for a scan to produce a batch if none is buffered. The batch may
+  /// be empty once all the tokens have been scanned. The rows of the batch
+  /// remain valid until the next call to this method with the same batch,
+  /// or until the parallel scanner is closed.
+  ///
+  /// @param [out] batch
+  ///   Placeholder for the result.
+  /// @return Operation result status. If the scan of a token failed, the
+  ///   first such error is returned and the other scans are stopped.
+  Status NextBatch(KuduScanBatch* batch) WARN_UNUSED_RESULT;
+
+  /// Stop the scans and release their resources.
+  ///
+  /// This is called automatically when the parallel scanner is destroyed.
+  void Close();
+
+ private:
+  class KUDU_NO_EXPORT Data;
+
+  // Owned.
+  Data* data_;
+
+  DISALLOW_COPY_AND_ASSIGN(KuduParallelScanner);
+};
+
 /// @brief Builder for Partitioner instances.
 class KUDU_EXPORT KuduPartitionerBuilder {
  public:
@@ -3557,6 +3869,20 @@ class KUDU_EXPORT KuduPartitioner {
   ///   provided row does not have all columns of the partition key
   ///   set.
   Status PartitionRow(const KuduPartialRow& row, int* partition);
+
+  /// Determine the partition indexes that the given rows fall into, as
+  /// @c PartitionRow would for each of them. This is cheaper than calling
+  /// @c PartitionRow for each row: the partition key columns are resolved
+  /// once for all the rows.
+  ///
+  /// @param [in] rows
+  ///   The rows to be partitioned. They must all have the same schema.
+  /// @param [out] partitions
+  ///   The resulting partition indexes, in the order of @c rows.
+  ///
+  /// @return Status::OK if successful.
+  Status PartitionRows(const std::vector<const KuduPartialRow*>& rows,
+                       std::vector<int>* partitions);
  private:
   class KUDU_NO_EXPORT Data;
 
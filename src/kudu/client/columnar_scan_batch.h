@@ -43,7 +43,10 @@ namespace client {
 ///
 /// The columnar data retrieved by this class matches the columnar encoding described by
 /// Apache Arrow[1], but without the alignment and padding guarantees that are made by
-/// the Arrow IPC serialization.
+/// the Arrow IPC serialization. If the KuduScanner::ARROW_LAYOUT row format flag is
+/// also enabled, BOOL columns are bit-packed and every buffer is zero-padded to a multiple
+/// of 8 bytes, so that the buffers can be wrapped as the buffers of an Arrow record batch
+/// without copying them.
 ///
 /// [1] https://arrow.apache.org/docs/format/Columnar.html
 ///
@@ -69,6 +72,8 @@ class KUDU_EXPORT KuduColumnarScanBatch {
   ///   The data is in little-endian packed array format. No alignment or padding is guaranteed.
   ///   Space is reserved for all cells regardless of whether they might be null.
   ///   The data stored in a null cell may or may not be zeroed.
+  ///   With the KuduScanner::ARROW_LAYOUT flag, BOOL cells are stored as a bitmap (a set
+  ///   bit indicates 'true') and the data is zero-padded to a multiple of 8 bytes.
   /// @return Operation result status.
   Status GetFixedLengthColumn(int idx, Slice* data) const;
 
@@ -81,7 +86,8 @@ class KUDU_EXPORT KuduColumnarScanBatch {
   ///   will contain NumRows() + 1 entries, each indicating an offset within the
   ///   variable-length data array returned in 'data'. For each cell with index 'n',
   ///   offsets[n] indicates the starting offset of that cell, and offsets[n+1] indicates
-  ///   the ending offset of that cell.
+  ///   the ending offset of that cell. With the KuduScanner::ARROW_LAYOUT flag, the
+  ///   array is zero-padded to a multiple of 8 bytes.
   /// @param [out] data
   ///   The variable-length data.
   /// @return Operation result status.
@@ -100,7 +106,8 @@ class KUDU_EXPORT KuduColumnarScanBatch {
   ///   The bitmap corresponding to the non-null status of the cells in the given column.
   ///   A set bit indicates a non-null cell.
   ///   If the number of rows is not a multiple of 8, the state of the trailing bits in the
-  ///   bitmap is undefined.
+  ///   bitmap is undefined, unless the KuduScanner::ARROW_LAYOUT flag is set, in which
+  ///   case they are zeroed and the bitmap is zero-padded to a multiple of 8 bytes.
   /// @return Operation result status.
   Status GetNonNullBitmapForColumn(int idx, Slice* data) const;
 
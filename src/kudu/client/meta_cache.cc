@@ -17,6 +17,8 @@
 
 #include "kudu/client/meta_cache.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -108,6 +110,13 @@ DEFINE_bool(prevent_kudu_3461_infinite_recursion, true,
             "client metacache as described in KUDU-3461. Used for testing only!");
 TAG_FLAG(prevent_kudu_3461_infinite_recursion, unsafe);
 
+DEFINE_int32(client_replica_lag_ttl_ms, 5000,
+             "For how long the client remembers that the safe time of a tablet "
+             "replica lags too far behind to serve bounded-staleness scans. Once "
+             "this expires, such scans may be sent to the replica again.");
+TAG_FLAG(client_replica_lag_ttl_ms, advanced);
+TAG_FLAG(client_replica_lag_ttl_ms, runtime);
+
 namespace kudu {
 namespace client {
 namespace internal {
@@ -378,6 +387,29 @@ void RemoteTablet::MarkTServerAsFollower(const RemoteTabletServer* server) {
   VLOG(3) << "Latest replicas: " << ReplicasAsStringUnlocked();
 }
 
+void RemoteTablet::UpdateReplicaLag(const RemoteTabletServer* server, MonoDelta lag) {
+  const MonoTime now = MonoTime::Now();
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (RemoteReplica& replica : replicas_) {
+    if (replica.ts == server) {
+      replica.safe_time_lag = lag;
+      replica.lag_observed = now;
+    }
+  }
+}
+
+void RemoteTablet::GetLaggingReplicas(MonoDelta max_lag, set<string>* uuids) const {
+  const MonoTime expired = MonoTime::Now() -
+      MonoDelta::FromMilliseconds(FLAGS_client_replica_lag_ttl_ms);
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (const RemoteReplica& replica : replicas_) {
+    if (replica.lag_observed.Initialized() && replica.lag_observed > expired &&
+        replica.safe_time_lag > max_lag) {
+      uuids->insert(replica.ts->permanent_uuid());
+    }
+  }
+}
+
 string RemoteTablet::ReplicasAsString() const {
   std::lock_guard<simple_spinlock> l(lock_);
   return ReplicasAsStringUnlocked();
@@ -643,13 +675,57 @@ void MetaCacheServerPicker::InitProxyCb(const ServerPickedCallback& callback,
 
 ////////////////////////////////////////////////////////////
 
+namespace {
+std::atomic<uint64_t> next_meta_cache_id(1);
+} // anonymous namespace
+
 MetaCache::MetaCache(KuduClient* client,
                      ReplicaController::Visibility replica_visibility)
     : client_(client),
+      key_index_(std::make_shared<KeyIndex>()),
+      key_index_version_(0),
+      cache_id_(next_meta_cache_id++),
       master_lookup_sem_(50),
       replica_visibility_(replica_visibility) {
 }
 
+void MetaCache::PublishKeyIndexUnlocked(const string& table_id) {
+  DCHECK(lock_.is_write_locked());
+  auto index = std::make_shared<KeyIndex>(*key_index_);
+  const TabletMap* tablets = FindOrNull(tablets_by_table_and_key_, table_id);
+  if (tablets) {
+    auto table_index = std::make_shared<TableKeyIndex>();
+    table_index->lower_bounds.reserve(tablets->size());
+    table_index->entries.reserve(tablets->size());
+    for (const auto& e : *tablets) {
+      table_index->lower_bounds.emplace_back(e.first);
+      table_index->entries.emplace_back(e.second);
+    }
+    (*index)[table_id] = std::move(table_index);
+  } else {
+    index->erase(table_id);
+  }
+  key_index_ = std::move(index);
+  key_index_version_.fetch_add(1, std::memory_order_release);
+}
+
+const MetaCache::KeyIndex* MetaCache::GetKeyIndex() {
+  struct CachedKeyIndex {
+    uint64_t cache_id = 0;
+    uint64_t version = 0;
+    std::shared_ptr<const KeyIndex> index;
+  };
+  static thread_local CachedKeyIndex cached;
+  if (PREDICT_FALSE(cached.cache_id != cache_id_ ||
+                    cached.version != key_index_version_.load(std::memory_order_acquire))) {
+    shared_lock<rw_spinlock> l(lock_.get_lock());
+    cached.cache_id = cache_id_;
+    cached.version = key_index_version_.load(std::memory_order_relaxed);
+    cached.index = key_index_;
+  }
+  return cached.index.get();
+}
+
 void MetaCache::UpdateTabletServerUnlocked(const TSInfoPB& pb) {
   DCHECK(lock_.is_write_locked());
   const auto& ts_uuid = pb.permanent_uuid();
@@ -1101,6 +1177,8 @@ Status MetaCache::ProcessGetTableLocationsResponse(const KuduTable* table,
   std::lock_guard<percpu_rwlock> l(lock_);
   TabletMap& tablets_by_key = LookupOrInsert(&tablets_by_table_and_key_,
                                              table->id(), TabletMap());
+  // Publish whatever was cached, even if processing the response fails.
+  SCOPED_CLEANUP({ PublishKeyIndexUnlocked(table->id()); });
 
   const auto& tablet_locations = resp.tablet_locations();
 
@@ -1259,21 +1337,22 @@ bool MetaCache::LookupEntryByKeyFastPath(const KuduTable* table,
                                          const PartitionKey& partition_key,
                                          MetaCacheEntry* entry) {
   SCOPED_LOG_SLOW_EXECUTION(WARNING, 50, "looking up entry by key");
-  shared_lock<rw_spinlock> l(lock_.get_lock());
-  const TabletMap* tablets = FindOrNull(tablets_by_table_and_key_, table->id());
+  const auto* tablets = FindOrNull(*GetKeyIndex(), table->id());
   if (PREDICT_FALSE(!tablets)) {
     // No cache available for this table.
     VLOG(2) << Substitute("No cache available for table $0", table->name());
     return false;
   }
 
-  const MetaCacheEntry* e = FindFloorOrNull(*tablets, partition_key);
-  if (PREDICT_FALSE(!e)) {
+  const auto& lower_bounds = (*tablets)->lower_bounds;
+  const auto it = std::upper_bound(lower_bounds.begin(), lower_bounds.end(), partition_key);
+  if (PREDICT_FALSE(it == lower_bounds.begin())) {
     // No tablets with a start partition key lower than 'partition_key'.
     VLOG(2) << Substitute("Table $0: No tablets found with a start key lower than input key.",
                           table->name());
     return false;
   }
+  const MetaCacheEntry* e = &(*tablets)->entries[it - lower_bounds.begin() - 1];
 
   // Stale entries must be re-fetched.
   if (e->stale()) {
@@ -1373,6 +1452,7 @@ void MetaCache::ClearNonCoveredRangeEntries(const std::string& table_id) {
       it++;
     }
   }
+  PublishKeyIndexUnlocked(table_id);
 }
 
 void MetaCache::ClearCache() {
@@ -1382,6 +1462,8 @@ void MetaCache::ClearCache() {
   tablets_by_id_.clear();
   tablets_by_table_and_key_.clear();
   entry_by_tablet_id_.clear();
+  key_index_ = std::make_shared<KeyIndex>();
+  key_index_version_.fetch_add(1, std::memory_order_release);
 }
 
 Status MetaCache::GetTableKeyRanges(const KuduTable* table,
@@ -1461,6 +1543,34 @@ Status MetaCache::GetTableKeyRanges(const KuduTable* table,
   return Status::OK();
 }
 
+Status MetaCache::PrefetchTableLocations(const KuduTable* table,
+                                         const MonoTime& deadline) {
+  // Walk the partition key space tablet by tablet: a range lookup which
+  // misses the cache fetches the locations of the next page of tablets, so
+  // the following lookups take the fast path until that page is consumed.
+  PartitionKey partition_key;
+  while (true) {
+    scoped_refptr<RemoteTablet> tablet;
+    Synchronizer sync;
+    LookupTabletByKey(table,
+                      partition_key,
+                      deadline,
+                      LookupType::kLowerBound,
+                      &tablet,
+                      sync.AsStatusCallback());
+    const Status s = sync.Wait();
+    if (s.IsNotFound()) {
+      // The rest of the partition key space isn't covered by any tablet.
+      return Status::OK();
+    }
+    RETURN_NOT_OK(s);
+    if (tablet->partition().end().empty()) {
+      return Status::OK();
+    }
+    partition_key = tablet->partition().end();
+  }
+}
+
 void MetaCache::LookupTabletByKey(const KuduTable* table,
                                   PartitionKey partition_key,
                                   const MonoTime& deadline,
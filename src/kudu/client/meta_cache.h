@@ -147,6 +147,12 @@ struct RemoteReplica {
   RemoteTabletServer* ts;
   consensus::RaftPeerPB::Role role;
   bool failed;
+
+  // How far the safe time of the replica lagged behind the clock when it last
+  // served a bounded-staleness scan, and when that was. Uninitialized if it
+  // hasn't served any.
+  MonoDelta safe_time_lag;
+  MonoTime lag_observed;
 };
 
 typedef std::unordered_map<std::string, std::unique_ptr<RemoteTabletServer>>
@@ -272,6 +278,14 @@ class RemoteTablet : public RefCountedThreadSafe<RemoteTablet> {
   // Mark the specified tablet server as a follower in the cache.
   void MarkTServerAsFollower(const RemoteTabletServer* server);
 
+  // Records that the safe time of the replica hosted by 'server' lags 'lag'
+  // behind the clock.
+  void UpdateReplicaLag(const RemoteTabletServer* server, MonoDelta lag);
+
+  // Adds to 'uuids' the tablet servers hosting the replicas which were
+  // recently observed to lag more than 'max_lag' behind the clock.
+  void GetLaggingReplicas(MonoDelta max_lag, std::set<std::string>* uuids) const;
+
   // Return stringified representation of the list of replicas for this tablet.
   std::string ReplicasAsString() const;
 
@@ -459,6 +473,12 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
                            const MonoDelta& timeout,
                            std::vector<RangeWithRemoteTablet>* range_tablets);
 
+  // Populate the cache with the locations of all the tablets of a table,
+  // instead of looking them up one range at a time on first use. Tablets are
+  // fetched from the master in pages of kFetchTabletsPerRangeLookup tablets.
+  Status PrefetchTableLocations(const KuduTable* table,
+                                const MonoTime& deadline);
+
   // Look up the locations of the given tablet, storing the result in
   // 'remote_tablet' if not null, and calling 'lookup_complete_cb' once the
   // lookup is complete. Only tablets with non-failed LEADERs are considered.
@@ -561,6 +581,30 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
   // NOTE: Must be called with lock_ held.
   void UpdateTabletServerUnlocked(const master::TSInfoPB& pb);
 
+  // An immutable copy of the entries of a table in 'tablets_by_table_and_key_',
+  // sorted by their lower bound partition keys.
+  struct TableKeyIndex {
+    std::vector<PartitionKey> lower_bounds;
+    std::vector<MetaCacheEntry> entries;
+  };
+
+  // An immutable copy of 'tablets_by_table_and_key_', keyed by table ID. The
+  // indexes of the tables which didn't change are shared between copies.
+  typedef std::unordered_map<std::string, std::shared_ptr<const TableKeyIndex>> KeyIndex;
+
+  // Replaces the index of the table 'table_id' in 'key_index_' by a copy of
+  // its current entries, and publishes the new 'key_index_'.
+  //
+  // NOTE: Must be called with lock_ held for writing.
+  void PublishKeyIndexUnlocked(const std::string& table_id);
+
+  // Returns the last published 'key_index_'. The returned index remains valid
+  // until the next call to this method on the same thread.
+  //
+  // Each thread keeps a reference to the last index it saw, so this only
+  // takes 'lock_' when a new index was published since.
+  const KeyIndex* GetKeyIndex();
+
   KuduClient* client_;
 
   percpu_rwlock lock_;
@@ -590,6 +634,19 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
   // Protected by lock_.
   std::unordered_map<std::string, TabletMap> tablets_by_table_and_key_;
 
+  // The copy of 'tablets_by_table_and_key_' the key-based lookups use, so
+  // that they don't take 'lock_' or walk the maps, and aren't held up while
+  // the cache is updated.
+  //
+  // Protected by lock_. 'key_index_version_' is incremented, with lock_ held,
+  // every time 'key_index_' is replaced, and may be read without the lock.
+  std::shared_ptr<const KeyIndex> key_index_;
+  std::atomic<uint64_t> key_index_version_;
+
+  // Distinguishes this cache from the other ones the threads may look up
+  // keys in, for GetKeyIndex().
+  const uint64_t cache_id_;
+
   // Cache entries for tablets, keyed by tablet ID, used for ID-based lookups.
   // NOTE: existence in 'tablets_by_table_and_key' does not imply existence in
   // 'entry_by_tablet_id_', and vice versa.
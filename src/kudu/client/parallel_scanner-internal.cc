@@ -0,0 +1,272 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "kudu/client/parallel_scanner-internal.h"
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/client/scan_batch.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/util/threadpool.h"
+
+using std::deque;
+using std::lock_guard;
+using std::string;
+using std::unique_lock;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace kudu {
+namespace client {
+
+KuduParallelScanner::Data::Data(const vector<KuduScanToken*>& tokens)
+    : tokens_(tokens),
+      max_concurrency_(8),
+      max_concurrency_per_tserver_(2),
+      max_buffered_batches_(16),
+      cond_(&lock_),
+      opened_(false),
+      closing_(false),
+      num_running_(0),
+      status_reported_(false) {
+}
+
+KuduParallelScanner::Data::~Data() {
+  Close();
+}
+
+Status KuduParallelScanner::Data::SetMaxConcurrency(int max_concurrency) {
+  if (opened_) {
+    return Status::IllegalState("Maximum concurrency must be set before Open()");
+  }
+  if (max_concurrency <= 0) {
+    return Status::InvalidArgument("maximum concurrency must be positive");
+  }
+  max_concurrency_ = max_concurrency;
+  return Status::OK();
+}
+
+Status KuduParallelScanner::Data::SetMaxConcurrencyPerTabletServer(int max_concurrency) {
+  if (opened_) {
+    return Status::IllegalState("Maximum concurrency must be set before Open()");
+  }
+  if (max_concurrency <= 0) {
+    return Status::InvalidArgument("maximum concurrency must be positive");
+  }
+  max_concurrency_per_tserver_ = max_concurrency;
+  return Status::OK();
+}
+
+Status KuduParallelScanner::Data::SetMaxBufferedBatches(int max_batches) {
+  if (opened_) {
+    return Status::IllegalState("Maximum buffered batches must be set before Open()");
+  }
+  if (max_batches <= 0) {
+    return Status::InvalidArgument("maximum buffered batches must be positive");
+  }
+  max_buffered_batches_ = max_batches;
+  return Status::OK();
+}
+
+string KuduParallelScanner::Data::TabletServerOf(const KuduScanToken& token) {
+  const auto& replicas = token.tablet().replicas();
+  for (const auto* replica : replicas) {
+    if (replica->is_leader()) {
+      return replica->ts().uuid();
+    }
+  }
+  return replicas.empty() ? "" : replicas.front()->ts().uuid();
+}
+
+Status KuduParallelScanner::Data::Open() {
+  CHECK(!opened_) << "Parallel scanner already open";
+  opened_ = true;
+
+  // Interleave the tokens by tablet server, so that the scans started first
+  // are spread over as many servers as possible.
+  vector<string> tserver_uuids;
+  unordered_map<string, deque<Task>> tasks_by_tserver;
+  for (auto* token : tokens_) {
+    string uuid = TabletServerOf(*token);
+    auto& tasks = LookupOrInsert(&tasks_by_tserver, uuid, deque<Task>());
+    if (tasks.empty()) {
+      tserver_uuids.emplace_back(uuid);
+    }
+    tasks.push_back({ token, std::move(uuid) });
+  }
+  deque<Task> pending;
+  while (pending.size() < tokens_.size()) {
+    for (const auto& uuid : tserver_uuids) {
+      auto& tasks = FindOrDie(tasks_by_tserver, uuid);
+      if (!tasks.empty()) {
+        pending.emplace_back(std::move(tasks.front()));
+        tasks.pop_front();
+      }
+    }
+  }
+
+  RETURN_NOT_OK(ThreadPoolBuilder("parallel-scanner")
+                .set_max_threads(max_concurrency_)
+                .Build(&pool_));
+
+  lock_guard<Mutex> l(lock_);
+  pending_ = std::move(pending);
+  ScheduleScansUnlocked();
+  return status_;
+}
+
+bool KuduParallelScanner::Data::HasMoreRows() const {
+  lock_guard<Mutex> l(lock_);
+  if (!status_.ok()) {
+    return !status_reported_;
+  }
+  return !batches_.empty() || !pending_.empty() || num_running_ > 0;
+}
+
+Status KuduParallelScanner::Data::NextBatch(unique_ptr<KuduScanBatch>* batch) {
+  CHECK(opened_) << "Parallel scanner not open";
+  unique_lock<Mutex> l(lock_);
+  while (status_.ok() && batches_.empty() && (!pending_.empty() || num_running_ > 0)) {
+    cond_.Wait();
+  }
+  if (!status_.ok()) {
+    status_reported_ = true;
+    return status_;
+  }
+  if (batches_.empty()) {
+    batch->reset();
+    return Status::OK();
+  }
+  *batch = std::move(batches_.front());
+  batches_.pop_front();
+  // Wake up the scans waiting for room in the queue.
+  cond_.Broadcast();
+  return Status::OK();
+}
+
+void KuduParallelScanner::Data::Close() {
+  {
+    lock_guard<Mutex> l(lock_);
+    closing_ = true;
+    pending_.clear();
+    cond_.Broadcast();
+  }
+  if (pool_) {
+    pool_->Shutdown();
+  }
+  // The batches reference the projections of the scanners, so they must be
+  // destroyed first.
+  batches_.clear();
+  scanners_.clear();
+}
+
+void KuduParallelScanner::Data::ScheduleScansUnlocked() {
+  lock_.AssertAcquired();
+  for (auto it = pending_.begin();
+       it != pending_.end() && num_running_ < max_concurrency_;) {
+    // Tokens of tablets without known replicas aren't subject to the limit
+    // per tablet server.
+    int* num_running_on_tserver = it->tserver_uuid.empty() ?
+        nullptr : &LookupOrInsert(&num_running_per_tserver_, it->tserver_uuid, 0);
+    if (num_running_on_tserver && *num_running_on_tserver >= max_concurrency_per_tserver_) {
+      ++it;
+      continue;
+    }
+    Task task = std::move(*it);
+    Status s = pool_->Submit([this, task]() { this->RunScan(task); });
+    if (!s.ok()) {
+      RecordErrorUnlocked(s);
+      return;
+    }
+    it = pending_.erase(it);
+    ++num_running_;
+    if (num_running_on_tserver) {
+      ++*num_running_on_tserver;
+    }
+  }
+}
+
+void KuduParallelScanner::Data::RunScan(const Task& task) {
+  Status s = ScanToken(task.token);
+
+  lock_guard<Mutex> l(lock_);
+  --num_running_;
+  if (!task.tserver_uuid.empty()) {
+    --FindOrDie(num_running_per_tserver_, task.tserver_uuid);
+  }
+  if (!s.ok()) {
+    RecordErrorUnlocked(s);
+  } else if (!closing_) {
+    ScheduleScansUnlocked();
+  }
+  cond_.Broadcast();
+}
+
+Status KuduParallelScanner::Data::ScanToken(KuduScanToken* token) {
+  KuduScanner* scanner;
+  RETURN_NOT_OK(token->IntoKuduScanner(&scanner));
+  {
+    lock_guard<Mutex> l(lock_);
+    scanners_.emplace_back(scanner);
+    if (closing_ || !status_.ok()) {
+      return Status::OK();
+    }
+  }
+  RETURN_NOT_OK(scanner->Open());
+  while (scanner->HasMoreRows()) {
+    unique_ptr<KuduScanBatch> batch(new KuduScanBatch());
+    Status s = scanner->NextBatch(batch.get());
+    if (!s.ok()) {
+      scanner->Close();
+      return s;
+    }
+    unique_lock<Mutex> l(lock_);
+    while (!closing_ && status_.ok() && batches_.size() >= static_cast<size_t>(max_buffered_batches_)) {
+      cond_.Wait();
+    }
+    if (closing_ || !status_.ok()) {
+      l.unlock();
+      scanner->Close();
+      return Status::OK();
+    }
+    if (batch->NumRows() > 0) {
+      batches_.emplace_back(std::move(batch));
+      cond_.Broadcast();
+    }
+  }
+  scanner->Close();
+  return Status::OK();
+}
+
+void KuduParallelScanner::Data::RecordErrorUnlocked(const Status& s) {
+  lock_.AssertAcquired();
+  if (status_.ok()) {
+    status_ = s;
+  }
+  // Stop starting new scans: the running ones give up once they see the error.
+  pending_.clear();
+}
+
+} // namespace client
+} // namespace kudu
@@ -0,0 +1,122 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kudu/client/client.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ThreadPool;
+
+namespace client {
+
+class KuduScanBatch;
+
+class KuduParallelScanner::Data {
+ public:
+  explicit Data(const std::vector<KuduScanToken*>& tokens);
+  ~Data();
+
+  Status SetMaxConcurrency(int max_concurrency);
+  Status SetMaxConcurrencyPerTabletServer(int max_concurrency);
+  Status SetMaxBufferedBatches(int max_batches);
+
+  Status Open();
+
+  bool HasMoreRows() const;
+
+  // Waits for the next batch scanned by any of the scans and sets 'batch' to
+  // it, or to null if all the tokens have been scanned.
+  Status NextBatch(std::unique_ptr<KuduScanBatch>* batch);
+
+  void Close();
+
+ private:
+  struct Task {
+    KuduScanToken* token;
+    // The UUID of the tablet server the token is expected to be scanned from,
+    // or empty if its tablet has no known replica.
+    std::string tserver_uuid;
+  };
+
+  // Returns the UUID of the tablet server hosting the leader replica of the
+  // tablet of 'token', or of its first replica if its leader is not known.
+  static std::string TabletServerOf(const KuduScanToken& token);
+
+  // Submits scans of pending tokens to the thread pool, as long as neither
+  // the global nor the per-tablet server concurrency limits are reached.
+  void ScheduleScansUnlocked();
+
+  // Scans 'task.token', queuing its batches. Runs on the thread pool.
+  void RunScan(const Task& task);
+
+  // Scans 'token' until it is exhausted, or until the parallel scanner is
+  // closed or another scan fails.
+  Status ScanToken(KuduScanToken* token);
+
+  // Records the first error of the scans. Requires 'lock_' to be held.
+  void RecordErrorUnlocked(const Status& s);
+
+  const std::vector<KuduScanToken*> tokens_;
+
+  int max_concurrency_;
+  int max_concurrency_per_tserver_;
+  int max_buffered_batches_;
+
+  std::unique_ptr<ThreadPool> pool_;
+
+  mutable Mutex lock_;
+
+  // Signaled whenever a batch is queued or consumed, a scan completes, or the
+  // parallel scanner is closed.
+  ConditionVariable cond_;
+
+  bool opened_;
+  bool closing_;
+
+  // The tokens left to scan, interleaved by tablet server.
+  std::deque<Task> pending_;
+
+  // The number of scans running, in total and per tablet server.
+  int num_running_;
+  std::unordered_map<std::string, int> num_running_per_tserver_;
+
+  // The batches scanned but not returned by NextBatch() yet.
+  std::deque<std::unique_ptr<KuduScanBatch>> batches_;
+
+  // The first error of the scans, and whether it was returned by NextBatch().
+  Status status_;
+  bool status_reported_;
+
+  // The scanners of the tokens. They're kept until the parallel scanner is
+  // closed since the batches reference their projections.
+  std::vector<std::unique_ptr<KuduScanner>> scanners_;
+};
+
+} // namespace client
+} // namespace kudu
@@ -19,6 +19,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "kudu/client/client-internal.h"
 #include "kudu/client/client.h"
@@ -32,6 +33,7 @@
 
 using std::string;
 using std::unique_ptr;
+using std::vector;
 
 namespace kudu {
 namespace client {
@@ -83,5 +85,16 @@ Status KuduPartitioner::Data::PartitionRow(
   return Status::OK();
 }
 
+Status KuduPartitioner::Data::PartitionRows(
+    const vector<const KuduPartialRow*>& rows, vector<int>* partitions) {
+  table_->data_->partition_schema_.EncodeKeys(rows, &partition_keys_);
+  partitions->clear();
+  partitions->reserve(rows.size());
+  for (const auto& partition_key : partition_keys_) {
+    partitions->push_back(FindFloorOrDie(partitions_by_start_key_, partition_key));
+  }
+  return Status::OK();
+}
+
 } // namespace client
 } // namespace kudu
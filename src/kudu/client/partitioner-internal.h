@@ -19,6 +19,7 @@
 #include <map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "kudu/client/client.h"
 #include "kudu/client/shared_ptr.h" // IWYU pragma: keep
@@ -67,9 +68,14 @@ class KuduPartitionerBuilder::Data {
 class KuduPartitioner::Data {
  public:
   Status PartitionRow(const KuduPartialRow& row, int* partition);
+  Status PartitionRows(const std::vector<const KuduPartialRow*>& rows,
+                       std::vector<int>* partitions);
 
   sp::shared_ptr<KuduTable> table_;
   std::map<PartitionKey, int> partitions_by_start_key_;
+
+  // Scratch space for PartitionRows(), reused across calls.
+  std::vector<PartitionKey> partition_keys_;
   int num_partitions_ = 0;
 };
 
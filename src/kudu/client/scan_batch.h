@@ -153,7 +153,9 @@ class KUDU_EXPORT KuduScanBatch {
 
  private:
   class KUDU_NO_EXPORT Data;
+  friend class KuduParallelScanner;
   friend class KuduScanner;
+  friend class KuduTable;
   friend class tools::ReplicaDumper;
 
   Data* data_;
@@ -17,6 +17,7 @@
 
 #include "kudu/client/scan_configuration.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -62,7 +63,8 @@ ScanConfiguration::ScanConfiguration(KuduTable* table)
       lower_bound_propagation_timestamp_(kNoTimestamp),
       timeout_(MonoDelta::FromMilliseconds(KuduScanner::kScanTimeoutMillis)),
       arena_(256),
-      row_format_flags_(KuduScanner::NO_FLAGS) {
+      row_format_flags_(KuduScanner::NO_FLAGS),
+      prefetch_depth_(0) {
 }
 
 Status ScanConfiguration::SetProjectedColumnNames(const vector<string>& col_names) {
@@ -186,6 +188,14 @@ void ScanConfiguration::SetSnapshotRaw(uint64_t snapshot_timestamp) {
   snapshot_timestamp_ = snapshot_timestamp;
 }
 
+Status ScanConfiguration::SetMaxStalenessMillis(int max_staleness_ms) {
+  if (max_staleness_ms < 0) {
+    return Status::InvalidArgument("Maximum staleness must be non-negative");
+  }
+  max_staleness_ = MonoDelta::FromMilliseconds(max_staleness_ms);
+  return Status::OK();
+}
+
 Status ScanConfiguration::SetDiffScan(uint64_t start_timestamp, uint64_t end_timestamp) {
   if (start_timestamp == kNoTimestamp) {
     return Status::IllegalState("Start timestamp must be set bigger than 0");
@@ -209,6 +219,18 @@ void ScanConfiguration::SetTimeoutMillis(int millis) {
   timeout_ = MonoDelta::FromMilliseconds(millis);
 }
 
+void ScanConfiguration::SetPrefetching(bool prefetching) {
+  prefetch_depth_ = prefetching ? std::max(prefetch_depth_, 1) : 0;
+}
+
+Status ScanConfiguration::SetPrefetchDepth(int depth) {
+  if (depth < 0) {
+    return Status::InvalidArgument("Prefetch depth must be non-negative");
+  }
+  prefetch_depth_ = depth;
+  return Status::OK();
+}
+
 Status ScanConfiguration::SetRowFormatFlags(uint64_t flags) {
   row_format_flags_ = flags;
   return Status::OK();
@@ -87,6 +87,8 @@ class ScanConfiguration {
 
   void SetSnapshotRaw(uint64_t snapshot_timestamp);
 
+  Status SetMaxStalenessMillis(int max_staleness_ms) WARN_UNUSED_RESULT;
+
   // Set the lower bound of scan's propagation timestamp.
   // It is only used in READ_YOUR_WRITES scan mode.
   void SetScanLowerBoundTimestampRaw(uint64_t propagation_timestamp);
@@ -95,6 +97,10 @@ class ScanConfiguration {
 
   void SetTimeoutMillis(int millis);
 
+  void SetPrefetching(bool prefetching);
+
+  Status SetPrefetchDepth(int depth) WARN_UNUSED_RESULT;
+
   Status SetRowFormatFlags(uint64_t flags);
 
   Status SetLimit(int64_t limit);
@@ -176,6 +182,21 @@ class ScanConfiguration {
     return lower_bound_propagation_timestamp_;
   }
 
+  bool has_max_staleness() const {
+    return max_staleness_.Initialized();
+  }
+
+  const MonoDelta& max_staleness() const {
+    CHECK(has_max_staleness());
+    return max_staleness_;
+  }
+
+  // Returns the physical component, in microseconds since the Epoch, of the
+  // raw encoded timestamp 'timestamp'.
+  static uint64_t PhysicalMicros(uint64_t timestamp) {
+    return timestamp >> kHtTimestampBitsToShift;
+  }
+
   const MonoDelta& timeout() const {
     return timeout_;
   }
@@ -184,6 +205,14 @@ class ScanConfiguration {
     return row_format_flags_;
   }
 
+  bool prefetching() const {
+    return prefetch_depth_ > 0;
+  }
+
+  int prefetch_depth() const {
+    return prefetch_depth_;
+  }
+
   Arena* arena() {
     return &arena_;
   }
@@ -226,6 +255,10 @@ class ScanConfiguration {
 
   uint64_t lower_bound_propagation_timestamp_;
 
+  // The maximum staleness of a bounded-staleness scan. Uninitialized if the
+  // scan isn't one.
+  MonoDelta max_staleness_;
+
   MonoDelta timeout_;
 
   // Manages interior allocations for the scan spec and copied bounds.
@@ -237,6 +270,10 @@ class ScanConfiguration {
   std::deque<std::unique_ptr<KuduPredicate>> predicates_pool_;
 
   uint64_t row_format_flags_;
+
+  // The number of batches fetched ahead of the calls for them, or 0 if the
+  // batches aren't prefetched.
+  int prefetch_depth_;
 };
 
 } // namespace client
@@ -253,6 +253,11 @@ Status KuduScanToken::Data::PBIntoScanner(KuduClient* client,
       RETURN_NOT_OK_LOG(configuration->SetSelection(KuduClient::ReplicaSelection::FIRST_REPLICA),
                         ERROR, "set replica selection FIRST_REPLICA failed");
       break;
+    case kudu::ReplicaSelection::CLOSEST_NON_VOTER:
+      RETURN_NOT_OK_LOG(
+          configuration->SetSelection(KuduClient::ReplicaSelection::CLOSEST_NON_VOTER),
+          ERROR, "set replica selection CLOSEST_NON_VOTER failed");
+      break;
     default:
       return Status::NotSupported("unsupported ReplicaSelection policy");
   }
@@ -428,6 +433,9 @@ Status KuduScanTokenBuilder::Data::Build(vector<KuduScanToken*>* tokens) {
     case KuduClient::ReplicaSelection::FIRST_REPLICA:
       pb.set_replica_selection(kudu::ReplicaSelection::FIRST_REPLICA);
       break;
+    case KuduClient::ReplicaSelection::CLOSEST_NON_VOTER:
+      pb.set_replica_selection(kudu::ReplicaSelection::CLOSEST_NON_VOTER);
+      break;
     default:
       return Status::InvalidArgument("replica_selection is invalid.");
   }
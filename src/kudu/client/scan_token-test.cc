@@ -636,6 +636,67 @@ TEST_F(ScanTokenTest, TestScanTokens) {
   }
 }
 
+// Scan the tokens of a table with a parallel scanner, with small batches so
+// that the scans fill up the queue of batches.
+TEST_F(ScanTokenTest, TestParallelScanner) {
+  KuduSchema schema;
+  {
+    KuduSchemaBuilder builder;
+    builder.AddColumn("col")->NotNull()->Type(KuduColumnSchema::INT64)->PrimaryKey();
+    ASSERT_OK(builder.Build(&schema));
+  }
+
+  shared_ptr<KuduTable> table;
+  {
+    unique_ptr<KuduTableCreator> table_creator(client_->NewTableCreator());
+    ASSERT_OK(table_creator->table_name("table")
+              .schema(&schema)
+              .add_hash_partitions({ "col" }, 8)
+              .num_replicas(1)
+              .Create());
+    ASSERT_OK(client_->OpenTable("table", &table));
+  }
+
+  constexpr int kNumRows = 1000;
+  shared_ptr<KuduSession> session = client_->NewSession();
+  session->SetTimeoutMillis(10000);
+  ASSERT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+  for (int i = 0; i < kNumRows; i++) {
+    unique_ptr<KuduInsert> insert(table->NewInsert());
+    ASSERT_OK(insert->mutable_row()->SetInt64("col", i));
+    ASSERT_OK(session->Apply(insert.release()));
+  }
+  ASSERT_OK(session->Flush());
+
+  vector<KuduScanToken*> tokens;
+  ElementDeleter deleter(&tokens);
+  KuduScanTokenBuilder builder(table.get());
+  ASSERT_OK(builder.SetBatchSizeBytes(64));
+  ASSERT_OK(builder.Build(&tokens));
+  ASSERT_EQ(8, tokens.size());
+
+  KuduParallelScanner scanner(tokens);
+  ASSERT_OK(scanner.SetMaxConcurrency(4));
+  ASSERT_OK(scanner.SetMaxConcurrencyPerTabletServer(1));
+  ASSERT_OK(scanner.SetMaxBufferedBatches(2));
+  ASSERT_OK(scanner.Open());
+  ASSERT_TRUE(scanner.SetMaxConcurrency(1).IsIllegalState());
+
+  // Every row is returned exactly once, whatever the order of the batches.
+  unordered_set<int64_t> keys;
+  KuduScanBatch batch;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    for (const auto& row : batch) {
+      int64_t key;
+      ASSERT_OK(row.GetInt64(0, &key));
+      ASSERT_TRUE(keys.insert(key).second) << key;
+    }
+  }
+  ASSERT_EQ(kNumRows, keys.size());
+  scanner.Close();
+}
+
 TEST_F(ScanTokenTest, TestScanTokens_NonUniquePrimaryKey) {
   // Create schema
   KuduSchema schema;
@@ -27,6 +27,7 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/message.h>
 
@@ -45,6 +46,7 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/stringpiece.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/walltime.h"
 #include "kudu/rpc/connection.h"
 #include "kudu/rpc/messenger.h" // IWYU pragma: keep
 #include "kudu/rpc/periodic.h"
@@ -53,13 +55,26 @@
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/security/token.pb.h"
 #include "kudu/tserver/tserver_service.proxy.h" // IWYU pragma: keep
+#include "kudu/util/alignment.h"
 #include "kudu/util/async_util.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/hexdump.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/stopwatch.h"
 
+DEFINE_int64(scanner_prefetch_max_bytes, 64 * 1024 * 1024,
+             "Maximum number of bytes of the batches a scanner may fetch ahead "
+             "of the calls for them when prefetching. Once the memory of the "
+             "batches prefetched reaches this limit, the scanner waits for "
+             "batches to be consumed before fetching more.");
+TAG_FLAG(scanner_prefetch_max_bytes, advanced);
+TAG_FLAG(scanner_prefetch_max_bytes, runtime);
+
 using google::protobuf::FieldDescriptor;
 using google::protobuf::Reflection;
 using kudu::rpc::ComputeExponentialBackoff;
@@ -89,6 +104,11 @@ KuduScanner::Data::Data(KuduTable* table)
     open_(false),
     data_in_open_(false),
     short_circuit_(false),
+    async_rpc_pending_(false),
+    bloom_filter_feature_required_(false),
+    prefetch_cond_(&prefetch_lock_),
+    prefetched_bytes_(0),
+    prefetching_stopped_(false),
     table_(DCHECK_NOTNULL(table)->shared_from_this()),
     scan_attempts_(0),
     num_rows_returned_(0) {
@@ -220,6 +240,13 @@ Status KuduScanner::Data::HandleError(const ScanRpcStatus& err,
       mark_locations_stale = true;
       blacklist_location = true;
       break;
+    case ScanRpcStatus::REPLICA_TOO_STALE:
+      // Another replica may be fresh enough. The replica only reports that it
+      // lags more than the maximum staleness; keep it off the next scans too.
+      remote_->UpdateReplicaLag(ts_, configuration_.max_staleness() +
+                                     MonoDelta::FromMicroseconds(1));
+      blacklist_location = true;
+      break;
     default:
       can_retry = false;
       break;
@@ -370,6 +397,8 @@ ScanRpcStatus KuduScanner::Data::AnalyzeResponse(const Status& rpc_status,
     case tserver::TabletServerErrorPB::TABLET_FAILED: // fall-through
     case tserver::TabletServerErrorPB::TABLET_NOT_FOUND:
       return ScanRpcStatus{ScanRpcStatus::TABLET_NOT_FOUND, server_status};
+    case tserver::TabletServerErrorPB::REPLICA_TOO_STALE:
+      return ScanRpcStatus{ScanRpcStatus::REPLICA_TOO_STALE, server_status};
     default:
       return ScanRpcStatus{ScanRpcStatus::OTHER_TS_ERROR, server_status};
   }
@@ -389,8 +418,9 @@ Status KuduScanner::Data::ReopenCurrentTablet(const MonoTime& deadline,
                     blacklist);
 }
 
-ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
-                                             bool allow_time_for_failover) {
+MonoTime KuduScanner::Data::PrepareScanRpc(RpcController* controller,
+                                           const MonoTime& overall_deadline,
+                                           bool allow_time_for_failover) {
   // The user has specified a timeout which should apply to the total time for each call
   // to NextBatch(). However, for fault-tolerant scans, or for when we are first opening
   // a scanner, it's preferable to set a shorter timeout (the "default RPC timeout") for
@@ -404,26 +434,36 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
     rpc_deadline = overall_deadline;
   }
 
-  // Capture previously sent Bloom filter predicate feature flag so that we don't have to make
-  // expensive call to determine the flag on scan continuations.
-  bool prev_bloom_filter_feature = ContainsKey(controller_.required_server_features(),
-                                               TabletServerFeatures::BLOOM_FILTER_PREDICATE_V2);
-
-  controller_.Reset();
-  controller_.set_deadline(rpc_deadline);
+  controller->Reset();
+  controller->set_deadline(rpc_deadline);
   if (!configuration_.spec().predicates().empty()) {
-    controller_.RequireServerFeature(TabletServerFeatures::COLUMN_PREDICATES);
-    if (prev_bloom_filter_feature ||
-        (next_req_.has_new_scan_request() &&
-         configuration().spec().ContainsBloomFilterPredicate())) {
-      controller_.RequireServerFeature(TabletServerFeatures::BLOOM_FILTER_PREDICATE_V2);
+    controller->RequireServerFeature(TabletServerFeatures::COLUMN_PREDICATES);
+    // Remember that the Bloom filter predicate feature was required so that we
+    // don't have to make expensive call to determine the flag on scan
+    // continuations.
+    if (!bloom_filter_feature_required_ &&
+        next_req_.has_new_scan_request() &&
+        configuration().spec().ContainsBloomFilterPredicate()) {
+      bloom_filter_feature_required_ = true;
+    }
+    if (bloom_filter_feature_required_) {
+      controller->RequireServerFeature(TabletServerFeatures::BLOOM_FILTER_PREDICATE_V2);
     }
   }
   if (configuration().row_format_flags() & KuduScanner::PAD_UNIXTIME_MICROS_TO_16_BYTES) {
-    controller_.RequireServerFeature(TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES);
+    controller->RequireServerFeature(TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES);
   }
   if (configuration().row_format_flags() & KuduScanner::COLUMNAR_LAYOUT) {
-    controller_.RequireServerFeature(TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE);
+    controller->RequireServerFeature(TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE);
+  }
+  if (configuration().row_format_flags() & KuduScanner::ARROW_LAYOUT) {
+    controller->RequireServerFeature(TabletServerFeatures::ARROW_LAYOUT_FEATURE);
+  }
+  if (configuration().row_format_flags() & KuduScanner::UNDEFINED_NULL_VALUES) {
+    controller->RequireServerFeature(TabletServerFeatures::UNDEFINED_NULL_VALUES_FEATURE);
+  }
+  if (configuration().row_format_flags() & KuduScanner::COMPRESSED_COLUMNS) {
+    controller->RequireServerFeature(TabletServerFeatures::COMPRESSED_COLUMNS_FEATURE);
   }
 
   if (next_req_.has_new_scan_request()) {
@@ -438,11 +478,13 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
       VLOG(1) << "no authz token for table " << table_->id();
     }
   }
-  ScanRpcStatus scan_status = AnalyzeResponse(
-      proxy_->Scan(next_req_,
-                   &last_response_,
-                   &controller_),
-      rpc_deadline, overall_deadline);
+  return rpc_deadline;
+}
+
+ScanRpcStatus KuduScanner::Data::FinishScanRpc(const Status& rpc_status,
+                                               const MonoTime& overall_deadline,
+                                               const MonoTime& rpc_deadline) {
+  ScanRpcStatus scan_status = AnalyzeResponse(rpc_status, rpc_deadline, overall_deadline);
   if (scan_status.result == ScanRpcStatus::OK) {
     UpdateResourceMetrics();
     num_rows_returned_ += last_response_.has_data() ? last_response_.data().num_rows() : 0;
@@ -452,6 +494,209 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
   return scan_status;
 }
 
+ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
+                                             bool allow_time_for_failover) {
+  const MonoTime rpc_deadline =
+      PrepareScanRpc(&controller_, overall_deadline, allow_time_for_failover);
+  return FinishScanRpc(proxy_->Scan(next_req_, &last_response_, &controller_),
+                       overall_deadline, rpc_deadline);
+}
+
+KuduScanner::Data::PrefetchedBatch* KuduScanner::Data::PrepareContinueRpcAsyncUnlocked() {
+  prefetch_lock_.AssertAcquired();
+  PrefetchedBatch* batch = new PrefetchedBatch;
+  prefetched_.emplace_back(batch);
+  PrepareRequest(KuduScanner::Data::CONTINUE);
+  batch->batch_deadline = MonoTime::Now() + configuration_.timeout();
+  batch->rpc_deadline = PrepareScanRpc(&batch->controller, batch->batch_deadline,
+                                       configuration_.is_fault_tolerant());
+  return batch;
+}
+
+void KuduScanner::Data::SendContinueRpcAsync(PrefetchedBatch* batch) {
+  proxy_->ScanAsync(next_req_, &batch->response, &batch->controller, [this, batch]() {
+    OnContinueRpcAsyncDone(batch);
+  });
+}
+
+void KuduScanner::Data::SendContinueRpcAsync() {
+  CHECK(proxy_);
+  PrefetchedBatch* batch;
+  {
+    MutexLock l(prefetch_lock_);
+    DCHECK(prefetched_.empty());
+    batch = PrepareContinueRpcAsyncUnlocked();
+  }
+  async_rpc_pending_ = true;
+  SendContinueRpcAsync(batch);
+}
+
+KuduScanner::Data::PrefetchedBatch* KuduScanner::Data::MaybePrefetchUnlocked() {
+  prefetch_lock_.AssertAcquired();
+  if (prefetching_stopped_ ||
+      static_cast<int>(prefetched_.size()) >= configuration_.prefetch_depth() ||
+      prefetched_bytes_ >= FLAGS_scanner_prefetch_max_bytes) {
+    return nullptr;
+  }
+  // The next batch is fetched once the scanner has no RPC in flight, and the
+  // latest batch fetched succeeded and isn't the last one of the tablet.
+  if (prefetched_.empty()) {
+    if (!last_response_.has_more_results()) {
+      return nullptr;
+    }
+  } else {
+    const PrefetchedBatch& latest = *prefetched_.back();
+    if (!latest.done || !latest.controller.status().ok() ||
+        latest.response.has_error() || !latest.response.has_more_results()) {
+      return nullptr;
+    }
+  }
+  VLOG(2) << "Prefetching the next batch of " << DebugString();
+  return PrepareContinueRpcAsyncUnlocked();
+}
+
+void KuduScanner::Data::OnContinueRpcAsyncDone(PrefetchedBatch* batch) {
+  // Account for the memory of the rows received, most of which the sidecars
+  // hold.
+  size_t bytes = batch->response.SpaceUsedLong();
+  Slice sidecar;
+  for (int i = 0; batch->controller.GetInboundSidecar(i, &sidecar).ok(); i++) {
+    bytes += sidecar.size();
+  }
+
+  std::function<void()> waiter;
+  PrefetchedBatch* next = nullptr;
+  {
+    MutexLock l(prefetch_lock_);
+    batch->done = true;
+    batch->bytes = bytes;
+    prefetched_bytes_ += bytes;
+    waiter.swap(prefetch_waiter_);
+    next = MaybePrefetchUnlocked();
+    prefetch_cond_.Broadcast();
+  }
+  // Unless a batch was just prefetched, whose completion the scanner waits
+  // for before it's destroyed, the scanner may be destroyed at this point
+  // by the thread taking 'batch'.
+  if (next) {
+    SendContinueRpcAsync(next);
+  }
+  if (waiter) {
+    waiter();
+  }
+}
+
+void KuduScanner::Data::WhenAsyncRpcDone(std::function<void()> f) {
+  DCHECK(async_rpc_pending_);
+  {
+    MutexLock l(prefetch_lock_);
+    DCHECK(!prefetched_.empty());
+    if (!prefetched_.front()->done) {
+      prefetch_waiter_ = std::move(f);
+      return;
+    }
+  }
+  f();
+}
+
+ScanRpcStatus KuduScanner::Data::TakeAsyncRpcResult() {
+  DCHECK(async_rpc_pending_);
+  unique_ptr<PrefetchedBatch> batch;
+  {
+    MutexLock l(prefetch_lock_);
+    DCHECK(!prefetched_.empty());
+    // Don't wait if the batch was fetched: this may run on the reactor thread
+    // which fetched it.
+    while (!prefetched_.front()->done) {
+      prefetch_cond_.Wait();
+    }
+    batch = std::move(prefetched_.front());
+    prefetched_.pop_front();
+    prefetched_bytes_ -= batch->bytes;
+    async_rpc_pending_ = !prefetched_.empty();
+  }
+  controller_.Swap(&batch->controller);
+  last_response_.Swap(&batch->response);
+  return FinishScanRpc(controller_.status(), batch->batch_deadline, batch->rpc_deadline);
+}
+
+void KuduScanner::Data::DiscardPrefetchedBatches() {
+  if (!async_rpc_pending_) {
+    return;
+  }
+  MutexLock l(prefetch_lock_);
+  prefetching_stopped_ = true;
+  while (!prefetched_.back()->done) {
+    prefetch_cond_.Wait();
+  }
+  prefetched_.clear();
+  prefetched_bytes_ = 0;
+  prefetching_stopped_ = false;
+  async_rpc_pending_ = false;
+}
+
+Status KuduScanner::Data::ResetBatch(internal::ScanBatchDataInterface* batch_data) {
+  RETURN_NOT_OK(batch_data->Reset(&controller_,
+                                  configuration_.projection(),
+                                  configuration_.client_projection(),
+                                  configuration_.row_format_flags(),
+                                  &last_response_));
+  // The controller and the response were handed over to 'batch_data', so
+  // the batches up to the prefetch depth may be fetched right away.
+  if (configuration_.prefetching()) {
+    PrefetchedBatch* next;
+    {
+      MutexLock l(prefetch_lock_);
+      next = MaybePrefetchUnlocked();
+    }
+    if (next) {
+      async_rpc_pending_ = true;
+      SendContinueRpcAsync(next);
+    }
+  }
+  return Status::OK();
+}
+
+Status KuduScanner::Data::HandleContinueResult(ScanRpcStatus result,
+                                               const MonoTime& batch_deadline,
+                                               internal::ScanBatchDataInterface* batch_data) {
+  while (true) {
+    // Success case.
+    if (result.result == ScanRpcStatus::OK) {
+      if (last_response_.has_last_primary_key()) {
+        last_primary_key_ = last_response_.last_primary_key();
+      }
+      scan_attempts_ = 0;
+      return ResetBatch(batch_data);
+    }
+
+    scan_attempts_++;
+
+    // Error handling.
+    set<string> blacklist;
+    bool needs_reopen = false;
+    Status s = HandleError(result, batch_deadline, &blacklist, &needs_reopen);
+    if (!s.ok()) {
+      LOG(WARNING) << "Scan on tablet server " << ts_->ToString() << " with "
+                   << DebugString() << " failed: " << result.status.ToString();
+      return s;
+    }
+
+    if (configuration_.is_fault_tolerant()) {
+      LOG(WARNING) << "Attempting to retry " << DebugString() << " elsewhere.";
+      return ReopenCurrentTablet(batch_deadline, &blacklist);
+    }
+
+    if (!blacklist.empty() || needs_reopen) {
+      // If we blacklisted the current server, and it's not fault-tolerant, we can't
+      // retry anywhere, so just propagate the error.
+      return result.status;
+    }
+    // If we didn't blacklist the current server, we can just retry again.
+    result = SendScanRpc(batch_deadline, configuration_.is_fault_tolerant());
+  }
+}
+
 Status KuduScanner::Data::OpenTablet(const PartitionKey& partition_key,
                                      const MonoTime& deadline,
                                      set<string>* blacklist) {
@@ -477,6 +722,8 @@ Status KuduScanner::Data::OpenTablet(const PartitionKey& partition_key,
       }
       if (configuration_.has_snapshot_timestamp()) {
         scan->set_snap_timestamp(configuration_.snapshot_timestamp());
+      } else if (configuration_.has_max_staleness()) {
+        scan->set_max_staleness_usec(configuration_.max_staleness().ToMicroseconds());
       }
       break;
     case KuduScanner::READ_YOUR_WRITES:
@@ -574,18 +821,36 @@ Status KuduScanner::Data::OpenTablet(const PartitionKey& partition_key,
     if (partition_key < remote_->partition().begin() &&
         partition_pruner_.ShouldPrune(remote_->partition())) {
       partition_pruner_.RemovePartitionKeyRange(remote_->partition().end());
+      resource_metrics_.data_->Increment(StringPiece("tablets_pruned"), 1);
       return Status::OK();
     }
 
     scan->set_tablet_id(remote_->tablet_id());
 
+    // Steer bounded-staleness scans away from the replicas known to lag too
+    // far behind, unless there is no other replica left.
+    set<string> lagging_blacklist;
+    const set<string>* selection_blacklist = blacklist;
+    if (scan->has_max_staleness_usec()) {
+      lagging_blacklist = *blacklist;
+      remote_->GetLaggingReplicas(configuration_.max_staleness(), &lagging_blacklist);
+      vector<RemoteTabletServer*> servers;
+      remote_->GetRemoteTabletServers(&servers);
+      if (std::any_of(servers.begin(), servers.end(),
+                      [&](const RemoteTabletServer* s) {
+                        return !ContainsKey(lagging_blacklist, s->permanent_uuid());
+                      })) {
+        selection_blacklist = &lagging_blacklist;
+      }
+    }
+
     RemoteTabletServer *ts;
     vector<RemoteTabletServer*> candidates;
     Status lookup_status = table_->client()->data_->GetTabletServer(
         table_->client(),
         remote_,
         configuration_.selection(),
-        *blacklist,
+        *selection_blacklist,
         &candidates,
         &ts);
     // If we get ServiceUnavailable, this indicates that the tablet doesn't
@@ -622,6 +887,7 @@ Status KuduScanner::Data::OpenTablet(const PartitionKey& partition_key,
   }
 
   partition_pruner_.RemovePartitionKeyRange(remote_->partition().end());
+  resource_metrics_.data_->Increment(StringPiece("tablets_scanned"), 1);
 
   next_req_.clear_new_scan_request();
   data_in_open_ = (last_response_.has_data() && last_response_.data().num_rows() > 0) ||
@@ -652,7 +918,20 @@ Status KuduScanner::Data::OpenTablet(const PartitionKey& partition_key,
     // it's the first response from the tablet server when scanning in the
     // READ_AT_SNAPSHOT mode with unspecified snapshot timestamp.
     CHECK(last_response_.has_snap_timestamp());
-    configuration_.SetSnapshotRaw(last_response_.snap_timestamp());
+    if (configuration_.has_max_staleness()) {
+      // The scan ran at the replica's safe time: remember how far it lags.
+      // The lag is measured against the local clock, which is good enough
+      // to pick among the replicas.
+      const int64_t snap_micros = static_cast<int64_t>(
+          ScanConfiguration::PhysicalMicros(last_response_.snap_timestamp()));
+      const int64_t lag_usec = std::max<int64_t>(GetCurrentTimeMicros() - snap_micros, 0);
+      remote_->UpdateReplicaLag(ts_, MonoDelta::FromMicroseconds(lag_usec));
+    }
+    // Unless the scan must be resumable elsewhere at the same snapshot, let
+    // each tablet of a bounded-staleness scan pick its own timestamp.
+    if (!configuration_.has_max_staleness() || configuration_.is_fault_tolerant()) {
+      configuration_.SetSnapshotRaw(last_response_.snap_timestamp());
+    }
   }
 
   // For READ_YOUR_WRITES mode, updates the latest observed timestamp with
@@ -672,6 +951,10 @@ Status KuduScanner::Data::OpenTablet(const PartitionKey& partition_key,
 
 Status KuduScanner::Data::KeepAlive() {
   if (!open_) return Status::IllegalState("Scanner was not open.");
+  // The scanner is kept alive by the batch being prefetched.
+  if (async_rpc_pending_) {
+    return Status::OK();
+  }
   // If there is no scanner to keep alive, we still return Status::OK().
   if (!last_response_.IsInitialized() || !last_response_.has_more_results() ||
       !next_req_.has_scanner_id()) {
@@ -838,6 +1121,7 @@ Status KuduColumnarScanBatch::Data::Reset(
   controller_.Swap(controller);
   projection_ = projection;
   client_projection_ = client_projection;
+  arrow_layout_ = row_format_flags & RowFormatFlags::ARROW_LAYOUT;
 
   unique_ptr<ColumnarRowBlockPB> resp_data(response->release_columnar_data());
   if (!resp_data) {
@@ -846,11 +1130,53 @@ Status KuduColumnarScanBatch::Data::Reset(
     return Status::OK();
   }
   resp_data_ = std::move(*resp_data);
+  uncompressed_sidecars_.clear();
+  if (row_format_flags & RowFormatFlags::COMPRESSED_COLUMNS) {
+    for (const auto& col : resp_data_.columns()) {
+      if (col.has_data_uncompressed_size()) {
+        RETURN_NOT_OK(UncompressSidecar(col.data_sidecar(), col.data_uncompressed_size()));
+      }
+      if (col.has_varlen_data_uncompressed_size()) {
+        RETURN_NOT_OK(UncompressSidecar(col.varlen_data_sidecar(),
+                                        col.varlen_data_uncompressed_size()));
+      }
+      if (col.has_non_null_bitmap_uncompressed_size()) {
+        RETURN_NOT_OK(UncompressSidecar(col.non_null_bitmap_sidecar(),
+                                        col.non_null_bitmap_uncompressed_size()));
+      }
+    }
+  }
   return Status::OK();
 }
 
+Status KuduColumnarScanBatch::Data::UncompressSidecar(int idx, int64_t uncompressed_size) {
+  if (PREDICT_FALSE(uncompressed_size < 0)) {
+    return Status::Corruption(Substitute("invalid uncompressed size $0 of sidecar $1",
+                                         uncompressed_size, idx));
+  }
+  const CompressionCodec* codec;
+  RETURN_NOT_OK(GetCompressionCodec(CompressionType::LZ4, &codec));
+  Slice compressed;
+  RETURN_NOT_OK(controller_.GetInboundSidecar(idx, &compressed));
+  faststring* buf = &uncompressed_sidecars_[idx];
+  buf->resize(uncompressed_size);
+  RETURN_NOT_OK_PREPEND(codec->Uncompress(compressed, buf->data(), uncompressed_size),
+                        Substitute("unable to uncompress sidecar $0", idx));
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::Data::GetSidecar(int idx, Slice* data) const {
+  const faststring* buf = FindOrNull(uncompressed_sidecars_, idx);
+  if (buf) {
+    *data = Slice(*buf);
+    return Status::OK();
+  }
+  return controller_.GetInboundSidecar(idx, data);
+}
+
 void KuduColumnarScanBatch::Data::Clear() {
   resp_data_.Clear();
+  uncompressed_sidecars_.clear();
   controller_.Reset();
 }
 
@@ -873,11 +1199,17 @@ Status KuduColumnarScanBatch::Data::GetFixedLengthColumn(int idx, Slice* data) c
   if (PREDICT_FALSE(!resp_data_.columns(idx).has_data_sidecar())) {
     return Status::Corruption("server did not send data for column", col.ToString());
   }
-  RETURN_NOT_OK(controller_.GetInboundSidecar(
-      resp_data_.columns(idx).data_sidecar(),
-      data));
+  RETURN_NOT_OK(GetSidecar(resp_data_.columns(idx).data_sidecar(), data));
 
-  size_t expected_size = resp_data_.num_rows() * col.type_info()->size();
+  size_t expected_size;
+  if (arrow_layout_ && col.type_info()->physical_type() == BOOL) {
+    expected_size = BitmapSize(resp_data_.num_rows());
+  } else {
+    expected_size = resp_data_.num_rows() * col.type_info()->size();
+  }
+  if (arrow_layout_) {
+    expected_size = KUDU_ALIGN_UP(expected_size, 8);
+  }
   if (PREDICT_FALSE(data->size() != expected_size)) {
     return Status::Corruption(Substitute(
         "server sent unexpected data length $0 for column $1 (expected $2)",
@@ -900,22 +1232,21 @@ Status KuduColumnarScanBatch::Data::GetVariableLengthColumn(
   if (PREDICT_FALSE(!resp_col.has_data_sidecar())) {
     return Status::Corruption("server did not send offset data for column", col.ToString());
   }
-  RETURN_NOT_OK(controller_.GetInboundSidecar(
-      resp_col.data_sidecar(),
-      &offsets_tmp));
+  RETURN_NOT_OK(GetSidecar(resp_col.data_sidecar(), &offsets_tmp));
 
   // Get the varlen data.
   Slice data_tmp;
   if (PREDICT_FALSE(!resp_col.has_varlen_data_sidecar())) {
     return Status::Corruption("server did not send varlen data for column", col.ToString());
   }
-  RETURN_NOT_OK(controller_.GetInboundSidecar(
-      resp_col.varlen_data_sidecar(),
-      &data_tmp));
+  RETURN_NOT_OK(GetSidecar(resp_col.varlen_data_sidecar(), &data_tmp));
 
   // Validate the offsets.
   auto expected_num_offsets = resp_data_.num_rows() == 0 ? 0 : (resp_data_.num_rows() + 1);
   auto expected_size = expected_num_offsets * sizeof(uint32_t);
+  if (arrow_layout_) {
+    expected_size = KUDU_ALIGN_UP(expected_size, 8);
+  }
   if (PREDICT_FALSE(offsets_tmp.size() != expected_size)) {
     return Status::Corruption(Substitute("size $0 of offsets buffer for column $1 did not "
                                          "match expected size $2",
@@ -943,7 +1274,7 @@ Status KuduColumnarScanBatch::Data::GetNonNullBitmapForColumn(int idx, Slice* da
     return Status::Corruption(Substitute("server did not send null bitmap for column $0",
                                          projection_->column(idx).ToString()));
   }
-  return controller_.GetInboundSidecar(col.non_null_bitmap_sidecar(), data);
+  return GetSidecar(col.non_null_bitmap_sidecar(), data);
 }
 
 
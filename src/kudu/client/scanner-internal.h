@@ -19,10 +19,13 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <ostream>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <glog/logging.h>
@@ -41,12 +44,15 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
 
-class MonoTime;
 class PartitionKey;
 class Schema;
 
@@ -66,6 +72,7 @@ class KuduSchema;
 namespace internal {
 class RemoteTablet;
 class RemoteTabletServer;
+class ScanBatchDataInterface;
 } // namespace internal
 
 // The result of KuduScanner::Data::AnalyzeResponse.
@@ -116,6 +123,9 @@ struct ScanRpcStatus {
     // The destination tablet does not exist (e.g. because the replica was deleted).
     TABLET_NOT_FOUND,
 
+    // The destination replica lags too far behind to serve a bounded-staleness scan.
+    REPLICA_TOO_STALE,
+
     // Some other unknown tablet server error. This indicates that the TS was running
     // but some problem occurred other than the ones enumerated above.
     OTHER_TS_ERROR
@@ -140,6 +150,77 @@ class KuduScanner::Data {
   // The RPC and TS proxy should already have been prepared in next_req_, proxy_, etc.
   ScanRpcStatus SendScanRpc(const MonoTime& overall_deadline, bool allow_time_for_failover);
 
+  // The two halves of SendScanRpc(): PrepareScanRpc() sets up 'controller'
+  // and returns the deadline of the RPC, and FinishScanRpc() analyzes its
+  // result once it completed into 'controller_' and 'last_response_' with
+  // 'rpc_status'.
+  MonoTime PrepareScanRpc(rpc::RpcController* controller,
+                          const MonoTime& overall_deadline,
+                          bool allow_time_for_failover);
+  ScanRpcStatus FinishScanRpc(const Status& rpc_status,
+                              const MonoTime& overall_deadline,
+                              const MonoTime& rpc_deadline);
+
+  // Like SendScanRpc(), but sends a continuation of the scan asynchronously,
+  // with a deadline of the scan timeout from now. Once the RPC completes,
+  // its result is collected with TakeAsyncRpcResult().
+  //
+  // No batch may be prefetched when this is called.
+  void SendContinueRpcAsync();
+
+  // Runs 'f' once the oldest batch fetched asynchronously is received: right
+  // away if it already was, or on a reactor thread otherwise.
+  void WhenAsyncRpcDone(std::function<void()> f);
+
+  // Returns the result of the RPC which fetched the oldest batch fetched
+  // asynchronously, once it completed into 'controller_' and 'last_response_'.
+  ScanRpcStatus TakeAsyncRpcResult();
+
+  // Waits for the RPC in flight, if any, and discards the batches fetched
+  // asynchronously.
+  void DiscardPrefetchedBatches();
+
+  // Handles the 'result' of a continuation of the scan, retrying it until
+  // 'batch_deadline' if needed, and resets 'batch_data' to the batch
+  // returned. The next batch is then prefetched if so configured.
+  //
+  // This function may block unless 'result' is OK.
+  Status HandleContinueResult(ScanRpcStatus result,
+                              const MonoTime& batch_deadline,
+                              internal::ScanBatchDataInterface* batch_data);
+
+  // Resets 'batch_data' to the rows of 'last_response_', and prefetches the
+  // next batches if so configured.
+  Status ResetBatch(internal::ScanBatchDataInterface* batch_data);
+
+  // A batch fetched asynchronously, before it's asked for if prefetched.
+  struct PrefetchedBatch {
+    rpc::RpcController controller;
+    tserver::ScanResponsePB response;
+    MonoTime rpc_deadline;
+    MonoTime batch_deadline;
+
+    // Whether the RPC completed, and the memory used by the batch then.
+    bool done = false;
+    int64_t bytes = 0;
+  };
+
+  // Prepares the continuation of the scan which fetches a new batch of
+  // 'prefetched_'.
+  PrefetchedBatch* PrepareContinueRpcAsyncUnlocked();
+
+  // Returns the batch to prefetch, prepared with
+  // PrepareContinueRpcAsyncUnlocked(), if the configured prefetch depth and
+  // --scanner_prefetch_max_bytes allow for another one and the scan continues.
+  PrefetchedBatch* MaybePrefetchUnlocked();
+
+  // Sends the RPC which fetches 'batch'.
+  void SendContinueRpcAsync(PrefetchedBatch* batch);
+
+  // Called on the reactor thread once the RPC which fetches 'batch'
+  // completes.
+  void OnContinueRpcAsyncDone(PrefetchedBatch* batch);
+
   // Called when KuduScanner::NextBatch or KuduScanner::Data::OpenTablet result in an RPC or
   // server error.
   //
@@ -248,6 +329,32 @@ class KuduScanner::Data {
   // RPC controller for the last in-flight RPC.
   rpc::RpcController controller_;
 
+  // Whether batches were fetched asynchronously, possibly in flight, without
+  // having been taken yet. Only accessed by the thread using the scanner.
+  bool async_rpc_pending_;
+
+  // Whether the Bloom filter predicate feature is required by the scan RPCs.
+  bool bloom_filter_feature_required_;
+
+  // Protects the fields below and the configuration of the batches to
+  // request which, once the scanner prefetches, the reactor threads access
+  // too.
+  Mutex prefetch_lock_;
+  ConditionVariable prefetch_cond_;
+
+  // The batches fetched asynchronously, oldest first. Only the latest one may
+  // be in flight.
+  std::deque<std::unique_ptr<PrefetchedBatch>> prefetched_;
+
+  // The memory used by the batches of 'prefetched_'.
+  int64_t prefetched_bytes_;
+
+  // Set while discarding the batches of 'prefetched_'.
+  bool prefetching_stopped_;
+
+  // Run once the oldest batch of 'prefetched_' is received.
+  std::function<void()> prefetch_waiter_;
+
   // The table we're scanning.
   sp::shared_ptr<KuduTable> table_;
 
@@ -397,6 +504,12 @@ class KuduScanBatch::Data : public internal::ScanBatchDataInterface {
   // The KuduSchema version of 'projection_'
   const KuduSchema* client_projection_;
 
+  // The projections of a batch which doesn't come from a scanner, e.g. one
+  // returned by KuduTable::Lookup(), which must outlive the batch. Null
+  // otherwise.
+  std::unique_ptr<Schema> owned_projection_;
+  std::unique_ptr<KuduSchema> owned_client_projection_;
+
   // The row format flags that were passed to the KuduScanner.
   // See: KuduScanner::SetRowFormatFlags()
   uint64_t row_format_flags_;
@@ -421,6 +534,13 @@ class KuduColumnarScanBatch::Data : public internal::ScanBatchDataInterface {
  private:
   Status CheckColumnIndex(int idx) const;
 
+  // Uncompresses the inbound sidecar 'idx', compressed with the COMPRESSED_COLUMNS
+  // row format flag, into 'uncompressed_sidecars_'.
+  Status UncompressSidecar(int idx, int64_t uncompressed_size);
+
+  // Returns the data of the inbound sidecar 'idx', uncompressed.
+  Status GetSidecar(int idx, Slice* data) const;
+
   friend class KuduColumnarScanBatch;
 
   // The RPC controller for the RPC which returned this batch.
@@ -435,6 +555,12 @@ class KuduColumnarScanBatch::Data : public internal::ScanBatchDataInterface {
   const Schema* projection_;
   // The KuduSchema version of 'projection_'
   const KuduSchema* client_projection_;
+
+  // Whether the batch uses the Arrow layout (see KuduScanner::ARROW_LAYOUT).
+  bool arrow_layout_ = false;
+
+  // The uncompressed data of the compressed sidecars, keyed by sidecar index.
+  std::unordered_map<int, faststring> uncompressed_sidecars_;
 };
 
 
@@ -56,7 +56,7 @@ MAKE_ENUM_LIMITS(kudu::client::KuduColumnStorageAttributes::EncodingType,
 
 MAKE_ENUM_LIMITS(kudu::client::KuduColumnStorageAttributes::CompressionType,
                  kudu::client::KuduColumnStorageAttributes::DEFAULT_COMPRESSION,
-                 kudu::client::KuduColumnStorageAttributes::ZLIB);
+                 kudu::client::KuduColumnStorageAttributes::ZSTD);
 
 MAKE_ENUM_LIMITS(kudu::client::KuduColumnSchema::DataType,
                  kudu::client::KuduColumnSchema::INT8,
@@ -81,6 +81,9 @@ kudu::EncodingType ToInternalEncodingType(KuduColumnStorageAttributes::EncodingT
     case KuduColumnStorageAttributes::GROUP_VARINT: return kudu::GROUP_VARINT;
     case KuduColumnStorageAttributes::RLE: return kudu::RLE;
     case KuduColumnStorageAttributes::BIT_SHUFFLE: return kudu::BIT_SHUFFLE;
+    case KuduColumnStorageAttributes::FRAME_OF_REFERENCE: return kudu::FRAME_OF_REFERENCE;
+    case KuduColumnStorageAttributes::FSST: return kudu::FSST;
+    case KuduColumnStorageAttributes::ADAPTIVE: return kudu::ADAPTIVE;
     default: LOG(FATAL) << "Unexpected encoding type: " << type;
   }
 }
@@ -94,6 +97,9 @@ KuduColumnStorageAttributes::EncodingType FromInternalEncodingType(kudu::Encodin
     case kudu::GROUP_VARINT: return KuduColumnStorageAttributes::GROUP_VARINT;
     case kudu::RLE: return KuduColumnStorageAttributes::RLE;
     case kudu::BIT_SHUFFLE: return KuduColumnStorageAttributes::BIT_SHUFFLE;
+    case kudu::FRAME_OF_REFERENCE: return KuduColumnStorageAttributes::FRAME_OF_REFERENCE;
+    case kudu::FSST: return KuduColumnStorageAttributes::FSST;
+    case kudu::ADAPTIVE: return KuduColumnStorageAttributes::ADAPTIVE;
     default: LOG(FATAL) << "Unexpected internal encoding type: " << type;
   }
 }
@@ -105,6 +111,7 @@ kudu::CompressionType ToInternalCompressionType(KuduColumnStorageAttributes::Com
     case KuduColumnStorageAttributes::SNAPPY: return kudu::SNAPPY;
     case KuduColumnStorageAttributes::LZ4: return kudu::LZ4;
     case KuduColumnStorageAttributes::ZLIB: return kudu::ZLIB;
+    case KuduColumnStorageAttributes::ZSTD: return kudu::ZSTD;
     default: LOG(FATAL) << "Unexpected compression type" << type;
   }
 }
@@ -117,6 +124,7 @@ KuduColumnStorageAttributes::CompressionType FromInternalCompressionType(
     case kudu::SNAPPY: return KuduColumnStorageAttributes::SNAPPY;
     case kudu::LZ4: return KuduColumnStorageAttributes::LZ4;
     case kudu::ZLIB: return KuduColumnStorageAttributes::ZLIB;
+    case kudu::ZSTD: return KuduColumnStorageAttributes::ZSTD;
     default: LOG(FATAL) << "Unexpected internal compression type: " << type;
   }
 }
@@ -244,6 +252,12 @@ Status KuduColumnStorageAttributes::StringToEncodingType(
     *type = KuduColumnStorageAttributes::DICT_ENCODING;
   } else if (encoding_uc == "BIT_SHUFFLE") {
     *type = KuduColumnStorageAttributes::BIT_SHUFFLE;
+  } else if (encoding_uc == "FRAME_OF_REFERENCE") {
+    *type = KuduColumnStorageAttributes::FRAME_OF_REFERENCE;
+  } else if (encoding_uc == "FSST") {
+    *type = KuduColumnStorageAttributes::FSST;
+  } else if (encoding_uc == "ADAPTIVE") {
+    *type = KuduColumnStorageAttributes::ADAPTIVE;
   } else if (encoding_uc == "GROUP_VARINT") {
     *type = KuduColumnStorageAttributes::GROUP_VARINT;
   } else {
@@ -268,6 +282,8 @@ Status KuduColumnStorageAttributes::StringToCompressionType(
     *type = KuduColumnStorageAttributes::LZ4;
   } else if (compression_uc == "ZLIB") {
     *type = KuduColumnStorageAttributes::ZLIB;
+  } else if (compression_uc == "ZSTD") {
+    *type = KuduColumnStorageAttributes::ZSTD;
   } else {
     return Status::InvalidArgument(Substitute(
         "compression type $0 is not supported", compression));
@@ -137,6 +137,9 @@ class KUDU_EXPORT KuduColumnStorageAttributes {
     RLE = 4,
     DICT_ENCODING = 5,
     BIT_SHUFFLE = 6,
+    FRAME_OF_REFERENCE = 7,
+    FSST = 8,
+    ADAPTIVE = 9,
 
     /// @deprecated GROUP_VARINT is not supported for valid types, and
     /// will fall back to another encoding on the server side.
@@ -150,6 +153,7 @@ class KUDU_EXPORT KuduColumnStorageAttributes {
     SNAPPY = 2,
     LZ4 = 3,
     ZLIB = 4,
+    ZSTD = 5,
   };
 
 
@@ -28,9 +28,11 @@
 
 #include "kudu/client/batcher.h"
 #include "kudu/client/callbacks.h"
+#include "kudu/client/client-internal.h"
 #include "kudu/client/error_collector.h"
 #include "kudu/client/resource_metrics-internal.h"
 #include "kudu/client/shared_ptr.h" // IWYU pragma: keep
+#include "kudu/client/write_op-internal.h"
 #include "kudu/client/write_op.h"
 #include "kudu/common/partial_row.h"
 #include "kudu/common/schema.h"
@@ -66,6 +68,7 @@ KuduSession::Data::Data(shared_ptr<KuduClient> client,
       flush_interval_(MonoDelta::FromMilliseconds(1000)),
       flush_task_active_(false),
       flush_mode_(AUTO_FLUSH_SYNC),
+      adaptive_flush_(false),
       condition_(&mutex_),
       batchers_num_(0),
       batchers_num_limit_(2),
@@ -73,6 +76,7 @@ KuduSession::Data::Data(shared_ptr<KuduClient> client,
       buffer_watermark_pct_(50),
       buffer_bytes_used_(0),
       txn_id_(txn_id),
+      write_op_pool_(new internal::WriteOpPool),
       buffer_pre_flush_enabled_(true) {
 }
 
@@ -83,10 +87,18 @@ void KuduSession::Data::Init(weak_ptr<KuduSession> session) {
 
 void KuduSession::Data::FlushFinished(Batcher* batcher) {
   const int64_t bytes_flushed = batcher->buffer_bytes_used();
+  MonoDelta coalesced_flush_age;
   {
     std::lock_guard<Mutex> l(mutex_);
     buffer_bytes_used_ -= bytes_flushed;
     --batchers_num_;
+    // With adaptive flushing, the time-based flush task may have let
+    // the current batcher grow past its flush age while this one was
+    // in flight: flush it once nothing else is in flight.
+    if (adaptive_flush_ && flush_mode_ == AUTO_FLUSH_BACKGROUND &&
+        batcher_ && batchers_num_ == 1) {
+      coalesced_flush_age = flush_interval_;
+    }
     // The logic of KuduSession::ApplyWriteOp() needs to know
     // if total number of batchers or buffer byte count decreases.
     // There can be a thread waiting on the corresponding condition
@@ -95,6 +107,9 @@ void KuduSession::Data::FlushFinished(Batcher* batcher) {
     // the only thread to notify.
     condition_.Signal();
   }
+  if (coalesced_flush_age.Initialized()) {
+    FlushCurrentBatcher(coalesced_flush_age);
+  }
 }
 
 Status KuduSession::Data::Close(bool force) {
@@ -228,6 +243,18 @@ Status KuduSession::Data::SetMaxBatchersNum(unsigned int max_num) {
   return Status::OK();
 }
 
+Status KuduSession::Data::SetAdaptiveFlush(bool enable) {
+  std::lock_guard<Mutex> l(mutex_);
+  if (HasPendingOperationsUnlocked()) {
+    // NOTE: this is an artificial restriction, as for the other settings
+    // of the mutation buffers.
+    return Status::IllegalState(
+        "Cannot change adaptive flushing when writes are buffered.");
+  }
+  adaptive_flush_ = enable;
+  return Status::OK();
+}
+
 void KuduSession::Data::SetTimeoutMillis(int timeout_ms) {
   if (timeout_ms < 0) {
     timeout_ms = 0;
@@ -522,7 +549,9 @@ Status KuduSession::Data::ApplyWriteOp(KuduWriteOperation* write_op) {
       // no thread-safety is advertised for the kudu::KuduSession interface.
       scoped_refptr<Batcher> batcher(
           new Batcher(client_.get(), error_collector_, session_,
-                      external_consistency_mode_, txn_id_));
+                      external_consistency_mode_, txn_id_,
+                      adaptive_flush_ ? &client_->data_->write_flow_controller_
+                                      : nullptr));
       if (timeout_.Initialized()) {
         batcher->SetTimeout(timeout_);
       }
@@ -589,6 +618,14 @@ void KuduSession::Data::TimeBasedFlushTask(
       return;
     }
     max_batcher_age = data->flush_interval_;
+    if (data->adaptive_flush_ &&
+        data->batchers_num_ > (data->batcher_ ? 1 : 0)) {
+      // Let the current batcher accumulate more operations while the
+      // earlier ones are in flight: FlushFinished() sends it once they're
+      // done if it's past its flush age by then.
+      max_batcher_age = MonoDelta::FromNanoseconds(
+          max_batcher_age.ToNanoseconds() * kAdaptiveFlushMaxIntervals);
+    }
   }
 
   // Let's measure the age of a batcher as the time elapsed from the moment
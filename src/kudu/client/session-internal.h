@@ -50,6 +50,10 @@ namespace client {
 class KuduStatusCallback;
 class KuduWriteOperation;
 
+namespace internal {
+class WriteOpPool;
+} // namespace internal
+
 // This class contains the code to do the heavy-lifting for the
 // kudu::KuduSession-related operations. Its interface does not assume
 // thread-safety in general, but it's thread-safe regarding the following
@@ -99,6 +103,9 @@ class KuduSession::Data {
   // Set the limit on maximum number of batchers with pending operations.
   Status SetMaxBatchersNum(unsigned int period_ms);
 
+  // Enable or disable adaptive flushing.
+  Status SetAdaptiveFlush(bool enable);
+
   // Set timeout for write operations, in milliseconds.
   void SetTimeoutMillis(int timeout_ms);
 
@@ -175,6 +182,11 @@ class KuduSession::Data {
   // if calling FlushCurrentBatcher() using this watermark.
   static const int64_t kWatermarkNonEmptyBatcher = 1;
 
+  // With adaptive flushing, the time-based flush of the current batcher
+  // is postponed while other batchers are in flight, up to this many
+  // flush intervals.
+  static const int kAdaptiveFlushMaxIntervals = 4;
+
   // The client that this session is associated with.
   const sp::shared_ptr<KuduClient> client_;
 
@@ -205,6 +217,11 @@ class KuduSession::Data {
   // Current flush mode for the session's data.
   FlushMode flush_mode_;  // protected by mutex_
 
+  // Whether the batchers are flushed adaptively: their write RPCs are paced
+  // by the client's WriteFlowController, and in AUTO_FLUSH_BACKGROUND mode
+  // the time-based flush coalesces the batchers while others are in flight.
+  bool adaptive_flush_;  // protected by mutex_
+
   // Mutex for the condition_ member (the condition variable).
   // This lock protects variables from simultaneous access:
   // batcher- and byte-counting members, data flow control and other variables
@@ -257,6 +274,9 @@ class KuduSession::Data {
   // Metrics of all write operations in the session.
   ResourceMetrics write_op_metrics_;
 
+  // The operations created by KuduSession::NewWriteOperation().
+  const sp::shared_ptr<internal::WriteOpPool> write_op_pool_;
+
  private:
   FRIEND_TEST(ClientTest, TestAutoFlushBackgroundApplyBlocks);
   FRIEND_TEST(ClientTest, TestAutoFlushBackgroundAndErrorCollector);
@@ -0,0 +1,137 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/client/write_flow_controller.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/port.h"
+
+using std::string;
+using std::vector;
+
+namespace kudu {
+namespace client {
+namespace internal {
+
+namespace {
+
+// The window grows by this fraction of each write handled promptly, but
+// by no less than kMinWindowIncrementBytes.
+constexpr int kWindowIncrementDivisor = 4;
+constexpr int64_t kMinWindowIncrementBytes = 64 * 1024;
+
+// A write whose latency exceeds the smoothed latency by this factor is
+// taken as a sign of overload.
+constexpr int kLatencySpikeFactor = 3;
+
+// The weight of a new sample in the smoothed latency, as a fraction
+// 1/kLatencySmoothingDivisor.
+constexpr int kLatencySmoothingDivisor = 8;
+
+} // anonymous namespace
+
+void WriteFlowController::Send(const string& server_uuid, int64_t bytes,
+                               std::function<void()> send) {
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    auto& s = servers_[server_uuid];
+    if (!s.queued.empty() || !s.Fits(bytes)) {
+      s.queued.emplace_back(bytes, std::move(send));
+      return;
+    }
+    s.in_flight_bytes += bytes;
+  }
+  send();
+}
+
+void WriteFlowController::Finished(const string& server_uuid, int64_t bytes,
+                                   const WriteFeedback& feedback) {
+  vector<std::function<void()>> to_send;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    auto* s = FindOrNull(servers_, server_uuid);
+    DCHECK(s) << "no write was sent to " << server_uuid;
+    if (PREDICT_FALSE(!s)) {
+      return;
+    }
+    s->in_flight_bytes -= bytes;
+    DCHECK_GE(s->in_flight_bytes, 0);
+
+    bool overloaded = feedback.rejected;
+    if (!overloaded && feedback.latency.Initialized()) {
+      const MonoDelta& latency = feedback.latency;
+      overloaded = (feedback.queue_time.Initialized() &&
+                    feedback.queue_time.ToNanoseconds() * 2 > latency.ToNanoseconds()) ||
+                   (s->latency.Initialized() &&
+                    latency.ToNanoseconds() >
+                        s->latency.ToNanoseconds() * kLatencySpikeFactor);
+      s->latency = s->latency.Initialized()
+          ? MonoDelta::FromNanoseconds(
+                s->latency.ToNanoseconds() +
+                (latency.ToNanoseconds() - s->latency.ToNanoseconds()) /
+                    kLatencySmoothingDivisor)
+          : latency;
+    }
+    if (overloaded) {
+      s->window_bytes = std::max(kMinWindowBytes, s->window_bytes / 2);
+    } else {
+      s->window_bytes = std::min(
+          kMaxWindowBytes,
+          s->window_bytes + std::max(kMinWindowIncrementBytes,
+                                     bytes / kWindowIncrementDivisor));
+    }
+
+    while (!s->queued.empty() && s->Fits(s->queued.front().first)) {
+      s->in_flight_bytes += s->queued.front().first;
+      to_send.emplace_back(std::move(s->queued.front().second));
+      s->queued.pop_front();
+    }
+  }
+  // Send outside the lock: a failed send may call back into Finished() on
+  // this very thread.
+  for (auto& send : to_send) {
+    send();
+  }
+}
+
+int64_t WriteFlowController::window_bytes(const string& server_uuid) const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  const auto* s = FindOrNull(servers_, server_uuid);
+  return s ? s->window_bytes : kInitialWindowBytes;
+}
+
+int64_t WriteFlowController::in_flight_bytes(const string& server_uuid) const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  const auto* s = FindOrNull(servers_, server_uuid);
+  return s ? s->in_flight_bytes : 0;
+}
+
+MonoDelta WriteFlowController::latency(const string& server_uuid) const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  const auto* s = FindOrNull(servers_, server_uuid);
+  return s ? s->latency : MonoDelta();
+}
+
+} // namespace internal
+} // namespace client
+} // namespace kudu
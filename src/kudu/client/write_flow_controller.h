@@ -0,0 +1,118 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
+
+namespace kudu {
+namespace client {
+namespace internal {
+
+// Limits the bytes of write RPCs in flight to each tablet server for the
+// sessions which use adaptive flushing (see
+// KuduSession::SetMutationBufferAdaptiveFlush()).
+//
+// The limit of each server is a window adjusted the way TCP adjusts its
+// congestion window: it grows additively with every write the server handles
+// promptly and is halved upon every sign of the server being overloaded,
+// i.e. a write rejected for a full service queue or throttling, a write
+// which spent most of its time in the server's queue, or a write which took
+// far longer than the recent writes to the server. Writes which don't fit
+// into the window are queued and sent in order as the in-flight ones finish.
+// A single write is always let through if nothing is in flight to the
+// server, whatever its size.
+//
+// This class is thread-safe.
+class WriteFlowController {
+ public:
+  // The bounds and the initial size of the window of a server.
+  static constexpr int64_t kMinWindowBytes = 256 * 1024;
+  static constexpr int64_t kInitialWindowBytes = 4 * 1024 * 1024;
+  static constexpr int64_t kMaxWindowBytes = 64 * 1024 * 1024;
+
+  // The outcome of a write, as reported to Finished().
+  struct WriteFeedback {
+    // The time from sending the write to receiving its response.
+    MonoDelta latency;
+
+    // The time the write spent in the service queue of the server,
+    // as reported by the server; uninitialized if not reported.
+    MonoDelta queue_time;
+
+    // Whether the server rejected the write because it is too busy.
+    bool rejected = false;
+  };
+
+  WriteFlowController() = default;
+
+  // Runs 'send' to send a write of 'bytes' to the server with UUID
+  // 'server_uuid' once it fits into the window of the server, either
+  // right away or from a thread finishing another write to the server.
+  // Every call must be followed by a call to Finished() once the write
+  // is done, whatever its outcome.
+  void Send(const std::string& server_uuid, int64_t bytes, std::function<void()> send);
+
+  // Releases the 'bytes' of a write sent with Send(), adjusts the window of
+  // the server per 'feedback' and sends the queued writes which now fit.
+  void Finished(const std::string& server_uuid, int64_t bytes,
+                const WriteFeedback& feedback);
+
+  // Returns the window of the server, or kInitialWindowBytes if nothing
+  // was sent to it.
+  int64_t window_bytes(const std::string& server_uuid) const;
+
+  // Returns the number of bytes in flight to the server.
+  int64_t in_flight_bytes(const std::string& server_uuid) const;
+
+  // Returns the smoothed latency of the writes to the server, uninitialized
+  // if no write to it finished yet.
+  MonoDelta latency(const std::string& server_uuid) const;
+
+ private:
+  struct ServerState {
+    int64_t window_bytes = kInitialWindowBytes;
+    int64_t in_flight_bytes = 0;
+
+    // Exponentially weighted moving average of the write latency.
+    MonoDelta latency;
+
+    // The writes waiting for room in the window, in the order of Send().
+    std::deque<std::pair<int64_t, std::function<void()>>> queued;
+
+    bool Fits(int64_t bytes) const {
+      return in_flight_bytes == 0 || in_flight_bytes + bytes <= window_bytes;
+    }
+  };
+
+  mutable simple_spinlock lock_;
+  std::unordered_map<std::string, ServerState> servers_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriteFlowController);
+};
+
+} // namespace internal
+} // namespace client
+} // namespace kudu
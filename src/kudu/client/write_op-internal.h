@@ -17,15 +17,65 @@
 #ifndef KUDU_CLIENT_WRITE_OP_INTERNAL_H
 #define KUDU_CLIENT_WRITE_OP_INTERNAL_H
 
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "kudu/client/shared_ptr.h" // IWYU pragma: keep
 #include "kudu/client/write_op.h"
 #include "kudu/common/wire_protocol.pb.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
 
 namespace kudu {
 
 namespace client {
 
+class KuduTable;
+
 RowOperationsPB_Type ToInternalWriteType(KuduWriteOperation::Type type);
 
+namespace internal {
+
+// The write operations created by KuduSession::NewWriteOperation(), which
+// are put back here once flushed rather than deleted, and handed out again
+// with their rows cleared.
+//
+// The operations handed out refer to the pool, so it outlives its session
+// while some of them are in flight, whereas the ones in the pool don't.
+//
+// This class is thread-safe.
+class WriteOpPool : public sp::enable_shared_from_this<WriteOpPool> {
+ public:
+  // The most operations kept in the pool, across tables and types.
+  static const size_t kMaxPooledOps = 64 * 1024;
+
+  WriteOpPool() = default;
+
+  // Returns an operation of 'type' on 'table', reusing a pooled one if any.
+  KuduWriteOperation* Get(const sp::shared_ptr<KuduTable>& table,
+                          KuduWriteOperation::Type type);
+
+  // Puts back 'op', an operation returned by Get() that is done with.
+  void Put(std::unique_ptr<KuduWriteOperation> op);
+
+ private:
+  typedef std::pair<const KuduTable*, KuduWriteOperation::Type> Key;
+
+  simple_spinlock lock_;
+  std::map<Key, std::vector<std::unique_ptr<KuduWriteOperation>>> ops_;
+  size_t num_ops_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(WriteOpPool);
+};
+
+// Puts 'op' back into its pool if it was taken from one, deletes it otherwise.
+void ReleaseWriteOp(std::unique_ptr<KuduWriteOperation> op);
+
+} // namespace internal
+
 } // namespace client
 } // namespace kudu
 
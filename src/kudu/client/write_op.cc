@@ -17,6 +17,8 @@
 
 #include "kudu/client/write_op.h"
 
+#include <cstring>
+#include <mutex>
 #include <ostream>
 #include <type_traits>
 
@@ -24,6 +26,7 @@
 
 #include "kudu/client/client.h" // IWYU pragma: keep
 #include "kudu/client/schema.h"
+#include "kudu/client/write_op-internal.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_operations.pb.h"
@@ -61,6 +64,12 @@ KuduWriteOperation::KuduWriteOperation(const shared_ptr<KuduTable>& table)
 
 KuduWriteOperation::~KuduWriteOperation() {}
 
+void KuduWriteOperation::Reset() {
+  row_.DeallocateOwnedStrings();
+  memset(row_.isset_bitmap_, 0, BitmapSize(row_.schema()->num_columns()));
+  size_in_buffer_ = 0;
+}
+
 
 int64_t KuduWriteOperation::SizeInBuffer() const {
   if (size_in_buffer_ > 0) {
@@ -154,5 +163,59 @@ KuduUpsertIgnore::KuduUpsertIgnore(const shared_ptr<KuduTable>& table)
 
 KuduUpsertIgnore::~KuduUpsertIgnore() {}
 
+// WriteOpPool -----------------------------------------------------------------
+
+namespace internal {
+
+KuduWriteOperation* WriteOpPool::Get(const shared_ptr<KuduTable>& table,
+                                     KuduWriteOperation::Type type) {
+  unique_ptr<KuduWriteOperation> op;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    auto it = ops_.find(Key(table.get(), type));
+    if (it != ops_.end() && !it->second.empty()) {
+      op = std::move(it->second.back());
+      it->second.pop_back();
+      --num_ops_;
+    }
+  }
+  if (!op) {
+    switch (type) {
+      case KuduWriteOperation::INSERT: op.reset(table->NewInsert()); break;
+      case KuduWriteOperation::UPDATE: op.reset(table->NewUpdate()); break;
+      case KuduWriteOperation::DELETE: op.reset(table->NewDelete()); break;
+      case KuduWriteOperation::UPSERT: op.reset(table->NewUpsert()); break;
+      case KuduWriteOperation::INSERT_IGNORE: op.reset(table->NewInsertIgnore()); break;
+      case KuduWriteOperation::UPDATE_IGNORE: op.reset(table->NewUpdateIgnore()); break;
+      case KuduWriteOperation::DELETE_IGNORE: op.reset(table->NewDeleteIgnore()); break;
+      case KuduWriteOperation::UPSERT_IGNORE: op.reset(table->NewUpsertIgnore()); break;
+      default: LOG(FATAL) << "Unexpected write operation type: " << type;
+    }
+  }
+  op->pool_ = shared_from_this();
+  return op.release();
+}
+
+void WriteOpPool::Put(unique_ptr<KuduWriteOperation> op) {
+  DCHECK_EQ(this, op->pool_.get());
+  // The pooled operations don't refer to the pool, see the class comment.
+  // The caller holds a reference, so this doesn't destroy the pool.
+  op->pool_.reset();
+  op->Reset();
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (num_ops_ < kMaxPooledOps) {
+    ops_[Key(op->table(), op->type())].emplace_back(std::move(op));
+    ++num_ops_;
+  }
+}
+
+void ReleaseWriteOp(unique_ptr<KuduWriteOperation> op) {
+  if (op && op->pool_) {
+    shared_ptr<WriteOpPool> pool = op->pool_;
+    pool->Put(std::move(op));
+  }
+}
+
+} // namespace internal
 } // namespace client
 } // namespace kudu
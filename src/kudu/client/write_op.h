@@ -42,6 +42,7 @@ namespace client {
 namespace internal {
 class Batcher;
 class ErrorCollector;
+class WriteOpPool;
 class WriteRpc;
 } // namespace internal
 
@@ -125,6 +126,7 @@ class KUDU_EXPORT KuduWriteOperation {
   friend class internal::Batcher;
   friend class internal::WriteRpc;
   friend class internal::ErrorCollector;
+  friend class internal::WriteOpPool;
   friend class KuduSession;
 
   // Return the number of bytes required to buffer this operation,
@@ -132,8 +134,14 @@ class KUDU_EXPORT KuduWriteOperation {
   // so subsequent calls will return the size previously computed.
   int64_t SizeInBuffer() const;
 
+  // Unset all the columns of the row, to reuse the operation for another row.
+  void Reset();
+
   mutable int64_t size_in_buffer_;
 
+  // The pool the operation was taken from, if any.
+  sp::shared_ptr<internal::WriteOpPool> pool_;
+
   DISALLOW_COPY_AND_ASSIGN(KuduWriteOperation);
 };
 
@@ -60,6 +60,7 @@
 DECLARE_bool(inject_unsync_time_errors);
 DECLARE_string(builtin_ntp_servers);
 DECLARE_string(cloud_curl_dns_servers_for_testing);
+DECLARE_string(ptp_clock_device);
 DECLARE_string(time_source);
 DECLARE_uint32(cloud_metadata_server_request_timeout_ms);
 
@@ -660,6 +661,19 @@ TEST_F(HybridClockTest, TestNtpDiagnostics) {
 }
 #endif // #if defined(KUDU_HAS_SYSTEM_TIME_SOURCE) ...
 
+#if defined(KUDU_HAS_PTP_TIME_SOURCE)
+// Test that the 'ptp' time source fails to initialize without its PTP
+// hardware clock.
+TEST_F(HybridClockTest, PtpTimeSourceWithoutDevice) {
+  FLAGS_time_source = "ptp";
+  FLAGS_ptp_clock_device = "/dev/nonexistent-ptp-clock";
+  HybridClock clock(metric_entity_);
+  Status s = clock.Init();
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "could not open PTP hardware clock");
+}
+#endif // #if defined(KUDU_HAS_PTP_TIME_SOURCE) ...
+
 // The boolean parameter is to specify whether the wall clock protection is
 // enabled or not ('true' -- enabled, 'false' -- disabled).
 class HybridClockJumpProtectionTest : public ClockTest,
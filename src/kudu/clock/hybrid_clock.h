@@ -183,6 +183,9 @@ class HybridClock : public Clock {
     // Local machine clock synchronized by NTP.
     NTP_SYNC_SYSTEM,
 
+    // PTP hardware clock synchronized by a PTP daemon.
+    PTP,
+
     // Local machine clock with no requirement of NTP synchronization.
     UNSYNC_SYSTEM,
 
@@ -0,0 +1,189 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/clock/ptp_time.h"
+
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/timex.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/errno.h"
+#include "kudu/util/flag_tags.h"
+
+DEFINE_string(ptp_clock_device, "/dev/ptp0",
+              "The PTP hardware clock device read by the 'ptp' time source.");
+TAG_FLAG(ptp_clock_device, experimental);
+
+DEFINE_int32(ptp_clock_max_error_usec, 100,
+             "Maximum error in microseconds of the PTP hardware clock read by "
+             "the 'ptp' time source, i.e. the bound on its offset from the "
+             "grandmaster clock which the PTP daemon maintains. This is the "
+             "clock error reported to the hybrid clock, which the externally "
+             "consistent writes wait out.");
+TAG_FLAG(ptp_clock_max_error_usec, experimental);
+
+DEFINE_int32(ptp_clock_utc_offset_sec, 37,
+             "Offset in seconds of the timescale of the PTP hardware clock read "
+             "by the 'ptp' time source from UTC. PTP clocks keep TAI, which has "
+             "been ahead of UTC by 37 seconds since 2017. Set to 0 if the clock "
+             "keeps UTC.");
+TAG_FLAG(ptp_clock_utc_offset_sec, experimental);
+
+DECLARE_bool(inject_unsync_time_errors);
+
+namespace {
+
+bool ValidatePtpClockMaxError(const char* flagname, int32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(ptp_clock_max_error_usec, &ValidatePtpClockMaxError);
+
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace clock {
+
+namespace {
+
+// Returns the dynamic POSIX clock ID of the clock device open as 'fd', as
+// defined by the PTP hardware clock API of the kernel.
+clockid_t FdToClockId(int fd) {
+  constexpr clockid_t kClockFd = 3;
+  return static_cast<clockid_t>((~static_cast<unsigned int>(fd) << 3) | kClockFd);
+}
+
+} // anonymous namespace
+
+PtpTime::PtpTime()
+    : fd_(-1),
+      clock_id_(CLOCK_REALTIME) {
+}
+
+PtpTime::~PtpTime() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+Status PtpTime::Init() {
+  DCHECK_EQ(-1, fd_);
+  if (PREDICT_FALSE(FLAGS_inject_unsync_time_errors)) {
+    return Status::ServiceUnavailable("Injected clock unsync error");
+  }
+  int fd;
+  RETRY_ON_EINTR(fd, open(FLAGS_ptp_clock_device.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd < 0) {
+    int err = errno;
+    return Status::IOError(
+        Substitute("could not open PTP hardware clock $0", FLAGS_ptp_clock_device),
+        ErrnoToString(err), err);
+  }
+  fd_ = fd;
+  clock_id_ = FdToClockId(fd);
+
+  uint64_t now_usec;
+  RETURN_NOT_OK(ReadClock(&now_usec));
+  LOG(INFO) << Substitute("reading PTP hardware clock $0 with a max error of $1us",
+                          FLAGS_ptp_clock_device, FLAGS_ptp_clock_max_error_usec);
+  return Status::OK();
+}
+
+Status PtpTime::ReadClock(uint64_t* now_usec) const {
+  timespec ts;
+  if (PREDICT_FALSE(clock_gettime(clock_id_, &ts) != 0)) {
+    int err = errno;
+    return Status::ServiceUnavailable(
+        Substitute("could not read PTP hardware clock $0", FLAGS_ptp_clock_device),
+        ErrnoToString(err), err);
+  }
+  *now_usec = static_cast<uint64_t>(ts.tv_sec - FLAGS_ptp_clock_utc_offset_sec) * 1000000 +
+      ts.tv_nsec / 1000;
+  return Status::OK();
+}
+
+Status PtpTime::WalltimeWithError(uint64_t* now_usec, uint64_t* error_usec) {
+  if (PREDICT_FALSE(FLAGS_inject_unsync_time_errors)) {
+    return Status::ServiceUnavailable("Injected clock unsync error");
+  }
+  uint64_t now;
+  RETURN_NOT_OK(ReadClock(&now));
+  const uint64_t error = FLAGS_ptp_clock_max_error_usec;
+
+  // If the system clock is synchronized, both clocks must be within their
+  // error bounds of each other. The system clock is read in between two reads
+  // of the hardware clock to account for the time between the reads.
+  timex t;
+  t.modes = 0; // set mode to 0 for read-only query
+  if (ntp_adjtime(&t) == TIME_OK) {
+    uint64_t now_after;
+    RETURN_NOT_OK(ReadClock(&now_after));
+    // With STA_NANO, the kernel reports nanoseconds in the 'tv_usec' field.
+    const uint64_t system_usec = static_cast<uint64_t>(t.time.tv_sec) * 1000000 +
+        ((t.status & STA_NANO) ? t.time.tv_usec / 1000 : t.time.tv_usec);
+    const uint64_t bound = error + t.maxerror;
+    if (PREDICT_FALSE(system_usec + bound < now || system_usec > now_after + bound)) {
+      return Status::ServiceUnavailable(Substitute(
+          "PTP hardware clock $0 is off the synchronized system clock beyond their "
+          "max errors of $1us and $2us: hardware clock at $3us, system clock at $4us",
+          FLAGS_ptp_clock_device, error, t.maxerror, now, system_usec));
+    }
+  }
+  *now_usec = now;
+  *error_usec = error;
+  return Status::OK();
+}
+
+void PtpTime::DumpDiagnostics(vector<string>* log) const {
+  uint64_t now_usec;
+  Status s = ReadClock(&now_usec);
+  LOG_STRING(ERROR, log) << Substitute(
+      "PTP hardware clock $0 (max error $1us, UTC offset $2s): $3",
+      FLAGS_ptp_clock_device, FLAGS_ptp_clock_max_error_usec,
+      FLAGS_ptp_clock_utc_offset_sec,
+      s.ok() ? Substitute("$0us", now_usec) : s.ToString());
+
+  timex t;
+  t.modes = 0; // set mode to 0 for read-only query
+  const int rc = ntp_adjtime(&t);
+  LOG_STRING(ERROR, log) << Substitute(
+      "system clock: ntp_adjtime() returned $0, max error $1us",
+      rc, rc == -1 ? 0 : t.maxerror);
+}
+
+} // namespace clock
+} // namespace kudu
@@ -0,0 +1,74 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "kudu/clock/time_service.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace clock {
+
+// TimeService implementation which reads a PTP hardware clock (PHC), i.e. the
+// clock of a network interface synchronized by a PTP daemon like ptp4l.
+//
+// Unlike NTP, which reports errors bounds of milliseconds, PTP synchronizes
+// the hardware clocks within microseconds of their grandmaster. This time
+// service reports the precision the PTP daemon maintains, as configured with
+// --ptp_clock_max_error_usec, which shortens the commit-wait of the
+// externally consistent writes accordingly.
+//
+// The daemon's synchronization status isn't visible to the kernel. However,
+// if the system clock is synchronized on its own, e.g. by chronyd with the PHC
+// as a reference clock, the hardware clock is checked against it to detect a
+// PHC which drifted off.
+class PtpTime : public TimeService {
+ public:
+  PtpTime();
+  ~PtpTime() override;
+
+  Status Init() override;
+
+  Status WalltimeWithError(uint64_t* now_usec, uint64_t* error_usec) override;
+
+  int64_t skew_ppm() const override {
+    // The PTP daemon steers the frequency of the hardware clock: like for
+    // NTP, it may accumulate error at a max rate of 500us per second if the
+    // daemon stops.
+    return 500;
+  }
+
+  void DumpDiagnostics(std::vector<std::string>* log) const override;
+
+ private:
+  // Reads the hardware clock, in microseconds since the Unix epoch.
+  Status ReadClock(uint64_t* now_usec) const;
+
+  // The descriptor of the PTP device, and the dynamic clock ID of its clock.
+  int fd_;
+  clockid_t clock_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(PtpTime);
+};
+
+} // namespace clock
+} // namespace kudu
@@ -24,6 +24,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -40,6 +41,7 @@
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Target/TargetMachine.h>
 
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/codegen/row_projector.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/once.h"
@@ -235,5 +237,25 @@ Status CodeGenerator::CompileRowProjector(const Schema& base, const Schema& proj
   return Status::OK();
 }
 
+Status CodeGenerator::CompilePredicateEvaluator(
+    const std::vector<PredicateShape>& shapes,
+    scoped_refptr<PredicateEvaluatorFunctions>* out) {
+  RETURN_NOT_OK(CheckCodegenEnabled());
+
+  TargetMachine* tm;
+  RETURN_NOT_OK(PredicateEvaluatorFunctions::Create(shapes, out, &tm));
+
+  if (FLAGS_codegen_dump_mc) {
+    static const int kInstrMax = 1500;
+    std::ostringstream sstr;
+    sstr << "Printing predicate evaluation function:\n";
+    int instrs = DumpAsm((*out)->evaluate(), *tm, &sstr, kInstrMax);
+    sstr << "Printed " << instrs << " instructions.";
+    LOG(INFO) << sstr.str();
+  }
+
+  return Status::OK();
+}
+
 } // namespace codegen
 } // namespace kudu
@@ -18,6 +18,8 @@
 #ifndef KUDU_CODEGEN_CODE_GENERATOR_H
 #define KUDU_CODEGEN_CODE_GENERATOR_H
 
+#include <vector>
+
 #include "kudu/gutil/macros.h"
 #include "kudu/util/status.h"
 
@@ -30,7 +32,9 @@ class Schema;
 
 namespace codegen {
 
+class PredicateEvaluatorFunctions;
 class RowProjectorFunctions;
+struct PredicateShape;
 
 // CodeGenerator is a top-level class that manages a per-module
 // LLVM context, ExecutionEngine initialization, native target loading,
@@ -67,6 +71,11 @@ class CodeGenerator {
   Status CompileRowProjector(const Schema& base, const Schema& proj,
                              scoped_refptr<RowProjectorFunctions>* out);
 
+  // Attempts to initialize the functions evaluating a conjunction of
+  // predicates of the given shapes. Writes to 'out' upon success.
+  Status CompilePredicateEvaluator(const std::vector<PredicateShape>& shapes,
+                                   scoped_refptr<PredicateEvaluatorFunctions>* out);
+
  private:
   static void GlobalInit();
 
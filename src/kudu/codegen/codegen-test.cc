@@ -32,7 +32,11 @@
 
 #include "kudu/codegen/code_generator.h"
 #include "kudu/codegen/compilation_manager.h"
+#include "kudu/codegen/object_cache.h"
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/codegen/row_projector.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/row.h"
 #include "kudu/common/rowblock.h"
@@ -40,8 +44,11 @@
 #include "kudu/common/schema.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/singleton.h"
+#include "kudu/gutil/strings/util.h"
+#include "kudu/util/env.h"
 #include "kudu/util/logging_test_util.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/path_util.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
 #include "kudu/util/slice.h"
@@ -55,13 +62,18 @@ using std::vector;
 
 DECLARE_bool(codegen_dump_mc);
 DECLARE_int32(codegen_cache_capacity);
+DECLARE_string(codegen_object_cache_dir);
 
 namespace kudu {
 
 typedef RowProjector NoCodegenRP;
 typedef codegen::RowProjector CodegenRP;
 
+using codegen::ColumnIdxAndPredicate;
 using codegen::CompilationManager;
+using codegen::PredicateEvaluator;
+using codegen::PredicateEvaluatorFunctions;
+using codegen::PredicateShape;
 
 class CodegenTest : public KuduTest {
  public:
@@ -391,6 +403,52 @@ TEST_F(CodegenTest, TestDumpMC) {
 #endif  // #if defined(__powerpc__) ... #elif defined(__aarch64__) ... #else ...
 }
 
+// Test that the compiled code is persisted in the object cache directory,
+// and loaded instead of being compiled again.
+TEST_F(CodegenTest, TestObjectCache) {
+  const string dir = GetTestPath("codegen-objects");
+  FLAGS_codegen_object_cache_dir = dir;
+  codegen::DiskObjectCache* cache = codegen::DiskObjectCache::GetSingleton();
+  ASSERT_NE(nullptr, cache);
+  auto num_objects = [&]() {
+    vector<string> children;
+    CHECK_OK(env_->GetChildren(dir, &children));
+    return std::count_if(children.begin(), children.end(), [](const string& child) {
+        return HasSuffixString(child, ".o");
+      });
+  };
+
+  Schema ints;
+  vector<size_t> part_cols = { kI32Col, kI32NullValCol, kI32NullCol };
+  ASSERT_OK(CreatePartialSchema(part_cols, &ints));
+  for (int i = 0; i < 2; i++) {
+    SCOPED_TRACE(i);
+    const uint64_t hits = cache->hits();
+    NO_FATALS(TestProjection<true>(&ints));
+    // The first compilation persists the object, the second one loads it.
+    ASSERT_EQ(hits + i, cache->hits());
+    ASSERT_EQ(1, num_objects());
+  }
+
+  // The code of projections with defaults refers to the default values, so
+  // it isn't persisted.
+  Schema with_defaults;
+  part_cols = { kI32Col, kI32RCol };
+  ASSERT_OK(CreatePartialSchema(part_cols, &with_defaults));
+  const uint64_t misses = cache->misses();
+  NO_FATALS(TestProjection<true>(&with_defaults));
+  ASSERT_EQ(misses, cache->misses());
+  ASSERT_EQ(1, num_objects());
+
+  // Objects compiled for something else are deleted when the cache is opened.
+  const string stale_object = JoinPathSegments(dir, "0123456789abcdef-0123456789abcdef.o");
+  ASSERT_OK(WriteStringToFile(env_, "stale", stale_object));
+  codegen::DiskObjectCache reopened(env_, dir);
+  ASSERT_OK(reopened.Init());
+  ASSERT_FALSE(env_->FileExists(stale_object));
+  ASSERT_EQ(1, num_objects());
+}
+
 // Basic test for the CompilationManager code cache.
 // This runs a bunch of compilation tasks and ensures that the cache
 // sometimes hits on the second attempt for the same projection.
@@ -433,4 +491,178 @@ TEST_F(CodegenTest, TestCodeCache) {
   }
 }
 
+// Fixture for the code-generated evaluation of predicates, with a block of
+// random values of the supported types.
+class CodegenPredicateTest : public KuduTest {
+ public:
+  CodegenPredicateTest()
+    : random_(SeedRandom()),
+      schema_({ ColumnSchema("int8", INT8, false),
+                ColumnSchema("uint32-null", UINT32, true),
+                ColumnSchema("int64", INT64, false),
+                ColumnSchema("double-null", DOUBLE, true),
+                ColumnSchema("bool", BOOL, false),
+                ColumnSchema("str", STRING, false) }, 1),
+      mem_(1024),
+      block_(&schema_, kNumRows, &mem_) {
+    // Keep the values in small ranges for the predicates to match some rows.
+    for (int i = 0; i < kNumRows; i++) {
+      *reinterpret_cast<int8_t*>(block_.column_block(0).mutable_cell_ptr(i)) =
+          static_cast<int8_t>(random_.Uniform(20)) - 10;
+      *reinterpret_cast<uint32_t*>(block_.column_block(1).mutable_cell_ptr(i)) =
+          random_.Uniform(4);
+      block_.column_block(1).SetCellIsNull(i, random_.OneIn(4));
+      *reinterpret_cast<int64_t*>(block_.column_block(2).mutable_cell_ptr(i)) =
+          static_cast<int64_t>(random_.Uniform(2000)) - 1000;
+      *reinterpret_cast<double*>(block_.column_block(3).mutable_cell_ptr(i)) =
+          random_.Uniform(100) / 10.0;
+      block_.column_block(3).SetCellIsNull(i, random_.OneIn(3));
+      *reinterpret_cast<bool*>(block_.column_block(4).mutable_cell_ptr(i)) = random_.OneIn(2);
+      *reinterpret_cast<Slice*>(block_.column_block(5).mutable_cell_ptr(i)) = Slice("a");
+    }
+  }
+
+ protected:
+  // Not a multiple of 8, to test the rows which don't fill a byte.
+  static constexpr int kNumRows = 1003;
+
+  // Evaluates the predicates using 'evaluator' and ColumnPredicate::Evaluate(),
+  // starting from a random selection, and checks the results are the same.
+  void CheckEvaluate(const vector<ColumnIdxAndPredicate>& predicates,
+                     PredicateEvaluator* evaluator) {
+    SelectionVector expected(kNumRows);
+    for (int i = 0; i < kNumRows; i++) {
+      if (random_.OneIn(10)) {
+        block_.selection_vector()->SetRowUnselected(i);
+        expected.SetRowUnselected(i);
+      } else {
+        block_.selection_vector()->SetRowSelected(i);
+        expected.SetRowSelected(i);
+      }
+    }
+    for (const auto& col_idx_and_pred : predicates) {
+      col_idx_and_pred.second.Evaluate(block_.column_block(col_idx_and_pred.first), &expected);
+    }
+    evaluator->Evaluate(&block_);
+    for (int i = 0; i < kNumRows; i++) {
+      ASSERT_EQ(expected.IsRowSelected(i), block_.selection_vector()->IsRowSelected(i))
+          << "row " << i;
+    }
+  }
+
+  // Compiles an evaluator for 'predicates', and checks it.
+  void TestPredicates(const vector<ColumnIdxAndPredicate>& predicates) {
+    vector<PredicateShape> shapes;
+    ASSERT_OK(PredicateEvaluatorFunctions::GetShapes(predicates, &shapes));
+    scoped_refptr<PredicateEvaluatorFunctions> functions;
+    ASSERT_OK(generator_.CompilePredicateEvaluator(shapes, &functions));
+    PredicateEvaluator evaluator(predicates, functions);
+    NO_FATALS(CheckEvaluate(predicates, &evaluator));
+  }
+
+  ColumnIdxAndPredicate Pred(int col_idx, ColumnPredicate pred) {
+    return ColumnIdxAndPredicate(col_idx, std::move(pred));
+  }
+
+  Random random_;
+  Schema schema_;
+  RowBlockMemory mem_;
+  RowBlock block_;
+  codegen::CodeGenerator generator_;
+};
+
+TEST_F(CodegenPredicateTest, TestSinglePredicates) {
+  const int8_t i8_lower = -3;
+  const int8_t i8_upper = 4;
+  const uint32_t u32_val = 2;
+  const int64_t i64_upper = 100;
+  const double double_lower = 5.0;
+  const bool bool_val = true;
+  const ColumnSchema& i8_col = schema_.column(0);
+  const ColumnSchema& u32_col = schema_.column(1);
+  const ColumnSchema& i64_col = schema_.column(2);
+  const ColumnSchema& double_col = schema_.column(3);
+  const ColumnSchema& bool_col = schema_.column(4);
+
+  NO_FATALS(TestPredicates({ Pred(0, ColumnPredicate::Range(i8_col, &i8_lower, &i8_upper)) }));
+  NO_FATALS(TestPredicates({ Pred(0, ColumnPredicate::Range(i8_col, &i8_lower, nullptr)) }));
+  NO_FATALS(TestPredicates({ Pred(1, ColumnPredicate::Equality(u32_col, &u32_val)) }));
+  NO_FATALS(TestPredicates({ Pred(1, ColumnPredicate::Range(u32_col, nullptr, &u32_val)) }));
+  NO_FATALS(TestPredicates({ Pred(1, ColumnPredicate::IsNull(u32_col)) }));
+  NO_FATALS(TestPredicates({ Pred(1, ColumnPredicate::IsNotNull(u32_col)) }));
+  NO_FATALS(TestPredicates({ Pred(2, ColumnPredicate::Range(i64_col, nullptr, &i64_upper)) }));
+  NO_FATALS(TestPredicates({ Pred(2, ColumnPredicate::IsNotNull(i64_col)) }));
+  NO_FATALS(TestPredicates({ Pred(3, ColumnPredicate::Range(double_col, &double_lower,
+                                                            nullptr)) }));
+  NO_FATALS(TestPredicates({ Pred(3, ColumnPredicate::Equality(double_col, &double_lower)) }));
+  NO_FATALS(TestPredicates({ Pred(4, ColumnPredicate::Equality(bool_col, &bool_val)) }));
+}
+
+TEST_F(CodegenPredicateTest, TestConjunction) {
+  const int8_t i8_lower = -5;
+  const int8_t i8_upper = 8;
+  const uint32_t u32_lower = 1;
+  const int64_t i64_lower = -500;
+  const int64_t i64_upper = 700;
+  const double double_upper = 7.5;
+  const bool bool_val = false;
+  NO_FATALS(TestPredicates({
+      Pred(0, ColumnPredicate::Range(schema_.column(0), &i8_lower, &i8_upper)),
+      Pred(1, ColumnPredicate::Range(schema_.column(1), &u32_lower, nullptr)),
+      Pred(2, ColumnPredicate::Range(schema_.column(2), &i64_lower, &i64_upper)),
+      Pred(3, ColumnPredicate::Range(schema_.column(3), nullptr, &double_upper)),
+      Pred(4, ColumnPredicate::Equality(schema_.column(4), &bool_val)) }));
+  NO_FATALS(TestPredicates({
+      Pred(1, ColumnPredicate::IsNotNull(schema_.column(1))),
+      Pred(3, ColumnPredicate::IsNull(schema_.column(3))),
+      Pred(2, ColumnPredicate::Range(schema_.column(2), &i64_lower, nullptr)) }));
+}
+
+TEST_F(CodegenPredicateTest, TestUnsupportedPredicates) {
+  vector<PredicateShape> shapes;
+  const Slice str_val("a");
+  Status s = PredicateEvaluatorFunctions::GetShapes(
+      { Pred(5, ColumnPredicate::Equality(schema_.column(5), &str_val)) }, &shapes);
+  ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+
+  const int8_t v1 = 1;
+  const int8_t v2 = 5;
+  vector<const void*> values = { &v1, &v2 };
+  s = PredicateEvaluatorFunctions::GetShapes(
+      { Pred(0, ColumnPredicate::InList(schema_.column(0), &values)) }, &shapes);
+  ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+}
+
+// Test that predicates of the same shapes share the code in the cache, no
+// matter the values they compare against.
+TEST_F(CodegenPredicateTest, TestCodeCache) {
+  Singleton<CompilationManager>::UnsafeReset();
+  CompilationManager* cm = CompilationManager::GetSingleton();
+
+  const int64_t lower1 = -100;
+  const int64_t lower2 = 300;
+  const uint32_t val1 = 0;
+  const uint32_t val2 = 3;
+  const vector<ColumnIdxAndPredicate> preds1 = {
+      Pred(1, ColumnPredicate::Equality(schema_.column(1), &val1)),
+      Pred(2, ColumnPredicate::Range(schema_.column(2), &lower1, nullptr)) };
+  const vector<ColumnIdxAndPredicate> preds2 = {
+      Pred(1, ColumnPredicate::Equality(schema_.column(1), &val2)),
+      Pred(2, ColumnPredicate::Range(schema_.column(2), &lower2, nullptr)) };
+
+  unique_ptr<PredicateEvaluator> evaluator;
+  ASSERT_FALSE(cm->RequestPredicateEvaluator(preds1, &evaluator));
+  cm->Wait();
+  ASSERT_TRUE(cm->RequestPredicateEvaluator(preds1, &evaluator));
+  NO_FATALS(CheckEvaluate(preds1, evaluator.get()));
+  ASSERT_TRUE(cm->RequestPredicateEvaluator(preds2, &evaluator));
+  NO_FATALS(CheckEvaluate(preds2, evaluator.get()));
+
+  // A different shape needs its own code.
+  const vector<ColumnIdxAndPredicate> preds3 = {
+      Pred(2, ColumnPredicate::Range(schema_.column(2), &lower1, nullptr)) };
+  ASSERT_FALSE(cm->RequestPredicateEvaluator(preds3, &evaluator));
+  cm->Wait();
+}
+
 } // namespace kudu
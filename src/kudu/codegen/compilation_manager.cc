@@ -20,9 +20,12 @@
 #include <cstdlib>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -30,6 +33,7 @@
 #include "kudu/codegen/code_cache.h"
 #include "kudu/codegen/code_generator.h"
 #include "kudu/codegen/jit_wrapper.h"
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/codegen/row_projector.h"
 #include "kudu/common/schema.h"
 #include "kudu/gutil/casts.h"
@@ -47,7 +51,9 @@
 
 using std::make_shared;
 using std::shared_ptr;
+using std::string;
 using std::unique_ptr;
+using std::vector;
 
 DEFINE_bool(codegen_time_compilation, false, "Whether to print time that each code "
             "generation request took.");
@@ -130,6 +136,47 @@ class CompilationTask {
   DISALLOW_COPY_AND_ASSIGN(CompilationTask);
 };
 
+// Like CompilationTask, but generates the code evaluating conjunctions of
+// predicates of the given shapes.
+class PredicateCompilationTask {
+ public:
+  // Requires that the cache and generator are valid for the lifetime
+  // of this object.
+  PredicateCompilationTask(vector<PredicateShape> shapes, CodeCache* cache,
+                           CodeGenerator* generator)
+    : shapes_(std::move(shapes)),
+      cache_(cache),
+      generator_(generator) {}
+
+  // Can only be run once.
+  void Run() {
+    WARN_NOT_OK(RunWithStatus(), "Failed compilation of predicate evaluator");
+  }
+
+ private:
+  Status RunWithStatus() {
+    faststring key;
+    PredicateEvaluatorFunctions::EncodeKey(shapes_, &key);
+
+    // Check again to make sure we didn't compile it already.
+    if (cache_->Lookup(key)) return Status::OK();
+
+    scoped_refptr<PredicateEvaluatorFunctions> functions;
+    LOG_TIMING_IF(INFO, FLAGS_codegen_time_compilation, "code-generating predicate evaluator") {
+      RETURN_NOT_OK(generator_->CompilePredicateEvaluator(shapes_, &functions));
+    }
+
+    RETURN_NOT_OK(cache_->AddEntry(functions));
+    return Status::OK();
+  }
+
+  const vector<PredicateShape> shapes_;
+  CodeCache* const cache_;
+  CodeGenerator* const generator_;
+
+  DISALLOW_COPY_AND_ASSIGN(PredicateCompilationTask);
+};
+
 } // anonymous namespace
 
 CompilationManager::CompilationManager()
@@ -181,6 +228,27 @@ Status CompilationManager::StartInstrumentation(const scoped_refptr<MetricEntity
   return Status::OK();
 }
 
+void CompilationManager::SubmitUnlessPending(string key, std::function<void()> compile,
+                                             const char* submit_failure_msg) {
+  {
+    std::lock_guard<simple_spinlock> l(pending_lock_);
+    if (!pending_keys_.insert(key).second) {
+      // Already queued by a previous request.
+      return;
+    }
+  }
+  const auto s = pool_->Submit([this, key, compile]() {
+      compile();
+      std::lock_guard<simple_spinlock> l(pending_lock_);
+      pending_keys_.erase(key);
+    });
+  if (PREDICT_FALSE(!s.ok())) {
+    WARN_NOT_OK_EVERY_N_SECS(s, submit_failure_msg, 10);
+    std::lock_guard<simple_spinlock> l(pending_lock_);
+    pending_keys_.erase(key);
+  }
+}
+
 bool CompilationManager::RequestRowProjector(const Schema* base_schema,
                                              const Schema* projection,
                                              unique_ptr<RowProjector>* out) {
@@ -199,8 +267,8 @@ bool CompilationManager::RequestRowProjector(const Schema* base_schema,
   if (!cached) {
     shared_ptr<CompilationTask> task(make_shared<CompilationTask>(
         *base_schema, *projection, &cache_, &generator_));
-    WARN_NOT_OK_EVERY_N_SECS(pool_->Submit([task]() { task->Run(); }),
-                    "RowProjector compilation request submit failed", 10);
+    SubmitUnlessPending(key.ToString(), [task]() { task->Run(); },
+                        "RowProjector compilation request submit failed");
     return false;
   }
 
@@ -210,5 +278,34 @@ bool CompilationManager::RequestRowProjector(const Schema* base_schema,
   return true;
 }
 
+bool CompilationManager::RequestPredicateEvaluator(
+    const vector<ColumnIdxAndPredicate>& predicates,
+    unique_ptr<PredicateEvaluator>* out) {
+  vector<PredicateShape> shapes;
+  if (!PredicateEvaluatorFunctions::GetShapes(predicates, &shapes).ok() || shapes.empty()) {
+    return false;
+  }
+  faststring key;
+  PredicateEvaluatorFunctions::EncodeKey(shapes, &key);
+  ++query_counter_;
+
+  scoped_refptr<PredicateEvaluatorFunctions> cached(
+    down_cast<PredicateEvaluatorFunctions*>(cache_.Lookup(key).get()));
+
+  // If not cached, add a request to compilation pool
+  if (!cached) {
+    shared_ptr<PredicateCompilationTask> task(make_shared<PredicateCompilationTask>(
+        std::move(shapes), &cache_, &generator_));
+    SubmitUnlessPending(key.ToString(), [task]() { task->Run(); },
+                        "PredicateEvaluator compilation request submit failed");
+    return false;
+  }
+
+  ++hit_counter_;
+
+  out->reset(new PredicateEvaluator(predicates, cached));
+  return true;
+}
+
 } // namespace codegen
 } // namespace kudu
@@ -18,13 +18,19 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "kudu/codegen/code_generator.h"
 #include "kudu/codegen/code_cache.h"
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/singleton.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -76,6 +82,15 @@ class CompilationManager final {
                            const Schema* projection,
                            std::unique_ptr<RowProjector>* out);
 
+  // If a codegenned evaluator for predicates of the same shapes (see
+  // codegen::PredicateShape) is ready, then an evaluator of 'predicates' is
+  // written to 'out' and true is returned. Otherwise, unless generated code
+  // can't evaluate some of the predicates, this enqueues a compilation task
+  // for their shapes and returns false. Upon any failure, false is returned.
+  // Does not write to 'out' if false is returned.
+  bool RequestPredicateEvaluator(const std::vector<ColumnIdxAndPredicate>& predicates,
+                                 std::unique_ptr<PredicateEvaluator>* out);
+
   // Waits for all asynchronous compilation tasks to finish.
   void Wait();
 
@@ -92,10 +107,19 @@ class CompilationManager final {
 
   CompilationManager();
 
+  // Submits 'compile' to the thread pool, unless a task compiling the code
+  // with the same cache key is already queued or running.
+  void SubmitUnlessPending(std::string key, std::function<void()> compile,
+                           const char* submit_failure_msg);
+
   CodeGenerator generator_;
   CodeCache cache_;
   std::unique_ptr<ThreadPool> pool_;
 
+  // Cache keys of the code being compiled by queued or running tasks.
+  simple_spinlock pending_lock_;
+  std::unordered_set<std::string> pending_keys_;
+
   std::atomic<uint64_t> hit_counter_;
   std::atomic<uint64_t> query_counter_;
 
@@ -33,6 +33,7 @@
 #include <llvm/ADT/StringRef.h>
 #include <llvm/ADT/ilist_iterator.h>
 #include <llvm/ADT/iterator.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/MCJIT.h> // IWYU pragma: keep
 #include <llvm/IR/Attributes.h>
@@ -58,9 +59,11 @@
 #include <llvm/Transforms/IPO/AlwaysInliner.h>
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 
+#include "kudu/codegen/object_cache.h"
 #include "kudu/codegen/precompiled.ll.h"
 #include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/escaping.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/status.h"
 
@@ -317,8 +320,40 @@ vector<string> GetHostCPUAttrs() {
   return attrs;
 }
 
+// The llvm::ObjectCache of the compilation of a single module, backed by a
+// DiskObjectCache. The object of the module, if cached, is loaded before the
+// compilation, so that the module is only optimized if it isn't cached.
+class ModuleObjectCache : public llvm::ObjectCache {
+ public:
+  ModuleObjectCache(DiskObjectCache* cache, string id)
+      : cache_(cache),
+        id_(std::move(id)),
+        object_(cache_->Load(id_)) {
+  }
+
+  bool has_object() const { return object_ != nullptr; }
+
+  void notifyObjectCompiled(const Module* /*module*/, llvm::MemoryBufferRef object) override {
+    cache_->Store(id_, object);
+  }
+
+  unique_ptr<llvm::MemoryBuffer> getObject(const Module* /*module*/) override {
+    return std::move(object_);
+  }
+
+ private:
+  DiskObjectCache* const cache_;
+  const string id_;
+  unique_ptr<llvm::MemoryBuffer> object_;
+};
+
 } // anonymous namespace
 
+void ModuleBuilder::SetObjectCacheKey(const string& key) {
+  CHECK_EQ(state_, kBuilding);
+  object_cache_key_ = key;
+}
+
 Status ModuleBuilder::Compile(unique_ptr<ExecutionEngine>* out) {
   CHECK_EQ(state_, kBuilding);
 
@@ -344,11 +379,29 @@ Status ModuleBuilder::Compile(unique_ptr<ExecutionEngine>* out) {
   }
   module->setDataLayout(target_->createDataLayout());
 
-  DoOptimizations(module, GetFunctionNames());
+  unique_ptr<ModuleObjectCache> object_cache;
+  DiskObjectCache* disk_cache =
+      object_cache_key_.empty() ? nullptr : DiskObjectCache::GetSingleton();
+  if (disk_cache) {
+    string id;
+    b2a_hex(reinterpret_cast<const unsigned char*>(object_cache_key_.data()), &id,
+            object_cache_key_.size());
+    module->setModuleIdentifier(id);
+    object_cache.reset(new ModuleObjectCache(disk_cache, std::move(id)));
+    local_engine->setObjectCache(object_cache.get());
+  }
+
+  // A cached object was optimized before being compiled.
+  if (!object_cache || !object_cache->has_object()) {
+    DoOptimizations(module, GetFunctionNames());
+  }
   SetFunctionAttributes(module);
 
-  // Compile the module
+  // Compile the module, or load its cached object
   local_engine->finalizeObject();
+  if (object_cache) {
+    local_engine->setObjectCache(nullptr);
+  }
 
   // Satisfy the promises
   for (JITFuture& fut : futures_) {
@@ -112,6 +112,13 @@ class ModuleBuilder {
   // the code will be freed.
   Status Compile(std::unique_ptr<llvm::ExecutionEngine>* out);
 
+  // Has Compile() load the compiled object from the DiskObjectCache, if
+  // enabled, instead of optimizing and compiling the module when the cache
+  // has an object for a module with the same 'key', and add the object to
+  // the cache otherwise. The key must determine the code of the module, and
+  // the module must not refer to process memory (see GetPointerValue()).
+  void SetObjectCacheKey(const std::string& key);
+
   // Retrieves the TargetMachine that the engine builder guessed was
   // the native target. Requires compilation is complete.
   // Pointer is valid while Compile()'s ExecutionEngine is.
@@ -143,6 +150,9 @@ class ModuleBuilder {
   LLVMBuilder builder_;
   llvm::TargetMachine* target_; // not owned
 
+  // The key of the module in the DiskObjectCache, if it may be cached.
+  std::string object_cache_key_;
+
   DISALLOW_COPY_AND_ASSIGN(ModuleBuilder);
 };
 
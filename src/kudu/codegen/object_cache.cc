@@ -0,0 +1,217 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/codegen/object_cache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "kudu/codegen/precompiled.ll.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/strings/util.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/env.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/hash_util.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/path_util.h"
+#include "kudu/util/slice.h"
+
+DEFINE_string(codegen_object_cache_dir, "",
+              "Directory in which to persist the code compiled by code generation, "
+              "so that it is loaded rather than compiled again by later requests, "
+              "including after a restart. If empty, compiled code isn't persisted.");
+TAG_FLAG(codegen_object_cache_dir, experimental);
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace codegen {
+
+namespace {
+
+const char* const kObjectSuffix = ".o";
+
+string FormatHash(uint64_t hash) {
+  return StringPrintf("%016" PRIx64, hash);
+}
+
+// Returns the tag identifying what the compiled objects depend on besides
+// their modules: the precompiled IR, the version of LLVM, the host CPU and
+// its features, and the build type.
+string ComputeTag() {
+  string target(precompiled_ll_data, precompiled_ll_len);
+  target.append(LLVM_VERSION_STRING);
+  target.append(llvm::sys::getHostCPUName().str());
+  llvm::StringMap<bool> cpu_features;
+  llvm::sys::getHostCPUFeatures(cpu_features);
+  vector<string> attrs;
+  for (const auto& entry : cpu_features) {
+    attrs.emplace_back(Substitute("$0$1", entry.second ? "+" : "-", entry.first().str()));
+  }
+  std::sort(attrs.begin(), attrs.end());
+  for (const string& attr : attrs) {
+    target.append(attr);
+  }
+#ifdef NDEBUG
+  target.append("release");
+#else
+  target.append("debug");
+#endif
+  return FormatHash(HashUtil::FastHash64(target.data(), target.size(), 0));
+}
+
+} // anonymous namespace
+
+DiskObjectCache* DiskObjectCache::GetSingleton() {
+  static std::mutex lock;
+  // The caches are never deleted: an execution engine may still refer to the
+  // cache of a previous directory, which only changes in tests.
+  static DiskObjectCache* cache = nullptr;
+
+  std::lock_guard<std::mutex> l(lock);
+  if (FLAGS_codegen_object_cache_dir.empty()) {
+    return nullptr;
+  }
+  if (cache == nullptr || cache->dir() != FLAGS_codegen_object_cache_dir) {
+    unique_ptr<DiskObjectCache> new_cache(
+        new DiskObjectCache(Env::Default(), FLAGS_codegen_object_cache_dir));
+    Status s = new_cache->Init();
+    if (!s.ok()) {
+      KLOG_EVERY_N_SECS(WARNING, 60) << "Could not initialize codegen object cache: "
+                                     << s.ToString();
+      return nullptr;
+    }
+    cache = new_cache.release();
+  }
+  return cache;
+}
+
+DiskObjectCache::DiskObjectCache(Env* env, string dir)
+    : env_(env),
+      dir_(std::move(dir)),
+      tag_(ComputeTag()),
+      hits_(0),
+      misses_(0) {
+}
+
+DiskObjectCache::~DiskObjectCache() {}
+
+Status DiskObjectCache::Init() {
+  if (!env_->FileExists(dir_)) {
+    RETURN_NOT_OK_PREPEND(env_->CreateDir(dir_), "could not create directory");
+  }
+  vector<string> children;
+  RETURN_NOT_OK_PREPEND(env_->GetChildren(dir_, &children), "could not list directory");
+  for (const string& child : children) {
+    // Only touch the files looking like objects, "<tag>-<hash>.o".
+    if (!HasSuffixString(child, kObjectSuffix) || child.size() < tag_.size() + 1 ||
+        child[tag_.size()] != '-' || HasPrefixString(child, tag_)) {
+      continue;
+    }
+    WARN_NOT_OK(env_->DeleteFile(JoinPathSegments(dir_, child)),
+                "could not delete stale codegen object");
+  }
+  return Status::OK();
+}
+
+string DiskObjectCache::ObjectPath(const string& id) const {
+  return JoinPathSegments(
+      dir_, Substitute("$0-$1$2", tag_, FormatHash(HashUtil::FastHash64(id.data(), id.size(), 0)),
+                       kObjectSuffix));
+}
+
+unique_ptr<llvm::MemoryBuffer> DiskObjectCache::Load(const string& id) {
+  const string path = ObjectPath(id);
+  faststring contents;
+  Status s = ReadFileToString(env_, path, &contents);
+  if (!s.ok()) {
+    if (!s.IsNotFound()) {
+      WARN_NOT_OK(s, "could not read codegen object");
+    }
+    ++misses_;
+    return nullptr;
+  }
+
+  // Check the file is for the same module, in case of a hash collision.
+  if (contents.size() < sizeof(uint32_t) ||
+      contents.size() - sizeof(uint32_t) < DecodeFixed32(contents.data()) ||
+      Slice(contents.data() + sizeof(uint32_t), DecodeFixed32(contents.data())) != Slice(id)) {
+    ++misses_;
+    return nullptr;
+  }
+  const size_t header_size = sizeof(uint32_t) + id.size();
+  unique_ptr<llvm::MemoryBuffer> object(llvm::MemoryBuffer::getMemBufferCopy(
+      llvm::StringRef(reinterpret_cast<const char*>(contents.data()) + header_size,
+                      contents.size() - header_size),
+      path));
+
+  // Don't hand a truncated or otherwise corrupt object to the JIT.
+  auto object_file = llvm::object::ObjectFile::createObjectFile(object->getMemBufferRef());
+  if (!object_file) {
+    llvm::consumeError(object_file.takeError());
+    LOG(WARNING) << "Invalid codegen object " << path;
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return object;
+}
+
+void DiskObjectCache::Store(const string& id, const llvm::MemoryBufferRef& object) {
+  faststring contents;
+  PutFixed32(&contents, id.size());
+  contents.append(id);
+  contents.append(object.getBufferStart(), object.getBufferSize());
+
+  // Write the object to a temporary file first, so that it is either fully
+  // written or absent.
+  const string path = ObjectPath(id);
+  const string tmp_path = path + kTmpInfix;
+  Status s = WriteStringToFileSync(env_, Slice(contents), tmp_path);
+  if (s.ok()) {
+    s = env_->RenameFile(tmp_path, path);
+  }
+  if (!s.ok()) {
+    WARN_NOT_OK(s, "could not persist codegen object");
+    if (env_->FileExists(tmp_path)) {
+      WARN_NOT_OK(env_->DeleteFile(tmp_path), "could not delete temporary codegen object");
+    }
+  }
+}
+
+} // namespace codegen
+} // namespace kudu
@@ -0,0 +1,98 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class MemoryBuffer;
+class MemoryBufferRef;
+} // namespace llvm
+
+namespace kudu {
+
+class Env;
+
+namespace codegen {
+
+// A DiskObjectCache persists the objects compiled for code-generated modules
+// to files in a directory, so that a module built again, possibly by a later
+// run of the process, can load the object instead of being optimized and
+// compiled again.
+//
+// Modules are identified by a string which must determine their code: since
+// the objects outlive the process, the code of cached modules must not refer
+// to process memory, e.g. by embedding pointers as constants. The objects also
+// depend on the precompiled IR, the version of LLVM and the host CPU: the
+// files are named after a tag for those, and the files with another tag are
+// deleted when the cache is initialized.
+//
+// Each file consists of:
+//   identifier length (32-bit)
+//   identifier
+//   object
+//
+// Class is thread safe.
+class DiskObjectCache {
+ public:
+  // Returns the cache in --codegen_object_cache_dir, or nullptr if the flag
+  // is empty or the cache can't be initialized.
+  static DiskObjectCache* GetSingleton();
+
+  DiskObjectCache(Env* env, std::string dir);
+  ~DiskObjectCache();
+
+  // Creates the directory if it doesn't exist, and deletes the objects
+  // compiled for another tag.
+  Status Init();
+
+  // Returns the object compiled for the module 'id', or nullptr if there
+  // isn't a valid one.
+  std::unique_ptr<llvm::MemoryBuffer> Load(const std::string& id);
+
+  // Persists 'object', compiled for the module 'id'. Failures are logged.
+  void Store(const std::string& id, const llvm::MemoryBufferRef& object);
+
+  const std::string& dir() const { return dir_; }
+
+  // Number of calls to Load() which returned an object, and which didn't.
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+
+ private:
+  std::string ObjectPath(const std::string& id) const;
+
+  Env* const env_;
+  const std::string dir_;
+
+  // Identifies the precompiled IR, the version of LLVM and the host CPU.
+  const std::string tag_;
+
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(DiskObjectCache);
+};
+
+} // namespace codegen
+} // namespace kudu
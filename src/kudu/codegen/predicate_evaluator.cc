@@ -0,0 +1,497 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/codegen/predicate_evaluator.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags_declare.h>
+#include <glog/logging.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/IR/Argument.h>
+#include <llvm/IR/Attributes.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/Value.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "kudu/codegen/module_builder.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/faststring.h"
+
+namespace llvm {
+class LLVMContext;
+} // namespace llvm
+
+using llvm::Argument;
+using llvm::BasicBlock;
+using llvm::Function;
+using llvm::FunctionType;
+using llvm::LLVMContext;
+using llvm::PHINode;
+using llvm::PointerType;
+using llvm::Type;
+using llvm::Value;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+DECLARE_bool(codegen_dump_functions);
+
+namespace kudu {
+namespace codegen {
+
+namespace {
+
+// Returns the LLVM type of the cells of a column with the physical type
+// 'type', or nullptr if the generated code doesn't support the type.
+Type* GetCellType(LLVMContext& context, DataType type) {
+  switch (type) {
+    case BOOL:
+    case INT8:
+    case UINT8:
+      return Type::getInt8Ty(context);
+    case INT16:
+    case UINT16:
+      return Type::getInt16Ty(context);
+    case INT32:
+    case UINT32:
+      return Type::getInt32Ty(context);
+    case INT64:
+    case UINT64:
+      return Type::getInt64Ty(context);
+    case FLOAT:
+      return Type::getFloatTy(context);
+    case DOUBLE:
+      return Type::getDoubleTy(context);
+    default:
+      return nullptr;
+  }
+}
+
+bool IsSupportedType(DataType type) {
+  switch (type) {
+    case BOOL:
+    case INT8:
+    case UINT8:
+    case INT16:
+    case UINT16:
+    case INT32:
+    case UINT32:
+    case INT64:
+    case UINT64:
+    case FLOAT:
+    case DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsUnsignedType(DataType type) {
+  return type == BOOL || type == UINT8 || type == UINT16 ||
+      type == UINT32 || type == UINT64;
+}
+
+// The values of a predicate loaded in the entry block of the function.
+struct PredicateValues {
+  // The data of the column, as a pointer to its cells.
+  Value* data;
+  // i8*: the non-null bitmap of the column, if it is nullable.
+  Value* non_null_bitmap;
+  // The bounds of the predicate, as cells.
+  Value* lower;
+  Value* upper;
+};
+
+// Emits the code evaluating the conjunction for a single row, where
+// 'row' = 8 * 'byte_idx' + 'bit_idx'. Returns the i1 result.
+//
+// The comparisons follow DataTypeTraits<>::Compare(): for floating point
+// types, a NaN compares equal to everything, so the lower bound and equality
+// comparisons are unordered while the upper bound comparison is ordered.
+Value* EmitRowPass(ModuleBuilder::LLVMBuilder* builder,
+                   const vector<PredicateShape>& shapes,
+                   const vector<PredicateValues>& values,
+                   Value* row, Value* byte_idx, Value* bit_idx) {
+  LLVMContext& context = builder->getContext();
+  Type* i8 = Type::getInt8Ty(context);
+  Value* pass = builder->getTrue();
+  for (size_t k = 0; k < shapes.size(); k++) {
+    const PredicateShape& shape = shapes[k];
+    const PredicateValues& vals = values[k];
+
+    Value* non_null = nullptr;
+    if (shape.nullable) {
+      Value* bitmap_byte = builder->CreateLoad(
+          i8, builder->CreateInBoundsGEP(i8, vals.non_null_bitmap, byte_idx));
+      Value* bit = builder->CreateAnd(builder->CreateLShr(bitmap_byte, bit_idx),
+                                      builder->getInt8(1));
+      non_null = builder->CreateICmpNE(bit, builder->getInt8(0));
+    }
+
+    Value* result = nullptr;
+    switch (shape.predicate_type) {
+      case PredicateType::IsNotNull:
+        result = non_null;
+        break;
+      case PredicateType::IsNull:
+        result = non_null ? builder->CreateNot(non_null) : builder->getFalse();
+        break;
+      case PredicateType::Range:
+      case PredicateType::Equality: {
+        Type* cell_type = GetCellType(context, shape.physical_type);
+        Value* cell = builder->CreateLoad(
+            cell_type, builder->CreateInBoundsGEP(cell_type, vals.data, row));
+        const bool is_float = cell_type->isFloatingPointTy();
+        const bool is_unsigned = IsUnsignedType(shape.physical_type);
+        if (shape.predicate_type == PredicateType::Equality) {
+          result = is_float ? builder->CreateFCmpUEQ(cell, vals.lower)
+                            : builder->CreateICmpEQ(cell, vals.lower);
+        } else {
+          if (shape.has_lower) {
+            result = is_float ? builder->CreateFCmpUGE(cell, vals.lower)
+                  : is_unsigned ? builder->CreateICmpUGE(cell, vals.lower)
+                                : builder->CreateICmpSGE(cell, vals.lower);
+          }
+          if (shape.has_upper) {
+            Value* upper = is_float ? builder->CreateFCmpOLT(cell, vals.upper)
+                         : is_unsigned ? builder->CreateICmpULT(cell, vals.upper)
+                                       : builder->CreateICmpSLT(cell, vals.upper);
+            result = result ? builder->CreateAnd(result, upper) : upper;
+          }
+        }
+        // A null cell never matches a comparison.
+        if (non_null) {
+          result = builder->CreateAnd(result, non_null);
+        }
+        break;
+      }
+      default:
+        LOG(FATAL) << "unsupported predicate type";
+    }
+    if (result) {
+      pass = builder->CreateAnd(pass, result);
+    }
+  }
+  return pass;
+}
+
+// Generates a function evaluating the conjunction of predicates of the given
+// shapes, of the form PredicateEvaluatorFunctions::EvaluateFunction.
+//
+// The generated code is like ApplyPredicatePrimitive() in column_predicate.cc
+// with all the predicates evaluated in the same pass over the rows:
+//
+// define void @name(i8** noalias %col_data, i8** noalias %bitmaps,
+//                   i8** noalias %bounds, i64 %nrows, i8* noalias %sel)
+// entry:
+//   <for each predicate k, load col_data[k], bitmaps[k] if the column is
+//    nullable and the cells pointed to by bounds[2k] and bounds[2k + 1]
+//    if the predicate has them>
+//   %nbytes = lshr i64 %nrows, 3
+//   br (%nbytes == 0), label %tail_check, label %byte_loop
+// byte_loop:
+//   %byte_idx = phi i64 [0, %entry], [%next_byte_idx, %byte_loop]
+//   <for each j in 0..7, computed at JIT time>
+//     %pass = <conjunction for row 8 * %byte_idx + j>
+//     %res = or i8 %res, (zext %pass) << j
+//   %sel[%byte_idx] &= %res
+//   %next_byte_idx = add i64 %byte_idx, 1
+//   br (%next_byte_idx < %nbytes), label %byte_loop, label %tail_check
+// tail_check:
+//   br (%nbytes * 8 < %nrows), label %tail_loop, label %exit
+// tail_loop:
+//   <the remaining rows, one at a time>
+// exit:
+//   ret void
+Function* MakeEvaluate(const string& name,
+                       ModuleBuilder* mbuilder,
+                       const vector<PredicateShape>& shapes) {
+  ModuleBuilder::LLVMBuilder* builder = mbuilder->builder();
+  LLVMContext& context = builder->getContext();
+  Type* i8 = Type::getInt8Ty(context);
+  Type* i64 = Type::getInt64Ty(context);
+  Type* i8_ptr = Type::getInt8PtrTy(context);
+  Type* i8_ptr_ptr = PointerType::getUnqual(i8_ptr);
+
+  vector<Type*> argtypes = { i8_ptr_ptr, i8_ptr_ptr, i8_ptr_ptr, i64, i8_ptr };
+  FunctionType* fty = FunctionType::get(Type::getVoidTy(context), argtypes, false);
+  Function* f = mbuilder->Create(fty, name);
+
+  Function::arg_iterator it = f->arg_begin();
+  Argument* col_data = &*it++;
+  Argument* bitmaps = &*it++;
+  Argument* bounds = &*it++;
+  Argument* nrows = &*it++;
+  Argument* sel = &*it++;
+  DCHECK(it == f->arg_end());
+
+  col_data->setName("col_data");
+  bitmaps->setName("bitmaps");
+  bounds->setName("bounds");
+  nrows->setName("nrows");
+  sel->setName("sel");
+
+  // The selection vector is the only memory written to: marking it as not
+  // aliasing lets the column data and the bounds be loaded once.
+  f->addParamAttr(0, llvm::Attribute::NoAlias);
+  f->addParamAttr(1, llvm::Attribute::NoAlias);
+  f->addParamAttr(2, llvm::Attribute::NoAlias);
+  f->addParamAttr(4, llvm::Attribute::NoAlias);
+
+  BasicBlock* entry = BasicBlock::Create(context, "entry", f);
+  BasicBlock* byte_loop = BasicBlock::Create(context, "byte_loop", f);
+  BasicBlock* tail_check = BasicBlock::Create(context, "tail_check", f);
+  BasicBlock* tail_loop = BasicBlock::Create(context, "tail_loop", f);
+  BasicBlock* exit = BasicBlock::Create(context, "exit", f);
+
+  // Hoist the loads of the pointers and of the bounds out of the loops.
+  builder->SetInsertPoint(entry);
+  vector<PredicateValues> values(shapes.size());
+  for (size_t k = 0; k < shapes.size(); k++) {
+    const PredicateShape& shape = shapes[k];
+    PredicateValues& vals = values[k];
+    if (shape.nullable) {
+      vals.non_null_bitmap = builder->CreateLoad(
+          i8_ptr, builder->CreateConstInBoundsGEP1_64(i8_ptr, bitmaps, k),
+          Substitute("bitmap$0", k));
+    }
+    if (shape.predicate_type != PredicateType::Range &&
+        shape.predicate_type != PredicateType::Equality) {
+      continue;
+    }
+    Type* cell_type = GetCellType(context, shape.physical_type);
+    Type* cell_ptr_type = PointerType::getUnqual(cell_type);
+    Value* data = builder->CreateLoad(
+        i8_ptr, builder->CreateConstInBoundsGEP1_64(i8_ptr, col_data, k));
+    vals.data = builder->CreateBitCast(data, cell_ptr_type, Substitute("data$0", k));
+    auto load_bound = [&](size_t idx, const string& bound_name) {
+      Value* bound = builder->CreateLoad(
+          i8_ptr, builder->CreateConstInBoundsGEP1_64(i8_ptr, bounds, idx));
+      return builder->CreateLoad(cell_type, builder->CreateBitCast(bound, cell_ptr_type),
+                                 bound_name);
+    };
+    if (shape.predicate_type == PredicateType::Equality || shape.has_lower) {
+      vals.lower = load_bound(2 * k, Substitute("lower$0", k));
+    }
+    if (shape.predicate_type == PredicateType::Range && shape.has_upper) {
+      vals.upper = load_bound(2 * k + 1, Substitute("upper$0", k));
+    }
+  }
+  Value* nbytes = builder->CreateLShr(nrows, 3, "nbytes");
+  builder->CreateCondBr(builder->CreateICmpEQ(nbytes, builder->getInt64(0)),
+                        tail_check, byte_loop);
+
+  // Evaluate 8 rows at a time, one bit of the selection vector each.
+  builder->SetInsertPoint(byte_loop);
+  PHINode* byte_idx = builder->CreatePHI(i64, 2, "byte_idx");
+  byte_idx->addIncoming(builder->getInt64(0), entry);
+  Value* first_row = builder->CreateShl(byte_idx, 3, "first_row");
+  Value* res = builder->getInt8(0);
+  for (int j = 0; j < 8; j++) {
+    Value* row = builder->CreateOr(first_row, builder->getInt64(j));
+    Value* pass = EmitRowPass(builder, shapes, values, row, byte_idx, builder->getInt8(j));
+    res = builder->CreateOr(res, builder->CreateShl(builder->CreateZExt(pass, i8), j));
+  }
+  Value* sel_ptr = builder->CreateInBoundsGEP(i8, sel, byte_idx);
+  builder->CreateStore(builder->CreateAnd(builder->CreateLoad(i8, sel_ptr), res), sel_ptr);
+  Value* next_byte_idx = builder->CreateAdd(byte_idx, builder->getInt64(1), "next_byte_idx");
+  byte_idx->addIncoming(next_byte_idx, byte_loop);
+  builder->CreateCondBr(builder->CreateICmpULT(next_byte_idx, nbytes), byte_loop, tail_check);
+
+  // Evaluate the rows which don't fill a byte of the selection vector.
+  builder->SetInsertPoint(tail_check);
+  Value* tail_start = builder->CreateShl(nbytes, 3, "tail_start");
+  builder->CreateCondBr(builder->CreateICmpULT(tail_start, nrows), tail_loop, exit);
+
+  builder->SetInsertPoint(tail_loop);
+  PHINode* row = builder->CreatePHI(i64, 2, "row");
+  row->addIncoming(tail_start, tail_check);
+  Value* row_byte_idx = builder->CreateLShr(row, 3);
+  Value* row_bit_idx = builder->CreateTrunc(builder->CreateAnd(row, 7), i8);
+  Value* pass = EmitRowPass(builder, shapes, values, row, row_byte_idx, row_bit_idx);
+  Value* cleared = builder->CreateNot(builder->CreateShl(builder->getInt8(1), row_bit_idx));
+  Value* mask = builder->CreateSelect(pass, builder->getInt8(0xff), cleared);
+  Value* row_sel_ptr = builder->CreateInBoundsGEP(i8, sel, row_byte_idx);
+  builder->CreateStore(builder->CreateAnd(builder->CreateLoad(i8, row_sel_ptr), mask),
+                       row_sel_ptr);
+  Value* next_row = builder->CreateAdd(row, builder->getInt64(1), "next_row");
+  row->addIncoming(next_row, tail_loop);
+  builder->CreateCondBr(builder->CreateICmpULT(next_row, nrows), tail_loop, exit);
+
+  builder->SetInsertPoint(exit);
+  builder->CreateRetVoid();
+
+  if (FLAGS_codegen_dump_functions) {
+    LOG(INFO) << "Dumping predicate evaluation:";
+    f->print(llvm::errs(), nullptr);
+  }
+
+  return f;
+}
+
+// Convenience method which appends to a faststring
+template<typename T>
+void AddNext(faststring* fs, const T& val) {
+  fs->append(&val, sizeof(T));
+}
+
+} // anonymous namespace
+
+PredicateEvaluatorFunctions::PredicateEvaluatorFunctions(vector<PredicateShape> shapes,
+                                                         EvaluateFunction evaluate_f,
+                                                         unique_ptr<JITCodeOwner> owner)
+  : JITWrapper(std::move(owner)),
+    shapes_(std::move(shapes)),
+    evaluate_f_(evaluate_f) {
+  CHECK(evaluate_f != nullptr)
+    << "Promise to compile evaluate function not fulfilled by ModuleBuilder";
+}
+
+Status PredicateEvaluatorFunctions::Create(const vector<PredicateShape>& shapes,
+                                           scoped_refptr<PredicateEvaluatorFunctions>* out,
+                                           llvm::TargetMachine** tm) {
+  if (shapes.empty()) {
+    return Status::InvalidArgument("no predicates to evaluate");
+  }
+  for (const PredicateShape& shape : shapes) {
+    if (!IsSupportedType(shape.physical_type)) {
+      return Status::NotSupported("unsupported physical type",
+                                  GetTypeInfo(shape.physical_type)->name());
+    }
+  }
+
+  ModuleBuilder builder;
+  RETURN_NOT_OK(builder.Init());
+  faststring key;
+  EncodeKey(shapes, &key);
+  builder.SetObjectCacheKey(key.ToString());
+
+  Function* evaluate = MakeEvaluate("PredEval", &builder, shapes);
+
+  EvaluateFunction evaluate_f;
+  builder.AddJITPromise(evaluate, &evaluate_f);
+
+  unique_ptr<JITCodeOwner> owner;
+  RETURN_NOT_OK(builder.Compile(&owner));
+
+  if (tm) {
+    *tm = builder.GetTargetMachine();
+  }
+  out->reset(new PredicateEvaluatorFunctions(shapes, evaluate_f, std::move(owner)));
+  return Status::OK();
+}
+
+Status PredicateEvaluatorFunctions::GetShapes(const vector<ColumnIdxAndPredicate>& predicates,
+                                              vector<PredicateShape>* shapes) {
+  vector<PredicateShape> result;
+  result.reserve(predicates.size());
+  for (const auto& col_idx_and_pred : predicates) {
+    const ColumnPredicate& pred = col_idx_and_pred.second;
+    const ColumnSchema& col = pred.column();
+    const DataType physical_type = col.type_info()->physical_type();
+    if (!IsSupportedType(physical_type)) {
+      return Status::NotSupported("unsupported column type", pred.ToString());
+    }
+    switch (pred.predicate_type()) {
+      case PredicateType::Range:
+      case PredicateType::Equality:
+      case PredicateType::IsNull:
+      case PredicateType::IsNotNull:
+        break;
+      default:
+        return Status::NotSupported("unsupported predicate type", pred.ToString());
+    }
+    const bool is_range = pred.predicate_type() == PredicateType::Range;
+    result.push_back({ physical_type,
+                       col.is_nullable(),
+                       pred.predicate_type(),
+                       is_range && pred.raw_lower() != nullptr,
+                       is_range && pred.raw_upper() != nullptr });
+  }
+  *shapes = std::move(result);
+  return Status::OK();
+}
+
+// Generates a key for the shapes of a conjunction of predicates, encoded as
+// follows, in sequence.
+//
+// (4 bytes) unique type identifier for PredicateEvaluatorFunctions
+// (8 bytes) number, as unsigned long, of predicates
+// (8 bytes each) predicate shapes, in order
+//   4 bytes for the physical type
+//   1 byte for nullability
+//   1 byte for the predicate type
+//   1 byte each for whether a range has a lower and an upper bound
+//
+// Writes to 'out'.
+void PredicateEvaluatorFunctions::EncodeKey(const vector<PredicateShape>& shapes,
+                                            faststring* out) {
+  AddNext(out, JITWrapper::PREDICATE_EVALUATOR);
+  AddNext(out, shapes.size());
+  for (const PredicateShape& shape : shapes) {
+    AddNext(out, shape.physical_type);
+    AddNext(out, shape.nullable);
+    AddNext(out, static_cast<uint8_t>(shape.predicate_type));
+    AddNext(out, shape.has_lower);
+    AddNext(out, shape.has_upper);
+  }
+}
+
+PredicateEvaluator::PredicateEvaluator(vector<ColumnIdxAndPredicate> predicates,
+                                       scoped_refptr<PredicateEvaluatorFunctions> functions)
+  : predicates_(std::move(predicates)),
+    functions_(std::move(functions)),
+    col_data_(predicates_.size()),
+    non_null_bitmaps_(predicates_.size()) {
+  DCHECK_EQ(predicates_.size(), functions_->shapes().size());
+  bounds_.reserve(2 * predicates_.size());
+  for (const auto& col_idx_and_pred : predicates_) {
+    const ColumnPredicate& pred = col_idx_and_pred.second;
+    bounds_.push_back(pred.raw_lower());
+    bounds_.push_back(pred.raw_upper());
+  }
+}
+
+void PredicateEvaluator::Evaluate(RowBlock* block) {
+  for (size_t k = 0; k < predicates_.size(); k++) {
+    const ColumnBlock cblock = block->column_block(predicates_[k].first);
+    DCHECK(cblock.type_info()->physical_type() == functions_->shapes()[k].physical_type);
+    DCHECK_EQ(cblock.is_nullable(), functions_->shapes()[k].nullable);
+    col_data_[k] = cblock.data();
+    non_null_bitmaps_[k] = cblock.non_null_bitmap();
+  }
+  functions_->evaluate()(col_data_.data(), non_null_bitmaps_.data(), bounds_.data(),
+                         block->nrows(),
+                         block->selection_vector()->mutable_bitmap());
+}
+
+} // namespace codegen
+} // namespace kudu
@@ -0,0 +1,146 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "kudu/codegen/jit_wrapper.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class TargetMachine;
+} // namespace llvm
+
+namespace kudu {
+
+class faststring;
+class RowBlock;
+
+namespace codegen {
+
+// What the generated code for a column predicate depends on. The values the
+// predicate compares against aren't part of it: they are passed to the
+// generated function, so that predicates of the same shape share their code.
+struct PredicateShape {
+  DataType physical_type;
+  bool nullable;
+  PredicateType predicate_type;
+  bool has_lower;
+  bool has_upper;
+
+  bool operator==(const PredicateShape& other) const {
+    return physical_type == other.physical_type &&
+        nullable == other.nullable &&
+        predicate_type == other.predicate_type &&
+        has_lower == other.has_lower &&
+        has_upper == other.has_upper;
+  }
+};
+
+// A column index in a projection and a predicate over that column.
+typedef std::pair<int32_t, ColumnPredicate> ColumnIdxAndPredicate;
+
+// The JITWrapper for codegen::PredicateEvaluator functions. Contains the
+// compiled function evaluating a conjunction of predicates of the given
+// shapes, in order.
+class PredicateEvaluatorFunctions : public JITWrapper {
+ public:
+  // Evaluates the conjunction over 'nrows' rows, clearing the bits of
+  // 'sel_bitmap' for the rows which don't match. For the predicate with index
+  // k, 'col_data[k]' and 'non_null_bitmaps[k]' are the data and the non-null
+  // bitmap of its column, and 'bounds[2k]' and 'bounds[2k + 1]' its lower and
+  // upper bounds.
+  typedef void(*EvaluateFunction)(const uint8_t* const* col_data,
+                                  const uint8_t* const* non_null_bitmaps,
+                                  const void* const* bounds,
+                                  uint64_t nrows,
+                                  uint8_t* sel_bitmap);
+
+  // Compiles the function for predicates of the given shapes.
+  // Writes the llvm::TargetMachine* used to 'tm' (if not NULL)
+  // and the functions to 'out' upon success.
+  static Status Create(const std::vector<PredicateShape>& shapes,
+                       scoped_refptr<PredicateEvaluatorFunctions>* out,
+                       llvm::TargetMachine** tm = nullptr);
+
+  // Writes the shapes of the predicates to 'shapes'. Returns NotSupported if
+  // generated code can't evaluate one of them: only the equality, range and
+  // null predicates over fixed-size integer, floating point and boolean
+  // columns are supported.
+  static Status GetShapes(const std::vector<ColumnIdxAndPredicate>& predicates,
+                          std::vector<PredicateShape>* shapes);
+
+  const std::vector<PredicateShape>& shapes() const { return shapes_; }
+
+  EvaluateFunction evaluate() const { return evaluate_f_; }
+
+  Status EncodeOwnKey(faststring* out) override {
+    EncodeKey(shapes_, out);
+    return Status::OK();
+  }
+
+  static void EncodeKey(const std::vector<PredicateShape>& shapes, faststring* out);
+
+ private:
+  PredicateEvaluatorFunctions(std::vector<PredicateShape> shapes,
+                              EvaluateFunction evaluate_f,
+                              std::unique_ptr<JITCodeOwner> owner);
+
+  const std::vector<PredicateShape> shapes_;
+  const EvaluateFunction evaluate_f_;
+};
+
+// Evaluates a conjunction of column predicates over the rows of RowBlocks in
+// a single pass, with code generated for the shapes of the predicates. This
+// gives the same results as calling ColumnPredicate::Evaluate() for each
+// predicate in turn.
+class PredicateEvaluator {
+ public:
+  // Requires that the predicates have the shapes used to create 'functions',
+  // and that their values remain valid for the lifetime of this object.
+  PredicateEvaluator(std::vector<ColumnIdxAndPredicate> predicates,
+                     scoped_refptr<PredicateEvaluatorFunctions> functions);
+
+  // Clears the bits of the selection vector of 'block' for the rows which
+  // don't match all the predicates. Not thread-safe.
+  void Evaluate(RowBlock* block);
+
+  const std::vector<ColumnIdxAndPredicate>& predicates() const { return predicates_; }
+
+ private:
+  const std::vector<ColumnIdxAndPredicate> predicates_;
+  const scoped_refptr<PredicateEvaluatorFunctions> functions_;
+
+  // The bounds of the predicates, as passed to the generated function.
+  std::vector<const void*> bounds_;
+
+  // Scratch space for the column data and non-null bitmaps of each block.
+  std::vector<const uint8_t*> col_data_;
+  std::vector<const uint8_t*> non_null_bitmaps_;
+
+  DISALLOW_COPY_AND_ASSIGN(PredicateEvaluator);
+};
+
+} // namespace codegen
+} // namespace kudu
@@ -45,6 +45,7 @@
 #include "kudu/common/types.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/strcat.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/status.h"
 
 namespace llvm {
@@ -69,9 +70,6 @@ using std::vector;
 DECLARE_bool(codegen_dump_functions);
 
 namespace kudu {
-
-class faststring;
-
 namespace codegen {
 
 namespace {
@@ -281,6 +279,14 @@ Status RowProjectorFunctions::Create(const Schema& base_schema,
   kudu::RowProjector no_codegen(&base_schema, &projection);
   RETURN_NOT_OK(no_codegen.Init());
 
+  // The code of projections with defaults embeds pointers to the default
+  // values, so it can't outlive the process.
+  if (no_codegen.projection_defaults().empty()) {
+    faststring key;
+    RETURN_NOT_OK(EncodeKey(base_schema, projection, &key));
+    builder.SetObjectCacheKey(key.ToString());
+  }
+
   // Build the functions for code gen. No need to mangle for uniqueness;
   // in the rare case we have two projectors in one module, LLVM takes
   // care of uniquifying when making a GlobalValue.
@@ -39,6 +39,7 @@
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/walltime.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/block_bloom_filter.h"
 #include "kudu/util/hash.pb.h"
 #include "kudu/util/hash_util.h"
@@ -50,6 +51,8 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(disable_column_predicate_avx2);
+
 using std::vector;
 
 namespace kudu {
@@ -1303,6 +1306,61 @@ TEST_F(TestColumnPredicate, TestInList) {
   }
 }
 
+TEST_F(TestColumnPredicate, TestMayMatchRange) {
+  ColumnSchema column("c", INT32);
+  int32_t zero = 0;
+  int32_t five = 5;
+  int32_t ten = 10;
+  int32_t twenty = 20;
+  int32_t thirty = 30;
+
+  // The range of values of the block in question is [10, 20].
+  const auto may_match = [&](const ColumnPredicate& pred) {
+    return pred.MayMatchRange(&ten, &twenty);
+  };
+
+  EXPECT_FALSE(may_match(ColumnPredicate::None(column)));
+  EXPECT_FALSE(may_match(ColumnPredicate::IsNull(column)));
+  EXPECT_TRUE(may_match(ColumnPredicate::IsNotNull(column)));
+
+  EXPECT_FALSE(may_match(ColumnPredicate::Equality(column, &five)));
+  EXPECT_TRUE(may_match(ColumnPredicate::Equality(column, &ten)));
+  EXPECT_TRUE(may_match(ColumnPredicate::Equality(column, &twenty)));
+  EXPECT_FALSE(may_match(ColumnPredicate::Equality(column, &thirty)));
+
+  // Upper bounds are exclusive.
+  EXPECT_FALSE(may_match(ColumnPredicate::Range(column, &zero, &ten)));
+  EXPECT_TRUE(may_match(ColumnPredicate::Range(column, &five, &twenty)));
+  EXPECT_TRUE(may_match(ColumnPredicate::Range(column, &twenty, &thirty)));
+  EXPECT_TRUE(may_match(ColumnPredicate::Range(column, &zero, nullptr)));
+  EXPECT_FALSE(may_match(ColumnPredicate::Range(column, nullptr, &five)));
+  EXPECT_FALSE(may_match(ColumnPredicate::Range(column, &thirty, nullptr)));
+
+  vector<const void*> values = { &zero, &five, &thirty };
+  EXPECT_FALSE(may_match(ColumnPredicate::InList(column, &values)));
+  values = { &zero, &twenty, &thirty };
+  EXPECT_TRUE(may_match(ColumnPredicate::InList(column, &values)));
+
+  // The values of the narrow ranges are probed against the bloom filters.
+  Arena arena(1024);
+  ArenaBlockBloomFilterBufferAllocator allocator(&arena);
+  BlockBloomFilter bf(&allocator);
+  ASSERT_OK(bf.Init(BlockBloomFilter::MinLogSpace(100, 0.0001), FAST_HASH, 0));
+  int32_t fifteen = 15;
+  bf.Insert(HashUtil::ComputeHash32(
+      Slice(reinterpret_cast<const uint8_t*>(&fifteen), sizeof(fifteen)), FAST_HASH, 0));
+  const vector<BlockBloomFilter*> filters = { &bf };
+  EXPECT_TRUE(may_match(ColumnPredicate::InBloomFilter(column, filters, nullptr, nullptr)));
+  EXPECT_FALSE(may_match(ColumnPredicate::InBloomFilter(column, filters, &twenty, nullptr)));
+  int32_t thousand = 1000;
+  int32_t thousand_ten = 1010;
+  EXPECT_FALSE(ColumnPredicate::InBloomFilter(column, filters, nullptr, nullptr)
+                   .MayMatchRange(&thousand, &thousand_ten));
+  // The wide ranges aren't.
+  EXPECT_TRUE(ColumnPredicate::InBloomFilter(column, filters, nullptr, nullptr)
+                  .MayMatchRange(&zero, &thousand_ten));
+}
+
 // Test that column predicate comparison works correctly: ordered by predicate
 // type first, then size of the column type.
 TEST_F(TestColumnPredicate, TestSelectivity) {
@@ -1468,6 +1526,93 @@ TEST_F(TestColumnPredicate, TestEquals) {
   ASSERT_NE(ColumnPredicate::None(c1), ColumnPredicate::None(c1dflt));
 }
 
+// Evaluates random Range, Equality and InList predicates over a random block of
+// 'PhysicalType' cells, and checks that the result is the same whether or not
+// the AVX2 kernels are enabled.
+template <DataType PhysicalType>
+void TestVectorizedEvaluation(Random* rand) {
+  using cpp_type = typename DataTypeTraits<PhysicalType>::cpp_type;
+  // Mostly pick from a small number of values to get matches, but also include
+  // values with the sign bit set to exercise the unsigned comparisons.
+  const auto random_value = [&] () {
+    auto v = static_cast<cpp_type>(rand->OneIn(4) ? rand->Next64() : rand->Uniform(8));
+    if constexpr (sizeof(cpp_type) == 16) {
+      // Also vary the high half of 128-bit cells, including its sign bit, so
+      // that cells with equal high halves are compared by their low halves.
+      if (rand->OneIn(2)) {
+        const auto hi = static_cast<int64_t>(rand->Uniform(4)) - 2;
+        v = static_cast<cpp_type>((static_cast<uint128_t>(hi) << 64) |
+                                  static_cast<uint64_t>(v));
+      }
+    }
+    return v;
+  };
+
+  // Use a number of rows which isn't a multiple of 8 so the remainder of the
+  // block gets evaluated too.
+  constexpr int kNumRows = 1021;
+  for (bool nullable : {false, true}) {
+    ColumnSchema cs("c", PhysicalType, nullable);
+    ScopedColumnBlock<PhysicalType> b(kNumRows, nullable);
+    for (int i = 0; i < kNumRows; i++) {
+      b[i] = random_value();
+      if (nullable) {
+        b.SetCellIsNull(i, rand->OneIn(10));
+      }
+    }
+
+    for (int iter = 0; iter < 100; iter++) {
+      const cpp_type lower = random_value();
+      const cpp_type upper = random_value();
+      vector<cpp_type> in_values(1 + rand->Uniform(20));
+      for (auto& v : in_values) {
+        v = random_value();
+      }
+      vector<const void*> in_list;
+      for (const auto& v : in_values) {
+        in_list.emplace_back(&v);
+      }
+
+      for (const auto& pred : { ColumnPredicate::Range(cs, &lower, &upper),
+                                ColumnPredicate::Range(cs, &lower, nullptr),
+                                ColumnPredicate::Range(cs, nullptr, &upper),
+                                ColumnPredicate::Equality(cs, &lower),
+                                ColumnPredicate::InList(cs, &in_list) }) {
+        if (pred.predicate_type() == PredicateType::None) {
+          continue;
+        }
+        SCOPED_TRACE(pred.ToString());
+        SelectionVector vectorized(kNumRows);
+        SelectionVector scalar(kNumRows);
+        vectorized.SetAllTrue();
+        scalar.SetAllTrue();
+        for (int i = 0; i < kNumRows; i++) {
+          if (rand->OneIn(5)) {
+            BitmapClear(vectorized.mutable_bitmap(), i);
+            BitmapClear(scalar.mutable_bitmap(), i);
+          }
+        }
+
+        FLAGS_disable_column_predicate_avx2 = false;
+        pred.Evaluate(b, &vectorized);
+        FLAGS_disable_column_predicate_avx2 = true;
+        pred.Evaluate(b, &scalar);
+        for (int i = 0; i < kNumRows; i++) {
+          ASSERT_EQ(scalar.IsRowSelected(i), vectorized.IsRowSelected(i)) << "row " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TestColumnPredicate, TestVectorizedEvaluation) {
+  NO_FATALS(TestVectorizedEvaluation<INT32>(&rand_));
+  NO_FATALS(TestVectorizedEvaluation<UINT32>(&rand_));
+  NO_FATALS(TestVectorizedEvaluation<INT64>(&rand_));
+  NO_FATALS(TestVectorizedEvaluation<UINT64>(&rand_));
+  NO_FATALS(TestVectorizedEvaluation<INT128>(&rand_));
+}
+
 using TestColumnPredicateDeathTest = TestColumnPredicate;
 
 // Ensure that ColumnPredicate::Merge(other) requires the 'other' predicate to
@@ -1523,23 +1668,27 @@ class ColumnPredicateBenchmark : public KuduTest {
          }
        }
 
-       SelectionVector selvec(kNumRows);
-       int64_t tot_cycles = 0;
-       Stopwatch sw;
-       sw.start();
-       for (int i = 0; i < num_iters; i++) {
-         selvec.SetAllTrue();
-         int64_t cycles_start = CycleClock::Now();
-         pred.Evaluate(b, &selvec);
-         tot_cycles += CycleClock::Now() - cycles_start;
+       for (bool disable_avx2 : {true, false}) {
+         FLAGS_disable_column_predicate_avx2 = disable_avx2;
+         SelectionVector selvec(kNumRows);
+         int64_t tot_cycles = 0;
+         Stopwatch sw;
+         sw.start();
+         for (int i = 0; i < num_iters; i++) {
+           selvec.SetAllTrue();
+           int64_t cycles_start = CycleClock::Now();
+           pred.Evaluate(b, &selvec);
+           tot_cycles += CycleClock::Now() - cycles_start;
+         }
+         sw.stop();
+         LOG(INFO) << StringPrintf(
+               "%-6s %-10s %-7s (%s) %.1fM evals/sec\t%.2f cycles/eval",
+               TypeParam::name(), nullable ? "NULL" : "NOT NULL",
+               disable_avx2 ? "SCALAR" : "AVX2",
+               pred.ToString().c_str(),
+               num_evals / sw.elapsed().user_cpu_seconds() / 1000000,
+               static_cast<double>(tot_cycles) / num_evals);
        }
-       sw.stop();
-       LOG(INFO) << StringPrintf(
-             "%-6s %-10s (%s) %.1fM evals/sec\t%.2f cycles/eval",
-             TypeParam::name(), nullable ? "NULL" : "NOT NULL",
-             pred.ToString().c_str(),
-             num_evals / sw.elapsed().user_cpu_seconds() / 1000000,
-             static_cast<double>(tot_cycles) / num_evals);
      }
    }
 };
@@ -1552,6 +1701,8 @@ using test_types = ::testing::Types<
   DataTypeTraits<INT16>,
   DataTypeTraits<INT32>,
   DataTypeTraits<INT64>,
+  DataTypeTraits<UINT32>,
+  DataTypeTraits<UINT64>,
   DataTypeTraits<FLOAT>,
   DataTypeTraits<DOUBLE>>;
 
@@ -1576,6 +1727,14 @@ TYPED_TEST(RangePredicateBenchmark, TestRange) {
       [&](const ColumnSchema& cs) { return ColumnPredicate::Range(cs, &lower, &upper); });
 }
 
+TYPED_TEST(RangePredicateBenchmark, TestInList) {
+  const typename TypeParam::cpp_type values[] = { 0, 2, 5, 7 };
+  RangePredicateBenchmark<TypeParam>::DoTest([&](const ColumnSchema& cs) {
+    vector<const void*> in_list = { &values[0], &values[1], &values[2], &values[3] };
+    return ColumnPredicate::InList(cs, &in_list);
+  });
+}
+
 // IS NULL and IS NOT NULL predicates don't look at the data itself, so no need
 // to type-parameterize them.
 class NullPredicateBenchmark : public ColumnPredicateBenchmark<DataTypeTraits<INT32>> {};
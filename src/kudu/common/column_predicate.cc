@@ -22,19 +22,32 @@
 #include <iterator>
 #include <type_traits>
 
+#include <gflags/gflags.h>
+
+#include "kudu/common/column_predicate_avx2.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/key_util.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
+#include "kudu/gutil/cpu.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/alignment.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/int128.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/memory/arena.h"
 
+DEFINE_bool(disable_column_predicate_avx2, false,
+            "Disable the AVX2 kernels used to evaluate column predicates. This flag has no "
+            "effect if the target CPU doesn't support AVX2 at run-time or ColumnPredicate was "
+            "built with a compiler that doesn't support AVX2.");
+TAG_FLAG(disable_column_predicate_avx2, hidden);
+TAG_FLAG(disable_column_predicate_avx2, runtime);
+
 using std::string;
 using std::vector;
 
@@ -632,6 +645,27 @@ void ColumnPredicate::MergeIntoBloomFilter(const ColumnPredicate &other) {
 
 namespace {
 
+// Clears the bits of the first 'n_bytes' bytes of 'sel_bitmap' whose cells are
+// null in 'non_null_bitmap', or non-null if 'IS_NOT_NULL' is false, a word at
+// a time.
+template<bool IS_NOT_NULL>
+void ApplyNonNullBitmap(const uint8_t* __restrict__ non_null_bitmap,
+                        int n_bytes,
+                        uint8_t* __restrict__ sel_bitmap) {
+  constexpr int kWordSize = sizeof(uint64_t);
+  int i = 0;
+  for (; i + kWordSize <= n_bytes; i += kWordSize) {
+    uint64_t non_null_word = UnalignedLoad<uint64_t>(non_null_bitmap + i);
+    if (!IS_NOT_NULL) non_null_word = ~non_null_word;
+    UnalignedStore(sel_bitmap + i, UnalignedLoad<uint64_t>(sel_bitmap + i) & non_null_word);
+  }
+  for (; i < n_bytes; i++) {
+    uint8_t non_null_byte = non_null_bitmap[i];
+    if (!IS_NOT_NULL) non_null_byte = ~non_null_byte;
+    sel_bitmap[i] &= non_null_byte;
+  }
+}
+
 // Optimized predicate evaluation for primitive types.
 //
 // For primitives, it's safe to evaluate a predicate even if the cell is
@@ -662,25 +696,17 @@ int ApplyPredicatePrimitive(const ColumnBlock& block, uint8_t* __restrict__ sel_
     sel_bitmap[i] &= res_8;
   }
   if (block.is_nullable()) {
-    for (int i = 0; i < n_chunks; i++) {
-      sel_bitmap[i] &= block.non_null_bitmap()[i];
-    }
+    ApplyNonNullBitmap<true>(block.non_null_bitmap(), n_chunks, sel_bitmap);
   }
   return n_chunks * 8;
 }
 
 
+// Evaluates the predicate 'p' over the cells of 'block' starting at 'start_idx',
+// one cell at a time.
 template <DataType PhysicalType, typename P>
-void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
+void ApplyPredicateFrom(const ColumnBlock& block, int start_idx, SelectionVector* sel, P p) {
   using cpp_type = typename DataTypeTraits<PhysicalType>::cpp_type;
-  int start_idx = 0;
-  if (std::is_fundamental<cpp_type>::value) {
-    start_idx = ApplyPredicatePrimitive<PhysicalType>(block, sel->mutable_bitmap(), p);
-    if (PREDICT_TRUE(start_idx == block.nrows())) return;
-    // If we couldn't process the whole block unrolled by 8, fall through to the
-    // remainder.
-  }
-
   const cpp_type* data = reinterpret_cast<const cpp_type*>(block.data());
   if (block.is_nullable()) {
     for (size_t i = start_idx; i < block.nrows(); i++) {
@@ -701,14 +727,51 @@ void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
   }
 }
 
+template <DataType PhysicalType, typename P>
+void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
+  using cpp_type = typename DataTypeTraits<PhysicalType>::cpp_type;
+  int start_idx = 0;
+  // int128_t isn't a fundamental type in strict ISO C++ mode, but its cells
+  // are just as safe to evaluate unconditionally.
+  if (std::is_fundamental<cpp_type>::value || std::is_same<cpp_type, int128_t>::value) {
+    start_idx = ApplyPredicatePrimitive<PhysicalType>(block, sel->mutable_bitmap(), p);
+    if (PREDICT_TRUE(start_idx == block.nrows())) return;
+    // If we couldn't process the whole block unrolled by 8, fall through to the
+    // remainder.
+  }
+  ApplyPredicateFrom<PhysicalType>(block, start_idx, sel, p);
+}
+
+#ifdef USE_AVX2
+// Whether the AVX2 kernels in column_predicate_avx2.h may be used.
+bool UseAVX2Kernels() {
+  static const base::CPU kCpu;
+  return !FLAGS_disable_column_predicate_avx2 && kCpu.has_avx2();
+}
+#endif
+
+// Like ApplyPredicate(), but evaluates the block 8 cells at a time with
+// 'kernel', which is called with the data of the block, the number of 8-cell
+// chunks to evaluate and the selection bitmap. 'p' evaluates the remainder.
+//
+// REQUIRES: UseAVX2Kernels()
+template <DataType PhysicalType, typename K, typename P>
+void ApplyPredicateWithKernel(const ColumnBlock& block, SelectionVector* sel, K kernel, P p) {
+  using cpp_type = typename DataTypeTraits<PhysicalType>::cpp_type;
+  const int n_chunks = block.nrows() / 8;
+  uint8_t* sel_bitmap = sel->mutable_bitmap();
+  kernel(reinterpret_cast<const cpp_type*>(block.data()), n_chunks, sel_bitmap);
+  if (block.is_nullable()) {
+    ApplyNonNullBitmap<true>(block.non_null_bitmap(), n_chunks, sel_bitmap);
+  }
+  if (PREDICT_TRUE(n_chunks * 8 == block.nrows())) return;
+  ApplyPredicateFrom<PhysicalType>(block, n_chunks * 8, sel, p);
+}
+
 template<bool IS_NOT_NULL>
 void ApplyNullPredicate(const ColumnBlock& block, uint8_t* __restrict__ sel_vec) {
   int n_bytes = KUDU_ALIGN_UP(block.nrows(), 8) / 8;
-  for (int i = 0; i < n_bytes; i++) {
-    uint8_t non_null_byte = block.non_null_bitmap()[i];
-    if (!IS_NOT_NULL) non_null_byte = ~non_null_byte;
-    sel_vec[i] &= non_null_byte;
-  }
+  ApplyNonNullBitmap<IS_NOT_NULL>(block.non_null_bitmap(), n_bytes, sel_vec);
 }
 } // anonymous namespace
 
@@ -723,6 +786,25 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
       cpp_type local_lower = lower_ ? *static_cast<const cpp_type*>(lower_) : cpp_type();
       cpp_type local_upper = upper_ ? *static_cast<const cpp_type*>(upper_) : cpp_type();
 
+#ifdef USE_AVX2
+      if constexpr (avx2::HasKernels<cpp_type>()) {
+        if (UseAVX2Kernels()) {
+          const cpp_type* lower = lower_ ? &local_lower : nullptr;
+          const cpp_type* upper = upper_ ? &local_upper : nullptr;
+          ApplyPredicateWithKernel<PhysicalType>(
+              block, sel,
+              [lower, upper] (const cpp_type* data, int n_chunks, uint8_t* sel_bitmap) {
+                avx2::ApplyRange(data, n_chunks, lower, upper, sel_bitmap);
+              },
+              [lower, upper] (const void* cell) {
+                return (lower == nullptr || traits::Compare(cell, lower) >= 0) &&
+                       (upper == nullptr || traits::Compare(cell, upper) < 0);
+              });
+          return;
+        }
+      }
+#endif
+
       if (lower_ == nullptr) {
         ApplyPredicate<PhysicalType>(block, sel, [local_upper] (const void* cell) {
             return traits::Compare(cell, &local_upper) < 0;
@@ -741,6 +823,21 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
     };
     case PredicateType::Equality: {
       cpp_type local_lower = lower_ ? *static_cast<const cpp_type*>(lower_) : cpp_type();
+#ifdef USE_AVX2
+      if constexpr (avx2::HasKernels<cpp_type>()) {
+        if (UseAVX2Kernels()) {
+          ApplyPredicateWithKernel<PhysicalType>(
+              block, sel,
+              [local_lower] (const cpp_type* data, int n_chunks, uint8_t* sel_bitmap) {
+                avx2::ApplyEquality(data, n_chunks, local_lower, sel_bitmap);
+              },
+              [local_lower] (const void* cell) {
+                return traits::Compare(cell, &local_lower) == 0;
+              });
+          return;
+        }
+      }
+#endif
       ApplyPredicate<PhysicalType>(block, sel, [local_lower] (const void* cell) {
             return traits::Compare(cell, &local_lower) == 0;
       });
@@ -760,12 +857,26 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
       return;
     }
     case PredicateType::InList: {
-      ApplyPredicate<PhysicalType>(block, sel, [this] (const void* cell) {
+      auto in_list = [this] (const void* cell) {
         return std::binary_search(values_.begin(), values_.end(), cell,
                                   [] (const void* lhs, const void* rhs) {
                                     return traits::Compare(lhs, rhs) < 0;
                                   });
-      });
+      };
+#ifdef USE_AVX2
+      if constexpr (avx2::HasKernels<cpp_type>()) {
+        if (values_.size() <= avx2::kMaxInListValues && UseAVX2Kernels()) {
+          ApplyPredicateWithKernel<PhysicalType>(
+              block, sel,
+              [this] (const cpp_type* data, int n_chunks, uint8_t* sel_bitmap) {
+                avx2::ApplyInList(data, n_chunks, values_.data(), values_.size(), sel_bitmap);
+              },
+              in_list);
+          return;
+        }
+      }
+#endif
+      ApplyPredicate<PhysicalType>(block, sel, in_list);
       return;
     };
     case PredicateType::None: LOG(FATAL) << "NONE predicate evaluation";
@@ -798,6 +909,85 @@ bool ColumnPredicate::EvaluateCell(DataType type, const void* cell) const {
   }
 }
 
+namespace {
+
+// The largest number of values of a range which MayMatchRange() probes the
+// bloom filters of a predicate with.
+constexpr uint64_t kMaxBloomFilterProbes = 64;
+
+// Returns false if 'pred', an InBloomFilter predicate on an integer column,
+// matches none of the values in the inclusive range ['min', 'max'], e.g. the
+// key range of a join matched against the zone map of a block. Only probes
+// the narrow ranges.
+template <DataType PhysicalType>
+bool BloomFilterMayMatchRange(const ColumnPredicate& pred, const void* min, const void* max) {
+  using cpp_type = typename DataTypeTraits<PhysicalType>::cpp_type;
+  const cpp_type lo = *reinterpret_cast<const cpp_type*>(min);
+  const cpp_type hi = *reinterpret_cast<const cpp_type*>(max);
+  // The difference is computed modulo 2^64, which is exact for hi >= lo.
+  if (static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo) >= kMaxBloomFilterProbes) {
+    return true;
+  }
+  for (cpp_type v = lo; ; v++) {
+    if (pred.EvaluateCell<PhysicalType>(&v)) {
+      return true;
+    }
+    if (v == hi) {
+      return false;
+    }
+  }
+}
+
+} // anonymous namespace
+
+bool ColumnPredicate::MayMatchRange(const void* min, const void* max) const {
+  const TypeInfo* type_info = column_.type_info();
+  DCHECK_LE(type_info->Compare(min, max), 0);
+  switch (predicate_type()) {
+    case PredicateType::None:
+    case PredicateType::IsNull:
+      return false;
+    case PredicateType::IsNotNull:
+      return true;
+    case PredicateType::Equality:
+      return type_info->Compare(lower_, min) >= 0 &&
+             type_info->Compare(lower_, max) <= 0;
+    case PredicateType::Range:
+      return (lower_ == nullptr || type_info->Compare(lower_, max) <= 0) &&
+             (upper_ == nullptr || type_info->Compare(upper_, min) > 0);
+    case PredicateType::InBloomFilter: {
+      // Bloom filter predicates may carry optional range bounds as well.
+      if ((lower_ != nullptr && type_info->Compare(lower_, max) > 0) ||
+          (upper_ != nullptr && type_info->Compare(upper_, min) <= 0)) {
+        return false;
+      }
+      // The values of a narrow integer range are few enough to probe.
+      switch (type_info->physical_type()) {
+        case INT8: return BloomFilterMayMatchRange<INT8>(*this, min, max);
+        case INT16: return BloomFilterMayMatchRange<INT16>(*this, min, max);
+        case INT32: return BloomFilterMayMatchRange<INT32>(*this, min, max);
+        case INT64: return BloomFilterMayMatchRange<INT64>(*this, min, max);
+        case UINT8: return BloomFilterMayMatchRange<UINT8>(*this, min, max);
+        case UINT16: return BloomFilterMayMatchRange<UINT16>(*this, min, max);
+        case UINT32: return BloomFilterMayMatchRange<UINT32>(*this, min, max);
+        case UINT64: return BloomFilterMayMatchRange<UINT64>(*this, min, max);
+        default: return true;
+      }
+    }
+    case PredicateType::InList: {
+      // Find the first value in the list which isn't less than 'min': the
+      // range contains a value of the list iff that value isn't past 'max'.
+      auto it = std::lower_bound(values_.begin(), values_.end(), min,
+                                 [type_info](const void* lhs, const void* rhs) {
+                                   return type_info->Compare(lhs, rhs) < 0;
+                                 });
+      return it != values_.end() && type_info->Compare(*it, max) <= 0;
+    }
+  }
+  LOG(FATAL) << "unknown predicate type";
+  return true;
+}
+
 void ColumnPredicate::Evaluate(const ColumnBlock& block, SelectionVector* sel) const {
   DCHECK(sel);
   switch (block.type_info()->physical_type()) {
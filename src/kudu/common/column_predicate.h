@@ -224,6 +224,12 @@ class ColumnPredicate {
   // Otherwise, use EvaluateCell<DataType>.
   bool EvaluateCell(DataType type, const void* cell) const;
 
+  // Returns false if no non-NULL value in the inclusive range ['min', 'max']
+  // can satisfy the predicate, e.g. when the range is made of the smallest and
+  // the largest values of a block of cells. May return true even if none of
+  // the values in the range satisfy the predicate.
+  bool MayMatchRange(const void* min, const void* max) const;
+
   // Print the predicate for debugging.
   std::string ToString() const;
 
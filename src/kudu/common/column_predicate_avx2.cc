@@ -0,0 +1,276 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// This file is conditionally compiled if compiler supports AVX2.
+// However the tidy bot appears to compile this file regardless and does not define the USE_AVX2
+// macro raising incorrect errors.
+#if defined(CLANG_TIDY)
+#define USE_AVX2 1
+#endif
+
+#include "kudu/common/column_predicate_avx2.h"
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "kudu/gutil/port.h"
+#include "kudu/util/int128.h"
+
+namespace kudu {
+namespace avx2 {
+
+namespace {
+
+// Vector operations on the 8 cells of a chunk, specialized by cell size.
+//
+// AVX2 only has signed integer comparisons, so unsigned cells and constants
+// are compared after flipping their sign bit, which maps the unsigned order
+// onto the signed one.
+template <size_t kCellSize>
+struct Lanes;
+
+// 32-bit cells: a chunk fits in a single vector.
+template <>
+struct Lanes<4> {
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i Set1(int32_t v) {
+    return _mm256_set1_epi32(v);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i SignBits() {
+    return _mm256_set1_epi32(INT32_MIN);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i CmpGt(__m256i a, __m256i b) {
+    return _mm256_cmpgt_epi32(a, b);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i CmpEq(__m256i a, __m256i b) {
+    return _mm256_cmpeq_epi32(a, b);
+  }
+
+  // Evaluates 'f' over the chunk at 'p'. 'f' returns a vector whose lanes are
+  // all ones for the matching cells, and all zeros otherwise.
+  template <typename F>
+  static inline ATTRIBUTE_ALWAYS_INLINE uint8_t EvalChunk(const void* p, const F& f) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    return static_cast<uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(f(v))));
+  }
+};
+
+// 64-bit cells: a chunk spans two vectors.
+template <>
+struct Lanes<8> {
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i Set1(int64_t v) {
+    return _mm256_set1_epi64x(v);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i SignBits() {
+    return _mm256_set1_epi64x(INT64_MIN);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i CmpGt(__m256i a, __m256i b) {
+    return _mm256_cmpgt_epi64(a, b);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i CmpEq(__m256i a, __m256i b) {
+    return _mm256_cmpeq_epi64(a, b);
+  }
+
+  template <typename F>
+  static inline ATTRIBUTE_ALWAYS_INLINE uint8_t EvalChunk(const void* p, const F& f) {
+    const __m256i* vp = reinterpret_cast<const __m256i*>(p);
+    const int lo = _mm256_movemask_pd(_mm256_castsi256_pd(f(_mm256_loadu_si256(vp))));
+    const int hi = _mm256_movemask_pd(_mm256_castsi256_pd(f(_mm256_loadu_si256(vp + 1))));
+    return static_cast<uint8_t>(lo | (hi << 4));
+  }
+};
+
+// 128-bit cells: a chunk spans four vectors of two cells each.
+//
+// A cell is compared as its high 64-bit half, which is signed, and its low
+// 64-bit half, which is unsigned and only matters if the high halves are
+// equal. The comparisons leave the result of each cell in both of its 64-bit
+// lanes.
+template <>
+struct Lanes<16> {
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i Set1(int128_t v) {
+    const int64_t lo = static_cast<int64_t>(static_cast<uint64_t>(v));
+    const int64_t hi = static_cast<int64_t>(v >> 64);
+    return _mm256_set_epi64x(hi, lo, hi, lo);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i SignBits() {
+    return _mm256_set_epi64x(0, INT64_MIN, 0, INT64_MIN);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i CmpGt(__m256i a, __m256i b) {
+    const __m256i hi_gt = _mm256_cmpgt_epi64(a, b);
+    const __m256i hi_eq = _mm256_cmpeq_epi64(a, b);
+    // Compare the low halves as unsigned integers, and move their results
+    // into the lanes of the high halves.
+    const __m256i lo_gt = _mm256_slli_si256(
+        _mm256_cmpgt_epi64(_mm256_xor_si256(a, SignBits()), _mm256_xor_si256(b, SignBits())),
+        8);
+    const __m256i res = _mm256_or_si256(hi_gt, _mm256_and_si256(hi_eq, lo_gt));
+    // Copy the results of the high lanes into the low ones.
+    return _mm256_shuffle_epi32(res, 0xee);
+  }
+
+  static inline ATTRIBUTE_ALWAYS_INLINE __m256i CmpEq(__m256i a, __m256i b) {
+    const __m256i eq = _mm256_cmpeq_epi64(a, b);
+    // Both halves must be equal: AND each lane with the other one of its cell.
+    return _mm256_and_si256(eq, _mm256_shuffle_epi32(eq, 0x4e));
+  }
+
+  template <typename F>
+  static inline ATTRIBUTE_ALWAYS_INLINE uint8_t EvalChunk(const void* p, const F& f) {
+    const __m256i* vp = reinterpret_cast<const __m256i*>(p);
+    int res = 0;
+    for (int i = 0; i < 4; i++) {
+      const int m = _mm256_movemask_pd(_mm256_castsi256_pd(f(_mm256_loadu_si256(vp + i))));
+      // Bits 0 and 2 hold the results of the two cells.
+      res |= ((m & 1) | ((m >> 1) & 2)) << (i * 2);
+    }
+    return static_cast<uint8_t>(res);
+  }
+};
+
+// The signed integer type with the size of 'T'. int128_t isn't an integral
+// type in strict ISO C++ mode, so std::make_signed and std::is_signed don't
+// apply to it.
+template <typename T>
+struct SignedOf {
+  using type = typename std::make_signed<T>::type;
+  static constexpr bool kIsSigned = std::is_signed<T>::value;
+};
+
+template <>
+struct SignedOf<int128_t> {
+  using type = int128_t;
+  static constexpr bool kIsSigned = true;
+};
+
+// Maps 'v' to the signed integer with the same rank, see above.
+template <typename T>
+inline typename SignedOf<T>::type ToSignedOrder(T v) {
+  using S = typename SignedOf<T>::type;
+  if constexpr (SignedOf<T>::kIsSigned) {
+    return v;
+  } else {
+    return static_cast<S>(v ^ (static_cast<T>(1) << (sizeof(T) * 8 - 1)));
+  }
+}
+
+// The vector to XOR the cells with to map them to the signed order.
+template <typename T>
+inline __m256i OrderBias() {
+  if constexpr (SignedOf<T>::kIsSigned) {
+    return _mm256_setzero_si256();
+  } else {
+    return Lanes<sizeof(T)>::SignBits();
+  }
+}
+
+template <typename T, bool kHasLower, bool kHasUpper>
+void ApplyRangeImpl(const T* data, int n_chunks, T lower, T upper,
+                    uint8_t* __restrict__ sel_bitmap) {
+  using L = Lanes<sizeof(T)>;
+  const __m256i bias = OrderBias<T>();
+  const __m256i lower_v = L::Set1(ToSignedOrder(lower));
+  const __m256i upper_v = L::Set1(ToSignedOrder(upper));
+  const __m256i all_ones = _mm256_set1_epi32(-1);
+  for (int i = 0; i < n_chunks; i++) {
+    sel_bitmap[i] &= L::EvalChunk(data + i * 8, [&](__m256i v) {
+      v = _mm256_xor_si256(v, bias);
+      __m256i res = all_ones;
+      if (kHasLower) {
+        // cell >= lower <=> !(lower > cell)
+        res = _mm256_andnot_si256(L::CmpGt(lower_v, v), res);
+      }
+      if (kHasUpper) {
+        res = _mm256_and_si256(L::CmpGt(upper_v, v), res);
+      }
+      return res;
+    });
+  }
+}
+
+} // anonymous namespace
+
+template <typename T>
+void ApplyRange(const T* data, int n_chunks, const T* lower, const T* upper,
+                uint8_t* __restrict__ sel_bitmap) {
+  if (lower == nullptr) {
+    ApplyRangeImpl<T, false, true>(data, n_chunks, T(), *upper, sel_bitmap);
+  } else if (upper == nullptr) {
+    ApplyRangeImpl<T, true, false>(data, n_chunks, *lower, T(), sel_bitmap);
+  } else {
+    ApplyRangeImpl<T, true, true>(data, n_chunks, *lower, *upper, sel_bitmap);
+  }
+}
+
+template <typename T>
+void ApplyEquality(const T* data, int n_chunks, T value,
+                   uint8_t* __restrict__ sel_bitmap) {
+  using L = Lanes<sizeof(T)>;
+  const __m256i value_v = L::Set1(static_cast<typename SignedOf<T>::type>(value));
+  for (int i = 0; i < n_chunks; i++) {
+    sel_bitmap[i] &= L::EvalChunk(data + i * 8, [&](__m256i v) {
+      return L::CmpEq(v, value_v);
+    });
+  }
+}
+
+template <typename T>
+void ApplyInList(const T* data, int n_chunks, const void* const* values, size_t n_values,
+                 uint8_t* __restrict__ sel_bitmap) {
+  using L = Lanes<sizeof(T)>;
+  __m256i values_v[kMaxInListValues];
+  for (size_t j = 0; j < n_values; j++) {
+    values_v[j] = L::Set1(
+        static_cast<typename SignedOf<T>::type>(*static_cast<const T*>(values[j])));
+  }
+  for (int i = 0; i < n_chunks; i++) {
+    sel_bitmap[i] &= L::EvalChunk(data + i * 8, [&](__m256i v) {
+      __m256i res = _mm256_setzero_si256();
+      for (size_t j = 0; j < n_values; j++) {
+        res = _mm256_or_si256(res, L::CmpEq(v, values_v[j]));
+      }
+      return res;
+    });
+  }
+}
+
+#define INSTANTIATE_KERNELS(T)                                                              \
+  template void ApplyRange<T>(const T*, int, const T*, const T*, uint8_t* __restrict__);    \
+  template void ApplyEquality<T>(const T*, int, T, uint8_t* __restrict__);                  \
+  template void ApplyInList<T>(const T*, int, const void* const*, size_t,                   \
+                               uint8_t* __restrict__)
+
+INSTANTIATE_KERNELS(int32_t);
+INSTANTIATE_KERNELS(uint32_t);
+INSTANTIATE_KERNELS(int64_t);
+INSTANTIATE_KERNELS(uint64_t);
+INSTANTIATE_KERNELS(int128_t);
+
+#undef INSTANTIATE_KERNELS
+
+} // namespace avx2
+} // namespace kudu
@@ -0,0 +1,74 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+// AVX2 kernels used by ColumnPredicate to evaluate predicates over blocks of
+// fixed-width integer cells. They're only available if the compiler supports
+// AVX2 (USE_AVX2 is defined), and callers must check at run-time that the CPU
+// supports AVX2 before calling any of them.
+//
+// Each kernel evaluates the predicate over the first 'n_chunks' * 8 cells at
+// 'data', and clears the bits of 'sel_bitmap' corresponding to the cells which
+// don't match; one byte of 'sel_bitmap' covers 8 cells. The kernels don't look
+// at the null bitmap: the caller is expected to account for NULL cells.
+//
+// The kernels are instantiated for int32_t, uint32_t, int64_t, uint64_t and
+// int128_t, the physical type of INT128 and DECIMAL128 columns.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "kudu/util/int128.h"
+
+namespace kudu {
+namespace avx2 {
+
+// The maximum number of values in an IN list predicate for which
+// ApplyInList() may be used. Each value costs a comparison per cell, so
+// longer lists are better off with the binary search of the scalar path.
+constexpr size_t kMaxInListValues = 16;
+
+// Whether there are AVX2 kernels for cells of type 'T'.
+template <typename T>
+constexpr bool HasKernels() {
+  // int128_t isn't an integral type in strict ISO C++ mode, so it has to be
+  // listed on its own.
+  return (std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+          (sizeof(T) == 4 || sizeof(T) == 8)) ||
+      std::is_same<T, int128_t>::value;
+}
+
+// Evaluates 'lower <= cell < upper'. Either of the bounds may be null, in
+// which case the predicate is unbounded on that side.
+template <typename T>
+void ApplyRange(const T* data, int n_chunks, const T* lower, const T* upper,
+                uint8_t* __restrict__ sel_bitmap);
+
+// Evaluates 'cell == value'.
+template <typename T>
+void ApplyEquality(const T* data, int n_chunks, T value,
+                   uint8_t* __restrict__ sel_bitmap);
+
+// Evaluates 'cell IN values', where the 'n_values' elements of 'values' point
+// to cells of type 'T'. 'n_values' must be at most kMaxInListValues.
+template <typename T>
+void ApplyInList(const T* data, int n_chunks, const void* const* values, size_t n_values,
+                 uint8_t* __restrict__ sel_bitmap);
+
+} // namespace avx2
+} // namespace kudu
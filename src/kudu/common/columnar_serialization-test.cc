@@ -176,4 +176,28 @@ TEST_F(ColumnarSerializationTest, TestCopySelectedRows) {
   ASSERT_EQ(expected, ret);
 }
 
+TEST_F(ColumnarSerializationTest, TestCopySelectedRuns) {
+  auto num_rows = rng_.Uniform(1000) + 1;
+  vector<uint32_t> vals;
+  for (int i = 0; i < num_rows; i++) {
+    vals.push_back(rng_.Next());
+  }
+
+  // Select most of the rows, in runs of various lengths.
+  vector<uint32_t> expected;
+  vector<uint16_t> sel_indexes;
+  for (int i = 0; i < num_rows; i++) {
+    if (!rng_.OneIn(8)) {
+      sel_indexes.push_back(i);
+      expected.push_back(vals[i]);
+    }
+  }
+
+  vector<uint32_t> ret(expected.size());
+  internal::CopySelectedRuns(sel_indexes, kTypeSize,
+                             reinterpret_cast<const uint8_t*>(vals.data()),
+                             reinterpret_cast<uint8_t*>(ret.data()));
+  ASSERT_EQ(expected, ret);
+}
+
 } // namespace kudu
@@ -457,8 +457,34 @@ void CopySelectedRows(const vector<uint16_t>& sel_rows,
   }
 }
 
+// Copy the selected cells from the column data 'src_buf' into 'dst_buf' like
+// CopySelectedRows(), but with one memcpy() per run of consecutive indices in
+// 'sel_rows'. This is faster when most of the rows are selected, since the
+// runs are then long.
+void CopySelectedRuns(const vector<uint16_t>& sel_rows,
+                      int sizeof_type,
+                      const uint8_t* __restrict__ src_buf,
+                      uint8_t* __restrict__ dst_buf) {
+  const uint16_t* idx = sel_rows.data();
+  const uint16_t* const end = idx + sel_rows.size();
+  while (idx != end) {
+    const uint16_t* run_end = idx + 1;
+    while (run_end != end && *run_end == *(run_end - 1) + 1) {
+      run_end++;
+    }
+    const size_t run_bytes = (run_end - idx) * sizeof_type;
+    memcpy(dst_buf, src_buf + *idx * sizeof_type, run_bytes);
+    dst_buf += run_bytes;
+    idx = run_end;
+  }
+}
+
 namespace {
 
+// The selected rows of a block are copied run by run rather than one by one
+// when at least this fraction of them are selected.
+constexpr double kDenseSelectionRatio = 0.75;
+
 // Specialized division for the known type sizes. Despite having some branching here,
 // this is faster than a 'div' instruction which has a 20+ cycle latency.
 size_t div_sizeof_type(size_t s, size_t divisor) {
@@ -472,10 +498,26 @@ size_t div_sizeof_type(size_t s, size_t divisor) {
   }
 }
 
+// Copy the non-null-bitmap bits of the selected rows of 'cblock' into 'dst_bitmap',
+// starting at bit 'dst_idx'.
+void CopySelectedNonNullBits(const ColumnBlock& cblock,
+                             const SelectedRows& sel_rows,
+                             size_t dst_idx,
+                             uint8_t* dst_bitmap) {
+  if (sel_rows.all_selected()) {
+    BitmapCopy(dst_bitmap, dst_idx, cblock.non_null_bitmap(), 0, cblock.nrows());
+  } else {
+    CopyNonNullBitmap(cblock.non_null_bitmap(), sel_rows.bitmap(),
+                      dst_idx, cblock.nrows(), dst_bitmap);
+  }
+}
+
 // Copy the selected primitive cells (and non-null-bitmap bits) from 'cblock' into 'dst'
-// according to the given 'sel_rows'.
+// according to the given 'sel_rows'. The values of the null cells are zeroed if
+// 'zero_null_values' is true, and left undefined otherwise.
 void CopySelectedCellsFromColumn(const ColumnBlock& cblock,
                                  const SelectedRows& sel_rows,
+                                 bool zero_null_values,
                                  ColumnarSerializedBatch::Column* dst) {
   DCHECK(cblock.type_info()->physical_type() != BINARY);
   size_t sizeof_type = cblock.type_info()->size();
@@ -492,6 +534,8 @@ void CopySelectedCellsFromColumn(const ColumnBlock& cblock,
 
   if (sel_rows.all_selected()) {
     memcpy(dst_buf, src_buf, sizeof_type * n_sel);
+  } else if (n_sel >= cblock.nrows() * kDenseSelectionRatio) {
+    CopySelectedRuns(sel_rows.indexes(), sizeof_type, src_buf, dst_buf);
   } else {
     CopySelectedRows(sel_rows.indexes(), sizeof_type, src_buf, dst_buf);
   }
@@ -499,15 +543,60 @@ void CopySelectedCellsFromColumn(const ColumnBlock& cblock,
   if (cblock.is_nullable()) {
     DCHECK_EQ(dst->non_null_bitmap->size(), BitmapSize(initial_rows));
     dst->non_null_bitmap->resize_with_extra_capacity(BitmapSize(new_num_rows));
-    CopyNonNullBitmap(cblock.non_null_bitmap(),
-                      sel_rows.bitmap(),
-                      initial_rows, cblock.nrows(),
-                      dst->non_null_bitmap->data());
-    ZeroNullValues(sizeof_type, initial_rows, n_sel,
-        dst->data.data(), dst->non_null_bitmap->data());
+    CopySelectedNonNullBits(cblock, sel_rows, initial_rows, dst->non_null_bitmap->data());
+    if (zero_null_values) {
+      ZeroNullValues(sizeof_type, initial_rows, n_sel,
+          dst->data.data(), dst->non_null_bitmap->data());
+    }
   }
 }
 
+// Copy the selected BOOL cells (and non-null-bitmap bits) from 'cblock' into 'dst',
+// bit-packing the values as in the Arrow boolean layout. 'initial_rows' is the number
+// of rows already serialized into 'dst'.
+void CopySelectedBoolCellsFromColumn(const ColumnBlock& cblock,
+                                     const SelectedRows& sel_rows,
+                                     size_t initial_rows,
+                                     ColumnarSerializedBatch::Column* dst) {
+  DCHECK(cblock.type_info()->physical_type() == BOOL);
+  size_t new_num_rows = initial_rows + sel_rows.num_selected();
+
+  DCHECK_EQ(dst->data.size(), BitmapSize(initial_rows));
+  dst->data.resize_with_extra_capacity(BitmapSize(new_num_rows));
+  uint8_t* dst_bitmap = dst->data.data();
+  const uint8_t* src_buf = cblock.cell_ptr(0);
+  const bool nullable = cblock.is_nullable();
+  size_t dst_idx = initial_rows;
+  sel_rows.ForEachIndex(
+      [&](uint16_t i) {
+        // The values of NULL cells are undefined: serialize them as false.
+        BitmapChange(dst_bitmap, dst_idx++, src_buf[i] != 0 && !(nullable && cblock.is_null(i)));
+      });
+
+  if (nullable) {
+    DCHECK_EQ(dst->non_null_bitmap->size(), BitmapSize(initial_rows));
+    dst->non_null_bitmap->resize_with_extra_capacity(BitmapSize(new_num_rows));
+    CopySelectedNonNullBits(cblock, sel_rows, initial_rows, dst->non_null_bitmap->data());
+  }
+}
+
+// Zero the bits past the first 'num_rows' of 'bitmap', then zero-pad it to a
+// multiple of 8 bytes.
+void PadBitmapForArrow(size_t num_rows, faststring* bitmap) {
+  DCHECK_EQ(bitmap->size(), BitmapSize(num_rows));
+  if (num_rows % 8 != 0) {
+    BitmapChangeBits(bitmap->data(), num_rows, 8 - num_rows % 8, false);
+  }
+  bitmap->resize(KUDU_ALIGN_UP(bitmap->size(), 8));
+  memset(bitmap->data() + BitmapSize(num_rows), 0, bitmap->size() - BitmapSize(num_rows));
+}
+
+// Zero-pad 'buf' to a multiple of 8 bytes.
+void PadBufferForArrow(faststring* buf) {
+  size_t old_size = buf->size();
+  buf->resize(KUDU_ALIGN_UP(old_size, 8));
+  memset(buf->data() + old_size, 0, buf->size() - old_size);
+}
 
 // For each of the Slices in 'cells_buf', copy the pointed-to data into 'varlen' and
 // write the _end_ offset of the copied data into 'offsets_out'. This assumes (and
@@ -575,10 +664,9 @@ void CopySelectedVarlenCellsFromColumn(const ColumnBlock& cblock,
   if (cblock.is_nullable()) {
     DCHECK_EQ(dst->non_null_bitmap->size(), BitmapSize(initial_rows));
     dst->non_null_bitmap->resize_with_extra_capacity(BitmapSize(new_num_rows));
-    CopyNonNullBitmap(cblock.non_null_bitmap(),
-                      sel_rows.bitmap(),
-                      initial_rows, cblock.nrows(),
-                      dst->non_null_bitmap->data());
+    CopySelectedNonNullBits(cblock, sel_rows, initial_rows, dst->non_null_bitmap->data());
+    // The Slices of the null cells are zeroed regardless of 'zero_null_values',
+    // since their sizes determine the offsets of the following cells.
     ZeroNullValues(sizeof(Slice), 0, cblock.nrows(),
                    const_cast<ColumnBlock&>(cblock).data(), cblock.non_null_bitmap());
   }
@@ -594,7 +682,12 @@ void CopySelectedVarlenCellsFromColumn(const ColumnBlock& cblock,
 
 ColumnarSerializedBatch::ColumnarSerializedBatch(const Schema& rowblock_schema,
                                                  const Schema& client_schema,
-                                                 int expected_batch_size_bytes) {
+                                                 int expected_batch_size_bytes,
+                                                 bool arrow_layout,
+                                                 bool zero_null_values)
+    : arrow_layout_(arrow_layout),
+      zero_null_values_(zero_null_values),
+      num_rows_(0) {
   // Initialize buffers for the columns.
   int64_t row_bytes = client_schema.byte_size();
   columns_.reserve(client_schema.num_columns());
@@ -612,6 +705,7 @@ ColumnarSerializedBatch::ColumnarSerializedBatch(const Schema& rowblock_schema,
     if (schema_col.type_info()->physical_type() == BINARY) {
       col.varlen_data.emplace();
     }
+    col.bit_packed = arrow_layout_ && schema_col.type_info()->physical_type() == BOOL;
     if (schema_col.is_nullable()) {
       col.non_null_bitmap.emplace();
     }
@@ -629,7 +723,13 @@ int ColumnarSerializedBatch::AddRowBlock(const RowBlock& block) {
   int col_idx = 0;
   for (const auto& col : columns_) {
     const ColumnBlock& column_block = block.column_block(col.rowblock_schema_col_idx);
-    if (column_block.type_info()->physical_type() == BINARY) {
+    if (arrow_layout_ && column_block.type_info()->physical_type() == BOOL) {
+      internal::CopySelectedBoolCellsFromColumn(
+          column_block,
+          sel,
+          num_rows_,
+          &columns_[col_idx]);
+    } else if (column_block.type_info()->physical_type() == BINARY) {
       internal::CopySelectedVarlenCellsFromColumn(
           column_block,
           sel,
@@ -638,13 +738,34 @@ int ColumnarSerializedBatch::AddRowBlock(const RowBlock& block) {
       internal::CopySelectedCellsFromColumn(
           column_block,
           sel,
+          zero_null_values_,
           &columns_[col_idx]);
     }
     col_idx++;
   }
 
+  num_rows_ += sel.num_selected();
   return sel.num_selected();
 }
 
+vector<ColumnarSerializedBatch::Column> ColumnarSerializedBatch::TakeColumns() && {
+  if (arrow_layout_) {
+    for (auto& col : columns_) {
+      if (col.bit_packed) {
+        internal::PadBitmapForArrow(num_rows_, &col.data);
+      } else {
+        internal::PadBufferForArrow(&col.data);
+      }
+      if (col.varlen_data) {
+        internal::PadBufferForArrow(&*col.varlen_data);
+      }
+      if (col.non_null_bitmap) {
+        internal::PadBitmapForArrow(num_rows_, &*col.non_null_bitmap);
+      }
+    }
+  }
+  return std::move(columns_);
+}
+
 
 } // namespace kudu
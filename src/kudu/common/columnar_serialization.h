@@ -41,9 +41,23 @@ class ColumnarSerializedBatch {
   // 'expected_batch_size_bytes':
   //      the batch size at which the caller expects to stop adding new rows to
   //      this batch. This is is only a hint and does not affect correctness.
+  //
+  // 'arrow_layout': whether to lay out the columns following the Arrow
+  //                 columnar format, so that the buffers can be handed to
+  //                 Arrow readers as-is: BOOL cells are bit-packed rather than
+  //                 stored as one byte each, and TakeColumns() zero-pads every
+  //                 buffer (including the trailing bits of the bitmaps) to a
+  //                 multiple of 8 bytes.
+  //
+  // 'zero_null_values': whether to zero the values of the null cells of the
+  //                     fixed-width columns. If false, they're left undefined,
+  //                     which saves a pass over the values of the nullable
+  //                     columns.
   ColumnarSerializedBatch(const Schema& rowblock_schema,
                           const Schema& client_schema,
-                          int expected_batch_size_bytes);
+                          int expected_batch_size_bytes,
+                          bool arrow_layout = false,
+                          bool zero_null_values = true);
 
   // Append the data in 'block' into this columnar batch.
   //
@@ -57,6 +71,10 @@ class ColumnarSerializedBatch {
     // Underlying column data.
     faststring data;
 
+    // Whether 'data' is a bitmap of the cells' values rather than an array of
+    // cells. Only the BOOL columns of batches using the Arrow layout are.
+    bool bit_packed = false;
+
     // Data for varlen columns (those with BINARY physical type)
     std::optional<faststring> varlen_data;
 
@@ -68,13 +86,21 @@ class ColumnarSerializedBatch {
     return columns_;
   }
 
-  std::vector<Column> TakeColumns() && {
-    return std::move(columns_);
+  // Returns the columns of the batch, padding their buffers first if the
+  // batch uses the Arrow layout.
+  std::vector<Column> TakeColumns() &&;
+
+  // The number of rows serialized so far.
+  int64_t num_rows() const {
+    return num_rows_;
   }
 
  private:
   friend class WireProtocolTest;
   std::vector<Column> columns_;
+  const bool arrow_layout_;
+  const bool zero_null_values_;
+  int64_t num_rows_;
 };
 
 
@@ -101,6 +127,11 @@ void CopySelectedRows(const std::vector<uint16_t>& sel_rows,
                       const uint8_t* __restrict__ src_buf,
                       uint8_t* __restrict__ dst_buf);
 
+void CopySelectedRuns(const std::vector<uint16_t>& sel_rows,
+                      int sizeof_type,
+                      const uint8_t* __restrict__ src_buf,
+                      uint8_t* __restrict__ dst_buf);
+
 
 enum class PextMethod {
 #ifdef __x86_64__
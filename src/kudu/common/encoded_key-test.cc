@@ -18,13 +18,16 @@
 #include "kudu/common/encoded_key.h"
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "kudu/common/common.pb.h"
 #include "kudu/common/key_encoder.h"
+#include "kudu/common/row.h"
 #include "kudu/common/schema.h"
 #include "kudu/gutil/strings/substitute.h" // IWYU pragma: keep
 #include "kudu/util/faststring.h"
@@ -39,6 +42,7 @@
 
 using std::string;
 using std::unique_ptr;
+using std::vector;
 
 namespace kudu {
 class EncodedKeyTest;
@@ -298,6 +302,61 @@ TEST_F(EncodedKeyTest, TestRandomStringEncoding) {
   }
 }
 
+// Test encoding strings with a few '\0' bytes at various positions, which
+// take both the fast and the slow paths of the encoder, against a simple
+// reference encoding.
+TEST_F(EncodedKeyTest, TestStringEncodingWithZeros) {
+  Random r(SeedRandom());
+  faststring encoded;
+  for (int i = 0; i < 10000; i++) {
+    encoded.clear();
+    string in(r.Uniform(100), 'x');
+    const int num_zeros = r.Uniform(4);
+    for (int z = 0; z < num_zeros && !in.empty(); z++) {
+      in[r.Uniform(in.size())] = '\0';
+    }
+    string expected;
+    for (char c : in) {
+      if (c == '\0') {
+        expected.append("\0\1", 2);
+      } else {
+        expected.push_back(c);
+      }
+    }
+    expected.append("\0\0", 2);
+
+    KeyEncoderTraits<BINARY, faststring>::EncodeWithSeparators(Slice(in), false, &encoded);
+    ASSERT_EQ(Slice(expected).ToDebugString(), Slice(encoded).ToDebugString())
+        << "input: " << Slice(in).ToDebugString();
+  }
+}
+
+// Test that encoding a batch of keys with a single builder gives the same keys
+// as encoding them one by one.
+TEST_F(EncodedKeyTest, TestBuildFromContiguousRow) {
+  const Schema schema({ ColumnSchema("key0", STRING),
+                        ColumnSchema("key1", INT64),
+                        ColumnSchema("val", INT32) }, 2);
+  Random r(SeedRandom());
+  EncodedKeyBuilder builder(&schema, &arena_);
+  for (int i = 0; i < 100; i++) {
+    const string str = strings::Substitute("key-$0", r.Next());
+    const Slice str_slice(str);
+    const int64_t int_val = r.Next64();
+    vector<uint8_t> row_data(schema.byte_size());
+    memcpy(&row_data[schema.column_offset(0)], &str_slice, sizeof(str_slice));
+    memcpy(&row_data[schema.column_offset(1)], &int_val, sizeof(int_val));
+    const ConstContiguousRow row(&schema, row_data.data());
+
+    const EncodedKey* expected = EncodedKey::FromContiguousRow(row, &arena_);
+    const EncodedKey* key = builder.BuildFromContiguousRow(row);
+    ASSERT_EQ(expected->encoded_key(), key->encoded_key());
+    ASSERT_EQ(2, key->raw_keys().size());
+    ASSERT_EQ(row.cell_ptr(0), key->raw_keys()[0]);
+    ASSERT_EQ(row.cell_ptr(1), key->raw_keys()[1]);
+  }
+}
+
 #ifdef NDEBUG
 
 // Without this wrapper function, small changes to the code size of
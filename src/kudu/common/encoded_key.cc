@@ -125,6 +125,10 @@ string EncodedKey::Stringify(const Schema &schema) const {
 
 EncodedKeyBuilder::EncodedKeyBuilder(const Schema* schema, Arena* arena)
     : schema_(schema), arena_(arena), num_key_cols_(schema->num_key_columns()), idx_(0) {
+  encoders_.reserve(num_key_cols_);
+  for (size_t i = 0; i < num_key_cols_; i++) {
+    encoders_.push_back(&GetKeyEncoder<faststring>(schema_->column(i).type_info()));
+  }
   Reset();
 }
 
@@ -139,12 +143,10 @@ void EncodedKeyBuilder::Reset() {
 void EncodedKeyBuilder::AddColumnKey(const void *raw_key) {
   DCHECK_LT(idx_, num_key_cols_);
 
-  const ColumnSchema& col = schema_->column(idx_);
-  DCHECK(!col.is_nullable());
+  DCHECK(!schema_->column(idx_).is_nullable());
 
-  const TypeInfo* ti = col.type_info();
   bool is_last = idx_ == num_key_cols_ - 1;
-  GetKeyEncoder<faststring>(ti).Encode(raw_key, is_last, &encoded_key_);
+  encoders_[idx_]->Encode(raw_key, is_last, &encoded_key_);
   raw_keys_[idx_++] = raw_key;
 }
 
@@ -161,6 +163,15 @@ EncodedKey *EncodedKeyBuilder::BuildEncodedKey() {
   return ret;
 }
 
+EncodedKey* EncodedKeyBuilder::BuildFromContiguousRow(const ConstContiguousRow& row) {
+  DCHECK_EQ(num_key_cols_, row.schema()->num_key_columns());
+  Reset();
+  for (size_t i = 0; i < num_key_cols_; i++) {
+    AddColumnKey(row.cell_ptr(i));
+  }
+  return BuildEncodedKey();
+}
+
 string EncodedKey::RangeToString(const EncodedKey* lower, const EncodedKey* upper) {
   string ret;
   if (lower && upper) {
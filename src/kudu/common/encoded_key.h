@@ -18,6 +18,7 @@
 
 #include <cstddef>
 #include <string>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/util/array_view.h"
@@ -30,6 +31,8 @@ namespace kudu {
 class Arena;
 class ConstContiguousRow;
 class Schema;
+template <typename Buffer>
+class KeyEncoder;
 
 // Wrapper around an encoded Key as well as the component raw key columns that
 // went into encoding it.
@@ -42,6 +45,9 @@ class EncodedKey {
   // Construct an EncodedKey object in the given Arena corresponding to the
   // given Row. The lifetime of the row must outlive the lifetime of this
   // EncodedKey object.
+  //
+  // To encode the keys of a batch of rows, prefer
+  // EncodedKeyBuilder::BuildFromContiguousRow().
   static EncodedKey* FromContiguousRow(const ConstContiguousRow& row, Arena* arena);
 
   // Decode the encoded key specified in 'encoded', which must correspond to the
@@ -117,6 +123,12 @@ class EncodedKeyBuilder {
 
   EncodedKey *BuildEncodedKey();
 
+  // Resets the builder and builds the encoded key of 'row', as
+  // EncodedKey::FromContiguousRow() would. The key encoders of the columns are
+  // resolved once per builder, so encoding a batch of rows with the same
+  // builder is cheaper than encoding them one by one.
+  EncodedKey* BuildFromContiguousRow(const ConstContiguousRow& row);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(EncodedKeyBuilder);
 
@@ -127,6 +139,9 @@ class EncodedKeyBuilder {
   const size_t num_key_cols_;
   size_t idx_;
   const void** raw_keys_;
+
+  // The key encoders of the key columns of 'schema_'.
+  std::vector<const KeyEncoder<faststring>*> encoders_;
 };
 
 }  // namespace kudu
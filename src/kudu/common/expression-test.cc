@@ -0,0 +1,256 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/expression.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/common/columnblock-test-util.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/rowblock_memory.h"
+#include "kudu/common/schema.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+
+namespace {
+
+ExpressionPB Col(const string& name) {
+  ExpressionPB pb;
+  pb.set_type(ExpressionPB::COLUMN);
+  pb.set_column(name);
+  return pb;
+}
+
+ExpressionPB Int(int64_t value) {
+  ExpressionPB pb;
+  pb.set_type(ExpressionPB::LITERAL);
+  pb.set_int_value(value);
+  return pb;
+}
+
+ExpressionPB Double(double value) {
+  ExpressionPB pb;
+  pb.set_type(ExpressionPB::LITERAL);
+  pb.set_double_value(value);
+  return pb;
+}
+
+ExpressionPB Op(ExpressionPB::Type type, const vector<ExpressionPB>& args) {
+  ExpressionPB pb;
+  pb.set_type(type);
+  for (const auto& arg : args) {
+    *pb.add_args() = arg;
+  }
+  return pb;
+}
+
+ExpressionPB Cast(const ExpressionPB& arg, DataType type) {
+  ExpressionPB pb = Op(ExpressionPB::CAST, { arg });
+  pb.set_cast_type(type);
+  return pb;
+}
+
+} // anonymous namespace
+
+class ExpressionTest : public KuduTest {
+ public:
+  ExpressionTest()
+      : schema_({ ColumnSchema("i", INT32),
+                  ColumnSchema("n", INT64, /*is_nullable=*/true),
+                  ColumnSchema("d", DOUBLE),
+                  ColumnSchema("ts", UNIXTIME_MICROS),
+                  ColumnSchema("b", BOOL),
+                  ColumnSchema("s", STRING) },
+                1),
+        block_(&schema_, kNumRows, &memory_) {
+    // The rows are (i - 5, i * 10 or NULL every three rows, i / 2,
+    // (i - 3) * 20 minutes, i is even, "x").
+    for (int i = 0; i < kNumRows; i++) {
+      RowBlockRow row = block_.row(i);
+      *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(0)) = i - 5;
+      RowBlockRow::Cell n = row.cell(1);
+      n.set_null(i % 3 == 0);
+      *reinterpret_cast<int64_t*>(n.mutable_ptr()) = i * 10;
+      *reinterpret_cast<double*>(row.mutable_cell_ptr(2)) = i * 0.5;
+      *reinterpret_cast<int64_t*>(row.mutable_cell_ptr(3)) = (i - 3) * 20 * 60 * 1000000LL;
+      *reinterpret_cast<bool*>(row.mutable_cell_ptr(4)) = i % 2 == 0;
+      *reinterpret_cast<Slice*>(row.mutable_cell_ptr(5)) = Slice("x");
+    }
+  }
+
+ protected:
+  static constexpr int kNumRows = 10;
+
+  // Returns the values of 'pb' over the rows of the block, as formatted by
+  // ColumnBlock::ToString().
+  string Eval(const ExpressionPB& pb) {
+    unique_ptr<Expression> expr;
+    CHECK_OK(Expression::FromPB(pb, schema_, &expr));
+    switch (expr->type()) {
+      case INT64: return EvalInto<INT64>(*expr);
+      case DOUBLE: return EvalInto<DOUBLE>(*expr);
+      case BOOL: return EvalInto<BOOL>(*expr);
+      case UNIXTIME_MICROS: return EvalInto<UNIXTIME_MICROS>(*expr);
+      default: LOG(FATAL) << "unexpected type " << DataType_Name(expr->type());
+    }
+    return "";
+  }
+
+  template <DataType T>
+  string EvalInto(const Expression& expr) {
+    ScopedColumnBlock<T> dst(kNumRows);
+    expr.Evaluate(block_, &dst);
+    return dst.ToString();
+  }
+
+  const Schema schema_;
+  RowBlockMemory memory_;
+  RowBlock block_;
+};
+
+TEST_F(ExpressionTest, TestArithmetic) {
+  EXPECT_EQ("-9 -7 -5 -3 -1 1 3 5 7 9",
+            Eval(Op(ExpressionPB::ADD, { Op(ExpressionPB::MULTIPLY, { Col("i"), Int(2) }),
+                                         Int(1) })));
+  // The NULLs propagate, and so do the divisions by zero.
+  EXPECT_EQ("NULL 1 2 NULL 4 5 NULL 7 8 NULL",
+            Eval(Op(ExpressionPB::DIVIDE, { Col("n"), Int(10) })));
+  EXPECT_EQ("-2 -2 -3 -5 -10 NULL 10 5 3 2",
+            Eval(Op(ExpressionPB::DIVIDE, { Int(10), Col("i") })));
+  EXPECT_EQ("-1 0 -1 0 -1 0 1 0 1 0",
+            Eval(Op(ExpressionPB::MODULO, { Col("i"), Int(2) })));
+  // The integers are promoted to doubles.
+  EXPECT_EQ("-50 -35 -20 -5 10 25 40 55 70 85",
+            Eval(Cast(Op(ExpressionPB::MULTIPLY,
+                         { Op(ExpressionPB::ADD, { Col("d"), Col("i") }), Int(10) }),
+                      INT64)));
+  // The integer arithmetic wraps around.
+  EXPECT_EQ("-9223372036854775808",
+            Eval(Op(ExpressionPB::ADD, { Int(INT64_MAX), Int(1) })).substr(0, 20));
+}
+
+TEST_F(ExpressionTest, TestCasts) {
+  EXPECT_EQ("0 1 3 4 6 7 9 10 12 13",
+            Eval(Cast(Op(ExpressionPB::MULTIPLY, { Col("d"), Int(3) }), INT64)));
+  // The values out of the range of INT64 are NULL.
+  EXPECT_EQ("0 NULL NULL NULL NULL NULL NULL NULL NULL NULL",
+            Eval(Cast(Op(ExpressionPB::MULTIPLY, { Col("d"), Double(1e20) }), INT64)));
+  EXPECT_EQ("true true true true false false false false false false",
+            Eval(Op(ExpressionPB::LESS, { Cast(Col("i"), DOUBLE), Double(-1.5) })));
+}
+
+TEST_F(ExpressionTest, TestLogic) {
+  const ExpressionPB n_gt_30 = Op(ExpressionPB::GREATER, { Col("n"), Int(30) });
+  EXPECT_EQ("true false true NULL true true true true true NULL",
+            Eval(Op(ExpressionPB::OR, { n_gt_30, Col("b") })));
+  EXPECT_EQ("NULL false false false true false NULL false true false",
+            Eval(Op(ExpressionPB::AND, { n_gt_30, Col("b") })));
+  EXPECT_EQ("true false false true false false true false false true",
+            Eval(Op(ExpressionPB::IS_NULL, { Col("n") })));
+  EXPECT_EQ("false true false true false true false true false true",
+            Eval(Op(ExpressionPB::NOT, { Col("b") })));
+}
+
+TEST_F(ExpressionTest, TestCase) {
+  EXPECT_EQ("0 0 0 0 0 50 -1 70 80 -1",
+            Eval(Op(ExpressionPB::CASE,
+                    { Op(ExpressionPB::LESS, { Col("i"), Int(0) }), Int(0),
+                      Op(ExpressionPB::IS_NULL, { Col("n") }), Int(-1),
+                      Col("n") })));
+  // Without a default value, the rows matching no condition are NULL.
+  EXPECT_EQ("-5 NULL -3 NULL -1 NULL 1 NULL 3 NULL",
+            Eval(Op(ExpressionPB::CASE, { Col("b"), Col("i") })));
+}
+
+TEST_F(ExpressionTest, TestTruncateTime) {
+  ExpressionPB truncate = Op(ExpressionPB::TRUNCATE_TIME, { Col("ts") });
+  truncate.set_time_unit(ExpressionPB::HOUR);
+  // In minutes: the times before the epoch are rounded down too.
+  EXPECT_EQ("-60 -60 -60 0 0 0 60 60 60 120",
+            Eval(Op(ExpressionPB::DIVIDE, { Cast(truncate, INT64), Int(60 * 1000000LL) })));
+}
+
+TEST_F(ExpressionTest, TestFilter) {
+  unique_ptr<Expression> expr;
+  ASSERT_OK(Expression::FromPB(
+      Op(ExpressionPB::AND,
+         { Op(ExpressionPB::EQUAL, { Op(ExpressionPB::MODULO, { Col("i"), Int(2) }), Int(0) }),
+           Op(ExpressionPB::NOT, { Op(ExpressionPB::IS_NULL, { Col("n") }) }) }),
+      schema_, &expr));
+  ASSERT_EQ(BOOL, expr->type());
+  SelectionVector sel(kNumRows);
+  sel.SetAllTrue();
+  sel.SetRowUnselected(7);
+  expr->Filter(block_, &sel);
+  vector<int> selected;
+  for (int i = 0; i < kNumRows; i++) {
+    if (sel.IsRowSelected(i)) {
+      selected.emplace_back(i);
+    }
+  }
+  EXPECT_EQ(vector<int>({ 1, 5 }), selected);
+}
+
+TEST_F(ExpressionTest, TestInvalidExpressions) {
+  ExpressionPB truncate_int = Op(ExpressionPB::TRUNCATE_TIME, { Col("i") });
+  truncate_int.set_time_unit(ExpressionPB::DAY);
+  ExpressionPB no_literal;
+  no_literal.set_type(ExpressionPB::LITERAL);
+  ExpressionPB deep = Col("i");
+  for (int i = 0; i < 100; i++) {
+    deep = Op(ExpressionPB::ADD, { deep, Int(1) });
+  }
+  const vector<ExpressionPB> kBadExpressions = {
+    ExpressionPB(),
+    Col("missing"),
+    Col("s"),
+    no_literal,
+    Op(ExpressionPB::ADD, { Col("b"), Int(1) }),
+    Op(ExpressionPB::ADD, { Col("i") }),
+    Op(ExpressionPB::EQUAL, { Col("b"), Col("i") }),
+    Op(ExpressionPB::AND, { Col("b"), Col("i") }),
+    Op(ExpressionPB::CASE, { Col("i"), Int(1) }),
+    Op(ExpressionPB::CASE, { Col("b"), Int(1), Col("b") }),
+    Cast(Col("i"), STRING),
+    Op(ExpressionPB::TRUNCATE_TIME, { Col("ts") }),
+    truncate_int,
+    deep,
+  };
+  for (const auto& pb : kBadExpressions) {
+    SCOPED_TRACE(pb.ShortDebugString());
+    unique_ptr<Expression> expr;
+    Status s = Expression::FromPB(pb, schema_, &expr);
+    ASSERT_FALSE(s.ok());
+  }
+}
+
+} // namespace kudu
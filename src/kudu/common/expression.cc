@@ -0,0 +1,765 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/expression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/bitmap.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+struct Expression::Values {
+  // Sizes the values for 'n' rows of an expression of type 'type'.
+  void Resize(DataType type, size_t n) {
+    if (type == DOUBLE) {
+      doubles.resize(n);
+    } else {
+      ints.resize(n);
+    }
+    non_null.resize(n);
+  }
+
+  // The values of the INT64, UNIXTIME_MICROS and BOOL expressions, the
+  // latter as 0 or 1.
+  vector<int64_t> ints;
+
+  // The values of the DOUBLE expressions.
+  vector<double> doubles;
+
+  // Whether each value isn't NULL, as 0 or 1.
+  vector<uint8_t> non_null;
+};
+
+Expression::~Expression() {
+}
+
+namespace {
+
+using Values = Expression::Values;
+
+// The maximum depth of the expressions, which bounds the recursion of their
+// evaluation.
+constexpr int kMaxDepth = 64;
+
+bool IsNumeric(DataType type) {
+  return type == INT64 || type == DOUBLE || type == UNIXTIME_MICROS;
+}
+
+// Returns the values of 'values', of an expression of type 'type', as
+// doubles, converting them into 'buf' if needed.
+const double* AsDoubles(DataType type, const Values& values, vector<double>* buf) {
+  if (type == DOUBLE) {
+    return values.doubles.data();
+  }
+  buf->resize(values.ints.size());
+  for (size_t i = 0; i < values.ints.size(); i++) {
+    (*buf)[i] = static_cast<double>(values.ints[i]);
+  }
+  return buf->data();
+}
+
+// Whether the value of 'values' at 'i', of a BOOL expression, is true.
+bool IsTrue(const Values& values, size_t i) {
+  return values.non_null[i] && values.ints[i];
+}
+
+class ColumnExpression : public Expression {
+ public:
+  ColumnExpression(DataType type, int col_idx)
+      : Expression(type),
+        col_idx_(col_idx) {
+  }
+
+  void EvaluateValues(const RowBlock& block, Values* values) const override {
+    const ColumnBlock cblock = block.column_block(col_idx_);
+    const size_t n = block.nrows();
+    values->Resize(type(), n);
+    switch (cblock.type_info()->physical_type()) {
+      case BOOL: {
+        const uint8_t* src = cblock.data();
+        for (size_t i = 0; i < n; i++) {
+          values->ints[i] = src[i] != 0;
+        }
+        break;
+      }
+      case INT8: Convert<int8_t>(cblock, n, values->ints.data()); break;
+      case INT16: Convert<int16_t>(cblock, n, values->ints.data()); break;
+      case INT32: Convert<int32_t>(cblock, n, values->ints.data()); break;
+      case INT64: Convert<int64_t>(cblock, n, values->ints.data()); break;
+      case FLOAT: Convert<float>(cblock, n, values->doubles.data()); break;
+      case DOUBLE: Convert<double>(cblock, n, values->doubles.data()); break;
+      default:
+        LOG(FATAL) << "unexpected column type " << cblock.type_info()->name();
+    }
+    if (cblock.is_nullable()) {
+      const uint8_t* bitmap = cblock.non_null_bitmap();
+      for (size_t i = 0; i < n; i++) {
+        values->non_null[i] = BitmapTest(bitmap, i);
+      }
+    } else {
+      std::fill(values->non_null.begin(), values->non_null.end(), 1);
+    }
+  }
+
+ private:
+  template <typename T, typename U>
+  static void Convert(const ColumnBlock& cblock, size_t n, U* dst) {
+    const T* src = reinterpret_cast<const T*>(cblock.data());
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = static_cast<U>(src[i]);
+    }
+  }
+
+  const int col_idx_;
+};
+
+class LiteralExpression : public Expression {
+ public:
+  LiteralExpression(DataType type, int64_t int_value, double double_value)
+      : Expression(type),
+        int_value_(int_value),
+        double_value_(double_value) {
+  }
+
+  void EvaluateValues(const RowBlock& block, Values* values) const override {
+    const size_t n = block.nrows();
+    values->Resize(type(), n);
+    if (type() == DOUBLE) {
+      std::fill(values->doubles.begin(), values->doubles.end(), double_value_);
+    } else {
+      std::fill(values->ints.begin(), values->ints.end(), int_value_);
+    }
+    std::fill(values->non_null.begin(), values->non_null.end(), 1);
+  }
+
+ private:
+  const int64_t int_value_;
+  const double double_value_;
+};
+
+class ArithmeticExpression : public Expression {
+ public:
+  ArithmeticExpression(ExpressionPB::Type op,
+                       unique_ptr<Expression> lhs,
+                       unique_ptr<Expression> rhs)
+      : Expression(lhs->type() == DOUBLE || rhs->type() == DOUBLE ? DOUBLE : INT64),
+        op_(op),
+        lhs_(std::move(lhs)),
+        rhs_(std::move(rhs)) {
+  }
+
+  void EvaluateValues(const RowBlock& block, Values* values) const override {
+    Values a;
+    Values b;
+    lhs_->EvaluateValues(block, &a);
+    rhs_->EvaluateValues(block, &b);
+    const size_t n = block.nrows();
+    values->Resize(type(), n);
+    for (size_t i = 0; i < n; i++) {
+      values->non_null[i] = a.non_null[i] & b.non_null[i];
+    }
+
+    if (type() == DOUBLE) {
+      vector<double> a_buf;
+      vector<double> b_buf;
+      const double* x = AsDoubles(lhs_->type(), a, &a_buf);
+      const double* y = AsDoubles(rhs_->type(), b, &b_buf);
+      double* dst = values->doubles.data();
+      switch (op_) {
+        case ExpressionPB::ADD:
+          for (size_t i = 0; i < n; i++) dst[i] = x[i] + y[i];
+          break;
+        case ExpressionPB::SUBTRACT:
+          for (size_t i = 0; i < n; i++) dst[i] = x[i] - y[i];
+          break;
+        case ExpressionPB::MULTIPLY:
+          for (size_t i = 0; i < n; i++) dst[i] = x[i] * y[i];
+          break;
+        case ExpressionPB::DIVIDE:
+          for (size_t i = 0; i < n; i++) dst[i] = x[i] / y[i];
+          break;
+        case ExpressionPB::MODULO:
+          for (size_t i = 0; i < n; i++) dst[i] = std::fmod(x[i], y[i]);
+          break;
+        default:
+          LOG(FATAL) << "unexpected arithmetic expression " << op_;
+      }
+      return;
+    }
+
+    // The integer arithmetic wraps around: it's done over unsigned integers.
+    const int64_t* x = a.ints.data();
+    const int64_t* y = b.ints.data();
+    int64_t* dst = values->ints.data();
+    switch (op_) {
+      case ExpressionPB::ADD:
+        for (size_t i = 0; i < n; i++) {
+          dst[i] = static_cast<int64_t>(static_cast<uint64_t>(x[i]) + static_cast<uint64_t>(y[i]));
+        }
+        break;
+      case ExpressionPB::SUBTRACT:
+        for (size_t i = 0; i < n; i++) {
+          dst[i] = static_cast<int64_t>(static_cast<uint64_t>(x[i]) - static_cast<uint64_t>(y[i]));
+        }
+        break;
+      case ExpressionPB::MULTIPLY:
+        for (size_t i = 0; i < n; i++) {
+          dst[i] = static_cast<int64_t>(static_cast<uint64_t>(x[i]) * static_cast<uint64_t>(y[i]));
+        }
+        break;
+      case ExpressionPB::DIVIDE:
+      case ExpressionPB::MODULO: {
+        const bool divide = op_ == ExpressionPB::DIVIDE;
+        for (size_t i = 0; i < n; i++) {
+          if (y[i] == 0) {
+            values->non_null[i] = 0;
+            dst[i] = 0;
+          } else if (y[i] == -1) {
+            // Dividing the smallest integer by -1 overflows.
+            dst[i] = divide ? static_cast<int64_t>(0 - static_cast<uint64_t>(x[i])) : 0;
+          } else {
+            dst[i] = divide ? x[i] / y[i] : x[i] % y[i];
+          }
+        }
+        break;
+      }
+      default:
+        LOG(FATAL) << "unexpected arithmetic expression " << op_;
+    }
+  }
+
+ private:
+  const ExpressionPB::Type op_;
+  const unique_ptr<Expression> lhs_;
+  const unique_ptr<Expression> rhs_;
+};
+
+class ComparisonExpression : public Expression {
+ public:
+  ComparisonExpression(ExpressionPB::Type op,
+                       unique_ptr<Expression> lhs,
+                       unique_ptr<Expression> rhs)
+      : Expression(BOOL),
+        op_(op),
+        lhs_(std::move(lhs)),
+        rhs_(std::move(rhs)) {
+  }
+
+  void EvaluateValues(const RowBlock& block, Values* values) const override {
+    Values a;
+    Values b;
+    lhs_->EvaluateValues(block, &a);
+    rhs_->EvaluateValues(block, &b);
+    const size_t n = block.nrows();
+    values->Resize(type(), n);
+    for (size_t i = 0; i < n; i++) {
+      values->non_null[i] = a.non_null[i] & b.non_null[i];
+    }
+    if (lhs_->type() == DOUBLE || rhs_->type() == DOUBLE) {
+      vector<double> a_buf;
+      vector<double> b_buf;
+      Compare(AsDoubles(lhs_->type(), a, &a_buf), AsDoubles(rhs_->type(), b, &b_buf),
+              n, values->ints.data());
+    } else {
+      Compare(a.ints.data(), b.ints.data(), n, values->ints.data());
+    }
+  }
+
+ private:
+  template <typename T>
+  void Compare(const T* x, const T* y, size_t n, int64_t* dst) const {
+    switch (op_) {
+      case ExpressionPB::EQUAL:
+        for (size_t i = 0; i < n; i++) dst[i] = x[i] == y[i];
+        break;
+      case ExpressionPB::NOT_EQUAL:
+        for (size_t i = 0; i < n; i++) dst[i] = x[i] != y[i];
+        break;
+      case ExpressionPB::LESS:
+        for (size_t i = 0; i < n; i++) dst[i] = x[i] < y[i];
+        break;
+      case ExpressionPB::LESS_EQUAL:
+        for (size_t i = 0; i < n; i++) dst[i] = x[i] <= y[i];
+        break;
+      case ExpressionPB::GREATER:
+        for (size_t i = 0; i < n; i++) dst[i] = x[i] > y[i];
+        break;
+      case ExpressionPB::GREATER_EQUAL:
+        for (size_t i = 0; i < n; i++) dst[i] = x[i] >= y[i];
+        break;
+      default:
+        LOG(FATAL) << "unexpected comparison expression " << op_;
+    }
+  }
+
+  const ExpressionPB::Type op_;
+  const unique_ptr<Expression> lhs_;
+  const unique_ptr<Expression> rhs_;
+};
+
+// AND, OR, NOT and IS_NULL.
+class LogicalExpression : public Expression {
+ public:
+  LogicalExpression(ExpressionPB::Type op,
+                    unique_ptr<Expression> lhs,
+                    unique_ptr<Expression> rhs)
+      : Expression(BOOL),
+        op_(op),
+        lhs_(std::move(lhs)),
+        rhs_(std::move(rhs)) {
+  }
+
+  void EvaluateValues(const RowBlock& block, Values* values) const override {
+    Values a;
+    lhs_->EvaluateValues(block, &a);
+    const size_t n = block.nrows();
+    values->Resize(type(), n);
+    switch (op_) {
+      case ExpressionPB::NOT:
+        for (size_t i = 0; i < n; i++) {
+          values->ints[i] = !a.ints[i];
+          values->non_null[i] = a.non_null[i];
+        }
+        return;
+      case ExpressionPB::IS_NULL:
+        for (size_t i = 0; i < n; i++) {
+          values->ints[i] = !a.non_null[i];
+          values->non_null[i] = 1;
+        }
+        return;
+      default:
+        break;
+    }
+
+    // A NULL operand makes the result NULL unless the other operand decides it.
+    Values b;
+    rhs_->EvaluateValues(block, &b);
+    const bool is_and = op_ == ExpressionPB::AND;
+    for (size_t i = 0; i < n; i++) {
+      const bool a_decides = a.non_null[i] && (a.ints[i] != 0) != is_and;
+      const bool b_decides = b.non_null[i] && (b.ints[i] != 0) != is_and;
+      if (a_decides || b_decides) {
+        values->ints[i] = !is_and;
+        values->non_null[i] = 1;
+      } else {
+        values->ints[i] = is_and;
+        values->non_null[i] = a.non_null[i] & b.non_null[i];
+      }
+    }
+  }
+
+ private:
+  const ExpressionPB::Type op_;
+  const unique_ptr<Expression> lhs_;
+  // Unset for NOT and IS_NULL.
+  const unique_ptr<Expression> rhs_;
+};
+
+class CaseExpression : public Expression {
+ public:
+  CaseExpression(DataType type,
+                 vector<unique_ptr<Expression>> conditions,
+                 vector<unique_ptr<Expression>> results,
+                 unique_ptr<Expression> default_result)
+      : Expression(type),
+        conditions_(std::move(conditions)),
+        results_(std::move(results)),
+        default_result_(std::move(default_result)) {
+    DCHECK_EQ(conditions_.size(), results_.size());
+  }
+
+  void EvaluateValues(const RowBlock& block, Values* values) const override {
+    const size_t n = block.nrows();
+    values->Resize(type(), n);
+    if (default_result_) {
+      Values d;
+      default_result_->EvaluateValues(block, &d);
+      AssignWhere(nullptr, d, default_result_->type(), values);
+    } else {
+      std::fill(values->non_null.begin(), values->non_null.end(), 0);
+    }
+    // The first pair whose condition holds wins: assign the pairs from the last.
+    for (int k = conditions_.size() - 1; k >= 0; k--) {
+      Values c;
+      Values r;
+      conditions_[k]->EvaluateValues(block, &c);
+      results_[k]->EvaluateValues(block, &r);
+      AssignWhere(&c, r, results_[k]->type(), values);
+    }
+  }
+
+ private:
+  // Assigns the values of 'src', of an expression of type 'src_type', to
+  // 'dst' where 'cond' is true, or everywhere if 'cond' is null.
+  void AssignWhere(const Values* cond, const Values& src, DataType src_type, Values* dst) const {
+    const size_t n = dst->non_null.size();
+    if (type() == DOUBLE) {
+      vector<double> buf;
+      const double* s = AsDoubles(src_type, src, &buf);
+      for (size_t i = 0; i < n; i++) {
+        if (!cond || IsTrue(*cond, i)) {
+          dst->doubles[i] = s[i];
+          dst->non_null[i] = src.non_null[i];
+        }
+      }
+      return;
+    }
+    for (size_t i = 0; i < n; i++) {
+      if (!cond || IsTrue(*cond, i)) {
+        dst->ints[i] = src.ints[i];
+        dst->non_null[i] = src.non_null[i];
+      }
+    }
+  }
+
+  const vector<unique_ptr<Expression>> conditions_;
+  const vector<unique_ptr<Expression>> results_;
+  const unique_ptr<Expression> default_result_;
+};
+
+class CastExpression : public Expression {
+ public:
+  CastExpression(DataType type, unique_ptr<Expression> arg)
+      : Expression(type),
+        arg_(std::move(arg)) {
+  }
+
+  void EvaluateValues(const RowBlock& block, Values* values) const override {
+    Values a;
+    arg_->EvaluateValues(block, &a);
+    if (arg_->type() == type() || (arg_->type() != DOUBLE && type() != DOUBLE)) {
+      // The integer types share their representation.
+      *values = std::move(a);
+      return;
+    }
+    const size_t n = block.nrows();
+    values->Resize(type(), n);
+    values->non_null = std::move(a.non_null);
+    if (type() == DOUBLE) {
+      for (size_t i = 0; i < n; i++) {
+        values->doubles[i] = static_cast<double>(a.ints[i]);
+      }
+      return;
+    }
+    // -2^63 and 2^63, exactly representable as doubles.
+    constexpr double kMin = -9223372036854775808.0;
+    constexpr double kMax = 9223372036854775808.0;
+    for (size_t i = 0; i < n; i++) {
+      const double d = a.doubles[i];
+      if (std::isnan(d) || d < kMin || d >= kMax) {
+        values->ints[i] = 0;
+        values->non_null[i] = 0;
+      } else {
+        values->ints[i] = static_cast<int64_t>(d);
+      }
+    }
+  }
+
+ private:
+  const unique_ptr<Expression> arg_;
+};
+
+class TruncateTimeExpression : public Expression {
+ public:
+  TruncateTimeExpression(int64_t unit_micros, unique_ptr<Expression> arg)
+      : Expression(UNIXTIME_MICROS),
+        unit_micros_(unit_micros),
+        arg_(std::move(arg)) {
+  }
+
+  void EvaluateValues(const RowBlock& block, Values* values) const override {
+    arg_->EvaluateValues(block, values);
+    for (auto& v : values->ints) {
+      int64_t r = v % unit_micros_;
+      if (r < 0) {
+        r += unit_micros_;
+      }
+      v = static_cast<int64_t>(static_cast<uint64_t>(v) - static_cast<uint64_t>(r));
+    }
+  }
+
+ private:
+  const int64_t unit_micros_;
+  const unique_ptr<Expression> arg_;
+};
+
+Status CheckNumArgs(const ExpressionPB& pb, int num_args) {
+  if (pb.args_size() != num_args) {
+    return Status::InvalidArgument(Substitute(
+        "$0 expression requires $1 arguments, got $2",
+        ExpressionPB::Type_Name(pb.type()), num_args, pb.args_size()));
+  }
+  return Status::OK();
+}
+
+Status CheckArgType(const ExpressionPB& pb, const Expression& arg, bool valid) {
+  if (!valid) {
+    return Status::InvalidArgument(Substitute(
+        "$0 expression doesn't support arguments of type $1",
+        ExpressionPB::Type_Name(pb.type()), DataType_Name(arg.type())));
+  }
+  return Status::OK();
+}
+
+Status BuildExpression(const ExpressionPB& pb, const Schema& schema, int depth,
+                       unique_ptr<Expression>* expr) {
+  if (depth > kMaxDepth) {
+    return Status::InvalidArgument(Substitute("expression deeper than $0 levels", kMaxDepth));
+  }
+  vector<unique_ptr<Expression>> args;
+  args.reserve(pb.args_size());
+  for (const auto& arg_pb : pb.args()) {
+    unique_ptr<Expression> arg;
+    RETURN_NOT_OK(BuildExpression(arg_pb, schema, depth + 1, &arg));
+    args.emplace_back(std::move(arg));
+  }
+
+  switch (pb.type()) {
+    case ExpressionPB::COLUMN: {
+      RETURN_NOT_OK(CheckNumArgs(pb, 0));
+      const int col_idx = schema.find_column(pb.column());
+      if (col_idx == Schema::kColumnNotFound) {
+        return Status::InvalidArgument("unknown column in expression", pb.column());
+      }
+      const ColumnSchema& col = schema.column(col_idx);
+      DataType type;
+      switch (col.type_info()->type()) {
+        case INT8:
+        case INT16:
+        case INT32:
+        case INT64:
+        case DATE:
+          type = INT64;
+          break;
+        case FLOAT:
+        case DOUBLE:
+          type = DOUBLE;
+          break;
+        case BOOL:
+          type = BOOL;
+          break;
+        case UNIXTIME_MICROS:
+          type = UNIXTIME_MICROS;
+          break;
+        default:
+          return Status::NotSupported(Substitute(
+              "expressions don't support column $0 of type $1",
+              col.name(), col.type_info()->name()));
+      }
+      expr->reset(new ColumnExpression(type, col_idx));
+      return Status::OK();
+    }
+    case ExpressionPB::LITERAL: {
+      RETURN_NOT_OK(CheckNumArgs(pb, 0));
+      if (pb.has_int_value() + pb.has_double_value() + pb.has_bool_value() != 1) {
+        return Status::InvalidArgument("literal expression requires exactly one value");
+      }
+      if (pb.has_int_value()) {
+        expr->reset(new LiteralExpression(INT64, pb.int_value(), 0));
+      } else if (pb.has_double_value()) {
+        expr->reset(new LiteralExpression(DOUBLE, 0, pb.double_value()));
+      } else {
+        expr->reset(new LiteralExpression(BOOL, pb.bool_value(), 0));
+      }
+      return Status::OK();
+    }
+    case ExpressionPB::ADD:
+    case ExpressionPB::SUBTRACT:
+    case ExpressionPB::MULTIPLY:
+    case ExpressionPB::DIVIDE:
+    case ExpressionPB::MODULO:
+      RETURN_NOT_OK(CheckNumArgs(pb, 2));
+      for (const auto& arg : args) {
+        RETURN_NOT_OK(CheckArgType(pb, *arg, IsNumeric(arg->type())));
+      }
+      expr->reset(new ArithmeticExpression(pb.type(), std::move(args[0]), std::move(args[1])));
+      return Status::OK();
+    case ExpressionPB::EQUAL:
+    case ExpressionPB::NOT_EQUAL:
+    case ExpressionPB::LESS:
+    case ExpressionPB::LESS_EQUAL:
+    case ExpressionPB::GREATER:
+    case ExpressionPB::GREATER_EQUAL:
+      RETURN_NOT_OK(CheckNumArgs(pb, 2));
+      RETURN_NOT_OK(CheckArgType(
+          pb, *args[1],
+          IsNumeric(args[0]->type()) ? IsNumeric(args[1]->type()) : args[1]->type() == BOOL));
+      expr->reset(new ComparisonExpression(pb.type(), std::move(args[0]), std::move(args[1])));
+      return Status::OK();
+    case ExpressionPB::AND:
+    case ExpressionPB::OR:
+    case ExpressionPB::NOT:
+      RETURN_NOT_OK(CheckNumArgs(pb, pb.type() == ExpressionPB::NOT ? 1 : 2));
+      for (const auto& arg : args) {
+        RETURN_NOT_OK(CheckArgType(pb, *arg, arg->type() == BOOL));
+      }
+      expr->reset(new LogicalExpression(
+          pb.type(), std::move(args[0]), args.size() > 1 ? std::move(args[1]) : nullptr));
+      return Status::OK();
+    case ExpressionPB::IS_NULL:
+      RETURN_NOT_OK(CheckNumArgs(pb, 1));
+      expr->reset(new LogicalExpression(pb.type(), std::move(args[0]), nullptr));
+      return Status::OK();
+    case ExpressionPB::CASE: {
+      if (args.size() < 2) {
+        return Status::InvalidArgument("CASE expression requires a condition and a value");
+      }
+      vector<unique_ptr<Expression>> conditions;
+      vector<unique_ptr<Expression>> results;
+      unique_ptr<Expression> default_result;
+      if (args.size() % 2 == 1) {
+        default_result = std::move(args.back());
+        args.pop_back();
+      }
+      for (size_t i = 0; i < args.size(); i += 2) {
+        RETURN_NOT_OK(CheckArgType(pb, *args[i], args[i]->type() == BOOL));
+        conditions.emplace_back(std::move(args[i]));
+        results.emplace_back(std::move(args[i + 1]));
+      }
+      if (default_result) {
+        results.emplace_back(std::move(default_result));
+      }
+      // The values must all be BOOL, all UNIXTIME_MICROS, or numeric, in
+      // which case they're promoted to DOUBLE if any of them is.
+      DataType type = results[0]->type();
+      for (const auto& result : results) {
+        const DataType t = result->type();
+        if (t == type) {
+          continue;
+        }
+        RETURN_NOT_OK(CheckArgType(pb, *result, IsNumeric(t) && IsNumeric(type)));
+        type = (t == DOUBLE || type == DOUBLE) ? DOUBLE : INT64;
+      }
+      if (conditions.size() < results.size()) {
+        default_result = std::move(results.back());
+        results.pop_back();
+      }
+      expr->reset(new CaseExpression(type, std::move(conditions), std::move(results),
+                                     std::move(default_result)));
+      return Status::OK();
+    }
+    case ExpressionPB::CAST:
+      RETURN_NOT_OK(CheckNumArgs(pb, 1));
+      if (pb.cast_type() != INT64 && pb.cast_type() != DOUBLE) {
+        return Status::InvalidArgument(Substitute(
+            "unsupported CAST expression type: $0", DataType_Name(pb.cast_type())));
+      }
+      expr->reset(new CastExpression(pb.cast_type(), std::move(args[0])));
+      return Status::OK();
+    case ExpressionPB::TRUNCATE_TIME: {
+      RETURN_NOT_OK(CheckNumArgs(pb, 1));
+      RETURN_NOT_OK(CheckArgType(pb, *args[0], args[0]->type() == UNIXTIME_MICROS));
+      int64_t unit_micros;
+      switch (pb.time_unit()) {
+        case ExpressionPB::MILLISECOND: unit_micros = 1000LL; break;
+        case ExpressionPB::SECOND: unit_micros = 1000LL * 1000; break;
+        case ExpressionPB::MINUTE: unit_micros = 60LL * 1000 * 1000; break;
+        case ExpressionPB::HOUR: unit_micros = 60LL * 60 * 1000 * 1000; break;
+        case ExpressionPB::DAY: unit_micros = 24LL * 60 * 60 * 1000 * 1000; break;
+        default:
+          return Status::InvalidArgument("TRUNCATE_TIME expression requires a time unit");
+      }
+      expr->reset(new TruncateTimeExpression(unit_micros, std::move(args[0])));
+      return Status::OK();
+    }
+    default:
+      return Status::InvalidArgument(Substitute(
+          "unknown expression type: $0", ExpressionPB::Type_Name(pb.type())));
+  }
+}
+
+} // anonymous namespace
+
+Status Expression::FromPB(const ExpressionPB& pb, const Schema& schema,
+                          unique_ptr<Expression>* expr) {
+  return BuildExpression(pb, schema, 0, expr);
+}
+
+void Expression::GetReferencedColumns(const ExpressionPB& pb, vector<string>* columns) {
+  if (pb.type() == ExpressionPB::COLUMN) {
+    columns->emplace_back(pb.column());
+  }
+  for (const auto& arg : pb.args()) {
+    GetReferencedColumns(arg, columns);
+  }
+}
+
+void Expression::Evaluate(const RowBlock& block, ColumnBlock* dst) const {
+  DCHECK(dst->is_nullable());
+  DCHECK_GE(dst->nrows(), block.nrows());
+  const size_t n = block.nrows();
+  if (n == 0) {
+    return;
+  }
+  Values values;
+  EvaluateValues(block, &values);
+  switch (type_) {
+    case BOOL: {
+      bool* data = reinterpret_cast<bool*>(dst->data());
+      for (size_t i = 0; i < n; i++) {
+        data[i] = values.ints[i] != 0;
+      }
+      break;
+    }
+    case INT64:
+    case UNIXTIME_MICROS:
+      memcpy(dst->data(), values.ints.data(), n * sizeof(int64_t));
+      break;
+    case DOUBLE:
+      memcpy(dst->data(), values.doubles.data(), n * sizeof(double));
+      break;
+    default:
+      LOG(FATAL) << "unexpected expression type " << DataType_Name(type_);
+  }
+  uint8_t* non_null_bitmap = dst->non_null_bitmap();
+  for (size_t i = 0; i < n; i++) {
+    BitmapChange(non_null_bitmap, i, values.non_null[i]);
+  }
+}
+
+void Expression::Filter(const RowBlock& block, SelectionVector* sel) const {
+  DCHECK_EQ(BOOL, type_);
+  if (block.nrows() == 0 || !sel->AnySelected()) {
+    return;
+  }
+  Values values;
+  EvaluateValues(block, &values);
+  for (size_t i = 0; i < block.nrows(); i++) {
+    if (!IsTrue(values, i)) {
+      sel->SetRowUnselected(i);
+    }
+  }
+}
+
+} // namespace kudu
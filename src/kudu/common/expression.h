@@ -0,0 +1,92 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ColumnBlock;
+class RowBlock;
+class Schema;
+class SelectionVector;
+
+// A scalar expression over the columns of the rows of a RowBlock, built from
+// an ExpressionPB (see common.proto for the supported expressions and their
+// types).
+//
+// The expressions are evaluated a block at a time: each node of an
+// expression computes its values over all the rows of the block in a tight
+// loop before handing them to its parent, rather than the whole expression
+// being interpreted row by row. The nodes evaluate the unselected rows as
+// well, which is cheaper than checking the selection of each row.
+//
+// This class is thread-safe.
+class Expression {
+ public:
+  // The values of an expression over the rows of a block.
+  struct Values;
+
+  virtual ~Expression();
+
+  // Builds the expression of 'pb' over the columns of 'schema' into 'expr'.
+  static Status FromPB(const ExpressionPB& pb, const Schema& schema,
+                       std::unique_ptr<Expression>* expr);
+
+  // Appends the names of the columns referred to by 'pb' to 'columns'.
+  static void GetReferencedColumns(const ExpressionPB& pb, std::vector<std::string>* columns);
+
+  // The type of the values of the expression: INT64, DOUBLE, BOOL or
+  // UNIXTIME_MICROS.
+  DataType type() const {
+    return type_;
+  }
+
+  // Evaluates the expression over the rows of 'block' into 'dst', a nullable
+  // column block of type() with at least as many rows.
+  //
+  // REQUIRES: 'block' has the schema passed to FromPB().
+  void Evaluate(const RowBlock& block, ColumnBlock* dst) const;
+
+  // Unselects the rows of 'block' for which this BOOL expression doesn't
+  // evaluate to true from 'sel'.
+  //
+  // REQUIRES: 'block' has the schema passed to FromPB().
+  void Filter(const RowBlock& block, SelectionVector* sel) const;
+
+  // Evaluates the expression over the rows of 'block' into 'values'. Used by
+  // the nodes of the expression to evaluate their arguments.
+  virtual void EvaluateValues(const RowBlock& block, Values* values) const = 0;
+
+ protected:
+  explicit Expression(DataType type)
+      : type_(type) {
+  }
+
+ private:
+  const DataType type_;
+
+  DISALLOW_COPY_AND_ASSIGN(Expression);
+};
+
+} // namespace kudu
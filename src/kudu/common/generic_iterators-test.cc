@@ -62,6 +62,7 @@
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
+#include "kudu/util/threadpool.h"
 
 DEFINE_int32(num_lists, 3, "Number of lists to merge");
 DEFINE_int32(num_rows, 1000, "Number of entries per list");
@@ -512,8 +513,136 @@ TEST(TestMergeIterator, TestDeDupGhostRows) {
                       /*include_deleted_rows=*/true));
 }
 
+// Tests merging sub-iterators which interleave in runs of rows, of various
+// lengths relative to their blocks and to the merged blocks.
+TEST(TestMergeIterator, TestMergeRuns) {
+  const int kNumIters = 3;
+  const int kNumRows = 3000;
+  for (int run_length : { 1, 7, 50, 300 }) {
+    SCOPED_TRACE(run_length);
+    vector<vector<int64_t>> ints(kNumIters);
+    for (int i = 0; i < kNumRows; i++) {
+      ints[(i / run_length) % kNumIters].emplace_back(i);
+    }
+    vector<IterWithBounds> input;
+    for (int i = 0; i < kNumIters; i++) {
+      unique_ptr<VectorIterator> vec(new VectorIterator(ints[i]));
+      vec->set_block_size(16 << i);
+      IterWithBounds iwb;
+      iwb.iter = NewMaterializingIterator(std::move(vec));
+      input.emplace_back(std::move(iwb));
+    }
+    unique_ptr<RowwiseIterator> merger(NewMergeIterator(
+        MergeIteratorOptions(/*include_deleted_rows=*/false), std::move(input)));
+    ASSERT_OK(merger->Init(nullptr));
+
+    RowBlockMemory mem;
+    RowBlock dst(&kIntSchema, 128, &mem);
+    int64_t expected = 0;
+    while (merger->HasNext()) {
+      ASSERT_OK(merger->NextBlock(&dst));
+      for (int i = 0; i < dst.nrows(); i++) {
+        if (!dst.selection_vector()->IsRowSelected(i)) {
+          continue;
+        }
+        ASSERT_EQ(expected++,
+                  *kIntSchema.ExtractColumnFromRow<INT64>(dst.row(i), kValColIdx));
+      }
+    }
+    ASSERT_EQ(kNumRows, expected);
+  }
+}
+
 // Test that the MaterializingIterator properly evaluates predicates when they apply
 // to single columns.
+// Builds 'num_iters' materializing iterators over consecutive ranges of
+// 'ints_per_iter' integers.
+static vector<IterWithBounds> MakeConsecutiveIterators(int num_iters, int ints_per_iter) {
+  vector<IterWithBounds> iters;
+  for (int i = 0; i < num_iters; i++) {
+    vector<int64_t> ints(ints_per_iter);
+    for (int j = 0; j < ints_per_iter; j++) {
+      ints[j] = i * ints_per_iter + j;
+    }
+    unique_ptr<VectorIterator> vec(new VectorIterator(ints));
+    vec->set_block_size(16);
+    IterWithBounds iwb;
+    iwb.iter = NewMaterializingIterator(std::move(vec));
+    iters.emplace_back(std::move(iwb));
+  }
+  return iters;
+}
+
+TEST(TestParallelUnionIterator, TestParallelUnion) {
+  constexpr int kNumIters = 20;
+  constexpr int kIntsPerIter = 500;
+  unique_ptr<ThreadPool> pool;
+  ASSERT_OK(ThreadPoolBuilder("test").set_max_threads(4).Build(&pool));
+
+  for (bool with_predicate : { false, true }) {
+    SCOPED_TRACE(with_predicate);
+    ParallelUnionIteratorOptions opts;
+    opts.pool = pool.get();
+    opts.max_concurrency = 4;
+    opts.max_buffered_blocks = 2;
+    opts.block_rows = 32;
+    unique_ptr<RowwiseIterator> iter(NewParallelUnionIterator(
+        opts, MakeConsecutiveIterators(kNumIters, kIntsPerIter)));
+
+    ScanSpec spec;
+    TestIntRangePredicate pred(1000, 8000);
+    if (with_predicate) {
+      spec.AddPredicate(pred.pred_);
+    }
+    ASSERT_OK(iter->Init(&spec));
+    ASSERT_TRUE(spec.predicates().empty());
+
+    // Smaller than the materialized blocks, so that they're consumed in
+    // several calls.
+    RowBlockMemory mem;
+    RowBlock dst(&kIntSchema, 10, &mem);
+    vector<int64_t> results;
+    while (iter->HasNext()) {
+      ASSERT_OK(iter->NextBlock(&dst));
+      for (int i = 0; i < dst.nrows(); i++) {
+        if (dst.selection_vector()->IsRowSelected(i)) {
+          results.push_back(*kIntSchema.ExtractColumnFromRow<INT64>(dst.row(i), kValColIdx));
+        }
+      }
+    }
+    std::sort(results.begin(), results.end());
+
+    int64_t lower = with_predicate ? 1000 : 0;
+    int64_t upper = with_predicate ? 8000 : kNumIters * kIntsPerIter;
+    ASSERT_EQ(upper - lower, static_cast<int64_t>(results.size()));
+    for (int i = 0; i < results.size(); i++) {
+      ASSERT_EQ(lower + i, results[i]);
+    }
+  }
+}
+
+// Test that a ParallelUnionIterator can be destroyed while its sub-iterators
+// are still being materialized.
+TEST(TestParallelUnionIterator, TestNotConsumedCleanup) {
+  unique_ptr<ThreadPool> pool;
+  ASSERT_OK(ThreadPoolBuilder("test").set_max_threads(4).Build(&pool));
+  ParallelUnionIteratorOptions opts;
+  opts.pool = pool.get();
+  opts.max_concurrency = 4;
+  opts.max_buffered_blocks = 1;
+  unique_ptr<RowwiseIterator> iter(NewParallelUnionIterator(
+      opts, MakeConsecutiveIterators(10, 1000)));
+  ASSERT_OK(iter->Init(nullptr));
+
+  ASSERT_TRUE(iter->HasNext());
+  RowBlockMemory mem;
+  RowBlock dst(&kIntSchema, 1, &mem);
+  ASSERT_OK(iter->NextBlock(&dst));
+  ASSERT_EQ(1, dst.nrows());
+  ASSERT_TRUE(iter->HasNext());
+  iter.reset();
+}
+
 TEST(TestMaterializingIterator, TestMaterializingPredicatePushdown) {
   ScanSpec spec;
   TestIntRangePredicate pred1(20, 30);
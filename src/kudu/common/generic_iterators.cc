@@ -62,10 +62,14 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/condition_variable.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/object_pool.h"
+#include "kudu/util/status.h"
+#include "kudu/util/threadpool.h"
 
 namespace boost {
 namespace heap {
@@ -209,6 +213,15 @@ class MergeIterState : public boost::intrusive::list_base_hook<> {
   // If successful, 'num_rows_copied' will be set to the number of rows copied.
   Status CopyBlock(RowBlock* dst, size_t dst_offset, size_t* num_rows_copied);
 
+  // Returns the number of rows, up to 'max_rows', of the current block of
+  // buffered rows, starting at next_row(), whose selected rows all sort before
+  // 'bound'.
+  size_t CountRowsBefore(const RowBlockRow& bound, size_t max_rows) const;
+
+  // Copies 'num_rows' rows from the current block of buffered rows, starting
+  // at next_row(), to 'dst' (starting at 'dst_offset').
+  Status CopyRows(RowBlock* dst, size_t dst_offset, size_t num_rows);
+
   // Returns true if the current block in the underlying iterator is exhausted.
   bool IsBlockExhausted() const {
     return !read_block_ || read_block_->nrows() == next_row_idx_;
@@ -339,14 +352,46 @@ Status MergeIterState::CopyBlock(RowBlock* dst, size_t dst_offset,
 
   size_t num_rows_to_copy = std::min(remaining_in_block(),
                                      dst->nrows() - dst_offset);
+  RETURN_NOT_OK(CopyRows(dst, dst_offset, num_rows_to_copy));
+  *num_rows_copied = num_rows_to_copy;
+  return Status::OK();
+}
+
+size_t MergeIterState::CountRowsBefore(const RowBlockRow& bound, size_t max_rows) const {
+  DCHECK(read_block_);
+  DCHECK(!IsBlockExhausted());
+  max_rows = std::min(max_rows, remaining_in_block());
+
+  // If the bound lies beyond the last row, the whole block sorts before it,
+  // and there's no need to compare the rows one by one.
+  if (max_rows == remaining_in_block() &&
+      schema().Compare(last_row_, bound) < 0) {
+    return max_rows;
+  }
+  const SelectionVector* selection = read_block_->selection_vector();
+  RowBlockRow row(read_block_.get(), next_row_idx_);
+  size_t num_rows = 0;
+  for (; num_rows < max_rows; num_rows++) {
+    const size_t row_idx = next_row_idx_ + num_rows;
+    if (!selection->IsRowSelected(row_idx)) {
+      continue;
+    }
+    row.Reset(read_block_.get(), row_idx);
+    if (schema().Compare(row, bound) >= 0) {
+      break;
+    }
+  }
+  return num_rows;
+}
+
+Status MergeIterState::CopyRows(RowBlock* dst, size_t dst_offset, size_t num_rows) {
+  DCHECK(read_block_);
+  DCHECK_LE(num_rows, remaining_in_block());
   VLOG(3) << Substitute(
       "Copying $0 rows from RowBlock (s:$1,o:$2) to RowBlock (s:$3,o:$4): $5",
-      num_rows_to_copy, read_block_->nrows(), next_row_idx_, dst->nrows(),
+      num_rows, read_block_->nrows(), next_row_idx_, dst->nrows(),
       dst_offset, ToString());
-  RETURN_NOT_OK(read_block_->CopyTo(dst, next_row_idx_,
-                                    dst_offset, num_rows_to_copy));
-  *num_rows_copied = num_rows_to_copy;
-  return Status::OK();
+  return read_block_->CopyTo(dst, next_row_idx_, dst_offset, num_rows);
 }
 
 // An iterator which merges the results of other iterators, comparing
@@ -498,6 +543,16 @@ class MergeIterator : public RowwiseIterator {
   // On success, the selection vector in 'dst' and 'dst_row_idx' are both updated.
   Status MaterializeBlock(RowBlock* dst, size_t* dst_row_idx);
 
+  // Materializes the run of rows of the sub-iterator at the top of the hot
+  // heap which sort before the next row of every other sub-iterator into
+  // 'dst' at offset 'dst_row_idx', as a single copy and a single reheap. Only
+  // permitted when there are several sub-iterators in the hot heap.
+  //
+  // On success, the selection vector in 'dst' and 'dst_row_idx' are both
+  // updated. Materializes no rows if the next row of the top sub-iterator
+  // compares equal to another, i.e. if MaterializeOneRow() must deduplicate it.
+  Status MaterializeRun(RowBlock* dst, size_t* dst_row_idx);
+
   // Finds the next row and materializes it into 'dst' at offset 'dst_row_idx'.
   //
   // On success, the selection vector in 'dst' and 'dst_row_idx' are both updated.
@@ -788,7 +843,17 @@ Status MergeIterator::NextBlock(RowBlock* dst) {
     // rather than copying it.
     if (hot_.size() == 1 && hot_.top()->remaining_in_block() > 1) {
       RETURN_NOT_OK(MaterializeBlock(dst, &dst_row_idx));
-    } else {
+      continue;
+    }
+
+    // Otherwise, the top sub-iterator may still have a run of rows preceding
+    // all the others: copy it all at once rather than row-by-row, each row
+    // going through the heap.
+    const size_t prev_dst_row_idx = dst_row_idx;
+    if (hot_.size() > 1) {
+      RETURN_NOT_OK(MaterializeRun(dst, &dst_row_idx));
+    }
+    if (dst_row_idx == prev_dst_row_idx) {
       RETURN_NOT_OK(MaterializeOneRow(dst, &dst_row_idx));
     }
   }
@@ -813,6 +878,30 @@ Status MergeIterator::MaterializeBlock(RowBlock* dst, size_t* dst_row_idx) {
   return Status::OK();
 }
 
+Status MergeIterator::MaterializeRun(RowBlock* dst, size_t* dst_row_idx) {
+  DCHECK_GT(hot_.size(), 1);
+
+  // The run ends at the smallest next row of the other sub-iterators: the
+  // second hot sub-iterator in heap order, or the top cold one.
+  auto iter = hot_.ordered_begin();
+  MergeIterState* state = *iter;
+  ++iter;
+  const RowBlockRow* bound = &(*iter)->next_row();
+  if (!cold_.empty() && schema_->Compare(cold_.top()->next_row(), *bound) < 0) {
+    bound = &cold_.top()->next_row();
+  }
+  const size_t num_rows = state->CountRowsBefore(*bound, dst->nrows() - *dst_row_idx);
+  if (num_rows == 0) {
+    return Status::OK();
+  }
+  RETURN_NOT_OK(state->CopyRows(dst, *dst_row_idx, num_rows));
+  RETURN_NOT_OK(AdvanceAndReheap(state, num_rows));
+
+  // CopyRows() already updated dst's SelectionVector.
+  *dst_row_idx += num_rows;
+  return Status::OK();
+}
+
 // TODO(todd): this is an obvious spot to add codegen - there's a ton of branching
 // and such around the comparisons. A simple experiment indicated there's some
 // 2x to be gained.
@@ -1109,6 +1198,310 @@ unique_ptr<RowwiseIterator> NewUnionIterator(vector<IterWithBounds> iters) {
   return unique_ptr<RowwiseIterator>(new UnionIterator(std::move(iters)));
 }
 
+////////////////////////////////////////////////////////////
+// ParallelUnionIterator
+////////////////////////////////////////////////////////////
+
+// An iterator which unions the results of other iterators, materializing
+// several of them at once on a thread pool.
+//
+// The sub-iterators are materialized one block at a time by worker tasks
+// which queue the blocks for the consumer. A worker exits rather than block
+// when the queue is full, so an idle consumer never ties up the threads of the
+// pool: the consumer starts new workers as it drains the queue.
+class ParallelUnionIterator : public RowwiseIterator {
+ public:
+  ParallelUnionIterator(ParallelUnionIteratorOptions opts, vector<IterWithBounds> iters);
+
+  ~ParallelUnionIterator() override;
+
+  Status Init(ScanSpec* spec) override;
+
+  bool HasNext() const override;
+
+  string ToString() const override;
+
+  const Schema& schema() const override {
+    CHECK(initted_);
+    return *CHECK_NOTNULL(schema_.get());
+  }
+
+  // The statistics of the sub-iterators are only accounted for once they've
+  // been exhausted: while they're being materialized, they can't be accessed
+  // from the calling thread.
+  void GetIteratorStats(vector<IteratorStats>* stats) const override;
+
+  Status NextBlock(RowBlock* dst) override;
+
+ private:
+  // A block materialized by one of the sub-iterators, along with its memory.
+  struct Block {
+    Block(const Schema* schema, size_t nrows)
+        : block(schema, nrows, &memory) {
+    }
+
+    RowBlockMemory memory;
+    RowBlock block;
+  };
+
+  // Materializes blocks of the pending sub-iterators until there are none
+  // left, the queue is full, or the iteration is cancelled or fails.
+  void RunWorker();
+
+  // Starts as many workers as useful and allowed.
+  //
+  // 'lock_' must be held.
+  void MaybeStartWorkersUnlocked();
+
+  // Waits until there's a block to consume, all the sub-iterators are
+  // exhausted, or one of them failed.
+  //
+  // 'lock_' must be held.
+  void WaitForBlockUnlocked() const;
+
+  const ParallelUnionIteratorOptions opts_;
+
+  // Schema: initialized during Init()
+  unique_ptr<Schema> schema_;
+
+  bool initted_;
+
+  // The sub-iterators. Each is only accessed by the worker which popped it
+  // from 'pending_iters_', until it's pushed back.
+  vector<IterWithBounds> iters_;
+
+  // Initialized during Init(), since the sub-iterators may not be accessed
+  // once they're being materialized.
+  string to_string_;
+
+  // See UnionIterator::scan_spec_copies_.
+  ObjectPool<ScanSpec> scan_spec_copies_;
+
+  // The token of the worker tasks.
+  unique_ptr<ThreadPoolToken> token_;
+
+  // Protects all of the below, except for 'cur_block_' and
+  // 'cur_block_offset_'.
+  mutable Mutex lock_;
+
+  // Signaled when a block is queued, or when a worker exits.
+  ConditionVariable block_available_;
+
+  // The sub-iterators which have more rows and aren't being materialized.
+  deque<RowwiseIterator*> pending_iters_;
+
+  int num_running_workers_;
+
+  // Set upon destruction to stop the workers early.
+  bool cancelled_;
+
+  // The first error encountered by any of the workers.
+  Status status_;
+
+  // The blocks materialized so far and not yet consumed.
+  deque<unique_ptr<Block>> blocks_;
+
+  // Statistics (keyed by projection column index) accumulated so far by any
+  // fully-consumed sub-iterators.
+  vector<IteratorStats> finished_iter_stats_by_col_;
+
+  // The block being consumed, and the index of its first unconsumed row.
+  // Only accessed by the consumer.
+  unique_ptr<Block> cur_block_;
+  size_t cur_block_offset_;
+};
+
+ParallelUnionIterator::ParallelUnionIterator(ParallelUnionIteratorOptions opts,
+                                             vector<IterWithBounds> iters)
+    : opts_(opts),
+      initted_(false),
+      iters_(std::move(iters)),
+      block_available_(&lock_),
+      num_running_workers_(0),
+      cancelled_(false),
+      cur_block_offset_(0) {
+  CHECK_GT(iters_.size(), 0);
+  CHECK(opts_.pool);
+  CHECK_GT(opts_.max_concurrency, 0);
+  CHECK_GT(opts_.max_buffered_blocks, 0);
+  CHECK_GT(opts_.block_rows, 0);
+}
+
+ParallelUnionIterator::~ParallelUnionIterator() {
+  {
+    std::lock_guard<Mutex> l(lock_);
+    cancelled_ = true;
+  }
+  if (token_) {
+    // Waits for the running workers, which exit after their current block.
+    token_->Shutdown();
+  }
+}
+
+Status ParallelUnionIterator::Init(ScanSpec* spec) {
+  CHECK(!initted_);
+
+  // See UnionIterator::InitSubIterators().
+  for (auto& i : iters_) {
+    ScanSpec* spec_copy = spec != nullptr ? scan_spec_copies_.Construct(*spec) : nullptr;
+    RETURN_NOT_OK(InitAndMaybeWrap(&i.iter, spec_copy));
+    i.encoded_bounds.reset();
+  }
+  if (spec != nullptr) {
+    spec->RemovePredicates();
+  }
+
+  schema_.reset(new Schema(iters_.front().iter->schema()));
+  finished_iter_stats_by_col_.resize(schema_->num_columns());
+#ifndef NDEBUG
+  for (const auto& i : iters_) {
+    if (i.iter->schema() != *schema_) {
+      return Status::InvalidArgument(
+          Substitute("Schemas do not match: $0 vs. $1",
+                     schema_->ToString(), i.iter->schema().ToString()));
+    }
+  }
+#endif
+  to_string_ = Substitute("ParallelUnion($0)", JoinMapped(iters_, [](const IterWithBounds& i) {
+      return i.iter->ToString();
+    }, ","));
+
+  for (const auto& i : iters_) {
+    if (i.iter->HasNext()) {
+      pending_iters_.push_back(i.iter.get());
+    } else {
+      AddIterStats(*i.iter, &finished_iter_stats_by_col_);
+    }
+  }
+  initted_ = true;
+
+  token_ = opts_.pool->NewToken(ThreadPool::ExecutionMode::CONCURRENT);
+  std::lock_guard<Mutex> l(lock_);
+  MaybeStartWorkersUnlocked();
+  return status_;
+}
+
+void ParallelUnionIterator::MaybeStartWorkersUnlocked() {
+  lock_.AssertAcquired();
+  while (status_.ok() &&
+         num_running_workers_ < opts_.max_concurrency &&
+         num_running_workers_ < static_cast<int>(pending_iters_.size()) &&
+         static_cast<int>(blocks_.size()) + num_running_workers_ < opts_.max_buffered_blocks) {
+    Status s = token_->Submit([this]() { RunWorker(); });
+    if (PREDICT_FALSE(!s.ok())) {
+      status_ = s.CloneAndPrepend("unable to start a scan worker");
+      return;
+    }
+    num_running_workers_++;
+  }
+}
+
+void ParallelUnionIterator::RunWorker() {
+  unique_ptr<Block> block;
+  while (true) {
+    RowwiseIterator* iter;
+    {
+      std::lock_guard<Mutex> l(lock_);
+      if (cancelled_ || !status_.ok() || pending_iters_.empty() ||
+          static_cast<int>(blocks_.size()) >= opts_.max_buffered_blocks) {
+        num_running_workers_--;
+        block_available_.Signal();
+        return;
+      }
+      iter = pending_iters_.front();
+      pending_iters_.pop_front();
+    }
+
+    if (block) {
+      block->memory.Reset();
+    } else {
+      block.reset(new Block(schema_.get(), opts_.block_rows));
+    }
+    Status s = iter->NextBlock(&block->block);
+    const bool has_next = s.ok() && iter->HasNext();
+
+    std::lock_guard<Mutex> l(lock_);
+    if (PREDICT_FALSE(!s.ok())) {
+      if (status_.ok()) {
+        status_ = s;
+      }
+      continue;
+    }
+    if (has_next) {
+      // Keep going with the same sub-iterator, if no other worker picks it.
+      pending_iters_.push_front(iter);
+    } else {
+      AddIterStats(*iter, &finished_iter_stats_by_col_);
+    }
+    if (block->block.selection_vector()->AnySelected()) {
+      blocks_.emplace_back(std::move(block));
+      block_available_.Signal();
+    }
+  }
+}
+
+void ParallelUnionIterator::WaitForBlockUnlocked() const {
+  lock_.AssertAcquired();
+  while (blocks_.empty() && status_.ok() && num_running_workers_ > 0) {
+    block_available_.Wait();
+  }
+  // The workers only exit with pending sub-iterators if the queue is full.
+  DCHECK(!blocks_.empty() || !status_.ok() || pending_iters_.empty());
+}
+
+bool ParallelUnionIterator::HasNext() const {
+  CHECK(initted_);
+  if (cur_block_) {
+    return true;
+  }
+  std::lock_guard<Mutex> l(lock_);
+  WaitForBlockUnlocked();
+  // If a worker failed, let NextBlock() return the error.
+  return !blocks_.empty() || !status_.ok();
+}
+
+Status ParallelUnionIterator::NextBlock(RowBlock* dst) {
+  CHECK(initted_);
+  if (!cur_block_) {
+    std::lock_guard<Mutex> l(lock_);
+    WaitForBlockUnlocked();
+    RETURN_NOT_OK(status_);
+    if (blocks_.empty()) {
+      dst->Resize(0);
+      return Status::OK();
+    }
+    cur_block_ = std::move(blocks_.front());
+    blocks_.pop_front();
+    cur_block_offset_ = 0;
+    MaybeStartWorkersUnlocked();
+  }
+
+  const RowBlock& src = cur_block_->block;
+  const size_t num_rows = std::min(src.nrows() - cur_block_offset_, dst->row_capacity());
+  dst->Resize(num_rows);
+  RETURN_NOT_OK(src.CopyTo(dst, cur_block_offset_, 0, num_rows));
+  cur_block_offset_ += num_rows;
+  if (cur_block_offset_ == src.nrows()) {
+    cur_block_.reset();
+  }
+  return Status::OK();
+}
+
+string ParallelUnionIterator::ToString() const {
+  return to_string_;
+}
+
+void ParallelUnionIterator::GetIteratorStats(vector<IteratorStats>* stats) const {
+  CHECK(initted_);
+  std::lock_guard<Mutex> l(lock_);
+  *stats = finished_iter_stats_by_col_;
+}
+
+unique_ptr<RowwiseIterator> NewParallelUnionIterator(
+    ParallelUnionIteratorOptions opts, vector<IterWithBounds> iters) {
+  return unique_ptr<RowwiseIterator>(new ParallelUnionIterator(opts, std::move(iters)));
+}
+
 ////////////////////////////////////////////////////////////
 // MaterializingIterator
 ////////////////////////////////////////////////////////////
@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <string>
@@ -29,6 +30,7 @@ namespace kudu {
 
 class ColumnPredicate;
 class ScanSpec;
+class ThreadPool;
 
 // Encapsulates a rowwise-iterator along with the (encoded) lower and upper
 // bounds for the rowset that the iterator belongs to.
@@ -62,6 +64,37 @@ std::unique_ptr<RowwiseIterator> NewMergeIterator(
 // The iterators must have matching schemas and should not yet be initialized.
 std::unique_ptr<RowwiseIterator> NewUnionIterator(std::vector<IterWithBounds> iters);
 
+// Options for the ParallelUnionIterator.
+struct ParallelUnionIteratorOptions {
+  // The pool on which the iterators are materialized. Must outlive the
+  // ParallelUnionIterator.
+  ThreadPool* pool = nullptr;
+
+  // The maximum number of iterators materialized concurrently.
+  int max_concurrency = 1;
+
+  // The number of materialized blocks which may be buffered ahead of the
+  // consumer. Up to 'max_concurrency' more may be in the process of being
+  // materialized.
+  int max_buffered_blocks = 1;
+
+  // The row capacity of each of the materialized blocks.
+  size_t block_rows = 1024;
+};
+
+// Constructs a ParallelUnionIterator of the given iterators.
+//
+// Like a UnionIterator, it lays the results of the iterators out end-to-end,
+// but rather than exhausting them one after the other, it materializes up to
+// 'opts.max_concurrency' of them concurrently on 'opts.pool' and returns the
+// blocks in whatever order they're materialized.
+//
+// The iterators must have matching schemas, should not yet be initialized,
+// and must be safe to use from a thread other than the one which created them.
+std::unique_ptr<RowwiseIterator> NewParallelUnionIterator(
+    ParallelUnionIteratorOptions opts,
+    std::vector<IterWithBounds> iters);
+
 // Constructs a MaterializingIterator of the given ColumnwiseIterator.
 std::unique_ptr<RowwiseIterator> NewMaterializingIterator(
     std::unique_ptr<ColumnwiseIterator> iter);
@@ -30,12 +30,14 @@ IteratorStats::IteratorStats()
     : cells_read(0),
       bytes_read(0),
       blocks_read(0),
-      predicates_disabled(0) {
+      predicates_disabled(0),
+      cells_skipped(0) {
 }
 
 string IteratorStats::ToString() const {
-  return Substitute("cells_read=$0 bytes_read=$1 blocks_read=$2 predicates_disabled=$3",
-                    cells_read, bytes_read, blocks_read, predicates_disabled);
+  return Substitute("cells_read=$0 bytes_read=$1 blocks_read=$2 predicates_disabled=$3 "
+                    "cells_skipped=$4",
+                    cells_read, bytes_read, blocks_read, predicates_disabled, cells_skipped);
 }
 
 IteratorStats& IteratorStats::operator+=(const IteratorStats& other) {
@@ -43,6 +45,7 @@ IteratorStats& IteratorStats::operator+=(const IteratorStats& other) {
   bytes_read += other.bytes_read;
   blocks_read += other.blocks_read;
   predicates_disabled += other.predicates_disabled;
+  cells_skipped += other.cells_skipped;
   DCheckNonNegative();
   return *this;
 }
@@ -52,6 +55,7 @@ IteratorStats& IteratorStats::operator-=(const IteratorStats& other) {
   bytes_read -= other.bytes_read;
   blocks_read -= other.blocks_read;
   predicates_disabled -= other.predicates_disabled;
+  cells_skipped -= other.cells_skipped;
   DCheckNonNegative();
   return *this;
 }
@@ -73,5 +77,6 @@ void IteratorStats::DCheckNonNegative() const {
   DCHECK_GE(bytes_read, 0);
   DCHECK_GE(blocks_read, 0);
   DCHECK_GE(predicates_disabled, 0);
+  DCHECK_GE(cells_skipped, 0);
 }
 } // namespace kudu
@@ -43,6 +43,10 @@ struct IteratorStats {
   // Using an integer helps the stat work well when aggregating or computing delta.
   int64_t predicates_disabled;
 
+  // The number of cells which were not decoded because their rows had already
+  // been filtered out by the predicates on other columns.
+  int64_t cells_skipped;
+
   // Add statistics contained 'other' to this object (for each field
   // in this object, increment it by the value of the equivalent field
   // in 'other').
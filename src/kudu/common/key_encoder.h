@@ -159,25 +159,33 @@ struct KeyEncoderTraits<BINARY, Buffer> {
       int len = s.size();
       int rem = len;
 
+      // Copy the input a chunk at a time while it has no '\0' bytes. A chunk
+      // with '\0' bytes is escaped byte by byte, and the next chunks get back
+      // on the fast path, so that a few '\0' bytes early in a long input (e.g.
+      // in a binary identifier) don't leave the rest of it to the slow loop.
+      //
+      // 'last_chunk_copied' tracks whether the last chunk was copied verbatim,
+      // in which case it's safe to roll back over it for the tail.
+      bool last_chunk_copied = false;
       while (rem >= 16) {
-        if (!SSEEncodeChunk<16>(&srcp, &dstp)) {
-          goto slow_path;
+        last_chunk_copied = SSEEncodeChunk<16>(&srcp, &dstp);
+        if (!last_chunk_copied) {
+          EncodeChunkLoop(&srcp, &dstp, 16);
         }
         rem -= 16;
       }
-      while (rem >= 8) {
-        if (!SSEEncodeChunk<8>(&srcp, &dstp)) {
-          goto slow_path;
+      if (rem >= 8) {
+        last_chunk_copied = SSEEncodeChunk<8>(&srcp, &dstp);
+        if (!last_chunk_copied) {
+          EncodeChunkLoop(&srcp, &dstp, 8);
         }
         rem -= 8;
       }
       // Roll back to operate in 8 bytes at a time.
-      if (len > 8 && rem > 0) {
+      if (len > 8 && rem > 0 && last_chunk_copied) {
         dstp -= 8 - rem;
         srcp -= 8 - rem;
         if (!SSEEncodeChunk<8>(&srcp, &dstp)) {
-          // TODO: optimize for the case where the input slice has '\0'
-          // bytes. (e.g. move the pointer to the first zero byte.)
           dstp += 8 - rem;
           srcp += 8 - rem;
           goto slow_path;
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -46,6 +47,7 @@ using std::nullopt;
 using std::optional;
 using std::pair;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 using std::make_pair;
 using strings::Substitute;
@@ -1191,6 +1193,54 @@ TEST_F(PartitionTest, VaryingHashSchemasPerRange) {
             partitions[15].end().ToString());
 }
 
+// Test that EncodeKeys() encodes the same partition keys as EncodeKey(),
+// including for the rows of ranges with custom hash schemas and the rows
+// whose partition columns are unset.
+TEST_F(PartitionTest, EncodeKeysMatchesEncodeKey) {
+  Schema schema({ ColumnSchema("a", STRING),
+                  ColumnSchema("b", STRING),
+                  ColumnSchema("c", STRING) },
+                { ColumnId(0), ColumnId(1), ColumnId(2) }, 3);
+
+  PartitionSchemaPB ps_pb;
+  AddHashDimension(&ps_pb, { "a", "c" }, 3, 0);
+  AddHashDimension(&ps_pb, { "b" }, 2, 0);
+  {
+    KuduPartialRow lower(&schema);
+    KuduPartialRow upper(&schema);
+    ASSERT_OK(lower.SetStringCopy("a", "a3"));
+    ASSERT_OK(upper.SetStringCopy("a", "a5"));
+    AddRangePartitionWithSchema(
+        schema, lower, upper, { { { ColumnId(1), ColumnId(2) }, 5, 7 } }, &ps_pb);
+  }
+  PartitionSchema ps;
+  PartitionSchema::RangesWithHashSchemas ranges;
+  ASSERT_OK(PartitionSchema::FromPB(ps_pb, schema, &ps, &ranges));
+
+  vector<unique_ptr<KuduPartialRow>> rows;
+  vector<const KuduPartialRow*> row_ptrs;
+  for (int i = 0; i < 1000; i++) {
+    rows.emplace_back(new KuduPartialRow(&schema));
+    auto* row = rows.back().get();
+    ASSERT_OK(row->SetStringCopy("a", Substitute("a$0", i % 7)));
+    if (i % 5 != 0) {
+      ASSERT_OK(row->SetStringCopy("b", Substitute("b$0", i)));
+    }
+    ASSERT_OK(row->SetStringCopy("c", Substitute("c$0", i * 31)));
+    row_ptrs.emplace_back(row);
+  }
+
+  vector<PartitionKey> keys;
+  ps.EncodeKeys(row_ptrs, &keys);
+  ASSERT_EQ(rows.size(), keys.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    ASSERT_EQ(ps.EncodeKey(*rows[i]), keys[i]) << rows[i]->ToString();
+  }
+
+  ps.EncodeKeys({}, &keys);
+  ASSERT_TRUE(keys.empty());
+}
+
 TEST_F(PartitionTest, CustomHashSchemasPerRangeOnly) {
   // CREATE TABLE t (a STRING, b STRING, PRIMARY KEY (a, b)) RANGE (a, b)
   Schema schema({ ColumnSchema("a", STRING), ColumnSchema("b", STRING) },
@@ -448,6 +448,86 @@ PartitionKey PartitionSchema::EncodeKey(const ConstContiguousRow& row) const {
   return PartitionKey(std::move(encoded_hash), std::move(encoded_range));
 }
 
+struct PartitionSchema::ColumnEncoder {
+  int column_idx;
+  const TypeInfo* type_info;
+  const KeyEncoder<string>* encoder;
+};
+
+vector<PartitionSchema::ColumnEncoder> PartitionSchema::GetColumnEncoders(
+    const Schema& schema, const vector<ColumnId>& column_ids) {
+  vector<ColumnEncoder> encoders;
+  encoders.reserve(column_ids.size());
+  for (const auto& column_id : column_ids) {
+    const auto column_idx = schema.find_column_by_id(column_id);
+    CHECK(column_idx != Schema::kColumnNotFound);
+    const TypeInfo* type_info = schema.column(column_idx).type_info();
+    encoders.push_back({ column_idx, type_info, &GetKeyEncoder<string>(type_info) });
+  }
+  return encoders;
+}
+
+void PartitionSchema::EncodeColumns(const KuduPartialRow& row,
+                                    const vector<ColumnEncoder>& encoders,
+                                    string* buf) {
+  const ContiguousRow cont_row(row.schema(), row.row_data_);
+  for (size_t i = 0; i < encoders.size(); ++i) {
+    const auto& e = encoders[i];
+    const bool is_last = i + 1 == encoders.size();
+    if (PREDICT_FALSE(!row.IsColumnSet(e.column_idx))) {
+      uint8_t min_value[kLargestTypeSize];
+      e.type_info->CopyMinValue(min_value);
+      e.encoder->Encode(min_value, is_last, buf);
+    } else {
+      e.encoder->Encode(cont_row.cell_ptr(e.column_idx), is_last, buf);
+    }
+  }
+}
+
+void PartitionSchema::EncodeKeys(const vector<const KuduPartialRow*>& rows,
+                                 vector<PartitionKey>* keys) const {
+  keys->clear();
+  if (rows.empty()) {
+    return;
+  }
+  keys->reserve(rows.size());
+  const Schema& schema = *rows[0]->schema();
+  const auto range_encoders = GetColumnEncoders(schema, range_schema_.column_ids);
+  // The encoders of the dimensions of each hash schema the rows were hashed
+  // with so far: with custom hash schemas, depending on the range of each row.
+  vector<pair<const HashSchema*, vector<vector<ColumnEncoder>>>> hash_encoders;
+  const auto& bucket_encoder = GetKeyEncoder<string>(GetTypeInfo(UINT32));
+  string hash_columns;
+  for (const auto* row : rows) {
+    DCHECK_EQ(&schema, row->schema());
+    string range_key;
+    EncodeColumns(*row, range_encoders, &range_key);
+
+    const auto& hash_schema = GetHashSchemaForRange(range_key);
+    auto it = std::find_if(hash_encoders.begin(), hash_encoders.end(),
+                           [&](const auto& e) { return e.first == &hash_schema; });
+    if (PREDICT_FALSE(it == hash_encoders.end())) {
+      vector<vector<ColumnEncoder>> dimension_encoders;
+      dimension_encoders.reserve(hash_schema.size());
+      for (const auto& hash_dimension : hash_schema) {
+        dimension_encoders.emplace_back(GetColumnEncoders(schema, hash_dimension.column_ids));
+      }
+      hash_encoders.emplace_back(&hash_schema, std::move(dimension_encoders));
+      it = hash_encoders.end() - 1;
+    }
+
+    string hash_key;
+    for (size_t i = 0; i < hash_schema.size(); ++i) {
+      const auto& hash_dimension = hash_schema[i];
+      hash_columns.clear();
+      EncodeColumns(*row, it->second[i], &hash_columns);
+      const uint32_t bucket = HashValueForEncodedColumns(hash_columns, hash_dimension);
+      bucket_encoder.Encode(&bucket, &hash_key);
+    }
+    keys->emplace_back(std::move(hash_key), std::move(range_key));
+  }
+}
+
 Status PartitionSchema::EncodeRangeKey(const KuduPartialRow& row,
                                        const Schema& schema,
                                        string* key) const {
@@ -349,6 +349,12 @@ class PartitionSchema {
   PartitionKey EncodeKey(const KuduPartialRow& row) const;
   PartitionKey EncodeKey(const ConstContiguousRow& row) const;
 
+  // Sets 'keys' to the partition keys of 'rows', as EncodeKey() would, but
+  // resolving the partition columns and their encoders once for all the
+  // rows rather than once per row. The rows must share the same schema.
+  void EncodeKeys(const std::vector<const KuduPartialRow*>& rows,
+                  std::vector<PartitionKey>* keys) const;
+
   // Creates the set of table partitions for a partition schema and collection
   // of split rows and split bounds.
   //
@@ -568,6 +574,19 @@ class PartitionSchema {
                             const std::vector<ColumnId>& column_ids,
                             std::string* buf);
 
+  // The index and key encoder of a column, resolved from its ID. Used to
+  // encode the columns of many rows of the same schema.
+  struct ColumnEncoder;
+
+  // Resolves the specified columns of 'schema'.
+  static std::vector<ColumnEncoder> GetColumnEncoders(
+      const Schema& schema, const std::vector<ColumnId>& column_ids);
+
+  // As above, for columns resolved by GetColumnEncoders().
+  static void EncodeColumns(const KuduPartialRow& row,
+                            const std::vector<ColumnEncoder>& encoders,
+                            std::string* buf);
+
   // Encodes the specified columns of a row into lexicographic sort-order
   // preserving format.
   static void EncodeColumns(const ConstContiguousRow& row,
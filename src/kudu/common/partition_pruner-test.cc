@@ -28,6 +28,7 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -51,6 +52,8 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_int64(partition_pruner_max_hash_combinations);
+
 using std::count_if;
 using std::get;
 using std::make_tuple;
@@ -972,6 +975,61 @@ TEST_F(PartitionPrunerTest, TestMultiColumnInListHashPruning) {
                   6, 2));
 }
 
+TEST_F(PartitionPrunerTest, TestInListHashPruningMaxCombinations) {
+  // CREATE TABLE t
+  // (a INT8, b INT8, c INT8)
+  // PRIMARY KEY (a, b, c)
+  // DISTRIBUTE BY HASH(a) INTO 3 BUCKETS,
+  //               HASH(b, c) INTO 3 BUCKETS;
+  Schema schema({ ColumnSchema("a", INT8),
+                  ColumnSchema("b", INT8),
+                  ColumnSchema("c", INT8) },
+                { ColumnId(0), ColumnId(1), ColumnId(2) },
+                3);
+
+  PartitionSchemaPB pb;
+  CreatePartitionSchemaPB({}, { {{"a"}, 3, 0}, {{"b", "c"}, 3, 0} }, &pb);
+  pb.mutable_range_schema()->clear_columns();
+  PartitionSchema partition_schema;
+  ASSERT_OK(PartitionSchema::FromPB(pb, schema, &partition_schema));
+
+  vector<Partition> partitions;
+  ASSERT_OK(partition_schema.CreatePartitions(vector<KuduPartialRow>(), {},
+                                                     schema, &partitions));
+
+  const auto check = [&] (const vector<ColumnPredicate>& predicates,
+                          size_t remaining_tablets,
+                          size_t pruner_ranges) {
+    ScanSpec spec;
+    for (const auto& pred : predicates) {
+      spec.AddPredicate(pred);
+    }
+    CheckPrunedPartitions(schema, partition_schema, partitions, spec,
+                          remaining_tablets, pruner_ranges);
+  };
+
+  constexpr int8_t zero = 0;
+  constexpr int8_t one = 1;
+
+  // b = 0, c in [0, 1]: both (0, 0) and (0, 1) are in bucket 2.
+  vector<const void*> c_values = { &zero, &one };
+  const vector<ColumnPredicate> predicates = {
+    ColumnPredicate::Equality(schema.column(1), &zero),
+    ColumnPredicate::InList(schema.column(2), &c_values),
+  };
+  NO_FATALS(check(predicates, 3, 3));
+
+  // With a single combination hashed, the bucket of the other one is unknown.
+  FLAGS_partition_pruner_max_hash_combinations = 1;
+  NO_FATALS(check(predicates, 9, 1));
+
+  vector<const void*> a_values = { &zero, &one };
+  NO_FATALS(check({ ColumnPredicate::InList(schema.column(0), &a_values) }, 9, 1));
+
+  FLAGS_partition_pruner_max_hash_combinations = 2;
+  NO_FATALS(check({ ColumnPredicate::InList(schema.column(0), &a_values) }, 6, 2));
+}
+
 // For test cases that will run with in-list predicates using variant length
 class PartitionPrunerTestWithMaxInListLength : public PartitionPrunerTest,
                                                public testing::WithParamInterface<int32_t> {};
@@ -27,6 +27,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/common/column_predicate.h"
@@ -43,9 +44,32 @@
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/array_view.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/slice.h"
 
+DEFINE_int64(partition_pruner_max_hash_combinations, 1 << 20,
+             "Maximum number of combinations of the IN-list values of the columns of "
+             "a hash dimension which are hashed to find the buckets to scan. If a scan "
+             "has more combinations and their hash buckets don't already cover all the "
+             "buckets of the dimension, none of its buckets are pruned.");
+TAG_FLAG(partition_pruner_max_hash_combinations, advanced);
+TAG_FLAG(partition_pruner_max_hash_combinations, runtime);
+
+namespace {
+
+bool ValidateMaxHashCombinations(const char* flagname, int64_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(partition_pruner_max_hash_combinations, &ValidateMaxHashCombinations);
+
 using std::distance;
 using std::find;
 using std::iota;
@@ -200,6 +224,19 @@ vector<bool> PartitionPruner::PruneHashComponent(
     predicate_values_list.emplace_back(std::move(predicate_values));
   }
 
+  // The number of combinations may be huge with long IN-lists over several
+  // columns, so only up to --partition_pruner_max_hash_combinations of them
+  // are hashed.
+  const int64_t max_combinations = FLAGS_partition_pruner_max_hash_combinations;
+  int64_t num_combinations = 1;
+  for (const auto& values : predicate_values_list) {
+    const int64_t num_values = static_cast<int64_t>(values.size());
+    num_combinations = num_values > max_combinations / num_combinations
+        ? max_combinations + 1
+        : num_combinations * num_values;
+  }
+  int64_t combinations_left = max_combinations;
+
   // A combination of the predicate values is selected to compute the hash buckets.
   vector<const void*> predicate_values_selected;
   predicate_values_selected.reserve(hash_dimension.column_ids.size());
@@ -209,7 +246,17 @@ vector<bool> PartitionPruner::PruneHashComponent(
                      hash_dimension,
                      predicate_values_list,
                      &predicate_values_selected,
+                     &combinations_left,
                      &hash_bucket_bitset);
+  if (num_combinations > max_combinations) {
+    // Not every combination was hashed: the buckets of the others are unknown.
+    if (std::find(hash_bucket_bitset.begin(), hash_bucket_bitset.end(), false) !=
+        hash_bucket_bitset.end()) {
+      VLOG(1) << "Not pruning the buckets of a hash dimension with more than "
+              << max_combinations << " combinations of IN-list values";
+      hash_bucket_bitset.assign(hash_dimension.num_buckets, true);
+    }
+  }
   return hash_bucket_bitset;
 }
 
@@ -217,10 +264,15 @@ void PartitionPruner::ComputeHashBuckets(const Schema& schema, // NOLINT(misc-no
                                          const PartitionSchema::HashDimension& hash_dimension,
                                          const vector<vector<const void*>>& predicate_values_list,
                                          vector<const void*>* predicate_values_selected,
+                                         int64_t* combinations_left,
                                          vector<bool>* hash_bucket_bitset) {
   DCHECK(predicate_values_selected);
+  DCHECK(combinations_left);
   DCHECK(hash_bucket_bitset);
 
+  if (*combinations_left <= 0) {
+    return;
+  }
   if (std::all_of(hash_bucket_bitset->begin(),
                   hash_bucket_bitset->end(),
                   [](bool b) { return b; })) {
@@ -241,6 +293,7 @@ void PartitionPruner::ComputeHashBuckets(const Schema& schema, // NOLINT(misc-no
     uint32_t hash_value = PartitionSchema::HashValueForEncodedColumns(
         encoded_string, hash_dimension);
     (*hash_bucket_bitset)[hash_value] = true;
+    --*combinations_left;
     return;
   }
   DCHECK_LT(level, predicate_values_list.size());
@@ -250,6 +303,7 @@ void PartitionPruner::ComputeHashBuckets(const Schema& schema, // NOLINT(misc-no
                        hash_dimension,
                        predicate_values_list,
                        predicate_values_selected,
+                       combinations_left,
                        hash_bucket_bitset);
     predicate_values_selected->pop_back();
   }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -85,18 +86,22 @@ class PartitionPruner {
   };
 
   // Search all combinations of in-list and equality predicates.
-  // Return hash values bitset of these combinations.
+  // Return hash values bitset of these combinations. If there are more than
+  // --partition_pruner_max_hash_combinations combinations, and the ones hashed
+  // don't already reach every bucket, all the buckets are returned.
   static std::vector<bool> PruneHashComponent(
       const PartitionSchema::HashDimension& hash_dimension,
       const Schema& schema,
       const ScanSpec& scan_spec);
 
   // Pick all combinations in in-list values and compute their hash buckets,
-  // the result is stored in hash_bucket_bitset.
+  // the result is stored in hash_bucket_bitset. At most 'combinations_left'
+  // combinations are hashed, and it's decremented accordingly.
   static void ComputeHashBuckets(const Schema& schema,
                                  const PartitionSchema::HashDimension& hash_dimension,
                                  const std::vector<std::vector<const void*>>& predicate_values_list,
                                  std::vector<const void*>* predicate_values_selected,
+                                 int64_t* combinations_left,
                                  std::vector<bool>* hash_bucket_bitset);
 
   // Given the range bounds and the hash schema, constructs a set of partition
@@ -119,6 +119,15 @@ class RowOperationsPBDecoder {
                          const Schema* client_schema,
                          const Schema* tablet_schema,
                          Arena* dst_arena);
+
+  // Same as above, but decodes the encoded rows and indirect data from the
+  // given slices rather than from a protobuf, e.g. from RPC sidecars. The
+  // decoded operations point into 'indirect_data', which must outlive them.
+  RowOperationsPBDecoder(Slice rows,
+                         Slice indirect_data,
+                         const Schema* client_schema,
+                         const Schema* tablet_schema,
+                         Arena* dst_arena);
   ~RowOperationsPBDecoder();
 
   template <DecoderMode mode>
@@ -170,7 +179,7 @@ class RowOperationsPBDecoder {
                   const ClientServerMapping& mapping, DecodedRowOperation* op,
                   int64_t* auto_incrementing_counter);
 
-  const RowOperationsPB* const pb_;
+  const Slice indirect_data_;
   // If 'client_schema_' and 'tablet_schema_' are the same object, the mapping
   // between the two schemas is effectively useless since only one schema
   // exists. This is the only time when the client_schema_ can have column IDs.
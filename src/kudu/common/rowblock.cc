@@ -208,4 +208,13 @@ void RowBlock::Resize(size_t n_rows) {
   sel_vec_.Resize(n_rows);
 }
 
+void RowBlock::ResetSchema(const Schema* schema) {
+  // The old schema may be gone already: check what the block allocated.
+  DCHECK_EQ(columns_data_.size(), schema->num_columns());
+  for (size_t i = 0; i < schema->num_columns(); ++i) {
+    DCHECK_EQ(column_non_null_bitmaps_[i] != nullptr, schema->column(i).is_nullable());
+  }
+  schema_ = schema;
+}
+
 } // namespace kudu
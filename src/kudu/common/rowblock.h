@@ -322,6 +322,13 @@ class RowBlock {
   // Ensures that all rows for indices < n_rows are unmodified.
   void Resize(size_t n_rows);
 
+  // Makes the block hold rows of 'schema' instead, so that the block can be
+  // reused for another scan. 'schema' must have the layout of the schema the
+  // block was constructed with: the same number of columns, of the same sizes
+  // and nullability. The previous schema need not be alive anymore, but
+  // 'schema' must outlive this RowBlock or the next call to this method.
+  void ResetSchema(const Schema* schema);
+
   size_t row_capacity() const {
     return row_capacity_;
   }
@@ -147,12 +147,14 @@ struct ColumnStorageAttributes {
   ColumnStorageAttributes()
     : encoding(AUTO_ENCODING),
       compression(DEFAULT_COMPRESSION),
+      compression_level(0),
       cfile_block_size(0) {
   }
 
   ColumnStorageAttributes(EncodingType enc, CompressionType cmp)
     : encoding(enc),
       compression(cmp),
+      compression_level(0),
       cfile_block_size(0) {
   }
 
@@ -161,6 +163,10 @@ struct ColumnStorageAttributes {
   EncodingType encoding;
   CompressionType compression;
 
+  // The level at which to compress cfile blocks. If 0, uses the codec's
+  // default level.
+  int32_t compression_level;
+
   // The preferred block size for cfile blocks. If 0, uses the
   // server-wide default.
   int32_t cfile_block_size;
@@ -45,6 +45,7 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/walltime.h"
+#include "kudu/util/alignment.h"
 #include "kudu/util/bitmap.h"
 #include "kudu/util/block_bloom_filter.h"
 #include "kudu/util/faststring.h"
@@ -363,6 +364,71 @@ TEST_F(WireProtocolTest, TestRowBlockToColumnarPB) {
   }
 }
 
+// Test that the Arrow layout bit-packs the BOOL cells and zero-pads the buffers.
+TEST_F(WireProtocolTest, TestRowBlockToColumnarArrowLayout) {
+  static constexpr int kNumRows = 13;
+  Schema schema({ ColumnSchema("key", INT32),
+                  ColumnSchema("bool", BOOL),
+                  ColumnSchema("nullable_bool", BOOL, /* is_nullable=*/true),
+                  ColumnSchema("string", STRING) },
+                1);
+  RowBlockMemory mem(1024);
+  RowBlock block(&schema, kNumRows, &mem);
+  block.selection_vector()->SetAllTrue();
+  // Skip every third row.
+  for (int i = 0; i < kNumRows; i += 3) {
+    block.selection_vector()->SetRowUnselected(i);
+  }
+  for (int i = 0; i < kNumRows; i++) {
+    RowBlockRow row = block.row(i);
+    *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(0)) = i;
+    *reinterpret_cast<bool*>(row.mutable_cell_ptr(1)) = i % 2 == 0;
+    // The NULL cells hold 'true', which must not be serialized.
+    *reinterpret_cast<bool*>(row.mutable_cell_ptr(2)) = true;
+    row.cell(2).set_null(i % 4 == 0);
+    Slice str;
+    CHECK(test_data_arena_.RelocateSlice("abc", &str));
+    *reinterpret_cast<Slice*>(row.mutable_cell_ptr(3)) = str;
+  }
+
+  ColumnarSerializedBatch batch(schema, schema, 1024, /* arrow_layout=*/true);
+  // Add the block twice, so that the bit-packed cells of the second one don't
+  // start on a byte boundary.
+  ASSERT_EQ(8, batch.AddRowBlock(block));
+  ASSERT_EQ(8, batch.AddRowBlock(block));
+  ASSERT_EQ(16, batch.num_rows());
+  auto cols = std::move(batch).TakeColumns();
+  ASSERT_EQ(4, cols.size());
+
+  ASSERT_EQ(16 * sizeof(int32_t), cols[0].data.size());
+  ASSERT_EQ(8, cols[1].data.size());
+  ASSERT_EQ(8, cols[2].data.size());
+  ASSERT_EQ(8, cols[2].non_null_bitmap->size());
+  ASSERT_EQ(KUDU_ALIGN_UP(17 * sizeof(uint32_t), 8), cols[3].data.size());
+  ASSERT_EQ(16 * 3, cols[3].varlen_data->size());
+
+  int dst_idx = 0;
+  for (int rep = 0; rep < 2; rep++) {
+    for (int i = 0; i < kNumRows; i++) {
+      if (i % 3 == 0) {
+        continue;
+      }
+      SCOPED_TRACE(i);
+      EXPECT_EQ(i, UnalignedLoad<int32_t>(cols[0].data.data() + dst_idx * sizeof(int32_t)));
+      EXPECT_EQ(i % 2 == 0, BitmapTest(cols[1].data.data(), dst_idx));
+      EXPECT_EQ(i % 4 != 0, BitmapTest(cols[2].non_null_bitmap->data(), dst_idx));
+      EXPECT_EQ(i % 4 != 0, BitmapTest(cols[2].data.data(), dst_idx));
+      dst_idx++;
+    }
+  }
+  // The padding is zeroed.
+  for (int i = 2; i < 8; i++) {
+    EXPECT_EQ(0, cols[1].data[i]);
+    EXPECT_EQ(0, cols[2].data[i]);
+    EXPECT_EQ(0, cols[2].non_null_bitmap->at(i));
+  }
+  EXPECT_EQ(0, UnalignedLoad<uint32_t>(cols[3].data.data() + 17 * sizeof(uint32_t)));
+}
 
 // Create a block of rows in columnar layout and ensure that it can be
 // converted to and from protobuf.
@@ -247,6 +247,9 @@ void ColumnSchemaToPB(const ColumnSchema& col_schema, ColumnSchemaPB *pb, int fl
   if (!(flags & SCHEMA_PB_WITHOUT_STORAGE_ATTRIBUTES)) {
     pb->set_encoding(col_schema.attributes().encoding);
     pb->set_compression(col_schema.attributes().compression);
+    if (col_schema.attributes().compression_level != 0) {
+      pb->set_compression_level(col_schema.attributes().compression_level);
+    }
     pb->set_cfile_block_size(col_schema.attributes().cfile_block_size);
   }
   if (col_schema.has_read_default()) {
@@ -329,6 +332,9 @@ Status ColumnSchemaFromPB(const ColumnSchemaPB& pb, optional<ColumnSchema>* col_
   if (pb.has_compression()) {
     attributes.compression = pb.compression();
   }
+  if (pb.has_compression_level()) {
+    attributes.compression_level = pb.compression_level();
+  }
   if (pb.has_cfile_block_size()) {
     attributes.cfile_block_size = pb.cfile_block_size();
   }
@@ -573,6 +579,14 @@ Status ColumnPredicateFromPB(const Schema& schema,
                              Arena* arena,
                              const ColumnPredicatePB& pb,
                              optional<ColumnPredicate>* predicate) {
+  return ColumnPredicateFromPB(schema, arena, pb, nullptr, predicate);
+}
+
+Status ColumnPredicateFromPB(const Schema& schema,
+                             Arena* arena,
+                             const ColumnPredicatePB& pb,
+                             const vector<BlockBloomFilter*>* bloom_filters,
+                             optional<ColumnPredicate>* predicate) {
   if (!pb.has_column()) {
     return Status::InvalidArgument("Column predicate must include a column", SecureDebugString(pb));
   }
@@ -635,20 +649,25 @@ Status ColumnPredicateFromPB(const Schema& schema,
     };
     case ColumnPredicatePB::kInBloomFilter: {
       const auto& in_bloom_filter = pb.in_bloom_filter();
-      vector<BlockBloomFilter*> bloom_filters;
-      if (in_bloom_filter.bloom_filters_size() == 0) {
+      vector<BlockBloomFilter*> filters;
+      if (bloom_filters) {
+        filters = *bloom_filters;
+      } else {
+        auto* allocator = arena->NewObject<ArenaBlockBloomFilterBufferAllocator>(arena);
+        for (const auto& bf_src : in_bloom_filter.bloom_filters()) {
+          auto* block_bloom_filter = arena->NewObject<BlockBloomFilter>(allocator);
+          RETURN_NOT_OK_PREPEND(
+              block_bloom_filter->InitFromPB(bf_src),
+              Substitute("Failed to initialize bloom filter predicate on column: $0",
+                         col.name()));
+          filters.emplace_back(block_bloom_filter);
+        }
+      }
+      if (filters.empty()) {
         return Status::InvalidArgument(
             Substitute("Invalid bloom filter predicate on column: $0. "
                        "No bloom filters supplied", col.name()));
       }
-      auto* allocator = arena->NewObject<ArenaBlockBloomFilterBufferAllocator>(arena);
-      for (const auto& bf_src : in_bloom_filter.bloom_filters()) {
-        auto* block_bloom_filter = arena->NewObject<BlockBloomFilter>(allocator);
-        RETURN_NOT_OK_PREPEND(
-            block_bloom_filter->InitFromPB(bf_src),
-            Substitute("Failed to initialize bloom filter predicate on column: $0", col.name()));
-        bloom_filters.emplace_back(block_bloom_filter);
-      }
       // Extract the optional lower and upper bound.
       const void* lower = nullptr;
       const void* upper = nullptr;
@@ -658,8 +677,7 @@ Status ColumnPredicateFromPB(const Schema& schema,
       if (in_bloom_filter.has_upper()) {
         RETURN_NOT_OK(CopyPredicateBoundFromPB(col, in_bloom_filter.upper(), arena, &upper));
       }
-      *predicate = ColumnPredicate::InBloomFilter(col, std::move(bloom_filters), lower,
-                                                  upper);
+      *predicate = ColumnPredicate::InBloomFilter(col, std::move(filters), lower, upper);
       break;
     };
     default: return Status::InvalidArgument("Unknown predicate type for column", col.name());
@@ -683,6 +701,14 @@ Status ParseInt32Config(const string& name, const string& value, int32_t* result
   return Status::OK();
 }
 
+Status ParseInt64Config(const string& name, const string& value, int64_t* result) {
+  CHECK(result);
+  if (!safe_strto64(value, result)) {
+    return Status::InvalidArgument(Substitute("unable to parse $0", name), value);
+  }
+  return Status::OK();
+}
+
 Status ParseBoolConfig(const string& name, const string& value, bool* result) {
   CHECK(result);
   bool true_flag = iequals(value, "TRUE");
@@ -697,7 +723,14 @@ Status ParseBoolConfig(const string& name, const string& value, bool* result) {
 Status ExtraConfigPBFromPBMap(const Map<string, string>& configs, TableExtraConfigPB* pb) {
   static const unordered_set<string> kSupportedConfigs({kTableHistoryMaxAgeSec,
                                                         kTableMaintenancePriority,
-                                                        kTableDisableCompaction});
+                                                        kTableDisableCompaction,
+                                                        kTableColumnGroupSize,
+                                                        kTableBloomFilterColumns,
+                                                        kTableColdDataAgeSec,
+                                                        kTableScanBytesPerSecQuota,
+                                                        kTableWriteOpsPerSecQuota,
+                                                        kTableRowTtlColumn,
+                                                        kTableRowTtlSec});
   TableExtraConfigPB result;
   for (const auto& config : configs) {
     const string& name = config.first;
@@ -725,6 +758,59 @@ Status ExtraConfigPBFromPBMap(const Map<string, string>& configs, TableExtraConf
         RETURN_NOT_OK(ParseBoolConfig(name, value, &disable_compaction));
         result.set_disable_compaction(disable_compaction);
       }
+    } else if (name == kTableColumnGroupSize) {
+      if (!value.empty()) {
+        int32_t column_group_size;
+        RETURN_NOT_OK(ParseInt32Config(name, value, &column_group_size));
+        if (column_group_size < 0) {
+          return Status::InvalidArgument(Substitute("invalid $0", name), value);
+        }
+        result.set_column_group_size(column_group_size);
+      }
+    } else if (name == kTableBloomFilterColumns) {
+      if (!value.empty()) {
+        result.set_bloom_filter_columns(value);
+      }
+    } else if (name == kTableColdDataAgeSec) {
+      if (!value.empty()) {
+        int32_t cold_data_age_sec;
+        RETURN_NOT_OK(ParseInt32Config(name, value, &cold_data_age_sec));
+        if (cold_data_age_sec < 0) {
+          return Status::InvalidArgument(Substitute("invalid $0", name), value);
+        }
+        result.set_cold_data_age_sec(cold_data_age_sec);
+      }
+    } else if (name == kTableScanBytesPerSecQuota) {
+      if (!value.empty()) {
+        int64_t scan_bytes_per_sec_quota;
+        RETURN_NOT_OK(ParseInt64Config(name, value, &scan_bytes_per_sec_quota));
+        if (scan_bytes_per_sec_quota < 0) {
+          return Status::InvalidArgument(Substitute("invalid $0", name), value);
+        }
+        result.set_scan_bytes_per_sec_quota(scan_bytes_per_sec_quota);
+      }
+    } else if (name == kTableWriteOpsPerSecQuota) {
+      if (!value.empty()) {
+        int64_t write_ops_per_sec_quota;
+        RETURN_NOT_OK(ParseInt64Config(name, value, &write_ops_per_sec_quota));
+        if (write_ops_per_sec_quota < 0) {
+          return Status::InvalidArgument(Substitute("invalid $0", name), value);
+        }
+        result.set_write_ops_per_sec_quota(write_ops_per_sec_quota);
+      }
+    } else if (name == kTableRowTtlColumn) {
+      if (!value.empty()) {
+        result.set_row_ttl_column(value);
+      }
+    } else if (name == kTableRowTtlSec) {
+      if (!value.empty()) {
+        int64_t row_ttl_sec;
+        RETURN_NOT_OK(ParseInt64Config(name, value, &row_ttl_sec));
+        if (row_ttl_sec <= 0) {
+          return Status::InvalidArgument(Substitute("invalid $0", name), value);
+        }
+        result.set_row_ttl_sec(row_ttl_sec);
+      }
     } else {
       LOG(FATAL) << "Unknown extra configuration property: " << name;
     }
@@ -744,6 +830,27 @@ Status ExtraConfigPBToPBMap(const TableExtraConfigPB& pb, Map<string, string>* c
   if (pb.has_disable_compaction()) {
     result[kTableDisableCompaction] = std::to_string(pb.disable_compaction());
   }
+  if (pb.has_column_group_size()) {
+    result[kTableColumnGroupSize] = std::to_string(pb.column_group_size());
+  }
+  if (pb.has_bloom_filter_columns()) {
+    result[kTableBloomFilterColumns] = pb.bloom_filter_columns();
+  }
+  if (pb.has_cold_data_age_sec()) {
+    result[kTableColdDataAgeSec] = std::to_string(pb.cold_data_age_sec());
+  }
+  if (pb.has_scan_bytes_per_sec_quota()) {
+    result[kTableScanBytesPerSecQuota] = std::to_string(pb.scan_bytes_per_sec_quota());
+  }
+  if (pb.has_write_ops_per_sec_quota()) {
+    result[kTableWriteOpsPerSecQuota] = std::to_string(pb.write_ops_per_sec_quota());
+  }
+  if (pb.has_row_ttl_column()) {
+    result[kTableRowTtlColumn] = pb.row_ttl_column();
+  }
+  if (pb.has_row_ttl_sec()) {
+    result[kTableRowTtlSec] = std::to_string(pb.row_ttl_sec());
+  }
   *configs = std::move(result);
   return Status::OK();
 }
@@ -36,6 +36,7 @@ template <typename Key, typename T> class Map;
 namespace kudu {
 
 class Arena;
+class BlockBloomFilter;
 class ColumnPredicate;
 class ColumnSchema;
 class faststring;
@@ -60,6 +61,13 @@ class TableExtraConfigPB;
 static const std::string kTableHistoryMaxAgeSec = "kudu.table.history_max_age_sec";
 static const std::string kTableMaintenancePriority = "kudu.table.maintenance_priority";
 static const std::string kTableDisableCompaction = "kudu.table.disable_compaction";
+static const std::string kTableColumnGroupSize = "kudu.table.column_group_size";
+static const std::string kTableBloomFilterColumns = "kudu.table.bloom_filter_columns";
+static const std::string kTableColdDataAgeSec = "kudu.table.cold_data_age_sec";
+static const std::string kTableScanBytesPerSecQuota = "kudu.table.scan_bytes_per_sec_quota";
+static const std::string kTableWriteOpsPerSecQuota = "kudu.table.write_ops_per_sec_quota";
+static const std::string kTableRowTtlColumn = "kudu.table.row_ttl_column";
+static const std::string kTableRowTtlSec = "kudu.table.row_ttl_sec";
 
 // Convert the given C++ Status object into the equivalent Protobuf.
 void StatusToPB(const Status& status, AppStatusPB* pb);
@@ -142,6 +150,15 @@ Status ColumnPredicateFromPB(const Schema& schema,
                              const ColumnPredicatePB& pb,
                              std::optional<ColumnPredicate>* predicate);
 
+// Like above, but if 'bloom_filters' isn't null, an InBloomFilter predicate
+// uses those filters instead of decoding the ones of 'pb', which may be
+// empty. The filters must outlive the predicate.
+Status ColumnPredicateFromPB(const Schema& schema,
+                             Arena* arena,
+                             const ColumnPredicatePB& pb,
+                             const std::vector<BlockBloomFilter*>* bloom_filters,
+                             std::optional<ColumnPredicate>* predicate);
+
 // Convert a extra configuration properties protobuf to map.
 Status ExtraConfigPBToMap(const TableExtraConfigPB& pb,
                           std::map<std::string, std::string>* configs);
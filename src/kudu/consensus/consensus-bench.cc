@@ -0,0 +1,303 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmark of the replication path: RaftConsensus with real Logs, across
+// in-process peers which exchange their requests through local proxies, with
+// an optional injected network latency.
+//
+// For each combination of --batch_sizes and --op_sizes, the leader is handed
+// batches of that many NO_OP rounds carrying that many bytes of payload, each
+// batch once the previous one is replicated, for --run_seconds. The ops/s and
+// the percentiles of the latency from handing a round to the leader until it
+// is replicated by a majority are then reported.
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/clock/logical_clock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/timestamp.h"
+#include "kudu/common/wire_protocol-test-util.h"
+#include "kudu/common/wire_protocol.pb.h"
+#include "kudu/consensus/consensus-test-util.h"
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/consensus_meta_manager.h"
+#include "kudu/consensus/log.h"
+#include "kudu/consensus/metadata.pb.h"
+#include "kudu/consensus/opid.pb.h"
+#include "kudu/consensus/opid_util.h"
+#include "kudu/consensus/raft_consensus.h"
+#include "kudu/consensus/time_manager.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/hdr_histogram.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+#include "kudu/util/status_callback.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+#include "kudu/util/threadpool.h"
+
+DEFINE_int32(num_replicas, 3, "Number of replicas of the benchmarked tablet");
+DEFINE_int32(run_seconds, 1, "Seconds to run each combination of batch and op sizes");
+DEFINE_string(batch_sizes, "1,16,64",
+              "Comma-separated numbers of rounds handed to the leader at once");
+DEFINE_string(op_sizes, "64,4096",
+              "Comma-separated sizes in bytes of the payloads of the rounds");
+DEFINE_int32(network_latency_ms, 0,
+             "Latency injected into each request from the leader to a follower");
+
+DECLARE_bool(enable_leader_failure_detection);
+
+METRIC_DECLARE_entity(tablet);
+
+using kudu::log::Log;
+using kudu::log::LogOptions;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace consensus {
+
+namespace {
+
+const char* const kTestTablet = "TestTablet";
+
+// The highest commit latency tracked, in microseconds.
+constexpr uint64_t kMaxLatencyMicros = 60 * 1000 * 1000;
+
+vector<int> ParseSizes(const string& sizes) {
+  vector<int> ret;
+  for (const string& size : strings::Split(sizes, ",", strings::SkipEmpty())) {
+    int val;
+    CHECK(safe_strto32(size, &val) && val > 0) << "invalid size: " << size;
+    ret.push_back(val);
+  }
+  return ret;
+}
+
+void DoNothing(const string& /*reason*/) {
+}
+
+} // anonymous namespace
+
+class ConsensusBench : public KuduTest {
+ public:
+  ConsensusBench()
+      : clock_(Timestamp(1)),
+        metric_entity_(METRIC_ENTITY_tablet.Instantiate(&metric_registry_, "consensus-bench")),
+        schema_(GetSimpleTestSchema()) {
+    options_.tablet_id = kTestTablet;
+    FLAGS_enable_leader_failure_detection = false;
+    CHECK_OK(ThreadPoolBuilder("raft").Build(&raft_pool_));
+  }
+
+  ~ConsensusBench() {
+    if (peers_) {
+      peers_->Clear();
+    }
+  }
+
+  void SetUp() override {
+    KuduTest::SetUp();
+    OverrideFlagForSlowTests("run_seconds", "10");
+    ASSERT_OK(BuildFsManagersAndLogs());
+    ASSERT_OK(BuildAndStartPeers());
+  }
+
+ protected:
+  Status BuildFsManagersAndLogs() {
+    for (int i = 0; i < FLAGS_num_replicas; i++) {
+      shared_ptr<MemTracker> parent_mem_tracker =
+          MemTracker::CreateTracker(-1, Substitute("peer-$0", i));
+      parent_mem_trackers_.push_back(parent_mem_tracker);
+      const string root = GetTestPath(Substitute("peer-$0-root", i));
+      FsManagerOpts opts;
+      opts.parent_mem_tracker = parent_mem_tracker;
+      opts.wal_root = root;
+      opts.data_roots = { root };
+      unique_ptr<FsManager> fs_manager(new FsManager(env_, opts));
+      RETURN_NOT_OK(fs_manager->CreateInitialFileSystemLayout());
+      RETURN_NOT_OK(fs_manager->Open());
+
+      scoped_refptr<Log> log;
+      RETURN_NOT_OK(Log::Open(LogOptions(),
+                              fs_manager.get(),
+                              /*file_cache*/nullptr,
+                              kTestTablet,
+                              schema_,
+                              0, // schema_version
+                              /*metric_entity*/nullptr,
+                              &log));
+      logs_.emplace_back(std::move(log));
+      fs_managers_.push_back(std::move(fs_manager));
+    }
+    return Status::OK();
+  }
+
+  // Builds and starts a configuration of voters, all of them followers but
+  // the last one, which is elected leader.
+  Status BuildAndStartPeers() {
+    for (int i = 0; i < FLAGS_num_replicas; i++) {
+      RaftPeerPB* peer_pb = config_.add_peers();
+      peer_pb->set_member_type(RaftPeerPB::VOTER);
+      peer_pb->set_permanent_uuid(fs_managers_[i]->uuid());
+      HostPortPB* hp = peer_pb->mutable_last_known_addr();
+      hp->set_host(Substitute("peer-$0.fake-domain-for-tests", i));
+      hp->set_port(0);
+    }
+    config_.set_opid_index(kInvalidOpIdIndex);
+    peers_.reset(new TestPeerMapManager(config_));
+
+    for (int i = 0; i < FLAGS_num_replicas; i++) {
+      scoped_refptr<ConsensusMetadataManager> cmeta_manager(
+          new ConsensusMetadataManager(fs_managers_[i].get()));
+      RETURN_NOT_OK(cmeta_manager->Create(kTestTablet, config_, kMinimumTerm));
+      shared_ptr<RaftConsensus> peer;
+      ServerContext ctx({ /*quiescing*/nullptr,
+                          /*num_leaders*/nullptr,
+                          raft_pool_.get() });
+      RETURN_NOT_OK(RaftConsensus::Create(options_,
+                                          config_.peers(i),
+                                          std::move(cmeta_manager),
+                                          std::move(ctx),
+                                          &peer));
+      peers_->AddPeer(config_.peers(i).permanent_uuid(), peer);
+    }
+
+    const MonoDelta latency = FLAGS_network_latency_ms > 0 ?
+        MonoDelta::FromMilliseconds(FLAGS_network_latency_ms) : MonoDelta();
+    for (int i = 0; i < FLAGS_num_replicas; i++) {
+      shared_ptr<RaftConsensus> peer;
+      RETURN_NOT_OK(peers_->GetPeerByIdx(i, &peer));
+      unique_ptr<TestOpFactory> op_factory(new TestOpFactory(logs_[i].get()));
+      op_factory->SetConsensus(peer.get());
+      op_factories_.emplace_back(std::move(op_factory));
+      RETURN_NOT_OK(peer->Start(
+          ConsensusBootstrapInfo(),
+          unique_ptr<PeerProxyFactory>(new LocalTestPeerProxyFactory(peers_.get(), latency)),
+          logs_[i],
+          unique_ptr<TimeManager>(new TimeManager(&clock_, Timestamp::kMin)),
+          op_factories_.back().get(),
+          metric_entity_,
+          &DoNothing));
+    }
+
+    RETURN_NOT_OK(peers_->GetPeerByIdx(FLAGS_num_replicas - 1, &leader_));
+    return leader_->EmulateElectionForTests();
+  }
+
+  // Replicates batches of 'batch_size' rounds with payloads of 'op_size'
+  // bytes for --run_seconds, and reports the throughput and latencies.
+  void RunBenchmark(int batch_size, int op_size) {
+    const string payload(op_size, 'x');
+    HdrHistogram latencies(kMaxLatencyMicros, 2);
+    const scoped_refptr<Log>& leader_log = logs_.back();
+    int64_t num_ops = 0;
+
+    const MonoTime start = MonoTime::Now();
+    const MonoTime deadline = start + MonoDelta::FromSeconds(FLAGS_run_seconds);
+    while (MonoTime::Now() < deadline) {
+      CountDownLatch latch(batch_size);
+      vector<scoped_refptr<ConsensusRound>> rounds;
+      rounds.reserve(batch_size);
+      const MonoTime batch_start = MonoTime::Now();
+      for (int i = 0; i < batch_size; i++) {
+        unique_ptr<ReplicateMsg> msg(new ReplicateMsg());
+        msg->set_op_type(NO_OP);
+        msg->mutable_noop_request()->set_payload_for_tests(payload);
+        msg->set_timestamp(clock_.Now().ToUint64());
+        scoped_refptr<ConsensusRound> round = leader_->NewRound(
+            std::move(msg),
+            [&latencies, &latch, batch_start](const Status& s) {
+              CHECK_OK(s);
+              latencies.Increment((MonoTime::Now() - batch_start).ToMicroseconds());
+              latch.CountDown();
+            });
+        ASSERT_OK(leader_->Replicate(round.get()));
+        rounds.emplace_back(std::move(round));
+      }
+      latch.Wait();
+
+      // Commit the replicated rounds the way the leader's ops would.
+      for (const auto& round : rounds) {
+        CommitMsg commit;
+        commit.set_op_type(NO_OP);
+        *commit.mutable_commited_op_id() = round->id();
+        ASSERT_OK(leader_log->AsyncAppendCommit(commit, &DoNothingStatusCB));
+      }
+      num_ops += batch_size;
+    }
+    const double elapsed_secs = (MonoTime::Now() - start).ToSeconds();
+
+    LOG(INFO) << Substitute(
+        "replicas: $0, network latency: $1ms, batch size: $2, op size: $3 bytes",
+        FLAGS_num_replicas, FLAGS_network_latency_ms, batch_size, op_size);
+    LOG(INFO) << Substitute(
+        "ops/s: $0, commit latency (us): mean $1, p50 $2, p95 $3, p99 $4, p99.9 $5, max $6",
+        static_cast<int64_t>(num_ops / elapsed_secs),
+        static_cast<int64_t>(latencies.MeanValue()),
+        latencies.ValueAtPercentile(50),
+        latencies.ValueAtPercentile(95),
+        latencies.ValueAtPercentile(99),
+        latencies.ValueAtPercentile(99.9),
+        latencies.MaxValue());
+  }
+
+  ConsensusOptions options_;
+  RaftConfigPB config_;
+  vector<shared_ptr<MemTracker>> parent_mem_trackers_;
+  vector<unique_ptr<FsManager>> fs_managers_;
+  vector<scoped_refptr<Log>> logs_;
+  unique_ptr<ThreadPool> raft_pool_;
+  unique_ptr<TestPeerMapManager> peers_;
+  vector<unique_ptr<TestOpFactory>> op_factories_;
+  shared_ptr<RaftConsensus> leader_;
+  clock::LogicalClock clock_;
+  MetricRegistry metric_registry_;
+  scoped_refptr<MetricEntity> metric_entity_;
+  const Schema schema_;
+};
+
+TEST_F(ConsensusBench, BenchmarkReplication) {
+  for (int op_size : ParseSizes(FLAGS_op_sizes)) {
+    for (int batch_size : ParseSizes(FLAGS_batch_sizes)) {
+      SCOPED_TRACE(Substitute("batch size $0, op size $1", batch_size, op_size));
+      NO_FATALS(RunBenchmark(batch_size, op_size));
+    }
+  }
+}
+
+} // namespace consensus
+} // namespace kudu
@@ -40,6 +40,7 @@
 #include "kudu/rpc/messenger.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/threadpool.h"
@@ -484,14 +485,16 @@ class TestPeerMapManager {
 
 // Allows to test remote peers by emulating an RPC.
 // Both the "remote" peer's RPC call and the caller peer's response are executed
-// asynchronously in a ThreadPool.
+// asynchronously in a ThreadPool. If 'latency' is initialized, each Update()
+// is delayed by that much, emulating the network round trip to the peer.
 class LocalTestPeerProxy : public TestPeerProxy {
  public:
   LocalTestPeerProxy(std::string peer_uuid, ThreadPool* pool,
-                     TestPeerMapManager* peers)
+                     TestPeerMapManager* peers, MonoDelta latency = MonoDelta())
       : TestPeerProxy(pool),
         peer_uuid_(std::move(peer_uuid)),
         peers_(peers),
+        latency_(latency),
         miss_comm_(false) {}
 
   void UpdateAsync(const ConsensusRequestPB& request,
@@ -548,6 +551,10 @@ class LocalTestPeerProxy : public TestPeerProxy {
 
   void SendUpdateRequest(const ConsensusRequestPB& request,
                          ConsensusResponsePB* response) {
+    if (latency_.Initialized()) {
+      SleepFor(latency_);
+    }
+
     // Copy the request and the response for the other peer so that ownership
     // remains as close to the dist. impl. as possible.
     ConsensusRequestPB other_peer_req;
@@ -620,13 +627,18 @@ class LocalTestPeerProxy : public TestPeerProxy {
  private:
   const std::string peer_uuid_;
   TestPeerMapManager* const peers_;
+  const MonoDelta latency_;
   bool miss_comm_;
 };
 
 class LocalTestPeerProxyFactory : public PeerProxyFactory {
  public:
-  explicit LocalTestPeerProxyFactory(TestPeerMapManager* peers)
-    : peers_(peers) {
+  // The proxies created delay their requests by 'latency', if initialized.
+  // See LocalTestPeerProxy.
+  explicit LocalTestPeerProxyFactory(TestPeerMapManager* peers,
+                                     MonoDelta latency = MonoDelta())
+    : peers_(peers),
+      latency_(latency) {
     CHECK_OK(ThreadPoolBuilder("test-peer-pool").set_max_threads(3).Build(&pool_));
     CHECK_OK(rpc::MessengerBuilder("test").Build(&messenger_));
   }
@@ -635,7 +647,8 @@ class LocalTestPeerProxyFactory : public PeerProxyFactory {
                   std::unique_ptr<PeerProxy>* proxy) override {
     LocalTestPeerProxy* new_proxy = new LocalTestPeerProxy(peer_pb.permanent_uuid(),
                                                            pool_.get(),
-                                                           peers_);
+                                                           peers_,
+                                                           latency_);
     proxy->reset(new_proxy);
     proxies_.push_back(new_proxy);
     return Status::OK();
@@ -653,6 +666,7 @@ class LocalTestPeerProxyFactory : public PeerProxyFactory {
   std::unique_ptr<ThreadPool> pool_;
   std::shared_ptr<rpc::Messenger> messenger_;
   TestPeerMapManager* const peers_;
+  const MonoDelta latency_;
     // NOTE: There is no need to delete this on the dctor because proxies are externally managed
   std::vector<LocalTestPeerProxy*> proxies_;
 };
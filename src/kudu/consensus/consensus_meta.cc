@@ -18,6 +18,8 @@
 
 #include <cstddef>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <utility>
 
@@ -50,8 +52,16 @@ DEFINE_bool(cmeta_force_fsync, false,
             "Whether fsync() should be called when consensus metadata files are updated");
 TAG_FLAG(cmeta_force_fsync, advanced);
 
+DEFINE_bool(cmeta_group_dir_sync, true,
+            "Whether the fsync() of the consensus metadata directory upon flushing "
+            "consensus metadata is shared by the concurrent flushes of different "
+            "tablets, rather than issued by each of them");
+TAG_FLAG(cmeta_group_dir_sync, advanced);
+TAG_FLAG(cmeta_group_dir_sync, runtime);
+
 DECLARE_bool(cmeta_fsync_override_on_xfs);
 
+using std::shared_ptr;
 using std::string;
 using strings::Substitute;
 
@@ -269,6 +279,45 @@ ConsensusStatePB ConsensusMetadata::ToConsensusStatePB() const {
   return cstate;
 }
 
+ConsensusMetadataDirSyncer::ConsensusMetadataDirSyncer(FsManager* fs_manager)
+    : fs_manager_(CHECK_NOTNULL(fs_manager)),
+      cond_(&lock_),
+      started_count_(0),
+      completed_count_(0),
+      sync_in_progress_(false) {
+}
+
+Status ConsensusMetadataDirSyncer::SyncDir() {
+  std::unique_lock l(lock_);
+  // A sync running now may have started before the caller's changes, so wait
+  // for the next one.
+  const int64_t needed_count = started_count_ + 1;
+  while (completed_count_ < needed_count) {
+    if (sync_in_progress_) {
+      cond_.Wait();
+      continue;
+    }
+    sync_in_progress_ = true;
+    const int64_t count = ++started_count_;
+    l.unlock();
+    Status s = fs_manager_->GetEnv()->SyncDir(fs_manager_->GetConsensusMetadataDir());
+    l.lock();
+    completed_count_ = count;
+    last_status_ = std::move(s);
+    sync_in_progress_ = false;
+    cond_.Broadcast();
+  }
+  // Any successful sync which started after the caller's changes made them
+  // durable, so it doesn't matter if it's a later one than 'needed_count'.
+  return last_status_.CloneAndPrepend(
+      "Unable to fsync consensus metadata dir " + fs_manager_->GetConsensusMetadataDir());
+}
+
+int64_t ConsensusMetadataDirSyncer::sync_count_for_tests() const {
+  std::lock_guard l(lock_);
+  return completed_count_;
+}
+
 void ConsensusMetadata::MergeCommittedConsensusStatePB(const ConsensusStatePB& cstate) {
   DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   if (cstate.current_term() > current_term()) {
@@ -306,23 +355,28 @@ Status ConsensusMetadata::Flush(FlushMode flush_mode) {
 
   const bool cmeta_force_fsync =
       FLAGS_cmeta_force_fsync || (FLAGS_cmeta_fsync_override_on_xfs && fs_manager_->meta_on_xfs());
+  // We use FLAGS_log_force_fsync_all here because the consensus metadata is
+  // essentially an extension of the primary durability mechanism of the
+  // consensus subsystem: the WAL. Using the same flag ensures that the WAL
+  // and the consensus metadata get the same durability guarantees.
+  // We add FLAGS_cmeta_force_fsync to support an override in certain
+  // cases. Some filesystems such as ext4 are more forgiving to omitting an
+  // fsync() due to periodic commit with default settings, whereas other
+  // filesystems such as XFS will not commit as often and need the fsync to
+  // avoid significant data loss when a crash happens.
+  const bool sync = FLAGS_log_force_fsync_all || cmeta_force_fsync;
+  const bool group_dir_sync = sync && dir_syncer_ && FLAGS_cmeta_group_dir_sync;
   string meta_file_path = fs_manager_->GetConsensusMetadataPath(tablet_id_);
   RETURN_NOT_OK_PREPEND(pb_util::WritePBContainerToPath(
       fs_manager_->GetEnv(), meta_file_path, pb_,
       flush_mode == OVERWRITE ? pb_util::OVERWRITE : pb_util::NO_OVERWRITE,
-      // We use FLAGS_log_force_fsync_all here because the consensus metadata is
-      // essentially an extension of the primary durability mechanism of the
-      // consensus subsystem: the WAL. Using the same flag ensures that the WAL
-      // and the consensus metadata get the same durability guarantees.
-      // We add FLAGS_cmeta_force_fsync to support an override in certain
-      // cases. Some filesystems such as ext4 are more forgiving to omitting an
-      // fsync() due to periodic commit with default settings, whereas other
-      // filesystems such as XFS will not commit as often and need the fsync to
-      // avoid significant data loss when a crash happens.
-      FLAGS_log_force_fsync_all || cmeta_force_fsync ? pb_util::SYNC : pb_util::NO_SYNC,
+      group_dir_sync ? pb_util::SYNC_FILE_ONLY : (sync ? pb_util::SYNC : pb_util::NO_SYNC),
       pb_util::SENSITIVE),
           Substitute("Unable to write consensus meta file for tablet $0 to path $1",
                      tablet_id_, meta_file_path));
+  if (group_dir_sync) {
+    RETURN_NOT_OK(dir_syncer_->SyncDir());
+  }
   return UpdateOnDiskSize();
 }
 
@@ -334,10 +388,12 @@ ConsensusMetadata::RoleAndTerm ConsensusMetadata::GetRoleAndTerm() const {
 
 ConsensusMetadata::ConsensusMetadata(FsManager* fs_manager,
                                      std::string tablet_id,
-                                     std::string peer_uuid)
+                                     std::string peer_uuid,
+                                     shared_ptr<ConsensusMetadataDirSyncer> dir_syncer)
     : fs_manager_(CHECK_NOTNULL(fs_manager)),
       tablet_id_(std::move(tablet_id)),
       peer_uuid_(std::move(peer_uuid)),
+      dir_syncer_(std::move(dir_syncer)),
       has_pending_config_(false),
       flush_count_for_tests_(0),
       active_role_(RaftPeerPB::UNKNOWN_ROLE),
@@ -351,9 +407,11 @@ Status ConsensusMetadata::Create(FsManager* fs_manager,
                                  const RaftConfigPB& config,
                                  int64_t current_term,
                                  ConsensusMetadataCreateMode create_mode,
-                                 scoped_refptr<ConsensusMetadata>* cmeta_out) {
+                                 scoped_refptr<ConsensusMetadata>* cmeta_out,
+                                 shared_ptr<ConsensusMetadataDirSyncer> dir_syncer) {
 
-  scoped_refptr<ConsensusMetadata> cmeta(new ConsensusMetadata(fs_manager, tablet_id, peer_uuid));
+  scoped_refptr<ConsensusMetadata> cmeta(
+      new ConsensusMetadata(fs_manager, tablet_id, peer_uuid, std::move(dir_syncer)));
   cmeta->set_committed_config(config);
   cmeta->set_current_term(current_term);
 
@@ -373,8 +431,10 @@ Status ConsensusMetadata::Create(FsManager* fs_manager,
 Status ConsensusMetadata::Load(FsManager* fs_manager,
                                const std::string& tablet_id,
                                const std::string& peer_uuid,
-                               scoped_refptr<ConsensusMetadata>* cmeta_out) {
-  scoped_refptr<ConsensusMetadata> cmeta(new ConsensusMetadata(fs_manager, tablet_id, peer_uuid));
+                               scoped_refptr<ConsensusMetadata>* cmeta_out,
+                               shared_ptr<ConsensusMetadataDirSyncer> dir_syncer) {
+  scoped_refptr<ConsensusMetadata> cmeta(
+      new ConsensusMetadata(fs_manager, tablet_id, peer_uuid, std::move(dir_syncer)));
   RETURN_NOT_OK(pb_util::ReadPBContainerFromPath(fs_manager->GetEnv(),
                                                  fs_manager->GetConsensusMetadataPath(tablet_id),
                                                  &cmeta->pb_,
@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -28,11 +29,13 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/threading/thread_collision_warner.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
 
 namespace kudu {
 
 class FsManager;
-class Status;
 
 namespace consensus {
 
@@ -44,6 +47,41 @@ enum class ConsensusMetadataCreateMode {
   NO_FLUSH_ON_CREATE,
 };
 
+// Group-commits the fsync()s of the consensus metadata directory which make
+// the flushes of the consensus metadata files durable. The flushes of many
+// tablets at once, e.g. upon a mass election after a restart, then share a
+// few fsync()s of the directory instead of issuing one each.
+//
+// This class is thread-safe.
+class ConsensusMetadataDirSyncer {
+ public:
+  explicit ConsensusMetadataDirSyncer(FsManager* fs_manager);
+
+  // Makes the changes to the directory entries made before the call durable.
+  // Waits for a sync of the directory which started after the call, running
+  // it unless another thread already does.
+  Status SyncDir();
+
+  int64_t sync_count_for_tests() const;
+
+ private:
+  FsManager* const fs_manager_;
+
+  mutable Mutex lock_;
+  ConditionVariable cond_;
+
+  // The number of syncs of the directory started and completed so far, and
+  // whether one is running. Protected by 'lock_'.
+  int64_t started_count_;
+  int64_t completed_count_;
+  bool sync_in_progress_;
+
+  // The result of the last completed sync. Protected by 'lock_'.
+  Status last_status_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsensusMetadataDirSyncer);
+};
+
 // Provides methods to read, write, and persist consensus-related metadata.
 // This partly corresponds to Raft Figure 2's "Persistent state on all servers".
 //
@@ -182,13 +220,17 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   FRIEND_TEST(ConsensusMetadataTest, TestMergeCommittedConsensusStatePB);
 
   ConsensusMetadata(FsManager* fs_manager, std::string tablet_id,
-                    std::string peer_uuid);
+                    std::string peer_uuid,
+                    std::shared_ptr<ConsensusMetadataDirSyncer> dir_syncer);
 
   // Create a ConsensusMetadata object with provided initial state.
   // If 'create_mode' is set to FLUSH_ON_CREATE, the encoded PB is flushed to
   // disk before returning. Otherwise, if 'create_mode' is set to
   // NO_FLUSH_ON_CREATE, the caller must explicitly call Flush() on the
   // returned object to get the bytes onto disk.
+  //
+  // If 'dir_syncer' is set, the flushes of the object sync the consensus
+  // metadata directory through it.
   static Status Create(FsManager* fs_manager,
                        const std::string& tablet_id,
                        const std::string& peer_uuid,
@@ -196,7 +238,8 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
                        int64_t current_term,
                        ConsensusMetadataCreateMode create_mode =
                            ConsensusMetadataCreateMode::FLUSH_ON_CREATE,
-                       scoped_refptr<ConsensusMetadata>* cmeta_out = nullptr);
+                       scoped_refptr<ConsensusMetadata>* cmeta_out = nullptr,
+                       std::shared_ptr<ConsensusMetadataDirSyncer> dir_syncer = nullptr);
 
   // Load a ConsensusMetadata object from disk.
   // Returns Status::NotFound if the file could not be found. May return other
@@ -204,7 +247,8 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   static Status Load(FsManager* fs_manager,
                      const std::string& tablet_id,
                      const std::string& peer_uuid,
-                     scoped_refptr<ConsensusMetadata>* cmeta_out = nullptr);
+                     scoped_refptr<ConsensusMetadata>* cmeta_out = nullptr,
+                     std::shared_ptr<ConsensusMetadataDirSyncer> dir_syncer = nullptr);
 
   // Delete the ConsensusMetadata file associated with the given tablet from
   // disk. Returns Status::NotFound if the on-disk data is not found.
@@ -228,6 +272,9 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   const std::string tablet_id_;
   const std::string peer_uuid_;
 
+  // Syncs the consensus metadata directory upon flushes, if set.
+  const std::shared_ptr<ConsensusMetadataDirSyncer> dir_syncer_;
+
   // This fake mutex helps ensure that this ConsensusMetadata object stays
   // externally synchronized.
   DFAKE_MUTEX(fake_lock_);
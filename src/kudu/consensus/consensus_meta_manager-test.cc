@@ -20,7 +20,11 @@
 #include <cstdint>
 #include <initializer_list>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include <gflags/gflags_declare.h>
+#include <glog/logging.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
 
@@ -30,11 +34,18 @@
 #include "kudu/consensus/quorum_util.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(cmeta_force_fsync);
+
 using google::protobuf::util::MessageDifferencer;
+using std::string;
+using std::thread;
+using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace consensus {
@@ -158,5 +169,58 @@ TEST_F(ConsensusMetadataManagerTest, TestNoClobber) {
   }
 }
 
+// Test that concurrent syncs of the consensus metadata directory are batched.
+TEST_F(ConsensusMetadataManagerTest, TestGroupDirSync) {
+  constexpr int kNumThreads = 16;
+  constexpr int kNumSyncsPerThread = 10;
+  ConsensusMetadataDirSyncer syncer(&fs_manager_);
+  vector<thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < kNumSyncsPerThread; j++) {
+        CHECK_OK(syncer.SyncDir());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_GE(syncer.sync_count_for_tests(), kNumSyncsPerThread);
+  ASSERT_LE(syncer.sync_count_for_tests(), kNumThreads * kNumSyncsPerThread);
+}
+
+// Test that the consensus metadata of many tablets flushed concurrently, and
+// so sharing the fsync()s of their directory, is all persisted.
+TEST_F(ConsensusMetadataManagerTest, TestConcurrentFlushes) {
+  FLAGS_cmeta_force_fsync = true;
+  constexpr int kNumTablets = 16;
+  constexpr int kNumFlushesPerTablet = 10;
+  vector<scoped_refptr<ConsensusMetadata>> cmetas(kNumTablets);
+  for (int i = 0; i < kNumTablets; i++) {
+    ASSERT_OK(cmeta_manager_->Create(Substitute("$0-$1", kTabletId, i), config_, kInitialTerm,
+                                     ConsensusMetadataCreateMode::FLUSH_ON_CREATE,
+                                     &cmetas[i]));
+  }
+  vector<thread> threads;
+  for (int i = 0; i < kNumTablets; i++) {
+    threads.emplace_back([&, i] {
+      for (int term = kInitialTerm + 1; term <= kInitialTerm + kNumFlushesPerTablet; term++) {
+        cmetas[i]->set_current_term(term);
+        CHECK_OK(cmetas[i]->Flush());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  scoped_refptr<ConsensusMetadataManager> new_manager(new ConsensusMetadataManager(&fs_manager_));
+  for (int i = 0; i < kNumTablets; i++) {
+    scoped_refptr<ConsensusMetadata> cmeta;
+    ASSERT_OK(new_manager->Load(Substitute("$0-$1", kTabletId, i), &cmeta));
+    ASSERT_EQ(kInitialTerm + kNumFlushesPerTablet, cmeta->current_term());
+  }
+}
+
 } // namespace consensus
 } // namespace kudu
@@ -16,6 +16,7 @@
 // under the License.
 #include "kudu/consensus/consensus_meta_manager.h"
 
+#include <memory>
 #include <mutex>
 #include <utility>
 
@@ -35,7 +36,8 @@ using std::string;
 using strings::Substitute;
 
 ConsensusMetadataManager::ConsensusMetadataManager(FsManager* fs_manager)
-    : fs_manager_(DCHECK_NOTNULL(fs_manager)) {
+    : fs_manager_(DCHECK_NOTNULL(fs_manager)),
+      dir_syncer_(std::make_shared<ConsensusMetadataDirSyncer>(fs_manager)) {
 }
 
 Status ConsensusMetadataManager::Create(const string& tablet_id,
@@ -46,7 +48,7 @@ Status ConsensusMetadataManager::Create(const string& tablet_id,
   scoped_refptr<ConsensusMetadata> cmeta;
   RETURN_NOT_OK_PREPEND(ConsensusMetadata::Create(fs_manager_, tablet_id, fs_manager_->uuid(),
                                                   config, initial_term, create_mode,
-                                                  &cmeta),
+                                                  &cmeta, dir_syncer_),
                         Substitute("Unable to create consensus metadata for tablet $0", tablet_id));
 
   lock_guard<Mutex> l(lock_);
@@ -74,7 +76,7 @@ Status ConsensusMetadataManager::Load(const string& tablet_id,
   // If it's not yet cached, drop the lock before we load it.
   scoped_refptr<ConsensusMetadata> cmeta;
   RETURN_NOT_OK_PREPEND(ConsensusMetadata::Load(fs_manager_, tablet_id, fs_manager_->uuid(),
-                                                &cmeta),
+                                                &cmeta, dir_syncer_),
                         Substitute("Unable to load consensus metadata for tablet $0", tablet_id));
 
   // Cache and return the loaded ConsensusMetadata.
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -42,6 +43,10 @@ class RaftConfigPB;
 // provides flexibility to change the underlying implementation of
 // ConsensusMetadata in the future.
 //
+// The flushes of the consensus metadata instances of different tablets share
+// the fsync()s of the consensus metadata directory, see
+// ConsensusMetadataDirSyncer.
+//
 // This class is ONLY thread-safe across different tablets. Concurrent access
 // to Create(), Load(), or Delete() for the same tablet id is thread-hostile
 // and must be externally synchronized. Failure to do so may result in a crash.
@@ -86,6 +91,10 @@ class ConsensusMetadataManager : public RefCountedThreadSafe<ConsensusMetadataMa
 
   FsManager* const fs_manager_;
 
+  // Shared by the ConsensusMetadata instances created or loaded by this
+  // manager.
+  const std::shared_ptr<ConsensusMetadataDirSyncer> dir_syncer_;
+
   // Lock protecting the map below.
   Mutex lock_;
 
@@ -17,12 +17,17 @@
 
 #include "kudu/consensus/consensus_peers.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -44,7 +49,9 @@
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/messenger.h"
+#include "kudu/rpc/response_callback.h"
 #include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
@@ -52,6 +59,9 @@
 #include "kudu/util/test_util.h"
 #include "kudu/util/threadpool.h"
 
+DECLARE_int32(consensus_max_inflight_requests_per_peer);
+DECLARE_int32(raft_heartbeat_interval_ms);
+
 METRIC_DECLARE_entity(tablet);
 METRIC_DECLARE_entity(server);
 
@@ -62,6 +72,7 @@ using kudu::rpc::MessengerBuilder;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
+using std::vector;
 
 namespace kudu {
 namespace consensus {
@@ -73,6 +84,104 @@ const char* kFollowerUuid = "peer-1";
 template class OneTimeUsePeerProxyFactory<DelayablePeerProxy<NoOpTestPeerProxy>>;
 template class OneTimeUsePeerProxyFactory<MockedPeerProxy>;
 
+// Emulates a remote replica which appends the ops it receives right away, but
+// holds the responses until RespondToAll() is called.
+class HoldingPeerProxy : public PeerProxy {
+ public:
+  HoldingPeerProxy(ThreadPool* pool, RaftPeerPB peer_pb)
+      : pool_(pool),
+        peer_pb_(std::move(peer_pb)),
+        last_received_(MinimumOpId()) {
+  }
+
+  void UpdateAsync(const ConsensusRequestPB& request,
+                   ConsensusResponsePB* response,
+                   rpc::RpcController* /*controller*/,
+                   const rpc::ResponseCallback& callback) override {
+    std::lock_guard<simple_spinlock> l(lock_);
+    response->Clear();
+    if (last_received_ < request.preceding_id()) {
+      ConsensusErrorPB* error = response->mutable_status()->mutable_error();
+      error->set_code(ConsensusErrorPB::PRECEDING_ENTRY_DIDNT_MATCH);
+      StatusToPB(Status::IllegalState(""), error->mutable_status());
+    } else if (request.ops_size() > 0) {
+      last_received_.CopyFrom(request.ops(request.ops_size() - 1).id());
+    }
+    response->set_responder_uuid(peer_pb_.permanent_uuid());
+    response->set_responder_term(request.caller_term());
+    response->mutable_status()->mutable_last_received()->CopyFrom(last_received_);
+    response->mutable_status()->mutable_last_received_current_leader()->CopyFrom(
+        last_received_);
+    response->mutable_status()->set_last_committed_idx(last_received_.index());
+
+    first_op_indexes_.push_back(request.ops_size() > 0 ? request.ops(0).id().index() : -1);
+    held_callbacks_.push_back(callback);
+    max_held_ = std::max(max_held_, static_cast<int>(held_callbacks_.size()));
+  }
+
+  void RequestConsensusVoteAsync(const VoteRequestPB& /*request*/,
+                                 VoteResponsePB* /*response*/,
+                                 rpc::RpcController* /*controller*/,
+                                 const rpc::ResponseCallback& callback) override {
+    callback();
+  }
+
+  void StartElectionAsync(const RunLeaderElectionRequestPB& /*request*/,
+                          RunLeaderElectionResponsePB* /*response*/,
+                          rpc::RpcController* /*controller*/,
+                          const rpc::ResponseCallback& callback) override {
+    callback();
+  }
+
+  std::string PeerName() const override {
+    return "HoldingPeerProxy";
+  }
+
+  // Responds to all the requests received so far.
+  void RespondToAll() {
+    vector<rpc::ResponseCallback> callbacks;
+    {
+      std::lock_guard<simple_spinlock> l(lock_);
+      callbacks.swap(held_callbacks_);
+    }
+    for (auto& c : callbacks) {
+      CHECK_OK(pool_->Submit(std::move(c)));
+    }
+  }
+
+  int num_held() const {
+    std::lock_guard<simple_spinlock> l(lock_);
+    return held_callbacks_.size();
+  }
+
+  int max_held() const {
+    std::lock_guard<simple_spinlock> l(lock_);
+    return max_held_;
+  }
+
+  // The index of the first op of each request received so far, or -1 for
+  // the requests without ops.
+  vector<int64_t> first_op_indexes() const {
+    std::lock_guard<simple_spinlock> l(lock_);
+    return first_op_indexes_;
+  }
+
+  OpId last_received() const {
+    std::lock_guard<simple_spinlock> l(lock_);
+    return last_received_;
+  }
+
+ private:
+  ThreadPool* pool_;
+  const RaftPeerPB peer_pb_;
+
+  mutable simple_spinlock lock_;
+  OpId last_received_;
+  vector<rpc::ResponseCallback> held_callbacks_;
+  int max_held_ = 0;
+  vector<int64_t> first_op_indexes_;
+};
+
 class ConsensusPeersTest : public KuduTest {
  public:
   ConsensusPeersTest()
@@ -372,6 +481,61 @@ TEST_F(ConsensusPeersTest, TestDontSendOneRpcPerWriteWhenPeerIsDown) {
   ASSERT_LT(mock_proxy->update_count(), 5);
 }
 
+// Tests that the requests carrying new ops are pipelined while the previous
+// ones are in flight, up to --consensus_max_inflight_requests_per_peer.
+TEST_F(ConsensusPeersTest, TestPipelinedRequests) {
+  FLAGS_consensus_max_inflight_requests_per_peer = 3;
+  // Only send the requests that the test triggers.
+  FLAGS_raft_heartbeat_interval_ms = 60 * 1000;
+
+  message_queue_->SetLeaderMode(kMinimumOpIdIndex,
+                                kMinimumTerm,
+                                BuildRaftConfigPBForTests(3));
+
+  RaftPeerPB peer_pb = FakeRaftPeerPB(kFollowerUuid);
+  auto* proxy = new HoldingPeerProxy(raft_pool_.get(), peer_pb);
+  OneTimeUsePeerProxyFactory<HoldingPeerProxy> factory(messenger_, proxy);
+  shared_ptr<Peer> peer;
+  Peer::NewRemotePeer(std::move(peer_pb),
+                      kTabletId,
+                      kLeaderUuid,
+                      message_queue_.get(),
+                      raft_pool_token_.get(),
+                      &factory,
+                      &peer);
+
+  // Negotiate with the peer: no request is pipelined behind this one.
+  ASSERT_OK(peer->SignalRequest(true));
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(1, proxy->num_held());
+  });
+  proxy->RespondToAll();
+
+  // Each of the next ops is sent right away while the requests before it are
+  // still in flight, until the window is full.
+  for (int i = 1; i <= 3; i++) {
+    AppendReplicateMessagesToQueue(message_queue_.get(), clock_.get(), i, 1);
+    ASSERT_OK(peer->SignalRequest());
+    ASSERT_EVENTUALLY([&]() {
+      ASSERT_EQ(i, proxy->num_held());
+    });
+  }
+  AppendReplicateMessagesToQueue(message_queue_.get(), clock_.get(), 4, 1);
+  ASSERT_OK(peer->SignalRequest());
+  SleepFor(MonoDelta::FromMilliseconds(100));
+  ASSERT_EQ(3, proxy->num_held());
+  ASSERT_EQ(vector<int64_t>({ -1, 1, 2, 3 }), proxy->first_op_indexes());
+  ASSERT_LT(message_queue_->GetCommittedIndex(), 1);
+
+  // Once the peer responds, the last op is sent as well.
+  ASSERT_EVENTUALLY([&]() {
+    proxy->RespondToAll();
+    ASSERT_GE(message_queue_->GetCommittedIndex(), 4);
+  });
+  ASSERT_EQ(4, proxy->last_received().index());
+  ASSERT_EQ(3, proxy->max_held());
+}
+
 }  // namespace consensus
 }  // namespace kudu
 
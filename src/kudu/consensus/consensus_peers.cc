@@ -36,6 +36,7 @@
 #include "kudu/consensus/consensus.pb.h"
 #include "kudu/consensus/consensus.proxy.h"
 #include "kudu/consensus/consensus_queue.h"
+#include "kudu/consensus/heartbeat_coalescer.h"
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/consensus/opid_util.h"
 #include "kudu/gutil/macros.h"
@@ -81,6 +82,27 @@ DEFINE_bool(enable_tablet_copy, true,
             "replica. For testing purposes only.");
 TAG_FLAG(enable_tablet_copy, unsafe);
 
+DEFINE_int32(consensus_max_inflight_requests_per_peer, 1,
+             "The maximum number of UpdateConsensus RPCs a leader may have in flight "
+             "to each of its followers. When greater than one, the requests carrying "
+             "new ops are pipelined while the follower is in sync with the leader, "
+             "so that the replication throughput to distant followers isn't bounded "
+             "by the round-trip time.");
+TAG_FLAG(consensus_max_inflight_requests_per_peer, advanced);
+TAG_FLAG(consensus_max_inflight_requests_per_peer, experimental);
+
+// Validate that consensus_max_inflight_requests_per_peer >= 1
+static bool ValidateMaxInflightRequestsPerPeer(const char* flagname, int value) {
+  if (value >= 1) {
+    return true;
+  }
+  LOG(ERROR) << strings::Substitute("$0 must be at least 1, value $1 is invalid",
+                                    flagname, value);
+  return false;
+}
+DEFINE_validator(consensus_max_inflight_requests_per_peer,
+                 &ValidateMaxInflightRequestsPerPeer);
+
 DECLARE_int32(raft_heartbeat_interval_ms);
 
 using kudu::pb_util::SecureShortDebugString;
@@ -135,11 +157,16 @@ Peer::Peer(RaftPeerPB peer_pb,
       peer_proxy_factory_(peer_proxy_factory),
       queue_(queue),
       failed_attempts_(0),
+      max_update_rpcs_in_flight_(FLAGS_consensus_max_inflight_requests_per_peer),
+      last_request_committed_index_(kMinimumOpIdIndex),
       messenger_(peer_proxy_factory_->messenger()),
       raft_pool_token_(raft_pool_token),
       request_pending_(false),
       closed_(false),
-      has_sent_first_request_(false) {
+      has_sent_first_request_(false),
+      update_rpcs_in_flight_(0),
+      pipeline_stalled_(false),
+      next_dormant_heartbeat_time_(MonoTime::Min()) {
   CreateProxyIfNeeded();
 }
 
@@ -156,7 +183,7 @@ void Peer::Init() {
       messenger_,
       [w]() {
         if (auto p = w.lock()) {
-          p->SignalRequest(true);
+          p->Heartbeat();
         }
       },
       MonoDelta::FromMilliseconds(FLAGS_raft_heartbeat_interval_ms));
@@ -173,7 +200,7 @@ Status Peer::SignalRequest(bool even_if_queue_empty) {
     return Status::IllegalState("Peer was closed.");
   }
 
-  // Only allow one request at a time. No sense waking up the
+  // Only allow so many requests at a time. No sense waking up the
   // raft thread pool if the task will just abort anyway.
   if (request_pending_) {
     return Status::OK();
@@ -189,13 +216,28 @@ Status Peer::SignalRequest(bool even_if_queue_empty) {
   });
 }
 
+void Peer::Heartbeat() {
+  {
+    std::lock_guard<simple_spinlock> l(peer_lock_);
+    if (MonoTime::Now() < next_dormant_heartbeat_time_) {
+      return;
+    }
+  }
+  SignalRequest(true);
+}
+
+Peer::UpdateRpc::~UpdateRpc() {
+  // We don't own the ops (the queue does).
+  request.mutable_ops()->ExtractSubrange(0, request.ops_size(), nullptr);
+}
+
 void Peer::SendNextRequest(bool even_if_queue_empty) {
   std::unique_lock<simple_spinlock> l(peer_lock_);
   if (PREDICT_FALSE(closed_)) {
     return;
   }
 
-  // Only allow one request at a time.
+  // Only allow so many requests at a time.
   if (request_pending_) {
     return;
   }
@@ -221,14 +263,38 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
     return;
   }
 
+  auto rpc = std::make_shared<UpdateRpc>();
+
+  if (update_rpcs_in_flight_ > 0) {
+    // Pipeline the next ops behind the requests in flight, if the peer is in
+    // sync. There's no need for heartbeats or status-only requests: the
+    // responses to the requests in flight will do.
+    if (pipeline_stalled_ || failed_attempts_ > 0) {
+      return;
+    }
+    Status s = queue_->PipelinedRequestForPeer(peer_pb_.permanent_uuid(), &rpc->request,
+                                               &rpc->replicate_msg_refs);
+    if (PREDICT_FALSE(!s.ok())) {
+      VLOG_WITH_PREFIX_UNLOCKED(1) << s.ToString();
+      return;
+    }
+    if (rpc->request.ops_size() == 0) {
+      return;
+    }
+    last_request_committed_index_ = rpc->request.committed_index();
+    heartbeater_->Snooze();
+    SendUpdateRpc(std::move(rpc), &l);
+    return;
+  }
+
   // The peer has no pending request nor is sending: send the request.
   bool needs_tablet_copy = false;
-  int64_t commit_index_before = request_.has_committed_index() ?
-      request_.committed_index() : kMinimumOpIdIndex;
-  Status s = queue_->RequestForPeer(peer_pb_.permanent_uuid(), &request_,
-                                    &replicate_msg_refs_, &needs_tablet_copy);
-  int64_t commit_index_after = request_.has_committed_index() ?
-      request_.committed_index() : kMinimumOpIdIndex;
+  int64_t commit_index_before = last_request_committed_index_;
+  Status s = queue_->RequestForPeer(peer_pb_.permanent_uuid(), &rpc->request,
+                                    &rpc->replicate_msg_refs, &needs_tablet_copy);
+  int64_t commit_index_after = rpc->request.has_committed_index() ?
+      rpc->request.committed_index() : commit_index_before;
+  last_request_committed_index_ = commit_index_after;
 
   if (PREDICT_FALSE(!s.ok())) {
     VLOG_WITH_PREFIX_UNLOCKED(1) << s.ToString();
@@ -246,13 +312,13 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
   if (PREDICT_FALSE(needs_tablet_copy)) {
     Status s = PrepareTabletCopyRequest();
     if (s.ok()) {
-      controller_.Reset();
+      tc_controller_.Reset();
       request_pending_ = true;
       l.unlock();
       // Capture a shared_ptr reference into the RPC callback so that we're guaranteed
       // that this object outlives the RPC.
       shared_ptr<Peer> s_this = shared_from_this();
-      proxy_->StartTabletCopyAsync(tc_request_, &tc_response_, &controller_,
+      proxy_->StartTabletCopyAsync(tc_request_, &tc_response_, &tc_controller_,
                                    [s_this]() {
                                      s_this->ProcessTabletCopyResponse();
                                    });
@@ -263,7 +329,7 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
     return;
   }
 
-  bool req_has_ops = request_.ops_size() > 0 || (commit_index_after > commit_index_before);
+  bool req_has_ops = rpc->request.ops_size() > 0 || (commit_index_after > commit_index_before);
   // If the queue is empty, check if we were told to send a status-only
   // message, if not just return.
   if (PREDICT_FALSE(!req_has_ops && !even_if_queue_empty)) {
@@ -275,30 +341,55 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
     heartbeater_->Snooze();
   }
 
-  if (!has_sent_first_request_) {
-    // Set the 'immutable' fields in the request only once upon first request.
-    request_.set_tablet_id(tablet_id_);
-    request_.set_caller_uuid(leader_uuid_);
-    request_.set_dest_uuid(peer_pb_.permanent_uuid());
-    has_sent_first_request_ = true;
-  }
+  // The exchanges which failed before are over: requests may be pipelined
+  // behind this one once it succeeds.
+  pipeline_stalled_ = false;
+  // Only the heartbeats to a replica known to be healthy are coalesced: the
+  // others are sent right away, as they're likely to fail or to be retried.
+  rpc->is_heartbeat = !req_has_ops && failed_attempts_ == 0 && has_sent_first_request_;
+  SendUpdateRpc(std::move(rpc), &l);
+}
+
+void Peer::SendUpdateRpc(shared_ptr<UpdateRpc> rpc,
+                         std::unique_lock<simple_spinlock>* l) {
+  DCHECK(peer_lock_.is_locked());
+  ConsensusRequestPB* request = &rpc->request;
+  request->set_tablet_id(tablet_id_);
+  request->set_caller_uuid(leader_uuid_);
+  request->set_dest_uuid(peer_pb_.permanent_uuid());
+  has_sent_first_request_ = true;
 
   MAYBE_FAULT(FLAGS_fault_crash_on_leader_request_fraction);
 
   VLOG_WITH_PREFIX_UNLOCKED(2) << "Sending to peer " << peer_pb().permanent_uuid() << ": "
-      << SecureShortDebugString(request_);
-
-  controller_.Reset();
-  request_pending_ = true;
-  l.unlock();
+      << SecureShortDebugString(*request);
+
+  update_rpcs_in_flight_++;
+  request_pending_ = update_rpcs_in_flight_ >= max_update_rpcs_in_flight_;
+  rpc->send_time = MonoTime::Now();
+  // The heartbeater ticks every --raft_heartbeat_interval_ms: the next
+  // heartbeat of a dormant tablet is sent within its interval of this one.
+  next_dormant_heartbeat_time_ = request->has_dormant_heartbeat_interval_ms() ?
+      rpc->send_time + MonoDelta::FromMilliseconds(
+          request->dormant_heartbeat_interval_ms() - FLAGS_raft_heartbeat_interval_ms) :
+      MonoTime::Min();
+  l->unlock();
 
   // Capture a shared_ptr reference into the RPC callback so that we're guaranteed
   // that this object outlives the RPC.
+  //
+  // NOTE: the requests pipelined from different threads may be sent out of
+  // order. The peer then rejects the later one, which stalls the pipeline
+  // until the requests in flight are over.
   shared_ptr<Peer> s_this = shared_from_this();
-  proxy_->UpdateAsync(request_, &response_, &controller_,
-                      [s_this]() {
-                        s_this->ProcessResponse();
-                      });
+  auto callback = [s_this, rpc]() {
+    s_this->ProcessResponse(rpc);
+  };
+  if (rpc->is_heartbeat) {
+    proxy_->HeartbeatAsync(*request, &rpc->response, &rpc->controller, callback);
+  } else {
+    proxy_->UpdateAsync(*request, &rpc->response, &rpc->controller, callback);
+  }
 }
 
 void Peer::StartElection() {
@@ -333,44 +424,46 @@ void Peer::StartElection() {
     });
 }
 
-void Peer::ProcessResponse() {
+void Peer::ProcessResponse(const shared_ptr<UpdateRpc>& rpc) {
   // Note: This method runs on the reactor thread.
   std::lock_guard<simple_spinlock> lock(peer_lock_);
   if (PREDICT_FALSE(closed_)) {
     return;
   }
-  CHECK(request_pending_);
+  CHECK_GT(update_rpcs_in_flight_, 0);
 
   MAYBE_FAULT(FLAGS_fault_crash_after_leader_request_fraction);
 
+  const ConsensusResponsePB& response = rpc->response;
+
   // Process RpcController errors.
-  const auto controller_status = controller_.status();
+  const auto controller_status = rpc->controller.status();
   if (!controller_status.ok()) {
     auto ps = controller_status.IsRemoteError() ?
         PeerStatus::REMOTE_ERROR : PeerStatus::RPC_LAYER_ERROR;
     queue_->UpdatePeerStatus(peer_pb_.permanent_uuid(), ps, controller_status);
-    ProcessResponseErrorUnlocked(controller_status);
+    ProcessResponseErrorUnlocked(*rpc, controller_status);
     return;
   }
 
   // Process CANNOT_PREPARE.
   // TODO(todd): there is no integration test coverage of this code path. Likely a bug in
   // this path is responsible for KUDU-1779.
-  if (response_.status().has_error() &&
-      response_.status().error().code() == consensus::ConsensusErrorPB::CANNOT_PREPARE) {
-    Status response_status = StatusFromPB(response_.status().error().status());
+  if (response.status().has_error() &&
+      response.status().error().code() == consensus::ConsensusErrorPB::CANNOT_PREPARE) {
+    Status response_status = StatusFromPB(response.status().error().status());
     queue_->UpdatePeerStatus(peer_pb_.permanent_uuid(), PeerStatus::CANNOT_PREPARE,
                              response_status);
-    ProcessResponseErrorUnlocked(response_status);
+    ProcessResponseErrorUnlocked(*rpc, response_status);
     return;
   }
 
   // Process tserver-level errors.
-  if (response_.has_error()) {
-    Status response_status = StatusFromPB(response_.error().status());
+  if (response.has_error()) {
+    Status response_status = StatusFromPB(response.error().status());
     PeerStatus ps;
-    TabletServerErrorPB resp_error = response_.error();
-    switch (response_.error().code()) {
+    TabletServerErrorPB resp_error = response.error();
+    switch (response.error().code()) {
       // We treat WRONG_SERVER_UUID as failed.
       case TabletServerErrorPB::WRONG_SERVER_UUID: [[fallthrough]];
       case TabletServerErrorPB::TABLET_FAILED:
@@ -384,7 +477,7 @@ void Peer::ProcessResponse() {
         ps = PeerStatus::REMOTE_ERROR;
     }
     queue_->UpdatePeerStatus(peer_pb_.permanent_uuid(), ps, response_status);
-    ProcessResponseErrorUnlocked(response_status);
+    ProcessResponseErrorUnlocked(*rpc, response_status);
     return;
   }
 
@@ -396,31 +489,42 @@ void Peer::ProcessResponse() {
   // Capture a weak_ptr reference into the submitted functor so that we can
   // safely handle the functor outliving its peer.
   weak_ptr<Peer> w_this = shared_from_this();
-  Status s = raft_pool_token_->Submit([w_this]() {
+  Status s = raft_pool_token_->Submit([w_this, rpc]() {
     if (auto p = w_this.lock()) {
-      p->DoProcessResponse();
+      p->DoProcessResponse(rpc);
     }
   });
   if (PREDICT_FALSE(!s.ok())) {
     LOG_WITH_PREFIX_UNLOCKED(WARNING) << Substitute(
         "unable to process peer response: $0: $1",
-         s.ToString(), SecureShortDebugString(response_));
-    request_pending_ = false;
+         s.ToString(), SecureShortDebugString(response));
+    pipeline_stalled_ = true;
+    FinishUpdateRpcUnlocked();
   }
 }
 
-void Peer::DoProcessResponse() {
+void Peer::DoProcessResponse(const shared_ptr<UpdateRpc>& rpc) {
+  const ConsensusResponsePB& response = rpc->response;
   VLOG_WITH_PREFIX_UNLOCKED(2) << "Response from peer " << peer_pb().permanent_uuid() << ": "
-      << SecureShortDebugString(response_);
+      << SecureShortDebugString(response);
 
   const auto send_more_immediately =
-      queue_->ResponseFromPeer(peer_pb_.permanent_uuid(), response_);
+      queue_->ResponseFromPeer(peer_pb_.permanent_uuid(), response, rpc->send_time);
 
   {
     std::lock_guard<simple_spinlock> lock(peer_lock_);
-    CHECK(request_pending_);
+    CHECK_GT(update_rpcs_in_flight_, 0);
     failed_attempts_ = 0;
-    request_pending_ = false;
+    // The requests pipelined behind this one can't be appended by the peer
+    // unless it appended all of this one's ops.
+    const ConsensusRequestPB& request = rpc->request;
+    if (response.status().has_error() ||
+        (request.ops_size() > 0 &&
+         response.status().last_received().index() <
+             request.ops(request.ops_size() - 1).id().index())) {
+      pipeline_stalled_ = true;
+    }
+    FinishUpdateRpcUnlocked();
   }
 
   if (send_more_immediately) {
@@ -428,6 +532,13 @@ void Peer::DoProcessResponse() {
   }
 }
 
+void Peer::FinishUpdateRpcUnlocked() {
+  DCHECK(peer_lock_.is_locked());
+  DCHECK_GT(update_rpcs_in_flight_, 0);
+  update_rpcs_in_flight_--;
+  request_pending_ = false;
+}
+
 Status Peer::PrepareTabletCopyRequest() {
   if (PREDICT_FALSE(!FLAGS_enable_tablet_copy)) {
     failed_attempts_++;
@@ -447,7 +558,7 @@ void Peer::ProcessTabletCopyResponse() {
   request_pending_ = false;
 
   // If the response is OK, or ALREADY_INPROGRESS, then consider the RPC successful.
-  const auto controller_status = controller_.status();
+  const auto controller_status = tc_controller_.status();
   bool success =
     controller_status.ok() &&
     (!tc_response_.has_error() ||
@@ -468,14 +579,15 @@ void Peer::ProcessTabletCopyResponse() {
   }
 }
 
-void Peer::ProcessResponseErrorUnlocked(const Status& status) {
+void Peer::ProcessResponseErrorUnlocked(const UpdateRpc& rpc, const Status& status) {
   DCHECK(peer_lock_.is_locked());
   failed_attempts_++;
+  pipeline_stalled_ = true;
   string resp_err_info;
-  if (response_.has_error()) {
+  if (rpc.response.has_error()) {
     resp_err_info = Substitute(" Error code: $0 ($1).",
-                               TabletServerErrorPB::Code_Name(response_.error().code()),
-                               response_.error().code());
+                               TabletServerErrorPB::Code_Name(rpc.response.error().code()),
+                               rpc.response.error().code());
   }
   // We log the warning at the first failure, then every
   // 'kNumRetriesBetweenLoggingFailedRequest' retries.
@@ -493,7 +605,7 @@ void Peer::ProcessResponseErrorUnlocked(const Status& status) {
                  failed_attempts_,
                  kNumRetriesBetweenLoggingFailedRequest);
   }
-  request_pending_ = false;
+  FinishUpdateRpcUnlocked();
 }
 
 bool Peer::CreateProxyIfNeeded() {
@@ -536,15 +648,14 @@ Peer::~Peer() {
   if (heartbeater_) {
     heartbeater_->Stop();
   }
-
-  // We don't own the ops (the queue does).
-  request_.mutable_ops()->ExtractSubrange(0, request_.ops_size(), nullptr);
 }
 
 RpcPeerProxy::RpcPeerProxy(HostPort hostport,
-                           unique_ptr<ConsensusServiceProxy> consensus_proxy)
+                           unique_ptr<ConsensusServiceProxy> consensus_proxy,
+                           HeartbeatCoalescer* heartbeat_coalescer)
     : hostport_(std::move(hostport)),
-      consensus_proxy_(std::move(DCHECK_NOTNULL(consensus_proxy))) {
+      consensus_proxy_(std::move(DCHECK_NOTNULL(consensus_proxy))),
+      heartbeat_coalescer_(heartbeat_coalescer) {
 }
 
 void RpcPeerProxy::UpdateAsync(const ConsensusRequestPB& request,
@@ -555,6 +666,17 @@ void RpcPeerProxy::UpdateAsync(const ConsensusRequestPB& request,
   consensus_proxy_->UpdateConsensusAsync(request, response, controller, callback);
 }
 
+void RpcPeerProxy::HeartbeatAsync(const ConsensusRequestPB& request,
+                                  ConsensusResponsePB* response,
+                                  rpc::RpcController* controller,
+                                  const rpc::ResponseCallback& callback) {
+  if (heartbeat_coalescer_ && HeartbeatCoalescer::IsEnabled()) {
+    heartbeat_coalescer_->HeartbeatAsync(hostport_, request, response, controller, callback);
+    return;
+  }
+  UpdateAsync(request, response, controller, callback);
+}
+
 void RpcPeerProxy::StartElectionAsync(const RunLeaderElectionRequestPB& request,
                                       RunLeaderElectionResponsePB* response,
                                       rpc::RpcController* controller,
@@ -597,9 +719,11 @@ Status CreateConsensusServiceProxyForHost(
 } // anonymous namespace
 
 RpcPeerProxyFactory::RpcPeerProxyFactory(shared_ptr<Messenger> messenger,
-                                         DnsResolver* dns_resolver)
+                                         DnsResolver* dns_resolver,
+                                         HeartbeatCoalescer* heartbeat_coalescer)
     : messenger_(std::move(messenger)),
-      dns_resolver_(dns_resolver) {
+      dns_resolver_(dns_resolver),
+      heartbeat_coalescer_(heartbeat_coalescer) {
 }
 
 Status RpcPeerProxyFactory::NewProxy(const RaftPeerPB& peer_pb,
@@ -608,7 +732,8 @@ Status RpcPeerProxyFactory::NewProxy(const RaftPeerPB& peer_pb,
   unique_ptr<ConsensusServiceProxy> new_proxy;
   RETURN_NOT_OK(CreateConsensusServiceProxyForHost(
       hostport, messenger_, dns_resolver_, &new_proxy));
-  proxy->reset(new RpcPeerProxy(std::move(hostport), std::move(new_proxy)));
+  proxy->reset(new RpcPeerProxy(std::move(hostport), std::move(new_proxy),
+                                heartbeat_coalescer_));
   return Status::OK();
 }
 
@@ -19,6 +19,7 @@
 #include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -33,6 +34,7 @@
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/make_shared.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/status.h"
 
@@ -46,19 +48,27 @@ class PeriodicTimer;
 }
 
 namespace consensus {
+class HeartbeatCoalescer;
 class PeerMessageQueue;
 class PeerProxy;
 class PeerProxyFactory;
 
 // A remote peer in consensus.
 //
-// Leaders use peers to update the remote replicas. Each peer
+// Leaders use peers to update the remote replicas. By default, each peer
 // may have at most one outstanding request at a time. If a
 // request is signaled when there is already one outstanding,
 // the request will be generated once the outstanding one finishes.
 //
+// With --consensus_max_inflight_requests_per_peer greater than one, further
+// requests carrying the next ops are pipelined behind the outstanding ones
+// while the remote replica is in sync with the leader, so that the throughput
+// to a distant replica isn't bounded by the round-trip time. Once an exchange
+// fails, no more requests are pipelined until all the outstanding ones have
+// finished, and replication resumes from the last op the replica acknowledged.
+//
 // Peers are owned by the consensus implementation and do not keep
-// state aside from the most recent request and response.
+// state aside from the requests in flight and their responses.
 //
 // Peers are also responsible for sending periodic heartbeats
 // to assert liveness of the leader. The peer constructs a heartbeater
@@ -131,17 +141,51 @@ class Peer :
        PeerProxyFactory* peer_proxy_factory);
 
  private:
+  // An UpdateConsensus RPC to the peer, along with the state which must
+  // outlive it.
+  struct UpdateRpc {
+    ~UpdateRpc();
+
+    ConsensusRequestPB request;
+    ConsensusResponsePB response;
+    rpc::RpcController controller;
+
+    // The time at which the request was sent.
+    MonoTime send_time;
+
+    // Whether the request is a heartbeat, which may be coalesced with the
+    // heartbeats of the other tablets (see HeartbeatCoalescer).
+    bool is_heartbeat = false;
+
+    // Reference-counted pointers to the ReplicateMsgs in 'request'. We may
+    // have loaded these messages from the LogCache, in which case we are
+    // potentially sharing the same object as other peers. Since the PB
+    // request itself can't hold reference counts, this holds them.
+    std::vector<ReplicateRefPtr> replicate_msg_refs;
+  };
+
   void SendNextRequest(bool even_if_queue_empty);
 
-  // Signals that a response was received from the peer.
+  // Called by the heartbeater: sends a status-only request, unless the
+  // tablet is dormant and the next heartbeat isn't due yet.
+  void Heartbeat();
+
+  // Sends 'rpc' to the peer, releasing 'l' beforehand.
+  void SendUpdateRpc(std::shared_ptr<UpdateRpc> rpc,
+                     std::unique_lock<simple_spinlock>* l);
+
+  // Signals that a response to 'rpc' was received from the peer.
   //
   // This method is called from the reactor thread and calls
   // DoProcessResponse() on raft_pool_token_ to do any work that requires IO or
   // lock-taking.
-  void ProcessResponse();
+  void ProcessResponse(const std::shared_ptr<UpdateRpc>& rpc);
 
   // Run on 'raft_pool_token'. Does response handling that requires IO or may block.
-  void DoProcessResponse();
+  void DoProcessResponse(const std::shared_ptr<UpdateRpc>& rpc);
+
+  // Accounts for the end of an UpdateConsensus RPC. 'peer_lock_' must be held.
+  void FinishUpdateRpcUnlocked();
 
   // Fetch the desired tablet copy request from the queue and set up
   // tc_request_ appropriately.
@@ -153,8 +197,8 @@ class Peer :
   // Handle RPC callback from initiating tablet copy.
   void ProcessTabletCopyResponse();
 
-  // Signals there was an error sending the request to the peer.
-  void ProcessResponseErrorUnlocked(const Status& status);
+  // Signals there was an error sending 'rpc' to the peer.
+  void ProcessResponseErrorUnlocked(const UpdateRpc& rpc, const Status& status);
 
   // Sets 'proxy_' if needed. Returns 'false' if 'proxy_' is not set and a new
   // proxy could not be created. Otherwise returns 'true'.
@@ -183,21 +227,16 @@ class Peer :
   PeerMessageQueue* queue_;
   uint64_t failed_attempts_;
 
-  // The latest consensus update request and response.
-  ConsensusRequestPB request_;
-  ConsensusResponsePB response_;
+  // The maximum number of UpdateConsensus RPCs in flight to the peer.
+  const int max_update_rpcs_in_flight_;
 
-  // The latest tablet copy request and response.
+  // The committed index of the latest update request assembled for the peer.
+  int64_t last_request_committed_index_;
+
+  // The latest tablet copy request and response, and the controller of its RPC.
   StartTabletCopyRequestPB tc_request_;
   StartTabletCopyResponsePB tc_response_;
-
-  // Reference-counted pointers to any ReplicateMsgs which are in-flight to the peer. We
-  // may have loaded these messages from the LogCache, in which case we are potentially
-  // sharing the same object as other peers. Since the PB request_ itself can't hold
-  // reference counts, this holds them.
-  std::vector<ReplicateRefPtr> replicate_msg_refs_;
-
-  rpc::RpcController controller_;
+  rpc::RpcController tc_controller_;
 
   std::shared_ptr<rpc::Messenger> messenger_;
 
@@ -212,15 +251,29 @@ class Peer :
   // Lock that protects Peer state changes, initialization, etc. It's necessary
   // to hold 'peer_lock_' if setting 'request_pending_', 'closed_', and
   // 'has_sent_first_request_' fields below. To read 'has_sent_first_request_',
-  // it's necessary to hold 'peer_lock_'. To read the 'closed_' and
-  // 'request_pending_' fields, there is no need to hold 'peer_lock_' unless
-  // it's necessary to block the threads which might be setting these fields
-  // concurrently.
+  // 'update_rpcs_in_flight_' and 'pipeline_stalled_', it's necessary to hold
+  // 'peer_lock_'. To read the 'closed_' and 'request_pending_' fields, there
+  // is no need to hold 'peer_lock_' unless it's necessary to block the threads
+  // which might be setting these fields concurrently.
   simple_spinlock peer_lock_;
 
+  // Whether no further request may be sent until a response is received:
+  // either a tablet copy request is in flight, or the maximum number of
+  // UpdateConsensus RPCs are.
   std::atomic<bool> request_pending_;
   std::atomic<bool> closed_;
   bool has_sent_first_request_;
+
+  // The number of UpdateConsensus RPCs in flight to the peer.
+  int update_rpcs_in_flight_;
+
+  // Whether an exchange with the peer failed since the last time no
+  // UpdateConsensus RPC was in flight: no request may be pipelined until then.
+  bool pipeline_stalled_;
+
+  // If the last request was sent while the tablet was dormant, the earliest
+  // time of the next heartbeat. Protected by 'peer_lock_'.
+  MonoTime next_dormant_heartbeat_time_;
 };
 
 // A proxy to another peer. Usually a thin wrapper around an rpc proxy but can
@@ -235,6 +288,16 @@ class PeerProxy {
                            rpc::RpcController* controller,
                            const rpc::ResponseCallback& callback) = 0;
 
+  // Sends a heartbeat, i.e. a request carrying no ops, asynchronously, to a
+  // remote peer. The heartbeats may be delayed to be batched with the ones
+  // sent to the same server.
+  virtual void HeartbeatAsync(const ConsensusRequestPB& request,
+                              ConsensusResponsePB* response,
+                              rpc::RpcController* controller,
+                              const rpc::ResponseCallback& callback) {
+    UpdateAsync(request, response, controller, callback);
+  }
+
   // Asks a peer to vote for a candidate.
   virtual void RequestConsensusVoteAsync(const VoteRequestPB& request,
                                          VoteResponsePB* response,
@@ -275,13 +338,19 @@ class PeerProxyFactory {
 class RpcPeerProxy : public PeerProxy {
  public:
   RpcPeerProxy(HostPort hostport,
-               std::unique_ptr<ConsensusServiceProxy> consensus_proxy);
+               std::unique_ptr<ConsensusServiceProxy> consensus_proxy,
+               HeartbeatCoalescer* heartbeat_coalescer = nullptr);
 
   void UpdateAsync(const ConsensusRequestPB& request,
                    ConsensusResponsePB* response,
                    rpc::RpcController* controller,
                    const rpc::ResponseCallback& callback) override;
 
+  void HeartbeatAsync(const ConsensusRequestPB& request,
+                      ConsensusResponsePB* response,
+                      rpc::RpcController* controller,
+                      const rpc::ResponseCallback& callback) override;
+
   void RequestConsensusVoteAsync(const VoteRequestPB& request,
                                  VoteResponsePB* response,
                                  rpc::RpcController* controller,
@@ -302,13 +371,17 @@ class RpcPeerProxy : public PeerProxy {
  private:
   const HostPort hostport_;
   std::unique_ptr<ConsensusServiceProxy> consensus_proxy_;
+  HeartbeatCoalescer* heartbeat_coalescer_;
 };
 
 // PeerProxyFactory implementation that generates RPCPeerProxies
 class RpcPeerProxyFactory : public PeerProxyFactory {
  public:
+  // If 'heartbeat_coalescer' is set, the heartbeats of the proxies are sent
+  // through it.
   RpcPeerProxyFactory(std::shared_ptr<rpc::Messenger> messenger,
-                      DnsResolver* dns_resolver);
+                      DnsResolver* dns_resolver,
+                      HeartbeatCoalescer* heartbeat_coalescer = nullptr);
   ~RpcPeerProxyFactory() = default;
 
   Status NewProxy(const RaftPeerPB& peer_pb,
@@ -321,6 +394,7 @@ class RpcPeerProxyFactory : public PeerProxyFactory {
  private:
   std::shared_ptr<rpc::Messenger> messenger_;
   DnsResolver* dns_resolver_;
+  HeartbeatCoalescer* heartbeat_coalescer_;
 };
 
 // Query the consensus service at last known host/port that is
@@ -20,6 +20,7 @@
 #include <atomic>
 #include <cstdint>
 #include <deque>
+#include <initializer_list>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -64,8 +65,11 @@
 #include "kudu/util/test_util.h"
 #include "kudu/util/threadpool.h"
 
+DECLARE_int32(consensus_catchup_max_batch_size_bytes);
 DECLARE_int32(consensus_max_batch_size_bytes);
 DECLARE_int32(follower_unavailable_considered_failed_sec);
+DECLARE_int32(raft_dormant_heartbeat_interval_ms);
+DECLARE_int32(raft_dormant_tablet_idle_secs);
 DECLARE_double(consensus_fail_log_read_ops);
 
 using kudu::consensus::HealthReportPB;
@@ -793,6 +797,51 @@ TEST_F(ConsensusQueueTest, TestQueueLoadsOperationsForPeer) {
   request.mutable_ops()->ExtractSubrange(0, request.ops().size(), nullptr);
 }
 
+// Tests that the peers lagging behind the log cache are sent the ops read back
+// from the log in batches of up to --consensus_catchup_max_batch_size_bytes.
+TEST_F(ConsensusQueueTest, TestCatchupBatchesFromLog) {
+  OpId opid = MakeOpId(1, 1);
+  const int kOpsToAppend = 100;
+  for (int i = 1; i <= kOpsToAppend; i++) {
+    ASSERT_OK(log::AppendNoOpToLogSync(clock_.get(), log_.get(), &opid));
+  }
+  ASSERT_OK(log_->WaitUntilAllFlushed());
+  const OpId last_logged_opid = MakeOpId(opid.term(), opid.index() - 1);
+
+  google::FlagSaver saver;
+  FLAGS_consensus_max_batch_size_bytes = 512;
+  for (const int catchup_batch_size : { 0, 1024 * 1024 }) {
+    SCOPED_TRACE(catchup_batch_size);
+    FLAGS_consensus_catchup_max_batch_size_bytes = catchup_batch_size;
+    CloseAndReopenQueue(last_logged_opid, last_logged_opid);
+    queue_->SetLeaderMode(last_logged_opid.index(),
+                          last_logged_opid.term(),
+                          BuildRaftConfigPBForTests(3));
+
+    ConsensusRequestPB request;
+    ConsensusResponsePB response;
+    response.set_responder_uuid(kPeerUuid);
+    bool send_more_immediately = false;
+    NO_FATALS(UpdatePeerWatermarkToOp(&request,
+                                      &response,
+                                      MakeOpId(1, 50),
+                                      MinimumOpId(),
+                                      &send_more_immediately));
+    ASSERT_TRUE(send_more_immediately);
+
+    vector<ReplicateRefPtr> refs;
+    bool needs_tablet_copy;
+    ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_tablet_copy));
+    ASSERT_FALSE(needs_tablet_copy);
+    if (catchup_batch_size == 0) {
+      ASSERT_LT(request.ops_size(), 50);
+    } else {
+      ASSERT_EQ(50, request.ops_size());
+    }
+    request.mutable_ops()->ExtractSubrange(0, request.ops().size(), nullptr);
+  }
+}
+
 // This tests that the queue is able to handle operation overwriting, i.e. when a
 // newly tracked peer reports the last received operations as some operation that
 // doesn't exist in the leader's log. In particular it tests the case where a
@@ -1202,5 +1251,93 @@ TEST_F(ConsensusQueueTest, ClearLogCacheWhileClosing) {
   ASSERT_EQ(0, queue_->log_cache_.BytesUsed());
 }
 
+// Tests that the leader lease is based on the latest requests acknowledged by
+// a majority of the voters.
+TEST_F(ConsensusQueueTest, TestMajorityAckedRequestTime) {
+  const string kOtherPeerUuid = "peer-2";
+  queue_->SetLeaderMode(kMinimumOpIdIndex, kMinimumTerm, BuildRaftConfigPBForTests(3));
+  queue_->TrackPeer(MakePeer(kPeerUuid, RaftPeerPB::VOTER));
+  queue_->TrackPeer(MakePeer(kOtherPeerUuid, RaftPeerPB::VOTER));
+  ASSERT_EQ(MonoTime::Min(), queue_->GetMajorityAckedRequestTime());
+
+  const auto ack = [&](const string& uuid, MonoTime send_time) {
+    ConsensusRequestPB request;
+    vector<ReplicateRefPtr> refs;
+    bool needs_tablet_copy;
+    ASSERT_OK(queue_->RequestForPeer(uuid, &request, &refs, &needs_tablet_copy));
+    ConsensusResponsePB response;
+    response.set_responder_uuid(uuid);
+    SetLastReceivedAndLastCommitted(&response, MinimumOpId());
+    queue_->ResponseFromPeer(uuid, response, send_time);
+  };
+
+  // Along with the leader, a single follower makes a majority.
+  const MonoTime t1 = MonoTime::Now();
+  NO_FATALS(ack(kPeerUuid, t1));
+  ASSERT_EQ(t1, queue_->GetMajorityAckedRequestTime());
+
+  // The latest acknowledgements count.
+  const MonoTime t2 = t1 + MonoDelta::FromMilliseconds(10);
+  NO_FATALS(ack(kOtherPeerUuid, t2));
+  ASSERT_EQ(t2, queue_->GetMajorityAckedRequestTime());
+
+  // A late response to an older request doesn't move the lease backwards.
+  NO_FATALS(ack(kOtherPeerUuid, t1));
+  ASSERT_EQ(t2, queue_->GetMajorityAckedRequestTime());
+
+  // The acknowledgements don't carry over to the next term.
+  queue_->SetLeaderMode(kMinimumOpIdIndex, kMinimumTerm + 1, BuildRaftConfigPBForTests(3));
+  ASSERT_EQ(MonoTime::Min(), queue_->GetMajorityAckedRequestTime());
+
+  // There's no lease when not leading.
+  queue_->SetNonLeaderMode(BuildRaftConfigPBForTests(3));
+  ASSERT_EQ(MonoTime::Min(), queue_->GetMajorityAckedRequestTime());
+}
+
+// Test that the heartbeats of a tablet without writes for a while, whose
+// ops are replicated everywhere, mark it as dormant.
+TEST_F(ConsensusQueueTest, TestDormantHeartbeats) {
+  FLAGS_raft_dormant_tablet_idle_secs = 1;
+  queue_->SetLeaderMode(kMinimumOpIdIndex, 1, BuildRaftConfigPBForTests(2));
+  queue_->TrackPeer(MakePeer(kPeerUuid, RaftPeerPB::VOTER));
+
+  const auto request_for_peer = [&](ConsensusRequestPB* request) {
+    vector<ReplicateRefPtr> refs;
+    bool needs_tablet_copy;
+    ASSERT_OK(queue_->RequestForPeer(kPeerUuid, request, &refs, &needs_tablet_copy));
+    ASSERT_FALSE(needs_tablet_copy);
+  };
+  const auto ack = [&](const OpId& last_received) {
+    ConsensusResponsePB response;
+    response.set_responder_uuid(kPeerUuid);
+    SetLastReceivedAndLastCommitted(&response, last_received);
+    queue_->ResponseFromPeer(kPeerUuid, response);
+  };
+
+  // The new leader isn't dormant right away.
+  ConsensusRequestPB request;
+  NO_FATALS(request_for_peer(&request));
+  ASSERT_FALSE(request.has_dormant_heartbeat_interval_ms());
+  NO_FATALS(ack(MinimumOpId()));
+
+  SleepFor(MonoDelta::FromSeconds(FLAGS_raft_dormant_tablet_idle_secs));
+  NO_FATALS(request_for_peer(&request));
+  ASSERT_EQ(0, request.ops_size());
+  ASSERT_EQ(FLAGS_raft_dormant_heartbeat_interval_ms,
+            request.dormant_heartbeat_interval_ms());
+
+  // A write wakes the tablet up.
+  ASSERT_OK(AppendReplicateMsg(1, 1, 0));
+  WaitForLocalPeerToAckIndex(1);
+  NO_FATALS(request_for_peer(&request));
+  ASSERT_EQ(1, request.ops_size());
+  ASSERT_FALSE(request.has_dormant_heartbeat_interval_ms());
+  request.mutable_ops()->ExtractSubrange(0, request.ops_size(), nullptr);
+  NO_FATALS(ack(MakeOpId(1, 1)));
+  NO_FATALS(request_for_peer(&request));
+  ASSERT_EQ(0, request.ops_size());
+  ASSERT_FALSE(request.has_dormant_heartbeat_interval_ms());
+}
+
 }  // namespace consensus
 }  // namespace kudu
@@ -41,8 +41,10 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/walltime.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
@@ -51,12 +53,39 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/threadpool.h"
+#include "kudu/util/trace.h"
 #include "kudu/util/url-coding.h"
 
 DEFINE_int32(consensus_max_batch_size_bytes, 1024 * 1024,
              "The maximum per-tablet RPC batch size when updating peers.");
 TAG_FLAG(consensus_max_batch_size_bytes, advanced);
 
+DEFINE_int32(consensus_catchup_max_batch_size_bytes, 8 * 1024 * 1024,
+             "The maximum per-tablet RPC batch size when updating the peers lagging "
+             "behind the log cache, whose operations are read back from the log. Such "
+             "peers are caught up with fewer and larger reads of the log, and append "
+             "each batch to their own log at once. If 0, or lower than "
+             "--consensus_max_batch_size_bytes, the latter applies to them too.");
+TAG_FLAG(consensus_catchup_max_batch_size_bytes, advanced);
+
+DEFINE_int32(raft_dormant_tablet_idle_secs, 0,
+             "Number of seconds without writes after which a tablet whose "
+             "operations are all replicated to all its replicas becomes "
+             "dormant: its leader then heartbeats its followers every "
+             "--raft_dormant_heartbeat_interval_ms rather than every "
+             "--raft_heartbeat_interval_ms, until the next write. This cuts the "
+             "heartbeats of the rarely written tablets, at the cost of a slower "
+             "detection of the failures of their leaders, and of snapshot scans "
+             "of their followers possibly waiting for the next heartbeat to "
+             "advance their safe time. If 0, the tablets are never dormant.");
+TAG_FLAG(raft_dormant_tablet_idle_secs, experimental);
+TAG_FLAG(raft_dormant_tablet_idle_secs, runtime);
+
+DEFINE_int32(raft_dormant_heartbeat_interval_ms, 10000,
+             "The interval at which the leaders of the dormant tablets heartbeat "
+             "their followers. See --raft_dormant_tablet_idle_secs.");
+TAG_FLAG(raft_dormant_heartbeat_interval_ms, experimental);
+
 DEFINE_int32(follower_unavailable_considered_failed_sec, 300,
              "Seconds that a leader is unable to successfully heartbeat to a "
              "follower after which the follower is considered to be failed and "
@@ -78,6 +107,7 @@ TAG_FLAG(consensus_fail_log_read_ops, hidden);
 DECLARE_bool(raft_prepare_replacement_before_eviction);
 DECLARE_bool(safe_time_advancement_without_writes);
 DECLARE_int32(consensus_rpc_timeout_ms);
+DECLARE_int32(raft_heartbeat_interval_ms);
 DECLARE_int64(rpc_max_message_size);
 
 using kudu::log::Log;
@@ -103,10 +133,32 @@ static bool ValidateMaxMessageSizeFlags() {
         "down to $1", raft_max_size + kSizeDelta, rpc_max_size - kSizeDelta);
     return false;
   }
+  const int64_t catchup_max_size = FLAGS_consensus_catchup_max_batch_size_bytes;
+  if (catchup_max_size + kSizeDelta > rpc_max_size) {
+    LOG(ERROR) << strings::Substitute(
+        "--consensus_catchup_max_batch_size_bytes is set too high compared with "
+        "--rpc_max_message_size; either increase --rpc_max_message_size "
+        "at least up to $0 or decrease --consensus_catchup_max_batch_size_bytes "
+        "down to $1", catchup_max_size + kSizeDelta, rpc_max_size - kSizeDelta);
+    return false;
+  }
   return true;
 }
 GROUP_FLAG_VALIDATOR(max_message_size_flags, ValidateMaxMessageSizeFlags);
 
+static bool ValidateDormantHeartbeatInterval() {
+  if (FLAGS_raft_dormant_tablet_idle_secs > 0 &&
+      FLAGS_raft_dormant_heartbeat_interval_ms < 2 * FLAGS_raft_heartbeat_interval_ms) {
+    LOG(ERROR) << strings::Substitute(
+        "--raft_dormant_heartbeat_interval_ms ($0) must be at least twice "
+        "--raft_heartbeat_interval_ms ($1)",
+        FLAGS_raft_dormant_heartbeat_interval_ms, FLAGS_raft_heartbeat_interval_ms);
+    return false;
+  }
+  return true;
+}
+GROUP_FLAG_VALIDATOR(dormant_heartbeat_interval_flags, ValidateDormantHeartbeatInterval);
+
 namespace kudu {
 namespace consensus {
 
@@ -144,10 +196,12 @@ const char* PeerStatusToString(PeerStatus p) {
 PeerMessageQueue::TrackedPeer::TrackedPeer(RaftPeerPB peer_pb)
     : peer_pb(std::move(peer_pb)),
       next_index(kInvalidOpIdIndex),
+      next_index_to_send(kInvalidOpIdIndex),
       last_received(MinimumOpId()),
       last_known_committed_index(MinimumOpId().index()),
       last_exchange_status(PeerStatus::NEW),
       last_communication_time(MonoTime::Now()),
+      last_acked_request_time(MonoTime::Min()),
       wal_catchup_possible(true),
       remote_server_quiescing(false),
       last_overall_health_status(HealthReportPB::UNKNOWN),
@@ -230,6 +284,7 @@ void PeerMessageQueue::SetLeaderMode(int64_t committed_index,
   queue_state_.active_config.reset(new RaftConfigPB(active_config));
   queue_state_.majority_size_ = MajoritySize(CountVoters(*queue_state_.active_config));
   queue_state_.mode = LEADER;
+  queue_state_.last_append_time = MonoTime::Now();
 
   TrackLocalPeerUnlocked();
   CheckPeersInActiveConfigIfLeaderUnlocked();
@@ -239,9 +294,11 @@ void PeerMessageQueue::SetLeaderMode(int64_t committed_index,
 
   // Reset last communication time with all peers to reset the clock on the
   // failure timeout.
+  // Also forget about the requests acknowledged in previous terms.
   const auto now = MonoTime::Now();
   for (const PeersMap::value_type& entry : peers_map_) {
     entry.second->last_communication_time = now;
+    entry.second->last_acked_request_time = MonoTime::Min();
   }
   time_manager_->SetLeaderMode();
 }
@@ -284,6 +341,7 @@ void PeerMessageQueue::TrackPeerUnlocked(const RaftPeerPB& peer_pb) {
   // does not have a log that matches ours, the normal queue negotiation
   // process will eventually find the right point to resume from.
   tracked_peer->next_index = queue_state_.last_appended.index() + 1;
+  tracked_peer->next_index_to_send = tracked_peer->next_index;
   InsertOrDie(&peers_map_, tracked_peer->uuid(), tracked_peer);
 
   CheckPeersInActiveConfigIfLeaderUnlocked();
@@ -394,8 +452,16 @@ void PeerMessageQueue::LocalPeerAppendFinished(const OpId& id,
 }
 
 Status PeerMessageQueue::AppendOperation(const ReplicateRefPtr& msg) {
-  return AppendOperations({ msg }, [](const Status& s) {
+  // The callback runs once the operation is durable in the local WAL, on
+  // another thread: it records the time spent appending it onto the trace of
+  // the operation, if any.
+  scoped_refptr<Trace> trace(Trace::CurrentTrace());
+  const MicrosecondsInt64 start_micros = GetCurrentTimeMicros();
+  return AppendOperations({ msg }, [trace, start_micros](const Status& s) {
     CrashIfNotOkStatusCB("Enqueued replicate operation failed to write to WAL", s);
+    if (trace) {
+      trace->AddSpan("wal_append", start_micros, GetCurrentTimeMicros());
+    }
   });
 }
 
@@ -432,6 +498,7 @@ Status PeerMessageQueue::AppendOperations(vector<ReplicateRefPtr> msgs,
   // Until we have leader leases, replicas only call this when the message is committed.
   if (queue_state_.mode == LEADER) {
     time_manager_->AdvanceSafeTimeWithMessage(*msgs.back()->get());
+    queue_state_.last_append_time = MonoTime::Now();
   }
 
   // Unlock ourselves during Append to prevent a deadlock: it's possible that
@@ -647,11 +714,29 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
                                         ConsensusRequestPB* request,
                                         vector<ReplicateRefPtr>* msg_refs,
                                         bool* needs_tablet_copy) {
+  return AssembleRequestForPeer(uuid, /*pipelined=*/false, request, msg_refs,
+                                needs_tablet_copy);
+}
+
+Status PeerMessageQueue::PipelinedRequestForPeer(const string& uuid,
+                                                 ConsensusRequestPB* request,
+                                                 vector<ReplicateRefPtr>* msg_refs) {
+  bool needs_tablet_copy;
+  return AssembleRequestForPeer(uuid, /*pipelined=*/true, request, msg_refs,
+                                &needs_tablet_copy);
+}
+
+Status PeerMessageQueue::AssembleRequestForPeer(const string& uuid,
+                                                bool pipelined,
+                                                ConsensusRequestPB* request,
+                                                vector<ReplicateRefPtr>* msg_refs,
+                                                bool* needs_tablet_copy) {
   // Maintain a thread-safe copy of necessary members.
   OpId preceding_id;
   int64_t current_term;
   TrackedPeer peer_copy;
   MonoDelta unreachable_time;
+  MonoTime last_append_time;
   {
     std::lock_guard<simple_spinlock> lock(queue_lock_);
     DCHECK_EQ(queue_state_.state, kQueueOpen);
@@ -663,9 +748,13 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
                                          "queue is not in leader mode", uuid));
     }
     peer_copy = *peer;
+    if (pipelined && peer_copy.last_exchange_status != PeerStatus::OK) {
+      return Status::Incomplete(Substitute("peer $0 is not in sync with this leader", uuid));
+    }
 
     // Clear the requests without deleting the entries, as they may be in use by other peers.
     request->mutable_ops()->ExtractSubrange(0, request->ops_size(), nullptr);
+    request->clear_dormant_heartbeat_interval_ms();
 
     // This is initialized to the queue's last appended op but gets set to the id of the
     // log entry preceding the first one in 'messages' if messages are found for the peer.
@@ -677,11 +766,13 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
     request->set_last_idx_appended_to_leader(queue_state_.last_appended.index());
     request->set_caller_term(current_term);
     unreachable_time = MonoTime::Now() - peer_copy.last_communication_time;
+    last_append_time = queue_state_.last_append_time;
   }
 
   // Always trigger a health status update check at the end of this function.
   bool wal_catchup_progress = false;
   bool wal_catchup_failure = false;
+  optional<int64_t> next_index_to_send;
   SCOPED_CLEANUP({
       std::lock_guard<simple_spinlock> lock(queue_lock_);
       TrackedPeer* peer = FindPtrOrNull(peers_map_, uuid);
@@ -692,6 +783,11 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
       }
       if (wal_catchup_progress) peer->wal_catchup_possible = true;
       if (wal_catchup_failure) peer->wal_catchup_possible = false;
+      // A response processed in the meantime may have reset the pipeline.
+      if (next_index_to_send &&
+          (!pipelined || peer->next_index_to_send == peer_copy.next_index_to_send)) {
+        peer->next_index_to_send = *next_index_to_send;
+      }
       UpdatePeerHealthUnlocked(peer);
     });
 
@@ -718,10 +814,22 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
 
     // The batch of messages to send to the peer.
     vector<ReplicateRefPtr> messages;
-    int64_t max_batch_size = FLAGS_consensus_max_batch_size_bytes - request->ByteSizeLong();
 
-    // We try to get the follower's next_index from our log.
-    Status s = log_cache_.ReadOps(peer_copy.next_index - 1,
+    // We try to get the follower's next_index from our log, or the ops following
+    // those in flight to the follower when pipelining.
+    const int64_t first_index = pipelined ?
+        std::max(peer_copy.next_index, peer_copy.next_index_to_send) : peer_copy.next_index;
+
+    // The peers lagging behind the log cache are caught up from the log in
+    // larger batches.
+    int64_t max_batch_size = FLAGS_consensus_max_batch_size_bytes;
+    if (first_index <= request->last_idx_appended_to_leader() &&
+        !log_cache_.IsOpCached(first_index)) {
+      max_batch_size = std::max<int64_t>(max_batch_size,
+                                         FLAGS_consensus_catchup_max_batch_size_bytes);
+    }
+    max_batch_size -= request->ByteSizeLong();
+    Status s = log_cache_.ReadOps(first_index - 1,
                                   max_batch_size,
                                   &messages,
                                   &preceding_id);
@@ -771,6 +879,8 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
     for (const ReplicateRefPtr& msg : messages) {
       request->mutable_ops()->AddAllocated(msg->get());
     }
+    next_index_to_send = messages.empty() ?
+        first_index : messages.back()->get()->id().index() + 1;
     msg_refs->swap(messages);
   }
 
@@ -797,6 +907,16 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
       KLOG_EVERY_N_SECS(WARNING, 300) << "Safe time advancement without writes is disabled. "
             "Snapshot reads on non-leader replicas may stall if there are no writes in progress.";
     }
+    // The tablet is dormant once all its ops are replicated everywhere and it
+    // had no writes for a while.
+    const int32_t dormant_idle_secs = FLAGS_raft_dormant_tablet_idle_secs;
+    if (dormant_idle_secs > 0 &&
+        peer_copy.last_exchange_status == PeerStatus::OK &&
+        request->all_replicated_index() == request->last_idx_appended_to_leader() &&
+        request->committed_index() == request->last_idx_appended_to_leader() &&
+        MonoTime::Now() - last_append_time >= MonoDelta::FromSeconds(dormant_idle_secs)) {
+      request->set_dormant_heartbeat_interval_ms(FLAGS_raft_dormant_heartbeat_interval_ms);
+    }
   }
 
   if (PREDICT_FALSE(VLOG_IS_ON(2))) {
@@ -966,6 +1086,11 @@ void PeerMessageQueue::UpdatePeerStatus(const string& peer_uuid,
     return;
   }
   peer->last_exchange_status = ps;
+  if (ps != PeerStatus::OK) {
+    // The requests pipelined to the peer may not have been received: resume
+    // from the last op it acknowledged.
+    peer->next_index_to_send = peer->next_index;
+  }
 
   if (ps != PeerStatus::RPC_LAYER_ERROR) {
     // So long as we got _any_ response from the follower, we consider it a 'communication'.
@@ -1126,7 +1251,7 @@ void PeerMessageQueue::TransferLeadershipIfNeeded(const TrackedPeer& peer,
   RaftPeerPB* peer_pb;
   Status s = GetRaftConfigMember(DCHECK_NOTNULL(queue_state_.active_config.get()),
                                  peer.uuid(), &peer_pb);
-  if (!s.ok() || peer_pb->member_type() != RaftPeerPB::VOTER) {
+  if (!s.ok() || peer_pb->member_type() != RaftPeerPB::VOTER || IsWitness(*peer_pb)) {
     return;
   }
 
@@ -1143,7 +1268,8 @@ void PeerMessageQueue::TransferLeadershipIfNeeded(const TrackedPeer& peer,
 }
 
 bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
-                                        const ConsensusResponsePB& response) {
+                                        const ConsensusResponsePB& response,
+                                        MonoTime request_send_time) {
   DCHECK(response.IsInitialized()) << "Error: Uninitialized: "
       << response.InitializationErrorString() << ". Response: " << SecureShortDebugString(response);
   CHECK(!response.has_error());
@@ -1198,7 +1324,17 @@ bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
     // is guaranteed by the Raft protocol to be a valid op.
 
     bool peer_has_prefix_of_log = IsOpInLog(status.last_received());
-    if (peer_has_prefix_of_log) {
+    const OpId& received_from_leader = peer_has_prefix_of_log ?
+        status.last_received() : status.last_received_current_leader();
+    if (peer->last_exchange_status == PeerStatus::OK &&
+        prev_peer_state.last_exchange_status == PeerStatus::OK &&
+        received_from_leader.index() < prev_peer_state.last_received.index()) {
+      // With several requests in flight to the peer, the response to an older
+      // request may be processed after the response to a newer one: the
+      // peer's progress mustn't be rolled back to what it stated then.
+      VLOG_WITH_PREFIX_UNLOCKED(2) << "Ignoring stale response from peer " << peer_uuid
+                                   << ": " << SecureShortDebugString(response);
+    } else if (peer_has_prefix_of_log) {
       // If the latest thing in their log is in our log, we are in sync.
       peer->last_received = status.last_received();
       peer->next_index = peer->last_received.index() + 1;
@@ -1230,6 +1366,9 @@ bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
     }
 
     if (peer->last_exchange_status != PeerStatus::OK) {
+      // Resume from the point negotiated above rather than after the ops
+      // pipelined to the peer.
+      peer->next_index_to_send = peer->next_index;
       // In this case, 'send_more_immediately' has already been set by
       // UpdateExchangeStatus() to true in the case of an LMP mismatch, false
       // otherwise.
@@ -1246,6 +1385,12 @@ bool PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
       CHECK_LE(response.responder_term(), queue_state_.current_term);
     }
 
+    // The peer accepted the request, and withholds its vote from now on.
+    if (request_send_time.Initialized() &&
+        request_send_time > peer->last_acked_request_time) {
+      peer->last_acked_request_time = request_send_time;
+    }
+
     VLOG_WITH_PREFIX_UNLOCKED(2)
         << Substitute("Received Response from Peer ($0). Response: $1",
                       peer->ToString(), SecureShortDebugString(response));
@@ -1354,6 +1499,31 @@ bool PeerMessageQueue::IsCommittedIndexInCurrentTerm() const {
       queue_state_.committed_index >= *queue_state_.first_index_in_current_term;
 }
 
+MonoTime PeerMessageQueue::GetMajorityAckedRequestTime() const {
+  std::lock_guard<simple_spinlock> lock(queue_lock_);
+  if (queue_state_.mode != LEADER) {
+    return MonoTime::Min();
+  }
+  // The local peer doesn't vote for anyone else while it's the leader.
+  const MonoTime now = MonoTime::Now();
+  vector<MonoTime> ack_times;
+  for (const PeersMap::value_type& entry : peers_map_) {
+    const TrackedPeer* peer = entry.second;
+    if (!IsRaftConfigVoter(peer->uuid(), *queue_state_.active_config)) {
+      continue;
+    }
+    ack_times.emplace_back(peer->uuid() == local_peer_pb_.permanent_uuid() ?
+                           now : peer->last_acked_request_time);
+  }
+  const int majority_size = queue_state_.majority_size_;
+  if (majority_size <= 0 || static_cast<int>(ack_times.size()) < majority_size) {
+    return MonoTime::Min();
+  }
+  std::nth_element(ack_times.begin(), ack_times.begin() + majority_size - 1, ack_times.end(),
+                   std::greater<MonoTime>());
+  return ack_times[majority_size - 1];
+}
+
 bool PeerMessageQueue::IsInLeaderMode() const {
   std::lock_guard<simple_spinlock> lock(queue_lock_);
   return queue_state_.mode == Mode::LEADER;
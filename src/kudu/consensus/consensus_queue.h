@@ -108,9 +108,8 @@ const char* PeerStatusToString(PeerStatus p);
 // This also takes care of pushing requests to peers as new operations are
 // added, and notifying RaftConsensus when the commit index advances.
 //
-// TODO(todd): Right now this class is able to track one outstanding operation
-// per peer. If we want to have more than one outstanding RPC we need to
-// modify it.
+// Several requests may be in flight to a peer which is in sync with the
+// leader: see PipelinedRequestForPeer().
 class PeerMessageQueue {
  public:
   struct TrackedPeer {
@@ -140,6 +139,10 @@ class PeerMessageQueue {
     // This corresponds to "nextIndex" as specified in Raft.
     int64_t next_index;
 
+    // The index following the ops of the last request assembled for the peer.
+    // Ahead of 'next_index' while pipelined requests are in flight.
+    int64_t next_index_to_send;
+
     // The last operation that we've sent to this peer and that
     // it acked. Used for watermark movement.
     OpId last_received;
@@ -162,6 +165,13 @@ class PeerMessageQueue {
     // successful communication ever took place.
     MonoTime last_communication_time;
 
+    // The time at which the latest request acknowledged by the peer in the
+    // current term was sent. Having accepted it, the peer doesn't vote for
+    // another candidate for the minimum election timeout: see
+    // GetMajorityAckedRequestTime(). MonoTime::Min() if the peer hasn't
+    // acknowledged any request yet.
+    MonoTime last_acked_request_time;
+
     // Set to false if it is determined that the remote peer has fallen behind
     // the local peer's WAL.
     bool wal_catchup_possible;
@@ -278,6 +288,19 @@ class PeerMessageQueue {
                         std::vector<ReplicateRefPtr>* msg_refs,
                         bool* needs_tablet_copy);
 
+  // Like RequestForPeer(), but assembles a request to be sent while other
+  // requests are still in flight to the peer: its entries start right after
+  // those of the last request assembled for the peer, rather than after the
+  // last op acknowledged by the peer. The request has no entries if there are
+  // no new ops to send.
+  //
+  // Returns Status::Incomplete if the last exchange with the peer wasn't
+  // successful, in which case the caller must wait for the responses to the
+  // requests in flight and resume with RequestForPeer().
+  Status PipelinedRequestForPeer(const std::string& uuid,
+                                 ConsensusRequestPB* request,
+                                 std::vector<ReplicateRefPtr>* msg_refs);
+
   // Fill in a StartTabletCopyRequest for the specified peer.
   // If that peer should not initiate Tablet Copy, returns a non-OK status.
   // On success, also internally resets peer->needs_tablet_copy to false.
@@ -297,8 +320,21 @@ class PeerMessageQueue {
   // Returns true iff there are more requests pending in the queue for this
   // peer and another request should be sent immediately, with no intervening
   // delay.
+  //
+  // If set, 'request_send_time' is the time at which the request was sent,
+  // which is used to track the leader lease.
   bool ResponseFromPeer(const std::string& peer_uuid,
-                        const ConsensusResponsePB& response);
+                        const ConsensusResponsePB& response,
+                        MonoTime request_send_time = MonoTime());
+
+  // Returns the latest time T such that a majority of the voters, counting
+  // the local peer, acknowledged a request sent at T or later in the current
+  // term. Since the voters which acknowledged a request don't vote for another
+  // candidate for the minimum election timeout after receiving it, no other
+  // leader may be elected until then: this is what the leader lease is based
+  // upon. Returns MonoTime::Min() if there's no such time or if the queue
+  // isn't in LEADER mode.
+  MonoTime GetMajorityAckedRequestTime() const;
 
   // Called by the consensus implementation to update the queue's watermarks
   // based on information provided by the leader. This is used for metrics and
@@ -422,6 +458,10 @@ class PeerMessageQueue {
     // The opid of the last operation appended to the queue.
     OpId last_appended;
 
+    // The time of the last append of operations while in LEADER mode, or of
+    // the switch to LEADER mode.
+    MonoTime last_append_time;
+
     // The queue's owner current_term.
     // Set by the last appended operation.
     // If the queue owner's term is less than the term observed
@@ -447,6 +487,14 @@ class PeerMessageQueue {
     std::string ToString() const;
   };
 
+  // Assembles a request for the peer with 'uuid': see RequestForPeer() and
+  // PipelinedRequestForPeer().
+  Status AssembleRequestForPeer(const std::string& uuid,
+                                bool pipelined,
+                                ConsensusRequestPB* request,
+                                std::vector<ReplicateRefPtr>* msg_refs,
+                                bool* needs_tablet_copy);
+
   // Returns true iff given 'desired_op' is found in the local WAL.
   // If the op is not found, returns false.
   // If the log cache returns some error other than NotFound, crashes with a
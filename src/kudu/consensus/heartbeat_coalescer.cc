@@ -0,0 +1,228 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/heartbeat_coalescer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/consensus.proxy.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/messenger.h"
+#include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/flag_validators.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/net/net_util.h"
+#include "kudu/util/status.h"
+
+DEFINE_int32(consensus_heartbeat_coalescing_window_ms, 20,
+             "Maximum time in milliseconds by which the heartbeats sent by the "
+             "leaders hosted by this server may be delayed, so that the "
+             "heartbeats to the same server are sent within a single RPC. "
+             "If 0, each heartbeat is sent in its own RPC.");
+TAG_FLAG(consensus_heartbeat_coalescing_window_ms, advanced);
+TAG_FLAG(consensus_heartbeat_coalescing_window_ms, runtime);
+
+DECLARE_int32(consensus_rpc_timeout_ms);
+DECLARE_int32(raft_heartbeat_interval_ms);
+
+static bool ValidateHeartbeatCoalescingWindow() {
+  const int32_t window_ms = FLAGS_consensus_heartbeat_coalescing_window_ms;
+  if (window_ms < 0 || window_ms >= FLAGS_raft_heartbeat_interval_ms) {
+    LOG(ERROR) << strings::Substitute(
+        "--consensus_heartbeat_coalescing_window_ms must be non-negative and "
+        "less than --raft_heartbeat_interval_ms ($0): $1",
+        FLAGS_raft_heartbeat_interval_ms, window_ms);
+    return false;
+  }
+  return true;
+}
+GROUP_FLAG_VALIDATOR(heartbeat_coalescing_window_flags, ValidateHeartbeatCoalescingWindow);
+
+using kudu::rpc::ErrorStatusPB;
+using kudu::rpc::Messenger;
+using kudu::rpc::ResponseCallback;
+using kudu::rpc::RpcController;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+namespace consensus {
+
+namespace {
+
+struct PendingHeartbeat {
+  ConsensusRequestPB request;
+  ConsensusResponsePB* response;
+  RpcController* controller;
+  ResponseCallback callback;
+};
+
+// A MultiUpdateConsensus() RPC in flight.
+struct Batch {
+  vector<PendingHeartbeat> heartbeats;
+  MultiConsensusRequestPB request;
+  MultiConsensusResponsePB response;
+  RpcController controller;
+};
+
+MonoDelta ConsensusRpcTimeout() {
+  return MonoDelta::FromMilliseconds(FLAGS_consensus_rpc_timeout_ms);
+}
+
+} // anonymous namespace
+
+struct HeartbeatCoalescer::Destination {
+  Destination(shared_ptr<Messenger> m, unique_ptr<ConsensusServiceProxy> p)
+      : messenger(std::move(m)),
+        proxy(std::move(p)) {
+  }
+
+  const shared_ptr<Messenger> messenger;
+  const unique_ptr<ConsensusServiceProxy> proxy;
+
+  // Protects the members below.
+  simple_spinlock lock;
+  vector<PendingHeartbeat> pending;
+  bool flush_scheduled = false;
+
+  // Set once the server is found not to support MultiUpdateConsensus(), in
+  // which case the heartbeats are sent on their own.
+  std::atomic<bool> unsupported{false};
+};
+
+HeartbeatCoalescer::HeartbeatCoalescer(shared_ptr<Messenger> messenger,
+                                       DnsResolver* dns_resolver)
+    : messenger_(std::move(messenger)),
+      dns_resolver_(dns_resolver) {
+}
+
+HeartbeatCoalescer::~HeartbeatCoalescer() {
+}
+
+bool HeartbeatCoalescer::IsEnabled() {
+  return FLAGS_consensus_heartbeat_coalescing_window_ms > 0;
+}
+
+void HeartbeatCoalescer::HeartbeatAsync(const HostPort& hostport,
+                                        const ConsensusRequestPB& request,
+                                        ConsensusResponsePB* response,
+                                        RpcController* controller,
+                                        const ResponseCallback& callback) {
+  shared_ptr<Destination> dest;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    auto& d = destinations_[request.dest_uuid() + "@" + hostport.ToString()];
+    if (!d) {
+      unique_ptr<ConsensusServiceProxy> proxy(
+          new ConsensusServiceProxy(messenger_, hostport, dns_resolver_));
+      proxy->Init();
+      d = std::make_shared<Destination>(messenger_, std::move(proxy));
+    }
+    dest = d;
+  }
+  if (PREDICT_FALSE(dest->unsupported)) {
+    controller->set_timeout(ConsensusRpcTimeout());
+    dest->proxy->UpdateConsensusAsync(request, response, controller, callback);
+    return;
+  }
+
+  bool flush_now = false;
+  bool schedule_flush = false;
+  {
+    std::lock_guard<simple_spinlock> l(dest->lock);
+    dest->pending.push_back({ request, response, controller, callback });
+    if (dest->pending.size() >= kMaxHeartbeatsPerBatch) {
+      flush_now = true;
+    } else if (!dest->flush_scheduled) {
+      dest->flush_scheduled = true;
+      schedule_flush = true;
+    }
+  }
+  if (flush_now) {
+    Flush(dest);
+  } else if (schedule_flush) {
+    // The heartbeats are flushed even if the messenger is shutting down, so
+    // that their callbacks are called with the failures of their RPCs.
+    dest->messenger->ScheduleOnReactor(
+        [dest](const Status& /*s*/) { Flush(dest); },
+        MonoDelta::FromMilliseconds(FLAGS_consensus_heartbeat_coalescing_window_ms));
+  }
+}
+
+void HeartbeatCoalescer::Flush(const shared_ptr<Destination>& dest) {
+  auto batch = std::make_shared<Batch>();
+  {
+    std::lock_guard<simple_spinlock> l(dest->lock);
+    batch->heartbeats.swap(dest->pending);
+    dest->flush_scheduled = false;
+  }
+  if (batch->heartbeats.empty()) {
+    return;
+  }
+  batch->request.set_dest_uuid(batch->heartbeats.front().request.dest_uuid());
+  for (auto& hb : batch->heartbeats) {
+    batch->request.add_requests()->Swap(&hb.request);
+  }
+  batch->controller.set_timeout(ConsensusRpcTimeout());
+  dest->proxy->MultiUpdateConsensusAsync(
+      batch->request, &batch->response, &batch->controller,
+      [dest, batch]() {
+        auto& heartbeats = batch->heartbeats;
+        const Status& s = batch->controller.status();
+        if (PREDICT_TRUE(s.ok() && !batch->response.has_error() &&
+                         batch->response.responses_size() == heartbeats.size())) {
+          for (int i = 0; i < heartbeats.size(); i++) {
+            heartbeats[i].response->Swap(batch->response.mutable_responses(i));
+            heartbeats[i].callback();
+          }
+          return;
+        }
+        const ErrorStatusPB* err = batch->controller.error_response();
+        if (err && (err->code() == ErrorStatusPB::ERROR_NO_SUCH_METHOD ||
+                    err->code() == ErrorStatusPB::ERROR_NO_SUCH_SERVICE)) {
+          LOG(INFO) << "Server " << batch->request.dest_uuid()
+                    << " doesn't support coalesced heartbeats: sending them on their own";
+          dest->unsupported = true;
+        }
+        // Send the heartbeats on their own, so that their failures are
+        // reported by their own controllers.
+        for (int i = 0; i < heartbeats.size(); i++) {
+          heartbeats[i].controller->set_timeout(ConsensusRpcTimeout());
+          dest->proxy->UpdateConsensusAsync(batch->request.requests(i),
+                                            heartbeats[i].response,
+                                            heartbeats[i].controller,
+                                            heartbeats[i].callback);
+        }
+      });
+}
+
+} // namespace consensus
+} // namespace kudu
@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/rpc/response_callback.h"
+#include "kudu/util/locks.h"
+
+namespace kudu {
+
+class DnsResolver;
+class HostPort;
+
+namespace rpc {
+class Messenger;
+class RpcController;
+} // namespace rpc
+
+namespace consensus {
+
+class ConsensusRequestPB;
+class ConsensusResponsePB;
+
+// Coalesces the heartbeats sent by the leaders hosted by a tablet server to
+// their followers, into a single MultiUpdateConsensus() RPC per destination
+// server.
+//
+// Each leader heartbeats each of its followers every
+// --raft_heartbeat_interval_ms. With thousands of tablets per server, the
+// heartbeats of the idle tablets make for most of the RPCs between the
+// servers. Instead, the heartbeats queued for a destination within
+// --consensus_heartbeat_coalescing_window_ms are sent together, and their
+// responses are dispatched as if they were sent on their own.
+//
+// If the batch RPC fails, e.g. since the destination predates
+// MultiUpdateConsensus(), the heartbeats are sent on their own, so that
+// their failures are reported by their controllers as usual.
+//
+// This class is thread-safe.
+class HeartbeatCoalescer {
+ public:
+  HeartbeatCoalescer(std::shared_ptr<rpc::Messenger> messenger,
+                     DnsResolver* dns_resolver);
+  ~HeartbeatCoalescer();
+
+  // Returns whether the heartbeats are coalesced, per
+  // --consensus_heartbeat_coalescing_window_ms.
+  static bool IsEnabled();
+
+  // Sends the heartbeat 'request' to the server at 'hostport' within the
+  // next batch to that server. As with ConsensusServiceProxy, 'response'
+  // and 'controller' must stay valid until 'callback' is called.
+  void HeartbeatAsync(const HostPort& hostport,
+                      const ConsensusRequestPB& request,
+                      ConsensusResponsePB* response,
+                      rpc::RpcController* controller,
+                      const rpc::ResponseCallback& callback);
+
+ private:
+  struct Destination;
+
+  // The maximum number of heartbeats sent within a batch.
+  static constexpr int kMaxHeartbeatsPerBatch = 1024;
+
+  // Sends the heartbeats queued for 'dest'.
+  static void Flush(const std::shared_ptr<Destination>& dest);
+
+  std::shared_ptr<rpc::Messenger> messenger_;
+  DnsResolver* dns_resolver_;
+
+  // Protects 'destinations_'.
+  simple_spinlock lock_;
+
+  // Keyed by the address of the destination server.
+  std::unordered_map<std::string, std::shared_ptr<Destination>> destinations_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeartbeatCoalescer);
+};
+
+} // namespace consensus
+} // namespace kudu
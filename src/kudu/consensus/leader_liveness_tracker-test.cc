@@ -0,0 +1,88 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/leader_liveness_tracker.h"
+
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "kudu/util/monotime.h"
+#include "kudu/util/test_util.h"
+
+using std::map;
+using std::string;
+
+namespace kudu {
+namespace consensus {
+
+class LeaderLivenessTrackerTest : public KuduTest {
+ protected:
+  void Register(const string& tablet_id) {
+    tracker_.RegisterReplica(tablet_id, [this, tablet_id](const string& leader_uuid) {
+      notified_[tablet_id] = leader_uuid;
+    });
+  }
+
+  LeaderLivenessTracker tracker_;
+  map<string, string> notified_;
+};
+
+TEST_F(LeaderLivenessTrackerTest, TestNotifiesReplicasOfSilentLeader) {
+  const MonoDelta kTimeout = MonoDelta::FromMilliseconds(100);
+  for (const auto& tablet_id : { "t1", "t2", "t3", "t4" }) {
+    Register(tablet_id);
+  }
+  tracker_.RecordLeaderContact("t1", "A");
+  tracker_.RecordLeaderContact("t2", "A");
+  tracker_.RecordLeaderContact("t3", "A");
+  tracker_.RecordLeaderContact("t4", "B");
+
+  // A recent contact with the leader for any of its tablets means it's alive.
+  ASSERT_EQ(0, tracker_.ReportLeaderFailure("t1", "A", kTimeout));
+  SleepFor(kTimeout);
+  tracker_.RecordLeaderContact("t2", "A");
+  ASSERT_EQ(0, tracker_.ReportLeaderFailure("t1", "A", kTimeout));
+  ASSERT_TRUE(notified_.empty());
+
+  // Once silent for all its tablets, the other replicas it leads are notified.
+  SleepFor(kTimeout);
+  tracker_.RecordLeaderContact("t4", "B");
+  ASSERT_EQ(2, tracker_.ReportLeaderFailure("t1", "A", kTimeout));
+  ASSERT_EQ((map<string, string>{ { "t2", "A" }, { "t3", "A" } }), notified_);
+
+  // The replicas are notified once until the leader is heard from again.
+  notified_.clear();
+  ASSERT_EQ(0, tracker_.ReportLeaderFailure("t2", "A", kTimeout));
+  tracker_.RecordLeaderContact("t3", "A");
+  SleepFor(kTimeout);
+  tracker_.UnregisterReplica("t1");
+  ASSERT_EQ(1, tracker_.ReportLeaderFailure("t3", "A", kTimeout));
+  ASSERT_EQ((map<string, string>{ { "t2", "A" } }), notified_);
+
+  // The replicas following another leader aren't notified.
+  notified_.clear();
+  tracker_.RecordLeaderContact("t2", "B");
+  SleepFor(kTimeout);
+  ASSERT_EQ(1, tracker_.ReportLeaderFailure("t4", "B", kTimeout));
+  ASSERT_EQ((map<string, string>{ { "t2", "B" } }), notified_);
+  ASSERT_EQ(0, tracker_.ReportLeaderFailure("t4", "C", kTimeout));
+}
+
+} // namespace consensus
+} // namespace kudu
@@ -0,0 +1,95 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/leader_liveness_tracker.h"
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/map-util.h"
+
+using std::string;
+using std::vector;
+
+namespace kudu {
+namespace consensus {
+
+void LeaderLivenessTracker::RegisterReplica(const string& tablet_id, LeaderFailedCallback cb) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  ReplicaState& state = replicas_[tablet_id];
+  state.callback = std::move(cb);
+  state.leader_uuid.clear();
+}
+
+void LeaderLivenessTracker::UnregisterReplica(const string& tablet_id) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  replicas_.erase(tablet_id);
+}
+
+void LeaderLivenessTracker::RecordLeaderContact(const string& tablet_id,
+                                                const string& leader_uuid) {
+  const MonoTime now = MonoTime::Now();
+  std::lock_guard<simple_spinlock> l(lock_);
+  ReplicaState* replica = FindOrNull(replicas_, tablet_id);
+  if (!replica) {
+    return;
+  }
+  if (replica->leader_uuid != leader_uuid) {
+    replica->leader_uuid = leader_uuid;
+  }
+  LeaderState& leader = leaders_[leader_uuid];
+  leader.last_contact = now;
+  leader.failure_reported = false;
+}
+
+int LeaderLivenessTracker::ReportLeaderFailure(const string& tablet_id,
+                                               const string& leader_uuid,
+                                               const MonoDelta& timeout) {
+  vector<LeaderFailedCallback> callbacks;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    LeaderState* leader = FindOrNull(leaders_, leader_uuid);
+    if (!leader || leader->failure_reported ||
+        MonoTime::Now() - leader->last_contact < timeout) {
+      // Either the leader is unknown, or its failure was already reported,
+      // or another replica heard from it recently: the replica reporting
+      // the failure elects a new leader on its own.
+      return 0;
+    }
+    leader->failure_reported = true;
+    for (const auto& [id, replica] : replicas_) {
+      if (id != tablet_id && replica.leader_uuid == leader_uuid) {
+        callbacks.emplace_back(replica.callback);
+      }
+    }
+  }
+  if (!callbacks.empty()) {
+    LOG(INFO) << "Leader " << leader_uuid << " was not heard from for any tablet within "
+              << timeout.ToString() << ": notifying the " << callbacks.size()
+              << " other replicas it leads";
+  }
+  for (const auto& cb : callbacks) {
+    cb(leader_uuid);
+  }
+  return callbacks.size();
+}
+
+} // namespace consensus
+} // namespace kudu
@@ -0,0 +1,98 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
+
+namespace kudu {
+namespace consensus {
+
+// Tracks the liveness of the servers leading the replicas hosted on a
+// server, as a whole rather than per tablet.
+//
+// Each replica detects the failure of its leader on its own, once it hasn't
+// heard from it for a randomized election timeout. On a server following
+// thousands of tablets led by a server which crashes, the elections are
+// spread over the whole randomization window. Instead, the requests that
+// the replicas accept from their leaders are recorded here, so that the
+// first replica detecting the failure of its leader may tell whether the
+// server of the leader went silent for all the tablets it leads, in which
+// case the other replicas it leads start their elections right away.
+//
+// This class is thread-safe.
+class LeaderLivenessTracker {
+ public:
+  // Called with the UUID of the leader found to have failed.
+  typedef std::function<void(const std::string& leader_uuid)> LeaderFailedCallback;
+
+  LeaderLivenessTracker() = default;
+
+  // Registers the replica of 'tablet_id', to notify with 'cb' when its leader
+  // is found to have failed. 'cb' is called without any lock held, and must
+  // not block.
+  void RegisterReplica(const std::string& tablet_id, LeaderFailedCallback cb);
+
+  // Unregisters the replica of 'tablet_id'. No-op if it isn't registered.
+  void UnregisterReplica(const std::string& tablet_id);
+
+  // Records that the replica of 'tablet_id' accepted a request from its
+  // leader 'leader_uuid'.
+  void RecordLeaderContact(const std::string& tablet_id, const std::string& leader_uuid);
+
+  // Reports that the failure detector of the replica of 'tablet_id' expired
+  // while following 'leader_uuid'. If none of the replicas heard from
+  // 'leader_uuid' within 'timeout', notifies the other replicas last led by
+  // 'leader_uuid' once, until it's heard from again.
+  //
+  // Returns the number of replicas notified.
+  int ReportLeaderFailure(const std::string& tablet_id,
+                          const std::string& leader_uuid,
+                          const MonoDelta& timeout);
+
+ private:
+  struct ReplicaState {
+    LeaderFailedCallback callback;
+    // The UUID of the last leader the replica heard from, if any.
+    std::string leader_uuid;
+  };
+
+  struct LeaderState {
+    MonoTime last_contact;
+    // Whether the failure of the leader was reported since 'last_contact'.
+    bool failure_reported = false;
+  };
+
+  // Protects the members below.
+  simple_spinlock lock_;
+
+  // Keyed by tablet ID.
+  std::unordered_map<std::string, ReplicaState> replicas_;
+
+  // Keyed by the UUID of the leader server.
+  std::unordered_map<std::string, LeaderState> leaders_;
+
+  DISALLOW_COPY_AND_ASSIGN(LeaderLivenessTracker);
+};
+
+} // namespace consensus
+} // namespace kudu
@@ -26,7 +26,9 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -48,6 +50,7 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/tablet.pb.h"
 #include "kudu/util/async_util.h"
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/debug/sanitizer_scopes.h"
@@ -66,16 +69,25 @@ DEFINE_int32(num_batches, 10000,
 
 DECLARE_int32(log_min_segments_to_retain);
 DECLARE_int32(log_max_segments_to_retain);
+DECLARE_int32(log_group_commit_max_wait_us);
+DECLARE_int32(log_max_elided_commits);
+DECLARE_int32(log_max_recycled_segments);
+DECLARE_double(env_inject_eio);
 DECLARE_double(log_inject_io_error_on_preallocate_fraction);
 DECLARE_int64(fs_wal_dir_reserved_bytes);
 DECLARE_int64(disk_reserved_bytes_free_for_testing);
+DECLARE_string(env_inject_eio_globs);
 DECLARE_string(log_compression_codec);
 
+METRIC_DECLARE_histogram(log_entry_batches_per_group);
+METRIC_DECLARE_histogram(log_group_commit_wait_time);
+
 namespace kudu {
 namespace log {
 
 using std::shared_ptr;
 using std::string;
+using std::thread;
 using std::unique_ptr;
 using std::vector;
 using consensus::CommitMsg;
@@ -250,6 +262,101 @@ TEST_P(LogTestOptionalCompression, TestFsync) {
   ASSERT_OK(log_->Close());
 }
 
+// Same as above, synchronizing the whole filesystem of the WAL.
+TEST_P(LogTestOptionalCompression, TestGroupFsync) {
+  options_.force_fsync_all = true;
+  options_.group_fsync = true;
+  ASSERT_OK(BuildLog());
+
+  OpId opid;
+  opid.set_term(0);
+  opid.set_index(1);
+
+  AppendNoOp(&opid);
+
+  ASSERT_OK(log_->Close());
+}
+
+// Appends which are held to join larger groups all succeed and are all logged.
+TEST_P(LogTestOptionalCompression, TestGroupCommitMaxWait) {
+  constexpr int kNumAppends = 200;
+  FLAGS_log_group_commit_max_wait_us = 1000;
+  options_.force_fsync_all = true;
+  ASSERT_OK(BuildLog());
+
+  // The first sync gives the log a sync latency to base the wait on.
+  OpId opid = MakeOpId(0, 1);
+  ASSERT_OK(AppendNoOpToLogSync(clock_.get(), log_.get(), &opid));
+
+  vector<unique_ptr<Synchronizer>> syncs;
+  for (int i = 0; i < kNumAppends; i++) {
+    consensus::ReplicateRefPtr replicate = make_scoped_refptr_replicate(new ReplicateMsg());
+    replicate->get()->mutable_id()->CopyFrom(opid);
+    replicate->get()->set_op_type(NO_OP);
+    replicate->get()->mutable_noop_request();
+    replicate->get()->set_timestamp(clock_->Now().ToUint64());
+    opid.set_index(opid.index() + 1);
+    syncs.emplace_back(new Synchronizer);
+    ASSERT_OK(log_->AsyncAppendReplicates({ replicate }, syncs.back()->AsStatusCallback()));
+  }
+  for (const auto& s : syncs) {
+    ASSERT_OK(s->Wait());
+  }
+
+  // Waits are only made by groups which would otherwise have been committed.
+  scoped_refptr<Histogram> groups =
+      METRIC_log_entry_batches_per_group.Instantiate(metric_entity_tablet_);
+  scoped_refptr<Histogram> waits =
+      METRIC_log_group_commit_wait_time.Instantiate(metric_entity_tablet_);
+  ASSERT_LE(waits->TotalCount(), groups->TotalCount());
+  ASSERT_LE(groups->TotalCount(), kNumAppends + 1);
+
+  SegmentSequence segments;
+  log_->reader()->GetSegmentsSnapshot(&segments);
+  ASSERT_EQ(1, segments.size());
+  ASSERT_OK(segments[0]->ReadEntries(&entries_));
+  ASSERT_EQ(kNumAppends + 1, entries_.size());
+  ASSERT_OK(log_->Close());
+}
+
+// Concurrent syncs of a filesystem share the syncs of the filesystem.
+TEST_F(LogTest, TestFileSystemSyncer) {
+  constexpr int kNumThreads = 8;
+  constexpr int kSyncsPerThread = 20;
+  FileSystemSyncer syncer(env_, test_dir_);
+  vector<thread> threads;
+  vector<Status> statuses(kNumThreads);
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < kSyncsPerThread && statuses[i].ok(); j++) {
+        Status s = syncer.Sync();
+        if (s.IsNotSupported()) {
+          return;
+        }
+        statuses[i] = s;
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (const auto& s : statuses) {
+    ASSERT_OK(s);
+  }
+#if !defined(__APPLE__)
+  ASSERT_GT(syncer.num_syncs(), 0);
+  ASSERT_LE(syncer.num_syncs(), kNumThreads * kSyncsPerThread);
+
+  // The failures of the syncs are reported to the callers they cover.
+  FLAGS_env_inject_eio = 1.0;
+  FLAGS_env_inject_eio_globs = test_dir_;
+  Status s = syncer.Sync();
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+  FLAGS_env_inject_eio = 0;
+  ASSERT_OK(syncer.Sync());
+#endif
+}
+
 // Regression test for part of KUDU-735:
 // if a log is not preallocated, we should properly track its on-disk size as we append to
 // it.
@@ -676,6 +783,49 @@ TEST_P(LogTestOptionalCompression, TestWaitUntilAllFlushed) {
   }
 }
 
+// Tests that the elided commits of writes are coalesced into COMMIT entries
+// which cover runs of consecutive writes to the same store, and that these
+// entries are appended by WaitUntilAllFlushed().
+TEST_P(LogTestOptionalCompression, TestElidedCommits) {
+  FLAGS_log_max_elided_commits = 2;
+  ASSERT_OK(BuildLog());
+  tablet::MemStoreTargetPB mrs;
+  mrs.set_mrs_id(1);
+  tablet::MemStoreTargetPB dms;
+  dms.set_rs_id(0);
+  dms.set_dms_id(0);
+  // Runs: [1, 2] (the maximum length), [3], [5] (after a gap), [6] (another
+  // store) and [7] (another term).
+  for (int i = 1; i <= 3; i++) {
+    log_->AppendElidedCommit(MakeOpId(1, i), mrs, i);
+  }
+  log_->AppendElidedCommit(MakeOpId(1, 5), mrs, 1);
+  log_->AppendElidedCommit(MakeOpId(1, 6), dms, 1);
+  log_->AppendElidedCommit(MakeOpId(2, 7), dms, 1);
+  ASSERT_OK(log_->WaitUntilAllFlushed());
+
+  vector<scoped_refptr<ReadableLogSegment>> segments;
+  log_->reader()->GetSegmentsSnapshot(&segments);
+  ASSERT_OK(segments[0]->ReadEntries(&entries_));
+  ASSERT_EQ(5, entries_.size());
+  const vector<std::pair<OpId, int>> expected_runs = {
+    { MakeOpId(1, 1), 2 }, { MakeOpId(1, 3), 1 }, { MakeOpId(1, 5), 1 },
+    { MakeOpId(1, 6), 1 }, { MakeOpId(2, 7), 1 },
+  };
+  for (int i = 0; i < expected_runs.size(); i++) {
+    SCOPED_TRACE(i);
+    const CommitMsg& commit = entries_[i]->commit();
+    ASSERT_EQ(WRITE_OP, commit.op_type());
+    ASSERT_EQ(OpIdToString(expected_runs[i].first), OpIdToString(commit.commited_op_id()));
+    ASSERT_EQ(expected_runs[i].second, commit.elided_num_row_ops_size());
+    ASSERT_FALSE(commit.has_result());
+  }
+  ASSERT_EQ(1, entries_[0]->commit().elided_num_row_ops(0));
+  ASSERT_EQ(2, entries_[0]->commit().elided_num_row_ops(1));
+  ASSERT_EQ(1, entries_[0]->commit().elided_store().mrs_id());
+  ASSERT_EQ(0, entries_[3]->commit().elided_store().dms_id());
+}
+
 // Tests log reopening and that GC'ing the old log's segments works.
 TEST_P(LogTestOptionalCompression, TestLogReopenAndGC) {
   ASSERT_OK(BuildLog());
@@ -1110,6 +1260,52 @@ TEST_F(LogTest, TestGetGCableDataSize) {
   EXPECT_EQ(kSegmentSizeBytes * 4, log_->GetGCableDataSize(RetentionIndexes(35)));
 }
 
+// Test that the files of GC'd segments are reused as the files of new segments,
+// and that the entries they used to hold aren't read back as part of them.
+TEST_F(LogTest, TestGCRecyclesSegmentFiles) {
+  if (env_->IsEncryptionEnabled()) {
+    GTEST_SKIP() << "Encrypted segment files aren't recycled";
+  }
+  FLAGS_log_min_segments_to_retain = 2;
+  FLAGS_log_max_recycled_segments = 2;
+  ASSERT_OK(BuildLog());
+  const string wal_dir = fs_manager_->GetTabletWalDir(kTestTablet);
+  const auto num_recycled_files = [&] {
+    vector<string> children;
+    CHECK_OK(env_->GetChildren(wal_dir, &children));
+    return std::count_if(children.begin(), children.end(), [](const string& child) {
+      return child.find(".recycled-") != string::npos;
+    });
+  };
+
+  // Create 5 segments of 5 ops each, and GC the first 3: 2 of them are kept
+  // for reuse.
+  OpId op_id = MakeOpId(1, 10);
+  ASSERT_OK(AppendMultiSegmentSequence(5, 5, &op_id, nullptr));
+  int num_gced_segments;
+  ASSERT_OK(log_->GC(RetentionIndexes(35), &num_gced_segments));
+  ASSERT_EQ(3, num_gced_segments);
+  ASSERT_EQ(2, num_recycled_files());
+
+  // Roll over twice, with fewer ops per segment than the recycled segments
+  // used to hold.
+  ASSERT_OK(AppendMultiSegmentSequence(3, 2, &op_id, nullptr));
+  ASSERT_EQ(0, num_recycled_files());
+
+  // Reopen the log: the segments must only contain the ops written to them.
+  ASSERT_OK(log_->Close());
+  ASSERT_OK(BuildLog());
+  SegmentSequence segments;
+  log_->reader()->GetSegmentsSnapshot(&segments);
+  int64_t num_entries = 0;
+  for (const auto& segment : segments) {
+    LogEntries entries;
+    ASSERT_OK(segment->ReadEntries(&entries));
+    num_entries += entries.size();
+  }
+  ASSERT_EQ(5 + 5 + 2 + 2 + 2, num_entries) << DumpSegmentsToString(segments);
+}
+
 // Regression test. Check that failed preallocation returns an error instead of
 // hanging.
 TEST_F(LogTest, TestFailedLogPreAllocation) {
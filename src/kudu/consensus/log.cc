@@ -17,6 +17,7 @@
 
 #include "kudu/consensus/log.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdint>
 #include <functional>
@@ -31,6 +32,7 @@
 #include <boost/iterator/reverse_iterator.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <gflags/gflags.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include "kudu/common/wire_protocol.h"
 #include "kudu/consensus/consensus.pb.h"
@@ -45,7 +47,9 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/walltime.h"
+#include "kudu/tablet/tablet.pb.h"
 #include "kudu/util/async_util.h"
+#include "kudu/util/coding.h"
 #include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
@@ -88,6 +92,18 @@ DEFINE_int32(group_commit_queue_size_bytes, 4 * 1024 * 1024,
              "Maximum size of the group commit queue in bytes");
 TAG_FLAG(group_commit_queue_size_bytes, advanced);
 
+DEFINE_int32(log_group_commit_max_wait_us, 0,
+             "Maximum number of microseconds for which the log append thread "
+             "may hold a group commit to wait for more entries when the group "
+             "is small, so that they share a single fsync. The wait is also "
+             "bounded by half of the recently observed fsync latency. Only "
+             "applies when --log_force_fsync_all is true. If 0, groups are "
+             "committed as soon as they are collected.");
+TAG_FLAG(log_group_commit_max_wait_us, runtime);
+TAG_FLAG(log_group_commit_max_wait_us, experimental);
+DEFINE_validator(log_group_commit_max_wait_us,
+                 [](const char* /* flagname */, int32_t value) { return value >= 0; });
+
 
 DEFINE_int32(log_thread_idle_threshold_ms, 1000,
              "Number of milliseconds after which the log append thread decides that a "
@@ -95,10 +111,23 @@ DEFINE_int32(log_thread_idle_threshold_ms, 1000,
 TAG_FLAG(log_thread_idle_threshold_ms, experimental);
 TAG_FLAG(log_thread_idle_threshold_ms, hidden);
 
+DEFINE_int32(log_append_pool_num_threads, 0,
+             "Number of threads of the pool appending to the logs of all the "
+             "tablets of the server. If 0, each log appends with a thread of its "
+             "own, which waits for more appends while the log is active (see "
+             "--log_thread_idle_threshold_ms). A shared pool bounds the number of "
+             "appender threads regardless of the number of tablets, their appends "
+             "being serialized per log, but a slow sync of a log delays the "
+             "appends of the logs queued behind it.");
+TAG_FLAG(log_append_pool_num_threads, experimental);
+DEFINE_validator(log_append_pool_num_threads,
+                 [](const char* /* flagname */, int32_t value) { return value >= 0; });
+
 // Compression configuration.
 // -----------------------------
 DEFINE_string(log_compression_codec, "LZ4",
-              "Codec to use for compressing WAL segments.");
+              "Codec to use for compressing WAL segments. One of NO_COMPRESSION, "
+              "SNAPPY, LZ4, ZLIB or ZSTD.");
 TAG_FLAG(log_compression_codec, experimental);
 
 // Fault/latency injection flags.
@@ -128,6 +157,15 @@ DEFINE_int32(log_inject_thread_lifecycle_latency_ms, 0,
 TAG_FLAG(log_inject_thread_lifecycle_latency_ms, unsafe);
 TAG_FLAG(log_inject_thread_lifecycle_latency_ms, runtime);
 
+DEFINE_int32(log_max_elided_commits, 1024,
+             "The maximum number of writes whose elided commits are coalesced into a single "
+             "COMMIT entry of the WAL. See --log_elide_write_commits.");
+TAG_FLAG(log_max_elided_commits, advanced);
+TAG_FLAG(log_max_elided_commits, experimental);
+TAG_FLAG(log_max_elided_commits, runtime);
+DEFINE_validator(log_max_elided_commits,
+                 [](const char* /*flagname*/, int32_t value) { return value > 0; });
+
 DEFINE_double(fault_crash_before_append_commit, 0.0,
               "Fraction of the time when the server will crash just before appending a "
               "COMMIT message to the log. (For testing only!)");
@@ -162,6 +200,27 @@ DEFINE_bool(fs_wal_use_file_cache, true,
 TAG_FLAG(fs_wal_use_file_cache, runtime);
 TAG_FLAG(fs_wal_use_file_cache, advanced);
 
+DEFINE_int32(log_max_recycled_segments, 0,
+             "Maximum number of files of garbage-collected WAL segments to keep per "
+             "tablet for reuse as the files of new segments, rather than deleting "
+             "them and creating new files, which causes filesystem metadata churn. "
+             "Only effective when WAL segments are preallocated and encryption is "
+             "disabled.");
+TAG_FLAG(log_max_recycled_segments, advanced);
+TAG_FLAG(log_max_recycled_segments, experimental);
+TAG_FLAG(log_max_recycled_segments, runtime);
+DEFINE_validator(log_max_recycled_segments,
+                 [](const char* /*flagname*/, int32_t value) { return value >= 0; });
+
+DEFINE_bool(log_drop_finished_segments_from_page_cache, false,
+            "Whether to advise the OS to drop WAL segments from the page cache once "
+            "they're finished and written back, so that they don't evict data which "
+            "is more likely to be read. Finished segments are only read by lagging "
+            "peers and upon bootstrap.");
+TAG_FLAG(log_drop_finished_segments_from_page_cache, advanced);
+TAG_FLAG(log_drop_finished_segments_from_page_cache, experimental);
+TAG_FLAG(log_drop_finished_segments_from_page_cache, runtime);
+
 DEFINE_bool(skip_remove_old_recovery_dir, false,
             "Skip removing WAL recovery dir after startup. (useful for debugging)");
 TAG_FLAG(skip_remove_old_recovery_dir, hidden);
@@ -177,6 +236,7 @@ static bool ValidateLogsToRetain(const char* flagname, int value) {
 }
 DEFINE_validator(log_min_segments_to_retain, &ValidateLogsToRetain);
 
+using google::protobuf::internal::WireFormatLite;
 using kudu::consensus::CommitMsg;
 using kudu::consensus::OpId;
 using kudu::consensus::ReplicateRefPtr;
@@ -207,6 +267,12 @@ string LogContext::LogPrefix() const {
 // batches to write until it finds that the queue has been empty for a while,
 // at which point the task finishes.
 //
+// With --log_append_pool_num_threads, the tasks of all the logs run on a pool
+// shared by the server instead, through a serial token per log. The tasks
+// don't wait for more batches then: a task finishes as soon as the queue is
+// empty, and resubmits itself after each group rather than looping, so that
+// the busy logs don't hold the workers of the pool from the other logs.
+//
 // The trick, then, lies in two areas:
 //
 // 1) After adding a batch to the queue, we need to ensure that a task is
@@ -240,6 +306,13 @@ class Log::AppendThread {
   }
 
  private:
+  // Returns the pool shared by the logs of the server, building it on first
+  // use. See --log_append_pool_num_threads.
+  static Status GetSharedPool(ThreadPool** pool);
+
+  // Submits ProcessQueue() to the pool of the log.
+  void SubmitProcessQueue();
+
   // The task submitted to the threadpool which collects batches from the queue
   // and appends them, until it determines that the queue is idle.
   void ProcessQueue();
@@ -250,6 +323,11 @@ class Log::AppendThread {
   // a new task was enqueued just as we were trying to go idle.
   bool GoIdle();
 
+  // Keeps collecting batches from the queue into 'entry_batches' for a short
+  // while if the group is small and will be synced, so that more batches
+  // share the fsync. See --log_group_commit_max_wait_us.
+  void WaitForMoreBatches(vector<unique_ptr<LogEntryBatch>>* entry_batches);
+
   // Handle the actual appending of a group of entries.
   void HandleBatches(vector<unique_ptr<LogEntryBatch>> entry_batches);
 
@@ -267,9 +345,16 @@ class Log::AppendThread {
   };
   Atomic32 thread_state_ = IDLE;
 
+  // Moving average of the latency of the syncs of the log, in microseconds.
+  // Only accessed by the appender task.
+  int64_t sync_latency_avg_us_ = 0;
+
   // Pool with a single thread, which handles shutting down the thread
-  // when idle.
+  // when idle. Unset if the log appends on the shared pool.
   unique_ptr<ThreadPool> append_pool_;
+
+  // Serial token of the log on the shared pool, if any.
+  unique_ptr<ThreadPoolToken> append_token_;
 };
 
 
@@ -277,8 +362,32 @@ Log::AppendThread::AppendThread(Log *log)
   : log_(log) {
 }
 
+Status Log::AppendThread::GetSharedPool(ThreadPool** pool) {
+  static std::once_flag once;
+  static ThreadPool* shared_pool = nullptr;
+  static Status build_status;
+  std::call_once(once, []() {
+    unique_ptr<ThreadPool> new_pool;
+    build_status = ThreadPoolBuilder("wal-append")
+                   .set_min_threads(0)
+                   .set_max_threads(FLAGS_log_append_pool_num_threads)
+                   .Build(&new_pool);
+    shared_pool = new_pool.release();
+  });
+  RETURN_NOT_OK(build_status);
+  *pool = shared_pool;
+  return Status::OK();
+}
+
 Status Log::AppendThread::Init() {
-  DCHECK(!append_pool_) << "Already initialized";
+  DCHECK(!append_pool_ && !append_token_) << "Already initialized";
+  if (FLAGS_log_append_pool_num_threads > 0) {
+    VLOG_WITH_PREFIX(1) << "Starting log appends on the shared pool";
+    ThreadPool* pool;
+    RETURN_NOT_OK(GetSharedPool(&pool));
+    append_token_ = pool->NewToken(ThreadPool::ExecutionMode::SERIAL);
+    return Status::OK();
+  }
   VLOG_WITH_PREFIX(1) << "Starting log append thread";
   RETURN_NOT_OK(ThreadPoolBuilder("wal-append")
                 .set_min_threads(0)
@@ -292,12 +401,20 @@ Status Log::AppendThread::Init() {
   return Status::OK();
 }
 
+void Log::AppendThread::SubmitProcessQueue() {
+  if (append_token_) {
+    CHECK_OK(append_token_->Submit([this]() { this->ProcessQueue(); }));
+  } else {
+    CHECK_OK(append_pool_->Submit([this]() { this->ProcessQueue(); }));
+  }
+}
+
 void Log::AppendThread::Wake() {
-  DCHECK(append_pool_);
+  DCHECK(append_pool_ || append_token_);
   auto old_status = base::subtle::NoBarrier_CompareAndSwap(
       &thread_state_, IDLE, ACTIVE);
   if (old_status == IDLE) {
-    CHECK_OK(append_pool_->Submit([this]() { this->ProcessQueue(); }));
+    SubmitProcessQueue();
   }
 }
 
@@ -349,9 +466,11 @@ bool Log::AppendThread::GoIdle() {
 void Log::AppendThread::ProcessQueue() {
   DCHECK_EQ(ANNOTATE_UNPROTECTED_READ(thread_state_), ACTIVE);
   VLOG_WITH_PREFIX(2) << "WAL Appender going active";
+  const bool shared = append_token_ != nullptr;
   while (true) {
-    MonoTime deadline = MonoTime::Now() +
-        MonoDelta::FromMilliseconds(FLAGS_log_thread_idle_threshold_ms);
+    const MonoTime now = MonoTime::Now();
+    MonoTime deadline = shared ?
+        now : now + MonoDelta::FromMilliseconds(FLAGS_log_thread_idle_threshold_ms);
     vector<unique_ptr<LogEntryBatch>> entry_batches;
     Status s = log_->entry_queue()->BlockingDrainTo(&entry_batches, deadline);
     if (PREDICT_FALSE(s.IsAborted())) {
@@ -360,12 +479,62 @@ void Log::AppendThread::ProcessQueue() {
       if (GoIdle()) break;
       continue;
     }
+    WaitForMoreBatches(&entry_batches);
     HandleBatches(std::move(entry_batches));
+    if (shared && !log_->entry_queue()->empty()) {
+      // Yield the worker to the other logs: the task remains ACTIVE, and the
+      // token runs it again after the tasks queued in the meantime.
+      SubmitProcessQueue();
+      return;
+    }
   }
   log_->SetActiveSegmentIdle();
   VLOG_WITH_PREFIX(2) << "WAL Appender going idle";
 }
 
+void Log::AppendThread::WaitForMoreBatches(vector<unique_ptr<LogEntryBatch>>* entry_batches) {
+  const int32_t max_wait_us = FLAGS_log_group_commit_max_wait_us;
+  if (max_wait_us <= 0 || !log_->options_.force_fsync_all || sync_latency_avg_us_ <= 0) {
+    return;
+  }
+  // A group made of COMMIT entries only isn't synced, and waiting longer than
+  // a fraction of a sync adds more latency than sharing the sync saves.
+  const int64_t budget_us = std::min<int64_t>(max_wait_us, sync_latency_avg_us_ / 2);
+  if (budget_us <= 0) {
+    return;
+  }
+  bool is_all_commits = true;
+  size_t group_bytes = 0;
+  for (const auto& entry_batch : *entry_batches) {
+    is_all_commits &= entry_batch->type_ == COMMIT;
+    group_bytes += entry_batch->total_size_bytes();
+  }
+  // A group filling a good part of the queue means the log is busy enough to
+  // make large groups on its own.
+  const size_t large_group_bytes = log_->entry_queue()->max_size() / 2;
+  if (is_all_commits || group_bytes >= large_group_bytes) {
+    return;
+  }
+
+  const MonoTime start = MonoTime::Now();
+  const MonoTime deadline = start + MonoDelta::FromMicroseconds(budget_us);
+  while (group_bytes < large_group_bytes) {
+    const size_t num_batches = entry_batches->size();
+    // Stops on TimedOut, or on Aborted once the queue is shut down: the next
+    // drain in ProcessQueue() reports the latter.
+    if (!log_->entry_queue()->BlockingDrainTo(entry_batches, deadline).ok()) {
+      break;
+    }
+    for (size_t i = num_batches; i < entry_batches->size(); i++) {
+      group_bytes += (*entry_batches)[i]->total_size_bytes();
+    }
+  }
+  if (log_->ctx_.metrics) {
+    log_->ctx_.metrics->group_commit_wait_time->Increment(
+        (MonoTime::Now() - start).ToMicroseconds());
+  }
+}
+
 void Log::AppendThread::HandleBatches(vector<unique_ptr<LogEntryBatch>> entry_batches) {
   if (log_->ctx_.metrics) {
     log_->ctx_.metrics->entry_batches_per_group->Increment(entry_batches.size());
@@ -393,7 +562,13 @@ void Log::AppendThread::HandleBatches(vector<unique_ptr<LogEntryBatch>> entry_ba
 
   Status s;
   if (!is_all_commits) {
+    const MonoTime sync_start = MonoTime::Now();
     s = log_->Sync();
+    if (s.ok() && log_->options_.force_fsync_all) {
+      const int64_t sync_us = (MonoTime::Now() - sync_start).ToMicroseconds();
+      sync_latency_avg_us_ = sync_latency_avg_us_ == 0 ?
+          sync_us : (sync_latency_avg_us_ * 7 + sync_us) / 8;
+    }
   }
   if (PREDICT_FALSE(!s.ok())) {
     LOG_WITH_PREFIX(ERROR) << "Error syncing log: " << s.ToString();
@@ -420,6 +595,10 @@ void Log::AppendThread::Shutdown() {
     append_pool_->Wait();
     append_pool_->Shutdown();
   }
+  if (append_token_) {
+    append_token_->Wait();
+    append_token_->Shutdown();
+  }
 }
 
 string Log::AppendThread::LogPrefix() const {
@@ -513,7 +692,19 @@ Status SegmentAllocator::Sync() {
 
   if (opts_->force_fsync_all) {
     LOG_SLOW_EXECUTION(WARNING, 50, Substitute("$0Fsync log took a long time", LogPrefix())) {
-      RETURN_NOT_OK(active_segment_->Sync());
+      Status s = Status::NotSupported("group fsync is disabled");
+      if (opts_->group_fsync) {
+        if (!fs_syncer_) {
+          // The WALs of all of the tablets are in the same directory.
+          fs_syncer_ = FileSystemSyncer::Get(ctx_->fs_manager->GetEnv(),
+                                             DirName(ctx_->log_dir));
+        }
+        s = fs_syncer_->Sync();
+      }
+      if (s.IsNotSupported()) {
+        s = active_segment_->Sync();
+      }
+      RETURN_NOT_OK(s);
       if (hooks_) {
         RETURN_NOT_OK_PREPEND(hooks_->PostSyncIfFsyncEnabled(),
                               "PostSyncIfFsyncEnabled hook failed");
@@ -557,6 +748,11 @@ Status SegmentAllocator::FinishCurrentSegment(
         active_segment_->written_offset()));
   }
   RETURN_NOT_OK(Sync());
+  if (FLAGS_log_drop_finished_segments_from_page_cache) {
+    WARN_NOT_OK(active_segment_->file()->DropPageCache(0, 0),
+                Substitute("$0could not drop finished WAL segment $1 from the page cache",
+                           LogPrefix(), active_segment_->path()));
+  }
 
   if (hooks_) {
     RETURN_NOT_OK_PREPEND(hooks_->PostClose(), "PostClose hook failed");
@@ -594,6 +790,56 @@ void SegmentAllocator::StopAllocationThread() {
   allocation_pool_->Shutdown();
 }
 
+Status SegmentAllocator::RecycleSegmentFile(const string& path, bool* recycled) {
+  *recycled = false;
+  Env* env = ctx_->fs_manager->GetEnv();
+  // Reusing an encrypted file would require preserving its encryption header.
+  if (!opts_->preallocate_segments || env->IsEncryptionEnabled()) {
+    return Status::OK();
+  }
+  {
+    std::lock_guard l(recycled_segments_lock_);
+    if (recycled_segment_paths_.size() >= FLAGS_log_max_recycled_segments) {
+      return Status::OK();
+    }
+  }
+  string recycled_path = JoinPathSegments(
+      ctx_->log_dir, Substitute("$0.recycled-$1", kTmpInfix, BaseName(path)));
+  RETURN_NOT_OK_PREPEND(env->RenameFile(path, recycled_path),
+                        "could not recycle WAL segment");
+  std::lock_guard l(recycled_segments_lock_);
+  recycled_segment_paths_.emplace_back(std::move(recycled_path));
+  *recycled = true;
+  return Status::OK();
+}
+
+void SegmentAllocator::DeleteRecycledSegmentFiles() {
+  vector<string> paths;
+  {
+    std::lock_guard l(recycled_segments_lock_);
+    paths.swap(recycled_segment_paths_);
+  }
+  Env* env = ctx_->fs_manager->GetEnv();
+  for (const auto& path : paths) {
+    WARN_NOT_OK(env->DeleteFile(path), "could not delete recycled WAL segment " + path);
+  }
+}
+
+Status SegmentAllocator::ReuseRecycledSegmentFile(const string& path) {
+  RWFileOptions opts;
+  opts.mode = Env::MUST_EXIST;
+  opts.is_sensitive = true;
+  unique_ptr<RWFile> segment_file;
+  RETURN_NOT_OK(ctx_->fs_manager->GetEnv()->NewRWFile(opts, path, &segment_file));
+  // The file still holds the entries of the segment it used to be. They must
+  // not be mistaken for entries of the new segment when reading it back after
+  // a crash, which expects zeros past the last entry written.
+  RETURN_NOT_OK(segment_file->Truncate(0));
+  next_segment_path_ = path;
+  next_segment_file_.reset(segment_file.release());
+  return Status::OK();
+}
+
 Status SegmentAllocator::AllocateSegmentAndRollOver(
     scoped_refptr<ReadableLogSegment>* finished_segment,
     scoped_refptr<ReadableLogSegment>* new_readable_segment) {
@@ -635,21 +881,46 @@ Status SegmentAllocator::AllocateNewSegment() {
     allocation_state_ = kAllocationFinished;
   });
 
+  Env* env = ctx_->fs_manager->GetEnv();
+  string recycled_path;
+  {
+    std::lock_guard l(recycled_segments_lock_);
+    if (!recycled_segment_paths_.empty()) {
+      recycled_path = std::move(recycled_segment_paths_.back());
+      recycled_segment_paths_.pop_back();
+    }
+  }
+  bool reused = false;
+  if (!recycled_path.empty()) {
+    Status s = ReuseRecycledSegmentFile(recycled_path);
+    if (s.ok()) {
+      reused = true;
+      VLOG_WITH_PREFIX(1) << "Reusing recycled WAL segment as next WAL segment: "
+                          << next_segment_path_;
+    } else {
+      WARN_NOT_OK(s, "could not reuse recycled WAL segment " + recycled_path);
+      WARN_NOT_OK(env->DeleteFile(recycled_path),
+                  "could not delete recycled WAL segment " + recycled_path);
+    }
+  }
+
   // We could create the new segment file through the cache, but that's tricky
   // because of the file rename that'll happen later. So instead, we'll create
   // it outside the cache now, then reopen via the cache when we switch to it.
-  string tmp_suffix = Substitute("$0$1", kTmpInfix, ".newsegmentXXXXXX");
-  string path_tmpl = JoinPathSegments(ctx_->log_dir, tmp_suffix);
-  VLOG_WITH_PREFIX(2) << "Creating temp. file for place holder segment, template: " << path_tmpl;
-  unique_ptr<RWFile> segment_file;
-  Env* env = ctx_->fs_manager->GetEnv();
-  RWFileOptions opts;
-  opts.is_sensitive = true;
-  RETURN_NOT_OK_PREPEND(env->NewTempRWFile(
-      opts, path_tmpl, &next_segment_path_, &segment_file),
-                        "could not create next WAL segment");
-  next_segment_file_.reset(segment_file.release());
-  VLOG_WITH_PREFIX(1) << "Created next WAL segment, placeholder path: " << next_segment_path_;
+  if (!reused) {
+    string tmp_suffix = Substitute("$0$1", kTmpInfix, ".newsegmentXXXXXX");
+    string path_tmpl = JoinPathSegments(ctx_->log_dir, tmp_suffix);
+    VLOG_WITH_PREFIX(2) << "Creating temp. file for place holder segment, template: "
+                        << path_tmpl;
+    unique_ptr<RWFile> segment_file;
+    RWFileOptions opts;
+    opts.is_sensitive = true;
+    RETURN_NOT_OK_PREPEND(env->NewTempRWFile(
+        opts, path_tmpl, &next_segment_path_, &segment_file),
+                          "could not create next WAL segment");
+    next_segment_file_.reset(segment_file.release());
+    VLOG_WITH_PREFIX(1) << "Created next WAL segment, placeholder path: " << next_segment_path_;
+  }
 
   MAYBE_RETURN_FAILURE(FLAGS_log_inject_io_error_on_preallocate_fraction,
       Status::IOError("Injected IOError in SegmentAllocator::AllocateNewSegment()"));
@@ -859,20 +1130,8 @@ Status Log::AsyncAppend(unique_ptr<LogEntryBatch> entry_batch) {
 
 Status Log::AsyncAppendReplicates(vector<ReplicateRefPtr> replicates,
                                   StatusCallback callback) {
-  LogEntryBatchPB batch_pb;
-  batch_pb.mutable_entry()->Reserve(replicates.size());
-  for (const auto& r : replicates) {
-    LogEntryPB* entry_pb = batch_pb.add_entry();
-    entry_pb->set_type(REPLICATE);
-    entry_pb->set_allocated_replicate(r->get());
-  }
-  unique_ptr<LogEntryBatch> batch =
-      CreateBatchFromPB(REPLICATE, batch_pb, std::move(callback));
-
-  for (LogEntryPB& entry : *batch_pb.mutable_entry()) {
-    entry.release_replicate();
-  }
-
+  unique_ptr<LogEntryBatch> batch(new LogEntryBatch(replicates, std::move(callback)));
+  TRACE("Serialized $0 byte log entry", batch->total_size_bytes());
   return AsyncAppend(std::move(batch));
 }
 
@@ -892,6 +1151,48 @@ Status Log::AsyncAppendCommit(const consensus::CommitMsg& commit_msg,
   return Status::OK();
 }
 
+namespace {
+
+bool SameStore(const tablet::MemStoreTargetPB& a, const tablet::MemStoreTargetPB& b) {
+  return a.mrs_id() == b.mrs_id() && a.rs_id() == b.rs_id() && a.dms_id() == b.dms_id() &&
+      a.rs_txn_id() == b.rs_txn_id();
+}
+
+} // anonymous namespace
+
+void Log::AppendElidedCommit(const consensus::OpId& op_id,
+                             const tablet::MemStoreTargetPB& store,
+                             int32_t num_row_ops) {
+  std::lock_guard<std::mutex> l(elided_commits_lock_);
+  if (elided_commits_) {
+    const auto& first_id = elided_commits_->commited_op_id();
+    const int num_ops = elided_commits_->elided_num_row_ops_size();
+    if (first_id.term() == op_id.term() &&
+        first_id.index() + num_ops == op_id.index() &&
+        num_ops < FLAGS_log_max_elided_commits &&
+        SameStore(elided_commits_->elided_store(), store)) {
+      elided_commits_->add_elided_num_row_ops(num_row_ops);
+      return;
+    }
+    AppendElidedCommitsUnlocked();
+  }
+  elided_commits_.reset(new consensus::CommitMsg);
+  elided_commits_->set_op_type(consensus::WRITE_OP);
+  *elided_commits_->mutable_commited_op_id() = op_id;
+  *elided_commits_->mutable_elided_store() = store;
+  elided_commits_->add_elided_num_row_ops(num_row_ops);
+}
+
+void Log::AppendElidedCommitsUnlocked() {
+  if (!elided_commits_) {
+    return;
+  }
+  CHECK_OK(AsyncAppendCommit(*elided_commits_, [](const Status& s) {
+    CrashIfNotOkStatusCB("Enqueued elided commits failed to write to WAL", s);
+  }));
+  elided_commits_.reset();
+}
+
 Status Log::WriteBatch(LogEntryBatch* entry_batch) {
   // If there is no data to write return OK.
   if (PREDICT_FALSE(entry_batch->type_ == FLUSH_MARKER)) {
@@ -1033,7 +1334,12 @@ Status Log::WaitUntilAllFlushed() {
   Synchronizer s;
   unique_ptr<LogEntryBatch> reserved_entry_batch =
       CreateBatchFromPB(FLUSH_MARKER, entry_batch, s.AsStatusCallback());
-  AsyncAppend(std::move(reserved_entry_batch));
+  {
+    // Queue the marker after the elided commits of the writes applied so far.
+    std::lock_guard<std::mutex> l(elided_commits_lock_);
+    AppendElidedCommitsUnlocked();
+    AsyncAppend(std::move(reserved_entry_batch));
+  }
   return s.Wait();
 }
 
@@ -1073,8 +1379,18 @@ Status Log::GC(RetentionIndexes retention_indexes, int32_t* num_gced) {
                              segment->footer().min_replicate_index(),
                              segment->footer().max_replicate_index());
       }
-      LOG_WITH_PREFIX(INFO) << "Deleting log segment in path: " << segment->path() << ops_str;
-      if (PREDICT_TRUE(ctx_.file_cache)) {
+      // Recycle the segment's file if nothing but us still reads it.
+      bool recycled = false;
+      if (FLAGS_log_max_recycled_segments > 0 && segment->HasOneRef()) {
+        RETURN_NOT_OK(segment_allocator_.RecycleSegmentFile(segment->path(), &recycled));
+      }
+      LOG_WITH_PREFIX(INFO) << (recycled ? "Recycling" : "Deleting")
+                            << " log segment in path: " << segment->path() << ops_str;
+      if (recycled) {
+        if (PREDICT_TRUE(ctx_.file_cache)) {
+          ctx_.file_cache->Invalidate(segment->path());
+        }
+      } else if (PREDICT_TRUE(ctx_.file_cache)) {
         // Note: the segment files will only be deleted from disk when
         // segments_to_delete goes out of scope.
         RETURN_NOT_OK(ctx_.file_cache->DeleteFile(segment->path()));
@@ -1153,6 +1469,11 @@ void Log::SetSchemaForNextLogSegment(Schema schema,
 }
 
 Status Log::Close() {
+  {
+    // If the log is already closed, this is a no-op.
+    std::lock_guard<std::mutex> l(elided_commits_lock_);
+    AppendElidedCommitsUnlocked();
+  }
   segment_allocator_.StopAllocationThread();
   append_thread_->Shutdown();
 
@@ -1177,6 +1498,7 @@ Status Log::Close() {
 
   // Release FDs held by these objects.
   segment_allocator_.active_segment_.reset();
+  segment_allocator_.DeleteRecycledSegmentFiles();
   log_index_.reset();
   reader_.reset();
   return Status::OK();
@@ -1263,6 +1585,58 @@ LogEntryBatch::LogEntryBatch(LogEntryTypePB type,
   }
 }
 
+namespace {
+
+// Returns the size of the LogEntryPB of a REPLICATE entry whose ReplicateMsg
+// is 'replicate_size' bytes long.
+size_t ReplicateEntrySize(size_t replicate_size) {
+  return WireFormatLite::TagSize(LogEntryPB::kTypeFieldNumber, WireFormatLite::TYPE_ENUM) +
+      WireFormatLite::EnumSize(REPLICATE) +
+      WireFormatLite::TagSize(LogEntryPB::kReplicateFieldNumber, WireFormatLite::TYPE_MESSAGE) +
+      WireFormatLite::LengthDelimitedSize(replicate_size);
+}
+
+// Returns the size of the LogEntryBatchPB made of the REPLICATE entries of
+// 'replicates'.
+size_t ReplicateBatchSize(const vector<ReplicateRefPtr>& replicates) {
+  size_t size = 0;
+  for (const auto& r : replicates) {
+    size += WireFormatLite::TagSize(LogEntryBatchPB::kEntryFieldNumber,
+                                    WireFormatLite::TYPE_MESSAGE) +
+        WireFormatLite::LengthDelimitedSize(ReplicateEntrySize(r->serialized().size()));
+  }
+  return size;
+}
+
+} // anonymous namespace
+
+LogEntryBatch::LogEntryBatch(const vector<ReplicateRefPtr>& replicates,
+                             StatusCallback cb)
+    : type_(REPLICATE),
+      total_size_bytes_(ReplicateBatchSize(replicates)),
+      count_(replicates.size()),
+      callback_(std::move(cb)) {
+  // Lay out the LogEntryBatchPB by hand, as the protobuf library would, but
+  // copying the already serialized ReplicateMsgs.
+  buffer_.reserve(total_size_bytes_);
+  replicate_op_ids_.reserve(replicates.size());
+  for (const auto& r : replicates) {
+    const Slice replicate = r->serialized();
+    PutVarint32(&buffer_, WireFormatLite::MakeTag(LogEntryBatchPB::kEntryFieldNumber,
+                                                  WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+    PutVarint64(&buffer_, ReplicateEntrySize(replicate.size()));
+    PutVarint32(&buffer_, WireFormatLite::MakeTag(LogEntryPB::kTypeFieldNumber,
+                                                  WireFormatLite::WIRETYPE_VARINT));
+    PutVarint32(&buffer_, REPLICATE);
+    PutVarint32(&buffer_, WireFormatLite::MakeTag(LogEntryPB::kReplicateFieldNumber,
+                                                  WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+    PutVarint64(&buffer_, replicate.size());
+    buffer_.append(replicate.data(), replicate.size());
+    replicate_op_ids_.emplace_back(r->get()->id());
+  }
+  DCHECK_EQ(total_size_bytes_, buffer_.size());
+}
+
 LogEntryBatch::~LogEntryBatch() {}
 
 }  // namespace log
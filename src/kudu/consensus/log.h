@@ -24,6 +24,7 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <type_traits>
@@ -61,6 +62,10 @@ namespace consensus {
 class CommitMsg;
 }  // namespace consensus
 
+namespace tablet {
+class MemStoreTargetPB;
+}  // namespace tablet
+
 namespace log {
 
 class LogEntryBatch;
@@ -158,6 +163,15 @@ class SegmentAllocator {
     return active_segment_sequence_number_;
   }
 
+  // Keeps the file of the garbage-collected segment at 'path' for reuse as
+  // the file of a future segment, if --log_max_recycled_segments allows.
+  // Sets 'recycled' to whether it did; if not, the caller should delete the
+  // file.
+  Status RecycleSegmentFile(const std::string& path, bool* recycled);
+
+  // Deletes the files kept for reuse by RecycleSegmentFile().
+  void DeleteRecycledSegmentFiles();
+
  private:
   friend class Log;
   friend class LogTest;
@@ -191,9 +205,13 @@ class SegmentAllocator {
 
   // Creates a temporary file, populating 'next_segment_file_' and
   // 'next_segment_path_', and pre-allocating 'max_segment_size_' bytes if
-  // pre-allocation is enabled.
+  // pre-allocation is enabled. The file is a recycled one if there is any.
   Status AllocateNewSegment();
 
+  // Reopens the recycled segment file at 'path' as 'next_segment_file_',
+  // emptying it.
+  Status ReuseRecycledSegmentFile(const std::string& path);
+
   // Swaps in the next segment file as the new active segment.
   //
   // 'new_readable_segment' contains the newly active segment, reopened for reading.
@@ -237,6 +255,10 @@ class SegmentAllocator {
   // This is used to disable fsync during bootstrap.
   bool sync_disabled_;
 
+  // Synchronizes the active segment along with the WALs of the other
+  // tablets if --log_group_fsync is set. Set on the first sync.
+  FileSystemSyncer* fs_syncer_ = nullptr;
+
   // A footer being prepared for the current segment.
   // When the segment is finished, it will be written.
   LogSegmentFooterPB footer_;
@@ -254,6 +276,11 @@ class SegmentAllocator {
 
   // The sequence number of the 'active' log segment.
   uint64_t active_segment_sequence_number_ = 0;
+
+  // The paths of the files of garbage-collected segments kept for reuse,
+  // under temporary names so that they're removed upon restart if unused.
+  simple_spinlock recycled_segments_lock_;
+  std::vector<std::string> recycled_segment_paths_;
 };
 
 // Log interface, inspired by Raft's (logcabin) Log. Provides durability to
@@ -309,6 +336,22 @@ class Log : public RefCountedThreadSafe<Log> {
   Status AsyncAppendCommit(const consensus::CommitMsg& commit_msg,
                            StatusCallback callback);
 
+  // Records the commit of the write 'op_id', all 'num_row_ops' row operations
+  // of which were applied successfully to 'store', without appending a COMMIT
+  // entry for it alone.
+  //
+  // Such commits of writes with consecutive indexes, the same term and the
+  // same store are coalesced into a single COMMIT entry, which is appended
+  // once the run breaks or reaches --log_max_elided_commits writes, and before
+  // WaitUntilAllFlushed() or Close() return. Until then, a crash loses the
+  // commits of the run: bootstrap hands its writes back to consensus as
+  // orphaned replicates, as it does with the writes whose commits were still
+  // in flight. This is safe as long as the tablet doesn't persist the flush of
+  // stores before waiting for the log to be flushed, which it already has to.
+  void AppendElidedCommit(const consensus::OpId& op_id,
+                          const tablet::MemStoreTargetPB& store,
+                          int32_t num_row_ops);
+
   // Blocks the current thread until all the entries in the log queue
   // are flushed and fsynced (if fsync of log entries is enabled).
   Status WaitUntilAllFlushed();
@@ -458,6 +501,11 @@ class Log : public RefCountedThreadSafe<Log> {
   // Asynchronously appends 'entry_batch' to the log.
   Status AsyncAppend(std::unique_ptr<LogEntryBatch> entry_batch);
 
+  // Appends the COMMIT entry of the current run of elided commits, if any.
+  //
+  // Must be called when 'elided_commits_lock_' is held.
+  void AppendElidedCommitsUnlocked();
+
   // Writes serialized contents of 'entry' to the log. This is not thread-safe.
   Status WriteBatch(LogEntryBatch* entry_batch);
 
@@ -521,6 +569,13 @@ class Log : public RefCountedThreadSafe<Log> {
   // The cached on-disk size of the log, used to track its size even if it has been closed.
   std::atomic<int64_t> on_disk_size_;
 
+  // Protects 'elided_commits_'. The COMMIT entry of a run is queued while
+  // holding it, so that WaitUntilAllFlushed() can't overtake it.
+  std::mutex elided_commits_lock_;
+
+  // The current run of elided commits, or null if there is none.
+  std::unique_ptr<consensus::CommitMsg> elided_commits_;
+
   DISALLOW_COPY_AND_ASSIGN(Log);
 };
 
@@ -570,6 +625,11 @@ class LogEntryBatch {
   LogEntryBatch(LogEntryTypePB type, const LogEntryBatchPB& entry_batch_pb,
                 StatusCallback cb);
 
+  // Creates a batch of REPLICATE entries out of the serialized form of
+  // 'replicates', without serializing them again.
+  LogEntryBatch(const std::vector<consensus::ReplicateRefPtr>& replicates,
+                StatusCallback cb);
+
   // Serializes contents of the entry to an internal buffer.
   void Serialize();
 
@@ -65,6 +65,7 @@ using strings::Substitute;
 
 DECLARE_int32(log_cache_size_limit_mb);
 DECLARE_int32(global_log_cache_size_limit_mb);
+DECLARE_string(log_cache_compression_codec);
 
 METRIC_DECLARE_entity(server);
 METRIC_DECLARE_entity(tablet);
@@ -177,6 +178,9 @@ TEST_F(LogCacheTest, TestAppendAndGetMessages) {
   // Evict some and verify that the eviction took effect.
   cache_->EvictThroughOp(50);
   ASSERT_EQ(50, cache_->metrics_.log_cache_num_ops->value());
+  ASSERT_FALSE(cache_->IsOpCached(50));
+  ASSERT_TRUE(cache_->IsOpCached(51));
+  ASSERT_FALSE(cache_->IsOpCached(101));
 
   // Can still read data that was evicted, since it got written through.
   messages.clear();
@@ -324,6 +328,51 @@ TEST_F(LogCacheTest, TestGlobalMemoryLimit) {
   ASSERT_LE(cache_->BytesUsed(), 1024 * 1024);
 }
 
+// Test that with a compression codec, the ops are kept compressed rather than
+// evicted under memory pressure, and are uncompressed when read.
+TEST_F(LogCacheTest, TestCompressedEntries) {
+  FLAGS_log_cache_size_limit_mb = 1;
+  FLAGS_log_cache_compression_codec = "LZ4";
+  CloseAndReopenCache(MinimumOpId());
+
+  // The payloads are zeros, which compress well.
+  const int kPayloadSize = 400 * 1024;
+  const int kNumOps = 10;
+  for (int i = 1; i <= kNumOps; i++) {
+    ASSERT_OK(AppendReplicateMessagesToCache(i, 1, kPayloadSize));
+    log_->WaitUntilAllFlushed();
+  }
+
+  // None of the ops had to be evicted.
+  ASSERT_EQ(kNumOps, cache_->num_cached_ops());
+  ASSERT_GT(cache_->metrics_.log_cache_num_compressed_ops->value(), 0);
+  ASSERT_LT(cache_->BytesUsed(), 1024 * 1024);
+  ASSERT_EQ(cache_->BytesUsed(), cache_->metrics_.log_cache_size->value());
+
+  vector<ReplicateRefPtr> messages;
+  OpId preceding;
+  ASSERT_OK(cache_->ReadOps(0, 8 * 1024 * 1024, &messages, &preceding));
+  ASSERT_EQ(kNumOps, messages.size());
+  EXPECT_EQ("0.0", OpIdToString(preceding));
+  for (int i = 0; i < kNumOps; i++) {
+    const ReplicateMsg* msg = messages[i]->get();
+    EXPECT_EQ(i + 1, msg->id().index());
+    EXPECT_EQ((i + 1) / 7, msg->id().term());
+    EXPECT_EQ(kPayloadSize, msg->noop_request().payload_for_tests().size());
+  }
+
+  // The OpIds of the compressed ops are looked up without reading the log.
+  ASSERT_OK(cache_->LookupOpId(1, &preceding));
+  EXPECT_EQ("0.1", OpIdToString(preceding));
+
+  // Evicting the ops drops the compressed ones too.
+  messages.clear();
+  cache_->EvictThroughOp(kNumOps);
+  ASSERT_EQ(0, cache_->num_cached_ops());
+  ASSERT_EQ(0, cache_->metrics_.log_cache_num_compressed_ops->value());
+  ASSERT_EQ(0, cache_->BytesUsed());
+}
+
 // Test that the log cache properly replaces messages when an index
 // is reused. This is a regression test for a bug where the memtracker's
 // consumption wasn't properly managed when messages were replaced.
@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <string>
@@ -40,12 +41,16 @@
 #include "kudu/gutil/mathlimits.h"
 #include "kudu/gutil/strings/human_readable.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/pb_util.h"
+#include "kudu/util/slice.h"
 
 DEFINE_int32(log_cache_size_limit_mb, 128,
              "The total per-tablet size of consensus entries which may be kept in memory. "
@@ -59,7 +64,17 @@ DEFINE_int32(global_log_cache_size_limit_mb, 1024,
              "caching log entries across all tablets is kept under this threshold.");
 TAG_FLAG(global_log_cache_size_limit_mb, advanced);
 
+DEFINE_string(log_cache_compression_codec, "NO_COMPRESSION",
+              "Codec with which to compress the consensus entries the log cache would "
+              "otherwise evict to stay under its memory limits. The compressed entries are "
+              "uncompressed when sent to the followers lagging behind, which are then caught "
+              "up without reading back the log. Once compressing the entries doesn't free "
+              "enough memory, the oldest are evicted. One of NO_COMPRESSION, SNAPPY, LZ4, "
+              "ZLIB or ZSTD. If NO_COMPRESSION, the entries are evicted right away.");
+TAG_FLAG(log_cache_compression_codec, experimental);
+
 using kudu::pb_util::SecureShortDebugString;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 using strings::Substitute;
@@ -75,6 +90,11 @@ METRIC_DEFINE_gauge_int64(tablet, log_cache_size, "Log Cache Memory Usage",
                           MetricUnit::kBytes,
                           "Amount of memory in use for caching the local log.",
                           kudu::MetricLevel::kDebug);
+METRIC_DEFINE_gauge_int64(tablet, log_cache_num_compressed_ops,
+                          "Log Cache Compressed Operation Count",
+                          MetricUnit::kOperations,
+                          "Number of operations kept compressed in the log cache.",
+                          kudu::MetricLevel::kDebug);
 
 static const char kParentMemTrackerId[] = "log_cache";
 
@@ -83,6 +103,7 @@ LogCache::LogCache(const scoped_refptr<MetricEntity>& metric_entity,
                    string local_uuid,
                    string tablet_id)
     : log_(std::move(log)),
+      codec_(nullptr),
       local_uuid_(std::move(local_uuid)),
       tablet_id_(std::move(tablet_id)),
       next_sequential_op_index_(0),
@@ -103,6 +124,14 @@ LogCache::LogCache(const scoped_refptr<MetricEntity>& metric_entity,
                                      local_uuid_, tablet_id_),
       parent_tracker_);
 
+  const Status s = GetCompressionCodec(
+      GetCompressionCodecType(FLAGS_log_cache_compression_codec), &codec_);
+  if (PREDICT_FALSE(!s.ok())) {
+    LOG_WITH_PREFIX_UNLOCKED(WARNING) << "Could not instantiate the log cache compression "
+                                      << "codec, evicting the entries instead: " << s.ToString();
+    codec_ = nullptr;
+  }
+
   // Put a fake message at index 0, since this simplifies a lot of our
   // code paths elsewhere.
   auto zero_op = new ReplicateMsg;
@@ -156,7 +185,10 @@ Status LogCache::AppendOperations(vector<ReplicateRefPtr> msgs,
   vector<CacheEntry> entries_to_insert;
   entries_to_insert.reserve(msgs.size());
   for (const auto& msg : msgs) {
-    CacheEntry e = { msg, msg->get()->SpaceUsedLong() };
+    // The message is serialized here rather than when appended to the log,
+    // which then reuses the serialized message.
+    CacheEntry e = { msg, msg->get()->SpaceUsedLong() +
+                          static_cast<int64_t>(msg->serialized().size()) };
     mem_required += e.mem_usage;
     entries_to_insert.emplace_back(std::move(e));
   }
@@ -251,6 +283,11 @@ bool LogCache::HasOpBeenWritten(int64_t index) const {
   return index < next_sequential_op_index_;
 }
 
+bool LogCache::IsOpCached(int64_t index) const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return index < next_sequential_op_index_ && ContainsKey(cache_, index);
+}
+
 Status LogCache::LookupOpId(int64_t op_index, OpId* op_id) const {
   // First check the log cache itself.
   {
@@ -267,7 +304,7 @@ Status LogCache::LookupOpId(int64_t op_index, OpId* op_id) const {
     }
     auto iter = cache_.find(op_index);
     if (iter != cache_.end()) {
-      *op_id = iter->second.msg->get()->id();
+      *op_id = EntryOpId(op_index, iter->second);
       return Status::OK();
     }
   }
@@ -280,12 +317,21 @@ namespace {
 // Calculate the total byte size that will be used on the wire to replicate
 // this message as part of a consensus update request. This accounts for the
 // length delimiting and tagging of the message.
-int64_t TotalByteSizeForMessage(const ReplicateMsg& msg) {
+int64_t TotalByteSizeForMessage(size_t msg_byte_size) {
   int64_t msg_size = google::protobuf::internal::WireFormatLite::LengthDelimitedSize(
-      msg.ByteSizeLong());
+      msg_byte_size);
   // Add an extra byte for the type tag.
   return msg_size + 1;
 }
+
+int64_t TotalByteSizeForMessage(const ReplicateMsg& msg) {
+  return TotalByteSizeForMessage(msg.ByteSizeLong());
+}
+
+// The messages of the cache are already serialized.
+int64_t TotalByteSizeForMessage(const ReplicateRefPtr& msg) {
+  return TotalByteSizeForMessage(msg->serialized().size());
+}
 } // anonymous namespace
 
 Status LogCache::ReadOps(int64_t after_op_index,
@@ -299,6 +345,15 @@ Status LogCache::ReadOps(int64_t after_op_index,
   int64_t remaining_space = max_size_bytes;
   int64_t next_index = after_op_index + 1;
 
+  // The compressed messages to return, with their index and their position
+  // in 'messages'. They are uncompressed once the lock is released.
+  struct PendingMessage {
+    int64_t index;
+    size_t pos;
+    shared_ptr<const CompressedReplicate> compressed;
+  };
+  vector<PendingMessage> compressed;
+
   std::unique_lock<simple_spinlock> l(lock_);
   while (remaining_space > 0 && next_index < next_sequential_op_index_) {
     // If the messages the peer needs haven't been loaded into the queue yet,
@@ -316,10 +371,15 @@ Status LogCache::ReadOps(int64_t after_op_index,
       l.unlock();
 
       vector<ReplicateMsg*> raw_replicate_ptrs;
-      RETURN_NOT_OK_PREPEND(
-          log_->reader()->ReadReplicatesInRange(
-              next_index, up_to, remaining_space, &raw_replicate_ptrs),
-          Substitute("failed to read ops $0..$1", next_index, up_to));
+      const Status s = log_->reader()->ReadReplicatesInRange(
+          next_index, up_to, remaining_space, &raw_replicate_ptrs);
+      if (PREDICT_FALSE(!s.ok())) {
+        // Don't leave the placeholders of the compressed messages behind.
+        if (!compressed.empty()) {
+          messages->resize(compressed.front().pos);
+        }
+        return s.CloneAndPrepend(Substitute("failed to read ops $0..$1", next_index, up_to));
+      }
       VLOG_WITH_PREFIX_UNLOCKED(2) <<
           Substitute("read $0 ops from log ($1..$2)", raw_replicate_ptrs.size(),
           next_index, next_index + raw_replicate_ptrs.size() - 1);
@@ -339,24 +399,62 @@ Status LogCache::ReadOps(int64_t after_op_index,
     } else {
       // Pull contiguous messages from the cache until the size limit is achieved.
       for (; iter != cache_.end(); ++iter) {
-        const ReplicateRefPtr& msg = iter->second.msg;
-        if (next_index != msg->get()->id().index()) {
+        const CacheEntry& entry = iter->second;
+        if (next_index != iter->first) {
           continue;
         }
 
-        remaining_space -= TotalByteSizeForMessage(*msg->get());
+        remaining_space -= entry.msg ?
+            TotalByteSizeForMessage(entry.msg) :
+            TotalByteSizeForMessage(entry.compressed->uncompressed_size);
         if (remaining_space < 0 && !messages->empty()) {
           break;
         }
 
-        messages->push_back(msg);
+        if (entry.msg) {
+          messages->push_back(entry.msg);
+        } else {
+          compressed.push_back({ next_index, messages->size(), entry.compressed });
+          messages->emplace_back();
+        }
         ++next_index;
       }
     }
   }
+  l.unlock();
+
+  for (const auto& c : compressed) {
+    const Status s = UncompressEntry(c.index, *c.compressed, &(*messages)[c.pos]);
+    if (PREDICT_FALSE(!s.ok())) {
+      messages->resize(c.pos);
+      return s;
+    }
+  }
   return Status::OK();
 }
 
+Status LogCache::UncompressEntry(int64_t index,
+                                 const CompressedReplicate& compressed,
+                                 ReplicateRefPtr* msg) const {
+  DCHECK(codec_);
+  faststring buf;
+  buf.resize(compressed.uncompressed_size);
+  RETURN_NOT_OK_PREPEND(codec_->Uncompress(Slice(compressed.data), buf.data(), buf.size()),
+                        Substitute("failed to uncompress op $0.$1", compressed.term, index));
+  std::unique_ptr<ReplicateMsg> replicate(new ReplicateMsg);
+  if (PREDICT_FALSE(!replicate->ParseFromArray(buf.data(), buf.size()))) {
+    return Status::Corruption(Substitute("failed to parse uncompressed op $0.$1",
+                                         compressed.term, index));
+  }
+  DCHECK_EQ(index, replicate->id().index());
+  *msg = make_scoped_refptr_replicate(replicate.release());
+  return Status::OK();
+}
+
+OpId LogCache::EntryOpId(int64_t index, const CacheEntry& entry) {
+  return entry.msg ? entry.msg->get()->id() : MakeOpId(entry.compressed->term, index);
+}
+
 
 void LogCache::EvictThroughOp(int64_t index) {
   std::lock_guard<simple_spinlock> lock(lock_);
@@ -372,11 +470,20 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
                       << ": before state: " << ToStringUnlocked();
 
   int64_t bytes_evicted = 0;
+  if (codec_ && bytes_to_evict != MathLimits<int64_t>::kMax) {
+    bytes_evicted = CompressSomeUnlocked(stop_after_index, bytes_to_evict);
+    if (bytes_evicted > 0 && bytes_evicted >= bytes_to_evict) {
+      VLOG_WITH_PREFIX_UNLOCKED(1) << "Compressing log cache: after state: "
+                                   << ToStringUnlocked();
+      return;
+    }
+  }
   for (auto iter = cache_.begin(); iter != cache_.end();) {
     const CacheEntry& entry = iter->second;
     const ReplicateRefPtr& msg = entry.msg;
-    VLOG_WITH_PREFIX_UNLOCKED(2) << "considering for eviction: " << msg->get()->id();
-    int64_t msg_index = msg->get()->id().index();
+    const int64_t msg_index = iter->first;
+    VLOG_WITH_PREFIX_UNLOCKED(2) << "considering for eviction: "
+                                 << EntryOpId(msg_index, entry);
     if (msg_index == kZeroOpIdx) {
       // Always keep our special '0' op.
       ++iter;
@@ -387,14 +494,15 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
       break;
     }
 
-    if (!msg->HasOneRef()) {
+    if (msg && !msg->HasOneRef()) {
       VLOG_WITH_PREFIX_UNLOCKED(2) << "Evicting cache: cannot remove " << msg->get()->id()
                                    << " because it is in-use by a peer.";
       ++iter;
       continue;
     }
 
-    VLOG_WITH_PREFIX_UNLOCKED(2) << "Evicting cache. Removing: " << msg->get()->id();
+    VLOG_WITH_PREFIX_UNLOCKED(2) << "Evicting cache. Removing: "
+                                 << EntryOpId(msg_index, entry);
     AccountForMessageRemovalUnlocked(entry);
     bytes_evicted += entry.mem_usage;
     cache_.erase(iter++);
@@ -406,10 +514,69 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
   VLOG_WITH_PREFIX_UNLOCKED(1) << "Evicting log cache: after state: " << ToStringUnlocked();
 }
 
+int64_t LogCache::CompressSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_free) {
+  DCHECK(lock_.is_locked());
+  DCHECK(codec_);
+  int64_t bytes_freed = 0;
+  for (auto& e : cache_) {
+    const int64_t msg_index = e.first;
+    CacheEntry& entry = e.second;
+    if (msg_index == kZeroOpIdx) {
+      continue;
+    }
+    if (msg_index > stop_after_index || msg_index >= min_pinned_op_index_) {
+      break;
+    }
+    // The messages in use by a peer wouldn't be freed.
+    if (!entry.msg || !entry.msg->HasOneRef()) {
+      continue;
+    }
+
+    const Slice serialized = entry.msg->serialized();
+    auto compressed = std::make_shared<CompressedReplicate>();
+    compressed->term = entry.msg->get()->id().term();
+    compressed->uncompressed_size = serialized.size();
+    compressed->data.resize(codec_->MaxCompressedLength(serialized.size()));
+    size_t compressed_size;
+    const Status s = codec_->Compress(serialized, compressed->data.data(), &compressed_size);
+    if (PREDICT_FALSE(!s.ok())) {
+      LOG_WITH_PREFIX_UNLOCKED(WARNING) << "Could not compress op " << entry.msg->get()->id()
+                                        << ": " << s.ToString();
+      break;
+    }
+    compressed->data.resize(compressed_size);
+    compressed->data.shrink_to_fit();
+
+    const size_t mem_usage = sizeof(CompressedReplicate) + compressed->data.capacity();
+    if (mem_usage >= entry.mem_usage) {
+      // Not worth keeping compressed.
+      continue;
+    }
+    VLOG_WITH_PREFIX_UNLOCKED(2) << "Compressing " << entry.msg->get()->id() << ": "
+                                 << entry.mem_usage << " -> " << mem_usage << " bytes";
+    const int64_t saved = entry.mem_usage - mem_usage;
+    tracker_->Release(saved);
+    metrics_.log_cache_size->DecrementBy(saved);
+    metrics_.log_cache_num_compressed_ops->Increment();
+    entry.msg = nullptr;
+    entry.compressed = std::move(compressed);
+    entry.mem_usage = mem_usage;
+
+    bytes_freed += saved;
+    if (bytes_freed >= bytes_to_free) {
+      break;
+    }
+  }
+  return bytes_freed;
+}
+
 void LogCache::AccountForMessageRemovalUnlocked(const LogCache::CacheEntry& entry) {
   tracker_->Release(entry.mem_usage);
   metrics_.log_cache_size->DecrementBy(entry.mem_usage);
   metrics_.log_cache_num_ops->Decrement();
+  if (entry.compressed) {
+    metrics_.log_cache_num_compressed_ops->Decrement();
+  }
 }
 
 int64_t LogCache::BytesUsed() const {
@@ -449,6 +616,14 @@ void LogCache::DumpToStrings(vector<string>* lines) const {
   lines->push_back("Messages:");
   size_t counter = 0;
   for (const auto& entry : cache_) {
+    if (!entry.second.msg) {
+      const auto& compressed = *entry.second.compressed;
+      lines->push_back(
+          Substitute("Message[$0] $1.$2 : REPLICATE. Compressed, Size: $3",
+                     counter++, compressed.term, entry.first,
+                     compressed.uncompressed_size));
+      continue;
+    }
     const auto* msg = entry.second.msg->get();
     lines->push_back(
         Substitute("Message[$0] $1.$2 : REPLICATE. Type: $3, Size: $4",
@@ -467,6 +642,15 @@ void LogCache::DumpToHtml(std::ostream& out) const {
 
   int counter = 0;
   for (const auto& entry : cache_) {
+    if (!entry.second.msg) {
+      const auto& compressed = *entry.second.compressed;
+      const OpId id = EntryOpId(entry.first, entry.second);
+      out << Substitute("<tr><th>$0</th><th>$1.$2</th><td>REPLICATE (compressed)</td>"
+                        "<td>$3</td><td>$4</td></tr>",
+                        counter++, compressed.term, entry.first,
+                        compressed.uncompressed_size, SecureShortDebugString(id)) << endl;
+      continue;
+    }
     const ReplicateMsg* msg = entry.second.msg->get();
     out << Substitute("<tr><th>$0</th><th>$1.$2</th><td>REPLICATE $3</td>"
                       "<td>$4</td><td>$5</td></tr>",
@@ -486,7 +670,8 @@ void LogCache::Clear() {
   x.Instantiate(metric_entity, 0)
 LogCache::Metrics::Metrics(const scoped_refptr<MetricEntity>& metric_entity)
     : log_cache_num_ops(INSTANTIATE_METRIC(METRIC_log_cache_num_ops)),
-      log_cache_size(INSTANTIATE_METRIC(METRIC_log_cache_size)) {
+      log_cache_size(INSTANTIATE_METRIC(METRIC_log_cache_size)),
+      log_cache_num_compressed_ops(INSTANTIATE_METRIC(METRIC_log_cache_num_compressed_ops)) {
 }
 #undef INSTANTIATE_METRIC
 
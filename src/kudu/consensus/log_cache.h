@@ -29,6 +29,7 @@
 #include "kudu/consensus/ref_counted_replicate.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/status.h"
@@ -36,6 +37,7 @@
 
 namespace kudu {
 
+class CompressionCodec;
 class MemTracker;
 
 namespace log {
@@ -52,6 +54,11 @@ class OpId;
 // can be appended to the end as they are written to the log. Readers
 // fetch entries that were explicitly appended, or they can fetch older
 // entries which are asynchronously fetched from the disk.
+//
+// If --log_cache_compression_codec is set, the operations the cache would
+// otherwise evict to stay under its memory limits are first kept compressed,
+// and uncompressed by the reads which need them, so that the peers lagging
+// behind are served from memory rather than by reading back the log.
 class LogCache {
  public:
   LogCache(const scoped_refptr<MetricEntity>& metric_entity,
@@ -111,6 +118,10 @@ class LogCache {
   // en route to the log.
   bool HasOpBeenWritten(int64_t index) const;
 
+  // Return true if the operation with the given index is in the cache, and
+  // would be read by ReadOps() without reading the log.
+  bool IsOpCached(int64_t index) const;
+
   // Evict any operations with op index <= 'index'.
   void EvictThroughOp(int64_t index);
 
@@ -144,6 +155,7 @@ class LogCache {
 
  private:
   FRIEND_TEST(LogCacheTest, TestAppendAndGetMessages);
+  FRIEND_TEST(LogCacheTest, TestCompressedEntries);
   FRIEND_TEST(LogCacheTest, TestGlobalMemoryLimit);
   FRIEND_TEST(LogCacheTest, TestReplaceMessages);
   FRIEND_TEST(LogCacheTest, TestTruncation);
@@ -152,17 +164,51 @@ class LogCache {
   // Index of the special 'zero-op' entry in the cache.
   static constexpr const int64_t kZeroOpIdx = 0;
 
+  // A message of the cache kept compressed.
+  struct CompressedReplicate {
+    // The term of the message, whose index is the key of its entry.
+    int64_t term;
+    // The size of the serialized message.
+    size_t uncompressed_size;
+    // The serialized message, compressed with 'codec_'.
+    faststring data;
+  };
+
   // An entry in the cache.
   struct CacheEntry {
+    // The message, or nullptr if it's compressed.
     ReplicateRefPtr msg;
     // The cached value of msg->SpaceUsedLong(). This method is expensive
     // to compute, so we compute it only once upon insertion.
     size_t mem_usage;
+    // The compressed message, if 'msg' is nullptr. It's shared with the
+    // readers, which uncompress it without holding 'lock_'.
+    std::shared_ptr<const CompressedReplicate> compressed;
   };
 
+  // Returns the OpId of the message of 'entry', which has index 'index'.
+  static OpId EntryOpId(int64_t index, const CacheEntry& entry);
+
+  // Try to compress the oldest operations of the queue, stopping either
+  // when it saved 'bytes_to_free' bytes or when the op with index
+  // 'stop_after_index' has been compressed, whichever comes first.
+  //
+  // Returns the number of bytes saved.
+  int64_t CompressSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_free);
+
+  // Uncompresses 'compressed', an entry of the cache with index 'index',
+  // into 'msg'.
+  Status UncompressEntry(int64_t index,
+                         const CompressedReplicate& compressed,
+                         ReplicateRefPtr* msg) const;
+
   // Try to evict the oldest operations from the queue, stopping either when
   // 'bytes_to_evict' bytes have been evicted, or the op with index
   // 'stop_after_index' has been evicted, whichever comes first.
+  //
+  // Unless evicting all the ops up to 'stop_after_index', the ops are first
+  // compressed if the cache has a codec, and only evicted if compressing
+  // them didn't free enough memory.
   void EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evict);
 
   // Update metrics and MemTracker to account for the removal of the
@@ -185,6 +231,10 @@ class LogCache {
 
   scoped_refptr<log::Log> const log_;
 
+  // The codec compressing the entries under memory pressure, or nullptr if
+  // such entries are evicted right away.
+  const CompressionCodec* codec_;
+
   // The UUID of the local peer.
   const std::string local_uuid_;
 
@@ -229,6 +279,9 @@ class LogCache {
 
     // Keeps track of the memory consumed by the cache, in bytes.
     scoped_refptr<AtomicGauge<int64_t>> log_cache_size;
+
+    // Keeps track of the number of operations kept compressed.
+    scoped_refptr<AtomicGauge<int64_t>> log_cache_num_compressed_ops;
   };
   Metrics metrics_;
 
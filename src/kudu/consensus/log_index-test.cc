@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -36,6 +37,7 @@ namespace log {
 
 using consensus::MakeOpId;
 using consensus::OpId;
+using std::vector;
 
 class LogIndexTest : public KuduTest {
  public:
@@ -94,6 +96,39 @@ TEST_F(LogIndexTest, TestBasic) {
   VerifyEntry(MakeOpId(5, 1), 1, 50000);
 }
 
+TEST_F(LogIndexTest, TestGetEntries) {
+  // Write the entries of a range crossing two chunks, with a hole.
+  for (int64_t i = 999990; i <= 1000010; i++) {
+    if (i == 1000005) continue;
+    ASSERT_OK(AddEntry(MakeOpId(2, i), 3, i * 10));
+  }
+
+  vector<LogIndexEntry> entries;
+  ASSERT_OK(index_->GetEntries(999990, 1000004, &entries));
+  ASSERT_EQ(15, entries.size());
+  for (int i = 0; i < entries.size(); i++) {
+    const int64_t index = 999990 + i;
+    EXPECT_EQ(2, entries[i].op_id.term());
+    EXPECT_EQ(index, entries[i].op_id.index());
+    EXPECT_EQ(3, entries[i].segment_sequence_number);
+    EXPECT_EQ(index * 10, entries[i].offset_in_segment);
+  }
+
+  // The entries stop short at the hole.
+  ASSERT_OK(index_->GetEntries(1000000, 1000010, &entries));
+  ASSERT_EQ(5, entries.size());
+  EXPECT_EQ(1000004, entries.back().op_id.index());
+  Status s = index_->GetEntries(1000005, 1000010, &entries);
+  EXPECT_TRUE(s.IsNotFound()) << s.ToString();
+
+  // As well as at a missing chunk.
+  ASSERT_OK(AddEntry(MakeOpId(2, 1999999), 4, 100));
+  ASSERT_OK(index_->GetEntries(1999999, 2000010, &entries));
+  ASSERT_EQ(1, entries.size());
+  s = index_->GetEntries(2000000, 2000010, &entries);
+  EXPECT_TRUE(s.IsNotFound()) << s.ToString();
+}
+
 TEST_F(LogIndexTest, TestMultiSegmentWithGC) {
   ASSERT_OK(AddEntry(MakeOpId(1, 1), 1, 12345));
   ASSERT_OK(AddEntry(MakeOpId(1, 1000000), 1, 54321));
@@ -28,6 +28,7 @@
 
 #include "kudu/consensus/log_index.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstdint>
 #include <memory>
@@ -89,6 +90,9 @@ class LogIndex::IndexChunk : public RefCountedThreadSafe<LogIndex::IndexChunk> {
 
   Status Open(FileCache* file_cache);
   Status GetEntry(int entry_index, PhysicalEntry* ret) const;
+  // Reads the 'count' entries following 'first_entry_index', included, into
+  // 'ret'.
+  Status GetEntries(int first_entry_index, int count, PhysicalEntry* ret) const;
   Status SetEntry(int entry_index, const PhysicalEntry& entry);
 
  private:
@@ -124,6 +128,18 @@ Status LogIndex::IndexChunk::GetEntry(int entry_index, PhysicalEntry* ret) const
   return file_->Read(file_->GetEncryptionHeaderSize() + sizeof(PhysicalEntry) * entry_index, s);
 }
 
+Status LogIndex::IndexChunk::GetEntries(int first_entry_index,
+                                        int count,
+                                        PhysicalEntry* ret) const {
+  DCHECK(file_) << "Must Open() first";
+  DCHECK_GE(count, 0);
+  DCHECK_LE(first_entry_index + count, kEntriesPerIndexChunk);
+
+  Slice s(reinterpret_cast<const uint8_t*>(ret), sizeof(PhysicalEntry) * count);
+  return file_->Read(
+      file_->GetEncryptionHeaderSize() + sizeof(PhysicalEntry) * first_entry_index, s);
+}
+
 Status LogIndex::IndexChunk::SetEntry(int entry_index, const PhysicalEntry& entry) {
   DCHECK(file_) << "Must Open() first";
   DCHECK_LT(entry_index, kEntriesPerIndexChunk);
@@ -229,6 +245,45 @@ Status LogIndex::GetEntry(int64_t index, LogIndexEntry* entry) {
   return Status::OK();
 }
 
+Status LogIndex::GetEntries(int64_t first_index,
+                            int64_t last_index,
+                            vector<LogIndexEntry>* entries) {
+  DCHECK_LE(first_index, last_index);
+  entries->clear();
+  vector<PhysicalEntry> phys;
+  for (int64_t index = first_index; index <= last_index;) {
+    scoped_refptr<IndexChunk> chunk;
+    Status s = GetChunkForIndex(index, false /* do not create */, &chunk);
+    if (PREDICT_FALSE(!s.ok())) {
+      if (s.IsNotFound() && !entries->empty()) {
+        break;
+      }
+      return s;
+    }
+    const int index_in_chunk = index % kEntriesPerIndexChunk;
+    const int count = std::min<int64_t>(last_index - index + 1,
+                                        kEntriesPerIndexChunk - index_in_chunk);
+    phys.resize(count);
+    RETURN_NOT_OK(chunk->GetEntries(index_in_chunk, count, phys.data()));
+
+    for (const auto& p : phys) {
+      // See GetEntry().
+      if (p.offset_in_segment == 0) {
+        if (entries->empty()) {
+          return Status::NotFound("entry not found");
+        }
+        return Status::OK();
+      }
+      entries->emplace_back();
+      LogIndexEntry* entry = &entries->back();
+      entry->op_id = consensus::MakeOpId(p.term, index++);
+      entry->segment_sequence_number = p.segment_sequence_number;
+      entry->offset_in_segment = p.offset_in_segment;
+    }
+  }
+  return Status::OK();
+}
+
 void LogIndex::GC(int64_t min_index_to_retain) {
   int min_chunk_to_retain = min_index_to_retain / kEntriesPerIndexChunk;
 
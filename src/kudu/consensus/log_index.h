@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/gutil/macros.h"
@@ -72,6 +73,14 @@ class LogIndex : public RefCountedThreadSafe<LogIndex> {
   // Returns NotFound() if the given log entry was never written.
   Status GetEntry(int64_t index, LogIndexEntry* entry);
 
+  // Retrieve the existing entries from 'first_index' through 'last_index' into
+  // 'entries', stopping short at the first entry which was never written.
+  // The entries of each index chunk are read at once, which is much cheaper
+  // than calling GetEntry() for each of them.
+  // Returns NotFound() if the entry of 'first_index' was never written.
+  Status GetEntries(int64_t first_index, int64_t last_index,
+                    std::vector<LogIndexEntry>* entries);
+
   // Indicate that we no longer need to retain information about indexes lower than the
   // given index. Note that the implementation is conservative and _may_ choose to retain
   // earlier entries.
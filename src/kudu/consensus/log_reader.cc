@@ -23,6 +23,7 @@
 #include <mutex>
 #include <ostream>
 #include <type_traits>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -71,6 +72,9 @@ namespace kudu {
 namespace log {
 
 namespace {
+// The number of index entries ReadReplicatesInRange() reads at once.
+constexpr int64_t kIndexEntriesReadAhead = 1024;
+
 struct LogSegmentSeqnoComparator {
   bool operator() (const scoped_refptr<ReadableLogSegment>& a,
                    const scoped_refptr<ReadableLogSegment>& b) {
@@ -246,12 +250,16 @@ scoped_refptr<ReadableLogSegment> LogReader::GetSegmentBySequenceNumber(int64_t
 }
 
 Status LogReader::ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
+                                           scoped_refptr<ReadableLogSegment>* segment_cache,
                                            faststring* tmp_buf,
                                            LogEntryBatchPB* batch) const {
   const int64_t index = index_entry.op_id.index();
 
-  scoped_refptr<ReadableLogSegment> segment = GetSegmentBySequenceNumber(
-    index_entry.segment_sequence_number);
+  if (!*segment_cache ||
+      (*segment_cache)->header().sequence_number() != index_entry.segment_sequence_number) {
+    *segment_cache = GetSegmentBySequenceNumber(index_entry.segment_sequence_number);
+  }
+  const scoped_refptr<ReadableLogSegment>& segment = *segment_cache;
   if (PREDICT_FALSE(!segment)) {
     return Status::NotFound(Substitute("Segment $0 which contained index $1 has been GCed",
                                        index_entry.segment_sequence_number,
@@ -294,10 +302,19 @@ Status LogReader::ReadReplicatesInRange(int64_t starting_at,
   bool limit_exceeded = false;
   faststring tmp_buf;
   LogEntryBatchPB batch;
+  scoped_refptr<ReadableLogSegment> segment;
+  // The index entries are read ahead, a window at a time.
+  vector<LogIndexEntry> index_entries;
+  size_t next_index_entry = 0;
   for (int64_t index = starting_at; index <= up_to && !limit_exceeded; index++) {
-    LogIndexEntry index_entry;
-    RETURN_NOT_OK_PREPEND(log_index_->GetEntry(index, &index_entry),
-                          Substitute("Failed to read log index for op $0", index));
+    if (next_index_entry == index_entries.size()) {
+      const int64_t window_end = std::min(up_to, index + kIndexEntriesReadAhead - 1);
+      RETURN_NOT_OK_PREPEND(log_index_->GetEntries(index, window_end, &index_entries),
+                            Substitute("Failed to read log index for op $0", index));
+      next_index_entry = 0;
+    }
+    const LogIndexEntry& index_entry = index_entries[next_index_entry++];
+    DCHECK_EQ(index, index_entry.op_id.index());
 
     // Since a given LogEntryBatchPB may contain multiple REPLICATE messages,
     // it's likely that this index entry points to the same batch as the previous
@@ -306,7 +323,7 @@ Status LogReader::ReadReplicatesInRange(int64_t starting_at,
     if (index == starting_at ||
         index_entry.segment_sequence_number != prev_index_entry.segment_sequence_number ||
         index_entry.offset_in_segment != prev_index_entry.offset_in_segment) {
-      RETURN_NOT_OK(ReadBatchUsingIndexEntry(index_entry, &tmp_buf, &batch));
+      RETURN_NOT_OK(ReadBatchUsingIndexEntry(index_entry, &segment, &tmp_buf, &batch));
 
       // Sanity-check the property that a batch should only have increasing indexes.
       int64_t prev_index = 0;
@@ -179,7 +179,11 @@ class LogReader : public enable_make_shared<LogReader> {
 
   // Read the LogEntryBatchPB pointed to by the provided index entry.
   // 'tmp_buf' is used as scratch space to avoid extra allocation.
+  //
+  // 'segment' caches the segment of the batches read in a row: it's looked
+  // up only if it doesn't contain the batch.
   Status ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
+                                  scoped_refptr<ReadableLogSegment>* segment,
                                   faststring* tmp_buf,
                                   LogEntryBatchPB* batch) const;
 
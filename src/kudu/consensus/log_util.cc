@@ -21,6 +21,9 @@
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -53,6 +56,15 @@ DEFINE_bool(log_force_fsync_all, false,
             "Whether the Log/WAL should explicitly call fsync() after each write.");
 TAG_FLAG(log_force_fsync_all, stable);
 
+DEFINE_bool(log_group_fsync, false,
+            "Whether the WALs of all of the tablets in a WAL directory should be "
+            "synchronized together when --log_force_fsync_all is set: rather than each "
+            "tablet fsyncing its own WAL segment, the tablets which sync concurrently "
+            "share syncs of the whole filesystem of the WAL directory. This is only "
+            "worthwhile when the WAL directory is on a filesystem of its own, and is "
+            "only supported on Linux.");
+TAG_FLAG(log_group_fsync, experimental);
+
 DEFINE_bool(log_preallocate_segments, true,
             "Whether the WAL should preallocate the entire segment before writing to it");
 TAG_FLAG(log_preallocate_segments, advanced);
@@ -102,6 +114,7 @@ const uint32_t kLogSegmentMaxHeaderOrFooterSize = 8 * 1024 * 1024;
 LogOptions::LogOptions()
 : segment_size_mb(FLAGS_log_segment_size_mb),
   force_fsync_all(FLAGS_log_force_fsync_all),
+  group_fsync(FLAGS_log_group_fsync),
   preallocate_segments(FLAGS_log_preallocate_segments),
   async_preallocate_segments(FLAGS_log_async_preallocate_segments) {
 }
@@ -860,6 +873,62 @@ void WritableLogSegment::GoIdle() {
   compress_buf_.shrink_to_fit();
 }
 
+FileSystemSyncer* FileSystemSyncer::Get(Env* env, const string& wal_dir) {
+  static std::mutex lock;
+  static auto* syncers = new std::unordered_map<string, unique_ptr<FileSystemSyncer>>();
+  std::lock_guard<std::mutex> l(lock);
+  auto& syncer = (*syncers)[wal_dir];
+  if (!syncer) {
+    syncer.reset(new FileSystemSyncer(env, wal_dir));
+  }
+  return syncer.get();
+}
+
+FileSystemSyncer::FileSystemSyncer(Env* env, string path)
+    : env_(env),
+      path_(std::move(path)),
+      sync_in_progress_(false),
+      num_started_(0),
+      num_completed_(0),
+      last_failed_(0) {
+}
+
+Status FileSystemSyncer::Sync() {
+  std::unique_lock<std::mutex> l(lock_);
+  // The sync in progress, if any, may have started before the writes to
+  // synchronize were issued: only the next one is guaranteed to cover them.
+  const int64_t needed = num_started_ + 1;
+  while (num_completed_ < needed) {
+    if (sync_in_progress_) {
+      sync_done_.wait(l);
+      continue;
+    }
+    sync_in_progress_ = true;
+    const int64_t sync_num = ++num_started_;
+    l.unlock();
+    Status s = env_->SyncFileSystem(path_);
+    l.lock();
+    sync_in_progress_ = false;
+    num_completed_ = sync_num;
+    if (PREDICT_FALSE(!s.ok())) {
+      last_failed_ = sync_num;
+      last_error_ = s.CloneAndPrepend(Substitute("unable to sync the filesystem of $0", path_));
+    }
+    sync_done_.notify_all();
+  }
+  // A failed sync may have lost writes of its own, which later syncs wouldn't
+  // write: any failure since the needed sync is reported.
+  if (PREDICT_FALSE(last_failed_ >= needed)) {
+    return last_error_;
+  }
+  return Status::OK();
+}
+
+int64_t FileSystemSyncer::num_syncs() const {
+  std::lock_guard<std::mutex> l(lock_);
+  return num_completed_;
+}
+
 bool IsLogFileName(const string& fname) {
   if (HasPrefixString(fname, ".")) {
     // Hidden file or ./..
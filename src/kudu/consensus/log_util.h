@@ -17,9 +17,11 @@
 #pragma once
 
 #include <cstddef>
+#include <condition_variable>
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -65,6 +67,10 @@ struct LogOptions {
   // Whether to call fsync on every call to Append().
   bool force_fsync_all;
 
+  // Whether the fsyncs of 'force_fsync_all' are performed by syncing the
+  // whole filesystem of the WAL, with the syncs of the other tablets.
+  bool group_fsync;
+
   // Whether to fallocate segments before writing to them.
   bool preallocate_segments;
 
@@ -502,6 +508,57 @@ class WritableLogSegment {
   DISALLOW_COPY_AND_ASSIGN(WritableLogSegment);
 };
 
+// Synchronizes the WAL segments of all of the tablets whose WALs are on one
+// filesystem with syncs of the whole filesystem. With many tablets being
+// written at once, this replaces an fsync per tablet with a single sync
+// covering all of them. See --log_group_fsync.
+//
+// A sync requested while another one is in progress waits for the next one,
+// since the writes to synchronize may have been issued after the start of
+// the one in progress. That next sync covers all of the syncs requested in
+// the meantime.
+//
+// This class is thread-safe.
+class FileSystemSyncer {
+ public:
+  // Returns the syncer of the WALs in the directory 'wal_dir', creating it
+  // if needed. Syncers are never destroyed.
+  static FileSystemSyncer* Get(Env* env, const std::string& wal_dir);
+
+  FileSystemSyncer(Env* env, std::string path);
+
+  // Synchronizes the filesystem, returning once all of the writes issued
+  // before the call are durable.
+  //
+  // Returns the error of any sync covering the call which failed.
+  Status Sync();
+
+  // Returns the number of syncs of the filesystem which were performed.
+  int64_t num_syncs() const;
+
+ private:
+  Env* const env_;
+
+  // A path on the filesystem to synchronize.
+  const std::string path_;
+
+  mutable std::mutex lock_;
+  std::condition_variable sync_done_;
+
+  // Whether a sync is in progress.
+  bool sync_in_progress_;
+
+  // The number of syncs which were started and completed.
+  int64_t num_started_;
+  int64_t num_completed_;
+
+  // The number of the last sync which failed, or 0, and its error.
+  int64_t last_failed_;
+  Status last_error_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileSystemSyncer);
+};
+
 // Checks if 'fname' is a correctly formatted name of log segment file.
 bool IsLogFileName(const std::string& fname);
 
@@ -34,6 +34,7 @@
 
 #include "kudu/clock/clock.h"
 #include "kudu/common/row_operations.pb.h"
+#include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/common/wire_protocol-test-util.h"
 #include "kudu/consensus/consensus.pb.h"
@@ -43,6 +44,7 @@
 #include "kudu/consensus/log_reader.h"
 #include "kudu/consensus/log_util.h"
 #include "kudu/consensus/opid.pb.h"
+#include "kudu/consensus/opid_util.h"
 #include "kudu/consensus/ref_counted_replicate.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -62,19 +64,28 @@ DEFINE_int32(num_reader_threads, 1, "Number of threads accessing the log while w
 DEFINE_int32(num_batches_per_thread, 2000, "Number of batches per thread");
 DEFINE_int32(num_ops_per_batch_avg, 5, "Target average number of ops per batch");
 DEFINE_bool(verify_log, true, "Whether to verify the log by reading it after the writes complete");
+DEFINE_int32(num_logs, 100, "Number of logs appended to by TestManyLogs");
+DEFINE_int32(num_rounds_per_log, 20,
+             "Number of rounds of appends to each log by TestManyLogs");
+DEFINE_int32(num_shared_append_threads, 4,
+             "Number of threads of the shared append pool in TestManyLogs");
 
 DECLARE_int32(log_thread_idle_threshold_ms);
 DECLARE_int32(log_inject_thread_lifecycle_latency_ms);
+DECLARE_int32(log_append_pool_num_threads);
 
 using kudu::consensus::OpId;
 using kudu::consensus::ReplicateRefPtr;
 using kudu::consensus::ReplicateMsg;
 using kudu::consensus::WRITE_OP;
 using kudu::consensus::make_scoped_refptr_replicate;
+using kudu::consensus::MakeOpId;
 using std::map;
 using std::shared_ptr;
+using std::string;
 using std::thread;
 using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace log {
@@ -200,6 +211,46 @@ class MultiThreadedLogTest : public LogTestBase {
     }
   }
 
+  // Appends FLAGS_num_rounds_per_log no-ops to each log of 'logs', one per
+  // log and per round, from FLAGS_num_writer_threads threads each appending
+  // to a slice of the logs.
+  void AppendToLogs(const vector<scoped_refptr<Log>>& logs) {
+    vector<thread> writers;
+    for (int t = 0; t < FLAGS_num_writer_threads; t++) {
+      writers.emplace_back([&, t]() {
+        vector<size_t> slice;
+        for (size_t i = t; i < logs.size(); i += FLAGS_num_writer_threads) {
+          slice.push_back(i);
+        }
+        for (int round = 0; round < FLAGS_num_rounds_per_log; round++) {
+          CountDownLatch latch(slice.size());
+          vector<Status> errors;
+          simple_spinlock errors_lock;
+          for (size_t i : slice) {
+            ReplicateRefPtr replicate = make_scoped_refptr_replicate(new ReplicateMsg());
+            *replicate->get()->mutable_id() = MakeOpId(1, round + 1);
+            replicate->get()->set_op_type(consensus::NO_OP);
+            replicate->get()->mutable_noop_request();
+            replicate->get()->set_timestamp(clock_->Now().ToUint64());
+            CHECK_OK(logs[i]->AsyncAppendReplicates(
+                { replicate }, [&](const Status& s) {
+                  if (!s.ok()) {
+                    std::lock_guard<simple_spinlock> l(errors_lock);
+                    errors.push_back(s);
+                  }
+                  latch.CountDown();
+                }));
+          }
+          latch.Wait();
+          CHECK(errors.empty()) << errors.front().ToString();
+        }
+      });
+    }
+    for (auto& t : writers) {
+      t.join();
+    }
+  }
+
   void VerifyLog() {
     shared_ptr<LogReader> reader;
     ASSERT_OK(LogReader::Open(fs_manager_.get(),
@@ -261,5 +312,31 @@ TEST_F(MultiThreadedLogTest, TestAppendThreadStartStopRaces) {
   NO_FATALS(VerifyLog());
 }
 
+// Appends to many logs, as on a server hosting many tablets, with an appender
+// thread per log and then with a pool shared by the logs. Meant to measure the
+// scalability of the appends with the number of tablets, e.g. with
+// --num_logs=10000.
+TEST_F(MultiThreadedLogTest, TestManyLogs) {
+  Schema schema_with_ids = SchemaBuilder(schema_).Build();
+  for (int num_pool_threads : { 0, FLAGS_num_shared_append_threads }) {
+    FLAGS_log_append_pool_num_threads = num_pool_threads;
+    vector<scoped_refptr<Log>> logs(FLAGS_num_logs);
+    for (int i = 0; i < logs.size(); i++) {
+      ASSERT_OK(Log::Open(options_, fs_manager_.get(), file_cache_.get(),
+                          Substitute("tablet-$0-$1", num_pool_threads, i),
+                          schema_with_ids, 0, metric_entity_tablet_.get(), &logs[i]));
+    }
+    const string mode = num_pool_threads == 0 ?
+        "an appender thread per log" : Substitute("$0 shared appender threads", num_pool_threads);
+    LOG_TIMING(INFO, Substitute("appending $0 rounds to $1 logs with $2",
+                                FLAGS_num_rounds_per_log, logs.size(), mode)) {
+      NO_FATALS(AppendToLogs(logs));
+    }
+    for (auto& log : logs) {
+      ASSERT_OK(log->Close());
+    }
+  }
+}
+
 } // namespace log
 } // namespace kudu
@@ -93,6 +93,10 @@ static void AddPeer(RaftConfigPB* config,
         attrs_pb->set_promote(attr.second);
       } else if (attr.first == "REPLACE") {
         attrs_pb->set_replace(attr.second);
+      } else if (attr.first == "WITNESS") {
+        attrs_pb->set_witness(attr.second);
+      } else if (attr.first == "READ_REPLICA") {
+        attrs_pb->set_read_replica(attr.second);
       } else {
         FAIL() << attr.first << ": unexpected attribute to set";
       }
@@ -326,6 +330,51 @@ TEST(QuorumUtilTest, TestIsRaftConfigVoter) {
   ASSERT_FALSE(ReplicaTypesEqual(*peer_b, *peer_c));
 }
 
+TEST(QuorumUtilTest, TestWitnesses) {
+  RaftConfigPB config;
+  config.set_opid_index(1);
+  AddPeer(&config, "A", V);
+  AddPeer(&config, "B", V);
+  AddPeer(&config, "C", V, std::nullopt, {{"WITNESS", true}});
+  ASSERT_OK(VerifyRaftConfig(config));
+
+  // Witnesses are voters.
+  ASSERT_TRUE(IsRaftConfigVoter("C", config));
+  ASSERT_FALSE(IsRaftConfigWitness("A", config));
+  ASSERT_TRUE(IsRaftConfigWitness("C", config));
+  ASSERT_FALSE(IsRaftConfigWitness("D", config));
+  ASSERT_EQ(3, CountVoters(config));
+  ASSERT_EQ(1, CountWitnesses(config));
+  ASSERT_EQ(2, MajoritySize(CountVoters(config)));
+
+  RaftPeerPB* peer_a;
+  ASSERT_OK(GetRaftConfigMember(&config, "A", &peer_a));
+  RaftPeerPB* peer_c;
+  ASSERT_OK(GetRaftConfigMember(&config, "C", &peer_c));
+  ASSERT_FALSE(ReplicaTypesEqual(*peer_a, *peer_c));
+
+  // Only voters may be witnesses.
+  {
+    RaftConfigPB bad_config(config);
+    AddPeer(&bad_config, "D", N, std::nullopt, {{"WITNESS", true}});
+    Status s = VerifyRaftConfig(bad_config);
+    ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+    ASSERT_STR_CONTAINS(s.ToString(), "is a witness but not a VOTER");
+  }
+
+  // Some voter must not be a witness.
+  {
+    RaftConfigPB bad_config;
+    bad_config.set_opid_index(1);
+    AddPeer(&bad_config, "A", V, std::nullopt, {{"WITNESS", true}});
+    AddPeer(&bad_config, "B", V, std::nullopt, {{"WITNESS", true}});
+    AddPeer(&bad_config, "C", N);
+    Status s = VerifyRaftConfig(bad_config);
+    ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+    ASSERT_STR_CONTAINS(s.ToString(), "at least one VOTER which isn't a witness");
+  }
+}
+
 // Verify basic functionality of the kudu::consensus::ShouldAddReplica() utility
 // function.
 TEST(QuorumUtilTest, ShouldAddReplica) {
@@ -872,6 +921,47 @@ TEST(QuorumUtilTest, ShouldEvictReplicaVoters) {
 
 // Verify logic of the kudu::consensus::ShouldEvictReplica(), anticipating
 // removal of a non-voter replica.
+// Verify that the read replicas are evicted only if failed or marked for
+// replacement, not as excess replicas.
+TEST(QuorumUtilTest, ShouldEvictReplicaReadReplicas) {
+  {
+    RaftConfigPB config;
+    AddPeer(&config, "A", V, '+');
+    AddPeer(&config, "B", V, '+');
+    AddPeer(&config, "C", V, '+');
+    AddPeer(&config, "D", N, '+', {{"READ_REPLICA", true}});
+    AddPeer(&config, "E", N, '?', {{"READ_REPLICA", true}});
+    EXPECT_FALSE(ShouldEvictReplica(config, "A", 3));
+
+    // Another non-voter is still evicted as an excess replica.
+    AddPeer(&config, "F", N, '+');
+    string to_evict;
+    ASSERT_TRUE(ShouldEvictReplica(config, "A", 3, &to_evict));
+    EXPECT_EQ("F", to_evict);
+  }
+  for (const auto& health : { '-', 'x' }) {
+    SCOPED_TRACE(health);
+    RaftConfigPB config;
+    AddPeer(&config, "A", V, '+');
+    AddPeer(&config, "B", V, '+');
+    AddPeer(&config, "C", V, '+');
+    AddPeer(&config, "D", N, health, {{"READ_REPLICA", true}});
+    string to_evict;
+    ASSERT_TRUE(ShouldEvictReplica(config, "A", 3, &to_evict));
+    EXPECT_EQ("D", to_evict);
+  }
+  {
+    RaftConfigPB config;
+    AddPeer(&config, "A", V, '+');
+    AddPeer(&config, "B", V, '+');
+    AddPeer(&config, "C", V, '+');
+    AddPeer(&config, "D", N, '+', {{"READ_REPLICA", true}, {"REPLACE", true}});
+    string to_evict;
+    ASSERT_TRUE(ShouldEvictReplica(config, "A", 3, &to_evict));
+    EXPECT_EQ("D", to_evict);
+  }
+}
+
 TEST(QuorumUtilTest, ShouldEvictReplicaNonVoters) {
   {
     RaftConfigPB config;
@@ -68,6 +68,20 @@ bool IsRaftConfigVoter(const std::string& uuid, const RaftConfigPB& config) {
   return false;
 }
 
+bool IsWitness(const RaftPeerPB& peer) {
+  return peer.member_type() == RaftPeerPB::VOTER &&
+      peer.has_attrs() && peer.attrs().witness();
+}
+
+bool IsRaftConfigWitness(const std::string& uuid, const RaftConfigPB& config) {
+  for (const RaftPeerPB& peer : config.peers()) {
+    if (peer.permanent_uuid() == uuid) {
+      return IsWitness(peer);
+    }
+  }
+  return false;
+}
+
 bool IsVoterRole(RaftPeerPB::Role role) {
   return role == RaftPeerPB::LEADER || role == RaftPeerPB::FOLLOWER;
 }
@@ -109,7 +123,8 @@ bool RemoveFromRaftConfig(RaftConfigPB* config, const string& uuid) {
 bool ReplicaTypesEqual(const RaftPeerPB& peer1, const RaftPeerPB& peer2) {
   // TODO(mpercy): Include comparison of replica intentions once they are
   // implemented.
-  return peer1.member_type() == peer2.member_type();
+  return peer1.member_type() == peer2.member_type() &&
+      IsWitness(peer1) == IsWitness(peer2);
 }
 
 int CountVoters(const RaftConfigPB& config) {
@@ -122,6 +137,16 @@ int CountVoters(const RaftConfigPB& config) {
   return voters;
 }
 
+int CountWitnesses(const RaftConfigPB& config) {
+  int witnesses = 0;
+  for (const RaftPeerPB& peer : config.peers()) {
+    if (IsWitness(peer)) {
+      witnesses++;
+    }
+  }
+  return witnesses;
+}
+
 int MajoritySize(int num_voters) {
   DCHECK_GE(num_voters, 1);
   return (num_voters / 2) + 1;
@@ -217,6 +242,20 @@ Status VerifyRaftConfig(const RaftConfigPB& config) {
           Substitute("Peer: $0 has no member type set. RaftConfig: $1", peer.permanent_uuid(),
                      SecureShortDebugString(config)));
     }
+    if (peer.has_attrs() && peer.attrs().witness() &&
+        peer.member_type() != RaftPeerPB::VOTER) {
+      return Status::IllegalState(
+          Substitute("Peer: $0 is a witness but not a VOTER. RaftConfig: $1",
+                     peer.permanent_uuid(), SecureShortDebugString(config)));
+    }
+  }
+
+  // Some voter must be able to become the leader.
+  const int num_voters = CountVoters(config);
+  if (num_voters > 0 && CountWitnesses(config) == num_voters) {
+    return Status::IllegalState(
+        Substitute("RaftConfig must have at least one VOTER which isn't a witness. "
+                   "RaftConfig: $0", SecureShortDebugString(config)));
   }
 
   return Status::OK();
@@ -648,6 +687,11 @@ bool ShouldEvictReplica(const RaftConfigPB& config,
       case RaftPeerPB::NON_VOTER:
         DCHECK_NE(peer_uuid, leader_uuid) << peer_uuid
             << ": non-voter as a leader; " << SecureShortDebugString(config);
+        if (peer.attrs().read_replica() && !peer.attrs().promote() &&
+            !has_replace && !failed && !failed_unrecoverable) {
+          // A read replica in service is never an excess replica.
+          break;
+        }
         pq_non_voters.emplace(peer_to_elem(peer));
         ++num_non_voters_total;
         has_non_voter_failed |= failed;
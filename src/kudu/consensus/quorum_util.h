@@ -34,6 +34,11 @@ enum RaftConfigState {
 bool IsRaftConfigMember(const std::string& uuid, const RaftConfigPB& config);
 bool IsRaftConfigVoter(const std::string& uuid, const RaftConfigPB& config);
 
+// Whether the specified peer is a witness voter, which never starts leader
+// elections (see RaftPeerAttrsPB.witness).
+bool IsWitness(const RaftPeerPB& peer);
+bool IsRaftConfigWitness(const std::string& uuid, const RaftConfigPB& config);
+
 // Whether the specified Raft role is attributed to a peer which can participate
 // in leader elections.
 bool IsVoterRole(RaftPeerPB::Role role);
@@ -62,6 +67,9 @@ bool ReplicaTypesEqual(const RaftPeerPB& peer1, const RaftPeerPB& peer2);
 // Counts the number of voters in the configuration.
 int CountVoters(const RaftConfigPB& config);
 
+// Counts the number of witnesses in the configuration. They are voters too.
+int CountWitnesses(const RaftConfigPB& config);
+
 // Calculates size of a configuration majority based on # of voters.
 int MajoritySize(int num_voters);
 
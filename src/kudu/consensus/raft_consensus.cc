@@ -40,6 +40,7 @@
 #include "kudu/consensus/consensus_meta_manager.h"
 #include "kudu/consensus/consensus_peers.h"
 #include "kudu/consensus/leader_election.h"
+#include "kudu/consensus/leader_liveness_tracker.h"
 #include "kudu/consensus/log.h"
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/consensus/opid_util.h"
@@ -125,6 +126,16 @@ DEFINE_bool(raft_enable_tombstoned_voting, true,
 TAG_FLAG(raft_enable_tombstoned_voting, experimental);
 TAG_FLAG(raft_enable_tombstoned_voting, runtime);
 
+DEFINE_bool(raft_propagate_leader_server_failure, true,
+            "When enabled, once a replica detects the failure of its leader, "
+            "and none of the replicas on this server heard from the server "
+            "of the leader within the minimum election timeout, the other "
+            "replicas led by that server start their leader elections right "
+            "away rather than waiting for their own failure detectors to "
+            "expire.");
+TAG_FLAG(raft_propagate_leader_server_failure, advanced);
+TAG_FLAG(raft_propagate_leader_server_failure, runtime);
+
 // Enable improved re-replication (KUDU-1097).
 DEFINE_bool(raft_prepare_replacement_before_eviction, true,
             "When enabled, failed replicas will only be evicted after a "
@@ -132,6 +143,32 @@ DEFINE_bool(raft_prepare_replacement_before_eviction, true,
 TAG_FLAG(raft_prepare_replacement_before_eviction, advanced);
 TAG_FLAG(raft_prepare_replacement_before_eviction, experimental);
 
+DEFINE_bool(raft_enable_leader_leases, false,
+            "Whether leaders hold leases, letting them serve reads of the latest "
+            "data which can't miss writes accepted by a newer leader. With leases, "
+            "a leader which doesn't hold one rejects READ_LATEST scans and "
+            "READ_AT_SNAPSHOT scans without a snapshot timestamp. This must be "
+            "set on all the tablet servers, since it also makes the replicas "
+            "restarting within a term withhold their votes for the minimum "
+            "election timeout.");
+TAG_FLAG(raft_enable_leader_leases, experimental);
+
+DEFINE_double(raft_leader_lease_fraction, 0.8,
+              "The duration of the leader lease, as a fraction of the minimum "
+              "election timeout. The remainder of the timeout accounts for the "
+              "differences between the clock rates of the servers.");
+TAG_FLAG(raft_leader_lease_fraction, experimental);
+
+static bool ValidateLeaderLeaseFraction(const char* flagname, double value) {
+  if (value <= 0 || value >= 1) {
+    LOG(ERROR) << strings::Substitute("$0 must be in the range (0, 1), value $1 is invalid",
+                                      flagname, value);
+    return false;
+  }
+  return true;
+}
+DEFINE_validator(raft_leader_lease_fraction, &ValidateLeaderLeaseFraction);
+
 DECLARE_int32(memory_limit_warn_threshold_percentage);
 
 // Metrics
@@ -330,6 +367,16 @@ Status RaftConsensus::Start(const ConsensusBootstrapInfo& info,
       MinimumElectionTimeout(),
       opts);
 
+  if (server_ctx_.leader_liveness) {
+    server_ctx_.leader_liveness->RegisterReplica(
+        options_.tablet_id,
+        [w](const string& leader_uuid) {
+          if (auto consensus = w.lock()) {
+            consensus->ReportLeaderServerFailed(leader_uuid);
+          }
+        });
+  }
+
   {
     ThreadRestrictions::AssertWaitAllowed();
     LockGuard l(lock_);
@@ -390,6 +437,13 @@ Status RaftConsensus::Start(const ConsensusBootstrapInfo& info,
     // Now assume non-leader replica duties.
     RETURN_NOT_OK(BecomeReplicaUnlocked(fd_initial_delta));
 
+    // This replica may have accepted a request from a leader holding a lease
+    // right before restarting: keep the promise it made not to vote for
+    // anyone else for a while.
+    if (FLAGS_raft_enable_leader_leases && CurrentTermUnlocked() > 0) {
+      WithholdVotes();
+    }
+
     SetStateUnlocked(kRunning);
   }
 
@@ -488,6 +542,12 @@ Status RaftConsensus::StartElection(ElectionMode mode, ElectionReason reason) {
                                   "a non-participant in the Raft config",
                                   SecureShortDebugString(cmeta_->ActiveConfig()));
     }
+    if (PREDICT_FALSE(IsRaftConfigWitness(peer_uuid(), cmeta_->ActiveConfig()))) {
+      // A witness only votes for the other voters.
+      SnoozeFailureDetector();
+      return Status::IllegalState("Not starting election: node is a witness",
+                                  SecureShortDebugString(cmeta_->ActiveConfig()));
+    }
     LOG_WITH_PREFIX_UNLOCKED(INFO)
         << "Starting " << mode_str
         << " (" << ReasonString(reason, GetLeaderUuidUnlocked()) << ")";
@@ -629,6 +689,13 @@ Status RaftConsensus::TransferLeadership(const optional<string>& new_leader_uuid
                                      << "because " << msg;
       return Status::InvalidArgument(msg);
     }
+    if (IsRaftConfigWitness(*new_leader_uuid, cmeta_->ActiveConfig())) {
+      const string msg = Substitute("tablet server $0 is a witness in the active config",
+                                    *new_leader_uuid);
+      LOG_WITH_PREFIX_UNLOCKED(INFO) << "Rejecting request to transfer leadership "
+                                     << "because " << msg;
+      return Status::InvalidArgument(msg);
+    }
   }
   return BeginLeaderTransferPeriodUnlocked(new_leader_uuid);
 }
@@ -661,6 +728,17 @@ scoped_refptr<ConsensusRound> RaftConsensus::NewRound(
 }
 
 void RaftConsensus::ReportFailureDetectedTask() {
+  if (server_ctx_.leader_liveness && FLAGS_raft_propagate_leader_server_failure) {
+    string leader_uuid;
+    {
+      LockGuard l(lock_);
+      leader_uuid = GetLeaderUuidUnlocked();
+    }
+    if (!leader_uuid.empty()) {
+      server_ctx_.leader_liveness->ReportLeaderFailure(
+          options_.tablet_id, leader_uuid, MinimumElectionTimeout());
+    }
+  }
   Status s = StartElection(FLAGS_raft_enable_pre_election ?
       PRE_ELECTION : NORMAL_ELECTION, ELECTION_TIMEOUT_EXPIRED);
   if (PREDICT_FALSE(!s.ok())) {
@@ -686,6 +764,21 @@ void RaftConsensus::ReportFailureDetected() {
   }
 }
 
+void RaftConsensus::ReportLeaderServerFailed(const string& leader_uuid) {
+  {
+    LockGuard l(lock_);
+    // Only the replicas still following the failed leader, and running
+    // the failure detector, start an election.
+    if (state_ != kRunning || GetLeaderUuidUnlocked() != leader_uuid ||
+        !failure_detector_->started()) {
+      return;
+    }
+  }
+  LOG_WITH_PREFIX(INFO) << "Server of leader " << leader_uuid
+                        << " failed for other tablets: starting an election early";
+  ReportFailureDetected();
+}
+
 Status RaftConsensus::BecomeLeaderUnlocked() {
   DCHECK(lock_.is_locked());
 
@@ -699,6 +792,7 @@ Status RaftConsensus::BecomeLeaderUnlocked() {
 
   // Don't vote for anyone if we're a leader.
   withhold_votes_until_ = MonoTime::Max();
+  leader_since_ = MonoTime::Now();
 
   // Leadership never starts in a transfer period.
   EndLeaderTransferPeriod();
@@ -1067,10 +1161,11 @@ void RaftConsensus::TryStartElectionOnPeerTask(const string& peer_uuid) {
   ThreadRestrictions::AssertWaitAllowed();
   LockGuard l(lock_);
   // Double-check that the peer is a voter in the active config.
-  if (!IsRaftConfigVoter(peer_uuid, cmeta_->ActiveConfig())) {
+  if (!IsRaftConfigVoter(peer_uuid, cmeta_->ActiveConfig()) ||
+      IsRaftConfigWitness(peer_uuid, cmeta_->ActiveConfig())) {
     LOG_WITH_PREFIX_UNLOCKED(INFO) << "Not signalling peer " << peer_uuid
                                    << "to start an election: it's not a voter "
-                                   << "in the active config.";
+                                   << "which can lead in the active config.";
     return;
   }
   LOG_WITH_PREFIX_UNLOCKED(INFO) << "Signalling peer " << peer_uuid
@@ -1490,8 +1585,20 @@ Status RaftConsensus::UpdateReplica(const ConsensusRequestPB* request,
     //   * prohibit voting for anyone for the minimum election timeout
     // We are guaranteed to be acting as a FOLLOWER at this point by the above
     // sanity check.
-    SnoozeFailureDetector();
+    if (request->has_dormant_heartbeat_interval_ms()) {
+      // The leader of a dormant tablet heartbeats less often: it's considered
+      // failed after as many missed heartbeats as usual.
+      SnoozeFailureDetector(string("dormant tablet"), MonoDelta::FromMilliseconds(
+          request->dormant_heartbeat_interval_ms() *
+          FLAGS_leader_failure_max_missed_heartbeat_periods));
+    } else {
+      SnoozeFailureDetector();
+    }
     WithholdVotes();
+    if (server_ctx_.leader_liveness) {
+      server_ctx_.leader_liveness->RecordLeaderContact(options_.tablet_id,
+                                                       request->caller_uuid());
+    }
 
     last_leader_communication_time_micros_ = GetMonoTimeMicros();
 
@@ -2238,6 +2345,10 @@ void RaftConsensus::Stop() {
     LOG_WITH_PREFIX_UNLOCKED(INFO) << "Raft consensus shutting down.";
   }
 
+  if (server_ctx_.leader_liveness) {
+    server_ctx_.leader_liveness->UnregisterReplica(options_.tablet_id);
+  }
+
   // Close the peer manager.
   if (peer_manager_) peer_manager_->Close();
 
@@ -2473,6 +2584,35 @@ RaftPeerPB::Role RaftConsensus::role() const {
   return cmeta_->active_role();
 }
 
+bool RaftConsensus::HasLeaderLease() const {
+  if (!FLAGS_raft_enable_leader_leases) {
+    return false;
+  }
+  MonoTime leader_since;
+  {
+    ThreadRestrictions::AssertWaitAllowed();
+    LockGuard l(lock_);
+    if (state_ != kRunning || cmeta_->active_role() != RaftPeerPB::LEADER ||
+        !leader_is_ready_) {
+      return false;
+    }
+    leader_since = leader_since_;
+  }
+  // Until the leader commits an op of its own term, it may not know about
+  // all the ops committed by its predecessors.
+  if (!queue_->IsCommittedIndexInCurrentTerm()) {
+    return false;
+  }
+  const MonoDelta lease_duration = LeaderLeaseDuration();
+  const MonoTime now = MonoTime::Now();
+  // The lease of the previous leader may have been ignored by the voters if
+  // the election was forced, e.g. when transferring the leadership.
+  if (now < leader_since + lease_duration) {
+    return false;
+  }
+  return now < queue_->GetMajorityAckedRequestTime() + lease_duration;
+}
+
 RaftConsensus::RoleAndMemberType RaftConsensus::GetRoleAndMemberType() const {
   ThreadRestrictions::AssertWaitAllowed();
 
@@ -2546,6 +2686,11 @@ MonoDelta RaftConsensus::MinimumElectionTimeout() {
   return MonoDelta::FromMilliseconds(failure_timeout);
 }
 
+MonoDelta RaftConsensus::LeaderLeaseDuration() {
+  return MonoDelta::FromNanoseconds(static_cast<int64_t>(
+      MinimumElectionTimeout().ToNanoseconds() * FLAGS_raft_leader_lease_fraction));
+}
+
 void RaftConsensus::SetLeaderUuidUnlocked(const string& uuid) {
   DCHECK(lock_.is_locked());
   failed_elections_since_stable_leader_ = 0;
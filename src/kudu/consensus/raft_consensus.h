@@ -67,6 +67,8 @@ namespace consensus {
 class ConsensusMetadataManager;
 class ConsensusRound;
 class ConsensusRoundHandler;
+class HeartbeatCoalescer;
+class LeaderLivenessTracker;
 class PeerManager;
 class PeerProxyFactory;
 class PendingRounds;
@@ -90,6 +92,14 @@ struct ServerContext {
   // Shared boolean indicating whether Raft consensus should continue sending request messages
   // even if a peer is considered as failed.
   const bool* allow_status_msg_for_failed_peer = nullptr;
+
+  // Tracks the liveness of the leaders of the replicas hosted on the server,
+  // if the failures of the leader servers should be propagated among them.
+  LeaderLivenessTracker* leader_liveness = nullptr;
+
+  // Coalesces the heartbeats sent by the leaders hosted by the server into
+  // a single RPC per destination server, if set.
+  HeartbeatCoalescer* heartbeat_coalescer = nullptr;
 };
 
 struct ConsensusOptions {
@@ -326,6 +336,20 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   // Returns the current Raft role of this instance.
   RaftPeerPB::Role role() const;
 
+  // Returns whether this replica is the leader and holds a leader lease, in
+  // which case no other replica may have been elected leader: the reads
+  // served locally can't miss any write accepted by a newer leader.
+  //
+  // The lease is renewed by the requests acknowledged by a majority of the
+  // voters, who don't vote for another candidate for the minimum election
+  // timeout after accepting a request from the leader. It lasts for a
+  // fraction of that timeout past the time the requests were sent. A new
+  // leader only acquires a lease after waiting for as long, which covers the
+  // lease of the previous leader in case the election ignored it.
+  //
+  // Always returns false unless --raft_enable_leader_leases is set.
+  bool HasLeaderLease() const;
+
   // Returns the current Raft role and member type of this instance.
   // May return <UNKNOWN_ROLE, UNKNOWN_MEMBER_TYPE> if the information is not available.
   RoleAndMemberType GetRoleAndMemberType() const;
@@ -487,6 +511,9 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   // jitter, election timeouts may be longer than this.
   static MonoDelta MinimumElectionTimeout();
 
+  // Return the duration of the leader lease.
+  static MonoDelta LeaderLeaseDuration();
+
   // Initializes the RaftConsensus object, including loading the consensus
   // metadata.
   Status Init();
@@ -746,6 +773,11 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   // being shut down).
   void ReportFailureDetectedTask();
 
+  // Called when the server of 'leader_uuid' is found to have failed while
+  // leading other tablets (see LeaderLivenessTracker). Starts an election
+  // right away if the replica still follows 'leader_uuid'.
+  void ReportLeaderServerFailed(const std::string& leader_uuid);
+
   // Handle the completion of replication of a config change operation.
   // If 'status' is OK, this takes care of persisting the new configuration
   // to disk as the committed configuration. A non-OK status indicates that
@@ -920,6 +952,10 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   // disturbing the healthy leader.
   std::atomic<MonoTime> withhold_votes_until_;
 
+  // The time at which this replica last became the leader. Protected by
+  // 'lock_'.
+  MonoTime leader_since_;
+
   // The last OpId received from the current leader. This is updated whenever the follower
   // accepts operations from a leader, and passed back so that the leader knows from what
   // point to continue sending operations.
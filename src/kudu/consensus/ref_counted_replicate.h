@@ -16,13 +16,23 @@
 // under the License.
 #pragma once
 
+#include <memory>
+#include <mutex>
+
 #include "kudu/consensus/consensus.pb.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/pb_util.h"
+#include "kudu/util/slice.h"
 
 namespace kudu {
 namespace consensus {
 
 // A simple ref-counted wrapper around ReplicateMsg.
+//
+// The message is serialized at most once, the first time serialized() is
+// called, and the serialized form is then shared by all of its users: the WAL
+// appends it as is and the log cache uses it to size the consensus requests.
 class RefCountedReplicate : public RefCountedThreadSafe<RefCountedReplicate> {
  public:
   explicit RefCountedReplicate(ReplicateMsg* msg) : msg_(msg) {}
@@ -31,8 +41,21 @@ class RefCountedReplicate : public RefCountedThreadSafe<RefCountedReplicate> {
     return msg_.get();
   }
 
+  // Returns the serialized message.
+  //
+  // The message must not be modified once this has been called.
+  Slice serialized() {
+    std::call_once(serialize_once_, [this]() {
+      pb_util::AppendToString(*msg_, &serialized_);
+    });
+    return Slice(serialized_);
+  }
+
  private:
   std::unique_ptr<ReplicateMsg> msg_;
+
+  std::once_flag serialize_once_;
+  faststring serialized_;
 };
 
 typedef scoped_refptr<RefCountedReplicate> ReplicateRefPtr;
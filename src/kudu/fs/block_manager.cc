@@ -20,7 +20,10 @@
 #include <gflags/gflags.h>
 
 #include "kudu/gutil/macros.h"
+#include "kudu/util/array_view.h"
+#include "kudu/util/env.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/status.h"
 
 // The default value is optimized for throughput in the case that
 // there are multiple drives backing the tablet. By asynchronously
@@ -46,6 +49,13 @@ TAG_FLAG(block_manager_preflush_control, experimental);
 namespace kudu {
 namespace fs {
 
+Status ReadableBlock::ReadVBatch(ArrayView<const ReadVRequest> requests) const {
+  for (const auto& r : requests) {
+    RETURN_NOT_OK(ReadV(r.offset, r.results));
+  }
+  return Status::OK();
+}
+
 BlockManagerOptions::BlockManagerOptions()
   : read_only(false) {}
 
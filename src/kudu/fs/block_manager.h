@@ -32,6 +32,7 @@ namespace kudu {
 class BlockId;
 class MemTracker;
 class Slice;
+struct ReadVRequest;
 template <typename T>
 class ArrayView;
 
@@ -163,16 +164,39 @@ class ReadableBlock : public Block {
   // If an error was encountered, returns a non-OK status.
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const = 0;
 
+  // Performs each of 'requests', whose offsets are relative to the beginning
+  // of the block, as ReadV() would. The reads may be issued concurrently: see
+  // RandomAccessFile::ReadVBatch().
+  //
+  // The default implementation calls ReadV() for each request in turn.
+  virtual Status ReadVBatch(ArrayView<const ReadVRequest> requests) const;
+
   // Returns the memory usage of this object including the object itself.
   virtual size_t memory_footprint() const = 0;
+
+  // Returns the offset of this block's data within the block identified by
+  // id(). It's only non-zero for blocks which are a window onto a part of a
+  // larger block, such as the columns of a column group.
+  virtual uint64_t offset_in_block() const { return 0; }
+};
+
+// The storage tiers of the data directories. The directories listed in
+// --fs_cold_data_dirs form the cold tier, e.g. large HDDs, and the others form
+// the hot tier, e.g. SSDs.
+enum class StorageTier {
+  HOT,
+  COLD,
 };
 
 // Provides options and hints for block placement. This is used for identifying
-// the correct DataDirGroups to place blocks. In the future this may also be
-// used to specify directories based on block type (e.g. to prefer bloom block
-// placement into SSD-backed directories).
+// the correct DataDirGroups to place blocks, and the tier of the directories
+// within the group to prefer.
 struct CreateBlockOptions {
   const std::string tablet_id;
+
+  // If there are data directories of this tier, the block is placed in one of
+  // them, adding one to the tablet's DataDirGroup if necessary.
+  const StorageTier tier = StorageTier::HOT;
 };
 
 // Block manager creation options.
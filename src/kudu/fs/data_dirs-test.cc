@@ -62,10 +62,12 @@ DECLARE_bool(crash_on_eio);
 DECLARE_double(env_inject_eio);
 DECLARE_double(env_inject_full);
 DECLARE_int32(fs_data_dirs_available_space_cache_seconds);
+DECLARE_int32(fs_data_dirs_max_per_loaded_tablet);
 DECLARE_int32(fs_target_data_dirs_per_tablet);
 DECLARE_int64(disk_reserved_bytes_free_for_testing);
 DECLARE_int64(fs_data_dirs_reserved_bytes);
 DECLARE_string(env_inject_eio_globs);
+DECLARE_string(fs_cold_data_dirs);
 DECLARE_string(env_inject_full_globs);
 
 METRIC_DECLARE_gauge_uint64(data_dirs_failed);
@@ -351,6 +353,111 @@ TEST_F(DataDirsTest, TestFailedDirNotAddedToGroup) {
   ASSERT_TRUE(s.IsIOError()) << s.ToString();
 }
 
+TEST_F(DataDirsTest, TestStorageTiers) {
+  // Reopen the directories with the first half of them on the cold tier.
+  vector<string> dir_names;
+  for (const auto& name : GetDirNames(kNumDirs)) {
+    string canonicalized;
+    ASSERT_OK(env_->Canonicalize(name, &canonicalized));
+    dir_names.emplace_back(std::move(canonicalized));
+  }
+  FLAGS_fs_cold_data_dirs = JoinStrings(
+      vector<string>(dir_names.begin(), dir_names.begin() + kNumDirs / 2), ",");
+  ASSERT_OK(DataDirManager::OpenExistingForTests(env_, dir_names, DataDirManagerOptions(),
+                                                 &dd_manager_));
+  ASSERT_TRUE(dd_manager_->has_cold_tier());
+
+  // New groups are made of hot directories.
+  FLAGS_fs_target_data_dirs_per_tablet = 3;
+  ASSERT_OK(dd_manager_->CreateDataDirGroup(test_tablet_name_));
+  const auto& group = FindOrDie(dd_manager_->group_by_tablet_map_, test_tablet_name_);
+  ASSERT_EQ(3, group.uuid_indices().size());
+  for (int uuid_idx : group.uuid_indices()) {
+    ASSERT_EQ(StorageTier::HOT,
+              dd_manager_->GetDirTier(dd_manager_->FindDirByUuidIndex(uuid_idx)));
+  }
+  Dir* dd = nullptr;
+  ASSERT_OK(dd_manager_->GetDirAddIfNecessary(test_block_opts_, &dd));
+  ASSERT_EQ(StorageTier::HOT, dd_manager_->GetDirTier(dd));
+
+  // Cold blocks get a cold directory added to the group, which is used for
+  // the later cold blocks too.
+  const CreateBlockOptions cold_opts({ test_tablet_name_, StorageTier::COLD });
+  ASSERT_OK(dd_manager_->GetDirAddIfNecessary(cold_opts, &dd));
+  ASSERT_EQ(StorageTier::COLD, dd_manager_->GetDirTier(dd));
+  ASSERT_EQ(StorageTier::COLD, dd_manager_->GetTierOfPath(JoinPathSegments(dd->dir(), "block")));
+  ASSERT_EQ(4, FindOrDie(dd_manager_->group_by_tablet_map_, test_tablet_name_)
+                   .uuid_indices().size());
+  for (int i = 0; i < 10; i++) {
+    Dir* cold_dd = nullptr;
+    ASSERT_OK(dd_manager_->GetDirAddIfNecessary(cold_opts, &cold_dd));
+    ASSERT_EQ(dd, cold_dd);
+    ASSERT_OK(dd_manager_->GetDirAddIfNecessary(test_block_opts_, &dd));
+    ASSERT_EQ(StorageTier::HOT, dd_manager_->GetDirTier(dd));
+    dd = cold_dd;
+  }
+  ASSERT_EQ(4, FindOrDie(dd_manager_->group_by_tablet_map_, test_tablet_name_)
+                   .uuid_indices().size());
+}
+
+// Test that new blocks avoid directories with many I/Os in flight, and that
+// the group of a tablet whose directories are all loaded can grow by a less
+// loaded directory.
+TEST_F(DataDirsTest, TestLoadAwarePlacement) {
+  ASSERT_OK(dd_manager_->CreateDataDirGroup(test_tablet_name_));
+  vector<int> group_indices =
+      FindOrDie(dd_manager_->group_by_tablet_map_, test_tablet_name_).uuid_indices();
+  ASSERT_EQ(FLAGS_fs_target_data_dirs_per_tablet, group_indices.size());
+
+  // Keeps I/Os in flight on the given directory.
+  vector<unique_ptr<Dir::ScopedIo>> ios;
+  const auto load_dir = [&] (Dir* dd) {
+    for (int i = 0; i < 16; i++) {
+      ios.emplace_back(new Dir::ScopedIo(dd));
+    }
+  };
+
+  // Whenever the loaded directory is one of the two candidates, the other one
+  // is selected, so it never receives a block.
+  Dir* loaded_dd = FindOrDie(dd_manager_->dir_by_uuid_idx_, group_indices[0]);
+  load_dir(loaded_dd);
+  ASSERT_EQ(16, loaded_dd->ios_in_flight());
+  for (int i = 0; i < 100; i++) {
+    Dir* dd;
+    ASSERT_OK(dd_manager_->GetDirAddIfNecessary(test_block_opts_, &dd));
+    ASSERT_NE(loaded_dd, dd);
+  }
+
+  // With every directory of the group loaded, the group grows only when
+  // allowed to, and only up to the configured size.
+  for (int i = 1; i < group_indices.size(); i++) {
+    load_dir(FindOrDie(dd_manager_->dir_by_uuid_idx_, group_indices[i]));
+  }
+  Dir* dd;
+  ASSERT_OK(dd_manager_->GetDirAddIfNecessary(test_block_opts_, &dd));
+  ASSERT_EQ(group_indices.size(),
+            FindOrDie(dd_manager_->group_by_tablet_map_, test_tablet_name_)
+                .uuid_indices().size());
+
+  FLAGS_fs_data_dirs_max_per_loaded_tablet = group_indices.size() + 1;
+  ASSERT_OK(dd_manager_->GetDirAddIfNecessary(test_block_opts_, &dd));
+  const vector<int>& new_group_indices =
+      FindOrDie(dd_manager_->group_by_tablet_map_, test_tablet_name_).uuid_indices();
+  ASSERT_EQ(group_indices.size() + 1, new_group_indices.size());
+  ASSERT_EQ(FindOrDie(dd_manager_->dir_by_uuid_idx_, new_group_indices.back()), dd);
+  ASSERT_EQ(0, dd->ios_in_flight());
+
+  load_dir(dd);
+  ASSERT_OK(dd_manager_->GetDirAddIfNecessary(test_block_opts_, &dd));
+  ASSERT_EQ(group_indices.size() + 1,
+            FindOrDie(dd_manager_->group_by_tablet_map_, test_tablet_name_)
+                .uuid_indices().size());
+
+  // The in-flight counts drop as the I/Os complete.
+  ios.clear();
+  ASSERT_EQ(0, loaded_dd->ios_in_flight());
+}
+
 TEST_F(DataDirsTest, TestLoadBalancingDistribution) {
   FLAGS_fs_target_data_dirs_per_tablet = 3;
   const double kNumTablets = 20;
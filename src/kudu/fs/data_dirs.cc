@@ -23,6 +23,7 @@
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <ostream>
 #include <random>
 #include <set>
@@ -46,10 +47,14 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/strings/util.h"
+#include "kudu/util/env.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/random.h"
 #include "kudu/util/status.h"
@@ -109,6 +114,48 @@ DEFINE_bool(fs_data_dirs_consider_available_space, true,
 TAG_FLAG(fs_data_dirs_consider_available_space, runtime);
 TAG_FLAG(fs_data_dirs_consider_available_space, evolving);
 
+DEFINE_bool(fs_data_dirs_consider_load, true,
+            "Whether to consider the load of the disks, estimated from the "
+            "number of block I/Os in flight and their recent latency, when "
+            "selecting a data directory during data block creation. A "
+            "directory whose load exceeds another's by more than "
+            "--fs_data_dirs_load_imbalance_ratio is avoided, regardless of "
+            "available space.");
+TAG_FLAG(fs_data_dirs_consider_load, runtime);
+TAG_FLAG(fs_data_dirs_consider_load, evolving);
+
+DEFINE_double(fs_data_dirs_load_imbalance_ratio, 2.0,
+              "The ratio by which the load of a data directory's disk must "
+              "exceed that of another for the former to be considered more "
+              "loaded when placing data blocks.");
+DEFINE_validator(fs_data_dirs_load_imbalance_ratio,
+                 [](const char* /*n*/, double v) { return v >= 1.0; });
+TAG_FLAG(fs_data_dirs_load_imbalance_ratio, runtime);
+TAG_FLAG(fs_data_dirs_load_imbalance_ratio, advanced);
+TAG_FLAG(fs_data_dirs_load_imbalance_ratio, evolving);
+
+DEFINE_int32(fs_data_dirs_max_per_loaded_tablet, 0,
+             "If positive, when the data directory selected for a new block of "
+             "a tablet is more loaded, per --fs_data_dirs_load_imbalance_ratio, "
+             "than a healthy directory outside the tablet's directory group, "
+             "the latter is added to the group and receives the block, as long "
+             "as the group has fewer than this many directories. The existing "
+             "data of the tablet isn't moved. If 0, load doesn't grow groups.");
+DEFINE_validator(fs_data_dirs_max_per_loaded_tablet,
+                 [](const char* /*n*/, int32_t v) { return v >= 0; });
+TAG_FLAG(fs_data_dirs_max_per_loaded_tablet, runtime);
+TAG_FLAG(fs_data_dirs_max_per_loaded_tablet, experimental);
+
+DEFINE_string(fs_cold_data_dirs, "",
+              "Comma-separated list of the data directories, among those of "
+              "--fs_data_dirs, which form the cold storage tier, e.g. those on "
+              "large but slow disks. The other data directories form the hot "
+              "tier. New data is written to the hot tier, and the rowsets of the "
+              "tables configured with 'kudu.table.cold_data_age_sec' are moved "
+              "to the cold tier as their data ages. If empty, all the data "
+              "directories are treated alike.");
+TAG_FLAG(fs_cold_data_dirs, experimental);
+
 DEFINE_uint64(fs_max_thread_count_per_data_dir, 8,
               "Maximum work thread per data directory.");
 TAG_FLAG(fs_max_thread_count_per_data_dir, advanced);
@@ -222,7 +269,14 @@ DataDirManager::DataDirManager(Env* env,
     : DirManager(env, opts.metric_entity ?
                           unique_ptr<DirMetrics>(new DataDirMetrics(opts.metric_entity)) : nullptr,
                  FLAGS_fs_max_thread_count_per_data_dir,
-                 opts, std::move(canonicalized_data_roots)) {}
+                 opts, std::move(canonicalized_data_roots)) {
+  for (const auto& root : strings::Split(FLAGS_fs_cold_data_dirs, ",", strings::SkipEmpty())) {
+    string path = root.ToString();
+    string canonicalized;
+    cold_roots_.emplace(env->Canonicalize(path, &canonicalized).ok() ?
+                        std::move(canonicalized) : std::move(path));
+  }
+}
 
 Status DataDirManager::OpenExistingForTests(Env* env,
                                             const vector<string>& data_fs_roots,
@@ -385,6 +439,11 @@ Status DataDirManager::CreateDataDirGroup(const string& tablet_id,
         return Status::IOError("No healthy data directories available", "", ENODEV);
       }
     }
+    if (PREDICT_FALSE(has_cold_tier())) {
+      // New data is written to the hot tier, so prefer hot directories. The
+      // group is filled up with cold ones, which receive the cold data.
+      GetDirsForGroupUnlocked(group_target_size, &group_indices, StorageTier::HOT);
+    }
     GetDirsForGroupUnlocked(group_target_size, &group_indices);
     if (PREDICT_FALSE(group_indices.empty())) {
       return Status::IOError("All healthy data directories are full", "", ENOSPC);
@@ -439,17 +498,37 @@ Status DataDirManager::GetDirForBlock(const CreateBlockOptions& opts, Dir** dir,
                              "directory group", opts.tablet_id, ENODEV);
     }
   }
-  // Within a given directory group, filter out the ones that are full.
+  // Within a given directory group, filter out the ones that are full, and
+  // set aside those of another tier than requested.
   vector<Dir*> candidate_dirs;
+  vector<Dir*> other_tier_dirs;
   for (auto uuid_idx : healthy_uuid_indices) {
     Dir* candidate = FindOrDie(dir_by_uuid_idx_, uuid_idx);
     Status s = candidate->RefreshAvailableSpace(Dir::RefreshMode::EXPIRED_ONLY);
     WARN_NOT_OK(s, Substitute("failed to refresh fullness of $0", candidate->dir()));
     if (s.ok() && !candidate->is_full()) {
-      candidate_dirs.emplace_back(candidate);
+      if (PREDICT_FALSE(has_cold_tier()) && GetDirTier(candidate) != opts.tier) {
+        other_tier_dirs.emplace_back(candidate);
+      } else {
+        candidate_dirs.emplace_back(candidate);
+      }
     }
   }
 
+  // If there is room in the group only on another tier, have a directory of
+  // the requested tier added to the group if there is one, and fall back to
+  // the other tier otherwise.
+  if (PREDICT_FALSE(candidate_dirs.empty() && !other_tier_dirs.empty())) {
+    if (!opts.tablet_id.empty() && HasRoomOutsideGroupUnlocked(*group, opts.tier)) {
+      *new_target_group_size = group->uuid_indices().size() + 1;
+      return Status::IOError(
+          Substitute("No directories of the $0 tier available in $1's directory group",
+                     opts.tier == StorageTier::COLD ? "cold" : "hot", opts.tablet_id),
+          "", ENOSPC);
+    }
+    candidate_dirs.swap(other_tier_dirs);
+  }
+
   // If all the directories in the group are full, return an ENOSPC error.
   if (PREDICT_FALSE(candidate_dirs.empty())) {
     DCHECK(group);
@@ -472,9 +551,23 @@ Status DataDirManager::GetDirForBlock(const CreateBlockOptions& opts, Dir** dir,
     *dir = candidate_dirs[0];
     return Status::OK();
   }
-  // Pick two randomly and select the one with more space.
+  // Pick two randomly and select the less loaded one, if one of them is
+  // clearly more loaded, and the one with more space otherwise.
   shuffle(candidate_dirs.begin(), candidate_dirs.end(),
           default_random_engine(rng_.Next()));
+  if (PREDICT_TRUE(FLAGS_fs_data_dirs_consider_load)) {
+    const double ratio = FLAGS_fs_data_dirs_load_imbalance_ratio;
+    const int64_t load_in_first = candidate_dirs[0]->load();
+    const int64_t load_in_second = candidate_dirs[1]->load();
+    if (load_in_first > ratio * load_in_second) {
+      *dir = candidate_dirs[1];
+      return Status::OK();
+    }
+    if (load_in_second > ratio * load_in_first) {
+      *dir = candidate_dirs[0];
+      return Status::OK();
+    }
+  }
   *dir = PREDICT_TRUE(FLAGS_fs_data_dirs_consider_available_space) &&
          candidate_dirs[0]->available_bytes() > candidate_dirs[1]->available_bytes() ?
            candidate_dirs[0] : candidate_dirs[1];
@@ -510,6 +603,10 @@ Status DataDirManager::GetDirAddIfNecessary(const CreateBlockOptions& opts, Dir*
   int new_target_group_size = 0;
   Status s = GetDirForBlock(opts, dir, &new_target_group_size);
   if (PREDICT_TRUE(s.ok())) {
+    if (PREDICT_FALSE(FLAGS_fs_data_dirs_max_per_loaded_tablet > 0) &&
+        !opts.tablet_id.empty()) {
+      MaybeAddLessLoadedDir(opts, dir);
+    }
     return Status::OK();
   }
   const string& tablet_id = opts.tablet_id;
@@ -536,6 +633,9 @@ Status DataDirManager::GetDirAddIfNecessary(const CreateBlockOptions& opts, Dir*
     return Status::OK();
   }
   vector<int> group_uuid_indices = group.uuid_indices();
+  if (PREDICT_FALSE(has_cold_tier())) {
+    GetDirsForGroupUnlocked(new_target_group_size, &group_uuid_indices, opts.tier);
+  }
   GetDirsForGroupUnlocked(new_target_group_size, &group_uuid_indices);
   if (PREDICT_FALSE(group_uuid_indices.size() < new_target_group_size)) {
     // If we couldn't add to the group, return an error.
@@ -563,8 +663,67 @@ Status DataDirManager::GetDirAddIfNecessary(const CreateBlockOptions& opts, Dir*
   return Status::OK();
 }
 
+void DataDirManager::MaybeAddLessLoadedDir(const CreateBlockOptions& opts, Dir** dir) {
+  const string& tablet_id = opts.tablet_id;
+  const int64_t load = (*dir)->load();
+  const int max_group_size = FLAGS_fs_data_dirs_max_per_loaded_tablet;
+  // Check under the shared lock first, since this runs for every new block.
+  {
+    shared_lock<rw_spinlock> lock(dir_group_lock_.get_lock());
+    const DataDirGroup* group = FindOrNull(group_by_tablet_map_, tablet_id);
+    if (group == nullptr || group->uuid_indices().size() >= max_group_size ||
+        FindLessLoadedDirOutsideGroupUnlocked(*group, opts.tier, load) < 0) {
+      return;
+    }
+  }
+  std::lock_guard<percpu_rwlock> l(dir_group_lock_);
+  const DataDirGroup* group = FindOrNull(group_by_tablet_map_, tablet_id);
+  if (group == nullptr || group->uuid_indices().size() >= max_group_size) {
+    return;
+  }
+  const int new_uuid_idx = FindLessLoadedDirOutsideGroupUnlocked(*group, opts.tier, load);
+  if (new_uuid_idx < 0) {
+    return;
+  }
+  vector<int> group_uuid_indices = group->uuid_indices();
+  group_uuid_indices.push_back(new_uuid_idx);
+  InsertOrDie(&FindOrDie(tablets_by_uuid_idx_map_, new_uuid_idx), tablet_id);
+  CHECK(!EmplaceOrUpdate(&group_by_tablet_map_, tablet_id, DataDirGroup(group_uuid_indices)));
+  Dir* loaded_dir = *dir;
+  *dir = FindOrDie(dir_by_uuid_idx_, new_uuid_idx);
+  LOG(INFO) << Substitute("Added $0 to $1's directory group: load of $2 ($3) exceeds "
+                          "that of $0 ($4)", (*dir)->dir(), tablet_id,
+                          loaded_dir->dir(), load, (*dir)->load());
+}
+
+int DataDirManager::FindLessLoadedDirOutsideGroupUnlocked(const DataDirGroup& group,
+                                                          StorageTier tier,
+                                                          int64_t load) const {
+  unordered_set<int> group_indices(group.uuid_indices().begin(), group.uuid_indices().end());
+  int least_loaded_idx = -1;
+  int64_t least_load = 0;
+  for (const auto& e : dir_by_uuid_idx_) {
+    if (ContainsKey(group_indices, e.first) || ContainsKey(failed_dirs_, e.first) ||
+        e.second->is_full() ||
+        (PREDICT_FALSE(has_cold_tier()) && GetDirTier(e.second) != tier)) {
+      continue;
+    }
+    const int64_t dir_load = e.second->load();
+    if (least_loaded_idx < 0 || dir_load < least_load) {
+      least_loaded_idx = e.first;
+      least_load = dir_load;
+    }
+  }
+  if (least_loaded_idx >= 0 &&
+      load > FLAGS_fs_data_dirs_load_imbalance_ratio * least_load) {
+    return least_loaded_idx;
+  }
+  return -1;
+}
+
 void DataDirManager::GetDirsForGroupUnlocked(int target_size,
-                                             vector<int>* group_indices) {
+                                             vector<int>* group_indices,
+                                             std::optional<StorageTier> tier) {
   DCHECK(dir_group_lock_.is_locked());
   vector<int> candidate_indices;
   unordered_set<int> existing_group_indices(group_indices->begin(), group_indices->end());
@@ -576,6 +735,9 @@ void DataDirManager::GetDirsForGroupUnlocked(int target_size,
       continue;
     }
     Dir* dd = e.second;
+    if (tier && GetDirTier(dd) != *tier) {
+      continue;
+    }
     Status s = dd->RefreshAvailableSpace(Dir::RefreshMode::ALWAYS);
     WARN_NOT_OK(s, Substitute("failed to refresh fullness of $0", dd->dir()));
     if (s.ok() && !dd->is_full()) {
@@ -610,6 +772,35 @@ void DataDirManager::GetDirsForGroupUnlocked(int target_size,
   }
 }
 
+bool DataDirManager::HasRoomOutsideGroupUnlocked(const DataDirGroup& group,
+                                                 StorageTier tier) const {
+  unordered_set<int> group_indices(group.uuid_indices().begin(), group.uuid_indices().end());
+  for (const auto& e : dir_by_uuid_idx_) {
+    if (!ContainsKey(group_indices, e.first) && !ContainsKey(failed_dirs_, e.first) &&
+        !e.second->is_full() && GetDirTier(e.second) == tier) {
+      return true;
+    }
+  }
+  return false;
+}
+
+StorageTier DataDirManager::GetDirTier(const Dir* dir) const {
+  return ContainsKey(cold_roots_, DirName(dir->dir())) ? StorageTier::COLD : StorageTier::HOT;
+}
+
+StorageTier DataDirManager::GetTierOfPath(const string& path) const {
+  if (!has_cold_tier()) {
+    return StorageTier::HOT;
+  }
+  for (const auto& dd : dirs_) {
+    if (HasPrefixString(path, dd->dir()) && path.size() > dd->dir().size() &&
+        path[dd->dir().size()] == '/') {
+      return GetDirTier(dd.get());
+    }
+  }
+  return StorageTier::HOT;
+}
+
 Status DataDirManager::FindDataDirsByTabletId(const string& tablet_id,
                                               vector<string>* data_dirs) const {
   CHECK(data_dirs);
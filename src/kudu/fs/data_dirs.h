@@ -18,12 +18,15 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <gtest/gtest_prod.h>
 
+#include "kudu/fs/block_manager.h"
 #include "kudu/fs/dir_manager.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -39,7 +42,6 @@ class ThreadPool;
 namespace fs {
 
 class DirInstanceMetadataFile;
-struct CreateBlockOptions;
 
 const char kInstanceMetadataFileName[] = "block_manager_instance";
 const char kDataDirName[] = "data";
@@ -162,8 +164,23 @@ class DataDirManager : public DirManager,
   // Returns a dir for block placement in the data dir group specified in
   // 'opts'. If none exists, adds a new dir to the group and returns the dir,
   // and if none can be added, returns an error.
+  //
+  // If there are healthy data dirs with room on the tier specified in 'opts',
+  // the returned dir is one of them, even if that requires adding a dir to the
+  // group. Otherwise, dirs of any tier are considered.
   Status GetDirAddIfNecessary(const CreateBlockOptions& opts, Dir** dir);
 
+  // Returns the storage tier of 'dir'.
+  StorageTier GetDirTier(const Dir* dir) const;
+
+  // Returns the storage tier of the data dir containing the file at 'path',
+  // or HOT if no data dir contains it.
+  StorageTier GetTierOfPath(const std::string& path) const;
+
+  // Returns whether some data dirs are on the cold tier, i.e. whether the
+  // data dirs are split into tiers at all.
+  bool has_cold_tier() const { return !cold_roots_.empty(); }
+
   // Returns in 'data_dirs' a sorted list of the directory names for the data
   // dirs of the tablet specified by 'tablet_id'.
   Status FindDataDirsByTabletId(const std::string& tablet_id,
@@ -183,6 +200,8 @@ class DataDirManager : public DirManager,
   FRIEND_TEST(DataDirsTest, TestLoadBalancingBias);
   FRIEND_TEST(DataDirsTest, TestLoadBalancingDistribution);
   FRIEND_TEST(DataDirsTest, TestFailedDirNotAddedToGroup);
+  FRIEND_TEST(DataDirsTest, TestStorageTiers);
+  FRIEND_TEST(DataDirsTest, TestLoadAwarePlacement);
   friend class RefCountedThreadSafe<DataDirManager>;
   ~DataDirManager() override {}
 
@@ -207,9 +226,12 @@ class DataDirManager : public DirManager,
                  CanonicalizedRootsList canonicalized_data_roots);
 
   // Returns a random directory in the data dir group specified in 'opts',
-  // giving preference to those with more free space. If there is no room in
-  // the group, returns an IOError with the ENOSPC posix code and returns the
-  // new target size for the data dir group.
+  // giving preference to those on less loaded disks, then to those with more
+  // free space. If there is no room in
+  // the group, or only in dirs of another tier than the one specified in
+  // 'opts' while a dir of that tier could be added to the group, returns an
+  // IOError with the ENOSPC posix code and returns the new target size for
+  // the data dir group.
   Status GetDirForBlock(const CreateBlockOptions& opts, Dir** dir,
                         int* new_target_group_size) const;
 
@@ -228,7 +250,27 @@ class DataDirManager : public DirManager,
   // not considered. Although this function does not itself change
   // DataDirManager state, its expected usage warrants that it is called within
   // the scope of a lock_guard of dir_group_lock_.
-  void GetDirsForGroupUnlocked(int target_size, std::vector<int>* group_indices);
+  //
+  // If 'tier' is set, only the directories of that tier are selected.
+  void GetDirsForGroupUnlocked(int target_size, std::vector<int>* group_indices,
+                               std::optional<StorageTier> tier = std::nullopt);
+
+  // If a healthy directory outside the group of the tablet specified in
+  // 'opts' is clearly less loaded than '*dir', adds it to the group, up to
+  // --fs_data_dirs_max_per_loaded_tablet directories, and returns it in '*dir'.
+  void MaybeAddLessLoadedDir(const CreateBlockOptions& opts, Dir** dir);
+
+  // Returns the UUID index of the least loaded healthy, non-full directory of
+  // 'tier' outside 'group' if its load is lower than 'load' by more than
+  // --fs_data_dirs_load_imbalance_ratio, and -1 otherwise.
+  int FindLessLoadedDirOutsideGroupUnlocked(const internal::DataDirGroup& group,
+                                            StorageTier tier,
+                                            int64_t load) const;
+
+  // Returns whether there is a healthy directory of 'tier' which isn't full,
+  // as last refreshed, and isn't in 'group'.
+  bool HasRoomOutsideGroupUnlocked(const internal::DataDirGroup& group,
+                                   StorageTier tier) const;
 
   // Goes through the data dirs in 'uuid_indices' and populates
   // 'healthy_indices' with those that haven't failed.
@@ -238,6 +280,9 @@ class DataDirManager : public DirManager,
   typedef std::unordered_map<std::string, internal::DataDirGroup> TabletDataDirGroupMap;
   TabletDataDirGroupMap group_by_tablet_map_;
 
+  // The canonicalized roots listed in --fs_cold_data_dirs.
+  std::unordered_set<std::string> cold_roots_;
+
   DISALLOW_COPY_AND_ASSIGN(DataDirManager);
 };
 
@@ -123,13 +123,36 @@ Dir::Dir(Env* env,
       pool_(std::move(pool)),
       is_shutdown_(false),
       is_full_(false),
-      available_bytes_(0) {
+      available_bytes_(0),
+      ios_in_flight_(0),
+      io_latency_us_(0) {
 }
 
 Dir::~Dir() {
   Shutdown();
 }
 
+Dir::ScopedIo::ScopedIo(Dir* dir)
+    : dir_(dir),
+      start_(MonoTime::Now()) {
+  dir_->ios_in_flight_.fetch_add(1, std::memory_order_relaxed);
+}
+
+Dir::ScopedIo::~ScopedIo() {
+  const int64_t latency_us = (MonoTime::Now() - start_).ToMicroseconds();
+  // Weigh the new sample by 1/8, so that a single slow I/O doesn't steer
+  // placement but a persistently slow disk does within a few I/Os.
+  const int64_t avg_us = dir_->io_latency_us_.load(std::memory_order_relaxed);
+  dir_->io_latency_us_.store(avg_us + (latency_us - avg_us) / 8,
+                             std::memory_order_relaxed);
+  dir_->ios_in_flight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int64_t Dir::load() const {
+  return (static_cast<int64_t>(ios_in_flight()) + 1) *
+      std::max<int64_t>(io_latency_us(), 1);
+}
+
 void Dir::Shutdown() {
   if (is_shutdown_) {
     return;
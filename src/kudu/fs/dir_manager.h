@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -168,6 +169,34 @@ class Dir {
     return available_bytes_;
   }
 
+  // Accounts for an I/O issued by a block manager against this directory for
+  // as long as it is in scope, recording its latency on destruction.
+  class ScopedIo {
+   public:
+    explicit ScopedIo(Dir* dir);
+    ~ScopedIo();
+
+   private:
+    Dir* const dir_;
+    const MonoTime start_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedIo);
+  };
+
+  // Returns an estimate of the load of the disk backing this directory: the
+  // number of I/Os in flight (plus the one about to be issued) weighted by
+  // the recent per-I/O latency in microseconds. Lower is better.
+  int64_t load() const;
+
+  int32_t ios_in_flight() const {
+    return ios_in_flight_.load(std::memory_order_relaxed);
+  }
+
+  // Exponentially weighted moving average of the latency of recent I/Os.
+  int64_t io_latency_us() const {
+    return io_latency_us_.load(std::memory_order_relaxed);
+  }
+
   // The amount of time to cache the amount of available space in this
   // directory.
   static int available_space_cache_secs();
@@ -194,6 +223,11 @@ class Dir {
   // The available bytes of this dir, updated by RefreshAvailableSpace.
   int64_t available_bytes_;
 
+  // Maintained by ScopedIo. Approximate by design: racing updates of the
+  // latency average may drop a sample.
+  std::atomic<int32_t> ios_in_flight_;
+  std::atomic<int64_t> io_latency_us_;
+
   DISALLOW_COPY_AND_ASSIGN(Dir);
 };
 
@@ -343,7 +343,10 @@ Status FileWritableBlock::Append(const Slice& data) {
 
 Status FileWritableBlock::AppendV(ArrayView<const Slice> data) {
   DCHECK(state_ == CLEAN || state_ == DIRTY) << "Invalid state: " << state_;
-  RETURN_NOT_OK_HANDLE_ERROR(writer_->AppendV(data));
+  {
+    Dir::ScopedIo io(location_.data_dir());
+    RETURN_NOT_OK_HANDLE_ERROR(writer_->AppendV(data));
+  }
   RETURN_NOT_OK_HANDLE_ERROR(location_.data_dir()->RefreshAvailableSpace(
       Dir::RefreshMode::ALWAYS));
   state_ = DIRTY;
@@ -399,6 +402,7 @@ Status FileWritableBlock::Close(SyncMode mode) {
     VLOG(3) << "Syncing block " << id();
     if (FLAGS_enable_data_block_fsync) {
       if (block_manager_->metrics_) block_manager_->metrics_->total_disk_sync->Increment();
+      Dir::ScopedIo io(location_.data_dir());
       sync = writer_->Sync();
     }
     if (sync.ok()) {
@@ -453,6 +457,8 @@ class FileReadableBlock : public ReadableBlock {
 
   Status ReadV(uint64_t offset, ArrayView<Slice> results) const override;
 
+  Status ReadVBatch(ArrayView<const ReadVRequest> requests) const override;
+
   size_t memory_footprint() const override;
 
   void HandleError(const Status& s) const;
@@ -548,6 +554,28 @@ Status FileReadableBlock::ReadV(uint64_t offset, ArrayView<Slice> results) const
   return Status::OK();
 }
 
+Status FileReadableBlock::ReadVBatch(ArrayView<const ReadVRequest> requests) const {
+  DCHECK(!closed_);
+
+  // Skip the encryption header, if any.
+  const uint64_t header_size = reader_->GetEncryptionHeaderSize();
+  vector<ReadVRequest> file_requests;
+  file_requests.reserve(requests.size());
+  size_t bytes_read = 0;
+  for (const auto& r : requests) {
+    file_requests.push_back({ r.offset + header_size, r.results });
+    for (const auto& result : r.results) {
+      bytes_read += result.size();
+    }
+  }
+  RETURN_NOT_OK_HANDLE_ERROR(reader_->ReadVBatch(file_requests));
+
+  if (block_manager_->metrics_) {
+    block_manager_->metrics_->total_bytes_read->IncrementBy(bytes_read);
+  }
+  return Status::OK();
+}
+
 size_t FileReadableBlock::memory_footprint() const {
   DCHECK(reader_);
   return kudu_malloc_usable_size(this) + reader_->memory_footprint();
@@ -206,6 +206,7 @@ namespace kudu {
 const char *FsManager::kWalDirName = "wals";
 const char *FsManager::kWalFileNamePrefix = "wal";
 const char *FsManager::kWalsRecoveryDirSuffix = ".recovery";
+const char *FsManager::kTabletMetadataLogSuffix = ".log";
 const char *FsManager::kTabletMetadataDirName = "tablet-meta";
 const char *FsManager::kDataDirName = "data";
 const char *FsManager::kInstanceMetadataFileName = "instance";
@@ -1299,12 +1300,22 @@ string FsManager::GetTabletMetadataPath(const string& tablet_id) const {
   return JoinPathSegments(GetTabletMetadataDir(), tablet_id);
 }
 
+string FsManager::GetTabletMetadataLogPath(const string& tablet_id) const {
+  string path = GetTabletMetadataPath(tablet_id);
+  StrAppend(&path, kTabletMetadataLogSuffix);
+  return path;
+}
+
 bool FsManager::IsValidTabletId(const string& fname) {
   // Prevent warning logs for hidden files or ./..
   if (PREDICT_FALSE(HasPrefixString(fname, "."))) {
     VLOG(1) << "Ignoring hidden file in tablet metadata dir: " << fname;
     return false;
   }
+  // The superblock logs live next to the metadata files of their tablets.
+  if (HasSuffixString(fname, kTabletMetadataLogSuffix)) {
+    return false;
+  }
 
   string canonicalized_uuid;
   Status s = oid_generator_.Canonicalize(fname, &canonicalized_uuid);
@@ -167,6 +167,7 @@ class FsManager {
  public:
   static const char *kWalFileNamePrefix;
   static const char *kWalsRecoveryDirSuffix;
+  static const char *kTabletMetadataLogSuffix;
 
   explicit FsManager(Env* env, FsManagerOpts opts = {});
   ~FsManager();
@@ -296,6 +297,10 @@ class FsManager {
   // Return the path for a specific tablet's superblock.
   std::string GetTabletMetadataPath(const std::string& tablet_id) const;
 
+  // Return the path of the superblock log of the given tablet, which holds
+  // the updates of its superblock since its metadata file was last written.
+  std::string GetTabletMetadataLogPath(const std::string& tablet_id) const;
+
   // List the tablet IDs in the metadata directory.
   Status ListTabletIds(std::vector<std::string>* tablet_ids);
 
@@ -0,0 +1,157 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/fs/fs_mm_ops.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/fs/log_block_manager.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/status.h"
+
+DEFINE_bool(log_container_defrag_enabled, false,
+            "Whether to rewrite the live blocks of fragmented log block containers "
+            "into other containers of the same data directory in the background. "
+            "See --log_container_defrag_min_dead_ratio for the containers which are "
+            "considered fragmented.");
+TAG_FLAG(log_container_defrag_enabled, experimental);
+TAG_FLAG(log_container_defrag_enabled, runtime);
+
+DEFINE_int64(log_container_defrag_max_bytes_per_op, 256 * 1024 * 1024,
+             "The maximum number of bytes of live blocks relocated by a single run "
+             "of the log block container defragmentation maintenance op, bounding "
+             "the I/O it competes with the workload for.");
+TAG_FLAG(log_container_defrag_max_bytes_per_op, experimental);
+TAG_FLAG(log_container_defrag_max_bytes_per_op, runtime);
+
+METRIC_DEFINE_histogram(server, log_block_manager_defrag_duration,
+                        "Log Block Container Defragmentation Duration",
+                        kudu::MetricUnit::kMilliseconds,
+                        "Time spent relocating the live blocks of fragmented "
+                        "log block containers.",
+                        kudu::MetricLevel::kDebug,
+                        60000LU, 1);
+
+METRIC_DEFINE_gauge_uint32(server, log_block_manager_defrag_running,
+                           "Log Block Container Defragmentations Running",
+                           kudu::MetricUnit::kMaintenanceOperations,
+                           "Number of log block container defragmentations "
+                           "currently running.",
+                           kudu::MetricLevel::kDebug);
+
+using std::map;
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+namespace fs {
+
+namespace {
+
+// How long the cached stats of the op remain valid.
+const MonoDelta kStatsRefreshInterval = MonoDelta::FromSeconds(10);
+
+} // anonymous namespace
+
+DefragmentContainersOp::DefragmentContainersOp(
+    LogBlockManager* lbm, const scoped_refptr<MetricEntity>& metric_entity)
+    : MaintenanceOp("DefragmentContainersOp", MaintenanceOp::HIGH_IO_USAGE),
+      lbm_(lbm),
+      duration_(METRIC_log_block_manager_defrag_duration.Instantiate(metric_entity)),
+      running_gauge_(METRIC_log_block_manager_defrag_running.Instantiate(metric_entity, 0)),
+      performing_(false) {
+}
+
+void DefragmentContainersOp::UpdateStats(MaintenanceOpStats* stats) {
+  if (!FLAGS_log_container_defrag_enabled || performing_) {
+    stats->set_runnable(false);
+    return;
+  }
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  const MonoTime now = MonoTime::Now();
+  if (prev_stats_.valid() && now - prev_stats_time_ < kStatsRefreshInterval) {
+    *stats = prev_stats_;
+    return;
+  }
+
+  map<string, LogBlockManager::FragmentationStats> stats_by_dir;
+  lbm_->GetFragmentationStats(&stats_by_dir);
+  double max_dead_ratio = 0;
+  for (const auto& [_, dir_stats] : stats_by_dir) {
+    max_dead_ratio = std::max(max_dead_ratio, dir_stats.max_dead_ratio);
+  }
+  prev_stats_.Clear();
+  prev_stats_.set_runnable(max_dead_ratio > 0);
+  prev_stats_.set_perf_improvement(max_dead_ratio);
+  prev_stats_time_ = now;
+  *stats = prev_stats_;
+}
+
+bool DefragmentContainersOp::Prepare() {
+  bool expected = false;
+  if (!performing_.compare_exchange_strong(expected, true)) {
+    return false;
+  }
+  std::lock_guard<simple_spinlock> l(lock_);
+  prev_stats_.Clear();
+  return true;
+}
+
+void DefragmentContainersOp::Perform() {
+  int64_t bytes_relocated = 0;
+  Status s = lbm_->DefragmentContainers(FLAGS_log_container_defrag_max_bytes_per_op,
+                                        &bytes_relocated);
+  WARN_NOT_OK(s, "Unable to defragment log block containers");
+
+  map<string, LogBlockManager::FragmentationStats> stats_by_dir;
+  lbm_->GetFragmentationStats(&stats_by_dir);
+  for (const auto& [dir, dir_stats] : stats_by_dir) {
+    VLOG(1) << Substitute("Data directory $0: $1 fragmented container(s), "
+                          "$2 live bytes, $3 dead bytes",
+                          dir, dir_stats.fragmented_containers,
+                          dir_stats.fragmented_live_bytes, dir_stats.fragmented_dead_bytes);
+  }
+  if (bytes_relocated > 0) {
+    LOG(INFO) << Substitute("Relocated $0 bytes of log blocks", bytes_relocated);
+  }
+  performing_ = false;
+}
+
+scoped_refptr<Histogram> DefragmentContainersOp::DurationHistogram() const {
+  return duration_;
+}
+
+scoped_refptr<AtomicGauge<uint32_t>> DefragmentContainersOp::RunningGauge() const {
+  return running_gauge_;
+}
+
+int32_t DefragmentContainersOp::priority() const {
+  return 0;
+}
+
+} // namespace fs
+} // namespace kudu
@@ -0,0 +1,86 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/maintenance_manager.h"
+#include "kudu/util/monotime.h"
+
+namespace kudu {
+
+class Histogram;
+class MetricEntity;
+template <class T>
+class AtomicGauge;
+
+namespace fs {
+
+class LogBlockManager;
+
+// MaintenanceOp which rewrites the live blocks of fragmented log block
+// containers into other containers of the same data directory, so that they
+// can be read sequentially again and the old containers can be deleted.
+//
+// The more deleted bytes the most fragmented container has, the higher the
+// perf_improvement score of the op. The op is disabled unless
+// --log_container_defrag_enabled is set.
+class DefragmentContainersOp : public MaintenanceOp {
+ public:
+  DefragmentContainersOp(LogBlockManager* lbm,
+                         const scoped_refptr<MetricEntity>& metric_entity);
+
+  void UpdateStats(MaintenanceOpStats* stats) override;
+
+  bool Prepare() override;
+
+  void Perform() override;
+
+  scoped_refptr<Histogram> DurationHistogram() const override;
+
+  scoped_refptr<AtomicGauge<uint32_t>> RunningGauge() const override;
+
+ protected:
+  int32_t priority() const override;
+
+ private:
+  LogBlockManager* const lbm_;
+
+  scoped_refptr<Histogram> duration_;
+  scoped_refptr<AtomicGauge<uint32_t>> running_gauge_;
+
+  // Whether Perform() may be called. Only one instance of the op may run at a
+  // time, since concurrent runs would pick the same container.
+  std::atomic<bool> performing_;
+
+  // Protects the members below.
+  simple_spinlock lock_;
+
+  // Computing the stats walks all of the containers: they are only refreshed
+  // once in a while, or after each run.
+  MaintenanceOpStats prev_stats_;
+  MonoTime prev_stats_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(DefragmentContainersOp);
+};
+
+} // namespace fs
+} // namespace kudu
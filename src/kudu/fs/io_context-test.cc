@@ -0,0 +1,71 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/fs/io_context.h"
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <gflags/gflags_declare.h>
+#include <gtest/gtest.h>
+
+#include "kudu/util/test_util.h"
+
+DECLARE_bool(fs_io_priorities_enabled);
+DECLARE_int32(fs_background_io_priority_level);
+
+namespace kudu {
+namespace fs {
+
+class IOContextTest : public KuduTest {
+ protected:
+  // Returns the ioprio value of the calling thread.
+  static int ThreadIOPriority() {
+#if defined(__linux__)
+    return static_cast<int>(syscall(SYS_ioprio_get, 1 /* IOPRIO_WHO_PROCESS */, 0));
+#else
+    return 0;
+#endif
+  }
+};
+
+TEST_F(IOContextTest, TestSetThreadIOPriority) {
+#if !defined(__linux__)
+  GTEST_SKIP() << "I/O priorities are only supported on Linux";
+#endif
+  // The best-effort class at the configured level.
+  FLAGS_fs_background_io_priority_level = 1;
+  SetThreadIOPriority(IOPriority::BACKGROUND);
+  ASSERT_EQ((2 << 13) | 1, ThreadIOPriority());
+
+  // Back to the default priority, which follows the CPU nice value and is
+  // reported as the best-effort class at the level of the nice value.
+  SetThreadIOPriority(IOPriority::FOREGROUND);
+  const int foreground_ioprio = ThreadIOPriority();
+  ASSERT_NE((2 << 13) | 1, foreground_ioprio);
+
+  // With priorities disabled, the background IO is done at the default
+  // priority too.
+  FLAGS_fs_io_priorities_enabled = false;
+  SetThreadIOPriority(IOPriority::BACKGROUND);
+  ASSERT_EQ(foreground_ioprio, ThreadIOPriority());
+}
+
+} // namespace fs
+} // namespace kudu
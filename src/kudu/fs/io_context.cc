@@ -0,0 +1,95 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/fs/io_context.h"
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <ostream>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/gutil/port.h"
+#include "kudu/util/errno.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/logging.h"
+
+DEFINE_bool(fs_io_priorities_enabled, true,
+            "Whether the threads reading blocks on behalf of background work, "
+            "e.g. flushes, compactions and tablet copies, lower their I/O "
+            "priority while doing so, so that the I/O schedulers supporting "
+            "priorities serve the reads of scans and writes first.");
+TAG_FLAG(fs_io_priorities_enabled, advanced);
+TAG_FLAG(fs_io_priorities_enabled, runtime);
+
+DEFINE_int32(fs_background_io_priority_level, 7,
+             "The level of the best-effort I/O scheduling class at which the "
+             "background work reads blocks, from 0 (the highest) to 7 (the "
+             "lowest). The foreground IO is done at level 4 by default. Only "
+             "relevant if --fs_io_priorities_enabled is set.");
+TAG_FLAG(fs_background_io_priority_level, advanced);
+TAG_FLAG(fs_background_io_priority_level, runtime);
+DEFINE_validator(fs_background_io_priority_level,
+                 [](const char* /*n*/, int32 v) { return 0 <= v && v <= 7; });
+
+namespace kudu {
+namespace fs {
+
+#if defined(__linux__)
+namespace {
+
+// See include/uapi/linux/ioprio.h.
+constexpr int kIOPrioWhoProcess = 1;
+constexpr int kIOPrioClassShift = 13;
+constexpr int kIOPrioClassNone = 0;
+constexpr int kIOPrioClassBestEffort = 2;
+
+// The ioprio value last set for the calling thread, or -1 if unknown: a new
+// thread inherits the priority of the thread which created it.
+thread_local int thread_ioprio = -1;
+
+} // anonymous namespace
+#endif
+
+void SetThreadIOPriority(IOPriority priority) {
+#if defined(__linux__)
+  int ioprio = kIOPrioClassNone << kIOPrioClassShift;
+  if (priority == IOPriority::BACKGROUND && FLAGS_fs_io_priorities_enabled) {
+    ioprio = (kIOPrioClassBestEffort << kIOPrioClassShift) |
+             FLAGS_fs_background_io_priority_level;
+  }
+  if (ioprio == thread_ioprio) {
+    return;
+  }
+  // A 'who' of 0 with IOPRIO_WHO_PROCESS is the calling thread.
+  if (PREDICT_FALSE(syscall(SYS_ioprio_set, kIOPrioWhoProcess, 0, ioprio) != 0)) {
+    int err = errno;
+    KLOG_EVERY_N_SECS(WARNING, 60) << "unable to set the I/O priority of a thread: "
+                                   << ErrnoToString(err) << THROTTLE_MSG;
+  }
+  // Not retried on failure, which is bound to fail again.
+  thread_ioprio = ioprio;
+#endif
+}
+
+} // namespace fs
+} // namespace kudu
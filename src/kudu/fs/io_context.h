@@ -19,9 +19,35 @@
 
 #include <string>
 
+#include "kudu/gutil/ref_counted.h"
+
 namespace kudu {
+
+class Counter;
+
 namespace fs {
 
+// Counters accounting for the IO done on behalf of a tablet, e.g. to
+// aggregate the IO of the tablets by table.
+struct IOMetrics {
+  // The number of CFile block lookups in the block cache which hit and missed.
+  scoped_refptr<Counter> cfile_cache_hits;
+  scoped_refptr<Counter> cfile_cache_misses;
+
+  // The number of bytes of CFile blocks read from disk.
+  scoped_refptr<Counter> cfile_bytes_read;
+};
+
+// The priority of some IO relative to other IO.
+enum class IOPriority {
+  // IO on which a client is waiting, e.g. the reads of scans and writes.
+  FOREGROUND,
+
+  // IO done by background work, e.g. flushes, compactions and tablet copies,
+  // which should yield to foreground IO.
+  BACKGROUND,
+};
+
 // An IOContext provides a single interface to pass state around during IO. A
 // single IOContext should correspond to a single high-level operation that
 // does IO, e.g. a scan, a tablet bootstrap, etc.
@@ -43,7 +69,28 @@ namespace fs {
 struct IOContext {
   // The tablet id associated with this IO.
   std::string tablet_id;
+
+  // If not null, the counters which this IO is accounted to. Must outlive the
+  // IOContext.
+  const IOMetrics* metrics = nullptr;
+
+  // The priority of this IO: see SetThreadIOPriority().
+  IOPriority priority = IOPriority::FOREGROUND;
 };
 
+// Sets the I/O priority of the calling thread for the IO it does next, until
+// it's set again. The blocks read on behalf of an IOContext are read at its
+// priority.
+//
+// On Linux, BACKGROUND maps to the best-effort scheduling class of
+// ioprio_set(2) at --fs_background_io_priority_level, and FOREGROUND to the
+// default priority derived from the CPU nice value. Only the I/O schedulers
+// supporting priorities, e.g. BFQ, take them into account. Elsewhere, this
+// is a no-op.
+//
+// The priority of the thread is cached, so that setting it to the same
+// priority again is cheap.
+void SetThreadIOPriority(IOPriority priority);
+
 }  // namespace fs
 }  // namespace kudu
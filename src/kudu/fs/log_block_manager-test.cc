@@ -25,6 +25,8 @@
 #include <deque>
 #include <functional>
 #include <initializer_list>
+#include <limits>
+#include <map>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -1049,6 +1051,79 @@ TEST_P(LogBlockManagerTest, TestContainerWithManyHoles) {
   ASSERT_OK(deletion_transaction->CommitDeletedBlocks(nullptr));
 }
 
+// The live blocks of fragmented containers are relocated, and the containers
+// are deleted.
+TEST_P(LogBlockManagerTest, TestDefragmentContainers) {
+  const int kNumContainers = 4;
+  const int kBlocksPerContainer = 10;
+  const int kLiveBlocksPerContainer = 2;
+  FLAGS_log_container_max_blocks = kBlocksPerContainer;
+
+  auto block_data = [](int i) {
+    return string(4096, static_cast<char>('a' + i % 26));
+  };
+  vector<BlockId> ids;
+  for (int i = 0; i < kNumContainers * kBlocksPerContainer; i++) {
+    unique_ptr<WritableBlock> block;
+    ASSERT_OK(bm_->CreateBlock(test_block_opts_, &block));
+    ASSERT_OK(block->Append(block_data(i)));
+    ASSERT_OK(block->Close());
+    ids.push_back(block->id());
+  }
+  NO_FATALS(AssertNumContainers(kNumContainers));
+
+  // Nothing is fragmented yet.
+  int64_t bytes_relocated;
+  ASSERT_OK(bm_->DefragmentContainers(std::numeric_limits<int64_t>::max(), &bytes_relocated));
+  ASSERT_EQ(0, bytes_relocated);
+
+  // Delete most of the blocks of each container.
+  {
+    shared_ptr<BlockDeletionTransaction> deletion_transaction =
+        bm_->NewDeletionTransaction();
+    for (int i = 0; i < ids.size(); i++) {
+      if (i % kBlocksPerContainer >= kLiveBlocksPerContainer) {
+        deletion_transaction->AddDeletedBlock(ids[i]);
+      }
+    }
+    ASSERT_OK(deletion_transaction->CommitDeletedBlocks(nullptr));
+  }
+  std::map<string, LogBlockManager::FragmentationStats> stats_by_dir;
+  bm_->GetFragmentationStats(&stats_by_dir);
+  ASSERT_EQ(1, stats_by_dir.size());
+  ASSERT_EQ(kNumContainers, stats_by_dir.begin()->second.fragmented_containers);
+
+  // Each run relocates the blocks of one container.
+  for (int i = 0; i < kNumContainers; i++) {
+    ASSERT_OK(bm_->DefragmentContainers(std::numeric_limits<int64_t>::max(), &bytes_relocated));
+    ASSERT_EQ(kLiveBlocksPerContainer * 4096, bytes_relocated);
+  }
+  ASSERT_OK(bm_->DefragmentContainers(std::numeric_limits<int64_t>::max(), &bytes_relocated));
+  ASSERT_EQ(0, bytes_relocated);
+  bm_->GetFragmentationStats(&stats_by_dir);
+  ASSERT_EQ(0, stats_by_dir.begin()->second.fragmented_containers);
+
+  // The relocated blocks survive a restart, in a single container.
+  FsReport report;
+  ASSERT_OK(ReopenBlockManager(nullptr, &report));
+  NO_FATALS(AssertEmptyReport(report));
+  NO_FATALS(AssertNumContainers(1));
+  vector<BlockId> live_ids;
+  ASSERT_OK(bm_->GetAllBlockIds(&live_ids));
+  ASSERT_EQ(kNumContainers * kLiveBlocksPerContainer, live_ids.size());
+  for (int i = 0; i < ids.size(); i++) {
+    if (i % kBlocksPerContainer >= kLiveBlocksPerContainer) {
+      continue;
+    }
+    unique_ptr<ReadableBlock> block;
+    ASSERT_OK(bm_->OpenBlock(ids[i], &block));
+    string expected = block_data(i);
+    string data(expected.size(), '\0');
+    ASSERT_OK(block->Read(0, Slice(reinterpret_cast<uint8_t*>(&data[0]), data.size())));
+    ASSERT_EQ(expected, data);
+  }
+}
+
 TEST_P(LogBlockManagerTest, TestParseKernelRelease) {
   ASSERT_TRUE(LogBlockManager::IsBuggyEl6Kernel("1.7.0.0.el6.x86_64"));
 
@@ -69,6 +69,7 @@
 #include "kudu/util/array_view.h"
 #include "kudu/util/env.h"
 #include "kudu/util/fault_injection.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/file_cache.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
@@ -163,6 +164,18 @@ DEFINE_bool(log_block_manager_delete_dead_container, true,
 TAG_FLAG(log_block_manager_delete_dead_container, advanced);
 TAG_FLAG(log_block_manager_delete_dead_container, experimental);
 
+DEFINE_double(log_container_defrag_min_dead_ratio, 0.5,
+              "Minimum ratio of the bytes of the deleted blocks of a full log block "
+              "container to all of its bytes for the container to be considered "
+              "fragmented. The live blocks of fragmented containers are rewritten "
+              "into other containers by the container defragmentation maintenance "
+              "operation, see --log_container_defrag_enabled.");
+TAG_FLAG(log_container_defrag_min_dead_ratio, experimental);
+TAG_FLAG(log_container_defrag_min_dead_ratio, runtime);
+
+DEFINE_validator(log_container_defrag_min_dead_ratio,
+                 [](const char* /*n*/, double v) { return v > 0 && v <= 1; });
+
 DEFINE_int32(log_container_metadata_rewrite_inject_latency_ms, 0,
              "Amount of latency in ms to inject when rewrite metadata file. "
              "Only for testing.");
@@ -204,6 +217,36 @@ METRIC_DEFINE_counter(server, log_block_manager_dead_containers_deleted,
                       "Number of full (but dead) block containers that were deleted",
                       kudu::MetricLevel::kDebug);
 
+METRIC_DEFINE_gauge_uint64(server, log_block_manager_fragmented_containers,
+                           "Number of Fragmented Block Containers",
+                           kudu::MetricUnit::kLogBlockContainers,
+                           "Number of full log block containers whose ratio of deleted "
+                           "bytes is at least --log_container_defrag_min_dead_ratio, as of "
+                           "the last evaluation of the fragmentation of the containers",
+                           kudu::MetricLevel::kInfo);
+
+METRIC_DEFINE_gauge_uint64(server, log_block_manager_fragmented_live_bytes,
+                           "Bytes In Fragmented Block Containers",
+                           kudu::MetricUnit::kBytes,
+                           "Number of bytes of the live blocks of the fragmented log block "
+                           "containers, as of the last evaluation of the fragmentation of the "
+                           "containers",
+                           kudu::MetricLevel::kInfo);
+
+METRIC_DEFINE_counter(server, log_block_manager_blocks_relocated,
+                      "Number of Blocks Relocated",
+                      kudu::MetricUnit::kBlocks,
+                      "Number of blocks rewritten from fragmented log block containers "
+                      "into other containers since service start",
+                      kudu::MetricLevel::kDebug);
+
+METRIC_DEFINE_counter(server, log_block_manager_bytes_relocated,
+                      "Bytes Relocated",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes of blocks rewritten from fragmented log block "
+                      "containers into other containers since service start",
+                      kudu::MetricLevel::kDebug);
+
 METRIC_DEFINE_gauge_uint64(server, log_block_manager_total_containers_startup,
                            "Total number of Log Block Containers during startup",
                            kudu::MetricUnit::kLogBlockContainers,
@@ -281,11 +324,16 @@ struct LogBlockManagerMetrics {
   scoped_refptr<AtomicGauge<uint64_t>> containers;
   scoped_refptr<AtomicGauge<uint64_t>> full_containers;
 
+  scoped_refptr<AtomicGauge<uint64_t>> fragmented_containers;
+  scoped_refptr<AtomicGauge<uint64_t>> fragmented_live_bytes;
+
   scoped_refptr<AtomicGauge<uint64_t>> total_containers_startup;
   scoped_refptr<AtomicGauge<uint64_t>> processed_containers_startup;
 
   scoped_refptr<Counter> holes_punched;
   scoped_refptr<Counter> dead_containers_deleted;
+  scoped_refptr<Counter> blocks_relocated;
+  scoped_refptr<Counter> bytes_relocated;
 };
 
 #define MINIT(x) x(METRIC_log_block_manager_##x.Instantiate(metric_entity))
@@ -296,10 +344,14 @@ LogBlockManagerMetrics::LogBlockManagerMetrics(const scoped_refptr<MetricEntity>
     GINIT(blocks_under_management),
     GINIT(containers),
     GINIT(full_containers),
+    GINIT(fragmented_containers),
+    GINIT(fragmented_live_bytes),
     GINIT(total_containers_startup),
     GINIT(processed_containers_startup),
     MINIT(holes_punched),
-    MINIT(dead_containers_deleted) {
+    MINIT(dead_containers_deleted),
+    MINIT(blocks_relocated),
+    MINIT(bytes_relocated) {
 }
 #undef GINIT
 
@@ -405,6 +457,12 @@ class LogWritableBlock final : public WritableBlock {
 
   int64_t block_length() const { return block_length_; }
 
+  // Marks this block as a copy of the existing block with the same ID, which
+  // is being relocated. Closing the copy doesn't add it to the block manager's
+  // in-memory maps (see LogBlockManager::RelocateBlocks()), and aborting it
+  // doesn't delete the existing block.
+  void MarkAsRelocation() { relocation_ = true; }
+
  private:
   // The owning container.
   LogBlockContainerRefPtr container_;
@@ -423,6 +481,9 @@ class LogWritableBlock final : public WritableBlock {
   // for example, has it been synchronized to disk?
   WritableBlock::State state_;
 
+  // Whether this block is a copy of a block being relocated.
+  bool relocation_;
+
   DISALLOW_COPY_AND_ASSIGN(LogWritableBlock);
 };
 
@@ -489,6 +550,9 @@ class LogBlockContainer: public RefCountedThreadSafe<LogBlockContainer> {
   // See RWFile::ReadV().
   Status ReadVData(int64_t offset, ArrayView<Slice> results) const;
 
+  // See RWFile::ReadVBatch().
+  Status ReadVBatchData(ArrayView<const ReadVRequest> requests) const;
+
   // Removes block ids from this container's metadata part according to 'lbs',
   // the block ids removed successfully are returned by 'deleted_block_ids', even if
   // returning non-OK status.
@@ -613,6 +677,17 @@ class LogBlockContainer: public RefCountedThreadSafe<LogBlockContainer> {
   virtual bool full() const { return data_full(); }
   bool dead() const { return dead_; }
   const LogBlockManagerMetrics* metrics() const { return metrics_; }
+
+  // Returns the bytes of the blocks deleted from this container so far.
+  int64_t dead_bytes_aligned() const { return total_bytes() - live_bytes_aligned(); }
+
+  // Returns whether this container is fragmented: it's full, it still has
+  // live blocks, and the ratio of its deleted bytes to all of its bytes is at
+  // least --log_container_defrag_min_dead_ratio.
+  bool fragmented() const {
+    return full() && !dead() && live_blocks() > 0 && total_bytes() > 0 &&
+        dead_bytes_aligned() >= total_bytes() * FLAGS_log_container_defrag_min_dead_ratio;
+  }
   Dir* data_dir() const { return data_dir_; }
   const DirInstanceMetadataPB* instance() const { return data_dir_->instance()->metadata(); }
 
@@ -1588,7 +1663,10 @@ Status LogBlockContainer::WriteVData(int64_t offset, ArrayView<const Slice> data
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
   DCHECK_GE(offset, next_block_offset());
 
-  RETURN_NOT_OK_HANDLE_ERROR(data_file_->WriteV(offset, data));
+  {
+    Dir::ScopedIo io(data_dir_);
+    RETURN_NOT_OK_HANDLE_ERROR(data_file_->WriteV(offset, data));
+  }
 
   // This append may have changed the container size if:
   // 1. It was large enough that it blew out the preallocated space.
@@ -1615,6 +1693,11 @@ Status LogBlockContainer::ReadVData(int64_t offset, ArrayView<Slice> results) co
   return Status::OK();
 }
 
+Status LogBlockContainer::ReadVBatchData(ArrayView<const ReadVRequest> requests) const {
+  RETURN_NOT_OK_HANDLE_ERROR(data_file_->ReadVBatch(requests));
+  return Status::OK();
+}
+
 Status LogBlockContainer::FlushData(int64_t offset, int64_t length) {
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
   DCHECK_GE(offset, 0);
@@ -1627,6 +1710,7 @@ Status LogBlockContainer::SyncData() {
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
   if (FLAGS_enable_data_block_fsync) {
     if (metrics_) metrics_->generic_metrics.total_disk_sync->Increment();
+    Dir::ScopedIo io(data_dir_);
     RETURN_NOT_OK_HANDLE_ERROR(data_file_->Sync());
   }
   return Status::OK();
@@ -2369,6 +2453,9 @@ struct LogBlockContainerLoadResult {
   // Keep track of deleted blocks whose space hasn't been punched; they will
   // be repunched during repair.
   vector<LogBlockRefPtr> need_repunching_blocks;
+  // Keep track of the extra copies of the blocks whose relocation was
+  // interrupted; they will be deleted during repair.
+  vector<LogBlockRefPtr> relocated_block_copies;
 
   LogBlockContainerLoadResult() {
     // We are going to perform these checks.
@@ -2434,7 +2521,8 @@ LogWritableBlock::LogWritableBlock(LogBlockContainerRefPtr container,
       block_id_(block_id),
       block_offset_(block_offset),
       block_length_(0),
-      state_(CLEAN) {
+      state_(CLEAN),
+      relocation_(false) {
   DCHECK_GE(block_offset, 0);
   DCHECK_EQ(0, block_offset % container_->instance()->filesystem_block_size_bytes());
   container_->blocks_being_written_incr(1);
@@ -2459,6 +2547,14 @@ Status LogWritableBlock::Close() {
 }
 
 Status LogWritableBlock::Abort() {
+  // The ID of a relocation copy belongs to the block being relocated, which
+  // must not be deleted. Once finalized, the copy's data is left as a gap in
+  // the container.
+  if (relocation_) {
+    DoClose();
+    return Status::OK();
+  }
+
   // Only updates metrics and block state for read-only container.
   if (container_->read_only()) {
     if (state_ != CLOSED) {
@@ -2595,7 +2691,9 @@ void LogWritableBlock::DoClose() {
     container_->metrics()->generic_metrics.blocks_open_writing->Decrement();
     container_->metrics()->generic_metrics.total_bytes_written->IncrementBy(
         block_length_);
-    container_->metrics()->generic_metrics.total_blocks_created->Increment();
+    if (!relocation_) {
+      container_->metrics()->generic_metrics.total_blocks_created->Increment();
+    }
   }
 
   // Finalize() was not called; this indicates we should
@@ -2604,6 +2702,12 @@ void LogWritableBlock::DoClose() {
     container_->FinalizeBlock(block_offset_, block_length_);
   }
 
+  if (relocation_) {
+    // The block manager swaps the copy in itself.
+    state_ = CLOSED;
+    return;
+  }
+
   LogBlockRefPtr lb = container_->block_manager()->CreateAndAddLogBlock(
       container_, block_id_, block_offset_, block_length_);
   CHECK(lb);
@@ -2636,9 +2740,15 @@ class LogReadableBlock : public ReadableBlock {
 
   Status ReadV(uint64_t offset, ArrayView<Slice> results) const override;
 
+  Status ReadVBatch(ArrayView<const ReadVRequest> requests) const override;
+
   size_t memory_footprint() const override;
 
  private:
+  // Returns an error if reading 'length' bytes at 'offset' would go past the
+  // end of the block.
+  Status CheckReadBounds(uint64_t offset, size_t length) const;
+
   // A reference to this block's metadata.
   LogBlockRefPtr log_block_;
 
@@ -2702,18 +2812,10 @@ Status LogReadableBlock::ReadV(uint64_t offset, ArrayView<Slice> results) const
                                     return sum + curr.size();
                                   });
 
-  uint64_t read_offset = log_block_->offset() + offset;
-  if (log_block_->length() < offset + read_length) {
-    return Status::IOError("Out-of-bounds read",
-                           Substitute("read of [$0-$1) in block [$2-$3)",
-                                      read_offset,
-                                      read_offset + read_length,
-                                      log_block_->offset(),
-                                      log_block_->offset() + log_block_->length()));
-  }
+  RETURN_NOT_OK(CheckReadBounds(offset, read_length));
 
   MicrosecondsInt64 start_time = GetMonoTimeMicros();
-  RETURN_NOT_OK(log_block_->container()->ReadVData(read_offset, results));
+  RETURN_NOT_OK(log_block_->container()->ReadVData(log_block_->offset() + offset, results));
   MicrosecondsInt64 end_time = GetMonoTimeMicros();
 
   int64_t dur = end_time - start_time;
@@ -2728,6 +2830,52 @@ Status LogReadableBlock::ReadV(uint64_t offset, ArrayView<Slice> results) const
   return Status::OK();
 }
 
+Status LogReadableBlock::ReadVBatch(ArrayView<const ReadVRequest> requests) const {
+  DCHECK(!closed_);
+
+  // Translate the offsets into the container's data file.
+  vector<ReadVRequest> container_requests;
+  container_requests.reserve(requests.size());
+  size_t read_length = 0;
+  for (const auto& r : requests) {
+    size_t length = accumulate(r.results.begin(), r.results.end(), static_cast<size_t>(0),
+                               [&](size_t sum, const Slice& curr) {
+                                 return sum + curr.size();
+                               });
+    RETURN_NOT_OK(CheckReadBounds(r.offset, length));
+    container_requests.push_back({ log_block_->offset() + r.offset, r.results });
+    read_length += length;
+  }
+
+  MicrosecondsInt64 start_time = GetMonoTimeMicros();
+  RETURN_NOT_OK(log_block_->container()->ReadVBatchData(container_requests));
+  MicrosecondsInt64 end_time = GetMonoTimeMicros();
+
+  int64_t dur = end_time - start_time;
+  TRACE_COUNTER_INCREMENT("lbm_read_time_us", dur);
+
+  const char* counter = BUCKETED_COUNTER_NAME("lbm_reads", dur);
+  TRACE_COUNTER_INCREMENT(counter, requests.size());
+
+  if (log_block_->container()->metrics()) {
+    log_block_->container()->metrics()->generic_metrics.total_bytes_read->IncrementBy(read_length);
+  }
+  return Status::OK();
+}
+
+Status LogReadableBlock::CheckReadBounds(uint64_t offset, size_t length) const {
+  if (log_block_->length() < offset + length) {
+    uint64_t read_offset = log_block_->offset() + offset;
+    return Status::IOError("Out-of-bounds read",
+                           Substitute("read of [$0-$1) in block [$2-$3)",
+                                      read_offset,
+                                      read_offset + length,
+                                      log_block_->offset(),
+                                      log_block_->offset() + log_block_->length()));
+  }
+  return Status::OK();
+}
+
 size_t LogReadableBlock::memory_footprint() const {
   return kudu_malloc_usable_size(this);
 }
@@ -2959,6 +3107,11 @@ Status LogBlockManager::Open(FsReport* report, MergeReport need_merage,
           container_result->need_repunching_blocks.begin(),
           container_result->need_repunching_blocks.end());
       container_result->need_repunching_blocks.clear();
+      dir_result->relocated_block_copies.insert(
+          dir_result->relocated_block_copies.end(),
+          container_result->relocated_block_copies.begin(),
+          container_result->relocated_block_copies.end());
+      container_result->relocated_block_copies.clear();
     }
     if (do_repair) {
       dir_results[i] = std::move(dir_result);
@@ -3132,7 +3285,10 @@ Status LogBlockManager::GetOrCreateContainer(const CreateBlockOptions& opts,
       error_manager_->RunErrorNotificationCb(ErrorHandlerType::NO_AVAILABLE_DISKS,
                                              opts.tablet_id,
                                              tenant_id()));
+  return GetOrCreateContainerInDir(dir, container);
+}
 
+Status LogBlockManager::GetOrCreateContainerInDir(Dir* dir, LogBlockContainerRefPtr* container) {
   {
     std::lock_guard<simple_spinlock> l(lock_);
     auto& d = available_containers_by_data_dir_[DCHECK_NOTNULL(dir)];
@@ -3148,8 +3304,8 @@ Status LogBlockManager::GetOrCreateContainer(const CreateBlockOptions& opts,
   Status s = CreateContainer(dir, &new_container);
 
   // We could create a container in a different directory, but there's
-  // currently no point in doing so. On disk failure, the tablet specified by
-  // 'opts' will be shut down, so the returned container would not be used.
+  // currently no point in doing so. On disk failure, the tablets of the
+  // directory will be shut down, so the returned container would not be used.
   HANDLE_DISK_FAILURE(s, error_manager_->RunErrorNotificationCb(
       ErrorHandlerType::DISK_ERROR, dir, tenant_id()));
   RETURN_NOT_OK_PREPEND(s, "Could not create new log block container at " + dir->dir());
@@ -3386,6 +3542,257 @@ Status LogBlockManager::RemoveLogBlock(const BlockId& block_id,
   return Status::OK();
 }
 
+bool LogBlockManager::ReplaceLogBlock(const LogBlockRefPtr& old_lb, LogBlockRefPtr new_lb) {
+  DCHECK_EQ(old_lb->block_id(), new_lb->block_id());
+  auto index = old_lb->block_id().id() & kBlockMapMask;
+  std::lock_guard<simple_spinlock> l(*managed_block_shards_[index].lock);
+  auto& blocks_by_block_id = *managed_block_shards_[index].blocks_by_block_id;
+  auto it = blocks_by_block_id.find(old_lb->block_id());
+  if (it == blocks_by_block_id.end() || it->second.get() != old_lb.get()) {
+    // The block was deleted while it was being relocated.
+    return false;
+  }
+
+  VLOG(2) << Substitute("Relocated block: id $0, from $1 at offset $2 to $3 at offset $4",
+                        old_lb->block_id().ToString(),
+                        old_lb->container()->ToString(), old_lb->offset(),
+                        new_lb->container()->ToString(), new_lb->offset());
+  it->second = std::move(new_lb);
+  return true;
+}
+
+bool LogBlockManager::IsRelocatedBlockCopy(const LogBlockRefPtr& lb) const {
+  LogBlockRefPtr existing;
+  {
+    auto index = lb->block_id().id() & kBlockMapMask;
+    std::lock_guard<simple_spinlock> l(*managed_block_shards_[index].lock);
+    existing = FindPtrOrNull(*managed_block_shards_[index].blocks_by_block_id, lb->block_id());
+  }
+  return existing &&
+      existing->container()->data_dir() == lb->container()->data_dir() &&
+      existing->length() == lb->length();
+}
+
+namespace {
+
+// Returns whether the live blocks of 'container' should be relocated.
+bool ShouldDefragment(const LogBlockContainer& container,
+                      const set<int>& failed_dirs,
+                      DataDirManager* dd_manager) {
+  if (!container.fragmented() ||
+      container.read_only() ||
+      container.blocks_being_written() > 0) {
+    return false;
+  }
+  int uuid_idx;
+  return failed_dirs.empty() ||
+      !dd_manager->FindUuidIndexByDir(container.data_dir(), &uuid_idx) ||
+      !ContainsKey(failed_dirs, uuid_idx);
+}
+
+double DeadRatio(const LogBlockContainer& container) {
+  return static_cast<double>(container.dead_bytes_aligned()) / container.total_bytes();
+}
+
+} // anonymous namespace
+
+LogBlockContainerRefPtr LogBlockManager::FindContainerToDefragment() {
+  const set<int> failed_dirs = dd_manager_->GetFailedDirs();
+  LogBlockContainerRefPtr most_fragmented;
+  double max_dead_ratio = 0;
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (const auto& e : all_containers_by_name_) {
+    const auto& container = e.second;
+    if (!ShouldDefragment(*container, failed_dirs, dd_manager_.get())) {
+      continue;
+    }
+    double dead_ratio = DeadRatio(*container);
+    if (dead_ratio > max_dead_ratio) {
+      max_dead_ratio = dead_ratio;
+      most_fragmented = container;
+    }
+  }
+  return most_fragmented;
+}
+
+void LogBlockManager::GetFragmentationStats(map<string, FragmentationStats>* stats_by_dir) {
+  stats_by_dir->clear();
+  const set<int> failed_dirs = dd_manager_->GetFailedDirs();
+  for (const auto& dd : dd_manager_->dirs()) {
+    int uuid_idx;
+    if (dd_manager_->FindUuidIndexByDir(dd.get(), &uuid_idx) &&
+        ContainsKey(failed_dirs, uuid_idx)) {
+      continue;
+    }
+    (*stats_by_dir)[dd->dir()];
+  }
+
+  FragmentationStats total;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    for (const auto& e : all_containers_by_name_) {
+      const LogBlockContainer& container = *e.second;
+      if (!ShouldDefragment(container, failed_dirs, dd_manager_.get())) {
+        continue;
+      }
+      double dead_ratio = DeadRatio(container);
+      for (auto* stats : { &(*stats_by_dir)[container.data_dir()->dir()], &total }) {
+        stats->fragmented_containers++;
+        stats->fragmented_live_bytes += container.live_bytes_aligned();
+        stats->fragmented_dead_bytes += container.dead_bytes_aligned();
+        stats->max_dead_ratio = std::max(stats->max_dead_ratio, dead_ratio);
+      }
+    }
+  }
+
+  if (metrics()) {
+    metrics()->fragmented_containers->set_value(total.fragmented_containers);
+    metrics()->fragmented_live_bytes->set_value(total.fragmented_live_bytes);
+  }
+}
+
+Status LogBlockManager::DefragmentContainers(int64_t max_bytes, int64_t* bytes_relocated) {
+  CHECK(!opts_.read_only);
+  *bytes_relocated = 0;
+  LogBlockContainerRefPtr container = FindContainerToDefragment();
+  if (!container) {
+    return Status::OK();
+  }
+
+  // The blocks aren't indexed by container: this walks all of the blocks, which
+  // is cheap compared to rewriting them.
+  vector<LogBlockRefPtr> lbs;
+  for (const auto& mb : managed_block_shards_) {
+    std::lock_guard<simple_spinlock> l(*mb.lock);
+    for (const auto& e : *mb.blocks_by_block_id) {
+      if (e.second->container() == container.get()) {
+        lbs.emplace_back(e.second);
+      }
+    }
+  }
+
+  // Relocate the blocks in the order of their offsets, so that the container is
+  // read sequentially. The first block is relocated even if it exceeds the
+  // budget, so that every run makes progress.
+  std::sort(lbs.begin(), lbs.end(), [](const LogBlockRefPtr& a, const LogBlockRefPtr& b) {
+    return a->offset() < b->offset();
+  });
+  int64_t bytes_to_relocate = 0;
+  size_t num_blocks = 0;
+  for (; num_blocks < lbs.size(); num_blocks++) {
+    int64_t length = lbs[num_blocks]->length();
+    if (num_blocks > 0 && bytes_to_relocate + length > max_bytes) {
+      break;
+    }
+    bytes_to_relocate += length;
+  }
+  lbs.resize(num_blocks);
+
+  LOG(INFO) << Substitute("Relocating $0 live block(s) ($1 bytes) of fragmented container $2 "
+                          "($3 of $4 bytes are dead)",
+                          lbs.size(), bytes_to_relocate, container->ToString(),
+                          container->dead_bytes_aligned(), container->total_bytes());
+  return RelocateBlocks(container->data_dir(), lbs, bytes_relocated);
+}
+
+Status LogBlockManager::RelocateBlocks(Dir* dir,
+                                       const vector<LogBlockRefPtr>& lbs,
+                                       int64_t* bytes_relocated) {
+  static constexpr int64_t kCopyChunkBytes = 1024 * 1024;
+
+  // 1. Copy the blocks. Like the blocks of a flush, the copies are written one
+  //    after the other, mostly into the same container.
+  vector<unique_ptr<LogWritableBlock>> copies;
+  copies.reserve(lbs.size());
+  faststring buf;
+  for (const auto& lb : lbs) {
+    LogBlockContainerRefPtr container;
+    RETURN_NOT_OK(GetOrCreateContainerInDir(dir, &container));
+    unique_ptr<LogWritableBlock> copy(new LogWritableBlock(
+        container, lb->block_id(), container->next_block_offset()));
+    copy->MarkAsRelocation();
+    for (int64_t offset = 0; offset < lb->length(); offset += kCopyChunkBytes) {
+      int64_t length = std::min(kCopyChunkBytes, lb->length() - offset);
+      buf.resize(length);
+      Slice chunk(buf.data(), length);
+      RETURN_NOT_OK(lb->container()->ReadData(lb->offset() + offset, chunk));
+      RETURN_NOT_OK(copy->Append(chunk));
+    }
+    RETURN_NOT_OK(copy->Finalize());
+    copies.emplace_back(std::move(copy));
+  }
+
+  unordered_map<LogBlockContainer*, vector<size_t>> copy_idxs_by_container;
+  for (size_t i = 0; i < copies.size(); i++) {
+    LookupOrInsert(&copy_idxs_by_container, copies[i]->container(), {}).emplace_back(i);
+  }
+
+  // 2. Make the copies durable, along with their creation records, and swap
+  //    them in. A copy whose original was deleted in the meantime is garbage.
+  Status first_failure;
+  unordered_map<LogBlockContainer*, vector<LogBlockRefPtr>> garbage_by_container;
+  for (const auto& [container, idxs] : copy_idxs_by_container) {
+    vector<LogWritableBlock*> blocks;
+    blocks.reserve(idxs.size());
+    for (auto i : idxs) {
+      blocks.emplace_back(copies[i].get());
+    }
+    Status s = container->DoCloseBlocks(blocks, LogBlockContainer::SyncMode::SYNC);
+    if (!s.ok()) {
+      if (first_failure.ok()) first_failure = s;
+      continue;
+    }
+
+    for (auto i : idxs) {
+      const auto& lb = lbs[i];
+      LogBlockRefPtr copy_lb(new LogBlock(LogBlockContainerRefPtr(container), lb->block_id(),
+                                          copies[i]->block_offset(),
+                                          copies[i]->block_length()));
+      mem_tracker_->Consume(kudu_malloc_usable_size(copy_lb.get()));
+      container->BlockCreated(copy_lb);
+      LogBlockRefPtr garbage;
+      if (ReplaceLogBlock(lb, copy_lb)) {
+        *bytes_relocated += lb->length();
+        if (metrics()) {
+          metrics()->blocks_relocated->Increment();
+          metrics()->bytes_relocated->IncrementBy(lb->length());
+        }
+        garbage = lb;
+      } else {
+        garbage = std::move(copy_lb);
+      }
+      mem_tracker_->Release(kudu_malloc_usable_size(garbage.get()));
+      LookupOrInsert(&garbage_by_container, garbage->container(), {})
+          .emplace_back(std::move(garbage));
+    }
+  }
+
+  // 3. Delete the garbage blocks. As for any deletion, the deletion records
+  //    aren't synced: if they are lost, both the original and the copy of a
+  //    block are found at startup, and the copy is deleted then.
+  auto transaction = std::make_shared<LogBlockDeletionTransaction>(this);
+  for (auto& [container, garbage] : garbage_by_container) {
+    for (const auto& lb : garbage) {
+      container->BlockDeleted(lb);
+    }
+    vector<BlockId> deleted_block_ids;
+    Status s = container->RemoveBlockIdsFromMetadata(garbage, &deleted_block_ids);
+    if (s.ok()) {
+      container->PostWorkOfBlocksDeleted();
+    } else {
+      if (first_failure.ok()) {
+        first_failure = s.CloneAndPrepend("Unable to append deletion record(s) to block metadata");
+      }
+      garbage.resize(deleted_block_ids.size());
+    }
+    for (const auto& lb : garbage) {
+      lb->RegisterDeletion(transaction);
+      transaction->AddBlock(lb);
+    }
+  }
+  return first_failure;
+}
+
 void LogBlockManager::OpenDataDir(
     Dir* dir,
     vector<unique_ptr<internal::LogBlockContainerLoadResult>>* results,
@@ -3584,7 +3991,17 @@ void LogBlockManager::LoadContainer(Dir* dir,
   int64_t mem_usage = 0;
   for (UntrackedBlockMap::value_type& e : live_blocks) {
     int block_mem = kudu_malloc_usable_size(e.second.get());
-    if (!AddLogBlock(std::move(e.second))) {
+    if (!AddLogBlock(e.second)) {
+      // If the server crashed while relocating a block, both of its copies
+      // may be alive. They are complete and identical, so the one found last
+      // is deleted.
+      if (IsRelocatedBlockCopy(e.second)) {
+        LOG(WARNING) << Substitute("Found a second copy of block $0 in container $1, left "
+                                   "behind by an interrupted relocation; deleting it",
+                                   e.first.ToString(), container->ToString());
+        result->relocated_block_copies.emplace_back(std::move(e.second));
+        continue;
+      }
       // TODO(adar): track as an inconsistency?
       LOG(FATAL) << "Found duplicate CREATE record for block " << e.first
                  << " which already is alive from another container when "
@@ -3614,7 +4031,8 @@ void LogBlockManager::RepairTask(Dir* dir, internal::LogBlockContainerLoadResult
                           &result->report,
                           std::move(result->need_repunching_blocks),
                           std::move(result->dead_containers),
-                          std::move(result->low_live_block_containers));
+                          std::move(result->low_live_block_containers),
+                          std::move(result->relocated_block_copies));
 }
 
 #define RETURN_NOT_OK_LBM_DISK_FAILURE_PREPEND(status_expr, msg) do { \
@@ -3839,7 +4257,8 @@ Status LogBlockManager::Repair(
     FsReport* report,
     vector<LogBlockRefPtr> need_repunching,
     vector<LogBlockContainerRefPtr> dead_containers,
-    const ContainerBlocksByName& low_live_block_containers) {
+    const ContainerBlocksByName& low_live_block_containers,
+    vector<LogBlockRefPtr> relocated_block_copies) {
   if (opts_.read_only) {
     LOG(INFO) << "Read-only block manager, skipping repair";
     return Status::OK();
@@ -3876,7 +4295,27 @@ Status LogBlockManager::Repair(
   // 4. Repair the containers according to 'report'.
   RETURN_NOT_OK(DoRepair(dir, report, low_live_block_containers, containers_by_name));
 
-  // 5. Repunch all requested holes. Any excess space reclaimed was already
+  // 5. Delete the extra copies of the relocated blocks, which are punched out
+  // along with the other holes.
+  unordered_map<LogBlockContainer*, vector<LogBlockRefPtr>> copies_by_container;
+  for (auto& lb : relocated_block_copies) {
+    auto& copies = LookupOrInsert(&copies_by_container, lb->container(), {});
+    copies.emplace_back(std::move(lb));
+  }
+  for (auto& [container, copies] : copies_by_container) {
+    for (const auto& lb : copies) {
+      container->BlockDeleted(lb);
+    }
+    vector<BlockId> deleted_block_ids;
+    Status s = container->RemoveBlockIdsFromMetadata(copies, &deleted_block_ids);
+    WARN_NOT_OK_LBM_DISK_FAILURE(s, Substitute(
+        "could not delete the relocated block copies of container $0", container->ToString()));
+    copies.resize(deleted_block_ids.size());
+    need_repunching.insert(need_repunching.end(), copies.begin(), copies.end());
+  }
+  copies_by_container.clear();
+
+  // 6. Repunch all requested holes. Any excess space reclaimed was already
   // tracked by LBMFullContainerSpaceCheck.
   //
   // Register deletions to a single BlockDeletionTransaction. So, the repunched
@@ -3887,7 +4326,7 @@ Status LogBlockManager::Repair(
     transaction->AddBlock(b);
   }
 
-  // 6. Clearing this vector drops the last references to the LogBlocks within,
+  // 7. Clearing this vector drops the last references to the LogBlocks within,
   // triggering the repunching operations.
   need_repunching.clear();
 
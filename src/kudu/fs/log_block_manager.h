@@ -207,6 +207,45 @@ class LogBlockManager : public BlockManager {
 
   std::string tenant_id() const override { return tenant_id_; }
 
+  // The fragmentation of the containers of a data directory.
+  //
+  // Deleting a block punches a hole in its container, so that the live blocks
+  // of old containers end up scattered over the data file. A full container
+  // is considered fragmented once the ratio of its deleted bytes to all of its
+  // bytes reaches --log_container_defrag_min_dead_ratio.
+  struct FragmentationStats {
+    // The number of fragmented containers.
+    int64_t fragmented_containers = 0;
+
+    // The bytes of the live blocks of the fragmented containers, i.e. the
+    // bytes to rewrite in order to defragment them.
+    int64_t fragmented_live_bytes = 0;
+
+    // The bytes of the deleted blocks of the fragmented containers.
+    int64_t fragmented_dead_bytes = 0;
+
+    // The highest ratio of deleted bytes among the fragmented containers.
+    double max_dead_ratio = 0;
+  };
+
+  // Computes the fragmentation of the containers of each healthy data
+  // directory, keyed by the path of the directory, and updates the
+  // fragmentation metrics.
+  void GetFragmentationStats(std::map<std::string, FragmentationStats>* stats_by_dir);
+
+  // Rewrites the live blocks of the most fragmented container into other
+  // containers of the same data directory, relocating at most 'max_bytes'
+  // bytes of blocks, but at least one block. The old container is deleted
+  // once all of its blocks are relocated.
+  //
+  // Relocated blocks keep their IDs: readers which opened a block before its
+  // relocation keep reading the old copy, which is only punched out once they
+  // close it.
+  //
+  // Sets 'bytes_relocated' to the bytes of the blocks relocated, which is 0 if
+  // no container is fragmented.
+  Status DefragmentContainers(int64_t max_bytes, int64_t* bytes_relocated);
+
  protected:
   // Note: all objects passed as pointers should remain alive for the lifetime
   // of the block manager.
@@ -304,6 +343,9 @@ class LogBlockManager : public BlockManager {
   Status GetOrCreateContainer(const CreateBlockOptions& opts,
                               LogBlockContainerRefPtr* container);
 
+  // Like GetOrCreateContainer(), but in the given data directory.
+  Status GetOrCreateContainerInDir(Dir* dir, LogBlockContainerRefPtr* container);
+
   // Indicate that this container is no longer in use and can be handed out
   // to other writers.
   void MakeContainerAvailable(LogBlockContainerRefPtr container);
@@ -334,6 +376,31 @@ class LogBlockManager : public BlockManager {
   // Returns true if the LogBlock was successfully added, false if it was already present.
   bool AddLogBlock(LogBlockRefPtr lb);
 
+  // Replaces 'old_lb' with 'new_lb', a copy of the same block in another
+  // container, in the in-memory data structures.
+  //
+  // Returns false if 'old_lb' isn't present anymore, i.e. if it was deleted.
+  bool ReplaceLogBlock(const LogBlockRefPtr& old_lb, LogBlockRefPtr new_lb);
+
+  // Returns whether 'lb', which couldn't be added because a block with the
+  // same ID is already present, is a copy of that block left behind by a
+  // relocation interrupted by a crash: both copies are then in the same data
+  // directory and have the same length.
+  bool IsRelocatedBlockCopy(const LogBlockRefPtr& lb) const;
+
+  // Returns the most fragmented container of a healthy data directory, or
+  // nullptr if no container is fragmented.
+  LogBlockContainerRefPtr FindContainerToDefragment();
+
+  // Copies the live blocks 'lbs' to other containers of 'dir', swapping the
+  // copies in and deleting the originals. The copies of blocks deleted in the
+  // meantime are deleted in turn.
+  //
+  // Adds the bytes of the relocated blocks to 'bytes_relocated'.
+  Status RelocateBlocks(Dir* dir,
+                        const std::vector<LogBlockRefPtr>& lbs,
+                        int64_t* bytes_relocated);
+
   // Removes the given set of LogBlocks from in-memory data structures, and
   // adds the block deletion metadata to record the on-disk deletion.
   // The 'log_blocks' out parameter will be set with the LogBlocks that were
@@ -362,13 +429,15 @@ class LogBlockManager : public BlockManager {
   // 2. Containers in 'dead_containers' will be deleted from disk.
   // 3. Containers in 'low_live_block_containers' will have their metadata
   //    files compacted.
+  // 4. Blocks in 'relocated_block_copies' will be deleted.
   //
   // Returns an error if repairing a fatal inconsistency failed.
   Status Repair(Dir* dir,
                 FsReport* report,
                 std::vector<LogBlockRefPtr> need_repunching,
                 std::vector<LogBlockContainerRefPtr> dead_containers,
-                const ContainerBlocksByName& low_live_block_containers);
+                const ContainerBlocksByName& low_live_block_containers,
+                std::vector<LogBlockRefPtr> relocated_block_copies);
 
   // Fetch all the containers we're going to repair.
   //
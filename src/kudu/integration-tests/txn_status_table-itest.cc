@@ -416,6 +416,30 @@ TEST_F(TxnStatusTableITest, TestCreateTxnStatusTablePartitions) {
   NO_FATALS(CheckTableTypes({ { TableTypePB::TXN_STATUS_TABLE, 3 } }));
 }
 
+// Test that the ranges of a hash-partitioned transaction status table are
+// spread over several transaction status tablets, each coordinating its own
+// share of the transactions.
+TEST_F(TxnStatusTableITest, TestHashPartitionedTxnStatusTable) {
+  constexpr int kNumHashPartitions = 3;
+  constexpr int kPartitionWidth = 10;
+  ASSERT_OK(txn_sys_client_->CreateTxnStatusTable(
+      kPartitionWidth, /*num_replicas=*/1, kNumHashPartitions));
+  NO_FATALS(CheckTableTypes({ { TableTypePB::TXN_STATUS_TABLE, kNumHashPartitions } }));
+
+  // The ranges added later are hash-partitioned the same way.
+  ASSERT_OK(txn_sys_client_->AddTxnStatusTableRange(kPartitionWidth, 2 * kPartitionWidth));
+  NO_FATALS(CheckTableTypes({ { TableTypePB::TXN_STATUS_TABLE, 2 * kNumHashPartitions } }));
+
+  ASSERT_OK(txn_sys_client_->OpenTxnStatusTable());
+  for (int64_t txn_id = 0; txn_id < 2 * kPartitionWidth; txn_id++) {
+    ASSERT_OK(txn_sys_client_->BeginTransaction(txn_id, kUser));
+    ASSERT_OK(txn_sys_client_->RegisterParticipant(txn_id, ParticipantId(1), kUser));
+    TxnStatusEntryPB txn_status;
+    ASSERT_OK(txn_sys_client_->GetTransactionStatus(txn_id, kUser, &txn_status));
+    ASSERT_EQ(TxnStatePB::OPEN, txn_status.state());
+  }
+}
+
 // Test that tablet servers can host both transaction status tablets and
 // regular tablets.
 TEST_F(TxnStatusTableITest, TestTxnStatusTableColocatedWithTables) {
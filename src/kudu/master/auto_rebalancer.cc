@@ -47,6 +47,7 @@
 #include "kudu/master/ts_descriptor.h"
 #include "kudu/master/ts_manager.h"
 #include "kudu/rebalance/cluster_status.h"
+#include "kudu/rebalance/load_balancing_algo.h"
 #include "kudu/rebalance/placement_policy_util.h"
 #include "kudu/rebalance/rebalance_algo.h"
 #include "kudu/rebalance/rebalancer.h"
@@ -55,6 +56,7 @@
 #include "kudu/security/init.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/cow_object.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
@@ -84,13 +86,17 @@ using kudu::master::TSManager;
 using kudu::pb_util::SecureShortDebugString;
 using kudu::rebalance::BuildTabletExtraInfoMap;
 using kudu::rebalance::ClusterInfo;
+using kudu::rebalance::ClusterLoadInfo;
 using kudu::rebalance::ClusterLocalityInfo;
 using kudu::rebalance::ClusterRawInfo;
+using kudu::rebalance::LoadBalancingAlgo;
+using kudu::rebalance::LoadMove;
 using kudu::rebalance::PlacementPolicyViolationInfo;
 using kudu::rebalance::Rebalancer;
 using kudu::rebalance::SelectReplicaToMove;
 using kudu::rebalance::TableReplicaMove;
 using kudu::rebalance::TabletExtraInfo;
+using kudu::rebalance::TabletLoadInfo;
 using kudu::rebalance::TabletsPlacementInfo;
 using kudu::rpc::MessengerBuilder;
 using kudu::rpc::RpcController;
@@ -137,6 +143,30 @@ DEFINE_uint32(auto_rebalancing_wait_for_replica_moves_seconds, 1,
               "How long to wait before checking to see if the scheduled replica movement "
               "in this iteration of auto-rebalancing has completed.");
 
+DEFINE_bool(auto_rebalancing_load_balancing_enabled, false,
+            "Whether the auto-rebalancer evens out the read and write load of the tablet "
+            "servers once their replica distribution is balanced, by swapping the "
+            "leadership or the replicas of tablets of the same table between tablet "
+            "servers. The load of the replicas is reported by the tablet servers, see "
+            "--heartbeat_replica_load_report_interval_secs.");
+TAG_FLAG(auto_rebalancing_load_balancing_enabled, experimental);
+TAG_FLAG(auto_rebalancing_load_balancing_enabled, runtime);
+
+DEFINE_double(auto_rebalancing_server_load_imbalance_threshold, 0.2,
+              "The auto-rebalancer moves load off the most loaded tablet server while "
+              "its load is more than (1 + this threshold) times the mean load of the tablet "
+              "servers. Only used if --auto_rebalancing_load_balancing_enabled is set.");
+TAG_FLAG(auto_rebalancing_server_load_imbalance_threshold, experimental);
+TAG_FLAG(auto_rebalancing_server_load_imbalance_threshold, runtime);
+
+DEFINE_double(auto_rebalancing_leader_write_load_factor, 2.0,
+              "How much more loaded a leader replica is than a follower replica when "
+              "writing the same rows, with the leader replicating the writes and "
+              "serving the clients. Only used if "
+              "--auto_rebalancing_load_balancing_enabled is set.");
+TAG_FLAG(auto_rebalancing_leader_write_load_factor, experimental);
+TAG_FLAG(auto_rebalancing_leader_write_load_factor, runtime);
+
 DECLARE_bool(auto_rebalancing_enabled);
 
 namespace kudu {
@@ -250,6 +280,18 @@ void AutoRebalancerTask::RunLoop() {
                                  s.ToString());
       continue;
     }
+    if (replica_moves.empty() && FLAGS_auto_rebalancing_load_balancing_enabled) {
+      // The replica distribution is balanced: even out the load instead.
+      vector<LoadMove> leader_moves;
+      s = GetLoadMoves(raw_info, &replica_moves, &leader_moves);
+      if (!s.ok()) {
+        LOG(WARNING) << Substitute("could not retrieve auto-rebalancing load moves: $0",
+                                   s.ToString());
+        continue;
+      }
+      WARN_NOT_OK(ExecuteLeaderTransfers(leader_moves),
+                  "failed to transfer tablet leadership");
+    }
     WARN_NOT_OK(ExecuteMoves(replica_moves),
                 "failed to send replica move request");
     moves_scheduled_this_round_for_test_ = replica_moves.size();
@@ -378,6 +420,110 @@ Status AutoRebalancerTask::GetMovesUsingRebalancingAlgo(
   return Status::OK();
 }
 
+Status AutoRebalancerTask::GetLoadMoves(
+    const ClusterRawInfo& raw_info,
+    vector<Rebalancer::ReplicaMove>* replica_moves,
+    vector<LoadMove>* leader_moves) {
+  ClusterLoadInfo load_info;
+  unordered_map<string, ReplicaLoadMap> loads_by_ts;
+  for (const auto& summary : raw_info.tserver_summaries) {
+    shared_ptr<TSDescriptor> desc;
+    if (!ts_manager_->LookupTSByUUID(summary.uuid, &desc)) {
+      return Status::NotFound(Substitute("tserver $0 not found", summary.uuid));
+    }
+    auto loads = desc->replica_loads();
+    if (!loads) {
+      // The rates are derived from two consecutive reports: wait for them.
+      VLOG(1) << Substitute("tserver $0 hasn't reported its replica load yet", summary.uuid);
+      return Status::OK();
+    }
+    EmplaceOrDie(&loads_by_ts, summary.uuid, std::move(*loads));
+    EmplaceOrDie(&load_info.location_by_ts_id, summary.uuid, summary.ts_location);
+  }
+
+  const double leader_write_factor = FLAGS_auto_rebalancing_leader_write_load_factor;
+  for (const auto& tablet : raw_info.tablet_summaries) {
+    if (tablet.result != HealthCheckResult::HEALTHY) {
+      continue;
+    }
+    TabletLoadInfo tablet_load;
+    tablet_load.tablet_id = tablet.id;
+    tablet_load.table_id = tablet.table_id;
+    bool load_known = true;
+    for (const auto& r : tablet.replicas) {
+      const ReplicaLoad* load = FindOrNull(FindOrDie(loads_by_ts, r.ts_uuid), tablet.id);
+      if (!load) {
+        load_known = false;
+        break;
+      }
+      rebalance::ReplicaLoadInfo replica_load;
+      replica_load.ts_uuid = r.ts_uuid;
+      replica_load.is_leader = r.is_leader;
+      replica_load.load = load->rows_read_per_sec +
+          load->rows_written_per_sec * (r.is_leader ? leader_write_factor : 1);
+      replica_load.on_disk_size = load->on_disk_size;
+      tablet_load.replicas.emplace_back(std::move(replica_load));
+    }
+    // Leave out the tablets which replicas were just added.
+    if (load_known) {
+      load_info.tablets.emplace_back(std::move(tablet_load));
+    }
+  }
+
+  const auto max_moves =
+      FLAGS_auto_rebalancing_max_moves_per_server * raw_info.tserver_summaries.size();
+  LoadBalancingAlgo algo(FLAGS_auto_rebalancing_server_load_imbalance_threshold);
+  vector<LoadMove> moves;
+  RETURN_NOT_OK(algo.GetNextMoves(load_info, static_cast<int>(max_moves), &moves));
+  for (auto& move : moves) {
+    if (move.type == LoadMove::Type::LEADER) {
+      leader_moves->emplace_back(std::move(move));
+    } else {
+      replica_moves->push_back({ std::move(move.tablet_id), std::move(move.from),
+                                 std::move(move.to) });
+    }
+  }
+  return Status::OK();
+}
+
+Status AutoRebalancerTask::ExecuteLeaderTransfers(const vector<LoadMove>& leader_moves) {
+  const auto transfer = [&](const LoadMove& move) -> Status {
+    DCHECK(move.type == LoadMove::Type::LEADER);
+    shared_ptr<TSDescriptor> desc;
+    if (!ts_manager_->LookupTSByUUID(move.from, &desc)) {
+      return Status::NotFound("Could not find leader replica's tserver");
+    }
+    shared_ptr<ConsensusServiceProxy> proxy;
+    RETURN_NOT_OK(desc->GetConsensusProxy(messenger_, &proxy));
+
+    LeaderStepDownRequestPB req;
+    LeaderStepDownResponsePB resp;
+    RpcController rpc;
+    req.set_dest_uuid(move.from);
+    req.set_tablet_id(move.tablet_id);
+    req.set_mode(LeaderStepDownMode::GRACEFUL);
+    req.set_new_leader_uuid(move.to);
+    rpc.set_timeout(MonoDelta::FromSeconds(FLAGS_auto_rebalancing_rpc_timeout_seconds));
+    RETURN_NOT_OK(proxy->LeaderStepDown(req, &resp, &rpc));
+    if (resp.has_error()) {
+      return StatusFromPB(resp.error().status());
+    }
+    return Status::OK();
+  };
+
+  // A failed transfer, e.g. because the leadership changed in the meantime,
+  // doesn't prevent the others.
+  Status first_error;
+  for (const auto& move : leader_moves) {
+    Status s = transfer(move);
+    if (!s.ok() && first_error.ok()) {
+      first_error = s.CloneAndPrepend(Substitute("tablet $0, TS $1 -> TS $2",
+                                                 move.tablet_id, move.from, move.to));
+    }
+  }
+  return first_error;
+}
+
 Status AutoRebalancerTask::GetTabletLeader(
     const string& tablet_id,
     string* leader_uuid,
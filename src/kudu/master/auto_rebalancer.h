@@ -38,6 +38,7 @@ class Thread;
 namespace rebalance {
 class RebalancingAlgo;
 struct ClusterLocalityInfo;
+struct LoadMove;
 struct TabletsPlacementInfo;
 } // namespace rebalance
 
@@ -122,6 +123,21 @@ class AutoRebalancerTask {
       const rebalance::TabletsPlacementInfo& placement_info,
       std::vector<rebalance::Rebalancer::ReplicaMove>* replica_moves);
 
+  // Gets the replica moves and the leadership transfers which even out the
+  // read and write load of the tablet servers, as reported in their
+  // heartbeats, without changing the replica distribution. The replica moves
+  // are added to 'replica_moves', and the leadership transfers to
+  // 'leader_moves'. Both are left empty if a tablet server hasn't reported
+  // the load of its replicas yet.
+  Status GetLoadMoves(
+      const rebalance::ClusterRawInfo& raw_info,
+      std::vector<rebalance::Rebalancer::ReplicaMove>* replica_moves,
+      std::vector<rebalance::LoadMove>* leader_moves);
+
+  // Asks the leader replicas specified in 'leader_moves' to transfer their
+  // leadership. Returns the first non-OK status encountered, if any.
+  Status ExecuteLeaderTransfers(const std::vector<rebalance::LoadMove>& leader_moves);
+
   // Gets information on the current leader replica for the specified tablet and
   // populates the 'leader_uuid' and 'leader_hp' output parameters. The
   // function returns Status::NotFound() if no replica is a leader for the tablet.
@@ -103,6 +103,39 @@ TEST(TableInfoTest, TestAssignmentRanges) {
   }
 }
 
+// Test that the metadata snapshots of a tablet are reused until the metadata
+// is mutated, and that snapshots taken earlier aren't affected by mutations.
+TEST(TabletInfoTest, MetadataSnapshot) {
+  scoped_refptr<TableInfo> table(new TableInfo(CURRENT_TEST_NAME()));
+  scoped_refptr<TabletInfo> tablet(new TabletInfo(table, "tablet"));
+  {
+    TabletMetadataLock l(tablet.get(), LockMode::WRITE);
+    l.mutable_data()->pb.set_state(SysTabletsEntryPB::RUNNING);
+    l.Commit();
+  }
+  const auto running = tablet->MetadataSnapshot();
+  ASSERT_TRUE(running->is_running());
+  ASSERT_EQ(running.get(), tablet->MetadataSnapshot().get());
+
+  // An aborted mutation doesn't change the metadata.
+  {
+    TabletMetadataLock l(tablet.get(), LockMode::WRITE);
+    l.mutable_data()->pb.set_state(SysTabletsEntryPB::DELETED);
+  }
+  ASSERT_EQ(running.get(), tablet->MetadataSnapshot().get());
+
+  {
+    TabletMetadataLock l(tablet.get(), LockMode::WRITE);
+    l.mutable_data()->set_state(SysTabletsEntryPB::DELETED, "deleted");
+    l.Commit();
+  }
+  const auto deleted = tablet->MetadataSnapshot();
+  ASSERT_NE(running.get(), deleted.get());
+  ASSERT_TRUE(deleted->is_deleted());
+  ASSERT_EQ("deleted", deleted->pb.state_msg());
+  ASSERT_TRUE(running->is_running());
+}
+
 TEST(TableInfoTest, GetTableLocationsLegacyCustomHashSchemas) {
   const string table_id = CURRENT_TEST_NAME();
   scoped_refptr<TableInfo> table(new TableInfo(table_id));
@@ -116,6 +116,7 @@
 #include "kudu/master/ts_manager.h"
 #include "kudu/rpc/messenger.h" // IWYU pragma: keep
 #include "kudu/rpc/remote_user.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/rpc_context.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/security/cert.h"
@@ -129,10 +130,12 @@
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/ops/op_tracker.h"
 #include "kudu/tablet/tablet_replica.h"
+#include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_admin.pb.h"
 #include "kudu/tserver/tserver_admin.proxy.h" // IWYU pragma: keep
 #include "kudu/util/bitmap.h"
 #include "kudu/util/cache_metrics.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/condition_variable.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/fault_injection.h"
@@ -438,6 +441,25 @@ DEFINE_uint32(default_deleted_table_reserve_seconds, 0,
 TAG_FLAG(default_deleted_table_reserve_seconds, advanced);
 TAG_FLAG(default_deleted_table_reserve_seconds, runtime);
 
+DEFINE_int32(catalog_manager_delete_tablets_batch_size, 100,
+             "Maximum number of tablets per DeleteTablets RPC sent to a tablet server "
+             "when deleting a table: the replicas of the tablets of the table hosted "
+             "by a tablet server are deleted with a few batched RPCs rather than an "
+             "RPC per replica. If 1 or less, or if the tablet server doesn't support "
+             "batches, a DeleteTablet RPC is sent per replica.");
+TAG_FLAG(catalog_manager_delete_tablets_batch_size, advanced);
+TAG_FLAG(catalog_manager_delete_tablets_batch_size, runtime);
+
+DEFINE_int32(catalog_manager_create_tablets_batch_size, 100,
+             "Maximum number of tablets per CreateTablets RPC sent to a tablet server "
+             "when creating the tablets of a table: the replicas hosted by a tablet "
+             "server are created with a few batched RPCs rather than an RPC per "
+             "replica, and concurrently by the tablet server. If 1 or less, or if the "
+             "tablet server doesn't support batches, a CreateTablet RPC is sent per "
+             "replica.");
+TAG_FLAG(catalog_manager_create_tablets_batch_size, advanced);
+TAG_FLAG(catalog_manager_create_tablets_batch_size, runtime);
+
 DECLARE_string(hive_metastore_uris);
 
 bool ValidateDeletedTableReserveSeconds()  {
@@ -459,6 +481,16 @@ DECLARE_string(ranger_config_path);
 
 METRIC_DEFINE_entity(table);
 
+METRIC_DEFINE_histogram(server, table_creation_duration_ms,
+                        "Table Creation Duration",
+                        kudu::MetricUnit::kMilliseconds,
+                        "Time from the CreateTable request for a table to its creation "
+                        "being reported as done, i.e. all its tablets running, to a client "
+                        "polling for it. Only covers the tables created since the master "
+                        "became the leader.",
+                        kudu::MetricLevel::kInfo,
+                        3600000LU, 2);
+
 using base::subtle::NoBarrier_CompareAndSwap;
 using base::subtle::NoBarrier_Load;
 using google::protobuf::Map;
@@ -492,6 +524,7 @@ using kudu::tablet::TabletReplica;
 using kudu::tablet::TabletStatePB;
 using kudu::tserver::TabletServerErrorPB;
 using std::make_optional;
+using std::map;
 using std::nullopt;
 using std::optional;
 using std::pair;
@@ -977,7 +1010,9 @@ CatalogManager::CatalogManager(Master* master)
       hms_notification_log_event_id_(-1),
       leader_lock_(RWMutex::Priority::PREFER_WRITING),
       ipki_private_key_password_(""),
-      tsk_private_key_password_("") {
+      tsk_private_key_password_(""),
+      table_creation_duration_ms_(
+          METRIC_table_creation_duration_ms.Instantiate(master_->metric_entity())) {
   if (RangerAuthzProvider::IsEnabled()) {
     authz_provider_.reset(new RangerAuthzProvider(master_->fs_manager()->GetEnv(),
                                                   master_->metric_entity()));
@@ -1891,6 +1926,14 @@ Status ValidateClientSchema(const optional<string>& name,
     if (!s.ok()) {
       return s.CloneAndPrepend(Substitute("invalid encoding for column '$0'", col.name()));
     }
+
+    // Check that the compression level is valid for the specified codec.
+    const CompressionCodec* codec;
+    s = GetCompressionCodec(col.attributes().compression,
+                            col.attributes().compression_level, &codec);
+    if (!s.ok() && !s.IsNotFound()) {
+      return s.CloneAndPrepend(Substitute("invalid compression for column '$0'", col.name()));
+    }
   }
   return Status::OK();
 }
@@ -1903,6 +1946,7 @@ Status CatalogManager::CreateTable(const CreateTableRequestPB* orig_req,
                                    CreateTableResponsePB* resp,
                                    rpc::RpcContext* rpc) {
   leader_lock_.AssertAcquiredForReading();
+  const MonoTime start_time = MonoTime::Now();
 
   // Copy the request, so we can fill in some defaults.
   CreateTableRequestPB req = *orig_req;
@@ -2105,6 +2149,7 @@ Status CatalogManager::CreateTable(const CreateTableRequestPB* orig_req,
   // d. Create the in-memory representation of the new table and its tablets.
   //    It's not yet in any global maps; that will happen in step g below.
   table = CreateTableInfo(req, schema, partition_schema, std::move(extra_config_pb));
+  table->set_create_start_time(start_time);
   vector<scoped_refptr<TabletInfo>> tablets;
   auto abort_mutations = MakeScopedCleanup([&table, &tablets]() {
     table->mutable_metadata()->AbortMutation();
@@ -2244,7 +2289,12 @@ Status CatalogManager::IsCreateTableDone(const IsCreateTableDoneRequestPB* req,
 
   // 2. Verify if the create is in-progress
   TRACE("Verify if the table creation is in progress for $0", table->ToString());
-  resp->set_done(!table->IsCreateInProgress());
+  const bool done = !table->IsCreateInProgress();
+  resp->set_done(done);
+  MonoDelta duration;
+  if (done && table->MarkCreateDone(&duration)) {
+    table_creation_duration_ms_->Increment(duration.ToMilliseconds());
+  }
 
   return Status::OK();
 }
@@ -4727,6 +4777,31 @@ class RetrySpecificTSRpcTask : public RetryingTSRpcTask {
   const string permanent_uuid_;
 };
 
+// Fills 'req' to create the replica of 'tablet' hosted by the tablet server
+// with 'permanent_uuid'.
+//
+// The tablet lock must be acquired for reading before making this call.
+static void FillCreateTabletRequest(const string& permanent_uuid,
+                                    const scoped_refptr<TabletInfo>& tablet,
+                                    const TabletMetadataLock& tablet_lock,
+                                    tserver::CreateTabletRequestPB* req) {
+  TableMetadataLock table_lock(tablet->table().get(), LockMode::READ);
+  req->set_dest_uuid(permanent_uuid);
+  req->set_table_id(tablet->table()->id());
+  req->set_tablet_id(tablet->id());
+  req->mutable_partition()->CopyFrom(tablet_lock.data().pb.partition());
+  req->set_table_name(table_lock.data().pb.name());
+  req->mutable_schema()->CopyFrom(table_lock.data().pb.schema());
+  req->mutable_partition_schema()->CopyFrom(
+      table_lock.data().pb.partition_schema());
+  req->mutable_config()->CopyFrom(
+      tablet_lock.data().pb.consensus_state().committed_config());
+  req->mutable_extra_config()->CopyFrom(
+      table_lock.data().pb.extra_config());
+  req->set_dimension_label(tablet_lock.data().pb.dimension_label());
+  req->set_table_type(table_lock.data().pb.table_type());
+}
+
 // Fire off the async create tablet.
 // This requires that the new tablet info is locked for write, and the
 // consensus configuration information has been filled into the 'dirty' data.
@@ -4741,22 +4816,18 @@ class AsyncCreateReplica : public RetrySpecificTSRpcTask {
     : RetrySpecificTSRpcTask(master, permanent_uuid, tablet->table().get()),
       tablet_id_(tablet->id()) {
     deadline_ = start_ts_ + MonoDelta::FromMilliseconds(FLAGS_tablet_creation_timeout_ms);
+    FillCreateTabletRequest(permanent_uuid, tablet, tablet_lock, &req_);
+  }
 
-    TableMetadataLock table_lock(tablet->table().get(), LockMode::READ);
-    req_.set_dest_uuid(permanent_uuid);
-    req_.set_table_id(tablet->table()->id());
-    req_.set_tablet_id(tablet->id());
-    req_.mutable_partition()->CopyFrom(tablet_lock.data().pb.partition());
-    req_.set_table_name(table_lock.data().pb.name());
-    req_.mutable_schema()->CopyFrom(table_lock.data().pb.schema());
-    req_.mutable_partition_schema()->CopyFrom(
-        table_lock.data().pb.partition_schema());
-    req_.mutable_config()->CopyFrom(
-        tablet_lock.data().pb.consensus_state().committed_config());
-    req_.mutable_extra_config()->CopyFrom(
-        table_lock.data().pb.extra_config());
-    req_.set_dimension_label(tablet_lock.data().pb.dimension_label());
-    req_.set_table_type(table_lock.data().pb.table_type());
+  // Same as above, with the request filled by FillCreateTabletRequest().
+  AsyncCreateReplica(Master* master,
+                     const string& permanent_uuid,
+                     TableInfo* table,
+                     tserver::CreateTabletRequestPB req)
+    : RetrySpecificTSRpcTask(master, permanent_uuid, table),
+      tablet_id_(req.tablet_id()),
+      req_(std::move(req)) {
+    deadline_ = start_ts_ + MonoDelta::FromMilliseconds(FLAGS_tablet_creation_timeout_ms);
   }
 
   string type_name() const override { return "CreateTablet"; }
@@ -4801,6 +4872,132 @@ class AsyncCreateReplica : public RetrySpecificTSRpcTask {
   tserver::CreateTabletResponsePB resp_;
 };
 
+// Send a CreateTablets RPC creating the replicas of a batch of new tablets of
+// a table on a tablet server. The tablets whose creation fails are retried as
+// a smaller batch. If the tablet server doesn't support the RPC, an
+// AsyncCreateReplica task is started per tablet instead.
+class AsyncCreateReplicas : public RetrySpecificTSRpcTask {
+ public:
+  // The requests must be filled by FillCreateTabletRequest().
+  AsyncCreateReplicas(Master* master,
+                      const string& permanent_uuid,
+                      TableInfo* table,
+                      vector<tserver::CreateTabletRequestPB> reqs)
+      : RetrySpecificTSRpcTask(master, permanent_uuid, table),
+        first_tablet_id_(reqs.front().tablet_id()),
+        num_tablets_(reqs.size()),
+        reqs_(std::move(reqs)) {
+    deadline_ = start_ts_ + MonoDelta::FromMilliseconds(FLAGS_tablet_creation_timeout_ms);
+  }
+
+  string type_name() const override { return "CreateTablets"; }
+
+  string description() const override {
+    return Substitute("CreateTablets RPC for $0 tablets starting with $1 on TS $2",
+                      num_tablets_, first_tablet_id_, permanent_uuid_);
+  }
+
+ protected:
+  // The task is registered with the first tablet of the batch.
+  string tablet_id() const override { return first_tablet_id_; }
+
+  void HandleResponse(int attempt) override {
+    if (resp_.has_error()) {
+      Status status = StatusFromPB(resp_.error().status());
+      if (resp_.error().code() == TabletServerErrorPB::WRONG_SERVER_UUID) {
+        LOG(WARNING) << Substitute("TS $0: create failed for $1 tablets "
+            "because the server uuid is wrong. No further retry: $2",
+            target_ts_desc_->ToString(), reqs_.size(), status.ToString());
+        MarkFailed();
+        return;
+      }
+      KLOG_EVERY_N_SECS(WARNING, 1) <<
+          Substitute("TS $0: create failed for $1 tablets with error code $2: $3",
+                     target_ts_desc_->ToString(), reqs_.size(),
+                     TabletServerErrorPB::Code_Name(resp_.error().code()), status.ToString());
+      return;
+    }
+    if (PREDICT_FALSE(resp_.responses_size() != reqs_.size())) {
+      KLOG_EVERY_N_SECS(WARNING, 1) <<
+          Substitute("TS $0: unexpected number of responses to the creation of $1 tablets: $2",
+                     target_ts_desc_->ToString(), reqs_.size(), resp_.responses_size());
+      return;
+    }
+
+    // Same handling of the errors as AsyncCreateReplica, per tablet.
+    vector<tserver::CreateTabletRequestPB> to_retry;
+    for (int i = 0; i < reqs_.size(); i++) {
+      const tserver::CreateTabletResponsePB& tablet_resp = resp_.responses(i);
+      if (!tablet_resp.has_error()) {
+        continue;
+      }
+      const string& tablet_id = reqs_[i].tablet_id();
+      Status s = StatusFromPB(tablet_resp.error().status());
+      if (s.IsAlreadyPresent()) {
+        LOG(INFO) << Substitute("CreateTablets RPC for tablet $0 on TS $1 "
+            "returned already present: $2", tablet_id,
+            target_ts_desc_->ToString(), s.ToString());
+        continue;
+      }
+      KLOG_EVERY_N_SECS(WARNING, 1) <<
+          Substitute("CreateTablets RPC for tablet $0 on TS $1 failed: $2",
+                     tablet_id, target_ts_desc_->ToString(), s.ToString());
+      to_retry.emplace_back(std::move(reqs_[i]));
+    }
+    VLOG(1) << Substitute("TS $0: $1 of $2 tablets (table $3) successfully created",
+                          target_ts_desc_->ToString(), reqs_.size() - to_retry.size(),
+                          reqs_.size(), table_->ToString());
+    reqs_.swap(to_retry);
+    if (reqs_.empty()) {
+      MarkComplete();
+    }
+  }
+
+  bool SendRequest(int attempt) override {
+    tserver::CreateTabletsRequestPB req;
+    req.set_dest_uuid(permanent_uuid_);
+    for (const auto& tablet_req : reqs_) {
+      *req.add_requests() = tablet_req;
+    }
+    resp_.Clear();
+    rpc_.RequireServerFeature(tserver::TabletServerFeatures::CREATE_TABLETS);
+
+    VLOG(1) << Substitute("Sending $0 request for $1 tablets to $2 (attempt $3)",
+                          type_name(), reqs_.size(), target_ts_desc_->ToString(),
+                          attempt);
+    ts_proxy_->CreateTabletsAsync(req, &resp_, &rpc_,
+                                  [this]() { this->CreateTabletsCallback(); });
+    return true;
+  }
+
+ private:
+  void CreateTabletsCallback() {
+    if (rpc_.status().IsRemoteError() &&
+        rpc_.error_response()->unsupported_feature_flags_size() > 0 &&
+        state() == kStateRunning) {
+      LOG(INFO) << Substitute("TS $0 doesn't support CreateTablets, sending "
+                              "$1 CreateTablet RPCs instead",
+                              target_ts_desc_->ToString(), reqs_.size());
+      for (auto& tablet_req : reqs_) {
+        const string tablet_id = tablet_req.tablet_id();
+        scoped_refptr<AsyncCreateReplica> task = new AsyncCreateReplica(
+            master_, permanent_uuid_, table_, std::move(tablet_req));
+        table_->AddTask(tablet_id, task);
+        WARN_NOT_OK(task->Run(), "Failed to send new tablet request");
+      }
+      reqs_.clear();
+      MarkComplete();
+    }
+    RpcCallback();
+  }
+
+  const string first_tablet_id_;
+  const size_t num_tablets_;
+  // The requests for the tablets whose replicas are left to create.
+  vector<tserver::CreateTabletRequestPB> reqs_;
+  tserver::CreateTabletsResponsePB resp_;
+};
+
 // Send a DeleteTablet() RPC request.
 class AsyncDeleteReplica : public RetrySpecificTSRpcTask {
  public:
@@ -4906,6 +5103,147 @@ class AsyncDeleteReplica : public RetrySpecificTSRpcTask {
   tserver::DeleteTabletResponsePB resp_;
 };
 
+// Send a DeleteTablets RPC deleting the replicas of a batch of tablets of a
+// deleted table from a tablet server. The tablets whose deletion fails with a
+// transient error are retried as a smaller batch. If the tablet server
+// doesn't support the RPC, an AsyncDeleteReplica task is started per tablet
+// instead.
+class AsyncDeleteReplicas : public RetrySpecificTSRpcTask {
+ public:
+  AsyncDeleteReplicas(Master* master,
+                      const string& permanent_uuid,
+                      TableInfo* table,
+                      vector<string> tablet_ids,
+                      string reason)
+      : RetrySpecificTSRpcTask(master, permanent_uuid, table),
+        first_tablet_id_(tablet_ids.front()),
+        num_tablets_(tablet_ids.size()),
+        tablet_ids_(std::move(tablet_ids)),
+        reason_(std::move(reason)) {}
+
+  string type_name() const override {
+    return "DeleteTablets:TABLET_DATA_DELETED";
+  }
+
+  string description() const override {
+    return Substitute("DeleteTablets RPC for $0 tablets starting with $1 on TS $2",
+                      num_tablets_, first_tablet_id_, permanent_uuid_);
+  }
+
+ protected:
+  // The task is registered with the first tablet of the batch.
+  string tablet_id() const override { return first_tablet_id_; }
+
+  void HandleResponse(int attempt) override {
+    if (resp_.has_error()) {
+      Status status = StatusFromPB(resp_.error().status());
+      if (resp_.error().code() == TabletServerErrorPB::WRONG_SERVER_UUID) {
+        LOG(WARNING) << Substitute("TS $0: delete failed for $1 tablets "
+            "because the server uuid is wrong. No further retry: $2",
+            target_ts_desc_->ToString(), tablet_ids_.size(), status.ToString());
+        MarkFailed();
+        return;
+      }
+      KLOG_EVERY_N_SECS(WARNING, 1) <<
+          Substitute("TS $0: delete failed for $1 tablets with error code $2: $3",
+                     target_ts_desc_->ToString(), tablet_ids_.size(),
+                     TabletServerErrorPB::Code_Name(resp_.error().code()), status.ToString());
+      return;
+    }
+    if (PREDICT_FALSE(resp_.responses_size() != tablet_ids_.size())) {
+      KLOG_EVERY_N_SECS(WARNING, 1) <<
+          Substitute("TS $0: unexpected number of responses to the deletion of $1 tablets: $2",
+                     target_ts_desc_->ToString(), tablet_ids_.size(), resp_.responses_size());
+      return;
+    }
+
+    // Same handling of the errors as AsyncDeleteReplica, per tablet.
+    vector<string> to_retry;
+    for (int i = 0; i < tablet_ids_.size(); i++) {
+      const string& tablet_id = tablet_ids_[i];
+      const tserver::DeleteTabletResponsePB& tablet_resp = resp_.responses(i);
+      if (!tablet_resp.has_error()) {
+        VLOG(1) << Substitute("TS $0: delete complete on tablet $1",
+                              target_ts_desc_->ToString(), tablet_id);
+        continue;
+      }
+      Status status = StatusFromPB(tablet_resp.error().status());
+      TabletServerErrorPB::Code code = tablet_resp.error().code();
+      switch (code) {
+        case TabletServerErrorPB::TABLET_NOT_FOUND:
+        case TabletServerErrorPB::ALREADY_INPROGRESS:
+        case TabletServerErrorPB::CAS_FAILED:
+        case TabletServerErrorPB::WRONG_SERVER_UUID:
+          LOG(WARNING) << Substitute("TS $0: delete failed for tablet $1 with error code $2. "
+              "No further retry: $3", target_ts_desc_->ToString(), tablet_id,
+              TabletServerErrorPB::Code_Name(code), status.ToString());
+          break;
+        default:
+          KLOG_EVERY_N_SECS(WARNING, 1) <<
+              Substitute("TS $0: delete failed for tablet $1 with error code $2: $3",
+                         target_ts_desc_->ToString(), tablet_id,
+                         TabletServerErrorPB::Code_Name(code), status.ToString());
+          to_retry.emplace_back(tablet_id);
+          break;
+      }
+    }
+    LOG(INFO) << Substitute("TS $0: $1 of $2 tablets (table $3) successfully deleted",
+                            target_ts_desc_->ToString(), tablet_ids_.size() - to_retry.size(),
+                            tablet_ids_.size(), table_->ToString());
+    tablet_ids_.swap(to_retry);
+    if (tablet_ids_.empty()) {
+      MarkComplete();
+    }
+  }
+
+  bool SendRequest(int attempt) override {
+    tserver::DeleteTabletsRequestPB req;
+    req.set_dest_uuid(permanent_uuid_);
+    for (const auto& tablet_id : tablet_ids_) {
+      tserver::DeleteTabletRequestPB* tablet_req = req.add_requests();
+      tablet_req->set_tablet_id(tablet_id);
+      tablet_req->set_reason(reason_);
+      tablet_req->set_delete_type(TABLET_DATA_DELETED);
+    }
+    resp_.Clear();
+    rpc_.RequireServerFeature(tserver::TabletServerFeatures::DELETE_TABLETS);
+
+    VLOG(1) << Substitute("Sending $0 request for $1 tablets to $2 (attempt $3)",
+                          type_name(), tablet_ids_.size(), target_ts_desc_->ToString(),
+                          attempt);
+    ts_proxy_->DeleteTabletsAsync(req, &resp_, &rpc_,
+                                  [this]() { this->DeleteTabletsCallback(); });
+    return true;
+  }
+
+ private:
+  void DeleteTabletsCallback() {
+    if (rpc_.status().IsRemoteError() &&
+        rpc_.error_response()->unsupported_feature_flags_size() > 0 &&
+        state() == kStateRunning) {
+      LOG(INFO) << Substitute("TS $0 doesn't support DeleteTablets, sending "
+                              "$1 DeleteTablet RPCs instead",
+                              target_ts_desc_->ToString(), tablet_ids_.size());
+      for (const auto& tablet_id : tablet_ids_) {
+        scoped_refptr<AsyncDeleteReplica> task = new AsyncDeleteReplica(
+            master_, permanent_uuid_, table_, tablet_id, TABLET_DATA_DELETED, nullopt, reason_);
+        table_->AddTask(tablet_id, task);
+        WARN_NOT_OK(task->Run(), Substitute(
+            "Failed to send DeleteReplica request for tablet $0", tablet_id));
+      }
+      MarkComplete();
+    }
+    RpcCallback();
+  }
+
+  const string first_tablet_id_;
+  const size_t num_tablets_;
+  // The tablets whose replicas are left to delete.
+  vector<string> tablet_ids_;
+  const string reason_;
+  tserver::DeleteTabletsResponsePB resp_;
+};
+
 // Send the "Alter Table" with the latest table schema to the leader replica
 // for the tablet.
 // Keeps retrying until we get an "ok" response.
@@ -5792,9 +6130,46 @@ void CatalogManager::SendDeleteTableRequest(const scoped_refptr<TableInfo>& tabl
   vector<scoped_refptr<TabletInfo>> tablets;
   table->GetAllTablets(&tablets);
 
+  const int32_t batch_size = FLAGS_catalog_manager_delete_tablets_batch_size;
+  if (batch_size <= 1) {
+    for (const scoped_refptr<TabletInfo>& tablet : tablets) {
+      TabletMetadataLock l(tablet.get(), LockMode::READ);
+      SendDeleteTabletRequest(tablet, l, deletion_msg);
+    }
+    return;
+  }
+
+  // Group the replicas to delete per tablet server.
+  map<string, vector<string>> tablet_ids_by_ts;
+  int num_replicas = 0;
   for (const scoped_refptr<TabletInfo>& tablet : tablets) {
     TabletMetadataLock l(tablet.get(), LockMode::READ);
-    SendDeleteTabletRequest(tablet, l, deletion_msg);
+    if (!l.data().pb.has_consensus_state()) {
+      // See SendDeleteTabletRequest().
+      LOG(INFO) << "Not sending DeleteTablet requests; no consensus state for tablet "
+                << tablet->id();
+      continue;
+    }
+    for (const auto& peer : l.data().pb.consensus_state().committed_config().peers()) {
+      tablet_ids_by_ts[peer.permanent_uuid()].emplace_back(tablet->id());
+      num_replicas++;
+    }
+  }
+  LOG_WITH_PREFIX(INFO) << Substitute(
+      "Sending DeleteTablets for $0 replicas of $1 tablets of table $2 to $3 tablet servers",
+      num_replicas, tablets.size(), table->ToString(), tablet_ids_by_ts.size());
+  for (auto& entry : tablet_ids_by_ts) {
+    const vector<string>& tablet_ids = entry.second;
+    for (size_t start = 0; start < tablet_ids.size(); start += batch_size) {
+      const size_t end = std::min<size_t>(start + batch_size, tablet_ids.size());
+      vector<string> batch(tablet_ids.begin() + start, tablet_ids.begin() + end);
+      const string first_tablet_id = batch.front();
+      scoped_refptr<AsyncDeleteReplicas> task = new AsyncDeleteReplicas(
+          master_, entry.first, table.get(), std::move(batch), deletion_msg);
+      table->AddTask(first_tablet_id, task);
+      WARN_NOT_OK(task->Run(), Substitute(
+          "Failed to send DeleteTablets request to TS $0", entry.first));
+    }
   }
 }
 
@@ -6192,10 +6567,7 @@ Status CatalogManager::ProcessPendingAssignments(
   }
 
   // Send the CreateTablet() requests to the servers. This is asynchronous / non-blocking.
-  for (const auto& tablet : deferred.needs_create_rpc) {
-    TabletMetadataLock l(tablet.get(), LockMode::READ);
-    SendCreateTabletRequest(tablet, l);
-  }
+  SendCreateTabletRequests(deferred.needs_create_rpc);
   return Status::OK();
 }
 
@@ -6300,6 +6672,49 @@ void CatalogManager::SendCreateTabletRequest(const scoped_refptr<TabletInfo>& ta
   }
 }
 
+void CatalogManager::SendCreateTabletRequests(const vector<scoped_refptr<TabletInfo>>& tablets) {
+  const int32_t batch_size = FLAGS_catalog_manager_create_tablets_batch_size;
+  if (batch_size <= 1) {
+    for (const auto& tablet : tablets) {
+      TabletMetadataLock l(tablet.get(), LockMode::READ);
+      SendCreateTabletRequest(tablet, l);
+    }
+    return;
+  }
+
+  // Group the replicas to create per tablet server and table, since a task
+  // belongs to a single table.
+  typedef pair<scoped_refptr<TableInfo>, vector<tserver::CreateTabletRequestPB>> TableRequests;
+  map<pair<string, string>, TableRequests> reqs_by_ts_and_table;
+  for (const auto& tablet : tablets) {
+    TabletMetadataLock l(tablet.get(), LockMode::READ);
+    tablet->set_last_create_tablet_time(MonoTime::Now());
+    for (const RaftPeerPB& peer : l.data().pb.consensus_state().committed_config().peers()) {
+      auto& entry = reqs_by_ts_and_table[{ peer.permanent_uuid(), tablet->table()->id() }];
+      entry.first = tablet->table();
+      entry.second.emplace_back();
+      FillCreateTabletRequest(peer.permanent_uuid(), tablet, l, &entry.second.back());
+    }
+  }
+  for (auto& e : reqs_by_ts_and_table) {
+    const string& ts_uuid = e.first.first;
+    TableInfo* table = e.second.first.get();
+    auto& reqs = e.second.second;
+    for (size_t start = 0; start < reqs.size(); start += batch_size) {
+      const size_t end = std::min<size_t>(start + batch_size, reqs.size());
+      vector<tserver::CreateTabletRequestPB> batch(
+          std::make_move_iterator(reqs.begin() + start),
+          std::make_move_iterator(reqs.begin() + end));
+      const string first_tablet_id = batch.front().tablet_id();
+      scoped_refptr<AsyncCreateReplicas> task = new AsyncCreateReplicas(
+          master_, ts_uuid, table, std::move(batch));
+      table->AddTask(first_tablet_id, task);
+      WARN_NOT_OK(task->Run(), Substitute(
+          "Failed to send CreateTablets request to TS $0", ts_uuid));
+    }
+  }
+}
+
 Status CatalogManager::ProcessDeletedTablets(const vector<scoped_refptr<TabletInfo>>& tablets,
                                              time_t current_timestamp) {
   TabletMetadataGroupLock tablets_lock(LockMode::RELEASED);
@@ -6372,19 +6787,22 @@ Status CatalogManager::BuildLocationsForTablet(
     bool use_external_addr,
     TabletLocationsPB* locs_pb,
     TSInfosDict* ts_infos_dict) {
-  TabletMetadataLock l_tablet(tablet.get(), LockMode::READ);
-  if (PREDICT_FALSE(l_tablet.data().is_deleted())) {
-    return Status::NotFound("Tablet deleted", l_tablet.data().pb.state_msg());
+  // Use a snapshot of the tablet's metadata rather than its metadata lock:
+  // lookups are frequent enough for the lock to become contended, and would
+  // otherwise wait for the commits of tablet reports and DDL operations.
+  const auto metadata = tablet->MetadataSnapshot();
+  if (PREDICT_FALSE(metadata->is_deleted())) {
+    return Status::NotFound("Tablet deleted", metadata->pb.state_msg());
   }
 
-  if (PREDICT_FALSE(!l_tablet.data().is_running())) {
+  if (PREDICT_FALSE(!metadata->is_running())) {
     return Status::ServiceUnavailable("Tablet not running");
   }
 
   // Guaranteed because the tablet is RUNNING.
-  DCHECK(l_tablet.data().pb.has_consensus_state());
+  DCHECK(metadata->pb.has_consensus_state());
 
-  const ConsensusStatePB& cstate = l_tablet.data().pb.consensus_state();
+  const ConsensusStatePB& cstate = metadata->pb.consensus_state();
 
   if (ts_infos_dict) {
     locs_pb->mutable_interned_replicas()->Reserve(cstate.committed_config().peers().size());
@@ -6434,8 +6852,8 @@ Status CatalogManager::BuildLocationsForTablet(
     };
 
     const auto role = GetParticipantRole(peer, cstate);
-    const optional<string> dimension = l_tablet.data().pb.has_dimension_label()
-        ? make_optional(l_tablet.data().pb.dimension_label()) : nullopt;
+    const optional<string> dimension = metadata->pb.has_dimension_label()
+        ? make_optional(metadata->pb.dimension_label()) : nullopt;
 
     // Don't even add a TSInfo entry when using external addresses if
     // proxy-advertised address for the peer isn't yet known at this point.
@@ -6468,7 +6886,7 @@ Status CatalogManager::BuildLocationsForTablet(
     }
   }
 
-  locs_pb->mutable_partition()->CopyFrom(tablet->metadata().state().pb.partition());
+  locs_pb->mutable_partition()->CopyFrom(metadata->pb.partition());
   locs_pb->set_tablet_id(tablet->id());
 
   // No longer used; always set to false.
@@ -7266,6 +7684,25 @@ TabletInfo::TabletInfo(scoped_refptr<TableInfo> table, string tablet_id)
 TabletInfo::~TabletInfo() {
 }
 
+shared_ptr<const PersistentTabletInfo> TabletInfo::MetadataSnapshot() const {
+  auto snapshot = std::atomic_load(&metadata_snapshot_);
+  if (!snapshot || snapshot->version != metadata_.version()) {
+    // The metadata changed since the last copy was made. Concurrent callers
+    // may all make a copy: whichever is stored last, the next callers find out
+    // whether it's current.
+    auto fresh = std::make_shared<VersionedMetadata>();
+    {
+      TabletMetadataLock l(this, LockMode::READ);
+      fresh->version = metadata_.version();
+      fresh->data = l.data();
+    }
+    snapshot = std::move(fresh);
+    std::atomic_store(&metadata_snapshot_, snapshot);
+  }
+  // Share the ownership of the whole copy, but only expose its data.
+  return shared_ptr<const PersistentTabletInfo>(snapshot, &snapshot->data);
+}
+
 void TabletInfo::set_last_create_tablet_time(const MonoTime& ts) {
   std::lock_guard<simple_spinlock> l(lock_);
   last_create_tablet_time_ = ts;
@@ -7528,6 +7965,21 @@ bool TableInfo::IsCreateInProgress() const {
   return false;
 }
 
+void TableInfo::set_create_start_time(MonoTime time) {
+  std::lock_guard<rw_spinlock> l(lock_);
+  create_start_time_ = time;
+}
+
+bool TableInfo::MarkCreateDone(MonoDelta* duration) {
+  std::lock_guard<rw_spinlock> l(lock_);
+  if (!create_start_time_.Initialized()) {
+    return false;
+  }
+  *duration = MonoTime::Now() - create_start_time_;
+  create_start_time_ = MonoTime();
+  return true;
+}
+
 void TableInfo::AddTask(const string& tablet_id, const scoped_refptr<MonitoredTask>& task) {
   std::lock_guard<rw_spinlock> l(lock_);
   pending_tasks_.emplace(tablet_id, task);
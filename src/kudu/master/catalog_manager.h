@@ -71,6 +71,7 @@ namespace kudu {
 
 class AuthzTokenTest_TestSingleMasterUnavailable_Test;
 class CreateTableStressTest_TestConcurrentCreateTableAndReloadMetadata_Test;
+class Histogram;
 class HostPort;
 class MetricEntity;
 class MetricRegistry;
@@ -200,6 +201,12 @@ class TabletInfo : public RefCountedThreadSafe<TabletInfo> {
   const CowObject<PersistentTabletInfo>& metadata() const { return metadata_; }
   CowObject<PersistentTabletInfo>* mutable_metadata() { return &metadata_; }
 
+  // Returns a copy of the persistent metadata as of the last committed
+  // mutation. The copy is shared and only refreshed, under the metadata lock,
+  // after the metadata is mutated, so that hot read-only paths (e.g. tablet
+  // locations lookups) don't contend on the metadata lock.
+  std::shared_ptr<const PersistentTabletInfo> MetadataSnapshot() const;
+
   // Accessors for the last time create tablet RPCs were sent for this tablet.
   void set_last_create_tablet_time(const MonoTime& ts);
   MonoTime last_create_tablet_time() const;
@@ -231,6 +238,16 @@ class TabletInfo : public RefCountedThreadSafe<TabletInfo> {
 
   CowObject<PersistentTabletInfo> metadata_;
 
+  struct VersionedMetadata {
+    // The version of 'metadata_' the copy was made from.
+    uint64_t version;
+    PersistentTabletInfo data;
+  };
+
+  // The last copy of the persistent metadata made by MetadataSnapshot().
+  // Only accessed with std::atomic_load() and std::atomic_store().
+  mutable std::shared_ptr<const VersionedMetadata> metadata_snapshot_;
+
   // Lock protecting the below mutable fields.
   // This doesn't protect metadata_ (the on-disk portion).
   mutable simple_spinlock lock_;
@@ -377,6 +394,14 @@ class TableInfo : public RefCountedThreadSafe<TableInfo> {
   // Returns true if the table creation is in-progress
   bool IsCreateInProgress() const;
 
+  // Records the start of the creation of the table by this master.
+  void set_create_start_time(MonoTime time);
+
+  // If the start of the creation of the table was recorded and the creation
+  // not yet marked done, marks it done, sets 'duration' to the time it took
+  // and returns true. Returns false otherwise.
+  bool MarkCreateDone(MonoDelta* duration);
+
   // Returns true if an "Alter" operation is in-progress
   bool IsAlterInProgress(uint32_t version) const;
 
@@ -459,7 +484,8 @@ class TableInfo : public RefCountedThreadSafe<TableInfo> {
   typedef std::map<PartitionKey, TabletInfo*> RawTabletInfoMap;
   RawTabletInfoMap tablet_map_;
 
-  // Protects tablet_map_, pending_tasks_, and schema_version_counts_.
+  // Protects tablet_map_, pending_tasks_, schema_version_counts_ and
+  // create_start_time_.
   mutable rw_spinlock lock_;
 
   CowObject<PersistentTableInfo> metadata_;
@@ -476,6 +502,9 @@ class TableInfo : public RefCountedThreadSafe<TableInfo> {
   // tablet_map_ and summing up the tablets' reported schema versions.
   std::map<int64_t, int64_t> schema_version_counts_;
 
+  // See set_create_start_time() and MarkCreateDone().
+  MonoTime create_start_time_;
+
   scoped_refptr<MetricEntity> metric_entity_;
   std::unique_ptr<TableMetrics> metrics_;
 
@@ -1296,6 +1325,11 @@ class CatalogManager : public tserver::TabletReplicaLookupIf {
   void SendCreateTabletRequest(const scoped_refptr<TabletInfo>& tablet,
                                const TabletMetadataLock& tablet_lock);
 
+  // Sends the CreateTablet() requests for 'tablets', batched per tablet server
+  // into CreateTablets() requests of up to
+  // --catalog_manager_create_tablets_batch_size tablets.
+  void SendCreateTabletRequests(const std::vector<scoped_refptr<TabletInfo>>& tablets);
+
   // Send the "alter table request" to all tablets of the specified table.
   void SendAlterTableRequest(const scoped_refptr<TableInfo>& table);
 
@@ -1456,6 +1490,9 @@ class CatalogManager : public tserver::TabletReplicaLookupIf {
   std::string ipki_private_key_password_;
   std::string tsk_private_key_password_;
 
+  // Time to create the tables, see MarkCreateDone().
+  scoped_refptr<Histogram> table_creation_duration_ms_;
+
   // Async operations are accessing some private methods
   // (TODO: this stuff should be deferred and done in the background thread)
   friend class AsyncAlterTable;
@@ -142,6 +142,8 @@ DECLARE_int32(flush_threshold_mb);
 DECLARE_int32(flush_threshold_secs);
 DECLARE_int32(flush_upper_bound_ms);
 DECLARE_int32(master_inject_latency_on_tablet_lookups_ms);
+DECLARE_int32(master_inject_latency_on_tablet_reports_ms);
+DECLARE_int32(master_max_concurrent_full_tablet_reports);
 DECLARE_int32(max_table_comment_length);
 DECLARE_int32(rpc_service_queue_length);
 DECLARE_int64(live_row_count_for_testing);
@@ -152,6 +154,7 @@ DECLARE_string(log_filename);
 DECLARE_string(tsk_private_key_password_cmd);
 DECLARE_string(webserver_doc_root);
 
+METRIC_DECLARE_counter(full_tablet_reports_deferred);
 METRIC_DECLARE_histogram(handler_latency_kudu_master_MasterService_GetTableSchema);
 
 namespace kudu {
@@ -772,6 +775,68 @@ TEST_F(MasterTest, TestRegisterAndHeartbeat) {
   }
 }
 
+// Test that full tablet reports beyond --master_max_concurrent_full_tablet_reports
+// are not processed, and that the tablet servers sending them are asked for a
+// full report again.
+TEST_F(MasterTest, TestConcurrentFullTabletReportsLimit) {
+  constexpr int kNumTServers = 2;
+  FLAGS_master_max_concurrent_full_tablet_reports = 1;
+  FLAGS_master_inject_latency_on_tablet_reports_ms = 2000;
+
+  ReplicaManagementInfoPB rmi;
+  rmi.set_replacement_scheme(FLAGS_raft_prepare_replacement_before_eviction
+      ? ReplicaManagementInfoPB::PREPARE_REPLACEMENT_BEFORE_EVICTION
+      : ReplicaManagementInfoPB::EVICT_FIRST);
+  vector<TSToMasterCommonPB> commons(kNumTServers);
+  for (int i = 0; i < kNumTServers; ++i) {
+    commons[i].mutable_ts_instance()->set_permanent_uuid(Substitute("ts-$0", i));
+    commons[i].mutable_ts_instance()->set_instance_seqno(1);
+    ServerRegistrationPB reg;
+    MakeHostPortPB("localhost", 1000 + i, reg.add_rpc_addresses());
+    TSHeartbeatRequestPB req;
+    TSHeartbeatResponsePB resp;
+    RpcController rpc;
+    req.mutable_common()->CopyFrom(commons[i]);
+    req.mutable_registration()->CopyFrom(reg);
+    req.mutable_replica_management_info()->CopyFrom(rmi);
+    ASSERT_OK(proxy_->TSHeartbeat(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error());
+  }
+
+  // Send full reports from all the tablet servers at once.
+  vector<TSHeartbeatResponsePB> resps(kNumTServers);
+  vector<Status> statuses(kNumTServers);
+  vector<thread> threads;
+  for (int i = 0; i < kNumTServers; ++i) {
+    threads.emplace_back([&, i]() {
+      TSHeartbeatRequestPB req;
+      RpcController rpc;
+      req.mutable_common()->CopyFrom(commons[i]);
+      req.mutable_tablet_report()->set_is_incremental(false);
+      req.mutable_tablet_report()->set_sequence_number(0);
+      statuses[i] = proxy_->TSHeartbeat(req, &resps[i], &rpc);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  int num_processed = 0;
+  for (int i = 0; i < kNumTServers; ++i) {
+    ASSERT_OK(statuses[i]);
+    ASSERT_FALSE(resps[i].has_error());
+    if (resps[i].has_tablet_report()) {
+      ASSERT_FALSE(resps[i].needs_full_tablet_report());
+      ++num_processed;
+    } else {
+      ASSERT_TRUE(resps[i].needs_full_tablet_report());
+    }
+  }
+  ASSERT_EQ(1, num_processed);
+  ASSERT_EQ(kNumTServers - 1, METRIC_full_tablet_reports_deferred.Instantiate(
+      master_->metric_entity())->value());
+}
+
 TEST_F(MasterTest, TestCatalog) {
   const char *kTableName = "testtb";
   const char *kOtherTableName = "tbtest";
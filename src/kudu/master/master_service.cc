@@ -17,6 +17,7 @@
 
 #include "kudu/master/master_service.h"
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -55,6 +56,7 @@
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
@@ -73,6 +75,12 @@ DEFINE_int32(master_inject_latency_on_tablet_lookups_ms, 0,
 TAG_FLAG(master_inject_latency_on_tablet_lookups_ms, unsafe);
 TAG_FLAG(master_inject_latency_on_tablet_lookups_ms, hidden);
 
+DEFINE_int32(master_inject_latency_on_tablet_reports_ms, 0,
+             "Number of milliseconds that the master will sleep before processing "
+             "tablet reports.");
+TAG_FLAG(master_inject_latency_on_tablet_reports_ms, unsafe);
+TAG_FLAG(master_inject_latency_on_tablet_reports_ms, hidden);
+
 DEFINE_bool(master_support_connect_to_master_rpc, true,
             "Whether to support the ConnectToMaster() RPC. Used for testing "
             "version compatibility fallback in the client.");
@@ -125,6 +133,27 @@ TAG_FLAG(master_support_auto_incrementing_column, unsafe);
 TAG_FLAG(master_support_auto_incrementing_column, experimental);
 TAG_FLAG(master_support_auto_incrementing_column, runtime);
 
+DEFINE_int32(master_max_concurrent_full_tablet_reports, 0,
+             "Maximum number of full tablet reports the leader master processes "
+             "concurrently. All the tablet servers send a full tablet report when "
+             "a new leader master is elected: the reports received while this many "
+             "are being processed are dropped, and the tablet servers are asked to "
+             "send them again with their next regular heartbeat. If 0, the number "
+             "of full tablet reports processed concurrently is not limited.");
+TAG_FLAG(master_max_concurrent_full_tablet_reports, advanced);
+TAG_FLAG(master_max_concurrent_full_tablet_reports, runtime);
+DEFINE_validator(master_max_concurrent_full_tablet_reports,
+                 [](const char* /*flagname*/, int32_t value) { return value >= 0; });
+
+METRIC_DEFINE_counter(server, full_tablet_reports_deferred,
+                      "Full Tablet Reports Deferred",
+                      kudu::MetricUnit::kRequests,
+                      "Number of full tablet reports from tablet servers which "
+                      "were not processed, and requested again, because "
+                      "--master_max_concurrent_full_tablet_reports full reports "
+                      "were already being processed",
+                      kudu::MetricLevel::kInfo);
+
 using google::protobuf::Message;
 using kudu::consensus::ReplicaManagementInfoPB;
 using kudu::pb_util::SecureDebugString;
@@ -173,7 +202,10 @@ bool StateChangeToTServerState(const TServerStateChangePB::StateChange& change,
 
 MasterServiceImpl::MasterServiceImpl(Master* server)
   : MasterServiceIf(server->metric_entity(), server->result_tracker()),
-    server_(server) {
+    server_(server),
+    num_full_tablet_reports_in_progress_(0),
+    full_tablet_reports_deferred_(
+        METRIC_full_tablet_reports_deferred.Instantiate(server->metric_entity())) {
 }
 
 bool MasterServiceImpl::AuthorizeClient(const Message* /*req*/,
@@ -466,9 +498,36 @@ void MasterServiceImpl::TSHeartbeat(const TSHeartbeatRequestPB* req,
     }
     ts_desc->set_num_live_replicas_by_range_per_table(it->first, ranges);
   }
+  if (req->has_replica_load_report()) {
+    ts_desc->UpdateReplicaLoads(req->replica_load_report(), MonoTime::Now());
+  }
 
-  // 5. Only leaders handle tablet reports.
-  if (is_leader_master && req->has_tablet_report()) {
+  // 5. Only leaders handle tablet reports. Full reports are bounded in number,
+  //    since all the tablet servers send one when a new leader is elected:
+  //    those beyond the limit are deferred to a later heartbeat.
+  const bool is_full_report =
+      req->has_tablet_report() && !req->tablet_report().is_incremental();
+  bool full_report_deferred = false;
+  if (is_leader_master && is_full_report) {
+    const int in_progress = num_full_tablet_reports_in_progress_++;
+    const int max_full_reports = FLAGS_master_max_concurrent_full_tablet_reports;
+    full_report_deferred = max_full_reports > 0 && in_progress >= max_full_reports;
+  }
+  SCOPED_CLEANUP({
+    if (is_leader_master && is_full_report) {
+      num_full_tablet_reports_in_progress_--;
+    }
+  });
+  if (full_report_deferred) {
+    VLOG(1) << Substitute("Deferring full tablet report from $0: $1 full reports "
+                          "are being processed", rpc->requestor_string(),
+                          FLAGS_master_max_concurrent_full_tablet_reports);
+    full_tablet_reports_deferred_->Increment();
+    ts_desc->UpdateNeedsFullTabletReport(true);
+  } else if (is_leader_master && req->has_tablet_report()) {
+    if (PREDICT_FALSE(FLAGS_master_inject_latency_on_tablet_reports_ms > 0)) {
+      SleepFor(MonoDelta::FromMilliseconds(FLAGS_master_inject_latency_on_tablet_reports_ms));
+    }
     Status s = server_->catalog_manager()->ProcessTabletReport(
         ts_desc.get(), req->tablet_report(), resp->mutable_tablet_report(), rpc);
     if (!s.ok()) {
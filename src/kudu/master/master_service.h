@@ -17,9 +17,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/master/master.service.h"
 
 namespace google {
@@ -30,6 +32,8 @@ class Message;
 
 namespace kudu {
 
+class Counter;
+
 namespace rpc {
 class RpcContext;
 }
@@ -209,6 +213,12 @@ class MasterServiceImpl : public MasterServiceIf {
  private:
   Master* server_;
 
+  // The number of full tablet reports being processed, bounded by
+  // --master_max_concurrent_full_tablet_reports.
+  std::atomic<int> num_full_tablet_reports_in_progress_;
+
+  scoped_refptr<Counter> full_tablet_reports_deferred_;
+
   DISALLOW_COPY_AND_ASSIGN(MasterServiceImpl);
 };
 
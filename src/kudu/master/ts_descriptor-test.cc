@@ -17,6 +17,7 @@
 
 #include "kudu/master/ts_descriptor.h"
 
+#include <cstdint>
 #include <initializer_list>
 #include <memory>
 #include <optional>
@@ -27,6 +28,8 @@
 
 #include "kudu/common/common.pb.h"
 #include "kudu/common/wire_protocol.pb.h"
+#include "kudu/master/master.pb.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/net/dns_resolver.h"
 #include "kudu/util/test_macros.h"
 
@@ -94,5 +97,49 @@ TEST(TSDescriptorTest, TestLocationCmd) {
       instance, registration, location, dns_resolver.get(), &desc));
   ASSERT_EQ(location, desc->location());
 }
+
+TEST(TSDescriptorTest, TestReplicaLoads) {
+  NodeInstancePB instance;
+  ServerRegistrationPB registration;
+  SetupBasicRegistrationInfo("test", &instance, &registration);
+  unique_ptr<DnsResolver> dns_resolver(new DnsResolver);
+  shared_ptr<TSDescriptor> desc;
+  ASSERT_OK(TSDescriptor::RegisterNew(
+      instance, registration, {}, dns_resolver.get(), &desc));
+
+  const auto report = [](uint64_t rows_read, uint64_t rows_written) {
+    ReplicaLoadReportPB report;
+    auto* replica = report.add_replicas();
+    replica->set_tablet_id("tablet");
+    replica->set_rows_read(rows_read);
+    replica->set_rows_written(rows_written);
+    replica->set_on_disk_size(1024);
+    replica->set_is_leader(true);
+    return report;
+  };
+
+  // The rates are only known from the second report on.
+  const MonoTime now = MonoTime::Now();
+  desc->UpdateReplicaLoads(report(100, 10), now);
+  ASSERT_FALSE(desc->replica_loads().has_value());
+  desc->UpdateReplicaLoads(report(300, 30), now + MonoDelta::FromSeconds(10));
+  auto loads = desc->replica_loads();
+  ASSERT_TRUE(loads.has_value());
+  ASSERT_EQ(1, loads->size());
+  const auto& load = loads->at("tablet");
+  ASSERT_DOUBLE_EQ(20, load.rows_read_per_sec);
+  ASSERT_DOUBLE_EQ(2, load.rows_written_per_sec);
+  ASSERT_EQ(1024, load.on_disk_size);
+  ASSERT_TRUE(load.is_leader);
+
+  // Counters going backwards, e.g. once the replica is reopened, don't yield
+  // negative rates.
+  desc->UpdateReplicaLoads(report(50, 5), now + MonoDelta::FromSeconds(20));
+  loads = desc->replica_loads();
+  ASSERT_TRUE(loads.has_value());
+  ASSERT_DOUBLE_EQ(0, loads->at("tablet").rows_read_per_sec);
+  ASSERT_DOUBLE_EQ(0, loads->at("tablet").rows_written_per_sec);
+}
+
 } // namespace master
 } // namespace kudu
@@ -22,6 +22,7 @@
 #include <optional>
 #include <ostream>
 #include <shared_mutex>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -59,6 +60,7 @@ using std::optional;
 using std::shared_lock;
 using std::shared_ptr;
 using std::string;
+using std::unordered_map;
 using std::vector;
 using strings::Substitute;
 
@@ -159,6 +161,41 @@ void TSDescriptor::UpdateHeartbeatTime() {
   last_heartbeat_ = MonoTime::Now();
 }
 
+void TSDescriptor::UpdateReplicaLoads(const ReplicaLoadReportPB& report, MonoTime now) {
+  std::lock_guard<rw_spinlock> l(lock_);
+  const bool has_previous_report = last_replica_load_report_.Initialized() &&
+                                   now > last_replica_load_report_;
+  const double elapsed_sec = has_previous_report
+      ? (now - last_replica_load_report_).ToSeconds() : 0;
+  unordered_map<string, ReplicaLoadCounters> counters;
+  ReplicaLoadMap loads;
+  for (const auto& replica : report.replicas()) {
+    counters[replica.tablet_id()] = { replica.rows_read(), replica.rows_written() };
+    ReplicaLoad& load = loads[replica.tablet_id()];
+    load.on_disk_size = replica.on_disk_size();
+    load.is_leader = replica.is_leader();
+    if (!has_previous_report) {
+      continue;
+    }
+    // The rates of a replica without previous counters, or whose counters
+    // restarted because it was reopened, are known from the next report.
+    const ReplicaLoadCounters* prev = FindOrNull(last_replica_load_counters_,
+                                                 replica.tablet_id());
+    if (prev == nullptr ||
+        prev->rows_read > replica.rows_read() ||
+        prev->rows_written > replica.rows_written()) {
+      continue;
+    }
+    load.rows_read_per_sec = (replica.rows_read() - prev->rows_read) / elapsed_sec;
+    load.rows_written_per_sec = (replica.rows_written() - prev->rows_written) / elapsed_sec;
+  }
+  last_replica_load_counters_ = std::move(counters);
+  last_replica_load_report_ = now;
+  if (has_previous_report) {
+    replica_loads_ = std::move(loads);
+  }
+}
+
 MonoDelta TSDescriptor::TimeSinceHeartbeat() const {
   MonoTime now(MonoTime::Now());
   shared_lock<rw_spinlock> l(lock_);
@@ -58,6 +58,7 @@ class TabletServerAdminServiceProxy;
 
 namespace master {
 
+class ReplicaLoadReportPB;
 class TSInfoPB;
 
 // Map of dimension -> number of tablets.
@@ -74,6 +75,18 @@ typedef std::unordered_map<std::string, TabletNumByRangeMap> TabletNumByRangePer
 // has had a replica selected on this tablet server.
 typedef std::pair<std::unordered_map<std::string, double>, double> RecentReplicaByRangesPerTable;
 
+// The load of a tablet replica, as derived by the master from the successive
+// replica load reports of the tablet server hosting it.
+struct ReplicaLoad {
+  double rows_read_per_sec = 0;
+  double rows_written_per_sec = 0;
+  uint64_t on_disk_size = 0;
+  bool is_leader = false;
+};
+
+// Map of tablet id -> load of the replica.
+typedef std::unordered_map<std::string, ReplicaLoad> ReplicaLoadMap;
+
 // Map of table id -> number of times each range in the table and
 // the table itself has had a replica selected on this tablet server.
 typedef std::unordered_map<std::string, RecentReplicaByRangesPerTable> RecentReplicasByTable;
@@ -243,6 +256,18 @@ class TSDescriptor : public enable_make_shared<TSDescriptor> {
     return num_live_tablets_by_table;
   }
 
+  // Update the load of the replicas from 'report', received at 'now'. The
+  // rates are derived from the counters of the previous report; replicas
+  // missing from 'report' are dropped.
+  void UpdateReplicaLoads(const ReplicaLoadReportPB& report, MonoTime now);
+
+  // Return the load of the replicas hosted by the tablet server, or
+  // std::nullopt if the rates aren't known yet, i.e. before the second report.
+  std::optional<ReplicaLoadMap> replica_loads() const {
+    std::shared_lock<rw_spinlock> l(lock_);
+    return replica_loads_;
+  }
+
   // Return the location of the tablet server. This returns a safe copy
   // since the location could change at any time if the tablet server
   // re-registers.
@@ -313,6 +338,18 @@ class TSDescriptor : public enable_make_shared<TSDescriptor> {
   // The number of live replicas for each range for each table on this host from the last heartbeat.
   TabletNumByRangePerTableMap num_live_tablets_by_range_per_table_;
 
+  // The cumulative counters of the replicas, and the time of the report
+  // they're from.
+  struct ReplicaLoadCounters {
+    uint64_t rows_read;
+    uint64_t rows_written;
+  };
+  std::unordered_map<std::string, ReplicaLoadCounters> last_replica_load_counters_;
+  MonoTime last_replica_load_report_;
+
+  // The load of the replicas, derived from the last two replica load reports.
+  std::optional<ReplicaLoadMap> replica_loads_;
+
   // The tablet server's location, as determined by the master at registration.
   std::optional<std::string> location_;
 
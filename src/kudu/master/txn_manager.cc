@@ -78,6 +78,27 @@ DEFINE_uint32(txn_manager_status_table_num_replicas, 3,
 TAG_FLAG(txn_manager_status_table_num_replicas, advanced);
 TAG_FLAG(txn_manager_status_table_num_replicas, experimental);
 
+DEFINE_uint32(txn_manager_status_table_num_hash_partitions, 1,
+              "Number of hash partitions of each range of the transaction status "
+              "table. Transaction identifiers are allocated in increasing order, so "
+              "with a single hash partition all the transactions in flight are "
+              "coordinated by the same transaction status tablet. With more hash "
+              "partitions, they're spread over that many tablets, so the rate of "
+              "beginning and committing transactions scales with the number of "
+              "tablet servers. Only taken into account when the transaction status "
+              "table is created.");
+TAG_FLAG(txn_manager_status_table_num_hash_partitions, advanced);
+TAG_FLAG(txn_manager_status_table_num_hash_partitions, experimental);
+
+static bool ValidateNumHashPartitions(const char* flagname, uint32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive";
+  return false;
+}
+DEFINE_validator(txn_manager_status_table_num_hash_partitions, &ValidateNumHashPartitions);
+
 namespace kudu {
 namespace transactions {
 
@@ -242,7 +263,8 @@ Status TxnManager::Init() {
   DCHECK(txn_sys_client_);
   auto s = txn_sys_client_->CreateTxnStatusTable(
       FLAGS_txn_manager_status_table_range_partition_span,
-      FLAGS_txn_manager_status_table_num_replicas);
+      FLAGS_txn_manager_status_table_num_replicas,
+      FLAGS_txn_manager_status_table_num_hash_partitions);
   if (!s.ok() && !s.IsAlreadyPresent()) {
     // Status::OK() is expected only on the very first call to Init() before
     // the transaction status table is created.
@@ -59,6 +59,7 @@ DECLARE_string(ranger_jar_path);
 DECLARE_string(ranger_java_extra_args);
 DECLARE_bool(ranger_logtostdout);
 DECLARE_bool(ranger_overwrite_log_config);
+DECLARE_uint32(ranger_authz_cache_capacity_mb);
 
 using boost::hash_combine;
 using kudu::env_util::ListFilesInDir;
@@ -111,6 +112,7 @@ struct AuthorizedActionHash {
 class MockSubprocessServer : public SubprocessServer {
  public:
   unordered_set<AuthorizedAction, AuthorizedActionHash> next_response_;
+  int num_executions_ = 0;
 
   Status Init() override {
     // don't want to start anything
@@ -124,6 +126,7 @@ class MockSubprocessServer : public SubprocessServer {
 
   Status Execute(SubprocessRequestPB* req,
                  SubprocessResponsePB* resp) override {
+    num_executions_++;
     RangerRequestListPB req_list;
     CHECK(req->request().UnpackTo(&req_list));
 
@@ -191,6 +194,48 @@ TEST_F(RangerClientTest, TestAuthorizeCreateTableAuthorized) {
   ASSERT_TRUE(authorized);
 }
 
+TEST_F(RangerClientTest, TestDecisionCache) {
+  FLAGS_ranger_authz_cache_capacity_mb = 1;
+  RangerClient client(env_, METRIC_ENTITY_server.Instantiate(&metric_registry_, "cached"));
+  std::unique_ptr<MockSubprocessServer> server(new MockSubprocessServer());
+  auto* mock = server.get();
+  client.ReplaceServerForTests(std::move(server));
+  mock->next_response_.emplace(AuthorizedAction{ "jdoe", ActionPB::METADATA, "foo", "bar", "" });
+
+  // Repeated checks of the same action are answered from the cache.
+  bool authorized;
+  for (int i = 0; i < 3; i++) {
+    ASSERT_OK(client.AuthorizeAction("jdoe", ActionPB::METADATA, "foo", "bar",
+                                     /*is_owner=*/false, /*requires_delegate_admin=*/false,
+                                     &authorized));
+    ASSERT_TRUE(authorized);
+    ASSERT_EQ(1, mock->num_executions_);
+  }
+  // Denials are cached too, separately for each user and action.
+  for (int i = 0; i < 2; i++) {
+    ASSERT_OK(client.AuthorizeAction("jdoe", ActionPB::DROP, "foo", "bar",
+                                     /*is_owner=*/false, /*requires_delegate_admin=*/false,
+                                     &authorized));
+    ASSERT_FALSE(authorized);
+    ASSERT_OK(client.AuthorizeAction("other", ActionPB::METADATA, "foo", "bar",
+                                     /*is_owner=*/false, /*requires_delegate_admin=*/false,
+                                     &authorized));
+    ASSERT_FALSE(authorized);
+    ASSERT_EQ(3, mock->num_executions_);
+  }
+
+  // Refreshing the policies invalidates the cached decisions. The mock server
+  // doesn't handle the refresh itself.
+  mock->next_response_.clear();
+  ASSERT_TRUE(client.RefreshPolicies().IsRemoteError());
+  ASSERT_EQ(4, mock->num_executions_);
+  ASSERT_OK(client.AuthorizeAction("jdoe", ActionPB::METADATA, "foo", "bar",
+                                   /*is_owner=*/false, /*requires_delegate_admin=*/false,
+                                   &authorized));
+  ASSERT_FALSE(authorized);
+  ASSERT_EQ(5, mock->num_executions_);
+}
+
 TEST_F(RangerClientTest, TestAuthorizeListNoTables) {
   unordered_map<string, bool> tables;
   ASSERT_OK(client_.AuthorizeActionMultipleTables("jdoe", ActionPB::METADATA, &tables));
@@ -18,6 +18,7 @@
 #include "kudu/ranger/ranger_client.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
 #include <ostream>
@@ -41,6 +42,7 @@
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/path_util.h"
 #include "kudu/util/scoped_cleanup.h"
@@ -108,6 +110,24 @@ DEFINE_bool(ranger_crash_master_on_subprocess_failure, true,
             "Whether to crash the Master if the Ranger subprocess crashes.");
 TAG_FLAG(ranger_crash_master_on_subprocess_failure, advanced);
 
+DEFINE_uint32(ranger_authz_cache_capacity_mb, 0,
+              "Capacity of the cache of the authorization decisions made by "
+              "Ranger for single actions, in MiBytes. A value of 0 means the "
+              "decisions are not cached. The cache is invalidated when the "
+              "Master refreshes the Ranger policies, but not when the Ranger "
+              "subprocess picks up policy changes on its own, so a decision "
+              "may be stale for up to --ranger_authz_cache_ttl_sec.");
+TAG_FLAG(ranger_authz_cache_capacity_mb, advanced);
+TAG_FLAG(ranger_authz_cache_capacity_mb, evolving);
+
+DEFINE_uint32(ranger_authz_cache_ttl_sec, 5,
+              "TTL of the entries in the cache of Ranger authorization "
+              "decisions, in seconds.");
+DEFINE_validator(ranger_authz_cache_ttl_sec,
+                 [](const char* /*n*/, uint32_t v) { return v > 0; });
+TAG_FLAG(ranger_authz_cache_ttl_sec, advanced);
+TAG_FLAG(ranger_authz_cache_ttl_sec, evolving);
+
 DECLARE_int32(max_log_files);
 DECLARE_uint32(max_log_size);
 DECLARE_uint32(subprocess_max_message_size_bytes);
@@ -193,6 +213,7 @@ using std::unordered_map;
 using std::unordered_set;
 using std::vector;
 using strings::Substitute;
+using strings::SubstituteAndAppend;
 
 namespace {
 
@@ -364,6 +385,20 @@ Status BuildArgv(const string& fifo_path, const string& log_properties_path,
   return Status::OK();
 }
 
+// Returns the key of the decision cache for the given request. The strings
+// are prefixed with their lengths to keep the keys unambiguous.
+string DecisionCacheKey(uint64_t generation, const string& user_name, ActionPB action,
+                        const string& database, const string& table, bool is_owner,
+                        bool requires_delegate_admin) {
+  string key = Substitute("$0/$1/$2$3/", generation, static_cast<int>(action),
+                          is_owner ? 1 : 0, requires_delegate_admin ? 1 : 0);
+  for (const string* s : { &user_name, &database, &table }) {
+    SubstituteAndAppend(&key, "$0:", s->size());
+    key.append(*s);
+  }
+  return key;
+}
+
 } // anonymous namespace
 
 bool ValidateRangerConfiguration() {
@@ -420,8 +455,16 @@ RangerSubprocessMetrics::RangerSubprocessMetrics(const scoped_refptr<MetricEntit
 #undef CINIT
 
 RangerClient::RangerClient(Env* env, const scoped_refptr<MetricEntity>& metric_entity)
-    : env_(env), metric_entity_(metric_entity) {
+    : env_(env),
+      metric_entity_(metric_entity),
+      policy_generation_(0) {
   DCHECK(metric_entity);
+  if (FLAGS_ranger_authz_cache_capacity_mb > 0) {
+    decision_cache_.reset(new DecisionCache(
+        FLAGS_ranger_authz_cache_capacity_mb * 1024 * 1024,
+        MonoDelta::FromSeconds(FLAGS_ranger_authz_cache_ttl_sec),
+        {}, 0, "ranger-authz-cache"));
+  }
 }
 
 Status RangerClient::Start() {
@@ -443,6 +486,19 @@ Status RangerClient::AuthorizeAction(const string& user_name, const ActionPB& ac
                                      bool requires_delegate_admin, bool* authorized,
                                      Scope scope) {
   DCHECK(subprocess_);
+  string cache_key;
+  if (decision_cache_) {
+    cache_key = DecisionCacheKey(policy_generation_.load(std::memory_order_acquire),
+                                 user_name, action, database,
+                                 scope == Scope::TABLE ? table : "",
+                                 is_owner, requires_delegate_admin);
+    auto handle = decision_cache_->Get(cache_key);
+    if (handle) {
+      *authorized = handle.value();
+      return Status::OK();
+    }
+  }
+
   RangerRequestListPB req_list;
   RangerResponseListPB resp_list;
   req_list.set_user(user_name);
@@ -462,6 +518,9 @@ Status RangerClient::AuthorizeAction(const string& user_name, const ActionPB& ac
 
   CHECK_EQ(1, resp_list.responses_size());
   *authorized = resp_list.responses().begin()->allowed();
+  if (decision_cache_) {
+    decision_cache_->Put(cache_key, unique_ptr<bool>(new bool(*authorized)));
+  }
   return Status::OK();
 }
 
@@ -590,6 +649,10 @@ Status RangerClient::RefreshPolicies() {
 
   req_list.mutable_control_request()->set_refresh_policies(true);
 
+  // Invalidate the cached decisions even if the refresh fails, since the
+  // subprocess may have picked up some of the new policies.
+  policy_generation_.fetch_add(1, std::memory_order_acq_rel);
+
   RETURN_NOT_OK(subprocess_->Execute(req_list, &resp_list));
 
   if (PREDICT_TRUE(!resp_list.control_response().success())) {
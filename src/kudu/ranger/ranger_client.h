@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -30,6 +32,7 @@
 #include "kudu/subprocess/subprocess_proxy.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/status.h"
+#include "kudu/util/ttl_cache.h"
 
 namespace kudu {
 
@@ -84,6 +87,9 @@ class RangerClient {
 
   // Authorizes an action on the table. Sets 'authorized' to true if it's
   // authorized, false otherwise.
+  //
+  // If --ranger_authz_cache_capacity_mb is positive, the decision may come
+  // from a cache of recent decisions, which RefreshPolicies() invalidates.
   Status AuthorizeAction(const std::string& user_name, const ActionPB& action,
                          const std::string& database, const std::string& table, bool is_owner,
                          bool requires_delegate_admin, bool* authorized,
@@ -112,7 +118,8 @@ class RangerClient {
 
   // Refreshes policies in the Ranger subprocess. This does not invalidate the
   // existing cache and doesn't fail if Ranger service is unavailable, it simply
-  // tries to refresh the policies from the server on a best effort basis.
+  // tries to refresh the policies from the server on a best effort basis. The
+  // decisions cached by AuthorizeAction() are invalidated though.
   Status RefreshPolicies() WARN_UNUSED_RESULT;
 
   // Replaces the subprocess server in the subprocess proxy.
@@ -125,9 +132,19 @@ class RangerClient {
   }
 
  private:
+  typedef TTLCache<std::string, bool> DecisionCache;
+
   Env* env_;
   std::unique_ptr<RangerSubprocess> subprocess_;
   scoped_refptr<MetricEntity> metric_entity_;
+
+  // Decisions of AuthorizeAction(), keyed by the request and the policy
+  // generation. Null if caching is disabled.
+  std::unique_ptr<DecisionCache> decision_cache_;
+
+  // Incremented by RefreshPolicies(), so that the decisions cached before
+  // aren't looked up anymore; they age out of the cache instead.
+  std::atomic<uint64_t> policy_generation_;
 };
 
 // Validate Ranger configuration.
@@ -0,0 +1,194 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/rebalance/load_balancing_algo.h"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace kudu {
+namespace rebalance {
+
+namespace {
+
+// Adds a tablet of table "T" with the replicas in 'replicas', given as
+// {tablet server, load} pairs, the first one being the leader.
+void AddTablet(const string& tablet_id,
+               const vector<std::pair<string, double>>& replicas,
+               ClusterLoadInfo* info) {
+  TabletLoadInfo tablet;
+  tablet.tablet_id = tablet_id;
+  tablet.table_id = "T";
+  for (const auto& r : replicas) {
+    ReplicaLoadInfo replica;
+    replica.ts_uuid = r.first;
+    replica.is_leader = tablet.replicas.empty();
+    replica.load = r.second;
+    tablet.replicas.emplace_back(std::move(replica));
+  }
+  info->tablets.emplace_back(std::move(tablet));
+}
+
+// Returns the load of each tablet server once 'moves' are applied, assuming a
+// replica's load moves along with it, and the leader and follower replicas
+// swap their loads with the leadership.
+unordered_map<string, double> LoadAfterMoves(ClusterLoadInfo info,
+                                             const vector<LoadMove>& moves) {
+  for (const auto& move : moves) {
+    for (auto& tablet : info.tablets) {
+      if (tablet.tablet_id != move.tablet_id) {
+        continue;
+      }
+      ReplicaLoadInfo* from = nullptr;
+      ReplicaLoadInfo* to = nullptr;
+      for (auto& r : tablet.replicas) {
+        if (r.ts_uuid == move.from) from = &r;
+        if (r.ts_uuid == move.to) to = &r;
+      }
+      CHECK(from);
+      if (move.type == LoadMove::Type::LEADER) {
+        CHECK(to);
+        CHECK(from->is_leader);
+        std::swap(from->load, to->load);
+        std::swap(from->is_leader, to->is_leader);
+      } else {
+        CHECK(!to);
+        from->ts_uuid = move.to;
+      }
+    }
+  }
+  unordered_map<string, double> load_by_ts;
+  for (const auto& elem : info.location_by_ts_id) {
+    load_by_ts[elem.first] = 0;
+  }
+  for (const auto& tablet : info.tablets) {
+    for (const auto& r : tablet.replicas) {
+      load_by_ts[r.ts_uuid] += r.load;
+    }
+  }
+  return load_by_ts;
+}
+
+} // anonymous namespace
+
+TEST(LoadBalancingAlgoTest, BalancedCluster) {
+  ClusterLoadInfo info;
+  info.location_by_ts_id = { { "A", "" }, { "B", "" }, { "C", "" } };
+  AddTablet("t0", { { "A", 10 }, { "B", 5 }, { "C", 5 } }, &info);
+  AddTablet("t1", { { "B", 10 }, { "C", 5 }, { "A", 5 } }, &info);
+  AddTablet("t2", { { "C", 10 }, { "A", 5 }, { "B", 5 } }, &info);
+
+  LoadBalancingAlgo algo(0.2);
+  vector<LoadMove> moves;
+  ASSERT_OK(algo.GetNextMoves(info, 0, &moves));
+  ASSERT_TRUE(moves.empty());
+}
+
+// A single hot tablet can't be spread by moving it around.
+TEST(LoadBalancingAlgoTest, SingleHotTablet) {
+  ClusterLoadInfo info;
+  info.location_by_ts_id = { { "A", "" }, { "B", "" }, { "C", "" } };
+  AddTablet("t0", { { "A", 100 }, { "B", 10 }, { "C", 10 } }, &info);
+  AddTablet("t1", { { "B", 2 }, { "C", 1 }, { "A", 1 } }, &info);
+  AddTablet("t2", { { "C", 2 }, { "A", 1 }, { "B", 1 } }, &info);
+
+  LoadBalancingAlgo algo(0.2);
+  vector<LoadMove> moves;
+  ASSERT_OK(algo.GetNextMoves(info, 0, &moves));
+  ASSERT_TRUE(moves.empty());
+}
+
+TEST(LoadBalancingAlgoTest, LeaderSwaps) {
+  ClusterLoadInfo info;
+  info.location_by_ts_id = { { "A", "" }, { "B", "" }, { "C", "" } };
+  AddTablet("t0", { { "A", 50 }, { "B", 10 }, { "C", 10 } }, &info);
+  AddTablet("t1", { { "A", 50 }, { "B", 10 }, { "C", 10 } }, &info);
+  AddTablet("t2", { { "B", 2 }, { "C", 1 }, { "A", 1 } }, &info);
+  AddTablet("t3", { { "C", 2 }, { "A", 1 }, { "B", 1 } }, &info);
+
+  LoadBalancingAlgo algo(0.2);
+  vector<LoadMove> moves;
+  ASSERT_OK(algo.GetNextMoves(info, 0, &moves));
+  ASSERT_EQ(4, moves.size());
+  for (const auto& move : moves) {
+    ASSERT_EQ(LoadMove::Type::LEADER, move.type);
+  }
+  // The leadership of both hot tablets moved off "A", to different servers.
+  const auto load_by_ts = LoadAfterMoves(info, moves);
+  ASSERT_EQ(24, load_by_ts.at("A"));
+  ASSERT_EQ(62, load_by_ts.at("B"));
+  ASSERT_EQ(62, load_by_ts.at("C"));
+
+  // Each swap counts as two moves.
+  ASSERT_OK(algo.GetNextMoves(info, 3, &moves));
+  ASSERT_EQ(2, moves.size());
+}
+
+TEST(LoadBalancingAlgoTest, ReplicaSwaps) {
+  ClusterLoadInfo info;
+  info.location_by_ts_id = { { "A", "L0" }, { "B", "L0" }, { "C", "L0" }, { "D", "L0" } };
+  AddTablet("t0", { { "C", 5 }, { "A", 60 } }, &info);
+  AddTablet("t1", { { "D", 5 }, { "A", 60 } }, &info);
+  AddTablet("t2", { { "C", 5 }, { "B", 1 } }, &info);
+  AddTablet("t3", { { "D", 5 }, { "B", 1 } }, &info);
+
+  LoadBalancingAlgo algo(0.2);
+  vector<LoadMove> moves;
+  ASSERT_OK(algo.GetNextMoves(info, 0, &moves));
+  ASSERT_EQ(2, moves.size());
+  for (const auto& move : moves) {
+    ASSERT_EQ(LoadMove::Type::REPLICA, move.type);
+  }
+  ASSERT_EQ("A", moves[0].from);
+  ASSERT_EQ("B", moves[0].to);
+  ASSERT_EQ("B", moves[1].from);
+  ASSERT_EQ("A", moves[1].to);
+  const auto load_by_ts = LoadAfterMoves(info, moves);
+  ASSERT_EQ(61, load_by_ts.at("A"));
+  ASSERT_EQ(61, load_by_ts.at("B"));
+
+  // Replicas aren't swapped across locations.
+  info.location_by_ts_id["B"] = "L1";
+  ASSERT_OK(algo.GetNextMoves(info, 0, &moves));
+  ASSERT_TRUE(moves.empty());
+}
+
+TEST(LoadBalancingAlgoTest, UnknownTabletServer) {
+  ClusterLoadInfo info;
+  info.location_by_ts_id = { { "A", "" }, { "B", "" } };
+  AddTablet("t0", { { "A", 1 }, { "X", 1 } }, &info);
+
+  LoadBalancingAlgo algo(0.2);
+  vector<LoadMove> moves;
+  Status s = algo.GetNextMoves(info, 0, &moves);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+}
+
+} // namespace rebalance
+} // namespace kudu
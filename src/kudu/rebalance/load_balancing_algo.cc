@@ -0,0 +1,245 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/rebalance/load_balancing_algo.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/substitute.h"
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace rebalance {
+
+namespace {
+
+// A swap is only worth it if it lowers the maximum load by this fraction.
+const double kMinImprovement = 0.01;
+
+struct Replica {
+  double load;
+  bool is_leader;
+  uint64_t on_disk_size;
+};
+
+// A candidate swap of 'tablet_out' moving from the most loaded server to
+// 'to', and 'tablet_in' moving the other way round.
+struct Swap {
+  LoadMove::Type type;
+  int tablet_out = -1;
+  int tablet_in = -1;
+  string to;
+  // The load moved off the most loaded server.
+  double delta = 0;
+  // The maximum load of the two servers after the swap.
+  double new_max_load = std::numeric_limits<double>::max();
+  // The size of the replicas moved.
+  uint64_t on_disk_size = 0;
+};
+
+} // anonymous namespace
+
+LoadBalancingAlgo::LoadBalancingAlgo(double imbalance_threshold)
+    : imbalance_threshold_(imbalance_threshold) {
+}
+
+Status LoadBalancingAlgo::GetNextMoves(const ClusterLoadInfo& cluster_info,
+                                       int max_moves_num,
+                                       vector<LoadMove>* moves) {
+  DCHECK_GE(max_moves_num, 0);
+  DCHECK(moves);
+  moves->clear();
+  const size_t max_moves = max_moves_num == 0 ? std::numeric_limits<size_t>::max()
+                                              : static_cast<size_t>(max_moves_num);
+
+  // The replicas of each tablet by tablet server, and the tablets by table.
+  const auto& tablets = cluster_info.tablets;
+  vector<unordered_map<string, Replica>> replicas(tablets.size());
+  unordered_map<string, vector<int>> tablets_by_table;
+  unordered_map<string, double> load_by_ts;
+  for (const auto& elem : cluster_info.location_by_ts_id) {
+    load_by_ts.emplace(elem.first, 0);
+  }
+  for (size_t i = 0; i < tablets.size(); ++i) {
+    for (const auto& r : tablets[i].replicas) {
+      double* ts_load = FindOrNull(load_by_ts, r.ts_uuid);
+      if (!ts_load) {
+        return Status::InvalidArgument(Substitute(
+            "tablet $0 has a replica on unknown tablet server $1",
+            tablets[i].tablet_id, r.ts_uuid));
+      }
+      *ts_load += r.load;
+      replicas[i].emplace(r.ts_uuid, Replica{ r.load, r.is_leader, r.on_disk_size });
+    }
+    tablets_by_table[tablets[i].table_id].emplace_back(static_cast<int>(i));
+  }
+  if (load_by_ts.size() < 2) {
+    return Status::OK();
+  }
+
+  vector<bool> moved(tablets.size(), false);
+  while (moves->size() + 2 <= max_moves) {
+    // Find the most loaded server, breaking ties by identifier so that the
+    // outcome is deterministic.
+    string hot;
+    double hot_load = -1;
+    double total_load = 0;
+    for (const auto& elem : load_by_ts) {
+      total_load += elem.second;
+      if (elem.second > hot_load || (elem.second == hot_load && elem.first < hot)) {
+        hot = elem.first;
+        hot_load = elem.second;
+      }
+    }
+    const double mean_load = total_load / load_by_ts.size();
+    if (hot_load <= 0 || hot_load <= mean_load * (1 + imbalance_threshold_)) {
+      break;
+    }
+    const string& hot_location = FindOrDie(cluster_info.location_by_ts_id, hot);
+
+    Swap best_leader_swap;
+    best_leader_swap.type = LoadMove::Type::LEADER;
+    Swap best_replica_swap;
+    best_replica_swap.type = LoadMove::Type::REPLICA;
+    const auto consider = [&](Swap* best, int tablet_out, int tablet_in, const string& to,
+                              double to_load, double delta, uint64_t on_disk_size) {
+      const double new_max_load = std::max(hot_load - delta, to_load + delta);
+      if (new_max_load < best->new_max_load ||
+          (new_max_load == best->new_max_load && on_disk_size < best->on_disk_size)) {
+        best->tablet_out = tablet_out;
+        best->tablet_in = tablet_in;
+        best->to = to;
+        best->delta = delta;
+        best->new_max_load = new_max_load;
+        best->on_disk_size = on_disk_size;
+      }
+    };
+
+    for (const auto& ts_elem : load_by_ts) {
+      const string& ts = ts_elem.first;
+      const double ts_load = ts_elem.second;
+      if (ts == hot || ts_load >= hot_load) {
+        continue;
+      }
+      const bool same_location = FindOrDie(cluster_info.location_by_ts_id, ts) == hot_location;
+      for (const auto& table_elem : tablets_by_table) {
+        const auto& table_tablets = table_elem.second;
+
+        // The tablets to move onto the most loaded server which add the least
+        // load to it.
+        int leader_in = -1;
+        double leader_in_load = std::numeric_limits<double>::max();
+        int replica_in = -1;
+        double replica_in_load = std::numeric_limits<double>::max();
+        uint64_t replica_in_size = 0;
+        for (int idx : table_tablets) {
+          if (moved[idx]) {
+            continue;
+          }
+          const Replica* on_hot = FindOrNull(replicas[idx], hot);
+          const Replica* on_ts = FindOrNull(replicas[idx], ts);
+          if (on_hot && on_ts && on_ts->is_leader &&
+              on_ts->load - on_hot->load < leader_in_load) {
+            leader_in = idx;
+            leader_in_load = on_ts->load - on_hot->load;
+          }
+          if (same_location && !on_hot && on_ts && !on_ts->is_leader &&
+              (on_ts->load < replica_in_load ||
+               (on_ts->load == replica_in_load && on_ts->on_disk_size < replica_in_size))) {
+            replica_in = idx;
+            replica_in_load = on_ts->load;
+            replica_in_size = on_ts->on_disk_size;
+          }
+        }
+        if (leader_in < 0 && replica_in < 0) {
+          continue;
+        }
+
+        // Pair them with the tablets to move off the most loaded server.
+        for (int idx : table_tablets) {
+          if (moved[idx]) {
+            continue;
+          }
+          const Replica* on_hot = FindOrNull(replicas[idx], hot);
+          if (!on_hot) {
+            continue;
+          }
+          const Replica* on_ts = FindOrNull(replicas[idx], ts);
+          if (leader_in >= 0 && on_hot->is_leader && on_ts) {
+            consider(&best_leader_swap, idx, leader_in, ts, ts_load,
+                     on_hot->load - on_ts->load - leader_in_load, 0);
+          }
+          if (replica_in >= 0 && !on_hot->is_leader && !on_ts) {
+            consider(&best_replica_swap, idx, replica_in, ts, ts_load,
+                     on_hot->load - replica_in_load, on_hot->on_disk_size + replica_in_size);
+          }
+        }
+      }
+    }
+
+    const double max_new_max_load = hot_load * (1 - kMinImprovement);
+    const Swap* swap = nullptr;
+    if (best_leader_swap.new_max_load < max_new_max_load) {
+      swap = &best_leader_swap;
+    } else if (best_replica_swap.new_max_load < max_new_max_load) {
+      swap = &best_replica_swap;
+    } else {
+      // The load of the most loaded server can't be lowered.
+      break;
+    }
+
+    // Update the model with the outcome of the swap.
+    auto& out_replicas = replicas[swap->tablet_out];
+    auto& in_replicas = replicas[swap->tablet_in];
+    if (swap->type == LoadMove::Type::LEADER) {
+      std::swap(out_replicas[hot], out_replicas[swap->to]);
+      std::swap(in_replicas[hot], in_replicas[swap->to]);
+    } else {
+      out_replicas[swap->to] = out_replicas[hot];
+      out_replicas.erase(hot);
+      in_replicas[hot] = in_replicas[swap->to];
+      in_replicas.erase(swap->to);
+    }
+    load_by_ts[hot] -= swap->delta;
+    load_by_ts[swap->to] += swap->delta;
+    moved[swap->tablet_out] = true;
+    moved[swap->tablet_in] = true;
+
+    VLOG(1) << Substitute("swapping $0 of tablets $1 and $2 between $3 and $4 moves $5 load",
+                          swap->type == LoadMove::Type::LEADER ? "leadership" : "replicas",
+                          tablets[swap->tablet_out].tablet_id,
+                          tablets[swap->tablet_in].tablet_id,
+                          hot, swap->to, swap->delta);
+    moves->push_back({ swap->type, tablets[swap->tablet_out].tablet_id, hot, swap->to });
+    moves->push_back({ swap->type, tablets[swap->tablet_in].tablet_id, swap->to, hot });
+  }
+  return Status::OK();
+}
+
+} // namespace rebalance
+} // namespace kudu
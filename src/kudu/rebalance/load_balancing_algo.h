@@ -0,0 +1,126 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace rebalance {
+
+// The load of a tablet replica, e.g. the rows it reads and writes per second.
+struct ReplicaLoadInfo {
+  // Unique identifier of the tablet server hosting the replica.
+  std::string ts_uuid;
+
+  // Whether the replica is the leader of the tablet.
+  bool is_leader = false;
+
+  // The load of the replica, in arbitrary units common to all replicas.
+  double load = 0;
+
+  // The size of the replica on disk, in bytes.
+  uint64_t on_disk_size = 0;
+};
+
+// The load of the replicas of a tablet.
+struct TabletLoadInfo {
+  std::string tablet_id;
+  std::string table_id;
+  std::vector<ReplicaLoadInfo> replicas;
+};
+
+// Load information for a cluster as input for LoadBalancingAlgo.
+struct ClusterLoadInfo {
+  // Mapping 'tablet server identifier' --> 'location' for all the tablet
+  // servers to balance, including those without replicas.
+  std::unordered_map<std::string, std::string> location_by_ts_id;
+
+  // The tablets which replicas may be moved.
+  std::vector<TabletLoadInfo> tablets;
+};
+
+// A directive to move the leadership or a replica of a tablet between two
+// tablet servers.
+struct LoadMove {
+  enum class Type {
+    // Transfer the leadership of the tablet from 'from' to 'to', which hosts
+    // a follower replica of the tablet.
+    LEADER,
+    // Move the replica of the tablet from 'from' to 'to'.
+    REPLICA,
+  };
+
+  Type type;
+  std::string tablet_id;
+
+  // Unique identifier of the source tablet server.
+  std::string from;
+
+  // Unique identifier of the target tablet server.
+  std::string to;
+};
+
+// A greedy algorithm minimizing the maximum load of the tablet servers of a
+// cluster, for clusters which replica counts are balanced but not their load,
+// e.g. because some tablets are much hotter than others.
+//
+// The load of a tablet server is the sum of the load of its replicas. While the
+// most loaded server is loaded more than (1 + 'imbalance_threshold') times the
+// mean load, the algorithm looks for the swap between that server and another
+// which lowers the maximum load of the two the most:
+//
+//   * A leader swap transfers the leadership of a tablet from the most loaded
+//     server to a server hosting a follower replica of it, and the leadership
+//     of another tablet of the same table the other way round. The leader and
+//     the follower replicas are assumed to swap their loads.
+//   * A replica swap moves a follower replica of a tablet from the most loaded
+//     server to a server of the same location, and a follower replica of
+//     another tablet of the same table the other way round, carrying their
+//     loads along. Among the replicas of equal load, the smallest on disk are
+//     moved first.
+//
+// Leader swaps are cheap, so they're preferred over replica swaps whenever
+// they lower the maximum load. Since swaps are per table, the replica and
+// leader counts of every table on every server are unchanged: the moves don't
+// compete with the ones of the replica count and leader rebalancers. Each
+// tablet is moved at most once per call.
+class LoadBalancingAlgo {
+ public:
+  explicit LoadBalancingAlgo(double imbalance_threshold);
+
+  // Using the load information of the cluster in 'cluster_info', populates
+  // 'moves' with no more than 'max_moves_num' moves, counting each swap as two
+  // moves, where '0' is a shortcut for 'the possible maximum'. Once this
+  // method leaves 'moves' empty, the load of the cluster is considered
+  // balanced, or it can't be improved by swaps.
+  //
+  // 'moves' must be non-NULL.
+  Status GetNextMoves(const ClusterLoadInfo& cluster_info,
+                      int max_moves_num,
+                      std::vector<LoadMove>* moves);
+
+ private:
+  const double imbalance_threshold_;
+};
+
+} // namespace rebalance
+} // namespace kudu
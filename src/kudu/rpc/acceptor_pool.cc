@@ -18,6 +18,7 @@
 #include "kudu/rpc/acceptor_pool.h"
 
 #include <functional>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -44,6 +45,7 @@
 #include "kudu/util/thread.h"
 
 using std::string;
+using std::unique_ptr;
 using strings::Substitute;
 
 METRIC_DEFINE_counter(server, rpc_connections_accepted,
@@ -133,12 +135,15 @@ namespace rpc {
 AcceptorPool::AcceptorPool(Messenger* messenger,
                            Socket* socket,
                            const Sockaddr& bind_address,
-                           int listen_backlog)
+                           int listen_backlog,
+                           int num_shards)
     : messenger_(messenger),
       socket_(socket->Release()),
       bind_address_(bind_address),
       listen_backlog_(listen_backlog),
+      num_shards_(num_shards),
       closing_(false) {
+  DCHECK_GE(num_shards_, 1);
   const auto& metric_entity = messenger->metric_entity();
   auto& connections_accepted = bind_address.is_ip()
       ? METRIC_rpc_connections_accepted
@@ -155,19 +160,39 @@ AcceptorPool::~AcceptorPool() {
 
 Status AcceptorPool::Start(int num_threads) {
   RETURN_NOT_OK(socket_.Listen(listen_backlog_));
+  if (num_shards_ > 1) {
+    // The other shards bind to the port actually bound by the first one, in
+    // case an ephemeral port was requested.
+    Sockaddr bound_addr;
+    RETURN_NOT_OK(socket_.GetSocketAddress(&bound_addr));
+    for (int i = 1; i < num_shards_; i++) {
+      unique_ptr<Socket> sock(new Socket);
+      RETURN_NOT_OK(sock->Init(bound_addr.family(), 0));
+      RETURN_NOT_OK(sock->SetReuseAddr(true));
+      RETURN_NOT_OK(sock->SetReusePort(true));
+      RETURN_NOT_OK_PREPEND(sock->Bind(bound_addr),
+                            Substitute("unable to bind acceptor shard $0", i));
+      RETURN_NOT_OK(sock->Listen(listen_backlog_));
+      shard_sockets_.emplace_back(std::move(sock));
+    }
+  }
 #if defined(__linux__)
   WARN_NOT_OK(diag_socket_.Init(), "could not initialize diagnostic socket");
 #endif
 
-  for (int i = 0; i < num_threads; i++) {
-    scoped_refptr<Thread> new_thread;
-    Status s = Thread::Create("acceptor pool", "acceptor",
-                              [this]() { this->RunThread(); }, &new_thread);
-    if (PREDICT_FALSE(!s.ok())) {
-      Shutdown();
-      return s;
+  for (int shard_idx = 0; shard_idx < num_shards_; shard_idx++) {
+    Socket* sock = shard_idx == 0 ? &socket_ : shard_sockets_[shard_idx - 1].get();
+    for (int i = 0; i < num_threads; i++) {
+      scoped_refptr<Thread> new_thread;
+      Status s = Thread::Create("acceptor pool", "acceptor",
+                                [this, sock, shard_idx]() { this->RunThread(sock, shard_idx); },
+                                &new_thread);
+      if (PREDICT_FALSE(!s.ok())) {
+        Shutdown();
+        return s;
+      }
+      threads_.emplace_back(std::move(new_thread));
     }
-    threads_.emplace_back(std::move(new_thread));
   }
   return Status::OK();
 }
@@ -186,6 +211,11 @@ void AcceptorPool::Shutdown() {
   WARN_NOT_OK(socket_.Shutdown(true, true),
               Substitute("Could not shut down acceptor socket on $0",
                          bind_address_.ToString()));
+  for (const auto& sock : shard_sockets_) {
+    WARN_NOT_OK(sock->Shutdown(true, true),
+                Substitute("Could not shut down acceptor socket on $0",
+                           bind_address_.ToString()));
+  }
 #else
   // Calling shutdown on an accepting (non-connected) socket is illegal on most
   // platforms (but not Linux). Instead, the accepting threads are interrupted
@@ -211,6 +241,9 @@ void AcceptorPool::Shutdown() {
   // here, it would  necessary to wait until Messenger::Shutdown() is called for
   // the corresponding messenger object to close this socket.
   ignore_result(socket_.Close());
+  for (const auto& sock : shard_sockets_) {
+    ignore_result(sock->Close());
+  }
 }
 
 Sockaddr AcceptorPool::bind_address() const {
@@ -228,19 +261,24 @@ int64_t AcceptorPool::num_rpc_connections_accepted() const {
 Status AcceptorPool::GetPendingConnectionsNum(uint32_t* result) const {
   DiagnosticSocket::TcpSocketInfo info;
   RETURN_NOT_OK(diag_socket_.Query(socket_, &info));
-  *result = info.rx_queue_size;
+  uint32_t num_pending = info.rx_queue_size;
+  for (const auto& sock : shard_sockets_) {
+    RETURN_NOT_OK(diag_socket_.Query(*sock, &info));
+    num_pending += info.rx_queue_size;
+  }
+  *result = num_pending;
 
   return Status::OK();
 }
 
-void AcceptorPool::RunThread() {
+void AcceptorPool::RunThread(Socket* socket, int shard_idx) {
   const int64_t kCyclesPerSecond = static_cast<int64_t>(base::CyclesPerSecond());
 
   // Fetch and keep the information on the listening socket's address to avoid
   // re-fetching it every time when accepting a new connection.
   // The diagnostic socket is needed to fetch information on the RX queue size.
   Sockaddr cur_addr;
-  WARN_NOT_OK(socket_.GetSocketAddress(&cur_addr),
+  WARN_NOT_OK(socket->GetSocketAddress(&cur_addr),
               "unable to get address info on RPC socket");
   const auto& cur_addr_str = cur_addr.ToString();
 
@@ -268,8 +306,8 @@ void AcceptorPool::RunThread() {
     Socket new_sock;
     Sockaddr remote;
     VLOG(2) << Substitute("calling accept() on socket $0 listening on $1",
-                          socket_.GetFd(), bind_address_.ToString());
-    const auto s = socket_.Accept(&new_sock, &remote, Socket::FLAG_NONBLOCKING);
+                          socket->GetFd(), bind_address_.ToString());
+    const auto s = socket->Accept(&new_sock, &remote, Socket::FLAG_NONBLOCKING);
     const auto accepted_at = CycleClock::Now();
 
     if (ds_query_enabled && ds.IsInitialized() &&
@@ -279,7 +317,7 @@ void AcceptorPool::RunThread() {
       // (a.k.a. listen backlog), collect information on the number
       // of connections in the queue still waiting to be accepted.
       DiagnosticSocket::TcpSocketInfo info;
-      if (auto s = ds.Query(socket_, &info); PREDICT_TRUE(s.ok())) {
+      if (auto s = ds.Query(*socket, &info); PREDICT_TRUE(s.ok())) {
         listen_socket_queue_size_->Increment(info.rx_queue_size);
       } else if (!closing_) {
         KLOG_EVERY_N_SECS(WARNING, 60)
@@ -319,7 +357,11 @@ void AcceptorPool::RunThread() {
         continue;
       }
     }
-    messenger_->RegisterInboundSocket(&new_sock, remote);
+    if (num_shards_ > 1) {
+      messenger_->RegisterInboundSocket(&new_sock, remote, shard_idx);
+    } else {
+      messenger_->RegisterInboundSocket(&new_sock, remote);
+    }
     rpc_connections_accepted_->Increment();
   }
   VLOG(1) << "AcceptorPool shutting down";
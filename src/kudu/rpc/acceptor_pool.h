@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "kudu/gutil/macros.h"
@@ -49,13 +50,20 @@ class AcceptorPool {
   // Create a new acceptor pool.  Calls socket::Release to take ownership of the
   // socket.
   // 'socket' must be already bound, but should not yet be listening.
+  //
+  // If 'num_shards' is greater than 1, 'socket' must have SO_REUSEPORT set:
+  // the pool then listens on 'num_shards' sockets bound to the same address,
+  // the connections accepted on the shard N being handled by the reactor N of
+  // the messenger.
   AcceptorPool(Messenger* messenger,
                Socket* socket,
                const Sockaddr& bind_address,
-               int listen_backlog = kDefaultListenBacklog);
+               int listen_backlog = kDefaultListenBacklog,
+               int num_shards = 1);
   ~AcceptorPool();
 
-  // Start listening and accepting connections.
+  // Start listening and accepting connections, with 'num_threads' threads per
+  // shard.
   Status Start(int num_threads);
   void Shutdown();
 
@@ -72,17 +80,24 @@ class AcceptorPool {
   int64_t num_rpc_connections_accepted() const;
 
   // Upon success, return Status::OK() and write the current size of the
-  // listening socket's RX queue into the 'result' out parameter. Otherwise,
+  // listening sockets' RX queues into the 'result' out parameter. Otherwise,
   // return corresponding status and leave the 'result' out parameter untouched.
   Status GetPendingConnectionsNum(uint32_t* result) const;
 
  private:
-  void RunThread();
+  // Accepts the connections of the listening socket of the shard 'shard_idx'.
+  void RunThread(Socket* socket, int shard_idx);
 
   Messenger* messenger_;
   Socket socket_;
   const Sockaddr bind_address_;
   const int listen_backlog_;
+  const int num_shards_;
+
+  // The listening sockets of the shards other than the first one, whose
+  // socket is 'socket_'.
+  std::vector<std::unique_ptr<Socket>> shard_sockets_;
+
   std::vector<scoped_refptr<Thread>> threads_;
   DiagnosticSocket diag_socket_;
 
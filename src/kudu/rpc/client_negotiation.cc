@@ -50,6 +50,7 @@
 #include "kudu/security/token.pb.h"
 #include "kudu/util/debug/leakcheck_disabler.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/net/socket.h"
 #include "kudu/util/slice.h"
@@ -64,6 +65,17 @@
 
 DECLARE_bool(rpc_encrypt_loopback_connections);
 
+DEFINE_bool(rpc_tls_session_resumption, false,
+            "Whether the TLS handshakes of the outbound RPC connections offer to "
+            "resume the TLS session last established with the same server. The "
+            "resumed handshakes skip the exchange and the verification of the "
+            "certificates, along with the public key operations of the full "
+            "handshakes. The servers resume the sessions of the tickets they "
+            "issued, until they restart.");
+TAG_FLAG(rpc_tls_session_resumption, advanced);
+TAG_FLAG(rpc_tls_session_resumption, experimental);
+TAG_FLAG(rpc_tls_session_resumption, runtime);
+
 using kudu::security::RpcEncryption;
 using std::set;
 using std::string;
@@ -192,7 +204,16 @@ Status ClientNegotiation::Negotiate(unique_ptr<ErrorStatusPB>* rpc_error) {
   // Step 3: if both ends support TLS, do a TLS handshake.
   if (encryption_ != RpcEncryption::DISABLED &&
       ContainsKey(server_features_, TLS)) {
-    RETURN_NOT_OK(tls_context_->InitiateHandshake(&tls_handshake_));
+    string session_key;
+    if (FLAGS_rpc_tls_session_resumption) {
+      // The sessions established without verifying the server's certificate
+      // mustn't be resumed by the handshakes which would verify it.
+      Sockaddr peer;
+      RETURN_NOT_OK(socket_->GetPeerAddress(&peer));
+      session_key = Substitute("$0/$1/$2", helper_.server_fqdn() ? helper_.server_fqdn() : "",
+                               peer.ToString(), AuthenticationTypeToString(negotiated_authn_));
+    }
+    RETURN_NOT_OK(tls_context_->InitiateHandshake(&tls_handshake_, session_key));
 
     if (negotiated_authn_ == AuthenticationType::SASL) {
       // When using SASL authentication, verifying the server's certificate is
@@ -542,6 +563,9 @@ Status ClientNegotiation::HandleTlsHandshake(const NegotiatePB& response) {
   RETURN_NOT_OK(s);
 
   // TLS handshake is finished.
+  if (tls_handshake_.session_reused()) {
+    TRACE("Resumed TLS session");
+  }
   if (ContainsKey(server_features_, TLS_AUTHENTICATION_ONLY) &&
       ContainsKey(client_features_, TLS_AUTHENTICATION_ONLY)) {
     TRACE("Negotiated auth-only $0 with cipher $1",
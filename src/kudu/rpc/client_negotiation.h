@@ -96,6 +96,12 @@ class ClientNegotiation {
     return tls_negotiated_;
   }
 
+  // Returns true if the TLS handshake resumed a previous TLS session.
+  // Must be called after Negotiate().
+  bool tls_session_reused() const {
+    return tls_negotiated_ && tls_handshake_.session_reused();
+  }
+
   // Returns the set of RPC system features supported by the remote server.
   // Must be called before Negotiate().
   std::set<RpcFeatureFlag> server_features() const {
@@ -17,16 +17,23 @@
 
 #include "kudu/rpc/connection.h"
 
+#include <sys/uio.h>
+
 #include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <boost/intrusive/detail/list_iterator.hpp>
 #include <boost/intrusive/list.hpp>
 #include <ev.h>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/gutil/map-util.h"
@@ -41,19 +48,74 @@
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/rpc_introspection.pb.h"
 #include "kudu/rpc/transfer.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/net/socket.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
+#include "kudu/util/string_case.h"
 
 using std::includes;
 using std::set;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
+using std::vector;
 using strings::Substitute;
 
+DEFINE_int32(rpc_max_send_iovecs, 64,
+             "Maximum number of buffers of a single write to the socket of an RPC "
+             "connection. Several outbound calls or responses queued on a "
+             "connection are coalesced into a single write as long as all of "
+             "their buffers fit. A call or response with more buffers is still "
+             "sent on its own. If 1, calls and responses are never coalesced.");
+TAG_FLAG(rpc_max_send_iovecs, advanced);
+TAG_FLAG(rpc_max_send_iovecs, runtime);
+DEFINE_validator(rpc_max_send_iovecs,
+                 [](const char* /* flagname */, int32_t value) {
+                   return value >= 1 && value <= IOV_MAX;
+                 });
+
+DEFINE_string(rpc_compression_codec, "NO_COMPRESSION",
+              "Codec to compress the bodies of RPC requests and responses with, "
+              "sidecars included, when sending them to peers which are able to "
+              "uncompress them. One of NO_COMPRESSION, LZ4 or ZSTD. Loopback "
+              "connections are never compressed. Meant for links where bandwidth "
+              "is scarcer than CPU, e.g. across datacenters: see also "
+              "--rpc_compression_subnets and --rpc_compression_min_bytes.");
+TAG_FLAG(rpc_compression_codec, advanced);
+TAG_FLAG(rpc_compression_codec, experimental);
+DEFINE_validator(rpc_compression_codec,
+                 [](const char* /* flagname */, const string& value) {
+                   const auto type = kudu::GetCompressionCodecType(value);
+                   return type == kudu::LZ4 || type == kudu::ZSTD ||
+                       (type == kudu::NO_COMPRESSION && kudu::iequals(value, "NO_COMPRESSION"));
+                 });
+
+DEFINE_string(rpc_compression_subnets, "",
+              "Comma-separated list of subnets in CIDR notation. If set, only the "
+              "connections with peers within these subnets are compressed as per "
+              "--rpc_compression_codec, e.g. the subnets of the remote datacenters "
+              "so that only the cross-datacenter links pay for the compression. "
+              "If empty, all the connections with remote peers are.");
+TAG_FLAG(rpc_compression_subnets, advanced);
+TAG_FLAG(rpc_compression_subnets, experimental);
+DEFINE_validator(rpc_compression_subnets,
+                 [](const char* /* flagname */, const string& value) {
+                   vector<kudu::Network> subnets;
+                   return kudu::Network::ParseCIDRStrings(value, &subnets).ok();
+                 });
+
+DEFINE_bool(rpc_compress_loopback_connections, false,
+            "Whether to compress loopback connections as well when "
+            "--rpc_compression_codec is set. For testing only.");
+TAG_FLAG(rpc_compress_loopback_connections, hidden);
+TAG_FLAG(rpc_compress_loopback_connections, unsafe);
+
 namespace kudu {
 namespace rpc {
 
@@ -77,7 +139,9 @@ Connection::Connection(ReactorThread* reactor_thread,
       credentials_policy_(policy),
       negotiation_complete_(false),
       is_confidential_(false),
-      scheduled_for_shutdown_(false) {
+      body_codec_(nullptr),
+      scheduled_for_shutdown_(false),
+      outbound_flush_pending_(false) {
 }
 
 Status Connection::SetNonBlocking(bool enabled) {
@@ -211,12 +275,30 @@ void Connection::QueueOutbound(unique_ptr<OutboundTransfer> transfer) {
 
   outbound_transfers_.push_back(*transfer.release());
 
+  if (outbound_flush_pending_) {
+    return;
+  }
   if (negotiation_complete_ && !write_io_.is_active()) {
-    // Optimistically assume that the socket is writable if we didn't already
-    // have something queued.
-    if (ProcessOutboundTransfers() == kMoreToSend) {
-      write_io_.start();
+    // While the reactor thread runs a batch of tasks, the transfers these
+    // queue on the connection are sent together once the batch ran.
+    if (reactor_thread_->ScheduleOutboundFlush(this)) {
+      outbound_flush_pending_ = true;
+      return;
     }
+    FlushOutboundTransfers();
+  }
+}
+
+void Connection::FlushOutboundTransfers() {
+  DCHECK(reactor_thread_->IsCurrentThread());
+  outbound_flush_pending_ = false;
+  if (PREDICT_FALSE(!shutdown_status_.ok()) || write_io_.is_active()) {
+    return;
+  }
+  // Optimistically assume that the socket is writable if we didn't already
+  // have something queued.
+  if (ProcessOutboundTransfers() == kMoreToSend) {
+    write_io_.start();
   }
 }
 
@@ -355,7 +437,7 @@ void Connection::QueueOutboundCall(shared_ptr<OutboundCall> call) {
 
   // Serialize the actual bytes to be put on the wire.
   TransferPayload tmp_slices;
-  call->SerializeTo(&tmp_slices);
+  call->SerializeTo(&tmp_slices, body_codec_);
 
   call->SetQueued();
 
@@ -650,64 +732,104 @@ void Connection::WriteHandler(ev::io& /*watcher*/, int revents) {
   }
 }
 
-Connection::ProcessOutboundTransfersResult Connection::ProcessOutboundTransfers() {
-  while (!outbound_transfers_.empty()) {
-    OutboundTransfer* transfer = &outbound_transfers_.front();
-
-    if (!transfer->TransferStarted()) {
-      if (transfer->is_for_outbound_call()) {
-        CallAwaitingResponse* car = FindOrDie(awaiting_response_, transfer->call_id());
-        if (!car->call) {
-          // If the call has already timed out or has already been cancelled, the 'call'
-          // field would be set to NULL. In that case, don't bother sending it.
-          outbound_transfers_.pop_front();
-          transfer->Abort(Status::Aborted("already timed out or cancelled"));
-          delete transfer;
-          continue;
-        }
+bool Connection::StartOutboundTransfer(
+    boost::intrusive::list<OutboundTransfer>::iterator* it) {
+  OutboundTransfer* transfer = &**it;
+  DCHECK(!transfer->TransferStarted());
+  if (!transfer->is_for_outbound_call()) {
+    return true;
+  }
 
-        // If this is the start of the transfer, then check if the server has the
-        // required RPC flags. We have to wait until just before the transfer in
-        // order to ensure that the negotiation has taken place, so that the flags
-        // are available.
-        const set<RpcFeatureFlag>& required_features = car->call->required_rpc_features();
-        if (!includes(remote_features_.begin(), remote_features_.end(),
-                      required_features.begin(), required_features.end())) {
-          outbound_transfers_.pop_front();
-          Status s = Status::NotSupported("server does not support the required RPC features");
-          transfer->Abort(s);
-          Phase phase = negotiation_complete_ ? Phase::REMOTE_CALL : Phase::CONNECTION_NEGOTIATION;
-          car->call->SetFailed(std::move(s), phase);
-          // Test cancellation when 'call_' is in 'FINISHED_ERROR' state.
-          MaybeInjectCancellation(car->call);
-          car->call.reset();
-          delete transfer;
-          continue;
-        }
+  CallAwaitingResponse* car = FindOrDie(awaiting_response_, transfer->call_id());
+  if (!car->call) {
+    // If the call has already timed out or has already been cancelled, the 'call'
+    // field would be set to NULL. In that case, don't bother sending it.
+    *it = outbound_transfers_.erase(*it);
+    transfer->Abort(Status::Aborted("already timed out or cancelled"));
+    delete transfer;
+    return false;
+  }
+
+  // If this is the start of the transfer, then check if the server has the
+  // required RPC flags. We have to wait until just before the transfer in
+  // order to ensure that the negotiation has taken place, so that the flags
+  // are available.
+  const set<RpcFeatureFlag>& required_features = car->call->required_rpc_features();
+  if (!includes(remote_features_.begin(), remote_features_.end(),
+                required_features.begin(), required_features.end())) {
+    *it = outbound_transfers_.erase(*it);
+    Status s = Status::NotSupported("server does not support the required RPC features");
+    transfer->Abort(s);
+    Phase phase = negotiation_complete_ ? Phase::REMOTE_CALL : Phase::CONNECTION_NEGOTIATION;
+    car->call->SetFailed(std::move(s), phase);
+    // Test cancellation when 'call_' is in 'FINISHED_ERROR' state.
+    MaybeInjectCancellation(car->call);
+    car->call.reset();
+    delete transfer;
+    return false;
+  }
+
+  car->call->SetSending();
+
+  // Test cancellation when 'call_' is in 'SENDING' state.
+  MaybeInjectCancellation(car->call);
+  return true;
+}
 
-        car->call->SetSending();
+Connection::ProcessOutboundTransfersResult Connection::ProcessOutboundTransfers() {
+  while (!outbound_transfers_.empty()) {
+    auto it = outbound_transfers_.begin();
+    if (!it->TransferStarted() && !StartOutboundTransfer(&it)) {
+      continue;
+    }
 
-        // Test cancellation when 'call_' is in 'SENDING' state.
-        MaybeInjectCancellation(car->call);
+    // The transfers queued behind the first one are sent with the same write
+    // as long as all of their slices fit, which saves a system call per
+    // transfer when many small calls or responses are queued.
+    const int max_iovecs = std::max<int>(FLAGS_rpc_max_send_iovecs,
+                                         std::min<size_t>(it->NumSlicesLeft(), IOV_MAX));
+    struct iovec iov[max_iovecs];
+    int n_iovecs = it->FillIovecs(iov, max_iovecs);
+    int n_transfers = 1;
+    for (++it; it != outbound_transfers_.end() && n_iovecs < max_iovecs;) {
+      if (it->NumSlicesLeft() > static_cast<size_t>(max_iovecs - n_iovecs)) {
+        break;
+      }
+      if (!it->TransferStarted() && !StartOutboundTransfer(&it)) {
+        continue;
       }
+      n_iovecs += it->FillIovecs(iov + n_iovecs, max_iovecs - n_iovecs);
+      n_transfers++;
+      ++it;
     }
 
     last_activity_time_ = reactor_thread_->cur_time();
-    Status status = transfer->SendBuffer(socket_.get());
+    int64_t written = 0;
+    Status status = socket_->Writev(iov, n_iovecs, &written);
     if (PREDICT_FALSE(!status.ok())) {
-      LOG(WARNING) << Substitute(
-          "$0 send error: $1", ToString(), status.ToString());
-      reactor_thread_->DestroyConnection(this, status);
-      return kConnectionDestroyed;
+      if (!Socket::IsTemporarySocketError(status.posix_code())) {
+        LOG(WARNING) << Substitute(
+            "$0 send error: $1", ToString(), status.ToString());
+        reactor_thread_->DestroyConnection(this, status);
+        return kConnectionDestroyed;
+      }
+      written = 0;
     }
-
-    if (!transfer->TransferFinished()) {
-      DVLOG(3) << Substitute("$0: writeHandler: xfer not finished", ToString());
-      return kMoreToSend;
+    reactor_thread_->RecordTransfersPerWrite(n_transfers);
+
+    // Account for the bytes written across the transfers sent.
+    for (int i = 0; i < n_transfers; i++) {
+      OutboundTransfer* transfer = &outbound_transfers_.front();
+      written = transfer->AdvanceSent(written);
+      if (!transfer->TransferFinished()) {
+        DCHECK_EQ(0, written);
+        DVLOG(3) << Substitute("$0: writeHandler: xfer not finished", ToString());
+        return kMoreToSend;
+      }
+      outbound_transfers_.pop_front();
+      delete transfer;
     }
-
-    outbound_transfers_.pop_front();
-    delete transfer;
+    DCHECK_EQ(0, written);
   }
 
   return kNoMoreToSend;
@@ -763,9 +885,31 @@ void Connection::CompleteNegotiation(Status negotiation_status,
 
 void Connection::MarkNegotiationComplete() {
   DCHECK(reactor_thread_->IsCurrentThread());
+  body_codec_ = ChooseBodyCodec();
   negotiation_complete_ = true;
 }
 
+const CompressionCodec* Connection::ChooseBodyCodec() const {
+  const CompressionType type = GetCompressionCodecType(FLAGS_rpc_compression_codec);
+  if (type == NO_COMPRESSION ||
+      !ContainsKey(remote_features_, RpcFeatureFlag::COMPRESSION) ||
+      !remote_.is_ip() ||
+      (socket_->IsLoopbackConnection() && !FLAGS_rpc_compress_loopback_connections)) {
+    return nullptr;
+  }
+  if (!FLAGS_rpc_compression_subnets.empty()) {
+    vector<Network> subnets;
+    CHECK_OK(Network::ParseCIDRStrings(FLAGS_rpc_compression_subnets, &subnets));
+    if (std::none_of(subnets.begin(), subnets.end(),
+                     [&](const Network& n) { return n.WithinNetwork(remote_); })) {
+      return nullptr;
+    }
+  }
+  const CompressionCodec* codec;
+  CHECK_OK(GetCompressionCodec(type, &codec));
+  return codec;
+}
+
 Status Connection::DumpPB(const DumpConnectionsRequestPB& req,
                           RpcConnectionPB* resp) const {
   DCHECK(reactor_thread_->IsCurrentThread());
@@ -44,6 +44,8 @@
 
 namespace kudu {
 
+class CompressionCodec;
+
 namespace rpc {
 
 class DumpConnectionsRequestPB;
@@ -164,6 +166,16 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // Set/unset the 'confidentiality' property for this connection.
   void set_confidential(bool is_confidential);
 
+  // The codec to compress the bodies of the calls or responses sent over this
+  // connection with, or nullptr if they are sent uncompressed. Chosen once the
+  // negotiation completes, based on whether the remote end supports it and on
+  // --rpc_compression_codec and --rpc_compression_subnets.
+  //
+  // May be called from a non-reactor thread once negotiation is complete.
+  const CompressionCodec* body_codec() const {
+    return body_codec_;
+  }
+
   // Credentials policy to start connection negotiation.
   CredentialsPolicy credentials_policy() const { return credentials_policy_; }
 
@@ -312,10 +324,22 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // This must be called from the reactor thread.
   void QueueOutbound(std::unique_ptr<OutboundTransfer> transfer);
 
+  // Sends the outbound transfers queued on the connection, unless the
+  // connection waits to become writable again to send them anyway.
+  void FlushOutboundTransfers();
+
+  // Prepares the outbound transfer at '*it', not started yet, to be sent. If
+  // it must not be sent after all, aborts and deletes it, advancing '*it' past
+  // it, and returns false.
+  bool StartOutboundTransfer(boost::intrusive::list<OutboundTransfer>::iterator* it);
+
   // Internal test function for injecting cancellation request when 'call'
   // reaches state specified in 'FLAGS_rpc_inject_cancellation_state'.
   void MaybeInjectCancellation(const std::shared_ptr<OutboundCall>& call);
 
+  // Returns the codec to set 'body_codec_' to once the negotiation completes.
+  const CompressionCodec* ChooseBodyCodec() const;
+
   // The reactor thread that created this connection.
   ReactorThread* const reactor_thread_;
 
@@ -400,8 +424,16 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // is considered confidential.
   bool is_confidential_;
 
+  // See body_codec().
+  const CompressionCodec* body_codec_;
+
   // Whether the connection is scheduled for shutdown.
   bool scheduled_for_shutdown_;
+
+  // Whether the reactor thread is to send the outbound transfers queued on the
+  // connection once it ran its current batch of tasks: see
+  // ReactorThread::ScheduleOutboundFlush().
+  bool outbound_flush_pending_;
 };
 
 } // namespace rpc
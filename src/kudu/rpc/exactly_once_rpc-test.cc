@@ -34,6 +34,7 @@
 #include <gtest/gtest.h>
 
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/request_tracker.h"
 #include "kudu/rpc/response_callback.h"
 #include "kudu/rpc/result_tracker.h"
@@ -63,6 +64,7 @@ using std::shared_ptr;
 using std::thread;
 using std::unique_ptr;
 using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace rpc {
@@ -570,6 +572,41 @@ TEST_F(ExactlyOnceRpcTest, TestExactlyOnceSemanticsGarbageCollection) {
   ASSERT_NE(SecureShortDebugString(resp), SecureShortDebugString(original));
 }
 
+// Clients are spread over the shards of the result tracker: each one gets its own cached
+// response back, and forgetting the clients releases all the memory of their state.
+TEST_F(ExactlyOnceRpcTest, TestExactlyOnceSemanticsManyClients) {
+  ASSERT_OK(StartServer());
+  constexpr int kNumClients = 64;
+  vector<ExactlyOnceResponsePB> originals(kNumClients);
+  for (int i = 0; i < kNumClients; i++) {
+    RpcController controller;
+    ExactlyOnceRequestPB req;
+    req.set_value_to_add(1);
+    AddRequestId(&controller, Substitute("$0-$1", kClientId, i), 0, 0);
+    ASSERT_OK(proxy_->AddExactlyOnce(req, &originals[i], &controller));
+    ASSERT_EQ(i + 1, originals[i].current_val());
+  }
+  const int64_t memory_consumption = mem_tracker_->consumption();
+
+  for (int i = 0; i < kNumClients; i++) {
+    RpcController controller;
+    ExactlyOnceRequestPB req;
+    req.set_value_to_add(1);
+    ExactlyOnceResponsePB resp;
+    AddRequestId(&controller, Substitute("$0-$1", kClientId, i), 0, 1);
+    ASSERT_OK(proxy_->AddExactlyOnce(req, &resp, &controller));
+    ASSERT_EQ(SecureShortDebugString(originals[i]), SecureShortDebugString(resp));
+  }
+  ASSERT_EQ(memory_consumption, mem_tracker_->consumption());
+  ASSERT_STR_CONTAINS(result_tracker_->ToString(),
+                      Substitute("Num. Client States: $0", kNumClients));
+
+  FLAGS_remember_clients_ttl_ms = 1;
+  SleepFor(MonoDelta::FromMilliseconds(10));
+  result_tracker_->GCResults();
+  ASSERT_EQ(0, mem_tracker_->consumption());
+}
+
 // This test creates a thread continuously making requests to the server, some lasting longer
 // than the GC period, at the same time it runs GC, making sure that the corresponding
 // CompletionRecords/ClientStates are not deleted from underneath the ongoing requests.
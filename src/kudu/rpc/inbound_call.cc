@@ -36,6 +36,7 @@
 #include "kudu/rpc/serialization.h"
 #include "kudu/rpc/service_if.h"
 #include "kudu/rpc/transfer.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/net/sockaddr.h"
@@ -81,6 +82,11 @@ Status InboundCall::ParseFrom(unique_ptr<InboundTransfer> transfer) {
 
   TRACE_EVENT0("rpc", "InboundCall::ParseFrom");
   RETURN_NOT_OK(serialization::ParseMessage(transfer->data(), &header_, &serialized_request_));
+  if (header_.has_body_compression()) {
+    RETURN_NOT_OK(serialization::UncompressMessage(
+        header_.body_compression(), header_.uncompressed_body_size(),
+        &uncompressed_request_, &serialized_request_));
+  }
 
   // Adopt the service/method info from the header as soon as it's available.
   if (PREDICT_FALSE(!header_.has_remote_method())) {
@@ -142,6 +148,16 @@ void InboundCall::RespondFailure(ErrorStatusPB::RpcErrorCodePB error_code,
   Respond(err, false);
 }
 
+void InboundCall::RespondTooBusy(const Status& status, MonoDelta retry_after) {
+  TRACE_EVENT0("rpc", "InboundCall::RespondTooBusy");
+  ErrorStatusPB err;
+  err.set_message(status.ToString());
+  err.set_code(ErrorStatusPB::ERROR_SERVER_TOO_BUSY);
+  err.set_retry_after_ms(retry_after.ToMilliseconds());
+
+  Respond(err, false);
+}
+
 void InboundCall::RespondApplicationError(int error_ext_id, const std::string& message,
                                           const MessageLite& app_error_pb) {
   ErrorStatusPB err;
@@ -204,6 +220,26 @@ void InboundCall::SerializeResponseBuffer(const MessageLite& response,
 
   serialization::SerializeMessage(response, &response_msg_buf_,
                                   sidecar_byte_size, true);
+
+  const CompressionCodec* codec = conn_->body_codec();
+  if (codec) {
+    TransferPayload sidecar_slices;
+    for (auto& sidecar : outbound_sidecars_) {
+      sidecar->AppendSlices(&sidecar_slices);
+    }
+    uint32_t uncompressed_size;
+    if (serialization::CompressMessage(
+            *codec, response_msg_buf_,
+            vector<Slice>(sidecar_slices.begin(), sidecar_slices.end()),
+            &response_compressed_buf_, &response_compressed_msg_, &uncompressed_size)) {
+      resp_hdr.set_body_compression(codec->type());
+      resp_hdr.set_uncompressed_body_size(uncompressed_size);
+      serialization::SerializeHeader(resp_hdr, response_compressed_msg_.size(),
+                                     &response_hdr_buf_);
+      return;
+    }
+  }
+
   int64_t main_msg_size = sidecar_byte_size + response_msg_buf_.size();
   serialization::SerializeHeader(resp_hdr, main_msg_size,
                                  &response_hdr_buf_);
@@ -214,6 +250,10 @@ void InboundCall::SerializeResponseTo(TransferPayload* slices) const {
   DCHECK_GT(response_hdr_buf_.size(), 0);
   DCHECK_GT(response_msg_buf_.size(), 0);
   slices->push_back(Slice(response_hdr_buf_));
+  if (!response_compressed_msg_.empty()) {
+    slices->push_back(response_compressed_msg_);
+    return;
+  }
   slices->push_back(Slice(response_msg_buf_));
   for (auto& sidecar : outbound_sidecars_) {
     sidecar->AppendSlices(slices);
@@ -298,8 +338,12 @@ void InboundCall::RecordHandlingStarted(Histogram* incoming_queue_time) {
   DCHECK(incoming_queue_time != nullptr);
   DCHECK(!timing_.time_handled.Initialized());  // Protect against multiple calls.
   timing_.time_handled = MonoTime::Now();
-  incoming_queue_time->Increment(
-      (timing_.time_handled - timing_.time_received).ToMicroseconds());
+  const int64_t queue_time_us =
+      (timing_.time_handled - timing_.time_received).ToMicroseconds();
+  incoming_queue_time->Increment(queue_time_us);
+  if (method_info_ && method_info_->queue_time_histogram) {
+    method_info_->queue_time_histogram->Increment(queue_time_us);
+  }
 }
 
 void InboundCall::RecordHandlingCompleted() {
@@ -359,11 +403,12 @@ Status InboundCall::GetInboundSidecar(int idx, Slice* sidecar) const {
 
 void InboundCall::DiscardTransfer() {
   transfer_.reset();
+  delete [] uncompressed_request_.release();
 }
 
 size_t InboundCall::GetTransferSize() {
   if (!transfer_) return 0;
-  return transfer_->data().size();
+  return transfer_->data().size() + uncompressed_request_.size();
 }
 
 } // namespace rpc
@@ -121,6 +121,13 @@ class InboundCall {
   void RespondFailure(ErrorStatusPB::RpcErrorCodePB error_code,
                       const Status &status);
 
+  // Like RespondFailure() with ERROR_SERVER_TOO_BUSY, also hinting the client
+  // to wait for 'retry_after' before retrying the call.
+  //
+  // This method deletes the InboundCall object, so no further calls may be
+  // made after this one.
+  void RespondTooBusy(const Status& status, MonoDelta retry_after);
+
   void RespondUnsupportedFeature(const std::vector<uint32_t>& unsupported_features);
 
   void RespondApplicationError(int error_ext_id, const std::string& message,
@@ -261,10 +268,19 @@ class InboundCall {
   // by 'serialized_request_' above.
   std::unique_ptr<InboundTransfer> transfer_;
 
+  // The uncompressed request, if it was sent compressed, in which case
+  // 'serialized_request_' and the inbound sidecars refer into it instead.
+  faststring uncompressed_request_;
+
   // The buffers for serialized response. Set by SerializeResponseBuffer().
   faststring response_hdr_buf_;
   faststring response_msg_buf_;
 
+  // The response param and the sidecars compressed together, when sent so.
+  // 'response_compressed_msg_' points into 'response_compressed_buf_'.
+  faststring response_compressed_buf_;
+  Slice response_compressed_msg_;
+
   // Vector of additional sidecars that are tacked on to the call's response
   // after serialization of the protobuf. See rpc/rpc_sidecar.h for more info.
   std::vector<std::unique_ptr<RpcSidecar>> outbound_sidecars_;
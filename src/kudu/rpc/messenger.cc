@@ -94,7 +94,8 @@ MessengerBuilder::MessengerBuilder(string name)
       rpc_tls_ciphersuites_(kudu::security::SecurityDefaults::kDefaultTlsCipherSuites),
       rpc_tls_min_protocol_(kudu::security::SecurityDefaults::kDefaultTlsMinVersion),
       enable_inbound_tls_(false),
-      reuseport_(false) {
+      reuseport_(false),
+      num_acceptor_shards_(1) {
 }
 
 Status MessengerBuilder::Build(shared_ptr<Messenger>* msgr) {
@@ -254,10 +255,14 @@ Status Messenger::AddAcceptorPool(const Sockaddr& accept_addr,
                           "GSSAPI/Kerberos not properly configured");
   }
 
+  int num_shards = 1;
+  if (accept_addr.is_ip()) {
+    num_shards = num_acceptor_shards_ == 0 ? reactors_.size() : num_acceptor_shards_;
+  }
   Socket sock;
   RETURN_NOT_OK(sock.Init(accept_addr.family(), 0));
   RETURN_NOT_OK(sock.SetReuseAddr(true));
-  if (reuseport_) {
+  if (reuseport_ || num_shards > 1) {
     RETURN_NOT_OK(sock.SetReusePort(true));
   }
   RETURN_NOT_OK(sock.Bind(accept_addr));
@@ -267,7 +272,7 @@ Status Messenger::AddAcceptorPool(const Sockaddr& accept_addr,
   {
     std::lock_guard<percpu_rwlock> guard(lock_);
     acceptor_pools_.emplace_back(std::make_shared<AcceptorPool>(
-        this, &sock, addr, acceptor_listen_backlog_));
+        this, &sock, addr, acceptor_listen_backlog_, num_shards));
     *pool = acceptor_pools_.back();
 
 #if defined(__linux__)
@@ -366,6 +371,12 @@ void Messenger::RegisterInboundSocket(Socket* new_socket, const Sockaddr& remote
   RemoteToReactor(remote)->RegisterInboundSocket(new_socket, remote);
 }
 
+void Messenger::RegisterInboundSocket(Socket* new_socket, const Sockaddr& remote,
+                                      int reactor_idx) {
+  DCHECK_GE(reactor_idx, 0);
+  reactors_[reactor_idx % reactors_.size()]->RegisterInboundSocket(new_socket, remote);
+}
+
 Messenger::Messenger(const MessengerBuilder& bld)
     : name_(bld.name_),
       state_(kStarted),
@@ -384,6 +395,7 @@ Messenger::Messenger(const MessengerBuilder& bld)
       sasl_proto_name_(bld.sasl_proto_name_),
       keytab_file_(bld.keytab_file_),
       reuseport_(bld.reuseport_),
+      num_acceptor_shards_(bld.num_acceptor_shards_),
       acceptor_listen_backlog_(bld.acceptor_listen_backlog_),
       retain_self_(this) {
   for (int i = 0; i < bld.num_reactors_; i++) {
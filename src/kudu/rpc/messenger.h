@@ -272,6 +272,17 @@ class MessengerBuilder {
     return *this;
   }
 
+  // Set the number of listening sockets of each acceptor pool of the
+  // messenger. If greater than 1, the pools listen on as many sockets bound to
+  // the same address with SO_REUSEPORT, which the kernel balances the incoming
+  // connections across, and the connections accepted on each socket are
+  // handled by a reactor of its own. If 0, the pools listen on a socket per
+  // reactor. Only applies to TCP addresses.
+  MessengerBuilder& set_num_acceptor_shards(int num_acceptor_shards) {
+    num_acceptor_shards_ = num_acceptor_shards;
+    return *this;
+  }
+
   Status Build(std::shared_ptr<Messenger>* msgr);
 
  private:
@@ -301,6 +312,7 @@ class MessengerBuilder {
   std::shared_ptr<JwtVerifier> jwt_verifier_;
   bool enable_inbound_tls_;
   bool reuseport_;
+  int num_acceptor_shards_;
 };
 
 // A Messenger is a container for the reactor threads which run event loops
@@ -379,6 +391,11 @@ class Messenger {
   // Take ownership of the socket via Socket::Release
   void RegisterInboundSocket(Socket* new_socket, const Sockaddr& remote);
 
+  // Same as above, but the connection is handled by the reactor 'reactor_idx'
+  // modulo the number of reactors rather than by the reactor of 'remote'.
+  void RegisterInboundSocket(Socket* new_socket, const Sockaddr& remote,
+                             int reactor_idx);
+
   // Dump info on related TCP connections into the given protobuf.
   Status DumpConnections(const DumpConnectionsRequestPB& req,
                          DumpConnectionsResponsePB* resp);
@@ -576,6 +593,10 @@ class Messenger {
   // Whether to set SO_REUSEPORT on the listening sockets.
   const bool reuseport_;
 
+  // The number of listening sockets of each acceptor pool, or 0 for one per
+  // reactor. See MessengerBuilder::set_num_acceptor_shards().
+  const int num_acceptor_shards_;
+
   // Acceptor's listened socket backlog: the capacity of the queue to
   // accommodate incoming (but not accepted yet) connection requests to the
   // messenger's listening sockets.
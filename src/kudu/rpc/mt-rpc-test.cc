@@ -24,6 +24,7 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -32,6 +33,7 @@
 #include "kudu/rpc/proxy.h"
 #include "kudu/rpc/rpc-test-base.h"
 #include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/rpc_service.h"
 #include "kudu/rpc/rtest.pb.h"
 #include "kudu/rpc/service_if.h"
@@ -50,6 +52,10 @@ METRIC_DECLARE_counter(queue_overflow_rejections_kudu_rpc_test_CalculatorService
 METRIC_DECLARE_counter(queue_overflow_rejections_kudu_rpc_test_CalculatorService_Sleep);
 METRIC_DECLARE_counter(rpc_connections_accepted);
 METRIC_DECLARE_counter(rpcs_queue_overflow);
+METRIC_DECLARE_counter(rpcs_shed);
+
+DECLARE_int32(rpc_service_queue_codel_interval_ms);
+DECLARE_int32(rpc_service_queue_codel_target_ms);
 
 using std::string;
 using std::shared_ptr;
@@ -340,6 +346,83 @@ TEST_F(MultiThreadedRpcTest, PerMethodQueueOverflowRejectionCounter) {
   ASSERT_EQ(queue_overflow_num, queue_overflow_rejections_sleep->value());
 }
 
+// Once calls wait in the service queue longer than the target of the admission
+// control, the service sheds them with a hint to retry later rather than let
+// them time out in the queue.
+TEST_F(MultiThreadedRpcTest, TestAdmissionControlShedsLoad) {
+  FLAGS_rpc_service_queue_codel_target_ms = 10;
+  FLAGS_rpc_service_queue_codel_interval_ms = 50;
+  n_server_reactor_threads_ = 1;
+  n_worker_threads_ = 1;
+  service_queue_length_ = 100;
+
+  Sockaddr server_addr;
+  ASSERT_OK(StartTestServerWithGeneratedCode(&server_addr, false /*enable_ssl*/));
+  auto* rpcs_shed = METRIC_rpcs_shed.Instantiate(server_messenger_->metric_entity()).get();
+
+  // With a single worker thread, 16 concurrent requests taking 20ms each
+  // build a standing queue of a few hundred milliseconds.
+  constexpr size_t kNumThreads = 16;
+  constexpr int kNumCallsPerThread = 5;
+  vector<thread> threads;
+  threads.reserve(kNumThreads);
+  vector<int> num_shed(kNumThreads, 0);
+  vector<Status> status(kNumThreads);
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    const size_t idx = i;
+    threads.emplace_back([&, idx]() {
+      shared_ptr<Messenger> client_messenger;
+      CHECK_OK(CreateMessenger("ClientMessenger", &client_messenger));
+      Proxy p(client_messenger, server_addr, server_addr.host(),
+              CalculatorService::static_service_name());
+      for (int c = 0; c < kNumCallsPerThread; c++) {
+        SleepRequestPB req;
+        req.set_sleep_micros(20 * 1000);
+        SleepResponsePB resp;
+        RpcController controller;
+        controller.set_timeout(MonoDelta::FromSeconds(30));
+        Status s = p.SyncRequest(
+            GenericCalculatorService::kSleepMethodName, req, &resp, &controller);
+        if (s.ok()) {
+          continue;
+        }
+        const ErrorStatusPB* err = controller.error_response();
+        if (!err || err->code() != ErrorStatusPB::ERROR_SERVER_TOO_BUSY ||
+            err->retry_after_ms() != FLAGS_rpc_service_queue_codel_interval_ms) {
+          status[idx] = s;
+          return;
+        }
+        num_shed[idx]++;
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  int total_shed = 0;
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    ASSERT_OK(status[i]);
+    total_shed += num_shed[i];
+  }
+  ASSERT_GT(total_shed, 0);
+  ASSERT_EQ(total_shed, rpcs_shed->value());
+
+  // Once the queue drained, calls are admitted again.
+  SleepMicros(2 * FLAGS_rpc_service_queue_codel_interval_ms * 1000);
+  shared_ptr<Messenger> client_messenger;
+  ASSERT_OK(CreateMessenger("ClientMessenger", &client_messenger));
+  Proxy p(client_messenger, server_addr, server_addr.host(),
+          CalculatorService::static_service_name());
+  for (int i = 0; i < 3; i++) {
+    SleepRequestPB req;
+    req.set_sleep_micros(1000);
+    SleepResponsePB resp;
+    RpcController controller;
+    ASSERT_OK(p.SyncRequest(GenericCalculatorService::kSleepMethodName, req, &resp, &controller));
+  }
+}
+
 static void HammerServerWithTCPConns(const Sockaddr& addr) {
   while (true) {
     Socket socket;
@@ -47,6 +47,7 @@
 #include "kudu/util/errno.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/socket.h"
 #include "kudu/util/slice.h"
@@ -78,6 +79,35 @@ DEFINE_bool(rpc_suppress_negotiation_trace, false,
             "For testing only!");
 TAG_FLAG(rpc_suppress_negotiation_trace, unsafe);
 
+METRIC_DEFINE_histogram(server, rpc_client_negotiation_time,
+                        "Outbound Connection Negotiation Time",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Histogram of the time to negotiate the outbound RPC "
+                        "connections of the server, including their TLS handshake "
+                        "and authentication, successful or not.",
+                        kudu::MetricLevel::kInfo,
+                        60000000LU, 2);
+METRIC_DEFINE_histogram(server, rpc_server_negotiation_time,
+                        "Inbound Connection Negotiation Time",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Histogram of the time to negotiate the inbound RPC "
+                        "connections of the server, including their TLS handshake "
+                        "and authentication, successful or not.",
+                        kudu::MetricLevel::kInfo,
+                        60000000LU, 2);
+METRIC_DEFINE_counter(server, rpc_client_tls_sessions_resumed,
+                      "Outbound Connection TLS Sessions Resumed",
+                      kudu::MetricUnit::kConnections,
+                      "Number of outbound RPC connections whose TLS handshake resumed "
+                      "a previous TLS session. See --rpc_tls_session_resumption.",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, rpc_server_tls_sessions_resumed,
+                      "Inbound Connection TLS Sessions Resumed",
+                      kudu::MetricUnit::kConnections,
+                      "Number of inbound RPC connections whose TLS handshake resumed "
+                      "a previous TLS session.",
+                      kudu::MetricLevel::kDebug);
+
 using kudu::security::RpcAuthentication;
 using kudu::security::RpcEncryption;
 using std::string;
@@ -236,6 +266,9 @@ static Status DoClientNegotiation(Connection* conn,
   conn->set_remote_features(client_negotiation.take_server_features());
   conn->set_confidential(client_negotiation.tls_negotiated() ||
       (conn->socket()->IsLoopbackConnection() && !FLAGS_rpc_encrypt_loopback_connections));
+  if (client_negotiation.tls_session_reused() && messenger->metric_entity()) {
+    METRIC_rpc_client_tls_sessions_resumed.Instantiate(messenger->metric_entity())->Increment();
+  }
 
   // Sanity check: if no authn token was supplied as user credentials,
   // the negotiated authentication type cannot be AuthenticationType::TOKEN.
@@ -299,6 +332,9 @@ static Status DoServerNegotiation(Connection* conn,
   conn->set_remote_user(server_negotiation.take_authenticated_user());
   conn->set_confidential(server_negotiation.tls_negotiated() ||
       (conn->socket()->IsLoopbackConnection() && !FLAGS_rpc_encrypt_loopback_connections));
+  if (server_negotiation.tls_session_reused() && messenger->metric_entity()) {
+    METRIC_rpc_server_tls_sessions_resumed.Instantiate(messenger->metric_entity())->Increment();
+  }
 
   return Status::OK();
 }
@@ -311,12 +347,20 @@ void Negotiation::RunNegotiation(const scoped_refptr<Connection>& conn,
   Status s;
   unique_ptr<ErrorStatusPB> rpc_error;
   bool encrypt_loopback = FLAGS_rpc_encrypt_loopback_connections || loopback_encryption;
+  const MonoTime start = MonoTime::Now();
   if (conn->direction() == Connection::SERVER) {
     s = DoServerNegotiation(conn.get(), authentication, encryption, encrypt_loopback, deadline);
   } else {
     s = DoClientNegotiation(conn.get(), authentication, encryption, encrypt_loopback, deadline,
                             &rpc_error);
   }
+  const auto metric_entity = conn->reactor_thread()->reactor()->messenger()->metric_entity();
+  if (metric_entity) {
+    auto& prototype = conn->direction() == Connection::SERVER
+        ? METRIC_rpc_server_negotiation_time : METRIC_rpc_client_negotiation_time;
+    prototype.Instantiate(metric_entity)->Increment(
+        (MonoTime::Now() - start).ToMicroseconds());
+  }
 
   if (PREDICT_FALSE(!s.ok())) {
     string msg = Substitute("$0 connection negotiation failed: $1",
@@ -43,6 +43,7 @@
 #include "kudu/rpc/rpc_sidecar.h"
 #include "kudu/rpc/serialization.h"
 #include "kudu/rpc/transfer.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/kernel_stack_watchdog.h"
 #include "kudu/util/net/sockaddr.h"
@@ -139,16 +140,34 @@ void OutboundCall::SerializeTo(TransferPayload* slices) {
   }
 
   DCHECK_LE(0, payload_->sidecar_byte_size_);
-  serialization::SerializeHeader(
-      payload_->header_, payload_->sidecar_byte_size_ + payload_->request_buf_.size(),
-      &payload_->header_buf_);
-
   slices->clear();
-  slices->push_back(payload_->header_buf_);
-  slices->push_back(payload_->request_buf_);
   for (auto& sidecar : payload_->sidecars_) {
     sidecar->AppendSlices(slices);
   }
+
+  // The payload may be serialized again for a retry over another connection,
+  // so make sure not to keep the compression settings of a previous attempt.
+  payload_->header_.clear_body_compression();
+  payload_->header_.clear_uncompressed_body_size();
+  uint32_t uncompressed_size;
+  if (codec && serialization::CompressMessage(
+          *codec, payload_->request_buf_, vector<Slice>(slices->begin(), slices->end()),
+          &payload_->compressed_buf_, &payload_->compressed_msg_, &uncompressed_size)) {
+    payload_->header_.set_body_compression(codec->type());
+    payload_->header_.set_uncompressed_body_size(uncompressed_size);
+    serialization::SerializeHeader(
+        payload_->header_, payload_->compressed_msg_.size(), &payload_->header_buf_);
+    slices->clear();
+    slices->push_back(payload_->header_buf_);
+    slices->push_back(payload_->compressed_msg_);
+    return;
+  }
+
+  serialization::SerializeHeader(
+      payload_->header_, payload_->sidecar_byte_size_ + payload_->request_buf_.size(),
+      &payload_->header_buf_);
+  slices->insert(slices->begin(), { Slice(payload_->header_buf_),
+                                    Slice(payload_->request_buf_) });
 }
 
 RequestPayload::RequestPayload(const RemoteMethod& remote_method) {
@@ -373,6 +392,7 @@ void OutboundCall::SetSent() {
   // which allocated it -- this lets it keep to thread-local operations instead
   // of taking a mutex to put memory back on the global freelist.
   delete [] payload_->header_buf_.release();
+  delete [] payload_->compressed_buf_.release();
 
   // payload_ is also done being used here, but since it was allocated by
   // the caller thread, we would rather let that thread free it whenever it
@@ -551,6 +571,11 @@ Status CallResponse::ParseFrom(unique_ptr<InboundTransfer> transfer) {
   CHECK(!parsed_);
   RETURN_NOT_OK(serialization::ParseMessage(transfer->data(), &header_,
                                             &serialized_response_));
+  if (header_.has_body_compression()) {
+    RETURN_NOT_OK(serialization::UncompressMessage(
+        header_.body_compression(), header_.uncompressed_body_size(),
+        &uncompressed_response_, &serialized_response_));
+  }
 
   // Use information from header to extract the payload slices.
   RETURN_NOT_OK(RpcSidecar::ParseSidecars(header_.sidecar_offsets(),
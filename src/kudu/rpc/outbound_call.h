@@ -50,6 +50,9 @@ class Message;
 } // namespace google
 
 namespace kudu {
+
+class CompressionCodec;
+
 namespace rpc {
 
 class CallResponse;
@@ -89,6 +92,11 @@ class RequestPayload {
   faststring request_buf_;
   std::vector<std::unique_ptr<RpcSidecar>> sidecars_;
 
+  // The request param and the sidecars compressed together, when sent so.
+  // 'compressed_msg_' points into 'compressed_buf_'.
+  faststring compressed_buf_;
+  Slice compressed_msg_;
+
   // Total size in bytes of all sidecars in 'sidecars_'. Set in SetRequestPayload().
   // This cannot exceed TransferLimits::kMaxTotalSidecarBytes.
   int32_t sidecar_byte_size_ = -1;
@@ -154,7 +162,10 @@ class OutboundCall {
 
   // Serialize the call for the wire. Requires that SetRequestPayload()
   // is called first. This is called from the Reactor thread.
-  void SerializeTo(TransferPayload* slices);
+  //
+  // If 'codec' isn't nullptr, the request param and the sidecars are sent
+  // compressed with it if they are large enough to be worth it.
+  void SerializeTo(TransferPayload* slices, const CompressionCodec* codec = nullptr);
 
   // Mark in the call that cancellation has been requested. If the call hasn't yet
   // started sending or has finished sending the RPC request but is waiting for a
@@ -384,6 +395,10 @@ class CallResponse {
   // and sidecar_slices_ refer into its data.
   std::unique_ptr<InboundTransfer> transfer_;
 
+  // The uncompressed response, if it was sent compressed, in which case
+  // serialized_response_ and sidecar_slices_ refer into it instead.
+  faststring uncompressed_response_;
+
   DISALLOW_COPY_AND_ASSIGN(CallResponse);
 };
 
@@ -443,6 +443,15 @@ class CodeGenerator : public ::google::protobuf::compiler::CodeGenerator {
             "    kudu::MetricLevel::kInfo,\n"
             "    60000000LU, 2);\n"
             "\n");
+        Print(printer, *subs,
+            "METRIC_DEFINE_histogram(server,\n"
+            "    queue_time_$rpc_full_name_plainchars$,\n"
+            "    \"$rpc_full_name$ RPC Queue Time\",\n"
+            "    kudu::MetricUnit::kMicroseconds,\n"
+            "    \"Microseconds $rpc_full_name$ RPC requests spend in the service queue\",\n"
+            "    kudu::MetricLevel::kDebug,\n"
+            "    60000000LU, 2);\n"
+            "\n");
         Print(printer, *subs,
             "METRIC_DEFINE_counter(server,\n"
             "    queue_overflow_rejections_$rpc_full_name_plainchars$,\n"
@@ -513,6 +522,8 @@ class CodeGenerator : public ::google::protobuf::compiler::CodeGenerator {
             "    mi->track_result = $track_result$;\n"
             "    mi->handler_latency_histogram =\n"
             "        METRIC_handler_latency_$rpc_full_name_plainchars$.Instantiate(entity);\n"
+            "    mi->queue_time_histogram =\n"
+            "        METRIC_queue_time_$rpc_full_name_plainchars$.Instantiate(entity);\n"
             "    mi->queue_overflow_rejections =\n"
             "        METRIC_queue_overflow_rejections_$rpc_full_name_plainchars$.Instantiate("
             "entity);\n"
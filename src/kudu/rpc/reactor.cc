@@ -52,6 +52,7 @@
 #include "kudu/util/debug/sanitizer_scopes.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flags.h"
+#include "kudu/util/logging.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/sockaddr.h"
@@ -104,6 +105,18 @@ TAG_FLAG(tcp_keepalive_probe_period_s, advanced);
 TAG_FLAG(tcp_keepalive_retry_period_s, advanced);
 TAG_FLAG(tcp_keepalive_retry_count, advanced);
 
+DEFINE_int32(rpc_socket_busy_poll_us, 0,
+             "If positive, the number of microseconds reads from the sockets of "
+             "TCP connections busy poll the receive queue of the network device "
+             "for new packets (SO_BUSY_POLL) rather than wait for an interrupt. "
+             "This trades CPU for lower latency of the RPCs between the servers "
+             "of a cluster on a fast network. Values above the net.core.busy_read "
+             "sysctl require CAP_NET_ADMIN.");
+TAG_FLAG(rpc_socket_busy_poll_us, advanced);
+TAG_FLAG(rpc_socket_busy_poll_us, experimental);
+DEFINE_validator(rpc_socket_busy_poll_us,
+                 [](const char* /* flagname */, int32_t value) { return value >= 0; });
+
 METRIC_DEFINE_histogram(server, reactor_load_percent,
                         "Reactor Thread Load Percentage",
                         kudu::MetricUnit::kUnits,
@@ -124,6 +137,26 @@ METRIC_DEFINE_histogram(server, reactor_active_latency_us,
                         kudu::MetricLevel::kInfo,
                         1000000, 2);
 
+METRIC_DEFINE_histogram(server, reactor_outbound_transfers_per_write,
+                        "Outbound Transfers per Write",
+                        kudu::MetricUnit::kUnits,
+                        "Histogram of the number of outbound RPC calls or responses "
+                        "sent with a single write to the socket of a connection. "
+                        "See --rpc_max_send_iovecs.",
+                        kudu::MetricLevel::kDebug,
+                        1024, 2);
+
+METRIC_DEFINE_histogram(server, reactor_inbound_connection_queue_time,
+                        "Inbound Connection Queue Time",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Histogram of the time from accepting inbound connections "
+                        "until reactor threads register them and start their "
+                        "negotiation. Outliers mean that reactor threads are too busy "
+                        "to keep up with bursts of new connections: sharding the "
+                        "acceptors with --rpc_num_acceptor_shards_per_address may help.",
+                        kudu::MetricLevel::kInfo,
+                        60000000LU, 2);
+
 namespace kudu {
 namespace rpc {
 
@@ -154,6 +187,7 @@ void DoInitLibEv() {
 
 ReactorThread::ReactorThread(Reactor* reactor, const MessengerBuilder& bld)
   : loop_(kDefaultLibEvFlags),
+    defer_outbound_flushes_(false),
     cur_time_(MonoTime::Now()),
     last_unused_tcp_scan_(cur_time_),
     reactor_(reactor),
@@ -168,6 +202,10 @@ ReactorThread::ReactorThread(Reactor* reactor, const MessengerBuilder& bld)
         METRIC_reactor_active_latency_us.Instantiate(bld.metric_entity_);
     load_percent_histogram_ =
         METRIC_reactor_load_percent.Instantiate(bld.metric_entity_);
+    inbound_conn_queue_time_histogram_ =
+        METRIC_reactor_inbound_connection_queue_time.Instantiate(bld.metric_entity_);
+    transfers_per_write_histogram_ =
+        METRIC_reactor_outbound_transfers_per_write.Instantiate(bld.metric_entity_);
   }
 }
 
@@ -343,11 +381,19 @@ void ReactorThread::AsyncHandler(ev::async& /*watcher*/, int /*revents*/) {
   boost::intrusive::list<ReactorTask> tasks;
   reactor_->DrainTaskQueue(&tasks);
 
+  // Only a batch of several tasks may queue several transfers on a connection.
+  defer_outbound_flushes_ = tasks.size() > 1;
   while (!tasks.empty()) {
     ReactorTask& task = tasks.front();
     tasks.pop_front();
     task.Run(this);
   }
+  defer_outbound_flushes_ = false;
+
+  for (auto& conn : connections_to_flush_) {
+    conn->FlushOutboundTransfers();
+  }
+  connections_to_flush_.clear();
 }
 
 void ReactorThread::RegisterConnection(scoped_refptr<Connection> conn) {
@@ -669,6 +715,15 @@ void ReactorThread::CompleteConnectionNegotiation(
     }
   }
 
+  if (conn->remote().is_ip() && FLAGS_rpc_socket_busy_poll_us > 0) {
+    // Not being able to busy poll only costs latency: keep the connection.
+    Status busy_poll_status = conn->socket()->SetBusyPoll(FLAGS_rpc_socket_busy_poll_us);
+    if (PREDICT_FALSE(!busy_poll_status.ok())) {
+      KLOG_EVERY_N_SECS(WARNING, 60) << "Unable to set busy polling for connection: "
+                                     << busy_poll_status.ToString() << THROTTLE_MSG;
+    }
+  }
+
   conn->MarkNegotiationComplete();
   conn->EpollRegister(loop_);
 }
@@ -869,10 +924,15 @@ Status Reactor::DumpConnections(const DumpConnectionsRequestPB& req,
 class RegisterConnectionTask : public ReactorTask {
  public:
   explicit RegisterConnectionTask(scoped_refptr<Connection> conn)
-      : conn_(std::move(conn)) {
+      : conn_(std::move(conn)),
+        accepted_at_(MonoTime::Now()) {
   }
 
   void Run(ReactorThread* reactor) override {
+    if (reactor->inbound_conn_queue_time_histogram_) {
+      reactor->inbound_conn_queue_time_histogram_->Increment(
+          (MonoTime::Now() - accepted_at_).ToMicroseconds());
+    }
     reactor->RegisterConnection(std::move(conn_));
     delete this;
   }
@@ -886,6 +946,7 @@ class RegisterConnectionTask : public ReactorTask {
 
  private:
   const scoped_refptr<Connection> conn_;
+  const MonoTime accepted_at_;
 };
 
 void Reactor::RegisterInboundSocket(Socket* socket, const Sockaddr& remote) {
@@ -22,10 +22,12 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/list_hook.hpp>
 #include <ev++.h>
+#include <glog/logging.h>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -177,6 +179,27 @@ class ReactorThread {
 
   MonoTime cur_time() const;
 
+  // If the reactor thread is running a batch of tasks, schedules sending the
+  // outbound transfers of 'conn' once the batch ran, so that the transfers
+  // the tasks queue on a connection are coalesced, and returns true.
+  // Otherwise returns false.
+  bool ScheduleOutboundFlush(Connection* conn) {
+    DCHECK(IsCurrentThread());
+    if (!defer_outbound_flushes_) {
+      return false;
+    }
+    connections_to_flush_.emplace_back(conn);
+    return true;
+  }
+
+  // Records the number of outbound transfers a connection sent with a
+  // single write.
+  void RecordTransfersPerWrite(int num_transfers) {
+    if (transfers_per_write_histogram_) {
+      transfers_per_write_histogram_->Increment(num_transfers);
+    }
+  }
+
   // This may be called from another thread.
   Reactor* reactor();
 
@@ -290,6 +313,15 @@ class ReactorThread {
   // Abort members, provided it was allocated on the heap.
   boost::intrusive::list<DelayedTask> scheduled_tasks_;
 
+  // Whether the reactor thread runs a batch of tasks, during which the
+  // connections defer sending their outbound transfers to the end of the
+  // batch.
+  bool defer_outbound_flushes_;
+
+  // The connections to send the outbound transfers of once the current batch
+  // of tasks ran.
+  std::vector<scoped_refptr<Connection>> connections_to_flush_;
+
   // The current monotonic time.  Updated every coarse_timer_granularity_secs_.
   MonoTime cur_time_;
 
@@ -313,6 +345,8 @@ class ReactorThread {
   // Metrics.
   scoped_refptr<Histogram> invoke_us_histogram_;
   scoped_refptr<Histogram> load_percent_histogram_;
+  scoped_refptr<Histogram> inbound_conn_queue_time_histogram_;
+  scoped_refptr<Histogram> transfers_per_write_histogram_;
 
   // Total number of client connections opened during Reactor's lifetime.
   uint64_t total_client_conns_cnt_;
@@ -25,8 +25,11 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/gutil/bits.h"
+#include "kudu/gutil/hash/string_hash.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/rpc/inbound_call.h"
 #include "kudu/rpc/remote_method.h"
 #include "kudu/rpc/rpc_context.h"
@@ -103,11 +106,18 @@ struct ScopedMemTrackerUpdater {
   bool cancelled;
 };
 
+// The maximum number of shards of the client states.
+static constexpr int kMaxShards = 64;
+
 ResultTracker::ResultTracker(shared_ptr<MemTracker> mem_tracker)
     : mem_tracker_(std::move(mem_tracker)),
-      clients_(ClientStateMap::key_compare(),
-               ClientStateMapAllocator(mem_tracker_)),
-      gc_thread_stop_latch_(1) {}
+      gc_thread_stop_latch_(1) {
+  const int num_shards = 1 << Bits::Log2Ceiling(std::min(base::NumCPUs(), kMaxShards));
+  shards_.reserve(num_shards);
+  for (int i = 0; i < num_shards; i++) {
+    shards_.emplace_back(new Shard(mem_tracker_));
+  }
+}
 
 ResultTracker::~ResultTracker() {
   if (gc_thread_) {
@@ -115,27 +125,36 @@ ResultTracker::~ResultTracker() {
     gc_thread_->Join();
   }
 
-  lock_guard<simple_spinlock> l(lock_);
   // Release all the memory for the stuff we'll delete on destruction.
-  for (auto& client_state : clients_) {
-    client_state.second->GCCompletionRecords(
-        mem_tracker_, [] (SequenceNumber, CompletionRecord*){ return true; });
-    mem_tracker_->Release(client_state.second->memory_footprint());
+  for (auto& shard : shards_) {
+    lock_guard<simple_spinlock> l(shard->lock);
+    for (auto& client_state : shard->clients) {
+      client_state.second->GCCompletionRecords(
+          mem_tracker_, [] (SequenceNumber, CompletionRecord*){ return true; });
+      mem_tracker_->Release(client_state.second->memory_footprint());
+    }
   }
 }
 
+ResultTracker::Shard* ResultTracker::ShardFor(const string& client_id) const {
+  const size_t hash = HashStringThoroughly(client_id.data(), client_id.size());
+  return shards_[hash & (shards_.size() - 1)].get();
+}
+
 ResultTracker::RpcState ResultTracker::TrackRpc(const RequestIdPB& request_id,
                                                 Message* response,
                                                 RpcContext* context) {
-  lock_guard<simple_spinlock> l(lock_);
-  return TrackRpcUnlocked(request_id, response, context);
+  Shard* shard = ShardFor(request_id.client_id());
+  lock_guard<simple_spinlock> l(shard->lock);
+  return TrackRpcUnlocked(shard, request_id, response, context);
 }
 
-ResultTracker::RpcState ResultTracker::TrackRpcUnlocked(const RequestIdPB& request_id,
+ResultTracker::RpcState ResultTracker::TrackRpcUnlocked(Shard* shard,
+                                                        const RequestIdPB& request_id,
                                                         Message* response,
                                                         RpcContext* context) {
   ClientState* client_state = ComputeIfAbsent(
-      &clients_,
+      &shard->clients,
       request_id.client_id(),
       [&]{
         unique_ptr<ClientState> client_state(new ClientState(mem_tracker_));
@@ -198,7 +217,9 @@ ResultTracker::RpcState ResultTracker::TrackRpcUnlocked(const RequestIdPB& reque
       // non-null) copy the response and reply immediately. If there is no context/response
       // do nothing.
       if (context != nullptr) {
-        DCHECK_NOTNULL(response)->CopyFrom(*completion_record->response);
+        CHECK(DCHECK_NOTNULL(response)->ParsePartialFromString(completion_record->response_data))
+            << "unable to parse the cached response of request "
+            << SecureShortDebugString(request_id);
         context->call_->RespondSuccess(*response);
         delete context;
       }
@@ -222,12 +243,13 @@ ResultTracker::RpcState ResultTracker::TrackRpcUnlocked(const RequestIdPB& reque
 }
 
 ResultTracker::RpcState ResultTracker::TrackRpcOrChangeDriver(const RequestIdPB& request_id) {
-  lock_guard<simple_spinlock> l(lock_);
-  RpcState state = TrackRpcUnlocked(request_id, nullptr, nullptr);
+  Shard* shard = ShardFor(request_id.client_id());
+  lock_guard<simple_spinlock> l(shard->lock);
+  RpcState state = TrackRpcUnlocked(shard, request_id, nullptr, nullptr);
 
   if (state != RpcState::IN_PROGRESS) return state;
 
-  CompletionRecord* completion_record = FindCompletionRecordOrDieUnlocked(request_id);
+  CompletionRecord* completion_record = FindCompletionRecordOrDieUnlocked(shard, request_id);
   ScopedMemTrackerUpdater<CompletionRecord> updater(mem_tracker_.get(), completion_record);
 
   // ... if we did find a CompletionRecord change the driver and return true.
@@ -242,8 +264,9 @@ ResultTracker::RpcState ResultTracker::TrackRpcOrChangeDriver(const RequestIdPB&
 }
 
 bool ResultTracker::IsCurrentDriver(const RequestIdPB& request_id) {
-  lock_guard<simple_spinlock> l(lock_);
-  CompletionRecord* completion_record = FindCompletionRecordOrNullUnlocked(request_id);
+  Shard* shard = ShardFor(request_id.client_id());
+  lock_guard<simple_spinlock> l(shard->lock);
+  CompletionRecord* completion_record = FindCompletionRecordOrNullUnlocked(shard, request_id);
 
   // If we couldn't find the CompletionRecord, someone might have called FailAndRespond() so
   // just return false.
@@ -288,14 +311,16 @@ void ResultTracker::LogAndTraceFailure(RpcContext* context,
 }
 
 ResultTracker::CompletionRecord* ResultTracker::FindCompletionRecordOrDieUnlocked(
-    const RequestIdPB& request_id) {
-  ClientState* client_state = DCHECK_NOTNULL(FindPointeeOrNull(clients_, request_id.client_id()));
+    Shard* shard, const RequestIdPB& request_id) {
+  ClientState* client_state = DCHECK_NOTNULL(FindPointeeOrNull(shard->clients,
+                                                               request_id.client_id()));
   return DCHECK_NOTNULL(FindPointeeOrNull(client_state->completion_records, request_id.seq_no()));
 }
 
 pair<ResultTracker::ClientState*, ResultTracker::CompletionRecord*>
-ResultTracker::FindClientStateAndCompletionRecordOrNullUnlocked(const RequestIdPB& request_id) {
-  ClientState* client_state = FindPointeeOrNull(clients_, request_id.client_id());
+ResultTracker::FindClientStateAndCompletionRecordOrNullUnlocked(Shard* shard,
+                                                               const RequestIdPB& request_id) {
+  ClientState* client_state = FindPointeeOrNull(shard->clients, request_id.client_id());
   CompletionRecord* completion_record = nullptr;
   if (client_state != nullptr) {
     completion_record = FindPointeeOrNull(client_state->completion_records, request_id.seq_no());
@@ -304,26 +329,30 @@ ResultTracker::FindClientStateAndCompletionRecordOrNullUnlocked(const RequestIdP
 }
 
 ResultTracker::CompletionRecord*
-ResultTracker::FindCompletionRecordOrNullUnlocked(const RequestIdPB& request_id) {
-  return FindClientStateAndCompletionRecordOrNullUnlocked(request_id).second;
+ResultTracker::FindCompletionRecordOrNullUnlocked(Shard* shard, const RequestIdPB& request_id) {
+  return FindClientStateAndCompletionRecordOrNullUnlocked(shard, request_id).second;
 }
 
 void ResultTracker::RecordCompletionAndRespond(const RequestIdPB& request_id,
                                                const Message* response) {
   vector<OnGoingRpcInfo> to_respond;
+  // Serialize the response to cache before taking the lock.
+  string response_data;
+  CHECK(DCHECK_NOTNULL(response)->SerializePartialToString(&response_data));
   {
-    lock_guard<simple_spinlock> l(lock_);
+    Shard* shard = ShardFor(request_id.client_id());
+    lock_guard<simple_spinlock> l(shard->lock);
 
-    CompletionRecord* completion_record = FindCompletionRecordOrDieUnlocked(request_id);
+    CompletionRecord* completion_record = FindCompletionRecordOrDieUnlocked(shard, request_id);
     ScopedMemTrackerUpdater<CompletionRecord> updater(mem_tracker_.get(), completion_record);
 
     CHECK_EQ(completion_record->driver_attempt_no, request_id.attempt_no())
         << "Called RecordCompletionAndRespond() from an executor identified with an "
         << "attempt number that was not marked as the driver for the RPC. RequestId: "
-        << SecureShortDebugString(request_id) << "\nTracker state:\n " << ToStringUnlocked();
+        << SecureShortDebugString(request_id) << "\nTracker state:\n "
+        << ToStringUnlocked(*shard);
     DCHECK_EQ(completion_record->state, RpcState::IN_PROGRESS);
-    completion_record->response.reset(DCHECK_NOTNULL(response)->New());
-    completion_record->response->CopyFrom(*response);
+    completion_record->response_data = std::move(response_data);
     completion_record->state = RpcState::COMPLETED;
     completion_record->last_updated = MonoTime::Now();
 
@@ -347,6 +376,10 @@ void ResultTracker::RecordCompletionAndRespond(const RequestIdPB& request_id,
         ++orpc_iter;
       }
     }
+    // Only the cached response is left once the ongoing RPCs are answered.
+    if (completion_record->ongoing_rpcs.empty()) {
+      vector<OnGoingRpcInfo>().swap(completion_record->ongoing_rpcs);
+    }
   }
 
   // Respond outside of holding the lock. This reduces lock contention and also
@@ -364,11 +397,12 @@ void ResultTracker::FailAndRespondInternal(const RequestIdPB& request_id,
                                            const HandleOngoingRpcFunc& func) {
   vector<OnGoingRpcInfo> to_handle;
   {
-    lock_guard<simple_spinlock> l(lock_);
-    auto state_and_record = FindClientStateAndCompletionRecordOrNullUnlocked(request_id);
+    Shard* shard = ShardFor(request_id.client_id());
+    lock_guard<simple_spinlock> l(shard->lock);
+    auto state_and_record = FindClientStateAndCompletionRecordOrNullUnlocked(shard, request_id);
     if (PREDICT_FALSE(state_and_record.first == nullptr)) {
       LOG(FATAL) << "Couldn't find ClientState for request: " << SecureShortDebugString(request_id)
-                 << ". \nTracker state:\n" << ToStringUnlocked();
+                 << ". \nTracker state:\n" << ToStringUnlocked(*shard);
     }
 
     CompletionRecord* completion_record = state_and_record.second;
@@ -471,7 +505,6 @@ void ResultTracker::RunGCThread() {
 }
 
 void ResultTracker::GCResults() {
-  lock_guard<simple_spinlock> l(lock_);
   MonoTime now = MonoTime::Now();
   // Calculate the instants before which we'll start GCing ClientStates and CompletionRecords.
   const auto time_to_gc_clients_from = now -
@@ -482,50 +515,64 @@ void ResultTracker::GCResults() {
   // Now go through the ClientStates. If we haven't heard from a client in a while
   // GC it and all its completion records (making sure there isn't actually one in progress first).
   // If we've heard from a client recently, but some of its responses are old, GC those responses.
-  for (auto iter = clients_.begin(); iter != clients_.end();) {
-    auto& client_state = iter->second;
-    if (client_state->last_heard_from < time_to_gc_clients_from) {
-      // Client should be GCed.
-      bool ongoing_request = false;
-      client_state->GCCompletionRecords(
-          mem_tracker_,
-          [&] (SequenceNumber, CompletionRecord* completion_record) {
-            if (PREDICT_FALSE(completion_record->state == RpcState::IN_PROGRESS)) {
-              ongoing_request = true;
-              return false;
-            }
-            return true;
-          });
-      // Don't delete the client state if there is still a request in execution.
-      if (PREDICT_FALSE(ongoing_request)) {
+  // The shards are GCed one at a time, so that GC only blocks the clients of one shard at once.
+  for (auto& shard : shards_) {
+    lock_guard<simple_spinlock> l(shard->lock);
+    ClientStateMap& clients = shard->clients;
+    for (auto iter = clients.begin(); iter != clients.end();) {
+      auto& client_state = iter->second;
+      if (client_state->last_heard_from < time_to_gc_clients_from) {
+        // Client should be GCed.
+        bool ongoing_request = false;
+        client_state->GCCompletionRecords(
+            mem_tracker_,
+            [&] (SequenceNumber, CompletionRecord* completion_record) {
+              if (PREDICT_FALSE(completion_record->state == RpcState::IN_PROGRESS)) {
+                ongoing_request = true;
+                return false;
+              }
+              return true;
+            });
+        // Don't delete the client state if there is still a request in execution.
+        if (PREDICT_FALSE(ongoing_request)) {
+          ++iter;
+          continue;
+        }
+        mem_tracker_->Release(client_state->memory_footprint());
+        iter = clients.erase(iter);
+      } else {
+        // Client can't be GCed, but its calls might be GCable.
+        iter->second->GCCompletionRecords(
+            mem_tracker_,
+            [&] (SequenceNumber, CompletionRecord* completion_record) {
+              return completion_record->state != RpcState::IN_PROGRESS &&
+                  completion_record->last_updated < time_to_gc_responses_from;
+            });
         ++iter;
-        continue;
       }
-      mem_tracker_->Release(client_state->memory_footprint());
-      iter = clients_.erase(iter);
-    } else {
-      // Client can't be GCed, but its calls might be GCable.
-      iter->second->GCCompletionRecords(
-          mem_tracker_,
-          [&] (SequenceNumber, CompletionRecord* completion_record) {
-            return completion_record->state != RpcState::IN_PROGRESS &&
-                completion_record->last_updated < time_to_gc_responses_from;
-          });
-      ++iter;
     }
   }
 }
 
 string ResultTracker::ToString() {
-  lock_guard<simple_spinlock> l(lock_);
-  return ToStringUnlocked();
+  size_t num_clients = 0;
+  string client_states;
+  for (const auto& shard : shards_) {
+    lock_guard<simple_spinlock> l(shard->lock);
+    num_clients += shard->clients.size();
+    for (const auto& cs : shard->clients) {
+      SubstituteAndAppend(&client_states, "\n\tClient: $0, $1", cs.first, cs.second->ToString());
+    }
+  }
+  return Substitute("ResultTracker[this: $0, Num. Client States: $1, Client States:\n$2]",
+                    this, num_clients, client_states);
 }
 
-string ResultTracker::ToStringUnlocked() const {
-  string result = Substitute("ResultTracker[this: $0, Num. Client States: $1, Client States:\n",
-                             this, clients_.size());
-  for (auto& cs : clients_) {
-    SubstituteAndAppend(&result, Substitute("\n\tClient: $0, $1", cs.first, cs.second->ToString()));
+string ResultTracker::ToStringUnlocked(const Shard& shard) const {
+  string result = Substitute("ResultTracker[this: $0, Num. Client States in shard: $1, "
+                             "Client States:\n", this, shard.clients.size());
+  for (const auto& cs : shard.clients) {
+    SubstituteAndAppend(&result, "\n\tClient: $0, $1", cs.first, cs.second->ToString());
   }
   result.append("]");
   return result;
@@ -573,7 +620,8 @@ string ResultTracker::CompletionRecord::ToString() const {
                              "Cached response: $2, $3 OngoingRpcs:",
                              state,
                              driver_attempt_no,
-                             response ? SecureShortDebugString(*response) : "None",
+                             state == RpcState::COMPLETED ?
+                                 Substitute("$0 bytes", response_data.size()) : "None",
                              ongoing_rpcs.size());
   for (auto& orpc : ongoing_rpcs) {
     SubstituteAndAppend(&result, Substitute("\n\t$0", orpc.ToString()));
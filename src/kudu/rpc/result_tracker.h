@@ -144,6 +144,9 @@ class RpcContext;
 //   }
 // }
 //
+// The client states are spread over shards by client ID, each with its own lock, so that
+// the RPCs of different clients seldom contend.
+//
 // This class is thread safe.
 class ResultTracker : public RefCountedThreadSafe<ResultTracker> {
  public:
@@ -271,8 +274,10 @@ class ResultTracker : public RefCountedThreadSafe<ResultTracker> {
     // The timestamp of the last CompletionRecord update.
     MonoTime last_updated;
 
-    // The cached response, if this RPC is in COMPLETED state.
-    std::unique_ptr<google::protobuf::Message> response;
+    // The serialized cached response, if this RPC is in COMPLETED state. It's kept
+    // serialized rather than as a message, which takes several times the memory, since
+    // it's only parsed again to answer the retries of the RPC.
+    std::string response_data;
 
     // The set of ongoing RPCs that correspond to this record.
     std::vector<OnGoingRpcInfo> ongoing_rpcs;
@@ -283,7 +288,7 @@ class ResultTracker : public RefCountedThreadSafe<ResultTracker> {
     int64_t memory_footprint() const {
       return kudu_malloc_usable_size(this)
           + (ongoing_rpcs.capacity() > 0 ? kudu_malloc_usable_size(ongoing_rpcs.data()) : 0)
-          + (response ? response->SpaceUsedLong() : 0);
+          + response_data.capacity();
     }
   };
 
@@ -333,7 +338,10 @@ class ResultTracker : public RefCountedThreadSafe<ResultTracker> {
     }
   };
 
-  RpcState TrackRpcUnlocked(const RequestIdPB& request_id,
+  struct Shard;
+
+  RpcState TrackRpcUnlocked(Shard* shard,
+                            const RequestIdPB& request_id,
                             google::protobuf::Message* response,
                             RpcContext* context);
 
@@ -344,10 +352,12 @@ class ResultTracker : public RefCountedThreadSafe<ResultTracker> {
   void FailAndRespondInternal(const rpc::RequestIdPB& request_id,
                               const HandleOngoingRpcFunc& func);
 
-  CompletionRecord* FindCompletionRecordOrNullUnlocked(const RequestIdPB& request_id);
-  CompletionRecord* FindCompletionRecordOrDieUnlocked(const RequestIdPB& request_id);
+  CompletionRecord* FindCompletionRecordOrNullUnlocked(Shard* shard,
+                                                      const RequestIdPB& request_id);
+  CompletionRecord* FindCompletionRecordOrDieUnlocked(Shard* shard,
+                                                     const RequestIdPB& request_id);
   std::pair<ClientState*, CompletionRecord*> FindClientStateAndCompletionRecordOrNullUnlocked(
-      const RequestIdPB& request_id);
+      Shard* shard, const RequestIdPB& request_id);
 
   // A handler must handle an RPC attempt if:
   // 1 - It's its own attempt. I.e. it has the same attempt number of the handler.
@@ -369,18 +379,17 @@ class ResultTracker : public RefCountedThreadSafe<ResultTracker> {
   void LogAndTraceFailure(RpcContext* context, ErrorStatusPB_RpcErrorCodePB err,
                           const Status& status);
 
-  std::string ToStringUnlocked() const;
+  // Returns the description of the client states of 'shard', whose lock must be held.
+  std::string ToStringUnlocked(const Shard& shard) const;
 
   void RunGCThread();
 
+  // Returns the shard of the client with the given ID.
+  Shard* ShardFor(const std::string& client_id) const;
+
   // The memory tracker that tracks this ResultTracker's memory consumption.
   std::shared_ptr<kudu::MemTracker> mem_tracker_;
 
-  // Lock that protects access to 'clients_' and to the state contained in each
-  // ClientState.
-  // TODO consider a per-ClientState lock if we find this too coarse grained.
-  simple_spinlock lock_;
-
   typedef MemTrackerAllocator<std::pair<const std::string,
                                         std::unique_ptr<ClientState>>> ClientStateMapAllocator;
   typedef std::map<std::string,
@@ -388,7 +397,20 @@ class ResultTracker : public RefCountedThreadSafe<ResultTracker> {
                    std::less<std::string>,
                    ClientStateMapAllocator> ClientStateMap;
 
-  ClientStateMap clients_;
+  struct Shard {
+    explicit Shard(std::shared_ptr<MemTracker> mem_tracker)
+        : clients(ClientStateMap::key_compare(),
+                  ClientStateMapAllocator(std::move(mem_tracker))) {}
+
+    // Lock that protects access to 'clients' and to the state contained in each
+    // of its ClientStates.
+    simple_spinlock lock;
+
+    ClientStateMap clients;
+  };
+
+  // The shards of the client states. Their number is a power of two.
+  std::vector<std::unique_ptr<Shard>> shards_;
 
   // The thread which runs GC, and a latch to stop it.
   scoped_refptr<Thread> gc_thread_;
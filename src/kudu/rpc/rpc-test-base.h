@@ -394,7 +394,10 @@ class CalculatorService : public CalculatorServiceIf {
       TRACE_COUNTER_INCREMENT("related_trace_metric", 1);
     }
 
-    SleepFor(MonoDelta::FromMicroseconds(req->sleep_micros()));
+    {
+      TRACE_SPAN("test_sleep");
+      SleepFor(MonoDelta::FromMicroseconds(req->sleep_micros()));
+    }
     context->RespondSuccess();
   }
 
@@ -61,6 +61,7 @@
 #include "kudu/security/test/test_certs.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/env.h"
+#include "kudu/util/hdr_histogram.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/diagnostic_socket.h"
@@ -87,16 +88,22 @@ METRIC_DECLARE_counter(timed_out_on_response_kudu_rpc_test_CalculatorService_Sle
 METRIC_DECLARE_gauge_int32(rpc_pending_connections);
 METRIC_DECLARE_histogram(acceptor_dispatch_times);
 METRIC_DECLARE_histogram(handler_latency_kudu_rpc_test_CalculatorService_Sleep);
+METRIC_DECLARE_histogram(reactor_inbound_connection_queue_time);
+METRIC_DECLARE_histogram(reactor_outbound_transfers_per_write);
 METRIC_DECLARE_histogram(rpc_incoming_queue_time);
 METRIC_DECLARE_histogram(rpc_listen_socket_rx_queue_size);
 
+DECLARE_bool(rpc_compress_loopback_connections);
 DECLARE_bool(rpc_reopen_outbound_connections);
 DECLARE_bool(rpc_suppress_negotiation_trace);
 DECLARE_int32(rpc_listen_socket_stats_every_log2);
+DECLARE_int32(rpc_max_send_iovecs);
 DECLARE_int32(rpc_negotiation_inject_delay_ms);
 DECLARE_int32(tcp_keepalive_probe_period_s);
 DECLARE_int32(tcp_keepalive_retry_period_s);
 DECLARE_int32(tcp_keepalive_retry_count);
+DECLARE_string(rpc_compression_codec);
+DECLARE_string(rpc_compression_subnets);
 
 using std::tuple;
 using std::shared_ptr;
@@ -224,6 +231,78 @@ TEST_P(TestRpc, TestNegotiationDeadlock) {
   ASSERT_OK(DoTestSyncCall(&p, GenericCalculatorService::kAddMethodName));
 }
 
+// Test accepting connections on a listening socket per reactor.
+TEST_P(TestRpc, TestShardedAcceptorPool) {
+  constexpr int kNumReactors = 4;
+  constexpr int kNumClients = 16;
+  MessengerBuilder mb("TestRpc.TestShardedAcceptorPool");
+  mb.set_num_reactors(kNumReactors)
+      .set_num_acceptor_shards(0)
+      .set_metric_entity(metric_entity_);
+  if (enable_ssl()) mb.enable_inbound_tls();
+
+  shared_ptr<Messenger> messenger;
+  ASSERT_OK(mb.Build(&messenger));
+
+  Sockaddr server_addr = bind_addr();
+  ASSERT_OK(StartTestServerWithCustomMessenger(&server_addr, messenger, enable_ssl()));
+  if (!use_unix_socket()) {
+    ASSERT_NE(0, server_addr.port());
+  }
+
+  // Each client messenger opens a connection of its own.
+  for (int i = 0; i < kNumClients; i++) {
+    shared_ptr<Messenger> client_messenger;
+    ASSERT_OK(CreateMessenger("Client", &client_messenger, 1, enable_ssl()));
+    Proxy p(client_messenger, server_addr, kRemoteHostName,
+            GenericCalculatorService::static_service_name());
+    ASSERT_OK(DoTestSyncCall(&p, GenericCalculatorService::kAddMethodName));
+  }
+
+  auto metric_map = server_messenger_->metric_entity()->UnsafeMetricsMapForTests();
+  auto* metric = FindOrDie(metric_map, &METRIC_reactor_inbound_connection_queue_time).get();
+  ASSERT_EQ(kNumClients, down_cast<Histogram*>(metric)->TotalCount());
+}
+
+// The responses to the calls queued on a connection are all sent, whether
+// or not they are coalesced into shared writes.
+TEST_P(TestRpc, TestCoalescedOutboundTransfers) {
+  constexpr int kNumCalls = 200;
+  Sockaddr server_addr = bind_addr();
+  ASSERT_OK(StartTestServer(&server_addr, enable_ssl()));
+  shared_ptr<Messenger> client_messenger;
+  ASSERT_OK(CreateMessenger("Client", &client_messenger, 1, enable_ssl()));
+  Proxy p(client_messenger, server_addr, kRemoteHostName,
+          GenericCalculatorService::static_service_name());
+  // Establish the connection first.
+  ASSERT_OK(DoTestSyncCall(&p, GenericCalculatorService::kAddMethodName));
+
+  for (int max_iovecs : { 1, 4, 64 }) {
+    SCOPED_TRACE(max_iovecs);
+    FLAGS_rpc_max_send_iovecs = max_iovecs;
+    vector<AddRequestPB> reqs(kNumCalls);
+    vector<AddResponsePB> resps(kNumCalls);
+    vector<RpcController> controllers(kNumCalls);
+    CountDownLatch latch(kNumCalls);
+    for (int i = 0; i < kNumCalls; i++) {
+      reqs[i].set_x(i);
+      reqs[i].set_y(i);
+      p.AsyncRequest(GenericCalculatorService::kAddMethodName, reqs[i], &resps[i],
+                     &controllers[i], [&latch]() { latch.CountDown(); });
+    }
+    latch.Wait();
+    for (int i = 0; i < kNumCalls; i++) {
+      ASSERT_OK(controllers[i].status());
+      ASSERT_EQ(2 * i, resps[i].result());
+    }
+  }
+
+  // Each response was sent once, by one of the writes.
+  auto metric_map = server_messenger_->metric_entity()->UnsafeMetricsMapForTests();
+  auto* metric = FindOrDie(metric_map, &METRIC_reactor_outbound_transfers_per_write).get();
+  ASSERT_EQ(3 * kNumCalls + 1, down_cast<Histogram*>(metric)->histogram()->TotalSum());
+}
+
 // Test making successful RPC calls.
 TEST_P(TestRpc, TestCall) {
   // Set up server.
@@ -905,6 +984,38 @@ TEST_P(TestRpc, TestRpcSidecar) {
   DoTestOutgoingSidecarExpectOK(&p, 3000 * 1024, 2000 * 1024);
 }
 
+// Test that compressed requests and responses make it through, along with
+// their sidecars, whatever the codec, and whether they are worth compressing
+// or not.
+TEST_P(TestRpc, TestCompressedCalls) {
+  FLAGS_rpc_compress_loopback_connections = true;
+  Sockaddr server_addr = bind_addr();
+  ASSERT_OK(StartTestServer(&server_addr, enable_ssl()));
+
+  for (const auto& codec : { "LZ4", "ZSTD" }) {
+    for (const auto& subnets : { "", "127.0.0.0/8", "10.0.0.0/8" }) {
+      SCOPED_TRACE(Substitute("$0 over subnets '$1'", codec, subnets));
+      // The codec is chosen by both ends as a connection gets negotiated, so
+      // use a new client for a new connection.
+      FLAGS_rpc_compression_codec = codec;
+      FLAGS_rpc_compression_subnets = subnets;
+      shared_ptr<Messenger> client_messenger;
+      ASSERT_OK(CreateMessenger("Client", &client_messenger, 1, enable_ssl()));
+      Proxy p(client_messenger, server_addr, kRemoteHostName,
+              GenericCalculatorService::static_service_name());
+
+      ASSERT_OK(DoTestSyncCall(&p, GenericCalculatorService::kAddMethodName));
+      // Random sidecars don't shrink and are sent as is.
+      DoTestSidecar(&p, 123, 456);
+      DoTestSidecar(&p, 3000 * 1024, 2000 * 1024);
+      // These ones do.
+      DoTestOutgoingSidecarExpectOK(&p, 123, 456);
+      DoTestOutgoingSidecarExpectOK(&p, 3000 * 1024, 2000 * 1024);
+      client_messenger->Shutdown();
+    }
+  }
+}
+
 // Test sending the maximum number of sidecars, each of them being a single
 // character. This makes sure we handle the limit of IOV_MAX iovecs per sendmsg
 // call.
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <string>
@@ -27,6 +28,7 @@
 
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/messenger.h"
+#include "kudu/rpc/rpc_header.pb.h"
 
 using std::string;
 using strings::Substitute;
@@ -49,6 +51,17 @@ void RpcRetrier::DelayedRetry(Rpc* rpc, const Status& why_status) {
   // If the delay causes us to miss our deadline, RetryCb will fail the
   // RPC on our behalf.
   MonoDelta backoff = ComputeBackoff(attempt_num_++);
+  // An overloaded server may hint when to retry: wait at least that long,
+  // with some jitter so that the rejected clients don't all come back at once.
+  const ErrorStatusPB* err = controller_.error_response();
+  if (err && err->has_retry_after_ms()) {
+    const uint32_t retry_after_ms = err->retry_after_ms();
+    const auto hint = MonoDelta::FromMilliseconds(
+        retry_after_ms + rand() % (retry_after_ms / 2 + 1));
+    if (hint > backoff) {
+      backoff = hint;
+    }
+  }
   messenger_->ScheduleOnReactor(
       [this, rpc](const Status& s) { this->DelayedRetryCb(rpc, s); }, backoff);
 }
@@ -665,6 +665,26 @@ TEST_F(RpcStubTest, TestDumpSampledCalls) {
                       "    }");
   ASSERT_STR_CONTAINS(SecureDebugString(sampled_rpcs), "SleepRequestPB");
   ASSERT_STR_CONTAINS(SecureDebugString(sampled_rpcs), "duration_ms");
+
+  // Each sample is broken down into spans: the whole call, the time spent in
+  // the service queue and in the handler, and the spans of the trace, nested
+  // under the handler's.
+  ASSERT_EQ(1, sampled_rpcs.methods_size());
+  ASSERT_EQ(2, sampled_rpcs.methods(0).samples_size());
+  for (const auto& sample : sampled_rpcs.methods(0).samples()) {
+    ASSERT_EQ(4, sample.spans_size()) << SecureDebugString(sample);
+    ASSERT_EQ("call", sample.spans(0).name());
+    ASSERT_FALSE(sample.spans(0).has_parent());
+    ASSERT_EQ("queue", sample.spans(1).name());
+    ASSERT_EQ(0, sample.spans(1).parent());
+    ASSERT_EQ("handler", sample.spans(2).name());
+    ASSERT_EQ(0, sample.spans(2).parent());
+    const auto& sleep_span = sample.spans(3);
+    ASSERT_EQ("test_sleep", sleep_span.name());
+    ASSERT_EQ(2, sleep_span.parent());
+    ASSERT_GE(sleep_span.duration_micros(), 150 * 1000);
+    ASSERT_LE(sleep_span.duration_micros(), sample.spans(2).duration_micros());
+  }
 }
 
 namespace {
@@ -105,11 +105,24 @@ class MethodSampler {
                               const string& child_path,
                               RpczSamplePB* sample_pb);
 
+  // Convert the spans from 't' into protobuf entries in 'sample_pb', the
+  // root spans being nested under the span at index 'root_parent'. This
+  // function recurses through the child traces like GetTraceMetrics().
+  static void GetTraceSpans(const Trace& t,
+                            const string& child_path,
+                            int root_parent,
+                            RpczSamplePB* sample_pb);
+
   // An individual recorded sample.
   struct Sample {
     RequestHeader header;
     scoped_refptr<Trace> trace;
     int duration_ms;
+    // Wall time at which the call was received, and the time it spent in the
+    // service queue and in total, in microseconds.
+    MicrosecondsInt64 start_unix_micros;
+    int64_t queue_us;
+    int64_t total_us;
   };
 
   // A sample, including the particular time at which it was
@@ -170,7 +183,12 @@ void MethodSampler::SampleCall(InboundCall* call) {
       if (!lock.owns_lock()) {
         return;
       }
-      bucket->sample = {call->header(), call->trace(), duration_ms};
+      const auto& timing = call->timing();
+      const int64_t total_us = timing.TotalDuration().ToMicroseconds();
+      const MicrosecondsInt64 start_unix_micros =
+          GetCurrentTimeMicros() - (MonoTime::Now() - timing.time_received).ToMicroseconds();
+      bucket->sample = {call->header(), call->trace(), duration_ms, start_unix_micros,
+                        timing.QueueDuration().ToMicroseconds(), total_us};
     }
     bucket->last_sample_time = now;
     VLOG(2) << "Sampled call " << call->ToString();
@@ -200,6 +218,35 @@ void MethodSampler::GetTraceMetrics(const Trace& t,
   }
 }
 
+void MethodSampler::GetTraceSpans(const Trace& t,
+                                  const string& child_path,
+                                  int root_parent,
+                                  RpczSamplePB* sample_pb) {
+  const int first_index = sample_pb->spans_size();
+  for (const auto& span : t.Spans()) {
+    auto* pb = sample_pb->add_spans();
+    if (!child_path.empty()) {
+      pb->set_child_path(child_path);
+    }
+    pb->set_name(span.name);
+    pb->set_parent(span.parent == TraceSpan::kNoParent ? root_parent
+                                                       : first_index + span.parent);
+    pb->set_start_unix_micros(span.start_micros);
+    if (span.end_micros != 0) {
+      pb->set_duration_micros(span.end_micros - span.start_micros);
+    }
+  }
+
+  for (const auto& child_pair : t.ChildTraces()) {
+    string path = child_path;
+    if (!path.empty()) {
+      path += ".";
+    }
+    path += child_pair.first.ToString();
+    GetTraceSpans(*child_pair.second.get(), path, root_parent, sample_pb);
+  }
+}
+
 void MethodSampler::GetSamplePBs(RpczMethodPB* method_pb) {
   for (auto& bucket : buckets_) {
     if (bucket.last_sample_time == 0) {
@@ -213,6 +260,26 @@ void MethodSampler::GetSamplePBs(RpczMethodPB* method_pb) {
 
     GetTraceMetrics(*bucket.sample.trace.get(), "", sample_pb);
     sample_pb->set_duration_ms(bucket.sample.duration_ms);
+
+    // The call, split into the time spent in the service queue and in the
+    // handler, which the spans of the trace are nested under.
+    const auto& sample = bucket.sample;
+    sample_pb->set_start_unix_micros(sample.start_unix_micros);
+    auto* call_span = sample_pb->add_spans();
+    call_span->set_name("call");
+    call_span->set_start_unix_micros(sample.start_unix_micros);
+    call_span->set_duration_micros(sample.total_us);
+    auto* queue_span = sample_pb->add_spans();
+    queue_span->set_name("queue");
+    queue_span->set_parent(0);
+    queue_span->set_start_unix_micros(sample.start_unix_micros);
+    queue_span->set_duration_micros(sample.queue_us);
+    auto* handler_span = sample_pb->add_spans();
+    handler_span->set_name("handler");
+    handler_span->set_parent(0);
+    handler_span->set_start_unix_micros(sample.start_unix_micros + sample.queue_us);
+    handler_span->set_duration_micros(sample.total_us - sample.queue_us);
+    GetTraceSpans(*sample.trace.get(), "", sample_pb->spans_size() - 1, sample_pb);
   }
 }
 
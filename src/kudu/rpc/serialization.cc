@@ -17,10 +17,12 @@
 
 #include "kudu/rpc/serialization.h"
 
+#include <algorithm>
 #include <limits>
 #include <ostream>
+#include <vector>
 
-#include <gflags/gflags_declare.h>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/message_lite.h>
@@ -30,16 +32,30 @@
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/constants.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 DECLARE_int64(rpc_max_message_size);
 
+DEFINE_int32(rpc_compression_min_bytes, 16 * 1024,
+             "Minimum size in bytes of the body of an RPC request or response, "
+             "sidecars included, for it to be compressed when compression is "
+             "enabled with --rpc_compression_codec. Smaller bodies are sent "
+             "as is since they don't gain enough from it to be worth the CPU.");
+TAG_FLAG(rpc_compression_min_bytes, advanced);
+TAG_FLAG(rpc_compression_min_bytes, experimental);
+TAG_FLAG(rpc_compression_min_bytes, runtime);
+DEFINE_validator(rpc_compression_min_bytes,
+                 [](const char* /* flagname */, int32_t value) { return value >= 0; });
+
 using google::protobuf::MessageLite;
 using google::protobuf::io::CodedInputStream;
 using google::protobuf::io::CodedOutputStream;
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
@@ -176,6 +192,77 @@ Status ParseMessage(const Slice& buf,
   return Status::OK();
 }
 
+bool CompressMessage(const CompressionCodec& codec,
+                     const Slice& param_buf,
+                     const vector<Slice>& sidecar_slices,
+                     faststring* compressed_buf,
+                     Slice* compressed_msg,
+                     uint32_t* uncompressed_size) {
+  // The main message follows the length prefix written by SerializeMessage().
+  CodedInputStream in(param_buf.data(), param_buf.size());
+  uint32_t main_msg_len;
+  CHECK(in.ReadVarint32(&main_msg_len));
+  if (static_cast<int64_t>(main_msg_len) < FLAGS_rpc_compression_min_bytes) {
+    return false;
+  }
+  const int delim_len = in.CurrentPosition();
+  vector<Slice> main_msg;
+  main_msg.reserve(1 + sidecar_slices.size());
+  main_msg.emplace_back(param_buf.data() + delim_len, param_buf.size() - delim_len);
+  main_msg.insert(main_msg.end(), sidecar_slices.begin(), sidecar_slices.end());
+
+  // Compress past room for the longest length prefix, then put the actual
+  // prefix right before the compressed bytes, so they aren't moved around.
+  const size_t max_compressed_len = codec.MaxCompressedLength(main_msg_len);
+  const int max_delim_len = CodedOutputStream::VarintSize32(
+      std::min<size_t>(max_compressed_len, std::numeric_limits<uint32_t>::max()));
+  compressed_buf->resize(max_delim_len + max_compressed_len);
+  size_t compressed_len = max_compressed_len;
+  Status s = codec.Compress(main_msg, compressed_buf->data() + max_delim_len, &compressed_len);
+  if (PREDICT_FALSE(!s.ok())) {
+    KLOG_EVERY_N_SECS(WARNING, 60) << "Unable to compress RPC message, sending it as is: "
+                                   << s.ToString();
+    return false;
+  }
+  if (compressed_len >= main_msg_len) {
+    return false;
+  }
+  const int compressed_delim_len = CodedOutputStream::VarintSize32(compressed_len);
+  uint8_t* start = compressed_buf->data() + max_delim_len - compressed_delim_len;
+  CodedOutputStream::WriteVarint32ToArray(compressed_len, start);
+  *compressed_msg = Slice(start, compressed_delim_len + compressed_len);
+  *uncompressed_size = main_msg_len;
+  return true;
+}
+
+Status UncompressMessage(CompressionType type,
+                         uint32_t uncompressed_size,
+                         faststring* uncompressed_buf,
+                         Slice* main_message) {
+  // Guard against a peer making us allocate more than any message may take.
+  if (PREDICT_FALSE(uncompressed_size > FLAGS_rpc_max_message_size)) {
+    return Status::Corruption(Substitute(
+        "Invalid packet: compressed message had an uncompressed length of $0, "
+        "but we only support messages up to $1 bytes",
+        uncompressed_size, FLAGS_rpc_max_message_size));
+  }
+  // Only accept the codecs which are known never to write past the end of the
+  // buffer they uncompress into, whatever the peer sends.
+  if (PREDICT_FALSE(type != LZ4 && type != ZSTD)) {
+    return Status::Corruption(Substitute(
+        "Invalid packet: message compressed with unsupported codec $0",
+        static_cast<int>(type)));
+  }
+  const CompressionCodec* codec;
+  RETURN_NOT_OK(GetCompressionCodec(type, &codec));
+  uncompressed_buf->resize(uncompressed_size);
+  RETURN_NOT_OK_PREPEND(codec->Uncompress(*main_message, uncompressed_buf->data(),
+                                          uncompressed_size),
+                        "Invalid packet: unable to uncompress message");
+  *main_message = Slice(*uncompressed_buf);
+  return Status::OK();
+}
+
 void SerializeConnHeader(uint8_t* buf) {
   memcpy(reinterpret_cast<char *>(buf), kMagicNumber, kMagicNumberLength);
   buf += kMagicNumberLength;
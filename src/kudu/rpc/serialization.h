@@ -18,6 +18,9 @@
 
 #include <cstdint>
 #include <cstring>
+#include <vector>
+
+#include "kudu/util/compression/compression.pb.h"
 
 namespace google {
 namespace protobuf {
@@ -27,6 +30,7 @@ class MessageLite;
 
 namespace kudu {
 
+class CompressionCodec;
 class Status;
 class faststring;
 class Slice;
@@ -72,6 +76,33 @@ Status ParseMessage(const Slice& buf,
                     google::protobuf::MessageLite* parsed_header,
                     Slice* parsed_main_message);
 
+// Compresses with 'codec' the main message made of the request or response
+// param serialized into 'param_buf' by SerializeMessage() and of the
+// 'sidecar_slices' appended onto it.
+// Out: 'compressed_msg' pointing into 'compressed_buf' at the compressed main
+//        message, prefixed with its length the same way as 'param_buf', to be
+//        sent in place of the param and the sidecars,
+//      'uncompressed_size' set to the size of the main message.
+// Returns false, leaving the outputs in an unspecified state, if the main
+// message is smaller than --rpc_compression_min_bytes or if it doesn't shrink,
+// in which case it should be sent as is.
+bool CompressMessage(const CompressionCodec& codec,
+                     const Slice& param_buf,
+                     const std::vector<Slice>& sidecar_slices,
+                     faststring* compressed_buf,
+                     Slice* compressed_msg,
+                     uint32_t* uncompressed_size);
+
+// Uncompresses the 'main_message' returned by ParseMessage() for a message
+// whose header says that it's compressed with 'type' from 'uncompressed_size'
+// bytes.
+// Out: 'main_message' pointing into 'uncompressed_buf' at the uncompressed
+//        main message.
+Status UncompressMessage(CompressionType type,
+                         uint32_t uncompressed_size,
+                         faststring* uncompressed_buf,
+                         Slice* main_message);
+
 // Serialize the RPC connection header (magic number + flags).
 // buf must have 7 bytes available (kMagicNumberLength + kHeaderFlagsLength).
 void SerializeConnHeader(uint8_t* buf);
@@ -651,6 +651,9 @@ Status ServerNegotiation::HandleTlsHandshake(const NegotiatePB& request) {
   }
 
   // TLS handshake is finished.
+  if (tls_handshake_.session_reused()) {
+    TRACE("Resumed TLS session");
+  }
   if (ContainsKey(server_features_, TLS_AUTHENTICATION_ONLY) &&
       ContainsKey(client_features_, TLS_AUTHENTICATION_ONLY)) {
     TRACE("Negotiated auth-only $0 with cipher $1",
@@ -98,6 +98,12 @@ class ServerNegotiation {
     return tls_negotiated_;
   }
 
+  // Returns true if the TLS handshake resumed a previous TLS session.
+  // Must be called after Negotiate().
+  bool tls_session_reused() const {
+    return tls_negotiated_ && tls_handshake_.session_reused();
+  }
+
   // Returns the set of RPC system features supported by the remote client.
   // Must be called after Negotiate().
   std::set<RpcFeatureFlag> client_features() const {
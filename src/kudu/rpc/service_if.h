@@ -47,6 +47,7 @@ struct RpcMethodInfo : public RefCountedThreadSafe<RpcMethodInfo> {
   std::unique_ptr<google::protobuf::Message> resp_prototype;
 
   scoped_refptr<Histogram> handler_latency_histogram;
+  scoped_refptr<Histogram> queue_time_histogram;
   scoped_refptr<Counter> queue_overflow_rejections;
 
   // The number of times the service sent back a response (both success and
@@ -17,25 +17,32 @@
 
 #include "kudu/rpc/service_pool.h"
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/join.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/inbound_call.h"
 #include "kudu/rpc/remote_method.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/service_if.h"
 #include "kudu/rpc/service_queue.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/net/sockaddr.h"
@@ -43,11 +50,50 @@
 #include "kudu/util/thread.h"
 #include "kudu/util/trace.h"
 
+using std::pair;
 using std::string;
 using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
+DEFINE_string(rpc_service_queue_method_weights, "",
+              "Comma-separated list of <method>:<weight> pairs, where <method> "
+              "is the name of an RPC method, optionally qualified with the name "
+              "of its service, e.g. 'Write:4,kudu.tserver.TabletServerService.Scan:1'. "
+              "Each listed method gets a part of the service queue of its own, as "
+              "long as the service queue length, so that a flood of calls of "
+              "another method doesn't delay or reject its calls beyond its share. "
+              "While calls of several parts are queued, each part gets a share of "
+              "the service threads proportional to its weight. The methods not "
+              "listed share a part of weight 1.");
+TAG_FLAG(rpc_service_queue_method_weights, advanced);
+TAG_FLAG(rpc_service_queue_method_weights, experimental);
+
+DEFINE_int32(rpc_service_queue_codel_target_ms, 0,
+             "Target time calls spend in the service queue, in milliseconds, of "
+             "the CoDel-style admission control of the services. Once the calls "
+             "dequeued during a whole interval (see "
+             "--rpc_service_queue_codel_interval_ms) all waited longer than this, "
+             "the service is considered overloaded: the calls which waited more "
+             "than twice the target are then rejected as the server being too "
+             "busy, with a hint to retry after an interval, rather than left to "
+             "time out in the queue. If 0, the admission control is disabled.");
+TAG_FLAG(rpc_service_queue_codel_target_ms, advanced);
+TAG_FLAG(rpc_service_queue_codel_target_ms, experimental);
+TAG_FLAG(rpc_service_queue_codel_target_ms, runtime);
+DEFINE_validator(rpc_service_queue_codel_target_ms,
+                 [](const char* /* flagname */, int32_t value) { return value >= 0; });
+
+DEFINE_int32(rpc_service_queue_codel_interval_ms, 100,
+             "Interval, in milliseconds, over which the CoDel-style admission "
+             "control of the services tracks the minimum time calls spend in the "
+             "service queue. See --rpc_service_queue_codel_target_ms.");
+TAG_FLAG(rpc_service_queue_codel_interval_ms, advanced);
+TAG_FLAG(rpc_service_queue_codel_interval_ms, experimental);
+TAG_FLAG(rpc_service_queue_codel_interval_ms, runtime);
+DEFINE_validator(rpc_service_queue_codel_interval_ms,
+                 [](const char* /* flagname */, int32_t value) { return value > 0; });
+
 METRIC_DEFINE_histogram(server, rpc_incoming_queue_time,
                         "RPC Queue Time",
                         kudu::MetricUnit::kMicroseconds,
@@ -68,6 +114,45 @@ METRIC_DEFINE_counter(server, rpcs_queue_overflow,
                       "Number of RPCs dropped because the service queue was full.",
                       kudu::MetricLevel::kWarn);
 
+METRIC_DEFINE_counter(server, rpcs_shed,
+                      "RPCs Shed by Admission Control",
+                      kudu::MetricUnit::kRequests,
+                      "Number of RPCs rejected because the service was overloaded, "
+                      "according to the time calls spent in the service queue.",
+                      kudu::MetricLevel::kWarn);
+
+namespace {
+
+// Parses the value of --rpc_service_queue_method_weights into 'weights', a
+// list of (method name, weight) pairs.
+kudu::Status ParseMethodWeights(const string& value, vector<pair<string, int>>* weights) {
+  for (const auto& entry : strings::Split(value, ",", strings::SkipWhitespace())) {
+    vector<string> parts = strings::Split(entry, ":");
+    int weight;
+    if (parts.size() != 2 || parts[0].empty() ||
+        !safe_strto32(parts[1], &weight) || weight <= 0) {
+      return kudu::Status::InvalidArgument(
+          "expected <method>:<weight> with a positive weight", entry.ToString());
+    }
+    weights->emplace_back(std::move(parts[0]), weight);
+  }
+  return kudu::Status::OK();
+}
+
+bool ValidateMethodWeights(const char* flagname, const string& value) {
+  vector<pair<string, int>> weights;
+  const auto s = ParseMethodWeights(value, &weights);
+  if (s.ok()) {
+    return true;
+  }
+  LOG(ERROR) << Substitute("invalid value for --$0: $1", flagname, s.ToString());
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(rpc_service_queue_method_weights, &ValidateMethodWeights);
+
 namespace kudu {
 namespace rpc {
 
@@ -75,10 +160,13 @@ ServicePool::ServicePool(unique_ptr<ServiceIf> service,
                          const scoped_refptr<MetricEntity>& entity,
                          size_t service_queue_length)
   : service_(std::move(service)),
-    service_queue_(service_queue_length),
+    service_queue_(InitQueueClasses(service_queue_length)),
     incoming_queue_time_(METRIC_rpc_incoming_queue_time.Instantiate(entity)),
     rpcs_timed_out_in_queue_(METRIC_rpcs_timed_out_in_queue.Instantiate(entity)),
     rpcs_queue_overflow_(METRIC_rpcs_queue_overflow.Instantiate(entity)),
+    rpcs_shed_(METRIC_rpcs_shed.Instantiate(entity)),
+    overloaded_(false),
+    last_queue_time_us_(0),
     closing_(false) {
 }
 
@@ -86,6 +174,40 @@ ServicePool::~ServicePool() {
   Shutdown();
 }
 
+vector<LifoServiceQueue::CallClass> ServicePool::InitQueueClasses(size_t service_queue_length) {
+  vector<LifoServiceQueue::CallClass> classes = { { service_queue_length, 1 } };
+  vector<pair<string, int>> weights;
+  CHECK_OK(ParseMethodWeights(FLAGS_rpc_service_queue_method_weights, &weights));
+  const string& service_name = service_->service_name();
+  for (const auto& [name, weight] : weights) {
+    string method_name = name;
+    const auto pos = name.rfind('.');
+    if (pos != string::npos) {
+      if (name.compare(0, pos, service_name) != 0 || pos != service_name.size()) {
+        continue;
+      }
+      method_name = name.substr(pos + 1);
+    }
+    // Only the methods the service dispatches on its own have a method info.
+    const RpcMethodInfo* method_info =
+        service_->LookupMethod(RemoteMethod(service_name, method_name));
+    if (!method_info || ContainsKey(method_classes_, method_info)) {
+      continue;
+    }
+    method_classes_.emplace(method_info, classes.size());
+    classes.push_back({ service_queue_length, weight });
+  }
+  return classes;
+}
+
+size_t ServicePool::QueueClassOf(InboundCall* c) const {
+  if (method_classes_.empty()) {
+    return 0;
+  }
+  const size_t* class_idx = FindOrNull(method_classes_, c->method_info());
+  return class_idx ? *class_idx : 0;
+}
+
 Status ServicePool::Init(int num_threads) {
   for (int i = 0; i < num_threads; i++) {
     scoped_refptr<kudu::Thread> new_thread;
@@ -128,7 +250,7 @@ void ServicePool::RejectTooBusy(InboundCall* c) {
                  c->remote_method().method_name(),
                  service_->service_name(),
                  c->remote_address().ToString(),
-                 service_queue_.max_size());
+                 service_queue_.max_size(QueueClassOf(c)));
   rpcs_queue_overflow_->Increment();
   auto* minfo = c->method_info();
   if (minfo) {
@@ -145,6 +267,67 @@ void ServicePool::RejectTooBusy(InboundCall* c) {
   }
 }
 
+void ServicePool::RejectOverloaded(InboundCall* c) {
+  const auto retry_after =
+      MonoDelta::FromMilliseconds(FLAGS_rpc_service_queue_codel_interval_ms);
+  string err_msg =
+      Substitute("$0 request on $1 from $2 dropped due to load shedding. "
+                 "Calls wait in the service queue for $3us.",
+                 c->remote_method().method_name(),
+                 service_->service_name(),
+                 c->remote_address().ToString(),
+                 last_queue_time_us_.load(std::memory_order_relaxed));
+  rpcs_shed_->Increment();
+  KLOG_EVERY_N_SECS(WARNING, 1) << err_msg << THROTTLE_MSG;
+  c->RespondTooBusy(Status::ServiceUnavailable(err_msg), retry_after);
+
+  if (too_busy_hook_) {
+    too_busy_hook_();
+  }
+}
+
+bool ServicePool::ShouldShedOnArrival() const {
+  const int64_t target_us = FLAGS_rpc_service_queue_codel_target_ms * 1000L;
+  // Only the calls which would wait in the queue about as long as the last one
+  // dequeued are rejected: that stops once the queue drained.
+  return target_us > 0 &&
+      overloaded_.load(std::memory_order_relaxed) &&
+      service_queue_.estimated_queue_length() > 0 &&
+      last_queue_time_us_.load(std::memory_order_relaxed) > 2 * target_us;
+}
+
+bool ServicePool::UpdateAdmissionControl(MonoDelta queue_time, MonoTime now) {
+  last_queue_time_us_.store(queue_time.ToMicroseconds(), std::memory_order_relaxed);
+  const auto target = MonoDelta::FromMilliseconds(FLAGS_rpc_service_queue_codel_target_ms);
+  if (PREDICT_TRUE(target.ToMilliseconds() == 0)) {
+    if (PREDICT_FALSE(overloaded_.load(std::memory_order_relaxed))) {
+      overloaded_.store(false, std::memory_order_relaxed);
+    }
+    return false;
+  }
+
+  bool overloaded;
+  {
+    std::lock_guard l(codel_lock_);
+    if (!codel_min_queue_time_.Initialized() || queue_time < codel_min_queue_time_) {
+      codel_min_queue_time_ = queue_time;
+    }
+    if (!codel_interval_end_.Initialized()) {
+      codel_interval_end_ =
+          now + MonoDelta::FromMilliseconds(FLAGS_rpc_service_queue_codel_interval_ms);
+    } else if (now >= codel_interval_end_) {
+      // As in CoDel, a standing queue is one that no call got through
+      // quickly during a whole interval: bursts alone don't trigger shedding.
+      overloaded_.store(codel_min_queue_time_ > target, std::memory_order_relaxed);
+      codel_min_queue_time_ = MonoDelta();
+      codel_interval_end_ =
+          now + MonoDelta::FromMilliseconds(FLAGS_rpc_service_queue_codel_interval_ms);
+    }
+    overloaded = overloaded_.load(std::memory_order_relaxed);
+  }
+  return overloaded && queue_time > target + target;
+}
+
 RpcMethodInfo* ServicePool::LookupMethod(const RemoteMethod& method) {
   return service_->LookupMethod(method);
 }
@@ -167,11 +350,16 @@ Status ServicePool::QueueInboundCall(unique_ptr<InboundCall> call) {
                                            ", "));
   }
 
+  if (PREDICT_FALSE(ShouldShedOnArrival())) {
+    RejectOverloaded(c);
+    return Status::OK();
+  }
+
   TRACE_TO(c->trace(), "Inserting onto call queue");
 
   // Queue message on service queue
   std::optional<InboundCall*> evicted;
-  const auto queue_status = service_queue_.Put(c, &evicted);
+  const auto queue_status = service_queue_.Put(c, &evicted, QueueClassOf(c));
   if (queue_status == QUEUE_FULL) {
     RejectTooBusy(c);
     return Status::OK();
@@ -210,6 +398,14 @@ void ServicePool::RunThread() {
     incoming->RecordHandlingStarted(incoming_queue_time_.get());
     ADOPT_TRACE(incoming->trace());
 
+    const MonoTime handled = incoming->GetTimeHandled();
+    if (PREDICT_FALSE(UpdateAdmissionControl(handled - incoming->GetTimeReceived(),
+                                             handled))) {
+      TRACE_TO(incoming->trace(), "Shedding call since the service is overloaded");
+      RejectOverloaded(incoming.release());
+      continue;
+    }
+
     if (PREDICT_FALSE(incoming->ClientTimedOut())) {
       TRACE_TO(incoming->trace(), "Skipping call since client already timed out");
       rpcs_timed_out_in_queue_->Increment();
@@ -16,10 +16,13 @@
 // under the License.
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -27,6 +30,8 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/rpc_service.h"
 #include "kudu/rpc/service_queue.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/mutex.h"
 #include "kudu/util/status.h"
 
@@ -86,18 +91,61 @@ class ServicePool : public RpcService {
     return rpcs_queue_overflow_.get();
   }
 
+  const Counter* RpcsShedMetricForTests() const {
+    return rpcs_shed_.get();
+  }
+
   const std::string& service_name() const;
 
  private:
   void RunThread();
   void RejectTooBusy(InboundCall* c);
 
+  // Rejects the call 'c' because the service is overloaded, according to the
+  // admission control.
+  void RejectOverloaded(InboundCall* c);
+
+  // Returns true if the admission control rejects the calls which arrive now.
+  bool ShouldShedOnArrival() const;
+
+  // Feeds the admission control with the time 'queue_time' the call dequeued
+  // at 'now' spent in the service queue. Returns true if the call should be
+  // shed rather than handled.
+  bool UpdateAdmissionControl(MonoDelta queue_time, MonoTime now);
+
+  // Returns the classes of calls of the service queue, according to
+  // --rpc_service_queue_method_weights, filling 'method_classes_'.
+  std::vector<LifoServiceQueue::CallClass> InitQueueClasses(size_t service_queue_length);
+
+  // Returns the class of the service queue the call 'c' belongs to.
+  size_t QueueClassOf(InboundCall* c) const;
+
   std::unique_ptr<ServiceIf> service_;
   std::vector<scoped_refptr<kudu::Thread> > threads_;
+
+  // The class of the service queue of the methods which have one of their
+  // own. The other methods share the class 0.
+  std::unordered_map<const RpcMethodInfo*, size_t> method_classes_;
+
   LifoServiceQueue service_queue_;
   scoped_refptr<Histogram> incoming_queue_time_;
   scoped_refptr<Counter> rpcs_timed_out_in_queue_;
   scoped_refptr<Counter> rpcs_queue_overflow_;
+  scoped_refptr<Counter> rpcs_shed_;
+
+  // The state of the CoDel-style admission control: see
+  // --rpc_service_queue_codel_target_ms.
+  //
+  // Protects the interval and the minimum queue time.
+  simple_spinlock codel_lock_;
+  // The end of the current interval.
+  MonoTime codel_interval_end_;
+  // The minimum queue time of the calls dequeued during the current interval.
+  MonoDelta codel_min_queue_time_;
+  // Whether the minimum queue time of the last interval exceeded the target.
+  std::atomic<bool> overloaded_;
+  // The queue time of the call dequeued last, in microseconds.
+  std::atomic<int64_t> last_queue_time_us_;
 
   Mutex shutdown_lock_;
   bool closing_;
@@ -22,6 +22,7 @@
 #include <ostream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -147,5 +148,63 @@ TEST(TestServiceQueue, LifoServiceQueuePerf) {
   LOG(INFO) << "Avg idle workers:     " << total_idle_workers / static_cast<double>(total_sample);
 }
 
+// The calls of a class don't evict the calls of another, and the classes with
+// queued calls are dequeued according to their weights.
+TEST(TestServiceQueue, TestCallClasses) {
+  constexpr int kClassSize = 10;
+  LifoServiceQueue queue({ { kClassSize, 1 }, { kClassSize, 3 } });
+  ASSERT_EQ(2 * kClassSize, queue.max_size());
+  ASSERT_EQ(2, queue.num_classes());
+
+  std::unordered_map<InboundCall*, int> call_classes;
+  for (int c = 0; c < 2; c++) {
+    for (int i = 0; i < kClassSize; i++) {
+      InboundCall* call = new InboundCall(nullptr);
+      std::optional<InboundCall*> evicted;
+      ASSERT_EQ(QUEUE_SUCCESS, queue.Put(call, &evicted, c));
+      ASSERT_FALSE(evicted.has_value());
+      call_classes.emplace(call, c);
+    }
+  }
+
+  // The class 0 is full: a new call of the class bumps one of its calls.
+  {
+    InboundCall* call = new InboundCall(nullptr);
+    std::optional<InboundCall*> evicted;
+    const auto status = queue.Put(call, &evicted, 0);
+    if (status == QUEUE_FULL) {
+      delete call;
+    } else {
+      ASSERT_EQ(QUEUE_SUCCESS, status);
+      ASSERT_TRUE(evicted.has_value());
+      ASSERT_EQ(0, call_classes[*evicted]);
+      call_classes.erase(*evicted);
+      delete *evicted;
+      call_classes.emplace(call, 0);
+    }
+  }
+
+  // A consumer thread is bound to a single queue.
+  vector<int> dequeued_classes;
+  std::thread consumer([&]() {
+    for (int i = 0; i < 2 * kClassSize; i++) {
+      unique_ptr<InboundCall> call;
+      CHECK(queue.BlockingGet(&call));
+      dequeued_classes.push_back(call_classes[call.get()]);
+    }
+  });
+  consumer.join();
+  queue.Shutdown();
+
+  // While both classes have calls, the class 1 gets three dequeues for each one
+  // of the class 0.
+  ASSERT_EQ(2 * kClassSize, dequeued_classes.size());
+  int num_class_1 = 0;
+  for (int i = 0; i < 8; i++) {
+    num_class_1 += dequeued_classes[i];
+  }
+  ASSERT_EQ(6, num_class_1);
+}
+
 } // namespace rpc
 } // namespace kudu
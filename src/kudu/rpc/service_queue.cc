@@ -20,25 +20,75 @@
 #include <mutex>
 #include <optional>
 #include <ostream>
+#include <vector>
 
 #include "kudu/gutil/port.h"
 
+using std::vector;
+
 namespace kudu {
 namespace rpc {
 
 thread_local LifoServiceQueue::ConsumerState* LifoServiceQueue::tl_consumer_ = nullptr;
 
+namespace {
+
+size_t TotalMaxSize(const vector<LifoServiceQueue::CallClass>& classes) {
+  size_t max_size = 0;
+  for (const auto& c : classes) {
+    max_size += c.max_size;
+  }
+  return max_size;
+}
+
+} // anonymous namespace
+
 LifoServiceQueue::LifoServiceQueue(size_t max_size)
-   : max_queue_size_(max_size),
-     shutdown_(false) {
-  DCHECK_GT(max_queue_size_, 0);
+    : LifoServiceQueue(vector<CallClass>{ { max_size, 1 } }) {
+}
+
+LifoServiceQueue::LifoServiceQueue(const vector<CallClass>& classes)
+   : max_queue_size_(TotalMaxSize(classes)),
+     shutdown_(false),
+     num_queued_(0) {
+  DCHECK(!classes.empty());
+  classes_.reserve(classes.size());
+  for (const auto& c : classes) {
+    DCHECK_GT(c.max_size, 0);
+    DCHECK_GT(c.weight, 0);
+    classes_.emplace_back(c);
+  }
 }
 
 LifoServiceQueue::~LifoServiceQueue() {
-  DCHECK(queue_.empty())
+  DCHECK_EQ(0, num_queued_)
       << "ServiceQueue holds bare pointers at destruction time";
 }
 
+LifoServiceQueue::ClassQueue* LifoServiceQueue::NextClassUnlocked() {
+  DCHECK(lock_.is_locked());
+  DCHECK_GT(num_queued_, 0);
+  if (classes_.size() == 1) {
+    return &classes_[0];
+  }
+  // Smooth weighted round-robin across the classes with queued calls: each of
+  // them earns its weight, and the richest one pays for the dequeue.
+  int64_t total_weight = 0;
+  ClassQueue* next = nullptr;
+  for (auto& c : classes_) {
+    if (c.calls.empty()) {
+      continue;
+    }
+    c.current_weight += c.weight;
+    total_weight += c.weight;
+    if (!next || c.current_weight > next->current_weight) {
+      next = &c;
+    }
+  }
+  next->current_weight -= total_weight;
+  return next;
+}
+
 bool LifoServiceQueue::BlockingGet(std::unique_ptr<InboundCall>* out) {
   auto* consumer = tl_consumer_;
   if (PREDICT_FALSE(!consumer)) {
@@ -50,10 +100,16 @@ bool LifoServiceQueue::BlockingGet(std::unique_ptr<InboundCall>* out) {
   while (true) {
     {
       std::lock_guard<simple_spinlock> l(lock_);
-      if (!queue_.empty()) {
-        auto it = queue_.begin();
+      if (num_queued_ > 0) {
+        ClassQueue* c = NextClassUnlocked();
+        auto it = c->calls.begin();
         out->reset(*it);
-        queue_.erase(it);
+        c->calls.erase(it);
+        if (c->calls.empty()) {
+          // A class doesn't keep any credit while idle.
+          c->current_weight = 0;
+        }
+        --num_queued_;
         return true;
       }
       if (PREDICT_FALSE(shutdown_)) {
@@ -75,16 +131,18 @@ bool LifoServiceQueue::BlockingGet(std::unique_ptr<InboundCall>* out) {
 }
 
 QueueStatus LifoServiceQueue::Put(InboundCall* call,
-                                  std::optional<InboundCall*>* evicted) {
+                                  std::optional<InboundCall*>* evicted,
+                                  size_t class_idx) {
+  DCHECK_LT(class_idx, classes_.size());
   std::unique_lock<simple_spinlock> l(lock_);
   if (PREDICT_FALSE(shutdown_)) {
     return QUEUE_SHUTDOWN;
   }
 
-  DCHECK(waiting_consumers_.empty() || queue_.empty());
+  DCHECK(waiting_consumers_.empty() || num_queued_ == 0);
 
   // fast path
-  if (queue_.empty() && !waiting_consumers_.empty()) {
+  if (num_queued_ == 0 && !waiting_consumers_.empty()) {
     auto* consumer = waiting_consumers_.back();
     waiting_consumers_.pop_back();
     // Notify condition var(and wake up consumer thread) takes time,
@@ -94,20 +152,23 @@ QueueStatus LifoServiceQueue::Put(InboundCall* call,
     return QUEUE_SUCCESS;
   }
 
-  if (PREDICT_FALSE(queue_.size() >= max_queue_size_)) {
+  auto& queue = classes_[class_idx].calls;
+  if (PREDICT_FALSE(queue.size() >= classes_[class_idx].max_size)) {
     // eviction
-    DCHECK_EQ(queue_.size(), max_queue_size_);
-    auto it = queue_.end();
+    DCHECK_EQ(queue.size(), classes_[class_idx].max_size);
+    auto it = queue.end();
     --it;
     if (DeadlineLess(*it, call)) {
       return QUEUE_FULL;
     }
 
     *evicted = *it;
-    queue_.erase(it);
+    queue.erase(it);
+    --num_queued_;
   }
 
-  queue_.insert(call);
+  queue.insert(call);
+  ++num_queued_;
   return QUEUE_SUCCESS;
 }
 
@@ -126,9 +187,11 @@ std::string LifoServiceQueue::ToString() const {
   std::string ret;
 
   std::lock_guard<simple_spinlock> l(lock_);
-  for (const auto* t : queue_) {
-    ret.append(t->ToString());
-    ret.append("\n");
+  for (const auto& c : classes_) {
+    for (const auto* t : c.calls) {
+      ret.append(t->ToString());
+      ret.append("\n");
+    }
   }
   return ret;
 }
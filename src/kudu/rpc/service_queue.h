@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <set>
@@ -69,33 +70,67 @@ enum QueueStatus {
 //   work rate, the queue implementation itself is never used. Thus, we can
 //   have a priority queue without paying extra for it in the common case.
 //
+// The calls may also be split into classes, each of which is bounded and
+// evicts calls on its own: a flood of calls of one class then neither delays
+// nor rejects the calls of the others beyond their share. While calls of
+// several classes are queued, the classes are dequeued in smooth weighted
+// round-robin order.
+//
 // NOTE: because of the use of thread-local consumer records, once a consumer
 // thread accesses one LifoServiceQueue, it becomes "bound" to that queue and
 // must never access any other instance.
 class LifoServiceQueue final {
  public:
+  // A class of calls of the queue.
+  struct CallClass {
+    // The maximum number of calls of the class held by the queue.
+    size_t max_size;
+
+    // The share of the dequeued calls the class gets, relative to the other
+    // classes with queued calls. Must be positive.
+    int weight;
+  };
+
+  // Creates a queue with a single class of calls.
   explicit LifoServiceQueue(size_t max_size);
+
+  // Creates a queue with the classes of calls 'classes'.
+  explicit LifoServiceQueue(const std::vector<CallClass>& classes);
+
   ~LifoServiceQueue();
 
+  // Returns the maximum number of calls held by the queue, for all classes.
   size_t max_size() const {
     return max_queue_size_;
   }
 
+  // Returns the maximum number of calls of the class 'class_idx' held by the
+  // queue.
+  size_t max_size(size_t class_idx) const {
+    DCHECK_LT(class_idx, classes_.size());
+    return classes_[class_idx].max_size;
+  }
+
+  size_t num_classes() const {
+    return classes_.size();
+  }
+
   // Get an element from the queue.  Returns false if we were shut down prior to
   // getting the element.
   bool BlockingGet(std::unique_ptr<InboundCall>* out);
 
-  // Add a new call to the queue.
+  // Add a new call of the class 'class_idx' to the queue.
   // Returns:
   // - QUEUE_SHUTDOWN if Shutdown() has already been called.
-  // - QUEUE_FULL if the queue is full and 'call' has a later deadline than any
-  //   RPC already in the queue.
+  // - QUEUE_FULL if the class is full and 'call' has a later deadline than any
+  //   RPC of the class already in the queue.
   // - QUEUE_SUCCESS if 'call' was enqueued.
   //
   // In the case of a 'QUEUE_SUCCESS' response, the new element may have bumped
-  // another call out of the queue. In that case, *evicted will be set to the
-  // call that was bumped.
-  QueueStatus Put(InboundCall* call, std::optional<InboundCall*>* evicted);
+  // another call of the same class out of the queue. In that case, *evicted
+  // will be set to the call that was bumped.
+  QueueStatus Put(InboundCall* call, std::optional<InboundCall*>* evicted,
+                  size_t class_idx = 0);
 
   // Shut down the queue.
   // When a blocking queue is shut down, no more elements can be added to it,
@@ -106,6 +141,14 @@ class LifoServiceQueue final {
 
   std::string ToString() const;
 
+  // Return an estimate of the current queue length.
+  size_t estimated_queue_length() const {
+    ANNOTATE_IGNORE_READS_BEGIN();
+    auto ret = num_queued_;
+    ANNOTATE_IGNORE_READS_END();
+    return ret;
+  }
+
  private:
   FRIEND_TEST(TestServiceQueue, LifoServiceQueuePerf);
 
@@ -177,17 +220,26 @@ class LifoServiceQueue final {
     LifoServiceQueue* bound_queue_;
   };
 
-  // Return an estimate of the current queue length.
-  size_t estimated_queue_length() const {
-    ANNOTATE_IGNORE_READS_BEGIN();
-    // The C++ standard says that std::multiset::size must be constant time,
-    // so this method won't try to traverse any actual nodes of the underlying
-    // RB tree. Investigation of the libstdcxx implementation confirms that
-    // size() is a simple field access of the _Rb_tree structure.
-    auto ret = queue_.size();
-    ANNOTATE_IGNORE_READS_END();
-    return ret;
-  }
+  // The calls of a class queued while no consumer was available.
+  struct ClassQueue {
+    explicit ClassQueue(const CallClass& call_class)
+        : max_size(call_class.max_size),
+          weight(call_class.weight) {
+    }
+
+    size_t max_size;
+    int weight;
+
+    // The credit of the class in the weighted round-robin.
+    int64_t current_weight = 0;
+
+    std::multiset<InboundCall*, DeadlineLessStruct> calls;
+  };
+
+  // Returns the class whose call to dequeue next.
+  //
+  // REQUIRES: 'lock_' is held and at least one call is queued.
+  ClassQueue* NextClassUnlocked();
 
   // Return an estimate of the number of idle threads currently awaiting work.
   size_t estimated_idle_worker_count() const {
@@ -207,9 +259,12 @@ class LifoServiceQueue final {
   // Stack of consumer threads which are currently waiting for work.
   std::vector<ConsumerState*> waiting_consumers_;
 
-  // The actual queue. Work is only added to the queue when there were no
-  // consumers available for a "direct hand-off".
-  std::multiset<InboundCall*, DeadlineLessStruct> queue_;
+  // The actual queue, per class of calls. Work is only added to the queue
+  // when there were no consumers available for a "direct hand-off".
+  std::vector<ClassQueue> classes_;
+
+  // The number of calls in 'classes_'.
+  size_t num_queued_;
 
   // The total set of consumers who have ever accessed this queue.
   // This container is necessary to maintain proper lifecycle and ownership
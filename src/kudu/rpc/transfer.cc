@@ -18,6 +18,7 @@
 #include "kudu/rpc/transfer.h"
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <algorithm>
 #include <cstddef>
@@ -222,27 +223,41 @@ void OutboundTransfer::Abort(const Status& status) {
 Status OutboundTransfer::SendBuffer(Socket* socket) {
   CHECK_LT(cur_slice_idx_, payload_slices_.size());
 
-  started_ = true;
-  int n_iovecs = std::min<int>(payload_slices_.size() - cur_slice_idx_, IOV_MAX);
-  struct iovec iovec[n_iovecs];
-  {
-    int offset_in_slice = cur_offset_in_slice_;
-    for (int i = 0; i < n_iovecs; i++) {
-      auto& slice = payload_slices_[cur_slice_idx_ + i];
-      iovec[i].iov_base = slice.mutable_data() + offset_in_slice;
-      iovec[i].iov_len = slice.size() - offset_in_slice;
-
-      offset_in_slice = 0;
-    }
-  }
+  const int max_iovecs = std::min<int>(NumSlicesLeft(), IOV_MAX);
+  struct iovec iovec[max_iovecs];
+  const int n_iovecs = FillIovecs(iovec, max_iovecs);
 
   int64_t written;
   Status status = socket->Writev(iovec, n_iovecs, &written);
   RETURN_ON_ERROR_OR_SOCKET_NOT_READY(status);
 
+  const int64_t excess = AdvanceSent(written);
+  DCHECK_EQ(0, excess);
+  return Status::OK();
+}
+
+int OutboundTransfer::FillIovecs(struct ::iovec* iov, int max_iovecs) {
+  DCHECK_LT(cur_slice_idx_, payload_slices_.size());
+
+  started_ = true;
+  const int n_iovecs = std::min<int>(NumSlicesLeft(), max_iovecs);
+  int offset_in_slice = cur_offset_in_slice_;
+  for (int i = 0; i < n_iovecs; i++) {
+    auto& slice = payload_slices_[cur_slice_idx_ + i];
+    iov[i].iov_base = slice.mutable_data() + offset_in_slice;
+    iov[i].iov_len = slice.size() - offset_in_slice;
+
+    offset_in_slice = 0;
+  }
+  return n_iovecs;
+}
+
+int64_t OutboundTransfer::AdvanceSent(int64_t written) {
+  DCHECK(!TransferFinished());
+
   // Adjust our accounting of current writer position.
-  for (int i = cur_slice_idx_; i < payload_slices_.size(); i++) {
-    const auto& slice = payload_slices_[i];
+  while (cur_slice_idx_ < payload_slices_.size()) {
+    const auto& slice = payload_slices_[cur_slice_idx_];
     int rem_in_slice = slice.size() - cur_offset_in_slice_;
     DCHECK_GE(rem_in_slice, 0);
 
@@ -254,6 +269,7 @@ Status OutboundTransfer::SendBuffer(Socket* socket) {
     } else {
       // Partially used up this slice, just advance the offset within it.
       cur_offset_in_slice_ += written;
+      written = 0;
       break;
     }
   }
@@ -266,7 +282,7 @@ Status OutboundTransfer::SendBuffer(Socket* socket) {
     DCHECK_LT(cur_offset_in_slice_, payload_slices_[cur_slice_idx_].size());
   }
 
-  return Status::OK();
+  return written;
 }
 
 bool OutboundTransfer::TransferStarted() const {
@@ -34,6 +34,8 @@
 
 DECLARE_int64(rpc_max_message_size);
 
+struct iovec;
+
 namespace kudu {
 
 class Socket;
@@ -145,6 +147,25 @@ class OutboundTransfer : public boost::intrusive::list_base_hook<> {
   // send from our buffers into the sock
   Status SendBuffer(Socket* socket);
 
+  // Fills 'iov' with up to 'max_iovecs' iovecs covering the part of the
+  // payload not sent yet, returning the number of iovecs filled. The transfer
+  // is considered started from then on, even if none of these bytes end up
+  // being sent.
+  int FillIovecs(struct ::iovec* iov, int max_iovecs);
+
+  // Accounts for up to 'written' bytes of the part of the payload not sent yet
+  // as sent, triggering TransferCallbacks::NotifyTransferFinished once the
+  // whole payload was sent. Returns the number of bytes of 'written' past the
+  // end of the payload.
+  //
+  // REQUIRES: !TransferFinished()
+  int64_t AdvanceSent(int64_t written);
+
+  // Returns the number of slices of the payload not entirely sent yet.
+  size_t NumSlicesLeft() const {
+    return payload_slices_.size() - cur_slice_idx_;
+  }
+
   // Return true if any bytes have yet been sent.
   bool TransferStarted() const;
 
@@ -28,6 +28,7 @@
 #include <openssl/x509v3.h>
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -43,6 +44,7 @@
 
 #include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/security/ca/cert_management.h"
 #include "kudu/security/cert.h"
@@ -113,6 +115,9 @@ namespace security {
 template<> struct SslTypeTraits<SSL> {
   static constexpr auto kFreeFunc = &SSL_free;
 };
+template<> struct SslTypeTraits<SSL_SESSION> {
+  static constexpr auto kFreeFunc = &SSL_SESSION_free;
+};
 template<> struct SslTypeTraits<X509_STORE_CTX> {
   static constexpr auto kFreeFunc = &X509_STORE_CTX_free;
 };
@@ -140,6 +145,22 @@ Status CheckMaxSupportedTlsVersion(int tls_version, const char* tls_version_str)
   return Status::OK();
 }
 
+// The context of the resumed sessions. A server verifying the certificates of
+// its clients refuses to resume sessions without one.
+constexpr const char* const kSessionIdContext = "kudu";
+
+void FreeSessionKey(void* /*parent*/, void* ptr, CRYPTO_EX_DATA* /*ad*/,
+                    int /*idx*/, long /*argl*/, void* /*argp*/) { // NOLINT(*)
+  delete static_cast<string*>(ptr);
+}
+
+// Returns the index of the session key in the extra data of the SSL handles.
+int SessionKeyIndex() {
+  static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, &FreeSessionKey);
+  CHECK_GE(index, 0);
+  return index;
+}
+
 } // anonymous namespace
 
 TlsContext::TlsContext()
@@ -247,14 +268,21 @@ Status TlsContext::Init() {
 
   SSL_CTX_set_options(ctx, options);
 
-  // Disable the TLS session cache on both the client and server sides. In Kudu
-  // RPC, connections are not re-established based on TLS sessions anyway. Every
-  // connection attempt from a client to a server results in a new connection
-  // negotiation. Disabling the TLS session cache helps to avoid using extra
-  // resources to store TLS session information and running the automatic check
-  // for expired sessions every 255 connections, as mentioned at
+  // Disable the internal TLS session cache on both the client and server sides.
+  // Servers resume the sessions of the stateless tickets they issue, and the
+  // clients keep the sessions to resume in their own cache, by session key
+  // (see InitiateHandshake()): only the handshakes with a session key look
+  // their sessions up. Not using the internal cache also avoids running the
+  // automatic check for expired sessions every 255 connections, as mentioned at
   // https://www.openssl.org/docs/manmaster/man3/SSL_CTX_set_session_cache_mode.html
-  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  SSL_CTX_set_session_cache_mode(
+      ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE |
+           SSL_SESS_CACHE_NO_AUTO_CLEAR);
+  SSL_CTX_sess_set_new_cb(ctx, &TlsContext::NewSessionCallback);
+  SSL_CTX_set_app_data(ctx, this);
+  OPENSSL_RET_NOT_OK(SSL_CTX_set_session_id_context(
+      ctx, reinterpret_cast<const unsigned char*>(kSessionIdContext),
+      strlen(kSessionIdContext)), "failed to set TLS session id context");
 
   // The sequence of SSL_CTX_set_ciphersuites() and SSL_CTX_set_cipher_list()
   // calls below is essential to make sure the TLS engine ends up with usable,
@@ -382,6 +410,7 @@ Status TlsContext::UseCertificateAndKey(const Cert& cert, const PrivateKey& key)
   OPENSSL_RET_NOT_OK(SSL_CTX_use_certificate(ctx_.get(), cert.GetTopOfChainX509()),
                      "failed to use certificate");
   has_cert_ = true;
+  ClearSessions();
   return Status::OK();
 }
 
@@ -584,6 +613,7 @@ Status TlsContext::AdoptSignedCert(const Cert& cert) {
     << "certificate does not match the private key";
 
   csr_.reset();
+  ClearSessions();
 
   return Status::OK();
 }
@@ -622,7 +652,8 @@ Status TlsContext::LoadCertificateAuthority(const string& certificate_path) {
   return AddTrustedCertificate(c);
 }
 
-Status TlsContext::InitiateHandshake(TlsHandshake* handshake) const {
+Status TlsContext::InitiateHandshake(TlsHandshake* handshake,
+                                     const string& session_key) const {
   SCOPED_OPENSSL_NO_PENDING_ERRORS;
   DCHECK(handshake);
   CHECK(ctx_);
@@ -645,9 +676,47 @@ Status TlsContext::InitiateHandshake(TlsHandshake* handshake) const {
   // $OPENSSL_ROOT/CHANGES and https://github.com/openssl/openssl/issues/4739.
   ssl->s3->flags |= SSL3_FLAGS_NO_RENEGOTIATE_CIPHERS;
 #endif
+
+  if (!session_key.empty()) {
+    auto key = std::make_unique<string>(session_key);
+    OPENSSL_RET_NOT_OK(SSL_set_ex_data(ssl.get(), SessionKeyIndex(), key.get()),
+                       "failed to set TLS session key");
+    key.release();
+    std::lock_guard<simple_spinlock> l(sessions_lock_);
+    const auto* session = FindOrNull(sessions_, session_key);
+    if (session) {
+      // A session which can't be resumed results in a full handshake.
+      OPENSSL_RET_NOT_OK(SSL_set_session(ssl.get(), session->get()),
+                         "failed to set TLS session");
+    }
+  }
   return handshake->Init(std::move(ssl));
 }
 
+int TlsContext::NewSessionCallback(SSL* ssl, SSL_SESSION* session) {
+  const auto* key = static_cast<const string*>(SSL_get_ex_data(ssl, SessionKeyIndex()));
+  if (!key) {
+    return 0;
+  }
+  auto* context = static_cast<TlsContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  DCHECK(context);
+  std::lock_guard<simple_spinlock> l(context->sessions_lock_);
+  if (context->sessions_.size() >= kMaxCachedSessions &&
+      !ContainsKey(context->sessions_, *key)) {
+    // The sessions are cheap to re-establish: rather than tracking their
+    // recency, start over.
+    context->sessions_.clear();
+  }
+  // Taking over the reference of 'session'.
+  context->sessions_[*key] = ssl_make_unique(session);
+  return 1;
+}
+
+void TlsContext::ClearSessions() {
+  std::lock_guard<simple_spinlock> l(sessions_lock_);
+  sessions_.clear();
+}
+
 const char* TlsContext::GetEngineVersionInfo() const {
   CHECK(ctx_);
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
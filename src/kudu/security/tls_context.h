@@ -17,15 +17,19 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <optional>
 #include <shared_mutex>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include "kudu/gutil/port.h"
 #include "kudu/security/cert.h" // IWYU pragma: keep
+#include "kudu/util/locks.h"
 #include "kudu/util/openssl_util.h"
 #include "kudu/util/rw_mutex.h"
 #include "kudu/util/status.h"
@@ -170,7 +174,22 @@ class TlsContext {
   Status LoadCertificateAuthority(const std::string& certificate_path) WARN_UNUSED_RESULT;
 
   // Initiates a new TlsHandshake instance.
-  Status InitiateHandshake(TlsHandshake* handshake) const WARN_UNUSED_RESULT;
+  //
+  // A non-empty 'session_key' identifies the remote peer of a client
+  // handshake: the handshake offers to resume the TLS session last
+  // established under 'session_key', if any, and the sessions it establishes
+  // are cached under 'session_key' in turn. Resuming a session skips the
+  // exchange and the verification of the certificates, so the key must tell
+  // apart the peers and the verification modes of the handshakes.
+  Status InitiateHandshake(TlsHandshake* handshake,
+                           const std::string& session_key = "") const WARN_UNUSED_RESULT;
+
+  // Returns the number of client TLS sessions cached for resumption.
+  // Used by tests.
+  size_t num_cached_sessions_for_tests() const {
+    std::lock_guard<simple_spinlock> l(sessions_lock_);
+    return sessions_.size();
+  }
 
   // Return the number of certs that have been marked as trusted.
   // Used by tests.
@@ -188,9 +207,20 @@ class TlsContext {
   const char* GetEngineVersionInfo() const;
 
  private:
+  // The maximum number of client TLS sessions cached for resumption.
+  static constexpr size_t kMaxCachedSessions = 1024;
 
   Status VerifyCertChainUnlocked(const Cert& cert) WARN_UNUSED_RESULT;
 
+  // Called by OpenSSL when a client handshake initiated with a session key
+  // establishes a new session, possibly after the handshake in the case of
+  // TLSv1.3. Caches 'session' under the key of 'ssl'.
+  static int NewSessionCallback(SSL* ssl, SSL_SESSION* session);
+
+  // Drops the cached client TLS sessions, which were established with the
+  // previous certificate of the context.
+  void ClearSessions();
+
   // The cipher suite preferences to use for RPC connections secured with
   // pre-TLSv1.3 protocols. Uses the OpenSSL cipher preference list format.
   // See man (1) ciphers for more information.
@@ -223,6 +253,12 @@ class TlsContext {
   bool has_cert_;
   bool is_external_cert_;
   std::optional<CertSignRequest> csr_;
+
+  // Protects 'sessions_'.
+  mutable simple_spinlock sessions_lock_;
+
+  // The client TLS sessions to resume, by session key.
+  std::unordered_map<std::string, c_unique_ptr<SSL_SESSION>> sessions_;
 };
 
 } // namespace security
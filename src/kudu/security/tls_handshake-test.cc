@@ -95,10 +95,22 @@ class TestTlsHandshakeBase : public KuduTest {
   // verification modes are set to 'client_verify' and 'server_verify' respectively.
   Status RunHandshake(TlsVerificationMode client_verify,
                       TlsVerificationMode server_verify) {
+    return RunHandshake(client_tls_, server_tls_, client_verify, server_verify);
+  }
+
+  // Same as above, using 'client_tls' and 'server_tls'. The client handshake
+  // is initiated with 'session_key', and 'session_reused' is set to whether
+  // it resumed a previous session.
+  static Status RunHandshake(const TlsContext& client_tls,
+                             const TlsContext& server_tls,
+                             TlsVerificationMode client_verify,
+                             TlsVerificationMode server_verify,
+                             const string& session_key = "",
+                             bool* session_reused = nullptr) {
     TlsHandshake client(TlsHandshakeType::CLIENT);
-    RETURN_NOT_OK(client_tls_.InitiateHandshake(&client));
+    RETURN_NOT_OK(client_tls.InitiateHandshake(&client, session_key));
     TlsHandshake server(TlsHandshakeType::SERVER);
-    RETURN_NOT_OK(server_tls_.InitiateHandshake(&server));
+    RETURN_NOT_OK(server_tls.InitiateHandshake(&server));
 
     client.set_verification_mode(client_verify);
     server.set_verification_mode(server_verify);
@@ -128,6 +140,10 @@ class TestTlsHandshakeBase : public KuduTest {
         }
       }
     }
+    DCHECK_EQ(client.session_reused(), server.session_reused());
+    if (session_reused) {
+      *session_reused = client.session_reused();
+    }
     return Status::OK();
   }
 
@@ -240,6 +256,71 @@ TEST_P(TestTlsHandshakeConcurrent, TestConcurrentAdoptCert) {
   SleepFor(MonoDelta::FromMilliseconds(10));
 }
 
+// The client handshakes initiated with a session key resume the last session
+// established with that key.
+//
+// The test excludes TLSv1.3, whose session tickets are only received by the
+// client after the handshake, once reading from the socket.
+TEST_F(TestTlsHandshake, TestSessionResumption) {
+  static const vector<string> kTlsExcludedProtocols = { "TLSv1.3" };
+  TlsContext client_tls(SecurityDefaults::kDefaultTlsCiphers,
+                        SecurityDefaults::kDefaultTlsCipherSuites,
+                        SecurityDefaults::kDefaultTlsMinVersion,
+                        kTlsExcludedProtocols);
+  ASSERT_OK(client_tls.Init());
+  TlsContext server_tls(SecurityDefaults::kDefaultTlsCiphers,
+                        SecurityDefaults::kDefaultTlsCipherSuites,
+                        SecurityDefaults::kDefaultTlsMinVersion,
+                        kTlsExcludedProtocols);
+  ASSERT_OK(server_tls.Init());
+
+  PrivateKey ca_key;
+  Cert ca_cert;
+  ASSERT_OK(GenerateSelfSignedCAForTests(&ca_key, &ca_cert));
+  ASSERT_OK(ConfigureTlsContext(PkiConfig::SIGNED, ca_cert, ca_key, &client_tls));
+  ASSERT_OK(ConfigureTlsContext(PkiConfig::SIGNED, ca_cert, ca_key, &server_tls));
+
+  const auto run_handshake = [&](const TlsContext& server, const string& session_key,
+                                 bool* session_reused) {
+    return RunHandshake(client_tls, server,
+                        TlsVerificationMode::VERIFY_REMOTE_CERT_AND_HOST,
+                        TlsVerificationMode::VERIFY_REMOTE_CERT_AND_HOST,
+                        session_key, session_reused);
+  };
+
+  // The handshakes without a session key don't cache their sessions.
+  bool reused;
+  ASSERT_OK(run_handshake(server_tls, "", &reused));
+  ASSERT_FALSE(reused);
+  ASSERT_EQ(0, client_tls.num_cached_sessions_for_tests());
+
+  ASSERT_OK(run_handshake(server_tls, "a", &reused));
+  ASSERT_FALSE(reused);
+  ASSERT_EQ(1, client_tls.num_cached_sessions_for_tests());
+  for (int i = 0; i < 3; i++) {
+    ASSERT_OK(run_handshake(server_tls, "a", &reused));
+    ASSERT_TRUE(reused);
+  }
+
+  // The sessions of the other keys aren't resumed.
+  ASSERT_OK(run_handshake(server_tls, "b", &reused));
+  ASSERT_FALSE(reused);
+  ASSERT_EQ(2, client_tls.num_cached_sessions_for_tests());
+
+  // A server with other ticket keys runs a full handshake, and the client
+  // caches the new session.
+  TlsContext other_server_tls(SecurityDefaults::kDefaultTlsCiphers,
+                              SecurityDefaults::kDefaultTlsCipherSuites,
+                              SecurityDefaults::kDefaultTlsMinVersion,
+                              kTlsExcludedProtocols);
+  ASSERT_OK(other_server_tls.Init());
+  ASSERT_OK(ConfigureTlsContext(PkiConfig::SIGNED, ca_cert, ca_key, &other_server_tls));
+  ASSERT_OK(run_handshake(other_server_tls, "a", &reused));
+  ASSERT_FALSE(reused);
+  ASSERT_OK(run_handshake(other_server_tls, "a", &reused));
+  ASSERT_TRUE(reused);
+}
+
 TEST_F(TestTlsHandshake, HandshakeSequenceNoTLSv1dot3) {
   static const vector<string> kTlsExcludedProtocols = { "TLSv1.3" };
 
@@ -164,6 +164,7 @@ Status TlsHandshake::Continue(const string& recv, string* send) {
   if (rc == 1) {
     // SSL_do_handshake() must have read all the pending data.
     DCHECK_EQ(0, BIO_ctrl_pending(rbio));
+    session_reused_ = SSL_session_reused(ssl);
     VLOG(2) << Substitute("TLS Handshake complete");
     return Status::OK();
   }
@@ -153,6 +153,12 @@ class TlsHandshake {
   // Only valid to call after the handshake is complete and before 'Finish()'.
   std::string GetCipherDescription() const;
 
+  // Whether the handshake resumed a previous TLS session rather than running
+  // a full handshake. Only valid to call after the handshake is complete.
+  bool session_reused() const {
+    return session_reused_;
+  }
+
  private:
   FRIEND_TEST(TestTlsHandshake, HandshakeSequenceNoTLSv1dot3);
   FRIEND_TEST(TestTlsHandshake, HandshakeSequenceTLSv1dot3);
@@ -177,6 +183,7 @@ class TlsHandshake {
   c_unique_ptr<SSL> ssl_;
 
   bool has_started_ = false;
+  bool session_reused_ = false;
   TlsVerificationMode verification_mode_ = TlsVerificationMode::VERIFY_REMOTE_CERT_AND_HOST;
 
   Cert local_cert_;
@@ -24,6 +24,7 @@
 #include <fstream>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
@@ -89,7 +90,7 @@ DEFINE_string(metrics_default_level, "debug",
               "Valid choices are 'debug', 'info', and 'warn'. "
               "The levels are ordered and lower levels include the levels above them. "
               "This value can be overridden by passing the level query parameter to the "
-              "'/metrics' endpoint.");
+              "'/metrics' and '/metrics_prometheus' endpoints.");
 TAG_FLAG(metrics_default_level, advanced);
 TAG_FLAG(metrics_default_level, runtime);
 TAG_FLAG(metrics_default_level, evolving);
@@ -105,6 +106,25 @@ DEFINE_validator(metrics_default_level, [](const char* flag_name, const string&
   return false;
 });
 
+DEFINE_int32(metrics_render_cache_ms, 0,
+             "If positive, the responses of the '/metrics' and '/metrics_prometheus' "
+             "endpoints are reused by the requests with the same query string within "
+             "this many milliseconds of their rendering, and the concurrent requests "
+             "wait for the rendering in progress rather than rendering the metrics "
+             "again. This bounds the cost of the scrapes of several monitoring agents "
+             "on the servers with many metric entities, at the price of metrics as "
+             "stale as the interval. The requests for the metrics modified since an "
+             "epoch ('since_epoch' parameter) are never cached.");
+TAG_FLAG(metrics_render_cache_ms, advanced);
+TAG_FLAG(metrics_render_cache_ms, runtime);
+DEFINE_validator(metrics_render_cache_ms, [](const char* flag_name, int32_t value) {
+  if (value >= 0) {
+    return true;
+  }
+  LOG(ERROR) << Substitute("--$0 must not be negative: $1", flag_name, value);
+  return false;
+});
+
 // For configuration dashboard
 DECLARE_bool(webserver_require_spnego);
 DECLARE_string(redact);
@@ -480,6 +500,65 @@ static vector<string> ParseArray(const Webserver::ArgumentMap& args, const strin
   return value;
 }
 
+namespace {
+
+// The responses of a metrics endpoint by query string, reused by the requests
+// within --metrics_render_cache_ms of their rendering.
+class RenderedMetricsCache {
+ public:
+  typedef std::function<void(Webserver::PrerenderedWebResponse*)> RenderCallback;
+
+  // Renders the response to 'req' into 'resp' with 'render', unless the
+  // response to a request with the same query string was rendered within the
+  // last --metrics_render_cache_ms.
+  void Render(const Webserver::WebRequest& req,
+              Webserver::PrerenderedWebResponse* resp,
+              const RenderCallback& render) {
+    const int32_t interval_ms = FLAGS_metrics_render_cache_ms;
+    if (interval_ms <= 0) {
+      render(resp);
+      return;
+    }
+
+    // Rendering under the lock lets the concurrent requests reuse the response
+    // rather than rendering the metrics again.
+    std::lock_guard<std::mutex> l(lock_);
+    const MonoTime now = MonoTime::Now();
+    const MonoTime expired = now - MonoDelta::FromMilliseconds(interval_ms);
+    for (auto it = responses_.begin(); it != responses_.end();) {
+      if (it->second.rendered < expired) {
+        it = responses_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    const auto* cached = FindOrNull(responses_, req.query_string);
+    if (cached) {
+      resp->status_code = cached->status_code;
+      resp->response_headers = cached->response_headers;
+      resp->output << cached->output;
+      return;
+    }
+    render(resp);
+    responses_.emplace(req.query_string, Response{ now, resp->status_code,
+                                                   resp->response_headers,
+                                                   resp->output.str() });
+  }
+
+ private:
+  struct Response {
+    MonoTime rendered;
+    HttpStatusCode status_code;
+    Webserver::ArgumentMap response_headers;
+    string output;
+  };
+
+  std::mutex lock_;
+  std::unordered_map<string, Response> responses_;
+};
+
+} // anonymous namespace
+
 static void WriteMetricsAsJson(const MetricRegistry* const metrics,
                                const Webserver::WebRequest& req,
                                Webserver::PrerenderedWebResponse* resp) {
@@ -505,6 +584,26 @@ static void WriteMetricsAsJson(const MetricRegistry* const metrics,
     }
   }
 
+  // With 'since_epoch', only the metrics modified in or after that epoch are
+  // written, and the epoch to pass to get the metrics modified after this
+  // request is returned in the X-Kudu-Metrics-Epoch header. The scrapes in
+  // this mode start with 'since_epoch=0', which writes all the metrics.
+  const string* since_epoch = FindOrNull(req.parsed_args, "since_epoch");
+  if (since_epoch) {
+    int64_t epoch;
+    if (!safe_strto64(*since_epoch, &epoch) || epoch < 0) {
+      resp->status_code = HttpStatusCode::BadRequest;
+      WARN_NOT_OK(Status::InvalidArgument(""), "The parameter of 'since_epoch' is wrong");
+      return;
+    }
+    opts.only_modified_in_or_after_epoch = epoch;
+    // The metrics modified from now on are stamped with the next epoch or a
+    // later one, if other requests advance the epoch concurrently.
+    const int64_t next_epoch = Metric::current_epoch() + 1;
+    Metric::IncrementEpoch();
+    resp->response_headers["X-Kudu-Metrics-Epoch"] = std::to_string(next_epoch);
+  }
+
   JsonWriter::Mode json_mode = ParseBool(req.parsed_args, "compact") ?
       JsonWriter::COMPACT : JsonWriter::PRETTY;
 
@@ -520,16 +619,27 @@ static void WriteMetricsAsJson(const MetricRegistry* const metrics,
 }
 
 static void WriteMetricsAsPrometheus(const MetricRegistry* const metrics,
-                                     const Webserver::WebRequest& /*req*/,
+                                     const Webserver::WebRequest& req,
                                      Webserver::PrerenderedWebResponse* resp) {
+  MetricFilters filters;
+  filters.entity_metrics = ParseArray(req.parsed_args, "metrics");
+  filters.entity_level = FindWithDefault(req.parsed_args, "level", FLAGS_metrics_default_level);
   PrometheusWriter writer(&resp->output);
-  WARN_NOT_OK(metrics->WriteAsPrometheus(&writer), "Couldn't write Prometheus metrics over HTTP");
+  WARN_NOT_OK(metrics->WriteAsPrometheus(&writer, filters),
+              "Couldn't write Prometheus metrics over HTTP");
 }
 
 void RegisterMetricsJsonHandler(Webserver* webserver, const MetricRegistry* const metrics) {
-  auto callback = [metrics](const Webserver::WebRequest& req,
-                            Webserver::PrerenderedWebResponse* resp) {
-    WriteMetricsAsJson(metrics, req, resp);
+  auto cache = std::make_shared<RenderedMetricsCache>();
+  auto callback = [metrics, cache](const Webserver::WebRequest& req,
+                                   Webserver::PrerenderedWebResponse* resp) {
+    if (ContainsKey(req.parsed_args, "since_epoch")) {
+      WriteMetricsAsJson(metrics, req, resp);
+      return;
+    }
+    cache->Render(req, resp, [&](Webserver::PrerenderedWebResponse* out) {
+      WriteMetricsAsJson(metrics, req, out);
+    });
   };
   bool not_styled = false;
   bool not_on_nav_bar = false;
@@ -544,9 +654,12 @@ void RegisterMetricsJsonHandler(Webserver* webserver, const MetricRegistry* cons
 }
 
 void RegisterMetricsPrometheusHandler(Webserver* webserver, const MetricRegistry* const metrics) {
-  auto callback = [metrics](const Webserver::WebRequest& req,
-                            Webserver::PrerenderedWebResponse* resp) {
-    WriteMetricsAsPrometheus(metrics, req, resp);
+  auto cache = std::make_shared<RenderedMetricsCache>();
+  auto callback = [metrics, cache](const Webserver::WebRequest& req,
+                                   Webserver::PrerenderedWebResponse* resp) {
+    cache->Render(req, resp, [&](Webserver::PrerenderedWebResponse* out) {
+      WriteMetricsAsPrometheus(metrics, req, out);
+    });
   };
   constexpr bool not_styled = false;
   constexpr bool is_on_nav_bar = true;
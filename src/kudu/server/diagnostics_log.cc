@@ -137,6 +137,11 @@ void DiagnosticsLog::DumpStacksNow(std::string reason) {
 }
 
 
+void DiagnosticsLog::AddRecordSource(string type, RecordFunc func) {
+  std::lock_guard l(lock_);
+  record_sources_.emplace_back(std::move(type), std::move(func));
+}
+
 Status DiagnosticsLog::Start() {
   unique_ptr<RollingLog> l(new RollingLog(Env::Default(), log_dir_, program_name_, "diagnostics"));
   RETURN_NOT_OK_PREPEND(l->Open(), "unable to open diagnostics log");
@@ -348,6 +353,19 @@ Status DiagnosticsLog::LogMetrics() {
   RETURN_NOT_OK(metric_registry_->WriteAsJson(&writer, opts));
   buf << "\n";
 
+  vector<pair<string, RecordFunc>> record_sources;
+  {
+    std::lock_guard l(lock_);
+    record_sources = record_sources_;
+  }
+  for (const auto& source : record_sources) {
+    buf << "I" << FormatTimestampForLog(now)
+        << " " << source.first << " " << now << " ";
+    JsonWriter record_writer(&buf, JsonWriter::COMPACT);
+    source.second(&record_writer);
+    buf << "\n";
+  }
+
   RETURN_NOT_OK(log_->Append(buf.str()));
 
   // Next time we fetch, only show those that changed after the epoch
@@ -17,9 +17,12 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <optional>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -29,6 +32,7 @@
 
 namespace kudu {
 
+class JsonWriter;
 class MetricRegistry;
 class RollingLog;
 class Thread;
@@ -52,6 +56,13 @@ class DiagnosticsLog {
   // this is suitable for running in a performance-sensitive context.
   void DumpStacksNow(std::string reason);
 
+  // Writes a JSON value describing some state of the server.
+  typedef std::function<void(JsonWriter*)> RecordFunc;
+
+  // Adds a record of type 'type', written by 'func', to the log along with
+  // each dump of the metrics. 'func' must stay valid until Stop() is called.
+  void AddRecordSource(std::string type, RecordFunc func);
+
  private:
   class SymbolSet;
 
@@ -82,6 +93,10 @@ class DiagnosticsLog {
   // Protected by 'lock_'.
   std::optional<std::string> dump_stacks_now_reason_;
 
+  // The types and functions of the records logged with the metrics.
+  // Protected by 'lock_'.
+  std::vector<std::pair<std::string, RecordFunc>> record_sources_;
+
   MonoDelta metrics_log_interval_;
 
   int64_t metrics_epoch_ = 0;
@@ -44,6 +44,7 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/sysinfo.h"
 #include "kudu/server/webserver.h"
+#include "kudu/util/cpu_profiler.h"
 #include "kudu/util/env.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/monotime.h"
@@ -199,6 +200,27 @@ static void PprofContentionHandler(const Webserver::WebRequest& req,
 #endif // defined(__linux__)
 }
 
+// Continuous CPU profiling, see --continuous_cpu_profiling_frequency_hz.
+// The samples are output in the "collapsed stacks" format, which can be
+// rendered with e.g. 'flamegraph.pl'. With 'reset=true', the samples are
+// cleared once output, so that each request only gets the samples collected
+// since the previous one.
+static void PprofContinuousCpuHandler(const Webserver::WebRequest& req,
+                                      Webserver::PrerenderedWebResponse* resp) {
+  if (!IsContinuousCpuProfilingEnabled()) {
+    resp->output << "# continuous CPU profiling is disabled, see "
+                    "--continuous_cpu_profiling_frequency_hz" << endl;
+  }
+  const bool reset = FindWithDefault(req.parsed_args, "reset", "") == "true";
+  int64_t dropped_samples = 0;
+  ostringstream profile;
+  DumpContinuousCpuProfile(reset, &profile, &dropped_samples);
+  if (dropped_samples > 0) {
+    LOG(WARNING) << strings::Substitute(
+        "continuous CPU profile dropped $0 samples", dropped_samples);
+  }
+  resp->output << profile.str();
+}
 
 // pprof asks for the url /pprof/symbol to map from hex addresses to variable names.
 // When the server receives a GET request for /pprof/symbol, it should return a line
@@ -266,6 +288,8 @@ void AddPprofPathHandlers(Webserver* webserver) {
   webserver->RegisterPrerenderedPathHandler("/pprof/symbol", "", PprofSymbolHandler, false, false);
   webserver->RegisterPrerenderedPathHandler("/pprof/contention", "", PprofContentionHandler,
                                             false, false);
+  webserver->RegisterPrerenderedPathHandler("/pprof/continuous_cpu", "",
+                                            PprofContinuousCpuHandler, false, false);
 }
 
 } // namespace kudu
@@ -90,6 +90,19 @@ DEFINE_int32(rpc_num_acceptors_per_address, 1,
              "Number of RPC acceptor threads for each bound address");
 TAG_FLAG(rpc_num_acceptors_per_address, advanced);
 
+DEFINE_int32(rpc_num_acceptor_shards_per_address, 1,
+             "Number of listening sockets for each bound TCP address. If greater "
+             "than 1, the sockets are bound to the same address with SO_REUSEPORT "
+             "and the kernel balances the incoming connections across them. Each "
+             "socket has its own --rpc_num_acceptors_per_address acceptor threads "
+             "and hands the connections it accepts to a reactor thread of its own, "
+             "which helps riding over bursts of new inbound connections. If 0, "
+             "there is a socket per reactor thread.");
+TAG_FLAG(rpc_num_acceptor_shards_per_address, advanced);
+TAG_FLAG(rpc_num_acceptor_shards_per_address, experimental);
+DEFINE_validator(rpc_num_acceptor_shards_per_address,
+                 [](const char* /* flagname */, int32_t value) { return value >= 0; });
+
 DEFINE_int32(rpc_num_service_threads, 10,
              "Number of RPC worker threads to run");
 TAG_FLAG(rpc_num_service_threads, advanced);
@@ -134,6 +147,7 @@ RpcServerOptions::RpcServerOptions()
       rpc_proxied_addresses(FLAGS_rpc_proxied_addresses),
       rpc_proxy_advertised_addresses(FLAGS_rpc_proxy_advertised_addresses),
       num_acceptors_per_address(FLAGS_rpc_num_acceptors_per_address),
+      num_acceptor_shards_per_address(FLAGS_rpc_num_acceptor_shards_per_address),
       num_service_threads(FLAGS_rpc_num_service_threads),
       default_port(0),
       service_queue_length(FLAGS_rpc_service_queue_length),
@@ -53,6 +53,7 @@ struct RpcServerOptions {
   std::string rpc_proxy_advertised_addresses;
 
   uint32_t num_acceptors_per_address;
+  uint32_t num_acceptor_shards_per_address;
   uint32_t num_service_threads;
   uint16_t default_port;
   size_t service_queue_length;
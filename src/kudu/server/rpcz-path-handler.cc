@@ -17,6 +17,8 @@
 
 #include "kudu/server/rpcz-path-handler.h"
 
+#include <cinttypes>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <sstream>
@@ -24,8 +26,10 @@
 #include <unordered_map>
 
 #include "kudu/gutil/map-util.h"
+#include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/numbers.h"
 #include "kudu/rpc/messenger.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/rpc_introspection.pb.h"
 #include "kudu/rpc/rpcz_store.h"
 #include "kudu/server/webserver.h"
@@ -37,6 +41,8 @@ using kudu::rpc::DumpConnectionsResponsePB;
 using kudu::rpc::DumpRpczStoreRequestPB;
 using kudu::rpc::DumpRpczStoreResponsePB;
 using kudu::rpc::Messenger;
+using kudu::rpc::RpczSamplePB;
+using kudu::rpc::TraceSpanPB;
 using std::ostringstream;
 using std::shared_ptr;
 using std::string;
@@ -45,9 +51,125 @@ namespace kudu {
 
 namespace {
 
+// The span kinds of the OpenTelemetry protocol.
+const int kOtlpSpanKindInternal = 1;
+const int kOtlpSpanKindServer = 2;
+
+void OtlpStringAttribute(const string& key, const string& value, JsonWriter* writer) {
+  writer->StartObject();
+  writer->String("key");
+  writer->String(key);
+  writer->String("value");
+  writer->StartObject();
+  writer->String("stringValue");
+  writer->String(value);
+  writer->EndObject();
+  writer->EndObject();
+}
+
+void OtlpSpan(const string& trace_id,
+              int index,
+              const TraceSpanPB& span,
+              const RpczSamplePB& sample,
+              JsonWriter* writer) {
+  // The span identifiers only need to be unique within their trace.
+  const auto span_id = [](int idx) { return StringPrintf("%016x", idx + 1); };
+  const int64_t end_micros = span.start_unix_micros() +
+      (span.has_duration_micros() ? span.duration_micros() : 0);
+
+  writer->StartObject();
+  writer->String("traceId");
+  writer->String(trace_id);
+  writer->String("spanId");
+  writer->String(span_id(index));
+  if (span.has_parent()) {
+    writer->String("parentSpanId");
+    writer->String(span_id(span.parent()));
+  }
+  writer->String("name");
+  writer->String(span.has_parent() ? span.name()
+                                   : sample.header().remote_method().method_name());
+  writer->String("kind");
+  writer->Int(span.has_parent() ? kOtlpSpanKindInternal : kOtlpSpanKindServer);
+  writer->String("startTimeUnixNano");
+  writer->String(std::to_string(span.start_unix_micros() * 1000));
+  writer->String("endTimeUnixNano");
+  writer->String(std::to_string(end_micros * 1000));
+  writer->String("attributes");
+  writer->StartArray();
+  if (!span.has_parent()) {
+    OtlpStringAttribute("rpc.system", "kudu", writer);
+    OtlpStringAttribute("rpc.service", sample.header().remote_method().service_name(), writer);
+    OtlpStringAttribute("rpc.method", sample.header().remote_method().method_name(), writer);
+  }
+  if (span.has_child_path()) {
+    OtlpStringAttribute("kudu.trace.child_path", span.child_path(), writer);
+  }
+  writer->EndArray();
+  writer->EndObject();
+}
+
+// Writes the sampled RPCs in 'sampled_rpcs' as OTLP/JSON, the format of the
+// OpenTelemetry protocol over HTTP, one trace per sampled call.
+void SampledRpcsToOtlp(const DumpRpczStoreResponsePB& sampled_rpcs, JsonWriter* writer) {
+  writer->StartObject();
+  writer->String("resourceSpans");
+  writer->StartArray();
+  writer->StartObject();
+  writer->String("resource");
+  writer->StartObject();
+  writer->String("attributes");
+  writer->StartArray();
+  OtlpStringAttribute("service.name", "kudu", writer);
+  writer->EndArray();
+  writer->EndObject();
+  writer->String("scopeSpans");
+  writer->StartArray();
+  writer->StartObject();
+  writer->String("scope");
+  writer->StartObject();
+  writer->String("name");
+  writer->String("kudu.rpcz");
+  writer->EndObject();
+  writer->String("spans");
+  writer->StartArray();
+  for (int m = 0; m < sampled_rpcs.methods_size(); m++) {
+    const auto& method = sampled_rpcs.methods(m);
+    for (int s = 0; s < method.samples_size(); s++) {
+      const auto& sample = method.samples(s);
+      // The samples are only kept for a little while, so the start time of
+      // the call and its position in the dump make a unique trace identifier.
+      const string trace_id = StringPrintf("%016" PRIx64 "%08x%08x",
+                                           sample.start_unix_micros(), m, s);
+      for (int i = 0; i < sample.spans_size(); i++) {
+        OtlpSpan(trace_id, i, sample.spans(i), sample, writer);
+      }
+    }
+  }
+  writer->EndArray();
+  writer->EndObject();
+  writer->EndArray();
+  writer->EndObject();
+  writer->EndArray();
+  writer->EndObject();
+}
+
 void RpczPathHandler(const shared_ptr<Messenger>& messenger,
                      const Webserver::WebRequest& req,
                      Webserver::PrerenderedWebResponse* resp) {
+  DumpRpczStoreResponsePB sampled_rpcs;
+  {
+    DumpRpczStoreRequestPB dump_req;
+    messenger->rpcz_store()->DumpPB(dump_req, &sampled_rpcs);
+  }
+
+  JsonWriter writer(&resp->output, JsonWriter::PRETTY);
+  if (FindWithDefault(req.parsed_args, "format", "") == "otlp") {
+    // Only the sampled RPCs are exported: the running ones have no spans yet.
+    SampledRpcsToOtlp(sampled_rpcs, &writer);
+    return;
+  }
+
   DumpConnectionsResponsePB running_rpcs;
   {
     DumpConnectionsRequestPB dump_req;
@@ -57,13 +179,7 @@ void RpczPathHandler(const shared_ptr<Messenger>& messenger,
 
     messenger->DumpConnections(dump_req, &running_rpcs);
   }
-  DumpRpczStoreResponsePB sampled_rpcs;
-  {
-    DumpRpczStoreRequestPB dump_req;
-    messenger->rpcz_store()->DumpPB(dump_req, &sampled_rpcs);
-  }
 
-  JsonWriter writer(&resp->output, JsonWriter::PRETTY);
   writer.StartObject();
   writer.String("running");
   writer.Protobuf(running_rpcs);
@@ -80,6 +80,7 @@
 #include "kudu/util/atomic.h"
 #include "kudu/util/cloud/instance_detector.h"
 #include "kudu/util/cloud/instance_metadata.h"
+#include "kudu/util/cpu_profiler.h"
 #include "kudu/util/env.h"
 #include "kudu/util/errno.h"  // IWYU pragma: keep
 #include "kudu/util/faststring.h"
@@ -319,6 +320,15 @@ DEFINE_uint64(tcmalloc_max_total_thread_cache_bytes, 128 * 1024 * 1024,
 TAG_FLAG(tcmalloc_max_total_thread_cache_bytes, advanced);
 TAG_FLAG(tcmalloc_max_total_thread_cache_bytes, experimental);
 
+DEFINE_int32(continuous_cpu_profiling_frequency_hz, 0,
+             "If greater than 0, the server continuously samples the stacks of its "
+             "threads this many times per second of CPU time, tagging the samples "
+             "with the tablet the threads work on, and exposes them in the "
+             "flame graph format at /pprof/continuous_cpu. The samples of each "
+             "thread are aggregated by stack, so a low frequency such as 19Hz "
+             "keeps the overhead negligible. Only supported on Linux.");
+TAG_FLAG(continuous_cpu_profiling_frequency_hz, experimental);
+
 DECLARE_bool(use_hybrid_clock);
 DECLARE_int32(dns_resolver_max_threads_num);
 DECLARE_uint32(dns_resolver_cache_capacity_mb);
@@ -449,6 +459,17 @@ bool ValidateWallClockJumpThreshold(const char* name, uint32_t value) {
 }
 DEFINE_validator(wall_clock_jump_threshold_sec, &ValidateWallClockJumpThreshold);
 
+bool ValidateContinuousCpuProfilingFrequency(const char* name, int32_t value) {
+  if (value < 0 || value > 1000) {
+    LOG(ERROR) << Substitute("--$0 must be within 0 and 1000, value $1 is invalid",
+                             name, value);
+    return false;
+  }
+  return true;
+}
+DEFINE_validator(continuous_cpu_profiling_frequency_hz,
+                 &ValidateContinuousCpuProfilingFrequency);
+
 bool ValidateTlsProtocol(const char* /*flagname*/, const string& value) {
   return IsValidTlsProtocolStr(value);
 }
@@ -956,6 +977,7 @@ Status ServerBase::Init() {
   if (options_.rpc_opts.rpc_reuseport) {
     builder.set_reuseport();
   }
+  builder.set_num_acceptor_shards(options_.rpc_opts.num_acceptor_shards_per_address);
 
   if (!FLAGS_keytab_file.empty()) {
     string service_name;
@@ -1328,6 +1350,14 @@ Status ServerBase::Start() {
 #ifdef TCMALLOC_ENABLED
   RETURN_NOT_OK(StartTcmallocMemoryGcThread());
 #endif
+  if (FLAGS_continuous_cpu_profiling_frequency_hz > 0) {
+    // The profiler is process-wide: it may have been started by another
+    // server of the same process, e.g. in tests.
+    Status s = StartContinuousCpuProfiling(FLAGS_continuous_cpu_profiling_frequency_hz);
+    if (!s.ok() && !s.IsAlreadyPresent()) {
+      LOG(WARNING) << "Unable to start continuous CPU profiling: " << s.ToString();
+    }
+  }
   Timer* start_rpc_server = startup_path_handler_->start_rpc_server_progress();
   start_rpc_server->Start();
   RETURN_NOT_OK(rpc_server_->Start());
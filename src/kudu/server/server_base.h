@@ -116,6 +116,10 @@ class ServerBase {
 
   FileCache* file_cache() const { return file_cache_.get(); }
 
+  // Returns the diagnostics log of the server, or nullptr if it doesn't keep
+  // one. Set once the server is started.
+  DiagnosticsLog* diagnostics_log() const { return diag_log_.get(); }
+
   // Return a PB describing the status of the server (version info, bound ports, etc)
   Status GetStatusPB(ServerStatusPB* status) const;
 
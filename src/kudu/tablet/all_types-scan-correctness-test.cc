@@ -722,16 +722,21 @@ struct KeyTypeWrapper {
 typedef ::testing::Types<NumTypeRowOps<KeyTypeWrapper<INT8, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT8, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT8, RLE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT8, FRAME_OF_REFERENCE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT16, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT16, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT16, RLE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT16, FRAME_OF_REFERENCE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT32, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT32, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT32, RLE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT32, FRAME_OF_REFERENCE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT32, ADAPTIVE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT64, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT64, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT64, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT64, RLE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT64, FRAME_OF_REFERENCE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT128, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT128, PLAIN_ENCODING>>,
                          // TODO: Uncomment when adding 128 bit support to RLE (KUDU-2284)
@@ -740,12 +745,16 @@ typedef ::testing::Types<NumTypeRowOps<KeyTypeWrapper<INT8, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<FLOAT, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<DOUBLE, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<DOUBLE, PLAIN_ENCODING>>,
+                         NumTypeRowOps<KeyTypeWrapper<DOUBLE, ADAPTIVE>>,
                          SliceTypeRowOps<KeyTypeWrapper<STRING, DICT_ENCODING>>,
                          SliceTypeRowOps<KeyTypeWrapper<STRING, PLAIN_ENCODING>>,
                          SliceTypeRowOps<KeyTypeWrapper<STRING, PREFIX_ENCODING>>,
+                         SliceTypeRowOps<KeyTypeWrapper<STRING, FSST>>,
+                         SliceTypeRowOps<KeyTypeWrapper<STRING, ADAPTIVE>>,
                          SliceTypeRowOps<KeyTypeWrapper<BINARY, DICT_ENCODING>>,
                          SliceTypeRowOps<KeyTypeWrapper<BINARY, PLAIN_ENCODING>>,
-                         SliceTypeRowOps<KeyTypeWrapper<BINARY, PREFIX_ENCODING>>
+                         SliceTypeRowOps<KeyTypeWrapper<BINARY, PREFIX_ENCODING>>,
+                         SliceTypeRowOps<KeyTypeWrapper<BINARY, FSST>>
                          > KeyTypes;
 
 TYPED_TEST_SUITE(AllTypesScanCorrectnessTest, KeyTypes);
@@ -22,6 +22,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <random>
 #include <string>
 #include <thread>
 #include <unordered_set>
@@ -45,6 +46,7 @@
 #include "kudu/util/memory/overwrite.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
 using std::string;
@@ -120,6 +122,9 @@ TEST_F(TestCBTree, TestNodeSizes) {
   InternalNode<BTreeTraits> inode(Slice("split"), &lnode, &lnode, &arena);
   ASSERT_LE(sizeof(inode), BTreeTraits::kInternalNodeSize);
 
+  LeafNode<PrefixTraits> prefix_lnode(false);
+  ASSERT_LE(sizeof(prefix_lnode), PrefixTraits::kLeafNodeSize);
+
 }
 
 TEST_F(TestCBTree, TestLeafNode) {
@@ -198,6 +203,15 @@ struct RacyTraits : public SmallFanoutTraits {
   static const size_t kDebugRaciness = 100;
 };
 
+// Keeps the prefixes of the keys in the leaves, as the MemRowSet does.
+struct PrefixSmallFanoutTraits : public SmallFanoutTraits {
+  static const size_t kInlineKeyPrefixes = 1;
+};
+
+struct PrefixTraits : public BTreeTraits {
+  static const size_t kInlineKeyPrefixes = 1;
+};
+
 void MakeKey(char *kbuf, size_t len, int i) {
   snprintf(kbuf, len, "key_%d%d", i % 10, i / 10);
 }
@@ -368,6 +382,132 @@ TEST_F(TestCBTree, TestInsertAndVerifyRandom) {
   }
 }
 
+// Keys inserted in increasing order, as in append-mostly workloads, fill the
+// leaves rather than leaving them half-empty after each split.
+TEST_F(TestCBTree, TestSequentialInsertFillsLeaves) {
+  constexpr int kNumKeys = 100000;
+  vector<int> order(kNumKeys);
+  for (int i = 0; i < kNumKeys; i++) {
+    order[i] = i;
+  }
+  CBTree<BTreeTraits> sequential;
+  CBTree<BTreeTraits> shuffled;
+  auto insert = [](CBTree<BTreeTraits>* tree, const vector<int>& keys) {
+    char kbuf[64];
+    for (int i : keys) {
+      snprintf(kbuf, sizeof(kbuf), "key_%08d", i);
+      ASSERT_TRUE(tree->Insert(Slice(kbuf), Slice("v")));
+    }
+  };
+  NO_FATALS(insert(&sequential, order));
+  std::mt19937 gen(SeedRandom());
+  std::shuffle(order.begin(), order.end(), gen);
+  NO_FATALS(insert(&shuffled, order));
+
+  ASSERT_EQ(kNumKeys, sequential.count());
+  for (int i = 0; i < kNumKeys; i += 997) {
+    char kbuf[64];
+    snprintf(kbuf, sizeof(kbuf), "key_%08d", i);
+    NO_FATALS(VerifyGet(sequential, Slice(kbuf), Slice("v")));
+  }
+  // Randomly inserted keys leave the leaves about 70% full on average.
+  ASSERT_LT(sequential.estimate_memory_usage(), shuffled.estimate_memory_usage());
+}
+
+// Keys which only differ after their first 8 bytes, or which are shorter
+// than 8 bytes or end with zeros, are ordered the same with the prefixes of
+// the keys kept in the leaves.
+TEST_F(TestCBTree, TestInlineKeyPrefixes) {
+  vector<string> keys = { "", string(1, '\0'), "a", string("a\0", 2), string("a\0\0", 3),
+                          "abcdefg", string("abcdefg\0", 8), string("abcdefg\0\0", 9),
+                          "abcdefgh", string("abcdefgh\0", 9), "abcdefgi", "\xff\xff" };
+  for (int i = 0; i < 1000; i++) {
+    keys.emplace_back(Substitute("abcdefgh_$0", i));
+    keys.emplace_back(Substitute("k$0", i));
+  }
+  std::mt19937 gen(SeedRandom());
+  std::shuffle(keys.begin(), keys.end(), gen);
+
+  CBTree<PrefixSmallFanoutTraits> t;
+  for (const auto& key : keys) {
+    ASSERT_TRUE(t.Insert(Slice(key), Slice(key)));
+  }
+  for (const auto& key : keys) {
+    ASSERT_FALSE(t.Insert(Slice(key), Slice(key)));
+    NO_FATALS(VerifyGet(t, Slice(key), Slice(key)));
+  }
+
+  std::sort(keys.begin(), keys.end());
+  unique_ptr<CBTreeIterator<PrefixSmallFanoutTraits>> iter(t.NewIterator());
+  bool exact;
+  ASSERT_TRUE(iter->SeekAtOrAfter(Slice(""), &exact));
+  for (const auto& key : keys) {
+    ASSERT_TRUE(iter->IsValid());
+    Slice k;
+    Slice v;
+    iter->GetCurrentEntry(&k, &v);
+    ASSERT_EQ(Slice(key), k);
+    iter->Next();
+  }
+  ASSERT_FALSE(iter->IsValid());
+
+  // Seeking to keys which aren't in the tree.
+  ASSERT_TRUE(iter->SeekAtOrAfter(Slice("abcdefgh_\xff"), &exact));
+  ASSERT_FALSE(exact);
+  Slice k;
+  Slice v;
+  iter->GetCurrentEntry(&k, &v);
+  ASSERT_EQ(Slice("abcdefgi"), k);
+}
+
+// Compare the performance of inserts and lookups of composite keys with and
+// without the prefixes of the keys kept in the leaves.
+template<class Traits>
+void DoTestKeyLookupPerformance(const vector<string>& keys) {
+  const int kLookupTrials = 5;
+  CBTree<Traits> tree;
+  LOG_TIMING(INFO, Substitute("Insert $0 keys (prefixes: $1)",
+                              keys.size(), Traits::kInlineKeyPrefixes)) {
+    for (const auto& key : keys) {
+      ASSERT_TRUE(tree.Insert(Slice(key), Slice("v")));
+    }
+  }
+  LOG_TIMING(INFO, Substitute("Look up $0 keys $1 times (prefixes: $2)",
+                              keys.size(), kLookupTrials, Traits::kInlineKeyPrefixes)) {
+    char vbuf[8];
+    for (int trial = 0; trial < kLookupTrials; trial++) {
+      for (const auto& key : keys) {
+        size_t len = sizeof(vbuf);
+        ASSERT_EQ(CBTree<Traits>::GET_SUCCESS, tree.GetCopy(Slice(key), vbuf, &len));
+      }
+    }
+  }
+}
+
+TEST_F(TestCBTree, TestKeyLookupPerformance) {
+#ifndef NDEBUG
+  int n_keys = 10000;
+#else
+  int n_keys = 1000000;
+#endif
+  if (AllowSlowTests()) {
+    n_keys = 4000000;
+  }
+  // Keys of a (host, metric, sequence number) composite key: the keys are
+  // longer than 8 bytes, so comparing them dereferences them unless their
+  // prefixes differ.
+  std::mt19937 gen(SeedRandom());
+  vector<string> keys;
+  keys.reserve(n_keys);
+  for (int i = 0; i < n_keys; i++) {
+    keys.emplace_back(Substitute("host$0.example.com/metric$1/$2",
+                                 gen() % 10000, i % 100, i));
+  }
+  std::shuffle(keys.begin(), keys.end(), gen);
+  NO_FATALS(DoTestKeyLookupPerformance<BTreeTraits>(keys));
+  NO_FATALS(DoTestKeyLookupPerformance<PrefixTraits>(keys));
+}
+
 // Thread which cycles through doing the following:
 // - lock the node
 // - either mark it splitting or inserting (alternatingly)
@@ -62,6 +62,7 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_double(cfile_set_sparse_materialization_max_selectivity);
 DECLARE_int32(cfile_default_block_size);
 
 using std::shared_ptr;
@@ -336,6 +337,7 @@ class TestCFileSet : public KuduRowSetTest {
 
   static Status MaterializeColumn(CFileSet::Iterator* iter, size_t col_idx, ColumnBlock* cb) {
     SelectionVector sel(cb->nrows());
+    sel.SetAllTrue();
     ColumnMaterializationContext ctx(col_idx, nullptr, cb, &sel);
     return iter->MaterializeColumn(&ctx);
   }
@@ -554,6 +556,54 @@ TEST_F(TestCFileSet, TestRangePredicates2) {
   DoTestRangeScan(fileset, kNumRows * 10, kNoBound);
 }
 
+// Test that the columns without predicates are only decoded for the rows which
+// passed the predicates when those are very selective.
+TEST_F(TestCFileSet, TestSparseMaterialization) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset;
+  ASSERT_OK(CFileSet::Open(rowset_meta_, MemTracker::GetRootTracker(), MemTracker::GetRootTracker(),
+                           nullptr, &fileset));
+
+  for (bool sparse : { false, true }) {
+    SCOPED_TRACE(sparse);
+    FLAGS_cfile_set_sparse_materialization_max_selectivity = sparse ? 0.05 : 0;
+
+    unique_ptr<RowwiseIterator> iter(NewMaterializingIterator(
+        unique_ptr<ColumnwiseIterator>(fileset->NewIterator(&schema_, nullptr))));
+    // An IN list on the non-key column 'c1' which selects rows 100, 5001 and 9999.
+    auto spec = GetInListScanSpec(schema_.column(1), { 1000, 50010, 99990 });
+    ASSERT_OK(iter->Init(&spec));
+
+    vector<string> results;
+    ASSERT_OK(IterateToStringList(iter.get(), &results));
+    ASSERT_EQ(3, results.size());
+    EXPECT_EQ("(int32 c0=200, int32 c1=1000, int32 c2=10000)", results[0]);
+    EXPECT_EQ("(int32 c0=10002, int32 c1=50010, int32 c2=500100)", results[1]);
+    EXPECT_EQ("(int32 c0=19998, int32 c1=99990, int32 c2=999900)", results[2]);
+
+    vector<IteratorStats> stats;
+    iter->GetIteratorStats(&stats);
+    ASSERT_EQ(3, stats.size());
+    for (int i = 0; i < 3; i++) {
+      LOG(INFO) << "Col " << i << " stats: " << stats[i].ToString();
+    }
+    // The predicate column is always decoded in full.
+    EXPECT_EQ(0, stats[1].cells_skipped);
+    if (sparse) {
+      // Only the 8-row aligned ranges around the selected rows are decoded: the
+      // last one is cut short by the end of the rowset.
+      EXPECT_EQ(kNumRows - 8 - 8 - 4, stats[0].cells_skipped);
+      EXPECT_EQ(kNumRows - 8 - 8 - 4, stats[2].cells_skipped);
+      EXPECT_LT(stats[2].cells_read, kNumRows / 2);
+    } else {
+      EXPECT_EQ(0, stats[0].cells_skipped);
+      EXPECT_EQ(0, stats[2].cells_skipped);
+    }
+  }
+}
+
 TEST_F(TestCFileSet, TestBloomFilterPredicates) {
   const int kNumRows = 100;
   Arena arena(1024);
@@ -17,9 +17,12 @@
 #include "kudu/tablet/cfile_set.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -32,6 +35,7 @@
 #include "kudu/cfile/cfile_reader.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/iterator_stats.h"
@@ -48,17 +52,43 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/column_group.h"
 #include "kudu/tablet/diskrowset.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
+#include "kudu/util/alignment.h"
+#include "kudu/util/array_view.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
+#include "kudu/util/trace.h"
 
 DEFINE_bool(consult_bloom_filters, true, "Whether to consult bloom filters on row presence checks");
 TAG_FLAG(consult_bloom_filters, hidden);
 
+DEFINE_bool(consult_column_bloom_filters, true,
+            "Whether scans consult the bloom filters of the values of columns, if any, "
+            "to skip the rowsets which can't match their equality and IN-list predicates");
+TAG_FLAG(consult_column_bloom_filters, advanced);
+TAG_FLAG(consult_column_bloom_filters, runtime);
+
+DEFINE_bool(consult_rowset_column_stats, true,
+            "Whether scans consult the column statistics stored in the rowset metadata, "
+            "if any, to skip the rowsets which can't match their predicates");
+TAG_FLAG(consult_rowset_column_stats, advanced);
+TAG_FLAG(consult_rowset_column_stats, runtime);
+
+DEFINE_double(cfile_set_sparse_materialization_max_selectivity, 0.05,
+              "When scanning, columns without predicates are only decoded for the ranges of "
+              "rows which passed the predicates on other columns if at most this fraction of "
+              "the batch's rows passed them. Otherwise, the whole batch is decoded. A value of "
+              "0 disables this.");
+TAG_FLAG(cfile_set_sparse_materialization_max_selectivity, advanced);
+TAG_FLAG(cfile_set_sparse_materialization_max_selectivity, runtime);
+
 DECLARE_bool(rowset_metadata_store_keys);
 
 using kudu::cfile::BloomFileReader;
@@ -102,6 +132,20 @@ static Status OpenReader(FsManager* fs,
                                  new_reader);
 }
 
+// Like OpenReader(), for the column 'col_id' of the column group 'group'.
+static Status OpenColumnGroupReader(const shared_ptr<ColumnGroupReader>& group,
+                                    ColumnId col_id,
+                                    shared_ptr<MemTracker> cfile_reader_tracker,
+                                    const IOContext* io_context,
+                                    unique_ptr<CFileReader>* new_reader) {
+  ReaderOptions opts;
+  opts.parent_mem_tracker = std::move(cfile_reader_tracker);
+  opts.io_context = io_context;
+  return CFileReader::OpenNoInit(group->NewColumnBlock(col_id),
+                                 std::move(opts),
+                                 new_reader);
+}
+
 ////////////////////////////////////////////////////////////
 // CFile Base
 ////////////////////////////////////////////////////////////
@@ -138,16 +182,28 @@ Status CFileSet::DoOpen(const IOContext* io_context) {
   // Lazily open the column data cfiles. Each one will be fully opened
   // later, when the first iterator seeks for the first time.
   RowSetMetadata::ColumnIdToBlockIdMap block_map = rowset_metadata_->GetColumnBlocksById();
+  std::unordered_map<BlockId, shared_ptr<ColumnGroupReader>, BlockIdHash, BlockIdEqual> groups;
   for (const RowSetMetadata::ColumnIdToBlockIdMap::value_type& e : block_map) {
     ColumnId col_id = e.first;
+    const BlockId& block_id = e.second;
     DCHECK(!ContainsKey(readers_by_col_id_, col_id)) << "already open";
 
     unique_ptr<CFileReader> reader;
-    RETURN_NOT_OK(OpenReader(rowset_metadata_->fs_manager(),
-                             cfile_reader_tracker_,
-                             rowset_metadata_->column_data_block_for_col_id(col_id),
-                             io_context,
-                             &reader));
+    if (rowset_metadata_->is_column_group_block(block_id)) {
+      // The columns of a group share the block of the group.
+      shared_ptr<ColumnGroupReader>& group = groups[block_id];
+      if (!group) {
+        RETURN_NOT_OK(ColumnGroupReader::Open(rowset_metadata_->fs_manager(), block_id, &group));
+      }
+      RETURN_NOT_OK(OpenColumnGroupReader(group, col_id, cfile_reader_tracker_,
+                                          io_context, &reader));
+    } else {
+      RETURN_NOT_OK(OpenReader(rowset_metadata_->fs_manager(),
+                               cfile_reader_tracker_,
+                               block_id,
+                               io_context,
+                               &reader));
+    }
     readers_by_col_id_[col_id] = std::move(reader);
     VLOG(1) << "Successfully opened cfile for column id " << col_id
             << " in " << rowset_metadata_->ToString();
@@ -285,6 +341,15 @@ Status CFileSet::FindRow(const RowSetKeyProbe &probe,
                          const IOContext* io_context,
                          optional<rowid_t>* idx,
                          ProbeStats* stats) const {
+  unique_ptr<CFileIterator> key_iter;
+  return FindRowWithKeyIterator(probe, io_context, &key_iter, idx, stats);
+}
+
+Status CFileSet::FindRowWithKeyIterator(const RowSetKeyProbe& probe,
+                                        const IOContext* io_context,
+                                        unique_ptr<CFileIterator>* key_iter,
+                                        optional<rowid_t>* idx,
+                                        ProbeStats* stats) const {
   if (FLAGS_consult_bloom_filters) {
     // Fully open the BloomFileReader if it was lazily opened earlier.
     //
@@ -311,18 +376,19 @@ Status CFileSet::FindRow(const RowSetKeyProbe &probe,
   }
 
   stats->keys_consulted++;
-  unique_ptr<CFileIterator> key_iter;
-  RETURN_NOT_OK(NewKeyIterator(io_context, &key_iter));
+  if (!*key_iter) {
+    RETURN_NOT_OK(NewKeyIterator(io_context, key_iter));
+  }
 
   bool exact;
-  Status s = key_iter->SeekAtOrAfter(probe.encoded_key(), &exact);
+  Status s = (*key_iter)->SeekAtOrAfter(probe.encoded_key(), &exact);
   if (s.IsNotFound() || (s.ok() && !exact)) {
     idx->reset();
     return Status::OK();
   }
   RETURN_NOT_OK(s);
 
-  *idx = key_iter->GetCurrentOrdinal();
+  *idx = (*key_iter)->GetCurrentOrdinal();
   return Status::OK();
 }
 
@@ -341,6 +407,23 @@ Status CFileSet::CheckRowPresent(const RowSetKeyProbe& probe, const IOContext* i
   return Status::OK();
 }
 
+Status CFileSet::CheckRowsPresent(ArrayView<KeyPresenceProbe> probes,
+                                  const IOContext* io_context,
+                                  vector<rowid_t>* rowids) const {
+  rowids->resize(probes.size());
+  unique_ptr<CFileIterator> key_iter;
+  for (int i = 0; i < probes.size(); i++) {
+    KeyPresenceProbe& p = probes[i];
+    optional<rowid_t> opt_rowid;
+    RETURN_NOT_OK(FindRowWithKeyIterator(*p.probe, io_context, &key_iter, &opt_rowid, p.stats));
+    p.present = opt_rowid.has_value();
+    if (p.present) {
+      (*rowids)[i] = *opt_rowid;
+    }
+  }
+  return Status::OK();
+}
+
 Status CFileSet::NewKeyIterator(const IOContext* io_context,
                                 unique_ptr<CFileIterator>* key_iter) const {
   RETURN_NOT_OK(key_index_reader()->Init(io_context));
@@ -390,6 +473,7 @@ Status CFileSet::Iterator::CreateColumnIterators(const ScanSpec* spec) {
 
   col_iters_.swap(ret_iters);
   prepared_iters_.reserve(col_iters_.size());
+  cells_skipped_.assign(col_iters_.size(), 0);
   return Status::OK();
 }
 
@@ -412,9 +496,19 @@ Status CFileSet::Iterator::Init(ScanSpec *spec) {
     lower_bound_idx_ = row_count_;
     spec->RemovePredicates();
   } else {
-    // If there is a range predicate on the key column, push that down into an
-    // ordinal range.
-    RETURN_NOT_OK(PushdownRangeScanPredicate(spec));
+    bool may_match = ColumnStatsMayMatch(spec);
+    if (may_match) {
+      RETURN_NOT_OK(CheckColumnBloomFilters(spec, &may_match));
+    }
+    if (!may_match) {
+      // None of the rows of this CFileSet can match. Unlike above, the
+      // predicates are left in the spec since other rowsets may match them.
+      lower_bound_idx_ = row_count_;
+    } else {
+      // If there is a range predicate on the key column, push that down into
+      // an ordinal range.
+      RETURN_NOT_OK(PushdownRangeScanPredicate(spec));
+    }
   }
 
   initted_ = true;
@@ -426,6 +520,83 @@ Status CFileSet::Iterator::Init(ScanSpec *spec) {
   return Status::OK();
 }
 
+Status CFileSet::Iterator::CheckColumnBloomFilters(const ScanSpec* spec, bool* may_match) {
+  *may_match = true;
+  if (spec == nullptr || !FLAGS_consult_column_bloom_filters) {
+    return Status::OK();
+  }
+  for (const auto& col_id : col_ids_without_deltas_) {
+    const auto* reader = FindOrNull(base_data_->readers_by_col_id_, col_id);
+    if (!reader) {
+      continue;
+    }
+    const auto& col = projection_->column_by_id(col_id);
+    const auto* pred = FindOrNull(spec->predicates(), col.name());
+    if (!pred) {
+      continue;
+    }
+    vector<const void*> values;
+    if (pred->predicate_type() == PredicateType::Equality) {
+      values.push_back(pred->raw_lower());
+    } else if (pred->predicate_type() == PredicateType::InList) {
+      values = pred->raw_values();
+    } else {
+      continue;
+    }
+    RETURN_NOT_OK((*reader)->Init(io_context_));
+    if (!(*reader)->has_bloom_filter()) {
+      continue;
+    }
+    bool may_be_present;
+    RETURN_NOT_OK((*reader)->ValuesMayBePresent(io_context_, values, &may_be_present));
+    if (!may_be_present) {
+      VLOG(1) << "Skipping " << ToString() << ": the bloom filter of column "
+              << col.name() << " rules out predicate " << pred->ToString();
+      TRACE_COUNTER_INCREMENT("rowsets_skipped_by_column_bloom_filters", 1);
+      *may_match = false;
+      return Status::OK();
+    }
+  }
+  return Status::OK();
+}
+
+bool CFileSet::Iterator::ColumnStatsMayMatch(const ScanSpec* spec) const {
+  if (spec == nullptr || !FLAGS_consult_rowset_column_stats) {
+    return true;
+  }
+  for (const auto& col_id : col_ids_without_deltas_) {
+    const auto& col = projection_->column_by_id(col_id);
+    const auto* pred = FindOrNull(spec->predicates(), col.name());
+    if (!pred) {
+      continue;
+    }
+    ColumnStatsPB stats;
+    if (!base_data_->rowset_metadata_->GetColumnStats(col_id, &stats) ||
+        !stats.has_null_count()) {
+      continue;
+    }
+    bool may_match = true;
+    if (pred->predicate_type() == PredicateType::IsNull) {
+      may_match = stats.null_count() > 0;
+    } else if (stats.null_count() == static_cast<int64_t>(row_count_)) {
+      // All the cells are NULL, and only IS NULL predicates match them.
+      may_match = false;
+    } else if (stats.has_min_value()) {
+      const size_t size = col.type_info()->size();
+      if (PREDICT_TRUE(stats.min_value().size() == size && stats.max_value().size() == size)) {
+        may_match = pred->MayMatchRange(stats.min_value().data(), stats.max_value().data());
+      }
+    }
+    if (!may_match) {
+      VLOG(1) << "Skipping " << ToString() << ": the statistics of column "
+              << col.name() << " rule out predicate " << pred->ToString();
+      TRACE_COUNTER_INCREMENT("rowsets_skipped_by_column_stats", 1);
+      return false;
+    }
+  }
+  return true;
+}
+
 Status CFileSet::Iterator::OptimizePKPredicates(ScanSpec* spec) {
   if (spec == nullptr) {
     // No predicate.
@@ -586,10 +757,104 @@ Status CFileSet::Iterator::InitializeSelectionVector(SelectionVector *sel_vec) {
   return Status::OK();
 }
 
+bool CFileSet::Iterator::ShouldMaterializeSelectedRanges(
+    ColumnMaterializationContext* ctx) const {
+  if (ctx->pred() != nullptr || ctx->sel() == nullptr ||
+      FLAGS_cfile_set_sparse_materialization_max_selectivity <= 0) {
+    return false;
+  }
+  return ctx->sel()->CountSelected() <=
+      prepared_count_ * FLAGS_cfile_set_sparse_materialization_max_selectivity;
+}
+
+Status CFileSet::Iterator::MaterializeSelectedRanges(ColumnMaterializationContext* ctx) {
+  // Seeking has a cost, so only skip runs of unselected rows which are at
+  // least this long. Ranges are also aligned to multiples of 8 rows so that
+  // they start on byte boundaries of the null bitmap.
+  static constexpr size_t kMinSkippedChunks = 8;
+
+  ColumnBlock* dst = ctx->block();
+  if (dst->is_nullable()) {
+    // The cells of the unselected rows are left unset: mark them as NULL
+    // rather than leaving the bitmap in an indeterminate state.
+    BitmapChangeBits(dst->non_null_bitmap(), 0, prepared_count_, false);
+  }
+
+  const uint8_t* sel_bitmap = ctx->sel()->bitmap();
+  const size_t n_chunks = KUDU_ALIGN_UP(prepared_count_, 8) / 8;
+  size_t chunk = 0;
+  size_t rows_materialized = 0;
+  while (chunk < n_chunks) {
+    // Find the next range of chunks with selected rows, merging in the runs of
+    // unselected chunks which are too short to be worth skipping.
+    while (chunk < n_chunks && sel_bitmap[chunk] == 0) {
+      chunk++;
+    }
+    if (chunk == n_chunks) {
+      break;
+    }
+    size_t range_end = chunk + 1;
+    size_t next_selected = range_end;
+    while (next_selected < n_chunks) {
+      if (sel_bitmap[next_selected] == 0) {
+        next_selected++;
+        continue;
+      }
+      if (next_selected - range_end >= kMinSkippedChunks) {
+        break;
+      }
+      range_end = ++next_selected;
+    }
+
+    const size_t start_row = chunk * 8;
+    const size_t end_row = std::min(range_end * 8, prepared_count_);
+    RETURN_NOT_OK(MaterializeRange(ctx, start_row, end_row - start_row));
+    rows_materialized += end_row - start_row;
+    chunk = range_end;
+  }
+  cells_skipped_[ctx->col_idx()] += prepared_count_ - rows_materialized;
+  return Status::OK();
+}
+
+Status CFileSet::Iterator::MaterializeRange(ColumnMaterializationContext* ctx,
+                                            size_t start_row,
+                                            size_t nrows) {
+  ColumnIterator* col_iter = col_iters_[ctx->col_idx()].get();
+  const rowid_t start_idx = cur_idx_ + start_row;
+  if (!col_iter->seeked() || col_iter->GetCurrentOrdinal() != start_idx) {
+    RETURN_NOT_OK(col_iter->SeekToOrdinal(start_idx));
+  }
+  size_t n = nrows;
+  RETURN_NOT_OK(col_iter->PrepareBatch(&n));
+  if (n != nrows) {
+    return Status::Corruption(
+        Substitute("Column $0 ($1) didn't yield enough rows at offset $2: expected $3 "
+                   "but only got $4", ctx->col_idx(),
+                   projection_->column(ctx->col_idx()).ToString(), start_idx, nrows, n));
+  }
+
+  ColumnBlock* dst = ctx->block();
+  DCHECK_EQ(0, start_row % 8);
+  ColumnBlock range_block(dst->type_info(),
+                          dst->is_nullable() ? dst->non_null_bitmap() + start_row / 8 : nullptr,
+                          dst->data() + start_row * dst->stride(),
+                          nrows,
+                          dst->memory());
+  SelectionVector range_sel(nrows);
+  range_sel.SetAllTrue();
+  ColumnMaterializationContext range_ctx(ctx->col_idx(), nullptr, &range_block, &range_sel);
+  RETURN_NOT_OK(col_iter->Scan(&range_ctx));
+  return col_iter->FinishBatch();
+}
+
 Status CFileSet::Iterator::MaterializeColumn(ColumnMaterializationContext *ctx) {
   CHECK_EQ(prepared_count_, ctx->block()->nrows());
   DCHECK_LT(ctx->col_idx(), col_iters_.size());
 
+  if (ShouldMaterializeSelectedRanges(ctx)) {
+    return MaterializeSelectedRanges(ctx);
+  }
+
   RETURN_NOT_OK(PrepareColumn(ctx));
   ColumnIterator* iter = col_iters_[ctx->col_idx()].get();
 
@@ -615,9 +880,10 @@ Status CFileSet::Iterator::FinishBatch() {
 void CFileSet::Iterator::GetIteratorStats(vector<IteratorStats>* stats) const {
   stats->clear();
   stats->reserve(col_iters_.size());
-  for (const auto& iter : col_iters_) {
+  for (size_t i = 0; i < col_iters_.size(); i++) {
     ANNOTATE_IGNORE_READS_BEGIN();
-    stats->push_back(iter->io_statistics());
+    stats->push_back(col_iters_[i]->io_statistics());
+    stats->back().cells_skipped = cells_skipped_[i];
     ANNOTATE_IGNORE_READS_END();
   }
 }
@@ -37,6 +37,7 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/tablet/rowset_metadata.h" // IWYU pragma: keep
+#include "kudu/util/array_view.h"
 #include "kudu/util/make_shared.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/status.h"
@@ -64,6 +65,7 @@ class TabletServerTest_SetEncodedKeysWhenStartingUp_Test;
 namespace tablet {
 
 class RowSetKeyProbe;
+struct KeyPresenceProbe;
 struct ProbeStats;
 
 // Set of CFiles which make up the base data for a single rowset
@@ -124,6 +126,14 @@ class CFileSet :
   Status CheckRowPresent(const RowSetKeyProbe& probe, const fs::IOContext* io_context,
                          bool* present, rowid_t* rowid, ProbeStats* stats) const;
 
+  // Like CheckRowPresent(), for a batch of row keys sorted in increasing
+  // order, with a single iterator over the key index for all of them. Sets
+  // the 'present' field of each of 'probes' and, if the row is present,
+  // the element of 'rowids' with the same index to the row's index.
+  Status CheckRowsPresent(ArrayView<KeyPresenceProbe> probes,
+                          const fs::IOContext* io_context,
+                          std::vector<rowid_t>* rowids) const;
+
   // Return true if there exists a CFile for the given column ID.
   bool has_data_for_column_id(ColumnId col_id) const {
     return ContainsKey(readers_by_col_id_, col_id);
@@ -153,6 +163,14 @@ class CFileSet :
   Status NewKeyIterator(const fs::IOContext* io_context,
                         std::unique_ptr<cfile::CFileIterator>* key_iter) const;
 
+  // Like FindRow(), seeking 'key_iter' in the key index. If 'key_iter' is
+  // null and the key index must be consulted, it's set to a new iterator.
+  Status FindRowWithKeyIterator(const RowSetKeyProbe& probe,
+                                const fs::IOContext* io_context,
+                                std::unique_ptr<cfile::CFileIterator>* key_iter,
+                                std::optional<rowid_t>* idx,
+                                ProbeStats* stats) const;
+
   // Return the CFileReader responsible for reading the key index.
   // (the ad-hoc reader for composite keys, otherwise the key column reader)
   cfile::CFileReader* key_index_reader() const;
@@ -222,6 +240,17 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // Collect the IO statistics for each of the underlying columns.
   void GetIteratorStats(std::vector<IteratorStats> *stats) const override;
 
+  // Sets the IDs of the projected columns whose base data values aren't
+  // changed by any deltas. Init() may skip all the rows of the CFileSet if
+  // the statistics of one of these columns in the rowset metadata, or the
+  // bloom filter of its values, show that none match a predicate of the scan.
+  //
+  // Must be called before Init().
+  void set_col_ids_without_deltas(std::vector<ColumnId> col_ids) {
+    DCHECK(!initted_);
+    col_ids_without_deltas_ = std::move(col_ids);
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(Iterator);
   FRIEND_TEST(TestCFileSet, TestRangeScan);
@@ -244,6 +273,15 @@ class CFileSet::Iterator : public ColumnwiseIterator {
 
   Status OptimizePKPredicates(ScanSpec* spec);
 
+  // Sets '*may_match' to false if the bloom filters of the values of the
+  // columns in 'col_ids_without_deltas_' show that no row can match the
+  // predicates of 'spec', and to true otherwise.
+  Status CheckColumnBloomFilters(const ScanSpec* spec, bool* may_match);
+
+  // Returns false if the statistics of the columns in 'col_ids_without_deltas_'
+  // show that no row can match the predicates of 'spec', and true otherwise.
+  bool ColumnStatsMayMatch(const ScanSpec* spec) const;
+
   // Look for a predicate which can be converted into a range scan using the key
   // column's index. If such a predicate exists, remove it from the scan spec and
   // store it in member fields.
@@ -254,9 +292,26 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // Prepare the given column. The column must not have been prepared yet.
   Status PrepareColumn(ColumnMaterializationContext *ctx);
 
+  // Returns true if the column of 'ctx' should be materialized with
+  // MaterializeSelectedRanges(), i.e. it has no predicate and few enough rows
+  // of the batch are still selected.
+  bool ShouldMaterializeSelectedRanges(ColumnMaterializationContext* ctx) const;
+
+  // Materialize the column of 'ctx' by seeking the column's iterator to the
+  // ranges of selected rows, and only decoding those. The cells of the rows
+  // which are not selected are left unset.
+  Status MaterializeSelectedRanges(ColumnMaterializationContext* ctx);
+
+  // Decode the 'nrows' cells starting at row 'start_row' of the batch into
+  // the corresponding cells of 'ctx'.
+  Status MaterializeRange(ColumnMaterializationContext* ctx, size_t start_row, size_t nrows);
+
   const std::shared_ptr<CFileSet const> base_data_;
   const Schema* projection_;
 
+  // See set_col_ids_without_deltas().
+  std::vector<ColumnId> col_ids_without_deltas_;
+
   // Iterator for the key column in the underlying data.
   std::unique_ptr<cfile::CFileIterator> key_iter_;
   std::vector<std::unique_ptr<cfile::ColumnIterator>> col_iters_;
@@ -286,6 +341,9 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // stored in 'col_iters_'.
   std::vector<cfile::ColumnIterator*> prepared_iters_;
 
+  // For each column, the number of cells skipped by MaterializeSelectedRanges().
+  std::vector<int64_t> cells_skipped_;
+
   Arena arena_;
 };
 
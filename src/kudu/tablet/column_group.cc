@@ -0,0 +1,396 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/column_group.h"
+
+#include <cstring>
+#include <numeric>
+#include <ostream>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/metadata.pb.h"
+#include "kudu/util/array_view.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/env.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/malloc.h"
+#include "kudu/util/pb_util.h"
+#include "kudu/util/slice.h"
+
+using kudu::fs::BlockCreationTransaction;
+using kudu::fs::BlockManager;
+using kudu::fs::CreateBlockOptions;
+using kudu::fs::ReadableBlock;
+using kudu::fs::WritableBlock;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tablet {
+
+namespace {
+
+constexpr const char* const kColumnGroupMagic = "kudugrp1";
+constexpr size_t kColumnGroupMagicLength = 8;
+
+// The length of the footer and the magic.
+constexpr size_t kColumnGroupTrailerLength = sizeof(uint32_t) + kColumnGroupMagicLength;
+
+size_t TotalLength(ArrayView<Slice> slices) {
+  return std::accumulate(slices.begin(), slices.end(), static_cast<size_t>(0),
+                         [](size_t sum, const Slice& s) { return sum + s.size(); });
+}
+
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////
+// ColumnGroupWriter
+////////////////////////////////////////////////////////////
+
+// An in-memory block holding the CFile of a column of the group.
+class ColumnGroupWriter::ColumnBlock : public WritableBlock {
+ public:
+  ColumnBlock(BlockManager* block_manager, BlockId group_block_id, ColumnId col_id)
+      : block_manager_(block_manager),
+        group_block_id_(group_block_id),
+        col_id_(col_id),
+        state_(CLEAN) {
+  }
+
+  const BlockId& id() const override {
+    return group_block_id_;
+  }
+
+  Status Close() override {
+    state_ = CLOSED;
+    return Status::OK();
+  }
+
+  Status Abort() override {
+    state_ = CLOSED;
+    return Status::OK();
+  }
+
+  BlockManager* block_manager() const override {
+    return block_manager_;
+  }
+
+  Status Append(const Slice& data) override {
+    return AppendV(ArrayView<const Slice>(&data, 1));
+  }
+
+  Status AppendV(ArrayView<const Slice> data) override {
+    DCHECK(state_ == CLEAN || state_ == DIRTY);
+    for (const auto& d : data) {
+      data_.append(d.data(), d.size());
+    }
+    state_ = DIRTY;
+    return Status::OK();
+  }
+
+  Status Finalize() override {
+    state_ = FINALIZED;
+    return Status::OK();
+  }
+
+  size_t BytesAppended() const override {
+    return data_.size();
+  }
+
+  State state() const override {
+    return state_;
+  }
+
+  ColumnId col_id() const {
+    return col_id_;
+  }
+
+  Slice data() const {
+    return Slice(data_);
+  }
+
+ private:
+  BlockManager* const block_manager_;
+  const BlockId group_block_id_;
+  const ColumnId col_id_;
+  faststring data_;
+  State state_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnBlock);
+};
+
+// Takes ownership of the finalized blocks of the columns of the group until
+// they're written to the block of the group.
+class ColumnGroupWriter::ColumnTransaction : public BlockCreationTransaction {
+ public:
+  ColumnTransaction() = default;
+
+  void AddCreatedBlock(unique_ptr<WritableBlock> block) override {
+    blocks_.emplace_back(std::move(block));
+  }
+
+  Status CommitCreatedBlocks() override {
+    return Status::OK();
+  }
+
+  size_t num_blocks() const {
+    return blocks_.size();
+  }
+
+  void Clear() {
+    blocks_.clear();
+  }
+
+ private:
+  vector<unique_ptr<WritableBlock>> blocks_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnTransaction);
+};
+
+ColumnGroupWriter::ColumnGroupWriter(FsManager* fs, string tablet_id, fs::StorageTier tier)
+    : fs_(fs),
+      tablet_id_(std::move(tablet_id)),
+      tier_(tier),
+      column_transaction_(new ColumnTransaction()) {
+}
+
+ColumnGroupWriter::~ColumnGroupWriter() {
+}
+
+Status ColumnGroupWriter::Open() {
+  DCHECK(!block_);
+  const CreateBlockOptions block_opts({ tablet_id_, tier_ });
+  RETURN_NOT_OK_PREPEND(fs_->CreateNewBlock(block_opts, &block_),
+      Substitute("tablet $0: unable to open output file for column group", tablet_id_));
+  return Status::OK();
+}
+
+const BlockId& ColumnGroupWriter::block_id() const {
+  DCHECK(block_);
+  return block_->id();
+}
+
+unique_ptr<WritableBlock> ColumnGroupWriter::NewColumnBlock(ColumnId col_id) {
+  DCHECK(block_);
+  unique_ptr<ColumnBlock> block(new ColumnBlock(block_->block_manager(), block_->id(), col_id));
+  column_blocks_.push_back(block.get());
+  return block;
+}
+
+BlockCreationTransaction* ColumnGroupWriter::column_transaction() {
+  return column_transaction_.get();
+}
+
+Status ColumnGroupWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction) {
+  DCHECK(block_);
+  CHECK_EQ(column_blocks_.size(), column_transaction_->num_blocks())
+      << "all the columns of the group must be finished first";
+
+  ColumnGroupFooterPB footer;
+  vector<Slice> data;
+  data.reserve(column_blocks_.size() + 1);
+  uint64_t offset = 0;
+  for (const auto* column_block : column_blocks_) {
+    DCHECK_EQ(WritableBlock::FINALIZED, column_block->state());
+    ColumnGroupFooterPB::ColumnPB* column = footer.add_columns();
+    column->set_column_id(column_block->col_id());
+    column->set_offset(offset);
+    column->set_length(column_block->BytesAppended());
+    data.emplace_back(column_block->data());
+    offset += column_block->BytesAppended();
+  }
+
+  faststring footer_str;
+  pb_util::SerializeToString(footer, &footer_str);
+  PutFixed32(&footer_str, footer.GetCachedSize());
+  footer_str.append(kColumnGroupMagic, kColumnGroupMagicLength);
+  data.emplace_back(footer_str);
+
+  RETURN_NOT_OK_PREPEND(block_->AppendV(data),
+      Substitute("tablet $0: unable to write column group", tablet_id_));
+  RETURN_NOT_OK(block_->Finalize());
+  transaction->AddCreatedBlock(std::move(block_));
+
+  // The CFiles of the columns aren't needed anymore.
+  column_blocks_.clear();
+  column_transaction_->Clear();
+  return Status::OK();
+}
+
+////////////////////////////////////////////////////////////
+// ColumnGroupReader
+////////////////////////////////////////////////////////////
+
+// A window onto the CFile of a column of the group.
+class ColumnGroupReader::ColumnBlock : public ReadableBlock {
+ public:
+  ColumnBlock(shared_ptr<ColumnGroupReader> group, ColumnId col_id)
+      : group_(std::move(group)),
+        col_id_(col_id) {
+  }
+
+  const BlockId& id() const override {
+    return group_->block_->id();
+  }
+
+  Status Close() override {
+    return Status::OK();
+  }
+
+  BlockManager* block_manager() const override {
+    return group_->block_->block_manager();
+  }
+
+  Status Size(uint64_t* sz) const override {
+    ColumnExtent extent;
+    RETURN_NOT_OK(group_->FindColumn(col_id_, &extent));
+    *sz = extent.length;
+    return Status::OK();
+  }
+
+  Status Read(uint64_t offset, Slice result) const override {
+    return ReadV(offset, ArrayView<Slice>(&result, 1));
+  }
+
+  Status ReadV(uint64_t offset, ArrayView<Slice> results) const override {
+    uint64_t group_offset;
+    RETURN_NOT_OK(ToGroupOffset(offset, TotalLength(results), &group_offset));
+    return group_->block_->ReadV(group_offset, results);
+  }
+
+  Status ReadVBatch(ArrayView<const ReadVRequest> requests) const override {
+    vector<ReadVRequest> group_requests;
+    group_requests.reserve(requests.size());
+    for (const auto& r : requests) {
+      uint64_t group_offset;
+      RETURN_NOT_OK(ToGroupOffset(r.offset, TotalLength(r.results), &group_offset));
+      group_requests.push_back({ group_offset, r.results });
+    }
+    return group_->block_->ReadVBatch(group_requests);
+  }
+
+  size_t memory_footprint() const override {
+    return kudu_malloc_usable_size(this);
+  }
+
+  uint64_t offset_in_block() const override {
+    // The CFile reader only reads blocks once it has read the footer, so the
+    // column is known to be part of the group by then.
+    ColumnExtent extent;
+    return group_->FindColumn(col_id_, &extent).ok() ? extent.offset : 0;
+  }
+
+ private:
+  // Translates the read of 'length' bytes at 'offset' of the CFile into an
+  // offset within the block of the group.
+  Status ToGroupOffset(uint64_t offset, size_t length, uint64_t* group_offset) const {
+    ColumnExtent extent;
+    RETURN_NOT_OK(group_->FindColumn(col_id_, &extent));
+    if (PREDICT_FALSE(offset + length > extent.length)) {
+      return Status::IOError(Substitute(
+          "Out-of-bounds read of column $0 of column group $1: "
+          "offset $2, length $3, column length $4",
+          col_id_, id().ToString(), offset, length, extent.length));
+    }
+    *group_offset = extent.offset + offset;
+    return Status::OK();
+  }
+
+  const shared_ptr<ColumnGroupReader> group_;
+  const ColumnId col_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnBlock);
+};
+
+Status ColumnGroupReader::Open(FsManager* fs, const BlockId& block_id,
+                               shared_ptr<ColumnGroupReader>* reader) {
+  unique_ptr<ReadableBlock> block;
+  RETURN_NOT_OK(fs->OpenBlock(block_id, &block));
+  reader->reset(new ColumnGroupReader(std::move(block)));
+  return Status::OK();
+}
+
+ColumnGroupReader::ColumnGroupReader(unique_ptr<ReadableBlock> block)
+    : block_(std::move(block)) {
+}
+
+ColumnGroupReader::~ColumnGroupReader() {
+}
+
+unique_ptr<ReadableBlock> ColumnGroupReader::NewColumnBlock(ColumnId col_id) {
+  return unique_ptr<ReadableBlock>(new ColumnBlock(shared_from_this(), col_id));
+}
+
+Status ColumnGroupReader::FindColumn(ColumnId col_id, ColumnExtent* extent) {
+  RETURN_NOT_OK(init_once_.Init(&ColumnGroupReader::ReadFooter, this));
+  const ColumnExtent* e = FindOrNull(columns_, col_id);
+  if (PREDICT_FALSE(!e)) {
+    return Status::NotFound(Substitute("column $0 not found in column group $1",
+                                       col_id, block_->id().ToString()));
+  }
+  *extent = *e;
+  return Status::OK();
+}
+
+Status ColumnGroupReader::ReadFooter() {
+  uint64_t size;
+  RETURN_NOT_OK(block_->Size(&size));
+  if (PREDICT_FALSE(size < kColumnGroupTrailerLength)) {
+    return Status::Corruption(Substitute("column group $0 is too short: $1 bytes",
+                                         block_->id().ToString(), size));
+  }
+  uint8_t trailer[kColumnGroupTrailerLength];
+  RETURN_NOT_OK(block_->Read(size - kColumnGroupTrailerLength,
+                             Slice(trailer, kColumnGroupTrailerLength)));
+  if (PREDICT_FALSE(memcmp(trailer + sizeof(uint32_t), kColumnGroupMagic,
+                           kColumnGroupMagicLength) != 0)) {
+    return Status::Corruption(Substitute("bad magic in column group $0",
+                                         block_->id().ToString()));
+  }
+  const uint32_t footer_length = DecodeFixed32(trailer);
+  if (PREDICT_FALSE(footer_length > size - kColumnGroupTrailerLength)) {
+    return Status::Corruption(Substitute("bad footer length $0 in column group $1",
+                                         footer_length, block_->id().ToString()));
+  }
+  const uint64_t data_length = size - kColumnGroupTrailerLength - footer_length;
+  unique_ptr<uint8_t[]> footer_buf(new uint8_t[footer_length]);
+  RETURN_NOT_OK(block_->Read(data_length, Slice(footer_buf.get(), footer_length)));
+  ColumnGroupFooterPB footer;
+  RETURN_NOT_OK_PREPEND(pb_util::ParseFromArray(&footer, footer_buf.get(), footer_length),
+                        Substitute("unable to parse the footer of column group $0",
+                                   block_->id().ToString()));
+
+  for (const auto& column : footer.columns()) {
+    if (PREDICT_FALSE(column.offset() + column.length() > data_length)) {
+      return Status::Corruption(Substitute("bad extent of column $0 in column group $1",
+                                           column.column_id(), block_->id().ToString()));
+    }
+    columns_[column.column_id()] = ColumnExtent{ column.offset(), column.length() };
+  }
+  return Status::OK();
+}
+
+} // namespace tablet
+} // namespace kudu
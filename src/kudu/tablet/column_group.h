@@ -0,0 +1,151 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kudu/common/schema.h"
+#include "kudu/fs/block_id.h"
+#include "kudu/fs/block_manager.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/once.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class FsManager;
+
+namespace tablet {
+
+// A column group stores the CFiles of several columns of a rowset one after
+// the other in a single block, so that the rowsets of very wide tables don't
+// need a block per column. The block is laid out as follows:
+//
+//   <CFile of the first column>
+//   ...
+//   <CFile of the last column>
+//   <ColumnGroupFooterPB>
+//   <length of the footer: fixed32>
+//   <magic: "kudugrp1">
+//
+// Each column of the group is read as if its CFile was a block of its own:
+// see ColumnGroupReader.
+
+// Writes the block of a column group.
+//
+// The CFiles of the columns are buffered in memory until the group is
+// finished, since the columns are written concurrently.
+class ColumnGroupWriter {
+ public:
+  // The block is placed on the 'tier' storage tier.
+  ColumnGroupWriter(FsManager* fs, std::string tablet_id,
+                    fs::StorageTier tier = fs::StorageTier::HOT);
+
+  ~ColumnGroupWriter();
+
+  // Creates the block of the group.
+  Status Open();
+
+  // Returns the ID of the block of the group.
+  //
+  // REQUIRES: Open() already called.
+  const BlockId& block_id() const;
+
+  // Returns a new in-memory block into which to write the CFile of the column
+  // 'col_id'. Once finalized, the block must be released to
+  // column_transaction().
+  std::unique_ptr<fs::WritableBlock> NewColumnBlock(ColumnId col_id);
+
+  // Returns the transaction to which the CFiles of the columns of the group
+  // are released.
+  fs::BlockCreationTransaction* column_transaction();
+
+  // Writes the CFiles of the columns and the footer to the block of the group,
+  // finalizing it and releasing it to 'transaction'.
+  Status FinishAndReleaseBlock(fs::BlockCreationTransaction* transaction);
+
+ private:
+  class ColumnBlock;
+  class ColumnTransaction;
+
+  FsManager* const fs_;
+  const std::string tablet_id_;
+  const fs::StorageTier tier_;
+
+  std::unique_ptr<fs::WritableBlock> block_;
+  std::unique_ptr<ColumnTransaction> column_transaction_;
+
+  // The blocks created by NewColumnBlock(), which are owned by their CFile
+  // writers and then by 'column_transaction_'.
+  std::vector<const ColumnBlock*> column_blocks_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnGroupWriter);
+};
+
+// Reads the columns of a column group.
+//
+// Opening the reader only opens the block of the group: its footer is read
+// the first time one of its columns is accessed, as CFileReader does.
+//
+// This class is thread-safe.
+class ColumnGroupReader : public std::enable_shared_from_this<ColumnGroupReader> {
+ public:
+  // Opens the column group stored in the block 'block_id'.
+  static Status Open(FsManager* fs, const BlockId& block_id,
+                     std::shared_ptr<ColumnGroupReader>* reader);
+
+  ~ColumnGroupReader();
+
+  // Returns a block from which to read the CFile of the column 'col_id'.
+  // Reading from the block fails if the column isn't part of the group.
+  std::unique_ptr<fs::ReadableBlock> NewColumnBlock(ColumnId col_id);
+
+ private:
+  class ColumnBlock;
+
+  // The location of the CFile of a column within the block.
+  struct ColumnExtent {
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  explicit ColumnGroupReader(std::unique_ptr<fs::ReadableBlock> block);
+
+  // Reads and parses the footer of the group.
+  Status ReadFooter();
+
+  // Returns the location of the CFile of the column 'col_id', reading the
+  // footer first if needed.
+  Status FindColumn(ColumnId col_id, ColumnExtent* extent);
+
+  const std::unique_ptr<fs::ReadableBlock> block_;
+
+  KuduOnceDynamic init_once_;
+
+  // The location of the CFile of each column, keyed by column ID. Immutable
+  // once 'init_once_' succeeded.
+  std::unordered_map<int32_t, ColumnExtent> columns_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnGroupReader);
+};
+
+} // namespace tablet
+} // namespace kudu
@@ -91,6 +91,7 @@ DEFINE_uint32(merge_benchmark_num_rowsets, 3,
 DEFINE_uint32(merge_benchmark_num_rows_per_rowset, 500000,
               "Number of rowsets as input to the merge");
 
+DECLARE_bool(compaction_copy_unmutated_rows_by_column);
 DECLARE_string(block_manager);
 
 using kudu::consensus::OpId;
@@ -1064,6 +1065,44 @@ TEST_F(TestCompaction, TestKUDU102) {
 }
 
 // Test compacting when all of the inputs and the output have the same schema
+// Compacting non-overlapping rowsets whose unmutated rows are copied a column
+// at a time yields the same output as processing every row on its own.
+TEST_F(TestCompaction, TestCopyUnmutatedRowsByColumn) {
+  constexpr int kNumRowSets = 3;
+  constexpr int kRowsPerRowSet = 250;
+  vector<shared_ptr<DiskRowSet>> rowsets;
+  for (int i = 0; i < kNumRowSets; i++) {
+    shared_ptr<MemRowSet> mrs;
+    ASSERT_OK(MemRowSet::Create(i, schema_, log_anchor_registry_.get(),
+                                mem_trackers_.tablet_tracker, &mrs));
+    for (int j = 0; j < kRowsPerRowSet; j++) {
+      InsertRow(mrs.get(), i * kRowsPerRowSet + j, j);
+    }
+    shared_ptr<DiskRowSet> rs;
+    ASSERT_OK(FlushMRSAndReopenNoRoll(*mrs, schema_, &rs));
+    rowsets.emplace_back(std::move(rs));
+  }
+  // Break the runs of unmutated rows of the middle rowset.
+  for (int j = 0; j < kRowsPerRowSet; j += 7) {
+    UpdateRow(rowsets[1].get(), kRowsPerRowSet + j, j + 1);
+  }
+  DeleteRow(rowsets[1].get(), kRowsPerRowSet + 1);
+
+  vector<string> outputs[2];
+  for (int copy_by_column = 0; copy_by_column < 2; copy_by_column++) {
+    SCOPED_TRACE(copy_by_column);
+    FLAGS_compaction_copy_unmutated_rows_by_column = copy_by_column;
+    shared_ptr<DiskRowSet> result;
+    NO_FATALS(CompactAndReopenNoRoll(rowsets, schema_, &result));
+    unique_ptr<CompactionOrFlushInput> input;
+    ASSERT_OK(CompactionOrFlushInput::Create(*result, &schema_, MvccSnapshot(mvcc_),
+                                             nullptr, &input));
+    NO_FATALS(IterateInput(input.get(), &outputs[copy_by_column]));
+  }
+  ASSERT_EQ(kNumRowSets * kRowsPerRowSet, outputs[1].size());
+  ASSERT_EQ(outputs[0], outputs[1]);
+}
+
 TEST_F(TestCompaction, TestMerge) {
   vector<Schema> schemas{ schema_, schema_, schema_ };
   NO_FATALS(DoMerge(schemas.back(), schemas));
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <deque>
 #include <memory>
 #include <ostream>
@@ -31,10 +32,13 @@
 #include <glog/logging.h>
 
 #include "kudu/clock/hybrid_clock.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/encoded_key.h"
 #include "kudu/common/generic_iterators.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/rowblock_memory.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/scan_spec.h"
@@ -48,12 +52,14 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/cfile_set.h"
 #include "kudu/tablet/delta_store.h"
 #include "kudu/tablet/delta_tracker.h"
 #include "kudu/tablet/diskrowset.h"
 #include "kudu/tablet/memrowset.h"
 #include "kudu/tablet/mutation.h"
 #include "kudu/tablet/mvcc.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/fault_injection.h"
@@ -88,6 +94,13 @@ DEFINE_double(tablet_inject_kudu_2233, 0,
 TAG_FLAG(tablet_inject_kudu_2233, unsafe);
 TAG_FLAG(tablet_inject_kudu_2233, hidden);
 
+DEFINE_bool(compaction_copy_unmutated_rows_by_column, true,
+            "Whether compactions and flushes copy the runs of input rows without "
+            "REDO mutations or ghost versions a column at a time, rather than "
+            "applying mutations to them one row at a time.");
+TAG_FLAG(compaction_copy_unmutated_rows_by_column, advanced);
+TAG_FLAG(compaction_copy_unmutated_rows_by_column, runtime);
+
 namespace kudu {
 namespace tablet {
 
@@ -231,12 +244,21 @@ class MemRowSetCompactionInput : public CompactionOrFlushInput {
 // CompactionOrFlushInput yielding rows and mutations from an on-disk DiskRowSet.
 class DiskRowSetCompactionInput : public CompactionOrFlushInput {
  public:
+  // 'base_cfile_iter' is the iterator wrapped by 'base_iter'. If any of
+  // 'lower_bound' and 'exclusive_upper_bound' is set, only the rows in that
+  // key range are yielded.
   DiskRowSetCompactionInput(unique_ptr<RowwiseIterator> base_iter,
+                            const CFileSet::Iterator* base_cfile_iter,
                             unique_ptr<DeltaIterator> redo_delta_iter,
-                            unique_ptr<DeltaIterator> undo_delta_iter)
+                            unique_ptr<DeltaIterator> undo_delta_iter,
+                            const EncodedKey* lower_bound,
+                            const EncodedKey* exclusive_upper_bound)
       : base_iter_(std::move(base_iter)),
+        base_cfile_iter_(base_cfile_iter),
         redo_delta_iter_(std::move(redo_delta_iter)),
         undo_delta_iter_(std::move(undo_delta_iter)),
+        lower_bound_(lower_bound),
+        exclusive_upper_bound_(exclusive_upper_bound),
         mem_(32 * 1024),
         block_(&base_iter_->schema(), kRowsPerBlock, &mem_),
         redo_mutation_block_(kRowsPerBlock, static_cast<Mutation*>(nullptr)),
@@ -245,11 +267,27 @@ class DiskRowSetCompactionInput : public CompactionOrFlushInput {
   Status Init() override {
     ScanSpec spec;
     spec.set_cache_blocks(false);
-    RETURN_NOT_OK(base_iter_->Init(&spec));
+    rowid_t start_ordinal = 0;
+    if (lower_bound_ || exclusive_upper_bound_) {
+      // The base iterator turns the key range into a range of ordinals. The
+      // key predicates it may derive from the range hold for all of the rows
+      // in that range, so no row is filtered out of the blocks: the rows stay
+      // aligned with the deltas.
+      if (lower_bound_) {
+        spec.SetLowerBoundKey(lower_bound_);
+      }
+      if (exclusive_upper_bound_) {
+        spec.SetExclusiveUpperBoundKey(exclusive_upper_bound_);
+      }
+      RETURN_NOT_OK(base_iter_->Init(&spec));
+      start_ordinal = base_cfile_iter_->cur_ordinal_idx();
+    } else {
+      RETURN_NOT_OK(base_iter_->Init(&spec));
+    }
     RETURN_NOT_OK(redo_delta_iter_->Init(&spec));
-    RETURN_NOT_OK(redo_delta_iter_->SeekToOrdinal(0));
+    RETURN_NOT_OK(redo_delta_iter_->SeekToOrdinal(start_ordinal));
     RETURN_NOT_OK(undo_delta_iter_->Init(&spec));
-    RETURN_NOT_OK(undo_delta_iter_->SeekToOrdinal(0));
+    RETURN_NOT_OK(undo_delta_iter_->SeekToOrdinal(start_ordinal));
     return Status::OK();
   }
 
@@ -301,9 +339,13 @@ class DiskRowSetCompactionInput : public CompactionOrFlushInput {
  private:
   DISALLOW_COPY_AND_ASSIGN(DiskRowSetCompactionInput);
   unique_ptr<RowwiseIterator> base_iter_;
+  const CFileSet::Iterator* const base_cfile_iter_;
   unique_ptr<DeltaIterator> redo_delta_iter_;
   unique_ptr<DeltaIterator> undo_delta_iter_;
 
+  const EncodedKey* const lower_bound_;
+  const EncodedKey* const exclusive_upper_bound_;
+
   RowBlockMemory mem_;
 
   // The current block of data which has come from the input iterator
@@ -636,6 +678,17 @@ class MergeCompactionInput : public CompactionOrFlushInput {
 
     block->clear();
 
+    // Once a single input is left in the merge, either because the others are
+    // exhausted or because its current block dominates them, its pending rows
+    // are the next rows of the output: take them all at once.
+    if (states_.size() == 1) {
+      MergeState* state = states_[0];
+      block->assign(state->pending.begin() + state->pending_idx, state->pending.end());
+      state->pending_idx = state->pending.size();
+      prepared_block_arena_ = state->input->PreparedBlockArena();
+      return Status::OK();
+    }
+
     while (true) {
       int smallest_idx = -1;
       CompactionInputRow* smallest = nullptr;
@@ -1101,10 +1154,22 @@ Status CompactionOrFlushInput::Create(const DiskRowSet& rowset,
                                       const MvccSnapshot& snap,
                                       const IOContext* io_context,
                                       unique_ptr<CompactionOrFlushInput>* out) {
+  return Create(rowset, projection, snap, io_context, nullptr, nullptr, out);
+}
+
+Status CompactionOrFlushInput::Create(const DiskRowSet& rowset,
+                                      const Schema* projection,
+                                      const MvccSnapshot& snap,
+                                      const IOContext* io_context,
+                                      const EncodedKey* lower_bound,
+                                      const EncodedKey* exclusive_upper_bound,
+                                      unique_ptr<CompactionOrFlushInput>* out) {
   CHECK(projection->has_column_ids());
 
-  unique_ptr<ColumnwiseIterator> base_cwise(rowset.base_data_->NewIterator(projection, io_context));
-  unique_ptr<RowwiseIterator> base_iter(NewMaterializingIterator(std::move(base_cwise)));
+  unique_ptr<CFileSet::Iterator> base_cfile_iter(
+      rowset.base_data_->NewIterator(projection, io_context));
+  const CFileSet::Iterator* base_cfile_iter_ptr = base_cfile_iter.get();
+  unique_ptr<RowwiseIterator> base_iter(NewMaterializingIterator(std::move(base_cfile_iter)));
 
   // Creates a DeltaIteratorMerger that will only include the relevant REDO deltas.
   RowIteratorOptions redo_opts;
@@ -1125,8 +1190,11 @@ Status CompactionOrFlushInput::Create(const DiskRowSet& rowset,
       undo_opts, DeltaTracker::UNDOS_ONLY, &undo_deltas), "Could not open UNDOs");
 
   out->reset(new DiskRowSetCompactionInput(std::move(base_iter),
+                                           base_cfile_iter_ptr,
                                            std::move(redo_deltas),
-                                           std::move(undo_deltas)));
+                                           std::move(undo_deltas),
+                                           lower_bound,
+                                           exclusive_upper_bound));
   return Status::OK();
 }
 
@@ -1150,14 +1218,38 @@ Status RowSetsInCompactionOrFlush::CreateCompactionOrFlushInput(
     const Schema* schema,
     const IOContext* io_context,
     shared_ptr<CompactionOrFlushInput>* out) const {
+  return CreateCompactionOrFlushInput(snap, schema, io_context, nullptr, nullptr, out);
+}
+
+Status RowSetsInCompactionOrFlush::CreateCompactionOrFlushInput(
+    const MvccSnapshot& snap,
+    const Schema* schema,
+    const IOContext* io_context,
+    const EncodedKey* lower_bound,
+    const EncodedKey* exclusive_upper_bound,
+    shared_ptr<CompactionOrFlushInput>* out) const {
   CHECK(schema->has_column_ids());
+  const bool bounded = lower_bound || exclusive_upper_bound;
 
   vector<shared_ptr<CompactionOrFlushInput>> inputs;
   for (const auto& rs : rowsets_) {
     unique_ptr<CompactionOrFlushInput> input;
-    RETURN_NOT_OK_PREPEND(rs->NewCompactionInput(schema, snap, io_context, &input),
-                          Substitute("Could not create compaction input for rowset $0",
-                                     rs->ToString()));
+    if (bounded) {
+      const auto* drs = dynamic_cast<const DiskRowSet*>(rs.get());
+      if (!drs) {
+        return Status::NotSupported("only the inputs of DiskRowSets may be bounded",
+                                    rs->ToString());
+      }
+      RETURN_NOT_OK_PREPEND(CompactionOrFlushInput::Create(*drs, schema, snap, io_context,
+                                                           lower_bound, exclusive_upper_bound,
+                                                           &input),
+                            Substitute("Could not create compaction input for rowset $0",
+                                       rs->ToString()));
+    } else {
+      RETURN_NOT_OK_PREPEND(rs->NewCompactionInput(schema, snap, io_context, &input),
+                            Substitute("Could not create compaction input for rowset $0",
+                                       rs->ToString()));
+    }
     inputs.push_back(shared_ptr<CompactionOrFlushInput>(input.release()));
   }
 
@@ -1517,6 +1609,71 @@ static Status ApplyMutationsAndMergeDuplicateHistory(const MvccSnapshot& snap,
   return Status::OK();
 }
 
+// Returns whether 'row' is output as is, along with its UNDOs: it has no REDO
+// mutations to apply and no ghost versions whose history to merge.
+static bool IsUnmutatedRow(const CompactionInputRow& row) {
+  return row.redo_head == nullptr && row.previous_ghost == nullptr;
+}
+
+// Copies 'num_rows' rows of 'src' starting at 'src_row_idx' into 'dst' at
+// 'dst_row_idx', one column at a time. Like CopyRow() without an arena, the
+// indirect data isn't relocated: the copied cells keep pointing into the
+// memory of 'src'.
+static void CopyRowsByColumn(const RowBlock& src, size_t src_row_idx,
+                             size_t dst_row_idx, size_t num_rows, RowBlock* dst) {
+  DCHECK_SCHEMA_EQ(*src.schema(), *dst->schema());
+  DCHECK_LE(src_row_idx + num_rows, src.nrows());
+  DCHECK_LE(dst_row_idx + num_rows, dst->nrows());
+  for (size_t col_idx = 0; col_idx < src.schema()->num_columns(); col_idx++) {
+    ColumnBlock src_cb(src.column_block(col_idx));
+    ColumnBlock dst_cb(dst->column_block(col_idx));
+    const size_t stride = src_cb.stride();
+    memcpy(dst_cb.data() + dst_row_idx * stride,
+           src_cb.data() + src_row_idx * stride,
+           num_rows * stride);
+    if (src_cb.is_nullable()) {
+      BitmapCopy(dst_cb.non_null_bitmap(), dst_row_idx,
+                 src_cb.non_null_bitmap(), src_row_idx,
+                 num_rows);
+    }
+  }
+}
+
+// Appends the run of 'num_rows' unmutated rows starting at 'rows' (see
+// IsUnmutatedRow()), which are consecutive rows of the same input block, to
+// 'block' at 'cur_row_idx'. This is equivalent to, but cheaper than, calling
+// ApplyMutationsAndMergeDuplicateHistory() on each of them: there's nothing
+// to apply or to merge, only ancient UNDOs to remove.
+static Status AppendUnmutatedRows(const CompactionInputRow* rows,
+                                  size_t num_rows,
+                                  size_t cur_row_idx,
+                                  RowBlock* block,
+                                  const HistoryGcOpts& history_gc_opts,
+                                  RollingDiskRowSetWriter* out,
+                                  int* live_row_count) {
+  // Rolling only ever happens before the first row of an output block.
+  RETURN_NOT_OK(out->RollIfNecessary());
+  CopyRowsByColumn(*rows[0].row.row_block(), rows[0].row.row_index(),
+                   cur_row_idx, num_rows, block);
+  for (size_t i = 0; i < num_rows; i++) {
+    Mutation* new_undos_head = const_cast<Mutation*>(rows[i].undo_head);
+    // Rows without a REDO DELETE are never garbage collected.
+    const bool is_garbage_collected =
+        RemoveAncientUndos(history_gc_opts, nullptr, &new_undos_head);
+    DCHECK(!is_garbage_collected);
+    if (new_undos_head != nullptr) {
+      rowid_t index_in_current_drs;
+      RETURN_NOT_OK(out->AppendUndoDeltas(cur_row_idx + i, new_undos_head,
+                                          &index_in_current_drs));
+    }
+#ifndef NDEBUG
+    UndoListSanityCheck(new_undos_head);
+#endif // NDEBUG
+  }
+  *live_row_count += num_rows;
+  return Status::OK();
+}
+
 // Following method processes the compaction input by reading input rows in
 // blocks and for each row inside the block:
 // - Apply all REDO mutations collected for the row at hand.
@@ -1543,7 +1700,40 @@ Status FlushCompactionInput(const string& tablet_id,
 
     size_t cur_row_idx = 0;
     int live_row_count = 0;
-    for (const auto& row : rows) {
+    for (size_t i = 0; i < rows.size(); i++) {
+      const auto& row = rows[i];
+      if (history_gc_opts.IsExpired(row.row)) {
+        // Rows expired by the row TTL are garbage collected with their history.
+        continue;
+      }
+      if (FLAGS_compaction_copy_unmutated_rows_by_column && IsUnmutatedRow(row)) {
+        // Extend the run of unmutated rows as far as they're consecutive in
+        // their input block and fit in the output block.
+        size_t run_length = 1;
+        const size_t max_run_length = std::min(rows.size() - i, block.nrows() - cur_row_idx);
+        while (run_length < max_run_length) {
+          const auto& next = rows[i + run_length];
+          if (!IsUnmutatedRow(next) ||
+              history_gc_opts.IsExpired(next.row) ||
+              next.row.row_block() != row.row.row_block() ||
+              next.row.row_index() != row.row.row_index() + run_length) {
+            break;
+          }
+          run_length++;
+        }
+        RETURN_NOT_OK(AppendUnmutatedRows(&row, run_length, cur_row_idx, &block,
+                                          history_gc_opts, out, &live_row_count));
+        i += run_length - 1;
+        cur_row_idx += run_length;
+        if (cur_row_idx == block.nrows()) {
+          // Append fully processed rowblock to DRS writer output.
+          RETURN_NOT_OK(out->AppendBlock(block, live_row_count));
+          live_row_count = 0;
+          cur_row_idx = 0;
+        }
+        continue;
+      }
+
       bool is_garbage_collected = false;
 
       RETURN_NOT_OK(ApplyMutationsAndMergeDuplicateHistory(snap,
@@ -1623,6 +1813,14 @@ Status ReupdateMissedDeltas(const IOContext* io_context,
     for (const auto& row : rows) {
       DVLOG(4) << "Revisiting row: " << CompactionInputRowToString(row);
 
+      // Rows expired by the row TTL were garbage collected at flush time, along
+      // with any missed updates: the row TTL hides them from the scans anyway.
+      if (history_gc_opts.IsExpired(row.row)) {
+        DVLOG(4) << "Skipping expired input row: " << schema->DebugRow(row.row)
+                 << " while reupdating missed deltas";
+        continue;
+      }
+
       bool is_garbage_collected = false;
       for (const auto* mut = row.redo_head;
            mut != nullptr;
@@ -18,6 +18,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -35,6 +36,7 @@
 namespace kudu {
 
 class Arena;
+class EncodedKey;
 class Schema;
 
 namespace fs {
@@ -79,10 +81,33 @@ class HistoryGcOpts {
     return ancient_history_mark_;
   }
 
+  // Returns a copy of these options which also garbage-collects the rows
+  // expired by a row TTL, i.e. the rows whose cell of the key column at index
+  // 'col_idx', holding microseconds since the Unix epoch, is below
+  // 'cutoff_micros'.
+  HistoryGcOpts WithRowTtl(int col_idx, int64_t cutoff_micros) const {
+    return HistoryGcOpts(gc_enabled_, ancient_history_mark_, col_idx, cutoff_micros);
+  }
+
+  // Returns true if 'row' is expired by the row TTL of these options, if any.
+  // As the TTL column is a key column, this only depends on the base row.
+  template<class RowType>
+  bool IsExpired(const RowType& row) const {
+    if (row_ttl_col_idx_ < 0) {
+      return false;
+    }
+    int64_t micros;
+    memcpy(&micros, row.cell_ptr(row_ttl_col_idx_), sizeof(micros));
+    return micros < row_ttl_cutoff_micros_;
+  }
+
  private:
-  HistoryGcOpts(bool gc_enabled, Timestamp ahm)
+  HistoryGcOpts(bool gc_enabled, Timestamp ahm,
+                int row_ttl_col_idx = -1, int64_t row_ttl_cutoff_micros = 0)
       : gc_enabled_(gc_enabled),
-        ancient_history_mark_(ahm) {
+        ancient_history_mark_(ahm),
+        row_ttl_col_idx_(row_ttl_col_idx),
+        row_ttl_cutoff_micros_(row_ttl_cutoff_micros) {
   }
 
   // Whether historical records prior to the ancient history mark should be
@@ -92,6 +117,11 @@ class HistoryGcOpts {
   // A timestamp prior to which no history will be preserved.
   // Ignored if 'enabled' != GC_ENABLED.
   const Timestamp ancient_history_mark_;
+
+  // The index of the TTL column of the rows, or -1 if there is no row TTL,
+  // and the value of the column below which the rows are expired.
+  const int row_ttl_col_idx_;
+  const int64_t row_ttl_cutoff_micros_;
 };
 
 // Interface for an input feeding into a compaction or flush.
@@ -112,6 +142,18 @@ class CompactionOrFlushInput {
                        const fs::IOContext* io_context,
                        std::unique_ptr<CompactionOrFlushInput>* out);
 
+  // Same as above, but only yielding the rows of the rowset whose keys are in
+  // [lower_bound, exclusive_upper_bound). Either bound may be null, in which
+  // case the range is unbounded on that side. The bounds must remain valid for
+  // the lifetime of the returned CompactionOrFlushInput.
+  static Status Create(const DiskRowSet& rowset,
+                       const Schema* projection,
+                       const MvccSnapshot& snap,
+                       const fs::IOContext* io_context,
+                       const EncodedKey* lower_bound,
+                       const EncodedKey* exclusive_upper_bound,
+                       std::unique_ptr<CompactionOrFlushInput>* out);
+
   // Create an input which reads from the given memrowset, yielding base rows and updates
   // prior to the given snapshot.
   static CompactionOrFlushInput* Create(const MemRowSet& memrowset,
@@ -165,6 +207,17 @@ class RowSetsInCompactionOrFlush {
                                       const fs::IOContext* io_context,
                                       std::shared_ptr<CompactionOrFlushInput>* out) const;
 
+  // Same as above, but only yielding the rows whose keys are in
+  // [lower_bound, exclusive_upper_bound), so that the sub-ranges of a
+  // compaction may be written concurrently. Either bound may be null. Only
+  // supported if all of the rowsets are DiskRowSets.
+  Status CreateCompactionOrFlushInput(const MvccSnapshot& snap,
+                                      const Schema* schema,
+                                      const fs::IOContext* io_context,
+                                      const EncodedKey* lower_bound,
+                                      const EncodedKey* exclusive_upper_bound,
+                                      std::shared_ptr<CompactionOrFlushInput>* out) const;
+
   // Dump a log message indicating the chosen rowsets.
   void DumpToLog() const;
 
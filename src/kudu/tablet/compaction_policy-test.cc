@@ -33,6 +33,7 @@
 #include <glog/stl_logging.h>
 #include <gtest/gtest.h>
 
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/split.h"
@@ -54,6 +55,7 @@ using std::string;
 using std::vector;
 
 DECLARE_double(compaction_minimum_improvement);
+DECLARE_double(compaction_read_hotness_weight);
 DECLARE_double(compaction_small_rowset_tradeoff);
 DECLARE_int64(budgeted_compaction_target_rowset_size);
 
@@ -200,6 +202,63 @@ TEST_F(TestCompactionPolicy, TestSignificantOverlap) {
   ASSERT_GT(quality, 0.5);
 }
 
+// Test that, when weighing the rowsets by their reads, the compaction policy
+// favors compacting the rowsets which are read over the rowsets whose
+// compaction would reduce the height of the tablet the most.
+TEST_F(TestCompactionPolicy, TestReadHotnessWeight) {
+  // This tests the overlap-based part of compaction policy and not the
+  // rowset-size based policy.
+  FLAGS_compaction_small_rowset_tradeoff = 0.0;
+
+  /*
+   * [A -- B]         (cold)
+   * [A -- B]         (cold)
+   * [A -- B]         (cold)
+   *          [C -- D] (hot)
+   *          [C -- D] (hot)
+   */
+  const auto hot_rowset_1 = std::make_shared<MockDiskRowSet>("C", "D");
+  const auto hot_rowset_2 = std::make_shared<MockDiskRowSet>("C", "D");
+  hot_rowset_1->set_read_rate(10);
+  hot_rowset_2->set_read_rate(10);
+  const RowSetVector rowsets = {
+    std::make_shared<MockDiskRowSet>("A", "B"),
+    std::make_shared<MockDiskRowSet>("A", "B"),
+    std::make_shared<MockDiskRowSet>("A", "B"),
+    hot_rowset_1,
+    hot_rowset_2,
+  };
+
+  // The budget only fits two rowsets.
+  constexpr auto kBudgetMb = 2;
+
+  // By default, the cold rowsets are picked since more of the data lies in
+  // their key range.
+  CompactionSelection picked;
+  double quality = 0.0;
+  NO_FATALS(RunTestCase(rowsets, kBudgetMb, &picked, &quality));
+  ASSERT_EQ(2, picked.size());
+  ASSERT_FALSE(ContainsKey(picked, hot_rowset_1.get()));
+  ASSERT_FALSE(ContainsKey(picked, hot_rowset_2.get()));
+
+  // Weighing by reads, the hot rowsets are picked.
+  FLAGS_compaction_read_hotness_weight = 0.9;
+  picked.clear();
+  NO_FATALS(RunTestCase(rowsets, kBudgetMb, &picked, &quality));
+  ASSERT_EQ(2, picked.size());
+  ASSERT_TRUE(ContainsKey(picked, hot_rowset_1.get()));
+  ASSERT_TRUE(ContainsKey(picked, hot_rowset_2.get()));
+
+  // Without any reads, the rowsets are weighed uniformly.
+  hot_rowset_1->set_read_rate(0);
+  hot_rowset_2->set_read_rate(0);
+  picked.clear();
+  NO_FATALS(RunTestCase(rowsets, kBudgetMb, &picked, &quality));
+  ASSERT_EQ(2, picked.size());
+  ASSERT_FALSE(ContainsKey(picked, hot_rowset_1.get()));
+  ASSERT_FALSE(ContainsKey(picked, hot_rowset_2.get()));
+}
+
 // Test the adjustment we make to the quality measure that penalizes wider
 // solutions that have almost the same quality score. For example, with no
 // adjustment and inputs
@@ -450,6 +509,7 @@ double ComputeAverageRowsetHeight(
   double rowset_total_width;
   RowSetInfo::ComputeCdfAndCollectOrdered(tree,
                                           nullopt,
+                                          0,
                                           &rowset_total_height,
                                           &rowset_total_width,
                                           nullptr,
@@ -117,6 +117,19 @@ DEFINE_bool(rowset_compaction_enforce_preset_factor, false,
 TAG_FLAG(rowset_compaction_enforce_preset_factor, experimental);
 TAG_FLAG(rowset_compaction_enforce_preset_factor, runtime);
 
+DEFINE_double(compaction_read_hotness_weight, 0,
+              "How much the compaction policy weighs the rowsets by how often they "
+              "are read by scans and lookups, rather than by their size only, when "
+              "estimating the benefit of reducing the height of the tablet in their "
+              "key ranges. With 0, all the data counts the same; with 1, the data "
+              "which isn't read recently doesn't count, so that e.g. the cold history "
+              "of a time series table isn't compacted. Values in between blend both. "
+              "See --rowset_read_rate_half_life_secs for what 'recently' means.");
+TAG_FLAG(compaction_read_hotness_weight, experimental);
+TAG_FLAG(compaction_read_hotness_weight, runtime);
+DEFINE_validator(compaction_read_hotness_weight,
+                 [](const char* /*n*/, double v) { return v >= 0 && v <= 1; });
+
 namespace kudu {
 namespace tablet {
 
@@ -211,6 +224,7 @@ void BudgetedCompactionPolicy::SetupKnapsackInput(
 
   RowSetInfo::ComputeCdfAndCollectOrdered(tree,
                                           make_optional(is_on_memory_budget),
+                                          FLAGS_compaction_read_hotness_weight,
                                           /*rowset_total_height=*/nullptr,
                                           /*rowset_total_width=*/nullptr,
                                           asc_min_key,
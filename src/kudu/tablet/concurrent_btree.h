@@ -43,11 +43,13 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <boost/smart_ptr/detail/yield_k.hpp>
 #include <boost/utility/binary.hpp>
 #include <memory>
 #include <string>
 
+#include "kudu/gutil/endian.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/mathlimits.h"
 #include "kudu/gutil/port.h"
@@ -84,7 +86,14 @@ struct BTreeTraits {
     // Tests can set this trait to a non-zero value, which inserts
     // some pause-loops in key parts of the code to try to simulate
     // races.
-    kDebugRaciness = 0
+    kDebugRaciness = 0,
+
+    // If non-zero, leaf nodes keep the first 8 bytes of each of their keys
+    // in an array of integers, so that searching a leaf only dereferences
+    // the keys whose prefix is equal to the prefix of the search key. This
+    // costs 8 bytes per entry, so it's only worth it for trees whose keys
+    // are usually longer than what an InlineSlice stores inline.
+    kInlineKeyPrefixes = 0
   };
   typedef ThreadSafeArena ArenaType;
 };
@@ -326,11 +335,11 @@ class ValueSlice {
   const uint8_t* ptr_;
 } PACKED;
 
-// Return the index of the first entry in the array which is
-// >= the given value
-template<size_t N>
-size_t FindInSliceArray(const InlineSlice<N, true> *array, ssize_t num_entries,
-                        const Slice &key, bool *exact) {
+// Return the index of the first entry of a sorted array of 'num_entries'
+// entries which is >= the search key, where 'compare(i)' compares the
+// i-th entry to the search key.
+template<class Compare>
+size_t FindInSortedArray(ssize_t num_entries, const Compare& compare, bool *exact) {
   DCHECK_GE(num_entries, 0);
 
   if (PREDICT_FALSE(num_entries == 0)) {
@@ -343,12 +352,10 @@ size_t FindInSliceArray(const InlineSlice<N, true> *array, ssize_t num_entries,
 
   while (left < right) {
     int mid = (left + right + 1) / 2;
-    // TODO: inline slices with more than 8 bytes will store a prefix of the
-    // slice inline, which we could use to short circuit some of these comparisons.
-    int compare = array[mid].as_slice().compare(key);
-    if (compare < 0) { // mid < key
+    int c = compare(mid);
+    if (c < 0) { // mid < key
       left = mid;
-    } else if (compare > 0) { // mid > search
+    } else if (c > 0) { // mid > search
       right = mid - 1;
     } else { // mid == search
       *exact = true;
@@ -356,14 +363,51 @@ size_t FindInSliceArray(const InlineSlice<N, true> *array, ssize_t num_entries,
     }
   }
 
-  int compare = array[left].as_slice().compare(key);
-  *exact = compare == 0;
-  if (compare < 0) { // key > left
+  int c = compare(left);
+  *exact = c == 0;
+  if (c < 0) { // key > left
     left++;
   }
   return left;
 }
 
+// Return the index of the first entry in the array which is
+// >= the given value
+template<size_t N>
+size_t FindInSliceArray(const InlineSlice<N, true> *array, ssize_t num_entries,
+                        const Slice &key, bool *exact) {
+  return FindInSortedArray(num_entries, [&](size_t idx) {
+      return array[idx].as_slice().compare(key);
+    }, exact);
+}
+
+// Return the first 8 bytes of 'key' as a big-endian integer, padded with
+// zeros if the key is shorter.
+//
+// If the prefix of a key is lower than the prefix of another key, then the
+// key is lower than the other key, so only keys with equal prefixes need
+// to be compared in full.
+inline uint64_t KeyPrefix(const Slice &key) {
+  uint64_t prefix = 0;
+  memcpy(&prefix, key.data(), std::min<size_t>(key.size(), sizeof(prefix)));
+  return BigEndian::ToHost64(prefix);
+}
+
+// Like FindInSliceArray(), where 'prefixes' holds the KeyPrefix() of each
+// entry of 'array'.
+template<size_t N>
+size_t FindInPrefixedSliceArray(const uint64_t *prefixes,
+                                const InlineSlice<N, true> *array, ssize_t num_entries,
+                                const Slice &key, bool *exact) {
+  const uint64_t key_prefix = KeyPrefix(key);
+  return FindInSortedArray(num_entries, [&](size_t idx) {
+      if (prefixes[idx] != key_prefix) {
+        return prefixes[idx] < key_prefix ? -1 : 1;
+      }
+      return array[idx].as_slice().compare(key);
+    }, exact);
+}
+
 
 template<class ISlice, class ArenaType>
 static void InsertInSliceArray(ISlice *array, size_t num_entries,
@@ -760,6 +804,12 @@ class LeafNode : public NodeBase<Traits> {
     // The following inserts should always succeed because we
     // verified that there is space available above.
     num_entries_++;
+    if (Traits::kInlineKeyPrefixes) {
+      for (size_t i = num_entries_ - 1; i > idx; i--) {
+        key_prefixes_[i] = key_prefixes_[i - 1];
+      }
+      key_prefixes_[idx] = KeyPrefix(key);
+    }
     InsertInSliceArray(keys_, num_entries_, key, idx, arena);
     DebugRacyPoint<Traits>();
     InsertInSliceArray(vals_, num_entries_, val, idx, arena);
@@ -776,6 +826,9 @@ class LeafNode : public NodeBase<Traits> {
   // Note that, if the lock is not held, this may return
   // bogus results, in which case OCC must be used to verify.
   size_t Find(const Slice &key, bool *exact) const {
+    if (Traits::kInlineKeyPrefixes) {
+      return FindInPrefixedSliceArray(key_prefixes_, keys_, num_entries_, key, exact);
+    }
     return FindInSliceArray(keys_, num_entries_, key, exact);
   }
 
@@ -851,11 +904,15 @@ class LeafNode : public NodeBase<Traits> {
                         + sizeof(LeafNode<Traits>*) // next_
                         + sizeof(uint8_t), // num_entries_
     kv_space = Traits::kLeafNodeSize - constant_overhead,
-    kMaxEntries = kv_space / (sizeof(KeyInlineSlice) + sizeof(ValueSlice))
+    prefix_size = Traits::kInlineKeyPrefixes ? sizeof(uint64_t) : 0,
+    kMaxEntries = kv_space / (prefix_size + sizeof(KeyInlineSlice) + sizeof(ValueSlice)),
+    kNumKeyPrefixes = Traits::kInlineKeyPrefixes ? kMaxEntries : 0
   };
 
   // This ordering of members keeps KeyInlineSlices so pointers are aligned
   LeafNode<Traits>* next_;
+  // The KeyPrefix() of each key, if Traits::kInlineKeyPrefixes is set.
+  uint64_t key_prefixes_[kNumKeyPrefixes];
   KeyInlineSlice keys_[kMaxEntries];
   ValueSlice vals_[kMaxEntries];
   uint8_t num_entries_;
@@ -1458,12 +1515,14 @@ class CBTree {
   }
 
   // Split the given leaf node 'node', creating a new node
-  // with the higher half of the elements.
+  // with the higher half of the elements. If 'append' is true,
+  // the new node is created empty instead, leaving 'node' full.
   //
   // N.B: the new node is initially locked, but doesn't have the
   // SPLITTING flag. This function sets the SPLITTING flag before
   // modifying it.
   void SplitLeafNode(LeafNode<Traits> *node,
+                     bool append,
                      LeafNode<Traits> **new_node) {
     DCHECK(node->IsLockedUnsafe());
 
@@ -1485,11 +1544,16 @@ class CBTree {
     LeafNode<Traits> *new_leaf = NewLeaf(true);
     new_leaf->next_ = node->next_;
 
-    // Copy half the keys from node into the new leaf
-    int copy_start = node->num_entries() / 2;
+    // Copy half the keys from node into the new leaf, or none of them
+    // when appending.
+    int copy_start = append ? node->num_entries() : node->num_entries() / 2;
     CHECK_GT(copy_start, 0) <<
       "Trying to split a node with 0 or 1 entries";
 
+    if (Traits::kInlineKeyPrefixes) {
+      std::copy(node->key_prefixes_ + copy_start, node->key_prefixes_ + node->num_entries(),
+                new_leaf->key_prefixes_);
+    }
     std::copy(node->keys_ + copy_start, node->keys_ + node->num_entries(),
               new_leaf->keys_);
     std::copy(node->vals_ + copy_start, node->vals_ + node->num_entries(),
@@ -1520,23 +1584,34 @@ class CBTree {
 
     //DebugPrint();
 
+    // When the key goes past the end of the node, as with the monotonically
+    // increasing keys of append-mostly workloads, splitting the node in half
+    // would leave it half-empty for good. Start a new node instead, so that
+    // such trees have full leaves: this halves the memory of their leaves,
+    // and the number of leaves to walk when scanning and flushing them.
+    const bool append = key.compare(node->GetKey(node->num_entries() - 1)) > 0;
+
     LeafNode<Traits> *new_leaf;
-    SplitLeafNode(node, &new_leaf);
+    SplitLeafNode(node, append, &new_leaf);
 
     // The new leaf node is returned still locked.
     DCHECK(new_leaf->IsLockedUnsafe());
 
     // Insert the key that we were originally trying to insert in the
     // correct side post-split.
-    Slice split_key = new_leaf->GetKey(0);
-    LeafNode<Traits> *dst_leaf = (key.compare(split_key) < 0) ? node : new_leaf;
+    LeafNode<Traits> *dst_leaf;
+    if (append) {
+      dst_leaf = new_leaf;
+    } else {
+      dst_leaf = (key.compare(new_leaf->GetKey(0)) < 0) ? node : new_leaf;
+    }
     // Re-prepare the mutation after the split.
     dst_leaf->PrepareMutation(mutation);
 
     CHECK_EQ(INSERT_SUCCESS, dst_leaf->Insert(mutation, val))
-      << "node split at " << KUDU_REDACT(split_key.ToDebugString())
-      << " did not result in enough space for key " << KUDU_REDACT(key.ToDebugString())
-      << " in left node";
+      << "node split did not result in enough space for key "
+      << KUDU_REDACT(key.ToDebugString());
+    Slice split_key = new_leaf->GetKey(0);
 
     // Insert the new node into the parents.
     PropagateSplitUpward(node, new_leaf, split_key);
@@ -17,14 +17,17 @@
 
 #include "kudu/tablet/delta_compaction.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/common/generic_iterators.h"
@@ -42,8 +45,10 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/tablet/cfile_set.h"
 #include "kudu/tablet/compaction.h"
+#include "kudu/tablet/delta_iterator_merger.h"
 #include "kudu/tablet/delta_key.h"
 #include "kudu/tablet/delta_stats.h"
 #include "kudu/tablet/delta_tracker.h"
@@ -51,9 +56,35 @@
 #include "kudu/tablet/multi_column_writer.h"
 #include "kudu/tablet/mutation.h"
 #include "kudu/tablet/mvcc.h"
+#include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 
+DEFINE_int32(major_delta_compaction_threads, 0,
+             "Number of threads of a shared pool that help major delta "
+             "compactions. A major delta compaction of at least "
+             "--major_delta_compaction_parallel_min_bytes of REDO deltas "
+             "splits the columns it rewrites into sets, one of which is "
+             "compacted by the compacting thread itself and the others "
+             "concurrently by the pool. If 0, major delta compactions are not "
+             "split.");
+TAG_FLAG(major_delta_compaction_threads, advanced);
+TAG_FLAG(major_delta_compaction_threads, experimental);
+TAG_FLAG(major_delta_compaction_threads, runtime);
+DEFINE_validator(major_delta_compaction_threads,
+                 [](const char* /*n*/, int32 v) { return v >= 0; });
+
+DEFINE_int64(major_delta_compaction_parallel_min_bytes, 64 * 1024 * 1024,
+             "The minimum estimated size of the REDO deltas of a major delta "
+             "compaction for its columns to be split into sets compacted "
+             "concurrently. See --major_delta_compaction_threads.");
+TAG_FLAG(major_delta_compaction_parallel_min_bytes, advanced);
+TAG_FLAG(major_delta_compaction_parallel_min_bytes, experimental);
+TAG_FLAG(major_delta_compaction_parallel_min_bytes, runtime);
+
 namespace kudu {
 class Arena;
 }
@@ -75,6 +106,22 @@ namespace {
 
 const size_t kRowsPerBlock = 100; // Number of rows per block of columns
 
+// Returns the pool compacting the column sets of split major delta
+// compactions, created on first use.
+ThreadPool* ColumnSetCompactionPool() {
+  static std::once_flag once;
+  static ThreadPool* pool = nullptr;
+  std::call_once(once, []() {
+    unique_ptr<ThreadPool> p;
+    CHECK_OK(ThreadPoolBuilder("mdc-column-set")
+             .set_min_threads(0)
+             .set_max_threads(base::NumCPUs())
+             .Build(&p));
+    pool = p.release();
+  });
+  return pool;
+}
+
 } // anonymous namespace
 
 // TODO: can you major-delta-compact a new column after an alter table in order
@@ -89,6 +136,8 @@ MajorDeltaCompaction::MajorDeltaCompaction(
     : fs_manager_(fs_manager),
       base_schema_(base_schema),
       column_ids_(std::move(col_ids)),
+      base_col_ids_(column_ids_),
+      write_redos_(true),
       history_gc_opts_(std::move(history_gc_opts)),
       base_data_(base_data),
       included_stores_(std::move(included_stores)),
@@ -100,6 +149,27 @@ MajorDeltaCompaction::MajorDeltaCompaction(
   CHECK(!column_ids_.empty());
 }
 
+MajorDeltaCompaction::MajorDeltaCompaction(
+    FsManager* fs_manager, const Schema& base_schema, CFileSet* base_data,
+    unique_ptr<DeltaIterator> delta_iter,
+    vector<ColumnId> col_ids,
+    HistoryGcOpts history_gc_opts,
+    string tablet_id)
+    : fs_manager_(fs_manager),
+      base_schema_(base_schema),
+      column_ids_(std::move(col_ids)),
+      base_col_ids_(column_ids_),
+      write_redos_(false),
+      history_gc_opts_(std::move(history_gc_opts)),
+      base_data_(base_data),
+      delta_iter_(std::move(delta_iter)),
+      tablet_id_(std::move(tablet_id)),
+      redo_delta_mutations_written_(0),
+      undo_delta_mutations_written_(0),
+      state_(kInitialized) {
+  CHECK(!column_ids_.empty());
+}
+
 MajorDeltaCompaction::~MajorDeltaCompaction() {
 }
 
@@ -208,6 +278,13 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas(const IOContext* io_context) {
     // 4) Write the new base data.
     RETURN_NOT_OK(base_data_writer_->AppendBlock(block));
 
+    // The REDO deltas are written back by a single one of the compactions of
+    // a split compaction.
+    if (!write_redos_) {
+      nrows += n;
+      continue;
+    }
+
     // 5) Remove the columns that we've done our major REDO delta compaction on
     //    from this delta flush, except keep all the delete and reinsert
     //    mutations.
@@ -327,7 +404,6 @@ Status MajorDeltaCompaction::Compact(const IOContext* io_context) {
   CHECK_EQ(state_, kInitialized);
 
   VLOG(1) << "Starting major delta compaction for columns " << ColumnNamesToString();
-  RETURN_NOT_OK(base_schema_.CreateProjectionByIdsIgnoreMissing(column_ids_, &partial_schema_));
 
   if (VLOG_IS_ON(1)) {
     for (const auto& ds : included_stores_) {
@@ -336,8 +412,25 @@ Status MajorDeltaCompaction::Compact(const IOContext* io_context) {
   }
 
   // We defer calling OpenRedoDeltaFileWriter() since we might not need to flush.
-  RETURN_NOT_OK(OpenBaseDataWriter());
-  RETURN_NOT_OK(FlushRowSetAndDeltas(io_context));
+  RETURN_NOT_OK(SplitColumnSets(io_context));
+  RETURN_NOT_OK(CompactColumnSets(io_context));
+
+  // Gather the UNDO delta blocks of all the column sets, ordered as the
+  // delta tracker keeps them.
+  vector<MajorDeltaCompaction*> compactions = { this };
+  for (const auto& c : column_set_compactions_) {
+    compactions.push_back(c.get());
+  }
+  for (auto* c : compactions) {
+    if (c->undo_delta_mutations_written_ > 0) {
+      new_undo_blocks_.emplace_back(c->new_undo_delta_block_,
+                                    c->new_undo_delta_writer_->release_delta_stats());
+    }
+  }
+  std::sort(new_undo_blocks_.begin(), new_undo_blocks_.end(),
+            [](const DeltaBlockIdAndStats& a, const DeltaBlockIdAndStats& b) {
+              return a.second->min_timestamp() > b.second->min_timestamp();
+            });
 
   TRACE_COUNTER_INCREMENT("delta_blocks_compacted", included_stores_.size());
   const auto stats = ComputeDeltaStoreStats(included_stores_);
@@ -352,6 +445,100 @@ Status MajorDeltaCompaction::Compact(const IOContext* io_context) {
   return Status::OK();
 }
 
+Status MajorDeltaCompaction::SplitColumnSets(const IOContext* io_context) {
+  DCHECK(column_set_compactions_.empty());
+  if (FLAGS_major_delta_compaction_threads == 0) {
+    return Status::OK();
+  }
+  int64_t delta_bytes = 0;
+  for (const auto& store : included_stores_) {
+    // A DELETE or REINSERT turns into UNDOs of whole rows which must be
+    // written once, so such compactions aren't split. Neither are those of
+    // stores whose stats aren't known yet.
+    if (!store->has_delta_stats() ||
+        store->delta_stats().delete_count() > 0 ||
+        store->delta_stats().reinsert_count() > 0) {
+      return Status::OK();
+    }
+    delta_bytes += store->EstimateSize();
+  }
+  if (delta_bytes < FLAGS_major_delta_compaction_parallel_min_bytes) {
+    return Status::OK();
+  }
+
+  // Only the columns present in the schema are split off: there is no base
+  // data to rewrite for the deleted ones.
+  vector<ColumnId> present_col_ids;
+  vector<ColumnId> deleted_col_ids;
+  for (ColumnId col_id : column_ids_) {
+    if (base_schema_.find_column_by_id(col_id) != Schema::kColumnNotFound) {
+      present_col_ids.push_back(col_id);
+    } else {
+      deleted_col_ids.push_back(col_id);
+    }
+  }
+  const size_t num_sets = std::min<size_t>(FLAGS_major_delta_compaction_threads + 1,
+                                           present_col_ids.size());
+  if (num_sets <= 1) {
+    return Status::OK();
+  }
+
+  RowIteratorOptions opts;
+  opts.projection = &base_schema_;
+  opts.io_context = io_context;
+  vector<vector<ColumnId>> col_id_sets(num_sets);
+  for (size_t i = 0; i < num_sets; i++) {
+    col_id_sets[i].assign(present_col_ids.begin() + i * present_col_ids.size() / num_sets,
+                          present_col_ids.begin() + (i + 1) * present_col_ids.size() / num_sets);
+  }
+  for (size_t i = 1; i < num_sets; i++) {
+    unique_ptr<DeltaIterator> delta_iter;
+    RETURN_NOT_OK(DeltaIteratorMerger::Create(included_stores_, opts, &delta_iter));
+    column_set_compactions_.emplace_back(new MajorDeltaCompaction(
+        fs_manager_, base_schema_, base_data_, std::move(delta_iter),
+        std::move(col_id_sets[i]), history_gc_opts_, tablet_id_));
+  }
+  base_col_ids_ = std::move(col_id_sets[0]);
+  base_col_ids_.insert(base_col_ids_.end(), deleted_col_ids.begin(), deleted_col_ids.end());
+  VLOG(1) << Substitute("Splitting major delta compaction of $0 bytes of deltas into $1 "
+                        "column sets", delta_bytes, num_sets);
+  return Status::OK();
+}
+
+Status MajorDeltaCompaction::CompactColumnSets(const IOContext* io_context) {
+  const auto compact = [io_context](MajorDeltaCompaction* c) -> Status {
+    RETURN_NOT_OK(c->base_schema_.CreateProjectionByIdsIgnoreMissing(c->base_col_ids_,
+                                                                     &c->partial_schema_));
+    RETURN_NOT_OK(c->OpenBaseDataWriter());
+    return c->FlushRowSetAndDeltas(io_context);
+  };
+
+  // The other column sets are handed to the pool, and the first one is
+  // compacted by this thread meanwhile. If the pool is unavailable, the
+  // column sets are compacted inline.
+  const size_t num_sets = column_set_compactions_.size();
+  vector<Status> statuses(num_sets);
+  CountDownLatch latch(num_sets);
+  for (size_t i = 0; i < num_sets; i++) {
+    MajorDeltaCompaction* c = column_set_compactions_[i].get();
+    Status* s = &statuses[i];
+    const auto task = [&compact, &latch, c, s]() {
+      *s = compact(c);
+      latch.CountDown();
+    };
+    if (PREDICT_FALSE(!ColumnSetCompactionPool()->Submit(task).ok())) {
+      task();
+    }
+  }
+  const Status s = compact(this);
+  latch.Wait();
+  RETURN_NOT_OK(s);
+  for (const auto& set_s : statuses) {
+    RETURN_NOT_OK_PREPEND(set_s, "Unable to compact column set");
+  }
+  return Status::OK();
+}
+
 void MajorDeltaCompaction::CreateMetadataUpdate(
     RowSetMetadataUpdate* update) {
   CHECK(update);
@@ -371,13 +558,23 @@ void MajorDeltaCompaction::CreateMetadataUpdate(
   update->ReplaceRedoDeltaBlocks(compacted_delta_blocks,
                                  new_delta_blocks);
 
-  if (undo_delta_mutations_written_ > 0) {
-    update->SetNewUndoBlock(new_undo_delta_block_);
+  if (!new_undo_blocks_.empty()) {
+    vector<BlockId> new_undo_block_ids;
+    new_undo_block_ids.reserve(new_undo_blocks_.size());
+    for (const auto& block_and_stats : new_undo_blocks_) {
+      new_undo_block_ids.push_back(block_and_stats.first);
+    }
+    update->SetNewUndoBlocks(new_undo_block_ids);
   }
 
   // Replace old column blocks with new ones
   std::map<ColumnId, BlockId> new_column_blocks;
   base_data_writer_->GetFlushedBlocksByColumnId(&new_column_blocks);
+  for (const auto& c : column_set_compactions_) {
+    std::map<ColumnId, BlockId> column_set_blocks;
+    c->base_data_writer_->GetFlushedBlocksByColumnId(&column_set_blocks);
+    new_column_blocks.insert(column_set_blocks.begin(), column_set_blocks.end());
+  }
 
   // NOTE: in the case that one of the columns being compacted is deleted,
   // we may have fewer elements in new_column_blocks compared to 'column_ids'.
@@ -427,13 +624,10 @@ Status MajorDeltaCompaction::UpdateDeltaTracker(DeltaTracker* tracker,
   RETURN_NOT_OK(tracker->OpenDeltaReaders(std::move(new_redo_blocks), io_context,
                                           &new_redo_stores, REDO));
 
-  // Create blocks for the new undo deltas.
+  // Create blocks for the new undo deltas, one per column set.
   SharedDeltaStoreVector new_undo_stores;
-  if (undo_delta_mutations_written_ > 0) {
-    vector<DeltaBlockIdAndStats> new_undo_blocks;
-    new_undo_blocks.emplace_back(std::make_pair(new_undo_delta_block_,
-        new_undo_delta_writer_->release_delta_stats()));
-    RETURN_NOT_OK(tracker->OpenDeltaReaders(std::move(new_undo_blocks), io_context,
+  if (!new_undo_blocks_.empty()) {
+    RETURN_NOT_OK(tracker->OpenDeltaReaders(std::move(new_undo_blocks_), io_context,
                                             &new_undo_stores, UNDO));
   }
 
@@ -25,6 +25,7 @@
 #include "kudu/fs/block_id.h"
 #include "kudu/tablet/compaction.h"
 #include "kudu/tablet/delta_store.h"
+#include "kudu/tablet/delta_tracker.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -39,7 +40,6 @@ namespace tablet {
 
 class CFileSet;
 class DeltaFileWriter;
-class DeltaTracker;
 class MultiColumnWriter;
 class RowSetMetadataUpdate;
 
@@ -47,6 +47,11 @@ class RowSetMetadataUpdate;
 // of a DiskRowSet, writing out an updated DiskRowSet without re-writing the
 // unchanged columns (see RowSetColumnUpdater), and writing out a new
 // deltafile which does not contain the deltas applied to the specific rows.
+//
+// Large compactions may split the columns to rewrite into sets, each of which
+// is compacted concurrently with its own delta iterator and UNDO delta file
+// (see --major_delta_compaction_threads). Their outputs are still committed
+// as a single metadata update.
 class MajorDeltaCompaction {
  public:
   // Creates a new major delta compaction. The given 'base_data' should already
@@ -79,8 +84,26 @@ class MajorDeltaCompaction {
   Status UpdateDeltaTracker(DeltaTracker* tracker, const fs::IOContext* io_context);
 
  private:
+  // Creates a compaction rewriting only the columns 'col_ids' of the base
+  // data, on behalf of another compaction which writes back the REDO deltas.
+  MajorDeltaCompaction(
+      FsManager* fs_manager, const Schema& base_schema, CFileSet* base_data,
+      std::unique_ptr<DeltaIterator> delta_iter,
+      std::vector<ColumnId> col_ids,
+      HistoryGcOpts history_gc_opts,
+      std::string tablet_id);
+
   std::string ColumnNamesToString() const;
 
+  // Splits off the columns to rewrite into 'column_set_compactions_' if the
+  // compaction is large enough to be worth it, leaving the first set to
+  // 'base_col_ids_'.
+  Status SplitColumnSets(const fs::IOContext* io_context);
+
+  // Rewrites the columns of 'base_col_ids_', running those of
+  // 'column_set_compactions_' concurrently.
+  Status CompactColumnSets(const fs::IOContext* io_context);
+
   // Opens a writer for the base data.
   Status OpenBaseDataWriter();
 
@@ -109,6 +132,15 @@ class MajorDeltaCompaction {
   // The column ids to compact.
   const std::vector<ColumnId> column_ids_;
 
+  // The column ids whose base data this compaction rewrites itself. The other
+  // ones are rewritten by 'column_set_compactions_'.
+  std::vector<ColumnId> base_col_ids_;
+
+  // Whether this compaction writes back the REDO deltas left after compacting
+  // 'column_ids_'. This is false for the column set compactions, which only
+  // rewrite base data and write UNDO deltas.
+  const bool write_redos_;
+
   const HistoryGcOpts history_gc_opts_;
 
   // Inputs:
@@ -135,6 +167,13 @@ class MajorDeltaCompaction {
   std::unique_ptr<DeltaFileWriter> new_undo_delta_writer_;
   BlockId new_undo_delta_block_;
 
+  // The compactions of the other sets of columns, if the compaction was split.
+  std::vector<std::unique_ptr<MajorDeltaCompaction>> column_set_compactions_;
+
+  // The UNDO delta blocks written by this compaction and by
+  // 'column_set_compactions_', newest first.
+  std::vector<DeltaBlockIdAndStats> new_undo_blocks_;
+
   size_t redo_delta_mutations_written_;
   size_t undo_delta_mutations_written_;
 
@@ -25,6 +25,7 @@
 
 #include <glog/logging.h>
 
+#include "kudu/common/common.pb.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
@@ -322,13 +323,9 @@ Status DeltaPreparer<Traits>::AddDelta(const DeltaKey& key, Slice val, bool* fin
 
         ColumnUpdate& cu = updates_by_col_[col_idx].back();
         cu.row_id = key.row_idx();
-        if (col_val == nullptr) {
-          cu.new_val_ptr = nullptr;
-        } else {
+        cu.is_null = col_val == nullptr;
+        if (!cu.is_null) {
           memcpy(cu.new_val_buf, col_val, col_size);
-          // NOTE: we're constructing a pointer here to an element inside the deque.
-          // This is safe because deques never invalidate pointers to their elements.
-          cu.new_val_ptr = cu.new_val_buf;
         }
         may_have_deltas_ = true;
       }
@@ -384,13 +381,35 @@ Status DeltaPreparer<Traits>::ApplyUpdates(size_t col_to_apply, ColumnBlock* dst
   }
 
   const ColumnSchema* col_schema = &opts_.projection->column(col_to_apply);
-  for (const ColumnUpdate& cu : updates_by_col_[col_to_apply]) {
+  const UpdatesForColumn& updates = updates_by_col_[col_to_apply];
+  if (col_schema->type_info()->physical_type() != BINARY) {
+    // Fixed-size cells have no indirect data to relocate into the block's
+    // arena: scatter the new values straight into the block.
+    const size_t col_size = col_schema->type_info()->size();
+    const bool is_nullable = dst->is_nullable();
+    for (const ColumnUpdate& cu : updates) {
+      int32_t idx_in_block = cu.row_id - prev_prepared_idx_;
+      DCHECK_GE(idx_in_block, 0);
+      if (!filter.IsRowSelected(idx_in_block)) {
+        continue;
+      }
+      if (is_nullable) {
+        dst->SetCellIsNull(idx_in_block, cu.is_null);
+      }
+      if (!cu.is_null) {
+        memcpy(dst->mutable_cell_ptr(idx_in_block), cu.new_val_buf, col_size);
+      }
+    }
+    return Status::OK();
+  }
+
+  for (const ColumnUpdate& cu : updates) {
     int32_t idx_in_block = cu.row_id - prev_prepared_idx_;
     DCHECK_GE(idx_in_block, 0);
     if (!filter.IsRowSelected(idx_in_block)) {
       continue;
     }
-    SimpleConstCell src(col_schema, cu.new_val_ptr);
+    SimpleConstCell src(col_schema, cu.is_null ? nullptr : cu.new_val_buf);
     ColumnBlock::Cell dst_cell = dst->cell(idx_in_block);
     RETURN_NOT_OK(CopyCell(src, &dst_cell, dst->arena()));
   }
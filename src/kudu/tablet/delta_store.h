@@ -520,10 +520,14 @@ class DeltaPreparer : public PreparedDeltas {
   // ------------------------------------------------------------
   struct ColumnUpdate {
     rowid_t row_id;
-    void* new_val_ptr;
+    bool is_null;
+    // The new value of the cell, unless 'is_null' is set. Large enough for
+    // the biggest fixed-size type, and for the Slice of binary types.
     uint8_t new_val_buf[16];
   };
-  typedef std::deque<ColumnUpdate> UpdatesForColumn;
+  // Vectors rather than deques, so that their capacity is reused across
+  // batches instead of reallocating chunks for every new batch.
+  typedef std::vector<ColumnUpdate> UpdatesForColumn;
   std::vector<UpdatesForColumn> updates_by_col_;
 
   // A row whose last relevant mutation was DELETE (or REINSERT).
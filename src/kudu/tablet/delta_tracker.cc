@@ -34,6 +34,7 @@
 #include <glog/logging.h>
 
 #include "kudu/cfile/cfile_util.h"
+#include "kudu/clock/hybrid_clock.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
@@ -47,10 +48,12 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/delta_applier.h"
 #include "kudu/tablet/delta_iterator_merger.h"
+#include "kudu/tablet/delta_relevancy.h"
 #include "kudu/tablet/delta_stats.h"
 #include "kudu/tablet/delta_store.h"
 #include "kudu/tablet/deltafile.h"
 #include "kudu/tablet/deltamemstore.h"
+#include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet.pb.h"
@@ -260,6 +263,42 @@ string JoinDeltaStoreStrings(const SharedDeltaStoreVector& stores) {
   return ::JoinStrings(strings, ",");
 }
 
+// Estimates the ratio of the deltas described by 'stats' which are older than
+// 'ancient_history_mark', assuming their timestamps are spread uniformly in
+// time between the minimum and maximum ones.
+double EstimateAncientRatio(const DeltaStats& stats, Timestamp ancient_history_mark) {
+  if (ancient_history_mark <= stats.min_timestamp()) {
+    return 0;
+  }
+  if (ancient_history_mark > stats.max_timestamp()) {
+    return 1;
+  }
+  const auto min_micros = clock::HybridClock::GetPhysicalValueMicros(stats.min_timestamp());
+  const auto max_micros = clock::HybridClock::GetPhysicalValueMicros(stats.max_timestamp());
+  const auto ahm_micros = clock::HybridClock::GetPhysicalValueMicros(ancient_history_mark);
+  if (max_micros <= min_micros) {
+    return 0;
+  }
+  return static_cast<double>(ahm_micros - min_micros) / (max_micros - min_micros);
+}
+
+// Whether the undo delta store 'undo' holds both ancient deltas and deltas
+// which are not, with an estimated ratio of ancient ones of at least
+// 'min_ancient_ratio'.
+bool IsTruncatableUndo(const DeltaStore& undo, Timestamp ancient_history_mark,
+                       double min_ancient_ratio, double* ancient_ratio) {
+  if (!undo.has_delta_stats()) {
+    return false;
+  }
+  const auto& stats = undo.delta_stats();
+  if (stats.min_timestamp() >= ancient_history_mark ||
+      stats.max_timestamp() < ancient_history_mark) {
+    return false;
+  }
+  *ancient_ratio = EstimateAncientRatio(stats, ancient_history_mark);
+  return *ancient_ratio >= min_ancient_ratio;
+}
+
 } // anonymous namespace
 
 #ifndef NDEBUG
@@ -506,6 +545,46 @@ bool DeltaTracker::EstimateAllRedosAreAncient(Timestamp ancient_history_mark) {
       newest_redo->delta_stats().max_timestamp() < ancient_history_mark;
 }
 
+bool DeltaTracker::EstimateAllDataOlderThan(Timestamp timestamp) const {
+  std::lock_guard<rw_spinlock> lock(component_lock_);
+  const std::optional<Timestamp> dms_highest_timestamp =
+      dms_ ? dms_->highest_timestamp() : std::nullopt;
+  if (dms_highest_timestamp && *dms_highest_timestamp >= timestamp) {
+    return false;
+  }
+  // The undo delta stores are ordered newest first, the redo ones oldest first.
+  for (const auto* newest : { undo_delta_stores_.empty() ? nullptr : &undo_delta_stores_.front(),
+                              redo_delta_stores_.empty() ? nullptr : &redo_delta_stores_.back() }) {
+    if (newest && (!(*newest)->has_delta_stats() ||
+                   (*newest)->delta_stats().max_timestamp() >= timestamp)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DeltaTracker::MayHaveDeltasBetween(const MvccSnapshot& snap_to_exclude,
+                                        const MvccSnapshot& snap_to_include) const {
+  std::lock_guard<rw_spinlock> lock(component_lock_);
+  if (dms_ && !dms_->Empty()) {
+    const std::optional<Timestamp> dms_highest_timestamp = dms_->highest_timestamp();
+    if (!dms_highest_timestamp || !snap_to_exclude.IsApplied(*dms_highest_timestamp)) {
+      return true;
+    }
+  }
+  for (const auto* stores : { &undo_delta_stores_, &redo_delta_stores_ }) {
+    for (const auto& store : *stores) {
+      if (!store->has_delta_stats() ||
+          IsDeltaRelevantForSelect(snap_to_exclude, snap_to_include,
+                                   store->delta_stats().min_timestamp(),
+                                   store->delta_stats().max_timestamp())) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 Status DeltaTracker::EstimateBytesInPotentiallyAncientUndoDeltas(
     Timestamp ancient_history_mark,
     RowSet::EstimateType estimate_type,
@@ -626,6 +705,100 @@ Status DeltaTracker::DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
   return Status::OK();
 }
 
+int64_t DeltaTracker::EstimateBytesInTruncatableUndoDeltas(Timestamp ancient_history_mark,
+                                                           double min_ancient_ratio) const {
+  DCHECK_NE(Timestamp::kInvalidTimestamp, ancient_history_mark);
+  SharedDeltaStoreVector undos_newest_first;
+  CollectStores(&undos_newest_first, UNDOS_ONLY);
+
+  int64_t bytes = 0;
+  for (const auto& undo : undos_newest_first) {
+    double ancient_ratio;
+    if (IsTruncatableUndo(*undo, ancient_history_mark, min_ancient_ratio, &ancient_ratio)) {
+      bytes += static_cast<int64_t>(undo->EstimateSize() * ancient_ratio);
+    }
+  }
+  return bytes;
+}
+
+Status DeltaTracker::TruncateAncientUndoDeltas(Timestamp ancient_history_mark,
+                                               double min_ancient_ratio,
+                                               MonoTime deadline,
+                                               const IOContext* io_context,
+                                               int64_t* blocks_truncated,
+                                               int64_t* bytes_truncated) {
+  DCHECK_NE(Timestamp::kInvalidTimestamp, ancient_history_mark);
+
+  // As in DeleteAncientUndoDeltas(), we must be the only thread doing a flush
+  // or a compaction on this RowSet while we swap out its delta blocks.
+  std::lock_guard<Mutex> l(compact_flush_lock_);
+  RETURN_NOT_OK(CheckWritableUnlocked());
+
+  SharedDeltaStoreVector undos_newest_first;
+  CollectStores(&undos_newest_first, UNDOS_ONLY);
+
+  // Only the deltas which are not ancient are written out: as UNDOs, these are
+  // the ones not applied in a snapshot of the ancient history mark. The delta
+  // file iterators ignore the projection when collecting, so an empty schema
+  // is enough.
+  Schema empty_schema;
+  RowIteratorOptions opts;
+  opts.projection = &empty_schema;
+  opts.snap_to_include = MvccSnapshot(ancient_history_mark);
+  opts.io_context = io_context;
+
+  FsManager* fs = rowset_metadata_->fs_manager();
+  int64_t tmp_blocks_truncated = 0;
+  int64_t tmp_bytes_truncated = 0;
+
+  // Traverse oldest-first, committing each rewritten block as we go so the
+  // progress made isn't lost if the deadline is hit.
+  for (const auto& undo : boost::adaptors::reverse(undos_newest_first)) {
+    if (deadline.Initialized() && MonoTime::Now() >= deadline) break;
+    double ancient_ratio;
+    if (!IsTruncatableUndo(*undo, ancient_history_mark, min_ancient_ratio, &ancient_ratio)) {
+      continue;
+    }
+
+    // This is always a safe downcast because UNDO deltas are always on disk.
+    const auto* reader = down_cast<DeltaFileReader*>(undo.get());
+    unique_ptr<DeltaIterator> iter;
+    RETURN_NOT_OK(reader->NewDeltaIterator(opts, &iter));
+
+    unique_ptr<WritableBlock> block;
+    CreateBlockOptions block_opts({ rowset_metadata_->tablet_metadata()->tablet_id() });
+    RETURN_NOT_OK_PREPEND(fs->CreateNewBlock(block_opts, &block),
+                          "Could not allocate delta block");
+    const BlockId new_block_id(block->id());
+    DeltaFileWriter dfw(std::move(block));
+    RETURN_NOT_OK(dfw.Start());
+    RETURN_NOT_OK(WriteDeltaIteratorToFile<UNDO>(iter.get(), ITERATE_OVER_ALL_ROWS, &dfw));
+    RETURN_NOT_OK(dfw.Finish());
+    const int64_t new_size = dfw.written_size();
+
+    VLOG_WITH_PREFIX(1) << Substitute("Truncating the ancient history of undo delta block "
+                                      "$0 into block $1", reader->block_id().ToString(),
+                                      new_block_id.ToString());
+    RowSetMetadataUpdate update;
+    update.ReplaceUndoDeltaBlock(reader->block_id(), new_block_id);
+    vector<DeltaBlockIdAndStats> new_block_and_stats;
+    new_block_and_stats.emplace_back(new_block_id, dfw.release_delta_stats());
+    const int64_t old_size = undo->EstimateSize();
+    // We do not flush the tablet metadata - that is the caller's responsibility.
+    RETURN_NOT_OK_PREPEND(CommitDeltaStoreMetadataUpdate(update, { undo },
+                                                         std::move(new_block_and_stats),
+                                                         io_context, UNDO, NO_FLUSH_METADATA),
+                          "DeltaTracker: TruncateAncientUndoDeltas: "
+                          "Unable to commit delta update");
+    tmp_blocks_truncated++;
+    tmp_bytes_truncated += std::max<int64_t>(0, old_size - new_size);
+  }
+
+  if (blocks_truncated) *blocks_truncated = tmp_blocks_truncated;
+  if (bytes_truncated) *bytes_truncated = tmp_bytes_truncated;
+  return Status::OK();
+}
+
 Status DeltaTracker::DoCompactStores(const IOContext* io_context,
                                      size_t start_idx, size_t end_idx,
                                      unique_ptr<WritableBlock> block,
@@ -990,6 +1163,38 @@ void DeltaTracker::GetColumnIdsToCompact(std::vector<ColumnId>* col_ids) const {
   col_ids->assign(column_ids_to_compact.begin(), column_ids_to_compact.end());
 }
 
+void DeltaTracker::GetColumnIdsWithoutDeltas(const Schema& projection,
+                                             vector<ColumnId>* col_ids) const {
+  col_ids->clear();
+  shared_lock<rw_spinlock> lock(component_lock_);
+  if (dms_exists_ && !dms_->Empty()) {
+    return;
+  }
+  for (const auto* stores : { &undo_delta_stores_, &redo_delta_stores_ }) {
+    for (const auto& ds : *stores) {
+      // We won't force open files just to read their stats.
+      if (!ds->has_delta_stats() || ds->delta_stats().reinsert_count() > 0) {
+        return;
+      }
+    }
+  }
+  for (int i = 0; i < projection.num_columns(); i++) {
+    const ColumnId col_id = projection.column_id(i);
+    bool updated = false;
+    for (const auto* stores : { &undo_delta_stores_, &redo_delta_stores_ }) {
+      for (const auto& ds : *stores) {
+        if (ds->delta_stats().update_count_for_col_id(col_id) > 0) {
+          updated = true;
+          break;
+        }
+      }
+    }
+    if (!updated) {
+      col_ids->push_back(col_id);
+    }
+  }
+}
+
 bool DeltaTracker::DeltaStoreNeedToBeCompacted() const {
   uint64_t all_delete_op_delta_store_cnt = 0;
   {
@@ -186,6 +186,22 @@ class DeltaTracker {
   // initted, this will return a false negative.
   bool EstimateAllRedosAreAncient(Timestamp ancient_history_mark);
 
+  // Returns whether all the data of the rowset is older than 'timestamp', i.e.
+  // its updates (in the DMS and the newest redo delta file) and its inserts
+  // (in the newest undo delta file). A rowset without undo delta files, which
+  // were all GCed as ancient, is taken to have old inserts. This is an
+  // estimate, since if the newest delta files have not yet been initted, this
+  // will return a false negative.
+  bool EstimateAllDataOlderThan(Timestamp timestamp) const;
+
+  // Returns whether any of the delta stores may hold deltas committed in
+  // 'snap_to_include' but not in 'snap_to_exclude', going by the timestamp
+  // ranges of their delta stats. The inserts of the base data are covered by
+  // the undo deltas which revert them. The stores whose stats aren't loaded
+  // yet are taken to hold such deltas.
+  bool MayHaveDeltasBetween(const MvccSnapshot& snap_to_exclude,
+                            const MvccSnapshot& snap_to_include) const;
+
   // See RowSet::InitUndoDeltas().
   Status InitUndoDeltas(Timestamp ancient_history_mark,
                         MonoTime deadline,
@@ -197,6 +213,18 @@ class DeltaTracker {
   Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark, const fs::IOContext* io_context,
                                  int64_t* blocks_deleted, int64_t* bytes_deleted);
 
+  // See RowSet::EstimateBytesInTruncatableUndoDeltas().
+  int64_t EstimateBytesInTruncatableUndoDeltas(Timestamp ancient_history_mark,
+                                               double min_ancient_ratio) const;
+
+  // See RowSet::TruncateAncientUndoDeltas().
+  Status TruncateAncientUndoDeltas(Timestamp ancient_history_mark,
+                                   double min_ancient_ratio,
+                                   MonoTime deadline,
+                                   const fs::IOContext* io_context,
+                                   int64_t* blocks_truncated,
+                                   int64_t* bytes_truncated);
+
   // Opens the input 'blocks' of type 'type' and returns the opened delta file
   // readers in 'stores'.
   Status OpenDeltaReaders(std::vector<DeltaBlockIdAndStats> blocks,
@@ -270,6 +298,13 @@ class DeltaTracker {
   // Retrieves the list of column indexes to compact.
   void GetColumnIdsToCompact(std::vector<ColumnId>* col_ids) const;
 
+  // Retrieves the IDs of the columns of 'projection' whose base data values
+  // can't be changed by any of the deltas: none of the delta stores updates
+  // them or reinserts rows. Delta stores whose stats aren't loaded yet, and
+  // a non-empty DMS, are assumed to change every column.
+  void GetColumnIdsWithoutDeltas(const Schema& projection,
+                                 std::vector<ColumnId>* col_ids) const;
+
   // Check if there is at least one delta file that needs to be compacted.
   bool DeltaStoreNeedToBeCompacted() const;
 
@@ -395,6 +395,46 @@ TEST_F(TestDeltaFile, TestLazyInit) {
   ASSERT_EQ(bytes_read_after_init, bytes_read);
 }
 
+// Check that batches prepared for applying deltas to a projection whose
+// columns aren't updated by a delta file don't read any of its delta blocks,
+// while batches prepared for collecting the deltas still do.
+TEST_F(TestDeltaFile, TestSkipsBlocksForUnupdatedProjection) {
+  WriteTestFile();
+
+  // A projection with a single column that isn't updated in the file.
+  const Schema projection({ ColumnSchema("other", UINT32) },
+                          { ColumnId(1000) }, 0);
+
+  for (int prepare_flags : { DeltaIterator::PREPARE_FOR_APPLY,
+                             DeltaIterator::PREPARE_FOR_COLLECT }) {
+    unique_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(test_block_, &block));
+    size_t bytes_read = 0;
+    unique_ptr<ReadableBlock> count_block(
+        new CountingReadableBlock(std::move(block), &bytes_read));
+    shared_ptr<DeltaFileReader> reader;
+    ASSERT_OK(DeltaFileReader::Open(
+        std::move(count_block), REDO, ReaderOptions(), &reader));
+
+    RowIteratorOptions opts;
+    opts.projection = &projection;
+    opts.snap_to_include = MvccSnapshot::CreateSnapshotIncludingAllOps();
+    unique_ptr<DeltaIterator> it;
+    ASSERT_OK(reader->NewDeltaIterator(opts, &it));
+    ASSERT_OK(it->Init(nullptr));
+    ASSERT_OK(it->SeekToOrdinal(FLAGS_first_row_to_update));
+    const size_t bytes_read_after_seek = bytes_read;
+
+    ASSERT_OK(it->PrepareBatch(100, prepare_flags));
+    if (prepare_flags == DeltaIterator::PREPARE_FOR_APPLY) {
+      ASSERT_EQ(bytes_read_after_seek, bytes_read);
+      ASSERT_FALSE(it->MayHaveDeltas());
+    } else {
+      ASSERT_GT(bytes_read, bytes_read_after_seek);
+    }
+  }
+}
+
 // Check that, if a delta file is opened but no deltas are written,
 // Finish() will return Status::Aborted().
 TEST_F(TestDeltaFile, TestEmptyFileIsAborted) {
@@ -424,6 +424,7 @@ DeltaFileIterator<Type>::DeltaFileIterator(shared_ptr<DeltaFileReader> dfr,
       prepared_(false),
       exhausted_(false),
       initted_(false),
+      may_apply_to_projection_(true),
       cache_blocks_(CFileReader::CACHE_BLOCK),
       delta_blocks_mem_size_(0) {
 }
@@ -460,6 +461,20 @@ Status DeltaFileIterator<Type>::SeekToOrdinal(rowid_t idx) {
     return Status::OK();
   }
 
+  // Use the delta stats to find out whether any delta in this file may affect
+  // the projected columns, so that batches prepared only for applying the
+  // deltas can skip reading the delta blocks entirely.
+  const DeltaStats& stats = dfr_->delta_stats();
+  const Schema* projection = preparer_.opts().projection;
+  may_apply_to_projection_ = stats.delete_count() > 0 ||
+                             stats.reinsert_count() > 0 ||
+                             !projection->has_column_ids();
+  for (size_t i = 0; !may_apply_to_projection_ && i < projection->num_columns(); i++) {
+    if (stats.update_count_for_col_id(projection->column_id(i)) > 0) {
+      may_apply_to_projection_ = true;
+    }
+  }
+
   if (!index_iter_) {
     index_iter_.reset(IndexTreeIterator::Create(
         preparer_.opts().io_context,
@@ -558,6 +573,19 @@ Status DeltaFileIterator<Type>::PrepareBatch(size_t nrows, int prepare_flags) {
   rowid_t start_row = preparer_.cur_prepared_idx();
   rowid_t stop_row = start_row + nrows - 1;
 
+  if (!may_apply_to_projection_ &&
+      prepare_flags == DeltaIterator::PREPARE_FOR_APPLY) {
+    // None of the deltas in this file touch the projection: there's nothing
+    // to read, but the preparer must still advance past the batch.
+    TRACE_COUNTER_INCREMENT("delta_batches_skipped_for_projection", 1);
+    delta_blocks_.clear();
+    delta_blocks_mem_size_ = 0;
+    prepared_ = true;
+    preparer_.Start(nrows, prepare_flags);
+    preparer_.Finish(nrows);
+    return Status::OK();
+  }
+
   // Remove blocks from our list which are no longer relevant to the range
   // being prepared.
   while (!delta_blocks_.empty() &&
@@ -358,6 +358,12 @@ class DeltaFileIterator : public DeltaIterator {
   bool exhausted_;
   bool initted_;
 
+  // Whether, according to the delta stats of the file, any of its deltas
+  // may be applied to the projection: deletes, reinserts, or updates to any
+  // projected column. Computed in SeekToOrdinal(). When false, preparing a
+  // batch only for PREPARE_FOR_APPLY doesn't need to read any delta block.
+  bool may_apply_to_projection_;
+
   // After PrepareBatch(), the set of delta blocks in the delta file
   // which correspond to prepared_block_.
   std::deque<PreparedDeltaBlock> delta_blocks_;
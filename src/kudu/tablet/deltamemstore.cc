@@ -21,6 +21,7 @@
 #include <memory>
 #include <ostream>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 
 #include "kudu/common/row_changelist.h"
@@ -37,6 +38,8 @@
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
+DECLARE_bool(memstore_use_huge_page_arenas);
+
 using kudu::fs::IOContext;
 using kudu::log::LogAnchorRegistry;
 using std::string;
@@ -74,13 +77,19 @@ DeltaMemStore::DeltaMemStore(int64_t id,
     creation_time_(MonoTime::Now()),
     highest_timestamp_(Timestamp::kMin),
     allocator_(new MemoryTrackingBufferAllocator(
-        HeapBufferAllocator::Get(), std::move(parent_tracker))),
+        FLAGS_memstore_use_huge_page_arenas ?
+            static_cast<BufferAllocator*>(HugePageBufferAllocator::Get()) :
+            HeapBufferAllocator::Get(),
+        std::move(parent_tracker))),
     arena_(new ThreadSafeMemoryTrackingArena(kInitialArenaSize, allocator_)),
     tree_(arena_),
     anchorer_(log_anchor_registry,
               Substitute("Rowset-$0/DeltaMemStore-$1", rs_id_, id_)),
     disambiguator_sequence_number_(0),
     deleted_row_count_(0) {
+  if (FLAGS_memstore_use_huge_page_arenas) {
+    arena_->SetMaxBufferSize(HugePageBufferAllocator::kChunkSize);
+  }
 }
 
 Status DeltaMemStore::Init(const IOContext* /*io_context*/) {
@@ -151,6 +151,12 @@ class DeltaMemStore : public DeltaStore,
     return delta_stats_;
   }
 
+  // The DMS doesn't keep stats of its deltas, so callers must not rely on
+  // 'delta_stats()' to know what it contains.
+  bool has_delta_stats() const override {
+    return false;
+  }
+
   // Returns the number of deleted rows in this DMS.
   int64_t deleted_row_count() const;
 
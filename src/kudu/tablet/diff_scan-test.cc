@@ -265,5 +265,60 @@ TEST_F(OrderedDiffScanWithDeletesTest, TestDiffScanAfterDeltaFlushRacesWithBatch
   ASSERT_STR_CONTAINS(rows[0], "val=9999");
 }
 
+// Test that the diff scans skip the rowsets without any changes between their
+// snapshots.
+TEST_F(OrderedDiffScanWithDeletesTest, TestCullRowSetsWithoutChanges) {
+  auto tablet = this->tablet();
+  LocalTabletWriter writer(tablet.get(), &client_schema_);
+
+  // 1. An old rowset, which only gets updated before the diff scan's start.
+  ASSERT_OK(InsertTestRow(&writer, 1, 1));
+  ASSERT_OK(tablet->Flush());
+  ASSERT_OK(UpdateTestRow(&writer, 1, 2));
+  ASSERT_OK(tablet->FlushAllDMSForTests());
+  ASSERT_OK(tablet->mvcc_manager()->WaitForApplyingOpsToApply());
+  MvccSnapshot snap1(*tablet->mvcc_manager());
+
+  // 2. A new rowset, inserted after the diff scan's start.
+  ASSERT_OK(InsertTestRow(&writer, 2, 1));
+  ASSERT_OK(tablet->Flush());
+  ASSERT_OK(tablet->mvcc_manager()->WaitForApplyingOpsToApply());
+  MvccSnapshot snap2(*tablet->mvcc_manager());
+
+  vector<std::shared_ptr<RowSet>> rowsets;
+  tablet->GetRowSetsForTests(&rowsets);
+  int num_rowsets_with_changes = 0;
+  for (const auto& rs : rowsets) {
+    if (rs->MayHaveChangesBetween(snap1, snap2)) {
+      num_rowsets_with_changes++;
+    }
+  }
+  ASSERT_EQ(2, rowsets.size());
+  ASSERT_EQ(1, num_rowsets_with_changes);
+
+  // Updating the old rowset makes it relevant again.
+  ASSERT_OK(UpdateTestRow(&writer, 1, 3));
+  ASSERT_OK(tablet->mvcc_manager()->WaitForApplyingOpsToApply());
+  MvccSnapshot snap3(*tablet->mvcc_manager());
+  for (const auto& rs : rowsets) {
+    ASSERT_TRUE(rs->MayHaveChangesBetween(snap1, snap3));
+  }
+
+  RowIteratorOptions opts;
+  opts.snap_to_exclude = snap1;
+  opts.snap_to_include = snap2;
+  opts.order = ORDERED;
+  Schema projection = tablet->metadata()->schema()->CopyWithoutColumnIds();
+  opts.projection = &projection;
+  unique_ptr<RowwiseIterator> row_iterator;
+  ASSERT_OK(tablet->NewRowIterator(std::move(opts), &row_iterator));
+  ScanSpec spec;
+  ASSERT_OK(row_iterator->Init(&spec));
+  vector<string> rows;
+  ASSERT_OK(tablet::IterateToStringList(row_iterator.get(), &rows));
+  ASSERT_EQ(1, rows.size());
+  ASSERT_EQ("(int64 key=2, int32 key_idx=2, int32 val=1)", rows[0]);
+}
+
 } // namespace tablet
 } // namespace kudu
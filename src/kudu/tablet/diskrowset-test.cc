@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -35,11 +36,13 @@
 #include <gtest/gtest.h>
 
 #include "kudu/clock/logical_clock.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
 #include "kudu/common/rowid.h"
+#include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/consensus/log_anchor_registry.h"
@@ -56,11 +59,14 @@
 #include "kudu/tablet/delta_store.h"
 #include "kudu/tablet/delta_tracker.h"
 #include "kudu/tablet/diskrowset-test-base.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/tablet/tablet.pb.h"
 #include "kudu/tablet/tablet_mem_trackers.h"
+#include "kudu/tablet/tablet_metadata.h"
 #include "kudu/util/bloom_filter.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/memory/arena.h"
@@ -71,6 +77,7 @@
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
+#include "kudu/util/trace.h"
 
 namespace kudu {
 namespace tablet {
@@ -82,6 +89,7 @@ DEFINE_double(update_fraction, 0.1f, "fraction of rows to update");
 DECLARE_bool(cfile_lazy_open);
 DECLARE_bool(crash_on_eio);
 DECLARE_int32(cfile_default_block_size);
+DECLARE_int32(flush_encode_threads);
 DECLARE_double(env_inject_eio);
 DECLARE_int32(tablet_history_max_age_sec);
 DECLARE_bool(rowset_metadata_store_keys);
@@ -346,6 +354,40 @@ TEST_F(TestRowSet, TestDelete) {
 }
 
 
+// Test that checking the presence of a batch of rows agrees with checking
+// the rows one at a time.
+TEST_F(TestRowSet, TestCheckRowsPresent) {
+  constexpr int kNumRows = 100;
+  WriteTestRowSet(kNumRows);
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+  for (int i = 0; i < kNumRows; i += 3) {
+    OperationResultPB result;
+    ASSERT_OK(DeleteRow(rs.get(), i, &result));
+  }
+
+  // Probe the rows in order, along with rows past the end of the rowset.
+  Schema proj_key = schema_.CreateKeyProjection();
+  Arena arena(1024);
+  vector<unique_ptr<RowBuilder>> rbs;
+  vector<unique_ptr<RowSetKeyProbe>> key_probes;
+  vector<ProbeStats> stats(kNumRows + 10);
+  vector<KeyPresenceProbe> probes;
+  for (int i = 0; i < kNumRows + 10; i++) {
+    rbs.emplace_back(new RowBuilder(&proj_key));
+    BuildRowKey(rbs.back().get(), i);
+    key_probes.emplace_back(new RowSetKeyProbe(rbs.back()->row(), &arena));
+    probes.push_back({ key_probes.back().get(), &stats[i], false });
+  }
+  ASSERT_OK(rs->CheckRowsPresent(probes, nullptr));
+  for (int i = 0; i < kNumRows + 10; i++) {
+    bool present;
+    ASSERT_OK(CheckRowPresent(*rs, i, &present));
+    ASSERT_EQ(present, probes[i].present) << i;
+    ASSERT_EQ(i < kNumRows && i % 3 != 0, present) << i;
+  }
+}
+
 TEST_F(TestRowSet, TestDMSFlush) {
   WriteTestRowSet();
 
@@ -832,6 +874,97 @@ TEST_F(TestRowSet, TestCountLiveRowsWithoutLiveRowCountStats) {
   ASSERT_GE(rs_live_rows_without_lrc, FLAGS_roundtrip_num_rows);
 }
 
+// Test that a rowset written with a bloom filter for a column is skipped by
+// scans with an equality predicate on a value it doesn't contain, unless the
+// column has deltas that might have changed its values.
+TEST_F(TestRowSet, TestColumnBloomFilterSkipsRowSet) {
+  TableExtraConfigPB extra_config;
+  extra_config.set_bloom_filter_columns("val");
+  tablet()->metadata()->SetExtraConfig(extra_config);
+  WriteTestRowSet();
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+
+  // Scans 'rs' for the rows with the given value, returning the number of
+  // rows found and whether the rowset was skipped.
+  auto scan_for_value = [&](uint32_t val, int* num_rows, bool* skipped) {
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::Equality(schema_.column(1), &val));
+    RowIteratorOptions opts;
+    opts.projection = &schema_;
+    unique_ptr<RowwiseIterator> iter;
+    scoped_refptr<Trace> trace(new Trace);
+    {
+      ADOPT_TRACE(trace.get());
+      RETURN_NOT_OK(rs->NewRowIterator(opts, &iter));
+      RETURN_NOT_OK(iter->Init(&spec));
+      RETURN_NOT_OK(SilentIterateToStringList(iter.get(), num_rows));
+    }
+    *skipped = trace->MetricsAsJSON().find(
+        "rowsets_skipped_by_column_bloom_filters") != string::npos;
+    return Status::OK();
+  };
+
+  const uint32_t kAbsentVal = n_rows_ + 1;
+  int num_rows;
+  bool skipped;
+  ASSERT_OK(scan_for_value(n_rows_ / 2, &num_rows, &skipped));
+  ASSERT_EQ(1, num_rows);
+  ASSERT_FALSE(skipped);
+  ASSERT_OK(scan_for_value(kAbsentVal, &num_rows, &skipped));
+  ASSERT_EQ(0, num_rows);
+  ASSERT_TRUE(skipped);
+
+  // Once a row is updated to the absent value, the rowset must be scanned,
+  // whether the update is in the DMS or in a delta file.
+  OperationResultPB result;
+  ASSERT_OK(UpdateRow(rs.get(), 0, kAbsentVal, &result));
+  ASSERT_OK(scan_for_value(kAbsentVal, &num_rows, &skipped));
+  ASSERT_EQ(1, num_rows);
+  ASSERT_FALSE(skipped);
+  ASSERT_OK(rs->FlushDeltas(nullptr));
+  ASSERT_OK(scan_for_value(kAbsentVal, &num_rows, &skipped));
+  ASSERT_EQ(1, num_rows);
+  ASSERT_FALSE(skipped);
+}
+
+// Test that the statistics of the columns of a rowset are stored in its
+// metadata, and dropped along with the base data of their column.
+TEST_F(TestRowSet, TestColumnStatsInMetadata) {
+  WriteTestRowSet();
+
+  ColumnStatsPB stats;
+  ASSERT_TRUE(rowset_meta_->GetColumnStats(schema_.column_id(1), &stats));
+  uint32_t min_val;
+  uint32_t max_val;
+  ASSERT_EQ(sizeof(min_val), stats.min_value().size());
+  ASSERT_EQ(sizeof(max_val), stats.max_value().size());
+  memcpy(&min_val, stats.min_value().data(), sizeof(min_val));
+  memcpy(&max_val, stats.max_value().data(), sizeof(max_val));
+  ASSERT_EQ(0, min_val);
+  ASSERT_EQ(n_rows_ - 1, max_val);
+  ASSERT_EQ(0, stats.null_count());
+  ASSERT_NEAR(n_rows_, stats.distinct_count_estimate(), n_rows_ / 20);
+
+  // The keys are strings, which have no bounds.
+  ASSERT_TRUE(rowset_meta_->GetColumnStats(schema_.column_id(0), &stats));
+  ASSERT_FALSE(stats.has_min_value());
+  ASSERT_NEAR(n_rows_, stats.distinct_count_estimate(), n_rows_ / 20);
+
+  RowSetDataPB pb;
+  rowset_meta_->ToProtobuf(&pb);
+  ASSERT_EQ(2, pb.column_stats_size());
+
+  // Replacing the base data of a column, as major delta compactions do, drops
+  // its statistics.
+  BlockIdContainer removed;
+  RowSetMetadataUpdate update;
+  update.ReplaceColumnId(schema_.column_id(1), BlockId(1000000));
+  rowset_meta_->CommitUpdate(update, &removed);
+  ASSERT_FALSE(rowset_meta_->GetColumnStats(schema_.column_id(1), &stats));
+  ASSERT_TRUE(rowset_meta_->GetColumnStats(schema_.column_id(0), &stats));
+}
+
 class DiffScanRowSetTest : public KuduRowSetTest,
                            public ::testing::WithParamInterface<tuple<bool, bool>> {
  public:
@@ -1076,5 +1209,156 @@ TEST_P(DiffScanRowSetTest, TestFuzz) {
                              make_tuple(3, 400, 9, true) }));
 }
 
+class TestColumnGroupRowSet : public KuduRowSetTest {
+ public:
+  TestColumnGroupRowSet()
+      : KuduRowSetTest(CreateTestSchema()) {
+  }
+
+ protected:
+  static constexpr int kNumValueColumns = 6;
+
+  static Schema CreateTestSchema() {
+    SchemaBuilder builder;
+    CHECK_OK(builder.AddKeyColumn("key", UINT32));
+    for (int i = 0; i < kNumValueColumns; i++) {
+      CHECK_OK(builder.AddColumn(Substitute("val$0", i), UINT32));
+    }
+    return builder.BuildWithoutIds();
+  }
+
+  BlockId ColumnBlock(int col_idx) const {
+    return rowset_meta_->column_data_block_for_col_id(schema_.column_id(col_idx));
+  }
+};
+
+// Test writing and reading back a rowset whose value columns are stored in
+// column groups.
+TEST_F(TestColumnGroupRowSet, TestRoundTrip) {
+  constexpr int kNumRows = 1000;
+  TableExtraConfigPB extra_config;
+  extra_config.set_column_group_size(4);
+  tablet()->metadata()->SetExtraConfig(extra_config);
+
+  DiskRowSetWriter drsw(rowset_meta_.get(), &schema_,
+                        BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01F));
+  ASSERT_OK(drsw.Open());
+  RowBuilder rb(&schema_);
+  for (int i = 0; i < kNumRows; i++) {
+    rb.Reset();
+    rb.AddUint32(i);
+    for (int c = 0; c < kNumValueColumns; c++) {
+      rb.AddUint32(i * 10 + c);
+    }
+    ASSERT_OK(WriteRow(rb.data(), &drsw));
+  }
+  ASSERT_OK(drsw.Finish());
+
+  // The key column has a block of its own, and the value columns are split
+  // into a group of four columns and a group of two.
+  ASSERT_FALSE(rowset_meta_->is_column_group_block(ColumnBlock(0)));
+  for (int i = 1; i <= kNumValueColumns; i++) {
+    ASSERT_TRUE(rowset_meta_->is_column_group_block(ColumnBlock(i)));
+  }
+  ASSERT_EQ(ColumnBlock(1), ColumnBlock(4));
+  ASSERT_NE(ColumnBlock(4), ColumnBlock(5));
+  ASSERT_EQ(ColumnBlock(5), ColumnBlock(6));
+  // The blocks of the columns, plus the bloom filter.
+  ASSERT_EQ(4, rowset_meta_->GetAllBlocks().size());
+
+  // The groups survive a round trip through the superblock.
+  RowSetDataPB pb;
+  rowset_meta_->ToProtobuf(&pb);
+  int num_grouped_columns = 0;
+  for (const auto& col_pb : pb.columns()) {
+    if (col_pb.in_column_group()) {
+      num_grouped_columns++;
+    }
+  }
+  ASSERT_EQ(kNumValueColumns, num_grouped_columns);
+
+  scoped_refptr<log::LogAnchorRegistry> log_anchor_registry(new log::LogAnchorRegistry());
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(DiskRowSet::Open(rowset_meta_, log_anchor_registry.get(),
+                             TabletMemTrackers(), nullptr, &rs));
+  RowIteratorOptions opts;
+  opts.projection = &schema_;
+  unique_ptr<RowwiseIterator> iter;
+  ASSERT_OK(rs->NewRowIterator(opts, &iter));
+  ASSERT_OK(iter->Init(nullptr));
+  vector<string> rows;
+  ASSERT_OK(IterateToStringList(iter.get(), &rows));
+  ASSERT_EQ(kNumRows, rows.size());
+  for (int i = 0; i < kNumRows; i += 100) {
+    SCOPED_TRACE(i);
+    ASSERT_STR_CONTAINS(rows[i], Substitute("uint32 val0=$0,", i * 10));
+    ASSERT_STR_CONTAINS(rows[i], Substitute("uint32 val5=$0)", i * 10 + 5));
+  }
+
+  // Replacing some of the columns of a group leaves the group in place; it's
+  // only removed along with its last column.
+  BlockIdContainer removed;
+  const BlockId second_group = ColumnBlock(5);
+  RowSetMetadataUpdate update;
+  update.ReplaceColumnId(schema_.column_id(5), BlockId(1000000));
+  rowset_meta_->CommitUpdate(update, &removed);
+  ASSERT_TRUE(removed.empty());
+  ASSERT_TRUE(rowset_meta_->is_column_group_block(second_group));
+
+  RowSetMetadataUpdate update2;
+  update2.ReplaceColumnId(schema_.column_id(6), BlockId(1000001));
+  rowset_meta_->CommitUpdate(update2, &removed);
+  ASSERT_EQ(BlockIdContainer({ second_group }), removed);
+  ASSERT_FALSE(rowset_meta_->is_column_group_block(second_group));
+}
+
+// Test that the columns encoded in parallel, whether in groups or in blocks
+// of their own, read back the same as if encoded serially.
+TEST_F(TestColumnGroupRowSet, TestParallelEncode) {
+  FLAGS_flush_encode_threads = 4;
+  constexpr int kNumRows = 10000;
+  TableExtraConfigPB extra_config;
+  extra_config.set_column_group_size(4);
+  tablet()->metadata()->SetExtraConfig(extra_config);
+
+  DiskRowSetWriter drsw(rowset_meta_.get(), &schema_,
+                        BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01F));
+  ASSERT_OK(drsw.Open());
+  // Blocks large enough for their columns to be split across the threads.
+  constexpr int kRowsPerBlock = 5000;
+  RowBlock block(&schema_, kRowsPerBlock, nullptr);
+  for (int start = 0; start < kNumRows; start += kRowsPerBlock) {
+    for (int i = 0; i < kRowsPerBlock; i++) {
+      RowBlockRow row = block.row(i);
+      *reinterpret_cast<uint32_t*>(row.mutable_cell_ptr(0)) = start + i;
+      for (int c = 0; c < kNumValueColumns; c++) {
+        *reinterpret_cast<uint32_t*>(row.mutable_cell_ptr(c + 1)) = (start + i) * 10 + c;
+      }
+    }
+    ASSERT_OK(drsw.AppendBlock(block, kRowsPerBlock));
+  }
+  ASSERT_OK(drsw.Finish());
+
+  scoped_refptr<log::LogAnchorRegistry> log_anchor_registry(new log::LogAnchorRegistry());
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(DiskRowSet::Open(rowset_meta_, log_anchor_registry.get(),
+                             TabletMemTrackers(), nullptr, &rs));
+  RowIteratorOptions opts;
+  opts.projection = &schema_;
+  unique_ptr<RowwiseIterator> iter;
+  ASSERT_OK(rs->NewRowIterator(opts, &iter));
+  ASSERT_OK(iter->Init(nullptr));
+  vector<string> rows;
+  ASSERT_OK(IterateToStringList(iter.get(), &rows));
+  ASSERT_EQ(kNumRows, rows.size());
+  for (int i = 0; i < kNumRows; i += 999) {
+    SCOPED_TRACE(i);
+    ASSERT_STR_CONTAINS(rows[i], Substitute("(uint32 key=$0,", i));
+    for (int c = 0; c < kNumValueColumns; c++) {
+      ASSERT_STR_CONTAINS(rows[i], Substitute("uint32 val$0=$1", c, i * 10 + c));
+    }
+  }
+}
+
 } // namespace tablet
 } // namespace kudu
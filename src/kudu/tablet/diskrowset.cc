@@ -18,10 +18,16 @@
 #include "kudu/tablet/diskrowset.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <map>
+#include <mutex>
 #include <optional>
 #include <ostream>
+#include <set>
 #include <shared_mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -43,6 +49,8 @@
 #include "kudu/fs/io_context.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/strip.h"
 #include "kudu/tablet/cfile_set.h"
 #include "kudu/tablet/compaction.h"
 #include "kudu/tablet/delta_compaction.h"
@@ -62,6 +70,7 @@
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
+#include "kudu/util/trace.h"
 
 DEFINE_int32(tablet_delta_store_minor_compact_max, 1000,
              "How many delta stores are required before forcing a minor delta compaction "
@@ -82,6 +91,23 @@ DEFINE_bool(rowset_metadata_store_keys, false,
             "metadata. If false, keys will be read from the data blocks.");
 TAG_FLAG(rowset_metadata_store_keys, experimental);
 
+DEFINE_bool(rowset_metadata_store_column_stats, true,
+            "Whether to collect the statistics of the columns of the rowsets written "
+            "by flushes and compactions (their smallest and largest values, their "
+            "number of NULLs and an estimate of their number of distinct values) and "
+            "store them in the rowset metadata. They allow scans to skip rowsets "
+            "which can't match their predicates.");
+TAG_FLAG(rowset_metadata_store_column_stats, advanced);
+
+DEFINE_int32(rowset_read_rate_half_life_secs, 60 * 60,
+             "Half-life, in seconds, of the reads of a rowset when computing "
+             "its recent read rate, used by the compaction policy to favor the "
+             "rowsets which are read. See --compaction_read_hotness_weight.");
+TAG_FLAG(rowset_read_rate_half_life_secs, experimental);
+TAG_FLAG(rowset_read_rate_half_life_secs, runtime);
+DEFINE_validator(rowset_read_rate_half_life_secs,
+                 [](const char* /*n*/, int32_t v) { return v > 0; });
+
 using kudu::cfile::BloomFileWriter;
 using kudu::fs::BlockManager;
 using kudu::fs::BlockCreationTransaction;
@@ -90,6 +116,7 @@ using kudu::fs::IOContext;
 using kudu::fs::WritableBlock;
 using kudu::log::LogAnchorRegistry;
 using std::optional;
+using std::set;
 using std::shared_lock;
 using std::shared_ptr;
 using std::string;
@@ -111,10 +138,12 @@ const char *DiskRowSet::kMaxKeyMetaEntryName = "max_key";
 
 DiskRowSetWriter::DiskRowSetWriter(RowSetMetadata* rowset_metadata,
                                    const Schema* schema,
-                                   BloomFilterSizing bloom_sizing)
+                                   BloomFilterSizing bloom_sizing,
+                                   fs::StorageTier tier)
     : rowset_metadata_(rowset_metadata),
       schema_(schema),
       bloom_sizing_(bloom_sizing),
+      tier_(tier),
       finished_(false),
       written_count_(0) {
   CHECK(schema->has_column_ids());
@@ -125,7 +154,20 @@ Status DiskRowSetWriter::Open() {
 
   FsManager* fs = rowset_metadata_->fs_manager();
   const string& tablet_id = rowset_metadata_->tablet_metadata()->tablet_id();
-  col_writer_.reset(new MultiColumnWriter(fs, schema_, tablet_id));
+  const auto& extra_config = rowset_metadata_->tablet_metadata()->extra_config();
+  const int column_group_size = extra_config && extra_config->has_column_group_size() ?
+      extra_config->column_group_size() : 0;
+  set<string> bloom_filter_columns;
+  if (extra_config && extra_config->has_bloom_filter_columns()) {
+    for (string name : strings::Split(extra_config->bloom_filter_columns(), ",",
+                                      strings::SkipWhitespace())) {
+      StripWhiteSpace(&name);
+      bloom_filter_columns.emplace(std::move(name));
+    }
+  }
+  col_writer_.reset(new MultiColumnWriter(fs, schema_, tablet_id, column_group_size,
+                                          std::move(bloom_filter_columns),
+                                          FLAGS_rowset_metadata_store_column_stats, tier_));
   RETURN_NOT_OK(col_writer_->Open());
 
   // Open bloom filter.
@@ -144,7 +186,7 @@ Status DiskRowSetWriter::InitBloomFileWriter() {
   unique_ptr<WritableBlock> block;
   FsManager* fs = rowset_metadata_->fs_manager();
   const string& tablet_id = rowset_metadata_->tablet_metadata()->tablet_id();
-  RETURN_NOT_OK_PREPEND(fs->CreateNewBlock(CreateBlockOptions({ tablet_id }),
+  RETURN_NOT_OK_PREPEND(fs->CreateNewBlock(CreateBlockOptions({ tablet_id, tier_ }),
                                            &block),
                         "Couldn't allocate a block for bloom filter");
   rowset_metadata_->set_bloom_block(block->id());
@@ -159,7 +201,7 @@ Status DiskRowSetWriter::InitAdHocIndexWriter() {
   unique_ptr<WritableBlock> block;
   FsManager* fs = rowset_metadata_->fs_manager();
   const string& tablet_id = rowset_metadata_->tablet_metadata()->tablet_id();
-  RETURN_NOT_OK_PREPEND(fs->CreateNewBlock(CreateBlockOptions({ tablet_id }),
+  RETURN_NOT_OK_PREPEND(fs->CreateNewBlock(CreateBlockOptions({ tablet_id, tier_ }),
                                            &block),
                         "Couldn't allocate a block for compoound index");
 
@@ -276,11 +318,26 @@ Status DiskRowSetWriter::FinishAndReleaseBlocks(BlockCreationTransaction* transa
 
   // Finish writing the columns themselves.
   RETURN_NOT_OK(col_writer_->FinishAndReleaseBlocks(transaction));
+  int64_t encode_us = 0;
+  for (auto i = 0; i < schema_->num_columns(); ++i) {
+    const MonoDelta col_encode_time = col_writer_->encode_time_for_col_idx(i);
+    VLOG(2) << "Column " << schema_->column(i).name() << " encoded in "
+            << col_encode_time.ToString();
+    encode_us += col_encode_time.ToMicroseconds();
+  }
+  TRACE_COUNTER_INCREMENT("column_encode_us", encode_us);
 
   // Put the column data blocks in the metadata.
   std::map<ColumnId, BlockId> flushed_blocks;
   col_writer_->GetFlushedBlocksByColumnId(&flushed_blocks);
-  rowset_metadata_->SetColumnDataBlocks(flushed_blocks);
+  BlockIdSet column_group_blocks;
+  col_writer_->GetFlushedColumnGroupBlocks(&column_group_blocks);
+  rowset_metadata_->SetColumnDataBlocks(flushed_blocks, column_group_blocks);
+  if (FLAGS_rowset_metadata_store_column_stats) {
+    std::map<ColumnId, ColumnStatsPB> stats;
+    col_writer_->GetValueStatsByColumnId(&stats);
+    rowset_metadata_->SetColumnStats(stats);
+  }
 
   if (ad_hoc_index_writer_ != nullptr) {
     Status s = ad_hoc_index_writer_->FinishAndReleaseBlock(transaction);
@@ -328,12 +385,13 @@ DiskRowSetWriter::~DiskRowSetWriter() {
 
 RollingDiskRowSetWriter::RollingDiskRowSetWriter(
     TabletMetadata* tablet_metadata, const Schema& schema,
-    BloomFilterSizing bloom_sizing, size_t target_rowset_size)
+    BloomFilterSizing bloom_sizing, size_t target_rowset_size, fs::StorageTier tier)
     : state_(kInitialized),
       tablet_metadata_(DCHECK_NOTNULL(tablet_metadata)),
       schema_(schema),
       bloom_sizing_(bloom_sizing),
       target_rowset_size_(target_rowset_size),
+      tier_(tier),
       row_idx_in_cur_drs_(0),
       can_roll_(false),
       written_count_(0),
@@ -359,16 +417,16 @@ Status RollingDiskRowSetWriter::RollWriter() {
 
   RETURN_NOT_OK(tablet_metadata_->CreateRowSet(&cur_drs_metadata_));
 
-  cur_writer_.reset(new DiskRowSetWriter(cur_drs_metadata_.get(), &schema_, bloom_sizing_));
+  cur_writer_.reset(new DiskRowSetWriter(cur_drs_metadata_.get(), &schema_, bloom_sizing_,
+                                         tier_));
   RETURN_NOT_OK(cur_writer_->Open());
 
   FsManager* fs = tablet_metadata_->fs_manager();
   unique_ptr<WritableBlock> undo_data_block;
   unique_ptr<WritableBlock> redo_data_block;
-  RETURN_NOT_OK(fs->CreateNewBlock(CreateBlockOptions({ tablet_metadata_->tablet_id() }),
-                                   &undo_data_block));
-  RETURN_NOT_OK(fs->CreateNewBlock(CreateBlockOptions({ tablet_metadata_->tablet_id() }),
-                                   &redo_data_block));
+  const CreateBlockOptions block_opts({ tablet_metadata_->tablet_id(), tier_ });
+  RETURN_NOT_OK(fs->CreateNewBlock(block_opts, &undo_data_block));
+  RETURN_NOT_OK(fs->CreateNewBlock(block_opts, &redo_data_block));
   cur_undo_ds_block_id_ = undo_data_block->id();
   cur_redo_ds_block_id_ = redo_data_block->id();
   cur_undo_writer_.reset(new DeltaFileWriter(std::move(undo_data_block)));
@@ -528,7 +586,8 @@ DiskRowSet::DiskRowSet(shared_ptr<RowSetMetadata> rowset_metadata,
       log_anchor_registry_(log_anchor_registry),
       mem_trackers_(std::move(mem_trackers)),
       num_rows_(-1),
-      has_been_compacted_(false) {}
+      has_been_compacted_(false),
+      read_count_(0) {}
 
 Status DiskRowSet::Open(const IOContext* io_context) {
   TRACE_EVENT0("tablet", "DiskRowSet::Open");
@@ -667,6 +726,11 @@ Status DiskRowSet::NewRowIterator(const RowIteratorOptions& opts,
 
   shared_ptr<CFileSet::Iterator> base_iter(base_data_->NewIterator(opts.projection,
                                                                    opts.io_context));
+  // The bloom filters of the values of the base data may only rule out the
+  // rowset for the columns whose values aren't changed by any deltas.
+  vector<ColumnId> col_ids_without_deltas;
+  delta_tracker_->GetColumnIdsWithoutDeltas(*opts.projection, &col_ids_without_deltas);
+  base_iter->set_col_ids_without_deltas(std::move(col_ids_without_deltas));
   unique_ptr<ColumnwiseIterator> col_iter;
   RETURN_NOT_OK(delta_tracker_->WrapIterator(base_iter, opts, &col_iter));
 
@@ -743,6 +807,33 @@ Status DiskRowSet::CheckRowPresent(const RowSetKeyProbe &probe,
   return Status::OK();
 }
 
+Status DiskRowSet::CheckRowsPresent(ArrayView<KeyPresenceProbe> probes,
+                                    const IOContext* io_context) const {
+  DCHECK(open_);
+#ifndef NDEBUG
+  rowid_t num_rows;
+  RETURN_NOT_OK(CountRows(io_context, &num_rows));
+#endif
+  shared_lock<rw_spinlock> l(component_lock_);
+
+  vector<rowid_t> row_idxs;
+  RETURN_NOT_OK(base_data_->CheckRowsPresent(probes, io_context, &row_idxs));
+  for (int i = 0; i < probes.size(); i++) {
+    KeyPresenceProbe& p = probes[i];
+    if (!p.present) {
+      continue;
+    }
+#ifndef NDEBUG
+    CHECK_LT(row_idxs[i], num_rows);
+#endif
+    // The row might be in the base data but deleted.
+    bool deleted = false;
+    RETURN_NOT_OK(delta_tracker_->CheckRowDeleted(row_idxs[i], io_context, &deleted, p.stats));
+    p.present = !deleted;
+  }
+  return Status::OK();
+}
+
 Status DiskRowSet::CountRows(const IOContext* io_context, rowid_t *count) const {
   DCHECK(open_);
   rowid_t num_rows = num_rows_.load();
@@ -790,6 +881,34 @@ void DiskRowSet::GetDiskRowSetSpaceUsage(DiskRowSetSpace* drss) const {
   drss->undo_deltas_size = delta_tracker_->UndoDeltaOnDiskSize();
 }
 
+void DiskRowSet::RecordRead() const {
+  const MonoTime now = MonoTime::Now();
+  const double half_life_secs = FLAGS_rowset_read_rate_half_life_secs;
+  std::lock_guard<simple_spinlock> l(read_count_lock_);
+  if (read_count_time_.Initialized()) {
+    read_count_ *= std::exp2(-(now - read_count_time_).ToSeconds() / half_life_secs);
+  }
+  read_count_ += 1;
+  read_count_time_ = now;
+}
+
+double DiskRowSet::ReadRate() const {
+  const MonoTime now = MonoTime::Now();
+  const double half_life_secs = FLAGS_rowset_read_rate_half_life_secs;
+  double read_count;
+  {
+    std::lock_guard<simple_spinlock> l(read_count_lock_);
+    if (!read_count_time_.Initialized()) {
+      return 0;
+    }
+    read_count = read_count_ *
+        std::exp2(-(now - read_count_time_).ToSeconds() / half_life_secs);
+  }
+  // At a steady rate of r reads per second, the decayed count converges to
+  // r * half-life / ln(2).
+  return read_count * M_LN2 / half_life_secs;
+}
+
 uint64_t DiskRowSet::OnDiskSize() const {
   DiskRowSetSpace drss;
   GetDiskRowSetSpaceUsage(&drss);
@@ -912,6 +1031,29 @@ Status DiskRowSet::IsDeletedAndFullyAncient(Timestamp ancient_history_mark,
   return Status::OK();
 }
 
+bool DiskRowSet::EstimateAllDataOlderThan(Timestamp timestamp) const {
+  return delta_tracker_->EstimateAllDataOlderThan(timestamp);
+}
+
+bool DiskRowSet::EstimateAllRowsExpired(const ColumnId& row_ttl_col_id,
+                                        int64_t cutoff_micros) const {
+  // The TTL column is a key column, so its cells are never updated and the
+  // statistics of the base data hold for the rowset as a whole.
+  ColumnStatsPB stats;
+  if (!rowset_metadata_->GetColumnStats(row_ttl_col_id, &stats) ||
+      !stats.has_max_value() || stats.max_value().size() != sizeof(int64_t)) {
+    return false;
+  }
+  int64_t max_micros;
+  memcpy(&max_micros, stats.max_value().data(), sizeof(max_micros));
+  return max_micros < cutoff_micros;
+}
+
+bool DiskRowSet::MayHaveChangesBetween(const MvccSnapshot& snap_to_exclude,
+                                       const MvccSnapshot& snap_to_include) const {
+  return delta_tracker_->MayHaveDeltasBetween(snap_to_exclude, snap_to_include);
+}
+
 Status DiskRowSet::InitUndoDeltas(Timestamp ancient_history_mark,
                                   MonoTime deadline,
                                   const IOContext* io_context,
@@ -930,6 +1072,26 @@ Status DiskRowSet::DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
                                                  blocks_deleted, bytes_deleted);
 }
 
+Status DiskRowSet::EstimateBytesInTruncatableUndoDeltas(Timestamp ancient_history_mark,
+                                                        double min_ancient_ratio,
+                                                        int64_t* bytes) {
+  *bytes = delta_tracker_->EstimateBytesInTruncatableUndoDeltas(ancient_history_mark,
+                                                                min_ancient_ratio);
+  return Status::OK();
+}
+
+Status DiskRowSet::TruncateAncientUndoDeltas(Timestamp ancient_history_mark,
+                                             double min_ancient_ratio,
+                                             MonoTime deadline,
+                                             const IOContext* io_context,
+                                             int64_t* blocks_truncated,
+                                             int64_t* bytes_truncated) {
+  TRACE_EVENT0("tablet", "DiskRowSet::TruncateAncientUndoDeltas");
+  return delta_tracker_->TruncateAncientUndoDeltas(ancient_history_mark, min_ancient_ratio,
+                                                   deadline, io_context,
+                                                   blocks_truncated, bytes_truncated);
+}
+
 Status DiskRowSet::DebugDumpImpl(int64_t* rows_left, vector<string>* lines) {
   // Using CompactionOrFlushInput to dump our data is an easy way of seeing all the
   // rows and deltas.
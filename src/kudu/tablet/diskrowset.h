@@ -35,6 +35,7 @@
 #include "kudu/common/rowid.h"
 #include "kudu/common/schema.h"
 #include "kudu/fs/block_id.h"
+#include "kudu/fs/block_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -43,10 +44,12 @@
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/tablet_mem_trackers.h"
 #include "kudu/tablet/tablet_metadata.h"
+#include "kudu/util/array_view.h"
 #include "kudu/util/bloom_filter.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/make_shared.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -105,8 +108,11 @@ class OperationResultPB;
 class DiskRowSetWriter {
  public:
   // TODO: document ownership of rowset_metadata
+  //
+  // The blocks of the rowset are placed on the 'tier' storage tier.
   DiskRowSetWriter(RowSetMetadata* rowset_metadata, const Schema* schema,
-                   BloomFilterSizing bloom_sizing);
+                   BloomFilterSizing bloom_sizing,
+                   fs::StorageTier tier = fs::StorageTier::HOT);
 
   ~DiskRowSetWriter();
 
@@ -159,6 +165,7 @@ class DiskRowSetWriter {
   const Schema* const schema_;
 
   BloomFilterSizing bloom_sizing_;
+  const fs::StorageTier tier_;
 
   bool finished_;
   rowid_t written_count_;
@@ -180,10 +187,12 @@ class RollingDiskRowSetWriter {
  public:
   // Create a new rolling writer. The given 'tablet_metadata' must stay valid
   // for the lifetime of this writer, and is used to construct the new rowsets
-  // that this RollingDiskRowSetWriter creates.
+  // that this RollingDiskRowSetWriter creates. The blocks of the rowsets,
+  // including their delta files, are placed on the 'tier' storage tier.
   RollingDiskRowSetWriter(TabletMetadata* tablet_metadata, const Schema& schema,
                           BloomFilterSizing bloom_sizing,
-                          size_t target_rowset_size);
+                          size_t target_rowset_size,
+                          fs::StorageTier tier = fs::StorageTier::HOT);
   ~RollingDiskRowSetWriter();
 
   Status Open();
@@ -262,6 +271,7 @@ class RollingDiskRowSetWriter {
   std::shared_ptr<RowSetMetadata> cur_drs_metadata_;
   const BloomFilterSizing bloom_sizing_;
   const size_t target_rowset_size_;
+  const fs::StorageTier tier_;
 
   std::unique_ptr<DiskRowSetWriter> cur_writer_;
 
@@ -372,6 +382,10 @@ class DiskRowSet :
                          const fs::IOContext* io_context,
                          bool *present, ProbeStats* stats) const override;
 
+  // Looks the keys up in the key index with a single iterator.
+  Status CheckRowsPresent(ArrayView<KeyPresenceProbe> probes,
+                          const fs::IOContext* io_context) const override;
+
   ////////////////////
   // Read functions.
   ////////////////////
@@ -428,6 +442,14 @@ class DiskRowSet :
   Status IsDeletedAndFullyAncient(Timestamp ancient_history_mark,
                                   bool* deleted_and_ancient) override;
 
+  bool EstimateAllDataOlderThan(Timestamp timestamp) const override;
+
+  bool EstimateAllRowsExpired(const ColumnId& row_ttl_col_id,
+                              int64_t cutoff_micros) const override;
+
+  bool MayHaveChangesBetween(const MvccSnapshot& snap_to_exclude,
+                             const MvccSnapshot& snap_to_include) const override;
+
   Status InitUndoDeltas(Timestamp ancient_history_mark,
                         MonoTime deadline,
                         const fs::IOContext* io_context,
@@ -437,6 +459,17 @@ class DiskRowSet :
   Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark, const fs::IOContext* io_context,
                                  int64_t* blocks_deleted, int64_t* bytes_deleted) override;
 
+  Status EstimateBytesInTruncatableUndoDeltas(Timestamp ancient_history_mark,
+                                              double min_ancient_ratio,
+                                              int64_t* bytes) override;
+
+  Status TruncateAncientUndoDeltas(Timestamp ancient_history_mark,
+                                   double min_ancient_ratio,
+                                   MonoTime deadline,
+                                   const fs::IOContext* io_context,
+                                   int64_t* blocks_truncated,
+                                   int64_t* bytes_truncated) override;
+
   // Major compacts all the delta files for all the columns.
   Status MajorCompactDeltaStores(const fs::IOContext* io_context, HistoryGcOpts history_gc_opts);
 
@@ -448,6 +481,10 @@ class DiskRowSet :
     return has_been_compacted_.load();
   }
 
+  void RecordRead() const override;
+
+  double ReadRate() const override;
+
   void set_has_been_compacted() override {
     has_been_compacted_.store(true);
   }
@@ -538,6 +575,13 @@ class DiskRowSet :
   // and thus should not be scheduled for further compactions.
   std::atomic<bool> has_been_compacted_;
 
+  // Count of the reads recorded by RecordRead(), decayed exponentially with
+  // the half-life of --rowset_read_rate_half_life_secs, as of
+  // 'read_count_time_'.
+  mutable simple_spinlock read_count_lock_;
+  mutable double read_count_;
+  mutable MonoTime read_count_time_;
+
   DISALLOW_COPY_AND_ASSIGN(DiskRowSet);
 };
 
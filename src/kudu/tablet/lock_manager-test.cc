@@ -51,6 +51,8 @@ using std::string;
 using std::thread;
 using std::vector;
 
+DECLARE_int32(lock_manager_num_shards);
+
 DEFINE_int32(num_test_threads, 10, "number of stress test client threads");
 DEFINE_int32(num_iterations, 1000, "number of iterations per client thread");
 
@@ -66,8 +68,27 @@ static const OpState* kFakeTransaction =
 class LockManagerTest : public KuduTest {
  public:
   void VerifyAlreadyLocked(const Slice& key) {
+    VerifyAlreadyLocked(&lock_manager_, key);
+  }
+
+  static void VerifyAlreadyLocked(LockManager* manager, const Slice& key) {
     LockEntry *entry;
-    ASSERT_FALSE(lock_manager_.TryLock(key, kFakeTransaction, &entry));
+    ASSERT_FALSE(manager->TryLock(key, kFakeTransaction, &entry));
+  }
+
+  // Returns the sum of the contention profiles of all the shards of the row
+  // lock table of 'manager'.
+  static LockManager::ShardProfile TotalProfile(const LockManager& manager) {
+    LockManager::ShardProfile total;
+    for (const auto& p : manager.GetContentionProfile()) {
+      total.lock_requests += p.lock_requests;
+      total.locked_keys += p.locked_keys;
+      total.contended_acquisitions += p.contended_acquisitions;
+      total.waiting_acquisitions += p.waiting_acquisitions;
+      total.wait_us += p.wait_us;
+      total.max_wait_us = std::max(total.max_wait_us, p.max_wait_us);
+    }
+    return total;
   }
 
   LockManager lock_manager_;
@@ -118,6 +139,70 @@ TEST_F(LockManagerTest, TestLockBatch) {
   }
 }
 
+// Test locking batches of rows spread across the shards of the lock table,
+// including the same row several times in one batch.
+TEST_F(LockManagerTest, TestLockBatchManyShards) {
+  FLAGS_lock_manager_num_shards = 8;
+  LockManager manager;
+  ASSERT_EQ(8, manager.num_shards());
+
+  constexpr int kNumKeys = 100;
+  vector<string> key_strings;
+  for (int i = 0; i < kNumKeys; i++) {
+    key_strings.emplace_back(StringPrintf("key%03d", i));
+  }
+  vector<Slice> keys(key_strings.begin(), key_strings.end());
+  keys.emplace_back(key_strings[0]);
+  keys.emplace_back(key_strings[kNumKeys - 1]);
+  for (int iter = 0; iter < 3; iter++) {
+    {
+      ScopedRowLock l(&manager, kFakeTransaction, keys, LockManager::LOCK_EXCLUSIVE);
+      ASSERT_TRUE(l.acquired());
+      for (const auto& k : key_strings) {
+        NO_FATALS(VerifyAlreadyLocked(&manager, k));
+      }
+      ASSERT_EQ(kNumKeys, TotalProfile(manager).locked_keys);
+    }
+    // Once released, the rows can be locked by another op.
+    for (const auto& k : key_strings) {
+      Slice key(k);
+      ScopedRowLock l(&manager, reinterpret_cast<OpState*>(0xabcdef), {&key, 1},
+                      LockManager::LOCK_EXCLUSIVE);
+      ASSERT_TRUE(l.acquired());
+    }
+  }
+  const auto total = TotalProfile(manager);
+  ASSERT_EQ(0, total.locked_keys);
+  ASSERT_EQ(0, total.contended_acquisitions);
+  ASSERT_GT(total.lock_requests, 3 * keys.size());
+}
+
+// Test that waiting for a row lock held by another op shows up in the
+// contention profile.
+TEST_F(LockManagerTest, TestContentionProfile) {
+  Slice key_a[] = {"a"};
+  const OpState* other_op = reinterpret_cast<OpState*>(0xabcdef);
+  std::unique_ptr<ScopedRowLock> l(new ScopedRowLock(
+      &lock_manager_, kFakeTransaction, key_a, LockManager::LOCK_EXCLUSIVE));
+  thread waiter([&]() {
+    ScopedRowLock l2(&lock_manager_, other_op, key_a, LockManager::LOCK_EXCLUSIVE);
+    CHECK(l2.acquired());
+  });
+  // Only release the lock once the waiter is blocked on it.
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(1, TotalProfile(lock_manager_).waiting_acquisitions);
+  });
+  l.reset();
+  waiter.join();
+
+  const auto total = TotalProfile(lock_manager_);
+  ASSERT_EQ(0, total.locked_keys);
+  ASSERT_EQ(0, total.waiting_acquisitions);
+  ASSERT_EQ(1, total.contended_acquisitions);
+  ASSERT_GT(total.max_wait_us, 0);
+  ASSERT_GE(total.wait_us, total.max_wait_us);
+}
+
 TEST_F(LockManagerTest, TestRelockSameRow) {
   Slice key_a[] = {"a"};
   ScopedRowLock row_lock(&lock_manager_, kFakeTransaction, key_a, LockManager::LOCK_EXCLUSIVE);
@@ -19,6 +19,8 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <limits>
 #include <memory>
@@ -28,19 +30,23 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/common/txn_id.h"
+#include "kudu/gutil/bits.h"
 #include "kudu/gutil/dynamic_annotations.h"
 #include "kudu/gutil/hash/city.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/tablet/ops/op.h"
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/array_view.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/monotime.h"
@@ -53,6 +59,20 @@ using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
+namespace {
+// The upper bound on the number of shards of a tablet's row lock table.
+constexpr int kMaxLockTableShards = 64;
+} // anonymous namespace
+
+DEFINE_int32(lock_manager_num_shards, 0,
+             "Number of shards of the row lock table of each tablet. Writers of "
+             "rows in different shards don't contend on the same spinlock. Rounded "
+             "up to a power of two. If 0, the number of CPU cores is used.");
+TAG_FLAG(lock_manager_num_shards, advanced);
+DEFINE_validator(lock_manager_num_shards, [](const char* /*flagname*/, int32_t value) {
+  return value >= 0 && value <= kMaxLockTableShards;
+});
+
 namespace kudu {
 namespace tablet {
 
@@ -62,14 +82,19 @@ namespace tablet {
 
 // The entry returned to a thread which has taken a lock.
 // Callers should generally use ScopedRowLock (see below).
+//
+// Entries which are no longer referenced are kept on a per-shard free list
+// and reused, so that locking an uncontended key usually doesn't need to
+// allocate memory.
 class LockEntry {
  public:
-  explicit LockEntry(const Slice& key)
-  : sem(1),
-    recursion_(0) {
-    key_hash_ = util_hash::CityHash64(reinterpret_cast<const char *>(key.data()), key.size());
-    key_ = key;
-    refs_ = 1;
+  LockEntry()
+      : sem(1),
+        recursion_(0),
+        ht_next_(nullptr),
+        key_hash_(0),
+        refs_(0),
+        holder_(nullptr) {
   }
 
   bool Equals(const Slice& key, uint64_t hash) const {
@@ -92,17 +117,25 @@ class LockEntry {
 
  private:
   friend class LockTable;
+  friend class LockTableShard;
   friend class LockManager;
 
-  void CopyKey() {
-    key_buf_.assign_copy(key_.data(), key_.size());
+  // Points this entry at a copy of 'key', with a single reference.
+  void Reset(const Slice& key, uint64_t hash) {
+    DCHECK_EQ(0, recursion_);
+    ht_next_ = nullptr;
+    key_hash_ = hash;
+    key_buf_.assign_copy(key.data(), key.size());
     key_ = Slice(key_buf_);
+    refs_ = 1;
+    holder_ = nullptr;
   }
 
-  // Pointer to the next entry in the same hash table bucket
+  // Pointer to the next entry in the same hash table bucket, or in the free
+  // list of the shard.
   LockEntry *ht_next_;
 
-  // Hash of the key, used to lookup the hash table bucket
+  // Hash of the key, used to lookup the shard and the hash table bucket
   uint64_t key_hash_;
 
   // key of the entry, used to compare the entries
@@ -111,14 +144,16 @@ class LockEntry {
   // number of users that are referencing this object
   uint64_t refs_;
 
-  // buffer of the key, allocated on insertion by CopyKey()
+  // buffer of the key, reused when the entry is recycled
   faststring key_buf_;
 
   // The op currently holding the lock
   const OpState* holder_;
 };
 
-class LockTable {
+// A single shard of the lock table: a chained hash table protected by a
+// spinlock.
+class LockTableShard {
  private:
   struct Bucket {
     // First entry chained from this bucket, or NULL if the bucket is empty.
@@ -127,11 +162,21 @@ class LockTable {
   };
 
  public:
-  LockTable() : mask_(0), size_(0), item_count_(0) {
+  LockTableShard()
+      : mask_(0),
+        size_(0),
+        item_count_(0),
+        free_list_(nullptr),
+        free_count_(0),
+        lock_requests_(0),
+        contended_count_(0),
+        waiting_count_(0),
+        wait_us_(0),
+        max_wait_us_(0) {
     Resize();
   }
 
-  ~LockTable() {
+  ~LockTableShard() {
     // Sanity checks: The table shouldn't be destructed when there are any entries in it.
     DCHECK_EQ(0, item_count_) << "There are some unreleased locks";
     for (size_t i = 0; i < size_; ++i) {
@@ -139,14 +184,55 @@ class LockTable {
         DCHECK(p == nullptr) << "The entry " << p->ToString() << " was not released";
       }
     }
+    DeleteChain(free_list_);
   }
 
-  vector<LockEntry*> GetLockEntries(ArrayView<Slice> keys);
-  LockEntry* GetLockEntry(Slice key);
+  // Looks up (or inserts) the entry for keys[i] for each index 'i' in 'idxs',
+  // storing it into entries[i]. The keys must all map to this shard, and
+  // 'hashes' holds the hash of each key. 'idxs' is used as scratch space.
+  void GetLockEntries(ArrayView<Slice> keys,
+                      const uint64_t* hashes,
+                      ArrayView<int> idxs,
+                      LockEntry** entries);
 
   void ReleaseLockEntries(ArrayView<LockEntry*> entries);
 
+  // Records the start of a wait for a lock in this shard held by another op.
+  void StartWaiting() {
+    waiting_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Records an acquisition of a lock in this shard which had to wait
+  // 'wait_us' microseconds since StartWaiting() for the previous holder to
+  // release it.
+  void RecordContention(int64_t wait_us) {
+    waiting_count_.fetch_sub(1, std::memory_order_relaxed);
+    contended_count_.fetch_add(1, std::memory_order_relaxed);
+    wait_us_.fetch_add(wait_us, std::memory_order_relaxed);
+    int64_t prev_max = max_wait_us_.load(std::memory_order_relaxed);
+    while (wait_us > prev_max &&
+           !max_wait_us_.compare_exchange_weak(prev_max, wait_us, std::memory_order_relaxed)) {
+    }
+  }
+
+  LockManager::ShardProfile GetProfile() const {
+    LockManager::ShardProfile profile;
+    {
+      std::lock_guard<simple_spinlock> l(lock_);
+      profile.lock_requests = lock_requests_;
+      profile.locked_keys = item_count_;
+    }
+    profile.contended_acquisitions = contended_count_.load(std::memory_order_relaxed);
+    profile.waiting_acquisitions = waiting_count_.load(std::memory_order_relaxed);
+    profile.wait_us = wait_us_.load(std::memory_order_relaxed);
+    profile.max_wait_us = max_wait_us_.load(std::memory_order_relaxed);
+    return profile;
+  }
+
  private:
+  // The maximum number of unreferenced entries kept for reuse.
+  static constexpr int kMaxFreeEntries = 16;
+
   Bucket *FindBucket(uint64_t hash) const {
     return &(buckets_[hash & mask_]);
   }
@@ -174,10 +260,44 @@ class LockTable {
     return nullptr;
   }
 
+  // Links 'entry' into the slot 'node' returned by FindSlot().
+  void InsertLocked(LockEntry** node, LockEntry* entry) {
+    DCHECK(lock_.is_locked());
+    entry->ht_next_ = nullptr;
+    *node = entry;
+    ++item_count_;
+
+    if (PREDICT_FALSE(item_count_ > size_)) {
+      Resize();
+    }
+  }
+
+  // Puts an unreferenced entry on the free list if there is room for it,
+  // otherwise chains it onto 'to_delete' so the caller can free it outside
+  // the lock.
+  void RecycleLocked(LockEntry* entry, LockEntry** to_delete) {
+    DCHECK(lock_.is_locked());
+    if (free_count_ < kMaxFreeEntries) {
+      entry->ht_next_ = free_list_;
+      free_list_ = entry;
+      ++free_count_;
+    } else {
+      entry->ht_next_ = *to_delete;
+      *to_delete = entry;
+    }
+  }
+
+  static void DeleteChain(LockEntry* head) {
+    while (head) {
+      auto* tmp = head;
+      head = head->ht_next_;
+      delete tmp;
+    }
+  }
+
   void Resize();
 
- private:
-  simple_spinlock lock_;
+  mutable simple_spinlock lock_;
   // size - 1 used to lookup the bucket (hash & mask_)
   uint64_t mask_;
   // number of buckets in the table
@@ -186,52 +306,84 @@ class LockTable {
   int64_t item_count_;
   // table buckets
   unique_ptr<Bucket[]> buckets_;
+
+  // Unreferenced entries available for reuse, chained through 'ht_next_'.
+  LockEntry* free_list_;
+  int free_count_;
+
+  // Contention profile of the shard. 'lock_requests_' is protected by
+  // 'lock_'; the others are updated outside of it.
+  int64_t lock_requests_;
+  std::atomic<int64_t> contended_count_;
+  std::atomic<int64_t> waiting_count_;
+  std::atomic<int64_t> wait_us_;
+  std::atomic<int64_t> max_wait_us_;
 };
 
-vector<LockEntry*> LockTable::GetLockEntries(ArrayView<Slice> keys) {
-  vector<LockEntry*> entries(keys.size());
-  for (auto i = 0; i < keys.size(); ++i) {
-    entries[i] = new LockEntry(keys[i]);
+void LockTableShard::GetLockEntries(ArrayView<Slice> keys,
+                                    const uint64_t* hashes,
+                                    ArrayView<int> idxs,
+                                    LockEntry** entries) {
+  // Fast path: look up the keys, and insert entries taken from the free list
+  // for the keys which aren't locked yet. The indexes of the keys that need a
+  // newly allocated entry are compacted at the front of 'idxs'.
+  int num_missing = 0;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    lock_requests_ += idxs.size();
+    for (int idx : idxs) {
+      Bucket* bucket = FindBucket(hashes[idx]);
+      LockEntry** node = FindSlot(bucket, keys[idx], hashes[idx]);
+      LockEntry* entry = *node;
+      if (PREDICT_FALSE(entry != nullptr)) {
+        entry->refs_++;
+      } else if (PREDICT_TRUE(free_list_ != nullptr)) {
+        entry = free_list_;
+        free_list_ = entry->ht_next_;
+        --free_count_;
+        entry->Reset(keys[idx], hashes[idx]);
+        InsertLocked(node, entry);
+      } else {
+        idxs[num_missing++] = idx;
+        continue;
+      }
+      entries[idx] = entry;
+    }
+  }
+  if (PREDICT_TRUE(num_missing == 0)) {
+    return;
   }
 
-  vector<LockEntry*> to_delete;
-
-  // TODO(todd) prefetch the hash buckets
+  // Slow path: allocate the remaining entries outside the lock, and insert
+  // them unless another thread has inserted the same key in the meantime.
+  for (int i = 0; i < num_missing; i++) {
+    const int idx = idxs[i];
+    entries[idx] = new LockEntry();
+    entries[idx]->Reset(keys[idx], hashes[idx]);
+  }
+  LockEntry* to_delete = nullptr;
   {
     std::lock_guard<simple_spinlock> l(lock_);
-    for (int i = 0; i < entries.size(); i++) {
-      LockEntry* new_entry = entries[i];
+    for (int i = 0; i < num_missing; i++) {
+      const int idx = idxs[i];
+      LockEntry* new_entry = entries[idx];
       Bucket* bucket = FindBucket(new_entry->key_hash_);
-      LockEntry **node = FindSlot(bucket, new_entry->key_, new_entry->key_hash_);
+      LockEntry** node = FindSlot(bucket, new_entry->key_, new_entry->key_hash_);
       LockEntry* old_entry = *node;
       if (PREDICT_FALSE(old_entry != nullptr)) {
         old_entry->refs_++;
-        to_delete.push_back(entries[i]);
-        entries[i] = old_entry;
+        new_entry->refs_ = 0;
+        RecycleLocked(new_entry, &to_delete);
+        entries[idx] = old_entry;
       } else {
-        new_entry->ht_next_ = nullptr;
-        new_entry->CopyKey();
-        *node = new_entry;
-        ++item_count_;
-
-        if (PREDICT_FALSE(item_count_ > size_)) {
-          Resize();
-        }
+        InsertLocked(node, new_entry);
       }
     }
   }
-
-  for (auto* e : to_delete) delete e;
-
-  return entries;
-}
-
-LockEntry* LockTable::GetLockEntry(Slice key) {
-  vector<LockEntry*> entries = GetLockEntries({&key, 1});
-  return entries[0];
+  DeleteChain(to_delete);
 }
 
-void LockTable::ReleaseLockEntries(ArrayView<LockEntry*> entries) {
+void LockTableShard::ReleaseLockEntries(ArrayView<LockEntry*> entries) {
   // Construct a linked list co-opting the ht_next pointers of the entries
   // to keep track of which objects need to be deleted.
   LockEntry* removed_head = nullptr;
@@ -242,9 +394,8 @@ void LockTable::ReleaseLockEntries(ArrayView<LockEntry*> entries) {
       if (--entry->refs_ > 0) return;
 
       *node = entry->ht_next_;
-      entry->ht_next_ = removed_head;
-      removed_head = entry;
       item_count_--;
+      RecycleLocked(entry, &removed_head);
     } else {
       LOG(DFATAL) << "Unable to find LockEntry on release";
     }
@@ -282,14 +433,10 @@ void LockTable::ReleaseLockEntries(ArrayView<LockEntry*> entries) {
   }
 
   // Actually free the memory outside the lock.
-  while (removed_head) {
-    auto* tmp = removed_head;
-    removed_head = removed_head->ht_next_;
-    delete tmp;
-  }
+  DeleteChain(removed_head);
 }
 
-void LockTable::Resize() {
+void LockTableShard::Resize() {
   // Calculate a new table size
   size_t new_size = 16;
   while (new_size < item_count_) {
@@ -324,6 +471,120 @@ void LockTable::Resize() {
   buckets_.swap(new_buckets);
 }
 
+// The row lock table, split into shards so that writers of unrelated rows
+// don't contend on a single spinlock. The shard of a key is determined by
+// the high bits of its hash, while the buckets within a shard are determined
+// by the low bits.
+class LockTable {
+ public:
+  explicit LockTable(int shard_bits)
+      : shard_bits_(shard_bits),
+        shards_(new LockTableShard[1 << shard_bits]) {
+  }
+
+  vector<LockEntry*> GetLockEntries(ArrayView<Slice> keys);
+  LockEntry* GetLockEntry(Slice key);
+
+  void ReleaseLockEntries(ArrayView<LockEntry*> entries);
+
+  LockTableShard* shard_for(uint64_t hash) const {
+    return &shards_[shard_index(hash)];
+  }
+
+  int num_shards() const {
+    return 1 << shard_bits_;
+  }
+
+  const LockTableShard& shard(int i) const {
+    return shards_[i];
+  }
+
+ private:
+  static uint64_t HashKey(const Slice& key) {
+    return util_hash::CityHash64(reinterpret_cast<const char*>(key.data()), key.size());
+  }
+
+  int shard_index(uint64_t hash) const {
+    return shard_bits_ == 0 ? 0 : static_cast<int>(hash >> (64 - shard_bits_));
+  }
+
+  const int shard_bits_;
+  unique_ptr<LockTableShard[]> shards_;
+};
+
+vector<LockEntry*> LockTable::GetLockEntries(ArrayView<Slice> keys) {
+  vector<LockEntry*> entries(keys.size());
+  if (keys.size() == 1) {
+    uint64_t hash = HashKey(keys[0]);
+    int idx = 0;
+    shard_for(hash)->GetLockEntries(keys, &hash, {&idx, 1}, entries.data());
+    return entries;
+  }
+
+  // Group the keys by shard with a counting sort, so that each shard's lock
+  // is taken once per batch.
+  const int num_shards = 1 << shard_bits_;
+  vector<uint64_t> hashes(keys.size());
+  vector<int> offsets(num_shards + 1, 0);
+  for (auto i = 0; i < keys.size(); ++i) {
+    hashes[i] = HashKey(keys[i]);
+    offsets[shard_index(hashes[i]) + 1]++;
+  }
+  for (int s = 0; s < num_shards; s++) {
+    offsets[s + 1] += offsets[s];
+  }
+  vector<int> idxs(keys.size());
+  {
+    vector<int> pos(offsets.begin(), offsets.end() - 1);
+    for (auto i = 0; i < keys.size(); ++i) {
+      idxs[pos[shard_index(hashes[i])]++] = i;
+    }
+  }
+  for (int s = 0; s < num_shards; s++) {
+    const int count = offsets[s + 1] - offsets[s];
+    if (count == 0) continue;
+    shards_[s].GetLockEntries(keys, hashes.data(),
+                              {idxs.data() + offsets[s], static_cast<size_t>(count)},
+                              entries.data());
+  }
+  return entries;
+}
+
+LockEntry* LockTable::GetLockEntry(Slice key) {
+  vector<LockEntry*> entries = GetLockEntries({&key, 1});
+  return entries[0];
+}
+
+void LockTable::ReleaseLockEntries(ArrayView<LockEntry*> entries) {
+  if (entries.empty()) return;
+  if (shard_bits_ == 0) {
+    shards_[0].ReleaseLockEntries(entries);
+    return;
+  }
+
+  // Release the entries in runs of consecutive entries that belong to the
+  // same shard, so that each shard's lock is taken once per batch.
+  vector<LockEntry*> sorted;
+  ArrayView<LockEntry*> to_release = entries;
+  if (entries.size() > 1) {
+    sorted.assign(entries.begin(), entries.end());
+    std::sort(sorted.begin(), sorted.end(), [&](const LockEntry* a, const LockEntry* b) {
+      return shard_index(a->key_hash_) < shard_index(b->key_hash_);
+    });
+    to_release = sorted;
+  }
+  size_t start = 0;
+  while (start < to_release.size()) {
+    const int s = shard_index(to_release[start]->key_hash_);
+    size_t end = start + 1;
+    while (end < to_release.size() && shard_index(to_release[end]->key_hash_) == s) {
+      end++;
+    }
+    shards_[s].ReleaseLockEntries({to_release.data() + start, end - start});
+    start = end;
+  }
+}
+
 // ============================================================================
 //  ScopedRowLock
 // ============================================================================
@@ -445,10 +706,18 @@ void ScopedPartitionLock::TakeState(ScopedPartitionLock* other) {
 //  LockManager
 // ============================================================================
 
+// Determine the number of bits of the hash that should be used to determine
+// the lock table shard. This, in turn, determines the number of shards.
+static int DetermineLockTableShardBits() {
+  const int num_shards = FLAGS_lock_manager_num_shards > 0 ?
+      FLAGS_lock_manager_num_shards : std::min(base::NumCPUs(), kMaxLockTableShards);
+  return Bits::Log2Ceiling(num_shards);
+}
+
 LockManager::LockManager()
   : partition_sem_(1),
     partition_lock_refs_(0),
-    locks_(new LockTable) {
+    locks_(new LockTable(DetermineLockTableShardBits())) {
 }
 
 LockManager::~LockManager() {
@@ -547,6 +816,19 @@ std::vector<LockEntry*> LockManager::LockBatch(ArrayView<Slice> keys, const OpSt
 
 void LockManager::ReleaseBatch(ArrayView<LockEntry*> locks) { locks_->ReleaseLockEntries(locks); }
 
+int LockManager::num_shards() const {
+  return locks_->num_shards();
+}
+
+vector<LockManager::ShardProfile> LockManager::GetContentionProfile() const {
+  vector<ShardProfile> profile;
+  profile.reserve(locks_->num_shards());
+  for (int i = 0; i < locks_->num_shards(); i++) {
+    profile.emplace_back(locks_->shard(i).GetProfile());
+  }
+  return profile;
+}
+
 void LockManager::ReleasePartitionLock() {
   std::lock_guard<simple_spinlock> l(p_lock_);
   DCHECK_GT(partition_lock_refs_, 0);
@@ -579,7 +861,9 @@ void LockManager::AcquireLockOnEntry(LockEntry* entry, const OpState* op) {
     // TODO: would be nice to hook in some histogram metric about lock acquisition
     // time. For now we just associate with per-request metrics.
     TRACE_COUNTER_INCREMENT("row_lock_wait_count", 1);
+    LockTableShard* shard = locks_->shard_for(entry->key_hash());
     MicrosecondsInt64 start_wait_us = GetMonoTimeMicros();
+    shard->StartWaiting();
     int waited_seconds = 0;
     while (!entry->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
       const OpState* cur_holder = ANNOTATE_UNPROTECTED_READ(entry->holder_);
@@ -593,6 +877,7 @@ void LockManager::AcquireLockOnEntry(LockEntry* entry, const OpState* op) {
       // complete at any point)
     }
     MicrosecondsInt64 wait_us = GetMonoTimeMicros() - start_wait_us;
+    shard->RecordContention(wait_us);
     TRACE_COUNTER_INCREMENT("row_lock_wait_us", wait_us);
     if (wait_us > 100 * 1000) {
       TRACE("Waited $0us for lock on $1 (key hash $2)",
@@ -73,6 +73,28 @@ class LockManager {
 
  int64_t partition_lock_refs() const { return partition_lock_refs_; }
 
+  // A snapshot of the contention profile of one shard of the row lock table.
+  struct ShardProfile {
+    // The number of row lock requests routed to the shard.
+    int64_t lock_requests = 0;
+    // The number of rows currently locked, or waited on, in the shard.
+    int64_t locked_keys = 0;
+    // The number of row lock acquisitions that had to wait for another op.
+    int64_t contended_acquisitions = 0;
+    // The number of row lock acquisitions currently waiting for another op.
+    int64_t waiting_acquisitions = 0;
+    // The total and maximum time spent waiting by those acquisitions.
+    int64_t wait_us = 0;
+    int64_t max_wait_us = 0;
+  };
+
+  // Returns the number of shards of the row lock table.
+  int num_shards() const;
+
+  // Returns the contention profile of each shard of the row lock table, used
+  // by the tablet's debug page.
+  std::vector<ShardProfile> GetContentionProfile() const;
+
  private:
   friend class ScopedPartitionLock;
   friend class ScopedRowLock;
@@ -106,7 +128,7 @@ class LockManager {
   PartitionLockState* WaitUntilAcquiredPartitionLock(const TxnId& txn_id);
   void ReleasePartitionLock();
 
-  static void AcquireLockOnEntry(LockEntry* e, const OpState* op);
+  void AcquireLockOnEntry(LockEntry* e, const OpState* op);
 
   // Semaphore used by the LockManager to signal the release of the partition
   // lock. If its value is >= 0, the partition lock is already held, and
@@ -37,11 +37,14 @@
 #include "kudu/tablet/local_tablet_writer.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 
 DECLARE_double(cfile_inject_corruption);
+DECLARE_int32(major_delta_compaction_threads);
+DECLARE_int64(major_delta_compaction_parallel_min_bytes);
 
 using std::shared_ptr;
 using std::string;
@@ -297,6 +300,49 @@ TEST_F(TestMajorDeltaCompaction, TestUndos) {
   NO_FATALS(VerifyData());
 }
 
+// Verify that a major delta compaction split into column sets rewrites each
+// of them, writes an UNDO file per set, and writes the uncompacted REDOs back
+// once.
+TEST_F(TestMajorDeltaCompaction, TestParallelCompact) {
+  FLAGS_major_delta_compaction_threads = 2;
+  FLAGS_major_delta_compaction_parallel_min_bytes = 0;
+  const int kNumRows = 100;
+  NO_FATALS(WriteTestTablet(kNumRows));
+  ASSERT_OK(tablet()->Flush());
+
+  vector<shared_ptr<RowSet> > all_rowsets;
+  tablet()->GetRowSetsForTests(&all_rowsets);
+  shared_ptr<RowSet> rs = all_rowsets.front();
+
+  MvccSnapshot snap(*tablet()->mvcc_manager());
+  vector<ExpectedRow> old_state(expected_state_);
+
+  NO_FATALS(UpdateRows(kNumRows, false));
+  ASSERT_OK(tablet()->FlushBiggestDMSForTests());
+  NO_FATALS(UpdateRows(kNumRows, true));
+  ASSERT_OK(tablet()->FlushBiggestDMSForTests());
+  const size_t num_undo_blocks = rs->metadata()->undo_delta_blocks().size();
+
+  // Each of the three columns is compacted in its own set.
+  vector<ColumnId> col_ids_to_compact = { schema_.column_id(1),
+                                          schema_.column_id(3),
+                                          schema_.column_id(4) };
+  ASSERT_OK(tablet()->DoMajorDeltaCompaction(col_ids_to_compact, rs));
+  ASSERT_EQ(num_undo_blocks + 3, rs->metadata()->undo_delta_blocks().size());
+  ASSERT_TRUE(rs->metadata()->redo_delta_blocks().empty());
+  NO_FATALS(VerifyData());
+  NO_FATALS(VerifyDataWithMvccAndExpectedState(snap, old_state));
+
+  // Leave one of the updated columns out: its updates must be kept as REDOs.
+  NO_FATALS(UpdateRows(kNumRows, false));
+  ASSERT_OK(tablet()->FlushBiggestDMSForTests());
+  col_ids_to_compact.pop_back();
+  ASSERT_OK(tablet()->DoMajorDeltaCompaction(col_ids_to_compact, rs));
+  ASSERT_EQ(1, rs->metadata()->redo_delta_blocks().size());
+  NO_FATALS(VerifyData());
+  NO_FATALS(VerifyDataWithMvccAndExpectedState(snap, old_state));
+}
+
 // Test that the delete REDO mutations are written back and not filtered out.
 TEST_F(TestMajorDeltaCompaction, TestCarryDeletesOver) {
   const int kNumRows = 100;
@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/memrowset.h"
 
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <string>
@@ -28,6 +29,7 @@
 #include <glog/logging.h>
 
 #include "kudu/codegen/compilation_manager.h"
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/codegen/row_projector.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/encoded_key.h"
@@ -53,6 +55,19 @@ DEFINE_bool(mrs_use_codegen, true, "whether the memrowset should use code "
             "generation for iteration");
 TAG_FLAG(mrs_use_codegen, hidden);
 
+DEFINE_bool(mrs_use_codegen_predicates, true, "whether the memrowset should evaluate "
+            "the predicates of a scan with generated code, if code generation is "
+            "used for iteration");
+TAG_FLAG(mrs_use_codegen_predicates, hidden);
+TAG_FLAG(mrs_use_codegen_predicates, runtime);
+
+DEFINE_bool(memstore_use_huge_page_arenas, false,
+            "Whether the MemRowSets and DeltaMemStores should allocate their memory in "
+            "chunks of huge pages, which are returned to a process-wide pool when they're "
+            "flushed. This reduces the fragmentation of the heap and the TLB misses of "
+            "lookups in their trees. See --huge_page_allocator_max_free_mb.");
+TAG_FLAG(memstore_use_huge_page_arenas, experimental);
+
 using kudu::consensus::OpId;
 using kudu::fs::IOContext;
 using kudu::log::LogAnchorRegistry;
@@ -130,7 +145,9 @@ MemRowSet::MemRowSet(int64_t id,
     txn_id_(txn_id),
     txn_metadata_(std::move(txn_metadata)),
     allocator_(new MemoryTrackingBufferAllocator(
-        HeapBufferAllocator::Get(),
+        FLAGS_memstore_use_huge_page_arenas ?
+            static_cast<BufferAllocator*>(HugePageBufferAllocator::Get()) :
+            HeapBufferAllocator::Get(),
         CreateMemTrackerForMemRowSet(id, std::move(parent_tracker)))),
     arena_(new ThreadSafeMemoryTrackingArena(kInitialArenaSize, allocator_)),
     tree_(arena_),
@@ -141,6 +158,9 @@ MemRowSet::MemRowSet(int64_t id,
     has_been_compacted_(false),
     live_row_count_(0) {
   CHECK(schema.has_column_ids());
+  if (FLAGS_memstore_use_huge_page_arenas) {
+    arena_->SetMaxBufferSize(HugePageBufferAllocator::kChunkSize);
+  }
   ANNOTATE_BENIGN_RACE(&debug_insert_count_, "insert count isnt accurate");
   ANNOTATE_BENIGN_RACE(&debug_update_count_, "update count isnt accurate");
 }
@@ -418,6 +438,37 @@ unique_ptr<MRSRowProjector> GenerateAppropriateProjector(
     new MRSRowProjectorImpl<RowProjector>(std::move(actual)));
 }
 
+// If codegen is enabled and a code-generated evaluator of all the predicates
+// of 'spec' is ready, writes it to 'out' and removes the predicates from
+// 'spec'. Otherwise, the predicates are left to be evaluated by the caller.
+void MaybeGeneratePredicateEvaluator(const Schema& projection, ScanSpec* spec,
+                                     unique_ptr<codegen::PredicateEvaluator>* out) {
+  if (!FLAGS_mrs_use_codegen || !FLAGS_mrs_use_codegen_predicates ||
+      spec == nullptr || spec->predicates().empty()) {
+    return;
+  }
+  vector<codegen::ColumnIdxAndPredicate> predicates;
+  predicates.reserve(spec->predicates().size());
+  for (const auto& col_pred : spec->predicates()) {
+    int col_idx = projection.find_column(col_pred.first);
+    if (col_idx == Schema::kColumnNotFound) {
+      return;
+    }
+    predicates.emplace_back(col_idx, col_pred.second);
+  }
+  // The order of the predicates in the spec is unspecified: sort them so
+  // the same predicates reuse the same code.
+  std::sort(predicates.begin(), predicates.end(),
+            [] (const codegen::ColumnIdxAndPredicate& left,
+                const codegen::ColumnIdxAndPredicate& right) {
+              return left.first < right.first;
+            });
+  if (codegen::CompilationManager::GetSingleton()->RequestPredicateEvaluator(
+          predicates, out)) {
+    spec->RemovePredicates();
+  }
+}
+
 } // anonymous namespace
 
 MemRowSet::Iterator::Iterator(const std::shared_ptr<const MemRowSet>& mrs,
@@ -462,6 +513,8 @@ Status MemRowSet::Iterator::Init(ScanSpec *spec) {
         spec->exclusive_upper_bound_key()->encoded_key());
   }
 
+  MaybeGeneratePredicateEvaluator(*opts_.projection, spec, &predicate_evaluator_);
+
   state_ = kScanning;
   return Status::OK();
 }
@@ -517,6 +570,10 @@ Status MemRowSet::Iterator::NextBlock(RowBlock *dst) {
   // Clear unreached bits by resizing
   dst->Resize(fetched);
 
+  if (predicate_evaluator_) {
+    predicate_evaluator_->Evaluate(dst);
+  }
+
   return Status::OK();
 }
 
@@ -68,6 +68,10 @@ namespace tablet {
 class MvccSnapshot;
 }  // namespace tablet
 
+namespace codegen {
+class PredicateEvaluator;
+}  // namespace codegen
+
 namespace consensus {
 class OpId;
 }  // namespace consensus
@@ -187,6 +191,9 @@ class MRSRow {
 
 struct MSBTreeTraits : public btree::BTreeTraits {
   typedef ThreadSafeMemoryTrackingArena ArenaType;
+
+  // The encoded primary keys of most tables are longer than 8 bytes.
+  static const size_t kInlineKeyPrefixes = 1;
 };
 
 // Define an MRSRow instance using on-stack storage.
@@ -447,6 +454,25 @@ class MemRowSet : public RowSet,
     return Status::OK();
   }
 
+  Status EstimateBytesInTruncatableUndoDeltas(Timestamp /*ancient_history_mark*/,
+                                              double /*min_ancient_ratio*/,
+                                              int64_t* bytes) override {
+    DCHECK(bytes);
+    *bytes = 0;
+    return Status::OK();
+  }
+
+  Status TruncateAncientUndoDeltas(Timestamp /*ancient_history_mark*/,
+                                   double /*min_ancient_ratio*/,
+                                   MonoTime /*deadline*/,
+                                   const fs::IOContext* /*io_context*/,
+                                   int64_t* blocks_truncated,
+                                   int64_t* bytes_truncated) override {
+    if (blocks_truncated) *blocks_truncated = 0;
+    if (bytes_truncated) *bytes_truncated = 0;
+    return Status::OK();
+  }
+
   Status FlushDeltas(const fs::IOContext* /*io_context*/) override { return Status::OK(); }
 
   Status MinorCompactDeltaStores(
@@ -667,6 +693,11 @@ class MemRowSet::Iterator : public RowwiseIterator {
 
   // Pushed down encoded upper bound key, if any
   std::optional<const Slice> exclusive_upper_bound_;
+
+  // Code-generated evaluator of the predicates of the scan spec, if any.
+  // When set, the predicates were removed from the spec and are evaluated
+  // on each fetched block.
+  std::unique_ptr<codegen::PredicateEvaluator> predicate_evaluator_;
 };
 
 inline const Schema* MRSRow::schema() const {
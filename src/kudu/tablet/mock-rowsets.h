@@ -177,6 +177,23 @@ class MockRowSet : public RowSet {
     return Status::OK();
   }
 
+  Status EstimateBytesInTruncatableUndoDeltas(Timestamp /*ancient_history_mark*/,
+                                              double /*min_ancient_ratio*/,
+                                              int64_t* /*bytes*/) override {
+    LOG(FATAL) << "Unimplemented";
+    return Status::OK();
+  }
+
+  Status TruncateAncientUndoDeltas(Timestamp /*ancient_history_mark*/,
+                                   double /*min_ancient_ratio*/,
+                                   MonoTime /*deadline*/,
+                                   const fs::IOContext* /*io_context*/,
+                                   int64_t* /*blocks_truncated*/,
+                                   int64_t* /*bytes_truncated*/) override {
+    LOG(FATAL) << "Unimplemented";
+    return Status::OK();
+  }
+
   bool IsAvailableForCompaction() override {
     return true;
   }
@@ -190,7 +207,8 @@ class MockDiskRowSet : public MockRowSet {
       : first_key_(std::move(first_key)),
         last_key_(std::move(last_key)),
         size_(size),
-        column_size_(column_size) {}
+        column_size_(column_size),
+        read_rate_(0) {}
 
   Status GetBounds(std::string* min_encoded_key,
                    std::string* max_encoded_key) const override {
@@ -221,11 +239,20 @@ class MockDiskRowSet : public MockRowSet {
                                Slice(last_key_).ToDebugString());
   }
 
+  double ReadRate() const override {
+    return read_rate_;
+  }
+
+  void set_read_rate(double read_rate) {
+    read_rate_ = read_rate;
+  }
+
  private:
   const std::string first_key_;
   const std::string last_key_;
   const uint64_t size_;
   const uint64_t column_size_;
+  double read_rate_;
 };
 
 // Mock which acts like a MemRowSet and has no known bounds.
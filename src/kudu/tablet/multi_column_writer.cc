@@ -17,10 +17,16 @@
 
 #include "kudu/tablet/multi_column_writer.h"
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
 
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/cfile_writer.h"
@@ -30,39 +36,114 @@
 #include "kudu/fs/block_id.h"
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
+#include "kudu/tablet/column_group.h"
+#include "kudu/tablet/metadata.pb.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/threadpool.h"
+
+DEFINE_int32(flush_encode_threads, 0,
+             "Number of threads of a shared pool that help encoding the columns "
+             "of the rowsets written by flushes and compactions. The columns of "
+             "each block of rows written are split into ranges, one of which is "
+             "encoded by the writing thread itself. If 0, the writing threads "
+             "encode all the columns by themselves.");
+TAG_FLAG(flush_encode_threads, advanced);
+TAG_FLAG(flush_encode_threads, experimental);
+TAG_FLAG(flush_encode_threads, runtime);
+DEFINE_validator(flush_encode_threads,
+                 [](const char* /*n*/, int32 v) { return v >= 0; });
 
 using kudu::cfile::CFileWriter;
 using kudu::fs::BlockCreationTransaction;
 using kudu::fs::CreateBlockOptions;
 using kudu::fs::WritableBlock;
 using std::map;
+using std::set;
 using std::string;
 using std::unique_ptr;
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
 namespace tablet {
 
+namespace {
+
+// The minimum number of cells, i.e. rows times columns, of a block for its
+// columns to be encoded in parallel, and of each range of columns then.
+// Smaller ranges aren't worth the handoff to another thread.
+constexpr size_t kMinParallelEncodeCells = 4096;
+
+// Returns the pool helping to encode the columns, created on first use.
+ThreadPool* EncodePool() {
+  static std::once_flag once;
+  static ThreadPool* pool = nullptr;
+  std::call_once(once, []() {
+    unique_ptr<ThreadPool> p;
+    CHECK_OK(ThreadPoolBuilder("flush-encode")
+             .set_min_threads(0)
+             .set_max_threads(base::NumCPUs())
+             .Build(&p));
+    pool = p.release();
+  });
+  return pool;
+}
+
+} // anonymous namespace
+
 MultiColumnWriter::MultiColumnWriter(FsManager* fs,
                                      const Schema* schema,
-                                     string tablet_id)
+                                     string tablet_id,
+                                     int column_group_size,
+                                     set<string> bloom_filter_columns,
+                                     bool collect_value_stats,
+                                     fs::StorageTier tier)
     : fs_(fs),
       schema_(DCHECK_NOTNULL(schema)),
       tablet_id_(std::move(tablet_id)),
+      column_group_size_(column_group_size),
+      bloom_filter_columns_(std::move(bloom_filter_columns)),
+      collect_value_stats_(collect_value_stats),
+      tier_(tier),
       open_(false),
       finished_(false) {
   cfile_writers_.reserve(schema_->num_columns());
   block_ids_.reserve(schema_->num_columns());
+  encode_times_.resize(schema_->num_columns(), MonoDelta::FromNanoseconds(0));
+}
+
+MultiColumnWriter::~MultiColumnWriter() {
 }
 
 Status MultiColumnWriter::Open() {
   DCHECK(!open_) << "already open";
   DCHECK(cfile_writers_.empty()); // this method isn't re-entrant after failures
 
+  // Assign the non-key columns to their groups, if any. The key columns are
+  // read on their own by the key lookups and their bloom filter checks, so
+  // they're kept apart.
+  group_idx_.assign(schema_->num_columns(), -1);
+  if (column_group_size_ > 1) {
+    int group_size = 0;
+    for (auto i = schema_->num_key_columns(); i < schema_->num_columns(); ++i) {
+      if (group_writers_.empty() || group_size == column_group_size_) {
+        unique_ptr<ColumnGroupWriter> group(new ColumnGroupWriter(fs_, tablet_id_, tier_));
+        RETURN_NOT_OK(group->Open());
+        group_writers_.emplace_back(std::move(group));
+        group_size = 0;
+      }
+      group_idx_[i] = group_writers_.size() - 1;
+      group_size++;
+    }
+  }
+
   // Open columns.
-  const CreateBlockOptions block_opts({ tablet_id_ });
+  const CreateBlockOptions block_opts({ tablet_id_, tier_ });
   for (auto i = 0; i < schema_->num_columns(); ++i) {
     const auto& col = schema_->column(i);
 
@@ -80,11 +161,18 @@ Status MultiColumnWriter::Open() {
       opts.write_validx = true;
     }
 
+    opts.write_bloom_filter = ContainsKey(bloom_filter_columns_, col.name());
+    opts.collect_value_stats = collect_value_stats_;
+
     // Open file for writing.
     unique_ptr<WritableBlock> block;
-    RETURN_NOT_OK_PREPEND(fs_->CreateNewBlock(block_opts, &block),
-        Substitute("tablet $0: unable to open output file for column $1",
-                   tablet_id_, col.ToString()));
+    if (group_idx_[i] >= 0) {
+      block = group_writers_[group_idx_[i]]->NewColumnBlock(schema_->column_id(i));
+    } else {
+      RETURN_NOT_OK_PREPEND(fs_->CreateNewBlock(block_opts, &block),
+          Substitute("tablet $0: unable to open output file for column $1",
+                     tablet_id_, col.ToString()));
+    }
     BlockId block_id(block->id());
 
     // Create the CFile writer itself.
@@ -105,7 +193,42 @@ Status MultiColumnWriter::Open() {
 
 Status MultiColumnWriter::AppendBlock(const RowBlock& block) {
   DCHECK(open_);
-  for (auto i = 0; i < schema_->num_columns(); ++i) {
+  const size_t num_columns = schema_->num_columns();
+  const size_t num_cells = block.nrows() * num_columns;
+  const size_t num_ranges = std::min<size_t>(
+      { static_cast<size_t>(FLAGS_flush_encode_threads) + 1,
+        num_cells / kMinParallelEncodeCells,
+        num_columns });
+  if (num_ranges <= 1) {
+    return AppendColumns(block, 0, num_columns);
+  }
+
+  // Split the columns into ranges of about the same number of columns. The
+  // calling thread encodes the first range.
+  const auto range_begin = [&](size_t r) { return r * num_columns / num_ranges; };
+  vector<Status> statuses(num_ranges);
+  CountDownLatch latch(num_ranges - 1);
+  ThreadPool* pool = EncodePool();
+  for (size_t r = 1; r < num_ranges; r++) {
+    auto encode_range = [&, r]() {
+      statuses[r] = AppendColumns(block, range_begin(r), range_begin(r + 1));
+      latch.CountDown();
+    };
+    if (PREDICT_FALSE(!pool->Submit(encode_range).ok())) {
+      encode_range();
+    }
+  }
+  statuses[0] = AppendColumns(block, 0, range_begin(1));
+  latch.Wait();
+  for (const auto& s : statuses) {
+    RETURN_NOT_OK(s);
+  }
+  return Status::OK();
+}
+
+Status MultiColumnWriter::AppendColumns(const RowBlock& block, size_t begin, size_t end) {
+  for (auto i = begin; i < end; ++i) {
+    const MonoTime start = MonoTime::Now();
     ColumnBlock column = block.column_block(i);
     if (column.is_nullable()) {
       RETURN_NOT_OK(cfile_writers_[i]->AppendNullableEntries(column.non_null_bitmap(),
@@ -113,6 +236,7 @@ Status MultiColumnWriter::AppendBlock(const RowBlock& block) {
     } else {
       RETURN_NOT_OK(cfile_writers_[i]->AppendEntries(column.data(), column.nrows()));
     }
+    encode_times_[i] += MonoTime::Now() - start;
   }
   return Status::OK();
 }
@@ -122,7 +246,11 @@ Status MultiColumnWriter::FinishAndReleaseBlocks(
   DCHECK(open_);
   DCHECK(!finished_);
   for (auto i = 0; i < schema_->num_columns(); ++i) {
-    auto s = cfile_writers_[i]->FinishAndReleaseBlock(transaction);
+    BlockCreationTransaction* column_transaction = group_idx_[i] >= 0 ?
+        group_writers_[group_idx_[i]]->column_transaction() : transaction;
+    const MonoTime start = MonoTime::Now();
+    auto s = cfile_writers_[i]->FinishAndReleaseBlock(column_transaction);
+    encode_times_[i] += MonoTime::Now() - start;
     if (PREDICT_FALSE(!s.ok())) {
       LOG(ERROR) << Substitute(
           "tablet $0: unable to finialize writer for column $1",
@@ -130,6 +258,9 @@ Status MultiColumnWriter::FinishAndReleaseBlocks(
       return s;
     }
   }
+  for (const auto& group : group_writers_) {
+    RETURN_NOT_OK(group->FinishAndReleaseBlock(transaction));
+  }
   finished_ = true;
   return Status::OK();
 }
@@ -143,6 +274,33 @@ void MultiColumnWriter::GetFlushedBlocksByColumnId(map<ColumnId, BlockId>* ret)
   }
 }
 
+void MultiColumnWriter::GetFlushedColumnGroupBlocks(BlockIdSet* ret) const {
+  DCHECK(finished_);
+  ret->clear();
+  for (auto i = 0; i < schema_->num_columns(); ++i) {
+    if (group_idx_[i] >= 0) {
+      ret->insert(block_ids_[i]);
+    }
+  }
+}
+
+void MultiColumnWriter::GetValueStatsByColumnId(map<ColumnId, ColumnStatsPB>* ret) const {
+  DCHECK(finished_);
+  DCHECK(collect_value_stats_);
+  ret->clear();
+  for (auto i = 0; i < schema_->num_columns(); ++i) {
+    const cfile::CFileValueStats stats = cfile_writers_[i]->GetValueStats();
+    ColumnStatsPB* pb = &(*ret)[schema_->column_id(i)];
+    pb->set_column_id(schema_->column_id(i));
+    if (stats.min_value) {
+      pb->set_min_value(*stats.min_value);
+      pb->set_max_value(*stats.max_value);
+    }
+    pb->set_null_count(stats.null_count);
+    pb->set_distinct_count_estimate(stats.distinct_count_estimate);
+  }
+}
+
 size_t MultiColumnWriter::written_size() const {
   DCHECK(open_);
   size_t size = 0;
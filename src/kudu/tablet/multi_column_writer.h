@@ -18,6 +18,7 @@
 #include <cstddef>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -25,7 +26,9 @@
 
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/fs/block_id.h"
+#include "kudu/fs/block_manager.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -35,21 +38,37 @@ class RowBlock;
 class Schema;
 struct ColumnId;
 
-namespace fs {
-class BlockCreationTransaction;
-} // namespace fs
-
 namespace tablet {
 
+class ColumnGroupWriter;
+class ColumnStatsPB;
+
 // Wrapper which writes several columns in parallel corresponding to some
 // Schema. Written blocks will fall in the tablet_id's data dir group.
+//
+// If 'column_group_size' is greater than 1, the non-key columns are written
+// in column groups of up to that many consecutive columns: see
+// column_group.h.
+//
+// The columns named in 'bloom_filter_columns' are written with a bloom filter
+// of their values. If 'collect_value_stats' is true, the statistics of the
+// values of all the columns are collected as they're written. The blocks are
+// placed on the 'tier' storage tier.
+//
+// The CFile writers of the columns are independent, so with
+// --flush_encode_threads set, the columns of each appended block are encoded
+// concurrently, split into ranges of columns across a shared pool.
 class MultiColumnWriter final {
  public:
   MultiColumnWriter(FsManager* fs,
                     const Schema* schema,
-                    std::string tablet_id);
+                    std::string tablet_id,
+                    int column_group_size = 0,
+                    std::set<std::string> bloom_filter_columns = {},
+                    bool collect_value_stats = false,
+                    fs::StorageTier tier = fs::StorageTier::HOT);
 
-  ~MultiColumnWriter() = default;
+  ~MultiColumnWriter();
 
   // Open and start writing the columns.
   Status Open();
@@ -57,6 +76,9 @@ class MultiColumnWriter final {
   // Append the given block to the output columns.
   //
   // Note that the selection vector here is ignored.
+  //
+  // Each column is appended to by a single thread, so this doesn't change the
+  // CFiles written, only how long it takes to write them.
   Status AppendBlock(const RowBlock& block);
 
   // Close the in-progress CFiles, finalizing the underlying writable
@@ -66,6 +88,13 @@ class MultiColumnWriter final {
   // Return the number of bytes written so far.
   size_t written_size() const;
 
+  // Return the time spent encoding, compressing and writing out the column
+  // at index 'i' so far, i.e. appending to and finishing its CFile.
+  MonoDelta encode_time_for_col_idx(size_t i) const {
+    CHECK_LT(i, encode_times_.size());
+    return encode_times_[i];
+  }
+
   cfile::CFileWriter* writer_for_col_idx(size_t i) {
     CHECK_LT(i, cfile_writers_.size());
     return cfile_writers_[i].get();
@@ -76,13 +105,41 @@ class MultiColumnWriter final {
   // REQUIRES: Finish() already called.
   void GetFlushedBlocksByColumnId(std::map<ColumnId, BlockId>* ret) const;
 
+  // Return the block IDs of the written column groups.
+  //
+  // REQUIRES: Finish() already called.
+  void GetFlushedColumnGroupBlocks(BlockIdSet* ret) const;
+
+  // Return the statistics of the values of the written columns, keyed by
+  // column ID.
+  //
+  // REQUIRES: Finish() already called, and the writer collects statistics.
+  void GetValueStatsByColumnId(std::map<ColumnId, ColumnStatsPB>* ret) const;
+
  private:
+  // Appends the columns of 'block' with indexes in [begin, end).
+  Status AppendColumns(const RowBlock& block, size_t begin, size_t end);
+
   FsManager* const fs_;
   const Schema* const schema_;
   const std::string tablet_id_;
+  const int column_group_size_;
+  const std::set<std::string> bloom_filter_columns_;
+  const bool collect_value_stats_;
+  const fs::StorageTier tier_;
 
   std::vector<std::unique_ptr<cfile::CFileWriter>> cfile_writers_;
   std::vector<BlockId> block_ids_;
+
+  // The time spent on each column so far: see encode_time_for_col_idx().
+  // Each entry is only updated by the thread appending to its column.
+  std::vector<MonoDelta> encode_times_;
+
+  std::vector<std::unique_ptr<ColumnGroupWriter>> group_writers_;
+
+  // The index in 'group_writers_' of the group of each column, or -1 if the
+  // column isn't part of a group.
+  std::vector<int> group_idx_;
   bool open_;
   bool finished_;
 
@@ -17,9 +17,11 @@
 
 #include "kudu/tablet/mvcc.h"
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <ostream>
+#include <random>
 #include <string>
 #include <thread>
 #include <vector>
@@ -31,12 +33,14 @@
 #include "kudu/clock/logical_clock.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/txn_metadata.h"
 #include "kudu/util/barrier.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
@@ -784,6 +788,56 @@ TEST_F(MvccTest, TestCorrectInitWithNoOps) {
   EXPECT_EQ(snap2.applied_timestamps_.size(), 0);
 }
 
+// Test that snapshots with many applied ops above the clean time, applied out
+// of order while an earlier op is still in flight, answer IsApplied()
+// correctly, and measure how long it takes.
+TEST_F(MvccTest, TestIsAppliedWithManyAppliedOps) {
+  const int kNumOps = AllowSlowTests() ? 10000 : 1000;
+  const int kNumLookupRounds = AllowSlowTests() ? 1000 : 100;
+  MvccManager mgr;
+
+  // Keep the earliest op in flight so the clean time can't move past it.
+  Timestamp first_ts = clock_.Now();
+  ScopedOp first_op(&mgr, first_ts);
+
+  vector<unique_ptr<ScopedOp>> ops;
+  vector<Timestamp> timestamps;
+  for (int i = 0; i < kNumOps; i++) {
+    timestamps.emplace_back(clock_.Now());
+    ops.emplace_back(new ScopedOp(&mgr, timestamps.back()));
+  }
+  mgr.AdjustNewOpLowerBound(clock_.Now());
+
+  // Apply every other op, in random order.
+  vector<int> to_apply;
+  for (int i = 0; i < kNumOps; i += 2) {
+    to_apply.push_back(i);
+  }
+  std::mt19937 gen(SeedRandom());
+  std::shuffle(to_apply.begin(), to_apply.end(), gen);
+  for (int i : to_apply) {
+    ops[i]->StartApplying();
+    ops[i]->FinishApplying();
+  }
+
+  MvccSnapshot snap(mgr);
+  ASSERT_FALSE(snap.is_clean());
+  ASSERT_FALSE(snap.IsApplied(first_ts));
+  for (int i = 0; i < kNumOps; i++) {
+    ASSERT_EQ(i % 2 == 0, snap.IsApplied(timestamps[i])) << timestamps[i].ToString();
+  }
+
+  int num_applied = 0;
+  LOG_TIMING(INFO, strings::Substitute("$0 IsApplied() calls", kNumOps * kNumLookupRounds)) {
+    for (int r = 0; r < kNumLookupRounds; r++) {
+      for (const auto& ts : timestamps) {
+        num_applied += snap.IsApplied(ts) ? 1 : 0;
+      }
+    }
+  }
+  ASSERT_EQ(kNumOps / 2 * kNumLookupRounds, num_applied);
+}
+
 class TransactionMvccTest : public MvccTest {
  public:
   // Simulates successfully committing the given transaction by starting an MVCC
@@ -212,16 +212,10 @@ void MvccManager::AdjustNewOpLowerBound(Timestamp timestamp) {
   AdjustCleanTimeUnlocked();
 }
 
-// Remove any elements from 'v' which are < the given watermark.
+// Remove any elements from the sorted 'v' which are < the given watermark.
 static void FilterTimestamps(std::vector<Timestamp::val_type>* v,
                              Timestamp::val_type watermark) {
-  int j = 0;
-  for (const auto& ts : *v) {
-    if (ts >= watermark) {
-      (*v)[j++] = ts;
-    }
-  }
-  v->resize(j);
+  v->erase(v->begin(), std::lower_bound(v->begin(), v->end(), watermark));
 }
 
 void MvccManager::Close() {
@@ -346,6 +340,11 @@ Status MvccManager::CheckOpen() const {
   return Status::Aborted("MVCC is closed");
 }
 
+bool MvccManager::AreAllOpsApplied(Timestamp timestamp) const {
+  std::lock_guard<LockType> l(lock_);
+  return AreAllOpsAppliedUnlocked(timestamp);
+}
+
 bool MvccManager::AreAllOpsAppliedUnlocked(Timestamp ts) const {
   // If ts is before the 'all_applied_before_' watermark on the current snapshot then
   // all ops before it are applied.
@@ -455,11 +454,8 @@ MvccSnapshot MvccSnapshot::CreateSnapshotIncludingNoOps() {
 }
 
 bool MvccSnapshot::IsAppliedFallback(const Timestamp& timestamp) const {
-  for (const Timestamp::val_type& v : applied_timestamps_) {
-    if (v == timestamp.value()) return true;
-  }
-
-  return false;
+  return std::binary_search(applied_timestamps_.begin(), applied_timestamps_.end(),
+                            timestamp.value());
 }
 
 bool MvccSnapshot::MayHaveAppliedOpsAtOrAfter(const Timestamp& timestamp) const {
@@ -491,7 +487,11 @@ void MvccSnapshot::AddAppliedTimestamp(Timestamp timestamp) {
   DCHECK_EQ(kLatest, type_);
   if (IsApplied(timestamp)) return;
 
-  applied_timestamps_.push_back(timestamp.value());
+  // Ops mostly apply in timestamp order, in which case this is an append.
+  applied_timestamps_.insert(std::upper_bound(applied_timestamps_.begin(),
+                                              applied_timestamps_.end(),
+                                              timestamp.value()),
+                             timestamp.value());
 
   // If this is a new upper bound apply mark, update it.
   if (none_applied_at_or_after_ <= timestamp) {
@@ -212,17 +212,21 @@ class MvccSnapshot {
 
   // An op timestamp at or beyond which no ops have been applied.
   // For any timestamp X, if X >= none_applied_at_or_after_, then X is
-  // nonapplied. This is equivalent to max(applied_timestamps_) + 1, but since
-  // that vector is unsorted, we cache it.
+  // nonapplied. This is equivalent to max(applied_timestamps_) + 1, but we
+  // cache it so the inlined fast path of IsApplied() doesn't need to look at
+  // the vector.
   Timestamp none_applied_at_or_after_;
 
   // The set of ops higher than all_applied_before_timestamp_ which are applied
-  // in this snapshot.
+  // in this snapshot, sorted in ascending order.
   // It might seem like using an unordered_set<> or a set<> would be faster here,
   // but in practice, this list tends to be stay pretty small, and is only
   // rarely consulted (most data will be culled by 'all_applied_before_'
   // or none_applied_at_or_after_. So, using the compact vector structure fits
   // the whole thing on one or two cache lines, and it ends up going faster.
+  // Keeping it sorted bounds the cost of the lookups when many ops are in
+  // flight, and ops mostly apply in timestamp order, so insertions are
+  // usually appends.
   std::vector<Timestamp::val_type> applied_timestamps_;
 };
 
@@ -281,6 +285,10 @@ class MvccManager {
                                        MvccSnapshot* snapshot,
                                        const MonoTime& deadline) const WARN_UNUSED_RESULT;
 
+  // Returns true if all the ops with a timestamp lower than 'timestamp' have
+  // been applied. Unlike WaitForSnapshotWithAllApplied(), doesn't wait.
+  bool AreAllOpsApplied(Timestamp timestamp) const;
+
   // Wait for all operations that are currently APPLYING to finish applying.
   //
   // NOTE: this does _not_ guarantee that no ops are APPLYING upon return --
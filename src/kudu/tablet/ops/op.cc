@@ -19,6 +19,8 @@
 
 #include "kudu/common/schema.h"
 #include "kudu/rpc/result_tracker.h"
+#include "kudu/tablet/tablet_replica.h"
+#include "kudu/util/memory/memory.h"
 
 using kudu::tserver::TabletServerErrorPB;
 
@@ -37,7 +39,8 @@ OpState::OpState(TabletReplica* tablet_replica)
       completion_clbk_(new OpCompletionCallback),
       timestamp_(Timestamp()),
       timestamp_error_(0),
-      arena_(1024),
+      arena_(tablet_replica ? tablet_replica->op_buffer_allocator() : HeapBufferAllocator::Get(),
+             1024),
       external_consistency_mode_(CLIENT_PROPAGATED) {
 }
 
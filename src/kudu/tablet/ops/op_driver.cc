@@ -24,6 +24,7 @@
 #include <type_traits>
 #include <utility>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/message.h>
@@ -31,28 +32,45 @@
 #include "kudu/clock/clock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/timestamp.h"
+#include "kudu/consensus/consensus.pb.h"
 #include "kudu/consensus/log.h"
 #include "kudu/consensus/raft_consensus.h"
 #include "kudu/consensus/time_manager.h"
+#include "kudu/gutil/casts.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/strcat.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/walltime.h"
 #include "kudu/rpc/result_tracker.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/op_order_verifier.h"
 #include "kudu/tablet/ops/op_tracker.h"
+#include "kudu/tablet/ops/write_op.h"
 #include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet.pb.h"
 #include "kudu/tablet/tablet_metrics.h"
 #include "kudu/tablet/tablet_replica.h"
+#include "kudu/util/cpu_profiler.h"
 #include "kudu/util/debug/trace_event.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/status_callback.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 
+DEFINE_bool(log_elide_write_commits, false,
+            "Whether to elide the COMMIT entries of the WAL for non-transactional writes all "
+            "the row operations of which were applied to the same memory store. The commits "
+            "of runs of such writes are coalesced into a single COMMIT entry instead, see "
+            "--log_max_elided_commits. Writes whose runs weren't appended yet when a tablet "
+            "server crashes are replayed through consensus when the tablet is bootstrapped.");
+TAG_FLAG(log_elide_write_commits, experimental);
+TAG_FLAG(log_elide_write_commits, runtime);
+
 using kudu::consensus::CommitMsg;
 using kudu::consensus::DriverType;
 using kudu::consensus::RaftConsensus;
@@ -70,6 +88,41 @@ namespace tablet {
 
 static const char* kTimestampFieldName = "timestamp";
 
+namespace {
+
+// Returns whether the commit of 'op' doesn't need a COMMIT entry of its own,
+// see Log::AppendElidedCommit(). If so, sets 'store' to the store which all
+// the row operations of the write were applied to.
+bool CanElideCommit(const Op& op, const CommitMsg& commit, const MemStoreTargetPB** store) {
+  if (!FLAGS_log_elide_write_commits || op.op_type() != Op::WRITE_OP ||
+      down_cast<const WriteOpState*>(op.state())->txn_id()) {
+    return false;
+  }
+  const auto& ops = commit.result().ops();
+  if (ops.empty()) {
+    return false;
+  }
+  *store = nullptr;
+  for (const auto& op_result : ops) {
+    if (op_result.has_failed_status() || op_result.skip_on_replay() ||
+        op_result.mutated_stores_size() != 1) {
+      return false;
+    }
+    const auto& target = op_result.mutated_stores(0);
+    if (*store == nullptr) {
+      *store = &target;
+    } else if (target.mrs_id() != (*store)->mrs_id() ||
+               target.rs_id() != (*store)->rs_id() ||
+               target.dms_id() != (*store)->dms_id() ||
+               target.rs_txn_id() != (*store)->rs_txn_id()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // anonymous namespace
+
 class FollowerOpCompletionCallback : public OpCompletionCallback {
  public:
   FollowerOpCompletionCallback(const RequestIdPB& request_id,
@@ -227,7 +280,10 @@ void OpDriver::ExecuteAsync() {
   }
 
   if (s.ok()) {
-    s = prepare_pool_token_->Submit([this]() { this->PrepareTask(); });
+    const MicrosecondsInt64 submit_micros = GetCurrentTimeMicros();
+    s = prepare_pool_token_->Submit([this, submit_micros]() {
+      this->PrepareTask(submit_micros);
+    });
   }
 
   if (PREDICT_FALSE(!s.ok())) {
@@ -235,8 +291,9 @@ void OpDriver::ExecuteAsync() {
   }
 }
 
-void OpDriver::PrepareTask() {
+void OpDriver::PrepareTask(MicrosecondsInt64 submit_micros) {
   TRACE_EVENT_FLOW_END0("op", "PrepareTask", this);
+  trace()->AddSpan("prepare_queue", submit_micros, GetCurrentTimeMicros());
   if (PREDICT_FALSE(deadline_ <= MonoTime::Now())) {
     static const Status kTimedOut = Status::TimedOut(
         "operation timed out while waiting in prepare queue");
@@ -282,6 +339,7 @@ void OpDriver::RegisterFollowerOpOnResultTracker() {
 
 Status OpDriver::Prepare() {
   TRACE_EVENT1("op", "Prepare", "op", this);
+  TRACE_SPAN("prepare");
   VLOG_WITH_PREFIX(4) << "Prepare()";
 
   // Actually prepare and start the op.
@@ -445,6 +503,11 @@ void OpDriver::ReplicationFinished(const Status& status) {
   }
   TRACE_COUNTER_INCREMENT("replication_time_us", replication_duration.ToMicroseconds());
   TRACE("REPLICATION: finished");
+  {
+    const MicrosecondsInt64 now_micros = GetCurrentTimeMicros();
+    trace()->AddSpan("replicate", now_micros - replication_duration.ToMicroseconds(),
+                     now_micros);
+  }
 
   // If we have prepared and replicated, we're ready
   // to move ahead and apply this operation.
@@ -501,12 +564,16 @@ Status OpDriver::ApplyAsync() {
   }
 
   TRACE_EVENT_FLOW_BEGIN0("op", "ApplyTask", this);
-  return apply_pool_->Submit([this]() { this->ApplyTask(); });
+  const MicrosecondsInt64 submit_micros = GetCurrentTimeMicros();
+  return apply_pool_->Submit([this, submit_micros]() { this->ApplyTask(submit_micros); });
 }
 
-void OpDriver::ApplyTask() {
+void OpDriver::ApplyTask(MicrosecondsInt64 submit_micros) {
   TRACE_EVENT_FLOW_END0("op", "ApplyTask", this);
   ADOPT_TRACE(trace());
+  trace()->AddSpan("apply_queue", submit_micros, GetCurrentTimeMicros());
+  TRACE_SPAN("apply");
+  SCOPED_CPU_PROFILE_TAG(state()->tablet_replica()->tablet_id());
   Tablet* tablet = state()->tablet_replica()->tablet();
   if (tablet->HasBeenStopped()) {
     HandleFailure(Status::IllegalState("Not Applying op; the tablet is stopped"));
@@ -527,7 +594,20 @@ void OpDriver::ApplyTask() {
 
   {
     CommitMsg* commit_msg;
+    TabletMetrics* metrics = tablet->metrics();
+    if (metrics) {
+      metrics->tablet_applying_ops->Increment();
+      metrics->op_apply_concurrency->Increment(metrics->tablet_applying_ops->value());
+    }
+    Stopwatch sw(Stopwatch::THIS_THREAD);
+    sw.start();
     Status s = op_->Apply(&commit_msg);
+    sw.stop();
+    if (metrics) {
+      metrics->tablet_applying_ops->Decrement();
+      metrics->apply_cpu_user_time->IncrementBy(sw.elapsed().user / 1000);
+      metrics->apply_cpu_system_time->IncrementBy(sw.elapsed().system / 1000);
+    }
     if (PREDICT_FALSE(!s.ok())) {
       LOG(WARNING) << Substitute("Did not Apply op $0: $1",
           op_->ToString(), s.ToString());
@@ -537,7 +617,10 @@ void OpDriver::ApplyTask() {
     commit_msg->mutable_commited_op_id()->CopyFrom(op_id_copy_);
     SetResponseTimestamp(op_->state(), op_->state()->timestamp());
 
-    {
+    const MemStoreTargetPB* elided_store;
+    if (CanElideCommit(*op_, *commit_msg, &elided_store)) {
+      log_->AppendElidedCommit(op_id_copy_, *elided_store, commit_msg->result().ops_size());
+    } else {
       TRACE_EVENT1("op", "AsyncAppendCommit", "op", this);
       CHECK_OK(log_->AsyncAppendCommit(
           *commit_msg, [](const Status& s) {
@@ -573,6 +656,7 @@ void OpDriver::SetResponseTimestamp(OpState* op_state,
 }
 
 Status OpDriver::CommitWait() {
+  TRACE_SPAN("commit_wait");
   MonoTime before = MonoTime::Now();
   DCHECK(mutable_state()->external_consistency_mode() == COMMIT_WAIT);
   RETURN_NOT_OK(mutable_state()->tablet_replica()->clock()->WaitUntilAfter(
@@ -87,6 +87,14 @@ class OpTracker;
 //  5 - ApplyAsync() submits ApplyTask() to the apply_pool_.
 //      ApplyTask() calls op_->Apply().
 //
+//      ApplyAsync() is called in OpId order, but the apply tasks of a tablet's ops
+//      aren't serialized: they may run concurrently on several apply threads. This is
+//      safe because the row locks taken in Prepare() are held until Finalize(), so
+//      concurrently applying ops never touch the same rows, and MVCC tracks each op
+//      separately, so ops may finish applying out of order. The tablet's
+//      'tablet_applying_ops' and 'op_apply_concurrency' metrics show how many ops are
+//      applied at once.
+//
 //      When Apply() is called, changes are made to the in-memory data structures. These
 //      changes are not visible to clients yet. After Apply() completes, a CommitMsg
 //      is enqueued to the WAL in order to store information about the operation result
@@ -304,8 +312,9 @@ class OpDriver : public RefCountedThreadSafe<OpDriver> {
   ~OpDriver() {}
 
   // The task submitted to the prepare threadpool to prepare the op. If Prepare() fails,
-  // calls HandleFailure.
-  void PrepareTask();
+  // calls HandleFailure. 'submit_micros' is the wall time at which the task was
+  // submitted, to trace the time spent in the queue.
+  void PrepareTask(MicrosecondsInt64 submit_micros);
 
   // Actually prepare.
   Status Prepare();
@@ -314,8 +323,8 @@ class OpDriver : public RefCountedThreadSafe<OpDriver> {
   Status ApplyAsync();
 
   // Calls Op::Apply() followed by RaftConsensus::Commit() with the
-  // results from the Apply().
-  void ApplyTask();
+  // results from the Apply(). 'submit_micros' is as for PrepareTask().
+  void ApplyTask(MicrosecondsInt64 submit_micros);
 
   // Sleeps until the op is allowed to commit based on the
   // requested consistency mode.
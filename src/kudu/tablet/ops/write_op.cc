@@ -165,6 +165,17 @@ void WriteOp::NewReplicateMsg(unique_ptr<ReplicateMsg>* replicate_msg) {
   (*replicate_msg)->set_op_type(consensus::OperationType::WRITE_OP);
   auto* write_req = (*replicate_msg)->mutable_write_request();
   write_req->CopyFrom(*state()->request());
+  // The WAL and the followers need the row data along with the request, so
+  // inline it if it came in sidecars. This is the one copy it takes.
+  auto* row_ops = write_req->mutable_row_operations();
+  if (row_ops->has_rows_sidecar() || row_ops->has_indirect_data_sidecar()) {
+    const Slice rows = state()->rows();
+    const Slice indirect_data = state()->indirect_data();
+    row_ops->clear_rows_sidecar();
+    row_ops->clear_indirect_data_sidecar();
+    row_ops->set_rows(rows.data(), rows.size());
+    row_ops->set_indirect_data(indirect_data.data(), indirect_data.size());
+  }
   if (state()->are_results_tracked()) {
     (*replicate_msg)->mutable_request_id()->CopyFrom(state()->request_id());
   }
@@ -318,6 +329,11 @@ Status WriteOp::Apply(CommitMsg** commit_msg) {
   state()->ReleaseTxResultPB((*commit_msg)->mutable_result());
   (*commit_msg)->set_op_type(consensus::OperationType::WRITE_OP);
 
+  // The memory the op allocated for its decoded rows and messages. How much of
+  // the arena came from the replica's buffer pool is counted by the allocator.
+  TRACE_COUNTER_INCREMENT("op_arena_bytes", state_->arena()->memory_footprint());
+  TRACE_COUNTER_INCREMENT("op_pb_arena_bytes", state_->pb_arena()->SpaceAllocated());
+
   return Status::OK();
 }
 
@@ -429,6 +445,7 @@ void WriteOpState::set_txn_rowsets(const scoped_refptr<TxnRowSets>& rowsets) {
 }
 
 void WriteOpState::AcquireSchemaLock(rw_semaphore* schema_lock) {
+  TRACE_SPAN("acquire_schema_lock");
   TRACE("Acquiring schema lock in shared mode");
   shared_lock<rw_semaphore> temp(*schema_lock);
   schema_lock_.swap(temp);
@@ -618,6 +635,7 @@ Status WriteOpState::AcquirePartitionLock(
     txn_id = request()->txn_id();
   }
   TRACE("Acquiring the partition lock for write op");
+  TRACE_SPAN("acquire_partition_lock");
   partition_lock_ = ScopedPartitionLock(lock_manager, txn_id, wait_mode);
   bool acquired = partition_lock_.IsAcquired(&code);
   if (!acquired) {
@@ -678,6 +696,7 @@ void WriteOpState::ResetRpcFields() {
   std::lock_guard<simple_spinlock> l(op_state_lock_);
   request_ = nullptr;
   response_ = nullptr;
+  row_data_.reset();
   // these are allocated from the arena, so just run the dtors.
   for (RowOp* op : row_ops_) {
     op->~RowOp();
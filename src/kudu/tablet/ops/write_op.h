@@ -41,6 +41,7 @@
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/bitset.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -148,6 +149,23 @@ class WriteOpState : public OpState {
                                   : std::nullopt;
   }
 
+  // Makes the row operations of the request be decoded from 'rows' and
+  // 'indirect_data' rather than from the request itself, e.g. when the client
+  // sent them as RPC sidecars. Like the request, they must stay valid until
+  // the RPC fields of this op are reset.
+  void set_row_data(Slice rows, Slice indirect_data) {
+    row_data_ = RowData{ rows, indirect_data };
+  }
+
+  // The encoded rows and indirect data to decode the row operations from.
+  Slice rows() const {
+    return row_data_ ? row_data_->rows : Slice(request_->row_operations().rows());
+  }
+  Slice indirect_data() const {
+    return row_data_ ? row_data_->indirect_data
+                     : Slice(request_->row_operations().indirect_data());
+  }
+
   // Returns the state associated with authorizing this op, or 'nullopt' if no
   // authorization is necessary.
   const std::optional<WriteAuthorizationContext>& authz_context() const {
@@ -288,6 +306,13 @@ class WriteOpState : public OpState {
   const tserver::WriteRequestPB* request_;
   tserver::WriteResponsePB* response_;
 
+  // The row data of the request, if set with set_row_data().
+  struct RowData {
+    Slice rows;
+    Slice indirect_data;
+  };
+  std::optional<RowData> row_data_;
+
   // Encapsulates state required to authorize a write request. If 'nullopt',
   // then no authorization is required.
   std::optional<WriteAuthorizationContext> authz_context_;
@@ -0,0 +1,173 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/row_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/rowblock_memory.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+using std::string;
+using std::vector;
+
+namespace kudu {
+namespace tablet {
+
+class RowCacheTest : public KuduTest {
+ public:
+  RowCacheTest()
+      : schema_({ ColumnSchema("key", INT32),
+                  ColumnSchema("val", STRING, /*is_nullable=*/true) },
+                { ColumnId(0), ColumnId(1) },
+                1),
+        row_cache_(1024 * 1024),
+        cache_(&row_cache_, "tablet") {
+  }
+
+ protected:
+  // Sets the first row of 'block' to ('key', 'val'), with a null value if
+  // 'val' is empty.
+  static void SetRow(RowBlock* block, int32_t key, const string& val) {
+    RowBlockRow row = block->row(0);
+    *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(0)) = key;
+    RowBlockRow::Cell cell = row.cell(1);
+    cell.set_null(val.empty());
+    *reinterpret_cast<Slice*>(cell.mutable_ptr()) = Slice(val);
+  }
+
+  // Looks up 'key' into the first row of 'block', returning "<key>:<val>" or
+  // "miss".
+  string LookupRow(const TabletRowCache::Projection& projection, const Slice& key,
+                   RowBlock* block) {
+    RowBlockRow row = block->row(0);
+    if (!cache_.Lookup(projection, key, &row, &arena_)) {
+      return "miss";
+    }
+    const int32_t k = *reinterpret_cast<const int32_t*>(row.cell_ptr(0));
+    if (row.is_null(1)) {
+      return strings::Substitute("$0:NULL", k);
+    }
+    return strings::Substitute(
+        "$0:$1", k, reinterpret_cast<const Slice*>(row.cell_ptr(1))->ToString());
+  }
+
+  const Schema schema_;
+  RowCache row_cache_;
+  TabletRowCache cache_;
+  Arena arena_{1024};
+};
+
+TEST_F(RowCacheTest, TestInsertAndInvalidate) {
+  TabletRowCache::Projection projection;
+  ASSERT_TRUE(cache_.RegisterProjection(schema_, &projection));
+  RowBlockMemory mem;
+  RowBlock block(&schema_, 1, &mem);
+
+  ASSERT_EQ("miss", LookupRow(projection, "k1", &block));
+  uint64_t token = cache_.GetFillToken("k1");
+  SetRow(&block, 1, "foo");
+  cache_.Insert(projection, "k1", token, block.row(0));
+  token = cache_.GetFillToken("k2");
+  SetRow(&block, 2, "");
+  cache_.Insert(projection, "k2", token, block.row(0));
+  ASSERT_EQ("1:foo", LookupRow(projection, "k1", &block));
+  ASSERT_EQ("2:NULL", LookupRow(projection, "k2", &block));
+
+  // A write invalidates the row of its key only.
+  cache_.Invalidate("k1");
+  ASSERT_EQ("miss", LookupRow(projection, "k1", &block));
+  ASSERT_EQ("2:NULL", LookupRow(projection, "k2", &block));
+
+  // The rows read before an invalidation aren't cached.
+  token = cache_.GetFillToken("k1");
+  cache_.Invalidate("k1");
+  SetRow(&block, 1, "stale");
+  cache_.Insert(projection, "k1", token, block.row(0));
+  ASSERT_EQ("miss", LookupRow(projection, "k1", &block));
+
+  // Invalidating the whole tablet drops its projections along with its rows.
+  cache_.InvalidateAll();
+  ASSERT_EQ("miss", LookupRow(projection, "k2", &block));
+  TabletRowCache::Projection new_projection;
+  ASSERT_TRUE(cache_.RegisterProjection(schema_, &new_projection));
+  ASSERT_NE(projection.generation, new_projection.generation);
+  token = cache_.GetFillToken("k2");
+  SetRow(&block, 2, "bar");
+  cache_.Insert(projection, "k2", token, block.row(0));
+  ASSERT_EQ("miss", LookupRow(new_projection, "k2", &block));
+  cache_.Insert(new_projection, "k2", token, block.row(0));
+  ASSERT_EQ("2:bar", LookupRow(new_projection, "k2", &block));
+}
+
+TEST_F(RowCacheTest, TestProjections) {
+  const Schema key_projection({ ColumnSchema("key", INT32) }, { ColumnId(0) }, 1);
+  TabletRowCache::Projection full;
+  TabletRowCache::Projection key_only;
+  ASSERT_TRUE(cache_.RegisterProjection(schema_, &full));
+  ASSERT_TRUE(cache_.RegisterProjection(key_projection, &key_only));
+  ASSERT_NE(full.index, key_only.index);
+  TabletRowCache::Projection full_again;
+  ASSERT_TRUE(cache_.RegisterProjection(schema_, &full_again));
+  ASSERT_EQ(full.index, full_again.index);
+
+  // The rows of each projection are cached separately, and invalidated
+  // together.
+  RowBlockMemory mem;
+  RowBlock block(&schema_, 1, &mem);
+  SetRow(&block, 1, "foo");
+  cache_.Insert(full, "k1", cache_.GetFillToken("k1"), block.row(0));
+  ASSERT_EQ("1:foo", LookupRow(full, "k1", &block));
+  RowBlock key_block(&key_projection, 1, &mem);
+  RowBlockRow key_row = key_block.row(0);
+  ASSERT_FALSE(cache_.Lookup(key_only, "k1", &key_row, &arena_));
+  cache_.Insert(key_only, "k1", cache_.GetFillToken("k1"), key_block.row(0));
+  ASSERT_TRUE(cache_.Lookup(key_only, "k1", &key_row, &arena_));
+  cache_.Invalidate("k1");
+  ASSERT_FALSE(cache_.Lookup(key_only, "k1", &key_row, &arena_));
+  ASSERT_EQ("miss", LookupRow(full, "k1", &block));
+
+  // The number of projections per tablet is bounded.
+  vector<Schema> projections;
+  projections.reserve(32);
+  int num_registered = 2;
+  for (int i = 0; i < 32; i++) {
+    projections.emplace_back(
+        vector<ColumnSchema>({ ColumnSchema(strings::Substitute("c$0", i), INT32) }),
+        vector<ColumnId>({ ColumnId(10 + i) }), 1);
+    TabletRowCache::Projection p;
+    if (cache_.RegisterProjection(projections.back(), &p)) {
+      num_registered++;
+    }
+  }
+  ASSERT_EQ(16, num_registered);
+}
+
+} // namespace tablet
+} // namespace kudu
@@ -0,0 +1,265 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/row_cache.h"
+
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/cache.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/hash_util.h"
+#include "kudu/util/memory/arena.h"
+
+DEFINE_int64(tablet_row_cache_capacity_mb, 0,
+             "Capacity in MiB of the cache of the rows served by the point lookups "
+             "of the tablets (see the LookupRows RPC). The hot rows are served from "
+             "the cache without reading their rowsets, until they're written. The "
+             "cache is shared by all the tablets of the server. If 0, the rows "
+             "aren't cached.");
+TAG_FLAG(tablet_row_cache_capacity_mb, experimental);
+
+namespace {
+
+bool ValidateRowCacheCapacity(const char* flagname, int64_t value) {
+  if (value >= 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must not be negative: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(tablet_row_cache_capacity_mb, &ValidateRowCacheCapacity);
+
+using std::string;
+
+namespace kudu {
+namespace tablet {
+
+RowCache::RowCache(size_t capacity_bytes)
+    : cache_(NewCache<Cache::EvictionPolicy::LRU>(capacity_bytes, "row_cache")) {
+}
+
+RowCache::~RowCache() {
+}
+
+RowCache* RowCache::GetSingleton() {
+  static std::once_flag once;
+  static RowCache* cache = nullptr;
+  if (FLAGS_tablet_row_cache_capacity_mb <= 0) {
+    return nullptr;
+  }
+  std::call_once(once, []() {
+    cache = new RowCache(FLAGS_tablet_row_cache_capacity_mb * 1024 * 1024);
+  });
+  return cache;
+}
+
+TabletRowCache::TabletRowCache(RowCache* cache, string tablet_id)
+    : cache_(DCHECK_NOTNULL(cache)->cache_.get()),
+      tablet_id_(std::move(tablet_id)),
+      generation_(0) {
+  for (auto& s : stripes_) {
+    s = 0;
+  }
+}
+
+bool TabletRowCache::RegisterProjection(const Schema& projection, Projection* handle) {
+  DCHECK(projection.has_column_ids());
+  faststring fingerprint;
+  for (int i = 0; i < projection.num_columns(); i++) {
+    const ColumnSchema& col = projection.column(i);
+    PutFixed32(&fingerprint, projection.column_id(i));
+    fingerprint.push_back(static_cast<uint8_t>(col.type_info()->type()));
+    fingerprint.push_back(col.is_nullable() ? 1 : 0);
+  }
+  const string fp = fingerprint.ToString();
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  handle->generation = generation_;
+  for (int i = 0; i < projections_.size(); i++) {
+    if (projections_[i] == fp) {
+      handle->index = i;
+      return true;
+    }
+  }
+  if (projections_.size() >= kMaxProjections) {
+    return false;
+  }
+  handle->index = projections_.size();
+  projections_.emplace_back(fp);
+  return true;
+}
+
+string TabletRowCache::BuildKey(uint64_t generation,
+                                int projection_index,
+                                const Slice& key) const {
+  faststring buf;
+  buf.reserve(tablet_id_.size() + 12 + key.size());
+  buf.append(tablet_id_);
+  PutFixed64(&buf, generation);
+  PutFixed32(&buf, projection_index);
+  buf.append(key.data(), key.size());
+  return buf.ToString();
+}
+
+std::atomic<uint64_t>* TabletRowCache::stripe(const Slice& key) {
+  return &stripes_[HashUtil::FastHash64(key.data(), key.size(), 0) % kNumStripes];
+}
+
+const std::atomic<uint64_t>* TabletRowCache::stripe(const Slice& key) const {
+  return &stripes_[HashUtil::FastHash64(key.data(), key.size(), 0) % kNumStripes];
+}
+
+bool TabletRowCache::Lookup(const Projection& projection,
+                            const Slice& key,
+                            RowBlockRow* dst,
+                            Arena* arena) const {
+  if (projection.index < 0 || projection.generation != generation_) {
+    return false;
+  }
+  auto h(cache_->Lookup(BuildKey(projection.generation, projection.index, key),
+                        Cache::EXPECT_IN_CACHE));
+  if (!h) {
+    return false;
+  }
+
+  // The cells are laid out as serialized by Insert().
+  const Slice value = cache_->Value(h);
+  const uint8_t* p = value.data();
+  const uint8_t* const end = p + value.size();
+  for (int c = 0; c < dst->schema()->num_columns(); c++) {
+    RowBlockRow::Cell cell = dst->cell(c);
+    if (cell.is_nullable()) {
+      DCHECK_LT(p, end);
+      const bool is_null = *p++;
+      cell.set_null(is_null);
+      if (is_null) {
+        continue;
+      }
+    }
+    if (cell.typeinfo()->physical_type() == BINARY) {
+      DCHECK_LE(p + sizeof(uint32_t), end);
+      const uint32_t len = DecodeFixed32(p);
+      p += sizeof(uint32_t);
+      DCHECK_LE(p + len, end);
+      Slice* dst_slice = reinterpret_cast<Slice*>(cell.mutable_ptr());
+      if (PREDICT_FALSE(!arena->RelocateSlice(Slice(p, len), dst_slice))) {
+        return false;
+      }
+      p += len;
+    } else {
+      DCHECK_LE(p + cell.size(), end);
+      memcpy(cell.mutable_ptr(), p, cell.size());
+      p += cell.size();
+    }
+  }
+  DCHECK_EQ(p, end);
+  return true;
+}
+
+uint64_t TabletRowCache::GetFillToken(const Slice& key) const {
+  return stripe(key)->load();
+}
+
+void TabletRowCache::Insert(const Projection& projection,
+                            const Slice& key,
+                            uint64_t fill_token,
+                            const RowBlockRow& row) {
+  if (projection.index < 0 || projection.generation != generation_ ||
+      stripe(key)->load() != fill_token) {
+    return;
+  }
+
+  // Serialize the cells: a byte for the null state of the nullable cells,
+  // followed by the value of the non-null cells, prefixed by their length
+  // for the binary ones.
+  faststring value;
+  for (int c = 0; c < row.schema()->num_columns(); c++) {
+    const RowBlockRow::Cell cell = row.cell(c);
+    if (cell.is_nullable()) {
+      value.push_back(cell.is_null() ? 1 : 0);
+      if (cell.is_null()) {
+        continue;
+      }
+    }
+    if (cell.typeinfo()->physical_type() == BINARY) {
+      const Slice* s = reinterpret_cast<const Slice*>(cell.ptr());
+      PutFixed32(&value, s->size());
+      value.append(s->data(), s->size());
+    } else {
+      value.append(cell.ptr(), cell.size());
+    }
+  }
+
+  const string cache_key = BuildKey(projection.generation, projection.index, key);
+  auto pending(cache_->Allocate(cache_key, value.size()));
+  if (!pending) {
+    // The row doesn't fit in the cache.
+    return;
+  }
+  memcpy(cache_->MutableValue(&pending), value.data(), value.size());
+  cache_->Insert(std::move(pending), nullptr);
+
+  // The row may have been invalidated while inserting it, before the
+  // invalidation could erase it.
+  if (PREDICT_FALSE(stripe(key)->load() != fill_token)) {
+    cache_->Erase(cache_key);
+  }
+}
+
+void TabletRowCache::Invalidate(const Slice& key) {
+  stripe(key)->fetch_add(1);
+  uint64_t generation;
+  int num_projections;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    generation = generation_;
+    num_projections = projections_.size();
+  }
+  for (int i = 0; i < num_projections; i++) {
+    cache_->Erase(BuildKey(generation, i, key));
+  }
+}
+
+void TabletRowCache::InvalidateAll() {
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    generation_++;
+    projections_.clear();
+  }
+  for (auto& s : stripes_) {
+    s.fetch_add(1);
+  }
+}
+
+} // namespace tablet
+} // namespace kudu
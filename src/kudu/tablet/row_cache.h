@@ -0,0 +1,152 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/slice.h"
+
+namespace kudu {
+
+class Arena;
+class Cache;
+class RowBlockRow;
+class Schema;
+
+namespace tablet {
+
+// The cache of the rows served by the point lookups of the tablets of a
+// tablet server (see Tablet::LookupRows()). Like the block cache, a single
+// cache is shared by all the tablets, and its memory is tracked by the
+// 'row_cache' MemTracker.
+//
+// The rows of each tablet are accessed through its TabletRowCache.
+class RowCache {
+ public:
+  explicit RowCache(size_t capacity_bytes);
+  ~RowCache();
+
+  // Returns the cache of the server, or nullptr if
+  // --tablet_row_cache_capacity_mb is 0.
+  static RowCache* GetSingleton();
+
+ private:
+  friend class TabletRowCache;
+
+  std::unique_ptr<Cache> cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowCache);
+};
+
+// The rows of a tablet in the row cache.
+//
+// An entry holds the cells of a row in one projection, and is keyed by the
+// tablet, the projection and the encoded primary key of the row. The rows
+// are cached as read at the latest snapshot, and must be invalidated before
+// they change at that snapshot:
+// - the writes to a row invalidate its entries as they're applied, i.e.
+//   before they're committed,
+// - committing a transaction or altering the schema invalidates all the
+//   entries of the tablet.
+//
+// A row read by a lookup which misses in the cache may have been changed by
+// a write applied in the meantime. To keep such stale rows out of the
+// cache, each key hashes to one of the invalidation counters of the tablet
+// which the invalidations bump. The lookups take the counters of their keys
+// before reading the rows, and only insert the rows whose counters didn't
+// change.
+//
+// This class is thread-safe.
+class TabletRowCache {
+ public:
+  // The projection of the entries looked up and inserted, as registered
+  // with RegisterProjection().
+  struct Projection {
+    uint64_t generation = 0;
+    int index = -1;
+  };
+
+  TabletRowCache(RowCache* cache, std::string tablet_id);
+
+  // Registers 'projection', a projection of the tablet schema with the IDs
+  // of its columns, into 'handle'. Returns false if the tablet already has
+  // as many projections cached as allowed, in which case the rows of
+  // 'projection' aren't cached.
+  bool RegisterProjection(const Schema& projection, Projection* handle);
+
+  // If the row of 'key' in 'projection' is cached, copies its cells into
+  // 'dst', whose schema must match 'projection', with their indirect data
+  // allocated from 'arena', and returns true.
+  bool Lookup(const Projection& projection, const Slice& key,
+              RowBlockRow* dst, Arena* arena) const;
+
+  // Returns the fill token of 'key', to take before reading its row from
+  // the tablet and to pass to Insert().
+  uint64_t GetFillToken(const Slice& key) const;
+
+  // Caches 'row' as the row of 'key' in 'projection', unless 'key' was
+  // invalidated since 'fill_token' was taken.
+  void Insert(const Projection& projection, const Slice& key,
+              uint64_t fill_token, const RowBlockRow& row);
+
+  // Invalidates the cached rows of 'key'.
+  void Invalidate(const Slice& key);
+
+  // Invalidates all the cached rows of the tablet, along with its
+  // projections.
+  void InvalidateAll();
+
+ private:
+  // The number of distinct projections whose rows may be cached per tablet.
+  // Each write erases the entries of its key in every projection.
+  static constexpr int kMaxProjections = 16;
+
+  // The number of invalidation counters of a tablet.
+  static constexpr int kNumStripes = 64;
+
+  std::string BuildKey(uint64_t generation, int projection_index, const Slice& key) const;
+
+  std::atomic<uint64_t>* stripe(const Slice& key);
+  const std::atomic<uint64_t>* stripe(const Slice& key) const;
+
+  Cache* const cache_;
+  const std::string tablet_id_;
+
+  // Protects 'projections_'.
+  mutable simple_spinlock lock_;
+
+  // The fingerprints of the projections registered in the current generation.
+  std::vector<std::string> projections_;
+
+  // Bumped by InvalidateAll(): the entries of the earlier generations are
+  // unreachable, and age out of the cache.
+  std::atomic<uint64_t> generation_;
+
+  std::atomic<uint64_t> stripes_[kNumStripes];
+
+  DISALLOW_COPY_AND_ASSIGN(TabletRowCache);
+};
+
+} // namespace tablet
+} // namespace kudu
@@ -47,7 +47,10 @@ RowIteratorOptions::RowIteratorOptions()
     : projection(nullptr),
       snap_to_include(MvccSnapshot::CreateSnapshotIncludingAllOps()),
       order(OrderMode::UNORDERED),
-      include_deleted_rows(false) {}
+      io_context(nullptr),
+      include_deleted_rows(false),
+      parallel_scan_pool(nullptr),
+      checksum_scan(nullptr) {}
 
 Status RowSet::DebugDump(std::vector<std::string>* lines) {
   return DebugDumpImpl(nullptr /* rows_left */, lines);
@@ -73,6 +76,14 @@ Status RowSet::NewRowIteratorWithBounds(const RowIteratorOptions& opts,
   return Status::OK();
 }
 
+Status RowSet::CheckRowsPresent(ArrayView<KeyPresenceProbe> probes,
+                                const IOContext* io_context) const {
+  for (auto& p : probes) {
+    RETURN_NOT_OK(CheckRowPresent(*p.probe, io_context, &p.present, p.stats));
+  }
+  return Status::OK();
+}
+
 DuplicatingRowSet::DuplicatingRowSet(RowSetVector old_rowsets,
                                      RowSetVector new_rowsets)
     : old_rowsets_(std::move(old_rowsets)),
@@ -34,6 +34,7 @@
 #include "kudu/common/timestamp.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/tablet/mvcc.h"
+#include "kudu/util/array_view.h"
 #include "kudu/util/bloom_filter.h"
 #include "kudu/util/status.h"
 // IWYU pragma: no_include "kudu/util/monotime.h"
@@ -46,6 +47,7 @@ class RowChangeList;
 class RowwiseIterator;
 class Schema;
 class Slice;
+class ThreadPool;
 struct ColumnId;
 struct IterWithBounds;
 
@@ -63,6 +65,7 @@ class CompactionOrFlushInput;
 class OperationResultPB;
 class RowSetKeyProbe;
 class RowSetMetadata;
+struct ChecksumScanState;
 struct ProbeStats;
 
 // Encapsulates all options passed to row-based Iterators.
@@ -101,6 +104,31 @@ struct RowIteratorOptions {
   //
   // Defaults to false.
   bool include_deleted_rows;
+
+  // The pool on which an UNORDERED tablet iterator may materialize several of
+  // its rowsets concurrently. See --tablet_parallel_scan_max_rowsets.
+  //
+  // Defaults to nullptr, i.e. the rowsets are scanned one after the other.
+  ThreadPool* parallel_scan_pool;
+
+  // If set, the iteration is that of a checksum scan, at a clean snapshot and
+  // without predicates, which may reuse the checksums of the DiskRowSets
+  // computed by the previous checksum scans of the tablet: see
+  // Tablet::CaptureConsistentIterators().
+  //
+  // Defaults to nullptr.
+  ChecksumScanState* checksum_scan;
+};
+
+// A row key in a batch of presence checks: see RowSet::CheckRowsPresent().
+struct KeyPresenceProbe {
+  const RowSetKeyProbe* probe;
+
+  // The stats of the operation of the row.
+  ProbeStats* stats;
+
+  // Set to whether the row is present.
+  bool present;
 };
 
 class RowSet {
@@ -132,6 +160,14 @@ class RowSet {
   virtual Status CheckRowPresent(const RowSetKeyProbe &probe, const fs::IOContext* io_context,
                                  bool *present, ProbeStats* stats) const = 0;
 
+  // Like CheckRowPresent(), for a batch of row keys sorted in increasing
+  // order. Sets the 'present' field of each of 'probes'.
+  //
+  // Rowsets may share the lookups of their indexes between the keys of the
+  // batch. The default implementation checks the keys one at a time.
+  virtual Status CheckRowsPresent(ArrayView<KeyPresenceProbe> probes,
+                                  const fs::IOContext* io_context) const;
+
   // Update/delete a row in this rowset.
   // The 'update_schema' is the client schema used to encode the 'update' RowChangeList.
   //
@@ -214,6 +250,15 @@ class RowSet {
   // Returns the metadata associated with this rowset.
   virtual std::shared_ptr<RowSetMetadata> metadata() = 0;
 
+  // Records that a scan or a lookup is reading this rowset. The compaction
+  // policy favors the rowsets which are read, see
+  // --compaction_read_hotness_weight.
+  virtual void RecordRead() const {}
+
+  // Returns the recent rate of the reads recorded by RecordRead(), in reads
+  // per second, or 0 if this type of rowset doesn't record reads.
+  virtual double ReadRate() const { return 0; }
+
   // Get the size of the delta's MemStore
   virtual size_t DeltaMemStoreSize() const = 0;
 
@@ -242,6 +287,32 @@ class RowSet {
   virtual Status IsDeletedAndFullyAncient(Timestamp ancient_history_mark,
                                           bool* deleted_and_ancient) = 0;
 
+  // Returns whether all the data of the rowset, its inserts as well as its
+  // updates, is older than 'timestamp'.
+  //
+  // This may return false negatives, but should not return false positives.
+  virtual bool EstimateAllDataOlderThan(Timestamp /*timestamp*/) const { return false; }
+
+  // Returns whether the rows of the rowset are all expired by a row TTL, i.e.
+  // whether their cells of the int64 key column 'row_ttl_col_id' are all below
+  // 'cutoff_micros', going by the column statistics of the rowset.
+  //
+  // This may return false negatives, but should not return false positives.
+  virtual bool EstimateAllRowsExpired(const ColumnId& /*row_ttl_col_id*/,
+                                      int64_t /*cutoff_micros*/) const {
+    return false;
+  }
+
+  // Returns whether the rowset may have inserts or mutations committed in
+  // 'snap_to_include' but not in 'snap_to_exclude', i.e. rows to return to
+  // a diff scan between these snapshots.
+  //
+  // This may return false positives, but should not return false negatives.
+  virtual bool MayHaveChangesBetween(const MvccSnapshot& /*snap_to_exclude*/,
+                                     const MvccSnapshot& /*snap_to_include*/) const {
+    return true;
+  }
+
   // Estimate the number of bytes in ancient undo delta stores. This may be an
   // overestimate or an underestimate depending on 'estimate_type,. The argument
   // 'ancient_history_mark' must be valid: it must not be equal to
@@ -297,6 +368,38 @@ class RowSet {
                                          int64_t* blocks_deleted,
                                          int64_t* bytes_deleted) = 0;
 
+  // Estimate the number of bytes of ancient deltas in the initialized undo
+  // delta blocks which TruncateAncientUndoDeltas() would reclaim, i.e. in the
+  // blocks which also hold deltas not older than 'ancient_history_mark', and
+  // whose estimated ratio of ancient deltas is at least 'min_ancient_ratio'.
+  virtual Status EstimateBytesInTruncatableUndoDeltas(Timestamp ancient_history_mark,
+                                                      double min_ancient_ratio,
+                                                      int64_t* bytes) = 0;
+
+  // Rewrite the undo delta blocks counted by
+  // EstimateBytesInTruncatableUndoDeltas() without their deltas older than
+  // 'ancient_history_mark', oldest block first, until the given 'deadline' is
+  // passed. Such blocks are otherwise only reclaimed once all their deltas are
+  // ancient, or by a rowset compaction.
+  //
+  // Each block rewritten replaces the original one in the rowset metadata
+  // right away, so the progress made before the deadline isn't lost. As with
+  // DeleteAncientUndoDeltas(), the caller is responsible for flushing the
+  // rowset metadata.
+  //
+  // If this method returns OK, it also returns the number of delta blocks
+  // rewritten and the estimated number of bytes reclaimed in the out-params
+  // 'blocks_truncated' and 'bytes_truncated', which may be passed in as
+  // nullptr.
+  //
+  // If 'deadline' is not Initialized() then no deadline is enforced.
+  virtual Status TruncateAncientUndoDeltas(Timestamp ancient_history_mark,
+                                           double min_ancient_ratio,
+                                           MonoTime deadline,
+                                           const fs::IOContext* io_context,
+                                           int64_t* blocks_truncated,
+                                           int64_t* bytes_truncated) = 0;
+
   // Return true if this RowSet is available for compaction, based on
   // the current state of the compact_flush_lock. This should only be
   // used under the Tablet's compaction selection lock, or else the
@@ -345,6 +448,13 @@ class RowSetKeyProbe {
         encoded_key_(EncodedKey::FromContiguousRow(row_key_, arena)),
         bloom_probe_(BloomKeyProbe(encoded_key_slice())) {}
 
+  // Same as above, but encodes the key with 'key_builder', which is cheaper
+  // when probing for a batch of keys.
+  RowSetKeyProbe(ConstContiguousRow row_key, EncodedKeyBuilder* key_builder)
+      : row_key_(row_key),
+        encoded_key_(key_builder->BuildFromContiguousRow(row_key_)),
+        bloom_probe_(BloomKeyProbe(encoded_key_slice())) {}
+
   const ConstContiguousRow& row_key() const { return row_key_; }
 
   // Pointer to the key which has been encoded to be contiguous
@@ -523,6 +633,25 @@ class DuplicatingRowSet : public RowSet {
     return Status::OK();
   }
 
+  Status EstimateBytesInTruncatableUndoDeltas(Timestamp /*ancient_history_mark*/,
+                                              double /*min_ancient_ratio*/,
+                                              int64_t* bytes) override {
+    DCHECK(bytes);
+    *bytes = 0;
+    return Status::OK();
+  }
+
+  Status TruncateAncientUndoDeltas(Timestamp /*ancient_history_mark*/,
+                                   double /*min_ancient_ratio*/,
+                                   MonoTime /*deadline*/,
+                                   const fs::IOContext* /*io_context*/,
+                                   int64_t* blocks_truncated,
+                                   int64_t* bytes_truncated) override {
+    if (blocks_truncated) *blocks_truncated = 0;
+    if (bytes_truncated) *bytes_truncated = 0;
+    return Status::OK();
+  }
+
   Status MinorCompactDeltaStores(
       const fs::IOContext* /*io_context*/) override { return Status::OK(); }
 
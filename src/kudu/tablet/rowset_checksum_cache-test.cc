@@ -0,0 +1,77 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/rowset_checksum_cache.h"
+
+#include <cstdint>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+
+#include "kudu/common/timestamp.h"
+#include "kudu/util/test_util.h"
+
+namespace kudu {
+namespace tablet {
+
+class RowSetChecksumCacheTest : public KuduTest {
+ protected:
+  RowSetChecksumCache cache_;
+};
+
+TEST_F(RowSetChecksumCacheTest, TestInsertAndLookup) {
+  RowSetChecksumCache::Entry entry;
+  ASSERT_FALSE(cache_.Lookup("p", 1, &entry));
+  cache_.Insert("p", 1, { Timestamp(10), 123, 3 });
+  ASSERT_TRUE(cache_.Lookup("p", 1, &entry));
+  ASSERT_EQ(Timestamp(10), entry.timestamp);
+  ASSERT_EQ(123, entry.checksum);
+  ASSERT_EQ(3, entry.num_rows);
+  ASSERT_FALSE(cache_.Lookup("p", 2, &entry));
+  ASSERT_FALSE(cache_.Lookup("q", 1, &entry));
+
+  // The checksums at later snapshots are kept.
+  cache_.Insert("p", 1, { Timestamp(20), 456, 4 });
+  cache_.Insert("p", 1, { Timestamp(15), 789, 5 });
+  ASSERT_TRUE(cache_.Lookup("p", 1, &entry));
+  ASSERT_EQ(Timestamp(20), entry.timestamp);
+  ASSERT_EQ(456, entry.checksum);
+
+  // The checksums of another projection replace those of the previous one.
+  cache_.Insert("q", 2, { Timestamp(30), 1, 1 });
+  ASSERT_FALSE(cache_.Lookup("p", 1, &entry));
+  ASSERT_TRUE(cache_.Lookup("q", 2, &entry));
+  ASSERT_EQ(1, cache_.size());
+}
+
+TEST_F(RowSetChecksumCacheTest, TestRetain) {
+  for (int64_t id = 0; id < 4; id++) {
+    cache_.Insert("p", id, { Timestamp(10), 1, 1 });
+  }
+  cache_.Retain("p", { 1, 3, 5 });
+  ASSERT_EQ(2, cache_.size());
+  RowSetChecksumCache::Entry entry;
+  ASSERT_FALSE(cache_.Lookup("p", 0, &entry));
+  ASSERT_TRUE(cache_.Lookup("p", 1, &entry));
+  ASSERT_TRUE(cache_.Lookup("p", 3, &entry));
+
+  cache_.Retain("q", { 1, 3 });
+  ASSERT_EQ(0, cache_.size());
+}
+
+} // namespace tablet
+} // namespace kudu
@@ -0,0 +1,205 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/rowset_checksum_cache.h"
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/iterator.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/crc.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+using std::string;
+using std::unique_ptr;
+using std::unordered_set;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+class ScanSpec;
+struct IteratorStats;
+
+namespace tablet {
+
+uint32_t CalcRowCrc32(const Schema& projection, const RowBlockRow& row, faststring* buf) {
+  buf->clear();
+  for (size_t j = 0; j < projection.num_columns(); j++) {
+    uint32_t col_index = static_cast<uint32_t>(j);  // For the CRC.
+    buf->append(&col_index, sizeof(col_index));
+    ColumnBlockCell cell = row.cell(j);
+    if (cell.is_nullable()) {
+      uint8_t is_defined = cell.is_null() ? 0 : 1;
+      buf->append(&is_defined, sizeof(is_defined));
+      if (!is_defined) continue;
+    }
+    if (cell.typeinfo()->physical_type() == BINARY) {
+      const Slice* data = reinterpret_cast<const Slice *>(cell.ptr());
+      buf->append(data->data(), data->size());
+    } else {
+      buf->append(cell.ptr(), cell.size());
+    }
+  }
+
+  uint64_t row_crc = 0;
+  crc::GetCrc32cInstance()->Compute(buf->data(), buf->size(), &row_crc, nullptr);
+  return static_cast<uint32_t>(row_crc); // CRC32 only uses the lower 32 bits.
+}
+
+bool RowSetChecksumCache::Lookup(const string& projection_key,
+                                 int64_t rowset_id,
+                                 Entry* entry) const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (projection_key != projection_key_) {
+    return false;
+  }
+  const Entry* e = FindOrNull(entries_, rowset_id);
+  if (!e) {
+    return false;
+  }
+  *entry = *e;
+  return true;
+}
+
+void RowSetChecksumCache::Insert(const string& projection_key,
+                                 int64_t rowset_id,
+                                 const Entry& entry) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (projection_key != projection_key_) {
+    entries_.clear();
+    projection_key_ = projection_key;
+  }
+  Entry* e = &LookupOrInsert(&entries_, rowset_id, entry);
+  if (e->timestamp < entry.timestamp) {
+    *e = entry;
+  }
+}
+
+void RowSetChecksumCache::Retain(const string& projection_key,
+                                 const unordered_set<int64_t>& rowset_ids) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (projection_key != projection_key_) {
+    entries_.clear();
+    projection_key_ = projection_key;
+    return;
+  }
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (ContainsKey(rowset_ids, it->first)) {
+      ++it;
+    } else {
+      it = entries_.erase(it);
+    }
+  }
+}
+
+size_t RowSetChecksumCache::size() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return entries_.size();
+}
+
+namespace {
+
+// Checksums the rows of a rowset as they're returned: see
+// NewChecksumCachingIterator().
+class ChecksumCachingIterator : public RowwiseIterator {
+ public:
+  ChecksumCachingIterator(unique_ptr<RowwiseIterator> iter,
+                          RowSetChecksumCache* cache,
+                          string projection_key,
+                          int64_t rowset_id,
+                          Timestamp timestamp)
+      : iter_(std::move(iter)),
+        cache_(DCHECK_NOTNULL(cache)),
+        projection_key_(std::move(projection_key)),
+        rowset_id_(rowset_id),
+        timestamp_(timestamp) {
+  }
+
+  Status Init(ScanSpec* spec) override {
+    return iter_->Init(spec);
+  }
+
+  bool HasNext() const override {
+    return iter_->HasNext();
+  }
+
+  Status NextBlock(RowBlock* dst) override {
+    RETURN_NOT_OK(iter_->NextBlock(dst));
+    const SelectionVector* sel = dst->selection_vector();
+    for (size_t i = 0; i < dst->nrows(); i++) {
+      if (sel->IsRowSelected(i)) {
+        checksum_ += CalcRowCrc32(iter_->schema(), dst->row(i), &buf_);
+        num_rows_++;
+      }
+    }
+    if (!iter_->HasNext()) {
+      cache_->Insert(projection_key_, rowset_id_, { timestamp_, checksum_, num_rows_ });
+    }
+    return Status::OK();
+  }
+
+  string ToString() const override {
+    return Substitute("ChecksumCaching($0)", iter_->ToString());
+  }
+
+  const Schema& schema() const override {
+    return iter_->schema();
+  }
+
+  void GetIteratorStats(vector<IteratorStats>* stats) const override {
+    iter_->GetIteratorStats(stats);
+  }
+
+ private:
+  const unique_ptr<RowwiseIterator> iter_;
+  RowSetChecksumCache* const cache_;
+  const string projection_key_;
+  const int64_t rowset_id_;
+  const Timestamp timestamp_;
+
+  uint64_t checksum_ = 0;
+  int64_t num_rows_ = 0;
+  faststring buf_;
+};
+
+} // anonymous namespace
+
+unique_ptr<RowwiseIterator> NewChecksumCachingIterator(
+    unique_ptr<RowwiseIterator> iter,
+    RowSetChecksumCache* cache,
+    string projection_key,
+    int64_t rowset_id,
+    Timestamp timestamp) {
+  return unique_ptr<RowwiseIterator>(new ChecksumCachingIterator(
+      std::move(iter), cache, std::move(projection_key), rowset_id, timestamp));
+}
+
+} // namespace tablet
+} // namespace kudu
@@ -0,0 +1,117 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "kudu/common/timestamp.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+
+namespace kudu {
+
+class RowBlockRow;
+class RowwiseIterator;
+class Schema;
+class faststring;
+
+namespace tablet {
+
+// Returns the CRC32C of the first 'projection.num_columns()' cells of 'row',
+// using 'buf' as scratch space. The checksum of a checksum scan is the sum of
+// the CRCs of its rows, so that the checksums of disjoint sets of rows, e.g.
+// of the rowsets of a tablet, add up to the checksum of their union.
+uint32_t CalcRowCrc32(const Schema& projection, const RowBlockRow& row, faststring* buf);
+
+// The state of a checksum scan which reuses the checksums of the rowsets of
+// the tablet (see RowIteratorOptions::checksum_scan).
+struct ChecksumScanState {
+  // The timestamp of the snapshot of the scan.
+  Timestamp snapshot_timestamp;
+
+  // Set when the iterator is initialized, to the sum of the checksums and to
+  // the number of rows of the rowsets whose cached checksums are reused
+  // rather than scanning the rowsets.
+  uint64_t cached_checksum = 0;
+  int64_t cached_rows = 0;
+  int64_t num_cached_rowsets = 0;
+};
+
+// The checksums of the DiskRowSets of a tablet computed by the checksum scans
+// of the tablet, to be reused by the later checksum scans of the rowsets that
+// didn't change since.
+//
+// The checksums are those of a single projection of the tablet schema: the
+// checksums of another projection replace them all.
+//
+// This class is thread-safe.
+class RowSetChecksumCache {
+ public:
+  // The checksum of a rowset.
+  struct Entry {
+    // The timestamp of the snapshot the checksum was computed at.
+    Timestamp timestamp;
+    uint64_t checksum = 0;
+    int64_t num_rows = 0;
+  };
+
+  RowSetChecksumCache() = default;
+
+  // Looks up the checksum of rowset 'rowset_id' in the projection identified
+  // by 'projection_key' into 'entry'. Returns false if it isn't cached.
+  bool Lookup(const std::string& projection_key, int64_t rowset_id, Entry* entry) const;
+
+  // Caches 'entry' as the checksum of rowset 'rowset_id' in the projection
+  // identified by 'projection_key', unless a checksum at a later snapshot is
+  // already cached.
+  void Insert(const std::string& projection_key, int64_t rowset_id, const Entry& entry);
+
+  // Drops the checksums of the rowsets which aren't in 'rowset_ids', and those
+  // of the projections other than the one identified by 'projection_key'.
+  void Retain(const std::string& projection_key, const std::unordered_set<int64_t>& rowset_ids);
+
+  size_t size() const;
+
+ private:
+  mutable simple_spinlock lock_;
+
+  // The key of the projection of the checksums.
+  std::string projection_key_;
+
+  // The checksums, keyed by rowset ID.
+  std::unordered_map<int64_t, Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowSetChecksumCache);
+};
+
+// Returns an iterator which returns the rows of 'iter', the iterator of rowset
+// 'rowset_id', and caches their checksum into 'cache' once they're all
+// returned. The rows must be those of the rowset in a snapshot at 'timestamp',
+// without predicates. 'cache' must outlive the iterator.
+std::unique_ptr<RowwiseIterator> NewChecksumCachingIterator(
+    std::unique_ptr<RowwiseIterator> iter,
+    RowSetChecksumCache* cache,
+    std::string projection_key,
+    int64_t rowset_id,
+    Timestamp timestamp);
+
+} // namespace tablet
+} // namespace kudu
@@ -188,19 +188,55 @@ double StringFractionInRange(const RowSetInfo* rsi,
 // multiplying the fraction that the interval takes up in the keyspace of
 // each rowset by the rowset's size (assumes distribution of rows is somewhat
 // uniform).
+// If 'read_weights' is not null, the size of each rowset is multiplied by its
+// weight in the map.
 // Requires: [prev, next] contained in each rowset in "active"
 double WidthByDataSize(const Slice& prev, const Slice& next,
-                       const unordered_map<RowSet*, RowSetInfo*>& active) {
+                       const unordered_map<RowSet*, RowSetInfo*>& active,
+                       const unordered_map<const RowSet*, double>* read_weights = nullptr) {
   double weight = 0;
 
   for (const auto& rs_rsi : active) {
     double fraction = StringFractionInRange(rs_rsi.second, prev, next);
-    weight += rs_rsi.second->base_and_redos_size_bytes() * fraction;
+    double rs_weight = rs_rsi.second->base_and_redos_size_bytes() * fraction;
+    if (read_weights) {
+      rs_weight *= FindOrDie(*read_weights, rs_rsi.first);
+    }
+    weight += rs_weight;
   }
 
   return weight;
 }
 
+// Computes the weight of each of 'rowsets' when weighing them by how often
+// they're read, blended with weight 'read_hotness_weight' into the uniform
+// weight of 1. The weights average to 1 over the data of the rowsets. Returns
+// false if none of the rowsets has been read recently, in which case the
+// rowsets should be weighed uniformly.
+bool ComputeReadWeights(const RowSetVector& rowsets,
+                        double read_hotness_weight,
+                        unordered_map<const RowSet*, double>* read_weights) {
+  double total_size = 0;
+  double total_read_size = 0;
+  for (const auto& rs : rowsets) {
+    const double size = rs->OnDiskBaseDataSizeWithRedos();
+    const double read_rate = rs->ReadRate();
+    total_size += size;
+    total_read_size += size * read_rate;
+    EmplaceOrDie(read_weights, rs.get(), read_rate);
+  }
+  if (total_read_size <= 0) {
+    return false;
+  }
+  // Normalize the read rates by their average over the data.
+  const double mean_read_rate = total_read_size / total_size;
+  for (auto& rs_and_weight : *read_weights) {
+    rs_and_weight.second = (1 - read_hotness_weight) +
+        read_hotness_weight * rs_and_weight.second / mean_read_rate;
+  }
+  return true;
+}
+
 // Computes the "width" of an interval as above, for the provided columns in the rowsets.
 double WidthByDataSize(const Slice& prev, const Slice& next,
                        const unordered_map<RowSet*, RowSetInfo*>& active,
@@ -259,6 +295,7 @@ void RowSetInfo::Collect(const RowSetTree& tree, vector<RowSetInfo>* rsvec) {
 void RowSetInfo::ComputeCdfAndCollectOrdered(
     const RowSetTree& tree,
     optional<MemoryBudgetingFunc> is_on_memory_budget,
+    double read_hotness_weight,
     double* rowset_total_height,
     double* rowset_total_width,
     vector<RowSetInfo>* info_by_min_key,
@@ -307,6 +344,10 @@ void RowSetInfo::ComputeCdfAndCollectOrdered(
     }
   }
 
+  unordered_map<const RowSet*, double> read_weights;
+  const bool weigh_by_reads = read_hotness_weight > 0 &&
+      ComputeReadWeights(available_rowsets, read_hotness_weight, &read_weights);
+
   size_t len = available_rowsets.size();
   vector<RowSetInfo> info_by_min_key_tmp;
   vector<RowSetInfo> info_by_max_key_tmp;
@@ -322,7 +363,8 @@ void RowSetInfo::ComputeCdfAndCollectOrdered(
   for (const auto& rse : available_rs_tree.key_endpoints()) {
     RowSet* rs = rse.rowset_;
     const Slice& next_key = rse.slice_;
-    double interval_width = WidthByDataSize(prev_key, next_key, active);
+    double interval_width = WidthByDataSize(prev_key, next_key, active,
+                                            weigh_by_reads ? &read_weights : nullptr);
 
     // For each active rowset, update the cdf value at the max key and the
     // running total of weighted heights. They will be divided by the
@@ -52,6 +52,10 @@ class RowSetInfo {
   // information in min-key- and max-key-sorted order into 'info_by_min_key'
   // and 'info_by_max_key', respectively. The memory budgeting function
   // 'is_on_memory_budget' is used for OS resource assessment, if present.
+  // If 'read_hotness_weight' is positive, the data of each rowset counts in
+  // the cdf in proportion to how often the rowset is read rather than to its
+  // size only, with the weight in [0, 1] blending the two; see
+  // --compaction_read_hotness_weight.
   // The total weighted height and the total width of the rowset tree is set into
   // 'rowset_total_height' and 'rowset_total_width', if they are not nullptr.
   // If one of 'info_by_min_key' and 'info_by_max_key' is nullptr, the other
@@ -61,6 +65,7 @@ class RowSetInfo {
   static void ComputeCdfAndCollectOrdered(
       const RowSetTree& tree,
       std::optional<MemoryBudgetingFunc> is_on_memory_budget,
+      double read_hotness_weight,
       double* rowset_total_height,
       double* rowset_total_width,
       std::vector<RowSetInfo>* info_by_min_key,
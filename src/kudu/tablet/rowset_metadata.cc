@@ -100,9 +100,20 @@ void RowSetMetadata::LoadFromPB(const RowSetDataPB& pb) {
 
   // Load Column Files.
   blocks_by_col_id_.clear();
+  column_group_blocks_.clear();
   for (const ColumnDataPB& col_pb : pb.columns()) {
     ColumnId col_id = ColumnId(col_pb.column_id());
-    blocks_by_col_id_[col_id] = BlockId::FromPB(col_pb.block());
+    BlockId block_id = BlockId::FromPB(col_pb.block());
+    blocks_by_col_id_[col_id] = block_id;
+    if (col_pb.in_column_group()) {
+      column_group_blocks_.insert(block_id);
+    }
+  }
+
+  // Load the column statistics.
+  stats_by_col_id_.clear();
+  for (const ColumnStatsPB& stats_pb : pb.column_stats()) {
+    stats_by_col_id_[ColumnId(stats_pb.column_id())] = stats_pb;
   }
 
   // Load redo delta files.
@@ -138,6 +149,14 @@ void RowSetMetadata::ToProtobuf(RowSetDataPB *pb) {
     ColumnDataPB *col_data = pb->add_columns();
     block_id.CopyToPB(col_data->mutable_block());
     col_data->set_column_id(col_id);
+    if (ContainsKey(column_group_blocks_, block_id)) {
+      col_data->set_in_column_group(true);
+    }
+  }
+
+  // Write the column statistics.
+  for (const auto& e : stats_by_col_id_) {
+    *pb->add_column_stats() = e.second;
   }
 
   // Write Delta Files
@@ -179,11 +198,20 @@ const std::string RowSetMetadata::ToString() const {
   return Substitute("RowSet($0)", id_);
 }
 
-void RowSetMetadata::SetColumnDataBlocks(const std::map<ColumnId, BlockId>& blocks_by_col_id) {
+void RowSetMetadata::SetColumnDataBlocks(const std::map<ColumnId, BlockId>& blocks_by_col_id,
+                                         const BlockIdSet& column_group_blocks) {
   ColumnIdToBlockIdMap new_map(blocks_by_col_id.begin(), blocks_by_col_id.end());
   new_map.shrink_to_fit();
   std::lock_guard<LockType> l(lock_);
   blocks_by_col_id_ = std::move(new_map);
+  column_group_blocks_ = column_group_blocks;
+}
+
+void RowSetMetadata::SetColumnStats(const std::map<ColumnId, ColumnStatsPB>& stats_by_col_id) {
+  ColumnIdToStatsMap new_map(stats_by_col_id.begin(), stats_by_col_id.end());
+  new_map.shrink_to_fit();
+  std::lock_guard<LockType> l(lock_);
+  stats_by_col_id_ = std::move(new_map);
 }
 
 void RowSetMetadata::CommitRedoDeltaDataBlock(int64_t dms_id,
@@ -232,6 +260,17 @@ void RowSetMetadata::CommitUpdate(const RowSetMetadataUpdate& update,
       redo_delta_blocks_.push_back(b);
     }
 
+    // Replace undo blocks in place.
+    for (const auto& rep : update.replace_undo_blocks_) {
+      auto it = std::find(undo_delta_blocks_.begin(), undo_delta_blocks_.end(), rep.first);
+      CHECK(it != undo_delta_blocks_.end())
+          << "Tablet " << tablet_metadata_->tablet_id() << " RowSet " << id_ << ": "
+          << "Attempted to replace undo delta block " << rep.first.ToString()
+          << " which is not present in { " << undo_delta_blocks_ << " }";
+      removed->push_back(*it);
+      *it = rep.second;
+    }
+
     // Remove undo blocks.
     BlockIdSet undos_to_remove(update.remove_undo_blocks_.begin(),
                                update.remove_undo_blocks_.end());
@@ -253,25 +292,46 @@ void RowSetMetadata::CommitUpdate(const RowSetMetadataUpdate& update,
         << vector<BlockId>(undos_to_remove.begin(), undos_to_remove.end())
         << " }";
 
-    if (!update.new_undo_block_.IsNull()) {
-      // Front-loading to keep the UNDO files in their natural order.
-      undo_delta_blocks_.insert(undo_delta_blocks_.begin(), update.new_undo_block_);
-    }
+    // Front-loading to keep the UNDO files in their natural order.
+    undo_delta_blocks_.insert(undo_delta_blocks_.begin(),
+                              update.new_undo_blocks_.begin(), update.new_undo_blocks_.end());
 
+    BlockIdContainer old_column_blocks;
     for (const ColumnIdToBlockIdMap::value_type& e : update.cols_to_replace_) {
       // If we are major-compacting deltas into a column which previously had no
       // base-data (e.g. because it was newly added), then there will be no original
       // block there to replace.
       BlockId old_block_id;
       if (UpdateReturnCopy(&blocks_by_col_id_, e.first, e.second, &old_block_id)) {
-        removed->push_back(old_block_id);
+        old_column_blocks.push_back(old_block_id);
       }
+      // The statistics described the replaced data.
+      stats_by_col_id_.erase(e.first);
     }
 
     for (const ColumnId& col_id : update.col_ids_to_remove_) {
       BlockId old = FindOrDie(blocks_by_col_id_, col_id);
       CHECK_EQ(1, blocks_by_col_id_.erase(col_id));
-      removed->push_back(old);
+      old_column_blocks.push_back(old);
+      stats_by_col_id_.erase(col_id);
+    }
+
+    if (column_group_blocks_.empty()) {
+      removed->insert(removed->end(), old_column_blocks.begin(), old_column_blocks.end());
+    } else {
+      // The block of a column group is shared by several columns: it's only
+      // removed, once, along with the last of its columns.
+      BlockIdSet live_column_blocks;
+      for (const auto& e : blocks_by_col_id_) {
+        live_column_blocks.insert(e.second);
+      }
+      BlockIdSet removed_column_blocks;
+      for (const BlockId& b : old_column_blocks) {
+        if (!ContainsKey(live_column_blocks, b) && InsertIfNotPresent(&removed_column_blocks, b)) {
+          removed->push_back(b);
+          column_group_blocks_.erase(b);
+        }
+      }
     }
   }
 
@@ -309,7 +369,17 @@ BlockIdContainer RowSetMetadata::GetAllBlocks() const {
   if (!bloom_block_.IsNull()) {
     blocks.push_back(bloom_block_);
   }
-  AppendValuesFromMap(blocks_by_col_id_, &blocks);
+  if (column_group_blocks_.empty()) {
+    AppendValuesFromMap(blocks_by_col_id_, &blocks);
+  } else {
+    // The columns of a column group share its block.
+    BlockIdSet column_blocks;
+    for (const auto& e : blocks_by_col_id_) {
+      if (InsertIfNotPresent(&column_blocks, e.second)) {
+        blocks.push_back(e.second);
+      }
+    }
+  }
 
   blocks.insert(blocks.end(),
                 undo_delta_blocks_.begin(), undo_delta_blocks_.end());
@@ -371,8 +441,14 @@ RowSetMetadataUpdate& RowSetMetadataUpdate::RemoveUndoDeltaBlocks(
   return *this;
 }
 
-RowSetMetadataUpdate& RowSetMetadataUpdate::SetNewUndoBlock(const BlockId& undo_block) {
-  new_undo_block_ = undo_block;
+RowSetMetadataUpdate& RowSetMetadataUpdate::ReplaceUndoDeltaBlock(const BlockId& to_remove,
+                                                                 const BlockId& to_add) {
+  replace_undo_blocks_.emplace_back(to_remove, to_add);
+  return *this;
+}
+
+RowSetMetadataUpdate& RowSetMetadataUpdate::SetNewUndoBlocks(const vector<BlockId>& undo_blocks) {
+  new_undo_blocks_ = undo_blocks;
   return *this;
 }
 
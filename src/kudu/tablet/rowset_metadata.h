@@ -36,6 +36,7 @@
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/status.h"
@@ -44,7 +45,6 @@ namespace kudu {
 
 namespace tablet {
 
-class RowSetDataPB;
 class RowSetMetadataUpdate;
 
 // Keeps track of the RowSet data blocks.
@@ -74,6 +74,7 @@ class RowSetMetadata {
   // We use a flat_map to save memory, since there are lots of these metadata
   // objects.
   typedef boost::container::flat_map<ColumnId, BlockId> ColumnIdToBlockIdMap;
+  typedef boost::container::flat_map<ColumnId, ColumnStatsPB> ColumnIdToStatsMap;
 
   // Create a new RowSetMetadata
   static Status CreateNew(TabletMetadata* tablet_metadata,
@@ -116,7 +117,31 @@ class RowSetMetadata {
     adhoc_index_block_ = block_id;
   }
 
-  void SetColumnDataBlocks(const std::map<ColumnId, BlockId>& blocks_by_col_id);
+  // Sets the data blocks of the columns, of which 'column_group_blocks' are
+  // column groups.
+  void SetColumnDataBlocks(const std::map<ColumnId, BlockId>& blocks_by_col_id,
+                           const BlockIdSet& column_group_blocks = {});
+
+  // Sets the statistics of the columns written along with the rowset.
+  void SetColumnStats(const std::map<ColumnId, ColumnStatsPB>& stats_by_col_id);
+
+  // Returns whether the column 'col_id' has statistics, setting 'stats' to
+  // them if so. A column which was rewritten by a major delta compaction, or
+  // which was added after the rowset was written, has none.
+  bool GetColumnStats(ColumnId col_id, ColumnStatsPB* stats) const {
+    std::lock_guard<LockType> l(lock_);
+    const ColumnStatsPB* col_stats = FindOrNull(stats_by_col_id_, col_id);
+    if (!col_stats) {
+      return false;
+    }
+    *stats = *col_stats;
+    return true;
+  }
+
+  ColumnIdToStatsMap GetAllColumnStats() const {
+    std::lock_guard<LockType> l(lock_);
+    return stats_by_col_id_;
+  }
 
   // Atomically commit the new redo delta block to RowSetMetadata.
   // This atomic operation includes updates to last_durable_redo_dms_id_ and live_row_count_.
@@ -182,6 +207,12 @@ class RowSetMetadata {
     return blocks_by_col_id_;
   }
 
+  // Returns whether the column data block 'block_id' is a column group.
+  bool is_column_group_block(const BlockId& block_id) const {
+    std::lock_guard<LockType> l(lock_);
+    return ContainsKey(column_group_blocks_, block_id);
+  }
+
   std::vector<BlockId> redo_delta_blocks() const {
     std::lock_guard<LockType> l(lock_);
     return redo_delta_blocks_;
@@ -281,6 +312,13 @@ class RowSetMetadata {
 
   // Map of column ID to block ID.
   ColumnIdToBlockIdMap blocks_by_col_id_;
+
+  // The blocks of 'blocks_by_col_id_' which are column groups, shared by
+  // several columns.
+  BlockIdSet column_group_blocks_;
+
+  // The statistics of the columns' base data, for the columns which have any.
+  ColumnIdToStatsMap stats_by_col_id_;
   std::vector<BlockId> redo_delta_blocks_;
   std::vector<BlockId> undo_delta_blocks_;
 
@@ -311,15 +349,20 @@ class RowSetMetadataUpdate {
   // Remove the specified undo delta blocks.
   RowSetMetadataUpdate& RemoveUndoDeltaBlocks(const std::vector<BlockId>& to_remove);
 
+  // Replace the undo delta block 'to_remove' with 'to_add' at the same
+  // position, e.g. with a copy of it without its ancient deltas.
+  RowSetMetadataUpdate& ReplaceUndoDeltaBlock(const BlockId& to_remove,
+                                              const BlockId& to_add);
+
   // Replace the CFile for the given column ID.
   RowSetMetadataUpdate& ReplaceColumnId(ColumnId col_id, const BlockId& block_id);
 
   // Remove the CFile for the given column ID.
   RowSetMetadataUpdate& RemoveColumnId(ColumnId col_id);
 
-  // Add a new UNDO delta block to the list of UNDO files.
-  // We'll need to replace them instead when we start GCing.
-  RowSetMetadataUpdate& SetNewUndoBlock(const BlockId& undo_block);
+  // Add new UNDO delta blocks, ordered newest first, to the list of UNDO
+  // files. We'll need to replace them instead when we start GCing.
+  RowSetMetadataUpdate& SetNewUndoBlocks(const std::vector<BlockId>& undo_blocks);
 
  private:
   friend class RowSetMetadata;
@@ -334,7 +377,8 @@ class RowSetMetadataUpdate {
   std::vector<ReplaceDeltaBlocks> replace_redo_blocks_;
 
   std::vector<BlockId> remove_undo_blocks_;
-  BlockId new_undo_block_;
+  std::vector<std::pair<BlockId, BlockId>> replace_undo_blocks_;
+  std::vector<BlockId> new_undo_blocks_;
 
   DISALLOW_COPY_AND_ASSIGN(RowSetMetadataUpdate);
 };
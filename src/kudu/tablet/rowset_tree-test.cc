@@ -39,12 +39,14 @@
 #include "kudu/tablet/mock-rowsets.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
 using std::make_shared;
 using std::nullopt;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::unordered_set;
@@ -214,6 +216,49 @@ TEST_F(TestRowSetTree, TestTree) {
   ASSERT_EQ(vec[2].get(), out[3]);
 }
 
+// Keys above the bounds of all of the DiskRowSets are only passed to the
+// MemRowSet.
+TEST_F(TestRowSetTree, TestKeysAboveAllBounds) {
+  RowSetVector vec;
+  vec.push_back(make_shared<MockDiskRowSet>("0", "5"));
+  vec.push_back(make_shared<MockDiskRowSet>("3", "7"));
+  vec.push_back(make_shared<MockMemRowSet>());
+
+  RowSetTree tree;
+  ASSERT_OK(tree.Reset(vec));
+  ASSERT_FALSE(tree.IsAboveAllBounds("6"));
+  ASSERT_FALSE(tree.IsAboveAllBounds("7"));
+  ASSERT_TRUE(tree.IsAboveAllBounds("70"));
+  ASSERT_TRUE(tree.IsAboveAllBounds("8"));
+
+  vector<RowSet *> out;
+  tree.FindRowSetsWithKeyInRange("8", &out);
+  ASSERT_EQ(1, out.size());
+  ASSERT_EQ(vec[2].get(), out[0]); // MemRowSet
+
+  vector<Slice> keys = { "4", "7", "8", "9" };
+  vector<pair<RowSet*, int>> results;
+  int num_above = tree.ForEachRowSetContainingKeys(
+      keys, [&](RowSet* rs, int i) { results.emplace_back(rs, i); });
+  ASSERT_EQ(2, num_above);
+  // The MemRowSet gets all of the keys, the DiskRowSets only "4" and "7".
+  ASSERT_EQ(7, results.size());
+  for (const auto& r : results) {
+    if (r.first != vec[2].get()) {
+      ASSERT_LT(r.second, 2);
+    }
+  }
+
+  // Without DiskRowSets, all keys are above their bounds.
+  RowSetTree mrs_only;
+  ASSERT_OK(mrs_only.Reset({ vec[2] }));
+  ASSERT_TRUE(mrs_only.IsAboveAllBounds("0"));
+  results.clear();
+  ASSERT_EQ(4, mrs_only.ForEachRowSetContainingKeys(
+      keys, [&](RowSet* rs, int i) { results.emplace_back(rs, i); }));
+  ASSERT_EQ(4, results.size());
+}
+
 TEST_F(TestRowSetTree, TestTreeRandomized) {
   enum BoundOperator {
     BOUND_LESS_THAN,
@@ -358,6 +403,106 @@ TEST_P(TestRowSetTreePerformance, TestPerformance) {
                             batch_total ? (oat_total / batch_total) : 0);
 }
 
+// Test that a tree built from another one with ResetFromTree() is the same as
+// a tree built from scratch with the same rowsets.
+TEST_F(TestRowSetTree, TestResetFromTree) {
+  SeedRandom();
+  RowSetVector vec = GenerateRandomRowSets(100);
+  vec.push_back(make_shared<MockMemRowSet>());
+  auto tree = make_shared<RowSetTree>();
+  ASSERT_OK(tree->Reset(vec));
+
+  for (int i = 0; i < 20; i++) {
+    // Replace a few random rowsets with new ones, as a compaction would.
+    RowSetVector to_remove;
+    RowSetVector kept;
+    for (const auto& rs : tree->all_rowsets()) {
+      (rand() % 10 == 0 ? to_remove : kept).push_back(rs);
+    }
+    RowSetVector to_add = GenerateRandomRowSets(rand() % 5);
+    if (rand() % 4 == 0) {
+      to_add.push_back(make_shared<MockMemRowSet>());
+    }
+    auto new_tree = make_shared<RowSetTree>();
+    ASSERT_OK(new_tree->ResetFromTree(*tree, to_remove, to_add));
+
+    kept.insert(kept.end(), to_add.begin(), to_add.end());
+    RowSetTree expected;
+    ASSERT_OK(expected.Reset(kept));
+    ASSERT_EQ(expected.all_rowsets(), new_tree->all_rowsets());
+    ASSERT_EQ(expected.key_endpoints().size(), new_tree->key_endpoints().size());
+    for (int e = 0; e < expected.key_endpoints().size(); e++) {
+      const auto& a = expected.key_endpoints()[e];
+      const auto& b = new_tree->key_endpoints()[e];
+      ASSERT_EQ(a.rowset_, b.rowset_);
+      ASSERT_EQ(a.endpoint_, b.endpoint_);
+      ASSERT_EQ(a.slice_, b.slice_);
+    }
+    for (int q = 0; q < 100; q++) {
+      const string key = StringPrintf("%04d", rand() % 10000);
+      vector<RowSet*> expected_out;
+      vector<RowSet*> out;
+      expected.FindRowSetsWithKeyInRange(Slice(key), &expected_out);
+      new_tree->FindRowSetsWithKeyInRange(Slice(key), &out);
+      std::sort(expected_out.begin(), expected_out.end());
+      std::sort(out.begin(), out.end());
+      ASSERT_EQ(expected_out, out);
+    }
+
+    // The old tree stays usable until it's dropped.
+    tree.swap(new_tree);
+    new_tree.reset();
+  }
+
+  // Removing a rowset which isn't in the tree is an error.
+  RowSetTree bad_tree;
+  Status s = bad_tree.ResetFromTree(*tree, GenerateRandomRowSets(1), {});
+  ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+}
+
+// Compare the cost of swapping a few rowsets of a tree with many rowsets by
+// rebuilding the tree from scratch and by updating it.
+TEST_F(TestRowSetTree, TestResetFromTreePerformance) {
+  const int kNumRowSets = AllowSlowTests() ? 10000 : 1000;
+  const int kNumSwaps = 100;
+  SeedRandom();
+  auto tree = make_shared<RowSetTree>();
+  ASSERT_OK(tree->Reset(GenerateRandomRowSets(kNumRowSets)));
+
+  Stopwatch reset_timer;
+  Stopwatch update_timer;
+  for (int i = 0; i < kNumSwaps; i++) {
+    // Swap two rowsets for one, as a small compaction would.
+    const auto& all = tree->all_rowsets();
+    const int idx = rand() % all.size();
+    RowSetVector to_remove = { all[idx], all[(idx + 1) % all.size()] };
+    RowSetVector to_add = GenerateRandomRowSets(1);
+
+    RowSetVector post_swap;
+    for (const auto& rs : all) {
+      if (rs != to_remove[0] && rs != to_remove[1]) {
+        post_swap.push_back(rs);
+      }
+    }
+    post_swap.push_back(to_add[0]);
+    reset_timer.resume();
+    RowSetTree rebuilt;
+    ASSERT_OK(rebuilt.Reset(post_swap));
+    reset_timer.stop();
+
+    update_timer.resume();
+    auto updated = make_shared<RowSetTree>();
+    ASSERT_OK(updated->ResetFromTree(*tree, to_remove, to_add));
+    update_timer.stop();
+    ASSERT_EQ(rebuilt.key_endpoints().size(), updated->key_endpoints().size());
+    tree = std::move(updated);
+  }
+  LOG(INFO) << Substitute("R=$0: $1 swaps with Reset(): $2 ms, with ResetFromTree(): $3 ms",
+                          kNumRowSets, kNumSwaps,
+                          reset_timer.elapsed().wall_millis(),
+                          update_timer.elapsed().wall_millis());
+}
+
 TEST_F(TestRowSetTree, TestEndpointsConsistency) {
   const int kNumRowSets = 1000;
   RowSetVector vec = GenerateRandomRowSets(kNumRowSets);
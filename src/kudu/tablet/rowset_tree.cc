@@ -20,15 +20,19 @@
 #include <algorithm>
 #include <cstddef>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
 
-#include "kudu/gutil/stl_util.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"  // IWYU pragma: keep
 #include "kudu/util/interval_tree-inl.h"
@@ -40,7 +44,9 @@ using std::optional;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
+using std::unordered_set;
 using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace tablet {
@@ -125,23 +131,17 @@ struct RowSetIntervalTraits {
   }
 };
 
-RowSetTree::RowSetTree()
-  : initted_(false) {
-}
-
-Status RowSetTree::Reset(const RowSetVector &rowsets) {
-  DCHECK(!initted_);
-  vector<RowSetWithBounds *> entries;
-  RowSetVector unbounded;
-  ElementDeleter deleter(&entries);
-  entries.reserve(rowsets.size());
-  vector<RSEndpoint> endpoints;
-  endpoints.reserve(rowsets.size()*2);
+namespace {
 
-  // Iterate over each of the provided RowSets, fetching their
-  // bounds and adding them to the local vectors.
+// Fetches the bounds of 'rowsets', appending an entry to 'entries' and its
+// endpoints to 'endpoints' for each of the rowsets with known bounds, and
+// appending the others to 'unbounded'.
+Status LoadBounds(const RowSetVector& rowsets,
+                  vector<shared_ptr<RowSetWithBounds>>* entries,
+                  RowSetVector* unbounded,
+                  vector<RowSetTree::RSEndpoint>* endpoints) {
   for (const shared_ptr<RowSet> &rs : rowsets) {
-    unique_ptr<RowSetWithBounds> rsit(new RowSetWithBounds());
+    auto rsit(std::make_shared<RowSetWithBounds>());
     rsit->rowset = rs.get();
     string min_key;
     string max_key;
@@ -151,7 +151,7 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
       // data gets inserted. Therefore we can't put it in the static
       // interval tree -- instead put it on the list which is consulted
       // on every access.
-      unbounded.push_back(rs);
+      unbounded->push_back(rs);
       continue;
     } else if (!s.ok()) {
       LOG(WARNING) << "Unable to construct RowSetTree: "
@@ -167,21 +167,122 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
     rsit->max_key = std::move(max_key);
 
     // Load into key endpoints.
-    endpoints.emplace_back(rsit->rowset, START, rsit->min_key);
-    endpoints.emplace_back(rsit->rowset, STOP, rsit->max_key);
+    endpoints->emplace_back(rsit->rowset, RowSetTree::START, rsit->min_key);
+    endpoints->emplace_back(rsit->rowset, RowSetTree::STOP, rsit->max_key);
 
-    entries.push_back(rsit.release());
+    entries->emplace_back(std::move(rsit));
   }
+  return Status::OK();
+}
+
+} // anonymous namespace
+
+RowSetTree::RowSetTree()
+  : initted_(false) {
+}
+
+Status RowSetTree::Reset(const RowSetVector &rowsets) {
+  DCHECK(!initted_);
+  vector<shared_ptr<RowSetWithBounds>> entries;
+  RowSetVector unbounded;
+  entries.reserve(rowsets.size());
+  vector<RSEndpoint> endpoints;
+  endpoints.reserve(rowsets.size()*2);
+
+  // Iterate over each of the provided RowSets, fetching their
+  // bounds and adding them to the local vectors.
+  RETURN_NOT_OK(LoadBounds(rowsets, &entries, &unbounded, &endpoints));
 
   // Sort endpoints
   std::sort(endpoints.begin(), endpoints.end(), RSEndpointBySliceCompare);
 
+  Install(std::move(entries), std::move(unbounded), std::move(endpoints),
+          RowSetVector(rowsets.begin(), rowsets.end()));
+  return Status::OK();
+}
+
+Status RowSetTree::ResetFromTree(const RowSetTree& base,
+                                 const RowSetVector& rowsets_to_remove,
+                                 const RowSetVector& rowsets_to_add) {
+  DCHECK(!initted_);
+  DCHECK(base.initted_);
+  unordered_set<const RowSet*> to_remove;
+  for (const auto& rs : rowsets_to_remove) {
+    to_remove.insert(rs.get());
+  }
+  const auto is_removed = [&](const RowSet* rs) {
+    return ContainsKey(to_remove, rs);
+  };
+
+  RowSetVector all_rowsets;
+  all_rowsets.reserve(base.all_rowsets_.size() + rowsets_to_add.size());
+  for (const auto& rs : base.all_rowsets_) {
+    if (!is_removed(rs.get())) {
+      all_rowsets.push_back(rs);
+    }
+  }
+  if (PREDICT_FALSE(base.all_rowsets_.size() - all_rowsets.size() != to_remove.size())) {
+    return Status::NotFound(Substitute(
+        "$0 of the $1 rowsets to remove aren't in the tree",
+        to_remove.size() - (base.all_rowsets_.size() - all_rowsets.size()),
+        to_remove.size()));
+  }
+  all_rowsets.insert(all_rowsets.end(), rowsets_to_add.begin(), rowsets_to_add.end());
+
+  // Keep the entries of the remaining rowsets along with their endpoints,
+  // which are already sorted.
+  vector<shared_ptr<RowSetWithBounds>> entries;
+  entries.reserve(base.entries_.size() + rowsets_to_add.size());
+  for (const auto& e : base.entries_) {
+    if (!is_removed(e->rowset)) {
+      entries.push_back(e);
+    }
+  }
+  RowSetVector unbounded;
+  for (const auto& rs : base.unbounded_rowsets_) {
+    if (!is_removed(rs.get())) {
+      unbounded.push_back(rs);
+    }
+  }
+  vector<RSEndpoint> kept_endpoints;
+  kept_endpoints.reserve(base.key_endpoints_.size());
+  for (const auto& e : base.key_endpoints_) {
+    if (!is_removed(e.rowset_)) {
+      kept_endpoints.push_back(e);
+    }
+  }
+
+  // Load the new rowsets, and merge their sorted endpoints in.
+  vector<RSEndpoint> new_endpoints;
+  new_endpoints.reserve(rowsets_to_add.size() * 2);
+  RETURN_NOT_OK(LoadBounds(rowsets_to_add, &entries, &unbounded, &new_endpoints));
+  std::sort(new_endpoints.begin(), new_endpoints.end(), RSEndpointBySliceCompare);
+  vector<RSEndpoint> endpoints;
+  endpoints.reserve(kept_endpoints.size() + new_endpoints.size());
+  std::merge(kept_endpoints.begin(), kept_endpoints.end(),
+             new_endpoints.begin(), new_endpoints.end(),
+             std::back_inserter(endpoints), RSEndpointBySliceCompare);
+
+  Install(std::move(entries), std::move(unbounded), std::move(endpoints),
+          std::move(all_rowsets));
+  return Status::OK();
+}
+
+void RowSetTree::Install(vector<shared_ptr<RowSetWithBounds>> entries,
+                         RowSetVector unbounded,
+                         vector<RSEndpoint> endpoints,
+                         RowSetVector all_rowsets) {
   // Install the vectors into the object.
-  entries_.swap(entries);
-  unbounded_rowsets_.swap(unbounded);
-  tree_.reset(new IntervalTree<RowSetIntervalTraits>(entries_));
-  key_endpoints_.swap(endpoints);
-  all_rowsets_.assign(rowsets.begin(), rowsets.end());
+  entries_ = std::move(entries);
+  unbounded_rowsets_ = std::move(unbounded);
+  vector<RowSetWithBounds*> intervals;
+  intervals.reserve(entries_.size());
+  for (const auto& e : entries_) {
+    intervals.push_back(e.get());
+  }
+  tree_.reset(new IntervalTree<RowSetIntervalTraits>(intervals));
+  key_endpoints_ = std::move(endpoints);
+  all_rowsets_ = std::move(all_rowsets);
 
   // Build the mapping from DRS ID to DRS.
   drs_by_id_.clear();
@@ -192,8 +293,6 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
   }
 
   initted_ = true;
-
-  return Status::OK();
 }
 
 void RowSetTree::FindRowSetsIntersectingInterval(const optional<Slice>& lower_bound,
@@ -224,10 +323,15 @@ void RowSetTree::FindRowSetsWithKeyInRange(const Slice &encoded_key,
     rowsets->push_back(rs.get());
   }
 
+  if (IsAboveAllBounds(encoded_key)) {
+    return;
+  }
+
   // Query the interval tree to efficiently find rowsets with known bounds
-  // whose ranges overlap the probe key.
+  // whose ranges overlap the probe key. Only a few of them usually do, so
+  // don't reserve room for all of them: on tablets with many rowsets, that
+  // allocation would dominate the cost of the probe.
   vector<RowSetWithBounds *> from_tree;
-  from_tree.reserve(all_rowsets_.size());
   tree_->FindContainingPoint(encoded_key, &from_tree);
   rowsets->reserve(rowsets->size() + from_tree.size());
   for (RowSetWithBounds *rs : from_tree) {
@@ -235,7 +339,7 @@ void RowSetTree::FindRowSetsWithKeyInRange(const Slice &encoded_key,
   }
 }
 
-void RowSetTree::ForEachRowSetContainingKeys(
+int RowSetTree::ForEachRowSetContainingKeys(
     const vector<Slice>& encoded_keys,
     const function<void(RowSet*, int)>& cb) const {
 
@@ -248,12 +352,21 @@ void RowSetTree::ForEachRowSetContainingKeys(
     }
   }
 
+  // The keys above the largest upper bound can't be in any rowset of the
+  // interval tree, so there's no need to query it for them.
+  int num_bounded_keys = 0;
+  if (!key_endpoints_.empty()) {
+    num_bounded_keys = std::upper_bound(encoded_keys.begin(), encoded_keys.end(),
+                                        key_endpoints_.back().slice_,
+                                        Slice::Comparator()) - encoded_keys.begin();
+  }
+
   // The interval tree batch query callback would naturally just give us back
   // the matching Slices, but that won't allow us to easily tell the caller
   // which specific operation _index_ matched the RowSet. So, we make a vector
   // of QueryStructs to pair the Slice with its original index.
-  vector<QueryStruct> queries(encoded_keys.size());
-  for (auto i = 0; i < encoded_keys.size(); ++i) {
+  vector<QueryStruct> queries(num_bounded_keys);
+  for (auto i = 0; i < num_bounded_keys; ++i) {
     queries[i] = {encoded_keys[i], i};
   }
 
@@ -262,11 +375,11 @@ void RowSetTree::ForEachRowSetContainingKeys(
       [&](const QueryStruct& qs, RowSetWithBounds* rs) {
         cb(rs->rowset, qs.idx);
       });
+  return encoded_keys.size() - num_bounded_keys;
 }
 
 
 RowSetTree::~RowSetTree() {
-  STLDeleteElements(&entries_);
 }
 
 } // namespace tablet
@@ -66,6 +66,21 @@ class RowSetTree {
 
   RowSetTree();
   Status Reset(const RowSetVector &rowsets);
+
+  // Resets the tree with the rowsets of 'base' except for 'rowsets_to_remove',
+  // plus 'rowsets_to_add', as with Reset(). The bounds of the rowsets kept from
+  // 'base' are shared with it rather than fetched and copied again, and their
+  // endpoints are merged with those of the new rowsets rather than sorted
+  // again, so the cost of swapping a few rowsets in a tree of many is mostly
+  // that of rebuilding the interval tree.
+  //
+  // Returns NotFound if some of 'rowsets_to_remove' aren't in 'base'.
+  //
+  // NOTE: this relies on the bounds of the rowsets with known bounds never
+  // changing, which is the case of the DiskRowSets.
+  Status ResetFromTree(const RowSetTree& base,
+                       const RowSetVector& rowsets_to_remove,
+                       const RowSetVector& rowsets_to_add);
   ~RowSetTree();
 
   // Return all RowSets whose range may contain the given encoded key.
@@ -81,9 +96,13 @@ class RowSetTree {
   // See IntervalTree::ForEachIntervalContainingPoints for additional
   // information on the particular order in which the callback will be called.
   //
+  // Returns the number of keys which are above the bounds of all of the
+  // rowsets with known bounds, which are only passed to the rowsets with
+  // unknown bounds: with increasing keys, this is the case of most inserts.
+  //
   // REQUIRES: 'encoded_keys' must be in sorted order.
-  void ForEachRowSetContainingKeys(const std::vector<Slice>& encoded_keys,
-                                   const std::function<void(RowSet*, int)>& cb) const;
+  int ForEachRowSetContainingKeys(const std::vector<Slice>& encoded_keys,
+                                  const std::function<void(RowSet*, int)>& cb) const;
 
   // When 'lower_bound' is std::nullopt, it means negative infinity.
   // When 'upper_bound' is std::nullopt, it means positive infinity.
@@ -98,6 +117,13 @@ class RowSetTree {
 
   const RowSetVector &all_rowsets() const { return all_rowsets_; }
 
+  // Return true if 'encoded_key' is above the upper bounds of all of the
+  // rowsets with known bounds, i.e. only the rowsets with unknown bounds
+  // may contain it.
+  bool IsAboveAllBounds(const Slice& encoded_key) const {
+    return key_endpoints_.empty() || encoded_key.compare(key_endpoints_.back().slice_) > 0;
+  }
+
   RowSet* drs_by_id(int64_t drs_id) const {
     return FindPtrOrNull(drs_by_id_, drs_id);
   }
@@ -117,10 +143,17 @@ class RowSetTree {
   // TODO map to usage statistics as well. See KUDU-???
   std::vector<RSEndpoint> key_endpoints_;
 
+  // Installs the given state into the object and builds the interval tree.
+  void Install(std::vector<std::shared_ptr<RowSetWithBounds>> entries,
+               RowSetVector unbounded,
+               std::vector<RSEndpoint> endpoints,
+               RowSetVector all_rowsets);
+
   // Container for all of the entries in tree_. IntervalTree does
-  // not itself manage memory, so this provides a simple way to enumerate
-  // all the entry structs and free them in the destructor.
-  std::vector<RowSetWithBounds *> entries_;
+  // not itself manage memory, so this holds the entry structs. They're shared
+  // with the trees built from this one with ResetFromTree(), whose endpoints
+  // point into their keys.
+  std::vector<std::shared_ptr<RowSetWithBounds>> entries_;
 
   // All of the rowsets which were put in this RowSetTree.
   RowSetVector all_rowsets_;
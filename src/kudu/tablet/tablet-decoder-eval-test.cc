@@ -296,6 +296,16 @@ TEST_P(TabletDecoderEvalTest, EvaluateEmpty) {
   TestScanAndFilter(50, 50, 55);
 }
 
+TEST_P(TabletDecoderEvalTest, SingleMatchingWord) {
+  // Only a single word of the dictionary matches [7, 8).
+  TestScanAndFilter(50, 7, 8);
+}
+
+TEST_P(TabletDecoderEvalTest, AllWordsMatching) {
+  // Every word of the dictionary matches [0, 50).
+  TestScanAndFilter(50, 0, 50);
+}
+
 TEST_P(TabletDecoderEvalTest, NullableLowCardinality) {
   // Fill a tablet with pattern [0, 50) but with values [0, 40) as NULL.
   // Query for values [30, 50).
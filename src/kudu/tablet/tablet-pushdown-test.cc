@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cinttypes>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -38,6 +39,7 @@
 #include "kudu/common/schema.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/tablet/local_tablet_writer.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/tablet/tablet.h"
 #include "kudu/util/memory/arena.h"
@@ -186,7 +188,8 @@ class TabletPushdownTest : public KuduTabletTest,
       ASSERT_EQ("()", result);
     }
   }
- private:
+
+ protected:
   uint64_t nrows_;
 };
 
@@ -220,6 +223,53 @@ TEST_P(TabletPushdownTest, TestPushdownIntValueRange) {
   // were not read.
 }
 
+// Test the statistics of the columns of the flushed rows, and that scans skip
+// the rowsets which they rule out.
+TEST_P(TabletPushdownTest, TestColumnStats) {
+  vector<ColumnStatsPB> stats;
+  tablet()->GetColumnStats(&stats);
+  if (GetParam() == ALL_IN_MEMORY) {
+    ASSERT_TRUE(stats.empty());
+    return;
+  }
+  // The flushed rows are those with keys 0 to 'max_key'.
+  const int32_t max_key = GetParam() == SPLIT_MEMORY_DISK ? 205 : nrows_ - 1;
+  const auto int32_cell = [](const string& cell) {
+    int32_t val;
+    CHECK_EQ(sizeof(val), cell.size());
+    memcpy(&val, cell.data(), sizeof(val));
+    return val;
+  };
+  ASSERT_EQ(3, stats.size());
+  for (const auto& col_stats : stats) {
+    SCOPED_TRACE(col_stats.column_id());
+    ASSERT_EQ(0, col_stats.null_count());
+    ASSERT_NEAR(max_key + 1, col_stats.distinct_count_estimate(), (max_key + 1) / 20);
+  }
+  ASSERT_EQ(0, int32_cell(stats[0].min_value()));
+  ASSERT_EQ(max_key, int32_cell(stats[0].max_value()));
+  ASSERT_EQ(0, int32_cell(stats[1].min_value()));
+  ASSERT_EQ(max_key * 10, int32_cell(stats[1].max_value()));
+  // There are no bounds for variable-length values.
+  ASSERT_FALSE(stats[2].has_min_value());
+
+  // A scan for values which aren't in the flushed rows doesn't read them.
+  ScanSpec spec;
+  int32_t lower = max_key * 10 + 1;
+  spec.AddPredicate(ColumnPredicate::Range(schema_.column(1), &lower, nullptr));
+  unique_ptr<RowwiseIterator> iter;
+  ASSERT_OK(tablet()->NewRowIterator(client_schema_, &iter));
+  ASSERT_OK(iter->Init(&spec));
+  vector<string> results;
+  ASSERT_OK(IterateToStringList(iter.get(), &results));
+  ASSERT_EQ(nrows_ - max_key - 1, results.size());
+  vector<IteratorStats> iter_stats;
+  iter->GetIteratorStats(&iter_stats);
+  for (const IteratorStats& col_stats : iter_stats) {
+    ASSERT_EQ(0, col_stats.cells_read);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(AllMemory, TabletPushdownTest, ::testing::Values(ALL_IN_MEMORY));
 INSTANTIATE_TEST_SUITE_P(SplitMemoryDisk, TabletPushdownTest, ::testing::Values(SPLIT_MEMORY_DISK));
 INSTANTIATE_TEST_SUITE_P(AllDisk, TabletPushdownTest, ::testing::Values(ALL_ON_DISK));
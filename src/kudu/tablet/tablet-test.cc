@@ -37,8 +37,10 @@
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/iterator.h"
+#include "kudu/common/iterator_stats.h"
 #include "kudu/common/key_range.h"
 #include "kudu/common/partial_row.h"
+#include "kudu/common/row.h"
 #include "kudu/common/row_operations.pb.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/rowblock_memory.h"
@@ -64,6 +66,7 @@
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet_metrics.h" // IWYU pragma: keep
 #include "kudu/util/faststring.h"
+#include "kudu/util/hot_key_tracker.h"
 #include "kudu/util/jsonwriter.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
@@ -71,6 +74,13 @@
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 
+namespace kudu {
+class ScanSpec;
+} // namespace kudu
+
+DECLARE_int64(budgeted_compaction_target_rowset_size);
+DECLARE_int32(tablet_hot_key_sampling_rate);
+
 DEFINE_int32(testflush_num_inserts, 1000,
              "Number of rows inserted in TestFlush");
 DEFINE_int32(testiterator_num_inserts, 1000,
@@ -81,6 +91,7 @@ DEFINE_int32(testcompaction_num_rows, 1000,
 using kudu::cfile::ReaderOptions;
 using kudu::fs::ReadableBlock;
 using std::make_shared;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -531,6 +542,55 @@ TYPED_TEST(TestTablet, TestRowIteratorSimple) {
   ASSERT_FALSE(iter->HasNext());
 }
 
+TYPED_TEST(TestTablet, TestLookupRows) {
+  // Put rows 0-4 in a disk rowset and rows 5-9 in the memrowset, then delete
+  // and update some of them.
+  LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+  for (int i = 0; i < 5; i++) {
+    CHECK_OK(this->InsertTestRow(&writer, i, i));
+  }
+  ASSERT_OK(this->tablet()->Flush());
+  for (int i = 5; i < 10; i++) {
+    CHECK_OK(this->InsertTestRow(&writer, i, i));
+  }
+  ASSERT_OK(this->DeleteTestRow(&writer, 1));
+  ASSERT_OK(this->UpdateTestRow(&writer, 2, 100));
+  ASSERT_OK(this->DeleteTestRow(&writer, 6));
+
+  // Look up present, deleted and missing keys, sorted by their encoding.
+  vector<pair<string, int>> encoded_keys;
+  for (int key_idx : { 0, 1, 2, 6, 7, 20 }) {
+    KuduPartialRow row(&this->client_schema_);
+    this->setup_.BuildRowKey(&row, key_idx);
+    string encoded_key;
+    ASSERT_OK(row.EncodeRowKey(&encoded_key));
+    encoded_keys.emplace_back(std::move(encoded_key), key_idx);
+  }
+  std::sort(encoded_keys.begin(), encoded_keys.end());
+  Arena arena(1024);
+  vector<const EncodedKey*> keys;
+  for (const auto& encoded_key : encoded_keys) {
+    EncodedKey* key;
+    ASSERT_OK(EncodedKey::DecodeEncodedString(this->schema_, &arena, encoded_key.first, &key));
+    keys.push_back(key);
+  }
+
+  RowBlockMemory mem;
+  RowBlock block(&this->client_schema_, keys.size(), &mem);
+  ASSERT_OK(this->tablet()->LookupRows(this->client_schema_, keys, &block));
+  ASSERT_EQ(keys.size(), block.nrows());
+  ASSERT_EQ(3, block.selection_vector()->CountSelected());
+  for (int i = 0; i < keys.size(); i++) {
+    const int key_idx = encoded_keys[i].second;
+    if (key_idx == 1 || key_idx == 6 || key_idx == 20) {
+      ASSERT_FALSE(block.selection_vector()->IsRowSelected(i)) << key_idx;
+      continue;
+    }
+    ASSERT_TRUE(block.selection_vector()->IsRowSelected(i)) << key_idx;
+    NO_FATALS(this->VerifyRow(block.row(i), key_idx, key_idx == 2 ? 100 : key_idx));
+  }
+}
+
 // Hook implementation which runs a lambda function during the 'duplicating'
 // phase of compaction.
 template<class HookFunc>
@@ -1031,6 +1091,26 @@ TYPED_TEST(TestTablet, TestMultipleUpdates) {
   ASSERT_EQ(this->setup_.FormatDebugRow(1, 0, false), out_rows[1]);
 }
 
+// The row operations repeatedly accessing a key make it the hottest one.
+TYPED_TEST(TestTablet, TestHotKeys) {
+  FLAGS_tablet_hot_key_sampling_rate = 1;
+  LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(this->InsertTestRow(&writer, i, 0));
+  }
+  for (int i = 1; i <= 200; i++) {
+    ASSERT_OK(this->UpdateTestRow(&writer, 7, i));
+  }
+  const HotKeyTracker& tracker = this->tablet()->hot_keys();
+  ASSERT_EQ(300, tracker.total_count());
+  const auto hot_keys = tracker.HotKeys();
+  ASSERT_FALSE(hot_keys.empty());
+  ASSERT_GE(hot_keys[0].count, 201);
+  ASSERT_LE(hot_keys[0].count, 210);
+  ASSERT_GE(tracker.HottestKeyPermille(), 670);
+  ASSERT_EQ(300, this->tablet()->hot_key_ranges().total_count());
+}
+
 TYPED_TEST(TestTablet, TestCompaction) {
   uint64_t max_rows = this->ClampRowCount(FLAGS_testcompaction_num_rows);
 
@@ -1100,6 +1180,48 @@ TYPED_TEST(TestTablet, TestCompaction) {
   }
 }
 
+// The key ranges of a compaction written concurrently produce all the rows
+// of the input rowsets, into rowsets which don't overlap.
+TYPED_TEST(TestTablet, TestParallelCompaction) {
+  constexpr int kNumRowSets = 4;
+  const uint64_t n_rows = this->ClampRowCount(FLAGS_testcompaction_num_rows / kNumRowSets);
+  for (int i = 0; i < kNumRowSets; i++) {
+    this->InsertTestRows(i * n_rows, n_rows, 0);
+    ASSERT_OK(this->tablet()->Flush());
+  }
+
+  // Update every other row of the flushed rowsets.
+  LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+  for (int64_t key = 0; key < n_rows * kNumRowSets; key += 2) {
+    ASSERT_OK(this->UpdateTestRow(&writer, key, 1));
+  }
+  ASSERT_OK(this->tablet()->FlushAllDMSForTests());
+
+  // Small enough for every input rowset to be worth a key range of its own.
+  FLAGS_budgeted_compaction_target_rowset_size = 1024;
+
+  ASSERT_OK(this->tablet()->Compact(Tablet::FORCE_COMPACT_ALL, kNumRowSets));
+  ASSERT_EQ(n_rows * kNumRowSets, this->TabletCount());
+  NO_FATALS(this->CheckLiveRowsCount(n_rows * kNumRowSets));
+  NO_FATALS(this->VerifyTestRows(0, n_rows * kNumRowSets));
+
+  // The output rowsets of the key ranges don't overlap.
+  vector<shared_ptr<RowSet>> rowsets;
+  this->tablet()->GetRowSetsForTests(&rowsets);
+  ASSERT_GT(rowsets.size(), 1);
+  vector<std::pair<string, string>> bounds;
+  for (const auto& rs : rowsets) {
+    string min_key;
+    string max_key;
+    ASSERT_OK(rs->GetBounds(&min_key, &max_key));
+    bounds.emplace_back(std::move(min_key), std::move(max_key));
+  }
+  std::sort(bounds.begin(), bounds.end());
+  for (size_t i = 1; i < bounds.size(); i++) {
+    ASSERT_LT(bounds[i - 1].second, bounds[i].first);
+  }
+}
+
 TYPED_TEST(TestTablet, TestCountLiveRowsAfterShutdown) {
   // Insert 1000 rows into memrowset
   uint64_t max_rows = this->ClampRowCount(FLAGS_testflush_num_inserts);
@@ -1731,5 +1853,120 @@ TYPED_TEST(TestTablet, TestDiffScanUnobservableOperations) {
   NO_FATALS(diff_scan_no_rows());
 }
 
+// Produces rows of the IntKeyTestSetup<INT32> schema with the given keys, in
+// the given order, using each key as 'key_idx' as well.
+class KeysIterator : public RowwiseIterator {
+ public:
+  KeysIterator(const Schema& schema, vector<int32_t> keys, int32_t val)
+      : schema_(schema),
+        keys_(std::move(keys)),
+        val_(val),
+        idx_(0) {
+  }
+
+  Status Init(ScanSpec* /*spec*/) override {
+    return Status::OK();
+  }
+
+  bool HasNext() const override {
+    return idx_ < keys_.size();
+  }
+
+  Status NextBlock(RowBlock* dst) override {
+    const size_t nrows = std::min(dst->row_capacity(), keys_.size() - idx_);
+    dst->Resize(nrows);
+    dst->selection_vector()->SetAllTrue();
+    for (size_t i = 0; i < nrows; ++i, ++idx_) {
+      const RowBlockRow row = dst->row(i);
+      *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(0)) = keys_[idx_];
+      *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(1)) = keys_[idx_];
+      *reinterpret_cast<int32_t*>(row.mutable_cell_ptr(2)) = val_;
+    }
+    return Status::OK();
+  }
+
+  string ToString() const override {
+    return "KeysIterator";
+  }
+
+  const Schema& schema() const override {
+    return schema_;
+  }
+
+  void GetIteratorStats(vector<IteratorStats>* stats) const override {
+    stats->resize(schema_.num_columns());
+  }
+
+ private:
+  const Schema schema_;
+  const vector<int32_t> keys_;
+  const int32_t val_;
+  size_t idx_;
+};
+
+class TestTabletIngest : public TestTablet<IntKeyTestSetup<INT32>> {
+ public:
+  Status Ingest(vector<int32_t> keys, int64_t* rows_ingested = nullptr) {
+    KeysIterator iter(*this->tablet()->schema(), std::move(keys), 7);
+    return this->tablet()->IngestSortedRows(&iter, rows_ingested);
+  }
+};
+
+// Test ingesting sorted rows directly into new DiskRowSets.
+TEST_F(TestTabletIngest, TestIngestSortedRows) {
+  // Odd keys are used so that IntKeyTestSetup<INT32> maps the key index
+  // of the rows written by the test utilities to the same keys.
+  vector<int32_t> keys;
+  for (int32_t k = 1; k < 2000; k += 2) {
+    keys.push_back(k);
+  }
+  int64_t rows_ingested = 0;
+  ASSERT_OK(Ingest(keys, &rows_ingested));
+  ASSERT_EQ(keys.size(), rows_ingested);
+  ASSERT_EQ(1, this->tablet()->num_rowsets());
+  NO_FATALS(this->CheckLiveRowsCount(keys.size()));
+
+  vector<string> rows;
+  ASSERT_OK(this->IterateToStringList(&rows));
+  ASSERT_EQ(keys.size(), rows.size());
+  ASSERT_EQ(this->setup_.FormatDebugRow(1, 7, false), rows.front());
+  ASSERT_EQ(this->setup_.FormatDebugRow(1999, 7, false), rows.back());
+
+  // The ingested rows are visible to regular writes.
+  {
+    LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+    KuduPartialRow row(&this->client_schema_);
+    this->setup_.BuildRow(&row, 1);
+    Status s = writer.Insert(row);
+    ASSERT_TRUE(s.IsAlreadyPresent()) << s.ToString();
+  }
+
+  // Unsorted input and key ranges overlapping an existing rowset are rejected.
+  Status s = Ingest({ 4001, 4001 });
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "ascending key order");
+  s = Ingest({ 0, 3001 });
+  ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "overlaps 1 rowsets");
+  ASSERT_EQ(1, this->tablet()->num_rowsets());
+
+  // A non-overlapping key range is attached alongside the existing rowset.
+  ASSERT_OK(Ingest({ 3001, 3003 }));
+  ASSERT_EQ(2, this->tablet()->num_rowsets());
+
+  // Rows in the MemRowSet may overlap the ingested range, so ingesting is
+  // refused until they're flushed.
+  this->InsertTestRows(2, 1, 0);
+  s = Ingest({ 5001 });
+  ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+  ASSERT_OK(this->tablet()->Flush());
+  ASSERT_OK(Ingest({ 5001 }));
+  NO_FATALS(this->CheckLiveRowsCount(keys.size() + 4));
+
+  // The ingested rowsets survive a restart of the tablet.
+  ASSERT_OK(this->harness_->Open());
+  NO_FATALS(this->CheckLiveRowsCount(keys.size() + 4));
+}
+
 } // namespace tablet
 } // namespace kudu
@@ -18,9 +18,10 @@
 #include "kudu/tablet/tablet.h"
 
 #include <algorithm>
+#include <cstring>
 #include <ctime>
 #include <functional>
-#include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -37,12 +38,14 @@
 #include <glog/logging.h>
 #include <google/protobuf/arena.h>
 
+#include "kudu/cfile/block_cache.h"
 #include "kudu/clock/clock.h"
 #include "kudu/clock/hybrid_clock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/generic_iterators.h"
 #include "kudu/common/iterator.h"
+#include "kudu/common/key_range.h"
 #include "kudu/common/partition.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
@@ -54,9 +57,11 @@
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
+#include "kudu/common/types.h"
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/fs/block_manager.h"
+#include "kudu/fs/data_dirs.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/fs/io_context.h"
 #include "kudu/gutil/casts.h"
@@ -69,11 +74,15 @@
 #include "kudu/tablet/delta_tracker.h"
 #include "kudu/tablet/diskrowset.h"
 #include "kudu/tablet/memrowset.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/ops/alter_schema_op.h"
 #include "kudu/tablet/ops/participant_op.h"
 #include "kudu/tablet/ops/write_op.h"
+#include "kudu/tablet/row_cache.h"
 #include "kudu/tablet/row_op.h"
+#include "kudu/tablet/rowset_checksum_cache.h"
 #include "kudu/tablet/rowset_info.h"
+#include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/rowset_tree.h"
 #include "kudu/tablet/svg_dump.h"
 #include "kudu/tablet/tablet.pb.h"
@@ -84,6 +93,7 @@
 #include "kudu/tserver/tserver_admin.pb.h"
 #include "kudu/util/bitmap.h"
 #include "kudu/util/bloom_filter.h"
+#include "kudu/util/coding.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/fault_injection.h"
@@ -95,9 +105,12 @@
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/process_memory.h"
+#include "kudu/util/random.h"
+#include "kudu/util/random_util.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status_callback.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/throttler.h"
 #include "kudu/util/trace.h"
 #include "kudu/util/url-coding.h"
@@ -227,6 +240,38 @@ DEFINE_bool(enable_gc_deleted_rowsets_without_live_row_count, false,
             "cluster, just ignore this flag.");
 TAG_FLAG(enable_gc_deleted_rowsets_without_live_row_count, advanced);
 
+DEFINE_int32(tablet_parallel_scan_max_rowsets, 1,
+             "The maximum number of rowsets an unordered scan of a tablet "
+             "materializes concurrently. If greater than 1, the rowsets of "
+             "unordered scans are materialized on the tablet server's parallel "
+             "scan thread pool, and the rows are returned in no particular order "
+             "across rowsets.");
+TAG_FLAG(tablet_parallel_scan_max_rowsets, experimental);
+TAG_FLAG(tablet_parallel_scan_max_rowsets, runtime);
+
+DEFINE_int32(tablet_parallel_scan_max_buffered_blocks, 16,
+             "The maximum number of blocks of rows materialized ahead of the "
+             "consumer by a parallel scan of a tablet. Only relevant if "
+             "--tablet_parallel_scan_max_rowsets is greater than 1.");
+TAG_FLAG(tablet_parallel_scan_max_buffered_blocks, experimental);
+TAG_FLAG(tablet_parallel_scan_max_buffered_blocks, runtime);
+
+DEFINE_int32(tablet_hot_key_sampling_rate, 64,
+             "One in this many row operations and scans of a tablet has its primary "
+             "key, or the start key of the scan, sampled to track the most accessed "
+             "keys and key ranges of the tablet. These are shown on the tablet's page "
+             "of the web UI and in the diagnostics log. If 0, no keys are sampled.");
+TAG_FLAG(tablet_hot_key_sampling_rate, experimental);
+TAG_FLAG(tablet_hot_key_sampling_rate, runtime);
+
+DEFINE_int32(tablet_hot_key_range_prefix_bytes, 4,
+             "The length of the prefix of the encoded primary keys which identifies "
+             "the key ranges tracked along with the most accessed keys of a tablet. "
+             "See --tablet_hot_key_sampling_rate.");
+TAG_FLAG(tablet_hot_key_range_prefix_bytes, experimental);
+DEFINE_validator(tablet_hot_key_range_prefix_bytes,
+                 [](const char* /*flagname*/, int32_t value) { return value > 0; });
+
 DECLARE_bool(enable_undo_delta_block_gc);
 DECLARE_uint32(rowset_compaction_estimate_min_deltas_size_mb);
 
@@ -255,11 +300,26 @@ METRIC_DEFINE_gauge_uint64(tablet, last_write_elapsed_time, "Seconds Since Last
                            "tablet, or since this Tablet object was created on current tserver if "
                            "it hasn't been written to since then.",
                            kudu::MetricLevel::kDebug);
+METRIC_DEFINE_gauge_uint64(tablet, hottest_key_access_permille,
+                           "Hottest Key Access Share",
+                           kudu::MetricUnit::kUnits,
+                           "The share, in parts per thousand, of the recent sampled row "
+                           "operations and scans of this tablet which accessed its most "
+                           "accessed primary key. See --tablet_hot_key_sampling_rate.",
+                           kudu::MetricLevel::kDebug);
+METRIC_DEFINE_gauge_uint64(tablet, hottest_key_range_access_permille,
+                           "Hottest Key Range Access Share",
+                           kudu::MetricUnit::kUnits,
+                           "The share, in parts per thousand, of the recent sampled row "
+                           "operations and scans of this tablet which accessed its most "
+                           "accessed key range. See --tablet_hot_key_range_prefix_bytes.",
+                           kudu::MetricLevel::kDebug);
 
 using kudu::MaintenanceManager;
 using kudu::clock::HybridClock;
 using kudu::consensus::OpId;
 using kudu::fs::IOContext;
+using kudu::fs::IOPriority;
 using kudu::log::LogAnchorRegistry;
 using kudu::log::MinLogIndexAnchorer;
 using std::endl;
@@ -348,6 +408,8 @@ Tablet::Tablet(scoped_refptr<TabletMetadata> metadata,
       state_(kInitialized),
       last_read_time_(MonoTime::Now()),
       last_write_time_(last_read_time_),
+      hot_keys_(kNumHotKeys, kHotKeyDecayWindow, 4, 512),
+      hot_key_ranges_(kNumHotKeys, kHotKeyDecayWindow, 4, 512),
       last_update_workload_stats_time_(last_read_time_),
       last_scans_started_(0),
       last_rows_mutated_(0),
@@ -380,6 +442,14 @@ Tablet::Tablet(scoped_refptr<TabletMetadata> metadata,
         metric_entity_, [this]() { return this->LastWriteElapsedSeconds(); },
         MergeType::kMin)
         ->AutoDetach(&metric_detacher_);
+    METRIC_hottest_key_access_permille.InstantiateFunctionGauge(
+        metric_entity_, [this]() { return this->hot_keys_.HottestKeyPermille(); },
+        MergeType::kMax)
+        ->AutoDetach(&metric_detacher_);
+    METRIC_hottest_key_range_access_permille.InstantiateFunctionGauge(
+        metric_entity_, [this]() { return this->hot_key_ranges_.HottestKeyPermille(); },
+        MergeType::kMax)
+        ->AutoDetach(&metric_detacher_);
   }
 
   compaction_policy_.reset(new BudgetedCompactionPolicy(
@@ -391,6 +461,10 @@ Tablet::Tablet(scoped_refptr<TabletMetadata> metadata,
                                    FLAGS_tablet_throttler_bytes_per_sec,
                                    FLAGS_tablet_throttler_burst_factor));
   }
+
+  if (RowCache* row_cache = RowCache::GetSingleton()) {
+    row_cache_.reset(new TabletRowCache(row_cache, tablet_id()));
+  }
 }
 
 Tablet::~Tablet() {
@@ -422,7 +496,11 @@ Status Tablet::Open(const unordered_set<int64_t>& in_flight_txn_ids,
     txn_participant_.CreateOpenTransaction(txn_id, log_anchor_registry_.get());
   }
 
-  fs::IOContext io_context({ tablet_id() });
+  // Let the blocks of the tablet go to the partition of the block cache
+  // reserved for its table, if any.
+  cfile::BlockCache::GetSingleton()->RegisterTablet(tablet_id(), metadata_->table_id());
+
+  fs::IOContext io_context({ tablet_id(), io_metrics() });
   // open the tablet row-sets
   RowSetVector rowsets_opened;
   rowsets_opened.reserve(metadata_->rowsets().size());
@@ -441,12 +519,18 @@ Status Tablet::Open(const unordered_set<int64_t>& in_flight_txn_ids,
     rowsets_opened.emplace_back(std::move(rowset));
   }
 
-  // Update the auto incrementing counter of the tablet from the data directories
+  // Update the auto incrementing counter of the tablet from the metadata or,
+  // if the metadata predates the counter being persisted, from the data
+  // directories.
   if (schema()->has_auto_incrementing()) {
-    Status s = UpdateAutoIncrementingCounter(rowsets_opened);
-    if (!s.ok()) {
-      LOG_WITH_PREFIX(ERROR) << "Failed to update auto incrementing counter" << s.ToString();
-      return s;
+    if (const auto counter = metadata_->auto_incrementing_counter(); counter) {
+      SetAutoIncrementingCounter(*counter);
+    } else {
+      Status s = UpdateAutoIncrementingCounter(rowsets_opened);
+      if (!s.ok()) {
+        LOG_WITH_PREFIX(ERROR) << "Failed to update auto incrementing counter" << s.ToString();
+        return s;
+      }
     }
   }
 
@@ -499,6 +583,7 @@ Status Tablet::Open(const unordered_set<int64_t>& in_flight_txn_ids,
 }
 
 Status Tablet::UpdateAutoIncrementingCounter(const RowSetVector& rowsets_opened) {
+  int64_t max_counter = GetAutoIncrementingCounter();
   LOG_TIMING(INFO, "fetching auto increment counter") {
     for (const shared_ptr<RowSet>& rowset: rowsets_opened) {
       RowIteratorOptions opts;
@@ -521,13 +606,12 @@ Status Tablet::UpdateAutoIncrementingCounter(const RowSetVector& rowsets_opened)
           }
           int64 counter = *reinterpret_cast<const int64 *>(block.row(i).cell_ptr(
               schema()->auto_incrementing_col_idx()));
-          if (counter > auto_incrementing_counter_) {
-            auto_incrementing_counter_ = counter;
-          }
+          max_counter = std::max(max_counter, counter);
         }
       }
     }
   }
+  SetAutoIncrementingCounter(max_counter);
   return Status::OK();
 }
 
@@ -662,11 +746,14 @@ Status Tablet::DecodeWriteOperations(const Schema* client_schema,
 
   SchemaPtr schema_ptr = schema();
   // Decode the ops
-  RowOperationsPBDecoder dec(&op_state->request()->row_operations(),
+  RowOperationsPBDecoder dec(op_state->rows(),
+                             op_state->indirect_data(),
                              client_schema,
                              schema_ptr.get(),
                              op_state->arena());
-  RETURN_NOT_OK(dec.DecodeOperations<DecoderMode::WRITE_OPS>(&ops, &auto_incrementing_counter_));
+  int64_t auto_incrementing_counter = GetAutoIncrementingCounter();
+  RETURN_NOT_OK(dec.DecodeOperations<DecoderMode::WRITE_OPS>(&ops, &auto_incrementing_counter));
+  SetAutoIncrementingCounter(auto_incrementing_counter);
   TRACE_COUNTER_INCREMENT("num_ops", ops.size());
 
   // Important to set the schema before the ops -- we need the
@@ -681,13 +768,15 @@ Status Tablet::AcquireRowLocks(WriteOpState* op_state) {
   TRACE_EVENT1("tablet", "Tablet::AcquireRowLocks",
                "num_locks", op_state->row_ops().size());
   TRACE("Acquiring locks for $0 operations", op_state->row_ops().size());
+  TRACE_SPAN("acquire_row_locks");
 
+  Arena* arena = op_state->arena();
+  EncodedKeyBuilder key_builder(&key_schema_, arena);
   for (RowOp* op : op_state->row_ops()) {
     if (op->has_result()) continue;
 
     ConstContiguousRow row_key(&key_schema_, op->decoded_op.row_data);
-    Arena* arena = op_state->arena();
-    op->key_probe = arena->NewObject<RowSetKeyProbe>(row_key, arena);
+    op->key_probe = arena->NewObject<RowSetKeyProbe>(row_key, &key_builder);
     if (PREDICT_FALSE(!ValidateOpOrMarkFailed(op))) {
       continue;
     }
@@ -1233,6 +1322,8 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteOpState* op_s
   // 'pending_group' and then calls 'ProcessPendingGroup' when the next group
   // begins.
   vector<pair<RowSet*, int>> pending_group;
+  vector<KeyPresenceProbe> probes;
+  vector<RowOp*> probe_ops;
   Status s;
   const auto& ProcessPendingGroup = [&]() {
     if (pending_group.empty() || !s.ok()) return;
@@ -1244,6 +1335,8 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteOpState* op_s
                             return keys[a.second] < keys[b.second];
                           }));
     RowSet* rs = pending_group[0].first;
+    probes.clear();
+    probe_ops.clear();
     for (auto it = pending_group.begin(); it != pending_group.end(); ++it) {
       DCHECK_EQ(it->first, rs) << "All results within a group should be for the same RowSet";
       int op_idx = keys_and_indexes[it->second].second;
@@ -1252,22 +1345,26 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteOpState* op_s
         // Already found this op present somewhere.
         continue;
       }
+      probes.push_back({ op->key_probe, op_state->mutable_op_stats(op_idx), false });
+      probe_ops.push_back(op);
+    }
+    pending_group.clear();
 
-      bool present = false;
-      s = rs->CheckRowPresent(*op->key_probe, io_context,
-                              &present, op_state->mutable_op_stats(op_idx));
-      if (PREDICT_FALSE(!s.ok())) {
-        LOG(WARNING) << Substitute("Tablet $0 failed to check row presence for op $1: $2",
-            tablet_id(), op->ToString(key_schema_), s.ToString());
-        return;
-      }
-      if (present) {
-        op->present_in_rowset = rs;
+    // Check the keys of the group in one batch, so that the rowset can share
+    // the lookups of its key index between them.
+    s = rs->CheckRowsPresent(probes, io_context);
+    if (PREDICT_FALSE(!s.ok())) {
+      LOG(WARNING) << Substitute("Tablet $0 failed to check row presence for $1 ops: $2",
+          tablet_id(), probes.size(), s.ToString());
+      return;
+    }
+    for (int i = 0; i < probes.size(); i++) {
+      if (probes[i].present) {
+        probe_ops[i]->present_in_rowset = rs;
       }
     }
-    pending_group.clear();
   };
-  comps->rowsets->ForEachRowSetContainingKeys(
+  const int num_keys_above_rowsets = comps->rowsets->ForEachRowSetContainingKeys(
       keys,
       [&](RowSet* rs, int i) {
         if (!pending_group.empty() && rs != pending_group.back().first) {
@@ -1278,6 +1375,9 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteOpState* op_s
   // Process the last group.
   ProcessPendingGroup();
   RETURN_NOT_OK_PREPEND(s, "Error while checking presence of rows");
+  if (metrics_ && num_keys_above_rowsets > 0) {
+    metrics_->presence_checks_skipped_above_rowsets->IncrementBy(num_keys_above_rowsets);
+  }
 
   // Mark all of the ops as having been checked.
   // TODO(todd): this could potentially be weaved into the std::unique() call up
@@ -1288,6 +1388,10 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteOpState* op_s
   return Status::OK();
 }
 
+const fs::IOMetrics* Tablet::io_metrics() const {
+  return metrics_ ? &metrics_->io_metrics : nullptr;
+}
+
 bool Tablet::HasBeenStopped() const {
   State s = state_.load();
   return s == kStopped || s == kShutdown;
@@ -1332,6 +1436,11 @@ void Tablet::CommitTransaction(Txn* txn, Timestamp commit_ts, const OpId& op_id)
   metadata_->AddCommitTimestamp(txn_id, commit_ts, std::move(anchor));
   CommitTxnRowSets(txn_id);
   txn->FinalizeCommit(commit_ts.value());
+
+  // The rows of the transaction are now visible.
+  if (row_cache_) {
+    row_cache_->InvalidateAll();
+  }
 }
 
 void Tablet::CommitTxnRowSets(int64_t txn_id) {
@@ -1363,7 +1472,7 @@ Status Tablet::ApplyRowOperations(WriteOpState* op_state) {
   StartApplying(op_state);
 
   TRACE("starting BulkCheckPresence");
-  IOContext io_context({ tablet_id() });
+  IOContext io_context({ tablet_id(), io_metrics() });
   RETURN_NOT_OK(BulkCheckPresence(&io_context, op_state));
   TRACE("finished BulkCheckPresence");
 
@@ -1398,6 +1507,7 @@ Status Tablet::ApplyRowOperation(const IOContext* io_context,
   if (!ValidateOpOrMarkFailed(row_op)) {
     return Status::OK();
   }
+  SampleKeyAccess(row_op->key_probe->encoded_key_slice());
 
   {
     State s;
@@ -1427,6 +1537,10 @@ Status Tablet::ApplyRowOperation(const IOContext* io_context,
     row_op->checked_present = true;
   }
 
+  if (row_cache_) {
+    row_cache_->Invalidate(row_op->key_probe->encoded_key_slice());
+  }
+
   Status s;
   switch (row_op->decoded_op.type) {
     case RowOperationsPB::INSERT:
@@ -1459,36 +1573,7 @@ void Tablet::ModifyRowSetTree(const RowSetTree& old_tree,
                               const RowSetVector& rowsets_to_remove,
                               const RowSetVector& rowsets_to_add,
                               RowSetTree* new_tree) {
-  RowSetVector post_swap;
-
-  // O(n^2) diff algorithm to collect the set of rowsets excluding
-  // the rowsets that were included in the compaction
-  int num_removed = 0;
-
-  for (const shared_ptr<RowSet> &rs : old_tree.all_rowsets()) {
-    // Determine if it should be removed
-    bool should_remove = false;
-    for (const shared_ptr<RowSet> &to_remove : rowsets_to_remove) {
-      if (to_remove == rs) {
-        should_remove = true;
-        num_removed++;
-        break;
-      }
-    }
-    if (!should_remove) {
-      post_swap.push_back(rs);
-    }
-  }
-
-  CHECK_EQ(num_removed, rowsets_to_remove.size());
-
-  // Then push the new rowsets on the end of the new list
-  std::copy(rowsets_to_add.begin(),
-            rowsets_to_add.end(),
-            std::back_inserter(post_swap));
-
-
-  CHECK_OK(new_tree->Reset(post_swap));
+  CHECK_OK(new_tree->ResetFromTree(old_tree, rowsets_to_remove, rowsets_to_add));
 }
 
 void Tablet::AtomicSwapRowSets(const RowSetVector &to_remove,
@@ -1554,6 +1639,57 @@ HistoryGcOpts Tablet::GetHistoryGcOpts() const {
   return HistoryGcOpts::Disabled();
 }
 
+HistoryGcOpts Tablet::GetHistoryGcOptsWithRowTtl(const Schema& schema) const {
+  int row_ttl_col_idx;
+  int64_t row_ttl_cutoff_micros;
+  if (GetRowTtlCutoff(*metadata_, schema, clock_, &row_ttl_col_idx, &row_ttl_cutoff_micros)) {
+    return GetHistoryGcOpts().WithRowTtl(row_ttl_col_idx, row_ttl_cutoff_micros);
+  }
+  return GetHistoryGcOpts();
+}
+
+bool Tablet::GetRowTtl(const TabletMetadata& metadata,
+                       const Schema& schema,
+                       clock::Clock* clock,
+                       int* col_idx,
+                       int64_t* ttl_sec) {
+  const auto& extra_config = metadata.extra_config();
+  if (!extra_config || !extra_config->has_row_ttl_column() ||
+      !extra_config->has_row_ttl_sec() || !clock->HasPhysicalComponent()) {
+    return false;
+  }
+  const int idx = schema.find_column(extra_config->row_ttl_column());
+  if (idx == Schema::kColumnNotFound || !schema.is_key_column(idx)) {
+    return false;
+  }
+  const DataType type = schema.column(idx).type_info()->type();
+  if (type != UNIXTIME_MICROS && type != INT64) {
+    return false;
+  }
+  *col_idx = idx;
+  // Clamp the TTL so that the cutoff doesn't overflow.
+  *ttl_sec = std::min<int64_t>(extra_config->row_ttl_sec(),
+                               std::numeric_limits<int64_t>::max() / 1000000 - 1);
+  return true;
+}
+
+int64_t Tablet::GetRowTtlCutoffMicros(const Timestamp& timestamp, int64_t ttl_sec) {
+  return HybridClock::GetPhysicalValueMicros(timestamp) - ttl_sec * 1000000;
+}
+
+bool Tablet::GetRowTtlCutoff(const TabletMetadata& metadata,
+                             const Schema& schema,
+                             clock::Clock* clock,
+                             int* col_idx,
+                             int64_t* cutoff_micros) {
+  int64_t ttl_sec;
+  if (!GetRowTtl(metadata, schema, clock, col_idx, &ttl_sec)) {
+    return false;
+  }
+  *cutoff_micros = GetRowTtlCutoffMicros(clock->Now(), ttl_sec);
+  return true;
+}
+
 Status Tablet::Flush() {
   TRACE_EVENT1("tablet", "Tablet::Flush", "id", tablet_id());
   std::lock_guard<Semaphore> lock(rowsets_flush_sem_);
@@ -1740,6 +1876,10 @@ Status Tablet::AlterSchema(AlterSchemaOpState* op_state) {
     return metadata_->Flush();
   }
 
+  // The cached rows may lack the new columns or their new defaults.
+  if (row_cache_) {
+    row_cache_->InvalidateAll();
+  }
   return FlushUnlocked();
 }
 
@@ -1771,6 +1911,21 @@ Status Tablet::RewindSchemaForBootstrap(const Schema& new_schema,
   return Status::OK();
 }
 
+void Tablet::SampleKeyAccess(Slice encoded_key) const {
+  const int32_t rate = FLAGS_tablet_hot_key_sampling_rate;
+  if (rate <= 0) {
+    return;
+  }
+  static thread_local Random rng(GetRandomSeed32());
+  if (!rng.OneIn(rate)) {
+    return;
+  }
+  hot_keys_.Add(encoded_key);
+  hot_key_ranges_.Add(Slice(encoded_key.data(),
+                            std::min<size_t>(encoded_key.size(),
+                                             FLAGS_tablet_hot_key_range_prefix_bytes)));
+}
+
 void Tablet::SetCompactionHooksForTests(
   const shared_ptr<Tablet::CompactionFaultHooks> &hooks) {
   compaction_hooks_ = hooks;
@@ -1942,6 +2097,11 @@ void Tablet::RegisterMaintenanceOps(MaintenanceManager* maint_mgr) {
     maint_mgr->RegisterOp(maintenance_ops.back().get());
   }
 
+  if (metadata_->fs_manager()->dd_manager()->has_cold_tier()) {
+    maintenance_ops.emplace_back(new MoveColdRowSetsOp(this));
+    maint_mgr->RegisterOp(maintenance_ops.back().get());
+  }
+
   std::lock_guard<simple_spinlock> l(state_lock_);
   maintenance_ops_ = std::move(maintenance_ops);
 }
@@ -1990,6 +2150,12 @@ Status Tablet::FlushMetadata(const RowSetVector& to_remove,
     to_remove_meta.insert(rowset->metadata()->id());
   }
 
+  // The rows of the rowsets being added were all decoded before this point, so
+  // the current value of the counter is at least theirs.
+  if (schema()->has_auto_incrementing()) {
+    metadata_->UpdateAutoIncrementingCounter(GetAutoIncrementingCounter());
+  }
+
   return metadata_->UpdateAndFlush(to_remove_meta, to_add, mrs_being_flushed,
                                    txns_being_flushed);
 }
@@ -2009,7 +2175,9 @@ size_t Tablet::GetAllDeltasSizeOnDisk(const RowSetsInCompactionOrFlush &input) {
 
 Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
                                         int64_t mrs_being_flushed,
-                                        const vector<TxnInfoBeingFlushed>& txns_being_flushed) {
+                                        const vector<TxnInfoBeingFlushed>& txns_being_flushed,
+                                        int max_threads,
+                                        fs::StorageTier tier) {
   const char *op_name =
         (mrs_being_flushed == TabletMetadata::kNoMrsFlushed) ? "Compaction" : "Flush";
   TRACE_EVENT2("tablet", "Tablet::DoMergeCompactionOrFlush",
@@ -2023,9 +2191,8 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
   }
 
   const auto& tid = tablet_id();
-  const IOContext io_context({ tid });
+  const IOContext io_context({ tid, io_metrics(), IOPriority::BACKGROUND });
 
-  shared_ptr<CompactionOrFlushInput> merge;
   const SchemaPtr schema_ptr = schema();
   MvccSnapshot flush_snap(mvcc_);
   VLOG_WITH_PREFIX(1) << Substitute("$0: entering phase 1 (flushing snapshot). "
@@ -2038,30 +2205,63 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
                           "PostTakeMvccSnapshot hook failed");
   }
 
+  // Get tablet history, to be used later for AHM validation checks, along
+  // with the row TTL of the table, if any.
+  HistoryGcOpts history_gc_opts = GetHistoryGcOptsWithRowTtl(*schema_ptr);
+
+  // Split the key range of a compaction into sub-ranges which are written
+  // concurrently, each with its own input and DRS writer. The rows of any key
+  // belong to a single sub-range, so the outputs of the sub-ranges, taken in
+  // key order, are sorted and don't overlap, as required by phase 2.
+  vector<string> split_keys;
+  if (mrs_being_flushed == TabletMetadata::kNoMrsFlushed && max_threads > 1) {
+    ComputeCompactionSplitKeys(input, max_threads, &split_keys);
+  }
+  const size_t num_ranges = split_keys.size() + 1;
+  Arena arena(256);
+  vector<const EncodedKey*> range_bounds(num_ranges + 1, nullptr);
+  for (size_t i = 0; i < split_keys.size(); i++) {
+    EncodedKey* key;
+    RETURN_NOT_OK(EncodedKey::DecodeEncodedString(*schema_ptr, &arena, split_keys[i], &key));
+    range_bounds[i + 1] = key;
+  }
+
   // Create input of rowsets by iterating through all rowsets and for each rowset:
   //   - For compaction ops, create input that contains initialized base,
   //     relevant REDO and UNDO delta iterators to be used read from persistent storage.
   //   - For Flush ops, create iterator for in-memory tree holding data updates.
-  RETURN_NOT_OK(input.CreateCompactionOrFlushInput(flush_snap,
-                                                   schema_ptr.get(),
-                                                   &io_context,
-                                                   &merge));
-
-  // Initializing a DRS writer, to be used later for writing REDO, UNDO deltas, delta stats, etc.
-  RollingDiskRowSetWriter drsw(metadata_.get(), merge->schema(), DefaultBloomSizing(),
-                               compaction_policy_->target_rowset_size());
-  RETURN_NOT_OK_PREPEND(drsw.Open(), "Failed to open DiskRowSet for flush");
-
-  // Get tablet history, to be used later for AHM validation checks.
-  HistoryGcOpts history_gc_opts = GetHistoryGcOpts();
-
-  // Apply REDO and UNDO deltas to the rows, merge histories of rows with 'ghost' entries.
-  RETURN_NOT_OK_PREPEND(
-      FlushCompactionInput(
-          tid, metadata_->fs_manager()->block_manager()->error_manager(),
-          merge.get(), flush_snap, history_gc_opts, &drsw),
-      "Flush to disk failed");
-  RETURN_NOT_OK_PREPEND(drsw.Finish(), "Failed to finish DRS writer");
+  // Then apply REDO and UNDO deltas to the rows, merge histories of rows with
+  // 'ghost' entries, and write them out.
+  vector<shared_ptr<CompactionOrFlushInput>> merges(num_ranges);
+  vector<unique_ptr<RollingDiskRowSetWriter>> writers(num_ranges);
+  if (num_ranges == 1) {
+    RETURN_NOT_OK(WriteCompactionOrFlushOutput(input, flush_snap, schema_ptr.get(), &io_context,
+                                               history_gc_opts, nullptr, nullptr, tier,
+                                               &merges[0], &writers[0]));
+  } else {
+    VLOG_WITH_PREFIX(1) << Substitute("$0: writing $1 key ranges concurrently",
+                                      op_name, num_ranges);
+    unique_ptr<ThreadPool> pool;
+    RETURN_NOT_OK(ThreadPoolBuilder("compaction")
+                  .set_min_threads(static_cast<int>(num_ranges))
+                  .set_max_threads(static_cast<int>(num_ranges))
+                  .Build(&pool));
+    vector<Status> range_statuses(num_ranges);
+    Status s;
+    for (size_t i = 0; i < num_ranges && s.ok(); i++) {
+      s = pool->Submit([&, i]() {
+        range_statuses[i] = WriteCompactionOrFlushOutput(
+            input, flush_snap, schema_ptr.get(), &io_context, history_gc_opts,
+            range_bounds[i], range_bounds[i + 1], tier, &merges[i], &writers[i]);
+      });
+    }
+    // The submitted tasks reference the state of this frame.
+    pool->Wait();
+    RETURN_NOT_OK(s);
+    for (const auto& range_status : range_statuses) {
+      RETURN_NOT_OK(range_status);
+    }
+  }
 
   // Fault injection hook for testing and debugging purpose only.
   if (common_hooks_) {
@@ -2069,24 +2269,37 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
                           "PostWriteSnapshot hook failed");
   }
 
+  int64_t rows_written = 0;
+  int64_t drs_written = 0;
+  uint64_t bytes_written = 0;
+  for (const auto& drsw : writers) {
+    rows_written += drsw->rows_written_count();
+    drs_written += drsw->drs_written_count();
+    bytes_written += drsw->written_size();
+  }
+
   // Though unlikely, it's possible that no rows were written because all of
   // the input rows were GCed in this compaction. In that case, we don't
   // actually want to reopen.
-  if (drsw.rows_written_count() == 0) {
+  if (rows_written == 0) {
     LOG_WITH_PREFIX(INFO) << op_name << " resulted in no output rows (all input rows "
                           << "were GCed!)  Removing all input rowsets.";
     return HandleEmptyCompactionOrFlush(input.rowsets(), mrs_being_flushed,
                                         txns_being_flushed);
   }
 
-  // The RollingDiskRowSet writer wrote out one or more RowSets as the
-  // output. Open these into 'new_rowsets'.
+  // The RollingDiskRowSet writers wrote out one or more RowSets as the
+  // output. Open these into 'new_rowsets', in key order.
   RowSetMetadataVector new_drs_metas;
-  drsw.GetWrittenRowSetMetadata(&new_drs_metas);
+  for (const auto& drsw : writers) {
+    RowSetMetadataVector range_metas;
+    drsw->GetWrittenRowSetMetadata(&range_metas);
+    new_drs_metas.insert(new_drs_metas.end(), range_metas.begin(), range_metas.end());
+  }
   CHECK(!new_drs_metas.empty());
 
   if (metrics_) {
-    metrics_->bytes_flushed->IncrementBy(drsw.written_size());
+    metrics_->bytes_flushed->IncrementBy(bytes_written);
   }
 
   // Open all the rowsets (that were processed in this stage) from disk and
@@ -2194,8 +2407,13 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
                           "PostSwapInDuplicatingRowSet hook failed");
   }
 
-  // Store the stats on the max memory used for compaction phase 1.
-  const size_t peak_mem_usage_ph1 = merge->memory_footprint();
+  // Store the stats on the max memory used for compaction phase 1, during
+  // which the inputs of all the key ranges were in use.
+  size_t peak_mem_usage_ph1 = 0;
+  for (const auto& range_merge : merges) {
+    peak_mem_usage_ph1 += range_merge->memory_footprint();
+  }
+  merges.clear();
 
   // Phase 2. Here we re-scan the compaction input, copying those missed updates into the
   // new rowset's DeltaTracker.
@@ -2203,6 +2421,7 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
                                     "which arrived during Phase 1. Snapshot: $1",
                                     op_name, non_duplicated_ops_snap.ToString());
   const SchemaPtr schema_ptr2 = schema();
+  shared_ptr<CompactionOrFlushInput> merge;
   RETURN_NOT_OK_PREPEND(input.CreateCompactionOrFlushInput(non_duplicated_ops_snap,
                                                            schema_ptr2.get(),
                                                            &io_context,
@@ -2280,9 +2499,6 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
     }
   }
 
-  const auto rows_written = drsw.rows_written_count();
-  const auto drs_written = drsw.drs_written_count();
-  const auto bytes_written = drsw.written_size();
   TRACE_COUNTER_INCREMENT("rows_written", rows_written);
   TRACE_COUNTER_INCREMENT("drs_written", drs_written);
   TRACE_COUNTER_INCREMENT("bytes_written", bytes_written);
@@ -2302,6 +2518,68 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
   return Status::OK();
 }
 
+void Tablet::ComputeCompactionSplitKeys(const RowSetsInCompactionOrFlush& input,
+                                        int max_ranges,
+                                        vector<string>* split_keys) const {
+  split_keys->clear();
+  uint64_t total_size = 0;
+  for (const auto& rs : input.rowsets()) {
+    total_size += rs->OnDiskBaseDataSizeWithRedos();
+  }
+  const uint64_t target_rowset_size = std::max<uint64_t>(
+      1, compaction_policy_->target_rowset_size());
+  const uint64_t num_ranges = std::min<uint64_t>(max_ranges, total_size / target_rowset_size);
+  if (num_ranges <= 1) {
+    return;
+  }
+
+  RowSetTree tree;
+  Status s = tree.Reset(input.rowsets());
+  if (PREDICT_FALSE(!s.ok())) {
+    LOG_WITH_PREFIX(WARNING) << "Unable to split the key range of a compaction: "
+                             << s.ToString();
+    return;
+  }
+  vector<KeyRange> ranges;
+  RowSetInfo::SplitKeyRange(tree, Slice(), Slice(), {}, total_size / num_ranges, &ranges);
+  // Rounding may yield one range too many, in which case the last range
+  // absorbs it.
+  for (size_t i = 1; i < std::min<size_t>(ranges.size(), num_ranges); i++) {
+    split_keys->emplace_back(ranges[i].start_primary_key());
+  }
+}
+
+Status Tablet::WriteCompactionOrFlushOutput(const RowSetsInCompactionOrFlush& input,
+                                            const MvccSnapshot& snap,
+                                            const Schema* schema,
+                                            const IOContext* io_context,
+                                            const HistoryGcOpts& history_gc_opts,
+                                            const EncodedKey* lower_bound,
+                                            const EncodedKey* exclusive_upper_bound,
+                                            fs::StorageTier tier,
+                                            shared_ptr<CompactionOrFlushInput>* merge,
+                                            unique_ptr<RollingDiskRowSetWriter>* drsw) {
+  RETURN_NOT_OK(input.CreateCompactionOrFlushInput(snap, schema, io_context,
+                                                   lower_bound, exclusive_upper_bound,
+                                                   merge));
+
+  // Initializing a DRS writer, to be used later for writing REDO, UNDO deltas, delta stats, etc.
+  drsw->reset(new RollingDiskRowSetWriter(metadata_.get(), (*merge)->schema(),
+                                          DefaultBloomSizing(),
+                                          compaction_policy_->target_rowset_size(),
+                                          tier));
+  RETURN_NOT_OK_PREPEND((*drsw)->Open(), "Failed to open DiskRowSet for flush");
+
+  // Apply REDO and UNDO deltas to the rows, merge histories of rows with 'ghost' entries.
+  RETURN_NOT_OK_PREPEND(
+      FlushCompactionInput(
+          tablet_id(), metadata_->fs_manager()->block_manager()->error_manager(),
+          merge->get(), snap, history_gc_opts, drsw->get()),
+      "Flush to disk failed");
+  RETURN_NOT_OK_PREPEND((*drsw)->Finish(), "Failed to finish DRS writer");
+  return Status::OK();
+}
+
 Status Tablet::HandleEmptyCompactionOrFlush(const RowSetVector& rowsets,
                                             int mrs_being_flushed,
                                             const vector<TxnInfoBeingFlushed>& txns_being_flushed) {
@@ -2317,6 +2595,145 @@ Status Tablet::HandleEmptyCompactionOrFlush(const RowSetVector& rowsets,
   return Status::OK();
 }
 
+Status Tablet::IngestSortedRows(RowwiseIterator* iter, int64_t* rows_ingested) {
+  TRACE_EVENT1("tablet", "Tablet::IngestSortedRows", "id", tablet_id());
+  RETURN_NOT_OK(CheckHasNotBeenStopped());
+  const SchemaPtr schema_ptr = schema();
+  const Schema& schema = *schema_ptr;
+  if (PREDICT_FALSE(!(iter->schema() == schema))) {
+    return Status::InvalidArgument(Substitute(
+        "schema of the ingested rows $0 doesn't match the tablet schema $1",
+        iter->schema().ToString(), schema.ToString()));
+  }
+
+  const IOContext io_context({ tablet_id(), io_metrics() });
+  RollingDiskRowSetWriter drsw(metadata_.get(), schema, DefaultBloomSizing(),
+                               compaction_policy_->target_rowset_size());
+  RETURN_NOT_OK_PREPEND(drsw.Open(), "Failed to open DiskRowSet for ingestion");
+
+  // The first and the last keys of the ingested rows, used to make sure
+  // the input is sorted and to check for overlaps with the existing rowsets.
+  faststring min_key;
+  faststring max_key;
+  faststring cur_key;
+  faststring row_buf(ContiguousRowHelper::row_size(schema));
+  ContiguousRow contiguous_row(&schema, row_buf.data());
+  RowBlockMemory mem;
+  RowBlock block(&iter->schema(), 512, &mem);
+  while (iter->HasNext()) {
+    mem.Reset();
+    RETURN_NOT_OK(iter->NextBlock(&block));
+    const size_t nrows = block.nrows();
+    if (PREDICT_FALSE(block.selection_vector()->CountSelected() != nrows)) {
+      return Status::InvalidArgument("the ingested rows must not be filtered");
+    }
+    for (size_t i = 0; i < nrows; ++i) {
+      const RowBlockRow row = block.row(i);
+      schema.EncodeComparableKey(row, &cur_key);
+      if (PREDICT_FALSE(!max_key.empty() && Slice(cur_key).compare(Slice(max_key)) <= 0)) {
+        return Status::InvalidArgument(Substitute(
+            "the ingested rows must be in strictly ascending key order: $0",
+            schema.DebugRowKey(row)));
+      }
+      // The partition check needs a row-wise representation of the row. The
+      // indirect data isn't relocated: the copy doesn't outlive the block.
+      RETURN_NOT_OK(CopyRow(row, &contiguous_row, static_cast<Arena*>(nullptr)));
+      RETURN_NOT_OK(CheckRowInTablet(ConstContiguousRow(contiguous_row)));
+      if (min_key.empty()) {
+        min_key.assign_copy(cur_key.data(), cur_key.size());
+      }
+      max_key.assign_copy(cur_key.data(), cur_key.size());
+    }
+    RETURN_NOT_OK(drsw.AppendBlock(block, static_cast<int>(nrows)));
+    RETURN_NOT_OK(drsw.RollIfNecessary());
+  }
+  RETURN_NOT_OK_PREPEND(drsw.Finish(), "Failed to finish DRS writer");
+  if (rows_ingested) {
+    *rows_ingested = drsw.rows_written_count();
+  }
+  if (drsw.rows_written_count() == 0) {
+    return Status::OK();
+  }
+
+  // The rowsets overlapping the ingested key range. 'max_key' followed by a
+  // zero byte is the smallest key greater than 'max_key', which makes the
+  // upper bound of the interval exclusive as required.
+  max_key.push_back('\0');
+  const auto check_no_overlap = [&]() {
+    if (!components_->memrowset->empty()) {
+      return Status::IllegalState("the MemRowSet of the tablet isn't empty");
+    }
+    for (const auto& txn_mrs : components_->txn_memrowsets) {
+      if (!txn_mrs->empty()) {
+        return Status::IllegalState("the MemRowSet of a transaction isn't empty");
+      }
+    }
+    for (const auto& [txn_id, txn_rowsets] : uncommitted_rowsets_by_txn_id_) {
+      if (!txn_rowsets->memrowset->empty()) {
+        return Status::IllegalState(Substitute(
+            "the MemRowSet of uncommitted transaction $0 isn't empty", txn_id));
+      }
+    }
+    vector<RowSet*> overlapping;
+    components_->rowsets->FindRowSetsIntersectingInterval(
+        Slice(min_key), Slice(max_key), &overlapping);
+    if (!overlapping.empty()) {
+      return Status::IllegalState(Substitute(
+          "the ingested key range overlaps $0 rowsets, including $1",
+          overlapping.size(), overlapping.front()->ToString()));
+    }
+    return Status::OK();
+  };
+  {
+    shared_lock<rw_spinlock> l(component_lock_);
+    RETURN_NOT_OK(check_no_overlap());
+  }
+
+  RowSetMetadataVector new_drs_metas;
+  drsw.GetWrittenRowSetMetadata(&new_drs_metas);
+  RowSetVector new_disk_rowsets;
+  new_disk_rowsets.reserve(new_drs_metas.size());
+  for (const auto& meta : new_drs_metas) {
+    shared_ptr<DiskRowSet> new_rowset;
+    RETURN_NOT_OK_PREPEND(DiskRowSet::Open(meta,
+                                           log_anchor_registry_.get(),
+                                           mem_trackers_,
+                                           &io_context,
+                                           &new_rowset),
+                          Substitute("Unable to open ingested rowset $0",
+                                     meta->ToString()));
+    new_disk_rowsets.emplace_back(std::move(new_rowset));
+  }
+
+  // The metadata is flushed before the rowsets become visible, as with
+  // flushes and compactions, so the component lock isn't held while doing IO.
+  // That leaves a window for conflicting rowsets to appear, so the check is
+  // redone while swapping, and the new rowsets are removed from the metadata
+  // if it fails.
+  RETURN_NOT_OK_PREPEND(FlushMetadata({}, new_drs_metas, TabletMetadata::kNoMrsFlushed, {}),
+                        "Failed to flush new tablet metadata");
+  Status s;
+  {
+    std::lock_guard<rw_spinlock> lock(component_lock_);
+    s = check_no_overlap();
+    if (s.ok()) {
+      AtomicSwapRowSetsUnlocked({}, new_disk_rowsets);
+    }
+  }
+  if (PREDICT_FALSE(!s.ok())) {
+    RETURN_NOT_OK_PREPEND(FlushMetadata(new_disk_rowsets, {}, TabletMetadata::kNoMrsFlushed, {}),
+                          "Failed to remove the ingested rowsets from the tablet metadata");
+    return s;
+  }
+  UpdateAverageRowsetHeight();
+  if (metrics_) {
+    metrics_->bytes_flushed->IncrementBy(drsw.written_size());
+  }
+  LOG_WITH_PREFIX(INFO) << Substitute("Ingested $0 rows into $1 new rowsets",
+                                      drsw.rows_written_count(), new_disk_rowsets.size());
+  return Status::OK();
+}
+
 void Tablet::UpdateAverageRowsetHeight() {
   if (!metrics_) {
     return;
@@ -2331,6 +2748,7 @@ void Tablet::UpdateAverageRowsetHeight() {
   double rowset_total_width;
   RowSetInfo::ComputeCdfAndCollectOrdered(*comps->rowsets,
                                           /*is_on_memory_budget=*/nullopt,
+                                          /*read_hotness_weight=*/0,
                                           &rowset_total_height,
                                           &rowset_total_width,
                                           /*info_by_min_key=*/nullptr,
@@ -2338,7 +2756,7 @@ void Tablet::UpdateAverageRowsetHeight() {
   metrics_->average_diskrowset_height->set_value(rowset_total_height, rowset_total_width);
 }
 
-Status Tablet::Compact(CompactFlags flags) {
+Status Tablet::Compact(CompactFlags flags, int max_threads) {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
 
   RowSetsInCompactionOrFlush input;
@@ -2359,7 +2777,16 @@ Status Tablet::Compact(CompactFlags flags) {
     input.DumpToLog();
   }
 
-  return DoMergeCompactionOrFlush(input, TabletMetadata::kNoMrsFlushed, {});
+  // Keep cold data on the cold tier when compacting it.
+  fs::StorageTier tier = fs::StorageTier::HOT;
+  if (PREDICT_FALSE(metadata_->fs_manager()->dd_manager()->has_cold_tier()) &&
+      num_input_rowsets > 0 &&
+      std::all_of(input.rowsets().begin(), input.rowsets().end(),
+                  [this](const shared_ptr<RowSet>& rs) { return IsOnColdTier(rs); })) {
+    tier = fs::StorageTier::COLD;
+  }
+
+  return DoMergeCompactionOrFlush(input, TabletMetadata::kNoMrsFlushed, {}, max_threads, tier);
 }
 
 void Tablet::UpdateCompactionStats(MaintenanceOpStats* stats) {
@@ -2499,6 +2926,18 @@ Status Tablet::CaptureConsistentIterators(
     ret.emplace_back(std::move(txn_mrs_iwb));
   }
 
+  // A diff scan only returns the rows changed between its snapshots: cull the
+  // rowsets without any deltas between them.
+  int64_t num_rowsets_culled = 0;
+  const auto may_have_changes = [&](const RowSet& rs) {
+    if (opts.snap_to_exclude &&
+        !rs.MayHaveChangesBetween(*opts.snap_to_exclude, opts.snap_to_include)) {
+      num_rowsets_culled++;
+      return false;
+    }
+    return true;
+  };
+
   // Cull row-sets in the case of key-range queries.
   if (spec != nullptr && (spec->lower_bound_key() || spec->exclusive_upper_bound_key())) {
     optional<Slice> lower_bound = spec->lower_bound_key() ?
@@ -2508,38 +2947,300 @@ Status Tablet::CaptureConsistentIterators(
     vector<RowSet*> interval_sets;
     components_->rowsets->FindRowSetsIntersectingInterval(lower_bound, upper_bound, &interval_sets);
     for (const auto* rs : interval_sets) {
+      if (!may_have_changes(*rs)) {
+        continue;
+      }
       IterWithBounds iwb;
       RETURN_NOT_OK_PREPEND(rs->NewRowIteratorWithBounds(opts, &iwb),
                             Substitute("Could not create iterator for rowset $0",
                                        rs->ToString()));
+      rs->RecordRead();
       ret.emplace_back(std::move(iwb));
     }
+    TRACE_COUNTER_INCREMENT("diff_scan_rowsets_culled", num_rowsets_culled);
     *iters = std::move(ret);
     return Status::OK();
   }
 
+  // A checksum scan of the whole tablet at a clean snapshot reuses the cached
+  // checksums of the DiskRowSets that didn't change between the snapshot of
+  // their checksums and its own, and caches the checksums of the others. The
+  // checksums depend on the schema, which an alter may change the defaults of.
+  ChecksumScanState* checksum_scan = opts.checksum_scan;
+  if (checksum_scan &&
+      (opts.snap_to_exclude || opts.include_deleted_rows ||
+       opts.snap_to_include != MvccSnapshot(checksum_scan->snapshot_timestamp) ||
+       (spec && (!spec->predicates().empty() || spec->has_limit())))) {
+    checksum_scan = nullptr;
+  }
+  string checksum_projection_key;
+  unordered_set<int64_t> checksum_rowset_ids;
+  if (checksum_scan) {
+    faststring key;
+    PutFixed32(&key, metadata_->schema_version());
+    for (int i = 0; i < opts.projection->num_columns(); i++) {
+      const ColumnSchema& col = opts.projection->column(i);
+      PutFixed32(&key, opts.projection->column_id(i));
+      key.push_back(static_cast<uint8_t>(col.type_info()->type()));
+      key.push_back(col.is_nullable() ? 1 : 0);
+    }
+    checksum_projection_key = key.ToString();
+  }
+
   // If there are no encoded predicates of the primary keys, then
   // fall back to grabbing all rowset iterators.
   for (const shared_ptr<RowSet>& rs : components_->rowsets->all_rowsets()) {
+    if (!may_have_changes(*rs)) {
+      continue;
+    }
+    const shared_ptr<RowSetMetadata> rs_metadata =
+        checksum_scan ? rs->metadata() : nullptr;
+    if (rs_metadata) {
+      const int64_t rowset_id = rs_metadata->id();
+      checksum_rowset_ids.insert(rowset_id);
+      RowSetChecksumCache::Entry entry;
+      if (rowset_checksum_cache_.Lookup(checksum_projection_key, rowset_id, &entry) &&
+          entry.timestamp <= checksum_scan->snapshot_timestamp &&
+          !rs->MayHaveChangesBetween(MvccSnapshot(entry.timestamp), opts.snap_to_include)) {
+        checksum_scan->cached_checksum += entry.checksum;
+        checksum_scan->cached_rows += entry.num_rows;
+        checksum_scan->num_cached_rowsets++;
+        continue;
+      }
+    }
     IterWithBounds iwb;
     RETURN_NOT_OK_PREPEND(rs->NewRowIteratorWithBounds(opts, &iwb),
                           Substitute("Could not create iterator for rowset $0",
                                      rs->ToString()));
+    if (rs_metadata) {
+      iwb.iter = NewChecksumCachingIterator(
+          std::move(iwb.iter), &rowset_checksum_cache_, checksum_projection_key,
+          rs_metadata->id(), checksum_scan->snapshot_timestamp);
+    }
+    rs->RecordRead();
     ret.emplace_back(std::move(iwb));
   }
+  TRACE_COUNTER_INCREMENT("diff_scan_rowsets_culled", num_rowsets_culled);
+  if (checksum_scan) {
+    rowset_checksum_cache_.Retain(checksum_projection_key, checksum_rowset_ids);
+    TRACE_COUNTER_INCREMENT("checksum_rowsets_reused", checksum_scan->num_cached_rowsets);
+    if (metrics_) {
+      metrics_->checksum_rowsets_reused->IncrementBy(checksum_scan->num_cached_rowsets);
+    }
+  }
 
   // Swap results into the parameters.
   *iters = std::move(ret);
   return Status::OK();
 }
 
+Status Tablet::LookupRows(const Schema& projection,
+                          const vector<const EncodedKey*>& keys,
+                          RowBlock* dst) const {
+  DCHECK_GE(dst->row_capacity(), keys.size());
+  DCHECK(std::is_sorted(keys.begin(), keys.end(),
+                        [](const EncodedKey* a, const EncodedKey* b) {
+                          return a->encoded_key() < b->encoded_key();
+                        }));
+  RETURN_NOT_OK(CheckHasNotBeenStopped());
+
+  Schema mapped_projection;
+  RETURN_NOT_OK(GetMappedReadProjection(projection, &mapped_projection));
+  dst->Resize(keys.size());
+  dst->selection_vector()->SetAllFalse();
+  if (keys.empty()) {
+    return Status::OK();
+  }
+
+  const SchemaPtr schema_ptr = schema();
+  const Schema& tablet_schema = *schema_ptr;
+
+  // Serve the cached rows, and take the fill tokens of the others.
+  TabletRowCache::Projection cache_projection;
+  const bool use_cache =
+      row_cache_ && row_cache_->RegisterProjection(mapped_projection, &cache_projection);
+  vector<bool> cached(keys.size(), false);
+  vector<uint64_t> fill_tokens;
+  vector<Timestamp> applying_timestamps;
+  if (use_cache) {
+    int num_hits = 0;
+    fill_tokens.resize(keys.size());
+    for (int i = 0; i < keys.size(); i++) {
+      RowBlockRow dst_row = dst->row(i);
+      if (row_cache_->Lookup(cache_projection, keys[i]->encoded_key(),
+                             &dst_row, dst->arena())) {
+        cached[i] = true;
+        dst->selection_vector()->SetRowSelected(i);
+        num_hits++;
+      } else {
+        fill_tokens[i] = row_cache_->GetFillToken(keys[i]->encoded_key());
+      }
+    }
+    TRACE_COUNTER_INCREMENT("row_cache_hits", num_hits);
+    if (num_hits == keys.size()) {
+      return Status::OK();
+    }
+    mvcc_.GetApplyingOpsTimestamps(&applying_timestamps);
+  }
+
+  IOContext io_context({ tablet_id(), io_metrics() });
+  RowIteratorOptions opts;
+  opts.projection = &mapped_projection;
+  opts.snap_to_include = MvccSnapshot(mvcc_);
+  opts.io_context = &io_context;
+
+  // A write applying when the fill tokens were taken may have already
+  // invalidated its rows without being part of the snapshot: the rows read
+  // may only be cached if the snapshot includes all such writes.
+  const bool fill_cache = use_cache &&
+      std::all_of(applying_timestamps.begin(), applying_timestamps.end(),
+                  [&](const Timestamp& ts) { return opts.snap_to_include.IsApplied(ts); });
+
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+
+  // Build the probes of the keys.
+  Arena arena(1024);
+  vector<unique_ptr<RowSetKeyProbe>> key_probes;
+  key_probes.reserve(keys.size());
+  vector<Slice> encoded_keys;
+  encoded_keys.reserve(keys.size());
+  for (const auto* key : keys) {
+    uint8_t* row_key = static_cast<uint8_t*>(
+        arena.AllocateBytes(tablet_schema.key_byte_size()));
+    if (PREDICT_FALSE(!row_key)) {
+      return Status::RuntimeError("Out of memory allocating row key");
+    }
+    for (int i = 0; i < tablet_schema.num_key_columns(); i++) {
+      memcpy(row_key + tablet_schema.column_offset(i),
+             key->raw_keys()[i],
+             tablet_schema.column(i).type_info()->size());
+    }
+    key_probes.emplace_back(new RowSetKeyProbe(
+        ConstContiguousRow(&tablet_schema, row_key), &arena));
+    encoded_keys.emplace_back(key->encoded_key());
+  }
+
+  // Find the rowset holding each key, first among the memrowsets...
+  vector<ProbeStats> stats(keys.size());
+  vector<const RowSet*> found(keys.size(), nullptr);
+  for (int i = 0; i < keys.size(); i++) {
+    if (cached[i]) {
+      continue;
+    }
+    bool present = false;
+    RETURN_NOT_OK(comps->memrowset->CheckRowPresent(
+        *key_probes[i], &io_context, &present, &stats[i]));
+    if (present) {
+      found[i] = comps->memrowset.get();
+      continue;
+    }
+    for (const auto& mrs : comps->txn_memrowsets) {
+      RETURN_NOT_OK(mrs->CheckRowPresent(*key_probes[i], &io_context, &present, &stats[i]));
+      if (present) {
+        found[i] = mrs.get();
+        break;
+      }
+    }
+  }
+
+  // ... then among the other rowsets, checking the keys of each rowset in
+  // one batch as when acquiring the row locks of a write.
+  vector<pair<RowSet*, int>> pending_group;
+  vector<KeyPresenceProbe> probes;
+  vector<int> probe_idxs;
+  Status s;
+  const auto& ProcessPendingGroup = [&]() {
+    if (pending_group.empty() || !s.ok()) return;
+    RowSet* rs = pending_group[0].first;
+    probes.clear();
+    probe_idxs.clear();
+    for (const auto& rs_and_idx : pending_group) {
+      const int idx = rs_and_idx.second;
+      if (found[idx] || cached[idx]) {
+        continue;
+      }
+      probes.push_back({ key_probes[idx].get(), &stats[idx], false });
+      probe_idxs.push_back(idx);
+    }
+    pending_group.clear();
+    if (probes.empty()) {
+      return;
+    }
+    s = rs->CheckRowsPresent(probes, &io_context);
+    if (PREDICT_FALSE(!s.ok())) {
+      return;
+    }
+    for (int i = 0; i < probes.size(); i++) {
+      if (probes[i].present) {
+        found[probe_idxs[i]] = rs;
+      }
+    }
+  };
+  comps->rowsets->ForEachRowSetContainingKeys(
+      encoded_keys,
+      [&](RowSet* rs, int i) {
+        if (!pending_group.empty() && rs != pending_group.back().first) {
+          ProcessPendingGroup();
+        }
+        pending_group.emplace_back(rs, i);
+      });
+  ProcessPendingGroup();
+  RETURN_NOT_OK_PREPEND(s, Substitute("Tablet $0 failed to check row presence",
+                                      tablet_id()));
+
+  // Read each row found from its rowset.
+  RowBlockMemory mem;
+  RowBlock block(&mapped_projection, 1, &mem);
+  for (int i = 0; i < keys.size(); i++) {
+    if (!found[i]) {
+      continue;
+    }
+    EncodedKey* upper = const_cast<EncodedKey*>(keys[i]);
+    s = EncodedKey::IncrementEncodedKey(tablet_schema, &upper, &arena);
+    ScanSpec spec;
+    spec.SetLowerBoundKey(keys[i]);
+    if (s.ok()) {
+      spec.SetExclusiveUpperBoundKey(upper);
+    } else if (!s.IsIllegalState()) {
+      // IllegalState means that the key is the greatest one possible, so the
+      // scan has no upper bound.
+      return s;
+    }
+    unique_ptr<RowwiseIterator> iter;
+    RETURN_NOT_OK(found[i]->NewRowIterator(opts, &iter));
+    RETURN_NOT_OK(iter->Init(&spec));
+    RowBlockRow dst_row = dst->row(i);
+    while (iter->HasNext()) {
+      mem.Reset();
+      RETURN_NOT_OK(iter->NextBlock(&block));
+      for (int j = 0; j < block.nrows(); j++) {
+        if (!block.selection_vector()->IsRowSelected(j)) {
+          continue;
+        }
+        const RowBlockRow src_row = block.row(j);
+        for (int c = 0; c < mapped_projection.num_columns(); c++) {
+          RowBlockRow::Cell dst_cell = dst_row.cell(c);
+          RETURN_NOT_OK(CopyCell(src_row.cell(c), &dst_cell, dst->arena()));
+        }
+        dst->selection_vector()->SetRowSelected(i);
+        if (fill_cache) {
+          row_cache_->Insert(cache_projection, keys[i]->encoded_key(), fill_tokens[i], dst_row);
+        }
+      }
+    }
+  }
+  TRACE_COUNTER_INCREMENT("lookup_rows_found", dst->selection_vector()->CountSelected());
+  return Status::OK();
+}
+
 Status Tablet::CountRows(uint64_t *count) const {
   // First grab a consistent view of the components of the tablet.
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
 
   // Now sum up the counts.
-  IOContext io_context({ tablet_id() });
+  IOContext io_context({ tablet_id(), io_metrics() });
   *count = comps->memrowset->entry_count();
   for (const shared_ptr<RowSet> &rowset : comps->rowsets->all_rowsets()) {
     rowid_t l_count;
@@ -2647,6 +3348,58 @@ size_t Tablet::OnDiskDataSize() const {
   return ret;
 }
 
+void Tablet::GetColumnStats(vector<ColumnStatsPB>* stats) const {
+  stats->clear();
+  scoped_refptr<TabletComponents> comps;
+  GetComponentsOrNull(&comps);
+  if (!comps) return;
+
+  vector<RowSetMetadata::ColumnIdToStatsMap> rowset_stats;
+  for (const shared_ptr<RowSet>& rowset : comps->rowsets->all_rowsets()) {
+    const auto rowset_metadata = rowset->metadata();
+    if (rowset_metadata) {
+      rowset_stats.emplace_back(rowset_metadata->GetAllColumnStats());
+    }
+  }
+  if (rowset_stats.empty()) return;
+
+  const SchemaPtr schema_ptr = schema();
+  const Schema& s = *schema_ptr;
+  for (int i = 0; i < s.num_columns(); i++) {
+    const ColumnId col_id = s.column_id(i);
+    const TypeInfo* type_info = s.column(i).type_info();
+    ColumnStatsPB col_stats;
+    col_stats.set_column_id(col_id);
+    col_stats.set_null_count(0);
+    col_stats.set_distinct_count_estimate(0);
+    bool complete = true;
+    for (const auto& stats_by_col_id : rowset_stats) {
+      const ColumnStatsPB* rs_stats = FindOrNull(stats_by_col_id, col_id);
+      if (!rs_stats) {
+        // Partial statistics would be misleading.
+        complete = false;
+        break;
+      }
+      col_stats.set_null_count(col_stats.null_count() + rs_stats->null_count());
+      col_stats.set_distinct_count_estimate(std::max(col_stats.distinct_count_estimate(),
+                                                     rs_stats->distinct_count_estimate()));
+      if (rs_stats->has_min_value()) {
+        if (!col_stats.has_min_value() ||
+            type_info->Compare(rs_stats->min_value().data(), col_stats.min_value().data()) < 0) {
+          col_stats.set_min_value(rs_stats->min_value());
+        }
+        if (!col_stats.has_max_value() ||
+            type_info->Compare(rs_stats->max_value().data(), col_stats.max_value().data()) > 0) {
+          col_stats.set_max_value(rs_stats->max_value());
+        }
+      }
+    }
+    if (complete) {
+      stats->emplace_back(std::move(col_stats));
+    }
+  }
+}
+
 uint64_t Tablet::LastReadElapsedSeconds() const {
   shared_lock<rw_spinlock> l(last_rw_time_lock_);
   DCHECK(last_read_time_.Initialized());
@@ -2735,7 +3488,7 @@ Status Tablet::FlushBestDMS(const ReplaySizeMap &replay_size_map) const {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
   shared_ptr<RowSet> rowset = FindBestDMSToFlush(replay_size_map);
   if (rowset) {
-    IOContext io_context({ tablet_id() });
+    IOContext io_context({ tablet_id(), io_metrics(), IOPriority::BACKGROUND });
     return rowset->FlushDeltas(&io_context);
   }
   return Status::OK();
@@ -2838,7 +3591,7 @@ Status Tablet::MajorCompactAllDeltaStoresForTests() {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
-  IOContext io_context({ tablet_id() });
+  IOContext io_context({ tablet_id(), io_metrics() });
   for (const auto& rs : comps->rowsets->all_rowsets()) {
     if (!rs->IsAvailableForCompaction()) continue;
     DiskRowSet* drs = down_cast<DiskRowSet*>(rs.get());
@@ -2873,7 +3626,7 @@ Status Tablet::CompactWorstDeltas(RowSet::DeltaCompactionType type) {
   // We just released compact_select_lock_ so other compactions can select and run, but the
   // rowset is ours.
   DCHECK(perf_improv != 0);
-  IOContext io_context({ tablet_id() });
+  IOContext io_context({ tablet_id(), io_metrics(), IOPriority::BACKGROUND });
   if (type == RowSet::MINOR_DELTA_COMPACTION) {
     RETURN_NOT_OK_PREPEND(rs->MinorCompactDeltaStores(&io_context),
                           "Failed minor delta compaction on " + rs->ToString());
@@ -2949,7 +3702,7 @@ Status Tablet::EstimateBytesInPotentiallyAncientUndoDeltas(int64_t* bytes) {
 Status Tablet::InitAncientUndoDeltas(MonoDelta time_budget, int64_t* bytes_in_ancient_undos) {
   MonoTime tablet_init_start = MonoTime::Now();
 
-  IOContext io_context({ tablet_id() });
+  IOContext io_context({ tablet_id(), io_metrics(), IOPriority::BACKGROUND });
   Timestamp ancient_history_mark;
   if (!Tablet::GetTabletAncientHistoryMark(&ancient_history_mark)) {
     VLOG_WITH_PREFIX(1) << "Cannot get ancient history mark. "
@@ -3010,29 +3763,50 @@ Status Tablet::InitAncientUndoDeltas(MonoDelta time_budget, int64_t* bytes_in_an
   return Status::OK();
 }
 
-Status Tablet::GetBytesInAncientDeletedRowsets(int64_t* bytes_in_ancient_deleted_rowsets) {
+Status Tablet::CollectDeletableRowSets(const RowSetTree& tree, RowSetVector* rowsets) const {
   Timestamp ancient_history_mark;
-  if (!Tablet::GetTabletAncientHistoryMark(&ancient_history_mark)) {
+  const bool has_ancient_history_mark = GetTabletAncientHistoryMark(&ancient_history_mark);
+  if (!has_ancient_history_mark) {
     VLOG_WITH_PREFIX(1) << "Cannot get ancient history mark. "
                            "The clock is likely not a hybrid clock";
-    *bytes_in_ancient_deleted_rowsets = 0;
+  }
+  const SchemaPtr schema_ptr = schema();
+  int row_ttl_col_idx;
+  int64_t row_ttl_cutoff_micros;
+  const bool has_row_ttl = GetRowTtlCutoff(*metadata_, *schema_ptr, clock_,
+                                           &row_ttl_col_idx, &row_ttl_cutoff_micros);
+  if (!has_ancient_history_mark && !has_row_ttl) {
     return Status::OK();
   }
+  for (const auto& rowset : tree.all_rowsets()) {
+    // Check if this rowset has been locked by a compaction. If so, we
+    // shouldn't attempt to delete it.
+    if (!rowset->IsAvailableForCompaction()) {
+      continue;
+    }
+    bool deletable = has_row_ttl &&
+        rowset->EstimateAllRowsExpired(schema_ptr->column_id(row_ttl_col_idx),
+                                       row_ttl_cutoff_micros);
+    if (!deletable && has_ancient_history_mark) {
+      RETURN_NOT_OK(rowset->IsDeletedAndFullyAncient(ancient_history_mark, &deletable));
+    }
+    if (deletable) {
+      rowsets->emplace_back(rowset);
+    }
+  }
+  return Status::OK();
+}
 
+Status Tablet::GetBytesInAncientDeletedRowsets(int64_t* bytes_in_ancient_deleted_rowsets) {
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
   int64_t bytes = 0;
   {
     std::lock_guard<std::mutex> csl(compact_select_lock_);
-    for (const auto& rowset : comps->rowsets->all_rowsets()) {
-      if (!rowset->IsAvailableForCompaction()) {
-        continue;
-      }
-      bool deleted_and_ancient = false;
-      RETURN_NOT_OK(rowset->IsDeletedAndFullyAncient(ancient_history_mark, &deleted_and_ancient));
-      if (deleted_and_ancient) {
-        bytes += rowset->OnDiskSize();
-      }
+    RowSetVector rowsets;
+    RETURN_NOT_OK(CollectDeletableRowSets(*comps->rowsets, &rowsets));
+    for (const auto& rowset : rowsets) {
+      bytes += rowset->OnDiskSize();
     }
   }
   metrics_->deleted_rowset_estimated_retained_bytes->set_value(bytes);
@@ -3043,12 +3817,6 @@ Status Tablet::GetBytesInAncientDeletedRowsets(int64_t* bytes_in_ancient_deleted
 Status Tablet::DeleteAncientDeletedRowsets() {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
   const MonoTime start_time = MonoTime::Now();
-  Timestamp ancient_history_mark;
-  if (!Tablet::GetTabletAncientHistoryMark(&ancient_history_mark)) {
-    VLOG_WITH_PREFIX(1) << "Cannot get ancient history mark. "
-                           "The clock is likely not a hybrid clock";
-    return Status::OK();
-  }
 
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
@@ -3060,23 +3828,14 @@ Status Tablet::DeleteAncientDeletedRowsets() {
   int64_t bytes_deleted = 0;
   {
     std::lock_guard<std::mutex> csl(compact_select_lock_);
-    for (const auto& rowset : comps->rowsets->all_rowsets()) {
-      // Check if this rowset has been locked by a compaction. If so, we
-      // shouldn't attempt to delete it.
-      if (!rowset->IsAvailableForCompaction()) {
-        continue;
-      }
-      bool deleted_and_empty = false;
-      RETURN_NOT_OK(rowset->IsDeletedAndFullyAncient(ancient_history_mark, &deleted_and_empty));
-      if (deleted_and_empty) {
-        // If we intend on deleting the rowset, take its lock so concurrent
-        // compactions don't try to select it for compactions.
-        std::unique_lock<std::mutex> l(*rowset->compact_flush_lock(), std::try_to_lock);
-        CHECK(l.owns_lock());
-        to_delete.emplace_back(rowset);
-        rowset_locks.emplace_back(std::move(l));
-        bytes_deleted += rowset->OnDiskSize();
-      }
+    RETURN_NOT_OK(CollectDeletableRowSets(*comps->rowsets, &to_delete));
+    for (const auto& rowset : to_delete) {
+      // Since we intend on deleting the rowset, take its lock so concurrent
+      // compactions don't try to select it for compactions.
+      std::unique_lock<std::mutex> l(*rowset->compact_flush_lock(), std::try_to_lock);
+      CHECK(l.owns_lock());
+      rowset_locks.emplace_back(std::move(l));
+      bytes_deleted += rowset->OnDiskSize();
     }
   }
   if (to_delete.empty()) {
@@ -3089,6 +3848,114 @@ Status Tablet::DeleteAncientDeletedRowsets() {
   return Status::OK();
 }
 
+bool Tablet::GetColdDataMark(Timestamp* cold_data_mark) const {
+  const auto& extra_config = metadata_->extra_config();
+  if (!extra_config || !extra_config->has_cold_data_age_sec() ||
+      !clock_->HasPhysicalComponent() ||
+      !metadata_->fs_manager()->dd_manager()->has_cold_tier()) {
+    return false;
+  }
+  Timestamp now = clock_->Now();
+  uint64_t now_micros = HybridClock::GetPhysicalValueMicros(now);
+  uint64_t age_micros = extra_config->cold_data_age_sec() * 1000000ULL;
+  if (age_micros <= now_micros) {
+    *cold_data_mark =
+        HybridClock::TimestampFromMicrosecondsAndLogicalValue(
+            now_micros - age_micros,
+            HybridClock::GetLogicalValue(now));
+  } else {
+    *cold_data_mark = Timestamp(0);
+  }
+  return true;
+}
+
+bool Tablet::IsOnColdTier(const shared_ptr<RowSet>& rowset) const {
+  const auto rowset_metadata = rowset->metadata();
+  if (!rowset_metadata) {
+    return false;
+  }
+  FsManager* fs = metadata_->fs_manager();
+  const auto dd_manager = fs->dd_manager();
+  for (const auto& block_id : rowset_metadata->GetAllBlocks()) {
+    string path;
+    if (!fs->block_manager()->FindBlockPath(block_id, &path) ||
+        dd_manager->GetTierOfPath(path) != fs::StorageTier::COLD) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Tablet::CollectColdRowSetsOnHotTier(const RowSetTree& tree,
+                                         Timestamp cold_data_mark,
+                                         RowSetVector* rowsets) const {
+  for (const auto& rowset : tree.all_rowsets()) {
+    if (rowset->IsAvailableForCompaction() &&
+        rowset->EstimateAllDataOlderThan(cold_data_mark) &&
+        !IsOnColdTier(rowset)) {
+      rowsets->emplace_back(rowset);
+    }
+  }
+}
+
+Status Tablet::GetBytesInColdRowSetsOnHotTier(int64_t* bytes) {
+  *bytes = 0;
+  Timestamp cold_data_mark;
+  if (!GetColdDataMark(&cold_data_mark)) {
+    return Status::OK();
+  }
+
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  RowSetVector rowsets;
+  {
+    std::lock_guard<std::mutex> csl(compact_select_lock_);
+    CollectColdRowSetsOnHotTier(*comps->rowsets, cold_data_mark, &rowsets);
+  }
+  for (const auto& rowset : rowsets) {
+    *bytes += rowset->OnDiskSize();
+  }
+  return Status::OK();
+}
+
+Status Tablet::MoveColdRowSetToColdTier() {
+  RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
+  Timestamp cold_data_mark;
+  if (!GetColdDataMark(&cold_data_mark)) {
+    return Status::OK();
+  }
+
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  RowSetsInCompactionOrFlush input;
+  int64_t bytes = 0;
+  {
+    std::lock_guard<std::mutex> csl(compact_select_lock_);
+    RowSetVector rowsets;
+    CollectColdRowSetsOnHotTier(*comps->rowsets, cold_data_mark, &rowsets);
+    if (rowsets.empty()) {
+      return Status::OK();
+    }
+    const auto& largest = *std::max_element(
+        rowsets.begin(), rowsets.end(),
+        [](const shared_ptr<RowSet>& a, const shared_ptr<RowSet>& b) {
+          return a->OnDiskSize() < b->OnDiskSize();
+        });
+    // Take the rowset's lock so concurrent compactions don't select it.
+    std::unique_lock<std::mutex> l(*largest->compact_flush_lock(), std::try_to_lock);
+    CHECK(l.owns_lock());
+    bytes = largest->OnDiskSize();
+    input.AddRowSet(largest, std::move(l));
+  }
+  VLOG_WITH_PREFIX(1) << "Moving rowset onto the cold tier: " << input.rowsets()[0]->ToString();
+  RETURN_NOT_OK(DoMergeCompactionOrFlush(input, TabletMetadata::kNoMrsFlushed, {},
+                                         /*max_threads=*/1, fs::StorageTier::COLD));
+  if (metrics_) {
+    metrics_->cold_rowset_bytes_moved->IncrementBy(bytes);
+  }
+  return Status::OK();
+}
+
 Status Tablet::DeleteAncientUndoDeltas(int64_t* blocks_deleted, int64_t* bytes_deleted) {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
   MonoTime tablet_delete_start = MonoTime::Now();
@@ -3119,7 +3986,7 @@ Status Tablet::DeleteAncientUndoDeltas(int64_t* blocks_deleted, int64_t* bytes_d
 
   int64_t tablet_blocks_deleted = 0;
   int64_t tablet_bytes_deleted = 0;
-  fs::IOContext io_context({ tablet_id() });
+  fs::IOContext io_context({ tablet_id(), io_metrics(), IOPriority::BACKGROUND });
   for (const auto& rowset : rowsets_to_gc_undos) {
     int64_t rowset_blocks_deleted;
     int64_t rowset_bytes_deleted;
@@ -3144,6 +4011,90 @@ Status Tablet::DeleteAncientUndoDeltas(int64_t* blocks_deleted, int64_t* bytes_d
   return Status::OK();
 }
 
+Status Tablet::EstimateBytesInTruncatableUndoDeltas(double min_ancient_ratio, int64_t* bytes) {
+  DCHECK(bytes);
+  *bytes = 0;
+
+  Timestamp ancient_history_mark;
+  if (!Tablet::GetTabletAncientHistoryMark(&ancient_history_mark)) return Status::OK();
+
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+
+  int64_t tablet_bytes = 0;
+  for (const auto& rowset : comps->rowsets->all_rowsets()) {
+    int64_t rowset_bytes;
+    RETURN_NOT_OK(rowset->EstimateBytesInTruncatableUndoDeltas(
+        ancient_history_mark, min_ancient_ratio, &rowset_bytes));
+    tablet_bytes += rowset_bytes;
+  }
+  *bytes = tablet_bytes;
+  return Status::OK();
+}
+
+Status Tablet::TruncateAncientUndoDeltas(double min_ancient_ratio,
+                                         MonoDelta time_budget,
+                                         int64_t* blocks_truncated,
+                                         int64_t* bytes_truncated) {
+  RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
+  MonoTime tablet_truncate_start = MonoTime::Now();
+
+  Timestamp ancient_history_mark;
+  if (!Tablet::GetTabletAncientHistoryMark(&ancient_history_mark)) return Status::OK();
+
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+
+  // As in DeleteAncientUndoDeltas(), we need to hold the compact_flush_lock
+  // for each rowset we rewrite undos of.
+  RowSetVector rowsets_to_truncate_undos;
+  vector<std::unique_lock<std::mutex>> rowset_locks;
+  {
+    std::lock_guard<std::mutex> compact_lock(compact_select_lock_);
+    for (const auto& rowset : comps->rowsets->all_rowsets()) {
+      if (!rowset->IsAvailableForCompaction()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(*rowset->compact_flush_lock(), std::try_to_lock);
+      CHECK(lock.owns_lock()) << rowset->ToString() << " unable to lock compact_flush_lock";
+      rowsets_to_truncate_undos.push_back(rowset);
+      rowset_locks.push_back(std::move(lock));
+    }
+  }
+
+  const MonoTime deadline = time_budget.Initialized() ?
+      tablet_truncate_start + time_budget : MonoTime();
+  int64_t tablet_blocks_truncated = 0;
+  int64_t tablet_bytes_truncated = 0;
+  fs::IOContext io_context({ tablet_id(), io_metrics(), IOPriority::BACKGROUND });
+  Status s;
+  for (const auto& rowset : rowsets_to_truncate_undos) {
+    int64_t rowset_blocks_truncated = 0;
+    int64_t rowset_bytes_truncated = 0;
+    s = rowset->TruncateAncientUndoDeltas(ancient_history_mark, min_ancient_ratio, deadline,
+                                          &io_context, &rowset_blocks_truncated,
+                                          &rowset_bytes_truncated);
+    if (PREDICT_FALSE(!s.ok())) break;
+    tablet_blocks_truncated += rowset_blocks_truncated;
+    tablet_bytes_truncated += rowset_bytes_truncated;
+  }
+  // The blocks rewritten so far are already swapped in the rowset metadata,
+  // so persist them even if a later rowset failed.
+  if (tablet_blocks_truncated > 0) {
+    RETURN_NOT_OK(metadata_->Flush());
+  }
+  RETURN_NOT_OK(s);
+
+  metrics_->undo_delta_block_gc_bytes_truncated->IncrementBy(tablet_bytes_truncated);
+  VLOG_WITH_PREFIX(1) << Substitute("Truncated $0 undo delta blocks ($1 bytes) in $2",
+                                    tablet_blocks_truncated, tablet_bytes_truncated,
+                                    (MonoTime::Now() - tablet_truncate_start).ToString());
+
+  if (blocks_truncated) *blocks_truncated = tablet_blocks_truncated;
+  if (bytes_truncated) *bytes_truncated = tablet_bytes_truncated;
+  return Status::OK();
+}
+
 int64_t Tablet::CountUndoDeltasForTests() const {
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
@@ -3209,6 +4160,7 @@ void Tablet::PrintRSLayout(ostream* o) {
   vector<RowSetInfo> max;
   RowSetInfo::ComputeCdfAndCollectOrdered(*rowsets_copy,
                                           /*is_on_memory_budget=*/nullopt,
+                                          /*read_hotness_weight=*/0,
                                           &rowset_total_height,
                                           &rowset_total_width,
                                           &min,
@@ -3303,7 +4255,7 @@ string Tablet::LogPrefix() const {
 Tablet::Iterator::Iterator(const Tablet* tablet,
                            RowIteratorOptions opts)
     : tablet_(tablet),
-      io_context_({ tablet->tablet_id() }),
+      io_context_({ tablet->tablet_id(), tablet->io_metrics() }),
       projection_(*CHECK_NOTNULL(opts.projection)),
       opts_(std::move(opts)) {
   opts_.io_context = &io_context_;
@@ -3316,6 +4268,10 @@ Status Tablet::Iterator::Init(ScanSpec *spec) {
   RETURN_NOT_OK(tablet_->CheckHasNotBeenStopped());
   DCHECK(iter_.get() == nullptr);
 
+  if (spec && spec->lower_bound_key()) {
+    tablet_->SampleKeyAccess(spec->lower_bound_key()->encoded_key());
+  }
+
   RETURN_NOT_OK(tablet_->GetMappedReadProjection(projection_, &projection_));
 
   vector<IterWithBounds> iters;
@@ -3328,7 +4284,18 @@ Status Tablet::Iterator::Init(ScanSpec *spec) {
       break;
     case UNORDERED:
     default:
-      iter_ = NewUnionIterator(std::move(iters));
+      if (opts_.parallel_scan_pool != nullptr &&
+          FLAGS_tablet_parallel_scan_max_rowsets > 1 &&
+          iters.size() > 1) {
+        ParallelUnionIteratorOptions parallel_opts;
+        parallel_opts.pool = opts_.parallel_scan_pool;
+        parallel_opts.max_concurrency = FLAGS_tablet_parallel_scan_max_rowsets;
+        parallel_opts.max_buffered_blocks =
+            std::max(1, FLAGS_tablet_parallel_scan_max_buffered_blocks);
+        iter_ = NewParallelUnionIterator(parallel_opts, std::move(iters));
+      } else {
+        iter_ = NewUnionIterator(std::move(iters));
+      }
       break;
   }
 
@@ -37,6 +37,7 @@
 
 #include "kudu/common/iterator.h"
 #include "kudu/common/schema.h"
+#include "kudu/fs/block_manager.h"
 #include "kudu/fs/io_context.h"
 #include "kudu/gutil/integral_types.h"
 #include "kudu/gutil/macros.h"
@@ -46,10 +47,12 @@
 #include "kudu/tablet/lock_manager.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/rowset_checksum_cache.h"
 #include "kudu/tablet/tablet_mem_trackers.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/txn_participant.h"
 #include "kudu/util/bloom_filter.h"
+#include "kudu/util/hot_key_tracker.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/maintenance_manager.h"
 #include "kudu/util/metrics.h"
@@ -91,12 +94,16 @@ class TabletServerTest_SetEncodedKeysWhenStartingUp_Test;
 namespace tablet {
 
 class AlterSchemaOpState;
+class ColumnStatsPB;
+class CompactionOrFlushInput;
 class CompactionPolicy;
 class HistoryGcOpts;
 class MemRowSet;
 class ParticipantOpState;
+class RollingDiskRowSetWriter;
 class RowSetTree;
 class RowSetsInCompactionOrFlush;
+class TabletRowCache;
 class TxnMetadata;
 class WriteOpState;
 struct RowOp;
@@ -136,8 +143,9 @@ class Tablet {
   Status Open(const std::unordered_set<int64_t>& in_flight_txn_ids = std::unordered_set<int64_t>{},
               const std::unordered_set<int64_t>& txn_ids_with_mrs = std::unordered_set<int64_t>{});
 
-  // Update the auto incrementing counter of the tablet
-  // if the tablet has the auto incrementing column in the schema.
+  // Update the auto incrementing counter of the tablet from the rows of
+  // 'rowsets_opened'. This is only needed for tablets whose metadata
+  // doesn't have the counter persisted yet.
   Status UpdateAutoIncrementingCounter(const RowSetVector& rowsets_opened);
 
   // Mark that the tablet has finished bootstrapping.
@@ -260,12 +268,47 @@ class Tablet {
   Status NewRowIterator(RowIteratorOptions opts,
                         std::unique_ptr<RowwiseIterator>* iter) const;
 
+  // Looks up the rows with the primary keys 'keys' as of the current MVCC
+  // state of this tablet. Sets row 'i' of 'dst' to the row of 'keys[i]',
+  // projected to 'projection', and selects it if the row exists.
+  //
+  // Unlike an iterator with an IN-list predicate, only the rowsets whose
+  // bloom filters and key indexes contain a key are read, each with an
+  // iterator bounded by the key. If the row cache is enabled, the rows are
+  // served from it when cached, and cached otherwise.
+  //
+  // REQUIRES: 'keys' are sorted in increasing order without duplicates, and
+  // 'dst' has the schema 'projection' and a capacity of at least keys.size().
+  Status LookupRows(const Schema& projection,
+                    const std::vector<const EncodedKey*>& keys,
+                    RowBlock* dst) const;
+
   // Flush the current MemRowSet for this tablet to disk. This swaps
   // in a new (initially empty) MemRowSet in its place.
   //
   // This doesn't flush any DeltaMemStores for any existing RowSets.
   Status Flush();
 
+  // Writes the rows of 'iter' directly into new DiskRowSets and attaches them
+  // to the tablet, bypassing the WAL and the MemRowSet. This is meant for
+  // backfilling a key range of the tablet with a large amount of pre-sorted
+  // data.
+  //
+  // 'iter' must be initialized, have the tablet's schema, and produce rows
+  // in strictly ascending primary key order, all of them belonging to the
+  // tablet's partition. The key range spanned by the rows must not overlap
+  // any existing DiskRowSet, and the MemRowSets of the tablet must be empty;
+  // otherwise Status::IllegalState is returned and nothing is attached.
+  // Writes within the ingested key range must not race with this call.
+  //
+  // The ingested rows have no history: once attached, they are visible to
+  // every snapshot, as if they had always been there. This isn't replicated
+  // through consensus: to keep the replicas of a tablet consistent, the same
+  // rows must be ingested into each of them.
+  //
+  // If 'rows_ingested' is not null, it's set to the number of ingested rows.
+  Status IngestSortedRows(RowwiseIterator* iter, int64_t* rows_ingested = nullptr);
+
   // Prepares the op context for the alter schema operation.
   // An error will be returned if the specified schema is invalid (e.g.
   // key mismatch, or missing IDs)
@@ -301,7 +344,10 @@ class Tablet {
   };
   typedef int CompactFlags;
 
-  Status Compact(CompactFlags flags);
+  // Compacts the rowsets picked by the compaction policy. If 'max_threads' is
+  // greater than 1, the key range of the input rowsets may be split into up to
+  // 'max_threads' sub-ranges whose output rowsets are written concurrently.
+  Status Compact(CompactFlags flags, int max_threads = 1);
 
   // Update the statistics for performing a compaction.
   void UpdateCompactionStats(MaintenanceOpStats* stats);
@@ -328,6 +374,13 @@ class Tablet {
   // Excludes all metadata (both tablet metadata and the metadata of this tablet's rowsets).
   size_t OnDiskDataSize() const;
 
+  // Returns the statistics of the columns of this tablet's flushed data,
+  // aggregated from those of its rowsets. Only the columns with statistics in
+  // all the rowsets are included. The rows of the MemRowSet and the deltas
+  // aren't accounted for, and the estimated number of distinct values of a
+  // column is the largest of its rowsets', i.e. a lower bound.
+  void GetColumnStats(std::vector<ColumnStatsPB>* stats) const;
+
   // Get the total size of all the DMS
   size_t DeltaMemStoresSize() const;
 
@@ -382,8 +435,26 @@ class Tablet {
   Status DeleteAncientUndoDeltas(int64_t* blocks_deleted = nullptr,
                                  int64_t* bytes_deleted = nullptr);
 
+  // Estimate the number of bytes of ancient deltas in the initialized undo
+  // delta blocks which also hold deltas newer than the ancient history mark,
+  // and of which at least 'min_ancient_ratio' is estimated to be ancient.
+  Status EstimateBytesInTruncatableUndoDeltas(double min_ancient_ratio, int64_t* bytes);
+
+  // Rewrite the undo delta blocks counted by
+  // EstimateBytesInTruncatableUndoDeltas() without their ancient deltas, for
+  // up to 'time_budget' amount of time. If 'time_budget' is not Initialized()
+  // then there is no time limit. The blocks rewritten within the budget are
+  // persisted, so that the next call picks up where this one stopped. If this
+  // method returns OK, the number of blocks rewritten and of bytes reclaimed
+  // are returned in the out-parameters.
+  Status TruncateAncientUndoDeltas(double min_ancient_ratio,
+                                   MonoDelta time_budget,
+                                   int64_t* blocks_truncated = nullptr,
+                                   int64_t* bytes_truncated = nullptr);
+
   // Returns the number of bytes potentially used by rowsets that have no live
-  // rows and are entirely ancient.
+  // rows and are entirely ancient, or whose rows are all expired by the row TTL
+  // of the table.
   //
   // These checks may not touch on-disk block data if we can determine from the
   // live row count that the rowsets aren't fully deleted, or from the DMS that
@@ -394,12 +465,24 @@ class Tablet {
   Status GetBytesInAncientDeletedRowsets(int64_t* bytes_in_ancient_deleted_rowsets);
 
   // Finds and GCs all fully deleted rowsets that have a maximum op timestamp
-  // prior to the current ancient history mark.
+  // prior to the current ancient history mark, as well as the rowsets whose
+  // rows are all expired by the row TTL of the table, without rewriting them.
   //
   // Returns an error if the metadata update fails. Upon failure, no in-memory
   // state is change.
   Status DeleteAncientDeletedRowsets();
 
+  // Returns the number of bytes of the rowsets whose data is older than the
+  // table's 'kudu.table.cold_data_age_sec' but which aren't on the cold
+  // storage tier yet. Since the age of the rowsets is estimated from their
+  // newest delta files without initializing them, this may be an
+  // underestimate.
+  Status GetBytesInColdRowSetsOnHotTier(int64_t* bytes);
+
+  // Rewrites the largest of the rowsets counted by
+  // GetBytesInColdRowSetsOnHotTier() onto the cold storage tier.
+  Status MoveColdRowSetToColdTier();
+
   // Counts the number of deltas in the tablet. Only used for tests.
   int64_t CountUndoDeltasForTests() const;
   int64_t CountRedoDeltasForTests() const;
@@ -434,6 +517,16 @@ class Tablet {
   // Return the Lock Manager for this tablet.
   LockManager* lock_manager() { return &lock_manager_; }
 
+  // Samples an access to the encoded primary key 'encoded_key' by a row
+  // operation or by the start of a scan, per --tablet_hot_key_sampling_rate.
+  void SampleKeyAccess(Slice encoded_key) const;
+
+  // Return the trackers of the most accessed primary keys and key ranges of
+  // this tablet, among the sampled accesses. The key ranges are identified by
+  // the first --tablet_hot_key_range_prefix_bytes bytes of the encoded keys.
+  const HotKeyTracker& hot_keys() const { return hot_keys_; }
+  const HotKeyTracker& hot_key_ranges() const { return hot_key_ranges_; }
+
   // Return the transaction participant for this tablet.
   TxnParticipant* txn_participant() { return &txn_participant_; }
 
@@ -464,9 +557,44 @@ class Tablet {
   // Otherwise, returns false.
   bool GetTabletAncientHistoryMark(Timestamp* ancient_history_mark) const WARN_UNUSED_RESULT;
 
+  // Calculates the timestamp before which the tablet's data is cold, and
+  // returns true iff the table is configured with 'kudu.table.cold_data_age_sec',
+  // the data dirs have a cold tier and the clock is a HybridClock.
+  // Otherwise, returns false.
+  bool GetColdDataMark(Timestamp* cold_data_mark) const WARN_UNUSED_RESULT;
+
   // Calculates history GC options based on properties of the Clock implementation.
   HistoryGcOpts GetHistoryGcOpts() const;
 
+  // Like GetHistoryGcOpts(), but the options also garbage-collect the rows
+  // expired by the row TTL of the table, if any. 'schema' is the schema of the
+  // rows to garbage-collect.
+  HistoryGcOpts GetHistoryGcOptsWithRowTtl(const Schema& schema) const;
+
+  // Returns true iff the table of 'metadata' is configured with
+  // 'kudu.table.row_ttl_column', naming a UNIXTIME_MICROS or INT64 key column
+  // of 'schema', and with 'kudu.table.row_ttl_sec', and 'clock' has a physical
+  // component. Sets 'col_idx' to the index of the TTL column in 'schema' and
+  // 'ttl_sec' to the TTL. Otherwise, returns false.
+  static bool GetRowTtl(const TabletMetadata& metadata,
+                        const Schema& schema,
+                        clock::Clock* clock,
+                        int* col_idx,
+                        int64_t* ttl_sec) WARN_UNUSED_RESULT;
+
+  // Returns the value of the TTL column below which the rows with a TTL of
+  // 'ttl_sec', as returned by GetRowTtl(), are expired as of the physical time
+  // of 'timestamp'.
+  static int64_t GetRowTtlCutoffMicros(const Timestamp& timestamp, int64_t ttl_sec);
+
+  // Like GetRowTtl(), but sets 'cutoff_micros' to the cutoff of the row TTL as
+  // of the current time of 'clock'.
+  static bool GetRowTtlCutoff(const TabletMetadata& metadata,
+                              const Schema& schema,
+                              clock::Clock* clock,
+                              int* col_idx,
+                              int64_t* cutoff_micros) WARN_UNUSED_RESULT;
+
   // Method used by tests to retrieve all rowsets of this table. This
   // will be removed once code for selecting the appropriate RowSet is
   // finished and delta files is finished is part of Tablet class.
@@ -494,6 +622,16 @@ class Tablet {
   // May be NULL in unit tests, etc.
   TabletMetrics* metrics() { return metrics_.get(); }
 
+  // Return the checksums of the rowsets cached by the checksum scans.
+  const RowSetChecksumCache& rowset_checksum_cache() const {
+    return rowset_checksum_cache_;
+  }
+
+  // Return the counters which the IO done on behalf of this tablet is
+  // accounted to, see fs::IOContext.
+  // May be NULL in unit tests, etc.
+  const fs::IOMetrics* io_metrics() const;
+
   // Return handle to the metric entity of this tablet.
   const scoped_refptr<MetricEntity>& GetMetricEntity() const {
     return metric_entity_;
@@ -549,11 +687,11 @@ class Tablet {
                                              MonoTime* earliest_dms_time = nullptr) const;
 
   int64_t GetAutoIncrementingCounter() const {
-    return auto_incrementing_counter_;
+    return auto_incrementing_counter_.load(std::memory_order_acquire);
   }
 
   void SetAutoIncrementingCounter(int64_t auto_incrementing_counter) {
-    auto_incrementing_counter_ = auto_incrementing_counter;
+    auto_incrementing_counter_.store(auto_incrementing_counter, std::memory_order_release);
   }
  private:
   friend class kudu::AlterTableTest;
@@ -683,10 +821,58 @@ class Tablet {
   Status PickRowSetsToCompact(RowSetsInCompactionOrFlush *picked,
                               CompactFlags flags) const;
 
-  // Performs a merge compaction or a flush.
+  // Performs a merge compaction or a flush. The output of a compaction is
+  // written with up to 'max_threads' threads, onto the 'tier' storage tier.
   Status DoMergeCompactionOrFlush(const RowSetsInCompactionOrFlush &input,
                                   int64_t mrs_being_flushed,
-                                  const std::vector<TxnInfoBeingFlushed>& txns_being_flushed);
+                                  const std::vector<TxnInfoBeingFlushed>& txns_being_flushed,
+                                  int max_threads = 1,
+                                  fs::StorageTier tier = fs::StorageTier::HOT);
+
+  // Returns whether all the blocks of 'rowset' are on the cold storage tier.
+  bool IsOnColdTier(const std::shared_ptr<RowSet>& rowset) const;
+
+  // Collects into 'rowsets' those of 'tree' which are available for compaction
+  // and can be deleted without being rewritten: those which have no live rows
+  // and are fully ancient, and those whose rows are all expired by the row TTL
+  // of the table.
+  //
+  // REQUIRES: compact_select_lock_ is held.
+  Status CollectDeletableRowSets(const RowSetTree& tree, RowSetVector* rowsets) const;
+
+  // Collects into 'rowsets' those of 'tree' which are available for
+  // compaction, whose data is older than 'cold_data_mark' and which aren't on
+  // the cold storage tier.
+  //
+  // REQUIRES: compact_select_lock_ is held.
+  void CollectColdRowSetsOnHotTier(const RowSetTree& tree,
+                                   Timestamp cold_data_mark,
+                                   RowSetVector* rowsets) const;
+
+  // Computes the encoded keys splitting the key range of the rowsets of a
+  // compaction 'input' into up to 'max_ranges' sub-ranges of similar sizes, each
+  // large enough to produce at least one rowset of the target size. The splits
+  // are only made at the bounds of the input rowsets. 'split_keys' is left
+  // empty if the compaction isn't worth splitting.
+  void ComputeCompactionSplitKeys(const RowSetsInCompactionOrFlush& input,
+                                  int max_ranges,
+                                  std::vector<std::string>* split_keys) const;
+
+  // Phase 1 of a merge compaction or flush: writes the rows of 'input' whose
+  // keys are in [lower_bound, exclusive_upper_bound) as of 'snap' into new
+  // rowsets with the writer returned in 'drsw', onto the 'tier' storage tier.
+  // Null bounds leave the range unbounded. The input created to read the rows
+  // is returned in 'merge'.
+  Status WriteCompactionOrFlushOutput(const RowSetsInCompactionOrFlush& input,
+                                      const MvccSnapshot& snap,
+                                      const Schema* schema,
+                                      const fs::IOContext* io_context,
+                                      const HistoryGcOpts& history_gc_opts,
+                                      const EncodedKey* lower_bound,
+                                      const EncodedKey* exclusive_upper_bound,
+                                      fs::StorageTier tier,
+                                      std::shared_ptr<CompactionOrFlushInput>* merge,
+                                      std::unique_ptr<RollingDiskRowSetWriter>* drsw);
 
   // Handle the case in which a compaction or flush yielded no output rows.
   // In this case, we just need to remove the rowsets in 'rowsets' from the
@@ -815,11 +1001,19 @@ class Tablet {
 
   std::unique_ptr<Throttler> throttler_;
 
+  // The rows of this tablet in the row cache. Null if the row cache is
+  // disabled.
+  std::unique_ptr<TabletRowCache> row_cache_;
+
+  // The checksums of the rowsets computed by the checksum scans.
+  mutable RowSetChecksumCache rowset_checksum_cache_;
+
   int64_t next_mrs_id_;
 
   // Counter for an auto-incrementing column. It is expected that this is only
-  // updated by the prepare thread.
-  int64_t auto_incrementing_counter_;
+  // updated by the prepare thread, but it's read when flushing the metadata
+  // to persist it along with the rowsets.
+  std::atomic<int64_t> auto_incrementing_counter_;
 
   // A pointer to the server's clock.
   clock::Clock* clock_;
@@ -873,6 +1067,15 @@ class Tablet {
   MonoTime last_read_time_;
   MonoTime last_write_time_;
 
+  // The number of the most accessed keys and key ranges tracked, and the
+  // number of sampled accesses after which their counts are halved.
+  static constexpr int kNumHotKeys = 10;
+  static constexpr uint64_t kHotKeyDecayWindow = 10000;
+
+  // Updated by the scans as well, so mutable.
+  mutable HotKeyTracker hot_keys_;
+  mutable HotKeyTracker hot_key_ranges_;
+
   // NOTE: it's important that this is the first member to be destructed. This
   // ensures we do not attempt to collect metrics while calling the destructor.
   FunctionGaugeDetacher metric_detacher_;
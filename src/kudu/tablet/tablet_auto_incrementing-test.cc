@@ -29,6 +29,8 @@
 #include "kudu/common/schema.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/local_tablet_writer.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
@@ -233,5 +235,44 @@ TEST_F(AutoIncrementingTabletTest, TestNegatives) {
   }
 }
 
+// Test that the counter is persisted in the tablet metadata upon flushes, so
+// reopening the tablet doesn't hand out the values of rows deleted meanwhile.
+TEST_F(AutoIncrementingTabletTest, TestCounterPersistedOnFlush) {
+  ASSERT_FALSE(tablet()->metadata()->auto_incrementing_counter());
+  unique_ptr<KuduPartialRow> row(new KuduPartialRow(&client_schema_));
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(row->SetInt32(1, 1337));
+    ASSERT_OK(writer_->Insert(*row));
+  }
+  ASSERT_OK(tablet()->Flush());
+  const auto counter = tablet()->metadata()->auto_incrementing_counter();
+  ASSERT_TRUE(counter);
+  ASSERT_EQ(10, *counter);
+
+  // Delete the rows with the highest values and flush the deletes.
+  for (int i = 6; i <= 10; i++) {
+    KuduPartialRow key(&client_schema_);
+    ASSERT_OK(key.SetInt64(0, i));
+    ASSERT_OK(writer_->Delete(key));
+  }
+  ASSERT_OK(tablet()->FlushAllDMSForTests());
+
+  // The counter picks up where it was after reopening the tablet.
+  writer_.reset();
+  TabletReOpen();
+  ASSERT_EQ(10, tablet()->GetAutoIncrementingCounter());
+  writer_.reset(new LocalTabletWriter(tablet().get(), &client_schema_));
+  row.reset(new KuduPartialRow(&client_schema_));
+  ASSERT_OK(row->SetInt32(1, 1337));
+  ASSERT_OK(writer_->Insert(*row));
+  unique_ptr<RowwiseIterator> iter;
+  ASSERT_OK(tablet()->NewRowIterator(schema_.CopyWithoutColumnIds(), &iter));
+  ASSERT_OK(iter->Init(nullptr));
+  vector<string> out;
+  IterateToStringList(iter.get(), &out);
+  ASSERT_EQ(6, out.size());
+  ASSERT_STR_CONTAINS(out.back(), "int64 key=11");
+}
+
 } // namespace tablet
 } // namespace kudu
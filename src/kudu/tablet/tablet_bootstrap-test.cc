@@ -27,6 +27,7 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -92,6 +93,8 @@ using std::string;
 using std::unique_ptr;
 using std::vector;
 
+DECLARE_int64(tablet_bootstrap_log_read_ahead_bytes);
+
 namespace kudu {
 namespace tablet {
 
@@ -263,6 +266,36 @@ TEST_F(BootstrapTest, TestBootstrapHighOpIdIndex) {
   ASSERT_OPID_EQ(last_opid, boot_info.last_committed_id);
 }
 
+// Test that the log is replayed the same whether its entries are read ahead
+// of their replay or not, however small the read-ahead buffer.
+TEST_F(BootstrapTest, TestLogReadAhead) {
+  constexpr int kNumSegments = 3;
+  constexpr int kEntriesPerSegment = 10;
+  ASSERT_OK(BuildLog());
+  for (int i = 0; i < kNumSegments; i++) {
+    ASSERT_OK(AppendReplicateBatchAndCommitEntryPairsToLog(kEntriesPerSegment));
+    ASSERT_OK(RollLog());
+  }
+  scoped_refptr<TabletMetadata> meta;
+  ASSERT_OK(LoadTestTabletMetadata(-1, -1, &meta));
+  ASSERT_OK(CreateConsensusMetadata(meta));
+
+  for (int64_t read_ahead_bytes : { 0, 1, 64 * 1024 * 1024 }) {
+    SCOPED_TRACE(read_ahead_bytes);
+    FLAGS_tablet_bootstrap_log_read_ahead_bytes = read_ahead_bytes;
+    // Each bootstrap replays the log written by the previous one.
+    shared_ptr<Tablet> tablet;
+    ConsensusBootstrapInfo boot_info;
+    ASSERT_OK(RunBootstrapOnTestTablet(meta, &tablet, &boot_info));
+    OpId last_opid = MakeOpId(1, current_index_ - 1);
+    ASSERT_OPID_EQ(last_opid, boot_info.last_id);
+    ASSERT_OPID_EQ(last_opid, boot_info.last_committed_id);
+    vector<string> results;
+    NO_FATALS(IterateTabletRows(tablet.get(), &results));
+    ASSERT_EQ(kNumSegments * kEntriesPerSegment, results.size());
+  }
+}
+
 // Tests attempting a local bootstrap of a tablet that was in the middle of a
 // tablet copy before "crashing".
 TEST_F(BootstrapTest, TestIncompleteTabletCopy) {
@@ -447,6 +480,34 @@ TEST_F(BootstrapTest, TestOrphanedReplicate) {
   EXPECT_EQ("term: 1 index: 1", SecureShortDebugString(boot_info.last_id));
 }
 
+// Tests that the writes whose commits were elided and coalesced into COMMIT
+// entries are replayed, and that the write whose elided commit wasn't appended
+// is handed back to consensus.
+TEST_F(BootstrapTest, TestElidedCommits) {
+  ASSERT_OK(BuildLog());
+  MemStoreTargetPB mrs;
+  mrs.set_mrs_id(1);
+  constexpr int kNumWrites = 10;
+  OpId last_committed;
+  for (int i = 0; i < kNumWrites; i++) {
+    last_committed = MakeOpId(1, current_index_++);
+    ASSERT_OK(AppendReplicateBatch(last_committed));
+    log_->AppendElidedCommit(last_committed, mrs, 2);
+  }
+  ASSERT_OK(log_->WaitUntilAllFlushed());
+  ASSERT_OK(AppendReplicateBatch(MakeOpId(1, current_index_++)));
+
+  shared_ptr<Tablet> tablet;
+  ConsensusBootstrapInfo boot_info;
+  ASSERT_OK(BootstrapTestTablet(-1, -1, &tablet, &boot_info));
+
+  vector<string> results;
+  IterateTabletRows(tablet.get(), &results);
+  ASSERT_EQ(kNumWrites, results.size());
+  ASSERT_EQ(1, boot_info.orphaned_replicates.size());
+  ASSERT_OPID_EQ(last_committed, boot_info.last_committed_id);
+}
+
 // Bootstrap should fail if no ConsensusMetadata file exists.
 TEST_F(BootstrapTest, TestMissingConsensusMetadata) {
   ASSERT_OK(BuildLog());
@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/tablet_bootstrap.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <iterator>
@@ -83,6 +84,7 @@
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_admin.pb.h"
+#include "kudu/util/blocking_queue.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -95,6 +97,7 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/thread.h"
 
 DECLARE_bool(prevent_kudu_2233_corruption);
 DECLARE_int32(group_commit_queue_size_bytes);
@@ -105,6 +108,13 @@ DEFINE_double(fault_crash_during_log_replay, 0.0,
               "(For testing only!)");
 TAG_FLAG(fault_crash_during_log_replay, unsafe);
 
+DEFINE_int64(tablet_bootstrap_log_read_ahead_bytes, 64 * 1024 * 1024,
+             "The maximum size of the log entries read ahead of their replay during "
+             "tablet bootstrap. The entries are read and decoded on a separate thread, "
+             "concurrently with the replay of the previous ones. If not positive, the "
+             "entries are read on the replaying thread.");
+TAG_FLAG(tablet_bootstrap_log_read_ahead_bytes, advanced);
+
 DECLARE_int32(max_clock_sync_error_usec);
 
 using kudu::clock::Clock;
@@ -245,6 +255,9 @@ class TabletBootstrap {
                    scoped_refptr<Log>* rebuilt_log,
                    ConsensusBootstrapInfo* consensus_info);
 
+  // Sets 'stats' to the statistics of the bootstrap so far.
+  void GetStats(BootstrapStats* stats) const;
+
  private:
 
   // The method that does the actual work of tablet bootstrap. Bootstrap() is
@@ -392,6 +405,11 @@ class TabletBootstrap {
   Status HandleCommitMessage(const IOContext* io_context, ReplayState* state,
                              unique_ptr<LogEntryPB> entry,
                              string* entry_debug_info);
+  // Handles a COMMIT entry standing for the elided commits of a run of writes,
+  // see Log::AppendElidedCommit().
+  Status HandleElidedCommits(const IOContext* io_context, ReplayState* state,
+                             const LogEntryPB& entry,
+                             string* entry_debug_info);
 
   Status ApplyCommitMessage(const IOContext* io_context, ReplayState* state, LogEntryPB* entry);
   Status HandleEntryPair(const IOContext* io_context, LogEntryPB* replicate_entry,
@@ -445,11 +463,14 @@ class TabletBootstrap {
       return Substitute("ops{read=$0 overwritten=$1 applied=$2 ignored=$3} "
                         "inserts{seen=$4 ignored=$5} "
                         "mutations{seen=$6 ignored=$7} "
-                        "orphaned_commits=$8",
+                        "orphaned_commits=$8 "
+                        "time{open=$9 read=$10 read_wait=$11 replay=$12}",
                         ops_read, ops_overwritten, ops_committed, ops_ignored,
                         inserts_seen, inserts_ignored,
                         mutations_seen, mutations_ignored,
-                        orphaned_commits);
+                        orphaned_commits,
+                        open_time.ToString(), read_time.ToString(),
+                        read_wait_time.ToString(), replay_time.ToString());
     }
 
     // Number of REPLICATE messages read from the log
@@ -471,6 +492,14 @@ class TabletBootstrap {
 
     // Number of COMMIT messages for which a corresponding REPLICATE was not found.
     int orphaned_commits;
+
+    // Time spent opening the tablet, reading and decoding the log entries,
+    // waiting for them to be read, and replaying them. With read-ahead, the
+    // reading overlaps with the replay: only the waiting adds to it.
+    MonoDelta open_time = MonoDelta::FromNanoseconds(0);
+    MonoDelta read_time = MonoDelta::FromNanoseconds(0);
+    MonoDelta read_wait_time = MonoDelta::FromNanoseconds(0);
+    MonoDelta replay_time = MonoDelta::FromNanoseconds(0);
   };
   Stats stats_;
 
@@ -506,7 +535,8 @@ Status BootstrapTablet(scoped_refptr<TabletMetadata> tablet_meta,
                        scoped_refptr<log::LogAnchorRegistry> log_anchor_registry,
                        shared_ptr<tablet::Tablet>* rebuilt_tablet,
                        scoped_refptr<log::Log>* rebuilt_log,
-                       ConsensusBootstrapInfo* consensus_info) {
+                       ConsensusBootstrapInfo* consensus_info,
+                       BootstrapStats* stats) {
   TRACE_EVENT1("tablet", "BootstrapTablet",
                "tablet_id", tablet_meta->tablet_id());
   TabletBootstrap bootstrap(std::move(tablet_meta),
@@ -521,6 +551,9 @@ Status BootstrapTablet(scoped_refptr<TabletMetadata> tablet_meta,
   RETURN_NOT_OK(bootstrap.Bootstrap(rebuilt_tablet, rebuilt_log, consensus_info));
   // This is necessary since OpenNewLog() initially disables sync.
   RETURN_NOT_OK((*rebuilt_log)->ReEnableSyncIfRequired());
+  if (stats) {
+    bootstrap.GetStats(stats);
+  }
   return Status::OK();
 }
 
@@ -605,6 +638,15 @@ Status TabletBootstrap::Bootstrap(shared_ptr<Tablet>* rebuilt_tablet,
   return Status::OK();
 }
 
+void TabletBootstrap::GetStats(BootstrapStats* stats) const {
+  stats->open_time = stats_.open_time;
+  stats->read_time = stats_.read_time;
+  stats->read_wait_time = stats_.read_wait_time;
+  stats->replay_time = stats_.replay_time;
+  stats->ops_read = stats_.ops_read;
+  stats->ops_committed = stats_.ops_committed;
+}
+
 Status TabletBootstrap::RunBootstrap(shared_ptr<Tablet>* rebuilt_tablet,
                                      scoped_refptr<Log>* rebuilt_log,
                                      ConsensusBootstrapInfo* consensus_info) {
@@ -698,7 +740,9 @@ Status TabletBootstrap::OpenTablet(bool* has_blocks) {
   // doing nothing for now except opening a tablet locally.
   {
     SCOPED_LOG_SLOW_EXECUTION_PREFIX(INFO, 100, LogPrefix(), "opening tablet");
+    const MonoTime start = MonoTime::Now();
     RETURN_NOT_OK(tablet->Open(in_flight_txn_ids_, mrs_txn_ids_));
+    stats_.open_time = MonoTime::Now() - start;
   }
   *has_blocks = tablet->num_rowsets() != 0;
   tablet_ = std::move(tablet);
@@ -904,6 +948,10 @@ Status TabletBootstrap::HandleEntry(const IOContext* io_context,
       RETURN_NOT_OK(HandleReplicateMessage(state, std::move(entry), entry_debug_info));
       break;
     case log::COMMIT:
+      if (entry->has_commit() && entry->commit().elided_num_row_ops_size() > 0) {
+        RETURN_NOT_OK(HandleElidedCommits(io_context, state, *entry, entry_debug_info));
+        break;
+      }
       // check the unpaired ops for the matching replicate msg, abort if not found
       RETURN_NOT_OK(HandleCommitMessage(io_context, state,
                                         std::move(entry), entry_debug_info));
@@ -985,6 +1033,32 @@ Status TabletBootstrap::HandleReplicateMessage(ReplayState* state,
   return Status::OK();
 }
 
+Status TabletBootstrap::HandleElidedCommits(const IOContext* io_context, ReplayState* state,
+                                            const LogEntryPB& entry,
+                                            string* entry_debug_info) {
+  const CommitMsg& elided = entry.commit();
+  if (PREDICT_FALSE(elided.op_type() != consensus::WRITE_OP || !elided.has_elided_store())) {
+    *entry_debug_info = SecureShortDebugString(entry);
+    return Status::Corruption("bad COMMIT entry for elided commits");
+  }
+  // Rebuild the COMMIT entry of each of the writes, and handle them in order.
+  for (int i = 0; i < elided.elided_num_row_ops_size(); i++) {
+    unique_ptr<LogEntryPB> commit_entry(new LogEntryPB);
+    commit_entry->set_type(log::COMMIT);
+    CommitMsg* commit = commit_entry->mutable_commit();
+    commit->set_op_type(consensus::WRITE_OP);
+    commit->mutable_commited_op_id()->set_term(elided.commited_op_id().term());
+    commit->mutable_commited_op_id()->set_index(elided.commited_op_id().index() + i);
+    TxResultPB* result = commit->mutable_result();
+    for (int j = 0; j < elided.elided_num_row_ops(i); j++) {
+      *result->add_ops()->add_mutated_stores() = elided.elided_store();
+    }
+    RETURN_NOT_OK(HandleCommitMessage(io_context, state, std::move(commit_entry),
+                                      entry_debug_info));
+  }
+  return Status::OK();
+}
+
 // On returning OK, takes ownership of the pointer from the 'entry_ptr' wrapper.
 Status TabletBootstrap::HandleCommitMessage(const IOContext* io_context, ReplayState* state,
                                             unique_ptr<LogEntryPB> entry,
@@ -1215,6 +1289,163 @@ void TabletBootstrap::DumpReplayStateToLog(const ReplayState& state) {
   }
 }
 
+namespace {
+
+// An entry read from a log segment during bootstrap.
+struct ReadLogEntry {
+  // The entry, or nullptr if this marks the end of the segment.
+  unique_ptr<LogEntryPB> entry;
+
+  // The index of the segment in the replayed sequence, and the number of
+  // entries read from it so far, this one included.
+  int segment_idx = 0;
+  int entry_count = 0;
+
+  // The offset of the reader in the segment after reading the entry, and the
+  // offset up to which it reads.
+  int64_t offset = 0;
+  int64_t read_up_to_offset = 0;
+
+  // The time spent reading and decoding the entry.
+  MonoDelta read_time;
+
+  // The approximate size of the entry.
+  size_t size_bytes = 0;
+};
+
+struct ReadLogEntryLogicalSize {
+  static size_t logical_size(const unique_ptr<ReadLogEntry>& e) {
+    return e->size_bytes;
+  }
+};
+
+// Reads the entries of a sequence of log segments, in order.
+//
+// If 'read_ahead_bytes' is positive, the entries are read and decoded on a
+// separate thread, up to 'read_ahead_bytes' ahead of the caller, so that the
+// reading of the segments from disk overlaps with the replay of the entries.
+class LogEntrySource {
+ public:
+  LogEntrySource(log::SegmentSequence segments, string tablet_id, int64_t read_ahead_bytes)
+      : segments_(std::move(segments)),
+        tablet_id_(std::move(tablet_id)),
+        read_ahead_bytes_(read_ahead_bytes),
+        cur_segment_(0),
+        entry_count_(0) {
+  }
+
+  ~LogEntrySource() {
+    if (thread_) {
+      queue_->Shutdown();
+      thread_->Join();
+    }
+  }
+
+  Status Start() {
+    if (read_ahead_bytes_ <= 0 || segments_.empty()) {
+      return Status::OK();
+    }
+    queue_.reset(new BlockingQueue<unique_ptr<ReadLogEntry>, ReadLogEntryLogicalSize>(
+        read_ahead_bytes_));
+    return Thread::Create("tablet", "bootstrap-log-reader", [this]() { ReadAhead(); },
+                          &thread_);
+  }
+
+  // Returns the next entry, or the end-of-segment marker, in 'entry'. Returns
+  // EndOfFile once all the segments have been read, or Corruption if one of
+  // them couldn't be read.
+  Status Next(unique_ptr<ReadLogEntry>* entry) {
+    if (!queue_) {
+      return ReadNext(entry);
+    }
+    Status s = queue_->BlockingGet(entry);
+    if (PREDICT_FALSE(!s.ok())) {
+      // The reader thread sets its status before shutting the queue down.
+      DCHECK(s.IsAborted());
+      return reader_status_;
+    }
+    return Status::OK();
+  }
+
+ private:
+  Status ReadNext(unique_ptr<ReadLogEntry>* out) {
+    if (cur_segment_ >= segments_.size()) {
+      return Status::EndOfFile("no more log segments");
+    }
+    const scoped_refptr<ReadableLogSegment>& segment = segments_[cur_segment_];
+    if (!reader_) {
+      reader_.reset(new log::LogEntryReader(segment.get()));
+      entry_count_ = 0;
+    }
+    unique_ptr<ReadLogEntry> e(new ReadLogEntry);
+    const MonoTime start = MonoTime::Now();
+    Status s = reader_->ReadNextEntry(&e->entry);
+    e->read_time = MonoTime::Now() - start;
+    if (PREDICT_FALSE(!s.ok())) {
+      if (!s.IsEndOfFile()) {
+        return Status::Corruption(
+            Substitute("Error reading Log Segment of tablet $0: $1 "
+                       "(Read up to entry $2 of segment $3, in path $4)",
+                       tablet_id_,
+                       s.ToString(),
+                       entry_count_,
+                       segment->header().sequence_number(),
+                       segment->path()));
+      }
+      e->entry.reset();
+    } else {
+      entry_count_++;
+      e->size_bytes = e->entry->ByteSizeLong();
+    }
+    e->segment_idx = cur_segment_;
+    e->entry_count = entry_count_;
+    e->offset = reader_->offset();
+    e->read_up_to_offset = reader_->read_up_to_offset();
+    if (!e->entry) {
+      reader_.reset();
+      cur_segment_++;
+    }
+    *out = std::move(e);
+    return Status::OK();
+  }
+
+  // Runs on 'thread_'.
+  void ReadAhead() {
+    while (true) {
+      unique_ptr<ReadLogEntry> e;
+      Status s = ReadNext(&e);
+      if (!s.ok()) {
+        reader_status_ = std::move(s);
+        break;
+      }
+      if (!queue_->BlockingPut(std::move(e)).ok()) {
+        // The replay stopped.
+        break;
+      }
+    }
+    queue_->Shutdown();
+  }
+
+  const log::SegmentSequence segments_;
+  const string tablet_id_;
+  const int64_t read_ahead_bytes_;
+
+  // The state of the reading, only accessed by the reader thread, if any.
+  size_t cur_segment_;
+  unique_ptr<log::LogEntryReader> reader_;
+  int entry_count_;
+
+  // Why the reader thread stopped. Written before 'queue_' is shut down.
+  Status reader_status_;
+
+  unique_ptr<BlockingQueue<unique_ptr<ReadLogEntry>, ReadLogEntryLogicalSize>> queue_;
+  scoped_refptr<Thread> thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogEntrySource);
+};
+
+} // anonymous namespace
+
 Status TabletBootstrap::PlaySegments(const IOContext* io_context,
                                      ConsensusBootstrapInfo* consensus_info) {
   ReplayState state;
@@ -1242,60 +1473,57 @@ Status TabletBootstrap::PlaySegments(const IOContext* io_context,
 
   auto last_status_update = MonoTime::Now();
   const auto kStatusUpdateInterval = MonoDelta::FromSeconds(5);
-  int segment_count = 0;
-
-  for (const scoped_refptr<ReadableLogSegment>& segment : segments) {
-    log::LogEntryReader reader(segment.get());
-
-    int entry_count = 0;
-    while (true) {
-      {
-        unique_ptr<LogEntryPB> entry;
-        Status s = reader.ReadNextEntry(&entry);
-        if (PREDICT_FALSE(!s.ok())) {
-          if (s.IsEndOfFile()) {
-            break;
-          }
-          return Status::Corruption(
-              Substitute("Error reading Log Segment of tablet $0: $1 "
-                         "(Read up to entry $2 of segment $3, in path $4)",
-                         tablet_->tablet_id(),
-                         s.ToString(),
-                         entry_count,
-                         segment->header().sequence_number(),
-                         segment->path()));
-        }
-        entry_count++;
-
-        string entry_debug_info;
-        s = HandleEntry(io_context, &state, std::move(entry), &entry_debug_info);
-        if (PREDICT_FALSE(!s.ok())) {
-          DumpReplayStateToLog(state);
-          RETURN_NOT_OK_PREPEND(s, DebugInfo(tablet_->tablet_id(),
-                                             segment->header().sequence_number(),
-                                             entry_count, segment->path(),
-                                             entry_debug_info));
-        }
-      }
-
-      const auto now = MonoTime::Now();
-      if (now - last_status_update > kStatusUpdateInterval) {
-        SetStatusMessage(Substitute("Bootstrap replaying log segment $0/$1 "
-                                    "($2/$3 this segment, stats: $4)",
-                                    segment_count + 1, log_reader_->num_segments(),
-                                    HumanReadableNumBytes::ToString(reader.offset()),
-                                    HumanReadableNumBytes::ToString(reader.read_up_to_offset()),
-                                    stats_.ToString()));
-        last_status_update = now;
+  const int num_segments = segments.size();
+
+  LogEntrySource source(segments, tablet_->tablet_id(),
+                        FLAGS_tablet_bootstrap_log_read_ahead_bytes);
+  RETURN_NOT_OK_PREPEND(source.Start(), "Failed to start reading the log");
+  while (true) {
+    unique_ptr<ReadLogEntry> read_entry;
+    MonoTime start = MonoTime::Now();
+    Status s = source.Next(&read_entry);
+    if (PREDICT_FALSE(!s.ok())) {
+      if (s.IsEndOfFile()) {
+        break;
       }
+      return s;
+    }
+    MonoTime now = MonoTime::Now();
+    stats_.read_time += read_entry->read_time;
+    stats_.read_wait_time += now - start;
+
+    const scoped_refptr<ReadableLogSegment>& segment = segments[read_entry->segment_idx];
+    if (!read_entry->entry) {
+      SetStatusMessage(Substitute("Bootstrap replayed $0/$1 log segments. "
+                                  "Stats: $2. Pending: $3 replicates",
+                                  read_entry->segment_idx + 1, num_segments,
+                                  stats_.ToString(),
+                                  state.pending_replicates.size()));
+      continue;
     }
 
-    SetStatusMessage(Substitute("Bootstrap replayed $0/$1 log segments. "
-                                "Stats: $2. Pending: $3 replicates",
-                                segment_count + 1, log_reader_->num_segments(),
-                                stats_.ToString(),
-                                state.pending_replicates.size()));
-    segment_count++;
+    string entry_debug_info;
+    s = HandleEntry(io_context, &state, std::move(read_entry->entry), &entry_debug_info);
+    if (PREDICT_FALSE(!s.ok())) {
+      DumpReplayStateToLog(state);
+      RETURN_NOT_OK_PREPEND(s, DebugInfo(tablet_->tablet_id(),
+                                         segment->header().sequence_number(),
+                                         read_entry->entry_count, segment->path(),
+                                         entry_debug_info));
+    }
+    start = now;
+    now = MonoTime::Now();
+    stats_.replay_time += now - start;
+
+    if (now - last_status_update > kStatusUpdateInterval) {
+      SetStatusMessage(Substitute("Bootstrap replaying log segment $0/$1 "
+                                  "($2/$3 this segment, stats: $4)",
+                                  read_entry->segment_idx + 1, num_segments,
+                                  HumanReadableNumBytes::ToString(read_entry->offset),
+                                  HumanReadableNumBytes::ToString(read_entry->read_up_to_offset),
+                                  stats_.ToString()));
+      last_status_update = now;
+    }
   }
 
   // If we have non-applied commits they all must belong to pending operations and
@@ -1642,9 +1870,19 @@ Status TabletBootstrap::PlayRowOperations(const IOContext* io_context,
   RETURN_NOT_OK_PREPEND(SchemaFromPB(op_state->request()->schema(), &inserts_schema),
                         "Couldn't decode client schema");
 
+  // Replay the inserts with the values of the auto-incrementing column that
+  // they originally got, as the counter may be persisted past them already.
+  // The counter ends up at the highest of the values seen.
+  const int64_t auto_incrementing_counter = tablet_->GetAutoIncrementingCounter();
+  if (op_state->request()->has_auto_incrementing_column()) {
+    tablet_->SetAutoIncrementingCounter(
+        op_state->request()->auto_incrementing_column().auto_incrementing_counter());
+  }
   RETURN_NOT_OK_PREPEND(tablet_->DecodeWriteOperations(&inserts_schema, op_state),
                         Substitute("Could not decode row operations: $0",
                                    SecureDebugString(op_state->request()->row_operations())));
+  tablet_->SetAutoIncrementingCounter(
+      std::max(auto_incrementing_counter, tablet_->GetAutoIncrementingCounter()));
 
   // If the write is a part of a transaction that's currently open (i.e., it
   // has an in-flight Txn associated with it), lock the Txn now and make sure
@@ -476,6 +476,52 @@ TEST_F(TabletHistoryGcTest, TestRowRemovalGCOnMergeCompaction) {
   ASSERT_EQ(0, tablet()->OnDiskDataSize());
 }
 
+// Test that the rowsets whose rows are all expired by the row TTL of the table
+// are deleted without being rewritten, and that compactions remove the expired
+// rows of the other rowsets.
+TEST_F(TabletHistoryGcTest, TestRowTtl) {
+  // As microseconds since the epoch, the keys of the original rows are all
+  // long expired.
+  NO_FATALS(InsertOriginalRows(kNumRowsets, rows_per_rowset_));
+
+  // Add a rowset with both expired rows and rows from now on.
+  const int64_t now_micros = HybridClock::GetPhysicalValueMicros(clock()->Now());
+  const int kNumLiveRows = 10;
+  LocalTabletWriter writer(tablet().get(), &client_schema_);
+  for (int i = 0; i < 2 * kNumLiveRows; i++) {
+    KuduPartialRow row(&client_schema_);
+    ASSERT_OK(row.SetInt64(0, i < kNumLiveRows ? now_micros + i : TotalNumRows() + i));
+    ASSERT_OK(row.SetInt32(1, i));
+    ASSERT_OK(row.SetInt32(2, 0));
+    ASSERT_OK(writer.Insert(row));
+  }
+  ASSERT_OK(tablet()->Flush());
+  ASSERT_EQ(kNumRowsets + 1, tablet()->num_rowsets());
+
+  TableExtraConfigPB extra_config;
+  extra_config.set_row_ttl_column("key");
+  extra_config.set_row_ttl_sec(100);
+  tablet()->metadata()->SetExtraConfig(std::move(extra_config));
+
+  // Only the original rowsets are fully expired.
+  NO_FATALS(TryRunningDeletedRowsetGC());
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  uint64_t num_rows = 0;
+  ASSERT_OK(tablet()->CountRows(&num_rows));
+  ASSERT_EQ(2 * kNumLiveRows, num_rows);
+
+  // Compacting the remaining rowset drops its expired rows.
+  ASSERT_OK(tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+  ASSERT_OK(tablet()->CountRows(&num_rows));
+  ASSERT_EQ(kNumLiveRows, num_rows);
+  NO_FATALS(TryRunningDeletedRowsetGCWithoutEffect());
+
+  // Once the remaining rows are expired too, the rowset is deleted.
+  NO_FATALS(AddTimeToHybridClock(MonoDelta::FromSeconds(200)));
+  NO_FATALS(TryRunningDeletedRowsetGC());
+  ASSERT_EQ(0, tablet()->num_rowsets());
+}
+
 // Test that we don't over-aggressively GC history prior to the AHM.
 TEST_F(TabletHistoryGcTest, TestNoUndoGCUntilAncientHistoryMark) {
   FLAGS_tablet_history_max_age_sec = 1000; // 1000 seconds before we GC history.
@@ -835,6 +881,61 @@ TEST_F(TabletHistoryGcNoMaintMgrTest, TestUndoDeltaBlockGc) {
   ASSERT_EQ(1, tablet()->metrics()->undo_delta_block_gc_delete_duration->TotalCount());
 }
 
+// Test that undo delta blocks straddling the AHM are rewritten without their
+// ancient deltas.
+TEST_F(TabletHistoryGcNoMaintMgrTest, TestUndoDeltaBlockTruncation) {
+  FLAGS_tablet_history_max_age_sec = 1000;
+
+  NO_FATALS(InsertOriginalRows(kNumRowsets, rows_per_rowset_));
+
+  // Update the rows twice, 500 seconds apart, and compact both rounds of
+  // REDOs into a single undo delta block per rowset.
+  NO_FATALS(AddTimeToHybridClock(MonoDelta::FromSeconds(1)));
+  NO_FATALS(UpdateOriginalRows(kNumRowsets, rows_per_rowset_, 1));
+  NO_FATALS(AddTimeToHybridClock(MonoDelta::FromSeconds(500)));
+  NO_FATALS(UpdateOriginalRows(kNumRowsets, rows_per_rowset_, 2));
+  const Timestamp post_update_ts = clock()->Now();
+  ASSERT_OK(tablet()->MajorCompactAllDeltaStoresForTests());
+  const int expected_undo_blocks = 2 * kNumRowsets;
+  ASSERT_EQ(expected_undo_blocks, tablet()->CountUndoDeltasForTests());
+
+  // Move the AHM halfway between the two rounds of updates.
+  NO_FATALS(AddTimeToHybridClock(MonoDelta::FromSeconds(750)));
+  const MonoDelta kNoTimeLimit = MonoDelta();
+  int64_t bytes_in_ancient_undos = 0;
+  ASSERT_OK(tablet()->InitAncientUndoDeltas(kNoTimeLimit, &bytes_in_ancient_undos));
+
+  constexpr double kMinAncientRatio = 0.25;
+  int64_t bytes;
+  ASSERT_OK(tablet()->EstimateBytesInTruncatableUndoDeltas(kMinAncientRatio, &bytes));
+  ASSERT_GT(bytes, 0);
+
+  // With a ratio above the estimate, the blocks are left alone.
+  int64_t blocks_truncated;
+  int64_t bytes_truncated;
+  ASSERT_OK(tablet()->TruncateAncientUndoDeltas(1, kNoTimeLimit,
+                                                &blocks_truncated, &bytes_truncated));
+  ASSERT_EQ(0, blocks_truncated);
+
+  ASSERT_OK(tablet()->TruncateAncientUndoDeltas(kMinAncientRatio, kNoTimeLimit,
+                                                &blocks_truncated, &bytes_truncated));
+  ASSERT_EQ(kNumRowsets, blocks_truncated);
+  ASSERT_GT(bytes_truncated, 0);
+  ASSERT_EQ(bytes_truncated,
+            tablet()->metrics()->undo_delta_block_gc_bytes_truncated->value());
+
+  // The blocks were replaced rather than removed, and nothing is left to
+  // truncate.
+  ASSERT_EQ(expected_undo_blocks, tablet()->CountUndoDeltasForTests());
+  ASSERT_OK(tablet()->EstimateBytesInTruncatableUndoDeltas(kMinAncientRatio, &bytes));
+  ASSERT_EQ(0, bytes);
+
+  // Reads past the AHM are unaffected.
+  NO_FATALS(VerifyTestRowsWithTimestampAndVerifier(kStartRow, TotalNumRows(),
+                                                   post_update_ts, kRowsEqual2));
+  NO_FATALS(VerifyTestRowsWithVerifier(kStartRow, TotalNumRows(), kRowsEqual2));
+}
+
 class TabletDeletedRowsetGcTest : public TabletHistoryGcNoMaintMgrTest,
                                   public ::testing::WithParamInterface<bool> {
 public:
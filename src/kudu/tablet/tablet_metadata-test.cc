@@ -39,6 +39,7 @@
 #include "kudu/common/wire_protocol-test-util.h"
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/fs/block_id.h"
+#include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/tablet/local_tablet_writer.h"
@@ -47,11 +48,14 @@
 #include "kudu/tablet/tablet-harness.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/tablet/txn_metadata.h"
+#include "kudu/util/env.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_bool(tablet_metadata_log_enabled);
+
 DEFINE_int64(test_row_set_count, 1000, "");
 DEFINE_int64(test_block_count_per_rs, 1000, "");
 
@@ -59,6 +63,7 @@ using kudu::log::LogAnchorRegistry;
 using kudu::log::MinLogIndexAnchorer;
 using std::map;
 using std::shared_ptr;
+using std::string;
 using std::unique_ptr;
 using std::unordered_set;
 
@@ -204,6 +209,83 @@ TEST_F(TestTabletMetadata, TestOnDiskSize) {
   ASSERT_GE(final_size, superblock_pb.ByteSizeLong());
 }
 
+// Test that the updates appended to the superblock log are applied when
+// loading the superblock, and that the log is folded into the superblock once
+// it grows larger than it.
+TEST_F(TestTabletMetadata, TestSuperBlockLog) {
+  FLAGS_tablet_metadata_log_enabled = true;
+  auto* meta = harness_->tablet()->metadata();
+  FsManager* fs_manager = harness_->fs_manager();
+  const string& tablet_id = harness_->tablet()->tablet_id();
+  const string log_path = fs_manager->GetTabletMetadataLogPath(tablet_id);
+
+  const auto make_rowset = [&] (int64_t id, shared_ptr<RowSetMetadata>* rowset) {
+    unique_ptr<RowSetMetadata> rs_meta;
+    RETURN_NOT_OK(RowSetMetadata::CreateNew(meta, id, &rs_meta));
+    map<ColumnId, BlockId> block_by_column;
+    for (int j = 0; j < 10; ++j) {
+      block_by_column[ColumnId(j)] = BlockId(1000 + 10 * id + j);
+    }
+    rs_meta->SetColumnDataBlocks(block_by_column);
+    *rowset = shared_ptr<RowSetMetadata>(rs_meta.release());
+    return Status::OK();
+  };
+  const auto check_superblocks_match = [&] {
+    scoped_refptr<TabletMetadata> new_meta;
+    ASSERT_OK(TabletMetadata::Load(fs_manager, tablet_id, &new_meta));
+    TabletSuperBlockPB expected;
+    ASSERT_OK(meta->ToSuperBlock(&expected));
+    TabletSuperBlockPB actual;
+    ASSERT_OK(new_meta->ToSuperBlock(&actual));
+    ASSERT_EQ(expected.SerializeAsString(), actual.SerializeAsString())
+        << pb_util::SecureDebugString(expected)
+        << pb_util::SecureDebugString(actual);
+  };
+
+  // The first flush with the log enabled writes the full superblock.
+  RowSetMetadataVector rs_metas;
+  for (int i = 0; i < 20; ++i) {
+    shared_ptr<RowSetMetadata> rowset;
+    ASSERT_OK(make_rowset(i, &rowset));
+    rs_metas.emplace_back(std::move(rowset));
+  }
+  ASSERT_OK(meta->UpdateAndFlush(RowSetMetadataIds(), rs_metas, TabletMetadata::kNoMrsFlushed));
+  ASSERT_FALSE(fs_manager->GetEnv()->FileExists(log_path));
+
+  // The next ones append their changes to the log.
+  shared_ptr<RowSetMetadata> rowset;
+  ASSERT_OK(make_rowset(20, &rowset));
+  ASSERT_OK(meta->UpdateAndFlush({ 3, 7 }, { rowset }, TabletMetadata::kNoMrsFlushed));
+  ASSERT_TRUE(fs_manager->GetEnv()->FileExists(log_path));
+  ASSERT_OK(make_rowset(21, &rowset));
+  ASSERT_OK(meta->UpdateAndFlush({ 0 }, { rowset }, TabletMetadata::kNoMrsFlushed));
+  NO_FATALS(check_superblocks_match());
+
+  TabletSuperBlockPB superblock;
+  ASSERT_OK(TabletMetadata::ReadSuperBlockFromDisk(fs_manager, tablet_id, &superblock));
+  ASSERT_EQ(19, superblock.rowsets_size());
+  ASSERT_EQ(21, superblock.rowsets(18).id());
+
+  // Once the log grows larger than the superblock, the superblock is
+  // rewritten and the log removed.
+  int flushes = 0;
+  while (fs_manager->GetEnv()->FileExists(log_path)) {
+    ASSERT_LT(flushes++, 1000);
+    ASSERT_OK(meta->Flush());
+  }
+  NO_FATALS(check_superblocks_match());
+
+  // The updates keep being appended to a new log afterwards, and the log is
+  // removed by the first flush with it disabled.
+  ASSERT_OK(meta->UpdateAndFlush({ 1 }, {}, TabletMetadata::kNoMrsFlushed));
+  ASSERT_TRUE(fs_manager->GetEnv()->FileExists(log_path));
+  NO_FATALS(check_superblocks_match());
+  FLAGS_tablet_metadata_log_enabled = false;
+  ASSERT_OK(meta->Flush());
+  ASSERT_FALSE(fs_manager->GetEnv()->FileExists(log_path));
+  NO_FATALS(check_superblocks_match());
+}
+
 TEST_F(TestTabletMetadata, BenchmarkCollectBlockIds) {
   auto tablet_meta = harness_->tablet()->metadata();
   RowSetMetadataVector rs_metas;
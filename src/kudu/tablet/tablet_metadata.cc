@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <ostream>
@@ -28,6 +29,7 @@
 #include <utility>
 
 #include <gflags/gflags.h>
+#include <google/protobuf/repeated_field.h>
 
 #include "kudu/common/common.pb.h"
 #include "kudu/common/schema.h"
@@ -42,6 +44,7 @@
 #include "kudu/fs/fs.pb.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/atomicops.h"
+#include "kudu/gutil/hash/city.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -53,6 +56,7 @@
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/status.h"
@@ -71,6 +75,17 @@ DEFINE_int32(tablet_metadata_load_inject_latency_ms, 0,
              "Only for testing.");
 TAG_FLAG(tablet_metadata_load_inject_latency_ms, hidden);
 
+DEFINE_bool(tablet_metadata_log_enabled, false,
+            "Whether to persist tablet metadata updates incrementally, by "
+            "appending the changes of the superblock to a log next to it "
+            "instead of rewriting the whole superblock on every flush. The "
+            "whole superblock is rewritten once the log grows larger than it. "
+            "Note: versions of Kudu that don't support the log ignore it, so "
+            "the tablet metadata must be flushed with this disabled before "
+            "downgrading.");
+TAG_FLAG(tablet_metadata_log_enabled, experimental);
+TAG_FLAG(tablet_metadata_log_enabled, runtime);
+
 using base::subtle::Barrier_AtomicIncrement;
 using kudu::consensus::MinimumOpId;
 using kudu::consensus::OpId;
@@ -94,6 +109,52 @@ using strings::Substitute;
 namespace kudu {
 namespace tablet {
 
+namespace {
+
+uint64_t FingerprintRowSet(const RowSetDataPB& rowset) {
+  string data;
+  rowset.SerializeToString(&data);
+  return util_hash::CityHash64(data.data(), data.size());
+}
+
+// Applies 'update' from the superblock log to 'superblock', consuming it.
+void ApplySuperBlockUpdate(TabletSuperBlockUpdatePB* update,
+                           TabletSuperBlockPB* superblock) {
+  google::protobuf::RepeatedPtrField<RowSetDataPB> old_rowsets;
+  old_rowsets.Swap(superblock->mutable_rowsets());
+  superblock->Swap(update->mutable_superblock());
+  superblock->clear_rowsets();
+  superblock->set_log_sequence_number(update->sequence_number());
+
+  const unordered_set<uint64_t> removed(update->removed_rowset_ids().begin(),
+                                        update->removed_rowset_ids().end());
+  unordered_map<uint64_t, RowSetDataPB*> updated;
+  for (auto& rowset : *update->mutable_updated_rowsets()) {
+    updated.emplace(rowset.id(), &rowset);
+  }
+  // The rowsets which were already there keep their position, and the ones
+  // added since follow them, like in TabletMetadata::UpdateUnlocked().
+  for (auto& rowset : old_rowsets) {
+    if (ContainsKey(removed, rowset.id())) {
+      continue;
+    }
+    auto it = updated.find(rowset.id());
+    if (it == updated.end()) {
+      superblock->add_rowsets()->Swap(&rowset);
+    } else {
+      superblock->add_rowsets()->Swap(it->second);
+      updated.erase(it);
+    }
+  }
+  for (auto& rowset : *update->mutable_updated_rowsets()) {
+    if (rowset.has_id() && ContainsKey(updated, rowset.id())) {
+      superblock->add_rowsets()->Swap(&rowset);
+    }
+  }
+}
+
+} // anonymous namespace
+
 // ============================================================================
 //  Tablet Metadata
 // ============================================================================
@@ -195,8 +256,13 @@ Status TabletMetadata::LoadOrCreate(FsManager* fs_manager,
 vector<BlockIdPB> TabletMetadata::CollectBlockIdPBs(const TabletSuperBlockPB& superblock) {
   vector<BlockIdPB> block_ids;
   for (const RowSetDataPB& rowset : superblock.rowsets()) {
+    // The columns of a column group share its block.
+    BlockIdSet column_blocks;
     for (const ColumnDataPB& column : rowset.columns()) {
-      block_ids.push_back(column.block());
+      if (!column.in_column_group() ||
+          InsertIfNotPresent(&column_blocks, BlockId::FromPB(column.block()))) {
+        block_ids.push_back(column.block());
+      }
     }
     for (const DeltaDataPB& redo : rowset.redo_deltas()) {
       block_ids.push_back(redo.block());
@@ -285,6 +351,7 @@ bool TabletMetadata::IsTombstonedWithNoBlocks() const {
 }
 
 Status TabletMetadata::DeleteSuperBlock() {
+  std::lock_guard l_flush(flush_lock_);
   std::lock_guard<LockType> l(data_lock_);
   if (!orphaned_blocks_.empty()) {
     return Status::InvalidArgument("The metadata for tablet " + tablet_id_ +
@@ -301,6 +368,13 @@ Status TabletMetadata::DeleteSuperBlock() {
                    tablet_data_state_));
   }
 
+  string log_path = fs_manager_->GetTabletMetadataLogPath(tablet_id_);
+  log_writer_.reset();
+  flushed_rowset_fingerprints_.reset();
+  if (fs_manager_->GetEnv()->FileExists(log_path)) {
+    RETURN_NOT_OK_PREPEND(fs_manager_->GetEnv()->DeleteFile(log_path),
+                          "Unable to delete superblock log for tablet " + tablet_id_);
+  }
   string path = fs_manager_->GetTabletMetadataPath(tablet_id_);
   RETURN_NOT_OK_PREPEND(fs_manager_->GetEnv()->DeleteFile(path),
                         "Unable to delete superblock for tablet " + tablet_id_);
@@ -337,6 +411,8 @@ TabletMetadata::TabletMetadata(FsManager* fs_manager, string tablet_id,
       num_flush_pins_(0),
       needs_flush_(false),
       flush_count_for_tests_(0),
+      log_sequence_number_(0),
+      full_superblock_size_(0),
       pre_flush_callback_(&DoNothingStatusClosure),
       supports_live_row_count_(supports_live_row_count) {
   CHECK(schema_->has_column_ids());
@@ -354,6 +430,8 @@ TabletMetadata::TabletMetadata(FsManager* fs_manager, string tablet_id)
       num_flush_pins_(0),
       needs_flush_(false),
       flush_count_for_tests_(0),
+      log_sequence_number_(0),
+      full_superblock_size_(0),
       pre_flush_callback_(&DoNothingStatusClosure),
       supports_live_row_count_(false) {}
 
@@ -367,6 +445,7 @@ Status TabletMetadata::LoadFromDisk() {
   RETURN_NOT_OK(ReadSuperBlockFromDisk(&superblock));
   RETURN_NOT_OK_PREPEND(LoadFromSuperBlock(superblock),
                         "Failed to load data from superblock protobuf");
+  log_sequence_number_ = superblock.log_sequence_number();
   RETURN_NOT_OK(UpdateOnDiskSize());
   state_ = kInitialized;
   return Status::OK();
@@ -376,6 +455,12 @@ Status TabletMetadata::UpdateOnDiskSize() {
   string path = fs_manager_->GetTabletMetadataPath(tablet_id_);
   uint64_t on_disk_size;
   RETURN_NOT_OK(fs_manager()->GetEnv()->GetFileSize(path, &on_disk_size));
+  string log_path = fs_manager_->GetTabletMetadataLogPath(tablet_id_);
+  if (fs_manager_->GetEnv()->FileExists(log_path)) {
+    uint64_t log_size;
+    RETURN_NOT_OK(fs_manager_->GetEnv()->GetFileSize(log_path, &log_size));
+    on_disk_size += log_size;
+  }
   on_disk_size_.store(on_disk_size, memory_order_relaxed);
   return Status::OK();
 }
@@ -509,6 +594,12 @@ Status TabletMetadata::LoadFromSuperBlock(const TabletSuperBlockPB& superblock)
       dimension_label_.reset();
     }
 
+    if (superblock.has_auto_incrementing_counter()) {
+      auto_incrementing_counter_ = superblock.auto_incrementing_counter();
+    } else {
+      auto_incrementing_counter_.reset();
+    }
+
     if (superblock.has_table_type() && superblock.table_type() != TableTypePB::DEFAULT_TABLE) {
       table_type_ = superblock.table_type();
     }
@@ -637,7 +728,22 @@ Status TabletMetadata::Flush() {
     anchors_needing_flush = std::move(anchors_needing_flush_);
   }
   pre_flush_callback_();
-  RETURN_NOT_OK(ReplaceSuperBlockUnlocked(pb));
+  const bool log_enabled = FLAGS_tablet_metadata_log_enabled;
+  unordered_map<uint64_t, uint64_t> rowset_fingerprints;
+  bool appended = false;
+  if (log_enabled) {
+    for (const auto& rowset : pb.rowsets()) {
+      rowset_fingerprints.emplace(rowset.id(), FingerprintRowSet(rowset));
+    }
+    RETURN_NOT_OK(MaybeAppendSuperBlockUpdateUnlocked(&pb, rowset_fingerprints, &appended));
+  }
+  if (!appended) {
+    pb.set_log_sequence_number(log_sequence_number_);
+    RETURN_NOT_OK(ReplaceSuperBlockUnlocked(pb));
+  }
+  if (log_enabled) {
+    flushed_rowset_fingerprints_ = std::move(rowset_fingerprints);
+  }
   TRACE("Metadata flushed");
   l_flush.unlock();
 
@@ -713,11 +819,91 @@ Status TabletMetadata::ReplaceSuperBlockUnlocked(const TabletSuperBlockPB &pb) {
                             pb_util::SENSITIVE),
                         Substitute("Failed to write tablet metadata $0", tablet_id_));
   flush_count_for_tests_++;
+  full_superblock_size_ = pb.ByteSizeLong();
+  flushed_rowset_fingerprints_.reset();
+
+  // The superblock now includes every update of the log, so get rid of it. If
+  // we crash before doing so, its updates are skipped at load time since
+  // their sequence numbers aren't past the superblock's.
+  log_writer_.reset();
+  string log_path = fs_manager_->GetTabletMetadataLogPath(tablet_id_);
+  if (fs_manager_->GetEnv()->FileExists(log_path)) {
+    RETURN_NOT_OK_PREPEND(fs_manager_->GetEnv()->DeleteFile(log_path),
+                          Substitute("Failed to delete superblock log of tablet $0", tablet_id_));
+  }
   RETURN_NOT_OK(UpdateOnDiskSize());
 
   return Status::OK();
 }
 
+Status TabletMetadata::MaybeAppendSuperBlockUpdateUnlocked(
+    TabletSuperBlockPB* pb,
+    const unordered_map<uint64_t, uint64_t>& rowset_fingerprints,
+    bool* appended) {
+  flush_lock_.AssertAcquired();
+  *appended = false;
+  if (!flushed_rowset_fingerprints_) {
+    return Status::OK();
+  }
+  const auto& flushed_fingerprints = *flushed_rowset_fingerprints_;
+
+  TabletSuperBlockUpdatePB update;
+  update.set_sequence_number(log_sequence_number_ + 1);
+  for (const auto& rowset : pb->rowsets()) {
+    const uint64_t* flushed = FindOrNull(flushed_fingerprints, rowset.id());
+    if (!flushed || *flushed != FindOrDie(rowset_fingerprints, rowset.id())) {
+      *update.add_updated_rowsets() = rowset;
+    }
+  }
+  for (const auto& e : flushed_fingerprints) {
+    if (!ContainsKey(rowset_fingerprints, e.first)) {
+      update.add_removed_rowset_ids(e.first);
+    }
+  }
+  // Copy everything but the rowsets, which are the bulk of the superblock.
+  google::protobuf::RepeatedPtrField<RowSetDataPB> rowsets;
+  rowsets.Swap(pb->mutable_rowsets());
+  *update.mutable_superblock() = *pb;
+  rowsets.Swap(pb->mutable_rowsets());
+
+  const uint64_t log_size = log_writer_ ? log_writer_->Offset() : 0;
+  if (log_size + update.ByteSizeLong() > full_superblock_size_) {
+    return Status::OK();
+  }
+
+  Env* env = fs_manager_->GetEnv();
+  if (!log_writer_) {
+    string path = fs_manager_->GetTabletMetadataLogPath(tablet_id_);
+    RWFileOptions opts;
+    opts.mode = Env::CREATE_OR_OPEN_WITH_TRUNCATE;
+    opts.is_sensitive = true;
+    unique_ptr<RWFile> file;
+    RETURN_NOT_OK_PREPEND(env->NewRWFile(opts, path, &file),
+                          Substitute("Failed to create superblock log of tablet $0", tablet_id_));
+    auto writer = std::make_unique<pb_util::WritablePBContainerFile>(std::move(file));
+    RETURN_NOT_OK(writer->CreateNew(TabletSuperBlockUpdatePB()));
+    RETURN_NOT_OK(writer->Sync());
+    RETURN_NOT_OK(env->SyncDir(DirName(path)));
+    log_writer_ = std::move(writer);
+  }
+  Status s = log_writer_->Append(update);
+  if (s.ok()) {
+    s = log_writer_->Sync();
+  }
+  if (PREDICT_FALSE(!s.ok())) {
+    // The log may now end with a partial update: write the full superblock
+    // on the next flush, which gets rid of the log.
+    log_writer_.reset();
+    flushed_rowset_fingerprints_.reset();
+    return s.CloneAndPrepend(
+        Substitute("Failed to append to superblock log of tablet $0", tablet_id_));
+  }
+  log_sequence_number_ = update.sequence_number();
+  flush_count_for_tests_++;
+  *appended = true;
+  return UpdateOnDiskSize();
+}
+
 void TabletMetadata::SetPreFlushCallback(StatusClosure callback) {
   std::lock_guard l(flush_lock_);
   pre_flush_callback_ = std::move(callback);
@@ -729,11 +915,56 @@ std::optional<consensus::OpId> TabletMetadata::tombstone_last_logged_opid() cons
 }
 
 Status TabletMetadata::ReadSuperBlockFromDisk(TabletSuperBlockPB* superblock) const {
-  string path = fs_manager_->GetTabletMetadataPath(tablet_id_);
+  std::lock_guard l(flush_lock_);
+  return ReadSuperBlockFromDisk(fs_manager_, tablet_id_, superblock);
+}
+
+Status TabletMetadata::ReadSuperBlockFromDisk(FsManager* fs_manager,
+                                              const string& tablet_id,
+                                              TabletSuperBlockPB* superblock) {
+  Env* env = fs_manager->GetEnv();
+  string path = fs_manager->GetTabletMetadataPath(tablet_id);
   RETURN_NOT_OK_PREPEND(
-      pb_util::ReadPBContainerFromPath(fs_manager_->GetEnv(), path, superblock, pb_util::SENSITIVE),
+      pb_util::ReadPBContainerFromPath(env, path, superblock, pb_util::SENSITIVE),
       Substitute("Could not load tablet metadata from $0", path));
-  return Status::OK();
+
+  string log_path = fs_manager->GetTabletMetadataLogPath(tablet_id);
+  if (!env->FileExists(log_path)) {
+    return Status::OK();
+  }
+  RandomAccessFileOptions opts;
+  opts.is_sensitive = true;
+  unique_ptr<RandomAccessFile> file;
+  RETURN_NOT_OK_PREPEND(env->NewRandomAccessFile(opts, log_path, &file),
+                        Substitute("Could not open superblock log $0", log_path));
+  pb_util::ReadablePBContainerFile reader(std::move(file));
+  Status s = reader.Open();
+  if (s.IsIncomplete()) {
+    // We crashed while creating the log, before appending any update to it.
+    return Status::OK();
+  }
+  RETURN_NOT_OK_PREPEND(s, Substitute("Could not open superblock log $0", log_path));
+  while (true) {
+    TabletSuperBlockUpdatePB update;
+    s = reader.ReadNextPB(&update);
+    if (s.IsEndOfFile()) {
+      break;
+    }
+    if (s.IsIncomplete()) {
+      // We crashed while appending this update, so its flush never completed.
+      LOG(WARNING) << Substitute("Ignoring partial update at the end of superblock log $0: $1",
+                                 log_path, s.ToString());
+      break;
+    }
+    RETURN_NOT_OK_PREPEND(s, Substitute("Could not read superblock log $0", log_path));
+    // Skip the updates which were already part of the superblock when it was
+    // last rewritten.
+    if (update.sequence_number() <= superblock->log_sequence_number()) {
+      continue;
+    }
+    ApplySuperBlockUpdate(&update, superblock);
+  }
+  return reader.Close();
 }
 
 Status TabletMetadata::ToSuperBlock(TabletSuperBlockPB* super_block) const {
@@ -796,6 +1027,10 @@ Status TabletMetadata::ToSuperBlockUnlocked(TabletSuperBlockPB* super_block,
     pb.set_dimension_label(*dimension_label_);
   }
 
+  if (auto_incrementing_counter_) {
+    pb.set_auto_incrementing_counter(*auto_incrementing_counter_);
+  }
+
   if (table_type_) {
     DCHECK_NE(TableTypePB::DEFAULT_TABLE, *table_type_);
     pb.set_table_type(*table_type_);
@@ -1009,6 +1244,18 @@ optional<string> TabletMetadata::dimension_label() const {
   return dimension_label_;
 }
 
+void TabletMetadata::UpdateAutoIncrementingCounter(int64_t counter) {
+  std::lock_guard<LockType> l(data_lock_);
+  if (!auto_incrementing_counter_ || *auto_incrementing_counter_ < counter) {
+    auto_incrementing_counter_ = counter;
+  }
+}
+
+optional<int64_t> TabletMetadata::auto_incrementing_counter() const {
+  std::lock_guard<LockType> l(data_lock_);
+  return auto_incrementing_counter_;
+}
+
 const optional<TableTypePB>& TabletMetadata::table_type() const {
   std::lock_guard<LockType> l(data_lock_);
   return table_type_;
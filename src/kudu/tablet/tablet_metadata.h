@@ -48,6 +48,10 @@ class BlockIdPB;
 class FsManager;
 class Timestamp;
 
+namespace pb_util {
+class WritablePBContainerFile;
+}
+
 namespace log {
 class MinLogIndexAnchorer;
 } // namespace log
@@ -79,6 +83,12 @@ constexpr int64_t kNoDurableMemStore = -1;
 // At startup, the TSTabletManager will load a TabletMetadata for each
 // super block found in the tablets/ directory, and then instantiate
 // tablets from this data.
+//
+// If --tablet_metadata_log_enabled is set, a flush may append only the changes
+// of the superblock since the previous flush to the tablet's superblock log
+// instead of rewriting the whole superblock, whose rowsets may take megabytes.
+// The whole superblock is rewritten, and the log removed, once the log grows
+// larger than it.
 class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
  public:
   // Create metadata for a new tablet. This assumes that the given superblock
@@ -157,6 +167,10 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
 
   void SetExtraConfig(TableExtraConfigPB extra_config);
 
+  // Raises the persisted counter of the auto-incrementing column to
+  // 'counter', if it's lower. This is persisted upon the next Flush().
+  void UpdateAutoIncrementingCounter(int64_t counter);
+
   // Return a scoped_refptr to the current schema.
   // This pointer will be valid until the TabletMetadata is destructed,
   // even if the schema is changed.
@@ -308,9 +322,20 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // Returns the table's dimension label.
   std::optional<std::string> dimension_label() const;
 
+  // Returns the counter of the auto-incrementing column as of the last call to
+  // UpdateAutoIncrementingCounter(), or none if it was never persisted.
+  std::optional<int64_t> auto_incrementing_counter() const;
+
   // Loads the currently-flushed superblock from disk into the given protobuf.
   Status ReadSuperBlockFromDisk(TabletSuperBlockPB* superblock) const;
 
+  // Loads the superblock of the given tablet from disk into the given
+  // protobuf, applying the updates of its superblock log if any. The
+  // superblock must not be flushed concurrently.
+  static Status ReadSuperBlockFromDisk(FsManager* fs_manager,
+                                       const std::string& tablet_id,
+                                       TabletSuperBlockPB* superblock);
+
   // Sets *super_block to the serialized form of the current metadata.
   Status ToSuperBlock(TabletSuperBlockPB* super_block) const;
 
@@ -382,10 +407,21 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // Updates the cached on-disk size of the tablet superblock.
   Status UpdateOnDiskSize();
 
-  // Fully replace superblock.
+  // Fully replace superblock, removing the superblock log.
   // Requires 'flush_lock_'.
   Status ReplaceSuperBlockUnlocked(const TabletSuperBlockPB& pb);
 
+  // Appends the changes of 'pb' since the last flush to the superblock log,
+  // unless the log would grow larger than the full superblock. Sets
+  // 'appended' to whether it did; if not, the caller must replace the whole
+  // superblock with 'pb'. 'rowset_fingerprints' are the fingerprints of the
+  // rowsets of 'pb', by rowset ID. 'pb' is left unchanged on return.
+  // Requires 'flush_lock_'.
+  Status MaybeAppendSuperBlockUpdateUnlocked(
+      TabletSuperBlockPB* pb,
+      const std::unordered_map<uint64_t, uint64_t>& rowset_fingerprints,
+      bool* appended);
+
   // Requires 'data_lock_'.
   Status UpdateUnlocked(const RowSetMetadataIds& to_remove,
                         const RowSetMetadataVector& to_add,
@@ -420,7 +456,7 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
 
   // Lock protecting flushing the data to disk.
   // If taken together with 'data_lock_', must be acquired first.
-  Mutex flush_lock_;
+  mutable Mutex flush_lock_;
 
   const std::string tablet_id_;
   std::string table_id_;
@@ -465,6 +501,10 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // Tablet's dimension label.
   std::optional<std::string> dimension_label_;
 
+  // The counter of the auto-incrementing column, if any.
+  // Protected by 'data_lock_'.
+  std::optional<int64_t> auto_incrementing_counter_;
+
   // The table type of the table this tablet belongs to.
   std::optional<TableTypePB> table_type_;
 
@@ -480,6 +520,21 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // The number of times metadata has been flushed to disk
   int flush_count_for_tests_;
 
+  // The state of the superblock log, protected by 'flush_lock_'.
+  //
+  // The sequence number of the last update written, either to the log or as
+  // part of the full superblock.
+  int64_t log_sequence_number_;
+  // The open superblock log, if any update was appended to it since the full
+  // superblock was last written.
+  std::unique_ptr<pb_util::WritablePBContainerFile> log_writer_;
+  // The size of the full superblock last written.
+  uint64_t full_superblock_size_;
+  // The fingerprints of the rowsets as of the last flush, by rowset ID, or
+  // none if the next flush must write the full superblock, e.g. when the
+  // metadata was just loaded.
+  std::optional<std::unordered_map<uint64_t, uint64_t>> flushed_rowset_fingerprints_;
+
   // A callback that, if set, is called before this metadata is flushed
   // to disk. Protected by the 'flush_lock_'.
   StatusClosure pre_flush_callback_;
@@ -110,6 +110,11 @@ METRIC_DEFINE_counter(tablet, scanner_predicates_disabled, "Scanner Column Predi
                       "Bloom filter predicate that are automatically disabled if determined to "
                       "be ineffective.",
                       kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(tablet, scanner_cells_skipped, "Scanner Cells Skipped",
+                      kudu::MetricUnit::kCells,
+                      "Number of table cells which scanners didn't decode because their "
+                      "rows had already been filtered out by the predicates on other columns.",
+                      kudu::MetricLevel::kDebug);
 
 METRIC_DEFINE_counter(tablet, scanner_rows_scanned, "Scanner Rows Scanned",
                       kudu::MetricUnit::kRows,
@@ -174,6 +179,59 @@ METRIC_DEFINE_histogram(tablet, scan_duration_user_time,
                         kudu::MetricLevel::kDebug,
                         60000LU, 1);
 
+METRIC_DEFINE_counter(tablet, scanner_cpu_user_time, "Scanner CPU User Time",
+                      kudu::MetricUnit::kMicroseconds,
+                      "Total user CPU time spent by the threads handling the scan "
+                      "requests of this tablet.",
+                      kudu::MetricLevel::kInfo);
+METRIC_DEFINE_counter(tablet, scanner_cpu_system_time, "Scanner CPU System Time",
+                      kudu::MetricUnit::kMicroseconds,
+                      "Total system CPU time spent by the threads handling the scan "
+                      "requests of this tablet.",
+                      kudu::MetricLevel::kInfo);
+
+METRIC_DEFINE_counter(tablet, apply_cpu_user_time, "Apply CPU User Time",
+                      kudu::MetricUnit::kMicroseconds,
+                      "Total user CPU time spent by the apply threads applying the "
+                      "operations of this tablet.",
+                      kudu::MetricLevel::kInfo);
+METRIC_DEFINE_counter(tablet, apply_cpu_system_time, "Apply CPU System Time",
+                      kudu::MetricUnit::kMicroseconds,
+                      "Total system CPU time spent by the apply threads applying the "
+                      "operations of this tablet.",
+                      kudu::MetricLevel::kInfo);
+METRIC_DEFINE_gauge_size(tablet, tablet_applying_ops, "Applying Operations",
+                         kudu::MetricUnit::kOperations,
+                         "Number of operations of this tablet being applied right now. "
+                         "Operations that hold disjoint sets of row locks are applied "
+                         "concurrently by the threads of the apply pool.",
+                         kudu::MetricLevel::kDebug);
+METRIC_DEFINE_histogram(tablet, op_apply_concurrency, "Operation Apply Concurrency",
+                        kudu::MetricUnit::kOperations,
+                        "Number of operations of this tablet being applied, including the "
+                        "one sampling it, when each operation starts to be applied.",
+                        kudu::MetricLevel::kDebug,
+                        1024, 2);
+
+METRIC_DEFINE_counter(tablet, cfile_cache_hits, "CFile Cache Hits",
+                      kudu::MetricUnit::kCacheHits,
+                      "Number of lookups of CFile blocks of this tablet in the block "
+                      "cache which found the block, by scans, writes and maintenance "
+                      "operations.",
+                      kudu::MetricLevel::kInfo);
+METRIC_DEFINE_counter(tablet, cfile_cache_misses, "CFile Cache Misses",
+                      kudu::MetricUnit::kCacheQueries,
+                      "Number of lookups of CFile blocks of this tablet in the block "
+                      "cache which didn't find the block, by scans, writes and "
+                      "maintenance operations.",
+                      kudu::MetricLevel::kInfo);
+METRIC_DEFINE_counter(tablet, cfile_bytes_read, "CFile Bytes Read",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes of CFile blocks of this tablet read from disk "
+                      "upon block cache misses, by scans, writes and maintenance "
+                      "operations.",
+                      kudu::MetricLevel::kInfo);
+
 METRIC_DEFINE_counter(tablet, bloom_lookups, "Bloom Filter Lookups",
                       kudu::MetricUnit::kProbes,
                       "Number of times a bloom filter was consulted",
@@ -190,6 +248,14 @@ METRIC_DEFINE_counter(tablet, mrs_lookups, "MemRowSet Lookups",
                       kudu::MetricUnit::kProbes,
                       "Number of times a MemRowSet was consulted.",
                       kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(tablet, presence_checks_skipped_above_rowsets,
+                      "Presence Checks Skipped Above DiskRowSets",
+                      kudu::MetricUnit::kRows,
+                      "Number of rows written whose key was above the keys of all of the "
+                      "DiskRowSets of the tablet, so that no DiskRowSet was consulted to check "
+                      "whether the row already existed. With increasing keys, this is the case "
+                      "of most inserts and upserts.",
+                      kudu::MetricLevel::kDebug);
 METRIC_DEFINE_counter(tablet, bytes_flushed, "Bytes Flushed",
                       kudu::MetricUnit::kBytes,
                       "Amount of data that has been flushed to disk by this tablet.",
@@ -203,12 +269,28 @@ METRIC_DEFINE_counter(tablet, undo_delta_block_gc_bytes_deleted,
                       "Does not include bytes garbage collected during compactions.",
                       kudu::MetricLevel::kDebug);
 
+METRIC_DEFINE_counter(tablet, undo_delta_block_gc_bytes_truncated,
+                      "Undo Delta Block GC Bytes Truncated",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes reclaimed by rewriting UNDO delta blocks without "
+                      "their ancient deltas on this tablet since this server was restarted. "
+                      "Does not include bytes garbage collected during compactions.",
+                      kudu::MetricLevel::kDebug);
+
 METRIC_DEFINE_counter(tablet, deleted_rowset_gc_bytes_deleted,
                       "Deleted Rowsets GC Bytes Deleted",
                       kudu::MetricUnit::kBytes,
                       "Number of bytes deleted by garbage-collecting deleted rowsets.",
                       kudu::MetricLevel::kDebug);
 
+METRIC_DEFINE_counter(tablet, cold_rowset_bytes_moved,
+                      "Cold Rowset Bytes Moved",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes of rowsets moved onto the cold storage tier "
+                      "because their data is older than the table's "
+                      "'kudu.table.cold_data_age_sec'.",
+                      kudu::MetricLevel::kDebug);
+
 METRIC_DEFINE_counter(tablet, ops_timed_out_in_prepare_queue,
                       "Number of Requests Timed Out In Prepare Queue",
                       kudu::MetricUnit::kRequests,
@@ -330,6 +412,12 @@ METRIC_DEFINE_gauge_int64(tablet, undo_delta_block_estimated_retained_bytes,
   "May be an overestimate.",
   kudu::MetricLevel::kDebug);
 
+METRIC_DEFINE_gauge_uint32(tablet, move_cold_rowset_running,
+  "Cold Rowset Moves Running",
+  kudu::MetricUnit::kMaintenanceOperations,
+  "Number of operations moving rowsets onto the cold storage tier currently running.",
+  kudu::MetricLevel::kDebug);
+
 METRIC_DEFINE_gauge_uint32(tablet, deleted_rowset_gc_running,
   "Deleted Rowset GC Running",
   kudu::MetricUnit::kMaintenanceOperations,
@@ -413,6 +501,13 @@ METRIC_DEFINE_histogram(tablet, compact_rs_mem_usage_to_deltas_size_ratio,
   kudu::MetricLevel::kDebug,
   60000LU, 1);
 
+METRIC_DEFINE_histogram(tablet, move_cold_rowset_duration,
+  "Cold Rowset Move Duration",
+  kudu::MetricUnit::kMilliseconds,
+  "Time spent moving rowsets onto the cold storage tier.",
+  kudu::MetricLevel::kDebug,
+  60000LU, 1);
+
 METRIC_DEFINE_histogram(tablet, deleted_rowset_gc_duration,
   "Deleted Rowset GC Duration",
   kudu::MetricUnit::kMilliseconds,
@@ -426,6 +521,27 @@ METRIC_DEFINE_counter(tablet, leader_memory_pressure_rejections,
   "Number of RPC requests rejected due to memory pressure while LEADER.",
   kudu::MetricLevel::kWarn);
 
+METRIC_DEFINE_counter(tablet, scan_quota_rejections,
+  "Scan Quota Rejections",
+  kudu::MetricUnit::kRequests,
+  "Number of Scan RPC requests rejected because the scan quota of the table "
+  "or of the user was exceeded.",
+  kudu::MetricLevel::kInfo);
+
+METRIC_DEFINE_counter(tablet, checksum_rowsets_reused,
+  "Checksum Scan Rowsets Reused",
+  kudu::MetricUnit::kUnits,
+  "Number of rowsets whose checksums, as cached by a previous checksum scan, "
+  "were reused by a checksum scan rather than scanning the rowsets again.",
+  kudu::MetricLevel::kDebug);
+
+METRIC_DEFINE_counter(tablet, write_quota_rejections,
+  "Write Quota Rejections",
+  kudu::MetricUnit::kRequests,
+  "Number of Write RPC requests rejected because the write quota of the table "
+  "or of the user was exceeded.",
+  kudu::MetricLevel::kInfo);
+
 METRIC_DEFINE_gauge_double(tablet, average_diskrowset_height, "Average DiskRowSet Height",
                            kudu::MetricUnit::kUnits,
                            "Average height of the diskrowsets in this tablet "
@@ -459,18 +575,28 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(scanner_cells_scanned_from_disk),
     MINIT(scanner_bytes_scanned_from_disk),
     MINIT(scanner_predicates_disabled),
+    MINIT(scanner_cells_skipped),
     MINIT(scans_started),
     GINIT(tablet_active_scanners),
     MINIT(scan_duration_wall_time),
     MINIT(scan_duration_system_time),
     MINIT(scan_duration_user_time),
+    MINIT(scanner_cpu_user_time),
+    MINIT(scanner_cpu_system_time),
+    MINIT(apply_cpu_user_time),
+    MINIT(apply_cpu_system_time),
+    GINIT(tablet_applying_ops),
+    MINIT(op_apply_concurrency),
     MINIT(bloom_lookups),
     MINIT(key_file_lookups),
     MINIT(delta_file_lookups),
     MINIT(mrs_lookups),
+    MINIT(presence_checks_skipped_above_rowsets),
     MINIT(bytes_flushed),
     MINIT(deleted_rowset_gc_bytes_deleted),
     MINIT(undo_delta_block_gc_bytes_deleted),
+    MINIT(undo_delta_block_gc_bytes_truncated),
+    MINIT(cold_rowset_bytes_moved),
     MINIT(ops_timed_out_in_prepare_queue),
     MINIT(bloom_lookups_per_op),
     MINIT(key_file_lookups_per_op),
@@ -490,6 +616,7 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     GINIT(delta_major_compact_rs_running),
     GINIT(undo_delta_block_gc_running),
     GINIT(undo_delta_block_estimated_retained_bytes),
+    GINIT(move_cold_rowset_running),
     MINIT(flush_dms_duration),
     MINIT(flush_mrs_duration),
     MINIT(compact_rs_duration),
@@ -499,11 +626,18 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(undo_delta_block_gc_init_duration),
     MINIT(undo_delta_block_gc_delete_duration),
     MINIT(undo_delta_block_gc_perform_duration),
+    MINIT(move_cold_rowset_duration),
     MINIT(compact_rs_mem_usage),
     MINIT(compact_rs_mem_usage_to_deltas_size_ratio),
     MINIT(leader_memory_pressure_rejections),
+    MINIT(scan_quota_rejections),
+    MINIT(checksum_rowsets_reused),
+    MINIT(write_quota_rejections),
     MEANINIT(average_diskrowset_height),
     HIDEINIT(merged_entities_count_of_tablet, 1) {
+  io_metrics.cfile_cache_hits = METRIC_cfile_cache_hits.Instantiate(entity);
+  io_metrics.cfile_cache_misses = METRIC_cfile_cache_misses.Instantiate(entity);
+  io_metrics.cfile_bytes_read = METRIC_cfile_bytes_read.Instantiate(entity);
 }
 #undef MINIT
 #undef GINIT
@@ -20,6 +20,7 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "kudu/fs/io_context.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/metrics.h"
 
@@ -63,22 +64,40 @@ struct TabletMetrics {
   scoped_refptr<Counter> scanner_cells_scanned_from_disk;
   scoped_refptr<Counter> scanner_bytes_scanned_from_disk;
   scoped_refptr<Counter> scanner_predicates_disabled;
+  scoped_refptr<Counter> scanner_cells_skipped;
   scoped_refptr<Counter> scans_started;
   scoped_refptr<AtomicGauge<size_t>> tablet_active_scanners;
   scoped_refptr<Histogram> scan_duration_wall_time;
   scoped_refptr<Histogram> scan_duration_system_time;
   scoped_refptr<Histogram> scan_duration_user_time;
+  scoped_refptr<Counter> scanner_cpu_user_time;
+  scoped_refptr<Counter> scanner_cpu_system_time;
+
+  // CPU time spent applying operations.
+  scoped_refptr<Counter> apply_cpu_user_time;
+  scoped_refptr<Counter> apply_cpu_system_time;
+
+  // The number of ops of the tablet being applied right now, and its
+  // distribution as sampled by each op when its apply starts.
+  scoped_refptr<AtomicGauge<size_t>> tablet_applying_ops;
+  scoped_refptr<Histogram> op_apply_concurrency;
+
+  // The IO done on behalf of the tablet, see fs::IOContext.
+  fs::IOMetrics io_metrics;
 
   // Probe stats.
   scoped_refptr<Counter> bloom_lookups;
   scoped_refptr<Counter> key_file_lookups;
   scoped_refptr<Counter> delta_file_lookups;
   scoped_refptr<Counter> mrs_lookups;
+  scoped_refptr<Counter> presence_checks_skipped_above_rowsets;
 
   // Operation stats.
   scoped_refptr<Counter> bytes_flushed;
   scoped_refptr<Counter> deleted_rowset_gc_bytes_deleted;
   scoped_refptr<Counter> undo_delta_block_gc_bytes_deleted;
+  scoped_refptr<Counter> undo_delta_block_gc_bytes_truncated;
+  scoped_refptr<Counter> cold_rowset_bytes_moved;
   scoped_refptr<Counter> ops_timed_out_in_prepare_queue;
 
   scoped_refptr<Histogram> bloom_lookups_per_op;
@@ -101,6 +120,7 @@ struct TabletMetrics {
   scoped_refptr<AtomicGauge<uint32_t> > delta_major_compact_rs_running;
   scoped_refptr<AtomicGauge<uint32_t> > undo_delta_block_gc_running;
   scoped_refptr<AtomicGauge<int64_t> > undo_delta_block_estimated_retained_bytes;
+  scoped_refptr<AtomicGauge<uint32_t> > move_cold_rowset_running;
 
   scoped_refptr<Histogram> flush_dms_duration;
   scoped_refptr<Histogram> flush_mrs_duration;
@@ -111,12 +131,16 @@ struct TabletMetrics {
   scoped_refptr<Histogram> undo_delta_block_gc_init_duration;
   scoped_refptr<Histogram> undo_delta_block_gc_delete_duration;
   scoped_refptr<Histogram> undo_delta_block_gc_perform_duration;
+  scoped_refptr<Histogram> move_cold_rowset_duration;
 
   // Metrics specific to rowset merge compaction.
   scoped_refptr<Histogram> compact_rs_mem_usage;
   scoped_refptr<Histogram> compact_rs_mem_usage_to_deltas_size_ratio;
 
   scoped_refptr<Counter> leader_memory_pressure_rejections;
+  scoped_refptr<Counter> scan_quota_rejections;
+  scoped_refptr<Counter> checksum_rowsets_reused;
+  scoped_refptr<Counter> write_quota_rejections;
 
   // Compaction metrics.
   scoped_refptr<MeanGauge> average_diskrowset_height;
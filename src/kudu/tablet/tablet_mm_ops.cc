@@ -17,15 +17,21 @@
 
 #include "kudu/tablet/tablet_mm_ops.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <mutex>
 #include <optional>
 #include <ostream>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/fs/data_dirs.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/rowset.h"
@@ -36,6 +42,7 @@
 #include "kudu/util/logging.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/status.h"
 
 DEFINE_int32(undo_delta_block_gc_init_budget_millis, 1000,
@@ -46,6 +53,31 @@ DEFINE_int32(undo_delta_block_gc_init_budget_millis, 1000,
 TAG_FLAG(undo_delta_block_gc_init_budget_millis, evolving);
 TAG_FLAG(undo_delta_block_gc_init_budget_millis, advanced);
 
+DEFINE_bool(enable_undo_delta_block_truncation, true,
+    "Whether UndoDeltaBlockGCOp rewrites the UNDO delta blocks which hold both "
+    "deltas older than --tablet_history_max_age_sec and newer ones without the "
+    "older deltas. Otherwise, the history held in such blocks is only dropped "
+    "once all of it is ancient, or when their rowset is compacted.");
+TAG_FLAG(enable_undo_delta_block_truncation, experimental);
+TAG_FLAG(enable_undo_delta_block_truncation, runtime);
+
+DEFINE_double(undo_delta_block_truncation_min_ancient_ratio, 0.5,
+    "The minimum estimated ratio of ancient deltas in an UNDO delta block "
+    "for UndoDeltaBlockGCOp to rewrite it without them. "
+    "See --enable_undo_delta_block_truncation.");
+TAG_FLAG(undo_delta_block_truncation_min_ancient_ratio, experimental);
+TAG_FLAG(undo_delta_block_truncation_min_ancient_ratio, runtime);
+DEFINE_validator(undo_delta_block_truncation_min_ancient_ratio,
+                 [](const char* /*n*/, double v) { return v > 0 && v <= 1; });
+
+DEFINE_int32(undo_delta_block_truncation_budget_millis, 1000,
+    "The maximum number of milliseconds we will spend rewriting UNDO delta "
+    "blocks without their ancient deltas per invocation of UndoDeltaBlockGCOp. "
+    "The blocks rewritten before the budget runs out are kept, and the "
+    "remaining ones are rewritten by the next invocations.");
+TAG_FLAG(undo_delta_block_truncation_budget_millis, experimental);
+TAG_FLAG(undo_delta_block_truncation_budget_millis, runtime);
+
 DEFINE_bool(enable_major_delta_compaction, true,
     "Whether to enable major delta compaction. Disabling major delta "
     "compaction may worsen performance and increase disk space usage for "
@@ -95,7 +127,16 @@ DEFINE_int32(update_stats_log_throttling_interval_sec, 600,
 TAG_FLAG(update_stats_log_throttling_interval_sec, runtime);
 TAG_FLAG(update_stats_log_throttling_interval_sec, experimental);
 
+DEFINE_int32(rowset_compaction_max_threads, 1,
+    "The maximum number of threads a single rowset compaction may use to write "
+    "its output, splitting the key range of its input rowsets into sub-ranges "
+    "written concurrently. The threads beyond the first are only taken from "
+    "the idle threads of the maintenance manager.");
+TAG_FLAG(rowset_compaction_max_threads, experimental);
+TAG_FLAG(rowset_compaction_max_threads, runtime);
+
 using std::string;
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
@@ -123,6 +164,15 @@ bool TabletOpBase::compaction_enabled() const {
   return tablet_->compaction_enabled();
 }
 
+vector<string> TabletOpBase::DataDirs() const {
+  // If the group can't be found, e.g. because the tablet is being deleted,
+  // the op isn't tied to any directory.
+  vector<string> data_dirs;
+  ignore_result(tablet_->metadata()->fs_manager()->dd_manager()->FindDataDirsByTabletId(
+      tablet_->tablet_id(), &data_dirs));
+  return data_dirs;
+}
+
 ////////////////////////////////////////////////////////////
 // CompactRowSetsOp
 ////////////////////////////////////////////////////////////
@@ -190,7 +240,12 @@ bool CompactRowSetsOp::Prepare() {
 }
 
 void CompactRowSetsOp::Perform() {
-  WARN_NOT_OK(tablet_->Compact(Tablet::COMPACT_NO_FLAGS),
+  const int32_t extra_threads =
+      AcquireExtraThreads(std::max(0, FLAGS_rowset_compaction_max_threads - 1));
+  SCOPED_CLEANUP({
+    ReleaseExtraThreads(extra_threads);
+  });
+  WARN_NOT_OK(tablet_->Compact(Tablet::COMPACT_NO_FLAGS, 1 + extra_threads),
               Substitute("$0Compaction failed on $1",
                          LogPrefix(), tablet_->tablet_id()));
 }
@@ -394,6 +449,13 @@ void UndoDeltaBlockGCOp::UpdateStats(MaintenanceOpStats* stats) {
   int64_t max_estimated_retained_bytes = 0;
   WARN_NOT_OK(tablet_->EstimateBytesInPotentiallyAncientUndoDeltas(&max_estimated_retained_bytes),
               "Unable to count bytes in potentially ancient undo deltas");
+  if (FLAGS_enable_undo_delta_block_truncation) {
+    int64_t truncatable_bytes = 0;
+    WARN_NOT_OK(tablet_->EstimateBytesInTruncatableUndoDeltas(
+                    FLAGS_undo_delta_block_truncation_min_ancient_ratio, &truncatable_bytes),
+                "Unable to count bytes in truncatable undo deltas");
+    max_estimated_retained_bytes += truncatable_bytes;
+  }
   stats->set_data_retained_bytes(max_estimated_retained_bytes);
   stats->set_runnable(max_estimated_retained_bytes > 0);
 }
@@ -412,11 +474,19 @@ void UndoDeltaBlockGCOp::Perform() {
     return;
   }
 
-  // Return early if it turns out that we have nothing to GC.
-  if (bytes_in_ancient_undos == 0) return;
+  // Skip the deletion if it turns out that there are no entirely ancient
+  // blocks to GC.
+  if (bytes_in_ancient_undos > 0) {
+    CHECK_OK_PREPEND(tablet_->DeleteAncientUndoDeltas(),
+                     Substitute("$0GC of undo delta blocks failed", LogPrefix()));
+  }
 
-  CHECK_OK_PREPEND(tablet_->DeleteAncientUndoDeltas(),
-                   Substitute("$0GC of undo delta blocks failed", LogPrefix()));
+  if (FLAGS_enable_undo_delta_block_truncation) {
+    WARN_NOT_OK(tablet_->TruncateAncientUndoDeltas(
+                    FLAGS_undo_delta_block_truncation_min_ancient_ratio,
+                    MonoDelta::FromMilliseconds(FLAGS_undo_delta_block_truncation_budget_millis)),
+                Substitute("$0Truncation of undo delta blocks failed", LogPrefix()));
+  }
 }
 
 scoped_refptr<Histogram> UndoDeltaBlockGCOp::DurationHistogram() const {
@@ -472,5 +542,46 @@ std::string DeletedRowsetGCOp::LogPrefix() const {
   return tablet_->LogPrefix();
 }
 
+////////////////////////////////////////////////////////////
+// MoveColdRowSetsOp
+////////////////////////////////////////////////////////////
+
+MoveColdRowSetsOp::MoveColdRowSetsOp(Tablet* tablet)
+    : TabletOpBase(Substitute("MoveColdRowSetsOp($0)", tablet->tablet_id()),
+                   MaintenanceOp::HIGH_IO_USAGE, tablet),
+      running_(false) {
+}
+
+void MoveColdRowSetsOp::UpdateStats(MaintenanceOpStats* stats) {
+  if (PREDICT_FALSE(!compaction_enabled())) {
+    stats->set_runnable(false);
+    return;
+  }
+  if (running_.load()) {
+    VLOG(1) << LogPrefix() << " not updating stats: already running";
+    stats->set_runnable(false);
+    return;
+  }
+  int64_t bytes_to_move = 0;
+  WARN_NOT_OK(tablet_->GetBytesInColdRowSetsOnHotTier(&bytes_to_move),
+              "Unable to count bytes in cold rowsets");
+  stats->set_data_retained_bytes(bytes_to_move);
+  stats->set_runnable(bytes_to_move > 0);
+}
+
+void MoveColdRowSetsOp::Perform() {
+  WARN_NOT_OK(tablet_->MoveColdRowSetToColdTier(),
+      Substitute("$0Moving a rowset onto the cold tier failed", LogPrefix()));
+  running_.store(false);
+}
+
+scoped_refptr<Histogram> MoveColdRowSetsOp::DurationHistogram() const {
+  return tablet_->metrics()->move_cold_rowset_duration;
+}
+
+scoped_refptr<AtomicGauge<uint32_t>> MoveColdRowSetsOp::RunningGauge() const {
+  return tablet_->metrics()->move_cold_rowset_running;
+}
+
 } // namespace tablet
 } // namespace kudu
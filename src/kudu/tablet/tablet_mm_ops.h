@@ -19,6 +19,7 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -45,6 +46,9 @@ class TabletOpBase : public MaintenanceOp {
   // otherwise return 'false'.
   bool compaction_enabled() const;
 
+  // Returns the directories of the tablet's data dir group.
+  std::vector<std::string> DataDirs() const override;
+
  protected:
   int32_t priority() const override;
 
@@ -165,14 +169,15 @@ class UndoDeltaBlockGCOp : public TabletOpBase {
 };
 
 // MaintenanceOp to garbage-collect entire rowsets that are fully deleted and
-// older than the ancient history mark.
+// older than the ancient history mark, or whose rows are all expired by the
+// row TTL of the table.
 class DeletedRowsetGCOp : public TabletOpBase {
  public:
   explicit DeletedRowsetGCOp(Tablet* tablet);
 
   // Estimate the number of bytes from rowsets that have been fully deleted and
   // exist entirely before the AHM (i.e. their most recent update happened
-  // before the AHM).
+  // before the AHM), or whose rows are all expired.
   void UpdateStats(MaintenanceOpStats* stats) override;
 
   // If this op is already running, we shouldn't run it again.
@@ -197,6 +202,37 @@ class DeletedRowsetGCOp : public TabletOpBase {
   DISALLOW_COPY_AND_ASSIGN(DeletedRowsetGCOp);
 };
 
+// MaintenanceOp to rewrite the rowsets whose data is older than the table's
+// 'kudu.table.cold_data_age_sec' onto the cold storage tier, freeing space on
+// the hot tier for new data. It is only registered if the data dirs have a
+// cold tier, see --fs_cold_data_dirs.
+class MoveColdRowSetsOp : public TabletOpBase {
+ public:
+  explicit MoveColdRowSetsOp(Tablet* tablet);
+
+  // Estimates the number of bytes in the rowsets to move.
+  void UpdateStats(MaintenanceOpStats* stats) override;
+
+  // If this op is already running, we shouldn't run it again.
+  bool Prepare() override {
+    bool false_ref = false;
+    return running_.compare_exchange_strong(false_ref, true);
+  }
+
+  // Moves the largest of the rowsets to move onto the cold tier.
+  void Perform() override;
+
+  scoped_refptr<Histogram> DurationHistogram() const override;
+  scoped_refptr<AtomicGauge<uint32_t> > RunningGauge() const override;
+
+ private:
+  // Used to ensure only a single instance of this op is scheduled per tablet
+  // at a time.
+  std::atomic<bool> running_;
+
+  DISALLOW_COPY_AND_ASSIGN(MoveColdRowSetsOp);
+};
+
 } // namespace tablet
 } // namespace kudu
 
@@ -74,6 +74,7 @@
 #include "kudu/util/test_util.h"
 
 DECLARE_bool(enable_maintenance_manager);
+DECLARE_int32(flush_forecast_horizon_secs);
 DECLARE_int32(flush_threshold_mb);
 DECLARE_int32(tablet_history_max_age_sec);
 
@@ -563,6 +564,58 @@ TEST_F(TabletReplicaTest, TestFlushOpsPerfImprovements) {
   stats.Clear();
 }
 
+TEST_F(TabletReplicaTest, TestFlushOpsForecastPerfImprovements) {
+  FLAGS_flush_threshold_mb = 64;
+  FLAGS_flush_forecast_horizon_secs = 10;
+  constexpr int64_t kMiB = 1024 * 1024;
+  constexpr int64_t kPressureThreshold = 1024 * kMiB;
+
+  MaintenanceOpStats stats;
+
+  // Growing at 1 MiB/s, the mem-store won't reach the threshold within the
+  // horizon: no improvement.
+  stats.set_ram_anchored(32 * kMiB);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 1);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForForecast(
+      &stats, kMiB, kMiB, 512 * kMiB, kPressureThreshold);
+  ASSERT_EQ(0, stats.perf_improvement());
+  stats.Clear();
+
+  // Growing at 4 MiB/s, it will: a low improvement, growing with its size.
+  stats.set_ram_anchored(32 * kMiB);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 1);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForForecast(
+      &stats, 4 * kMiB, 4 * kMiB, 512 * kMiB, kPressureThreshold);
+  ASSERT_NEAR(0.5, stats.perf_improvement(), 0.01);
+  stats.Clear();
+
+  // The server's memory consumption will reach the pressure threshold: the
+  // improvement is as if the mem-store were over the threshold.
+  stats.set_ram_anchored(32 * kMiB);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 1);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForForecast(
+      &stats, kMiB, 100 * kMiB, 512 * kMiB, kPressureThreshold);
+  ASSERT_NEAR(32, stats.perf_improvement(), 0.01);
+  stats.Clear();
+
+  // A mem-store which doesn't grow isn't flushed ahead of time.
+  stats.set_ram_anchored(32 * kMiB);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 1);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForForecast(
+      &stats, 0, 100 * kMiB, 512 * kMiB, kPressureThreshold);
+  ASSERT_EQ(0, stats.perf_improvement());
+  stats.Clear();
+
+  // Without a horizon, there is no forecast.
+  FLAGS_flush_forecast_horizon_secs = 0;
+  stats.set_ram_anchored(32 * kMiB);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 1);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForForecast(
+      &stats, 4 * kMiB, 100 * kMiB, 512 * kMiB, kPressureThreshold);
+  ASSERT_EQ(0, stats.perf_improvement());
+  stats.Clear();
+}
+
 // Test that the schema of a tablet will be rolled forward upon replaying an
 // alter schema request.
 TEST_F(TabletReplicaTest, TestRollLogSegmentSchemaOnAlter) {
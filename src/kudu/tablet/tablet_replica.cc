@@ -82,6 +82,15 @@ DEFINE_uint32(tablet_max_pending_txn_write_ops, 2,
 TAG_FLAG(tablet_max_pending_txn_write_ops, experimental);
 TAG_FLAG(tablet_max_pending_txn_write_ops, runtime);
 
+DEFINE_int32(tablet_op_buffer_pool_kb, 128,
+             "Maximum amount of memory, in KiB, kept by each tablet replica in its pool "
+             "of free arena buffers, for reuse by the arenas of later write operations. "
+             "If 0, the arena buffers of operations are not pooled.");
+TAG_FLAG(tablet_op_buffer_pool_kb, advanced);
+DEFINE_validator(tablet_op_buffer_pool_kb, [](const char* /*flagname*/, int32_t value) {
+  return value >= 0;
+});
+
 METRIC_DEFINE_histogram(tablet, op_prepare_queue_length, "Operation Prepare Queue Length",
                         kudu::MetricUnit::kTasks,
                         "Number of operations waiting to be prepared within this tablet. "
@@ -183,6 +192,7 @@ TabletReplica::TabletReplica(
                          this->TxnStatusReplicaStateChanged(this->tablet_id(), reason);
                        } : std::move(cb)),
       state_(NOT_INITIALIZED),
+      op_buffer_allocator_(static_cast<size_t>(FLAGS_tablet_op_buffer_pool_kb) * 1024),
       last_status_("Tablet initializing...") {
 }
 
@@ -190,6 +200,7 @@ TabletReplica::TabletReplica()
     : apply_pool_(nullptr),
       reload_txn_status_tablet_pool_(nullptr),
       state_(SHUTDOWN),
+      op_buffer_allocator_(0),
       last_status_("Fake replica created") {
 }
 
@@ -206,6 +217,7 @@ Status TabletReplica::Init(ServerContext server_ctx) {
   SetStatusMessage("Initializing consensus...");
   ConsensusOptions options;
   options.tablet_id = meta_->tablet_id();
+  heartbeat_coalescer_ = server_ctx.heartbeat_coalescer;
   shared_ptr<RaftConsensus> consensus;
   RETURN_NOT_OK(RaftConsensus::Create(std::move(options),
                                       local_peer_pb_,
@@ -279,7 +291,8 @@ Status TabletReplica::Start(
       VLOG(2) << "T " << tablet_id() << " P " << consensus_->peer_uuid() << ": Peer starting";
       VLOG(2) << "RaftConfig before starting: " << SecureDebugString(consensus_->CommittedConfig());
 
-      peer_proxy_factory.reset(new RpcPeerProxyFactory(messenger_, resolver));
+      peer_proxy_factory.reset(
+          new RpcPeerProxyFactory(messenger_, resolver, heartbeat_coalescer_));
       time_manager.reset(new TimeManager(clock_, tablet_->mvcc_manager()->GetCleanTimestamp()));
     }
 
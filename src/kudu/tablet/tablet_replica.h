@@ -45,6 +45,7 @@
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/memory/memory.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
@@ -66,6 +67,7 @@ class TxnOpDispatcherITest_PreliminaryTasksTimeout_Test;
 
 namespace consensus {
 class ConsensusMetadataManager;
+class HeartbeatCoalescer;
 class OpStatusPB;
 class TimeManager;
 }
@@ -342,6 +344,10 @@ class TabletReplica : public RefCountedThreadSafe<TabletReplica>,
   // Return pointer to the op tracker for this peer.
   const OpTracker* op_tracker() const { return &op_tracker_; }
 
+  // Returns the allocator for the arenas of this replica's ops. It pools the
+  // arena buffers, so that most ops don't allocate their arena on the heap.
+  BufferAllocator* op_buffer_allocator() { return &op_buffer_allocator_; }
+
   const scoped_refptr<TabletMetadata>& tablet_metadata() const {
     return meta_;
   }
@@ -583,6 +589,8 @@ class TabletReplica : public RefCountedThreadSafe<TabletReplica>,
 
   TabletStatePB state_;
   Status error_;
+  // Declared before 'op_tracker_' so that it outlives the tracked ops.
+  PooledBufferAllocator op_buffer_allocator_;
   OpTracker op_tracker_;
   OpOrderVerifier op_order_verifier_;
   scoped_refptr<log::Log> log_;
@@ -590,6 +598,9 @@ class TabletReplica : public RefCountedThreadSafe<TabletReplica>,
   std::shared_ptr<rpc::Messenger> messenger_;
   std::shared_ptr<consensus::RaftConsensus> consensus_;
 
+  // Coalesces the heartbeats sent by the leaders of the server, if any.
+  consensus::HeartbeatCoalescer* heartbeat_coalescer_ = nullptr;
+
   // Lock protecting state_, last_status_, as well as pointers to collaborating
   // classes such as tablet_, consensus_, and maintenance_ops_.
   mutable simple_spinlock lock_;
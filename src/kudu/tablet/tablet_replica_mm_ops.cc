@@ -18,16 +18,22 @@
 #include "kudu/tablet/tablet_replica_mm_ops.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <map>
 #include <mutex>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/fs/data_dirs.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/tablet/tablet_metadata.h"
@@ -37,6 +43,7 @@
 #include "kudu/util/maintenance_manager.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/process_memory.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/status.h"
 
@@ -82,6 +89,18 @@ DEFINE_int32(flush_upper_bound_ms, 60 * 60 * 1000,
 TAG_FLAG(flush_upper_bound_ms, experimental);
 TAG_FLAG(flush_upper_bound_ms, runtime);
 
+DEFINE_int32(flush_forecast_horizon_secs, 0,
+             "If positive, MRS flushes are scheduled ahead of time based on the rate "
+             "at which the MRS of each tablet grows: an MRS projected to reach "
+             "--flush_threshold_mb, or the MRSs of a server whose memory consumption is "
+             "projected to reach --memory_pressure_percentage, within this many seconds "
+             "become flushable before they do. This spreads the flushes over time rather "
+             "than having many tablets flush at once when crossing the thresholds. "
+             "If 0, MRS flushes are scheduled based on the current size and age of the "
+             "MRS and the current memory consumption only.");
+TAG_FLAG(flush_forecast_horizon_secs, experimental);
+TAG_FLAG(flush_forecast_horizon_secs, runtime);
+
 DECLARE_bool(enable_workload_score_for_perf_improvement_ops);
 
 METRIC_DEFINE_gauge_uint32(tablet, log_gc_running,
@@ -101,7 +120,16 @@ DECLARE_int32(update_stats_log_throttling_interval_sec);
 namespace kudu {
 namespace tablet {
 
+namespace {
+
+// Total ingest rate of the MRSs of the process, in bytes per second.
+std::atomic<int64_t> total_mrs_ingest_rate(0);
+
+} // anonymous namespace
+
 using std::map;
+using std::string;
+using std::vector;
 
 //
 // FlushOpPerfImprovementPolicy.
@@ -135,6 +163,34 @@ void FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(MaintenanceOpStats
   }
 }
 
+void FlushOpPerfImprovementPolicy::SetPerfImprovementForForecast(
+    MaintenanceOpStats* stats,
+    double ingest_rate,
+    double total_ingest_rate,
+    int64_t memory_consumption,
+    int64_t memory_pressure_threshold) {
+  const int32_t horizon_secs = FLAGS_flush_forecast_horizon_secs;
+  if (horizon_secs <= 0 || ingest_rate <= 0) {
+    return;
+  }
+  const double anchored_mb = static_cast<double>(stats->ram_anchored()) / (1024 * 1024);
+  const double threshold_mb = FLAGS_flush_threshold_mb;
+  double perf = stats->perf_improvement();
+  if (memory_consumption + total_ingest_rate * horizon_secs >= memory_pressure_threshold) {
+    // The server is about to be under memory pressure: score the growing
+    // mem-stores as if they were over the threshold, so that the largest ones
+    // are flushed first and one after the other, rather than all of them at
+    // once when the pressure is reached.
+    perf = std::max(perf, std::max(1.0, anchored_mb));
+  } else if (anchored_mb + ingest_rate / (1024 * 1024) * horizon_secs >= threshold_mb) {
+    // The mem-store is about to reach the threshold: make it flushable with
+    // a low score growing as it approaches the threshold, so that it's flushed
+    // early if there isn't much else to do.
+    perf = std::max(perf, std::min(1.0, anchored_mb / threshold_mb));
+  }
+  stats->set_perf_improvement(perf);
+}
+
 //
 // TabletReplicaOpBase.
 //
@@ -154,10 +210,49 @@ int32_t TabletReplicaOpBase::priority() const {
   return priority;
 }
 
+vector<string> TabletReplicaOpBase::DataDirs() const {
+  // If the group can't be found, e.g. because the tablet is being deleted,
+  // the op isn't tied to any directory.
+  vector<string> data_dirs;
+  const auto& meta = tablet_replica_->tablet_metadata();
+  ignore_result(meta->fs_manager()->dd_manager()->FindDataDirsByTabletId(
+      meta->tablet_id(), &data_dirs));
+  return data_dirs;
+}
+
 //
 // FlushMRSOp.
 //
 
+FlushMRSOp::~FlushMRSOp() {
+  total_mrs_ingest_rate -= static_cast<int64_t>(ingest_rate_);
+}
+
+void FlushMRSOp::UpdateIngestRateUnlocked(int64_t mrs_size) {
+  const int32_t horizon_secs = FLAGS_flush_forecast_horizon_secs;
+  const int64_t prev_rate = static_cast<int64_t>(ingest_rate_);
+  const MonoTime now = MonoTime::Now();
+  if (horizon_secs <= 0) {
+    ingest_rate_ = 0;
+    last_sample_time_ = MonoTime();
+  } else {
+    if (last_sample_time_.Initialized()) {
+      const double elapsed_secs = (now - last_sample_time_).ToSeconds();
+      if (elapsed_secs > 0) {
+        // The MRS shrinks when it's flushed: then it grew by its whole size.
+        const int64_t growth = mrs_size >= last_mrs_size_ ? mrs_size - last_mrs_size_
+                                                          : mrs_size;
+        // Average the rate over about the forecast horizon.
+        const double alpha = 1 - std::exp(-elapsed_secs / horizon_secs);
+        ingest_rate_ += alpha * (growth / elapsed_secs - ingest_rate_);
+      }
+    }
+    last_sample_time_ = now;
+    last_mrs_size_ = mrs_size;
+  }
+  total_mrs_ingest_rate += static_cast<int64_t>(ingest_rate_) - prev_rate;
+}
+
 void FlushMRSOp::UpdateStats(MaintenanceOpStats* stats) {
   if (PREDICT_FALSE(!FLAGS_enable_flush_memrowset)) {
     KLOG_EVERY_N_SECS(WARNING, FLAGS_update_stats_log_throttling_interval_sec)
@@ -168,6 +263,8 @@ void FlushMRSOp::UpdateStats(MaintenanceOpStats* stats) {
 
   std::lock_guard<simple_spinlock> l(lock_);
 
+  UpdateIngestRateUnlocked(tablet_replica_->tablet()->MemRowSetSize());
+
   map<int64_t, int64_t> replay_size_map;
   if (tablet_replica_->tablet()->MemRowSetEmpty() ||
       !tablet_replica_->GetReplaySizeMap(&replay_size_map).ok()) {
@@ -193,6 +290,12 @@ void FlushMRSOp::UpdateStats(MaintenanceOpStats* stats) {
   FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(
       stats,
       time_since_flush_.elapsed().wall_millis());
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForForecast(
+      stats,
+      ingest_rate_,
+      total_mrs_ingest_rate,
+      process_memory::CurrentConsumption(),
+      process_memory::MemoryPressureThreshold());
 }
 
 bool FlushMRSOp::Prepare() {
@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
@@ -28,6 +29,7 @@
 #include "kudu/util/locks.h"
 #include "kudu/util/maintenance_manager.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/semaphore.h"
 #include "kudu/util/stopwatch.h"
 
@@ -42,6 +44,17 @@ class FlushOpPerfImprovementPolicy {
   // else it will set it based on how long the mem-store has been non-empty.
   static void SetPerfImprovementForFlush(MaintenanceOpStats* stats, double elapsed_ms);
 
+  // Raises the performance improvement set by SetPerfImprovementForFlush() if,
+  // within --flush_forecast_horizon_secs, the mem-store is projected to reach
+  // the flush threshold at its ingest rate, or the server's memory consumption
+  // is projected to reach 'memory_pressure_threshold' at the total ingest rate
+  // of the mem-stores. The rates are in bytes per second.
+  static void SetPerfImprovementForForecast(MaintenanceOpStats* stats,
+                                            double ingest_rate,
+                                            double total_ingest_rate,
+                                            int64_t memory_consumption,
+                                            int64_t memory_pressure_threshold);
+
  private:
   FlushOpPerfImprovementPolicy() {}
 };
@@ -50,6 +63,9 @@ class TabletReplicaOpBase : public MaintenanceOp {
  public:
   explicit TabletReplicaOpBase(std::string name, IOUsage io_usage, TabletReplica* tablet_replica);
 
+  // Returns the directories of the tablet's data dir group.
+  std::vector<std::string> DataDirs() const override;
+
  protected:
   int32_t priority() const override;
 
@@ -67,6 +83,8 @@ class FlushMRSOp : public TabletReplicaOpBase {
     time_since_flush_.start();
   }
 
+  ~FlushMRSOp() override;
+
   void UpdateStats(MaintenanceOpStats* stats) override;
 
   bool Prepare() override;
@@ -78,9 +96,19 @@ class FlushMRSOp : public TabletReplicaOpBase {
   scoped_refptr<AtomicGauge<uint32_t> > RunningGauge() const override;
 
  private:
-  // Lock protecting time_since_flush_.
+  // Samples the size of the MRS to update 'ingest_rate_', and the total
+  // ingest rate of the MRSs of the process.
+  void UpdateIngestRateUnlocked(int64_t mrs_size);
+
+  // Lock protecting the fields below.
   mutable simple_spinlock lock_;
   Stopwatch time_since_flush_;
+
+  // Moving average of the rate at which the MRS grows, in bytes per second,
+  // and the time and MRS size of the last sample.
+  double ingest_rate_ = 0;
+  MonoTime last_sample_time_;
+  int64_t last_mrs_size_ = 0;
 };
 
 // Maintenance op for DMS flush.
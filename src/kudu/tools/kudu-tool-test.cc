@@ -1403,6 +1403,7 @@ TEST_F(ToolTest, TestModeHelp) {
     const vector<string> kLocalReplicaModeRegexes = {
         "cmeta.*Operate on a local tablet replica's consensus",
         "tmeta.*Edit a local tablet metadata",
+        "compact.*Compact tablet replicas in the local filesystem",
         "data_size.*Summarize the data size",
         "dump.*Dump a Kudu filesystem",
         "copy_from_remote.*Copy tablet replicas from a remote server",
@@ -1510,12 +1511,14 @@ TEST_F(ToolTest, TestModeHelp) {
   {
     const string kCmd = "perf";
     const vector<string> kPerfRegexes = {
+        "bootstrap.*Measure the time to bootstrap local tablets",
         "loadgen.*Run load generation with optional scan afterwards",
         "table_scan.*Show row count and scanning time cost of tablets in a table",
         "tablet_scan.*Show row count of a local tablet",
+        "workload.*Run a YCSB-style mix of reads, writes and scans",
     };
     NO_FATALS(RunTestHelp(kCmd, kPerfRegexes));
-    NO_FATALS(RunTestHelpRpcFlags(kCmd, {"loadgen", "table_scan"}));
+    NO_FATALS(RunTestHelpRpcFlags(kCmd, {"loadgen", "table_scan", "workload"}));
   }
   {
     const string kCmd = "remote_replica";
@@ -4114,6 +4117,37 @@ TEST_F(ToolTest, TestPerfTableScan) {
   NO_FATALS(RunScanTableCheck(kTableName, "", 1, 2000, {}, "perf table_scan"));
 }
 
+TEST_F(ToolTest, TestPerfWorkload) {
+  {
+    ExternalMiniClusterOptions opts;
+    opts.num_tablet_servers = 1;
+    NO_FATALS(StartExternalMiniCluster(std::move(opts)));
+  }
+  const string master_addr = cluster_->master()->bound_rpc_addr().ToString();
+  for (const auto* workload : { "a", "b", "c", "d", "e", "f" }) {
+    SCOPED_TRACE(workload);
+    string out;
+    NO_FATALS(RunActionStdoutString(Substitute(
+        "perf workload $0 --workload=$1 --workload_record_count=1000 "
+        "--workload_duration_sec=1 --num_threads=2 --table_num_replicas=1",
+        master_addr, workload), &out));
+    ASSERT_STR_CONTAINS(out, "Workload report");
+    ASSERT_STR_CONTAINS(out, "errors: 0");
+    ASSERT_STR_MATCHES(out, "(READ|SCAN) report");
+  }
+
+  // Unknown workloads and distributions are rejected.
+  string err;
+  Status s = RunActionStderrString(Substitute(
+      "perf workload $0 --workload=z", master_addr), &err);
+  ASSERT_TRUE(s.IsRuntimeError()) << s.ToString();
+  ASSERT_STR_CONTAINS(err, "unknown workload 'z'");
+  s = RunActionStderrString(Substitute(
+      "perf workload $0 --workload_request_distribution=hotspot", master_addr), &err);
+  ASSERT_TRUE(s.IsRuntimeError()) << s.ToString();
+  ASSERT_STR_CONTAINS(err, "unknown request distribution 'hotspot'");
+}
+
 TEST_F(ToolTest, PerfTableScanCountOnly) {
   constexpr const char* const kTableName = "perf.table_scan.row_count_only";
   // Be specific about the number of threads even if it matches the default
@@ -4282,6 +4316,36 @@ TEST_F(ToolTest, TestPerfTabletScan) {
   }
 }
 
+TEST_F(ToolTest, TestPerfBootstrap) {
+  constexpr const char* const kTableName = "perf.bootstrap";
+  NO_FATALS(RunLoadgen(1, {}, kTableName));
+
+  vector<string> tablet_ids;
+  TServerDetails* ts = ts_map_[cluster_->tablet_server(0)->uuid()];
+  ASSERT_OK(ListRunningTabletIds(ts, MonoDelta::FromSeconds(30), &tablet_ids));
+  ASSERT_FALSE(tablet_ids.empty());
+
+  // Bootstrap all the tablets at once a couple of times, then flush them.
+  cluster_->Shutdown();
+  const string args = Substitute(
+      "perf bootstrap $0 --fs_wal_dir=$1 --fs_data_dirs=$2 --num_threads=4",
+      JoinStrings(tablet_ids, ","), cluster_->tablet_server(0)->wal_dir(),
+      JoinStrings(cluster_->tablet_server(0)->data_dirs(), ","));
+  string out;
+  NO_FATALS(RunActionStdoutString(args + " --num_iters=2", &out));
+  for (const auto& tablet_id : tablet_ids) {
+    ASSERT_STR_CONTAINS(out, Substitute("iter 1, tablet $0: total", tablet_id));
+  }
+  ASSERT_STR_CONTAINS(out, Substitute("iter 1: bootstrapped $0 tablets", tablet_ids.size()));
+  NO_FATALS(RunActionStdoutString(args + " --flush_after_bootstrap", &out));
+  ASSERT_STR_CONTAINS(out, "iter 0: bootstrapped");
+
+  // The tablet server still starts up with the bootstrapped tablets.
+  ASSERT_OK(cluster_->Restart());
+  ASSERT_OK(WaitForNumTabletsOnTS(ts, tablet_ids.size(), MonoDelta::FromSeconds(30),
+                                  nullptr, tablet::RUNNING));
+}
+
 TEST_F(ToolTest, TestTabletInfo) {
   ExternalMiniClusterOptions opts;
   const int kNumTabletServers = 3;
@@ -4677,6 +4741,67 @@ TEST_F(ToolTest, TestLocalReplicaDelete) {
   ASSERT_EQ(0, tablet_replicas.size());
 }
 
+// Test 'kudu local_replica compact' tool compacting the rowsets of a replica
+// while the tablet server is stopped, including the rows only in its WAL.
+TEST_F(ToolTest, TestLocalReplicaCompact) {
+  NO_FATALS(StartMiniCluster());
+
+  TestWorkload workload(mini_cluster_.get());
+  workload.set_num_replicas(1);
+  workload.Setup();
+  workload.Start();
+
+  ASSERT_OK(mini_cluster_->WaitForTabletServerCount(1));
+  MiniTabletServer* ts = mini_cluster_->mini_tablet_server(0);
+  string tablet_id;
+  {
+    vector<scoped_refptr<TabletReplica>> tablet_replicas;
+    ts->server()->tablet_manager()->GetTabletReplicas(&tablet_replicas);
+    ASSERT_EQ(1, tablet_replicas.size());
+    Tablet* tablet = tablet_replicas[0]->tablet();
+    tablet_id = tablet_replicas[0]->tablet_id();
+    // Flush a few times to get overlapping rowsets, and leave the last rows
+    // in the MemRowSet.
+    for (int i = 1; i <= 3; i++) {
+      while (workload.rows_inserted() < i * 1000) {
+        SleepFor(MonoDelta::FromMilliseconds(10));
+      }
+      ASSERT_OK(tablet->Flush());
+    }
+    while (workload.rows_inserted() < 4000) {
+      SleepFor(MonoDelta::FromMilliseconds(10));
+    }
+    workload.StopAndJoin();
+    ASSERT_GE(tablet->num_rowsets(), 3);
+  }
+
+  // The tool refuses to run while the tablet server is running.
+  const string& tserver_dir = ts->options()->fs_opts.wal_root;
+  const string cmd = Substitute("local_replica compact $0 --fs_wal_dir=$1 --fs_data_dirs=$1 "
+                                "--num_threads=4", tablet_id, tserver_dir);
+  string stderr;
+  Status s = RunTool(cmd, nullptr, &stderr, nullptr, nullptr);
+  ASSERT_TRUE(s.IsRuntimeError());
+  SCOPED_TRACE(stderr);
+  ASSERT_STR_CONTAINS(stderr, "Resource temporarily unavailable");
+
+  ts->Shutdown();
+  NO_FATALS(RunActionStdoutNone(cmd));
+
+  // All the rows are in a single rowset once the tablet server is back up.
+  ASSERT_OK(ts->Start());
+  ASSERT_OK(ts->WaitStarted());
+  vector<scoped_refptr<TabletReplica>> tablet_replicas;
+  ts->server()->tablet_manager()->GetTabletReplicas(&tablet_replicas);
+  ASSERT_EQ(1, tablet_replicas.size());
+  ASSERT_OK(tablet_replicas[0]->WaitUntilConsensusRunning(MonoDelta::FromSeconds(30)));
+  Tablet* tablet = tablet_replicas[0]->tablet();
+  ASSERT_EQ(1, tablet->num_rowsets());
+  uint64_t num_rows;
+  ASSERT_OK(tablet->CountRows(&num_rows));
+  ASSERT_EQ(workload.rows_inserted(), num_rows);
+}
+
 // Test 'kudu local_replica delete' tool with multiple tablet replicas to
 // operate at once.
 TEST_F(ToolTest, TestLocalReplicaDeleteMultiple) {
@@ -5937,6 +6062,36 @@ TEST_F(ToolTest, TableCopyFaultTolerant) {
   }
 }
 
+// Copy a table with more threads than tablets and a mutation buffer small
+// enough to be flushed in the background many times while scanning.
+TEST_F(ToolTest, TableCopySharedTokensSmallBuffer) {
+  constexpr const char* const kTableName = "kudu.table.copy.small_buffer.from";
+  constexpr const char* const kNewTableName = "kudu.table.copy.small_buffer.to";
+  NO_FATALS(RunLoadgen(1,
+                       {
+                           "--num_threads=4",
+                           "--num_rows_per_thread=2000",
+                       },
+                       kTableName));
+  string out;
+  string err;
+  const auto s = RunTool(
+      Substitute("table copy $0 $1 $2 --dst_table=$3 --write_type=insert "
+                 "--num_threads=8 --copy_mutation_buffer_size_mb=1",
+                 cluster_->master()->bound_rpc_addr().ToString(), kTableName,
+                 cluster_->master()->bound_rpc_addr().ToString(), kNewTableName),
+      &out, &err);
+  ASSERT_TRUE(s.ok()) << s.ToString() << ": " << err;
+  ASSERT_STR_MATCHES(out, "Total count 8000 cost .* seconds");
+
+  // Scan the destination table: all the rows must be there.
+  out.clear();
+  ASSERT_OK(RunKuduTool({"table", "scan",
+                         cluster_->master()->bound_rpc_addr().ToString(),
+                         kNewTableName}, &out));
+  ASSERT_STR_CONTAINS(out, "Total count 8000 ");
+}
+
 TEST_P(ToolTestCopyTableParameterized, TestCopyTable) {
   SKIP_IF_SLOW_NOT_ALLOWED();
   for (const auto& arg : GenerateArgs()) {
@@ -25,7 +25,6 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
-#include <map>
 #include <memory>
 #include <optional>
 #include <set>
@@ -54,6 +53,7 @@
 #include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/jsonreader.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/memory/arena.h"
@@ -79,7 +79,6 @@ using kudu::client::KuduWriteOperation;
 using kudu::iequals;
 using std::endl;
 using std::function;
-using std::map;
 using std::nullopt;
 using std::optional;
 using std::ostream;
@@ -137,8 +136,16 @@ DEFINE_string(write_type, "insert",
               "creating the destination table without copying the data.");
 DEFINE_string(replica_selection, "CLOSEST",
               "Replica selection for scan operations. Acceptable values are: "
-              "CLOSEST, LEADER (maps into KuduClient::CLOSEST_REPLICA and "
-              "KuduClient::LEADER_ONLY correspondingly).");
+              "CLOSEST, LEADER, NON_VOTER (maps into KuduClient::CLOSEST_REPLICA, "
+              "KuduClient::LEADER_ONLY and KuduClient::CLOSEST_NON_VOTER "
+              "correspondingly).");
+DEFINE_int32(copy_mutation_buffer_size_mb, 64,
+             "Size of the mutation buffer of each session writing into the "
+             "destination table when copying tables, in MiB. Rows are "
+             "flushed in the background as the buffer fills up, so a larger "
+             "buffer lets rows accumulate into bigger per-tablet write "
+             "batches while the copying thread keeps on scanning.");
+TAG_FLAG(copy_mutation_buffer_size_mb, advanced);
 
 DECLARE_bool(row_count_only);
 DECLARE_int32(num_threads);
@@ -188,6 +195,7 @@ bool ValidateWriteType(const char* flag_name,
 constexpr const char* const kReplicaSelectionClosest = "closest";
 constexpr const char* const kReplicaSelectionFirst = "first";
 constexpr const char* const kReplicaSelectionLeader = "leader";
+constexpr const char* const kReplicaSelectionNonVoter = "non_voter";
 
 bool ValidateReplicaSelection(const char* flag_name,
                               const string& flag_value) {
@@ -195,14 +203,25 @@ bool ValidateReplicaSelection(const char* flag_name,
     kReplicaSelectionClosest,
     kReplicaSelectionFirst,
     kReplicaSelectionLeader,
+    kReplicaSelectionNonVoter,
   };
   return IsFlagValueAcceptable(flag_name, flag_value, kReplicaSelections);
 }
 
+bool ValidateCopyMutationBufferSize(const char* flag_name, int32_t flag_value) {
+  if (flag_value <= 0 || flag_value > 1024) {
+    LOG(ERROR) << Substitute("'$0': invalid value for --$1 flag: should be "
+                             "in the range of [1, 1024]", flag_value, flag_name);
+    return false;
+  }
+  return true;
+}
+
 } // anonymous namespace
 
 DEFINE_validator(write_type, &ValidateWriteType);
 DEFINE_validator(replica_selection, &ValidateReplicaSelection);
+DEFINE_validator(copy_mutation_buffer_size_mb, &ValidateCopyMutationBufferSize);
 
 namespace kudu {
 namespace tools {
@@ -564,6 +583,8 @@ TableScanner::TableScanner(
     optional<client::sp::shared_ptr<client::KuduClient>> dst_client,
     optional<std::string> dst_table_name)
     : total_count_(0),
+      total_applied_count_(0),
+      next_token_idx_(0),
       client_(std::move(client)),
       table_name_(std::move(table_name)),
       dst_client_(std::move(dst_client)),
@@ -575,7 +596,11 @@ TableScanner::TableScanner(
 
 Status TableScanner::ScanData(const vector<KuduScanToken*>& tokens,
                               const function<Status(const KuduScanBatch& batch)>& cb) {
-  for (const auto* token : tokens) {
+  // The tokens are shared by all the worker threads: every thread picks up
+  // the next token nobody has taken yet, so a few large tablets don't leave
+  // the rest of the threads idle as a static assignment would.
+  for (size_t idx = next_token_idx_++; idx < tokens.size(); idx = next_token_idx_++) {
+    const auto* token = tokens[idx];
     Stopwatch sw(Stopwatch::THIS_THREAD);
     sw.start();
 
@@ -659,28 +684,37 @@ void TableScanner::CopyTask(const vector<KuduScanToken*>& tokens, Status* thread
   // One session per thread.
   client::sp::shared_ptr<KuduSession> session((*dst_client_)->NewSession());
   TASK_RET_NOT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+  TASK_RET_NOT_OK(session->SetMutationBufferSpace(
+      static_cast<size_t>(FLAGS_copy_mutation_buffer_size_mb) * 1024 * 1024));
   TASK_RET_NOT_OK(session->SetErrorBufferSpace(1024 * 1024));
   session->SetTimeoutMillis(FLAGS_timeout_ms);
 
-  // The callback's lambda of ScanData() keeps references to the session and
-  // the destination table objects, making sure they are alive when the callback
-  // is invoked.
-  *thread_status = ScanData(tokens, [table = std::move(dst_table),
-                                     session = std::move(session),
-                                     op_type] (const KuduScanBatch& batch) {
-    auto* s_ptr = session.get();
-    auto* t_ptr = table.get();
+  // The session isn't flushed after every scan batch: that would make the
+  // thread wait for the destination tablet servers before issuing the next
+  // scan request. Instead, the session flushes its buffers in the background
+  // while the thread keeps on scanning, and the errors accumulated so far
+  // are checked after every batch.
+  auto* s_ptr = session.get();
+  auto* t_ptr = dst_table.get();
+  Status s = ScanData(tokens, [&](const KuduScanBatch& batch) {
     for (const auto& row : batch) {
       RETURN_NOT_OK(AddRow(s_ptr, t_ptr, row, op_type));
     }
-    // Flush the session to make sure all write operations have been sent
-    // to the server. If any error happens, CheckPendingErrors() will report
-    // on them.
-    auto s = s_ptr->Flush();
-    CheckPendingErrors(s_ptr);
-    return s;
+    total_applied_count_ += batch.NumRows();
+    if (PREDICT_FALSE(s_ptr->CountPendingErrors() > 0)) {
+      CheckPendingErrors(s_ptr);
+      return Status::IOError("failed to write rows into the destination table");
+    }
+    return Status::OK();
   });
 
+  // Flush the session to make sure all write operations have been sent
+  // to the server. If any error happens, CheckPendingErrors() will report
+  // on them.
+  const auto flush_status = s_ptr->Flush();
+  CheckPendingErrors(s_ptr);
+  *thread_status = s.ok() ? flush_status : s;
+
 #undef TASK_RET_NOT_OK
 }
 
@@ -782,13 +816,13 @@ Status TableScanner::StartWork(WorkType work_type) {
 
   // Set tablet filter.
   const set<string>& tablet_id_filters = Split(FLAGS_tablets, ",", strings::SkipWhitespace());
-  map<int, vector<KuduScanToken*>> thread_tokens;
-  int i = 0;
+  vector<KuduScanToken*> work_tokens;
   for (auto* token : tokens) {
     if (tablet_id_filters.empty() || ContainsKey(tablet_id_filters, token->tablet().id())) {
-      thread_tokens[i++ % num_threads].emplace_back(token);
+      work_tokens.emplace_back(token);
     }
   }
+  next_token_idx_ = 0;
 
   RETURN_NOT_OK(ThreadPoolBuilder("table_scan_pool")
                   .set_max_threads(num_threads)
@@ -800,8 +834,8 @@ Status TableScanner::StartWork(WorkType work_type) {
 
   Stopwatch sw(Stopwatch::THIS_THREAD);
   sw.start();
-  for (i = 0; i < num_threads; ++i) {
-    auto* t_tokens = &thread_tokens[i];
+  for (int i = 0; i < num_threads; ++i) {
+    const auto* t_tokens = &work_tokens;
     auto* t_status = &thread_statuses[i];
     if (work_type == WorkType::kScan) {
       RETURN_NOT_OK(thread_pool_->Submit([this, t_tokens, t_status]()
@@ -812,15 +846,38 @@ Status TableScanner::StartWork(WorkType work_type) {
                                          { this->CopyTask(*t_tokens, t_status); }));
     }
   }
+  uint64_t last_count = 0;
+  MonoTime last_report = MonoTime::Now();
   while (!thread_pool_->WaitFor(MonoDelta::FromSeconds(5))) {
-    LOG(INFO) << "Scanned count: " << total_count_;
+    const auto now = MonoTime::Now();
+    const uint64_t count = total_count_;
+    const double rate = (count - last_count) / (now - last_report).ToSeconds();
+    const size_t tokens_started = std::min<size_t>(next_token_idx_, work_tokens.size());
+    if (work_type == WorkType::kScan) {
+      LOG(INFO) << Substitute("Scanned count: $0 ($1 rows/s), tablets started: $2/$3",
+                              count, static_cast<int64_t>(rate),
+                              tokens_started, work_tokens.size());
+    } else {
+      LOG(INFO) << Substitute("Scanned count: $0 ($1 rows/s), applied count: $2, "
+                              "tablets started: $3/$4",
+                              count, static_cast<int64_t>(rate),
+                              total_applied_count_.load(),
+                              tokens_started, work_tokens.size());
+    }
+    last_count = count;
+    last_report = now;
   }
   thread_pool_->Shutdown();
 
   sw.stop();
   if (out_) {
+    const double elapsed = sw.elapsed().wall_seconds();
     *out_ << "Total count " << total_count_
-        << " cost " << sw.elapsed().wall_seconds() << " seconds" << endl;
+        << " cost " << elapsed << " seconds";
+    if (elapsed > 0) {
+      *out_ << " (" << static_cast<int64_t>(total_count_ / elapsed) << " rows/s)";
+    }
+    *out_ << endl;
   }
 
   const auto& operation = work_type == WorkType::kScan ? "Scanning" : "Copying";
@@ -911,6 +968,8 @@ Status TableScanner::ParseReplicaSelection(
     *selection = KuduClient::ReplicaSelection::LEADER_ONLY;
   } else if (iequals(kReplicaSelectionFirst, selection_str)) {
     *selection = KuduClient::ReplicaSelection::FIRST_REPLICA;
+  } else if (iequals(kReplicaSelectionNonVoter, selection_str)) {
+    *selection = KuduClient::ReplicaSelection::CLOSEST_NON_VOTER;
   } else {
     return Status::InvalidArgument("invalid replica selection", selection_str);
   }
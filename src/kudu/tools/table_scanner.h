@@ -18,6 +18,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <iosfwd>
@@ -86,6 +87,10 @@ class TableScanner {
       client::KuduClient::ReplicaSelection* selection);
 
   Status StartWork(WorkType work_type);
+
+  // Scan the tokens in 'tokens', invoking 'cb' on every batch. The tokens are
+  // shared among all the worker threads running ScanData(): each token is
+  // scanned by the first thread which picks it up.
   Status ScanData(const std::vector<client::KuduScanToken*>& tokens,
                   const std::function<Status(const client::KuduScanBatch& batch)>& cb);
   void ScanTask(const std::vector<client::KuduScanToken*>& tokens,
@@ -94,6 +99,12 @@ class TableScanner {
                 Status* thread_status);
 
   std::atomic<uint64_t> total_count_;
+  // The number of rows applied to the destination table's sessions when
+  // copying a table.
+  std::atomic<uint64_t> total_applied_count_;
+  // The index of the next token to scan in the tokens shared by the worker
+  // threads.
+  std::atomic<size_t> next_token_idx_;
   std::optional<client::KuduScanner::ReadMode> mode_;
   client::sp::shared_ptr<client::KuduClient> client_;
   std::string table_name_;
@@ -410,6 +410,7 @@ unique_ptr<Mode> BuildClusterMode() {
         .Description(desc)
         .ExtraDescription(extra_desc)
         .AddOptionalParameter("checksum_cache_blocks")
+        .AddOptionalParameter("checksum_reuse_rowset_checksums")
         .AddOptionalParameter("checksum_scan")
         .AddOptionalParameter("checksum_scan_concurrency")
         .AddOptionalParameter("checksum_snapshot")
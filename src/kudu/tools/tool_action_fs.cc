@@ -569,6 +569,7 @@ enum class Field {
   kCFileDataType,
   kCFileNullable,
   kCFileEncoding,
+  kCFileBlockEncodings,
   kCFileCompression,
   kCFileNumValues,
   kCFileSize,
@@ -593,6 +594,7 @@ const Field kFieldVariants[] = {
   Field::kCFileDataType,
   Field::kCFileNullable,
   Field::kCFileEncoding,
+  Field::kCFileBlockEncodings,
   Field::kCFileCompression,
   Field::kCFileNumValues,
   Field::kCFileSize,
@@ -637,6 +639,7 @@ const char* ToString(Field field) {
     case Field::kCFileDataType: return "cfile-data-type";
     case Field::kCFileNullable: return "cfile-nullable";
     case Field::kCFileEncoding: return "cfile-encoding";
+    case Field::kCFileBlockEncodings: return "cfile-block-encodings";
     case Field::kCFileCompression: return "cfile-compression";
     case Field::kCFileNumValues: return "cfile-num-values";
     case Field::kCFileSize: return "cfile-size";
@@ -693,6 +696,7 @@ FieldGroup ToFieldGroup(Field field) {
     case Field::kCFileDataType:
     case Field::kCFileNullable:
     case Field::kCFileEncoding:
+    case Field::kCFileBlockEncodings:
     case Field::kCFileCompression:
     case Field::kCFileNumValues:
     case Field::kCFileSize:
@@ -781,6 +785,17 @@ string FormatCFileDeltaStats(const CFileReader& cfile) {
   return deltastats.ToString();
 }
 
+// Formats the number of data blocks written with each encoding, as recorded
+// by adaptive encoding. Empty for the other encodings.
+string FormatCFileBlockEncodings(const CFileReader& cfile) {
+  vector<string> counts;
+  for (const auto& count : cfile.footer().block_encoding_counts()) {
+    counts.emplace_back(Substitute("$0:$1", EncodingType_Name(count.encoding()),
+                                   count.num_blocks()));
+  }
+  return JoinStrings(counts, " ");
+}
+
 // Returns cfile info for the field.
 string CFileInfo(Field field,
                  const TabletMetadata& tablet,
@@ -796,6 +811,8 @@ string CFileInfo(Field field,
       return cfile.is_nullable() ? "true" : "false";
     case Field::kCFileEncoding:
       return EncodingType_Name(cfile.type_encoding_info()->encoding_type());
+    case Field::kCFileBlockEncodings:
+      return FormatCFileBlockEncodings(cfile);
     case Field::kCFileCompression:
       return CompressionType_Name(cfile.footer().compression());
     case Field::kCFileNumValues: if (FLAGS_h) {
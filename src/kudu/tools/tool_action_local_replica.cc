@@ -37,16 +37,19 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/clock/logical_clock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/partition.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/rowblock_memory.h"
 #include "kudu/common/schema.h"
+#include "kudu/common/timestamp.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/consensus/consensus.pb.h"
 #include "kudu/consensus/consensus_meta.h"
 #include "kudu/consensus/consensus_meta_manager.h"
+#include "kudu/consensus/log.h"
 #include "kudu/consensus/log.pb.h"
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/log_index.h"
@@ -54,6 +57,7 @@
 #include "kudu/consensus/log_util.h"
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/consensus/opid.pb.h"
+#include "kudu/consensus/raft_consensus.h"
 #include "kudu/fs/block_id.h"
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/data_dirs.h"
@@ -76,6 +80,8 @@
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_bootstrap.h"
 #include "kudu/tablet/tablet_mem_trackers.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet_replica.h"
@@ -133,6 +139,12 @@ DEFINE_bool(ignore_nonexistent, false,
             "Whether to ignore non-existent tablet replicas when deleting: if "
             "set to 'true', the tool does not report an error if the requested "
             "tablet replica to remove is not found");
+DEFINE_int32(compaction_max_threads_per_tablet, 1,
+             "Maximum number of threads a compaction of a tablet replica by "
+             "'local_replica compact' may use to write its output rowsets. "
+             "The replicas themselves are compacted by --num_threads threads.");
+DEFINE_validator(compaction_max_threads_per_tablet,
+                 [](const char* /*n*/, int32_t v) { return v > 0; });
 DEFINE_string(src_fs_wal_dir, "",
               "Source: Directory with write-ahead logs.");
 DEFINE_string(src_fs_data_dirs, "",
@@ -166,6 +178,8 @@ DECLARE_int64(tablet_copy_throttler_bytes_per_sec);
 DECLARE_double(tablet_copy_throttler_burst_factor);
 DECLARE_string(tables);
 
+using kudu::clock::LogicalClock;
+using kudu::consensus::ConsensusBootstrapInfo;
 using kudu::consensus::ConsensusMetadata;
 using kudu::consensus::ConsensusMetadataManager;
 using kudu::consensus::OpId;
@@ -173,6 +187,8 @@ using kudu::consensus::RaftConfigPB;
 using kudu::consensus::RaftPeerPB;
 using kudu::fs::IOContext;
 using kudu::fs::ReadableBlock;
+using kudu::log::Log;
+using kudu::log::LogAnchorRegistry;
 using kudu::log::LogEntryPB;
 using kudu::log::LogEntryReader;
 using kudu::log::LogReader;
@@ -183,6 +199,7 @@ using kudu::tablet::DiskRowSet;
 using kudu::tablet::RowIteratorOptions;
 using kudu::tablet::RowSetMetadata;
 using kudu::tablet::RowSetMetadataIds;
+using kudu::tablet::Tablet;
 using kudu::tablet::TabletDataState;
 using kudu::tablet::TabletMetadata;
 using kudu::tablet::TabletReplica;
@@ -666,12 +683,18 @@ Status DeleteRowsets(const RunnerContext& context) {
                         Substitute("could not load tablet metadata for $0", tablet_id));
 
   if (FLAGS_backup_metadata) {
-    // Move the old tablet metadata file to a backup location.
+    // Write the old tablet metadata to a backup location. The superblock is
+    // taken from the loaded metadata rather than renamed so that the updates
+    // of its superblock log, if any, are part of the backup.
     string original_path = fs_manager.GetTabletMetadataPath(tablet_id);
     string backup_path = Substitute("$0.bak.$1", original_path, GetCurrentTimeMicros());
-    RETURN_NOT_OK_PREPEND(Env::Default()->RenameFile(original_path, backup_path),
+    tablet::TabletSuperBlockPB superblock;
+    RETURN_NOT_OK(meta->ToSuperBlock(&superblock));
+    RETURN_NOT_OK_PREPEND(pb_util::WritePBContainerToPath(
+                              Env::Default(), backup_path, superblock,
+                              pb_util::NO_OVERWRITE, pb_util::SYNC, pb_util::SENSITIVE),
                           "couldn't back up original file");
-    LOG(INFO) << "Moved original file to " << backup_path;
+    LOG(INFO) << "Backed up original file to " << backup_path;
   }
 
   RETURN_NOT_OK(meta->UpdateAndFlush(
@@ -899,6 +922,117 @@ Status DeleteLocalReplicas(const RunnerContext& context) {
   return Status::OK();
 }
 
+// Bootstraps the local replica 'tablet_id', flushes its MemRowSet and compacts
+// all of its rowsets into new ones. Since a full compaction rewrites the base
+// data with the deltas of the input rowsets applied, it subsumes the major
+// compaction of their delta stores.
+//
+// The replica must be bootstrapped rather than just opened from its metadata:
+// the updates in the DeltaMemStores of a rowset are only in the WAL, and once
+// the rowset is compacted away they would be considered flushed at the next
+// bootstrap and lost.
+Status CompactLocalReplica(const string& tablet_id,
+                           FsManager* fs_manager,
+                           const scoped_refptr<ConsensusMetadataManager>& cmeta_manager) {
+  scoped_refptr<TabletMetadata> tmeta;
+  RETURN_NOT_OK(TabletMetadata::Load(fs_manager, tablet_id, &tmeta));
+  if (tmeta->tablet_data_state() != TabletDataState::TABLET_DATA_READY) {
+    LOG(INFO) << Substitute("skipping tablet replica $0 in state $1", tablet_id,
+                            TabletDataState_Name(tmeta->tablet_data_state()));
+    return Status::OK();
+  }
+  scoped_refptr<ConsensusMetadata> cmeta;
+  RETURN_NOT_OK(cmeta_manager->Load(tablet_id, &cmeta));
+
+  // History is never GCed with a logical clock, so the compaction keeps all
+  // the versions of the rows: the tablet server GCs them once restarted.
+  LogicalClock clock(Timestamp::kInitialTimestamp);
+  RETURN_NOT_OK(clock.Init());
+  scoped_refptr<LogAnchorRegistry> registry(new LogAnchorRegistry());
+  shared_ptr<Tablet> tablet;
+  scoped_refptr<Log> log;
+  ConsensusBootstrapInfo cbi;
+  RETURN_NOT_OK(tablet::BootstrapTablet(std::move(tmeta),
+                                        cmeta->CommittedConfig(),
+                                        &clock,
+                                        /*mem_tracker=*/ nullptr,
+                                        /*result_tracker=*/ nullptr,
+                                        /*metric_registry=*/ nullptr,
+                                        /*file_cache=*/ nullptr,
+                                        /*tablet_replica=*/ nullptr,
+                                        std::move(registry),
+                                        &tablet,
+                                        &log,
+                                        &cbi));
+  const size_t num_rowsets_before = tablet->num_rowsets();
+  Status s = tablet->Flush().AndThen([&] {
+    return tablet->Compact(Tablet::FORCE_COMPACT_ALL,
+                           FLAGS_compaction_max_threads_per_tablet);
+  });
+  const size_t num_rowsets_after = tablet->num_rowsets();
+  tablet->Shutdown();
+  RETURN_NOT_OK(log->Close());
+  RETURN_NOT_OK_PREPEND(s, Substitute("could not compact tablet replica $0", tablet_id));
+  LOG(INFO) << Substitute("compacted tablet replica $0: $1 rowsets before, $2 after",
+                          tablet_id, num_rowsets_before, num_rowsets_after);
+  return Status::OK();
+}
+
+Status CompactLocalReplicas(const RunnerContext& context) {
+  const string& tablet_ids_str = FindOrDie(context.required_args, kTabletIdsGlobArg);
+  vector<string> tablet_id_patterns = strings::Split(tablet_ids_str, ",", strings::SkipEmpty());
+  if (tablet_id_patterns.empty()) {
+    return Status::InvalidArgument("no tablet identifiers provided");
+  }
+
+  // The file system is opened read-write, which locks its directories and so
+  // fails if the tablet server is running.
+  FsManager fs_manager(Env::Default(), {});
+  RETURN_NOT_OK(fs_manager.Open());
+  scoped_refptr<ConsensusMetadataManager> cmeta_manager(new ConsensusMetadataManager(&fs_manager));
+
+  vector<string> tablets;
+  RETURN_NOT_OK(GetTabletIdsByTableName(&fs_manager, &tablets));
+  vector<string> tablet_ids;
+  for (const auto& tablet_id : tablets) {
+    if (MatchesAnyPattern(tablet_id_patterns, tablet_id)) {
+      tablet_ids.emplace_back(tablet_id);
+    }
+  }
+  if (tablet_ids.empty()) {
+    return Status::NotFound(
+        "specified tablet id (pattern) does not exist or does not match "
+        "table name patterns specified in --tables flag.");
+  }
+
+  unique_ptr<ThreadPool> pool;
+  RETURN_NOT_OK(ThreadPoolBuilder("tool-compaction-pool")
+                .set_max_threads(FLAGS_num_threads)
+                .Build(&pool));
+  simple_spinlock lock;
+  vector<string> failed_tablet_ids;
+  for (const auto& tablet_id : tablet_ids) {
+    RETURN_NOT_OK(pool->Submit([&]() {
+      Status s = CompactLocalReplica(tablet_id, &fs_manager, cmeta_manager);
+      if (!s.ok()) {
+        LOG(ERROR) << s.ToString();
+        std::lock_guard<simple_spinlock> l(lock);
+        failed_tablet_ids.emplace_back(tablet_id);
+      }
+    }));
+  }
+  pool->Wait();
+  pool->Shutdown();
+
+  if (!failed_tablet_ids.empty()) {
+    return Status::RuntimeError(Substitute(
+        "failed to compact tablet replicas $0: check error messages for details",
+        JoinStrings(failed_tablet_ids, ",")));
+  }
+  LOG(INFO) << Substitute("compacted $0 tablet replicas.", tablet_ids.size());
+  return Status::OK();
+}
+
 Status SummarizeSize(FsManager* fs,
                      const vector<BlockId>& blocks,
                      StringPiece block_type,
@@ -1482,6 +1616,22 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
       .AddOptionalParameter("num_threads")
       .Build();
 
+  unique_ptr<Action> compact_local_replica =
+      ActionBuilder("compact", &CompactLocalReplicas)
+      .Description("Compact tablet replicas in the local filesystem")
+      .ExtraDescription("Each replica is bootstrapped from its metadata and WAL, then its "
+          "MemRowSet is flushed and all of its rowsets are compacted into new ones, with their "
+          "deltas applied. Up to --num_threads replicas are compacted concurrently. The "
+          "tablet server must be stopped: the tool fails otherwise.")
+      .AddRequiredParameter({ kTabletIdsGlobArg, kTabletIdsGlobArgDesc })
+      .AddOptionalParameter("compaction_max_threads_per_tablet")
+      .AddOptionalParameter("fs_data_dirs")
+      .AddOptionalParameter("fs_metadata_dir")
+      .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("num_threads")
+      .AddOptionalParameter("tables")
+      .Build();
+
   unique_ptr<Action> list =
       ActionBuilder("list", &ListLocalReplicas)
       .Description("Show list of tablet replicas in the local filesystem")
@@ -1518,6 +1668,7 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
       .Description("Operate on local tablet replicas via the local filesystem")
       .AddMode(std::move(cmeta))
       .AddMode(std::move(tmeta))
+      .AddAction(std::move(compact_local_replica))
       .AddAction(std::move(copy_from_local))
       .AddAction(std::move(copy_from_remote))
       .AddAction(std::move(data_size))
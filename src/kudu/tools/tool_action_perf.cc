@@ -162,8 +162,22 @@
 //      |  | thread2 +---------+
 //      |  |         | tabletC |
 //      v  +---------+         v
+//
+// The 'workload' action runs a mix of operations modeled after the core
+// workloads of YCSB against a table it loads first, and reports the
+// throughput and the latency percentiles of each kind of operation. For
+// example, to load 1M rows into an auto-created table with 8 threads and then
+// run workload B (95% reads, 5% updates) for 5 minutes with uniformly
+// distributed keys:
+//
+//   kudu perf workload 127.0.0.1 --num_threads=8 --workload=b \
+//     --workload_record_count=1000000 --workload_duration_sec=300 \
+//     --workload_request_distribution=uniform
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
@@ -183,8 +197,11 @@
 #include <glog/logging.h>
 
 #include "kudu/client/client.h"
+#include "kudu/client/scan_batch.h"
+#include "kudu/client/scan_predicate.h"
 #include "kudu/client/schema.h"
 #include "kudu/client/shared_ptr.h" // IWYU pragma: keep
+#include "kudu/client/value.h"
 #include "kudu/client/write_op.h"
 #include "kudu/clock/logical_clock.h"
 #include "kudu/common/common.pb.h"
@@ -208,6 +225,7 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/result_tracker.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/tablet.h"
 #include "kudu/tablet/tablet_bootstrap.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet_replica.h"
@@ -217,19 +235,17 @@
 #include "kudu/util/decimal_util.h"
 #include "kudu/util/env.h"
 #include "kudu/util/flag_validators.h"
+#include "kudu/util/hash_util.h"
+#include "kudu/util/hdr_histogram.h"
 #include "kudu/util/int128.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/oid_generator.h"
 #include "kudu/util/random.h"
+#include "kudu/util/random_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 
-namespace kudu {
-namespace tablet {
-class Tablet;
-}  // namespace tablet
-}  // namespace kudu
-
 using kudu::ColumnSchema;
 using kudu::KuduPartialRow;
 using kudu::Stopwatch;
@@ -237,6 +253,8 @@ using kudu::TypeInfo;
 using kudu::client::KuduClient;
 using kudu::client::KuduColumnSchema;
 using kudu::client::KuduError;
+using kudu::client::KuduPredicate;
+using kudu::client::KuduScanBatch;
 using kudu::client::KuduScanner;
 using kudu::client::KuduSchema;
 using kudu::client::KuduSchemaBuilder;
@@ -244,6 +262,7 @@ using kudu::client::KuduSession;
 using kudu::client::KuduTable;
 using kudu::client::KuduTableCreator;
 using kudu::client::KuduTransaction;
+using kudu::client::KuduValue;
 using kudu::client::KuduWriteOperation;
 using kudu::client::sp::shared_ptr;
 using kudu::clock::LogicalClock;
@@ -252,6 +271,7 @@ using kudu::consensus::ConsensusMetadata;
 using kudu::consensus::ConsensusMetadataManager;
 using kudu::log::Log;
 using kudu::log::LogAnchorRegistry;
+using kudu::tablet::BootstrapStats;
 using kudu::tablet::RowIteratorOptions;
 using kudu::tablet::Tablet;
 using kudu::tablet::TabletMetadata;
@@ -265,6 +285,7 @@ using std::ostringstream;
 using std::string;
 using std::thread;
 using std::unique_ptr;
+using std::unordered_map;
 using std::vector;
 using strings::Substitute;
 using strings::SubstituteAndAppend;
@@ -292,7 +313,7 @@ DEFINE_bool(keep_auto_table, false,
             "(see the '--table_name' flag): neither the existing table "
             "nor its data is ever dropped/deleted.");
 DEFINE_int32(num_iters, 1,
-             "Number of times to run the scan.");
+             "Number of times to run the scan or the bootstrap.");
 DEFINE_int64(num_rows_per_thread, 1000,
              "Number of rows each thread generates and inserts; "
              "-1 means unlimited. All rows generated by a thread are inserted "
@@ -304,6 +325,10 @@ DEFINE_bool(use_client_per_thread,
             "internals.");
 DEFINE_bool(ordered_scan, false,
             "Whether to run an ordered or unordered scan.");
+DEFINE_bool(flush_after_bootstrap, false,
+            "Whether to flush the MemRowSet of each tablet after bootstrapping "
+            "it, timing the flush. The flushed operations aren't replayed by "
+            "the next bootstraps of the tablet anymore.");
 DEFINE_bool(run_scan, false,
             "Whether to run post-insertion scan to verify that the count of "
             "the inserted rows matches the expected number. If enabled, "
@@ -385,6 +410,30 @@ DEFINE_bool(txn_rollback, false,
             "Whether to rollback the multi-row transaction which contains all "
             "the inserted rows. Setting --txn_rollback=true implies setting "
             "--txn_start=true as well.");
+DEFINE_string(workload, "a",
+              "The workload run by 'kudu perf workload', modeled after the core "
+              "workloads of YCSB: 'a' (50% reads, 50% updates), 'b' (95% reads, "
+              "5% updates), 'c' (100% reads), 'd' (95% reads, 5% inserts, reading "
+              "the most recently inserted rows), 'e' (95% short scans, 5% inserts) "
+              "or 'f' (50% reads, 50% read-modify-writes)");
+DEFINE_int64(workload_record_count, 100000,
+             "Number of rows loaded into the table before running the workload. "
+             "The keys of the rows are 0 to this number, exclusive.");
+DEFINE_int32(workload_duration_sec, 30,
+             "For how long to run the workload once the rows are loaded, in seconds");
+DEFINE_string(workload_request_distribution, "",
+              "Distribution of the keys of the rows read, updated or scanned by the "
+              "workload: 'uniform', 'zipfian' (a few rows are much more popular than "
+              "the others) or 'latest' (the most recently inserted rows are the most "
+              "popular). If empty, 'latest' for workload 'd', and 'zipfian' otherwise.");
+DEFINE_int32(workload_max_scan_length, 100,
+             "Maximum number of consecutive keys covered by each scan of workload 'e'; "
+             "the length of each scan is uniformly distributed between 1 and this "
+             "number");
+DEFINE_bool(workload_skip_load, false,
+            "Whether to skip loading the rows before running the workload, e.g. when "
+            "the table given by --table_name was loaded by a previous run with the "
+            "same --workload_record_count");
 
 DECLARE_bool(show_values);
 DECLARE_int32(num_threads);
@@ -1017,6 +1066,591 @@ Status TabletScan(const RunnerContext& context) {
   return Status::OK();
 }
 
+// The timings of a bootstrap of a local tablet by 'kudu perf bootstrap'.
+struct BootstrapTimings {
+  BootstrapStats stats;
+  MonoDelta flush_time = MonoDelta::FromNanoseconds(0);
+  MonoDelta total_time = MonoDelta::FromNanoseconds(0);
+};
+
+// Bootstraps the local tablet 'tablet_id' like a tablet server does when
+// starting up, then shuts it down.
+Status BootstrapLocalTablet(FsManager* fs,
+                            ConsensusMetadataManager* cmeta_manager,
+                            const string& tablet_id,
+                            BootstrapTimings* timings) {
+  scoped_refptr<TabletMetadata> tmeta;
+  RETURN_NOT_OK(TabletMetadata::Load(fs, tablet_id, &tmeta));
+  scoped_refptr<ConsensusMetadata> cmeta;
+  RETURN_NOT_OK(cmeta_manager->Load(tablet_id, &cmeta));
+
+  LogicalClock clock(Timestamp::kInitialTimestamp);
+  RETURN_NOT_OK(clock.Init());
+  scoped_refptr<LogAnchorRegistry> registry(new LogAnchorRegistry());
+
+  std::shared_ptr<Tablet> tablet;
+  scoped_refptr<Log> log;
+  ConsensusBootstrapInfo cbi;
+  const MonoTime start = MonoTime::Now();
+  RETURN_NOT_OK(tablet::BootstrapTablet(std::move(tmeta),
+                                        cmeta->CommittedConfig(),
+                                        &clock,
+                                        /*mem_tracker=*/ nullptr,
+                                        /*result_tracker=*/ nullptr,
+                                        /*metric_registry=*/ nullptr,
+                                        /*file_cache=*/ nullptr,
+                                        /*tablet_replica=*/ nullptr,
+                                        std::move(registry),
+                                        &tablet,
+                                        &log,
+                                        &cbi,
+                                        &timings->stats));
+  Status s;
+  if (FLAGS_flush_after_bootstrap) {
+    const MonoTime flush_start = MonoTime::Now();
+    s = tablet->Flush();
+    timings->flush_time = MonoTime::Now() - flush_start;
+  }
+  timings->total_time = MonoTime::Now() - start;
+  tablet->Shutdown();
+  RETURN_NOT_OK(s);
+  return log->Close();
+}
+
+Status TabletBootstrapBenchmark(const RunnerContext& context) {
+  const string& tablet_ids_str = FindOrDie(context.required_args, kTabletIdsCsvArg);
+  const vector<string> tablet_ids = strings::Split(tablet_ids_str, ",", strings::SkipEmpty());
+  if (tablet_ids.empty()) {
+    return Status::InvalidArgument("no tablet identifiers provided");
+  }
+
+  // Bootstrapping does destructive things (e.g. rename the tablet's WAL
+  // segment directory, and write a new one), so the tablets must be copies,
+  // or at least their tablet server must be stopped.
+  FsManager fs(Env::Default());
+  RETURN_NOT_OK(fs.Open());
+  scoped_refptr<ConsensusMetadataManager> cmeta_manager(
+      new ConsensusMetadataManager(&fs));
+
+  for (int iter = 0; iter < FLAGS_num_iters; iter++) {
+    // Up to --num_threads tablets are bootstrapped concurrently, like the
+    // tablet server does with --num_tablets_to_open_simultaneously.
+    vector<BootstrapTimings> timings(tablet_ids.size());
+    vector<Status> statuses(tablet_ids.size());
+    std::atomic<size_t> next_tablet_idx(0);
+    const MonoTime start = MonoTime::Now();
+    vector<thread> threads;
+    const int num_threads = std::min<int>(FLAGS_num_threads, tablet_ids.size());
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&]() {
+        for (size_t idx = next_tablet_idx++; idx < tablet_ids.size(); idx = next_tablet_idx++) {
+          statuses[idx] = BootstrapLocalTablet(&fs, cmeta_manager.get(), tablet_ids[idx],
+                                               &timings[idx]);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    const MonoDelta elapsed = MonoTime::Now() - start;
+
+    for (size_t idx = 0; idx < tablet_ids.size(); idx++) {
+      RETURN_NOT_OK_PREPEND(statuses[idx], Substitute(
+          "could not bootstrap tablet $0", tablet_ids[idx]));
+      const auto& t = timings[idx];
+      cout << Substitute("iter $0, tablet $1: total $2, open $3, read $4 "
+                         "(waited $5), replay $6, flush $7; "
+                         "ops read $8, of which committed $9",
+                         iter, tablet_ids[idx], t.total_time.ToString(),
+                         t.stats.open_time.ToString(), t.stats.read_time.ToString(),
+                         t.stats.read_wait_time.ToString(),
+                         t.stats.replay_time.ToString(), t.flush_time.ToString(),
+                         t.stats.ops_read, t.stats.ops_committed)
+           << endl;
+    }
+    cout << Substitute("iter $0: bootstrapped $1 tablets in $2",
+                       iter, tablet_ids.size(), elapsed.ToString())
+         << endl;
+  }
+  return Status::OK();
+}
+
+// The kinds of operations of 'kudu perf workload'.
+enum WorkloadOp {
+  WORKLOAD_READ,
+  WORKLOAD_UPDATE,
+  WORKLOAD_INSERT,
+  WORKLOAD_SCAN,
+  WORKLOAD_READ_MODIFY_WRITE,
+  kNumWorkloadOps
+};
+
+const char* WorkloadOpToString(WorkloadOp op) {
+  switch (op) {
+    case WORKLOAD_READ:
+      return "READ";
+    case WORKLOAD_UPDATE:
+      return "UPDATE";
+    case WORKLOAD_INSERT:
+      return "INSERT";
+    case WORKLOAD_SCAN:
+      return "SCAN";
+    case WORKLOAD_READ_MODIFY_WRITE:
+      return "READ-MODIFY-WRITE";
+    default:
+      LOG(FATAL) << Substitute("unsupported workload op $0", op);
+  }
+}
+
+// The percentage of each kind of operation of a workload.
+typedef std::array<int, kNumWorkloadOps> WorkloadMix;
+
+Status GetWorkloadMix(const string& workload, WorkloadMix* mix) {
+  //                                              READ UPDATE INSERT SCAN RMW
+  static const unordered_map<string, WorkloadMix> kMixes = {
+    { "a", {{ 50, 50, 0, 0, 0 }} },
+    { "b", {{ 95, 5, 0, 0, 0 }} },
+    { "c", {{ 100, 0, 0, 0, 0 }} },
+    { "d", {{ 95, 0, 5, 0, 0 }} },
+    { "e", {{ 0, 0, 5, 95, 0 }} },
+    { "f", {{ 50, 0, 0, 0, 50 }} },
+  };
+  const auto* m = FindOrNull(kMixes, workload);
+  if (!m) {
+    return Status::InvalidArgument(
+        Substitute("unknown workload '$0'", workload), "expected one of 'a' to 'f'");
+  }
+  *mix = *m;
+  return Status::OK();
+}
+
+enum class KeyDistribution {
+  UNIFORM,
+  ZIPFIAN,
+  LATEST,
+};
+
+Status GetKeyDistribution(const string& workload, const string& name,
+                          KeyDistribution* dist) {
+  if (name.empty()) {
+    *dist = workload == "d" ? KeyDistribution::LATEST : KeyDistribution::ZIPFIAN;
+  } else if (name == "uniform") {
+    *dist = KeyDistribution::UNIFORM;
+  } else if (name == "zipfian") {
+    *dist = KeyDistribution::ZIPFIAN;
+  } else if (name == "latest") {
+    *dist = KeyDistribution::LATEST;
+  } else {
+    return Status::InvalidArgument(
+        Substitute("unknown request distribution '$0'", name),
+        "expected 'uniform', 'zipfian' or 'latest'");
+  }
+  return Status::OK();
+}
+
+// Generates integers in [0, num_items) following a Zipfian distribution in
+// which 0 is the most popular, with the algorithm of Gray et al., "Quickly
+// Generating Billion-Record Synthetic Databases", as YCSB does. The constants
+// are computed once, in O(num_items), so that a generator can be shared by
+// threads with their own Random.
+class ZipfianGenerator {
+ public:
+  static constexpr double kTheta = 0.99;
+
+  explicit ZipfianGenerator(uint64_t num_items)
+      : num_items_(std::max<uint64_t>(num_items, 1)),
+        alpha_(1.0 / (1.0 - kTheta)),
+        zetan_(Zeta(num_items_)),
+        eta_((1.0 - std::pow(2.0 / num_items_, 1.0 - kTheta)) / (1.0 - Zeta(2) / zetan_)) {
+  }
+
+  uint64_t Next(Random* rng) const {
+    const double u = rng->NextDoubleFraction();
+    const double uz = u * zetan_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, kTheta)) {
+      return std::min<uint64_t>(1, num_items_ - 1);
+    }
+    return std::min(num_items_ - 1,
+                    static_cast<uint64_t>(num_items_ * std::pow(eta_ * u - eta_ + 1.0, alpha_)));
+  }
+
+ private:
+  static double Zeta(uint64_t n) {
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++) {
+      sum += 1.0 / std::pow(i, kTheta);
+    }
+    return sum;
+  }
+
+  const uint64_t num_items_;
+  const double alpha_;
+  const double zetan_;
+  const double eta_;
+};
+
+// Runs a YCSB-style workload against a table with an INT64 'key' primary key
+// column and kWorkloadNumFields STRING columns.
+class Workload {
+ public:
+  static constexpr const char* const kKeyColumnName = "key";
+  static constexpr int kWorkloadNumFields = 10;
+
+  // Latencies above this are recorded as this, in microseconds.
+  static constexpr int64_t kMaxLatencyUs = 60 * 1000 * 1000;
+
+  Workload(shared_ptr<KuduClient> client,
+           string table_name,
+           WorkloadMix mix,
+           KeyDistribution dist)
+      : client_(std::move(client)),
+        table_name_(std::move(table_name)),
+        mix_(mix),
+        dist_(dist),
+        zipf_(FLAGS_workload_record_count),
+        next_insert_key_(FLAGS_workload_record_count) {
+    for (int i = 0; i < kNumWorkloadOps; i++) {
+      latencies_[i].reset(new HdrHistogram(kMaxLatencyUs, 2));
+      errors_[i] = 0;
+    }
+  }
+
+  // Returns the schema of the tables of the workload.
+  static Status BuildSchema(KuduSchema* schema) {
+    KuduSchemaBuilder b;
+    b.AddColumn(kKeyColumnName)->Type(KuduColumnSchema::INT64)->NotNull()->PrimaryKey();
+    for (int i = 0; i < kWorkloadNumFields; i++) {
+      b.AddColumn(FieldName(i))->Type(KuduColumnSchema::STRING);
+    }
+    return b.Build(schema);
+  }
+
+  // Upserts the --workload_record_count rows of the workload with
+  // --num_threads threads.
+  Status Load() {
+    const int num_threads = FLAGS_num_threads;
+    vector<Status> statuses(num_threads);
+    vector<thread> threads;
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([this, i, num_threads, &statuses]() {
+        statuses[i] = LoadThread(i, num_threads);
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    for (const auto& s : statuses) {
+      RETURN_NOT_OK(s);
+    }
+    return Status::OK();
+  }
+
+  // Runs the workload with --num_threads threads for --workload_duration_sec.
+  Status Run() {
+    const int num_threads = FLAGS_num_threads;
+    const MonoTime deadline =
+        MonoTime::Now() + MonoDelta::FromSeconds(FLAGS_workload_duration_sec);
+    vector<Status> statuses(num_threads);
+    vector<thread> threads;
+    threads.reserve(num_threads);
+    Stopwatch sw(Stopwatch::ALL_THREADS);
+    sw.start();
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([this, i, deadline, &statuses]() {
+        statuses[i] = RunThread(i, deadline);
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    sw.stop();
+    elapsed_sec_ = sw.elapsed().wall_seconds();
+    for (const auto& s : statuses) {
+      RETURN_NOT_OK(s);
+    }
+    return Status::OK();
+  }
+
+  // Writes the throughput and the latency percentiles of each kind of
+  // operation to 'out'. Returns the total number of failed operations.
+  int64_t Report(std::ostream* out) const {
+    int64_t total_ops = 0;
+    int64_t total_errors = 0;
+    for (int i = 0; i < kNumWorkloadOps; i++) {
+      const HdrHistogram& h = *latencies_[i];
+      const int64_t errors = errors_[i];
+      if (h.TotalCount() == 0 && errors == 0) {
+        continue;
+      }
+      total_ops += h.TotalCount();
+      total_errors += errors;
+      *out << endl
+           << WorkloadOpToString(static_cast<WorkloadOp>(i)) << " report" << endl
+           << "    operations: " << h.TotalCount() << endl
+           << "        errors: " << errors << endl
+           << "    throughput: " << h.TotalCount() / elapsed_sec_ << " ops/s" << endl;
+      if (h.TotalCount() > 0) {
+        *out << "  latency (us): "
+             << "mean=" << h.MeanValue()
+             << " p50=" << h.ValueAtPercentile(50)
+             << " p95=" << h.ValueAtPercentile(95)
+             << " p99=" << h.ValueAtPercentile(99)
+             << " p99.9=" << h.ValueAtPercentile(99.9)
+             << " max=" << h.MaxValue() << endl;
+      }
+    }
+    *out << endl
+         << "Workload report" << endl
+         << "    operations: " << total_ops << endl
+         << "        errors: " << total_errors << endl
+         << "    time total: " << elapsed_sec_ << " s" << endl
+         << "    throughput: " << total_ops / elapsed_sec_ << " ops/s" << endl;
+    return total_errors;
+  }
+
+ private:
+  static string FieldName(int i) {
+    return Substitute("field$0", i);
+  }
+
+  // Sets the key of 'row' to 'key' and, if 'field' is negative, all of its
+  // fields to random strings of --string_len characters, otherwise only the
+  // field 'field'.
+  static Status FillRow(int64_t key, int field, Random* rng, KuduPartialRow* row) {
+    RETURN_NOT_OK(row->SetInt64(kKeyColumnName, key));
+    string value(FLAGS_string_len, '\0');
+    for (int i = field < 0 ? 0 : field;
+         i < (field < 0 ? kWorkloadNumFields : field + 1);
+         i++) {
+      for (auto& c : value) {
+        c = static_cast<char>('a' + rng->Uniform(26));
+      }
+      RETURN_NOT_OK(row->SetStringCopy(FieldName(i), value));
+    }
+    return Status::OK();
+  }
+
+  // Applies 'op' in the AUTO_FLUSH_SYNC 'session', returning the error of the
+  // operation, if any.
+  static Status ApplySync(KuduSession* session, KuduWriteOperation* op) {
+    Status s = session->Apply(op);
+    if (!s.ok()) {
+      vector<KuduError*> errors;
+      ElementDeleter d(&errors);
+      session->GetPendingErrors(&errors, nullptr);
+      if (!errors.empty()) {
+        return errors.front()->status();
+      }
+    }
+    return s;
+  }
+
+  Status LoadThread(int idx, int num_threads) {
+    shared_ptr<KuduTable> table;
+    RETURN_NOT_OK(client_->OpenTable(table_name_, &table));
+    shared_ptr<KuduSession> session = client_->NewSession();
+    RETURN_NOT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+    Random rng(idx);
+    for (int64_t key = idx; key < FLAGS_workload_record_count; key += num_threads) {
+      unique_ptr<KuduWriteOperation> op(table->NewUpsert());
+      RETURN_NOT_OK(FillRow(key, -1, &rng, op->mutable_row()));
+      RETURN_NOT_OK(session->Apply(op.release()));
+    }
+    Status s = session->Flush();
+    vector<KuduError*> errors;
+    ElementDeleter d(&errors);
+    session->GetPendingErrors(&errors, nullptr);
+    if (!errors.empty()) {
+      return errors.front()->status().CloneAndPrepend(
+          Substitute("$0 errors loading the rows, the first one", errors.size()));
+    }
+    return s;
+  }
+
+  // Returns the key of the next row to read, update or scan.
+  int64_t NextKey(Random* rng) const {
+    const int64_t num_keys = next_insert_key_;
+    switch (dist_) {
+      case KeyDistribution::UNIFORM:
+        return static_cast<int64_t>(rng->Uniform64(num_keys));
+      case KeyDistribution::ZIPFIAN: {
+        // Scramble the popular keys so that they aren't all next to each other.
+        const uint64_t item = zipf_.Next(rng);
+        return static_cast<int64_t>(
+            HashUtil::FastHash64(&item, sizeof(item), 0) % FLAGS_workload_record_count);
+      }
+      case KeyDistribution::LATEST:
+        return std::max<int64_t>(0, num_keys - 1 - static_cast<int64_t>(zipf_.Next(rng)));
+    }
+    LOG(FATAL) << "unknown key distribution";
+  }
+
+  // Scans the rows with keys in ['lower', 'upper').
+  static Status ScanRange(KuduTable* table, int64_t lower, int64_t upper) {
+    KuduScanner scanner(table);
+    RETURN_NOT_OK(scanner.AddConjunctPredicate(table->NewComparisonPredicate(
+        kKeyColumnName, KuduPredicate::GREATER_EQUAL, KuduValue::FromInt(lower))));
+    RETURN_NOT_OK(scanner.AddConjunctPredicate(table->NewComparisonPredicate(
+        kKeyColumnName, KuduPredicate::LESS, KuduValue::FromInt(upper))));
+    RETURN_NOT_OK(scanner.Open());
+    KuduScanBatch batch;
+    while (scanner.HasMoreRows()) {
+      RETURN_NOT_OK(scanner.NextBatch(&batch));
+    }
+    return Status::OK();
+  }
+
+  Status RunOp(WorkloadOp op, KuduTable* table, KuduSession* session, Random* rng) {
+    switch (op) {
+      case WORKLOAD_READ: {
+        const int64_t key = NextKey(rng);
+        return ScanRange(table, key, key + 1);
+      }
+      case WORKLOAD_UPDATE: {
+        unique_ptr<KuduWriteOperation> update(table->NewUpdate());
+        RETURN_NOT_OK(FillRow(NextKey(rng), rng->Uniform(kWorkloadNumFields), rng,
+                              update->mutable_row()));
+        return ApplySync(session, update.release());
+      }
+      case WORKLOAD_INSERT: {
+        unique_ptr<KuduWriteOperation> insert(table->NewInsert());
+        RETURN_NOT_OK(FillRow(next_insert_key_++, -1, rng, insert->mutable_row()));
+        return ApplySync(session, insert.release());
+      }
+      case WORKLOAD_SCAN: {
+        const int64_t start = NextKey(rng);
+        return ScanRange(table, start,
+                         start + 1 + rng->Uniform(FLAGS_workload_max_scan_length));
+      }
+      case WORKLOAD_READ_MODIFY_WRITE: {
+        const int64_t key = NextKey(rng);
+        RETURN_NOT_OK(ScanRange(table, key, key + 1));
+        unique_ptr<KuduWriteOperation> update(table->NewUpdate());
+        RETURN_NOT_OK(FillRow(key, rng->Uniform(kWorkloadNumFields), rng,
+                              update->mutable_row()));
+        return ApplySync(session, update.release());
+      }
+      default:
+        LOG(FATAL) << Substitute("unsupported workload op $0", op);
+    }
+  }
+
+  Status RunThread(int idx, MonoTime deadline) {
+    shared_ptr<KuduTable> table;
+    RETURN_NOT_OK(client_->OpenTable(table_name_, &table));
+    shared_ptr<KuduSession> session = client_->NewSession();
+    RETURN_NOT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_SYNC));
+    Random rng(GetRandomSeed32() + idx);
+    while (MonoTime::Now() < deadline) {
+      int pct = static_cast<int>(rng.Uniform(100));
+      int op = 0;
+      while (pct >= mix_[op]) {
+        pct -= mix_[op];
+        op++;
+      }
+      const MonoTime start = MonoTime::Now();
+      Status s = RunOp(static_cast<WorkloadOp>(op), table.get(), session.get(), &rng);
+      const int64_t latency_us = (MonoTime::Now() - start).ToMicroseconds();
+      if (PREDICT_TRUE(s.ok())) {
+        latencies_[op]->Increment(std::min(latency_us, kMaxLatencyUs));
+      } else {
+        errors_[op]++;
+        if (FLAGS_show_first_n_errors > 0 &&
+            reported_errors_++ < FLAGS_show_first_n_errors) {
+          lock_guard<mutex> lock(cerr_lock);
+          cerr << WorkloadOpToString(static_cast<WorkloadOp>(op)) << " error: "
+               << s.ToString() << endl;
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  const shared_ptr<KuduClient> client_;
+  const string table_name_;
+  const WorkloadMix mix_;
+  const KeyDistribution dist_;
+  const ZipfianGenerator zipf_;
+
+  // The key of the next row to insert, i.e. the number of keys loaded or
+  // inserted so far, give or take the inserts in progress.
+  std::atomic<int64_t> next_insert_key_;
+
+  // The latency of the successful operations, and the number of failed ones,
+  // of each kind.
+  std::array<unique_ptr<HdrHistogram>, kNumWorkloadOps> latencies_;
+  std::array<std::atomic<int64_t>, kNumWorkloadOps> errors_;
+  std::atomic<int> reported_errors_{0};
+
+  double elapsed_sec_ = 0;
+};
+
+Status RunWorkload(const RunnerContext& context) {
+  WorkloadMix mix;
+  RETURN_NOT_OK(GetWorkloadMix(FLAGS_workload, &mix));
+  KeyDistribution dist;
+  RETURN_NOT_OK(GetKeyDistribution(FLAGS_workload, FLAGS_workload_request_distribution, &dist));
+  if (FLAGS_workload_record_count < 1) {
+    return Status::InvalidArgument("--workload_record_count must be positive");
+  }
+  if (FLAGS_workload_max_scan_length < 1) {
+    return Status::InvalidArgument("--workload_max_scan_length must be positive");
+  }
+
+  shared_ptr<KuduClient> client;
+  RETURN_NOT_OK(CreateKuduClient(context, &client));
+
+  string table_name;
+  bool is_auto_table = false;
+  if (!FLAGS_table_name.empty()) {
+    table_name = FLAGS_table_name;
+  } else {
+    is_auto_table = true;
+    ObjectIdGenerator oid_generator;
+    table_name = Substitute("$0workload_auto_$1",
+        FLAGS_auto_database.empty() ? "" : FLAGS_auto_database + ".",
+        oid_generator.Next());
+    KuduSchema schema;
+    RETURN_NOT_OK(Workload::BuildSchema(&schema));
+    unique_ptr<KuduTableCreator> table_creator(client->NewTableCreator());
+    table_creator->table_name(table_name).schema(&schema);
+    if (FLAGS_table_num_hash_partitions > 1) {
+      table_creator->add_hash_partitions({ Workload::kKeyColumnName },
+                                         FLAGS_table_num_hash_partitions);
+    }
+    if (FLAGS_table_num_replicas > 0) {
+      table_creator->num_replicas(FLAGS_table_num_replicas);
+    }
+    RETURN_NOT_OK(table_creator->Create());
+  }
+  cout << "Using " << (is_auto_table ? "auto-created " : "")
+       << "table '" << table_name << "'" << endl;
+
+  Workload workload(client, table_name, mix, dist);
+  if (!FLAGS_workload_skip_load) {
+    LOG_TIMING(INFO, Substitute("loading $0 rows", FLAGS_workload_record_count)) {
+      RETURN_NOT_OK_PREPEND(workload.Load(), "could not load the rows");
+    }
+  }
+  RETURN_NOT_OK(workload.Run());
+  const int64_t num_errors = workload.Report(&cout);
+
+  if (is_auto_table && !FLAGS_keep_auto_table) {
+    cout << "Dropping auto-created table '" << table_name << "'" << endl;
+    RETURN_NOT_OK(client->DeleteTable(table_name));
+  }
+  if (num_errors != 0) {
+    return Status::RuntimeError(
+        Substitute("Encountered $0 workload operation errors", num_errors));
+  }
+  return Status::OK();
+}
+
 } // anonymous namespace
 
 unique_ptr<Mode> BuildPerfMode() {
@@ -1071,6 +1705,24 @@ unique_ptr<Mode> BuildPerfMode() {
       .AddOptionalParameter("use_upsert")
       .Build();
 
+  unique_ptr<Action> bootstrap =
+      ActionBuilder("bootstrap", &TabletBootstrapBenchmark)
+      .Description("Measure the time to bootstrap local tablets")
+      .ExtraDescription("Bootstrap local tablets like a tablet server does when "
+          "starting up, replaying their WAL, and show where the time went. The "
+          "tablet server must be stopped, and it's best to run this on a copy of "
+          "its directories: bootstrapping rewrites the WAL of the tablets. The "
+          "reading of the WAL includes decoding its entries.")
+      .AddRequiredParameter({ kTabletIdsCsvArg, kTabletIdsCsvArgDesc })
+      .AddOptionalParameter("flush_after_bootstrap")
+      .AddOptionalParameter("fs_data_dirs")
+      .AddOptionalParameter("fs_metadata_dir")
+      .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("num_iters")
+      .AddOptionalParameter("num_threads")
+      .AddOptionalParameter("tablet_bootstrap_log_read_ahead_bytes")
+      .Build();
+
   unique_ptr<Action> table_scan =
       ClusterActionBuilder("table_scan", &TableScan)
       .Description("Show row count and scanning time cost of tablets in a table")
@@ -1090,6 +1742,31 @@ unique_ptr<Mode> BuildPerfMode() {
       .AddOptionalParameter("replica_selection")
       .Build();
 
+  unique_ptr<Action> workload =
+      ClusterActionBuilder("workload", &RunWorkload)
+      .Description("Run a YCSB-style mix of reads, writes and scans")
+      .ExtraDescription(
+          "Load rows into an existing or auto-created table, then run one of "
+          "the YCSB core workloads against it for a while and report the "
+          "throughput and the latency percentiles of each kind of operation. "
+          "An existing table must have an INT64 'key' primary key column and "
+          "STRING columns 'field0' to 'field9'.")
+      .AddOptionalParameter("auto_database")
+      .AddOptionalParameter("keep_auto_table")
+      .AddOptionalParameter("num_threads")
+      .AddOptionalParameter("show_first_n_errors")
+      .AddOptionalParameter("string_len")
+      .AddOptionalParameter("table_name")
+      .AddOptionalParameter("table_num_hash_partitions")
+      .AddOptionalParameter("table_num_replicas")
+      .AddOptionalParameter("workload")
+      .AddOptionalParameter("workload_duration_sec")
+      .AddOptionalParameter("workload_max_scan_length")
+      .AddOptionalParameter("workload_record_count")
+      .AddOptionalParameter("workload_request_distribution")
+      .AddOptionalParameter("workload_skip_load")
+      .Build();
+
   // TODO(aserbin): move this to tool_local_replica.cc
   unique_ptr<Action> tablet_scan =
       ActionBuilder("tablet_scan", &TabletScan)
@@ -1103,9 +1780,11 @@ unique_ptr<Mode> BuildPerfMode() {
       .Build();
   return ModeBuilder("perf")
       .Description("Measure the performance of a Kudu cluster")
+      .AddAction(std::move(bootstrap))
       .AddAction(std::move(loadgen))
       .AddAction(std::move(table_scan))
       .AddAction(std::move(tablet_scan))
+      .AddAction(std::move(workload))
       .Build();
 }
 
@@ -217,10 +217,11 @@ DECLARE_bool(show_scanner_stats);
 
 DEFINE_string(encoding_type, "AUTO_ENCODING",
               "Type of encoding for the column including AUTO_ENCODING, PLAIN_ENCODING, "
-              "PREFIX_ENCODING, RLE, DICT_ENCODING, BIT_SHUFFLE, GROUP_VARINT");
+              "PREFIX_ENCODING, RLE, DICT_ENCODING, BIT_SHUFFLE, FRAME_OF_REFERENCE, "
+              "FSST, ADAPTIVE, GROUP_VARINT");
 DEFINE_string(compression_type, "DEFAULT_COMPRESSION",
               "Type of compression for the column including DEFAULT_COMPRESSION, "
-              "NO_COMPRESSION, SNAPPY, LZ4, ZLIB");
+              "NO_COMPRESSION, SNAPPY, LZ4, ZLIB, ZSTD");
 DEFINE_string(default_value, "", "Default value for this column.");
 DEFINE_string(comment, "", "Comment for this column.");
 
@@ -1546,6 +1547,15 @@ Status ToClientEncodingType(
     case ColumnPB::BIT_SHUFFLE :
       *type = KuduColumnStorageAttributes::BIT_SHUFFLE;
       break;
+    case ColumnPB::FRAME_OF_REFERENCE :
+      *type = KuduColumnStorageAttributes::FRAME_OF_REFERENCE;
+      break;
+    case ColumnPB::FSST :
+      *type = KuduColumnStorageAttributes::FSST;
+      break;
+    case ColumnPB::ADAPTIVE :
+      *type = KuduColumnStorageAttributes::ADAPTIVE;
+      break;
     default :
       s = Status::InvalidArgument(Substitute("Unexpected encoding type: $0", type_pb));
   }
@@ -1572,6 +1582,9 @@ Status ToClientCompressionType(
     case ColumnPB::ZLIB :
       *type = KuduColumnStorageAttributes::ZLIB;
       break;
+    case ColumnPB::ZSTD :
+      *type = KuduColumnStorageAttributes::ZSTD;
+      break;
     default :
       s = Status::InvalidArgument(Substitute("Unexpected compression type: $0", type_pb));
   }
@@ -1954,6 +1967,7 @@ unique_ptr<Mode> BuildTableMode() {
                         "source table.")
       .AddRequiredParameter({ kTableNameArg, "Name of the source table" })
       .AddRequiredParameter({ kDestMasterAddressesArg, kDestMasterAddressesArgDesc })
+      .AddOptionalParameter("copy_mutation_buffer_size_mb")
       .AddOptionalParameter("create_table")
       .AddOptionalParameter("create_table_hash_bucket_nums")
       .AddOptionalParameter("create_table_replication_factor")
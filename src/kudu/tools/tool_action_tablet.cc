@@ -161,12 +161,16 @@ Status ChangeConfig(const RunnerContext& context, ChangeConfigType cc_type) {
   const string& tablet_id = FindOrDie(context.required_args, kTabletIdArg);
   const string& replica_uuid = FindOrDie(context.required_args, kTsUuidArg);
   optional<RaftPeerPB::MemberType> member_type;
+  bool read_replica = false;
   if (cc_type == consensus::ADD_PEER || cc_type == consensus::MODIFY_PEER) {
     const string& replica_type = FindOrDie(context.required_args, kReplicaTypeArg);
     string uppercase_peer_type;
     ToUpperCase(replica_type, &uppercase_peer_type);
     RaftPeerPB::MemberType member_type_val;
-    if (!RaftPeerPB::MemberType_Parse(uppercase_peer_type, &member_type_val)) {
+    if (cc_type == consensus::ADD_PEER && uppercase_peer_type == "READ_REPLICA") {
+      member_type_val = RaftPeerPB::NON_VOTER;
+      read_replica = true;
+    } else if (!RaftPeerPB::MemberType_Parse(uppercase_peer_type, &member_type_val)) {
       return Status::InvalidArgument("Unrecognized peer type", replica_type);
     }
     member_type = member_type_val;
@@ -174,7 +178,8 @@ Status ChangeConfig(const RunnerContext& context, ChangeConfigType cc_type) {
 
   vector<string> master_addresses;
   RETURN_NOT_OK(ParseMasterAddresses(context, &master_addresses));
-  return DoChangeConfig(master_addresses, tablet_id, replica_uuid, member_type, cc_type);
+  return DoChangeConfig(master_addresses, tablet_id, replica_uuid, member_type, cc_type,
+                        std::nullopt, nullptr, read_replica);
 }
 
 Status AddReplica(const RunnerContext& context) {
@@ -341,7 +346,9 @@ unique_ptr<Mode> BuildTabletMode() {
       .AddRequiredParameter({ kTsUuidArg,
                               "UUID of the tablet server that should host the new replica" })
       .AddRequiredParameter(
-          { kReplicaTypeArg, "New replica's type. Must be VOTER or NON_VOTER."
+          { kReplicaTypeArg, "New replica's type. Must be VOTER, NON_VOTER or "
+            "READ_REPLICA, a NON_VOTER kept to serve the scans which prefer "
+            "non-voters."
           })
       .Build();
 
@@ -674,7 +674,8 @@ Status DoChangeConfig(const vector<string>& master_addresses,
                       const optional<RaftPeerPB::MemberType>& member_type,
                       ChangeConfigType cc_type,
                       const optional<int64_t>& cas_opid_idx,
-                      bool* cas_failed) {
+                      bool* cas_failed,
+                      bool read_replica) {
   if (cas_failed) {
     *cas_failed = false;
   }
@@ -687,11 +688,19 @@ Status DoChangeConfig(const vector<string>& master_addresses,
         "must specify member type when adding a server or changing member type");
   }
 
+  if (read_replica &&
+      (cc_type != consensus::ADD_PEER || member_type != RaftPeerPB::NON_VOTER)) {
+    return Status::InvalidArgument("a read replica can only be added as a NON_VOTER");
+  }
+
   RaftPeerPB peer_pb;
   peer_pb.set_permanent_uuid(replica_uuid);
   if (member_type) {
     peer_pb.set_member_type(*member_type);
   }
+  if (read_replica) {
+    peer_pb.mutable_attrs()->set_read_replica(true);
+  }
 
   client::sp::shared_ptr<KuduClient> client;
   RETURN_NOT_OK(CreateKuduClient(master_addresses, &client));
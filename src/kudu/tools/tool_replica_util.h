@@ -172,13 +172,16 @@ Status GetRpcAddressForTS(
     HostPort* hp);
 
 // Change Raft consensus configuration for the tablet with UUID 'replica_uuid'.
+// If 'read_replica' is true, the replica added is a long-lived read replica
+// (see RaftPeerAttrsPB.read_replica), which must be a NON_VOTER.
 Status DoChangeConfig(const std::vector<std::string>& master_addresses,
     const std::string& tablet_id,
     const std::string& replica_uuid,
     const std::optional<consensus::RaftPeerPB::MemberType>& member_type,
     consensus::ChangeConfigType cc_type,
     const std::optional<int64_t>& cas_opid_idx = std::nullopt,
-    bool* cas_failed = nullptr);
+    bool* cas_failed = nullptr,
+    bool read_replica = false);
 
 // Check whether the cluster with the specified master addresses supports
 // the 3-4-3 replica management scheme. Returns Status::Incomplete() if
@@ -287,5 +287,45 @@ TEST_F(TxnStatusTabletTest, TestMultithreadedAccess) {
   }
 }
 
+// Test that the concurrent writes batched together get back the outcome of
+// their own rows.
+TEST_F(TxnStatusTabletTest, TestConcurrentWriteErrors) {
+  const int kNumThreads = 32;
+  TabletServerErrorPB ts_error;
+  for (int i = 0; i < kNumThreads; i += 2) {
+    ASSERT_OK(status_tablet_->AddNewTransaction(i, kOwner, kFakeTime, &ts_error));
+  }
+  // Update all the transactions at once: only the updates of the transactions
+  // with an odd ID, which weren't added, should fail.
+  vector<thread> threads;
+  vector<Status> statuses(kNumThreads);
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&, i] {
+      TabletServerErrorPB ts_error;
+      TxnStatusEntryPB status_entry_pb;
+      status_entry_pb.set_start_timestamp(kFakeTime);
+      status_entry_pb.set_last_transition_timestamp(kFakeTime);
+      status_entry_pb.set_user(kOwner);
+      status_entry_pb.set_state(TxnStatePB::COMMITTED);
+      statuses[i] = status_tablet_->UpdateTransaction(i, status_entry_pb, &ts_error);
+    });
+  }
+  std::for_each(threads.begin(), threads.end(), [] (thread& t) { t.join(); });
+  for (int i = 0; i < kNumThreads; i++) {
+    if (i % 2 == 0) {
+      EXPECT_OK(statuses[i]);
+    } else {
+      EXPECT_TRUE(statuses[i].IsIncomplete()) << statuses[i].ToString();
+    }
+  }
+  SimpleTransactionsVisitor visitor;
+  ASSERT_OK(status_tablet_->VisitTransactions(&visitor));
+  const auto entries = visitor.ReleaseEntries();
+  ASSERT_EQ(kNumThreads / 2, entries.size());
+  for (const auto& e : entries) {
+    EXPECT_EQ(TxnStatePB::COMMITTED, e.txn_pb.state()) << e;
+  }
+}
+
 } // namespace transactions
 } // namespace kudu
@@ -22,8 +22,11 @@
 #include <memory>
 #include <optional>
 #include <ostream>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/common/column_predicate.h"
@@ -38,6 +41,7 @@
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/common/wire_protocol.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/ops/op.h"
@@ -48,6 +52,7 @@
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/once.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/slice.h"
@@ -62,9 +67,29 @@ using std::nullopt;
 using std::optional;
 using std::string;
 using std::unique_ptr;
+using std::unordered_set;
 using std::vector;
 using strings::Substitute;
 
+DEFINE_int32(txn_status_tablet_max_write_batch_size, 64,
+             "Maximum number of rows written as a single write op to a transaction "
+             "status tablet. The updates of the transactions issued while a write op "
+             "is in flight are batched together into the next write op, which "
+             "reduces the replication overhead when many transactions are started "
+             "or committed concurrently. If 1, every update is written as its own "
+             "write op.");
+TAG_FLAG(txn_status_tablet_max_write_batch_size, advanced);
+TAG_FLAG(txn_status_tablet_max_write_batch_size, runtime);
+
+static bool ValidateMaxWriteBatchSize(const char* flagname, int32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << Substitute("--$0 must be positive: $1", flagname, value);
+  return false;
+}
+DEFINE_validator(txn_status_tablet_max_write_batch_size, &ValidateMaxWriteBatchSize);
+
 namespace kudu {
 namespace transactions {
 
@@ -300,8 +325,6 @@ Status TxnStatusTablet::VisitTransactions(TransactionsVisitor* visitor) {
 
 Status TxnStatusTablet::AddNewTransaction(int64_t txn_id, const string& user,
                                           int64_t start_timestamp, TabletServerErrorPB* ts_error) {
-  WriteRequestPB req = BuildWriteReqPB(tablet_replica_->tablet_id());
-
   TxnStatusEntryPB entry;
   entry.set_state(OPEN);
   entry.set_user(user);
@@ -312,85 +335,132 @@ Status TxnStatusTablet::AddNewTransaction(int64_t txn_id, const string& user,
 
   KuduPartialRow row(&GetSchemaWithoutIds());
   RETURN_NOT_OK(PopulateTransactionEntryRow(txn_id, metadata_buf, &row));
-  RowOperationsPBEncoder enc(req.mutable_row_operations());
-  enc.Add(RowOperationsPB::INSERT_IGNORE, row);
-  return SyncWrite(req, ts_error);
+  return Write(RowOperationsPB::INSERT_IGNORE, row, ts_error);
 }
 
 Status TxnStatusTablet::UpdateTransaction(int64_t txn_id, const TxnStatusEntryPB& pb,
                                           TabletServerErrorPB* ts_error) {
-  WriteRequestPB req = BuildWriteReqPB(tablet_replica_->tablet_id());
-
   faststring metadata_buf;
   pb_util::SerializeToString(pb, &metadata_buf);
 
   KuduPartialRow row(&GetSchemaWithoutIds());
   RETURN_NOT_OK(PopulateTransactionEntryRow(txn_id, metadata_buf, &row));
-  RowOperationsPBEncoder enc(req.mutable_row_operations());
-  enc.Add(RowOperationsPB::UPDATE, row);
-  return SyncWrite(req, ts_error);
+  return Write(RowOperationsPB::UPDATE, row, ts_error);
 }
 
 Status TxnStatusTablet::AddNewParticipant(int64_t txn_id, const string& tablet_id,
                                           TabletServerErrorPB* ts_error) {
-  WriteRequestPB req = BuildWriteReqPB(tablet_replica_->tablet_id());
-
   TxnParticipantEntryPB entry;
   entry.set_state(OPEN);
   faststring metadata_buf;
   pb_util::SerializeToString(entry, &metadata_buf);
 
   KuduPartialRow row(&TxnStatusTablet::GetSchemaWithoutIds());
-  PopulateParticipantEntryRow(txn_id, tablet_id, metadata_buf, &row);
-  RowOperationsPBEncoder enc(req.mutable_row_operations());
-  enc.Add(RowOperationsPB::INSERT_IGNORE, row);
-  return SyncWrite(req, ts_error);
+  RETURN_NOT_OK(PopulateParticipantEntryRow(txn_id, tablet_id, metadata_buf, &row));
+  return Write(RowOperationsPB::INSERT_IGNORE, row, ts_error);
 }
 
 Status TxnStatusTablet::UpdateParticipant(int64_t txn_id, const string& tablet_id,
                                           const TxnParticipantEntryPB& pb,
                                           TabletServerErrorPB* ts_error) {
-  WriteRequestPB req = BuildWriteReqPB(tablet_replica_->tablet_id());
-
   faststring metadata_buf;
   pb_util::SerializeToString(pb, &metadata_buf);
 
   KuduPartialRow row(&GetSchemaWithoutIds());
   RETURN_NOT_OK(PopulateParticipantEntryRow(txn_id, tablet_id, metadata_buf, &row));
+  return Write(RowOperationsPB::UPDATE, row, ts_error);
+}
+
+Status TxnStatusTablet::Write(RowOperationsPB::Type type,
+                              const KuduPartialRow& row,
+                              TabletServerErrorPB* ts_error) {
+  DCHECK(ts_error);
+  PendingWrite write;
+  write.type = type;
+  write.row = &row;
+  write.ts_error = ts_error;
+  RETURN_NOT_OK(row.EncodeRowKey(&write.key));
+
+  std::unique_lock<std::mutex> l(lock_);
+  pending_writes_.push_back(&write);
+  write_done_cond_.wait(l, [&] {
+    return write.done || pending_writes_.front() == &write;
+  });
+  if (write.done) {
+    // The write was a part of a batch written by another thread.
+    return write.status;
+  }
+
+  // This write is at the front of the queue: write it along with the writes
+  // queued behind it, stopping short of a second write to the same row.
+  vector<PendingWrite*> batch;
+  unordered_set<string> keys;
+  for (auto* w : pending_writes_) {
+    if (batch.size() >= static_cast<size_t>(FLAGS_txn_status_tablet_max_write_batch_size) ||
+        !InsertIfNotPresent(&keys, w->key)) {
+      break;
+    }
+    batch.emplace_back(w);
+  }
+  l.unlock();
+  WriteBatch(batch);
+  l.lock();
+  for (size_t i = 0; i < batch.size(); i++) {
+    DCHECK_EQ(batch[i], pending_writes_.front());
+    pending_writes_.front()->done = true;
+    pending_writes_.pop_front();
+  }
+  // Wake up the writers of the batch, and the writer of the next batch.
+  write_done_cond_.notify_all();
+  return write.status;
+}
+
+void TxnStatusTablet::WriteBatch(const vector<PendingWrite*>& batch) {
+  WriteRequestPB req = BuildWriteReqPB(tablet_replica_->tablet_id());
   RowOperationsPBEncoder enc(req.mutable_row_operations());
-  enc.Add(RowOperationsPB::UPDATE, row);
-  return SyncWrite(req, ts_error);
+  for (const auto* w : batch) {
+    enc.Add(w->type, *w->row);
+  }
+  WriteResponsePB resp;
+  const Status s = SyncWrite(req, &resp);
+  if (PREDICT_FALSE(!s.ok())) {
+    for (auto* w : batch) {
+      w->status = s;
+    }
+    return;
+  }
+  if (resp.has_error()) {
+    const Status error_status = StatusFromPB(resp.error().status());
+    for (auto* w : batch) {
+      *w->ts_error = resp.error();
+      w->status = error_status;
+    }
+    return;
+  }
+  for (const auto& error : resp.per_row_errors()) {
+    DCHECK_LT(error.row_index(), batch.size());
+    const Status row_status = StatusFromPB(error.error());
+    LOG(ERROR) << Substitute("row $0: $1", error.row_index(), row_status.ToString());
+    batch[error.row_index()]->status = Status::Incomplete(
+        Substitute("failed to write row to transaction status tablet $0: $1",
+                   tablet_replica_->tablet_id(), row_status.ToString()));
+  }
 }
 
-Status TxnStatusTablet::SyncWrite(const WriteRequestPB& req, TabletServerErrorPB* ts_error) {
+Status TxnStatusTablet::SyncWrite(const WriteRequestPB& req, WriteResponsePB* resp) {
   DCHECK(req.has_tablet_id());
   DCHECK(req.has_schema());
   CountDownLatch latch(1);
-  WriteResponsePB resp;
   unique_ptr<OpCompletionCallback> op_cb(
-      new LatchOpCompletionCallback<WriteResponsePB>(&latch, &resp));
+      new LatchOpCompletionCallback<WriteResponsePB>(&latch, resp));
   unique_ptr<WriteOpState> op_state(
       new WriteOpState(tablet_replica_,
                        &req,
                        nullptr, // RequestIdPB
-                       &resp));
+                       resp));
   op_state->set_completion_callback(std::move(op_cb));
   RETURN_NOT_OK(tablet_replica_->SubmitWrite(std::move(op_state)));
   latch.Wait();
-  if (resp.has_error()) {
-    DCHECK(ts_error);
-    *ts_error = std::move(resp.error());
-    return StatusFromPB(ts_error->status());
-  }
-  if (resp.per_row_errors_size() > 0) {
-    for (const auto& error : resp.per_row_errors()) {
-      LOG(ERROR) << Substitute(
-          "row $0: $1", error.row_index(), StatusFromPB(error.error()).ToString());
-    }
-    return Status::Incomplete(
-        Substitute("failed to write $0 rows to transaction status tablet $1",
-                   resp.per_row_errors_size(), tablet_replica_->tablet_id()));
-  }
   return Status::OK();
 }
 
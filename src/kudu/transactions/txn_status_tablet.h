@@ -16,15 +16,21 @@
 // under the License.
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "kudu/common/row_operations.pb.h"
+#include "kudu/gutil/macros.h"
 #include "kudu/transactions/transactions.pb.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
+class KuduPartialRow;
 class Schema;
 
 namespace tablet {
@@ -34,6 +40,7 @@ class TabletReplica;
 namespace tserver {
 class TabletServerErrorPB;
 class WriteRequestPB;
+class WriteResponsePB;
 } // namespace tserver
 
 namespace transactions {
@@ -78,8 +85,14 @@ class TransactionsVisitor {
 // Expected usage of this class is to have a management layer that reads and
 // writes to the underlying replica only if it is leader.
 //
+// The writes issued concurrently, e.g. on behalf of many transactions being
+// committed at once, are group-committed: while a write op is being
+// replicated, the writes issued in the meantime are queued, and then
+// replicated together as a single write op of up to
+// --txn_status_tablet_max_write_batch_size rows. Each write still gets back
+// the outcome of its own row.
+//
 // TODO(awong): delete transactions that are entirely aborted or committed.
-// TODO(awong): consider batching writes.
 class TxnStatusTablet {
  public:
   static const char* const kTxnIdColName;
@@ -123,13 +136,50 @@ class TxnStatusTablet {
  private:
   friend class TxnStatusManager;
 
-  // Writes 'req' to the underlying tablet replica, populating 'ts_error' and
-  // returning non-OK if there was a problem replicating the request, or simply
-  // returning a non-OK error if there were any row errors.
-  Status SyncWrite(const tserver::WriteRequestPB& req, tserver::TabletServerErrorPB* ts_error);
+  // A write waiting to be replicated as a part of a batch.
+  struct PendingWrite {
+    RowOperationsPB::Type type;
+    const KuduPartialRow* row;
+    // The encoded primary key of 'row'. The writes of a batch are to distinct
+    // rows, so that the order of the writes to the same row is preserved.
+    std::string key;
+    tserver::TabletServerErrorPB* ts_error;
+
+    // Set once the write is done.
+    Status status;
+    bool done = false;
+  };
+
+  // Writes 'row' to the underlying tablet replica with the operation 'type',
+  // populating 'ts_error' and returning non-OK if there was a problem
+  // replicating the request, or simply returning a non-OK error if there was
+  // a row error. Blocks until the row is written, batching it with the other
+  // concurrent writes.
+  Status Write(RowOperationsPB::Type type, const KuduPartialRow& row,
+               tserver::TabletServerErrorPB* ts_error);
+
+  // Writes the rows of 'batch' as a single write op, and sets the outcome of
+  // each of them.
+  void WriteBatch(const std::vector<PendingWrite*>& batch);
+
+  // Submits 'req' to the underlying tablet replica and waits for it to
+  // complete, populating 'resp'.
+  Status SyncWrite(const tserver::WriteRequestPB& req, tserver::WriteResponsePB* resp);
 
   // The tablet replica that backs this transaction status tablet.
   tablet::TabletReplica* tablet_replica_;
+
+  // Protects 'pending_writes_' and the 'done' state of the writes in it.
+  std::mutex lock_;
+
+  // Notified when a batch of writes is done.
+  std::condition_variable write_done_cond_;
+
+  // The writes in flight, in the order they were issued. The write at the
+  // front of the queue writes the next batch, which starts at the front.
+  std::deque<PendingWrite*> pending_writes_;
+
+  DISALLOW_COPY_AND_ASSIGN(TxnStatusTablet);
 };
 
 } // namespace transactions
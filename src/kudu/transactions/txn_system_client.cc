@@ -114,7 +114,9 @@ Status TxnSystemClient::Create(const vector<HostPort>& master_addrs,
 
 Status TxnSystemClient::CreateTxnStatusTableWithClient(int64_t initial_upper_bound,
                                                        int num_replicas,
-                                                       KuduClient* client) {
+                                                       KuduClient* client,
+                                                       int num_hash_partitions) {
+  DCHECK_GE(num_hash_partitions, 1);
 
   const auto& schema = TxnStatusTablet::GetSchema();
   const auto kudu_schema = KuduSchema::FromSchema(schema);
@@ -134,10 +136,19 @@ Status TxnSystemClient::CreateTxnStatusTableWithClient(int64_t initial_upper_bou
   // TODO(awong): ensure that transaction status managers only accept requests
   // when their replicas are leader. For now, ensure this is the case by making
   // them non-replicated.
-  return table_creator->schema(&kudu_schema)
+  table_creator->schema(&kudu_schema)
       .set_range_partition_columns({ TxnStatusTablet::kTxnIdColName })
-      .add_range_partition(lb.release(), ub.release())
-      .table_name(TxnStatusTablet::kTxnStatusTableName)
+      .add_range_partition(lb.release(), ub.release());
+  if (num_hash_partitions > 1) {
+    // Transaction IDs are handed out in increasing order, so with range
+    // partitioning alone all the transactions in flight would be coordinated
+    // by the tablet of the latest range. Hash-partitioning the ranges spreads
+    // them over several tablets, and the ranges added later get the same hash
+    // partitioning.
+    table_creator->add_hash_partitions({ TxnStatusTablet::kTxnIdColName },
+                                       num_hash_partitions);
+  }
+  return table_creator->table_name(TxnStatusTablet::kTxnStatusTableName)
       .num_replicas(num_replicas)
       .wait(true)
       .Create();
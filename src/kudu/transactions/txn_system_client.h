@@ -75,9 +75,14 @@ class TxnSystemClient {
                        std::unique_ptr<TxnSystemClient>* sys_client);
 
   // Creates the transaction status table with a single range partition of the
-  // given upper bound.
-  Status CreateTxnStatusTable(int64_t initial_upper_bound, int num_replicas = 1) {
-    return CreateTxnStatusTableWithClient(initial_upper_bound, num_replicas, client_.get());
+  // given upper bound. If 'num_hash_partitions' is greater than 1, each range
+  // is further hash-partitioned by transaction ID into that many tablets, so
+  // that the transactions of a range are coordinated by several transaction
+  // status tablets rather than a single one.
+  Status CreateTxnStatusTable(int64_t initial_upper_bound, int num_replicas = 1,
+                              int num_hash_partitions = 1) {
+    return CreateTxnStatusTableWithClient(initial_upper_bound, num_replicas, client_.get(),
+                                          num_hash_partitions);
   }
 
   // Adds a new range to the transaction status table with the given bounds.
@@ -170,7 +175,8 @@ class TxnSystemClient {
       : client_(std::move(client)) {}
 
   static Status CreateTxnStatusTableWithClient(int64_t initial_upper_bound, int num_replicas,
-                                               client::KuduClient* client);
+                                               client::KuduClient* client,
+                                               int num_hash_partitions = 1);
   static Status AddTxnStatusTableRangeWithClient(int64_t lower_bound, int64_t upper_bound,
                                                  client::KuduClient* client);
 
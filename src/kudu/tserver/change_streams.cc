@@ -0,0 +1,126 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/change_streams.h"
+
+#include <mutex>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/consensus/log_anchor_registry.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/flag_tags.h"
+
+DEFINE_int32(tablet_change_stream_subscription_ttl_ms, 10 * 60 * 1000,
+             "Number of milliseconds after which the subscribers to the change "
+             "stream of a tablet which stopped polling for its changes are dropped, "
+             "releasing the anchors they hold on the write-ahead log of the tablet.");
+TAG_FLAG(tablet_change_stream_subscription_ttl_ms, experimental);
+TAG_FLAG(tablet_change_stream_subscription_ttl_ms, runtime);
+
+namespace {
+
+bool ValidateSubscriptionTtl(const char* flagname, int32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(tablet_change_stream_subscription_ttl_ms, &ValidateSubscriptionTtl);
+
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+namespace tserver {
+
+ChangeStreamManager::Subscription::Subscription()
+    : anchor(new log::LogAnchor) {
+}
+
+ChangeStreamManager::Subscription::~Subscription() {
+}
+
+ChangeStreamManager::~ChangeStreamManager() {
+  for (auto& e : subscriptions_) {
+    ReleaseAnchor(e.second.get());
+  }
+}
+
+void ChangeStreamManager::ReleaseAnchor(Subscription* subscription) {
+  WARN_NOT_OK(subscription->registry->UnregisterIfAnchored(subscription->anchor.get()),
+              "could not release the log anchor of a change stream subscriber");
+}
+
+void ChangeStreamManager::Subscribe(const string& tablet_id,
+                                    const string& subscriber_id,
+                                    const scoped_refptr<log::LogAnchorRegistry>& registry,
+                                    int64_t log_index,
+                                    MonoTime now) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  auto& subscription = subscriptions_[Substitute("$0/$1", tablet_id, subscriber_id)];
+  if (!subscription) {
+    subscription.reset(new Subscription);
+  } else if (subscription->registry != registry) {
+    // The tablet replica was replaced since the last subscription, e.g. by a
+    // tablet copy: its anchors are registered with the new replica.
+    ReleaseAnchor(subscription.get());
+  }
+  subscription->registry = registry;
+  subscription->last_renewed = now;
+  CHECK_OK(registry->RegisterOrUpdate(
+      log_index, Substitute("change stream subscriber $0", subscriber_id),
+      subscription->anchor.get()));
+}
+
+void ChangeStreamManager::Unsubscribe(const string& tablet_id, const string& subscriber_id) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  auto it = subscriptions_.find(Substitute("$0/$1", tablet_id, subscriber_id));
+  if (it != subscriptions_.end()) {
+    ReleaseAnchor(it->second.get());
+    subscriptions_.erase(it);
+  }
+}
+
+void ChangeStreamManager::RemoveExpiredSubscriptions(MonoTime now) {
+  const MonoDelta ttl =
+      MonoDelta::FromMilliseconds(FLAGS_tablet_change_stream_subscription_ttl_ms);
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+    if (it->second->last_renewed + ttl < now) {
+      VLOG(1) << "Dropping expired change stream subscription " << it->first;
+      ReleaseAnchor(it->second.get());
+      it = subscriptions_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t ChangeStreamManager::num_subscriptions() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return subscriptions_.size();
+}
+
+} // namespace tserver
+} // namespace kudu
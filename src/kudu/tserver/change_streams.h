@@ -0,0 +1,96 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+namespace log {
+class LogAnchorRegistry;
+struct LogAnchor;
+} // namespace log
+
+namespace tserver {
+
+// Tracks the subscribers to the change streams of the tablets of a tablet
+// server (see the GetTabletChanges RPC).
+//
+// Each subscriber of a tablet anchors the write-ahead log of its replica at
+// the first op it hasn't read yet, so that the log segments it still needs
+// aren't garbage-collected while it lags behind. The subscribers which stop
+// polling for --tablet_change_stream_subscription_ttl_ms are dropped along
+// with their anchors, letting the log be garbage-collected again.
+//
+// This class is thread-safe.
+class ChangeStreamManager {
+ public:
+  ChangeStreamManager() = default;
+  ~ChangeStreamManager();
+
+  // Anchors the log of the tablet 'tablet_id', whose anchors are registered
+  // with 'registry', at 'log_index' on behalf of 'subscriber_id', replacing
+  // the previous anchor of the subscriber.
+  void Subscribe(const std::string& tablet_id,
+                 const std::string& subscriber_id,
+                 const scoped_refptr<log::LogAnchorRegistry>& registry,
+                 int64_t log_index,
+                 MonoTime now);
+
+  // Drops the subscription of 'subscriber_id' to 'tablet_id', if any.
+  void Unsubscribe(const std::string& tablet_id, const std::string& subscriber_id);
+
+  // Drops the subscriptions which haven't been renewed by Subscribe() since
+  // --tablet_change_stream_subscription_ttl_ms before 'now'.
+  void RemoveExpiredSubscriptions(MonoTime now);
+
+  size_t num_subscriptions() const;
+
+ private:
+  struct Subscription {
+    Subscription();
+    ~Subscription();
+
+    scoped_refptr<log::LogAnchorRegistry> registry;
+    std::unique_ptr<log::LogAnchor> anchor;
+    MonoTime last_renewed;
+  };
+
+  // Unregisters the anchor of 'subscription'.
+  static void ReleaseAnchor(Subscription* subscription);
+
+  // Protects 'subscriptions_'.
+  mutable simple_spinlock lock_;
+
+  // The subscriptions, keyed by tablet ID and subscriber ID.
+  std::unordered_map<std::string, std::unique_ptr<Subscription>> subscriptions_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChangeStreamManager);
+};
+
+} // namespace tserver
+} // namespace kudu
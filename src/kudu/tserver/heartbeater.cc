@@ -119,6 +119,15 @@ DEFINE_int32(tserver_send_tombstoned_tablets_report_inteval_secs, 1800,
              "Otherwise, the tombstoned tablets probably could not be deleted.");
 TAG_FLAG(tserver_send_tombstoned_tablets_report_inteval_secs, runtime);
 
+DEFINE_int32(heartbeat_replica_load_report_interval_secs, 10,
+             "Time interval in seconds of sending the load of the replicas hosted by "
+             "the tablet server, i.e. the rows they read and wrote and their size on "
+             "disk, along with a heartbeat. The master uses it to balance the load of "
+             "the tablet servers when --auto_rebalancing_load_balancing_enabled is set. "
+             "Turn off this by setting it to a value less than 0.");
+TAG_FLAG(heartbeat_replica_load_report_interval_secs, advanced);
+TAG_FLAG(heartbeat_replica_load_report_interval_secs, runtime);
+
 DECLARE_bool(raft_prepare_replacement_before_eviction);
 
 using kudu::consensus::ReplicaManagementInfoPB;
@@ -228,8 +237,14 @@ class Heartbeater::Thread {
   // Indicates that the thread should send a full tablet report. Set when
   // the thread detects that the master has been elected leader.
   bool send_full_tablet_report_;
+  // Set when the master asked for a full tablet report again in response to
+  // a full tablet report, i.e. deferred processing it because it's busy with
+  // the reports of other tablet servers.
+  bool full_tablet_report_deferred_;
   // Time of sending last report with tombstoned tablets.
   MonoTime last_tombstoned_report_time_;
+  // Time of sending last report of the load of the replicas.
+  MonoTime last_replica_load_report_time_;
 
   DISALLOW_COPY_AND_ASSIGN(Thread);
 };
@@ -331,7 +346,9 @@ Heartbeater::Thread::Thread(HostPort master_address, TabletServer* server)
     should_run_(false),
     heartbeat_asap_(true),
     send_full_tablet_report_(false),
-    last_tombstoned_report_time_(MonoTime::Now()) {
+    full_tablet_report_deferred_(false),
+    last_tombstoned_report_time_(MonoTime::Now()),
+    last_replica_load_report_time_(MonoTime::Min()) {
 }
 
 Status Heartbeater::Thread::ConnectToMaster() {
@@ -423,8 +440,10 @@ int Heartbeater::Thread::GetMinimumHeartbeatMillis() const {
 int Heartbeater::Thread::GetMillisUntilNextHeartbeat() const {
   // If the master needs something from us, we should immediately
   // send another heartbeat with that info, rather than waiting for the interval.
+  // A deferred full tablet report is only sent again after the regular
+  // interval, to let the master catch up with the reports of other servers.
   if (last_hb_response_.needs_reregister() ||
-      last_hb_response_.needs_full_tablet_report()) {
+      (last_hb_response_.needs_full_tablet_report() && !full_tablet_report_deferred_)) {
     return GetMinimumHeartbeatMillis();
   }
 
@@ -540,6 +559,15 @@ Status Heartbeater::Thread::DoHeartbeat(MasterErrorPB* error,
     req.mutable_num_live_tablets_by_range_per_table()->insert(pair);
   }
 
+  if (FLAGS_heartbeat_replica_load_report_interval_secs >= 0) {
+    const MonoTime now = MonoTime::Now();
+    if (now - last_replica_load_report_time_ >=
+        MonoDelta::FromSeconds(FLAGS_heartbeat_replica_load_report_interval_secs)) {
+      server_->tablet_manager()->PopulateReplicaLoadReport(req.mutable_replica_load_report());
+      last_replica_load_report_time_ = now;
+    }
+  }
+
   VLOG(2) << "Sending heartbeat:\n" << SecureDebugString(req);
   master::TSHeartbeatResponsePB resp;
   const auto& s = proxy_->TSHeartbeat(req, &resp, &rpc);
@@ -566,6 +594,8 @@ Status Heartbeater::Thread::DoHeartbeat(MasterErrorPB* error,
   }
 
   last_hb_response_.Swap(&resp);
+  full_tablet_report_deferred_ = !req.tablet_report().is_incremental() &&
+      last_hb_response_.needs_full_tablet_report();
 
   for (const auto& ca_cert_der : last_hb_response_.ca_cert_der()) {
     security::Cert ca_cert;
@@ -0,0 +1,136 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/resource_quotas.h"
+
+#include <optional>
+
+#include <gflags/gflags_declare.h>
+#include <gtest/gtest.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_int64(tserver_user_scan_bytes_per_sec_quota);
+DECLARE_int64(tserver_user_write_ops_per_sec_quota);
+
+namespace kudu {
+namespace tserver {
+
+class ResourceQuotaManagerTest : public KuduTest {
+ protected:
+  ResourceQuotaManager quotas_;
+};
+
+TEST_F(ResourceQuotaManagerTest, TestFromExtraConfig) {
+  TableQuotas q = TableQuotas::FromExtraConfig(std::nullopt);
+  ASSERT_EQ(0, q.scan_bytes_per_sec);
+  ASSERT_EQ(0, q.write_ops_per_sec);
+
+  TableExtraConfigPB config;
+  config.set_scan_bytes_per_sec_quota(1024);
+  config.set_write_ops_per_sec_quota(10);
+  q = TableQuotas::FromExtraConfig(config);
+  ASSERT_EQ(1024, q.scan_bytes_per_sec);
+  ASSERT_EQ(10, q.write_ops_per_sec);
+}
+
+TEST_F(ResourceQuotaManagerTest, TestUnlimited) {
+  const MonoTime now = MonoTime::Now();
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_OK(quotas_.AdmitWrite(now, "t", TableQuotas(), "alice"));
+    ASSERT_OK(quotas_.AdmitScan(now, "t", TableQuotas(), "alice"));
+    quotas_.ChargeScan(now, "t", TableQuotas(), "alice", 1024 * 1024);
+  }
+}
+
+TEST_F(ResourceQuotaManagerTest, TestTableWriteQuota) {
+  TableQuotas q;
+  q.write_ops_per_sec = 10;
+  MonoTime now = MonoTime::Now();
+
+  // A new bucket holds a second worth of writes.
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(quotas_.AdmitWrite(now, "t", q, "alice"));
+  }
+  Status s = quotas_.AdmitWrite(now, "t", q, "alice");
+  ASSERT_TRUE(s.IsServiceUnavailable()) << s.ToString();
+
+  // The other tables aren't affected.
+  ASSERT_OK(quotas_.AdmitWrite(now, "other", q, "alice"));
+
+  // A write is admitted again after a tenth of a second.
+  now += MonoDelta::FromMilliseconds(100);
+  ASSERT_OK(quotas_.AdmitWrite(now, "t", q, "alice"));
+  s = quotas_.AdmitWrite(now, "t", q, "alice");
+  ASSERT_TRUE(s.IsServiceUnavailable()) << s.ToString();
+
+  // Idle time only accrues up to the burst.
+  now += MonoDelta::FromSeconds(10);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(quotas_.AdmitWrite(now, "t", q, "alice"));
+  }
+  s = quotas_.AdmitWrite(now, "t", q, "alice");
+  ASSERT_TRUE(s.IsServiceUnavailable()) << s.ToString();
+}
+
+TEST_F(ResourceQuotaManagerTest, TestUserScanQuota) {
+  FLAGS_tserver_user_scan_bytes_per_sec_quota = 1000;
+  MonoTime now = MonoTime::Now();
+
+  // A batch may exceed the quota, and the debt delays the next batches.
+  ASSERT_OK(quotas_.AdmitScan(now, "t", TableQuotas(), "alice"));
+  quotas_.ChargeScan(now, "t", TableQuotas(), "alice", 3000);
+  Status s = quotas_.AdmitScan(now, "t", TableQuotas(), "alice");
+  ASSERT_TRUE(s.IsServiceUnavailable()) << s.ToString();
+  now += MonoDelta::FromMilliseconds(1500);
+  s = quotas_.AdmitScan(now, "t", TableQuotas(), "alice");
+  ASSERT_TRUE(s.IsServiceUnavailable()) << s.ToString();
+  now += MonoDelta::FromMilliseconds(600);
+  ASSERT_OK(quotas_.AdmitScan(now, "t", TableQuotas(), "alice"));
+
+  // The other users aren't affected, even when scanning the same table.
+  ASSERT_OK(quotas_.AdmitScan(now, "t", TableQuotas(), "bob"));
+
+  // The writes of the user aren't limited by the scan quota.
+  ASSERT_OK(quotas_.AdmitWrite(now, "t", TableQuotas(), "alice"));
+}
+
+TEST_F(ResourceQuotaManagerTest, TestTableAndUserQuotas) {
+  FLAGS_tserver_user_write_ops_per_sec_quota = 20;
+  TableQuotas q;
+  q.write_ops_per_sec = 10;
+  const MonoTime now = MonoTime::Now();
+
+  // The table's quota is reached first.
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(quotas_.AdmitWrite(now, "t0", q, "alice"));
+  }
+  ASSERT_TRUE(quotas_.AdmitWrite(now, "t0", q, "alice").IsServiceUnavailable());
+
+  // The rejected writes didn't count towards the user's quota.
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(quotas_.AdmitWrite(now, "t1", TableQuotas(), "alice"));
+  }
+  ASSERT_TRUE(quotas_.AdmitWrite(now, "t1", TableQuotas(), "alice").IsServiceUnavailable());
+}
+
+} // namespace tserver
+} // namespace kudu
@@ -0,0 +1,202 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/resource_quotas.h"
+
+#include <algorithm>
+#include <mutex>
+#include <ostream>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/flag_tags.h"
+
+DEFINE_int64(tserver_user_scan_bytes_per_sec_quota, 0,
+             "Maximum number of bytes per second read by the scans of each user on "
+             "this tablet server. The scans over quota are rejected with a retriable "
+             "error until enough time has passed. If 0, the scans of users are unlimited. "
+             "See also the 'kudu.table.scan_bytes_per_sec_quota' table property.");
+TAG_FLAG(tserver_user_scan_bytes_per_sec_quota, experimental);
+TAG_FLAG(tserver_user_scan_bytes_per_sec_quota, runtime);
+
+DEFINE_int64(tserver_user_write_ops_per_sec_quota, 0,
+             "Maximum number of write requests per second of each user on this tablet "
+             "server. The writes over quota are rejected with a retriable error. If 0, "
+             "the writes of users are unlimited. See also the "
+             "'kudu.table.write_ops_per_sec_quota' table property.");
+TAG_FLAG(tserver_user_write_ops_per_sec_quota, experimental);
+TAG_FLAG(tserver_user_write_ops_per_sec_quota, runtime);
+
+DEFINE_int32(tserver_quota_burst_ms, 1000,
+             "Maximum burst allowed by the scan and write quotas of the tables and of "
+             "the users, as the number of milliseconds worth of the quota which can "
+             "accumulate while a table or a user is idle.");
+TAG_FLAG(tserver_quota_burst_ms, experimental);
+TAG_FLAG(tserver_quota_burst_ms, runtime);
+
+namespace {
+
+bool ValidateQuota(const char* flagname, int64_t value) {
+  if (value >= 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must not be negative: " << value;
+  return false;
+}
+
+bool ValidateBurst(const char* flagname, int32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(tserver_user_scan_bytes_per_sec_quota, &ValidateQuota);
+DEFINE_validator(tserver_user_write_ops_per_sec_quota, &ValidateQuota);
+DEFINE_validator(tserver_quota_burst_ms, &ValidateBurst);
+
+using std::optional;
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+namespace tserver {
+
+namespace {
+
+string TableKey(const string& table_id) {
+  return "table:" + table_id;
+}
+
+string UserKey(const string& user) {
+  return "user:" + user;
+}
+
+} // anonymous namespace
+
+TableQuotas TableQuotas::FromExtraConfig(const optional<TableExtraConfigPB>& config) {
+  TableQuotas quotas;
+  if (config) {
+    quotas.scan_bytes_per_sec = config->scan_bytes_per_sec_quota();
+    quotas.write_ops_per_sec = config->write_ops_per_sec_quota();
+  }
+  return quotas;
+}
+
+void ResourceQuotaManager::Bucket::Refill(MonoTime now, int64_t rate) {
+  const double max_tokens =
+      static_cast<double>(rate) * FLAGS_tserver_quota_burst_ms / 1000;
+  if (!last_refill.Initialized()) {
+    // A new bucket starts full.
+    tokens = max_tokens;
+  } else if (now > last_refill) {
+    tokens = std::min(max_tokens, tokens + (now - last_refill).ToSeconds() * rate);
+  }
+  last_refill = std::max(now, last_refill);
+}
+
+ResourceQuotaManager::Bucket* ResourceQuotaManager::GetBucket(
+    BucketMap* buckets, const string& key, MonoTime now, int64_t rate) {
+  if (rate <= 0) {
+    return nullptr;
+  }
+  Bucket* bucket = &(*buckets)[key];
+  bucket->Refill(now, rate);
+  return bucket;
+}
+
+Status ResourceQuotaManager::AdmitWrite(MonoTime now,
+                                        const string& table_id,
+                                        const TableQuotas& table_quotas,
+                                        const string& user) {
+  const int64_t user_quota = FLAGS_tserver_user_write_ops_per_sec_quota;
+  if (table_quotas.write_ops_per_sec <= 0 && user_quota <= 0) {
+    return Status::OK();
+  }
+  std::lock_guard<simple_spinlock> l(lock_);
+  Bucket* table = GetBucket(&write_buckets_, TableKey(table_id), now,
+                            table_quotas.write_ops_per_sec);
+  if (table && table->tokens < 1) {
+    return Status::ServiceUnavailable(Substitute(
+        "write quota of table $0 exceeded", table_id));
+  }
+  Bucket* usr = GetBucket(&write_buckets_, UserKey(user), now, user_quota);
+  if (usr && usr->tokens < 1) {
+    return Status::ServiceUnavailable(Substitute(
+        "write quota of user $0 exceeded", user));
+  }
+  if (table) {
+    table->tokens -= 1;
+  }
+  if (usr) {
+    usr->tokens -= 1;
+  }
+  return Status::OK();
+}
+
+Status ResourceQuotaManager::AdmitScan(MonoTime now,
+                                       const string& table_id,
+                                       const TableQuotas& table_quotas,
+                                       const string& user) {
+  const int64_t user_quota = FLAGS_tserver_user_scan_bytes_per_sec_quota;
+  if (table_quotas.scan_bytes_per_sec <= 0 && user_quota <= 0) {
+    return Status::OK();
+  }
+  std::lock_guard<simple_spinlock> l(lock_);
+  const Bucket* table = GetBucket(&scan_buckets_, TableKey(table_id), now,
+                                  table_quotas.scan_bytes_per_sec);
+  if (table && table->tokens <= 0) {
+    return Status::ServiceUnavailable(Substitute(
+        "scan quota of table $0 exceeded", table_id));
+  }
+  const Bucket* usr = GetBucket(&scan_buckets_, UserKey(user), now, user_quota);
+  if (usr && usr->tokens <= 0) {
+    return Status::ServiceUnavailable(Substitute(
+        "scan quota of user $0 exceeded", user));
+  }
+  return Status::OK();
+}
+
+void ResourceQuotaManager::ChargeScan(MonoTime now,
+                                      const string& table_id,
+                                      const TableQuotas& table_quotas,
+                                      const string& user,
+                                      int64_t bytes) {
+  const int64_t user_quota = FLAGS_tserver_user_scan_bytes_per_sec_quota;
+  if ((table_quotas.scan_bytes_per_sec <= 0 && user_quota <= 0) || bytes <= 0) {
+    return;
+  }
+  std::lock_guard<simple_spinlock> l(lock_);
+  Bucket* table = GetBucket(&scan_buckets_, TableKey(table_id), now,
+                            table_quotas.scan_bytes_per_sec);
+  if (table) {
+    table->tokens -= bytes;
+  }
+  Bucket* usr = GetBucket(&scan_buckets_, UserKey(user), now, user_quota);
+  if (usr) {
+    usr->tokens -= bytes;
+  }
+}
+
+} // namespace tserver
+} // namespace kudu
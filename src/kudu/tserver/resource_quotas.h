@@ -0,0 +1,121 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class TableExtraConfigPB;
+
+namespace tserver {
+
+// The quotas of a table, as set by its 'kudu.table.scan_bytes_per_sec_quota'
+// and 'kudu.table.write_ops_per_sec_quota' properties. A quota of 0 is
+// unlimited.
+struct TableQuotas {
+  int64_t scan_bytes_per_sec = 0;
+  int64_t write_ops_per_sec = 0;
+
+  static TableQuotas FromExtraConfig(const std::optional<TableExtraConfigPB>& config);
+};
+
+// Enforces the per-table and per-user quotas on the scans and the writes
+// served by a tablet server.
+//
+// Each table and each user with a quota gets a token bucket for the bytes
+// read by its scans and one for its write requests. A bucket is refilled at
+// the rate of the quota, and holds up to --tserver_quota_burst_ms worth of
+// tokens. The quotas of each user are set with
+// --tserver_user_scan_bytes_per_sec_quota and
+// --tserver_user_write_ops_per_sec_quota.
+//
+// The requests over quota aren't queued, which would tie up the RPC service
+// threads serving everybody else: they're rejected with ServiceUnavailable,
+// and the clients retry them with an exponential backoff. The requests of
+// the tables and users within their quotas keep being served as usual.
+//
+// This class is thread-safe.
+class ResourceQuotaManager {
+ public:
+  ResourceQuotaManager() = default;
+
+  // Returns ServiceUnavailable if the writes to the table 'table_id', whose
+  // quotas are 'table_quotas', or those of 'user' are over quota. Otherwise,
+  // accounts for one write request and returns OK.
+  Status AdmitWrite(MonoTime now,
+                    const std::string& table_id,
+                    const TableQuotas& table_quotas,
+                    const std::string& user);
+
+  // Returns ServiceUnavailable if the scans of the table 'table_id' or those
+  // of 'user' are over quota, i.e. have read more bytes than their quota
+  // allows so far.
+  Status AdmitScan(MonoTime now,
+                   const std::string& table_id,
+                   const TableQuotas& table_quotas,
+                   const std::string& user);
+
+  // Accounts for 'bytes' read by a scan of the table 'table_id' on behalf of
+  // 'user'. Since the size of a batch is only known once it's read, a scan may
+  // exceed the quota by up to a batch, which delays the next batches
+  // accordingly.
+  void ChargeScan(MonoTime now,
+                  const std::string& table_id,
+                  const TableQuotas& table_quotas,
+                  const std::string& user,
+                  int64_t bytes);
+
+ private:
+  // A token bucket which may go into debt.
+  struct Bucket {
+    // Adds the tokens accrued at 'rate' per second since the last refill.
+    void Refill(MonoTime now, int64_t rate);
+
+    double tokens = 0;
+    MonoTime last_refill;
+  };
+  typedef std::unordered_map<std::string, Bucket> BucketMap;
+
+  // Returns the bucket of 'key' in 'buckets', refilled as of 'now' at 'rate',
+  // or nullptr if 'rate' isn't positive.
+  //
+  // REQUIRES: 'lock_' is held.
+  static Bucket* GetBucket(BucketMap* buckets, const std::string& key,
+                           MonoTime now, int64_t rate);
+
+  // Protects the buckets.
+  simple_spinlock lock_;
+
+  // The buckets of the scans and the writes, keyed by "table:<table ID>" and
+  // "user:<user name>".
+  BucketMap scan_buckets_;
+  BucketMap write_buckets_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResourceQuotaManager);
+};
+
+} // namespace tserver
+} // namespace kudu
@@ -0,0 +1,126 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/scan_bloom_filters.h"
+
+#include <cstdint>
+#include <memory>
+
+#include <gflags/gflags_declare.h>
+#include <glog/logging.h>
+#include <google/protobuf/repeated_field.h>
+#include <gtest/gtest.h>
+
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/block_bloom_filter.pb.h"
+#include "kudu/util/hash.pb.h"
+#include "kudu/util/hash_util.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_int32(scan_bloom_filter_ttl_ms);
+
+using google::protobuf::RepeatedPtrField;
+using std::shared_ptr;
+
+namespace kudu {
+namespace tserver {
+
+class ScanBloomFilterRegistryTest : public KuduTest {
+ protected:
+  // Returns the hash of 'value' in the filters of the test.
+  static uint32_t Hash(int64_t value) {
+    return HashUtil::ComputeHash32(
+        Slice(reinterpret_cast<const uint8_t*>(&value), sizeof(value)), FAST_HASH, 0);
+  }
+
+  // Returns a filter containing 'value'.
+  static BlockBloomFilterPB FilterOf(int64_t value) {
+    BlockBloomFilter bf(DefaultBlockBloomFilterBufferAllocator::GetSingleton());
+    CHECK_OK(bf.Init(BlockBloomFilter::MinLogSpace(100, 0.0001), FAST_HASH, 0));
+    bf.Insert(Hash(value));
+    BlockBloomFilterPB pb;
+    bf.CopyToPB(&pb);
+    return pb;
+  }
+
+  ScanBloomFilterRegistry registry_;
+};
+
+TEST_F(ScanBloomFilterRegistryTest, TestRegisterAndShare) {
+  const MonoTime now = MonoTime::Now();
+  const RepeatedPtrField<BlockBloomFilterPB> none;
+  shared_ptr<const ScanBloomFilterRegistry::Filters> filters;
+  Status s = registry_.GetOrRegister("f1", none, now, &filters);
+  ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+
+  RepeatedPtrField<BlockBloomFilterPB> pbs;
+  *pbs.Add() = FilterOf(42);
+  ASSERT_OK(registry_.GetOrRegister("f1", pbs, now, &filters));
+  ASSERT_EQ(1, filters->filters.size());
+  ASSERT_TRUE(filters->filters[0]->Find(Hash(42)));
+  ASSERT_EQ(1, registry_.num_filter_ids());
+
+  // The later scans share the filters by their ID.
+  shared_ptr<const ScanBloomFilterRegistry::Filters> shared;
+  ASSERT_OK(registry_.GetOrRegister("f1", none, now, &shared));
+  ASSERT_EQ(filters.get(), shared.get());
+
+  // Sending the filters again replaces them.
+  *pbs.Mutable(0) = FilterOf(7);
+  ASSERT_OK(registry_.GetOrRegister("f1", pbs, now, &shared));
+  ASSERT_NE(filters.get(), shared.get());
+  ASSERT_TRUE(shared->filters[0]->Find(Hash(7)));
+  ASSERT_EQ(1, registry_.num_filter_ids());
+
+  // Invalid filters are rejected.
+  pbs.Mutable(0)->clear_bloom_data();
+  s = registry_.GetOrRegister("f2", pbs, now, &filters);
+  ASSERT_FALSE(s.ok());
+  ASSERT_EQ(1, registry_.num_filter_ids());
+}
+
+TEST_F(ScanBloomFilterRegistryTest, TestExpiry) {
+  FLAGS_scan_bloom_filter_ttl_ms = 1000;
+  const MonoTime now = MonoTime::Now();
+  const RepeatedPtrField<BlockBloomFilterPB> none;
+  RepeatedPtrField<BlockBloomFilterPB> pbs;
+  *pbs.Add() = FilterOf(42);
+  shared_ptr<const ScanBloomFilterRegistry::Filters> filters;
+  ASSERT_OK(registry_.GetOrRegister("f1", pbs, now, &filters));
+  ASSERT_OK(registry_.GetOrRegister("f2", pbs, now, &filters));
+
+  // Using the filters of an ID keeps them alive.
+  const MonoTime later = now + MonoDelta::FromMilliseconds(800);
+  ASSERT_OK(registry_.GetOrRegister("f2", none, later, &filters));
+  registry_.RemoveExpiredFilters(now + MonoDelta::FromMilliseconds(1500));
+  ASSERT_EQ(1, registry_.num_filter_ids());
+  Status s = registry_.GetOrRegister("f1", none, later, &filters);
+  ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+  ASSERT_OK(registry_.GetOrRegister("f2", none, later, &filters));
+
+  // The scanners keep the expired filters they use.
+  registry_.RemoveExpiredFilters(later + MonoDelta::FromMilliseconds(1500));
+  ASSERT_EQ(0, registry_.num_filter_ids());
+  ASSERT_TRUE(filters->filters[0]->Find(Hash(42)));
+}
+
+} // namespace tserver
+} // namespace kudu
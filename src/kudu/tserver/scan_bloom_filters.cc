@@ -0,0 +1,121 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/scan_bloom_filters.h"
+
+#include <mutex>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/block_bloom_filter.pb.h"
+#include "kudu/util/flag_tags.h"
+
+DEFINE_int32(scan_bloom_filter_ttl_ms, 5 * 60 * 1000,
+             "Number of milliseconds after which the bloom filters registered "
+             "by the scans under a filter ID (see "
+             "ColumnPredicatePB.InBloomFilter.filter_id) are dropped if no scan "
+             "used them in the meantime.");
+TAG_FLAG(scan_bloom_filter_ttl_ms, experimental);
+TAG_FLAG(scan_bloom_filter_ttl_ms, runtime);
+
+namespace {
+
+bool ValidateFilterTtl(const char* flagname, int32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(scan_bloom_filter_ttl_ms, &ValidateFilterTtl);
+
+using google::protobuf::RepeatedPtrField;
+using std::shared_ptr;
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+namespace tserver {
+
+ScanBloomFilterRegistry::Filters::Filters() {
+}
+
+ScanBloomFilterRegistry::Filters::~Filters() {
+}
+
+Status ScanBloomFilterRegistry::GetOrRegister(const string& filter_id,
+                                              const RepeatedPtrField<BlockBloomFilterPB>& pbs,
+                                              MonoTime now,
+                                              shared_ptr<const Filters>* filters) {
+  if (pbs.empty()) {
+    std::lock_guard<simple_spinlock> l(lock_);
+    auto it = entries_.find(filter_id);
+    if (it == entries_.end()) {
+      return Status::NotFound(
+          Substitute("no bloom filters registered under filter ID $0", filter_id));
+    }
+    it->second.last_used = now;
+    *filters = it->second.filters;
+    return Status::OK();
+  }
+
+  // Decode the filters outside of the lock.
+  shared_ptr<Filters> decoded = std::make_shared<Filters>();
+  auto* allocator = DefaultBlockBloomFilterBufferAllocator::GetSingleton();
+  for (const auto& pb : pbs) {
+    std::unique_ptr<BlockBloomFilter> filter(new BlockBloomFilter(allocator));
+    RETURN_NOT_OK_PREPEND(filter->InitFromPB(pb),
+                          Substitute("invalid bloom filter under filter ID $0", filter_id));
+    decoded->filters.emplace_back(filter.get());
+    decoded->owned_filters.emplace_back(std::move(filter));
+  }
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  auto& entry = entries_[filter_id];
+  entry.filters = decoded;
+  entry.last_used = now;
+  *filters = std::move(decoded);
+  return Status::OK();
+}
+
+void ScanBloomFilterRegistry::RemoveExpiredFilters(MonoTime now) {
+  const MonoDelta ttl = MonoDelta::FromMilliseconds(FLAGS_scan_bloom_filter_ttl_ms);
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.last_used + ttl < now) {
+      VLOG(1) << "Dropping expired bloom filters " << it->first;
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t ScanBloomFilterRegistry::num_filter_ids() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return entries_.size();
+}
+
+} // namespace tserver
+} // namespace kudu
@@ -0,0 +1,98 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <google/protobuf/repeated_field.h> // IWYU pragma: keep
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class BlockBloomFilter;
+class BlockBloomFilterPB;
+
+namespace tserver {
+
+// The bloom filters of the InBloomFilter predicates which name them with a
+// filter ID (see ColumnPredicatePB.InBloomFilter.filter_id), e.g. the runtime
+// filters of a join. A client sends the filters of an ID to a tablet server
+// once, along with the first scan of the tablets of the server which uses
+// them, and refers to them by their ID only in the other scans. The scanners
+// share the decoded filters rather than decoding a copy each.
+//
+// The filters of an ID are dropped once unused for --scan_bloom_filter_ttl_ms.
+//
+// This class is thread-safe.
+class ScanBloomFilterRegistry {
+ public:
+  // Decoded bloom filters. Immutable once registered.
+  struct Filters {
+    Filters();
+    ~Filters();
+
+    // The filters, as passed to ColumnPredicate::InBloomFilter().
+    std::vector<BlockBloomFilter*> filters;
+
+    std::vector<std::unique_ptr<BlockBloomFilter>> owned_filters;
+  };
+
+  ScanBloomFilterRegistry() = default;
+  ~ScanBloomFilterRegistry() = default;
+
+  // Returns the filters of 'filter_id' in 'filters'. If 'pbs' isn't empty,
+  // its filters are decoded and registered under 'filter_id' first, replacing
+  // the filters previously registered under it.
+  //
+  // Returns NotFound if 'pbs' is empty and no filters are registered under
+  // 'filter_id', e.g. because they expired: the client must send them again.
+  Status GetOrRegister(const std::string& filter_id,
+                       const google::protobuf::RepeatedPtrField<BlockBloomFilterPB>& pbs,
+                       MonoTime now,
+                       std::shared_ptr<const Filters>* filters);
+
+  // Drops the filters which haven't been used since --scan_bloom_filter_ttl_ms
+  // before 'now'. The scanners using them keep them until they're done.
+  void RemoveExpiredFilters(MonoTime now);
+
+  size_t num_filter_ids() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<const Filters> filters;
+    MonoTime last_used;
+  };
+
+  // Protects 'entries_'.
+  mutable simple_spinlock lock_;
+
+  // The registered filters, keyed by filter ID.
+  std::unordered_map<std::string, Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanBloomFilterRegistry);
+};
+
+} // namespace tserver
+} // namespace kudu
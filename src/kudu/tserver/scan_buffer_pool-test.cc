@@ -0,0 +1,139 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/scan_buffer_pool.h"
+
+#include <cstdint>
+#include <memory>
+
+#include <gflags/gflags_declare.h>
+#include <gtest/gtest.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/rpc/rpc_sidecar.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_int64(scanner_buffer_pool_capacity_mb);
+
+METRIC_DECLARE_counter(scanner_row_block_pool_hits);
+METRIC_DECLARE_counter(scanner_row_block_pool_misses);
+METRIC_DECLARE_counter(scanner_buffer_pool_hits);
+METRIC_DECLARE_counter(scanner_buffer_pool_misses);
+
+using std::make_shared;
+using std::shared_ptr;
+using std::unique_ptr;
+
+namespace kudu {
+namespace tserver {
+
+class ScanBufferPoolTest : public KuduTest {
+ public:
+  ScanBufferPoolTest()
+      : entity_(METRIC_ENTITY_server.Instantiate(&registry_, "test")),
+        pool_(make_shared<ScanBufferPool>(entity_)) {
+  }
+
+ protected:
+  int64_t Count(const CounterPrototype& prototype) {
+    return prototype.Instantiate(entity_)->value();
+  }
+
+  MetricRegistry registry_;
+  scoped_refptr<MetricEntity> entity_;
+  shared_ptr<ScanBufferPool> pool_;
+};
+
+TEST_F(ScanBufferPoolTest, TestRowBlocks) {
+  const Schema schema({ ColumnSchema("key", INT32),
+                        ColumnSchema("val", STRING, /*is_nullable=*/true) }, 1);
+  // Same layout, other names and types.
+  const Schema other_schema({ ColumnSchema("k", UINT32),
+                              ColumnSchema("v", BINARY, /*is_nullable=*/true) }, 1);
+  const Schema not_null_schema({ ColumnSchema("key", INT32),
+                                 ColumnSchema("val", STRING) }, 1);
+  RowBlock* first;
+  {
+    ScanBufferPool::ScopedRowBlock block(pool_.get(), &schema, 100);
+    first = block.get();
+    ASSERT_EQ(&schema, first->schema());
+    ASSERT_EQ(100, first->row_capacity());
+    first->Resize(10);
+  }
+  ASSERT_EQ(0, Count(METRIC_scanner_row_block_pool_hits));
+  ASSERT_EQ(1, Count(METRIC_scanner_row_block_pool_misses));
+  ASSERT_GT(pool_->cached_bytes(), 0);
+
+  // A block with the same layout is reused, at its full capacity.
+  {
+    ScanBufferPool::ScopedRowBlock block(pool_.get(), &other_schema, 100);
+    ASSERT_EQ(first, block.get());
+    ASSERT_EQ(&other_schema, block.get()->schema());
+    ASSERT_EQ(100, block.get()->nrows());
+    ASSERT_EQ(0, pool_->cached_bytes());
+  }
+  ASSERT_EQ(1, Count(METRIC_scanner_row_block_pool_hits));
+
+  // Blocks of other layouts or capacities aren't.
+  {
+    ScanBufferPool::ScopedRowBlock block(pool_.get(), &not_null_schema, 100);
+    ScanBufferPool::ScopedRowBlock other_block(pool_.get(), &schema, 200);
+  }
+  ASSERT_EQ(1, Count(METRIC_scanner_row_block_pool_hits));
+  ASSERT_EQ(3, Count(METRIC_scanner_row_block_pool_misses));
+}
+
+TEST_F(ScanBufferPoolTest, TestBuffers) {
+  // Small buffers aren't pooled.
+  pool_->ReturnBuffer(pool_->GetBuffer(100));
+  ASSERT_EQ(0, pool_->cached_bytes());
+
+  faststring buf = pool_->GetBuffer(10000);
+  ASSERT_GE(buf.capacity(), 10000);
+  buf.append("data");
+  const uint8_t* data = buf.data();
+  pool_->ReturnBuffer(std::move(buf));
+  ASSERT_GE(pool_->cached_bytes(), 10000);
+
+  // A larger buffer isn't served from it.
+  ASSERT_GE(pool_->GetBuffer(30000).capacity(), 30000);
+  ASSERT_EQ(0, Count(METRIC_scanner_buffer_pool_hits));
+
+  // Sent buffers are returned when their sidecar is destroyed.
+  faststring reused = pool_->GetBuffer(8192);
+  ASSERT_EQ(data, reused.data());
+  ASSERT_EQ(0, reused.size());
+  ASSERT_EQ(1, Count(METRIC_scanner_buffer_pool_hits));
+  {
+    unique_ptr<rpc::RpcSidecar> sidecar = pool_->NewSidecar(std::move(reused));
+  }
+  ASSERT_EQ(data, pool_->GetBuffer(8192).data());
+  ASSERT_EQ(2, Count(METRIC_scanner_buffer_pool_hits));
+
+  // Nothing is cached without capacity.
+  FLAGS_scanner_buffer_pool_capacity_mb = 0;
+  pool_->ReturnBuffer(pool_->GetBuffer(10000));
+  ASSERT_EQ(0, pool_->cached_bytes());
+}
+
+} // namespace tserver
+} // namespace kudu
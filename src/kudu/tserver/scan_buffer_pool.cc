@@ -0,0 +1,258 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/scan_buffer_pool.h"
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/common/rowblock.h"
+#include "kudu/common/rowblock_memory.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/bits.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/rpc_sidecar.h"
+#include "kudu/rpc/transfer.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/slice.h"
+
+DEFINE_int64(scanner_buffer_pool_capacity_mb, 64,
+             "Maximum amount of memory, in MiB, cached by the pool of the row blocks and "
+             "serialization buffers reused across scan requests. If 0, they aren't reused.");
+TAG_FLAG(scanner_buffer_pool_capacity_mb, advanced);
+TAG_FLAG(scanner_buffer_pool_capacity_mb, runtime);
+
+METRIC_DEFINE_counter(server, scanner_row_block_pool_hits,
+                      "Scanner Row Block Pool Hits",
+                      kudu::MetricUnit::kRequests,
+                      "Number of row blocks for scan requests which were reused from the pool",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, scanner_row_block_pool_misses,
+                      "Scanner Row Block Pool Misses",
+                      kudu::MetricUnit::kRequests,
+                      "Number of row blocks for scan requests which had to be allocated "
+                      "since the pool had none with the same layout",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, scanner_buffer_pool_hits,
+                      "Scanner Buffer Pool Hits",
+                      kudu::MetricUnit::kRequests,
+                      "Number of buffers for serializing scan responses which were reused "
+                      "from the pool",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, scanner_buffer_pool_misses,
+                      "Scanner Buffer Pool Misses",
+                      kudu::MetricUnit::kRequests,
+                      "Number of buffers for serializing scan responses which had to be "
+                      "allocated since the pool had none large enough",
+                      kudu::MetricLevel::kDebug);
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+namespace tserver {
+
+namespace {
+
+// Identifies the RowBlocks which can hold 'nrows' rows of 'schema'.
+string RowBlockLayout(const Schema& schema, size_t nrows) {
+  string layout = strings::Substitute("$0:", nrows);
+  for (size_t i = 0; i < schema.num_columns(); ++i) {
+    const ColumnSchema& col = schema.column(i);
+    layout.push_back(static_cast<char>(col.type_info()->size()));
+    layout.push_back(col.is_nullable() ? 'n' : '-');
+  }
+  return layout;
+}
+
+// A sidecar whose buffer is returned to the pool when destroyed.
+class PooledBufferSidecar : public rpc::RpcSidecar {
+ public:
+  PooledBufferSidecar(std::shared_ptr<ScanBufferPool> pool, faststring data)
+      : pool_(std::move(pool)),
+        data_(std::move(data)) {
+  }
+
+  ~PooledBufferSidecar() override {
+    pool_->ReturnBuffer(std::move(data_));
+  }
+
+  void AppendSlices(rpc::TransferPayload* payload) const override {
+    payload->push_back(Slice(data_));
+  }
+
+  size_t TotalSize() const override {
+    return data_.size();
+  }
+
+ private:
+  const std::shared_ptr<ScanBufferPool> pool_;
+  faststring data_;
+};
+
+} // anonymous namespace
+
+struct ScanBufferPool::PooledRowBlock {
+  PooledRowBlock(const Schema* schema, size_t nrows, string layout)
+      : block(schema, nrows, &memory),
+        layout(std::move(layout)),
+        columns_footprint(0) {
+    for (size_t i = 0; i < schema->num_columns(); ++i) {
+      const ColumnSchema& col = schema->column(i);
+      columns_footprint += nrows * col.type_info()->size();
+      if (col.is_nullable()) {
+        columns_footprint += BitmapSize(nrows);
+      }
+    }
+  }
+
+  // Returns the memory used by the columns of the block and its arena.
+  size_t memory_footprint() const {
+    return columns_footprint + memory.arena.memory_footprint();
+  }
+
+  RowBlockMemory memory;
+  RowBlock block;
+  const string layout;
+  size_t columns_footprint;
+  // The footprint of the block when it was returned to the pool. The schema
+  // of the block may be gone by the time it's reused.
+  size_t cached_footprint = 0;
+};
+
+ScanBufferPool::ScopedRowBlock::ScopedRowBlock(ScanBufferPool* pool,
+                                               const Schema* schema,
+                                               size_t nrows)
+    : pool_(pool),
+      block_(pool->GetRowBlock(schema, nrows)) {
+}
+
+ScanBufferPool::ScopedRowBlock::~ScopedRowBlock() {
+  pool_->ReturnRowBlock(std::move(block_));
+}
+
+RowBlock* ScanBufferPool::ScopedRowBlock::get() const {
+  return &block_->block;
+}
+
+ScanBufferPool::ScanBufferPool(const scoped_refptr<MetricEntity>& metric_entity)
+    : buffers_(64),
+      cached_bytes_(0) {
+  if (metric_entity) {
+    row_block_hits_ = METRIC_scanner_row_block_pool_hits.Instantiate(metric_entity);
+    row_block_misses_ = METRIC_scanner_row_block_pool_misses.Instantiate(metric_entity);
+    buffer_hits_ = METRIC_scanner_buffer_pool_hits.Instantiate(metric_entity);
+    buffer_misses_ = METRIC_scanner_buffer_pool_misses.Instantiate(metric_entity);
+  }
+}
+
+ScanBufferPool::~ScanBufferPool() {}
+
+unique_ptr<ScanBufferPool::PooledRowBlock> ScanBufferPool::GetRowBlock(const Schema* schema,
+                                                                       size_t nrows) {
+  string layout = RowBlockLayout(*schema, nrows);
+  unique_ptr<PooledRowBlock> block;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    auto it = row_blocks_.find(layout);
+    if (it != row_blocks_.end() && !it->second.empty()) {
+      block = std::move(it->second.back());
+      it->second.pop_back();
+      cached_bytes_ -= block->cached_footprint;
+    }
+  }
+  if (block) {
+    if (row_block_hits_) row_block_hits_->Increment();
+    block->block.ResetSchema(schema);
+    return block;
+  }
+  if (row_block_misses_) row_block_misses_->Increment();
+  return unique_ptr<PooledRowBlock>(new PooledRowBlock(schema, nrows, std::move(layout)));
+}
+
+void ScanBufferPool::ReturnRowBlock(unique_ptr<PooledRowBlock> block) {
+  // Release the blocks of data referenced by the rows before caching, and
+  // shrink the arena to its last component.
+  block->memory.Reset();
+  block->block.Resize(block->block.row_capacity());
+  block->cached_footprint = block->memory_footprint();
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (ReserveUnlocked(block->cached_footprint)) {
+    row_blocks_[block->layout].emplace_back(std::move(block));
+  }
+}
+
+faststring ScanBufferPool::GetBuffer(size_t capacity) {
+  if (capacity >= kMinBufferCapacity) {
+    // The buffers of this class and above have at least 'capacity' bytes.
+    const int size_class = Bits::Log2Ceiling64(capacity);
+    std::lock_guard<simple_spinlock> l(lock_);
+    vector<faststring>& buffers = buffers_[size_class];
+    if (!buffers.empty()) {
+      faststring buffer = std::move(buffers.back());
+      buffers.pop_back();
+      cached_bytes_ -= buffer.capacity();
+      if (buffer_hits_) buffer_hits_->Increment();
+      return buffer;
+    }
+  }
+  if (buffer_misses_) buffer_misses_->Increment();
+  return faststring(capacity);
+}
+
+void ScanBufferPool::ReturnBuffer(faststring buffer) {
+  if (buffer.capacity() < kMinBufferCapacity) {
+    return;
+  }
+  buffer.clear();
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (ReserveUnlocked(buffer.capacity())) {
+    buffers_[Bits::Log2Floor64(buffer.capacity())].emplace_back(std::move(buffer));
+  }
+}
+
+unique_ptr<rpc::RpcSidecar> ScanBufferPool::NewSidecar(faststring data) {
+  return unique_ptr<rpc::RpcSidecar>(new PooledBufferSidecar(shared_from_this(),
+                                                             std::move(data)));
+}
+
+size_t ScanBufferPool::cached_bytes() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return cached_bytes_;
+}
+
+bool ScanBufferPool::ReserveUnlocked(size_t bytes) {
+  DCHECK(lock_.is_locked());
+  const int64_t capacity = FLAGS_scanner_buffer_pool_capacity_mb * 1024 * 1024;
+  if (static_cast<int64_t>(cached_bytes_ + bytes) > capacity) {
+    return false;
+  }
+  cached_bytes_ += bytes;
+  return true;
+}
+
+} // namespace tserver
+} // namespace kudu
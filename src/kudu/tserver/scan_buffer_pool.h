@@ -0,0 +1,121 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/metrics.h"
+
+namespace kudu {
+
+class RowBlock;
+class Schema;
+
+namespace rpc {
+class RpcSidecar;
+} // namespace rpc
+
+namespace tserver {
+
+// A pool of the RowBlocks and the serialization buffers used by scan
+// requests, shared by the scanners of a tablet server. Requests borrow them
+// and return them when done rather than allocating new ones, which saves
+// allocations and page faults for servers handling many small scans.
+//
+// RowBlocks are pooled by the layout of their schema, i.e. the sizes and
+// nullability of their columns, and by their capacity in rows. Buffers are
+// pooled by their capacity. The memory cached by the pool is bounded by
+// --scanner_buffer_pool_capacity_mb: what's returned beyond it is freed.
+//
+// This class is thread-safe.
+class ScanBufferPool : public std::enable_shared_from_this<ScanBufferPool> {
+ private:
+  struct PooledRowBlock;
+
+ public:
+  // The RowBlock borrowed from a pool for the lifetime of this object.
+  class ScopedRowBlock {
+   public:
+    ScopedRowBlock(ScanBufferPool* pool, const Schema* schema, size_t nrows);
+    ~ScopedRowBlock();
+
+    RowBlock* get() const;
+
+   private:
+    ScanBufferPool* const pool_;
+    std::unique_ptr<PooledRowBlock> block_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedRowBlock);
+  };
+
+  // 'metric_entity' may be null, in which case the hits and misses of the
+  // pool aren't counted.
+  explicit ScanBufferPool(const scoped_refptr<MetricEntity>& metric_entity);
+  ~ScanBufferPool();
+
+  // Returns an empty buffer with a capacity of at least 'capacity' bytes.
+  faststring GetBuffer(size_t capacity);
+
+  // Returns 'buffer' to the pool.
+  void ReturnBuffer(faststring buffer);
+
+  // Returns a sidecar sending 'data', whose buffer is returned to the pool
+  // once the sidecar is destroyed, i.e. once the response is sent.
+  std::unique_ptr<rpc::RpcSidecar> NewSidecar(faststring data);
+
+  // Returns the number of bytes cached by the pool.
+  size_t cached_bytes() const;
+
+ private:
+  // Buffers of a capacity below this aren't worth pooling.
+  static constexpr size_t kMinBufferCapacity = 4096;
+
+  std::unique_ptr<PooledRowBlock> GetRowBlock(const Schema* schema, size_t nrows);
+  void ReturnRowBlock(std::unique_ptr<PooledRowBlock> block);
+
+  // Returns whether 'bytes' more can be cached within the capacity of the
+  // pool, adding them to 'cached_bytes_' if so.
+  bool ReserveUnlocked(size_t bytes);
+
+  mutable simple_spinlock lock_;
+
+  // The RowBlocks, by layout.
+  std::unordered_map<std::string, std::vector<std::unique_ptr<PooledRowBlock>>> row_blocks_;
+
+  // The buffers, by the floor of the logarithm in base 2 of their capacity.
+  std::vector<std::vector<faststring>> buffers_;
+
+  size_t cached_bytes_;
+
+  scoped_refptr<Counter> row_block_hits_;
+  scoped_refptr<Counter> row_block_misses_;
+  scoped_refptr<Counter> buffer_hits_;
+  scoped_refptr<Counter> buffer_misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanBufferPool);
+};
+
+} // namespace tserver
+} // namespace kudu
@@ -0,0 +1,156 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/scan_expressions.h"
+
+#include <cstring>
+#include <unordered_set>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/expression.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/bitmap.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tserver {
+
+namespace {
+
+vector<ColumnSchema> AppendColumns(const Schema& schema, const vector<ColumnSchema>& columns) {
+  vector<ColumnSchema> all_columns = schema.columns();
+  all_columns.insert(all_columns.end(), columns.begin(), columns.end());
+  return all_columns;
+}
+
+} // anonymous namespace
+
+ScanExpressions::ScanExpressions(const Schema& schema,
+                                 unique_ptr<Expression> filter,
+                                 vector<ColumnSchema> computed_columns,
+                                 vector<unique_ptr<Expression>> computed_exprs)
+    : schema_(schema),
+      computed_columns_(std::move(computed_columns)),
+      output_schema_(AppendColumns(schema_, computed_columns_), schema_.num_key_columns()),
+      filter_(std::move(filter)),
+      computed_exprs_(std::move(computed_exprs)) {
+}
+
+ScanExpressions::~ScanExpressions() {
+}
+
+void ScanExpressions::GetReferencedColumns(const NewScanRequestPB& scan_pb,
+                                           vector<string>* columns) {
+  if (scan_pb.has_filter()) {
+    Expression::GetReferencedColumns(scan_pb.filter(), columns);
+  }
+  for (const auto& computed : scan_pb.computed_columns()) {
+    Expression::GetReferencedColumns(computed.expr(), columns);
+  }
+}
+
+Status ScanExpressions::Create(const NewScanRequestPB& scan_pb,
+                               const Schema& schema,
+                               unique_ptr<ScanExpressions>* expressions) {
+  if (!scan_pb.has_filter() && scan_pb.computed_columns().empty()) {
+    expressions->reset();
+    return Status::OK();
+  }
+
+  unique_ptr<Expression> filter;
+  if (scan_pb.has_filter()) {
+    RETURN_NOT_OK_PREPEND(Expression::FromPB(scan_pb.filter(), schema, &filter),
+                          "invalid scan filter");
+    if (filter->type() != BOOL) {
+      return Status::InvalidArgument(Substitute(
+          "scan filter must be a BOOL expression, not $0", DataType_Name(filter->type())));
+    }
+  }
+
+  std::unordered_set<string> names;
+  for (const auto& col : schema.columns()) {
+    names.insert(col.name());
+  }
+  vector<ColumnSchema> computed_columns;
+  vector<unique_ptr<Expression>> computed_exprs;
+  for (const auto& computed : scan_pb.computed_columns()) {
+    if (computed.name().empty()) {
+      return Status::InvalidArgument("computed columns require a name");
+    }
+    if (!names.insert(computed.name()).second) {
+      return Status::InvalidArgument("computed column name is already used", computed.name());
+    }
+    unique_ptr<Expression> expr;
+    RETURN_NOT_OK_PREPEND(Expression::FromPB(computed.expr(), schema, &expr),
+                          Substitute("invalid computed column $0", computed.name()));
+    computed_columns.emplace_back(computed.name(), expr->type(), /*is_nullable=*/true);
+    computed_exprs.emplace_back(std::move(expr));
+  }
+  expressions->reset(new ScanExpressions(
+      schema, std::move(filter), std::move(computed_columns), std::move(computed_exprs)));
+  return Status::OK();
+}
+
+void ScanExpressions::Filter(RowBlock* block) const {
+  DCHECK_EQ(schema_.num_columns(), block->schema()->num_columns());
+  if (filter_) {
+    filter_->Filter(*block, block->selection_vector());
+  }
+}
+
+const RowBlock& ScanExpressions::Compute(const RowBlock& block) {
+  DCHECK_EQ(schema_.num_columns(), block.schema()->num_columns());
+  if (computed_exprs_.empty()) {
+    return block;
+  }
+  const size_t n = block.nrows();
+  if (!output_ || output_->row_capacity() < n) {
+    output_.reset(new RowBlock(&output_schema_, n, &output_memory_));
+  }
+  output_->Resize(n);
+
+  // The cells of the scanned columns are copied as they are: the indirect data
+  // of their binary cells stays in the memory of 'block'. The computed cells
+  // have no indirect data.
+  for (size_t c = 0; c < schema_.num_columns(); c++) {
+    const ColumnBlock src = block.column_block(c);
+    ColumnBlock dst = output_->column_block(c);
+    memcpy(dst.data(), src.data(), n * src.stride());
+    if (src.is_nullable()) {
+      BitmapCopy(dst.non_null_bitmap(), 0, src.non_null_bitmap(), 0, n);
+    }
+  }
+  block.selection_vector()->CopyTo(output_->selection_vector(), 0, 0, n);
+  for (size_t i = 0; i < computed_exprs_.size(); i++) {
+    ColumnBlock dst = output_->column_block(schema_.num_columns() + i);
+    computed_exprs_[i]->Evaluate(block, &dst);
+  }
+  return *output_;
+}
+
+} // namespace tserver
+} // namespace kudu
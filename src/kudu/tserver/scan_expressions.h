@@ -0,0 +1,101 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/common/rowblock_memory.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Expression;
+class RowBlock;
+
+namespace tserver {
+
+class NewScanRequestPB;
+
+// The expressions evaluated by a scan over the rows of its tablet, for the
+// scans with a filter or computed columns (see NewScanRequestPB): the filter
+// unselects the rows which don't pass it, and the computed columns are
+// appended to the scanned rows before they're returned.
+//
+// This class is not thread-safe.
+class ScanExpressions {
+ public:
+  ~ScanExpressions();
+
+  // Appends the names of the columns referred to by the expressions of
+  // 'scan_pb' to 'columns'.
+  static void GetReferencedColumns(const NewScanRequestPB& scan_pb,
+                                   std::vector<std::string>* columns);
+
+  // Builds the expressions of 'scan_pb' over the scanned rows, of schema
+  // 'schema', into 'expressions'. Resets 'expressions' if 'scan_pb' has none.
+  static Status Create(const NewScanRequestPB& scan_pb,
+                       const Schema& schema,
+                       std::unique_ptr<ScanExpressions>* expressions);
+
+  // The schema of the rows returned by the scan: the schema of the scanned
+  // rows, followed by the computed columns.
+  const Schema& output_schema() const {
+    return output_schema_;
+  }
+
+  // The computed columns, in the order of the scan request.
+  const std::vector<ColumnSchema>& computed_columns() const {
+    return computed_columns_;
+  }
+
+  // Unselects the rows of 'block' which don't pass the filter, if any.
+  //
+  // REQUIRES: 'block' has the schema of the scanned rows.
+  void Filter(RowBlock* block) const;
+
+  // Returns the rows of 'block' followed by their computed columns, if any,
+  // or 'block' itself otherwise. The returned rows are valid until the next
+  // call, and refer to the indirect data of 'block'.
+  //
+  // REQUIRES: 'block' has the schema of the scanned rows.
+  const RowBlock& Compute(const RowBlock& block);
+
+ private:
+  ScanExpressions(const Schema& schema,
+                  std::unique_ptr<Expression> filter,
+                  std::vector<ColumnSchema> computed_columns,
+                  std::vector<std::unique_ptr<Expression>> computed_exprs);
+
+  const Schema schema_;
+  const std::vector<ColumnSchema> computed_columns_;
+  const Schema output_schema_;
+  const std::unique_ptr<Expression> filter_;
+  const std::vector<std::unique_ptr<Expression>> computed_exprs_;
+
+  // The rows returned by Compute(), reused across calls.
+  RowBlockMemory output_memory_;
+  std::unique_ptr<RowBlock> output_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanExpressions);
+};
+
+} // namespace tserver
+} // namespace kudu
@@ -0,0 +1,145 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/scan_top_n.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/common/row.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/util/status.h"
+
+using std::unique_ptr;
+
+namespace kudu {
+namespace tserver {
+
+namespace {
+
+// The initial size of the arena of the collected rows.
+constexpr size_t kInitialArenaSize = 4096;
+
+// Whether the row 'a' at position 'a_seq' of the scan ranks before the row
+// 'b' at position 'b_seq'. See ScanTopN.
+template<class RowTypeA, class RowTypeB>
+bool RanksBefore(const RowTypeA& a, int64_t a_seq,
+                 const RowTypeB& b, int64_t b_seq,
+                 int col_idx, bool descending) {
+  const ColumnSchema& col = a.schema()->column(col_idx);
+  if (col.is_nullable()) {
+    const bool a_null = a.is_null(col_idx);
+    const bool b_null = b.is_null(col_idx);
+    if (a_null || b_null) {
+      return a_null == b_null ? a_seq < b_seq : b_null;
+    }
+  }
+  const int cmp = col.type_info()->Compare(a.cell_ptr(col_idx), b.cell_ptr(col_idx));
+  if (cmp != 0) {
+    return descending ? cmp > 0 : cmp < 0;
+  }
+  return a_seq < b_seq;
+}
+
+} // anonymous namespace
+
+ScanTopN::ScanTopN(const Schema* schema, int col_idx, bool descending, size_t limit)
+    : schema_(schema),
+      col_idx_(col_idx),
+      descending_(descending),
+      limit_(limit),
+      arena_(new Arena(kInitialArenaSize)) {
+  DCHECK_GT(limit_, 0);
+  DCHECK_LT(col_idx_, schema_->num_columns());
+}
+
+bool ScanTopN::Better(const Row& a, const Row& b) const {
+  return RanksBefore(ContiguousRow(schema_, a.data), a.seq,
+                     ContiguousRow(schema_, b.data), b.seq,
+                     col_idx_, descending_);
+}
+
+template<class RowType>
+uint8_t* ScanTopN::CopyToArena(const RowType& src, Arena* arena) const {
+  const size_t row_size = ContiguousRowHelper::row_size(*schema_);
+  uint8_t* data = reinterpret_cast<uint8_t*>(arena->AllocateBytes(row_size));
+  CHECK(data) << "could not allocate " << row_size << " bytes for a row";
+  ContiguousRowHelper::InitNullsBitmap(
+      *schema_, data, ContiguousRowHelper::non_null_bitmap_size(*schema_));
+  ContiguousRow dst(schema_, data);
+  CHECK_OK(CopyRow(src, &dst, arena));
+  return data;
+}
+
+void ScanTopN::AddRows(const RowBlock& block) {
+  DCHECK(!returned_);
+  const auto worse = [this](const Row& a, const Row& b) { return Better(a, b); };
+  block.selection_vector()->ForEachIndex([&](size_t i) {
+    const RowBlockRow row = block.row(i);
+    const int64_t seq = next_seq_++;
+    if (rows_.size() < limit_) {
+      rows_.push_back({ CopyToArena(row, arena_.get()), seq });
+      std::push_heap(rows_.begin(), rows_.end(), worse);
+      return;
+    }
+    // Compare the row with the worst of the collected rows before copying it:
+    // most rows of a large scan don't make it.
+    const Row& worst = rows_.front();
+    if (!RanksBefore(row, seq, ContiguousRow(schema_, worst.data), worst.seq,
+                     col_idx_, descending_)) {
+      return;
+    }
+    std::pop_heap(rows_.begin(), rows_.end(), worse);
+    rows_.back() = { CopyToArena(row, arena_.get()), seq };
+    std::push_heap(rows_.begin(), rows_.end(), worse);
+    if (++num_evicted_ >= limit_) {
+      Compact();
+    }
+  });
+}
+
+void ScanTopN::Compact() {
+  unique_ptr<Arena> arena(new Arena(kInitialArenaSize));
+  for (auto& row : rows_) {
+    row.data = CopyToArena(ContiguousRow(schema_, row.data), arena.get());
+  }
+  arena_ = std::move(arena);
+  num_evicted_ = 0;
+}
+
+void ScanTopN::TakeRows(RowBlock* block) {
+  DCHECK(!returned_);
+  DCHECK_GE(block->row_capacity(), rows_.size());
+  std::sort(rows_.begin(), rows_.end(),
+            [this](const Row& a, const Row& b) { return Better(a, b); });
+  block->Resize(rows_.size());
+  block->selection_vector()->SetAllTrue();
+  for (size_t i = 0; i < rows_.size(); i++) {
+    RowBlockRow dst = block->row(i);
+    CHECK_OK(CopyRow(ContiguousRow(schema_, rows_[i].data), &dst, block->arena()));
+  }
+  rows_.clear();
+  arena_.reset(new Arena(kInitialArenaSize));
+  returned_ = true;
+}
+
+} // namespace tserver
+} // namespace kudu
@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/memory/arena.h"
+
+namespace kudu {
+
+class RowBlock;
+class Schema;
+
+namespace tserver {
+
+// The best rows of a scan ranked by the cells of one of its columns, for the
+// scans with a TopNPB: the rows are collected as the scan goes, and returned
+// once the whole tablet has been scanned.
+//
+// The rows are ranked in ascending order of their cells, or descending order
+// if 'descending', with the NULL cells last in both cases. The ties are
+// broken in scan order.
+//
+// This class is not thread-safe.
+class ScanTopN {
+ public:
+  // 'schema' is the schema of the scanned rows, and must outlive this object.
+  ScanTopN(const Schema* schema, int col_idx, bool descending, size_t limit);
+
+  // Collects the selected rows of 'block' ranking among the 'limit' best
+  // rows seen so far, evicting the rows they outrank.
+  void AddRows(const RowBlock& block);
+
+  // Copies the collected rows into 'block', best first, selecting them only.
+  // Marks the rows as returned.
+  //
+  // REQUIRES: 'block' has the schema passed to the constructor and a
+  // capacity of at least size() rows.
+  void TakeRows(RowBlock* block);
+
+  // The number of rows collected.
+  size_t size() const {
+    return rows_.size();
+  }
+
+  // Whether the rows were taken by TakeRows().
+  bool returned() const {
+    return returned_;
+  }
+
+ private:
+  struct Row {
+    // The row, laid out as a ContiguousRow allocated from 'arena_'.
+    uint8_t* data;
+    // The position of the row in the scan, to break the ties.
+    int64_t seq;
+  };
+
+  // Whether 'a' ranks before 'b'.
+  bool Better(const Row& a, const Row& b) const;
+
+  // Copies the cells of the row pointed to by 'src' into a new row allocated
+  // from 'arena'. 'src' is either a RowBlockRow or a ContiguousRow.
+  template<class RowType>
+  uint8_t* CopyToArena(const RowType& src, Arena* arena) const;
+
+  // Copies the collected rows into a new arena, releasing the memory of the
+  // evicted ones.
+  void Compact();
+
+  const Schema* const schema_;
+  const int col_idx_;
+  const bool descending_;
+  const size_t limit_;
+
+  // The collected rows, as a heap with the worst row on top.
+  std::vector<Row> rows_;
+  std::unique_ptr<Arena> arena_;
+  int64_t next_seq_ = 0;
+  // The number of rows evicted since the last compaction.
+  size_t num_evicted_ = 0;
+  bool returned_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanTopN);
+};
+
+} // namespace tserver
+} // namespace kudu
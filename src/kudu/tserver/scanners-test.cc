@@ -16,7 +16,9 @@
 // under the License.
 #include "kudu/tserver/scanners.h"
 
+#include <atomic>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <gflags/gflags_declare.h>
@@ -30,8 +32,11 @@
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_int32(scan_executor_batch_num_threads);
+DECLARE_int32(scan_executor_interactive_time_budget_ms);
 DECLARE_int32(scanner_ttl_ms);
 
 namespace kudu {
@@ -98,5 +103,135 @@ TEST(ScannerTest, TestExpire) {
   ASSERT_EQ(s2->id(), active_scanners[0]->id());
 }
 
+// A scanner accessed since it was queued for expiry is requeued, and expires
+// only once it's been idle for the TTL.
+TEST(ScannerTest, TestExpireRequeuesAccessedScanners) {
+  scoped_refptr<TabletReplica> null_replica(nullptr);
+  FLAGS_scanner_ttl_ms = 100;
+  MetricRegistry registry;
+  ScannerManager mgr(METRIC_ENTITY_server.Instantiate(&registry, "test"));
+  SharedScanner scanner;
+  mgr.NewScanner(null_replica, RemoteUser(), RowFormatFlags::NO_FLAGS, &scanner);
+  for (int i = 0; i < 3; i++) {
+    SleepFor(MonoDelta::FromMilliseconds(60));
+    {
+      auto access = scanner->LockForAccess();
+    }
+    mgr.RemoveExpiredScanners();
+    ASSERT_EQ(1, mgr.CountActiveScanners());
+  }
+  ASSERT_EQ(0, mgr.metrics_->scanners_expired->value());
+
+  SleepFor(MonoDelta::FromMilliseconds(200));
+  mgr.RemoveExpiredScanners();
+  ASSERT_EQ(0, mgr.CountActiveScanners());
+  ASSERT_EQ(1, mgr.metrics_->scanners_expired->value());
+
+  // Unregistering a scanner removes it from the expiry queue too.
+  mgr.NewScanner(null_replica, RemoteUser(), RowFormatFlags::NO_FLAGS, &scanner);
+  ASSERT_TRUE(mgr.UnregisterScanner(scanner->id()));
+  SleepFor(MonoDelta::FromMilliseconds(200));
+  mgr.RemoveExpiredScanners();
+  ASSERT_EQ(1, mgr.metrics_->scanners_expired->value());
+}
+
+TEST(ScannersTest, TestRegisterCreatedScanner) {
+  scoped_refptr<TabletReplica> null_replica(nullptr);
+  ScannerManager mgr(nullptr);
+  ASSERT_EQ(0, mgr.num_stripes() & (mgr.num_stripes() - 1));
+
+  RemoteUser user;
+  user.SetUnauthenticated(kUsername);
+  SharedScanner scanner;
+  mgr.CreateScanner(null_replica, user, RowFormatFlags::NO_FLAGS, &scanner);
+  ASSERT_EQ(0, mgr.CountActiveScanners());
+  SharedScanner result;
+  TabletServerErrorPB::Code error_code;
+  ASSERT_TRUE(mgr.LookupScanner(scanner->id(), kUsername, &error_code, &result).IsNotFound());
+
+  // A scope which isn't cancelled retires the scanner without registering it.
+  {
+    ScopedUnregisterScanner unreg(&mgr, scanner, /*registered=*/false);
+  }
+  ASSERT_EQ(0, mgr.CountActiveScanners());
+
+  // Cancelling the scope registers the scanner.
+  {
+    ScopedUnregisterScanner unreg(&mgr, scanner, /*registered=*/false);
+    unreg.Cancel();
+  }
+  ASSERT_EQ(1, mgr.CountActiveScanners());
+  ASSERT_OK(mgr.LookupScanner(scanner->id(), kUsername, &error_code, &result));
+  ASSERT_EQ(scanner.get(), result.get());
+  ASSERT_TRUE(mgr.UnregisterScanner(scanner->id()));
+  ASSERT_EQ(0, mgr.CountActiveScanners());
+}
+
+// The scanners move to the batch priority class once they've taken more than
+// the interactive time budget, and the classes without threads run their
+// tasks on the calling thread.
+TEST(ScannersTest, TestScanExecutor) {
+  FLAGS_scan_executor_interactive_time_budget_ms = 100;
+  FLAGS_scan_executor_batch_num_threads = 0;
+  scoped_refptr<TabletReplica> null_replica(nullptr);
+  MetricRegistry registry;
+  ScannerManager mgr(METRIC_ENTITY_server.Instantiate(&registry, "test"));
+  ASSERT_OK(mgr.StartCollectAndRemovalThread());
+  SharedScanner scanner;
+  mgr.NewScanner(null_replica, RemoteUser(), RowFormatFlags::NO_FLAGS, &scanner);
+  ASSERT_EQ(ScannerManager::ScanPriority::INTERACTIVE, ScannerManager::ScanPriorityOf(*scanner));
+  CpuTimes elapsed;
+  elapsed.wall = 200 * 1000000LL;
+  scanner->AddTimings(elapsed);
+  ASSERT_EQ(ScannerManager::ScanPriority::BATCH, ScannerManager::ScanPriorityOf(*scanner));
+
+  const auto caller = std::this_thread::get_id();
+  std::atomic<int> interactive_inline(0);
+  std::atomic<int> batch_inline(0);
+  for (int i = 0; i < 10; i++) {
+    mgr.RunScanTask(ScannerManager::ScanPriority::INTERACTIVE, [&]() {
+      interactive_inline += std::this_thread::get_id() == caller;
+    });
+    mgr.RunScanTask(ScannerManager::ScanPriority::BATCH, [&]() {
+      batch_inline += std::this_thread::get_id() == caller;
+    });
+  }
+  mgr.WaitForScanTasks();
+  ASSERT_EQ(0, interactive_inline);
+  ASSERT_EQ(10, batch_inline);
+}
+
+TEST(ScannerTest, TestAdaptiveBatchSizer) {
+  constexpr size_t kMin = AdaptiveBatchSizer::kMinBatchSizeBytes;
+  constexpr size_t kMax = 8 * kMin;
+  const auto kFillTime = MonoDelta::FromMilliseconds(100);
+  AdaptiveBatchSizer sizer;
+  MonoTime now = MonoTime::Now();
+  ASSERT_EQ(kMin, sizer.NextBatchSizeBytes(now, kMax, true));
+
+  // The batches grow while the client comes back sooner than the server took
+  // to fill them, up to the maximum.
+  for (size_t expected : { 2 * kMin, 4 * kMin, 8 * kMin, 8 * kMin }) {
+    now += kFillTime;
+    sizer.BatchReturned(now, kFillTime, false);
+    now += MonoDelta::FromMilliseconds(1);
+    ASSERT_EQ(expected, sizer.NextBatchSizeBytes(now, kMax, true));
+  }
+
+  // They don't grow while not allowed to, or while the client is slower than
+  // the server.
+  sizer.BatchReturned(now, kFillTime, false);
+  ASSERT_EQ(8 * kMin, sizer.NextBatchSizeBytes(now, 16 * kMin, false));
+  sizer.BatchReturned(now, kFillTime, false);
+  now += MonoDelta::FromMilliseconds(200);
+  ASSERT_EQ(8 * kMin, sizer.NextBatchSizeBytes(now, 16 * kMin, true));
+
+  // They shrink when running out of the time budget, down to the minimum.
+  for (size_t expected : { 4 * kMin, 2 * kMin, kMin, kMin }) {
+    sizer.BatchReturned(now, kFillTime, true);
+    ASSERT_EQ(expected, sizer.NextBatchSizeBytes(now, kMax, true));
+  }
+}
+
 } // namespace tserver
 } // namespace kudu
@@ -33,22 +33,28 @@
 #include "kudu/common/iterator.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
+#include "kudu/gutil/bits.h"
 #include "kudu/gutil/dynamic_annotations.h"
 #include "kudu/gutil/hash/string_hash.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/rpc/remote_user.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet_metrics.h"
+#include "kudu/tserver/scan_expressions.h"
+#include "kudu/tserver/scan_top_n.h"
 #include "kudu/tserver/scanner_metrics.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/mem_tracker.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/thread.h"
+#include "kudu/util/threadpool.h"
 
 DEFINE_int32(scanner_ttl_ms, 60000,
              "Number of milliseconds of inactivity allowed for a scanner "
@@ -60,6 +66,15 @@ DEFINE_int32(scanner_gc_check_interval_us, 5 * 1000L * 1000L, // 5 seconds
              "Number of microseconds in the interval at which we remove expired scanners");
 TAG_FLAG(scanner_gc_check_interval_us, hidden);
 
+DEFINE_int32(scanner_map_num_stripes, 0,
+             "Number of stripes of the map of the active scanners of the tablet server, "
+             "each with its own lock. Must be a power of two. If 0, the number of CPU "
+             "cores rounded up to a power of two is used, with a minimum of 32.");
+TAG_FLAG(scanner_map_num_stripes, advanced);
+DEFINE_validator(scanner_map_num_stripes, [](const char* /*flagname*/, int32_t value) {
+  return value == 0 || (value > 0 && value <= 4096 && (value & (value - 1)) == 0);
+});
+
 DEFINE_int32(completed_scan_history_count, 10,
              "Number of latest scans to keep history for. Determines how many historical "
              "latest scans will be shown on the tablet server's scans dashboard.");
@@ -83,7 +98,71 @@ DEFINE_int32(slow_scan_history_count, 10,
              "threshold for a slow scan is defined with --slow_scanner_threshold_ms.");
 TAG_FLAG(slow_scan_history_count, experimental);
 
+DEFINE_bool(scanner_prefetch_enabled, false,
+            "Whether scanners read ahead the rows to return to the next request of a scan, "
+            "once they've responded to the current one. This hides the latency of reading "
+            "the rows for sequential scans, at the cost of the memory used to hold them "
+            "until the next request arrives. See --scanner_prefetch_memory_limit_mb.");
+TAG_FLAG(scanner_prefetch_enabled, experimental);
+TAG_FLAG(scanner_prefetch_enabled, runtime);
+
+DEFINE_int64(scanner_prefetch_memory_limit_mb, 1024,
+             "Maximum amount of memory used to hold the rows read ahead by all the "
+             "scanners of the tablet server when --scanner_prefetch_enabled is set. "
+             "Once reached, scanners stop reading ahead until some of those rows are "
+             "returned to the clients.");
+TAG_FLAG(scanner_prefetch_memory_limit_mb, experimental);
+
+DEFINE_int64(scanner_response_memory_limit_mb, 0,
+             "Maximum amount of memory used by the scan responses being built and sent "
+             "by the tablet server. Once reached, the scan responses are cut short after "
+             "their first block of rows, and the adaptive batch sizes stop growing, "
+             "until some of those responses are sent. This bounds the memory used by "
+             "concurrent scans with large batches. If 0, the memory isn't limited.");
+TAG_FLAG(scanner_response_memory_limit_mb, experimental);
+TAG_FLAG(scanner_response_memory_limit_mb, runtime);
+
+DEFINE_int32(scanner_prefetch_num_threads, 4,
+             "Number of threads used to read ahead the rows of the scanners when "
+             "--scanner_prefetch_enabled is set.");
+TAG_FLAG(scanner_prefetch_num_threads, experimental);
+
+DEFINE_int32(scanner_parallel_scan_num_threads, 16,
+             "Number of threads shared by the scanners to materialize several "
+             "rowsets of a tablet concurrently when "
+             "--tablet_parallel_scan_max_rowsets is greater than 1.");
+TAG_FLAG(scanner_parallel_scan_num_threads, experimental);
+
+DEFINE_int32(scan_executor_interactive_num_threads, 16,
+             "Number of threads of the scan executor which read the rows of the requests "
+             "of the interactive scans, i.e. the new scans and the scans which took less "
+             "than --scan_executor_interactive_time_budget_ms so far. The RPC service "
+             "threads hand the scan requests off to the scan executor, so that heavy "
+             "scans can't occupy all of them and starve the other RPCs. If 0, the "
+             "service threads read the rows of these requests.");
+TAG_FLAG(scan_executor_interactive_num_threads, experimental);
+
+DEFINE_int32(scan_executor_batch_num_threads, 8,
+             "Number of threads of the scan executor which read the rows of the requests "
+             "of the batch scans, i.e. the scans which took more than "
+             "--scan_executor_interactive_time_budget_ms so far. If 0, the RPC service "
+             "threads read the rows of these requests.");
+TAG_FLAG(scan_executor_batch_num_threads, experimental);
+
+DEFINE_int32(scan_executor_interactive_time_budget_ms, 100,
+             "Time spent reading the rows of a scan after which its subsequent requests "
+             "are run by the batch threads of the scan executor rather than by its "
+             "interactive threads. See --scan_executor_batch_num_threads.");
+TAG_FLAG(scan_executor_interactive_time_budget_ms, experimental);
+TAG_FLAG(scan_executor_interactive_time_budget_ms, runtime);
+
+DEFINE_validator(scan_executor_interactive_num_threads,
+                 [](const char* /*flagname*/, int32_t value) { return value >= 0; });
+DEFINE_validator(scan_executor_batch_num_threads,
+                 [](const char* /*flagname*/, int32_t value) { return value >= 0; });
+
 DECLARE_int32(rpc_default_keepalive_time_ms);
+DECLARE_int32(scanner_batch_size_rows);
 
 METRIC_DEFINE_gauge_size(server, active_scanners,
                          "Active Scanners",
@@ -126,6 +205,13 @@ bool ValidateScannerAndRpcConnectionIdleTimes() {
 }
 
 GROUP_FLAG_VALIDATOR(idle_intervals, ValidateScannerAndRpcConnectionIdleTimes);
+
+size_t DetermineNumScannerMapStripes() {
+  if (FLAGS_scanner_map_num_stripes > 0) {
+    return FLAGS_scanner_map_num_stripes;
+  }
+  return std::max<size_t>(32, 1UL << Bits::Log2Ceiling(base::NumCPUs()));
+}
 } // anonymous namespace
 
 namespace kudu {
@@ -135,7 +221,11 @@ ScannerManager::ScannerManager(const scoped_refptr<MetricEntity>& metric_entity)
     : shutdown_(false),
       shutdown_cv_(&shutdown_lock_),
       completed_scans_offset_(0),
-      slow_scans_offset_(0) {
+      slow_scans_offset_(0),
+      prefetch_mem_tracker_(MemTracker::CreateTracker(
+          FLAGS_scanner_prefetch_memory_limit_mb * 1024 * 1024, "scanner-prefetch")),
+      response_mem_tracker_(MemTracker::CreateTracker(-1, "scanner-responses")),
+      buffer_pool_(std::make_shared<ScanBufferPool>(metric_entity)) {
   if (metric_entity) {
     metrics_.reset(new ScannerMetrics(metric_entity));
     METRIC_active_scanners.InstantiateFunctionGauge(
@@ -145,7 +235,9 @@ ScannerManager::ScannerManager(const scoped_refptr<MetricEntity>& metric_entity)
         metric_entity, [this]() { return this->CountSlowScans(); })
         ->AutoDetach(&metric_detacher_);
   }
-  for (size_t i = 0; i < kNumScannerMapStripes; i++) {
+  const size_t num_stripes = DetermineNumScannerMapStripes();
+  DCHECK_EQ(0, num_stripes & (num_stripes - 1));
+  for (size_t i = 0; i < num_stripes; i++) {
     scanner_maps_.push_back(new ScannerMapStripe());
   }
 
@@ -167,16 +259,86 @@ ScannerManager::~ScannerManager() {
   if (removal_thread_.get() != nullptr) {
     CHECK_OK(ThreadJoiner(removal_thread_.get()).Join());
   }
+  if (prefetch_pool_) {
+    prefetch_pool_->Shutdown();
+  }
+  if (parallel_scan_pool_) {
+    parallel_scan_pool_->Shutdown();
+  }
+  for (auto* pool : { interactive_scan_pool_.get(), batch_scan_pool_.get() }) {
+    if (pool) {
+      pool->Shutdown();
+    }
+  }
+  // The scanners' iterators must release their parallel scan pool tokens
+  // before the pool is destroyed.
   STLDeleteElements(&scanner_maps_);
 }
 
 Status ScannerManager::StartCollectAndRemovalThread() {
+  RETURN_NOT_OK(ThreadPoolBuilder("scanner-prefetch")
+                .set_max_threads(FLAGS_scanner_prefetch_num_threads)
+                .Build(&prefetch_pool_));
+  RETURN_NOT_OK(ThreadPoolBuilder("scanner-parallel-scan")
+                .set_max_threads(FLAGS_scanner_parallel_scan_num_threads)
+                .Build(&parallel_scan_pool_));
+  if (FLAGS_scan_executor_interactive_num_threads > 0) {
+    RETURN_NOT_OK(ThreadPoolBuilder("scan-interactive")
+                  .set_max_threads(FLAGS_scan_executor_interactive_num_threads)
+                  .Build(&interactive_scan_pool_));
+  }
+  if (FLAGS_scan_executor_batch_num_threads > 0) {
+    RETURN_NOT_OK(ThreadPoolBuilder("scan-batch")
+                  .set_max_threads(FLAGS_scan_executor_batch_num_threads)
+                  .Build(&batch_scan_pool_));
+  }
   RETURN_NOT_OK(Thread::Create("scanners", "collect_and_removal_thread",
                                [this]() { this->RunCollectAndRemovalThread(); },
                                &removal_thread_));
   return Status::OK();
 }
 
+void ScannerManager::PrefetchAsync(SharedScanner scanner, size_t batch_size_bytes) {
+  if (!FLAGS_scanner_prefetch_enabled || !prefetch_pool_) {
+    return;
+  }
+  // The submitting RPC still holds the scanner's access lock: the task waits
+  // for it to respond. If the client's next request gets the lock first, the
+  // rows are read ahead for the request after it.
+  Status s = prefetch_pool_->Submit([this, scanner = std::move(scanner), batch_size_bytes]() {
+    auto l = scanner->LockForAccess();
+    scanner->PrefetchBlocks(batch_size_bytes, prefetch_mem_tracker_);
+  });
+  WARN_NOT_OK(s, "unable to submit scanner prefetch task");
+}
+
+ScannerManager::ScanPriority ScannerManager::ScanPriorityOf(const Scanner& scanner) {
+  const int64_t budget_ns = FLAGS_scan_executor_interactive_time_budget_ms * 1000000LL;
+  return scanner.cpu_times().wall > budget_ns ? ScanPriority::BATCH : ScanPriority::INTERACTIVE;
+}
+
+void ScannerManager::RunScanTask(ScanPriority priority, std::function<void()> task) {
+  ThreadPool* pool = priority == ScanPriority::INTERACTIVE ? interactive_scan_pool_.get()
+                                                           : batch_scan_pool_.get();
+  if (pool && pool->Submit(task).ok()) {
+    return;
+  }
+  task();
+}
+
+void ScannerManager::WaitForScanTasks() {
+  for (auto* pool : { interactive_scan_pool_.get(), batch_scan_pool_.get() }) {
+    if (pool) {
+      pool->Wait();
+    }
+  }
+}
+
+bool ScannerManager::ResponseMemoryLimitExceeded() const {
+  const int64_t limit_mb = FLAGS_scanner_response_memory_limit_mb;
+  return limit_mb > 0 && response_mem_tracker_->consumption() > limit_mb * 1024 * 1024;
+}
+
 void ScannerManager::RunCollectAndRemovalThread() {
   while (true) {
     // Loop until we are shutdown.
@@ -198,7 +360,9 @@ void ScannerManager::RunCollectAndRemovalThread() {
 }
 
 ScannerManager::ScannerMapStripe& ScannerManager::GetStripeByScannerId(const string& scanner_id) {
-  size_t slot = HashStringThoroughly(scanner_id.data(), scanner_id.size()) % kNumScannerMapStripes;
+  // The number of stripes is a power of two.
+  size_t slot = HashStringThoroughly(scanner_id.data(), scanner_id.size()) &
+      (scanner_maps_.size() - 1);
   return *scanner_maps_[slot];
 }
 
@@ -209,19 +373,43 @@ void ScannerManager::NewScanner(const scoped_refptr<TabletReplica>& tablet_repli
   // Keep trying to generate a unique ID until we get one.
   bool success = false;
   while (!success) {
-    string id = oid_generator_.Next();
-    scanner->reset(new Scanner(id,
-                               tablet_replica,
-                               remote_user,
-                               metrics_.get(),
-                               row_format_flags));
-
-    ScannerMapStripe& stripe = GetStripeByScannerId(id);
+    CreateScanner(tablet_replica, remote_user, row_format_flags, scanner);
+    ScannerMapStripe& stripe = GetStripeByScannerId((*scanner)->id());
     std::lock_guard<RWMutex> l(stripe.lock_);
-    success = InsertIfNotPresent(&stripe.scanners_by_id_, id, *scanner);
+    success = InsertScannerUnlocked(&stripe, *scanner);
   }
 }
 
+void ScannerManager::CreateScanner(const scoped_refptr<TabletReplica>& tablet_replica,
+                                   const RemoteUser& remote_user,
+                                   uint64_t row_format_flags,
+                                   SharedScanner* scanner) {
+  scanner->reset(new Scanner(oid_generator_.Next(),
+                             tablet_replica,
+                             remote_user,
+                             metrics_.get(),
+                             row_format_flags));
+}
+
+void ScannerManager::RegisterScanner(const SharedScanner& scanner) {
+  ScannerMapStripe& stripe = GetStripeByScannerId(scanner->id());
+  std::lock_guard<RWMutex> l(stripe.lock_);
+  // The IDs are random UUIDs: unlike NewScanner(), a collision isn't worth
+  // handling here, as the ID of the scanner may already have been used.
+  CHECK(InsertScannerUnlocked(&stripe, scanner)) << "duplicate scanner ID " << scanner->id();
+}
+
+bool ScannerManager::InsertScannerUnlocked(ScannerMapStripe* stripe,
+                                           const SharedScanner& scanner) {
+  auto inserted = stripe->scanners_by_id_.emplace(scanner->id(), ScannerEntry{ scanner, {} });
+  if (!inserted.second) {
+    return false;
+  }
+  inserted.first->second.expiry_it =
+      stripe->scanners_by_access_.emplace(scanner->start_time(), scanner.get());
+  return true;
+}
+
 Status ScannerManager::LookupScanner(const string& scanner_id,
                                      const string& username,
                                      TabletServerErrorPB::Code* error_code,
@@ -229,12 +417,13 @@ Status ScannerManager::LookupScanner(const string& scanner_id,
   SharedScanner ret;
   ScannerMapStripe& stripe = GetStripeByScannerId(scanner_id);
   shared_lock<RWMutex> l(stripe.lock_);
-  bool found_scanner = FindCopy(stripe.scanners_by_id_, scanner_id, &ret);
-  if (!found_scanner) {
+  const ScannerEntry* entry = FindOrNull(stripe.scanners_by_id_, scanner_id);
+  if (!entry) {
     *error_code = TabletServerErrorPB::SCANNER_EXPIRED;
     return Status::NotFound(Substitute("Scanner $0 not found (it may have expired)",
                                        scanner_id));
   }
+  ret = entry->scanner;
   if (username != ret->remote_user().username()) {
     *error_code = TabletServerErrorPB::NOT_AUTHORIZED;
     return Status::NotAuthorized(Substitute("User $0 doesn't own scanner $1",
@@ -245,7 +434,7 @@ Status ScannerManager::LookupScanner(const string& scanner_id,
 }
 
 bool ScannerManager::UnregisterScanner(const string& scanner_id) {
-  SharedScanDescriptor descriptor;
+  SharedScanner scanner;
   ScannerMapStripe& stripe = GetStripeByScannerId(scanner_id);
   {
     std::lock_guard<RWMutex> l(stripe.lock_);
@@ -253,32 +442,39 @@ bool ScannerManager::UnregisterScanner(const string& scanner_id) {
     if (it == stripe.scanners_by_id_.end()) {
       return false;
     }
-
-    bool is_initted = it->second->is_initted();
-    if (is_initted) {
-      descriptor = it->second->Descriptor();
-      descriptor->state = it->second->iter()->HasNext() ? ScanState::kFailed : ScanState::kComplete;
-    }
+    scanner = std::move(it->second.scanner);
+    stripe.scanners_by_access_.erase(it->second.expiry_it);
     stripe.scanners_by_id_.erase(it);
-    if (!is_initted) {
-      return true;
-    }
   }
+  // The descriptor is built outside of the stripe's lock, which the other
+  // scanners of the stripe need to register and unregister.
+  RetireScanner(scanner);
+  return true;
+}
 
+void ScannerManager::RetireScanner(const SharedScanner& scanner) {
+  if (!scanner->is_initted()) {
+    return;
+  }
+  const bool is_slow = scanner->start_time() +
+      MonoDelta::FromMilliseconds(FLAGS_slow_scanner_threshold_ms) < MonoTime::Now();
+  if (FLAGS_completed_scan_history_count <= 0 &&
+      (!is_slow || FLAGS_slow_scan_history_count <= 0)) {
+    // Nothing would keep the descriptor.
+    return;
+  }
+
+  SharedScanDescriptor descriptor = scanner->Descriptor();
+  descriptor->state = scanner->iter()->HasNext() ? ScanState::kFailed : ScanState::kComplete;
   {
-    std::lock_guard<percpu_rwlock> l(completed_scans_lock_);
+    std::lock_guard l(completed_scans_lock_);
     RecordCompletedScanUnlocked(descriptor);
   }
 
-  {
-    const MonoTime start_time = descriptor->start_time;
-    if (start_time + MonoDelta::FromMilliseconds(FLAGS_slow_scanner_threshold_ms)
-        < MonoTime::Now()) {
-      std::lock_guard<percpu_rwlock> l(slow_scans_lock_);
-      RecordSlowScanUnlocked(descriptor);
-    }
+  if (is_slow) {
+    std::lock_guard<percpu_rwlock> l(slow_scans_lock_);
+    RecordSlowScanUnlocked(descriptor);
   }
-  return true;
 }
 
 size_t ScannerManager::CountActiveScanners() const {
@@ -297,7 +493,7 @@ size_t ScannerManager::CountSlowScans() const {
   for (const auto* stripe : scanner_maps_) {
     shared_lock<RWMutex> l(stripe->lock_);
     for (const auto& it : stripe->scanners_by_id_) {
-      const SharedScanner& scanner = it.second;
+      const SharedScanner& scanner = it.second.scanner;
       const MonoTime start_time = scanner->start_time();
       if (start_time + slow_threshold >= now) {
         continue;
@@ -313,7 +509,7 @@ void ScannerManager::ListScanners(std::vector<SharedScanner>* scanners) const {
   for (const ScannerMapStripe* stripe : scanner_maps_) {
     shared_lock<RWMutex> l(stripe->lock_);
     for (const auto& se : stripe->scanners_by_id_) {
-      scanners->push_back(se.second);
+      scanners->push_back(se.second.scanner);
     }
   }
 }
@@ -323,8 +519,8 @@ vector<SharedScanDescriptor> ScannerManager::ListScans() const {
   for (const ScannerMapStripe* stripe : scanner_maps_) {
     shared_lock<RWMutex> l(stripe->lock_);
     for (const auto& se : stripe->scanners_by_id_) {
-      if (se.second->is_initted()) {
-        SharedScanDescriptor desc = se.second->Descriptor();
+      if (se.second.scanner->is_initted()) {
+        SharedScanDescriptor desc = se.second.scanner->Descriptor();
         desc->state = ScanState::kActive;
         EmplaceOrDie(&scans, se.first, std::move(desc));
       }
@@ -332,7 +528,7 @@ vector<SharedScanDescriptor> ScannerManager::ListScans() const {
   }
 
   {
-    shared_lock<rw_spinlock> l(completed_scans_lock_.get_lock());
+    std::lock_guard l(completed_scans_lock_);
     // A scanner in 'scans' may have completed between the above loop and here.
     // As we'd rather have the finalized descriptor of the completed scan,
     // update over the old descriptor in this case.
@@ -390,7 +586,7 @@ void ScannerManager::CollectSlowScanners() {
   for (ScannerMapStripe* stripe : scanner_maps_) {
     std::lock_guard<RWMutex> l(stripe->lock_);
     for (auto it = stripe->scanners_by_id_.begin(); it != stripe->scanners_by_id_.end(); ++it) {
-      const SharedScanner& scanner = it->second;
+      const SharedScanner& scanner = it->second.scanner;
       if (!scanner->is_initted()) {
         // Ignore uninitialized scans.
         continue;
@@ -428,11 +624,18 @@ void ScannerManager::RemoveExpiredScanners() {
   vector<SharedScanDescriptor> descriptors;
   for (ScannerMapStripe* stripe : scanner_maps_) {
     std::lock_guard<RWMutex> l(stripe->lock_);
-    for (auto it = stripe->scanners_by_id_.begin(); it != stripe->scanners_by_id_.end();) {
-      const SharedScanner& scanner = it->second;
+    ExpiryQueue& queue = stripe->scanners_by_access_;
+    // The scanners further in the queue were accessed no earlier than the
+    // one at its front: once it's within the TTL, so are they.
+    while (!queue.empty() && now - queue.begin()->first > scanner_ttl) {
+      auto it = stripe->scanners_by_id_.find(queue.begin()->second->id());
+      DCHECK(it != stripe->scanners_by_id_.end());
+      queue.erase(queue.begin());
+      const SharedScanner& scanner = it->second.scanner;
       MonoDelta idle_time = scanner->TimeSinceLastAccess(now);
       if (idle_time <= scanner_ttl) {
-        ++it;
+        // The scanner has been accessed since it was queued.
+        it->second.expiry_it = queue.emplace(now - idle_time, scanner.get());
         continue;
       }
 
@@ -447,14 +650,14 @@ void ScannerManager::RemoveExpiredScanners() {
       if (scanner->is_initted()) {
         descriptors.emplace_back(scanner->Descriptor());
       }
-      it = stripe->scanners_by_id_.erase(it);
+      stripe->scanners_by_id_.erase(it);
       if (metrics_) {
         metrics_->scanners_expired->Increment();
       }
     }
   }
 
-  std::lock_guard<percpu_rwlock> l(completed_scans_lock_);
+  std::lock_guard l(completed_scans_lock_);
   for (auto& descriptor : descriptors) {
     descriptor->last_access_time = now;
     descriptor->state = ScanState::kExpired;
@@ -510,6 +713,21 @@ Scanner::Scanner(string id, const scoped_refptr<TabletReplica>& tablet_replica,
   }
 }
 
+void Scanner::set_top_n(unique_ptr<ScanTopN> top_n) {
+  lock_.AssertAcquired();
+  top_n_ = std::move(top_n);
+}
+
+void Scanner::set_expressions(unique_ptr<ScanExpressions> expressions) {
+  lock_.AssertAcquired();
+  expressions_ = std::move(expressions);
+}
+
+const Schema& Scanner::result_schema() const {
+  lock_.AssertAcquired();
+  return expressions_ ? expressions_->output_schema() : iter()->schema();
+}
+
 Scanner::~Scanner() {
   if (tablet_replica_) {
     auto tablet = tablet_replica_->shared_tablet();
@@ -522,6 +740,88 @@ Scanner::~Scanner() {
   }
 }
 
+void Scanner::PrefetchBlocks(size_t batch_size_bytes,
+                             const std::shared_ptr<MemTracker>& mem_tracker) {
+  lock_.AssertAcquired();
+  if (!is_initted()) {
+    return;
+  }
+  // The memory used by the blocks is only a rough estimate of the size of the
+  // response they'll make up, but it's good enough to bound the read-ahead.
+  size_t prefetched_bytes = 0;
+  while (prefetch_status_.ok() && prefetched_bytes < batch_size_bytes &&
+         !has_fulfilled_limit() && iter_->HasNext() && !mem_tracker->LimitExceeded()) {
+    auto prefetched = std::make_unique<PrefetchedBlock>(
+        &iter_->schema(), FLAGS_scanner_batch_size_rows, mem_tracker);
+    Status s = iter_->NextBlock(prefetched->block());
+    if (PREDICT_FALSE(!s.ok())) {
+      prefetch_status_ = s;
+      break;
+    }
+    if (prefetched->block()->nrows() == 0) {
+      continue;
+    }
+    prefetched->ConsumeMemory();
+    prefetched_bytes += iter_->schema().byte_size() * prefetched->block()->nrows();
+    prefetched_blocks_.emplace_back(std::move(prefetched));
+  }
+}
+
+Status Scanner::NextPrefetchedBlock(unique_ptr<PrefetchedBlock>* block) {
+  lock_.AssertAcquired();
+  DCHECK(HasPrefetchedBlocks());
+  if (prefetched_blocks_.empty()) {
+    return prefetch_status_;
+  }
+  *block = std::move(prefetched_blocks_.front());
+  prefetched_blocks_.pop_front();
+  return Status::OK();
+}
+
+PrefetchedBlock::PrefetchedBlock(const Schema* schema,
+                                 size_t nrows,
+                                 std::shared_ptr<MemTracker> mem_tracker)
+    : block_(schema, nrows, &memory_),
+      mem_tracker_(std::move(mem_tracker)),
+      consumption_(0) {
+}
+
+PrefetchedBlock::~PrefetchedBlock() {
+  mem_tracker_->Release(consumption_);
+}
+
+void PrefetchedBlock::ConsumeMemory() {
+  DCHECK_EQ(0, consumption_);
+  consumption_ = block_.schema()->byte_size() * block_.row_capacity() +
+      memory_.arena.memory_footprint();
+  mem_tracker_->Consume(consumption_);
+}
+
+AdaptiveBatchSizer::AdaptiveBatchSizer()
+    : batch_size_bytes_(kMinBatchSizeBytes),
+      last_budget_expired_(false) {
+}
+
+size_t AdaptiveBatchSizer::NextBatchSizeBytes(MonoTime now,
+                                              size_t max_batch_size_bytes,
+                                              bool allow_growth) {
+  if (allow_growth && last_returned_.Initialized() && !last_budget_expired_ &&
+      now - last_returned_ < last_server_time_) {
+    batch_size_bytes_ *= 2;
+  }
+  batch_size_bytes_ = std::min(batch_size_bytes_, max_batch_size_bytes);
+  return batch_size_bytes_;
+}
+
+void AdaptiveBatchSizer::BatchReturned(MonoTime now, MonoDelta server_time, bool budget_expired) {
+  if (budget_expired) {
+    batch_size_bytes_ = std::max(batch_size_bytes_ / 2, kMinBatchSizeBytes);
+  }
+  last_returned_ = now;
+  last_server_time_ = server_time;
+  last_budget_expired_ = budget_expired;
+}
+
 void Scanner::UpdateTabletMetrics(const CpuTimes& elapsed) {
   if (tablet_replica_) {
     auto tablet = tablet_replica_->shared_tablet();
@@ -530,6 +830,8 @@ void Scanner::UpdateTabletMetrics(const CpuTimes& elapsed) {
       tablet->metrics()->scan_duration_wall_time->Increment(elapsed.wall_millis());
       tablet->metrics()->scan_duration_system_time->Increment(elapsed.system_cpu_millis());
       tablet->metrics()->scan_duration_user_time->Increment(elapsed.user_cpu_millis());
+      tablet->metrics()->scanner_cpu_user_time->IncrementBy(elapsed.user / 1000);
+      tablet->metrics()->scanner_cpu_system_time->IncrementBy(elapsed.system / 1000);
     }
   }
 }
@@ -19,6 +19,9 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -27,15 +30,20 @@
 #include <vector>
 
 #include <glog/logging.h>
+#include <google/protobuf/repeated_field.h> // IWYU pragma: keep
 #include <gtest/gtest_prod.h>
 
 #include "kudu/common/iterator_stats.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/rowblock_memory.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/remote_user.h"
 #include "kudu/tablet/tablet_replica.h"
+#include "kudu/tserver/scan_bloom_filters.h"
+#include "kudu/tserver/scan_buffer_pool.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/condition_variable.h"
 #include "kudu/util/locks.h"
@@ -45,17 +53,21 @@
 #include "kudu/util/mutex.h"
 #include "kudu/util/oid_generator.h"
 #include "kudu/util/rw_mutex.h"
+#include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 
 namespace kudu {
 
+class MemTracker;
 class RowwiseIterator;
 class Schema;
-class Status;
 class Thread;
+class ThreadPool;
 
 namespace tserver {
 
+class ScanExpressions;
+class ScanTopN;
 class Scanner;
 
 enum class ScanState;
@@ -73,6 +85,12 @@ typedef scoped_refptr<ScanDescriptor> SharedScanDescriptor;
 //
 // Since scanners keep resources on the server, the manager periodically
 // removes any scanners which have not been accessed since a configurable TTL.
+//
+// The scanners are spread over stripes sized to the number of CPUs (see
+// --scanner_map_num_stripes), each with its own lock. Each stripe also
+// queues its scanners by the last access time it knows of, so that the
+// removal of the expired scanners only visits the ones which may have expired
+// rather than every registered scanner.
 class ScannerManager {
  public:
   explicit ScannerManager(const scoped_refptr<MetricEntity>& metric_entity);
@@ -89,6 +107,18 @@ class ScannerManager {
                   uint64_t row_format_flags,
                   SharedScanner* scanner);
 
+  // Like NewScanner(), but doesn't insert the scanner into the map: it can't
+  // be looked up until RegisterScanner() is called. This lets a scan which is
+  // answered by a single response skip the registration altogether, in which
+  // case RetireScanner() must be called once it's done.
+  void CreateScanner(const scoped_refptr<tablet::TabletReplica>& tablet_replica,
+                     const rpc::RemoteUser& remote_user,
+                     uint64_t row_format_flags,
+                     SharedScanner* scanner);
+
+  // Insert a scanner returned by CreateScanner() into the map.
+  void RegisterScanner(const SharedScanner& scanner);
+
   // Lookup the given scanner by its ID with the provided username, setting an
   // appropriate error code.
   // Returns NotFound if the scanner doesn't exist, or NotAuthorized if the
@@ -102,6 +132,15 @@ class ScannerManager {
   // Returns true if unregistered successfully.
   bool UnregisterScanner(const std::string& scanner_id);
 
+  // Add the scan of a scanner which isn't registered, or no longer is, to the
+  // completed scans, and to the slow scans if it took too long.
+  void RetireScanner(const SharedScanner& scanner);
+
+  // Return the number of stripes of the scanner map.
+  size_t num_stripes() const {
+    return scanner_maps_.size();
+  }
+
   // Return the number of scanners currently active.
   // Note this method will not return accurate value
   // if under concurrent modifications.
@@ -132,20 +171,79 @@ class ScannerManager {
   // Collect slow scanners whose scan times exceed the threshold.
   void CollectSlowScanners();
 
+  // If --scanner_prefetch_enabled is set, asynchronously read ahead up to
+  // about 'batch_size_bytes' of rows from 'scanner', to be returned by its
+  // next scan request. Does nothing if the prefetch pool isn't started.
+  void PrefetchAsync(SharedScanner scanner, size_t batch_size_bytes);
+
+  const std::shared_ptr<MemTracker>& prefetch_mem_tracker() const {
+    return prefetch_mem_tracker_;
+  }
+
+  // The tracker of the memory used by the scan responses being built and
+  // sent.
+  const std::shared_ptr<MemTracker>& response_mem_tracker() const {
+    return response_mem_tracker_;
+  }
+
+  // Whether the memory used by the scan responses is over
+  // --scanner_response_memory_limit_mb. The limit is checked against the
+  // tracker rather than enforced by it, so that it may change at runtime.
+  bool ResponseMemoryLimitExceeded() const;
+
+  // The pool on which unordered scans may materialize several rowsets of a
+  // tablet concurrently, or nullptr if it isn't started.
+  // See --tablet_parallel_scan_max_rowsets.
+  ThreadPool* parallel_scan_pool() const {
+    return parallel_scan_pool_.get();
+  }
+
+  // The pool of the row blocks and buffers reused by the scan requests.
+  ScanBufferPool* buffer_pool() const {
+    return buffer_pool_.get();
+  }
+
+  // The priority classes of the scan executor, each run by its own threads.
+  enum class ScanPriority {
+    // The new scans, and the scans which took little time so far.
+    INTERACTIVE,
+    // The scans which took more than --scan_executor_interactive_time_budget_ms.
+    BATCH,
+  };
+
+  // Returns the priority class of the next request of 'scanner'.
+  static ScanPriority ScanPriorityOf(const Scanner& scanner);
+
+  // Runs 'task', which reads the rows of a scan request and responds to it,
+  // on the scan executor threads of 'priority'. Runs 'task' on the calling
+  // thread if there are no such threads, or if they can't take the task.
+  void RunScanTask(ScanPriority priority, std::function<void()> task);
+
+  // Waits for the tasks submitted to the scan executor to complete.
+  void WaitForScanTasks();
+
  private:
   FRIEND_TEST(ScannerTest, TestExpire);
+  FRIEND_TEST(ScannerTest, TestExpireRequeuesAccessedScanners);
 
-  enum {
-    kNumScannerMapStripes = 32
+  // Scanners ordered by the last access time known to the stripe. A scanner
+  // accessed since it was queued is requeued when it reaches the front.
+  typedef std::multimap<MonoTime, Scanner*> ExpiryQueue;
+
+  struct ScannerEntry {
+    SharedScanner scanner;
+    ExpiryQueue::iterator expiry_it;
   };
 
-  typedef std::unordered_map<std::string, SharedScanner> ScannerMap;
+  typedef std::unordered_map<std::string, ScannerEntry> ScannerMap;
 
   struct ScannerMapStripe {
-    // Lock protecting the scanner map.
+    // Lock protecting the scanner map and the expiry queue.
     mutable RWMutex lock_;
     // Map of the currently active scanners.
     ScannerMap scanners_by_id_;
+    // The same scanners, by last access time.
+    ExpiryQueue scanners_by_access_;
   };
 
   // Periodically call CollectSlowScanners() and RemoveExpiredScanners().
@@ -153,6 +251,10 @@ class ScannerManager {
 
   ScannerMapStripe& GetStripeByScannerId(const std::string& scanner_id);
 
+  // Inserts the scanner into the stripe's map and expiry queue, unless a
+  // scanner with the same ID is already there. The stripe's lock must be held.
+  static bool InsertScannerUnlocked(ScannerMapStripe* stripe, const SharedScanner& scanner);
+
   // Adds the scan descriptor to the completed scans FIFO.
   void RecordCompletedScanUnlocked(const SharedScanDescriptor& descriptor);
 
@@ -177,8 +279,10 @@ class ScannerManager {
 
   std::vector<ScannerMapStripe*> scanner_maps_;
 
-  // completed_scans_ is a FIFO ring buffer of completed scans.
-  mutable percpu_rwlock completed_scans_lock_;
+  // completed_scans_ is a FIFO ring buffer of completed scans. It's added to
+  // by every scan but seldom read, hence a plain spinlock rather than a
+  // reader-biased one.
+  mutable simple_spinlock completed_scans_lock_;
   std::vector<SharedScanDescriptor> completed_scans_;
   size_t completed_scans_offset_;
 
@@ -193,6 +297,25 @@ class ScannerManager {
   // Thread to remove expired scanners.
   scoped_refptr<kudu::Thread> removal_thread_;
 
+  // Pool used to read ahead the rows of the scanners, and the tracker of the
+  // memory used by the rows read ahead.
+  std::unique_ptr<ThreadPool> prefetch_pool_;
+  std::shared_ptr<MemTracker> prefetch_mem_tracker_;
+
+  std::shared_ptr<MemTracker> response_mem_tracker_;
+
+  // Pool used by the tablet iterators to scan several rowsets concurrently.
+  std::unique_ptr<ThreadPool> parallel_scan_pool_;
+
+  // The pools of the scan executor which read the rows of the scan requests
+  // of each priority class, or nullptr if the class has no threads.
+  std::unique_ptr<ThreadPool> interactive_scan_pool_;
+  std::unique_ptr<ThreadPool> batch_scan_pool_;
+
+  // Shared with the sidecars of the scan responses, which return their
+  // buffers to it once sent.
+  std::shared_ptr<ScanBufferPool> buffer_pool_;
+
   FunctionGaugeDetacher metric_detacher_;
 
   DISALLOW_COPY_AND_ASSIGN(ScannerManager);
@@ -204,23 +327,106 @@ class ScopedUnregisterScanner {
   ScopedUnregisterScanner(ScannerManager* mgr, std::string id)
       : mgr_(mgr), id_(std::move(id)), cancelled_(false) {}
 
+  // If 'registered' is false, 'scanner' was returned by
+  // ScannerManager::CreateScanner() and isn't registered yet: it's retired
+  // upon scope exit, and registered if the scope is cancelled.
+  ScopedUnregisterScanner(ScannerManager* mgr, SharedScanner scanner, bool registered)
+      : mgr_(mgr),
+        id_(scanner->id()),
+        unregistered_scanner_(registered ? nullptr : std::move(scanner)),
+        cancelled_(false) {}
+
   ~ScopedUnregisterScanner() {
-    if (!cancelled_) {
+    if (cancelled_) {
+      return;
+    }
+    if (unregistered_scanner_) {
+      mgr_->RetireScanner(unregistered_scanner_);
+    } else {
       mgr_->UnregisterScanner(id_);
     }
   }
 
-  // Do not unregister the scanner when the scope is exited.
+  // Do not unregister the scanner when the scope is exited, registering it
+  // first if it isn't already, so that further requests may find it.
   void Cancel() {
+    if (!cancelled_ && unregistered_scanner_) {
+      mgr_->RegisterScanner(unregistered_scanner_);
+    }
+    cancelled_ = true;
+  }
+
+  // Leave the scanner as it is when the scope is exited, handing it over to
+  // another ScopedUnregisterScanner.
+  void Release() {
     cancelled_ = true;
   }
 
  private:
   ScannerManager* const mgr_;
   const std::string id_;
+  const SharedScanner unregistered_scanner_;
   bool cancelled_;
 };
 
+// A block of rows read from a scanner's iterator ahead of the scan request
+// which returns them. Its memory is accounted to the given MemTracker.
+class PrefetchedBlock {
+ public:
+  PrefetchedBlock(const Schema* schema, size_t nrows, std::shared_ptr<MemTracker> mem_tracker);
+  ~PrefetchedBlock();
+
+  RowBlock* block() { return &block_; }
+
+  // Accounts the memory used by the block to the MemTracker. Must be called
+  // once the block is filled.
+  void ConsumeMemory();
+
+ private:
+  RowBlockMemory memory_;
+  RowBlock block_;
+  std::shared_ptr<MemTracker> mem_tracker_;
+  int64_t consumption_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrefetchedBlock);
+};
+
+// Sizes the batches of a scanner whose client doesn't ask for a batch size,
+// with --scanner_adaptive_batch_size.
+//
+// The first batch is small, to return the first rows early. The batches then
+// double while the client asks for the next one sooner than the server took
+// to fill the previous one, i.e. while the scan is bound by the server and
+// larger batches amortize the round trips better. They halve when filling one
+// runs out of the time budget of a scan request.
+class AdaptiveBatchSizer {
+ public:
+  // The size of the first batch, and the minimum size of the batches.
+  static constexpr size_t kMinBatchSizeBytes = 64 * 1024;
+
+  AdaptiveBatchSizer();
+
+  // Returns the size of the batch to return at 'now', capped at
+  // 'max_batch_size_bytes'. The batches don't grow if 'allow_growth' is false,
+  // e.g. under memory pressure.
+  size_t NextBatchSizeBytes(MonoTime now, size_t max_batch_size_bytes, bool allow_growth);
+
+  // Records that the batch returned at 'now' took 'server_time' to fill, and
+  // whether filling it ran out of the time budget.
+  void BatchReturned(MonoTime now, MonoDelta server_time, bool budget_expired);
+
+ private:
+  size_t batch_size_bytes_;
+
+  // When the previous batch was returned, how long it took to fill, and
+  // whether it ran out of the time budget.
+  MonoTime last_returned_;
+  MonoDelta last_server_time_;
+  bool last_budget_expired_;
+
+  DISALLOW_COPY_AND_ASSIGN(AdaptiveBatchSizer);
+};
+
 // An open scanner on the server side.
 //
 // NOTE: unless otherwise specified, all methods of this class require that the
@@ -369,6 +575,50 @@ class Scanner {
     return row_format_flags_;
   }
 
+  // The aggregates to evaluate on each call of this scanner, if any.
+  const google::protobuf::RepeatedPtrField<ColumnAggregatePB>& aggregates() const {
+    lock_.AssertAcquired();
+    return aggregates_;
+  }
+
+  void set_aggregates(const google::protobuf::RepeatedPtrField<ColumnAggregatePB>& aggregates) {
+    lock_.AssertAcquired();
+    aggregates_ = aggregates;
+  }
+
+  // The best rows collected by this scanner, if it's a top-N scan.
+  ScanTopN* top_n() const {
+    lock_.AssertAcquired();
+    return top_n_.get();
+  }
+
+  void set_top_n(std::unique_ptr<ScanTopN> top_n);
+
+  // The filter and the computed columns of this scanner, if any.
+  ScanExpressions* expressions() const {
+    lock_.AssertAcquired();
+    return expressions_.get();
+  }
+
+  void set_expressions(std::unique_ptr<ScanExpressions> expressions);
+
+  // The schema of the rows returned by this scanner: the schema of iter(),
+  // followed by the computed columns, if any.
+  const Schema& result_schema() const;
+
+  // Keeps 'filters', shared bloom filters used by the predicates of the scan,
+  // for the lifetime of this scanner.
+  void AddBloomFilters(std::shared_ptr<const ScanBloomFilterRegistry::Filters> filters) {
+    lock_.AssertAcquired();
+    bloom_filters_.emplace_back(std::move(filters));
+  }
+
+  // The sizer of the batches of this scanner, with --scanner_adaptive_batch_size.
+  AdaptiveBatchSizer* batch_sizer() {
+    lock_.AssertAcquired();
+    return &batch_sizer_;
+  }
+
   void add_num_rows_returned(int64_t num_rows_added) {
     lock_.AssertAcquired();
     num_rows_returned_ += num_rows_added;
@@ -385,6 +635,24 @@ class Scanner {
     return spec_ && spec_->has_limit() && num_rows_returned_ >= spec_->limit();
   }
 
+  // Read up to about 'batch_size_bytes' of rows ahead from the iterator,
+  // tracking their memory in 'mem_tracker'. Stops early once 'mem_tracker'
+  // is over its limit. An error reading from the iterator is returned by
+  // NextPrefetchedBlock() once the blocks read before it have been returned.
+  void PrefetchBlocks(size_t batch_size_bytes, const std::shared_ptr<MemTracker>& mem_tracker);
+
+  // Whether NextPrefetchedBlock() has a block (or an error) to return.
+  bool HasPrefetchedBlocks() const {
+    lock_.AssertAcquired();
+    return !prefetched_blocks_.empty() || !prefetch_status_.ok();
+  }
+
+  // Returns the oldest block read ahead by PrefetchBlocks(), in order with
+  // the rows read from the iterator.
+  //
+  // REQUIRES: HasPrefetchedBlocks()
+  Status NextPrefetchedBlock(std::unique_ptr<PrefetchedBlock>* block);
+
   // Return a descriptor of the current state of this scan.
   // Does not require the AccessLock.
   //
@@ -426,6 +694,22 @@ class Scanner {
   // The row format flags the client passed, if any.
   const uint64_t row_format_flags_;
 
+  // The aggregates the client asked to evaluate, if any.
+  // Protected by lock_.
+  google::protobuf::RepeatedPtrField<ColumnAggregatePB> aggregates_;
+
+  // The filter and the computed columns of the scan, if any. Outlives
+  // 'top_n_', which refers to its output schema.
+  // Protected by lock_.
+  std::unique_ptr<ScanExpressions> expressions_;
+
+  // The best rows of a top-N scan, if any.
+  // Protected by lock_.
+  std::unique_ptr<ScanTopN> top_n_;
+
+  // Protected by lock_.
+  AdaptiveBatchSizer batch_sizer_;
+
   // (Optional) scanner metrics struct, for recording scanner's duration.
   ScannerMetrics* metrics_;
 
@@ -434,6 +718,9 @@ class Scanner {
   // response.
   Arena arena_;
 
+  // The shared bloom filters used by the predicates of 'spec_'.
+  std::vector<std::shared_ptr<const ScanBloomFilterRegistry::Filters>> bloom_filters_;
+
   // Protects access to this scanner by a single RPC at a time.
   mutable Mutex lock_;
 
@@ -474,6 +761,12 @@ class Scanner {
   mutable RWMutex cpu_times_lock_;
   CpuTimes cpu_times_;
 
+  // The blocks read ahead by PrefetchBlocks() which haven't been returned yet,
+  // and the error it ran into reading from the iterator, if any.
+  // Protected by lock_.
+  std::deque<std::unique_ptr<PrefetchedBlock>> prefetched_blocks_;
+  Status prefetch_status_;
+
   DISALLOW_COPY_AND_ASSIGN(Scanner);
 };
 
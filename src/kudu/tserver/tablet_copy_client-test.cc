@@ -79,8 +79,10 @@
 
 DECLARE_double(env_inject_eio);
 DECLARE_double(tablet_copy_fault_crash_during_download_block);
+DECLARE_double(tablet_copy_fault_corrupt_fetched_chunk);
 DECLARE_double(tablet_copy_fault_crash_during_download_wal);
 DECLARE_int32(tablet_copy_download_threads_nums_per_session);
+DECLARE_int32(tablet_copy_fetch_data_max_attempts);
 DECLARE_int32(tablet_copy_transfer_chunk_size_bytes);
 DECLARE_string(block_manager);
 DECLARE_string(env_inject_eio_globs);
@@ -600,6 +602,53 @@ TEST_P(TabletCopyClientBasicTest, TestDownloadAllBlocks) {
   }
 }
 
+// Test that the chunks failing their checksum verification are fetched again
+// from the same offset, so that the copy succeeds with intact blocks.
+TEST_P(TabletCopyClientBasicTest, TestFetchCorruptChunksAgain) {
+  if (mode_ != TabletCopyMode::REMOTE) {
+    GTEST_SKIP() << "Only remote tablet copies fetch chunks";
+  }
+  // Small chunks, so that blocks span several ones, and exercise the
+  // pipelined fetches falling back to fetching again.
+  FLAGS_tablet_copy_transfer_chunk_size_bytes = 256;
+  FLAGS_tablet_copy_fault_corrupt_fetched_chunk = 0.2;
+  FLAGS_tablet_copy_fetch_data_max_attempts = 100;
+
+  ASSERT_OK(ResetTabletCopyClient());
+  ASSERT_OK(StartCopy());
+  ASSERT_OK(client_->DownloadBlocks());
+  ASSERT_OK(client_->transaction_->CommitCreatedBlocks());
+
+  vector<BlockId> old_data_blocks = ListBlocks(*client_->remote_superblock_);
+  vector<BlockId> new_data_blocks = ListBlocks(*client_->superblock_);
+  ASSERT_EQ(old_data_blocks.size(), new_data_blocks.size());
+  FsManager* src_fs_manager = tablet_replica_->tablet_metadata()->fs_manager();
+  for (size_t i = 0; i < old_data_blocks.size(); i++) {
+    faststring old_scratch;
+    faststring new_scratch;
+    Slice old_data;
+    Slice new_data;
+    ASSERT_OK(ReadLocalBlockFile(src_fs_manager, old_data_blocks[i], &old_scratch, &old_data));
+    ASSERT_OK(ReadLocalBlockFile(fs_manager_.get(), new_data_blocks[i], &new_scratch, &new_data));
+    ASSERT_EQ(old_data, new_data);
+  }
+}
+
+// Test that a chunk failing its checksum verification fails the copy once
+// it's been fetched --tablet_copy_fetch_data_max_attempts times.
+TEST_P(TabletCopyClientBasicTest, TestFetchCorruptChunkFails) {
+  if (mode_ != TabletCopyMode::REMOTE) {
+    GTEST_SKIP() << "Only remote tablet copies fetch chunks";
+  }
+  FLAGS_tablet_copy_fault_corrupt_fetched_chunk = 1.0;
+  FLAGS_tablet_copy_fetch_data_max_attempts = 2;
+  ASSERT_OK(ResetTabletCopyClient());
+  ASSERT_OK(StartCopy());
+  Status s = client_->DownloadBlocks();
+  ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "Injected checksum mismatch");
+}
+
 // Test that failing a disk outside fo the tablet copy client will eventually
 // stop the copy client and cause it to fail.
 TEST_P(TabletCopyClientBasicTest, TestFailedDiskStopsClient) {
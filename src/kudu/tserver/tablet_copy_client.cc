@@ -25,6 +25,9 @@
 #include <optional>
 #include <ostream>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -46,6 +49,7 @@
 #include "kudu/fs/data_dirs.h"
 #include "kudu/fs/fs.pb.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -59,6 +63,7 @@
 #include "kudu/tserver/tablet_copy.proxy.h"
 #include "kudu/tserver/tablet_copy_service.h"
 #include "kudu/tserver/ts_tablet_manager.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -82,8 +87,9 @@
 
 DEFINE_int64(tablet_copy_throttler_bytes_per_sec, 0,
              "Limit tablet copying speed. It limits the copying speed of all the tablets "
-             "in one server for one session. The default value is 0, which means not limiting "
-             "the speed. The unit is bytes/seconds");
+             "in one server for one session, i.e. of all the tablets copied to a tablet "
+             "server, or by one run of the tablet copy tool. The default value is 0, which "
+             "means not limiting the speed. The unit is bytes/seconds");
 DEFINE_double(tablet_copy_throttler_burst_factor, 1.0f,
              "Burst factor for tablet copy throttling. The maximum rate the throttler "
              "allows within a token refill period (100ms) equals burst factor multiply "
@@ -143,6 +149,12 @@ DEFINE_double(tablet_copy_fault_crash_during_download_block, 0.0,
 TAG_FLAG(tablet_copy_fault_crash_during_download_block, unsafe);
 TAG_FLAG(tablet_copy_fault_crash_during_download_block, runtime);
 
+DEFINE_double(tablet_copy_fault_corrupt_fetched_chunk, 0.0,
+              "Fraction of the time that a chunk fetched from the tablet copy source "
+              "fails its checksum verification. For use in test only.");
+TAG_FLAG(tablet_copy_fault_corrupt_fetched_chunk, unsafe);
+TAG_FLAG(tablet_copy_fault_corrupt_fetched_chunk, runtime);
+
 DEFINE_double(tablet_copy_fault_crash_during_download_wal, 0.0,
               "Fraction of the time that DownloadWal() will fail. "
               "For use in test only.");
@@ -154,6 +166,22 @@ DEFINE_int32(tablet_copy_download_threads_nums_per_session, 4,
 DEFINE_validator(tablet_copy_download_threads_nums_per_session,
      [](const char* /*n*/, int32_t v) { return v > 0; });
 
+DEFINE_int32(tablet_copy_fetch_data_max_attempts, 5,
+             "Maximum number of attempts to fetch a chunk of a file from the tablet copy "
+             "source. A chunk failing with a network error, a timeout or a checksum mismatch "
+             "is fetched again from the same offset, so a transient failure neither fails "
+             "the copy nor requires downloading again what was already downloaded.");
+TAG_FLAG(tablet_copy_fetch_data_max_attempts, advanced);
+TAG_FLAG(tablet_copy_fetch_data_max_attempts, runtime);
+DEFINE_validator(tablet_copy_fetch_data_max_attempts,
+     [](const char* /*n*/, int32_t v) { return v > 0; });
+
+DEFINE_bool(tablet_copy_pipelined_fetch, true,
+            "Whether to fetch the next chunk of a file from the tablet copy source while the "
+            "current one is written, rather than waiting for the write to complete.");
+TAG_FLAG(tablet_copy_pipelined_fetch, advanced);
+TAG_FLAG(tablet_copy_pipelined_fetch, runtime);
+
 DEFINE_bool(tablet_copy_support_download_superblock_in_batch, true,
             "Whether to support download superblock in batch automatically when it is very large."
             "When superblock is small, it can be downloaded once a time.");
@@ -191,8 +219,6 @@ using kudu::fs::BlockManager;
 using kudu::fs::CreateBlockOptions;
 using kudu::fs::WritableBlock;
 using kudu::rpc::Messenger;
-using kudu::tablet::ColumnDataPB;
-using kudu::tablet::DeltaDataPB;
 using kudu::tablet::RowSetDataPB;
 using kudu::tablet::TabletDataState;
 using kudu::tablet::TabletDataState_Name;
@@ -206,6 +232,7 @@ using std::optional;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
@@ -699,124 +726,97 @@ Status TabletCopyClient::DownloadWALs() {
 }
 
 int TabletCopyClient::CountRemoteBlocks() const {
-  int num_blocks = 0;
-  for (const RowSetDataPB& rowset : remote_superblock_->rowsets()) {
-    num_blocks += rowset.columns_size();
-    num_blocks += rowset.redo_deltas_size();
-    num_blocks += rowset.undo_deltas_size();
-    if (rowset.has_bloom_block()) {
-      num_blocks++;
-    }
-    if (rowset.has_adhoc_index_block()) {
-      num_blocks++;
-    }
-  }
-  return num_blocks;
+  return TabletMetadata::CollectBlockIdPBs(*remote_superblock_).size();
 }
 
-void TabletCopyClient::DownloadRowset(const RowSetDataPB& src_rowset,
-                                      int num_remote_blocks,
-                                      atomic<int>* block_count,
-                                      Status* end_status) {
-  RowSetDataPB* dst_rowset;
-  {
-    std::lock_guard<simple_spinlock> l(simple_lock_);
-    if (!end_status->ok()) {
-      return;
-    }
-    // Create rowset.
-    dst_rowset = superblock_->add_rowsets();
+namespace {
+
+// Calls 'f' on each block ID of 'rowset'.
+template<typename F>
+void ForEachBlockId(RowSetDataPB* rowset, const F& f) {
+  for (auto& col : *rowset->mutable_columns()) {
+    f(col.mutable_block());
   }
-  *dst_rowset = src_rowset;
-  // Clear the data in the rowset so that we don't end up deleting the wrong
-  // blocks (using the ids of the remote blocks) if we fail.
-  // TODO(mpercy): This is pretty fragile. Consider building a class
-  // structure on top of SuperBlockPB to abstract copying details.
-  dst_rowset->clear_columns();
-  dst_rowset->clear_redo_deltas();
-  dst_rowset->clear_undo_deltas();
-  dst_rowset->clear_bloom_block();
-  dst_rowset->clear_adhoc_index_block();
-
-  // We can't leave superblock_ unserializable with unset required field
-  // values in child elements, so we must download and rewrite each block
-  // before referencing it in the rowset.
-  Status s;
-  for (const ColumnDataPB& src_col : src_rowset.columns()) {
-    BlockIdPB new_block_id;
-    s = DownloadAndRewriteBlockIfEndStatusOK(src_col.block(), num_remote_blocks,
-                                             block_count, &new_block_id, end_status);
-    if (!s.ok()) {
-      return;
-    }
-    ColumnDataPB* dst_col = dst_rowset->add_columns();
-    *dst_col = src_col;
-    *dst_col->mutable_block() = new_block_id;
+  for (auto& redo : *rowset->mutable_redo_deltas()) {
+    f(redo.mutable_block());
   }
-  for (const DeltaDataPB& src_redo : src_rowset.redo_deltas()) {
-    BlockIdPB new_block_id;
-    s = DownloadAndRewriteBlockIfEndStatusOK(src_redo.block(), num_remote_blocks,
-                                             block_count, &new_block_id, end_status);
-    if (!s.ok()) {
-      return;
-    }
-    DeltaDataPB* dst_redo = dst_rowset->add_redo_deltas();
-    *dst_redo = src_redo;
-    *dst_redo->mutable_block() = new_block_id;
+  for (auto& undo : *rowset->mutable_undo_deltas()) {
+    f(undo.mutable_block());
   }
-  for (const DeltaDataPB& src_undo : src_rowset.undo_deltas()) {
-    BlockIdPB new_block_id;
-    s = DownloadAndRewriteBlockIfEndStatusOK(src_undo.block(), num_remote_blocks,
-                                             block_count, &new_block_id, end_status);
-    if (!s.ok()) {
-      return;
-    }
-    DeltaDataPB* dst_undo = dst_rowset->add_undo_deltas();
-    *dst_undo = src_undo;
-    *dst_undo->mutable_block() = new_block_id;
+  if (rowset->has_bloom_block()) {
+    f(rowset->mutable_bloom_block());
   }
-  if (src_rowset.has_bloom_block()) {
-    BlockIdPB new_block_id;
-    s = DownloadAndRewriteBlockIfEndStatusOK(src_rowset.bloom_block(), num_remote_blocks,
-                                             block_count, &new_block_id, end_status);
-    if (!s.ok()) {
-      return;
-    }
-    *dst_rowset->mutable_bloom_block() = new_block_id;
-  }
-  if (src_rowset.has_adhoc_index_block()) {
-    BlockIdPB new_block_id;
-    s = DownloadAndRewriteBlockIfEndStatusOK(src_rowset.adhoc_index_block(), num_remote_blocks,
-                                             block_count, &new_block_id, end_status);
-    if (!s.ok()) {
-      return;
-    }
-    *dst_rowset->mutable_adhoc_index_block() = new_block_id;
+  if (rowset->has_adhoc_index_block()) {
+    f(rowset->mutable_adhoc_index_block());
   }
 }
 
+} // anonymous namespace
+
 Status TabletCopyClient::DownloadBlocks() {
   CHECK_EQ(kStarted, state_);
 
-  // Count up the total number of blocks to download.
-  const int num_remote_blocks = CountRemoteBlocks();
+  // The rowsets of the new superblock, which still reference the remote block
+  // IDs until all the blocks are downloaded.
+  vector<RowSetDataPB> rowsets(remote_superblock_->rowsets().begin(),
+                               remote_superblock_->rowsets().end());
+
+  // Collect the blocks to download. The columns of a column group share its
+  // block, which is only downloaded once.
+  struct BlockDownload {
+    explicit BlockDownload(BlockIdPB src) : src(std::move(src)) {}
+    BlockIdPB src;
+    BlockIdPB dst;
+    bool done = false;
+  };
+  vector<BlockDownload> downloads;
+  std::unordered_map<BlockId, size_t, BlockIdHash, BlockIdEqual> download_idx;
+  for (auto& rowset : rowsets) {
+    ForEachBlockId(&rowset, [&](BlockIdPB* block_id) {
+      if (InsertIfNotPresent(&download_idx, BlockId::FromPB(*block_id), downloads.size())) {
+        downloads.emplace_back(*block_id);
+      }
+    });
+  }
+  const int num_blocks = static_cast<int>(downloads.size());
 
-  // Download each block, writing the new block IDs into the new superblock
-  // as each block downloads.
+  // Download each block in parallel, as a task of its own.
   atomic<int32_t> block_count(0);
-  LOG_WITH_PREFIX(INFO) << "Starting download of " << num_remote_blocks << " data blocks...";
+  LOG_WITH_PREFIX(INFO) << "Starting download of " << num_blocks << " data blocks...";
 
   Status end_status = Status::OK();
-  // Download rowsets in parallel.
-  // Each task downloads the blocks of the corresponding rowset sequentially.
-  for (const RowSetDataPB& src_rowset : remote_superblock_->rowsets()) {
-    RETURN_NOT_OK(tablet_download_pool_->Submit([&]() mutable {
-      DownloadRowset(src_rowset, num_remote_blocks, &block_count, &end_status);
-    }));
+  for (auto& download : downloads) {
+    Status s = tablet_download_pool_->Submit([&, d = &download]() {
+      d->done = DownloadAndRewriteBlockIfEndStatusOK(
+          d->src, num_blocks, &block_count, &d->dst, &end_status).ok();
+    });
+    if (!s.ok()) {
+      std::lock_guard<simple_spinlock> l(simple_lock_);
+      end_status = s;
+      break;
+    }
   }
   tablet_download_pool_->Wait();
 
-  return end_status;
+  if (!end_status.ok()) {
+    // Let Abort() delete the blocks downloaded so far.
+    for (const auto& download : downloads) {
+      if (download.done) {
+        *superblock_->add_orphaned_blocks() = download.dst;
+      }
+    }
+    return end_status;
+  }
+
+  // All the blocks are downloaded: add the rowsets, with the new block IDs,
+  // to the new superblock.
+  for (auto& rowset : rowsets) {
+    ForEachBlockId(&rowset, [&](BlockIdPB* block_id) {
+      *block_id = downloads[FindOrDie(download_idx, BlockId::FromPB(*block_id))].dst;
+    });
+    superblock_->add_rowsets()->Swap(&rowset);
+  }
+  return Status::OK();
 }
 
 Status TabletCopyClient::DownloadWAL(uint64_t wal_segment_seqno) {
@@ -952,13 +952,6 @@ Status RemoteTabletCopyClient::DownloadSuperBlock(string* superblock_path) {
   DataIdPB data_id;
   data_id.set_type(DataIdPB::SUPER_BLOCK);
 
-  rpc::RpcController controller;
-  controller.set_timeout(MonoDelta::FromMilliseconds(session_idle_timeout_millis_));
-  FetchDataRequestPB req;
-  req.set_session_id(session_id_);
-  req.mutable_data_id()->CopyFrom(data_id);
-  req.set_max_length(FLAGS_tablet_copy_transfer_chunk_size_bytes);
-
   // Create a temporary file to store the superblock.
   string tmpl = "super_block.tmp.XXXXXX";
   unique_ptr<RWFile> tmp_file;
@@ -969,18 +962,9 @@ Status RemoteTabletCopyClient::DownloadSuperBlock(string* superblock_path) {
   bool done = false;
   uint64_t offset = 0;
   while (!done) {
-    req.set_offset(offset);
-
     // Request the next data chunk.
     FetchDataResponsePB resp;
-    RETURN_NOT_OK_PREPEND(SendRpcWithRetry(&controller, [&] {
-        return proxy_->FetchData(req, &resp, &controller);
-    }), "unable to fetch data from remote");
-
-    // Sanity-check for corruption.
-    RETURN_NOT_OK_PREPEND(VerifyData(offset, resp.chunk()),
-                          Substitute("error validating data item $0",
-                                     pb_util::SecureShortDebugString(data_id)));
+    RETURN_NOT_OK(FetchChunk(data_id, offset, &resp));
 
     // Write the data.
     RETURN_NOT_OK(tmp_file->Write(offset, resp.chunk().data()));
@@ -993,31 +977,96 @@ Status RemoteTabletCopyClient::DownloadSuperBlock(string* superblock_path) {
   return Status::OK();
 }
 
-template<class Appendable>
-Status RemoteTabletCopyClient::DownloadFile(const DataIdPB& data_id,
-                                            Appendable* appendable) {
-  uint64_t offset = 0;
+struct RemoteTabletCopyClient::PendingFetch {
+  PendingFetch() : done(1) {}
+
+  uint64_t offset;
+  FetchDataRequestPB req;
+  FetchDataResponsePB resp;
+  rpc::RpcController controller;
+  CountDownLatch done;
+};
+
+Status RemoteTabletCopyClient::FetchChunk(const DataIdPB& data_id,
+                                          uint64_t offset,
+                                          FetchDataResponsePB* resp) {
   rpc::RpcController controller;
-  controller.set_timeout(MonoDelta::FromMilliseconds(session_idle_timeout_millis_));
   FetchDataRequestPB req;
   req.set_session_id(session_id_);
   req.mutable_data_id()->CopyFrom(data_id);
   req.set_max_length(FLAGS_tablet_copy_transfer_chunk_size_bytes);
+  req.set_offset(offset);
+
+  for (int attempt = 1;; attempt++) {
+    Status s = SendRpcWithRetry(&controller, [&] {
+      return proxy_->FetchData(req, resp, &controller);
+    }).CloneAndPrepend("unable to fetch data from remote");
+    if (s.ok()) {
+      // Sanity-check for corruption.
+      s = VerifyData(offset, resp->chunk());
+      if (s.ok() && fault_injection::MaybeTrue(FLAGS_tablet_copy_fault_corrupt_fetched_chunk)) {
+        s = Status::Corruption("Injected checksum mismatch");
+      }
+      s = s.CloneAndPrepend(Substitute("Error validating data item $0",
+                                       pb_util::SecureShortDebugString(data_id)));
+    }
+    if (s.ok()) {
+      return Status::OK();
+    }
+    if (attempt >= FLAGS_tablet_copy_fetch_data_max_attempts ||
+        !(s.IsNetworkError() || s.IsTimedOut() || s.IsCorruption())) {
+      return s;
+    }
+    LOG_WITH_PREFIX(WARNING) << Substitute("Fetching data item $0 again from offset $1 "
+                                           "after attempt $2 failed: $3",
+                                           pb_util::SecureShortDebugString(data_id),
+                                           offset, attempt, s.ToString());
+  }
+}
+
+shared_ptr<RemoteTabletCopyClient::PendingFetch> RemoteTabletCopyClient::StartFetchChunk(
+    const DataIdPB& data_id, uint64_t offset) {
+  auto fetch = std::make_shared<PendingFetch>();
+  fetch->offset = offset;
+  fetch->req.set_session_id(session_id_);
+  fetch->req.mutable_data_id()->CopyFrom(data_id);
+  fetch->req.set_max_length(FLAGS_tablet_copy_transfer_chunk_size_bytes);
+  fetch->req.set_offset(offset);
+  fetch->controller.set_timeout(MonoDelta::FromMilliseconds(session_idle_timeout_millis_));
+  // The callback keeps the fetch alive, in case the download is abandoned
+  // while the RPC is in flight.
+  proxy_->FetchDataAsync(fetch->req, &fetch->resp, &fetch->controller,
+                         [fetch]() { fetch->done.CountDown(); });
+  return fetch;
+}
+
+Status RemoteTabletCopyClient::FinishFetchChunk(PendingFetch* fetch) {
+  fetch->done.Wait();
+  RETURN_NOT_OK(UnwindRemoteError(fetch->controller.status(), fetch->controller));
+  RETURN_NOT_OK(VerifyData(fetch->offset, fetch->resp.chunk()));
+  if (fault_injection::MaybeTrue(FLAGS_tablet_copy_fault_corrupt_fetched_chunk)) {
+    return Status::Corruption("Injected checksum mismatch");
+  }
+  return Status::OK();
+}
+
+template<class Appendable>
+Status RemoteTabletCopyClient::DownloadFile(const DataIdPB& data_id,
+                                            Appendable* appendable) {
+  uint64_t offset = 0;
+  FetchDataResponsePB resp;
+  RETURN_NOT_OK(FetchChunk(data_id, offset, &resp));
 
   bool done = false;
   while (!done) {
-    req.set_offset(offset);
-
-    // Request the next data chunk.
-    FetchDataResponsePB resp;
-    RETURN_NOT_OK_PREPEND(SendRpcWithRetry(&controller, [&] {
-        return proxy_->FetchData(req, &resp, &controller);
-    }), "unable to fetch data from remote");
+    auto chunk_size = resp.chunk().data().size();
+    done = offset + chunk_size == resp.chunk().total_data_length();
 
-    // Sanity-check for corruption.
-    RETURN_NOT_OK_PREPEND(VerifyData(offset, resp.chunk()),
-                          Substitute("Error validating data item $0",
-                                     pb_util::SecureShortDebugString(data_id)));
+    // Fetch the next chunk while this one is written.
+    shared_ptr<PendingFetch> next_fetch;
+    if (!done && FLAGS_tablet_copy_pipelined_fetch) {
+      next_fetch = StartFetchChunk(data_id, offset + chunk_size);
+    }
 
     // Write the data.
     RETURN_NOT_OK(appendable->Append(resp.chunk().data()));
@@ -1028,19 +1077,42 @@ Status RemoteTabletCopyClient::DownloadFile(const DataIdPB& data_id,
       SleepFor(MonoDelta::FromMilliseconds(FLAGS_tablet_copy_download_file_inject_latency_ms));
     }
 
-    auto chunk_size = resp.chunk().data().size();
-    done = offset + chunk_size == resp.chunk().total_data_length();
     offset += chunk_size;
     if (dst_tablet_copy_metrics_) {
       dst_tablet_copy_metrics_->bytes_fetched->IncrementBy(chunk_size);
     }
     if (throttler_) {
       LOG_TIMING(INFO, "Tablet copy throttler") {
-        while (!throttler_->Take(MonoTime::Now(), 0, chunk_size)) {
+        // Take the tokens piece by piece: the chunk may be larger than the
+        // burst rate of the throttler, notably once its rate is lowered.
+        uint64_t bytes_to_take = chunk_size;
+        while (true) {
+          bytes_to_take -= throttler_->TakeBytes(MonoTime::Now(), bytes_to_take);
+          if (bytes_to_take == 0) {
+            break;
+          }
           SleepFor(MonoDelta::FromMilliseconds(10));
         }
       }
     }
+    if (done) {
+      break;
+    }
+
+    // Request the next data chunk, unless it's been fetched already. If that
+    // failed, fetch it again with retries.
+    if (next_fetch) {
+      Status s = FinishFetchChunk(next_fetch.get());
+      if (s.ok()) {
+        resp.Swap(&next_fetch->resp);
+        continue;
+      }
+      VLOG_WITH_PREFIX(1) << Substitute("Pipelined fetch of data item $0 at offset $1 failed, "
+                                        "fetching it again: $2",
+                                        pb_util::SecureShortDebugString(data_id),
+                                        offset, s.ToString());
+    }
+    RETURN_NOT_OK(FetchChunk(data_id, offset, &resp));
   }
 
   return Status::OK();
@@ -60,7 +60,6 @@ class RpcController;
 } // namespace rpc
 
 namespace tablet {
-class RowSetDataPB;
 class TabletMetadata;
 class TabletReplica;
 class TabletSuperBlockPB;
@@ -69,6 +68,7 @@ class TabletSuperBlockPB;
 namespace tserver {
 class DataChunkPB;
 class DataIdPB;
+class FetchDataResponsePB;
 class TabletCopyServiceProxy;
 
 // Server-wide tablet copy metrics.
@@ -213,20 +213,16 @@ class TabletCopyClient {
   // Count the number of blocks on the remote (from 'remote_superblock_').
   int CountRemoteBlocks() const;
 
-  // A task do download blocks of the specified rowset.
-  // In case of a failure, a thread notifies others via 'end_status',
-  // so they can abort downloading of their rowsets' blocks.
-  // If all threads succeed, 'end_status' is set to Status::OK().
-  void DownloadRowset(const tablet::RowSetDataPB& src_rowset,
-                      int num_remote_blocks,
-                      std::atomic<int>* block_count,
-                      Status* end_status);
-
-  // Download all blocks belonging to a tablet sequentially. Add all
-  // downloaded blocks to the tablet copy's transaction.
+  // Download all blocks belonging to a tablet, each block being a task of
+  // 'tablet_download_pool_', so that the blocks of a large rowset are
+  // downloaded in parallel too. In case of a failure, the tasks which haven't
+  // started yet are skipped. Add all downloaded blocks to the tablet copy's
+  // transaction.
   //
   // Blocks are given new IDs upon creation. On success, 'superblock_'
-  // is populated to reflect the new block IDs.
+  // is populated to reflect the new block IDs. On failure, the blocks
+  // downloaded so far are added to the orphaned blocks of 'superblock_', so
+  // that Abort() deletes them.
   Status DownloadBlocks();
 
   // Download the remote block specified by 'src_block_id'. 'num_blocks' should
@@ -357,6 +353,21 @@ class RemoteTabletCopyClient : public TabletCopyClient {
   // Download the superblock from remote. The superblock will firstly be stored
   // in a temporary local file 'superblock_path' and then loaded into the memory.
   Status DownloadSuperBlock(std::string* superblock_path);
+
+  // Fetch the chunk of 'data_id' at 'offset' into 'resp' and verify it. A chunk
+  // failing with a network error, a timeout or a checksum mismatch is fetched
+  // again from the same offset, up to --tablet_copy_fetch_data_max_attempts
+  // times, so that a transient failure doesn't fail the whole copy.
+  Status FetchChunk(const DataIdPB& data_id, uint64_t offset, FetchDataResponsePB* resp);
+
+  // A FetchData RPC in flight.
+  struct PendingFetch;
+
+  // Start fetching the chunk of 'data_id' at 'offset' asynchronously.
+  std::shared_ptr<PendingFetch> StartFetchChunk(const DataIdPB& data_id, uint64_t offset);
+
+  // Wait for 'fetch' to complete and verify its chunk.
+  Status FinishFetchChunk(PendingFetch* fetch);
 };
 
 class LocalTabletCopyClient : public TabletCopyClient {
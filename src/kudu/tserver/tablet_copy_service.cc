@@ -16,8 +16,10 @@
 // under the License.
 #include "kudu/tserver/tablet_copy_service.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -37,10 +39,12 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/rpc_context.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/transfer.h"
 #include "kudu/server/server_base.h"
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/tablet_replica.h"
+#include "kudu/tserver/tablet_copy_throttle.h"
 #include "kudu/tserver/tablet_replica_lookup.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/fault_injection.h"
@@ -50,6 +54,7 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/random_util.h"
 #include "kudu/util/thread.h"
+#include "kudu/util/throttler.h"
 
 #define RPC_RETURN_NOT_OK(expr, app_err, message, context) \
   do { \
@@ -83,6 +88,16 @@ DEFINE_double(tablet_copy_early_session_timeout_prob, 0,
 TAG_FLAG(tablet_copy_early_session_timeout_prob, runtime);
 TAG_FLAG(tablet_copy_early_session_timeout_prob, unsafe);
 
+DEFINE_int64(tablet_copy_source_throttler_bytes_per_sec, 0,
+             "Limit the speed at which a tablet server serves the data of its tablets "
+             "to the servers copying them, across all its tablet copy sessions. The "
+             "default value is 0, which means not limiting the speed. The unit is "
+             "bytes/seconds. The burst factor is given by "
+             "--tablet_copy_throttler_burst_factor.");
+TAG_FLAG(tablet_copy_source_throttler_bytes_per_sec, advanced);
+
+DECLARE_int32(tablet_copy_transfer_chunk_size_bytes);
+
 using std::string;
 using std::vector;
 using strings::Substitute;
@@ -112,6 +127,12 @@ TabletCopyServiceImpl::TabletCopyServiceImpl(
       rand_(GetRandomSeed32()),
       shutdown_latch_(1),
       tablet_copy_metrics_(server->metric_entity()) {
+  if (FLAGS_tablet_copy_source_throttler_bytes_per_sec > 0) {
+    throttle_ = std::make_shared<TabletCopyThrottleController>(
+        FLAGS_tablet_copy_source_throttler_bytes_per_sec,
+        TabletCopyThrottleController::ScanLatencyHistogram(server->metric_entity()));
+    throttle_->Start(server->messenger());
+  }
   CHECK_OK(Thread::Create("tablet-copy", "tc-session-exp",
                           [this]() { this->EndExpiredSessions(); },
                           &session_expiration_thread_));
@@ -299,6 +320,23 @@ void TabletCopyServiceImpl::FetchData(const FetchDataRequestPB* req,
   RPC_RETURN_NOT_OK(ValidateFetchRequestDataId(data_id, &error_code),
                     error_code, "Invalid DataId", context);
 
+  // Throttle the reads, shortening the chunk to the bytes available if needed.
+  // Rather than holding up a service thread while throttled, let the client
+  // back off and retry.
+  if (throttle_) {
+    const int64_t maxlen = client_maxlen > 0
+        ? std::min<int64_t>(client_maxlen, FLAGS_tablet_copy_transfer_chunk_size_bytes)
+        : FLAGS_tablet_copy_transfer_chunk_size_bytes;
+    const uint64_t allowed = throttle_->throttler()->TakeBytes(MonoTime::Now(), maxlen);
+    if (allowed == 0) {
+      context->RespondRpcFailure(
+          rpc::ErrorStatusPB::ERROR_SERVER_TOO_BUSY,
+          Status::ServiceUnavailable("tablet copy is throttled on this server"));
+      return;
+    }
+    client_maxlen = allowed;
+  }
+
   DataChunkPB* data_chunk = resp->mutable_chunk();
   string* data = data_chunk->mutable_data();
   int64_t total_data_length = 0;
@@ -349,6 +387,9 @@ void TabletCopyServiceImpl::EndTabletCopySession(
 
 void TabletCopyServiceImpl::Shutdown() {
   shutdown_latch_.CountDown();
+  if (throttle_) {
+    throttle_->Shutdown();
+  }
   session_expiration_thread_->Join();
 
   // Destroy all tablet copy sessions.
@@ -17,6 +17,7 @@
 #ifndef KUDU_TSERVER_TABLET_COPY_SERVICE_H_
 #define KUDU_TSERVER_TABLET_COPY_SERVICE_H_
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -51,6 +52,7 @@ class RpcContext;
 
 namespace tserver {
 
+class TabletCopyThrottleController;
 class TabletReplicaLookupIf;
 
 class TabletCopyServiceImpl : public TabletCopyServiceIf {
@@ -133,6 +135,10 @@ class TabletCopyServiceImpl : public TabletCopyServiceIf {
   scoped_refptr<Thread> session_expiration_thread_;
 
   TabletCopySourceMetrics tablet_copy_metrics_;
+
+  // Throttles the reads of the tablet copies served by this server, if
+  // --tablet_copy_source_throttler_bytes_per_sec is set.
+  std::shared_ptr<TabletCopyThrottleController> throttle_;
 };
 
 } // namespace tserver
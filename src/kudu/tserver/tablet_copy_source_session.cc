@@ -40,6 +40,7 @@
 #include "kudu/fs/data_dirs.h"
 #include "kudu/fs/fs.pb.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/fs/io_context.h"
 #include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
@@ -281,6 +282,7 @@ static Status ReadFileChunkToBuf(const Info* info,
   data->resize(response_data_size);
   uint8_t* buf = reinterpret_cast<uint8_t*>(data->data());
   Slice slice(buf, response_data_size);
+  fs::SetThreadIOPriority(fs::IOPriority::BACKGROUND);
   Status s = info->Read(offset, slice);
   if (PREDICT_FALSE(!s.ok())) {
     s = s.CloneAndPrepend(
@@ -534,10 +536,8 @@ Status LocalTabletCopySourceSession::InitOnce() {
   RETURN_NOT_OK(CheckHealthyDirGroup());
 
   // Read the SuperBlock from disk.
-  string path = fs_manager_->GetTabletMetadataPath(tablet_id_);
   RETURN_NOT_OK_PREPEND(
-      pb_util::ReadPBContainerFromPath(fs_manager_->GetEnv(), path, &tablet_superblock_,
-                                       pb_util::SENSITIVE),
+      TabletMetadata::ReadSuperBlockFromDisk(fs_manager_, tablet_id_, &tablet_superblock_),
       Substitute("Unable to access superblock for tablet $0", tablet_id_));
 
   // Open the data blocks and add them to the cache.
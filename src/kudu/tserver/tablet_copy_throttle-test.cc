@@ -0,0 +1,110 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/tablet_copy_throttle.h"
+
+#include <cstdint>
+#include <memory>
+
+#include <gflags/gflags_declare.h>
+#include <gtest/gtest.h>
+
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/test_util.h"
+#include "kudu/util/throttler.h"
+
+DECLARE_int32(tablet_copy_throttler_scan_latency_target_ms);
+
+using std::make_shared;
+using std::shared_ptr;
+
+namespace kudu {
+namespace tserver {
+
+class TabletCopyThrottleTest : public KuduTest {
+ public:
+  static constexpr uint64_t kMaxRate = 16 * 1024 * 1024;
+
+  TabletCopyThrottleTest()
+      : entity_(METRIC_ENTITY_server.Instantiate(&registry_, "test")),
+        scan_latency_(TabletCopyThrottleController::ScanLatencyHistogram(entity_)),
+        controller_(make_shared<TabletCopyThrottleController>(kMaxRate, scan_latency_)) {
+  }
+
+ protected:
+  // Records 'num_scans' scans lasting 'latency_ms' each.
+  void Scan(int num_scans, int latency_ms) {
+    scan_latency_->IncrementBy(latency_ms * 1000, num_scans);
+  }
+
+  MetricRegistry registry_;
+  scoped_refptr<MetricEntity> entity_;
+  scoped_refptr<Histogram> scan_latency_;
+  shared_ptr<TabletCopyThrottleController> controller_;
+};
+
+TEST_F(TabletCopyThrottleTest, TestDisabledWithoutTarget) {
+  FLAGS_tablet_copy_throttler_scan_latency_target_ms = 0;
+  Scan(100, 1000);
+  controller_->Adjust();
+  ASSERT_EQ(kMaxRate, controller_->bytes_per_sec());
+}
+
+TEST_F(TabletCopyThrottleTest, TestAdaptsToScanLatency) {
+  FLAGS_tablet_copy_throttler_scan_latency_target_ms = 100;
+
+  // Scans within the target don't slow copies down.
+  Scan(100, 50);
+  controller_->Adjust();
+  ASSERT_EQ(kMaxRate, controller_->bytes_per_sec());
+
+  // Slow scans halve the rate, down to a sixteenth of the maximum rate.
+  Scan(100, 200);
+  controller_->Adjust();
+  ASSERT_EQ(kMaxRate / 2, controller_->bytes_per_sec());
+  for (int i = 0; i < 10; i++) {
+    Scan(100, 200);
+    controller_->Adjust();
+  }
+  ASSERT_EQ(kMaxRate / 16, controller_->bytes_per_sec());
+
+  // The throttler follows the rate.
+  MonoTime now = MonoTime::Now() + MonoDelta::FromSeconds(1);
+  ASSERT_EQ(kMaxRate / 16 / 10, controller_->throttler()->TakeBytes(now, kMaxRate));
+
+  // Without scans, or with fast scans, the rate increases back to the maximum.
+  controller_->Adjust();
+  ASSERT_EQ(kMaxRate / 16 + kMaxRate / 10, controller_->bytes_per_sec());
+  for (int i = 0; i < 10; i++) {
+    Scan(100, 10);
+    controller_->Adjust();
+  }
+  ASSERT_EQ(kMaxRate, controller_->bytes_per_sec());
+
+  // Only the scans since the previous adjustment count.
+  Scan(1, 10000);
+  controller_->Adjust();
+  ASSERT_EQ(kMaxRate / 2, controller_->bytes_per_sec());
+  Scan(1, 10);
+  controller_->Adjust();
+  ASSERT_EQ(kMaxRate / 2 + kMaxRate / 10, controller_->bytes_per_sec());
+}
+
+} // namespace tserver
+} // namespace kudu
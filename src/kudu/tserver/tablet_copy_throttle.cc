@@ -0,0 +1,173 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/tablet_copy_throttle.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/rpc/periodic.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/hdr_histogram.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/throttler.h"
+
+DEFINE_int32(tablet_copy_throttler_scan_latency_target_ms, 0,
+             "Target for the mean latency of the Scan RPCs handled by a tablet server. "
+             "While above the target, the tablet copies throttled by "
+             "--tablet_copy_throttler_bytes_per_sec or "
+             "--tablet_copy_source_throttler_bytes_per_sec slow down, letting scans take "
+             "over the disks and the network. If 0, tablet copies are throttled at the "
+             "configured rates regardless of scans.");
+TAG_FLAG(tablet_copy_throttler_scan_latency_target_ms, advanced);
+TAG_FLAG(tablet_copy_throttler_scan_latency_target_ms, runtime);
+
+DEFINE_int32(tablet_copy_throttler_adjust_period_ms, 1000,
+             "How often the rates of the tablet copy throttlers are adjusted to the "
+             "latency of scans, in milliseconds. See "
+             "--tablet_copy_throttler_scan_latency_target_ms.");
+TAG_FLAG(tablet_copy_throttler_adjust_period_ms, advanced);
+
+DECLARE_double(tablet_copy_throttler_burst_factor);
+
+METRIC_DECLARE_histogram(handler_latency_kudu_tserver_TabletServerService_Scan);
+
+namespace {
+
+bool ValidateAdjustPeriod(const char* flagname, int32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(tablet_copy_throttler_adjust_period_ms, &ValidateAdjustPeriod);
+
+using kudu::rpc::Messenger;
+using kudu::rpc::PeriodicTimer;
+using std::shared_ptr;
+using std::weak_ptr;
+
+namespace kudu {
+namespace tserver {
+
+namespace {
+
+// The rate isn't lowered further than the maximum rate divided by this, so
+// that copies make progress even with a sustained scan load.
+const uint64_t kMinRateDivisor = 16;
+
+// The rate is increased by the maximum rate divided by this per period.
+const uint64_t kRateIncreaseDivisor = 10;
+
+} // anonymous namespace
+
+TabletCopyThrottleController::TabletCopyThrottleController(
+    uint64_t max_bytes_per_sec,
+    scoped_refptr<Histogram> scan_latency)
+    : max_bytes_per_sec_(max_bytes_per_sec),
+      scan_latency_(std::move(scan_latency)),
+      throttler_(std::make_shared<Throttler>(MonoTime::Now(), 0, max_bytes_per_sec,
+                                             FLAGS_tablet_copy_throttler_burst_factor)),
+      bytes_per_sec_(max_bytes_per_sec),
+      last_scan_count_(scan_latency_->TotalCount()),
+      last_scan_sum_us_(scan_latency_->histogram()->TotalSum()) {
+  DCHECK_GT(max_bytes_per_sec, 0);
+}
+
+TabletCopyThrottleController::~TabletCopyThrottleController() {
+  Shutdown();
+}
+
+scoped_refptr<Histogram> TabletCopyThrottleController::ScanLatencyHistogram(
+    const scoped_refptr<MetricEntity>& metric_entity) {
+  return METRIC_handler_latency_kudu_tserver_TabletServerService_Scan.Instantiate(
+      metric_entity);
+}
+
+void TabletCopyThrottleController::Start(const shared_ptr<Messenger>& messenger) {
+  // Capture a weak_ptr reference into the functor so it can safely handle
+  // outliving the controller.
+  weak_ptr<TabletCopyThrottleController> w = shared_from_this();
+  std::lock_guard<simple_spinlock> l(lock_);
+  DCHECK(!timer_);
+  timer_ = PeriodicTimer::Create(
+      messenger,
+      [w]() {
+        if (auto c = w.lock()) {
+          c->Adjust();
+        }
+      },
+      MonoDelta::FromMilliseconds(FLAGS_tablet_copy_throttler_adjust_period_ms));
+  timer_->Start();
+}
+
+void TabletCopyThrottleController::Shutdown() {
+  shared_ptr<PeriodicTimer> timer;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    timer = std::move(timer_);
+  }
+  if (timer) {
+    timer->Stop();
+  }
+}
+
+void TabletCopyThrottleController::Adjust() {
+  const uint64_t scan_count = scan_latency_->TotalCount();
+  const uint64_t scan_sum_us = scan_latency_->histogram()->TotalSum();
+  const int32_t target_ms = FLAGS_tablet_copy_throttler_scan_latency_target_ms;
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  const uint64_t num_scans = scan_count - last_scan_count_;
+  const uint64_t mean_scan_latency_us =
+      num_scans == 0 ? 0 : (scan_sum_us - last_scan_sum_us_) / num_scans;
+  last_scan_count_ = scan_count;
+  last_scan_sum_us_ = scan_sum_us;
+
+  const uint64_t rate = bytes_per_sec_;
+  uint64_t new_rate;
+  if (target_ms <= 0) {
+    new_rate = max_bytes_per_sec_;
+  } else if (num_scans > 0 &&
+             mean_scan_latency_us > static_cast<uint64_t>(target_ms) * 1000) {
+    new_rate = std::max(rate / 2, max_bytes_per_sec_ / kMinRateDivisor);
+  } else {
+    new_rate = std::min(rate + max_bytes_per_sec_ / kRateIncreaseDivisor, max_bytes_per_sec_);
+  }
+  if (new_rate == rate) {
+    return;
+  }
+  VLOG(1) << "Mean scan latency " << mean_scan_latency_us << "us over " << num_scans
+          << " scans: changing tablet copy rate from " << rate << " to " << new_rate
+          << " bytes/sec";
+  bytes_per_sec_ = new_rate;
+  throttler_->SetRate(0, new_rate);
+}
+
+} // namespace tserver
+} // namespace kudu
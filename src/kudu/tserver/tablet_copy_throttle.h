@@ -0,0 +1,104 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/locks.h"
+
+namespace kudu {
+
+class Histogram;
+class MetricEntity;
+class Throttler;
+
+namespace rpc {
+class Messenger;
+class PeriodicTimer;
+} // namespace rpc
+
+namespace tserver {
+
+// Controls the rate of a throttler shared by the tablet copies of a tablet
+// server, either as a source or as a destination, so that copies yield to the
+// scans served by the server.
+//
+// Every --tablet_copy_throttler_adjust_period_ms, the mean latency of the
+// Scan RPCs handled since the previous adjustment is compared against
+// --tablet_copy_throttler_scan_latency_target_ms: if above, the rate is
+// halved, down to a sixteenth of the maximum rate; otherwise it's increased
+// by a tenth of the maximum rate, up to the maximum rate.
+//
+// This class is thread-safe.
+class TabletCopyThrottleController :
+    public std::enable_shared_from_this<TabletCopyThrottleController> {
+ public:
+  // Returns a controller limiting tablet copies to 'max_bytes_per_sec', with
+  // the burst factor of --tablet_copy_throttler_burst_factor, and adapting
+  // the rate to the latency of the scans recorded in 'scan_latency'.
+  TabletCopyThrottleController(uint64_t max_bytes_per_sec,
+                               scoped_refptr<Histogram> scan_latency);
+  ~TabletCopyThrottleController();
+
+  // Returns the histogram of the latency of the Scan RPCs handled by the
+  // server of 'metric_entity'.
+  static scoped_refptr<Histogram> ScanLatencyHistogram(
+      const scoped_refptr<MetricEntity>& metric_entity);
+
+  // Starts adjusting the rate periodically on the reactor threads of
+  // 'messenger'.
+  void Start(const std::shared_ptr<rpc::Messenger>& messenger);
+
+  // Stops adjusting the rate.
+  void Shutdown();
+
+  // Adjusts the rate to the latency of the scans since the previous call.
+  void Adjust();
+
+  // The throttler whose rate is controlled.
+  const std::shared_ptr<Throttler>& throttler() const {
+    return throttler_;
+  }
+
+  // Returns the current rate of the throttler.
+  uint64_t bytes_per_sec() const {
+    return bytes_per_sec_;
+  }
+
+ private:
+  const uint64_t max_bytes_per_sec_;
+  const scoped_refptr<Histogram> scan_latency_;
+  const std::shared_ptr<Throttler> throttler_;
+
+  std::atomic<uint64_t> bytes_per_sec_;
+
+  // Protects the fields below.
+  simple_spinlock lock_;
+  uint64_t last_scan_count_;
+  uint64_t last_scan_sum_us_;
+
+  std::shared_ptr<rpc::PeriodicTimer> timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(TabletCopyThrottleController);
+};
+
+} // namespace tserver
+} // namespace kudu
@@ -23,6 +23,7 @@
 #include <atomic>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
 #include <map>
@@ -56,8 +57,11 @@
 #include "kudu/common/wire_protocol-test-util.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/common/wire_protocol.pb.h"
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/consensus.proxy.h"
 #include "kudu/consensus/log-test-base.h"
 #include "kudu/consensus/log.h"
+#include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/fs/block_id.h"
 #include "kudu/fs/block_manager.h"
@@ -111,6 +115,7 @@
 #include "kudu/util/hdr_histogram.h"
 #include "kudu/util/jsonwriter.h"
 #include "kudu/util/logging_test_util.h"
+#include "kudu/util/mem_tracker.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
@@ -130,7 +135,11 @@
 using google::protobuf::util::MessageDifferencer;
 using kudu::clock::Clock;
 using kudu::clock::HybridClock;
+using kudu::consensus::ConsensusErrorPB;
+using kudu::consensus::ConsensusRequestPB;
 using kudu::consensus::ConsensusStatePB;
+using kudu::consensus::MultiConsensusRequestPB;
+using kudu::consensus::MultiConsensusResponsePB;
 using kudu::fs::BlockManager;
 using kudu::fs::CreateCorruptBlock;
 using kudu::fs::DataDirManager;
@@ -182,6 +191,7 @@ DECLARE_bool(enable_rowset_compaction);
 DECLARE_bool(enable_workload_score_for_perf_improvement_ops);
 DECLARE_bool(fail_dns_resolution);
 DECLARE_bool(rowset_metadata_store_keys);
+DECLARE_bool(scanner_prefetch_enabled);
 DECLARE_bool(scanner_unregister_on_invalid_seq_id);
 DECLARE_bool(show_slow_scans);
 DECLARE_double(cfile_inject_corruption);
@@ -198,6 +208,7 @@ DECLARE_int32(maintenance_manager_inject_latency_ms);
 DECLARE_int32(maintenance_manager_num_threads);
 DECLARE_int32(maintenance_manager_polling_interval_ms);
 DECLARE_int32(memory_pressure_percentage);
+DECLARE_int32(metrics_render_cache_ms);
 DECLARE_int32(metrics_retirement_age_ms);
 DECLARE_int32(rpc_num_service_threads);
 DECLARE_int32(rpc_service_queue_length);
@@ -211,6 +222,7 @@ DECLARE_int32(tablet_inject_latency_on_apply_write_op_ms);
 DECLARE_int32(tablet_inject_latency_on_prepare_write_op_ms);
 DECLARE_int32(workload_stats_rate_collection_min_interval_ms);
 DECLARE_int32(workload_stats_metric_collection_interval_ms);
+DECLARE_int64(scanner_response_memory_limit_mb);
 DECLARE_string(block_manager);
 DECLARE_string(env_inject_eio_globs);
 DECLARE_string(env_inject_full_globs);
@@ -226,6 +238,7 @@ METRIC_DECLARE_counter(rows_updated);
 METRIC_DECLARE_counter(rows_deleted);
 METRIC_DECLARE_counter(rpcs_queue_overflow);
 METRIC_DECLARE_counter(rpcs_timed_out_in_queue);
+METRIC_DECLARE_counter(scanner_batches_cut_for_memory);
 METRIC_DECLARE_counter(scanners_expired);
 METRIC_DECLARE_gauge_int32(startup_progress_steps_remaining);
 METRIC_DECLARE_gauge_int64(startup_progress_time_elapsed);
@@ -696,6 +709,32 @@ TEST_F(TabletServerTest, TestTombstonedTabletOnWebUI) {
   ASSERT_STR_NOT_CONTAINS(s, mini_server_->bound_rpc_addr().ToString());
 }
 
+// Test fetching only the metrics modified since an epoch, and reusing the
+// rendered metrics.
+TEST_F(TabletServerTest, TestMetricsSinceEpochAndRenderCache) {
+  EasyCurl c;
+  faststring buf;
+  const string addr = mini_server_->bound_http_addr().ToString();
+  ASSERT_OK(c.FetchURL(Substitute("http://$0/metrics?since_epoch=0", addr), &buf));
+  ASSERT_STR_CONTAINS(buf.ToString(), "\"type\": \"tablet\"");
+  ASSERT_STR_CONTAINS(buf.ToString(), "threads_started");
+  Status s = c.FetchURL(Substitute("http://$0/metrics?since_epoch=foo", addr), &buf);
+  ASSERT_TRUE(s.IsRemoteError()) << s.ToString();
+
+  // The scrapes within --metrics_render_cache_ms get the same response, even
+  // though the metrics changed in the meantime.
+  FLAGS_metrics_render_cache_ms = 60 * 1000;
+  const string url = Substitute("http://$0/metrics?metrics=rows_inserted", addr);
+  ASSERT_OK(c.FetchURL(url, &buf));
+  const string cached = buf.ToString();
+  NO_FATALS(InsertTestRowsRemote(0, 10));
+  ASSERT_OK(c.FetchURL(url, &buf));
+  ASSERT_EQ(cached, buf.ToString());
+  FLAGS_metrics_render_cache_ms = 0;
+  ASSERT_OK(c.FetchURL(url, &buf));
+  ASSERT_NE(cached, buf.ToString());
+}
+
 // When tablet server merge metrics by the same attributes, the metric
 // 'merged_entities_count_of_tablet' should be visible
 TEST_F(TabletServerTest, TestMergedEntitiesCount) {
@@ -709,6 +748,36 @@ TEST_F(TabletServerTest, TestMergedEntitiesCount) {
   ASSERT_STR_CONTAINS(buf.ToString(), "merged_entities_count_of_tablet");
 }
 
+// Test that the IO and CPU time of the scans and writes are accounted to the
+// tablet, and exported summed by table in the Prometheus format.
+TEST_F(TabletServerTest, TestTableResourceMetrics) {
+  NO_FATALS(InsertTestRowsRemote(0, 100));
+  ASSERT_OK(tablet_replica_->tablet()->Flush());
+  ScanResponsePB resp;
+  NO_FATALS(OpenScannerWithAllColumns(&resp));
+  vector<string> rows;
+  NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema_, &rows));
+  ASSERT_EQ(100, rows.size());
+
+  // The flushed blocks weren't cached, so the scan read them from disk.
+  const auto* metrics = tablet_replica_->tablet()->metrics();
+  ASSERT_GT(metrics->io_metrics.cfile_cache_misses->value(), 0);
+  ASSERT_GT(metrics->io_metrics.cfile_bytes_read->value(), 0);
+
+  EasyCurl c;
+  faststring buf;
+  const string addr = mini_server_->bound_http_addr().ToString();
+  ASSERT_OK(c.FetchURL(Substitute("http://$0/metrics_prometheus", addr), &buf));
+  const string prometheus = buf.ToString();
+  ASSERT_STR_CONTAINS(prometheus, "# TYPE kudu_table_cfile_cache_misses counter\n");
+  ASSERT_STR_CONTAINS(prometheus, Substitute(
+      "kudu_table_cfile_bytes_read{table_id=\"$0\",", kTableId));
+  ASSERT_STR_CONTAINS(prometheus, Substitute(
+      "kudu_table_apply_cpu_user_time{table_id=\"$0\",", kTableId));
+  ASSERT_STR_CONTAINS(prometheus, Substitute(
+      "kudu_table_rows_inserted{table_id=\"$0\",", kTableId));
+}
+
 class TabletServerDiskSpaceTest : public TabletServerTestBase,
                                   public testing::WithParamInterface<string> {
  public:
@@ -2675,6 +2744,74 @@ TEST_F(ScannerScansTest, TestSnapshotScan) {
   }
 }
 
+// Test that the scans of a table with a row TTL hide the rows expired as of
+// their snapshot, so that repeating a snapshot scan once its rows have expired
+// still returns them, while the READ_LATEST scans don't.
+TEST_F(ScannerScansTest, TestSnapshotScanWithRowTtl) {
+  const char* const kTtlTablet = "ttl_tablet";
+  const int64_t kTtlSec = 60;
+  const int kNumRows = 10;
+  const Schema schema({ ColumnSchema("key", UNIXTIME_MICROS),
+                        ColumnSchema("val", INT32) }, 1);
+  ASSERT_OK(mini_server_->AddTestTablet("ttl_table", kTtlTablet, schema));
+  ASSERT_OK(WaitForTabletRunning(kTtlTablet));
+  scoped_refptr<TabletReplica> replica;
+  ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet(kTtlTablet, &replica));
+  TableExtraConfigPB extra_config;
+  extra_config.set_row_ttl_column("key");
+  extra_config.set_row_ttl_sec(kTtlSec);
+  replica->tablet_metadata()->SetExtraConfig(std::move(extra_config));
+
+  // Insert rows which expire a second from now.
+  Clock* clock = mini_server_->server()->clock();
+  const int64_t now_micros = HybridClock::GetPhysicalValueMicros(clock->Now());
+  LocalTabletWriter writer(replica->tablet(), &schema);
+  for (int i = 0; i < kNumRows; i++) {
+    KuduPartialRow row(&schema);
+    ASSERT_OK(row.SetUnixTimeMicros(0, now_micros - (kTtlSec - 1) * 1000000 + i));
+    ASSERT_OK(row.SetInt32(1, i));
+    ASSERT_OK(writer.Insert(row));
+  }
+  const Timestamp snap_timestamp = clock->Now();
+
+  const auto scan_rows = [&](ReadMode read_mode, vector<string>* results) {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTtlTablet);
+    scan->set_read_mode(read_mode);
+    if (read_mode == READ_AT_SNAPSHOT) {
+      scan->set_snap_timestamp(snap_timestamp.ToUint64());
+    }
+    ASSERT_OK(SchemaToColumnPBs(schema, scan->mutable_projected_columns()));
+    req.set_call_seq_id(0);
+    req.set_batch_size_bytes(0);
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    results->clear();
+    if (resp.has_more_results()) {
+      NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema, results));
+    }
+  };
+
+  vector<string> results;
+  NO_FATALS(scan_rows(READ_AT_SNAPSHOT, &results));
+  ASSERT_EQ(kNumRows, results.size());
+  const vector<string> snapshot_results = results;
+
+  // Once the rows have expired, the READ_LATEST scans hide them...
+  ASSERT_EVENTUALLY([&] {
+    NO_FATALS(scan_rows(READ_LATEST, &results));
+    ASSERT_TRUE(results.empty());
+  });
+
+  // ... but the snapshot scan still returns them.
+  NO_FATALS(scan_rows(READ_AT_SNAPSHOT, &results));
+  ASSERT_EQ(snapshot_results, results);
+}
+
 TEST_F(ScannerScansTest, TestSnapshotScan_WithoutSnapshotTimestamp) {
   vector<uint64_t> write_timestamps_collector;
   // perform a write
@@ -3216,6 +3353,275 @@ TEST_F(ScannerScansTest, TestColumnarScan) {
 }
 
 
+TEST_F(ScannerScansTest, TestScanWithAggregates) {
+  const int kNumRows = 100;
+  InsertTestRowsDirect(0, kNumRows);
+
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  // A negative column index stands for an aggregate without a column.
+  const auto add_agg = [&](ColumnAggregatePB::Type type, int col_idx) {
+    auto* agg = scan->add_aggregates();
+    agg->set_type(type);
+    if (col_idx >= 0) {
+      agg->set_column_idx(col_idx);
+    }
+  };
+  add_agg(ColumnAggregatePB::COUNT, -1);
+  add_agg(ColumnAggregatePB::SUM, 1);
+  add_agg(ColumnAggregatePB::MIN, 0);
+  add_agg(ColumnAggregatePB::MAX, 2);
+  rpc.RequireServerFeature(TabletServerFeatures::SCAN_AGGREGATES);
+
+  SCOPED_TRACE(SecureDebugString(req));
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  SCOPED_TRACE(SecureDebugString(resp));
+  ASSERT_FALSE(resp.has_error());
+  ASSERT_FALSE(resp.has_more_results());
+  ASSERT_FALSE(resp.has_data());
+  ASSERT_EQ(4, resp.aggregate_results_size());
+
+  // COUNT(*)
+  EXPECT_EQ(kNumRows, resp.aggregate_results(0).count());
+  EXPECT_FALSE(resp.aggregate_results(0).has_value());
+
+  // SUM(int_val): the test rows have int_val = key * 2.
+  {
+    const auto& result = resp.aggregate_results(1);
+    EXPECT_EQ(kNumRows, result.count());
+    ASSERT_EQ(sizeof(int64_t), result.value().size());
+    int64_t sum;
+    memcpy(&sum, result.value().data(), sizeof(sum));
+    EXPECT_EQ(kNumRows * (kNumRows - 1), sum);
+  }
+
+  // MIN(key)
+  {
+    const auto& result = resp.aggregate_results(2);
+    ASSERT_EQ(sizeof(int32_t), result.value().size());
+    int32_t min;
+    memcpy(&min, result.value().data(), sizeof(min));
+    EXPECT_EQ(0, min);
+  }
+
+  // MAX(string_val)
+  EXPECT_EQ(Substitute("hello $0", kNumRows - 1), resp.aggregate_results(3).value());
+}
+
+TEST_F(ScannerScansTest, TestInvalidScanRequest_BadAggregates) {
+  InsertTestRowsDirect(0, 10);
+  // SUM of a string column, MIN without a column, and MAX of a column out
+  // of the projection's range.
+  const vector<pair<ColumnAggregatePB::Type, int>> kBadAggregates = {
+    { ColumnAggregatePB::SUM, 2 },
+    { ColumnAggregatePB::MIN, -1 },
+    { ColumnAggregatePB::MAX, 3 },
+  };
+  for (const auto& [type, col_idx] : kBadAggregates) {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+    auto* agg = scan->add_aggregates();
+    agg->set_type(type);
+    if (col_idx >= 0) {
+      agg->set_column_idx(col_idx);
+    }
+
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_SCAN_SPEC, resp.error().code());
+  }
+}
+
+TEST_F(ScannerScansTest, TestTopNScan) {
+  NO_FATALS(InsertTestRowsDirect(0, 50));
+  ASSERT_OK(tablet_replica_->tablet()->Flush());
+  NO_FATALS(InsertTestRowsDirect(50, 50));
+
+  // The top 3 rows by descending string_val, which sort lexicographically, and
+  // by ascending int_val.
+  for (const auto& [col_idx, descending] : vector<pair<int, bool>>{ { 2, true }, { 1, false } }) {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+    scan->mutable_top_n()->set_column_idx(col_idx);
+    scan->mutable_top_n()->set_descending(descending);
+    scan->mutable_top_n()->set_limit(3);
+    rpc.RequireServerFeature(TabletServerFeatures::TOP_N_SCANS);
+
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    vector<string> results;
+    NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, &results));
+    if (resp.has_more_results()) {
+      NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema_, &results));
+    }
+    ASSERT_EQ(3, results.size());
+    for (int i = 0; i < 3; i++) {
+      const int key = descending ? 99 - i : i;
+      EXPECT_EQ(Substitute(R"((int32 key=$0, int32 int_val=$1, string string_val="hello $0"))",
+                           key, key * 2),
+                results[i]);
+    }
+  }
+}
+
+TEST_F(ScannerScansTest, TestInvalidScanRequest_BadTopN) {
+  NO_FATALS(InsertTestRowsDirect(0, 10));
+  // A top-N with a limit, with a non-positive limit, and with a column out of
+  // the projection's range.
+  for (int i = 0; i < 3; i++) {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+    scan->mutable_top_n()->set_column_idx(i == 2 ? 3 : 0);
+    scan->mutable_top_n()->set_limit(i == 1 ? 0 : 10);
+    if (i == 0) {
+      scan->set_limit(10);
+    }
+
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_SCAN_SPEC, resp.error().code());
+  }
+}
+
+TEST_F(ScannerScansTest, TestScanWithExpressions) {
+  NO_FATALS(InsertTestRowsDirect(0, 50));
+  ASSERT_OK(tablet_replica_->tablet()->Flush());
+  NO_FATALS(InsertTestRowsDirect(50, 50));
+
+  const auto col = [](const string& name) {
+    ExpressionPB pb;
+    pb.set_type(ExpressionPB::COLUMN);
+    pb.set_column(name);
+    return pb;
+  };
+  const auto lit = [](int64_t value) {
+    ExpressionPB pb;
+    pb.set_type(ExpressionPB::LITERAL);
+    pb.set_int_value(value);
+    return pb;
+  };
+  const auto op = [](ExpressionPB::Type type, const ExpressionPB& lhs, const ExpressionPB& rhs) {
+    ExpressionPB pb;
+    pb.set_type(type);
+    *pb.add_args() = lhs;
+    *pb.add_args() = rhs;
+    return pb;
+  };
+
+  // The rows whose key is a multiple of 3 and int_val is above 20, with the
+  // square of their key computed from int_val, which isn't projected.
+  const Schema projection({ ColumnSchema("key", INT32) }, 1);
+  const auto new_scan = [&](ScanRequestPB* req) {
+    NewScanRequestPB* scan = req->mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    CHECK_OK(SchemaToColumnPBs(projection, scan->mutable_projected_columns()));
+    *scan->mutable_filter() = op(ExpressionPB::AND,
+                                 op(ExpressionPB::EQUAL,
+                                    op(ExpressionPB::MODULO, col("key"), lit(3)), lit(0)),
+                                 op(ExpressionPB::GREATER, col("int_val"), lit(20)));
+    auto* computed = scan->add_computed_columns();
+    computed->set_name("sq");
+    *computed->mutable_expr() = op(ExpressionPB::DIVIDE,
+                                   op(ExpressionPB::MULTIPLY, col("key"), col("int_val")),
+                                   lit(2));
+    return scan;
+  };
+  int64_t expected_sum = 0;
+  vector<string> expected_rows;
+  for (int key = 12; key < 100; key += 3) {
+    expected_sum += key * key;
+    expected_rows.emplace_back(Substitute("(int32 key=$0, int64 sq=$1)", key, key * key));
+  }
+
+  {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    new_scan(&req);
+    rpc.RequireServerFeature(TabletServerFeatures::SCAN_EXPRESSIONS);
+
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    const Schema result_schema({ ColumnSchema("key", INT32),
+                                 ColumnSchema("sq", INT64, /*is_nullable=*/true) }, 1);
+    vector<string> results;
+    NO_FATALS(StringifyRowsFromResponse(result_schema, rpc, &resp, &results));
+    if (resp.has_more_results()) {
+      NO_FATALS(DrainScannerToStrings(resp.scanner_id(), result_schema, &results));
+    }
+    std::sort(results.begin(), results.end());
+    std::sort(expected_rows.begin(), expected_rows.end());
+    ASSERT_EQ(expected_rows, results);
+  }
+
+  // The computed columns can be aggregated.
+  {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    auto* agg = new_scan(&req)->add_aggregates();
+    agg->set_type(ColumnAggregatePB::SUM);
+    agg->set_column_idx(1);
+
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_FALSE(resp.has_more_results());
+    ASSERT_EQ(1, resp.aggregate_results_size());
+    EXPECT_EQ(static_cast<int64_t>(expected_rows.size()), resp.aggregate_results(0).count());
+    int64_t sum;
+    ASSERT_EQ(sizeof(sum), resp.aggregate_results(0).value().size());
+    memcpy(&sum, resp.aggregate_results(0).value().data(), sizeof(sum));
+    EXPECT_EQ(expected_sum, sum);
+  }
+
+  // A filter must be a BOOL expression, and the computed columns can't shadow
+  // the columns of the scan.
+  for (int i = 0; i < 2; i++) {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    NewScanRequestPB* scan = new_scan(&req);
+    if (i == 0) {
+      *scan->mutable_filter() = col("key");
+    } else {
+      scan->mutable_computed_columns(0)->set_name("int_val");
+    }
+
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_SCAN_SPEC, resp.error().code());
+  }
+}
+
 TEST_F(ScannerScansTest, TestNonPositiveLimitsShortCircuit) {
   InsertTestRowsDirect(0, 10);
   for (int limit : { -1, 0 }) {
@@ -3286,6 +3692,98 @@ TEST_F(ScannerScansTest, TestRandomizedScanLimits) {
   }
 }
 
+// Test that scans return the same rows when the scanners read them ahead of
+// the scan requests.
+TEST_F(ScannerScansTest, TestScanWithPrefetch) {
+  const int kNumRows = 1000;
+  FLAGS_scanner_batch_size_rows = 50;
+  InsertTestRowsDirect(0, kNumRows);
+
+  for (int limit : { 0, 123 }) {
+    SCOPED_TRACE(limit);
+    vector<string> results[2];
+    for (bool prefetch : { false, true }) {
+      FLAGS_scanner_prefetch_enabled = prefetch;
+      ScanRequestPB req;
+      ScanResponsePB resp;
+      RpcController rpc;
+      NewScanRequestPB* scan = req.mutable_new_scan_request();
+      scan->set_tablet_id(kTabletId);
+      scan->set_read_mode(READ_AT_SNAPSHOT);
+      scan->set_order_mode(ORDERED);
+      if (limit > 0) {
+        scan->set_limit(limit);
+      }
+      ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+      req.set_batch_size_bytes(1000);
+      ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+      ASSERT_FALSE(resp.has_error()) << SecureDebugString(resp);
+      ASSERT_TRUE(resp.has_more_results());
+      NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, &results[prefetch]));
+      NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema_, &results[prefetch]));
+    }
+    ASSERT_EQ(limit > 0 ? limit : kNumRows, results[true].size());
+    ASSERT_EQ(results[false], results[true]);
+  }
+
+  // Once the scanners are done, the memory of the rows read ahead is released.
+  ASSERT_EVENTUALLY([&] {
+    ASSERT_EQ(0, mini_server_->server()->scanner_manager()->prefetch_mem_tracker()->consumption());
+  });
+}
+
+// Test that the scan responses are cut short once the memory of the scan
+// responses reaches its limit.
+TEST_F(ScannerScansTest, TestScanResponseMemoryLimit) {
+  const int kNumRows = 1000;
+  FLAGS_scanner_batch_size_rows = 50;
+  FLAGS_scanner_response_memory_limit_mb = 1;
+  InsertTestRowsDirect(0, kNumRows);
+  const auto& mem_tracker = mini_server_->server()->scanner_manager()->response_mem_tracker();
+  auto batches_cut = METRIC_scanner_batches_cut_for_memory.Instantiate(
+      mini_server_->server()->metric_entity());
+
+  const auto scan = [&](vector<string>* results, string* scanner_id) {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+    req.set_batch_size_bytes(1024 * 1024);
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error()) << SecureDebugString(resp);
+    NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, results));
+    if (resp.has_more_results()) {
+      *scanner_id = resp.scanner_id();
+    }
+  };
+
+  // Over the limit, the response only has the first block of rows, and the
+  // rest of the rows can still be scanned.
+  mem_tracker->Consume(2 * 1024 * 1024);
+  vector<string> results;
+  string scanner_id;
+  NO_FATALS(scan(&results, &scanner_id));
+  ASSERT_EQ(50, results.size());
+  ASSERT_EQ(1, batches_cut->value());
+  ASSERT_FALSE(scanner_id.empty());
+  NO_FATALS(DrainScannerToStrings(scanner_id, schema_, &results));
+  ASSERT_EQ(kNumRows, results.size());
+  mem_tracker->Release(2 * 1024 * 1024);
+
+  // Under the limit, the response has all the rows.
+  results.clear();
+  scanner_id.clear();
+  const int64_t num_cut = batches_cut->value();
+  NO_FATALS(scan(&results, &scanner_id));
+  ASSERT_EQ(kNumRows, results.size());
+  ASSERT_EQ(num_cut, batches_cut->value());
+
+  // Once sent, the memory of the responses is released.
+  ASSERT_EQ(0, mem_tracker->consumption());
+}
+
 TEST_F(ScannerScansTest, TestScanWithPredicates) {
   int num_rows = AllowSlowTests() ? 10000 : 1000;
   InsertTestRowsDirect(0, num_rows);
@@ -3996,6 +4494,115 @@ TEST_F(TabletServerTest, TestSplitKeyRange) {
   }
 }
 
+TEST_F(TabletServerTest, TestLookupRows) {
+  // Put rows 0-9 in a disk rowset and rows 10-19 in the memrowset.
+  scoped_refptr<TabletReplica> replica;
+  ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet(kTabletId, &replica));
+  NO_FATALS(InsertTestRowsDirect(0, 10));
+  ASSERT_OK(replica->tablet()->Flush());
+  NO_FATALS(InsertTestRowsDirect(10, 10));
+
+  const auto encode_key = [&](int32_t key) {
+    KuduPartialRow row(&schema_);
+    CHECK_OK(row.SetInt32(0, key));
+    string encoded;
+    CHECK_OK(row.EncodeRowKey(&encoded));
+    return encoded;
+  };
+
+  LookupRowsRequestPB req;
+  req.set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, req.mutable_projected_columns()));
+  for (int32_t key : { 3, 12, 15, 50 }) {
+    req.add_primary_keys(encode_key(key));
+  }
+  {
+    LookupRowsResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->LookupRows(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_EQ(vector<uint32_t>({ 0, 1, 2 }),
+              vector<uint32_t>(resp.found_key_indexes().begin(),
+                               resp.found_key_indexes().end()));
+
+    ScanResponsePB scan_resp;
+    scan_resp.mutable_data()->Swap(resp.mutable_data());
+    vector<string> results;
+    NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &scan_resp, &results));
+    ASSERT_EQ(vector<string>({
+        R"((int32 key=3, int32 int_val=6, string string_val="hello 3"))",
+        R"((int32 key=12, int32 int_val=24, string string_val="hello 12"))",
+        R"((int32 key=15, int32 int_val=30, string string_val="hello 15"))" }),
+        results);
+  }
+
+  // The keys must be sorted.
+  req.add_primary_keys(encode_key(1));
+  {
+    LookupRowsResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->LookupRows(req, &resp, &rpc));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_SCAN_SPEC, resp.error().code());
+  }
+}
+
+TEST_F(TabletServerTest, TestGetTabletChanges) {
+  scoped_refptr<TabletReplica> replica;
+  ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet(kTabletId, &replica));
+  const size_t num_anchors = replica->log_anchor_registry()->GetAnchorCountForTests();
+  NO_FATALS(InsertTestRowsRemote(0, 10, /*num_batches=*/5));
+
+  GetTabletChangesRequestPB req;
+  req.set_tablet_id(kTabletId);
+  req.set_subscriber_id("subscriber");
+  req.set_after_op_index(0);
+  int num_changes = 0;
+  int64_t committed_op_index = 0;
+  do {
+    GetTabletChangesResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->GetTabletChanges(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_GT(resp.last_op_index(), req.after_op_index());
+    for (const auto& change : resp.changes()) {
+      ASSERT_GT(change.op_id().index(), req.after_op_index());
+      ASSERT_LE(change.op_id().index(), resp.last_op_index());
+      ASSERT_TRUE(change.has_schema());
+      ASSERT_FALSE(change.row_operations().rows().empty());
+      num_changes++;
+    }
+    req.set_after_op_index(resp.last_op_index());
+    committed_op_index = resp.committed_op_index();
+
+    // Each subscriber holds a single anchor on the log.
+    ASSERT_EQ(num_anchors + 1, replica->log_anchor_registry()->GetAnchorCountForTests());
+  } while (req.after_op_index() < committed_op_index);
+  ASSERT_EQ(5, num_changes);
+
+  // Once caught up, there are no more changes.
+  {
+    GetTabletChangesResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->GetTabletChanges(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_TRUE(resp.changes().empty());
+    ASSERT_EQ(req.after_op_index(), resp.last_op_index());
+  }
+
+  // Unsubscribing releases the anchor.
+  req.set_unsubscribe(true);
+  {
+    GetTabletChangesResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->GetTabletChanges(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_EQ(num_anchors, replica->log_anchor_registry()->GetAnchorCountForTests());
+  }
+}
+
 TEST_F(TabletServerTest, TestAlterSchema) {
   AlterSchemaRequestPB req;
   AlterSchemaResponsePB resp;
@@ -4119,6 +4726,44 @@ TEST_F(TabletServerTest, TestCreateTablet_TabletExists) {
   }
 }
 
+TEST_F(TabletServerTest, TestCreateTablets) {
+  CreateTabletsRequestPB req;
+  CreateTabletsResponsePB resp;
+  RpcController rpc;
+
+  req.set_dest_uuid(mini_server_->server()->fs_manager()->uuid());
+  Schema schema = SchemaBuilder(schema_).Build();
+  const vector<string> tablet_ids = { kTabletId, "NewTablet1", "NewTablet2" };
+  for (int i = 0; i < tablet_ids.size(); i++) {
+    CreateTabletRequestPB* tablet_req = req.add_requests();
+    tablet_req->set_table_id("testtb");
+    tablet_req->set_tablet_id(tablet_ids[i]);
+    PartitionPB* partition = tablet_req->mutable_partition();
+    partition->set_partition_key_start(Substitute("$0", i));
+    partition->set_partition_key_end(Substitute("$0", i + 1));
+    tablet_req->set_table_name("testtb");
+    tablet_req->mutable_config()->CopyFrom(mini_server_->CreateLocalConfig());
+    ASSERT_OK(SchemaToPB(schema, tablet_req->mutable_schema()));
+  }
+
+  // Each tablet is created on its own, and gets its own response.
+  {
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(admin_proxy_->CreateTablets(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_EQ(3, resp.responses_size());
+    ASSERT_TRUE(resp.responses(0).has_error());
+    ASSERT_EQ(TabletServerErrorPB::TABLET_ALREADY_EXISTS, resp.responses(0).error().code());
+    ASSERT_FALSE(resp.responses(1).has_error());
+    ASSERT_FALSE(resp.responses(2).has_error());
+  }
+  for (const auto& tablet_id : tablet_ids) {
+    scoped_refptr<TabletReplica> replica;
+    ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet(tablet_id, &replica));
+  }
+}
+
 TEST_F(TabletServerTest, TestDeleteTablet) {
   scoped_refptr<TabletReplica> tablet;
 
@@ -4192,6 +4837,50 @@ TEST_F(TabletServerTest, TestDeleteTablet) {
   ASSERT_FALSE(mini_server_->server()->tablet_manager()->LookupTablet(kTabletId, &tablet));
 }
 
+TEST_F(TabletServerTest, TestDeleteTablets) {
+  scoped_refptr<TabletReplica> tablet;
+  NO_FATALS(InsertTestRowsRemote(1, 1));
+  tablet_replica_.reset();
+
+  DeleteTabletsRequestPB req;
+  DeleteTabletsResponsePB resp;
+  RpcController rpc;
+
+  // A batch addressed to another server is rejected as a whole.
+  req.set_dest_uuid("wrong-uuid");
+  for (const auto& tablet_id : { kTabletId, "NotPresentTabletId" }) {
+    DeleteTabletRequestPB* tablet_req = req.add_requests();
+    tablet_req->set_tablet_id(tablet_id);
+    tablet_req->set_delete_type(tablet::TABLET_DATA_DELETED);
+  }
+  {
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(admin_proxy_->DeleteTablets(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::WRONG_SERVER_UUID, resp.error().code());
+    ASSERT_EQ(0, resp.responses_size());
+  }
+  ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet(kTabletId, &tablet));
+  tablet.reset();
+
+  // Otherwise, each tablet is deleted on its own, and gets its own response.
+  req.set_dest_uuid(mini_server_->server()->fs_manager()->uuid());
+  resp.Clear();
+  rpc.Reset();
+  {
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(admin_proxy_->DeleteTablets(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_EQ(2, resp.responses_size());
+    ASSERT_FALSE(resp.responses(0).has_error());
+    ASSERT_TRUE(resp.responses(1).has_error());
+    ASSERT_EQ(TabletServerErrorPB::TABLET_NOT_FOUND, resp.responses(1).error().code());
+  }
+  ASSERT_FALSE(mini_server_->server()->tablet_manager()->LookupTablet(kTabletId, &tablet));
+}
+
 TEST_F(TabletServerTest, TestDeleteTablet_TabletNotCreated) {
   scoped_refptr<Histogram> delete_tablet_run_time =
       METRIC_delete_tablet_run_time.Instantiate(mini_server_->server()->metric_entity());
@@ -4532,6 +5221,65 @@ TEST_F(TabletServerTest, TestChecksumScan) {
   ASSERT_FALSE(resp.has_more_results());
 }
 
+// Test that the snapshot checksum scans reuse the checksums of the rowsets
+// which didn't change since the previous checksum scans.
+TEST_F(TabletServerTest, TestChecksumScanReusesRowSetChecksums) {
+  Tablet* tablet = tablet_replica_->tablet();
+  InsertTestRowsRemote(0, 10);
+  ASSERT_OK(tablet->Flush());
+  InsertTestRowsRemote(10, 10);
+  ASSERT_OK(tablet->Flush());
+
+  const auto checksum = [&](bool reuse, uint64_t* crc) {
+    ChecksumRequestPB req;
+    req.mutable_new_request()->set_tablet_id(kTabletId);
+    req.mutable_new_request()->set_read_mode(READ_AT_SNAPSHOT);
+    req.set_call_seq_id(0);
+    req.set_reuse_rowset_checksums(reuse);
+    ASSERT_OK(SchemaToColumnPBs(schema_, req.mutable_new_request()->mutable_projected_columns(),
+                                SCHEMA_PB_WITHOUT_IDS));
+    ChecksumResponsePB resp;
+    RpcController controller;
+    ASSERT_OK(proxy_->Checksum(req, &resp, &controller));
+    ASSERT_FALSE(resp.has_error()) << SecureDebugString(resp.error());
+    ASSERT_FALSE(resp.has_more_results());
+    ASSERT_EQ(20, resp.rows_checksummed());
+    *crc = resp.checksum();
+  };
+  const auto& rowsets_reused = tablet->metrics()->checksum_rowsets_reused;
+
+  // The first scan caches the checksums of both rowsets, which the second one
+  // reuses, with the same result as a scan without the cache.
+  uint64_t expected_crc;
+  NO_FATALS(checksum(false, &expected_crc));
+  ASSERT_EQ(0, tablet->rowset_checksum_cache().size());
+  uint64_t crc;
+  NO_FATALS(checksum(true, &crc));
+  ASSERT_EQ(expected_crc, crc);
+  ASSERT_EQ(0, rowsets_reused->value());
+  ASSERT_EQ(2, tablet->rowset_checksum_cache().size());
+  NO_FATALS(checksum(true, &crc));
+  ASSERT_EQ(expected_crc, crc);
+  ASSERT_EQ(2, rowsets_reused->value());
+
+  // Once a row of a rowset is updated, only the other rowset is reused.
+  NO_FATALS(UpdateTestRowRemote(1, 12345));
+  NO_FATALS(checksum(false, &expected_crc));
+  NO_FATALS(checksum(true, &crc));
+  ASSERT_EQ(expected_crc, crc);
+  ASSERT_EQ(3, rowsets_reused->value());
+  NO_FATALS(checksum(true, &crc));
+  ASSERT_EQ(expected_crc, crc);
+  ASSERT_EQ(5, rowsets_reused->value());
+
+  // The checksums of the compacted rowsets are dropped.
+  ASSERT_OK(tablet->Compact(Tablet::FORCE_COMPACT_ALL));
+  NO_FATALS(checksum(true, &crc));
+  ASSERT_EQ(expected_crc, crc);
+  ASSERT_EQ(5, rowsets_reused->value());
+  ASSERT_EQ(1, tablet->rowset_checksum_cache().size());
+}
+
 class DelayFsyncLogHook : public log::LogFaultHooks {
  public:
   DelayFsyncLogHook() : log_latch1_(1), test_latch1_(1) {}
@@ -5300,5 +6048,47 @@ TEST_F(OpPrepareQueueTest, RequestTimesOutInPrepareQueue) {
   ASSERT_TRUE(s.IsTimedOut()) << s.ToString();
 }
 
+// Test that the requests batched by MultiUpdateConsensus() get their own
+// responses, including their errors.
+TEST_F(TabletServerTest, TestMultiUpdateConsensus) {
+  const string& uuid = mini_server_->server()->fs_manager()->uuid();
+  MultiConsensusRequestPB req;
+  req.set_dest_uuid(uuid);
+  for (const auto& tablet_id : { kTabletId, "nonexistent-tablet" }) {
+    ConsensusRequestPB* tablet_req = req.add_requests();
+    tablet_req->set_dest_uuid(uuid);
+    tablet_req->set_tablet_id(tablet_id);
+    tablet_req->set_caller_uuid("fake-leader");
+    // The term is lower than the one of the single-replica leader of the
+    // tablet.
+    tablet_req->set_caller_term(0);
+  }
+  {
+    MultiConsensusResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(consensus_proxy_->MultiUpdateConsensus(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_EQ(2, resp.responses_size());
+    ASSERT_FALSE(resp.responses(0).has_error());
+    ASSERT_EQ(uuid, resp.responses(0).responder_uuid());
+    ASSERT_EQ(ConsensusErrorPB::INVALID_TERM,
+              resp.responses(0).status().error().code());
+    ASSERT_TRUE(resp.responses(1).has_error());
+    ASSERT_EQ(TabletServerErrorPB::TABLET_NOT_FOUND, resp.responses(1).error().code());
+  }
+
+  // A batch sent to another server is rejected as a whole.
+  req.set_dest_uuid("wrong-uuid");
+  {
+    MultiConsensusResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(consensus_proxy_->MultiUpdateConsensus(req, &resp, &rpc));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::WRONG_SERVER_UUID, resp.error().code());
+    ASSERT_EQ(0, resp.responses_size());
+  }
+}
+
 } // namespace tserver
 } // namespace kudu
@@ -25,23 +25,40 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/common/schema.h"
 #include "kudu/fs/error_manager.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/fs/fs_mm_ops.h"
+#include "kudu/fs/log_block_manager.h"
+#include "kudu/gutil/strings/escaping.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/periodic.h"
 #include "kudu/rpc/service_if.h"
+#include "kudu/server/diagnostics_log.h"
 #include "kudu/server/rpc_server.h"
 #include "kudu/server/startup_path_handler.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_replica.h"
 #include "kudu/transactions/txn_system_client.h"
+#include "kudu/tserver/change_streams.h"
+#include "kudu/tserver/scan_bloom_filters.h"
 #include "kudu/tserver/heartbeater.h"
+#include "kudu/tserver/resource_quotas.h"
 #include "kudu/tserver/scanners.h"
 #include "kudu/tserver/tablet_copy_service.h"
 #include "kudu/tserver/tablet_service.h"
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/tserver/tserver_path_handlers.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/hot_key_tracker.h"
+#include "kudu/util/jsonwriter.h"
+#include "kudu/util/logging.h"
 #include "kudu/util/maintenance_manager.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/net/dns_resolver.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/status.h"
@@ -50,9 +67,20 @@ namespace kudu {
 class Timer;
 } // namespace kudu
 
+DEFINE_int32(diagnostics_log_hot_key_min_permille, 100,
+             "The hot keys of a tablet are written to the diagnostics log along with "
+             "the metrics if its most accessed key or key range accounts for at least "
+             "this many parts per thousand of its sampled accesses. See "
+             "--tablet_hot_key_sampling_rate.");
+TAG_FLAG(diagnostics_log_hot_key_min_permille, experimental);
+TAG_FLAG(diagnostics_log_hot_key_min_permille, runtime);
+
 using kudu::fs::ErrorHandlerType;
 using kudu::rpc::ServiceIf;
+using kudu::tablet::Tablet;
+using kudu::tablet::TabletReplica;
 using kudu::transactions::TxnSystemClientInitializer;
+using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -68,6 +96,9 @@ TabletServer::TabletServer(const TabletServerOptions& opts)
       opts_(opts),
       tablet_manager_(new TSTabletManager(this)),
       scanner_manager_(new ScannerManager(metric_entity())),
+      quota_manager_(new ResourceQuotaManager),
+      change_stream_manager_(new ChangeStreamManager),
+      scan_bloom_filters_(new ScanBloomFilterRegistry),
       path_handlers_(new TabletServerPathHandlers(this)) {
 }
 
@@ -158,6 +189,10 @@ Status TabletServer::Start() {
   RETURN_NOT_OK(RegisterService(std::move(consensus_service)));
   RETURN_NOT_OK(RegisterService(std::move(tablet_copy_service)));
   RETURN_NOT_OK(KuduServer::Start());
+  if (diagnostics_log()) {
+    diagnostics_log()->AddRecordSource(
+        "hot_keys", [this](JsonWriter* writer) { this->WriteHotKeys(writer); });
+  }
 
   if (web_server_) {
     RETURN_NOT_OK(path_handlers_->Register(web_server_.get()));
@@ -165,6 +200,22 @@ Status TabletServer::Start() {
 
   RETURN_NOT_OK(heartbeater_->Start());
   RETURN_NOT_OK(maintenance_manager_->Start());
+  change_stream_gc_timer_ = rpc::PeriodicTimer::Create(
+      messenger_,
+      [this]() { change_stream_manager_->RemoveExpiredSubscriptions(MonoTime::Now()); },
+      MonoDelta::FromSeconds(1));
+  change_stream_gc_timer_->Start();
+  scan_bloom_filter_gc_timer_ = rpc::PeriodicTimer::Create(
+      messenger_,
+      [this]() { scan_bloom_filters_->RemoveExpiredFilters(MonoTime::Now()); },
+      MonoDelta::FromSeconds(1));
+  scan_bloom_filter_gc_timer_->Start();
+  // Only the log block manager's containers may get fragmented.
+  auto* lbm = dynamic_cast<fs::LogBlockManager*>(fs_manager_->block_manager().get());
+  if (lbm && !fs_manager_->read_only()) {
+    defrag_op_.reset(new fs::DefragmentContainersOp(lbm, metric_entity()));
+    maintenance_manager_->RegisterOp(defrag_op_.get());
+  }
 
   google::FlushLogFiles(google::INFO); // Flush the startup messages.
 
@@ -181,7 +232,16 @@ void TabletServer::ShutdownImpl() {
     UnregisterAllServices();
 
     // 2. Shut down the tserver's subsystems.
+    if (defrag_op_) {
+      defrag_op_->Unregister();
+    }
     maintenance_manager_->Shutdown();
+    if (change_stream_gc_timer_) {
+      change_stream_gc_timer_->Stop();
+    }
+    if (scan_bloom_filter_gc_timer_) {
+      scan_bloom_filter_gc_timer_->Stop();
+    }
     WARN_NOT_OK(heartbeater_->Stop(), "Failed to stop TS Heartbeat thread");
     fs_manager_->UnsetErrorNotificationCb(ErrorHandlerType::DISK_ERROR);
     fs_manager_->UnsetErrorNotificationCb(ErrorHandlerType::CFILE_CORRUPTION);
@@ -196,5 +256,49 @@ void TabletServer::ShutdownImpl() {
   state_ = kStopped;
 }
 
+void TabletServer::WriteHotKeys(JsonWriter* writer) const {
+  const uint64_t min_permille = FLAGS_diagnostics_log_hot_key_min_permille;
+  vector<scoped_refptr<TabletReplica>> replicas;
+  tablet_manager_->GetTabletReplicas(&replicas);
+  writer->StartArray();
+  for (const auto& replica : replicas) {
+    shared_ptr<Tablet> tablet = replica->shared_tablet();
+    if (!tablet ||
+        (tablet->hot_keys().HottestKeyPermille() < min_permille &&
+         tablet->hot_key_ranges().HottestKeyPermille() < min_permille)) {
+      continue;
+    }
+    writer->StartObject();
+    writer->String("tablet_id");
+    writer->String(replica->tablet_id());
+    writer->String("sampled_accesses");
+    writer->Uint64(tablet->hot_keys().total_count());
+    writer->String("keys");
+    writer->StartArray();
+    for (const auto& k : tablet->hot_keys().HotKeys()) {
+      writer->StartObject();
+      writer->String("key");
+      writer->String(KUDU_REDACT(tablet->schema()->DebugEncodedRowKey(k.key, Schema::START_KEY)));
+      writer->String("count");
+      writer->Uint64(k.count);
+      writer->EndObject();
+    }
+    writer->EndArray();
+    writer->String("ranges");
+    writer->StartArray();
+    for (const auto& r : tablet->hot_key_ranges().HotKeys()) {
+      writer->StartObject();
+      writer->String("prefix");
+      writer->String(KUDU_REDACT(strings::b2a_hex(r.key)));
+      writer->String("count");
+      writer->Uint64(r.count);
+      writer->EndObject();
+    }
+    writer->EndArray();
+    writer->EndObject();
+  }
+  writer->EndArray();
+}
+
 } // namespace tserver
 } // namespace kudu
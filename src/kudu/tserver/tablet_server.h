@@ -29,15 +29,27 @@
 
 namespace kudu {
 
+class JsonWriter;
 class MaintenanceManager;
 
+namespace rpc {
+class PeriodicTimer;
+} // namespace rpc
+
+namespace fs {
+class DefragmentContainersOp;
+} // namespace fs
+
 namespace transactions {
 class TxnSystemClientInitializer;
 } // namespace transactions
 
 namespace tserver {
 
+class ChangeStreamManager;
 class Heartbeater;
+class ResourceQuotaManager;
+class ScanBloomFilterRegistry;
 class ScannerManager;
 class TSTabletManager;
 class TabletServerPathHandlers;
@@ -73,6 +85,12 @@ class TabletServer : public kserver::KuduServer {
 
   ScannerManager* scanner_manager() { return scanner_manager_.get(); }
 
+  ResourceQuotaManager* quota_manager() { return quota_manager_.get(); }
+
+  ChangeStreamManager* change_stream_manager() { return change_stream_manager_.get(); }
+
+  ScanBloomFilterRegistry* scan_bloom_filters() { return scan_bloom_filters_.get(); }
+
   Heartbeater* heartbeater() { return heartbeater_.get(); }
 
   void set_fail_heartbeats_for_tests(bool fail_heartbeats_for_tests) {
@@ -113,6 +131,10 @@ class TabletServer : public kserver::KuduServer {
   // safe in a particular case.
   void ShutdownImpl();
 
+  // Writes the most accessed keys and key ranges of the tablets with hot keys
+  // to the diagnostics log. See --diagnostics_log_hot_key_min_permille.
+  void WriteHotKeys(JsonWriter* writer) const;
+
   TabletServerState state_;
 
   std::atomic<bool> quiescing_;
@@ -131,6 +153,21 @@ class TabletServer : public kserver::KuduServer {
   // dependencies.
   std::unique_ptr<ScannerManager> scanner_manager_;
 
+  // Enforces the scan and write quotas of the tables and the users.
+  std::unique_ptr<ResourceQuotaManager> quota_manager_;
+
+  // Anchors the logs of the tablets for the subscribers to their changes.
+  std::unique_ptr<ChangeStreamManager> change_stream_manager_;
+
+  // Drops the expired subscriptions of 'change_stream_manager_'.
+  std::shared_ptr<rpc::PeriodicTimer> change_stream_gc_timer_;
+
+  // The bloom filters shared by the scans of the tablets.
+  std::unique_ptr<ScanBloomFilterRegistry> scan_bloom_filters_;
+
+  // Drops the expired filters of 'scan_bloom_filters_'.
+  std::shared_ptr<rpc::PeriodicTimer> scan_bloom_filter_gc_timer_;
+
   // Thread that initializes a TxnSystemClient.
   std::unique_ptr<transactions::TxnSystemClientInitializer> client_initializer_;
 
@@ -143,6 +180,9 @@ class TabletServer : public kserver::KuduServer {
   // The maintenance manager for this tablet server
   std::shared_ptr<MaintenanceManager> maintenance_manager_;
 
+  // Defragments the log block containers, if the log block manager is in use.
+  std::unique_ptr<fs::DefragmentContainersOp> defrag_op_;
+
   DISALLOW_COPY_AND_ASSIGN(TabletServer);
 };
 
@@ -53,6 +53,8 @@
 #include "kudu/common/wire_protocol.h"
 #include "kudu/common/wire_protocol.pb.h"
 #include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/log.h"
+#include "kudu/consensus/log_reader.h"
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/raft_consensus.h"
@@ -65,9 +67,11 @@
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/template_util.h"
+#include "kudu/gutil/walltime.h"
 #include "kudu/rpc/inbound_call.h"
 #include "kudu/rpc/remote_user.h"
 #include "kudu/rpc/rpc_context.h"
@@ -85,6 +89,7 @@
 #include "kudu/tablet/ops/participant_op.h"
 #include "kudu/tablet/ops/write_op.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/rowset_checksum_cache.h"
 #include "kudu/tablet/tablet.h"
 #include "kudu/tablet/tablet.pb.h"
 #include "kudu/tablet/tablet_metadata.h"
@@ -93,6 +98,12 @@
 #include "kudu/tablet/txn_coordinator.h"
 #include "kudu/transactions/transactions.pb.h"
 #include "kudu/transactions/txn_status_manager.h"
+#include "kudu/tserver/change_streams.h"
+#include "kudu/tserver/resource_quotas.h"
+#include "kudu/tserver/scan_bloom_filters.h"
+#include "kudu/tserver/scan_buffer_pool.h"
+#include "kudu/tserver/scan_expressions.h"
+#include "kudu/tserver/scan_top_n.h"
 #include "kudu/tserver/scanners.h"
 #include "kudu/tserver/tablet_replica_lookup.h"
 #include "kudu/tserver/tablet_server.h"
@@ -100,12 +111,15 @@
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_admin.pb.h"
 #include "kudu/tserver/tserver_service.pb.h"
-#include "kudu/util/crc.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/cpu_profiler.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/mem_tracker.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
@@ -137,6 +151,54 @@ DEFINE_int32(scanner_batch_size_rows, 128,
 TAG_FLAG(scanner_batch_size_rows, advanced);
 TAG_FLAG(scanner_batch_size_rows, runtime);
 
+DEFINE_bool(scanner_adaptive_batch_size, false,
+            "Whether to size the batches of the scans which don't ask for a batch "
+            "size according to how fast their clients consume them, rather than "
+            "using --scanner_default_batch_size_bytes. The batches start small "
+            "and grow while the clients keep up, up to "
+            "--scanner_max_batch_size_bytes, and shrink when they take longer "
+            "than --scanner_batch_time_budget_ms to fill. They don't grow while "
+            "the server is under memory pressure.");
+TAG_FLAG(scanner_adaptive_batch_size, experimental);
+TAG_FLAG(scanner_adaptive_batch_size, runtime);
+
+DEFINE_int32(scanner_batch_time_budget_ms, 500,
+             "The maximum amount of time (in milliseconds) spent filling a batch "
+             "of scan results. A batch is returned once it's this old, even if "
+             "it's smaller than its batch size.");
+TAG_FLAG(scanner_batch_time_budget_ms, advanced);
+TAG_FLAG(scanner_batch_time_budget_ms, runtime);
+
+DEFINE_int32(scan_executor_batch_time_slice_ms, 100,
+             "The maximum amount of time (in milliseconds) spent filling a batch "
+             "of the scans of the batch priority class of the scan executor, if "
+             "less than --scanner_batch_time_budget_ms. The scan executor threads "
+             "move on to the next queued scan request once it is spent, so that "
+             "long batch scans take turns. See --scan_executor_batch_num_threads.");
+TAG_FLAG(scan_executor_batch_time_slice_ms, experimental);
+TAG_FLAG(scan_executor_batch_time_slice_ms, runtime);
+
+namespace {
+
+bool ValidateBatchTimeBudget(const char* flagname, int32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(scanner_batch_time_budget_ms, &ValidateBatchTimeBudget);
+DEFINE_validator(scan_executor_batch_time_slice_ms, &ValidateBatchTimeBudget);
+
+DEFINE_int64(scanner_max_top_n_rows, 100000,
+             "The maximum number of rows of a top-N scan. The rows a top-N scanner "
+             "returns are held in memory until the whole tablet has been scanned.");
+TAG_FLAG(scanner_max_top_n_rows, advanced);
+TAG_FLAG(scanner_max_top_n_rows, runtime);
+
 DEFINE_bool(scanner_allow_snapshot_scans_with_logical_timestamps, false,
             "If set, the server will support snapshot scans with logical timestamps.");
 TAG_FLAG(scanner_allow_snapshot_scans_with_logical_timestamps, unsafe);
@@ -166,6 +228,14 @@ DEFINE_bool(scanner_unregister_on_invalid_seq_id, true,
             "Used for tests.");
 TAG_FLAG(scanner_unregister_on_invalid_seq_id, unsafe);
 
+DEFINE_bool(scanner_register_after_first_batch, true,
+            "If set, the scanner of a new scan request which asks for rows is only "
+            "registered once its first batch is returned, if the scan has more rows. "
+            "The scans whose results fit in a single response then never register a "
+            "scanner, though they don't show up as active scans while running.");
+TAG_FLAG(scanner_register_after_first_batch, advanced);
+TAG_FLAG(scanner_register_after_first_batch, runtime);
+
 
 DEFINE_bool(tserver_enforce_access_control, false,
             "If set, the server will apply fine-grained access control rules "
@@ -182,6 +252,7 @@ DEFINE_bool(tserver_txn_write_op_handling_enabled, true,
 TAG_FLAG(tserver_txn_write_op_handling_enabled, hidden);
 
 DECLARE_bool(enable_txn_system_client_init);
+DECLARE_bool(raft_enable_leader_leases);
 DECLARE_bool(raft_prepare_replacement_before_eviction);
 DECLARE_int32(memory_limit_warn_threshold_percentage);
 DECLARE_int32(tablet_history_max_age_sec);
@@ -195,6 +266,15 @@ METRIC_DEFINE_counter(
     "Number of rejected write requests due to overloaded op apply queue",
     kudu::MetricLevel::kWarn);
 
+METRIC_DEFINE_counter(
+    server,
+    scanner_batches_cut_for_memory,
+    "Scan Batches Cut Short For Memory",
+    kudu::MetricUnit::kRequests,
+    "Number of scan responses cut short because the memory used by the scan "
+    "responses of the tablet server reached --scanner_response_memory_limit_mb",
+    kudu::MetricLevel::kInfo);
+
 using google::protobuf::RepeatedPtrField;
 using kudu::consensus::BulkChangeConfigRequestPB;
 using kudu::consensus::ChangeConfigRequestPB;
@@ -207,6 +287,8 @@ using kudu::consensus::GetNodeInstanceResponsePB;
 using kudu::consensus::LeaderStepDownMode;
 using kudu::consensus::LeaderStepDownRequestPB;
 using kudu::consensus::LeaderStepDownResponsePB;
+using kudu::consensus::MultiConsensusRequestPB;
+using kudu::consensus::MultiConsensusResponsePB;
 using kudu::consensus::OpId;
 using kudu::consensus::RaftConsensus;
 using kudu::consensus::RaftPeerPB;
@@ -230,6 +312,8 @@ using kudu::security::TokenPB;
 using kudu::security::TokenVerifier;
 using kudu::server::ServerBase;
 using kudu::tablet::AlterSchemaOpState;
+using kudu::tablet::ColumnStatsPB;
+using kudu::tablet::MvccManager;
 using kudu::tablet::MvccSnapshot;
 using kudu::tablet::OpCompletionCallback;
 using kudu::tablet::ParticipantOpState;
@@ -294,24 +378,34 @@ bool LookupTabletReplicaOrRespond(TabletReplicaLookupIf* tablet_manager,
   return true;
 }
 
-template<class RespClass>
-void RespondTabletNotRunning(const scoped_refptr<TabletReplica>& replica,
+// Returns the error to report for 'replica' not being RUNNING, with its code
+// in 'error_code'.
+Status TabletNotRunningError(const scoped_refptr<TabletReplica>& replica,
                              TabletStatePB tablet_state,
-                             RespClass* resp,
-                             RpcContext* context) {
+                             TabletServerErrorPB::Code* error_code) {
   Status s = Status::IllegalState("Tablet not RUNNING",
                                   tablet::TabletStatePB_Name(tablet_state));
-  auto error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
+  *error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
   if (replica->tablet_metadata()->tablet_data_state() == TABLET_DATA_TOMBSTONED ||
       replica->tablet_metadata()->tablet_data_state() == TABLET_DATA_DELETED) {
     // Treat tombstoned tablets as if they don't exist for most purposes.
     // This takes precedence over failed, since we don't reset the failed
     // status of a TabletReplica when deleting it. Only tablet copy does that.
-    error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
+    *error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
   } else if (tablet_state == tablet::FAILED) {
     s = s.CloneAndAppend(replica->error().ToString());
-    error_code = TabletServerErrorPB::TABLET_FAILED;
+    *error_code = TabletServerErrorPB::TABLET_FAILED;
   }
+  return s;
+}
+
+template<class RespClass>
+void RespondTabletNotRunning(const scoped_refptr<TabletReplica>& replica,
+                             TabletStatePB tablet_state,
+                             RespClass* resp,
+                             RpcContext* context) {
+  TabletServerErrorPB::Code error_code;
+  Status s = TabletNotRunningError(replica, tablet_state, &error_code);
   SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
 }
 
@@ -349,6 +443,34 @@ bool LookupRunningTabletReplicaOrRespond(TabletReplicaLookupIf* tablet_manager,
   return true;
 }
 
+// Submits 'req' to the RaftConsensus instance of its replica, without
+// responding to any RPC. On failure, returns the error with its code in
+// 'error_code'.
+Status UpdateReplicaConsensus(TabletReplicaLookupIf* tablet_manager,
+                              const ConsensusRequestPB& req,
+                              ConsensusResponsePB* resp,
+                              TabletServerErrorPB::Code* error_code) {
+  scoped_refptr<TabletReplica> replica;
+  Status s = tablet_manager->GetTabletReplica(req.tablet_id(), &replica);
+  if (PREDICT_FALSE(!s.ok())) {
+    *error_code = s.IsServiceUnavailable() ? TabletServerErrorPB::UNKNOWN_ERROR
+                                           : TabletServerErrorPB::TABLET_NOT_FOUND;
+    return s;
+  }
+  const TabletStatePB state = replica->state();
+  if (PREDICT_FALSE(state != tablet::RUNNING)) {
+    return TabletNotRunningError(replica, state, error_code);
+  }
+  shared_ptr<RaftConsensus> consensus = replica->shared_consensus();
+  if (PREDICT_FALSE(!consensus)) {
+    *error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
+    return Status::ServiceUnavailable("Raft Consensus unavailable",
+                                      "Tablet replica not initialized");
+  }
+  *error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+  return consensus->Update(&req, resp);
+}
+
 template<class ReqClass, class RespClass>
 bool CheckUuidMatchOrRespond(TabletReplicaLookupIf* tablet_manager,
                              const char* method_name,
@@ -730,6 +852,12 @@ class TxnWriteCompletionCallback : public RpcOpCompletionCallback<WriteResponseP
 // Generic interface to handle scan results.
 class ScanResultCollector {
  public:
+  virtual ~ScanResultCollector() {
+    if (mem_tracker_) {
+      mem_tracker_->Release(tracked_bytes_);
+    }
+  }
+
   virtual void HandleRowBlock(Scanner* scanner,
                               const RowBlock& row_block) = 0;
 
@@ -747,6 +875,7 @@ class ScanResultCollector {
   //
   // Does nothing by default.
   virtual Status InitSerializer(uint64_t /* row_format_flags */,
+                                const RepeatedPtrField<ColumnAggregatePB>& /* aggregates */,
                                 const Schema& /* scanner_schema */,
                                 const Schema& /* client_schema */) {
     return Status::OK();
@@ -756,8 +885,31 @@ class ScanResultCollector {
     return &cpu_times_;
   }
 
+  // Returns the state of the checksum scan reusing the checksums of the
+  // rowsets, if the collected scan is one.
+  virtual tablet::ChecksumScanState* checksum_scan() {
+    return nullptr;
+  }
+
+  // Accounts the growth of the response since the last call to 'tracker',
+  // until the collector is destroyed, i.e. the response is sent.
+  void TrackResponseMemory(const shared_ptr<MemTracker>& tracker) {
+    DCHECK(!mem_tracker_ || mem_tracker_ == tracker);
+    const int64_t bytes = ResponseSize() - tracked_bytes_;
+    if (bytes <= 0) {
+      return;
+    }
+    mem_tracker_ = tracker;
+    tracked_bytes_ += bytes;
+    tracker->Consume(bytes);
+  }
+
  private:
   CpuTimes cpu_times_;
+
+  // The tracker of the memory of the response, set by TrackResponseMemory().
+  shared_ptr<MemTracker> mem_tracker_;
+  int64_t tracked_bytes_ = 0;
 };
 
 namespace {
@@ -800,15 +952,22 @@ class ResultSerializer {
 
 class RowwiseResultSerializer : public ResultSerializer {
  public:
-  RowwiseResultSerializer(int batch_size_bytes, uint64_t flags)
-      : rows_data_(batch_size_bytes * 11 / 10),
-        indirect_data_(batch_size_bytes * 11 / 10),
+  RowwiseResultSerializer(int batch_size_bytes, uint64_t flags, ScanBufferPool* buffer_pool)
+      : buffer_pool_(buffer_pool),
+        rows_data_(buffer_pool->GetBuffer(batch_size_bytes * 11 / 10)),
+        indirect_data_(buffer_pool->GetBuffer(batch_size_bytes * 11 / 10)),
         pad_unixtime_micros_to_16_bytes_(flags & RowFormatFlags::PAD_UNIX_TIME_MICROS_TO_16_BYTES) {
     // TODO(todd): use a chain of faststrings instead of a single one to avoid
     // allocating this large buffer. Large buffer allocations are slow and
     // potentially wasteful.
   }
 
+  ~RowwiseResultSerializer() override {
+    // Return the buffers which weren't sent, if any.
+    buffer_pool_->ReturnBuffer(std::move(rows_data_));
+    buffer_pool_->ReturnBuffer(std::move(indirect_data_));
+  }
+
   int SerializeRowBlock(const RowBlock& row_block,
                         const Schema* client_projection_schema) override {
     // TODO(todd) create some kind of serializer object that caches the projection
@@ -832,19 +991,20 @@ class RowwiseResultSerializer : public ResultSerializer {
     // Add sidecar data to context and record the returned indices.
     int rows_idx;
     CHECK_OK(context->AddOutboundSidecar(
-        RpcSidecar::FromFaststring((std::move(rows_data_))), &rows_idx));
+        buffer_pool_->NewSidecar(std::move(rows_data_)), &rows_idx));
     resp->mutable_data()->set_rows_sidecar(rows_idx);
 
     // Add indirect data as a sidecar, if applicable.
     if (indirect_data_.size() > 0) {
       int indirect_idx;
       CHECK_OK(context->AddOutboundSidecar(
-          RpcSidecar::FromFaststring(std::move(indirect_data_)), &indirect_idx));
+          buffer_pool_->NewSidecar(std::move(indirect_data_)), &indirect_idx));
       resp->mutable_data()->set_indirect_data_sidecar(indirect_idx);
     }
   }
 
  private:
+  ScanBufferPool* const buffer_pool_;
   RowwiseRowBlockPB rowblock_pb_;
   faststring rows_data_;
   faststring indirect_data_;
@@ -859,11 +1019,19 @@ class ColumnarResultSerializer : public ResultSerializer {
                        const Schema& scanner_schema,
                        const Schema& client_schema,
                        unique_ptr<ResultSerializer>* serializer) {
-    if (flags & ~RowFormatFlags::COLUMNAR_LAYOUT) {
+    if (flags & ~(RowFormatFlags::COLUMNAR_LAYOUT | RowFormatFlags::ARROW_LAYOUT |
+                  RowFormatFlags::UNDEFINED_NULL_VALUES | RowFormatFlags::COMPRESSED_COLUMNS)) {
       return Status::InvalidArgument("Row format flags not supported with columnar layout");
     }
+    const CompressionCodec* codec = nullptr;
+    if (flags & RowFormatFlags::COMPRESSED_COLUMNS) {
+      RETURN_NOT_OK(GetCompressionCodec(CompressionType::LZ4, &codec));
+    }
     serializer->reset(new ColumnarResultSerializer(
-        scanner_schema, client_schema, batch_size_bytes));
+        scanner_schema, client_schema, batch_size_bytes,
+        flags & RowFormatFlags::ARROW_LAYOUT,
+        !(flags & RowFormatFlags::UNDEFINED_NULL_VALUES),
+        codec));
     return Status::OK();
   }
 
@@ -898,21 +1066,26 @@ class ColumnarResultSerializer : public ResultSerializer {
     auto cols = std::move(results_).TakeColumns();
     for (auto& col : cols) {
       auto* col_pb = data->add_columns();
-      int sidecar_idx;
-      CHECK_OK(context->AddOutboundSidecar(
-          RpcSidecar::FromFaststring((std::move(col.data))), &sidecar_idx));
-      col_pb->set_data_sidecar(sidecar_idx);
+      optional<int64_t> uncompressed_size;
+      col_pb->set_data_sidecar(AddSidecar(context, std::move(col.data), &uncompressed_size));
+      if (uncompressed_size) {
+        col_pb->set_data_uncompressed_size(*uncompressed_size);
+      }
 
       if (col.varlen_data) {
-        CHECK_OK(context->AddOutboundSidecar(
-            RpcSidecar::FromFaststring((std::move(*col.varlen_data))), &sidecar_idx));
-        col_pb->set_varlen_data_sidecar(sidecar_idx);
+        col_pb->set_varlen_data_sidecar(
+            AddSidecar(context, std::move(*col.varlen_data), &uncompressed_size));
+        if (uncompressed_size) {
+          col_pb->set_varlen_data_uncompressed_size(*uncompressed_size);
+        }
       }
 
       if (col.non_null_bitmap) {
-        CHECK_OK(context->AddOutboundSidecar(
-            RpcSidecar::FromFaststring((std::move(*col.non_null_bitmap))), &sidecar_idx));
-        col_pb->set_non_null_bitmap_sidecar(sidecar_idx);
+        col_pb->set_non_null_bitmap_sidecar(
+            AddSidecar(context, std::move(*col.non_null_bitmap), &uncompressed_size));
+        if (uncompressed_size) {
+          col_pb->set_non_null_bitmap_uncompressed_size(*uncompressed_size);
+        }
       }
     }
     data->set_num_rows(num_rows_);
@@ -921,15 +1094,250 @@ class ColumnarResultSerializer : public ResultSerializer {
  private:
   ColumnarResultSerializer(const Schema& scanner_schema,
                            const Schema& client_schema,
-                           int batch_size_bytes)
-      : results_(scanner_schema, client_schema, batch_size_bytes) {
+                           int batch_size_bytes,
+                           bool arrow_layout,
+                           bool zero_null_values,
+                           const CompressionCodec* codec)
+      : results_(scanner_schema, client_schema, batch_size_bytes, arrow_layout,
+                 zero_null_values),
+        codec_(codec) {
+  }
+
+  // Adds 'buf' as an outbound sidecar of 'context' and returns its index. If the
+  // sidecars are compressed and 'buf' shrinks when compressed, the compressed data
+  // is sent instead and 'uncompressed_size' is set to the size of 'buf'.
+  int AddSidecar(RpcContext* context, faststring buf, optional<int64_t>* uncompressed_size) {
+    uncompressed_size->reset();
+    if (codec_ && !buf.empty()) {
+      faststring compressed;
+      compressed.resize(codec_->MaxCompressedLength(buf.size()));
+      size_t compressed_size;
+      Status s = codec_->Compress(Slice(buf), compressed.data(), &compressed_size);
+      if (s.ok() && compressed_size < buf.size()) {
+        compressed.resize(compressed_size);
+        *uncompressed_size = buf.size();
+        buf = std::move(compressed);
+      }
+    }
+    int sidecar_idx;
+    CHECK_OK(context->AddOutboundSidecar(RpcSidecar::FromFaststring(std::move(buf)),
+                                         &sidecar_idx));
+    return sidecar_idx;
   }
 
   int64_t num_rows_ = 0;
   ColumnarSerializedBatch results_;
+  // The codec compressing the sidecars, or nullptr if they're sent uncompressed.
+  const CompressionCodec* const codec_;
   bool done_ = false;
 };
 
+// Evaluates the scan's aggregates over the selected rows instead of
+// serializing them, returning one partial result per aggregate.
+class AggregateResultSerializer : public ResultSerializer {
+ public:
+  static Status Create(uint64_t flags,
+                       const RepeatedPtrField<ColumnAggregatePB>& aggregates,
+                       const Schema& scanner_schema,
+                       const Schema& client_schema,
+                       unique_ptr<ResultSerializer>* serializer) {
+    if (flags != RowFormatFlags::NO_FLAGS) {
+      return Status::InvalidArgument("Row format flags not supported with aggregates");
+    }
+    vector<AggregateState> states;
+    states.reserve(aggregates.size());
+    for (const auto& agg : aggregates) {
+      AggregateState state;
+      state.type = agg.type();
+      if (!agg.has_column_idx()) {
+        if (agg.type() != ColumnAggregatePB::COUNT) {
+          return Status::InvalidArgument(Substitute(
+              "$0 aggregate requires a column",
+              ColumnAggregatePB::Type_Name(agg.type())));
+        }
+        states.emplace_back(std::move(state));
+        continue;
+      }
+      if (agg.column_idx() < 0 ||
+          static_cast<size_t>(agg.column_idx()) >= client_schema.num_columns()) {
+        return Status::InvalidArgument(Substitute(
+            "invalid aggregate column index $0", agg.column_idx()));
+      }
+      const ColumnSchema& col = client_schema.column(agg.column_idx());
+      state.col_idx = scanner_schema.find_column(col.name());
+      DCHECK_NE(Schema::kColumnNotFound, state.col_idx);
+      state.type_info = col.type_info();
+      switch (agg.type()) {
+        case ColumnAggregatePB::COUNT:
+        case ColumnAggregatePB::MIN:
+        case ColumnAggregatePB::MAX:
+          break;
+        case ColumnAggregatePB::SUM:
+          switch (state.type_info->type()) {
+            case INT8:
+            case INT16:
+            case INT32:
+            case INT64:
+            case FLOAT:
+            case DOUBLE:
+              break;
+            default:
+              return Status::InvalidArgument(Substitute(
+                  "SUM aggregate not supported for column $0 of type $1",
+                  col.name(), state.type_info->name()));
+          }
+          break;
+        default:
+          return Status::InvalidArgument("unknown aggregate type");
+      }
+      states.emplace_back(std::move(state));
+    }
+    serializer->reset(new AggregateResultSerializer(std::move(states)));
+    return Status::OK();
+  }
+
+  int SerializeRowBlock(const RowBlock& row_block,
+                        const Schema* /* unused */) override {
+    CHECK(!done_);
+    const SelectionVector* sel = row_block.selection_vector();
+    int n_sel = sel->CountSelected();
+    if (n_sel == 0) {
+      return 0;
+    }
+    for (auto& state : states_) {
+      if (state.col_idx == Schema::kColumnNotFound) {
+        state.count += n_sel;
+        continue;
+      }
+      ColumnBlock cblock = row_block.column_block(state.col_idx);
+      sel->ForEachIndex([&](size_t i) {
+        if (cblock.is_null(i)) {
+          return;
+        }
+        state.Update(cblock.cell_ptr(i));
+      });
+    }
+    return n_sel;
+  }
+
+  size_t ResponseSize() const override {
+    // The partial results have a small, fixed size; responses are bounded
+    // by the scan time budget instead.
+    return 0;
+  }
+
+  void SetupResponse(RpcContext* /* context */, ScanResponsePB* resp) override {
+    CHECK(!done_);
+    done_ = true;
+    for (const auto& state : states_) {
+      auto* result = resp->add_aggregate_results();
+      result->set_count(state.count);
+      if (state.type == ColumnAggregatePB::COUNT || state.count == 0) {
+        continue;
+      }
+      if (state.type == ColumnAggregatePB::SUM) {
+        if (state.type_info->physical_type() == FLOAT ||
+            state.type_info->physical_type() == DOUBLE) {
+          result->set_value(&state.double_sum, sizeof(state.double_sum));
+        } else {
+          result->set_value(&state.int_sum, sizeof(state.int_sum));
+        }
+      } else {
+        result->set_value(state.value.data(), state.value.size());
+      }
+    }
+  }
+
+ private:
+  struct AggregateState {
+    // Accumulates the non-NULL cell pointed to by 'cell'.
+    void Update(const uint8_t* cell) {
+      count++;
+      switch (type) {
+        case ColumnAggregatePB::SUM:
+          switch (type_info->physical_type()) {
+            case INT8: int_sum += *reinterpret_cast<const int8_t*>(cell); break;
+            case INT16: int_sum += *reinterpret_cast<const int16_t*>(cell); break;
+            case INT32: int_sum += *reinterpret_cast<const int32_t*>(cell); break;
+            case INT64: int_sum += *reinterpret_cast<const int64_t*>(cell); break;
+            case FLOAT: double_sum += *reinterpret_cast<const float*>(cell); break;
+            case DOUBLE: double_sum += *reinterpret_cast<const double*>(cell); break;
+            default: LOG(FATAL) << "unexpected type " << type_info->name();
+          }
+          break;
+        case ColumnAggregatePB::MIN:
+        case ColumnAggregatePB::MAX: {
+          if (count > 1) {
+            int cmp;
+            if (type_info->physical_type() == BINARY) {
+              Slice cur(value);
+              cmp = type_info->Compare(cell, &cur);
+            } else {
+              cmp = type_info->Compare(cell, value.data());
+            }
+            if ((type == ColumnAggregatePB::MIN && cmp >= 0) ||
+                (type == ColumnAggregatePB::MAX && cmp <= 0)) {
+              break;
+            }
+          }
+          if (type_info->physical_type() == BINARY) {
+            const Slice* s = reinterpret_cast<const Slice*>(cell);
+            value.assign_copy(s->data(), s->size());
+          } else {
+            value.assign_copy(cell, type_info->size());
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+
+    ColumnAggregatePB::Type type = ColumnAggregatePB::UNKNOWN_AGGREGATE;
+    // The index of the column in the scanner's schema, or kColumnNotFound
+    // for a COUNT of rows.
+    int col_idx = Schema::kColumnNotFound;
+    const TypeInfo* type_info = nullptr;
+    int64_t count = 0;
+    int64_t int_sum = 0;
+    double double_sum = 0;
+    // The current MIN or MAX value, in its wire encoding.
+    faststring value;
+  };
+
+  explicit AggregateResultSerializer(vector<AggregateState> states)
+      : states_(std::move(states)) {
+  }
+
+  vector<AggregateState> states_;
+  bool done_ = false;
+};
+
+// Checks the top-N of 'scan_pb', if any, against the rest of the scan and
+// the client's projection.
+Status ValidateTopN(const NewScanRequestPB& scan_pb, const Schema& client_projection) {
+  if (!scan_pb.has_top_n()) {
+    return Status::OK();
+  }
+  const TopNPB& top_n = scan_pb.top_n();
+  if (scan_pb.has_limit() || !scan_pb.aggregates().empty() ||
+      scan_pb.order_mode() == ORDERED) {
+    return Status::InvalidArgument(
+        "top-N scans don't support limits, aggregates and ORDERED scans");
+  }
+  if (top_n.limit() <= 0 || top_n.limit() > FLAGS_scanner_max_top_n_rows) {
+    return Status::InvalidArgument(Substitute(
+        "top-N limit must be between 1 and $0: $1",
+        FLAGS_scanner_max_top_n_rows, top_n.limit()));
+  }
+  if (!top_n.has_column_idx() || top_n.column_idx() < 0 ||
+      static_cast<size_t>(top_n.column_idx()) >= client_projection.num_columns()) {
+    return Status::InvalidArgument(Substitute(
+        "invalid top-N column index $0", top_n.column_idx()));
+  }
+  return Status::OK();
+}
+
 } // anonymous namespace
 
 // Copies the scan result to the given row block PB and data buffers.
@@ -942,12 +1350,20 @@ class ColumnarResultSerializer : public ResultSerializer {
 // server-side scan and thus never need to return the actual data.)
 class ScanResultCopier : public ScanResultCollector {
  public:
-  explicit ScanResultCopier(int batch_size_bytes)
+  ScanResultCopier(int batch_size_bytes, ScanBufferPool* buffer_pool)
       : batch_size_bytes_(batch_size_bytes),
+        buffer_pool_(buffer_pool),
         num_rows_returned_(0) {
   }
 
   void HandleRowBlock(Scanner* scanner, const RowBlock& row_block) override {
+    // The rows of a top-N scan are collected until the whole tablet has been
+    // scanned, and then returned as a single block.
+    ScanTopN* top_n = scanner->top_n();
+    if (top_n && !top_n->returned()) {
+      top_n->AddRows(row_block);
+      return;
+    }
     int num_selected = serializer_->SerializeRowBlock(
         row_block, scanner->client_projection_schema());
 
@@ -968,6 +1384,7 @@ class ScanResultCopier : public ScanResultCollector {
   }
 
   Status InitSerializer(uint64_t row_format_flags,
+                        const RepeatedPtrField<ColumnAggregatePB>& aggregates,
                         const Schema& scanner_schema,
                         const Schema& client_schema) override {
     if (serializer_) {
@@ -975,11 +1392,25 @@ class ScanResultCopier : public ScanResultCollector {
       // which is a bit ugly. Refactor to avoid!
       return Status::OK();
     }
+    if (!aggregates.empty()) {
+      return AggregateResultSerializer::Create(
+          row_format_flags, aggregates, scanner_schema, client_schema, &serializer_);
+    }
     if (row_format_flags & COLUMNAR_LAYOUT) {
       return ColumnarResultSerializer::Create(
           row_format_flags, batch_size_bytes_, scanner_schema, client_schema, &serializer_);
     }
-    serializer_.reset(new RowwiseResultSerializer(batch_size_bytes_, row_format_flags));
+    if (row_format_flags & ARROW_LAYOUT) {
+      return Status::InvalidArgument("Arrow layout requires the columnar layout");
+    }
+    if (row_format_flags & UNDEFINED_NULL_VALUES) {
+      return Status::InvalidArgument("Undefined null values require the columnar layout");
+    }
+    if (row_format_flags & COMPRESSED_COLUMNS) {
+      return Status::InvalidArgument("Compressed columns require the columnar layout");
+    }
+    serializer_.reset(new RowwiseResultSerializer(
+        batch_size_bytes_, row_format_flags, buffer_pool_));
     return Status::OK();
   }
 
@@ -999,6 +1430,7 @@ class ScanResultCopier : public ScanResultCollector {
 
  private:
   int batch_size_bytes_;
+  ScanBufferPool* const buffer_pool_;
   int64_t num_rows_returned_;
   faststring last_primary_key_;
   unique_ptr<ResultSerializer> serializer_;
@@ -1010,8 +1442,7 @@ class ScanResultCopier : public ScanResultCollector {
 class ScanResultChecksummer : public ScanResultCollector {
  public:
   ScanResultChecksummer()
-      : crc_(crc::GetCrc32cInstance()),
-        agg_checksum_(0),
+      : agg_checksum_(0),
         rows_checksummed_(0) {
   }
 
@@ -1026,7 +1457,8 @@ class ScanResultChecksummer : public ScanResultCollector {
     size_t nrows = row_block.nrows();
     for (size_t i = 0; i < nrows; i++) {
       if (!row_block.selection_vector()->IsRowSelected(i)) continue;
-      uint32_t row_crc = CalcRowCrc32(*client_projection_schema, row_block.row(i));
+      uint32_t row_crc = tablet::CalcRowCrc32(*client_projection_schema, row_block.row(i),
+                                              &tmp_buf_);
       agg_checksum_ += row_crc;
       rows_checksummed_++;
     }
@@ -1049,36 +1481,25 @@ class ScanResultChecksummer : public ScanResultCollector {
   void set_agg_checksum(uint64_t value) { agg_checksum_ = value; }
   uint64_t agg_checksum() const { return agg_checksum_; }
 
- private:
-  // Calculates a CRC32C for the given row.
-  uint32_t CalcRowCrc32(const Schema& projection, const RowBlockRow& row) {
-    tmp_buf_.clear();
-
-    for (size_t j = 0; j < projection.num_columns(); j++) {
-      uint32_t col_index = static_cast<uint32_t>(j);  // For the CRC.
-      tmp_buf_.append(&col_index, sizeof(col_index));
-      ColumnBlockCell cell = row.cell(j);
-      if (cell.is_nullable()) {
-        uint8_t is_defined = cell.is_null() ? 0 : 1;
-        tmp_buf_.append(&is_defined, sizeof(is_defined));
-        if (!is_defined) continue;
-      }
-      if (cell.typeinfo()->physical_type() == BINARY) {
-        const Slice* data = reinterpret_cast<const Slice *>(cell.ptr());
-        tmp_buf_.append(data->data(), data->size());
-      } else {
-        tmp_buf_.append(cell.ptr(), cell.size());
-      }
-    }
+  // Makes the new scan reuse the checksums of the rowsets cached by the
+  // previous checksum scans of the tablet.
+  void set_reuse_rowset_checksums() { reuse_rowset_checksums_ = true; }
 
-    uint64_t row_crc = 0;
-    crc_->Compute(tmp_buf_.data(), tmp_buf_.size(), &row_crc, nullptr);
-    return static_cast<uint32_t>(row_crc); // CRC32 only uses the lower 32 bits.
+  tablet::ChecksumScanState* checksum_scan() override {
+    return reuse_rowset_checksums_ ? &checksum_scan_ : nullptr;
   }
 
+  // Adds the checksums of the rowsets reused by the new scan, once its
+  // iterator is initialized.
+  void AddReusedRowSetChecksums() {
+    agg_checksum_ += checksum_scan_.cached_checksum;
+    rows_checksummed_ += checksum_scan_.cached_rows;
+  }
 
+ private:
   faststring tmp_buf_;
-  crc::Crc* const crc_;
+  bool reuse_rowset_checksums_ = false;
+  tablet::ChecksumScanState checksum_scan_;
   uint64_t agg_checksum_;
   int64_t rows_checksummed_;
   faststring encoded_last_row_;
@@ -1105,6 +1526,8 @@ TabletServiceImpl::TabletServiceImpl(TabletServer* server)
       rng_(GetRandomSeed32()) {
   num_op_apply_queue_rejections_ = server_->metric_entity()->FindOrCreateCounter(
       &METRIC_op_apply_queue_overload_rejections);
+  num_scan_batches_cut_for_memory_ = server_->metric_entity()->FindOrCreateCounter(
+      &METRIC_scanner_batches_cut_for_memory);
 }
 
 bool TabletServiceImpl::AuthorizeClientOrServiceUser(const google::protobuf::Message* /*req*/,
@@ -1406,6 +1829,8 @@ bool TabletServiceAdminImpl::SupportsFeature(uint32_t feature) const {
     case TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES:
     case TabletServerFeatures::QUIESCING:
     case TabletServerFeatures::BLOOM_FILTER_PREDICATE_V2:
+    case TabletServerFeatures::DELETE_TABLETS:
+    case TabletServerFeatures::CREATE_TABLETS:
     // TODO(awong): once transactions are useable, add a feature flag.
       return true;
     default:
@@ -1433,70 +1858,124 @@ void TabletServiceAdminImpl::Quiesce(const QuiesceTabletServerRequestPB* req,
   context->RespondSuccess();
 }
 
-void TabletServiceAdminImpl::CreateTablet(const CreateTabletRequestPB* req,
-                                          CreateTabletResponsePB* resp,
-                                          RpcContext* context) {
-  if (!CheckUuidMatchOrRespond(server_->tablet_manager(), "CreateTablet", req, resp, context)) {
-    return;
-  }
+namespace {
+// Creates the tablet replica specified by 'req'. On failure, sets 'code' to
+// the error code to respond with.
+Status CreateTabletFromRequest(TSTabletManager* tablet_manager,
+                               const CreateTabletRequestPB& req,
+                               TabletServerErrorPB::Code* code) {
   TRACE_EVENT1("tserver", "CreateTablet",
-               "tablet_id", req->tablet_id());
+               "tablet_id", req.tablet_id());
 
   Schema schema;
-  Status s = SchemaFromPB(req->schema(), &schema);
+  Status s = SchemaFromPB(req.schema(), &schema);
   DCHECK(schema.has_column_ids());
   if (!s.ok()) {
-    SetupErrorAndRespond(resp->mutable_error(),
-                         Status::InvalidArgument("Invalid Schema."),
-                         TabletServerErrorPB::INVALID_SCHEMA, context);
-    return;
+    *code = TabletServerErrorPB::INVALID_SCHEMA;
+    return Status::InvalidArgument("Invalid Schema.");
   }
 
   PartitionSchema partition_schema;
-  s = PartitionSchema::FromPB(req->partition_schema(), schema, &partition_schema);
+  s = PartitionSchema::FromPB(req.partition_schema(), schema, &partition_schema);
   if (!s.ok()) {
-    SetupErrorAndRespond(resp->mutable_error(),
-                         Status::InvalidArgument("Invalid PartitionSchema."),
-                         TabletServerErrorPB::INVALID_SCHEMA, context);
-    return;
+    *code = TabletServerErrorPB::INVALID_SCHEMA;
+    return Status::InvalidArgument("Invalid PartitionSchema.");
   }
 
   Partition partition;
-  Partition::FromPB(req->partition(), &partition);
+  Partition::FromPB(req.partition(), &partition);
 
   LOG(INFO) << Substitute("Processing CreateTablet for tablet $0 ($1table=$2 [id=$3]), "
-                          "partition=$4", req->tablet_id(),
-                          req->has_table_type() ? TableTypePB_Name(req->table_type()) + " ": "",
-                          req->table_name(), req->table_id(),
+                          "partition=$4", req.tablet_id(),
+                          req.has_table_type() ? TableTypePB_Name(req.table_type()) + " ": "",
+                          req.table_name(), req.table_id(),
                           partition_schema.PartitionDebugString(partition, schema));
-  VLOG(1) << "Full request: " << SecureDebugString(*req);
+  VLOG(1) << "Full request: " << SecureDebugString(req);
 
-  s = server_->tablet_manager()->CreateNewTablet(
-      req->table_id(),
-      req->tablet_id(),
+  s = tablet_manager->CreateNewTablet(
+      req.table_id(),
+      req.tablet_id(),
       partition,
-      req->table_name(),
+      req.table_name(),
       schema,
       partition_schema,
-      req->config(),
-      req->has_extra_config() ? make_optional(req->extra_config()) : nullopt,
-      req->has_dimension_label() ? make_optional(req->dimension_label()) : nullopt,
-      req->has_table_type() && req->table_type() != TableTypePB::DEFAULT_TABLE ?
-          make_optional(req->table_type()) : nullopt,
+      req.config(),
+      req.has_extra_config() ? make_optional(req.extra_config()) : nullopt,
+      req.has_dimension_label() ? make_optional(req.dimension_label()) : nullopt,
+      req.has_table_type() && req.table_type() != TableTypePB::DEFAULT_TABLE ?
+          make_optional(req.table_type()) : nullopt,
       nullptr);
   if (PREDICT_FALSE(!s.ok())) {
-    TabletServerErrorPB::Code code;
-    if (s.IsAlreadyPresent()) {
-      code = TabletServerErrorPB::TABLET_ALREADY_EXISTS;
-    } else {
-      code = TabletServerErrorPB::UNKNOWN_ERROR;
-    }
+    *code = s.IsAlreadyPresent() ? TabletServerErrorPB::TABLET_ALREADY_EXISTS
+                                 : TabletServerErrorPB::UNKNOWN_ERROR;
+  }
+  return s;
+}
+} // anonymous namespace
+
+void TabletServiceAdminImpl::CreateTablet(const CreateTabletRequestPB* req,
+                                          CreateTabletResponsePB* resp,
+                                          RpcContext* context) {
+  if (!CheckUuidMatchOrRespond(server_->tablet_manager(), "CreateTablet", req, resp, context)) {
+    return;
+  }
+  TabletServerErrorPB::Code code = TabletServerErrorPB::UNKNOWN_ERROR;
+  Status s = CreateTabletFromRequest(server_->tablet_manager(), *req, &code);
+  if (PREDICT_FALSE(!s.ok())) {
     SetupErrorAndRespond(resp->mutable_error(), s, code, context);
     return;
   }
   context->RespondSuccess();
 }
 
+void TabletServiceAdminImpl::CreateTablets(const CreateTabletsRequestPB* req,
+                                           CreateTabletsResponsePB* resp,
+                                           RpcContext* context) {
+  if (!CheckUuidMatchOrRespond(server_->tablet_manager(), "CreateTablets", req, resp, context)) {
+    return;
+  }
+  TRACE_EVENT1("tserver", "CreateTablets",
+               "num_tablets", req->requests_size());
+  LOG(INFO) << "Processing CreateTablets for " << req->requests_size() << " tablets"
+            << " from " << context->requestor_string();
+  if (req->requests_size() == 0) {
+    context->RespondSuccess();
+    return;
+  }
+
+  // As in DeleteTablets(), the creations run concurrently, on the creation
+  // pool of the tablet manager, and the last one to complete responds.
+  for (int i = 0; i < req->requests_size(); i++) {
+    resp->add_responses();
+  }
+  auto num_pending = std::make_shared<std::atomic<int>>(req->requests_size());
+  TSTabletManager* tablet_manager = server_->tablet_manager();
+  for (int i = 0; i < req->requests_size(); i++) {
+    const CreateTabletRequestPB* tablet_req = &req->requests(i);
+    CreateTabletResponsePB* tablet_resp = resp->mutable_responses(i);
+    auto finish = [context, tablet_resp, num_pending](
+        const Status& s, TabletServerErrorPB::Code code) {
+      if (PREDICT_FALSE(!s.ok())) {
+        StatusToPB(s, tablet_resp->mutable_error()->mutable_status());
+        tablet_resp->mutable_error()->set_code(code);
+      }
+      if (num_pending->fetch_sub(1) == 1) {
+        context->RespondSuccess();
+      }
+    };
+    Status s = tablet_manager->create_tablet_pool()->Submit(
+        [tablet_manager, tablet_req, finish]() {
+          TabletServerErrorPB::Code code = TabletServerErrorPB::UNKNOWN_ERROR;
+          Status s = CreateTabletFromRequest(tablet_manager, *tablet_req, &code);
+          finish(s, code);
+        });
+    if (PREDICT_FALSE(!s.ok())) {
+      finish(s, s.IsServiceUnavailable() ? TabletServerErrorPB::THROTTLED
+                                         : TabletServerErrorPB::UNKNOWN_ERROR);
+    }
+  }
+}
+
 void TabletServiceAdminImpl::DeleteTablet(const DeleteTabletRequestPB* req,
                                           DeleteTabletResponsePB* resp,
                                           RpcContext* context) {
@@ -1535,6 +2014,83 @@ void TabletServiceAdminImpl::DeleteTablet(const DeleteTabletRequestPB* req,
                                                response_callback);
 }
 
+void TabletServiceAdminImpl::DeleteTablets(const DeleteTabletsRequestPB* req,
+                                           DeleteTabletsResponsePB* resp,
+                                           RpcContext* context) {
+  if (!CheckUuidMatchOrRespond(server_->tablet_manager(), "DeleteTablets", req, resp, context)) {
+    return;
+  }
+  TRACE_EVENT1("tserver", "DeleteTablets",
+               "num_tablets", req->requests_size());
+  LOG(INFO) << "Processing DeleteTablets for " << req->requests_size() << " tablets"
+            << " from " << context->requestor_string();
+  VLOG(1) << "Full request: " << SecureDebugString(*req);
+  if (req->requests_size() == 0) {
+    context->RespondSuccess();
+    return;
+  }
+
+  // The responses are set up front: the deletions run concurrently on the
+  // pool of the tablet manager, each filling its own response, and the last
+  // one to complete responds to the batch.
+  for (int i = 0; i < req->requests_size(); i++) {
+    resp->add_responses();
+  }
+  auto num_pending = std::make_shared<std::atomic<int>>(req->requests_size());
+  for (int i = 0; i < req->requests_size(); i++) {
+    const DeleteTabletRequestPB& tablet_req = req->requests(i);
+    tablet::TabletDataState delete_type = tablet::TABLET_DATA_UNKNOWN;
+    if (tablet_req.has_delete_type()) {
+      delete_type = tablet_req.delete_type();
+    }
+    optional<int64_t> cas_config_opid_index_less_or_equal;
+    if (tablet_req.has_cas_config_opid_index_less_or_equal()) {
+      cas_config_opid_index_less_or_equal = tablet_req.cas_config_opid_index_less_or_equal();
+    }
+    DeleteTabletResponsePB* tablet_resp = resp->mutable_responses(i);
+    auto response_callback = [context, tablet_resp, num_pending](
+        const Status& s, TabletServerErrorPB::Code code) {
+      if (PREDICT_FALSE(!s.ok())) {
+        StatusToPB(s, tablet_resp->mutable_error()->mutable_status());
+        tablet_resp->mutable_error()->set_code(code);
+      }
+      if (num_pending->fetch_sub(1) == 1) {
+        context->RespondSuccess();
+      }
+    };
+    server_->tablet_manager()->DeleteTabletAsync(tablet_req.tablet_id(),
+                                                 delete_type,
+                                                 cas_config_opid_index_less_or_equal,
+                                                 response_callback);
+  }
+}
+
+namespace {
+// Sets 'rows' and 'indirect_data' to the row data of the write request 'req',
+// which may be carried by the sidecars of 'context'.
+Status GetWriteRowData(const WriteRequestPB& req,
+                       const RpcContext& context,
+                       Slice* rows,
+                       Slice* indirect_data) {
+  const auto& row_ops = req.row_operations();
+  *rows = row_ops.rows();
+  *indirect_data = row_ops.indirect_data();
+  if (row_ops.has_rows_sidecar()) {
+    if (PREDICT_FALSE(!rows->empty())) {
+      return Status::InvalidArgument("row data both inlined and in a sidecar");
+    }
+    RETURN_NOT_OK(context.GetInboundSidecar(row_ops.rows_sidecar(), rows));
+  }
+  if (row_ops.has_indirect_data_sidecar()) {
+    if (PREDICT_FALSE(!indirect_data->empty())) {
+      return Status::InvalidArgument("indirect data both inlined and in a sidecar");
+    }
+    RETURN_NOT_OK(context.GetInboundSidecar(row_ops.indirect_data_sidecar(), indirect_data));
+  }
+  return Status::OK();
+}
+} // anonymous namespace
+
 void TabletServiceImpl::Write(const WriteRequestPB* req,
                               WriteResponsePB* resp,
                               RpcContext* context) {
@@ -1607,8 +2163,15 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
     return;
   }
 
-  const uint64_t bytes = req->row_operations().rows().size() +
-      req->row_operations().indirect_data().size();
+  Slice rows;
+  Slice indirect_data;
+  s = GetWriteRowData(*req, *context, &rows, &indirect_data);
+  if (PREDICT_FALSE(!s.ok())) {
+    return SetupErrorAndRespond(resp->mutable_error(), s,
+                                TabletServerErrorPB::INVALID_MUTATION, context);
+  }
+
+  const uint64_t bytes = rows.size() + indirect_data.size();
   if (!tablet->ShouldThrottleAllow(bytes)) {
     constexpr const char* const kMsg = "rejecting write request: throttled";
     static const auto kStatus = Status::ServiceUnavailable(kMsg);
@@ -1619,6 +2182,19 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
                                 context);
   }
 
+  s = server_->quota_manager()->AdmitWrite(
+      MonoTime::Now(), replica->tablet_metadata()->table_id(),
+      TableQuotas::FromExtraConfig(replica->tablet_metadata()->extra_config()),
+      context->remote_user().username());
+  if (PREDICT_FALSE(!s.ok())) {
+    tablet->metrics()->write_quota_rejections->Increment();
+    KLOG_EVERY_N_SECS(INFO, 1) << "rejecting write request: " << s.ToString() << THROTTLE_MSG;
+    return SetupErrorAndRespond(resp->mutable_error(),
+                                s,
+                                TabletServerErrorPB::THROTTLED,
+                                context);
+  }
+
   // Check for memory pressure; don't bother doing any additional work if we've
   // exceeded the limit.
   double capacity_pct;
@@ -1670,6 +2246,10 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
       context->AreResultsTracked() ? context->request_id() : nullptr,
       resp,
       std::move(authz_context)));
+  if (req->row_operations().has_rows_sidecar() ||
+      req->row_operations().has_indirect_data_sidecar()) {
+    op_state->set_row_data(rows, indirect_data);
+  }
 
   // If the client sent us a timestamp, decode it and update the clock so that all future
   // timestamps are greater than the passed timestamp.
@@ -1776,6 +2356,28 @@ void ConsensusServiceImpl::UpdateConsensus(const ConsensusRequestPB* req,
   context->RespondSuccess();
 }
 
+void ConsensusServiceImpl::MultiUpdateConsensus(const MultiConsensusRequestPB* req,
+                                                MultiConsensusResponsePB* resp,
+                                                RpcContext* context) {
+  DVLOG(3) << "Received Consensus Multi Update RPC: " << SecureDebugString(*req);
+  if (!CheckUuidMatchOrRespond(tablet_manager_, "MultiUpdateConsensus", req, resp, context)) {
+    return;
+  }
+  // Unlike UpdateConsensus(), the failures are reported by the responses
+  // of the requests rather than by responding to the RPC.
+  for (const auto& tablet_req : req->requests()) {
+    ConsensusResponsePB* tablet_resp = resp->add_responses();
+    TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+    Status s = UpdateReplicaConsensus(tablet_manager_, tablet_req, tablet_resp, &error_code);
+    if (PREDICT_FALSE(!s.ok())) {
+      tablet_resp->Clear();
+      StatusToPB(s, tablet_resp->mutable_error()->mutable_status());
+      tablet_resp->mutable_error()->set_code(error_code);
+    }
+  }
+  context->RespondSuccess();
+}
+
 void ConsensusServiceImpl::RequestConsensusVote(const VoteRequestPB* req,
                                                 VoteResponsePB* resp,
                                                 RpcContext* context) {
@@ -2208,7 +2810,30 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
     }
   }
 
-  ScanResultCopier collector(GetMaxBatchSizeBytesHint(req));
+  // Hand the request off to the scan executor, so that the service threads
+  // don't wait for the rows to be read. The scans which have taken long so
+  // far are run by the batch threads, so they don't hold up the short ones.
+  auto priority = ScannerManager::ScanPriority::INTERACTIVE;
+  if (req->has_scanner_id()) {
+    SharedScanner scanner;
+    TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+    if (server_->scanner_manager()->LookupScanner(req->scanner_id(),
+                                                  context->remote_user().username(),
+                                                  &error_code,
+                                                  &scanner).ok()) {
+      priority = ScannerManager::ScanPriorityOf(*scanner);
+    }
+  }
+  server_->scanner_manager()->RunScanTask(priority, [this, req, resp, context]() {
+    ScanAndRespond(req, resp, context);
+  });
+}
+
+void TabletServiceImpl::ScanAndRespond(const ScanRequestPB* req,
+                                       ScanResponsePB* resp,
+                                       RpcContext* context) {
+  ScanResultCopier collector(GetMaxBatchSizeBytesHint(req),
+                             server_->scanner_manager()->buffer_pool());
 
   bool has_more_results = false;
   TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
@@ -2282,6 +2907,17 @@ void TabletServiceImpl::ListTablets(const ListTabletsRequestPB* req,
           tablet_schema, status->mutable_partition_schema()));
       status->set_schema_version(replica->tablet_metadata()->schema_version());
     }
+
+    if (req->need_column_stats()) {
+      const shared_ptr<Tablet> tablet = replica->shared_tablet();
+      if (tablet) {
+        vector<ColumnStatsPB> column_stats;
+        tablet->GetColumnStats(&column_stats);
+        for (auto& stats : column_stats) {
+          *status->add_column_stats() = std::move(stats);
+        }
+      }
+    }
   }
   context->RespondSuccess();
 }
@@ -2453,6 +3089,274 @@ void TabletServiceImpl::SplitKeyRange(const SplitKeyRangeRequestPB* req,
   context->RespondSuccess();
 }
 
+void TabletServiceImpl::LookupRows(const LookupRowsRequestPB* req,
+                                   LookupRowsResponsePB* resp,
+                                   RpcContext* context) {
+  TRACE_EVENT1("tserver", "TabletServiceImpl::LookupRows",
+               "tablet_id", req->tablet_id());
+  Stopwatch sw;
+  sw.start();
+  if (!CheckTabletServerNotQuiescingOrRespond(server_, resp, context)) {
+    return;
+  }
+  scoped_refptr<TabletReplica> replica;
+  if (!LookupRunningTabletReplicaOrRespond(server_->tablet_manager(), req->tablet_id(), resp,
+                                           context, &replica)) {
+    return;
+  }
+  SCOPED_CPU_PROFILE_TAG(replica->tablet_id());
+
+  if (FLAGS_tserver_enforce_access_control) {
+    TokenPB token;
+    if (!VerifyAuthzTokenOrRespond(server_->token_verifier(), *req, context, &token)) {
+      return;
+    }
+    const auto& privilege = token.authz().table_privilege();
+    if (!CheckMatchingTableIdOrRespond(privilege, replica->tablet_metadata()->table_id(),
+                                       "LookupRows", context)) {
+      return;
+    }
+    unordered_set<ColumnId> authorized_column_ids;
+    if (!CheckMayHaveScanPrivilegesOrRespond(privilege, "LookupRows",
+                                             &authorized_column_ids, context)) {
+      return;
+    }
+    if (!privilege.scan_privilege()) {
+      // A lookup requires the same privileges as a scan of the projected
+      // columns bounded by a primary key.
+      NewScanRequestPB scan_pb;
+      *scan_pb.mutable_projected_columns() = req->projected_columns();
+      scan_pb.set_start_primary_key("");
+      const SchemaPtr schema_ptr = replica->tablet_metadata()->schema();
+      if (!CheckScanPrivilegesOrRespond(scan_pb, *schema_ptr, authorized_column_ids,
+                                        "LookupRows", context)) {
+        return;
+      }
+    }
+  }
+
+  const auto respond_error = [&](const Status& s, TabletServerErrorPB::Code code) {
+    SetupErrorAndRespond(resp->mutable_error(), s, code, context);
+  };
+
+  Schema projection;
+  Status s = ColumnPBsToSchema(req->projected_columns(), &projection);
+  if (PREDICT_FALSE(!s.ok())) {
+    return respond_error(s, TabletServerErrorPB::INVALID_SCHEMA);
+  }
+  if (projection.has_column_ids()) {
+    return respond_error(Status::InvalidArgument("User requests should not have Column IDs"),
+                         TabletServerErrorPB::INVALID_SCHEMA);
+  }
+  if (req->row_format_flags() & ~(PAD_UNIX_TIME_MICROS_TO_16_BYTES | COLUMNAR_LAYOUT)) {
+    return respond_error(Status::InvalidArgument("unsupported row format flags"),
+                         TabletServerErrorPB::INVALID_SCAN_SPEC);
+  }
+
+  shared_ptr<Tablet> tablet;
+  TabletServerErrorPB::Code error_code;
+  s = GetTabletRef(replica, &tablet, &error_code);
+  if (PREDICT_FALSE(!s.ok())) {
+    return respond_error(s, error_code);
+  }
+  s = tablet->mvcc_manager()->CheckIsCleanTimeInitialized();
+  if (PREDICT_FALSE(!s.ok())) {
+    return respond_error(s, TabletServerErrorPB::TABLET_NOT_RUNNING);
+  }
+
+  // Like the scans of the latest data, the lookups on a leader require its
+  // lease, so that they can't miss the writes accepted by a newer leader.
+  if (FLAGS_raft_enable_leader_leases) {
+    shared_ptr<RaftConsensus> consensus = replica->shared_consensus();
+    if (consensus && consensus->role() == RaftPeerPB::LEADER &&
+        !consensus->HasLeaderLease()) {
+      return respond_error(Status::ServiceUnavailable("leader does not hold a leader lease"),
+                           TabletServerErrorPB::THROTTLED);
+    }
+  }
+
+  const string& table_id = replica->tablet_metadata()->table_id();
+  const TableQuotas quotas =
+      TableQuotas::FromExtraConfig(replica->tablet_metadata()->extra_config());
+  const string& user = context->remote_user().username();
+  s = server_->quota_manager()->AdmitScan(MonoTime::Now(), table_id, quotas, user);
+  if (PREDICT_FALSE(!s.ok())) {
+    tablet->metrics()->scan_quota_rejections->Increment();
+    return respond_error(s, TabletServerErrorPB::THROTTLED);
+  }
+
+  // Decode the keys.
+  Arena arena(1024);
+  const SchemaPtr tablet_schema_ptr = replica->tablet_metadata()->schema();
+  const Schema& tablet_schema = *tablet_schema_ptr;
+  vector<const EncodedKey*> keys;
+  keys.reserve(req->primary_keys_size());
+  for (const auto& encoded : req->primary_keys()) {
+    EncodedKey* key;
+    s = EncodedKey::DecodeEncodedString(tablet_schema, &arena, encoded, &key);
+    if (PREDICT_FALSE(!s.ok())) {
+      return respond_error(s.CloneAndPrepend("invalid primary key"),
+                           TabletServerErrorPB::INVALID_SCAN_SPEC);
+    }
+    if (PREDICT_FALSE(!keys.empty() &&
+                      keys.back()->encoded_key().compare(key->encoded_key()) >= 0)) {
+      return respond_error(Status::InvalidArgument(
+                               "primary keys must be sorted without duplicates"),
+                           TabletServerErrorPB::INVALID_SCAN_SPEC);
+    }
+    keys.push_back(key);
+  }
+
+  RowBlockMemory mem;
+  RowBlock block(&projection, keys.size(), &mem);
+  s = tablet->LookupRows(projection, keys, &block);
+  if (PREDICT_FALSE(!s.ok())) {
+    return respond_error(s, s.IsInvalidArgument() ? TabletServerErrorPB::MISMATCHED_SCHEMA
+                                                  : TabletServerErrorPB::UNKNOWN_ERROR);
+  }
+
+  unique_ptr<ResultSerializer> serializer;
+  if (req->row_format_flags() & COLUMNAR_LAYOUT) {
+    s = ColumnarResultSerializer::Create(req->row_format_flags(),
+                                         FLAGS_scanner_default_batch_size_bytes,
+                                         projection, projection, &serializer);
+    if (PREDICT_FALSE(!s.ok())) {
+      return respond_error(s, TabletServerErrorPB::INVALID_SCAN_SPEC);
+    }
+  } else {
+    serializer.reset(new RowwiseResultSerializer(FLAGS_scanner_default_batch_size_bytes,
+                                                 req->row_format_flags(),
+                                                 server_->scanner_manager()->buffer_pool()));
+  }
+  serializer->SerializeRowBlock(block, &projection);
+  for (int i = 0; i < block.nrows(); i++) {
+    if (block.selection_vector()->IsRowSelected(i)) {
+      resp->add_found_key_indexes(i);
+    }
+  }
+  server_->quota_manager()->ChargeScan(MonoTime::Now(), table_id, quotas, user,
+                                       serializer->ResponseSize());
+
+  ScanResponsePB scan_resp;
+  serializer->SetupResponse(context, &scan_resp);
+  if (scan_resp.has_data()) {
+    resp->mutable_data()->Swap(scan_resp.mutable_data());
+  }
+  if (scan_resp.has_columnar_data()) {
+    resp->mutable_columnar_data()->Swap(scan_resp.mutable_columnar_data());
+  }
+  resp->set_propagated_timestamp(server_->clock()->Now().ToUint64());
+  sw.stop();
+  const CpuTimes cpu_times = sw.elapsed();
+  SetResourceMetrics(context, &cpu_times, resp->mutable_resource_metrics());
+  context->RespondSuccess();
+}
+
+void TabletServiceImpl::GetTabletChanges(const GetTabletChangesRequestPB* req,
+                                         GetTabletChangesResponsePB* resp,
+                                         RpcContext* context) {
+  TRACE_EVENT1("tserver", "TabletServiceImpl::GetTabletChanges",
+               "tablet_id", req->tablet_id());
+  scoped_refptr<TabletReplica> replica;
+  if (!LookupRunningTabletReplicaOrRespond(server_->tablet_manager(), req->tablet_id(), resp,
+                                           context, &replica)) {
+    return;
+  }
+
+  // The changes hold the values of all the columns, which requires the
+  // privilege to scan the whole table.
+  if (FLAGS_tserver_enforce_access_control) {
+    TokenPB token;
+    if (!VerifyAuthzTokenOrRespond(server_->token_verifier(), *req, context, &token)) {
+      return;
+    }
+    const auto& privilege = token.authz().table_privilege();
+    if (!CheckMatchingTableIdOrRespond(privilege, replica->tablet_metadata()->table_id(),
+                                       "GetTabletChanges", context)) {
+      return;
+    }
+    if (!privilege.scan_privilege()) {
+      LOG(WARNING) << Substitute("rejecting GetTabletChanges request from $0: "
+                                 "no table scan privilege", context->requestor_string());
+      context->RespondRpcFailure(ErrorStatusPB::FATAL_UNAUTHORIZED,
+          Status::NotAuthorized("not authorized to GetTabletChanges"));
+      return;
+    }
+  }
+
+  ChangeStreamManager* streams = server_->change_stream_manager();
+  if (req->unsubscribe()) {
+    streams->Unsubscribe(req->tablet_id(), req->subscriber_id());
+    context->RespondSuccess();
+    return;
+  }
+  if (PREDICT_FALSE(req->after_op_index() < 0)) {
+    context->RespondFailure(Status::InvalidArgument("after_op_index must not be negative"));
+    return;
+  }
+
+  const auto respond_error = [&](const Status& s, TabletServerErrorPB::Code code) {
+    SetupErrorAndRespond(resp->mutable_error(), s, code, context);
+  };
+  shared_ptr<RaftConsensus> consensus;
+  if (!GetConsensusOrRespond(replica, resp, context, &consensus)) {
+    return;
+  }
+  const optional<OpId> committed_op_id =
+      consensus->GetLastOpId(consensus::COMMITTED_OPID);
+  if (PREDICT_FALSE(!committed_op_id)) {
+    return respond_error(Status::ServiceUnavailable("tablet replica is not running"),
+                         TabletServerErrorPB::TABLET_NOT_RUNNING);
+  }
+  const int64_t committed_index = committed_op_id->index();
+
+  // Anchor the log before reading it, so that the segments of the ops to
+  // return can't be garbage-collected meanwhile.
+  const int64_t start_index = req->after_op_index() + 1;
+  streams->Subscribe(req->tablet_id(), req->subscriber_id(), replica->log_anchor_registry(),
+                     start_index, MonoTime::Now());
+  const auto& reader = replica->log()->reader();
+  const int64_t min_index = reader->GetMinReplicateIndex();
+  if (min_index != -1 && start_index < min_index) {
+    streams->Unsubscribe(req->tablet_id(), req->subscriber_id());
+    return respond_error(
+        Status::NotFound(Substitute("the ops from index $0 were garbage-collected "
+                                    "from the log, it starts at index $1",
+                                    start_index, min_index)),
+        TabletServerErrorPB::INVALID_SNAPSHOT);
+  }
+
+  resp->set_committed_op_index(committed_index);
+  resp->set_last_op_index(req->after_op_index());
+  if (start_index <= committed_index) {
+    vector<consensus::ReplicateMsg*> replicates;
+    ElementDeleter d(&replicates);
+    const int64_t max_size_bytes =
+        std::min<int64_t>(req->max_size_bytes(), FLAGS_scanner_max_batch_size_bytes);
+    Status s = reader->ReadReplicatesInRange(start_index, committed_index, max_size_bytes,
+                                             &replicates);
+    if (PREDICT_FALSE(!s.ok() && !s.IsNotFound())) {
+      return respond_error(s, TabletServerErrorPB::UNKNOWN_ERROR);
+    }
+    // On NotFound, the committed ops haven't been appended to the log of this
+    // replica yet: they're returned by a later request.
+    for (const auto* msg : replicates) {
+      resp->set_last_op_index(msg->id().index());
+      if (msg->op_type() != consensus::WRITE_OP || !msg->has_write_request() ||
+          msg->write_request().has_txn_id()) {
+        continue;
+      }
+      const WriteRequestPB& write = msg->write_request();
+      TabletChangePB* change = resp->add_changes();
+      *change->mutable_op_id() = msg->id();
+      change->set_timestamp(msg->timestamp());
+      *change->mutable_schema() = write.schema();
+      *change->mutable_row_operations() = write.row_operations();
+    }
+  }
+  context->RespondSuccess();
+}
+
 void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
                                  ChecksumResponsePB* resp,
                                  RpcContext* context) {
@@ -2467,6 +3371,11 @@ void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
     return;
   }
 
+  if (PREDICT_FALSE(req->has_new_request() && req->new_request().has_top_n())) {
+    context->RespondFailure(Status::InvalidArgument("top-N checksum scans aren't supported"));
+    return;
+  }
+
   // Convert ChecksumRequestPB to a ScanRequestPB.
   ScanRequestPB scan_req;
   if (req->has_call_seq_id()) scan_req.set_call_seq_id(req->call_seq_id());
@@ -2474,6 +3383,9 @@ void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
   if (req->has_close_scanner()) scan_req.set_close_scanner(req->close_scanner());
 
   ScanResultChecksummer collector;
+  if (req->reuse_rowset_checksums()) {
+    collector.set_reuse_rowset_checksums();
+  }
   bool has_more = false;
   TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
   // TODO(KUDU-2870): the CLI tool doesn't currently fetch authz tokens when
@@ -2534,6 +3446,7 @@ void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
       SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
       return;
     }
+    collector.AddReusedRowSetChecksums();
     resp->set_scanner_id(scanner_id);
     if (snap_timestamp != Timestamp::kInvalidTimestamp) {
       resp->set_snap_timestamp(snap_timestamp.ToUint64());
@@ -2568,6 +3481,16 @@ bool TabletServiceImpl::SupportsFeature(uint32_t feature) const {
     case TabletServerFeatures::QUIESCING:
     case TabletServerFeatures::BLOOM_FILTER_PREDICATE_V2:
     case TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE:
+    case TabletServerFeatures::SCAN_AGGREGATES:
+    case TabletServerFeatures::ARROW_LAYOUT_FEATURE:
+    case TabletServerFeatures::LOOKUP_ROWS:
+    case TabletServerFeatures::TOP_N_SCANS:
+    case TabletServerFeatures::TABLET_CHANGE_STREAMS:
+    case TabletServerFeatures::UNDEFINED_NULL_VALUES_FEATURE:
+    case TabletServerFeatures::COMPRESSED_COLUMNS_FEATURE:
+    case TabletServerFeatures::SHARED_BLOOM_FILTERS:
+    case TabletServerFeatures::SCAN_EXPRESSIONS:
+    case TabletServerFeatures::ROW_OPERATIONS_SIDECARS:
       return true;
     default:
       return false;
@@ -2575,6 +3498,8 @@ bool TabletServiceImpl::SupportsFeature(uint32_t feature) const {
 }
 
 void TabletServiceImpl::Shutdown() {
+  // The scan requests handed off to the scan executor refer to this service.
+  server_->scanner_manager()->WaitForScanTasks();
 }
 
 // Extract a void* pointer suitable for use in a ColumnRangePredicate from the
@@ -2655,13 +3580,26 @@ static Status DecodeEncodedKeyRange(const NewScanRequestPB& scan_pb,
 static Status SetupScanSpec(const NewScanRequestPB& scan_pb,
                             const Schema& tablet_schema,
                             const SharedScanner& scanner,
+                            ScanBloomFilterRegistry* bloom_filter_registry,
                             ScanSpec* spec) {
   spec->set_cache_blocks(scan_pb.cache_blocks());
 
   // First the column predicates.
   for (const ColumnPredicatePB& pred_pb : scan_pb.column_predicates()) {
     optional<ColumnPredicate> predicate;
-    RETURN_NOT_OK(ColumnPredicateFromPB(tablet_schema, scanner->arena(), pred_pb, &predicate));
+    if (pred_pb.has_in_bloom_filter() && pred_pb.in_bloom_filter().has_filter_id()) {
+      // The filters shared under an ID are decoded once per server.
+      const auto& in_bloom_filter = pred_pb.in_bloom_filter();
+      shared_ptr<const ScanBloomFilterRegistry::Filters> filters;
+      RETURN_NOT_OK(bloom_filter_registry->GetOrRegister(
+          in_bloom_filter.filter_id(), in_bloom_filter.bloom_filters(), MonoTime::Now(),
+          &filters));
+      RETURN_NOT_OK(ColumnPredicateFromPB(tablet_schema, scanner->arena(), pred_pb,
+                                          &filters->filters, &predicate));
+      scanner->AddBloomFilters(std::move(filters));
+    } else {
+      RETURN_NOT_OK(ColumnPredicateFromPB(tablet_schema, scanner->arena(), pred_pb, &predicate));
+    }
     spec->AddPredicate(std::move(*predicate));
   }
 
@@ -2771,18 +3709,30 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   TRACE_EVENT2("tserver", "TabletServiceImpl::HandleNewScanRequest",
                "tablet_id", scan_pb.tablet_id(),
                "query_id", req->query_id());
+  SCOPED_CPU_PROFILE_TAG(replica->tablet_id());
+  // A scan which gets its first batch along with this request needs a
+  // registered scanner only if it has more rows than the batch.
+  const bool continue_scan = GetMaxBatchSizeBytesHint(req) > 0;
+  const bool register_scanner = !continue_scan || !FLAGS_scanner_register_after_first_batch;
   SharedScanner scanner;
-  server_->scanner_manager()->NewScanner(replica,
-                                         rpc_context->remote_user(),
-                                         scan_pb.row_format_flags(),
-                                         &scanner);
+  if (register_scanner) {
+    server_->scanner_manager()->NewScanner(replica,
+                                           rpc_context->remote_user(),
+                                           scan_pb.row_format_flags(),
+                                           &scanner);
+  } else {
+    server_->scanner_manager()->CreateScanner(replica,
+                                              rpc_context->remote_user(),
+                                              scan_pb.row_format_flags(),
+                                              &scanner);
+  }
   TRACE("Created scanner $0 for tablet $1, query id is $2",
         scanner->id(), scanner->tablet_id(), req->query_id());
   auto scanner_lock = scanner->LockForAccess();
 
   // If we early-exit out of this function, automatically unregister
   // the scanner.
-  ScopedUnregisterScanner unreg_scanner(server_->scanner_manager(), scanner->id());
+  ScopedUnregisterScanner unreg_scanner(server_->scanner_manager(), scanner, register_scanner);
   ScopedAddScannerTiming scanner_timer(scanner.get(), result_collector->cpu_times());
 
   // Create the user's requested projection.
@@ -2817,12 +3767,20 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   const Schema& tablet_schema = *tablet_schema_ptr;
 
   ScanSpec spec;
-  s = SetupScanSpec(scan_pb, tablet_schema, scanner, &spec);
+  s = SetupScanSpec(scan_pb, tablet_schema, scanner, server_->scan_bloom_filters(), &spec);
   if (PREDICT_FALSE(!s.ok())) {
     *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
     return s;
   }
 
+  // The rows expired by the row TTL of the table, if any, are hidden until
+  // the compactions remove them. They are expired as of the snapshot of the
+  // scan, which is only known once its iterator is created.
+  int row_ttl_col_idx;
+  int64_t row_ttl_sec;
+  const bool has_row_ttl = Tablet::GetRowTtl(*replica->tablet_metadata(), tablet_schema,
+                                             server_->clock(), &row_ttl_col_idx, &row_ttl_sec);
+
   VLOG(3) << "Before optimizing scan spec: " << spec.ToString(tablet_schema);
   spec.PruneInlistValuesIfPossible(tablet_schema,
                                    replica->tablet_metadata()->partition(),
@@ -2838,6 +3796,33 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   // remove unnecessary predicates.
   vector<ColumnSchema> missing_cols = spec.GetMissingColumns(projection);
 
+  // So are the columns referred to by the filter and the computed columns.
+  vector<string> expression_cols;
+  ScanExpressions::GetReferencedColumns(scan_pb, &expression_cols);
+  for (const string& name : expression_cols) {
+    if (projection.find_column(name) != Schema::kColumnNotFound ||
+        std::any_of(missing_cols.begin(), missing_cols.end(),
+                    [&](const ColumnSchema& col) { return col.name() == name; })) {
+      continue;
+    }
+    const int col_idx = tablet_schema.find_column(name);
+    if (col_idx == Schema::kColumnNotFound) {
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return Status::InvalidArgument("unknown column in scan expression", name);
+    }
+    missing_cols.emplace_back(tablet_schema.column(col_idx));
+  }
+
+  // So is the TTL column, for the predicate hiding the expired rows.
+  if (has_row_ttl) {
+    const ColumnSchema& col = tablet_schema.column(row_ttl_col_idx);
+    if (projection.find_column(col.name()) == Schema::kColumnNotFound &&
+        std::none_of(missing_cols.begin(), missing_cols.end(),
+                     [&](const ColumnSchema& c) { return c.name() == col.name(); })) {
+      missing_cols.emplace_back(col);
+    }
+  }
+
   // Build a new projection with the projection columns and the missing columns,
   // annotating each column as a key column appropriately.
   //
@@ -2883,8 +3868,30 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   projection = projection_builder.BuildWithoutIds();
   VLOG(3) << "Scan projection: " << projection.ToString(Schema::BASE_INFO);
 
+  unique_ptr<ScanExpressions> expressions;
+  s = ScanExpressions::Create(scan_pb, projection, &expressions);
+  if (!s.ok()) {
+    *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+    return s;
+  }
+  if (expressions && !expressions->computed_columns().empty()) {
+    // The computed columns are returned after the projected ones.
+    vector<ColumnSchema> client_cols = client_projection->columns();
+    client_cols.insert(client_cols.end(), expressions->computed_columns().begin(),
+                       expressions->computed_columns().end());
+    client_projection.reset(new Schema(std::move(client_cols),
+                                       client_projection->num_key_columns()));
+  }
+
+  s = ValidateTopN(scan_pb, *client_projection);
+  if (!s.ok()) {
+    *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+    return s;
+  }
+  scanner->set_aggregates(scan_pb.aggregates());
   s = result_collector->InitSerializer(scan_pb.row_format_flags(),
-                                       projection,
+                                       scan_pb.aggregates(),
+                                       expressions ? expressions->output_schema() : projection,
                                        *client_projection);
   if (!s.ok()) {
     *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
@@ -2913,12 +3920,38 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
     return s;
   }
 
+  s = server_->quota_manager()->AdmitScan(
+      MonoTime::Now(), replica->tablet_metadata()->table_id(),
+      TableQuotas::FromExtraConfig(replica->tablet_metadata()->extra_config()),
+      rpc_context->remote_user().username());
+  if (PREDICT_FALSE(!s.ok())) {
+    tablet->metrics()->scan_quota_rejections->Increment();
+    *error_code = TabletServerErrorPB::THROTTLED;
+    return s;
+  }
+
+  // With leader leases, the leader only serves the scans of the latest data
+  // while it holds its lease, so that they can't miss the writes accepted by a
+  // newer leader it hasn't heard of yet.
+  if (FLAGS_raft_enable_leader_leases &&
+      (scan_pb.read_mode() == READ_LATEST ||
+       (scan_pb.read_mode() == READ_AT_SNAPSHOT && !scan_pb.has_snap_timestamp() &&
+        !scan_pb.has_max_staleness_usec()))) {
+    shared_ptr<RaftConsensus> consensus = replica->shared_consensus();
+    if (consensus && consensus->role() == RaftPeerPB::LEADER &&
+        !consensus->HasLeaderLease()) {
+      *error_code = TabletServerErrorPB::THROTTLED;
+      return Status::ServiceUnavailable("leader does not hold a leader lease");
+    }
+  }
+
   unique_ptr<RowwiseIterator> iter;
   optional<Timestamp> snap_start_timestamp;
 
   {
     TRACE("Creating iterator");
     TRACE_EVENT0("tserver", "Create iterator");
+    TRACE_SPAN("create_iterator");
 
     switch (scan_pb.read_mode()) {
       case UNKNOWN_READ_MODE: {
@@ -2931,20 +3964,51 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
           return Status::InvalidArgument("scan start timestamp is only supported "
                                          "in READ_AT_SNAPSHOT read mode");
         }
-        s = tablet->NewRowIterator(projection, &iter);
+        if (scan_pb.has_max_staleness_usec()) {
+          *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+          return Status::InvalidArgument("maximum staleness is only supported "
+                                         "in READ_AT_SNAPSHOT read mode");
+        }
+        tablet::RowIteratorOptions opts;
+        opts.projection = &projection;
+        // Yield current rows.
+        opts.snap_to_include = MvccSnapshot(*tablet->mvcc_manager());
+        opts.parallel_scan_pool = server_->scanner_manager()->parallel_scan_pool();
+        s = tablet->NewRowIterator(std::move(opts), &iter);
         break;
       }
       case READ_YOUR_WRITES: // Fallthrough intended
       case READ_AT_SNAPSHOT: {
         s = HandleScanAtSnapshot(
             scan_pb, rpc_context, projection, tablet.get(), replica->time_manager(),
-            &iter, &snap_start_timestamp, snap_timestamp, error_code);
+            result_collector->checksum_scan(), &iter, &snap_start_timestamp, snap_timestamp,
+            error_code);
         break;
       }
     }
     TRACE("Iterator created");
   }
 
+  // Hide the expired rows. A snapshot scan expires them as of its snapshot,
+  // so that repeating it returns the same rows, and a READ_LATEST scan as of
+  // the current time.
+  if (PREDICT_TRUE(s.ok()) && has_row_ttl) {
+    const Timestamp ttl_timestamp =
+        scan_pb.read_mode() == READ_LATEST ? server_->clock()->Now() : *snap_timestamp;
+    const int64_t* cutoff = scanner->arena()->NewObject<int64_t>(
+        Tablet::GetRowTtlCutoffMicros(ttl_timestamp, row_ttl_sec));
+    spec.AddPredicate(ColumnPredicate::Range(tablet_schema.column(row_ttl_col_idx),
+                                             cutoff, nullptr));
+    if (spec.CanShortCircuit()) {
+      VLOG(1) << "short-circuiting: all the rows in range are expired";
+      RETURN_NOT_OK_EVAL(VerifyLegalSnapshotTimestamps(tablet.get(), scan_pb.read_mode(),
+                                                       snap_start_timestamp, *snap_timestamp),
+                         *error_code = TabletServerErrorPB::INVALID_SNAPSHOT);
+      *has_more_results = false;
+      return Status::OK();
+    }
+  }
+
   // Make a copy of the optimized spec before it's passed to the iterator.
   // This copy will be given to the Scanner so it can report its predicates to
   // /scans. The copy is necessary because the original spec will be modified
@@ -2953,6 +4017,7 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
 
   if (PREDICT_TRUE(s.ok())) {
     TRACE_EVENT0("tserver", "iter->Init");
+    TRACE_SPAN("init_iterator");
     s = iter->Init(&spec);
     if (PREDICT_FALSE(s.IsInvalidArgument())) {
       // Tablet::Iterator::Init() returns InvalidArgument when an invalid
@@ -3014,16 +4079,25 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
     return Status::OK();
   }
 
+  const string top_n_column = scan_pb.has_top_n() ?
+      client_projection->column(scan_pb.top_n().column_idx()).name() : "";
   scanner->Init(std::move(iter), std::move(orig_spec), std::move(client_projection));
+  scanner->set_expressions(std::move(expressions));
+  if (scan_pb.has_top_n()) {
+    const Schema& scanner_schema = scanner->result_schema();
+    const int col_idx = scanner_schema.find_column(top_n_column);
+    DCHECK_NE(Schema::kColumnNotFound, col_idx);
+    scanner->set_top_n(std::make_unique<ScanTopN>(
+        &scanner_schema, col_idx, scan_pb.top_n().descending(), scan_pb.top_n().limit()));
+  }
 
   // Stop the scanner timer because ContinueScanRequest starts its own timer.
   scanner_timer.Stop();
-  unreg_scanner.Cancel();
   *scanner_id = scanner->id();
 
   VLOG(1) << "Started scanner " << scanner->id() << ": " << scanner->iter()->ToString();
 
-  if (GetMaxBatchSizeBytesHint(req) > 0) {
+  if (continue_scan) {
     TRACE("Continuing scan request");
     // TODO(wdberkeley): Instead of copying the pb, instead split
     // HandleContinueScanRequest and call the second half directly. Once that's
@@ -3032,10 +4106,15 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
     // from the first half that is no longer executed in this codepath.
     ScanRequestPB continue_req(*req);
     continue_req.set_scanner_id(scanner->id());
+    // From here, HandleContinueScanRequest() unregisters the scanner if needed,
+    // or registers it if it isn't registered and the scan has more rows.
+    unreg_scanner.Release();
     scanner_lock.Unlock();
     return HandleContinueScanRequest(
-        &continue_req, rpc_context, result_collector, has_more_results, error_code);
+        &continue_req, rpc_context, result_collector, has_more_results, error_code,
+        register_scanner ? nullptr : scanner);
   }
+  unreg_scanner.Cancel();
 
   // Increment the scanner call sequence ID. HandleContinueScanRequest handles
   // this in the non-empty scan case.
@@ -3048,19 +4127,23 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
                                                     const RpcContext* rpc_context,
                                                     ScanResultCollector* result_collector,
                                                     bool* has_more_results,
-                                                    TabletServerErrorPB::Code* error_code) {
+                                                    TabletServerErrorPB::Code* error_code,
+                                                    const SharedScanner& unregistered_scanner) {
   DCHECK(req->has_scanner_id());
   TRACE_EVENT2("tserver", "TabletServiceImpl::HandleContinueScanRequest",
                "scanner_id", req->scanner_id(),
                "query_id", req->query_id());
   size_t batch_size_bytes = GetMaxBatchSizeBytesHint(req);
 
-  SharedScanner scanner;
+  SharedScanner scanner = unregistered_scanner;
   TabletServerErrorPB::Code code = TabletServerErrorPB::UNKNOWN_ERROR;
-  Status s = server_->scanner_manager()->LookupScanner(req->scanner_id(),
-                                                       rpc_context->remote_user().username(),
-                                                       &code,
-                                                       &scanner);
+  Status s;
+  if (!scanner) {
+    s = server_->scanner_manager()->LookupScanner(req->scanner_id(),
+                                                  rpc_context->remote_user().username(),
+                                                  &code,
+                                                  &scanner);
+  }
   if (!s.ok()) {
     if (s.IsNotFound() && batch_size_bytes == 0 && req->close_scanner()) {
       // Silently ignore any request to close a non-existent scanner.
@@ -3076,14 +4159,39 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   // circumstances -- only relevant when a client performs some retries on timeout.
   auto scanner_lock = scanner->LockForAccess();
 
+  // The first batch of a new scan was admitted along with the scan. Otherwise,
+  // a scan over quota is rejected before the call sequence ID is incremented,
+  // so that the client can retry the same call once it has backed off.
+  const auto& table_id = scanner->tablet_replica()->tablet_metadata()->table_id();
+  const auto table_quotas = TableQuotas::FromExtraConfig(
+      scanner->tablet_replica()->tablet_metadata()->extra_config());
+  const auto& username = rpc_context->remote_user().username();
+  if (!req->has_new_scan_request()) {
+    s = server_->quota_manager()->AdmitScan(MonoTime::Now(), table_id, table_quotas, username);
+    if (PREDICT_FALSE(!s.ok())) {
+      shared_ptr<Tablet> tablet = scanner->tablet_replica()->shared_tablet();
+      if (tablet) {
+        tablet->metrics()->scan_quota_rejections->Increment();
+      }
+      *error_code = TabletServerErrorPB::THROTTLED;
+      return s;
+    }
+  }
+
   if (PREDICT_FALSE(FLAGS_scanner_inject_service_unavailable_on_continue_scan)) {
+    // The client may retry the request against the scanner.
+    if (unregistered_scanner) {
+      server_->scanner_manager()->RegisterScanner(scanner);
+    }
     return Status::ServiceUnavailable("Injecting service unavailable status on Scan due to "
                                       "--scanner_inject_service_unavailable_on_continue_scan");
   }
 
   // If we early-exit out of this function, automatically unregister the scanner.
-  ScopedUnregisterScanner unreg_scanner(server_->scanner_manager(), scanner->id());
+  ScopedUnregisterScanner unreg_scanner(server_->scanner_manager(), scanner,
+                                        /*registered=*/!unregistered_scanner);
   ScopedAddScannerTiming scanner_timer(scanner.get(), result_collector->cpu_times());
+  SCOPED_CPU_PROFILE_TAG(scanner->tablet_id());
 
   VLOG(2) << "Found existing scanner " << scanner->id() << " for request: "
           << SecureShortDebugString(*req);
@@ -3104,11 +4212,22 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   }
   scanner->IncrementCallSeqId();
 
+  ScannerManager* scanner_manager = server_->scanner_manager();
+  const bool adaptive_batch_size =
+      FLAGS_scanner_adaptive_batch_size && !req->has_batch_size_bytes();
+  if (adaptive_batch_size) {
+    batch_size_bytes = scanner->batch_sizer()->NextBatchSizeBytes(
+        MonoTime::Now(), FLAGS_scanner_max_batch_size_bytes,
+        !process_memory::UnderMemoryPressure(nullptr) &&
+            !scanner_manager->ResponseMemoryLimitExceeded());
+  }
+
   RowwiseIterator* iter = scanner->iter();
 
   // Set the row format flags on the ScanResultCollector.
   s = result_collector->InitSerializer(scanner->row_format_flags(),
-                                       iter->schema(),
+                                       scanner->aggregates(),
+                                       scanner->result_schema(),
                                        *scanner->client_projection_schema());
   if (!s.ok()) {
     *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
@@ -3118,21 +4237,38 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   // TODO(todd): could size the RowBlock based on the user's requested batch size?
   // If people had really large indirect objects, we would currently overshoot
   // their requested batch size by a lot.
-  RowBlockMemory mem(32 * 1024);
-  RowBlock block(&iter->schema(), FLAGS_scanner_batch_size_rows, &mem);
+  ScanBufferPool::ScopedRowBlock block(server_->scanner_manager()->buffer_pool(),
+                                       &iter->schema(), FLAGS_scanner_batch_size_rows);
 
-  // TODO(todd): in the future, use the client timeout to set a budget. For now,
-  // just use a half second, which should be plenty to amortize call overhead.
-  int budget_ms = 500;
-  MonoTime deadline = MonoTime::Now() + MonoDelta::FromMilliseconds(budget_ms);
+  // TODO(todd): in the future, use the client timeout to set a budget.
+  int32_t time_budget_ms = FLAGS_scanner_batch_time_budget_ms;
+  if (ScannerManager::ScanPriorityOf(*scanner) == ScannerManager::ScanPriority::BATCH) {
+    time_budget_ms = std::min(time_budget_ms, FLAGS_scan_executor_batch_time_slice_ms);
+  }
+  const MonoTime batch_start = MonoTime::Now();
+  const MonoTime deadline = batch_start + MonoDelta::FromMilliseconds(time_budget_ms);
+  bool budget_expired = false;
 
   int64_t rows_scanned = 0;
-  while (iter->HasNext() && !scanner->has_fulfilled_limit()) {
+  TRACE_SPAN("read_rows");
+  while ((scanner->HasPrefetchedBlocks() || iter->HasNext()) &&
+         !scanner->has_fulfilled_limit()) {
     if (PREDICT_FALSE(FLAGS_scanner_inject_latency_on_each_batch_ms > 0)) {
       SleepFor(MonoDelta::FromMilliseconds(FLAGS_scanner_inject_latency_on_each_batch_ms));
     }
 
-    Status s = iter->NextBlock(&block);
+    // Return the rows read ahead by the scanner first, if any.
+    RowBlock* cur_block = block.get();
+    unique_ptr<PrefetchedBlock> prefetched;
+    Status s;
+    if (scanner->HasPrefetchedBlocks()) {
+      s = scanner->NextPrefetchedBlock(&prefetched);
+      if (s.ok()) {
+        cur_block = prefetched->block();
+      }
+    } else {
+      s = iter->NextBlock(block.get());
+    }
     if (PREDICT_FALSE(!s.ok())) {
       LOG(WARNING) << "Copying rows from internal iterator for request "
                    << SecureShortDebugString(*req);
@@ -3140,29 +4276,44 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
       return s;
     }
 
-    if (PREDICT_TRUE(block.nrows() > 0)) {
+    if (PREDICT_TRUE(cur_block->nrows() > 0)) {
       // Count the number of rows scanned, regardless of predicates or deletions.
       // The collector will separately count the number of rows actually returned to
       // the client.
-      rows_scanned += block.nrows();
+      rows_scanned += cur_block->nrows();
+      ScanExpressions* expressions = scanner->expressions();
+      if (expressions) {
+        expressions->Filter(cur_block);
+      }
       if (scanner->spec().has_limit()) {
         int64_t rows_left = scanner->spec().limit() - scanner->num_rows_returned();
         DCHECK_GT(rows_left, 0);  // Guaranteed by has_fulfilled_limit()
-        block.selection_vector()->ClearToSelectAtMost(static_cast<size_t>(rows_left));
+        cur_block->selection_vector()->ClearToSelectAtMost(static_cast<size_t>(rows_left));
       }
-      result_collector->HandleRowBlock(scanner.get(), block);
+      result_collector->HandleRowBlock(
+          scanner.get(), expressions ? expressions->Compute(*cur_block) : *cur_block);
     }
 
     int64_t response_size = result_collector->ResponseSize();
 
     if (VLOG_IS_ON(2)) {
       // This may be fairly expensive if row block size is small
-      TRACE("Copied block (nrows=$0), new size=$1", block.nrows(), response_size);
+      TRACE("Copied block (nrows=$0), new size=$1", cur_block->nrows(), response_size);
+    }
+
+    // Rather than growing the memory of the scan responses past their limit,
+    // return the rows collected so far, and let the client come back for more.
+    result_collector->TrackResponseMemory(scanner_manager->response_mem_tracker());
+    if (PREDICT_FALSE(scanner_manager->ResponseMemoryLimitExceeded())) {
+      TRACE("Scan response memory limit reached - responding early");
+      num_scan_batches_cut_for_memory_->Increment();
+      break;
     }
 
     // TODO: should check if RPC got cancelled, once we implement RPC cancellation.
     if (PREDICT_FALSE(MonoTime::Now() >= deadline)) {
       TRACE("Deadline expired - responding early");
+      budget_expired = true;
       break;
     }
 
@@ -3171,6 +4322,21 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
     }
   }
 
+  // Return the best rows of a top-N scan once the whole tablet is scanned.
+  ScanTopN* top_n = scanner->top_n();
+  if (top_n && !top_n->returned() && top_n->size() > 0 &&
+      !scanner->HasPrefetchedBlocks() && !iter->HasNext()) {
+    RowBlockMemory top_n_memory;
+    RowBlock top_n_rows(&scanner->result_schema(), top_n->size(), &top_n_memory);
+    top_n->TakeRows(&top_n_rows);
+    result_collector->HandleRowBlock(scanner.get(), top_n_rows);
+  }
+
+  if (adaptive_batch_size) {
+    const MonoTime now = MonoTime::Now();
+    scanner->batch_sizer()->BatchReturned(now, now - batch_start, budget_expired);
+  }
+
   scoped_refptr<TabletReplica> replica = scanner->tablet_replica();
   shared_ptr<Tablet> tablet;
   TabletServerErrorPB::Code tablet_ref_error_code;
@@ -3187,6 +4353,8 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   // Calculate the number of rows/cells/bytes actually processed.
   IteratorStats delta_stats = scanner->UpdateStatsAndGetDelta();
   TRACE_COUNTER_INCREMENT(SCANNER_BYTES_READ_METRIC_NAME, delta_stats.bytes_read);
+  server_->quota_manager()->ChargeScan(MonoTime::Now(), table_id, table_quotas, username,
+                                       delta_stats.bytes_read);
 
   // Update metrics based on this scan request.
   if (tablet) {
@@ -3204,15 +4372,20 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
     tablet->metrics()->scanner_cells_scanned_from_disk->IncrementBy(delta_stats.cells_read);
     tablet->metrics()->scanner_bytes_scanned_from_disk->IncrementBy(delta_stats.bytes_read);
     tablet->metrics()->scanner_predicates_disabled->IncrementBy(delta_stats.predicates_disabled);
+    tablet->metrics()->scanner_cells_skipped->IncrementBy(delta_stats.cells_skipped);
 
     // Last read timestamp.
     tablet->UpdateLastReadTime();
   }
 
-  *has_more_results = !req->close_scanner() && iter->HasNext() &&
+  *has_more_results = !req->close_scanner() &&
+      (scanner->HasPrefetchedBlocks() || iter->HasNext()) &&
       !scanner->has_fulfilled_limit();
   if (*has_more_results) {
     unreg_scanner.Cancel();
+    // Read ahead the rows to return to the next request while this response
+    // is on its way to the client.
+    server_->scanner_manager()->PrefetchAsync(scanner, batch_size_bytes);
   } else {
     VLOG(2) << "Scanner " << scanner->id() << " complete: removing...";
   }
@@ -3238,6 +4411,7 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
                                                const Schema& projection,
                                                Tablet* tablet,
                                                TimeManager* time_manager,
+                                               tablet::ChecksumScanState* checksum_scan,
                                                unique_ptr<RowwiseIterator>* iter,
                                                optional<Timestamp>* snap_start_timestamp,
                                                Timestamp* snap_timestamp,
@@ -3252,6 +4426,13 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
   }
 
   // Validate other input parameters as well in the very beginning.
+  if (scan_pb.has_max_staleness_usec() &&
+      (read_mode != READ_AT_SNAPSHOT || scan_pb.has_snap_timestamp())) {
+    *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+    return Status::InvalidArgument("maximum staleness is only supported in "
+                                   "READ_AT_SNAPSHOT read mode without a snapshot timestamp");
+  }
+  const bool bounded_staleness = scan_pb.has_max_staleness_usec();
   if (scan_pb.has_snap_start_timestamp()) {
     if (read_mode != READ_AT_SNAPSHOT) {
       // TODO(mpercy): Should we allow READ_YOUR_WRITES mode? There is no
@@ -3270,10 +4451,19 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
 
   // Based on the read mode, pick a timestamp and verify it.
   Timestamp tmp_snap_timestamp;
-  Status s = PickAndVerifyTimestamp(scan_pb, tablet, &tmp_snap_timestamp);
-  if (PREDICT_FALSE(!s.ok())) {
-    *error_code = TabletServerErrorPB::INVALID_SNAPSHOT;
-    return s.CloneAndPrepend("cannot verify timestamp");
+  Status s;
+  if (bounded_staleness) {
+    s = PickBoundedStalenessTimestamp(scan_pb, tablet, time_manager, &tmp_snap_timestamp);
+    if (PREDICT_FALSE(!s.ok())) {
+      *error_code = TabletServerErrorPB::REPLICA_TOO_STALE;
+      return s;
+    }
+  } else {
+    s = PickAndVerifyTimestamp(scan_pb, tablet, &tmp_snap_timestamp);
+    if (PREDICT_FALSE(!s.ok())) {
+      *error_code = TabletServerErrorPB::INVALID_SNAPSHOT;
+      return s.CloneAndPrepend("cannot verify timestamp");
+    }
   }
 
   // Reduce the client's deadline by a few msecs to allow for overhead.
@@ -3294,9 +4484,14 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
   // that came before it are, at least, started. This, together with waiting for the mvcc
   // snapshot to be clean below, allows us to always return the same data when scanning at
   // the same timestamp (repeatable reads).
-  TRACE("Waiting safe time to advance");
+  //
+  // The timestamp of a bounded-staleness scan is safe by construction, and
+  // there are no ops left to apply before it.
   const MonoTime before = MonoTime::Now();
-  s = time_manager->WaitUntilSafe(tmp_snap_timestamp, final_deadline);
+  if (!bounded_staleness) {
+    TRACE("Waiting safe time to advance");
+    s = time_manager->WaitUntilSafe(tmp_snap_timestamp, final_deadline);
+  }
 
   MvccSnapshot snap;
   if (PREDICT_TRUE(s.ok())) {
@@ -3317,12 +4512,21 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
 
   const auto duration_usec = (MonoTime::Now() - before).ToMicroseconds();
   tablet->metrics()->snapshot_read_inflight_wait_duration->Increment(duration_usec);
+  if (Trace* trace = Trace::CurrentTrace()) {
+    const MicrosecondsInt64 now_micros = GetCurrentTimeMicros();
+    trace->AddSpan("wait_for_snapshot", now_micros - duration_usec, now_micros);
+  }
   TRACE("All operations in snapshot committed. Waited for $0 microseconds", duration_usec);
 
   tablet::RowIteratorOptions opts;
   opts.projection = &projection;
   opts.snap_to_include = snap;
   opts.order = scan_pb.order_mode();
+  opts.parallel_scan_pool = server_->scanner_manager()->parallel_scan_pool();
+  if (checksum_scan) {
+    checksum_scan->snapshot_timestamp = tmp_snap_timestamp;
+    opts.checksum_scan = checksum_scan;
+  }
 
   optional<Timestamp> tmp_snap_start_timestamp;
   if (scan_pb.has_snap_start_timestamp()) {
@@ -3424,5 +4628,34 @@ Status TabletServiceImpl::PickAndVerifyTimestamp(const NewScanRequestPB& scan_pb
   return Status::OK();
 }
 
+Status TabletServiceImpl::PickBoundedStalenessTimestamp(const NewScanRequestPB& scan_pb,
+                                                        Tablet* tablet,
+                                                        TimeManager* time_manager,
+                                                        Timestamp* snap_timestamp) {
+  // No new op can start below the safe time. If the ops below it have all
+  // been applied, which is usually the case on an idle tablet, scan at the
+  // safe time. Otherwise, fall back to the clean timestamp: all the ops
+  // below it have been applied, and it's not higher than the safe time.
+  MvccManager* mvcc = tablet->mvcc_manager();
+  Timestamp timestamp = time_manager->GetSafeTime();
+  if (!mvcc->AreAllOpsApplied(timestamp)) {
+    timestamp = mvcc->GetCleanTimestamp();
+  }
+  clock::Clock* clock = server_->clock();
+  // The staleness can't be measured with the logical clock.
+  if (clock->HasPhysicalComponent()) {
+    const MonoDelta lag = clock->GetPhysicalComponentDifference(clock->Now(), timestamp);
+    const MonoDelta max_staleness = MonoDelta::FromMicroseconds(
+        static_cast<int64_t>(scan_pb.max_staleness_usec()));
+    if (lag > max_staleness) {
+      return Status::ServiceUnavailable(Substitute(
+          "replica lags $0 behind, more than the maximum staleness of $1",
+          lag.ToString(), max_staleness.ToString()));
+    }
+  }
+  *snap_timestamp = timestamp;
+  return Status::OK();
+}
+
 } // namespace tserver
 } // namespace kudu
@@ -60,6 +60,8 @@ class GetNodeInstanceRequestPB;
 class GetNodeInstanceResponsePB;
 class LeaderStepDownRequestPB;
 class LeaderStepDownResponsePB;
+class MultiConsensusRequestPB;
+class MultiConsensusResponsePB;
 class RunLeaderElectionRequestPB;
 class RunLeaderElectionResponsePB;
 class StartTabletCopyRequestPB;
@@ -78,6 +80,7 @@ class RpcContext;
 namespace tablet {
 class Tablet;
 class TabletReplica;
+struct ChecksumScanState;
 } // namespace tablet
 
 namespace tserver {
@@ -90,13 +93,18 @@ class CoordinateTransactionRequestPB;
 class CoordinateTransactionResponsePB;
 class CreateTabletRequestPB;
 class CreateTabletResponsePB;
+class CreateTabletsRequestPB;
+class CreateTabletsResponsePB;
 class DeleteTabletRequestPB;
 class DeleteTabletResponsePB;
+class DeleteTabletsRequestPB;
+class DeleteTabletsResponsePB;
 class ParticipantRequestPB;
 class ParticipantResponsePB;
 class QuiesceTabletServerRequestPB;
 class QuiesceTabletServerResponsePB;
 class ScanResultCollector;
+class Scanner;
 class TabletReplicaLookupIf;
 class TabletServer;
 
@@ -144,6 +152,14 @@ class TabletServiceImpl : public TabletServerServiceIf {
                      SplitKeyRangeResponsePB* resp,
                      rpc::RpcContext* context) override;
 
+  void LookupRows(const LookupRowsRequestPB* req,
+                  LookupRowsResponsePB* resp,
+                  rpc::RpcContext* context) override;
+
+  void GetTabletChanges(const GetTabletChangesRequestPB* req,
+                        GetTabletChangesResponsePB* resp,
+                        rpc::RpcContext* context) override;
+
   void Checksum(const ChecksumRequestPB* req,
                 ChecksumResponsePB* resp,
                 rpc::RpcContext* context) override;
@@ -153,6 +169,12 @@ class TabletServiceImpl : public TabletServerServiceIf {
   void Shutdown() override;
 
  private:
+  // Reads the rows of the scan request 'req', validated by Scan(), and
+  // responds to it.
+  void ScanAndRespond(const ScanRequestPB* req,
+                      ScanResponsePB* resp,
+                      rpc::RpcContext* context);
+
   Status HandleNewScanRequest(tablet::TabletReplica* tablet_replica,
                               const ScanRequestPB* req,
                               const rpc::RpcContext* rpc_context,
@@ -162,20 +184,27 @@ class TabletServiceImpl : public TabletServerServiceIf {
                               bool* has_more_results,
                               TabletServerErrorPB::Code* error_code);
 
-  Status HandleContinueScanRequest(const ScanRequestPB* req,
-                                   const rpc::RpcContext* rpc_context,
-                                   ScanResultCollector* result_collector,
-                                   bool* has_more_results,
-                                   TabletServerErrorPB::Code* error_code);
+  // If 'unregistered_scanner' is set, it's the scanner of the request, just
+  // created by HandleNewScanRequest() and not registered yet: it's registered
+  // only if the scan has more results than this response returns.
+  Status HandleContinueScanRequest(
+      const ScanRequestPB* req,
+      const rpc::RpcContext* rpc_context,
+      ScanResultCollector* result_collector,
+      bool* has_more_results,
+      TabletServerErrorPB::Code* error_code,
+      const std::shared_ptr<Scanner>& unregistered_scanner = nullptr);
 
   // Handle READ_AT_SNAPSHOT and READ_YOUR_WRITES scans.
   // Returns the opened row iterator, the start timestamp of a snapshot scan,
-  // if applicable, and the ending timestamp of a scan.
+  // if applicable, and the ending timestamp of a scan. If 'checksum_scan' is
+  // set, the scan is a checksum scan reusing the checksums of the rowsets.
   Status HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
                               const rpc::RpcContext* rpc_context,
                               const Schema& projection,
                               tablet::Tablet* tablet,
                               consensus::TimeManager* time_manager,
+                              tablet::ChecksumScanState* checksum_scan,
                               std::unique_ptr<RowwiseIterator>* iter,
                               std::optional<Timestamp>* snap_start_timestamp,
                               Timestamp* snap_timestamp,
@@ -192,6 +221,15 @@ class TabletServiceImpl : public TabletServerServiceIf {
                                 tablet::Tablet* tablet,
                                 Timestamp* snap_timestamp);
 
+  // Pick the timestamp of a bounded-staleness scan: the latest safe timestamp
+  // for which all the ops have already been applied locally. Returns
+  // ServiceUnavailable if it lags more than the scan's maximum staleness
+  // behind the clock.
+  Status PickBoundedStalenessTimestamp(const NewScanRequestPB& scan_pb,
+                                       tablet::Tablet* tablet,
+                                       consensus::TimeManager* time_manager,
+                                       Timestamp* snap_timestamp);
+
   TabletServer* server_;
 
   // Random generator used to make a decision on the admission of write
@@ -201,6 +239,10 @@ class TabletServiceImpl : public TabletServerServiceIf {
   // Counter to track number of rejected write requests while op apply queue
   // was overloaded.
   scoped_refptr<Counter> num_op_apply_queue_rejections_;
+
+  // Counter to track number of scan responses cut short because the memory
+  // of the scan responses reached its limit.
+  scoped_refptr<Counter> num_scan_batches_cut_for_memory_;
 };
 
 class TabletServiceAdminImpl : public TabletServerAdminServiceIf {
@@ -215,10 +257,18 @@ class TabletServiceAdminImpl : public TabletServerAdminServiceIf {
                     CreateTabletResponsePB* resp,
                     rpc::RpcContext* context) override;
 
+  void CreateTablets(const CreateTabletsRequestPB* req,
+                     CreateTabletsResponsePB* resp,
+                     rpc::RpcContext* context) override;
+
   void DeleteTablet(const DeleteTabletRequestPB* req,
                     DeleteTabletResponsePB* resp,
                     rpc::RpcContext* context) override;
 
+  void DeleteTablets(const DeleteTabletsRequestPB* req,
+                     DeleteTabletsResponsePB* resp,
+                     rpc::RpcContext* context) override;
+
   void AlterSchema(const AlterSchemaRequestPB* req,
                    AlterSchemaResponsePB* resp,
                    rpc::RpcContext* context) override;
@@ -256,6 +306,10 @@ class ConsensusServiceImpl : public consensus::ConsensusServiceIf {
                        consensus::ConsensusResponsePB* resp,
                        rpc::RpcContext* context) override;
 
+  void MultiUpdateConsensus(const consensus::MultiConsensusRequestPB* req,
+                            consensus::MultiConsensusResponsePB* resp,
+                            rpc::RpcContext* context) override;
+
   void RequestConsensusVote(const consensus::VoteRequestPB* req,
                             consensus::VoteResponsePB* resp,
                             rpc::RpcContext* context) override;
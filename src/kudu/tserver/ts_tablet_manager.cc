@@ -33,6 +33,8 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/codegen/compilation_manager.h"
+#include "kudu/codegen/row_projector.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/partition.h"
 #include "kudu/common/wire_protocol.h"
@@ -40,6 +42,8 @@
 #include "kudu/consensus/consensus.pb.h"
 #include "kudu/consensus/consensus_meta.h"
 #include "kudu/consensus/consensus_meta_manager.h"
+#include "kudu/consensus/heartbeat_coalescer.h"
+#include "kudu/consensus/leader_liveness_tracker.h"
 #include "kudu/consensus/log.h"
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/metadata.pb.h"
@@ -56,13 +60,16 @@
 #include "kudu/rpc/result_tracker.h"
 #include "kudu/server/rpc_server.h"
 #include "kudu/tablet/metadata.pb.h"
+#include "kudu/tablet/tablet.h"
 #include "kudu/tablet/tablet_bootstrap.h"
 #include "kudu/tablet/tablet_metadata.h"
+#include "kudu/tablet/tablet_metrics.h"
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tablet/txn_coordinator.h"
 #include "kudu/transactions/txn_status_manager.h"
 #include "kudu/transactions/txn_system_client.h"
 #include "kudu/tserver/heartbeater.h"
+#include "kudu/tserver/tablet_copy_throttle.h"
 #include "kudu/tserver/tablet_server.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/fault_injection.h"
@@ -103,6 +110,12 @@ DEFINE_int32(num_tablets_to_delete_simultaneously, 0,
              "device such as SSD or a RAID array, it may make sense to manually tune this.");
 TAG_FLAG(num_tablets_to_delete_simultaneously, advanced);
 
+DEFINE_int32(num_tablets_to_create_simultaneously, 0,
+             "Number of threads available to create the tablets of a CreateTablets "
+             "request. If this is set to 0 (the default), then the number of create "
+             "threads will be set based on the number of data directories.");
+TAG_FLAG(num_tablets_to_create_simultaneously, advanced);
+
 DEFINE_int32(num_txn_status_tablets_to_reload_simultaneously, 0,
              "Number of threads available to reload transaction status tablets in memory "
              "metadata. If this is set to 0 (the default), then the number of reload threads "
@@ -198,7 +211,22 @@ DEFINE_bool(tablet_bootstrap_skip_opening_tablet_for_testing, false,
             "Only for testing.");
 TAG_FLAG(tablet_bootstrap_skip_opening_tablet_for_testing, hidden);
 
+DEFINE_bool(open_tablets_while_loading_metadata, true,
+            "Whether to start opening each tablet found on startup as soon as its "
+            "metadata is loaded, rather than once the metadata of all the tablets "
+            "is loaded.");
+TAG_FLAG(open_tablets_while_loading_metadata, advanced);
+
+DEFINE_bool(codegen_warmup_tablet_schemas, true,
+            "Whether to request the code generation of the memrowset row projector "
+            "for the schema of each tablet once the tablet is opened, so that scans "
+            "don't fall back to the interpreted projector after a restart.");
+TAG_FLAG(codegen_warmup_tablet_schemas, experimental);
+TAG_FLAG(codegen_warmup_tablet_schemas, runtime);
+
+DECLARE_bool(mrs_use_codegen);
 DECLARE_bool(raft_prepare_replacement_before_eviction);
+DECLARE_int64(tablet_copy_throttler_bytes_per_sec);
 DECLARE_uint32(txn_staleness_tracker_interval_ms);
 
 METRIC_DEFINE_gauge_int32(server, tablets_num_not_initialized,
@@ -288,16 +316,22 @@ using kudu::consensus::ConsensusMetadataCreateMode;
 using kudu::consensus::ConsensusMetadataManager;
 using kudu::consensus::ConsensusStatePB;
 using kudu::consensus::EXCLUDE_HEALTH_REPORT;
+using kudu::consensus::HeartbeatCoalescer;
 using kudu::consensus::INCLUDE_HEALTH_REPORT;
+using kudu::consensus::LeaderLivenessTracker;
 using kudu::consensus::OpId;
 using kudu::consensus::OpIdToString;
 using kudu::consensus::RECEIVED_OPID;
 using kudu::consensus::RaftConfigPB;
 using kudu::consensus::RaftConsensus;
+using kudu::consensus::RaftPeerPB;
+using kudu::consensus::ServerContext;
 using kudu::consensus::StartTabletCopyRequestPB;
 using kudu::consensus::kMinimumTerm;
 using kudu::fs::DataDirManager;
 using kudu::log::Log;
+using kudu::master::ReplicaLoadPB;
+using kudu::master::ReplicaLoadReportPB;
 using kudu::master::ReportedTabletPB;
 using kudu::master::TabletReportPB;
 using kudu::tablet::ReportedTabletStatsPB;
@@ -318,6 +352,7 @@ using std::set;
 using std::shared_lock;
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
@@ -346,7 +381,8 @@ TSTabletManager::TSTabletManager(TabletServer* server)
     shutdown_latch_(1),
     metric_registry_(server->metric_registry()),
     tablet_copy_metrics_(server->metric_entity()),
-    state_(MANAGER_INITIALIZING) {
+    state_(MANAGER_INITIALIZING),
+    leader_liveness_(new LeaderLivenessTracker) {
   // A heartbeat msg without statistics will be considered to be from an old
   // version, thus it's necessary to trigger updating stats as soon as possible.
   next_update_time_ = MonoTime::Now();
@@ -448,6 +484,9 @@ Status TSTabletManager::Init(Timer* start_tablets,
                              std::atomic<int>* tablets_total) {
   CHECK_EQ(state(), MANAGER_INITIALIZING);
 
+  heartbeat_coalescer_.reset(
+      new HeartbeatCoalescer(server_->messenger(), server_->dns_resolver()));
+
   // Start the tablet copy thread pool. We set a max queue size of 0 so that if
   // the number of requests exceeds the number of threads, a
   // SERVICE_UNAVAILABLE error may be returned to the remote caller.
@@ -455,6 +494,12 @@ Status TSTabletManager::Init(Timer* start_tablets,
                 .set_max_queue_size(0)
                 .set_max_threads(FLAGS_num_tablets_to_copy_simultaneously)
                 .Build(&tablet_copy_pool_));
+  if (FLAGS_tablet_copy_throttler_bytes_per_sec > 0) {
+    tablet_copy_throttle_ = std::make_shared<TabletCopyThrottleController>(
+        FLAGS_tablet_copy_throttler_bytes_per_sec,
+        TabletCopyThrottleController::ScanLatencyHistogram(server_->metric_entity()));
+    tablet_copy_throttle_->Start(server_->messenger());
+  }
 
   RETURN_NOT_OK(ThreadPoolBuilder("txn-commit")
                 .set_max_threads(FLAGS_txn_commit_pool_num_threads)
@@ -481,6 +526,15 @@ Status TSTabletManager::Init(Timer* start_tablets,
                 .set_max_threads(max_delete_threads)
                 .Build(&delete_tablet_pool_));
 
+  int max_create_threads = FLAGS_num_tablets_to_create_simultaneously;
+  if (max_create_threads == 0) {
+    // Default to the number of disks.
+    max_create_threads = fs_manager_->GetDataRootDirs().size();
+  }
+  RETURN_NOT_OK(ThreadPoolBuilder("tablet-create")
+                .set_max_threads(max_create_threads)
+                .Build(&create_tablet_pool_));
+
   int max_reload_threads = FLAGS_num_txn_status_tablets_to_reload_simultaneously;
   if (max_reload_threads == 0) {
     // Default to the number of data directories.
@@ -516,6 +570,34 @@ Status TSTabletManager::Init(Timer* start_tablets,
 
   InitLocalRaftPeerPB();
 
+  *tablets_processed = 0;
+  int registered_count = 0;
+  if (FLAGS_open_tablets_while_loading_metadata &&
+      PREDICT_TRUE(!FLAGS_tablet_bootstrap_skip_opening_tablet_for_testing)) {
+    RETURN_NOT_OK(LoadAndOpenTablets(tablet_ids, max_open_threads, start_tablets,
+                                     tablets_processed, tablets_total, &registered_count));
+  } else {
+    RETURN_NOT_OK(LoadTabletMetadataThenOpenTablets(tablet_ids, start_tablets, tablets_processed,
+                                                    tablets_total, &registered_count));
+  }
+
+  if (registered_count == 0) {
+    start_tablets->Stop();
+  }
+
+  {
+    std::lock_guard<RWMutex> lock(lock_);
+    state_ = MANAGER_RUNNING;
+  }
+
+  return Status::OK();
+}
+
+Status TSTabletManager::LoadTabletMetadataThenOpenTablets(const vector<string>& tablet_ids,
+                                                          Timer* start_tablets,
+                                                          std::atomic<int>* tablets_processed,
+                                                          std::atomic<int>* tablets_total,
+                                                          int* registered_count) {
   vector<scoped_refptr<TabletMetadata>> metas(tablet_ids.size());
 
   // First, load all of the tablet metadata. We do this before we start
@@ -578,13 +660,13 @@ Status TSTabletManager::Init(Timer* start_tablets,
 
     LOG(INFO) << Substitute("Loaded tablet metadata ($0 total tablets, $1 live tablets)",
                             total_loaded_count.load(), success_loaded_count.load());
+    std::lock_guard<simple_spinlock> l(startup_progress_lock_);
     *tablets_total = success_loaded_count.load();
+    startup_tablets_registered_ = true;
   }
 
   // Now submit the "Open" task for each.
   METRIC_tablets_num_total_startup.Instantiate(server_->metric_entity(), *tablets_total);
-  *tablets_processed = 0;
-  int registered_count = 0;
   if (PREDICT_TRUE(!FLAGS_tablet_bootstrap_skip_opening_tablet_for_testing)) {
     SCOPED_LOG_TIMING(INFO, Substitute("register tablets"));
     for (const auto& meta : metas) {
@@ -592,34 +674,122 @@ Status TSTabletManager::Init(Timer* start_tablets,
         continue;
       }
       KLOG_EVERY_N_SECS(INFO, 1) << Substitute("Registering tablets ($0/$1 complete)",
-                                               registered_count, metas.size());
-      scoped_refptr<TransitionInProgressDeleter> deleter;
-      {
-        std::lock_guard<RWMutex> lock(lock_);
-        CHECK_OK(StartTabletStateTransitionUnlocked(meta->tablet_id(), "opening tablet", &deleter));
-      }
+                                               *registered_count, metas.size());
+      RETURN_NOT_OK(RegisterAndSubmitOpenTablet(meta, start_tablets, tablets_processed,
+                                                tablets_total));
+      ++*registered_count;
+    }
+    LOG(INFO) << Substitute("Registered $0 tablets", *registered_count);
+  }
+  return Status::OK();
+}
 
-      scoped_refptr<TabletReplica> replica;
-      RETURN_NOT_OK(CreateAndRegisterTabletReplica(meta, NEW_REPLICA, &replica));
-      RETURN_NOT_OK(open_tablet_pool_->Submit(
-          [this, replica, deleter, tablets_processed, tablets_total, start_tablets]() {
-            this->OpenTablet(replica, deleter, tablets_processed, tablets_total, start_tablets);
-          }));
-      registered_count++;
+Status TSTabletManager::LoadAndOpenTablets(const vector<string>& tablet_ids,
+                                           int num_threads,
+                                           Timer* start_tablets,
+                                           std::atomic<int>* tablets_processed,
+                                           std::atomic<int>* tablets_total,
+                                           int* registered_count) {
+  SCOPED_LOG_TIMING(INFO, "load tablet metadata and register tablets");
+  std::atomic<int> total_loaded_count = 0;
+  std::atomic<int> success_loaded_count = 0;
+  std::atomic<bool> seen_error = false;
+  Status first_error;
+
+  // The metadata is loaded on a pool of its own, so that its loading may be
+  // waited for independently of the opening of the tablets. The pool is
+  // declared last so that it's destroyed, and its tasks are done, first.
+  unique_ptr<ThreadPool> load_pool;
+  RETURN_NOT_OK(ThreadPoolBuilder("tablet-meta-load")
+                .set_max_threads(num_threads)
+                .Build(&load_pool));
+  for (int i = 0; i < tablet_ids.size(); i++) {
+    if (seen_error) {
+      // If seen any error, we should abort loading tablet metadata.
+      break;
     }
-    LOG(INFO) << Substitute("Registered $0 tablets", registered_count);
+
+    RETURN_NOT_OK(load_pool->Submit([&, i]() {
+      const string& tablet_id = tablet_ids[i];
+      Status s;
+      do {
+        KLOG_EVERY_N_SECS(INFO, 1) << Substitute("Loading tablet metadata ($0/$1 complete)",
+                                                 total_loaded_count.load(), tablet_ids.size());
+
+        scoped_refptr<TabletMetadata> meta;
+        s = OpenTabletMeta(tablet_id, &meta);
+        if (!s.ok()) {
+          s = s.CloneAndPrepend(Substitute("could not open tablet metadata: $0", tablet_id));
+          break;
+        }
+
+        total_loaded_count++;
+
+        if (meta->tablet_data_state() != TABLET_DATA_READY) {
+          s = HandleNonReadyTabletOnStartup(meta);
+          if (!s.ok()) {
+            s = s.CloneAndPrepend(Substitute("could not handle non-ready tablet: $0", tablet_id));
+          }
+          break;
+        }
+
+        {
+          std::lock_guard<simple_spinlock> l(startup_progress_lock_);
+          ++*tablets_total;
+        }
+        s = RegisterAndSubmitOpenTablet(meta, start_tablets, tablets_processed, tablets_total);
+        if (!s.ok()) {
+          s = s.CloneAndPrepend(Substitute("could not register tablet: $0", tablet_id));
+          break;
+        }
+        success_loaded_count++;
+      } while (false);
+
+      if (!s.ok()) {
+        bool current_seen_error = false;
+        if (seen_error.compare_exchange_strong(current_seen_error, true)) {
+          first_error = s;
+        }
+      }
+    }));
+  }
+  load_pool->Wait();
+  if (seen_error) {
+    LOG_AND_RETURN(ERROR, first_error);
   }
 
-  if (registered_count == 0) {
-    start_tablets->Stop();
+  LOG(INFO) << Substitute("Loaded tablet metadata and registered tablets "
+                          "($0 total tablets, $1 live tablets)",
+                          total_loaded_count.load(), success_loaded_count.load());
+  *registered_count = success_loaded_count.load();
+  METRIC_tablets_num_total_startup.Instantiate(server_->metric_entity(), *registered_count);
+
+  // Some tablets may have already been opened: the last one of them couldn't
+  // tell that it was the last.
+  std::lock_guard<simple_spinlock> l(startup_progress_lock_);
+  startup_tablets_registered_ = true;
+  if (*registered_count > 0 && *tablets_processed == *tablets_total) {
+    FinishStartTabletsUnlocked(start_tablets);
   }
+  return Status::OK();
+}
 
+Status TSTabletManager::RegisterAndSubmitOpenTablet(const scoped_refptr<TabletMetadata>& meta,
+                                                    Timer* start_tablets,
+                                                    std::atomic<int>* tablets_processed,
+                                                    std::atomic<int>* tablets_total) {
+  scoped_refptr<TransitionInProgressDeleter> deleter;
   {
     std::lock_guard<RWMutex> lock(lock_);
-    state_ = MANAGER_RUNNING;
+    CHECK_OK(StartTabletStateTransitionUnlocked(meta->tablet_id(), "opening tablet", &deleter));
   }
 
-  return Status::OK();
+  scoped_refptr<TabletReplica> replica;
+  RETURN_NOT_OK(CreateAndRegisterTabletReplica(meta, NEW_REPLICA, &replica));
+  return open_tablet_pool_->Submit(
+      [this, replica, deleter, tablets_processed, tablets_total, start_tablets]() {
+        this->OpenTablet(replica, deleter, tablets_processed, tablets_total, start_tablets);
+      });
 }
 
 Status TSTabletManager::WaitForAllBootstrapsToFinish() {
@@ -960,8 +1130,9 @@ void TSTabletManager::RunTabletCopy(
   //   to the leader.
   //
   // TODO(aserbin): make this robust and more optimal than it is now.
-  RemoteTabletCopyClient tc_client(tablet_id, fs_manager_, cmeta_manager_,
-                                   server_->messenger(), &tablet_copy_metrics_);
+  RemoteTabletCopyClient tc_client(
+      tablet_id, fs_manager_, cmeta_manager_, server_->messenger(), &tablet_copy_metrics_,
+      tablet_copy_throttle_ ? tablet_copy_throttle_->throttler() : nullptr);
 
   // Download and persist the remote superblock in TABLET_DATA_COPYING state.
   if (replacing_tablet) {
@@ -1041,9 +1212,12 @@ Status TSTabletManager::CreateAndRegisterTabletReplica(
                         [this, tablet_id](const string& reason) {
                           this->MarkTabletDirty(tablet_id, reason);
                         }));
-  Status s = replica->Init({ server_->mutable_quiescing(),
-                             server_->num_raft_leaders(),
-                             server_->raft_pool() });
+  ServerContext server_ctx{ server_->mutable_quiescing(),
+                            server_->num_raft_leaders(),
+                            server_->raft_pool() };
+  server_ctx.leader_liveness = leader_liveness_.get();
+  server_ctx.heartbeat_coalescer = heartbeat_coalescer_.get();
+  Status s = replica->Init(std::move(server_ctx));
   if (PREDICT_FALSE(!s.ok())) {
     replica->SetError(s);
     replica->Shutdown();
@@ -1388,8 +1562,7 @@ void TSTabletManager::OpenTablet(const scoped_refptr<tablet::TabletReplica>& rep
   });
   if (PREDICT_FALSE(!s.ok())) {
     LOG(ERROR) << LogPrefix(tablet_id) << "Failed to load consensus metadata: " << s.ToString();
-    IncrementTabletsProcessed((tablets_total != nullptr) ? tablets_total->load() : 0,
-                          tablets_processed, start_tablets);
+    IncrementTabletsProcessed(tablets_total, tablets_processed, start_tablets);
     return;
   }
 
@@ -1418,8 +1591,7 @@ void TSTabletManager::OpenTablet(const scoped_refptr<tablet::TabletReplica>& rep
     if (!s.ok()) {
       LOG(ERROR) << LogPrefix(tablet_id) << "Tablet failed to bootstrap: "
                  << s.ToString();
-      IncrementTabletsProcessed((tablets_total != nullptr) ? tablets_total->load() : 0,
-                            tablets_processed, start_tablets);
+      IncrementTabletsProcessed(tablets_total, tablets_processed, start_tablets);
       return;
     }
   }
@@ -1438,8 +1610,7 @@ void TSTabletManager::OpenTablet(const scoped_refptr<tablet::TabletReplica>& rep
     if (!s.ok()) {
       LOG(ERROR) << LogPrefix(tablet_id) << "Tablet failed to start: "
                  << s.ToString();
-      IncrementTabletsProcessed((tablets_total != nullptr) ? tablets_total->load() : 0,
-                            tablets_processed, start_tablets);
+      IncrementTabletsProcessed(tablets_total, tablets_processed, start_tablets);
       return;
     }
 
@@ -1455,6 +1626,15 @@ void TSTabletManager::OpenTablet(const scoped_refptr<tablet::TabletReplica>& rep
   // Now that the tablet has successfully opened, cancel the cleanup.
   fail_tablet.cancel();
 
+  if (FLAGS_codegen_warmup_tablet_schemas && FLAGS_mrs_use_codegen && tablet) {
+    // Compile in the background the projector of the scans of all the columns,
+    // unless it's cached already.
+    const auto schema = tablet->schema();
+    unique_ptr<codegen::RowProjector> projector;
+    codegen::CompilationManager::GetSingleton()->RequestRowProjector(
+        schema.get(), schema.get(), &projector);
+  }
+
   int elapsed_ms = (MonoTime::Now() - start).ToMilliseconds();
   if (elapsed_ms > FLAGS_tablet_start_warn_threshold_ms) {
     LOG(WARNING) << LogPrefix(tablet_id) << "Tablet startup took " << elapsed_ms << "ms";
@@ -1463,26 +1643,32 @@ void TSTabletManager::OpenTablet(const scoped_refptr<tablet::TabletReplica>& rep
                    << Trace::CurrentTrace()->DumpToString();
     }
   }
-  IncrementTabletsProcessed((tablets_total != nullptr) ? tablets_total->load() : 0,
-                        tablets_processed, start_tablets);
+  IncrementTabletsProcessed(tablets_total, tablets_processed, start_tablets);
   deleter->Destroy();
   MarkTabletDirty(tablet_id, "Open tablet completed");
 }
 
-void TSTabletManager::IncrementTabletsProcessed(int tablets_total,
-                                            std::atomic<int>* tablets_processed,
-                                            Timer* start_tablets) {
+void TSTabletManager::IncrementTabletsProcessed(std::atomic<int>* tablets_total,
+                                                std::atomic<int>* tablets_processed,
+                                                Timer* start_tablets) {
   if (tablets_processed) {
-    ++*tablets_processed;
     tablets_num_opened_startup_->Increment();
-    if (*tablets_processed == tablets_total) {
-      start_tablets->Stop();
-      METRIC_tablets_opening_time_startup.Instantiate(server_->metric_entity(),
-          (start_tablets->TimeElapsed()).ToMilliseconds());
+    std::lock_guard<simple_spinlock> l(startup_progress_lock_);
+    ++*tablets_processed;
+    if (startup_tablets_registered_ && tablets_total &&
+        *tablets_processed == *tablets_total) {
+      FinishStartTabletsUnlocked(start_tablets);
     }
   }
 }
 
+void TSTabletManager::FinishStartTabletsUnlocked(Timer* start_tablets) {
+  DCHECK(startup_progress_lock_.is_locked());
+  start_tablets->Stop();
+  METRIC_tablets_opening_time_startup.Instantiate(server_->metric_entity(),
+      (start_tablets->TimeElapsed()).ToMilliseconds());
+}
+
 void TSTabletManager::Shutdown() {
   {
     std::lock_guard<RWMutex> lock(lock_);
@@ -1512,6 +1698,9 @@ void TSTabletManager::Shutdown() {
   if (tablet_copy_pool_ != nullptr) {
     tablet_copy_pool_->Shutdown();
   }
+  if (tablet_copy_throttle_) {
+    tablet_copy_throttle_->Shutdown();
+  }
 
   // Shut down the bootstrap pool, so no new tablets are registered after this point.
   if (open_tablet_pool_ != nullptr) {
@@ -1523,6 +1712,11 @@ void TSTabletManager::Shutdown() {
     delete_tablet_pool_->Shutdown();
   }
 
+  // Likewise for the create pool.
+  if (create_tablet_pool_ != nullptr) {
+    create_tablet_pool_->Shutdown();
+  }
+
   // Shut down the transaction participant registration pool.
   if (txn_participant_registration_pool_ != nullptr) {
     txn_participant_registration_pool_->Shutdown();
@@ -1802,6 +1996,33 @@ void TSTabletManager::PopulateFullTabletReport(TabletReportPB* report) const {
   }
 }
 
+void TSTabletManager::PopulateReplicaLoadReport(ReplicaLoadReportPB* report) const {
+  // See comment in PopulateFullTabletReport for rationale on making a local
+  // copy of the set of replicas.
+  vector<scoped_refptr<tablet::TabletReplica>> replicas;
+  GetTabletReplicas(&replicas);
+  for (const auto& replica : replicas) {
+    if (replica->state() != tablet::RUNNING) {
+      continue;
+    }
+    shared_ptr<Tablet> tablet = replica->shared_tablet();
+    shared_ptr<RaftConsensus> consensus = replica->shared_consensus();
+    if (!tablet || !consensus || !tablet->metrics()) {
+      continue;
+    }
+    const tablet::TabletMetrics* metrics = tablet->metrics();
+    ReplicaLoadPB* load = report->add_replicas();
+    load->set_tablet_id(replica->tablet_id());
+    load->set_rows_read(metrics->scanner_rows_scanned->value());
+    load->set_rows_written(metrics->rows_inserted->value() +
+                           metrics->rows_upserted->value() +
+                           metrics->rows_updated->value() +
+                           metrics->rows_deleted->value());
+    load->set_on_disk_size(replica->OnDiskSize());
+    load->set_is_leader(consensus->role() == RaftPeerPB::LEADER);
+  }
+}
+
 void TSTabletManager::PopulateIncrementalTabletReport(TabletReportPB* report,
                                                       const vector<string>& tablet_ids,
                                                       bool including_tombstoned) const {
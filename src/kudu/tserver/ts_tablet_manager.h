@@ -65,11 +65,14 @@ class TxnSystemClient;
 
 namespace consensus {
 class ConsensusMetadataManager;
+class HeartbeatCoalescer;
+class LeaderLivenessTracker;
 class OpId;
 class StartTabletCopyRequestPB;
 } // namespace consensus
 
 namespace master {
+class ReplicaLoadReportPB;
 class ReportedTabletPB;
 class TabletReportPB;
 } // namespace master
@@ -79,6 +82,7 @@ class TabletMetadata;
 }
 
 namespace tserver {
+class TabletCopyThrottleController;
 class TabletServer;
 
 // Map of tablet id -> transition reason string.
@@ -110,6 +114,8 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   // Load all tablet metadata blocks from disk, and open their respective tablets.
   // Starts the timer, 'start_tablets' and populates the 'tablets_total'. The subsequent
   // function call to OpenTablet() updates 'tablets_processed' and stops the timer.
+  // With --open_tablets_while_loading_metadata, 'tablets_total' grows as the
+  // metadata of the tablets is loaded, and tablets may already be opened by then.
   // Upon return of this method all existing tablets are registered, but
   // the bootstrap is performed asynchronously.
   Status Init(Timer* start_tablets,
@@ -144,6 +150,10 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
                          std::optional<TableTypePB> table_type,
                          scoped_refptr<tablet::TabletReplica>* replica);
 
+  // Pool to create the tablets of batched creation requests on, see
+  // --num_tablets_to_create_simultaneously.
+  ThreadPool* create_tablet_pool() const { return create_tablet_pool_.get(); }
+
   // Delete the specified tablet asynchronously with callback 'cb'.
   // - If the async task cannot be started, 'cb' will be called with
   //   Status::ServiceUnavailable and TabletServerErrorPB::THROTTLED.
@@ -201,6 +211,9 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
                                        const std::vector<std::string>& tablet_ids,
                                        bool including_tombstoned) const;
 
+  // Adds the load of the RUNNING replicas to 'report'.
+  void PopulateReplicaLoadReport(master::ReplicaLoadReportPB* report) const;
+
   // Get all the tablets currently hosted on this server.
   void GetTabletReplicas(
       std::vector<scoped_refptr<tablet::TabletReplica>>* replicas) const override;
@@ -330,6 +343,33 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   Status OpenTabletMeta(const std::string& tablet_id,
                         scoped_refptr<tablet::TabletMetadata>* metadata);
 
+  // Loads the metadata of all the tablets in 'tablet_ids', then registers the
+  // live ones and submits their opening. Sets 'tablets_total' and
+  // 'registered_count' to the number of registered tablets.
+  Status LoadTabletMetadataThenOpenTablets(const std::vector<std::string>& tablet_ids,
+                                           Timer* start_tablets,
+                                           std::atomic<int>* tablets_processed,
+                                           std::atomic<int>* tablets_total,
+                                           int* registered_count);
+
+  // Loads the metadata of the tablets in 'tablet_ids' on 'num_threads'
+  // threads and, as soon as the metadata of a tablet is loaded, registers the
+  // tablet and submits its opening, counting it in 'tablets_total'. Sets
+  // 'registered_count' to the number of registered tablets.
+  Status LoadAndOpenTablets(const std::vector<std::string>& tablet_ids,
+                            int num_threads,
+                            Timer* start_tablets,
+                            std::atomic<int>* tablets_processed,
+                            std::atomic<int>* tablets_total,
+                            int* registered_count);
+
+  // Registers the tablet with the given metadata and submits its opening to
+  // 'open_tablet_pool_'.
+  Status RegisterAndSubmitOpenTablet(const scoped_refptr<tablet::TabletMetadata>& meta,
+                                     Timer* start_tablets,
+                                     std::atomic<int>* tablets_processed,
+                                     std::atomic<int>* tablets_total);
+
   // Open a tablet whose metadata has already been loaded/created.
   // This method does not return anything as it can be run asynchronously.
   // Upon completion of this method the tablet should be initialized and running.
@@ -408,8 +448,13 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   // If 'tablets_processed' is not nullptr, 'tablets_processed' will be incremented
   // after every tablet is attempted to be opened and the timer is stopped once all
   // the tablets are processed.
-  void IncrementTabletsProcessed(int tablets_total, std::atomic<int>* tablets_processed,
-                             Timer* start_tablets);
+  void IncrementTabletsProcessed(std::atomic<int>* tablets_total,
+                                 std::atomic<int>* tablets_processed,
+                                 Timer* start_tablets);
+
+  // Marks the end of the startup, once all the tablets were opened.
+  // 'startup_progress_lock_' must be held.
+  void FinishStartTabletsUnlocked(Timer* start_tablets);
 
   FsManager* const fs_manager_;
 
@@ -450,6 +495,10 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
 
   TabletCopyClientMetrics tablet_copy_metrics_;
 
+  // Throttles the tablets copied to this server, if
+  // --tablet_copy_throttler_bytes_per_sec is set.
+  std::shared_ptr<TabletCopyThrottleController> tablet_copy_throttle_;
+
   // Timestamp indicating the last time tablet_map_ was walked to count
   // tablet states.
   MonoTime last_walked_ = MonoTime::Min();
@@ -464,6 +513,12 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
 
   TSTabletManagerStatePB state_;
 
+  // Tracks the liveness of the servers leading the replicas of this server.
+  std::unique_ptr<consensus::LeaderLivenessTracker> leader_liveness_;
+
+  // Coalesces the heartbeats sent by the leaders of this server.
+  std::unique_ptr<consensus::HeartbeatCoalescer> heartbeat_coalescer_;
+
   // Thread pool used to run tablet copy operations.
   std::unique_ptr<ThreadPool> tablet_copy_pool_;
 
@@ -473,6 +528,9 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   // Thread pool used to delete tablets asynchronously.
   std::unique_ptr<ThreadPool> delete_tablet_pool_;
 
+  // Thread pool used to create the tablets of batched requests concurrently.
+  std::unique_ptr<ThreadPool> create_tablet_pool_;
+
   // Thread pool used to reload transaction status tablets asynchronously.
   std::unique_ptr<ThreadPool> reload_txn_status_tablet_pool_;
 
@@ -497,6 +555,14 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   // during server startup
   scoped_refptr<AtomicGauge<uint32_t>> tablets_num_opened_startup_;
 
+  // Serializes the updates of the startup progress of the tablets, so that
+  // the startup ends exactly once.
+  simple_spinlock startup_progress_lock_;
+
+  // Whether all the tablets found on startup have been registered, i.e.
+  // whether their total is known. Protected by 'startup_progress_lock_'.
+  bool startup_tablets_registered_ = false;
+
   // NOTE: it's important that this is the first member to be destructed. This
   // ensures we do not attempt to collect metrics while calling the destructor.
   FunctionGaugeDetacher metric_detacher_;
@@ -47,14 +47,17 @@
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/escaping.h"
 #include "kudu/gutil/strings/human_readable.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/remote_user.h"
 #include "kudu/server/webui_util.h"
+#include "kudu/tablet/lock_manager.h"
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/ops/op.h"
+#include "kudu/tablet/tablet.h"
 #include "kudu/tablet/tablet.pb.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet_replica.h"
@@ -62,6 +65,7 @@
 #include "kudu/tserver/tablet_server.h"
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/util/easy_json.h"
+#include "kudu/util/hot_key_tracker.h"
 #include "kudu/util/maintenance_manager.h"
 #include "kudu/util/maintenance_manager.pb.h"
 #include "kudu/util/monotime.h"
@@ -444,6 +448,41 @@ void TabletServerPathHandlers::HandleTabletPage(const Webserver::WebRequest& req
   }
 
   SchemaToJson(*schema_ptr, output);
+
+  shared_ptr<Tablet> tablet = replica->shared_tablet();
+  if (tablet) {
+    EasyJson row_locks_json = output->Set("row_locks", EasyJson::kObject);
+    EasyJson shards_json = row_locks_json.Set("shards", EasyJson::kArray);
+    const auto profile = tablet->lock_manager()->GetContentionProfile();
+    for (int i = 0; i < profile.size(); i++) {
+      const auto& p = profile[i];
+      EasyJson shard_json = shards_json.PushBack(EasyJson::kObject);
+      shard_json["shard"] = i;
+      shard_json["lock_requests"] = p.lock_requests;
+      shard_json["locked_keys"] = p.locked_keys;
+      shard_json["contended_acquisitions"] = p.contended_acquisitions;
+      shard_json["total_wait"] = HumanReadableElapsedTime::ToShortString(p.wait_us / 1e6);
+      shard_json["max_wait"] = HumanReadableElapsedTime::ToShortString(p.max_wait_us / 1e6);
+    }
+
+    const uint64_t sampled_keys = tablet->hot_keys().total_count();
+    const uint64_t sampled_ranges = tablet->hot_key_ranges().total_count();
+    if (sampled_keys > 0 && sampled_ranges > 0) {
+      EasyJson hot_keys_json = output->Set("hot_keys", EasyJson::kObject);
+      EasyJson keys_json = hot_keys_json.Set("keys", EasyJson::kArray);
+      for (const auto& k : tablet->hot_keys().HotKeys()) {
+        EasyJson key_json = keys_json.PushBack(EasyJson::kObject);
+        key_json["key"] = schema_ptr->DebugEncodedRowKey(k.key, Schema::START_KEY);
+        key_json["share"] = StringPrintf("%.1f%%", 100.0 * k.count / sampled_keys);
+      }
+      EasyJson ranges_json = hot_keys_json.Set("ranges", EasyJson::kArray);
+      for (const auto& r : tablet->hot_key_ranges().HotKeys()) {
+        EasyJson range_json = ranges_json.PushBack(EasyJson::kObject);
+        range_json["prefix"] = strings::b2a_hex(r.key);
+        range_json["share"] = StringPrintf("%.1f%%", 100.0 * r.count / sampled_ranges);
+      }
+    }
+  }
 }
 
 void TabletServerPathHandlers::HandleTabletSVGPage(const Webserver::WebRequest& req,
@@ -104,6 +104,15 @@ class BitReader {
   template<typename T>
   bool GetValue(int num_bits, T* v);
 
+  // Gets the next 'batch_size' values from the buffer as GetValue() would,
+  // storing them in 'v'. Returns the number of values read, which is less
+  // than 'batch_size' only if there are not enough bytes left.
+  //
+  // The values are unpacked in bulk once the stream is byte-aligned, e.g.
+  // with SIMD instructions for runs of single bits: see UnpackBits1().
+  template<typename T>
+  int GetValues(int num_bits, T* v, int batch_size);
+
   // Reads a 'num_bytes'-sized value from the buffer and stores it in 'v'. T needs to be a
   // little-endian native type and big enough to store 'num_bytes'. The value is assumed
   // to be byte-aligned so the stream will be advanced to the start of the next byte
@@ -17,10 +17,14 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include "glog/logging.h"
 #include "kudu/util/bit-stream-utils.h"
 #include "kudu/util/alignment.h"
+#include "kudu/util/bit-unpack.h"
 
 namespace kudu {
 
@@ -132,6 +136,56 @@ inline bool BitReader::GetValue(int num_bits, T* v) {
   return true;
 }
 
+template<typename T>
+inline int BitReader::GetValues(int num_bits, T* v, int batch_size) {
+  DCHECK_LE(num_bits, 64);
+  DCHECK_LE(num_bits, sizeof(T) * 8);
+
+  const int64_t bits_left = static_cast<int64_t>(max_bytes_) * 8 - position();
+  const int num_values = static_cast<int>(std::min<int64_t>(batch_size, bits_left / num_bits));
+
+  // Read the values one at a time until the stream is byte-aligned.
+  int i = 0;
+  for (; i < num_values && (bit_offset_ & 7) != 0; i++) {
+    GetValue(num_bits, &v[i]);
+  }
+  const int n = num_values - i;
+  if (n == 0) {
+    return num_values;
+  }
+
+  const uint8_t* src = buffer_ + byte_offset_ + bit_offset_ / 8;
+  const int src_bytes = max_bytes_ - static_cast<int>(src - buffer_);
+  if (num_bits == 1 && sizeof(T) == 1) {
+    UnpackBits1(src, n, reinterpret_cast<uint8_t*>(v + i));
+  } else if (num_bits == sizeof(T) * 8 && !std::is_same<T, bool>::value) {
+    // The values are stored as they are in memory.
+    memcpy(v + i, src, n * sizeof(T));
+  } else if (num_bits <= 56) {
+    // Any value starting within a byte lies within the 8 bytes loaded from it.
+    const uint64_t mask = (1ULL << num_bits) - 1;
+    for (int j = 0; j < n; j++) {
+      const int64_t bit = static_cast<int64_t>(j) * num_bits;
+      const int64_t byte = bit / 8;
+      uint64_t word = 0;
+      memcpy(&word, src + byte, std::min<int64_t>(8, src_bytes - byte));
+      v[i + j] = static_cast<T>((word >> (bit & 7)) & mask);
+    }
+  } else {
+    for (; i < num_values; i++) {
+      GetValue(num_bits, &v[i]);
+    }
+    return num_values;
+  }
+
+  // Skip over the values unpacked above.
+  const int64_t new_position = position() + static_cast<int64_t>(n) * num_bits;
+  byte_offset_ = static_cast<int>(new_position / 8);
+  bit_offset_ = static_cast<int>(new_position % 8);
+  BufferValues();
+  return num_values;
+}
+
 inline void BitReader::Rewind(int num_bits) {
   bit_offset_ -= num_bits;
   if (bit_offset_ >= 0) {
@@ -0,0 +1,129 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include "kudu/util/bit-unpack.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "kudu/gutil/cpu.h"
+#include "kudu/gutil/port.h"
+
+namespace kudu {
+
+namespace {
+
+// Spreads the 8 bits of 'bits' into the 8 bytes of the result: the byte 'i'
+// of the result is the bit 'i' of 'bits'.
+inline uint64_t SpreadBitsScalar(uint8_t bits) {
+  const uint64_t spread = (bits * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+  // Set the top bit of each non-zero byte, without carrying across bytes.
+  return (((spread + 0x7f7f7f7f7f7f7f7fULL) | spread) & 0x8080808080808080ULL) >> 7;
+}
+
+// Unpacks the values of the whole bytes of 'in', a byte at
+// a time, returning the number of values unpacked.
+int UnpackBits1Scalar(const uint8_t* __restrict__ in, int num_values,
+                      uint8_t* __restrict__ out) {
+  const int num_bytes = num_values / 8;
+  for (int i = 0; i < num_bytes; i++) {
+    const uint64_t spread = SpreadBitsScalar(in[i]);
+    memcpy(out + i * 8, &spread, sizeof(spread));
+  }
+  return num_bytes * 8;
+}
+
+#if defined(__x86_64__)
+// As above, but using the 'pdep' instruction to spread the bits.
+__attribute__((target("bmi2")))
+int UnpackBits1Bmi2(const uint8_t* __restrict__ in, int num_values,
+                    uint8_t* __restrict__ out) {
+  const int num_words = num_values / 64;
+  for (int i = 0; i < num_words; i++) {
+    uint64_t word;
+    memcpy(&word, in + i * 8, sizeof(word));
+    for (int j = 0; j < 8; j++) {
+      const uint64_t spread = _pdep_u64(word >> (j * 8), 0x0101010101010101ULL);
+      memcpy(out + i * 64 + j * 8, &spread, sizeof(spread));
+    }
+  }
+  return num_words * 64 + UnpackBits1Scalar(in + num_words * 8, num_values - num_words * 64,
+                                            out + num_words * 64);
+}
+
+// As above, but unpacking 32 values at a time: each byte of the output vector
+// is set from its own bit of the 32 bits broadcast to the vector.
+__attribute__((target("avx2")))
+int UnpackBits1Avx2(const uint8_t* __restrict__ in, int num_values,
+                    uint8_t* __restrict__ out) {
+  // Moves the byte 'i' of the 32 bits into the bytes 8*i to 8*i+7 of the vector.
+  // The shuffle works within each 128-bit lane, and both hold the 32 bits.
+  const __m256i shuffle = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0,
+                                           1, 1, 1, 1, 1, 1, 1, 1,
+                                           2, 2, 2, 2, 2, 2, 2, 2,
+                                           3, 3, 3, 3, 3, 3, 3, 3);
+  const __m256i bit_mask = _mm256_set1_epi64x(0x8040201008040201LL);
+  const __m256i ones = _mm256_set1_epi8(1);
+  const int num_words = num_values / 32;
+  for (int i = 0; i < num_words; i++) {
+    int32_t word;
+    memcpy(&word, in + i * 4, sizeof(word));
+    __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(word), shuffle);
+    v = _mm256_cmpeq_epi8(_mm256_and_si256(v, bit_mask), bit_mask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 32),
+                        _mm256_and_si256(v, ones));
+  }
+  return num_words * 32 + UnpackBits1Scalar(in + num_words * 4, num_values - num_words * 32,
+                                            out + num_words * 32);
+}
+#endif // __x86_64__
+
+using UnpackBits1Func = int (*)(const uint8_t* __restrict__, int, uint8_t* __restrict__);
+
+UnpackBits1Func ChooseUnpackBits1() {
+#if defined(__x86_64__)
+  base::CPU cpu;
+  if (cpu.has_avx2()) {
+    return &UnpackBits1Avx2;
+  }
+  // 'pdep' is very slow on the AMD CPUs which predate Zen 3: see
+  // GetAvailablePextMethods().
+  if (cpu.has_bmi2() && cpu.vendor_name() == "GenuineIntel") {
+    return &UnpackBits1Bmi2;
+  }
+#endif
+  return &UnpackBits1Scalar;
+}
+
+const UnpackBits1Func kUnpackBits1 = ChooseUnpackBits1();
+
+} // anonymous namespace
+
+void UnpackBits1(const uint8_t* __restrict__ in, int num_values, uint8_t* __restrict__ out) {
+  const int unpacked = kUnpackBits1(in, num_values, out);
+  if (PREDICT_FALSE(unpacked < num_values)) {
+    // Unpack the remaining values from the last, partial byte.
+    const uint8_t bits = in[unpacked / 8];
+    for (int i = unpacked; i < num_values; i++) {
+      out[i] = (bits >> (i - unpacked)) & 1;
+    }
+  }
+}
+
+} // namespace kudu
@@ -0,0 +1,30 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+
+namespace kudu {
+
+// Unpacks the 'num_values' single-bit values packed into 'in', least
+// significant bit first as written by BitWriter, into 'out' as one 0 or 1 byte
+// per value. Reads exactly BitUtil::Ceil<3>(num_values) bytes of 'in'.
+//
+// Uses AVX2 or BMI2 instructions when the CPU supports them.
+void UnpackBits1(const uint8_t* __restrict__ in, int num_values, uint8_t* __restrict__ out);
+
+} // namespace kudu
@@ -57,6 +57,93 @@ METRIC_DEFINE_gauge_uint64(server, block_cache_usage, "Block Cache Memory Usage"
                            "Memory consumed by the block cache",
                            kudu::MetricLevel::kInfo);
 
+METRIC_DEFINE_counter(server, block_cache_index_inserts,
+                      "Block Cache Index Inserts", kudu::MetricUnit::kBlocks,
+                      "Number of index and bloom blocks inserted in the partition "
+                      "of the cache reserved for them",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_index_lookups,
+                      "Block Cache Index Lookups", kudu::MetricUnit::kBlocks,
+                      "Number of index and bloom blocks looked up from the partition "
+                      "of the cache reserved for them",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_index_evictions,
+                      "Block Cache Index Evictions", kudu::MetricUnit::kBlocks,
+                      "Number of index and bloom blocks evicted from the partition "
+                      "of the cache reserved for them",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_index_misses,
+                      "Block Cache Index Misses", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of index and bloom blocks that didn't yield a block",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_index_misses_caching,
+                      "Block Cache Index Misses (Caching)", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of index and bloom blocks that were expecting "
+                      "a block that didn't yield one",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_index_hits,
+                      "Block Cache Index Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of index and bloom blocks that found a block",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_index_hits_caching,
+                      "Block Cache Index Hits (Caching)", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of index and bloom blocks that were expecting "
+                      "a block that found one",
+                      kudu::MetricLevel::kDebug);
+
+METRIC_DEFINE_gauge_uint64(server, block_cache_index_usage,
+                           "Block Cache Index Memory Usage",
+                           kudu::MetricUnit::kBytes,
+                           "Memory consumed by the partition of the block cache "
+                           "reserved for index and bloom blocks",
+                           kudu::MetricLevel::kInfo);
+
+METRIC_DEFINE_counter(server, secondary_block_cache_inserts,
+                      "Secondary Block Cache Inserts", kudu::MetricUnit::kBlocks,
+                      "Number of blocks evicted from the block cache and written "
+                      "to the secondary block cache",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, secondary_block_cache_inserts_dropped,
+                      "Secondary Block Cache Dropped Inserts", kudu::MetricUnit::kBlocks,
+                      "Number of blocks evicted from the block cache which weren't "
+                      "written to the secondary block cache because too many blocks "
+                      "were already waiting to be written",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, secondary_block_cache_lookups,
+                      "Secondary Block Cache Lookups", kudu::MetricUnit::kBlocks,
+                      "Number of blocks looked up from the secondary block cache",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, secondary_block_cache_hits,
+                      "Secondary Block Cache Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups that found a block in the secondary block cache",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, secondary_block_cache_misses,
+                      "Secondary Block Cache Misses", kudu::MetricUnit::kBlocks,
+                      "Number of lookups that didn't yield a block from the secondary "
+                      "block cache",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, secondary_block_cache_evictions,
+                      "Secondary Block Cache Evictions", kudu::MetricUnit::kBlocks,
+                      "Number of blocks overwritten in the secondary block cache",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, secondary_block_cache_checksum_failures,
+                      "Secondary Block Cache Checksum Failures", kudu::MetricUnit::kBlocks,
+                      "Number of blocks read from the secondary block cache which "
+                      "failed verification, e.g. because they were overwritten while "
+                      "being read",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, secondary_block_cache_write_errors,
+                      "Secondary Block Cache Write Errors", kudu::MetricUnit::kBlocks,
+                      "Number of blocks which couldn't be written to the secondary "
+                      "block cache because of an I/O error",
+                      kudu::MetricLevel::kWarn);
+
+METRIC_DEFINE_gauge_uint64(server, secondary_block_cache_usage,
+                           "Secondary Block Cache Usage",
+                           kudu::MetricUnit::kBytes,
+                           "Size of the blocks in the secondary block cache",
+                           kudu::MetricLevel::kInfo);
+
 namespace kudu {
 
 #define MINIT(member, x) member = METRIC_##x.Instantiate(entity)
@@ -71,6 +158,30 @@ BlockCacheMetrics::BlockCacheMetrics(const scoped_refptr<MetricEntity>& entity)
   MINIT(cache_misses_caching, block_cache_misses_caching);
   GINIT(cache_usage, block_cache_usage);
 }
+
+IndexBlockCacheMetrics::IndexBlockCacheMetrics(const scoped_refptr<MetricEntity>& entity) {
+  MINIT(inserts, block_cache_index_inserts);
+  MINIT(lookups, block_cache_index_lookups);
+  MINIT(evictions, block_cache_index_evictions);
+  MINIT(cache_hits, block_cache_index_hits);
+  MINIT(cache_hits_caching, block_cache_index_hits_caching);
+  MINIT(cache_misses, block_cache_index_misses);
+  MINIT(cache_misses_caching, block_cache_index_misses_caching);
+  GINIT(cache_usage, block_cache_index_usage);
+}
+
+SecondaryBlockCacheMetrics::SecondaryBlockCacheMetrics(
+    const scoped_refptr<MetricEntity>& entity) {
+  MINIT(inserts, secondary_block_cache_inserts);
+  MINIT(inserts_dropped, secondary_block_cache_inserts_dropped);
+  MINIT(lookups, secondary_block_cache_lookups);
+  MINIT(hits, secondary_block_cache_hits);
+  MINIT(misses, secondary_block_cache_misses);
+  MINIT(evictions, secondary_block_cache_evictions);
+  MINIT(checksum_failures, secondary_block_cache_checksum_failures);
+  MINIT(write_errors, secondary_block_cache_write_errors);
+  GINIT(usage, secondary_block_cache_usage);
+}
 #undef MINIT
 #undef GINIT
 
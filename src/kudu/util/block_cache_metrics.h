@@ -17,8 +17,11 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/cache_metrics.h"
+#include "kudu/util/metrics.h"
 
 namespace kudu {
 
@@ -28,4 +31,27 @@ struct BlockCacheMetrics : public CacheMetrics {
   explicit BlockCacheMetrics(const scoped_refptr<MetricEntity>& entity);
 };
 
+// Metrics of the partition of the block cache reserved for index and bloom
+// blocks. See --block_cache_index_capacity_pct.
+struct IndexBlockCacheMetrics : public CacheMetrics {
+  explicit IndexBlockCacheMetrics(const scoped_refptr<MetricEntity>& entity);
+};
+
+// Metrics of the victim cache of the block cache. See
+// cfile::SecondaryBlockCache.
+struct SecondaryBlockCacheMetrics {
+  explicit SecondaryBlockCacheMetrics(const scoped_refptr<MetricEntity>& entity);
+
+  scoped_refptr<Counter> inserts;
+  scoped_refptr<Counter> inserts_dropped;
+  scoped_refptr<Counter> lookups;
+  scoped_refptr<Counter> hits;
+  scoped_refptr<Counter> misses;
+  scoped_refptr<Counter> evictions;
+  scoped_refptr<Counter> checksum_failures;
+  scoped_refptr<Counter> write_errors;
+
+  scoped_refptr<AtomicGauge<uint64_t>> usage;
+};
+
 } // namespace kudu
@@ -81,18 +81,27 @@ struct BenchSetup {
 
   Cache::EvictionPolicy eviction_policy;
 
+  // The number of threads to access the cache concurrently, or 0 to use
+  // --num_threads.
+  int num_threads = 0;
+
+  int threads() const {
+    return num_threads > 0 ? num_threads : FLAGS_num_threads;
+  }
+
   string ToString() const {
     string ret;
     switch (pattern) {
       case Pattern::ZIPFIAN: ret += "ZIPFIAN"; break;
       case Pattern::UNIFORM: ret += "UNIFORM"; break;
     }
-    if (eviction_policy == Cache::EvictionPolicy::SLRU) {
-      ret += " SLRU";
-    } else {
-      ret += " LRU";
+    switch (eviction_policy) {
+      case Cache::EvictionPolicy::SLRU: ret += " SLRU"; break;
+      case Cache::EvictionPolicy::CLOCK: ret += " CLOCK"; break;
+      default: ret += " LRU"; break;
     }
-    ret += StringPrintf(" ratio=%.2fx n_unique=%d", dataset_cache_ratio, max_key());
+    ret += StringPrintf(" ratio=%.2fx n_unique=%d threads=%d",
+                        dataset_cache_ratio, max_key(), threads());
     return ret;
   }
 
@@ -116,6 +125,9 @@ class CacheBench : public KuduTest,
     if (setup.eviction_policy == Cache::EvictionPolicy::SLRU) {
       cache_.reset(NewSLRUCache(kProbationarySegmentCapacity, kProtectedSegmentCapacity,
                                 "test-cache", kLookups));
+    } else if (setup.eviction_policy == Cache::EvictionPolicy::CLOCK) {
+      cache_.reset(NewCache<Cache::EvictionPolicy::CLOCK, Cache::MemoryType::DRAM>(
+          kCacheCapacity, "test-cache"));
     } else {
       cache_.reset(NewCache(kCacheCapacity, "test-cache"));
     }
@@ -187,7 +199,14 @@ INSTANTIATE_TEST_SUITE_P(Patterns, CacheBench, testing::ValuesIn(std::vector<Ben
       {BenchSetup::Pattern::UNIFORM, 1.0, Cache::EvictionPolicy::LRU},
       {BenchSetup::Pattern::UNIFORM, 1.0, Cache::EvictionPolicy::SLRU},
       {BenchSetup::Pattern::UNIFORM, 3.0, Cache::EvictionPolicy::LRU},
-      {BenchSetup::Pattern::UNIFORM, 3.0, Cache::EvictionPolicy::SLRU}
+      {BenchSetup::Pattern::UNIFORM, 3.0, Cache::EvictionPolicy::SLRU},
+      // Mostly hits from many threads: the contention on the shard locks
+      // dominates.
+      {BenchSetup::Pattern::ZIPFIAN, 1.0, Cache::EvictionPolicy::LRU, 64},
+      {BenchSetup::Pattern::ZIPFIAN, 1.0, Cache::EvictionPolicy::CLOCK, 64},
+      {BenchSetup::Pattern::ZIPFIAN, 1.0, Cache::EvictionPolicy::LRU, 128},
+      {BenchSetup::Pattern::ZIPFIAN, 1.0, Cache::EvictionPolicy::CLOCK, 128},
+      {BenchSetup::Pattern::ZIPFIAN, 3.0, Cache::EvictionPolicy::CLOCK}
     }));
 
 TEST_P(CacheBench, RunBench) {
@@ -197,10 +216,10 @@ TEST_P(CacheBench, RunBench) {
   // dataset is smaller than the cache capacity, we would count a bunch of misses
   // during the warm-up phase.
   LOG(INFO) << "Warming up...";
-  RunQueryThreads(FLAGS_num_threads, 1);
+  RunQueryThreads(setup.threads(), 1);
 
   LOG(INFO) << "Running benchmark...";
-  pair<int64_t, int64_t> hits_lookups = RunQueryThreads(FLAGS_num_threads, FLAGS_run_seconds);
+  pair<int64_t, int64_t> hits_lookups = RunQueryThreads(setup.threads(), FLAGS_run_seconds);
   int64_t hits = hits_lookups.first;
   int64_t lookups = hits_lookups.second;
 
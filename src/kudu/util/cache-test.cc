@@ -146,6 +146,24 @@ class CacheBaseTest : public KuduTest,
         }
         MemTracker::FindTracker("cache_test-sharded_lru_cache", &mem_tracker_);
         break;
+      case Cache::EvictionPolicy::TINYLFU:
+        if (mem_type != Cache::MemoryType::DRAM) {
+          FAIL() << "TinyLFU cache can only be of DRAM type";
+        }
+        cache_.reset(NewCache<Cache::EvictionPolicy::TINYLFU,
+                              Cache::MemoryType::DRAM>(cache_size(),
+                                                       "cache_test"));
+        MemTracker::FindTracker("cache_test-sharded_tinylfu_cache", &mem_tracker_);
+        break;
+      case Cache::EvictionPolicy::CLOCK:
+        if (mem_type != Cache::MemoryType::DRAM) {
+          FAIL() << "CLOCK cache can only be of DRAM type";
+        }
+        cache_.reset(NewCache<Cache::EvictionPolicy::CLOCK,
+                              Cache::MemoryType::DRAM>(cache_size(),
+                                                       "cache_test"));
+        MemTracker::FindTracker("cache_test-sharded_clock_cache", &mem_tracker_);
+        break;
       default:
         FAIL() << "unrecognized cache eviction policy";
         break;
@@ -208,6 +226,18 @@ INSTANTIATE_TEST_SUITE_P(
         make_tuple(Cache::MemoryType::DRAM,
                    Cache::EvictionPolicy::LRU,
                    ShardingPolicy::SingleShard),
+        make_tuple(Cache::MemoryType::DRAM,
+                   Cache::EvictionPolicy::TINYLFU,
+                   ShardingPolicy::MultiShard),
+        make_tuple(Cache::MemoryType::DRAM,
+                   Cache::EvictionPolicy::TINYLFU,
+                   ShardingPolicy::SingleShard),
+        make_tuple(Cache::MemoryType::DRAM,
+                   Cache::EvictionPolicy::CLOCK,
+                   ShardingPolicy::MultiShard),
+        make_tuple(Cache::MemoryType::DRAM,
+                   Cache::EvictionPolicy::CLOCK,
+                   ShardingPolicy::SingleShard),
         make_tuple(Cache::MemoryType::NVM,
                    Cache::EvictionPolicy::LRU,
                    ShardingPolicy::MultiShard),
@@ -533,4 +563,118 @@ TEST_P(LRUCacheTest, EvictionPolicy) {
   ASSERT_EQ(-1, Lookup(200));
 }
 
+// This class is dedicated for scenarios specific for the TinyLFU cache.
+// The scenarios use a single-shard cache for simpler logic.
+class TinyLFUCacheTest : public CacheBaseTest {
+ public:
+  TinyLFUCacheTest()
+      : CacheBaseTest(16 * 1024 * 1024) {
+  }
+
+  void SetUp() override {
+    SetupWithParameters(Cache::MemoryType::DRAM,
+                        Cache::EvictionPolicy::TINYLFU,
+                        ShardingPolicy::SingleShard);
+  }
+
+  // Looks up the entry, inserting it on a miss as the block cache does.
+  void LookupOrInsert(int key, int charge) {
+    if (Lookup(key) == -1) {
+      Insert(key, key, charge);
+    }
+  }
+};
+
+// A scan of entries which are looked up only once doesn't evict the entries
+// which are looked up repeatedly, unlike with the LRU policy.
+TEST_F(TinyLFUCacheTest, ScanResistance) {
+  static constexpr int kNumElems = 1000;
+  static constexpr int kNumHot = kNumElems / 2;
+  const int size_per_elem = cache_size() / kNumElems;
+
+  for (int i = 0; i < 3; i++) {
+    for (int key = 0; key < kNumHot; key++) {
+      LookupOrInsert(key, size_per_elem);
+    }
+  }
+  ASSERT_TRUE(evicted_keys_.empty());
+
+  // Scan through several times the capacity of the cache, while touching
+  // the hot entries less often than an LRU cache would need to retain them.
+  int hot_key = 0;
+  for (int key = kNumElems; key < 5 * kNumElems; key++) {
+    LookupOrInsert(key, size_per_elem);
+    if (key % 2 == 0) {
+      LookupOrInsert(hot_key, size_per_elem);
+      hot_key = (hot_key + 1) % kNumHot;
+    }
+  }
+  // Only the entries of the scan were evicted.
+  for (int key : evicted_keys_) {
+    ASSERT_GE(key, kNumElems);
+  }
+  for (int key = 0; key < kNumHot; key++) {
+    ASSERT_EQ(key, Lookup(key));
+  }
+}
+
+// Lookups which don't intend to cache don't make entries more likely to be
+// admitted.
+TEST_F(TinyLFUCacheTest, NonCachingLookupsDoNotCount) {
+  static constexpr int kNumElems = 100;
+  const int size_per_elem = cache_size() / kNumElems;
+  for (int i = 0; i < 3; i++) {
+    for (int key = 0; key < kNumElems; key++) {
+      LookupOrInsert(key, size_per_elem);
+    }
+  }
+  // Entry 1000 is looked up many times, but without the intent to cache it.
+  for (int i = 0; i < 10; i++) {
+    ASSERT_FALSE(cache_->Lookup(EncodeInt(1000), Cache::NO_EXPECT_IN_CACHE));
+  }
+  Insert(1000, 1000, size_per_elem);
+  // Make it leave the window.
+  Insert(1001, 1001, size_per_elem);
+  ASSERT_EQ(-1, Lookup(1000));
+}
+
+// This class is dedicated for scenarios specific for the CLOCK cache.
+// The scenarios use a single-shard cache for simpler logic.
+class ClockCacheTest : public CacheBaseTest {
+ public:
+  ClockCacheTest()
+      : CacheBaseTest(16 * 1024 * 1024) {
+  }
+
+  void SetUp() override {
+    SetupWithParameters(Cache::MemoryType::DRAM,
+                        Cache::EvictionPolicy::CLOCK,
+                        ShardingPolicy::SingleShard);
+  }
+};
+
+// An entry which was looked up since it was last passed by the clock hand
+// gets a second chance, and the next unreferenced entry is evicted instead.
+TEST_F(ClockCacheTest, SecondChance) {
+  static constexpr int kNumElems = 1000;
+  const int size_per_elem = cache_size() / kNumElems;
+  for (int key = 0; key < kNumElems; key++) {
+    Insert(key, key, size_per_elem);
+  }
+  ASSERT_TRUE(evicted_keys_.empty());
+
+  // Entry 0 is the oldest one.
+  ASSERT_EQ(0, Lookup(0));
+  Insert(kNumElems, kNumElems, size_per_elem);
+  ASSERT_EQ(0, Lookup(0));
+  ASSERT_EQ(-1, Lookup(1));
+  ASSERT_EQ(2, Lookup(2));
+
+  // Entry 0 lost its reference bit when it was passed over, and the hand
+  // moved on: entry 3 is evicted next, since entry 2 was just looked up.
+  Insert(kNumElems + 1, kNumElems + 1, size_per_elem);
+  ASSERT_EQ(-1, Lookup(3));
+  ASSERT_EQ(2, Lookup(2));
+}
+
 }  // namespace kudu
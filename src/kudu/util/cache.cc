@@ -4,13 +4,16 @@
 
 #include "kudu/util/cache.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <memory>
 #include <mutex>
 #include <ostream>
+#include <shared_mutex>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -47,6 +50,7 @@ TAG_FLAG(cache_memtracker_approximation_ratio, hidden);
 
 using RLHandle = kudu::Cache::RLHandle;
 using std::atomic;
+using std::shared_lock;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -77,6 +81,10 @@ string ToString(Cache::EvictionPolicy p) {
       return "lru";
     case Cache::EvictionPolicy::SLRU:
       return "slru";
+    case Cache::EvictionPolicy::TINYLFU:
+      return "tinylfu";
+    case Cache::EvictionPolicy::CLOCK:
+      return "clock";
     default:
       LOG(FATAL) << "unexpected cache eviction policy: " << static_cast<int>(p);
       break;
@@ -84,6 +92,81 @@ string ToString(Cache::EvictionPolicy p) {
   return "unknown";
 }
 
+// A count-min sketch estimating how often keys were looked up, used by the
+// TINYLFU policy. The counters saturate at 15, and the caller is expected to
+// age them periodically so that the estimates favor recent accesses. See
+// "TinyLFU: A Highly Efficient Cache Admission Policy" by G. Einziger,
+// R. Friedman and B. Manes.
+//
+// This class is not thread-safe.
+class FrequencySketch {
+ public:
+  // Creates a sketch with 'width' counters per row, rounded up to a power of 2.
+  explicit FrequencySketch(size_t width)
+      : width_(1ULL << Bits::Log2Ceiling64(std::max<size_t>(16, width))),
+        counters_(kDepth * width_, 0),
+        additions_(0) {
+  }
+
+  void Increment(uint32_t hash) {
+    bool incremented = false;
+    for (int row = 0; row < kDepth; row++) {
+      uint8_t* c = &counters_[Index(hash, row)];
+      if (*c < kMaxCount) {
+        ++*c;
+        incremented = true;
+      }
+    }
+    if (incremented) {
+      additions_++;
+    }
+  }
+
+  int Frequency(uint32_t hash) const {
+    int freq = kMaxCount;
+    for (int row = 0; row < kDepth; row++) {
+      freq = std::min<int>(freq, counters_[Index(hash, row)]);
+    }
+    return freq;
+  }
+
+  // Halves all the counters.
+  void Age() {
+    for (auto& c : counters_) {
+      c >>= 1;
+    }
+    additions_ = 0;
+  }
+
+  // The number of increments since the counters were last aged.
+  size_t additions() const {
+    return additions_;
+  }
+
+ private:
+  static constexpr int kDepth = 4;
+  static constexpr uint8_t kMaxCount = 15;
+
+  size_t Index(uint32_t hash, int row) const {
+    static constexpr uint64_t kSeeds[kDepth] = {
+      0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+      0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL,
+    };
+    // Each row hashes with a different multiplier so that keys colliding in
+    // one row are unlikely to collide in the others.
+    uint64_t h = static_cast<uint64_t>(hash) * kSeeds[row];
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    return row * width_ + ((h >> 32) & (width_ - 1));
+  }
+
+  const size_t width_;
+  vector<uint8_t> counters_;
+  size_t additions_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrequencySketch);
+};
+
 // A single shard of sharded cache.
 template<Cache::EvictionPolicy policy>
 class CacheShard {
@@ -95,6 +178,10 @@ class CacheShard {
   void SetCapacity(size_t capacity) {
     capacity_ = capacity;
     max_deferred_consumption_ = capacity * FLAGS_cache_memtracker_approximation_ratio;
+    if (policy == Cache::EvictionPolicy::TINYLFU) {
+      window_capacity_ = capacity * kWindowFraction;
+      sketch_.reset(new FrequencySketch(capacity / kSketchBytesPerCounter));
+    }
   }
 
   void SetMetrics(CacheMetrics* metrics) { metrics_ = metrics; }
@@ -107,10 +194,31 @@ class CacheShard {
   size_t Invalidate(const Cache::InvalidationControl& ctl);
 
  private:
+  // The fraction of the capacity of a TINYLFU shard used by its window.
+  static constexpr double kWindowFraction = 0.01;
+
+  // The number of bytes of capacity of a TINYLFU shard per counter in each
+  // row of its frequency sketch.
+  static constexpr size_t kSketchBytesPerCounter = 4096;
+
+  // The frequency sketch of a TINYLFU shard is aged after this many lookups
+  // per entry.
+  static constexpr size_t kSketchSamplesPerEntry = 10;
+
   void RL_Remove(RLHandle* e);
   void RL_Append(RLHandle* e);
+  // Add a newly inserted entry to the recency list.
+  void RL_Insert(RLHandle* e);
   // Update the recency list after a lookup operation.
   void RL_UpdateAfterLookup(RLHandle* e);
+  // Record a lookup of the entry with the given hash, whether it hit or not.
+  void RecordLookup(uint32_t hash);
+  // Remove entries from the recency list until the usage is within the
+  // capacity, prepending those with no references left to '*to_remove_head'.
+  void EvictUnlocked(RLHandle** to_remove_head);
+  // Remove the entry from the recency list and the table, prepending it to
+  // '*to_remove_head' if it has no references left.
+  void EvictEntryUnlocked(RLHandle* e, RLHandle** to_remove_head);
   // Just reduce the reference count by 1.
   // Return true if last reference
   bool Unref(RLHandle* e);
@@ -144,8 +252,10 @@ class CacheShard {
   // Initialized before use.
   size_t capacity_;
 
-  // mutex_ protects the following state.
-  simple_spinlock mutex_;
+  // mutex_ protects the following state. The lookups of a CLOCK shard only
+  // take it in shared mode.
+  typename std::conditional<policy == Cache::EvictionPolicy::CLOCK,
+                            rw_spinlock, simple_spinlock>::type mutex_;
   size_t usage_;
 
   // Dummy head of recency list.
@@ -154,6 +264,15 @@ class CacheShard {
 
   Cache::HandleTable<RLHandle> table_;
 
+  // Used by the TINYLFU policy only: the dummy head of the window's recency
+  // list, whose entries are also accounted in 'usage_', and the estimates of
+  // the frequency of the lookups.
+  RLHandle window_;
+  size_t window_capacity_;
+  size_t window_usage_;
+  size_t num_entries_;
+  unique_ptr<FrequencySketch> sketch_;
+
   MemTracker* mem_tracker_;
   atomic<int64_t> deferred_consumption_ { 0 };
 
@@ -167,23 +286,30 @@ class CacheShard {
 template<Cache::EvictionPolicy policy>
 CacheShard<policy>::CacheShard(MemTracker* tracker)
     : usage_(0),
+      window_capacity_(0),
+      window_usage_(0),
+      num_entries_(0),
       mem_tracker_(tracker),
       metrics_(nullptr) {
-  // Make empty circular linked list.
+  // Make empty circular linked lists.
   rl_.next = &rl_;
   rl_.prev = &rl_;
+  window_.next = &window_;
+  window_.prev = &window_;
 }
 
 template<Cache::EvictionPolicy policy>
 CacheShard<policy>::~CacheShard() {
-  for (RLHandle* e = rl_.next; e != &rl_; ) {
-    RLHandle* next = e->next;
-    DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 1)
-        << "caller has an unreleased handle";
-    if (Unref(e)) {
-      FreeEntry(e);
+  for (RLHandle* head : { &rl_, &window_ }) {
+    for (RLHandle* e = head->next; e != head; ) {
+      RLHandle* next = e->next;
+      DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 1)
+          << "caller has an unreleased handle";
+      if (Unref(e)) {
+        FreeEntry(e);
+      }
+      e = next;
     }
-    e = next;
   }
   mem_tracker_->Consume(deferred_consumption_);
 }
@@ -246,6 +372,12 @@ void CacheShard<policy>::RL_Remove(RLHandle* e) {
   e->prev->next = e->next;
   DCHECK_GE(usage_, e->charge);
   usage_ -= e->charge;
+  num_entries_--;
+  if (e->in_window) {
+    DCHECK_GE(window_usage_, e->charge);
+    window_usage_ -= e->charge;
+    e->in_window = false;
+  }
 }
 
 template<Cache::EvictionPolicy policy>
@@ -256,6 +388,25 @@ void CacheShard<policy>::RL_Append(RLHandle* e) {
   e->prev->next = e;
   e->next->prev = e;
   usage_ += e->charge;
+  num_entries_++;
+}
+
+template<Cache::EvictionPolicy policy>
+void CacheShard<policy>::RL_Insert(RLHandle* e) {
+  RL_Append(e);
+}
+
+template<>
+void CacheShard<Cache::EvictionPolicy::TINYLFU>::RL_Insert(RLHandle* e) {
+  // Make "e" the newest entry of the window.
+  e->next = &window_;
+  e->prev = window_.prev;
+  e->prev->next = e;
+  e->next->prev = e;
+  e->in_window = true;
+  usage_ += e->charge;
+  window_usage_ += e->charge;
+  num_entries_++;
 }
 
 template<>
@@ -268,6 +419,90 @@ void CacheShard<Cache::EvictionPolicy::LRU>::RL_UpdateAfterLookup(RLHandle* e) {
   RL_Append(e);
 }
 
+template<>
+void CacheShard<Cache::EvictionPolicy::TINYLFU>::RL_UpdateAfterLookup(RLHandle* e) {
+  // Entries stay in their list, as the newest entry.
+  if (e->in_window) {
+    RL_Remove(e);
+    RL_Insert(e);
+  } else {
+    RL_Remove(e);
+    RL_Append(e);
+  }
+}
+
+template<Cache::EvictionPolicy policy>
+void CacheShard<policy>::RecordLookup(uint32_t /* hash */) {
+}
+
+template<>
+void CacheShard<Cache::EvictionPolicy::TINYLFU>::RecordLookup(uint32_t hash) {
+  sketch_->Increment(hash);
+  // Aging in proportion to the number of entries lets a new working set
+  // replace the previous one.
+  if (sketch_->additions() >= kSketchSamplesPerEntry * std::max<size_t>(num_entries_, 16)) {
+    sketch_->Age();
+  }
+}
+
+template<Cache::EvictionPolicy policy>
+void CacheShard<policy>::EvictEntryUnlocked(RLHandle* e, RLHandle** to_remove_head) {
+  RL_Remove(e);
+  table_.Remove(e->key(), e->hash);
+  if (Unref(e)) {
+    e->next = *to_remove_head;
+    *to_remove_head = e;
+  }
+}
+
+template<Cache::EvictionPolicy policy>
+void CacheShard<policy>::EvictUnlocked(RLHandle** to_remove_head) {
+  while (usage_ > capacity_ && rl_.next != &rl_) {
+    EvictEntryUnlocked(rl_.next, to_remove_head);
+  }
+}
+
+template<>
+void CacheShard<Cache::EvictionPolicy::TINYLFU>::EvictUnlocked(RLHandle** to_remove_head) {
+  // The oldest entries of the window move to the main list if it has room.
+  // Otherwise, each competes with the oldest entry of the main list, and the
+  // one looked up less frequently is evicted.
+  while (window_usage_ > window_capacity_) {
+    RLHandle* candidate = window_.next;
+    RL_Remove(candidate);
+    RL_Append(candidate);
+    while (usage_ > capacity_) {
+      RLHandle* victim = rl_.next;
+      if (victim == candidate ||
+          sketch_->Frequency(candidate->hash) <= sketch_->Frequency(victim->hash)) {
+        EvictEntryUnlocked(candidate, to_remove_head);
+        break;
+      }
+      EvictEntryUnlocked(victim, to_remove_head);
+    }
+  }
+  // The window alone may exceed the capacity with very large entries.
+  while (usage_ > capacity_ && window_.next != &window_) {
+    EvictEntryUnlocked(window_.next, to_remove_head);
+  }
+}
+
+template<>
+void CacheShard<Cache::EvictionPolicy::CLOCK>::EvictUnlocked(RLHandle** to_remove_head) {
+  // rl_ is the clock, rl_.next is its hand. No lookup can mark an entry while
+  // the lock is held exclusively, so this stops after a full turn at most.
+  while (usage_ > capacity_ && rl_.next != &rl_) {
+    RLHandle* e = rl_.next;
+    if (e->referenced.load(std::memory_order_relaxed)) {
+      e->referenced.store(false, std::memory_order_relaxed);
+      RL_Remove(e);
+      RL_Append(e);
+      continue;
+    }
+    EvictEntryUnlocked(e, to_remove_head);
+  }
+}
+
 template<Cache::EvictionPolicy policy>
 Cache::Handle* CacheShard<policy>::Lookup(const Slice& key,
                                           uint32_t hash,
@@ -280,6 +515,36 @@ Cache::Handle* CacheShard<policy>::Lookup(const Slice& key,
       e->refs.fetch_add(1, std::memory_order_relaxed);
       RL_UpdateAfterLookup(e);
     }
+    // Lookups which don't intend to cache the entry, such as those of large
+    // scans, don't make it more likely to be admitted.
+    if (caching) {
+      RecordLookup(hash);
+    }
+  }
+
+  // Do the metrics outside the lock.
+  UpdateMetricsLookup(e != nullptr, caching);
+
+  return reinterpret_cast<Cache::Handle*>(e);
+}
+
+template<>
+Cache::Handle* CacheShard<Cache::EvictionPolicy::CLOCK>::Lookup(const Slice& key,
+                                                               uint32_t hash,
+                                                               bool caching) {
+  RLHandle* e;
+  {
+    // The table is only read, and the entry only marked: other lookups may
+    // proceed concurrently.
+    shared_lock<decltype(mutex_)> l(mutex_);
+    e = table_.Lookup(key, hash);
+    if (e != nullptr) {
+      e->refs.fetch_add(1, std::memory_order_relaxed);
+      // Avoid writing to the cache line of an entry which is already marked.
+      if (!e->referenced.load(std::memory_order_relaxed)) {
+        e->referenced.store(true, std::memory_order_relaxed);
+      }
+    }
   }
 
   // Do the metrics outside the lock.
@@ -315,7 +580,7 @@ Cache::Handle* CacheShard<policy>::Insert(
   {
     std::lock_guard<decltype(mutex_)> l(mutex_);
 
-    RL_Append(handle);
+    RL_Insert(handle);
 
     RLHandle* old = table_.Insert(handle);
     if (old != nullptr) {
@@ -326,15 +591,7 @@ Cache::Handle* CacheShard<policy>::Insert(
       }
     }
 
-    while (usage_ > capacity_ && rl_.next != &rl_) {
-      RLHandle* old = rl_.next;
-      RL_Remove(old);
-      table_.Remove(old->key(), old->hash);
-      if (Unref(old)) {
-        old->next = to_remove_head;
-        to_remove_head = old;
-      }
-    }
+    EvictUnlocked(&to_remove_head);
   }
 
   // We free the entries here outside the mutex for performance reasons.
@@ -376,27 +633,25 @@ size_t CacheShard<policy>::Invalidate(const Cache::InvalidationControl& ctl) {
     std::lock_guard<decltype(mutex_)> l(mutex_);
 
     // rl_.next is the oldest (a.k.a. least relevant) entry in the recency list.
-    RLHandle* h = rl_.next;
-    while (h != nullptr && h != &rl_ &&
-           ctl.iteration_func(valid_entry_count, invalid_entry_count)) {
-      if (ctl.validity_func(h->key(), h->value())) {
-        // Continue iterating over the list.
+    // The entries of the window (TINYLFU only) are more recent than those.
+    for (RLHandle* head : { &rl_, &window_ }) {
+      RLHandle* h = head->next;
+      while (h != nullptr && h != head &&
+             ctl.iteration_func(valid_entry_count, invalid_entry_count)) {
+        if (ctl.validity_func(h->key(), h->value())) {
+          // Continue iterating over the list.
+          h = h->next;
+          ++valid_entry_count;
+          continue;
+        }
+        // Copy the handle slated for removal.
+        RLHandle* h_to_remove = h;
+        // Prepare for next iteration of the cycle.
         h = h->next;
-        ++valid_entry_count;
-        continue;
-      }
-      // Copy the handle slated for removal.
-      RLHandle* h_to_remove = h;
-      // Prepare for next iteration of the cycle.
-      h = h->next;
-
-      RL_Remove(h_to_remove);
-      table_.Remove(h_to_remove->key(), h_to_remove->hash);
-      if (Unref(h_to_remove)) {
-        h_to_remove->next = to_remove_head;
-        to_remove_head = h_to_remove;
+
+        EvictEntryUnlocked(h_to_remove, &to_remove_head);
+        ++invalid_entry_count;
       }
-      ++invalid_entry_count;
     }
   }
   // Once removed from the lookup table and the recency list, the entries
@@ -506,6 +761,8 @@ class ShardedCache : public Cache {
     handle->charge = (charge == kAutomaticCharge) ? kudu_malloc_usable_size(h.get())
                                                   : charge;
     handle->hash = HashSlice(key);
+    handle->in_window = false;
+    handle->referenced.store(false, std::memory_order_relaxed);
     memcpy(handle->kv_data, key.data(), key_len);
 
     return h;
@@ -572,6 +829,18 @@ Cache* NewCache<Cache::EvictionPolicy::LRU,
   return new ShardedCache<Cache::EvictionPolicy::LRU>(capacity, id);
 }
 
+template<>
+Cache* NewCache<Cache::EvictionPolicy::TINYLFU,
+                Cache::MemoryType::DRAM>(size_t capacity, const std::string& id) {
+  return new ShardedCache<Cache::EvictionPolicy::TINYLFU>(capacity, id);
+}
+
+template<>
+Cache* NewCache<Cache::EvictionPolicy::CLOCK,
+                Cache::MemoryType::DRAM>(size_t capacity, const std::string& id) {
+  return new ShardedCache<Cache::EvictionPolicy::CLOCK>(capacity, id);
+}
+
 std::ostream& operator<<(std::ostream& os, Cache::MemoryType mem_type) {
   switch (mem_type) {
     case Cache::MemoryType::DRAM:
@@ -56,6 +56,18 @@ class Cache {
 
     // Segmented version of LRU.
     SLRU,
+
+    // Window TinyLFU: new items enter a small LRU window, and the items leaving
+    // the window are only admitted to the main LRU list if they were looked up
+    // more frequently than the items they would evict. This keeps a working
+    // set from being evicted by a scan of items which are looked up only once.
+    TINYLFU,
+
+    // CLOCK (second chance): lookups only mark the items as referenced instead
+    // of reordering them, so that concurrent lookups don't exclude each other.
+    // The earliest added items are evicted, except for those referenced since
+    // the eviction last passed them, which are given another pass.
+    CLOCK,
   };
 
   // Callback interface which is called when an entry is evicted from the cache.
@@ -80,6 +92,8 @@ class Cache {
     uint32_t val_length;
     std::atomic<int32_t> refs;
     uint32_t hash;      // Hash of key(); used for fast sharding and comparisons
+    bool in_window;     // Whether the entry is in the window of a TINYLFU cache
+    std::atomic<bool> referenced;  // Whether a CLOCK cache's entry was looked up
 
     // The storage for the key/value pair itself. The data is stored as:
     //   [key bytes ...] [padding up to 8-byte boundary] [value bytes ...]
@@ -503,6 +517,19 @@ template<>
 Cache* NewCache<Cache::EvictionPolicy::LRU,
                 Cache::MemoryType::DRAM>(size_t capacity, const std::string& id);
 
+// Create a new W-TinyLFU cache with a fixed size capacity. This implementation
+// of Cache uses the least-recently-used eviction policy with frequency-based
+// admission and stored in DRAM.
+template<>
+Cache* NewCache<Cache::EvictionPolicy::TINYLFU,
+                Cache::MemoryType::DRAM>(size_t capacity, const std::string& id);
+
+// Create a new CLOCK cache with a fixed size capacity. This implementation
+// of Cache uses the second-chance eviction policy and stored in DRAM.
+template<>
+Cache* NewCache<Cache::EvictionPolicy::CLOCK,
+                Cache::MemoryType::DRAM>(size_t capacity, const std::string& id);
+
 // A helper method to output cache memory type into ostream.
 std::ostream& operator<<(std::ostream& os, Cache::MemoryType mem_type);
 
@@ -33,6 +33,7 @@
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
@@ -148,14 +149,52 @@ TEST_F(TestCompression, TestNoCompressionCodec) {
 }
 
 TEST_F(TestCompression, TestSnappyCompressionCodec) {
-  for (auto type : { SNAPPY, LZ4, ZLIB }) {
+  for (auto type : { SNAPPY, LZ4, ZLIB, ZSTD }) {
     NO_FATALS(TestCompressionCodec(type));
   }
 }
 
+TEST_F(TestCompression, TestZstdCompressionLevels) {
+  constexpr int kInputSize = 4096;
+  Random r(SeedRandom());
+  string input = RandomString(kInputSize / 4, &r);
+  while (input.size() < kInputSize) {
+    input += input;
+  }
+
+  const CompressionCodec* default_codec;
+  ASSERT_OK(GetCompressionCodec(ZSTD, &default_codec));
+  for (int level : { -5, 0, 1, 3, 19 }) {
+    SCOPED_TRACE(level);
+    const CompressionCodec* codec;
+    ASSERT_OK(GetCompressionCodec(ZSTD, level, &codec));
+    ASSERT_EQ(ZSTD, codec->type());
+    // The codecs are cached per level.
+    const CompressionCodec* same_codec;
+    ASSERT_OK(GetCompressionCodec(ZSTD, level, &same_codec));
+    ASSERT_EQ(codec, same_codec);
+
+    unique_ptr<uint8_t[]> cbuffer(new uint8_t[codec->MaxCompressedLength(input.size())]);
+    size_t compressed;
+    ASSERT_OK(codec->Compress(Slice(input), cbuffer.get(), &compressed));
+    ASSERT_LT(compressed, input.size());
+
+    // Any ZSTD codec can uncompress the data regardless of the level.
+    unique_ptr<uint8_t[]> ubuffer(new uint8_t[input.size()]);
+    ASSERT_OK(default_codec->Uncompress(Slice(cbuffer.get(), compressed),
+                                        ubuffer.get(), input.size()));
+    ASSERT_EQ(0, memcmp(input.data(), ubuffer.get(), input.size()));
+  }
+
+  const CompressionCodec* codec;
+  Status s = GetCompressionCodec(ZSTD, 1000, &codec);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  ASSERT_EQ(ZSTD, GetCompressionCodecType("zstd"));
+}
+
 TEST_F(TestCompression, TestSimpleBenchmark) {
   Random r(SeedRandom());
-  for (auto type : { SNAPPY, LZ4, ZLIB }) {
+  for (auto type : { SNAPPY, LZ4, ZLIB, ZSTD }) {
     NO_FATALS(Benchmark(r, type));
   }
 }
@@ -17,8 +17,11 @@
 
 #include "kudu/util/compression/compression_codec.h"
 
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <glog/logging.h>
@@ -26,16 +29,22 @@
 #include <snappy-sinksource.h>
 #include <snappy.h>
 #include <zlib.h>
+#include <zstd.h>
 
 #include "kudu/gutil/singleton.h"
 #include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/string_case.h"
 
 namespace kudu {
 
+using std::unique_ptr;
+using std::unordered_map;
 using std::vector;
+using strings::Substitute;
 
 CompressionCodec::CompressionCodec() {
 }
@@ -243,7 +252,95 @@ class ZlibCodec : public CompressionCodec {
   }
 };
 
+class ZstdCodec : public CompressionCodec {
+ public:
+  // Returns the codec compressing at 'level', creating it if necessary.
+  // The codecs are never destroyed.
+  static Status GetForLevel(int level, const CompressionCodec** codec) {
+    if (level == 0) {
+      level = ZSTD_CLEVEL_DEFAULT;
+    }
+    if (level < ZSTD_minCLevel() || level > ZSTD_maxCLevel()) {
+      return Status::InvalidArgument(
+          Substitute("invalid ZSTD compression level $0: must be between $1 and $2",
+                     level, ZSTD_minCLevel(), ZSTD_maxCLevel()));
+    }
+    static simple_spinlock lock;
+    static auto* codecs = new unordered_map<int, unique_ptr<ZstdCodec>>();
+    std::lock_guard<simple_spinlock> l(lock);
+    auto& c = (*codecs)[level];
+    if (!c) {
+      c.reset(new ZstdCodec(level));
+    }
+    *codec = c.get();
+    return Status::OK();
+  }
+
+  Status Compress(const Slice& input,
+                  uint8_t *compressed, size_t *compressed_length) const override {
+    // Compression contexts are expensive to set up, so reuse one per thread.
+    static thread_local unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx(
+        ZSTD_createCCtx(), &ZSTD_freeCCtx);
+    size_t n = ZSTD_compressCCtx(cctx.get(),
+                                 compressed, MaxCompressedLength(input.size()),
+                                 input.data(), input.size(),
+                                 level_);
+    if (ZSTD_isError(n)) {
+      return Status::IOError("unable to compress the buffer", ZSTD_getErrorName(n));
+    }
+    *compressed_length = n;
+    return Status::OK();
+  }
+
+  Status Compress(const vector<Slice>& input_slices,
+                  uint8_t *compressed, size_t *compressed_length) const override {
+    if (input_slices.size() == 1) {
+      return Compress(input_slices[0], compressed, compressed_length);
+    }
+
+    SlicesSource source(input_slices);
+    faststring buffer;
+    source.Dump(&buffer);
+    return Compress(Slice(buffer.data(), buffer.size()), compressed, compressed_length);
+  }
+
+  Status Uncompress(const Slice& compressed,
+                    uint8_t *uncompressed, size_t uncompressed_length) const override {
+    static thread_local unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx(
+        ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    size_t n = ZSTD_decompressDCtx(dctx.get(),
+                                   uncompressed, uncompressed_length,
+                                   compressed.data(), compressed.size());
+    if (ZSTD_isError(n) || n != uncompressed_length) {
+      return Status::Corruption(
+          Substitute("unable to uncompress the buffer: $0",
+                     ZSTD_isError(n) ? ZSTD_getErrorName(n) : "unexpected length"),
+          KUDU_REDACT(compressed.ToDebugString(100)));
+    }
+    return Status::OK();
+  }
+
+  size_t MaxCompressedLength(size_t source_bytes) const override {
+    return ZSTD_compressBound(source_bytes);
+  }
+
+  CompressionType type() const override {
+    return ZSTD;
+  }
+
+ private:
+  explicit ZstdCodec(int level) : level_(level) {}
+
+  const int level_;
+};
+
+Status GetCompressionCodec(CompressionType compression,
+                           const CompressionCodec** codec) {
+  return GetCompressionCodec(compression, 0, codec);
+}
+
 Status GetCompressionCodec(CompressionType compression,
+                           int level,
                            const CompressionCodec** codec) {
   switch (compression) {
     case NO_COMPRESSION:
@@ -258,6 +355,8 @@ Status GetCompressionCodec(CompressionType compression,
     case ZLIB:
       *codec = ZlibCodec::GetSingleton();
       break;
+    case ZSTD:
+      return ZstdCodec::GetForLevel(level, codec);
     default:
       return Status::NotFound("bad compression type");
   }
@@ -274,6 +373,8 @@ CompressionType GetCompressionCodecType(const std::string& name) {
     return LZ4;
   if (uname == "ZLIB")
     return ZLIB;
+  if (uname == "ZSTD")
+    return ZSTD;
   if (uname == "NO_COMPRESSION")
     return NO_COMPRESSION;
 
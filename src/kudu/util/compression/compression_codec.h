@@ -70,6 +70,15 @@ class CompressionCodec {
 Status GetCompressionCodec(CompressionType compression,
                            const CompressionCodec** codec);
 
+// Same as above, but the returned codec compresses at the given level.
+// A level of 0 selects the codec's default level. Only ZSTD honors the
+// level at the moment: it's ignored by the other codecs.
+//
+// Returns InvalidArgument if the level is out of range for the codec.
+Status GetCompressionCodec(CompressionType compression,
+                           int level,
+                           const CompressionCodec** codec);
+
 // Returns the compression codec type given the name
 CompressionType GetCompressionCodecType(const std::string& name);
 
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <algorithm> // IWYU pragma: keep
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <ostream>
@@ -37,7 +39,7 @@ namespace kudu {
 template<class State>
 class CowObject {
  public:
-  CowObject() {}
+  CowObject() : version_(0) {}
   ~CowObject() {}
 
   // Lock an object for read.
@@ -91,9 +93,19 @@ class CowObject {
     lock_.UpgradeToCommitLock();
     std::swap(state_, *dirty_state_);
     dirty_state_.reset();
+    version_.fetch_add(1, std::memory_order_release);
     lock_.CommitUnlock();
   }
 
+  // Return the number of mutations committed so far.
+  //
+  // May be called without holding any lock, e.g. to check whether a copy of
+  // the state made under the read lock (along with the version at that time)
+  // is still current.
+  uint64_t version() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
   // Return the current state, not reflecting any in-progress mutations.
   State& state() {
     DCHECK(lock_.HasReaders() || lock_.HasWriteLock());
@@ -129,6 +141,9 @@ class CowObject {
   State state_;
   std::unique_ptr<State> dirty_state_;
 
+  // Incremented on every committed mutation, while holding the commit lock.
+  std::atomic<uint64_t> version_;
+
   DISALLOW_COPY_AND_ASSIGN(CowObject);
 };
 
@@ -0,0 +1,86 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/cpu_profiler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+#include "kudu/util/thread.h"
+
+using std::string;
+
+namespace kudu {
+
+class CpuProfilerTest : public KuduTest {};
+
+#if defined(__linux__)
+TEST_F(CpuProfilerTest, TestTaggedSamples) {
+  ASSERT_OK(StartContinuousCpuProfiling(1000));
+  ASSERT_TRUE(IsContinuousCpuProfilingEnabled());
+  Status s = StartContinuousCpuProfiling(1000);
+  ASSERT_TRUE(s.IsAlreadyPresent()) << s.ToString();
+
+  // Burn CPU in a tagged scope of a named thread.
+  std::atomic<bool> done(false);
+  scoped_refptr<Thread> thread;
+  ASSERT_OK(Thread::Create("test", "spinner", [&]() {
+    const string tag = "tablet-0123";
+    SCOPED_CPU_PROFILE_TAG(tag);
+    volatile uint64_t x = 0;
+    while (!done) {
+      x = x + 1;
+    }
+  }, &thread));
+  SleepFor(MonoDelta::FromMilliseconds(500));
+  done = true;
+  thread->Join();
+  StopContinuousCpuProfiling();
+  ASSERT_FALSE(IsContinuousCpuProfilingEnabled());
+
+  std::ostringstream out;
+  int64_t dropped = 0;
+  DumpContinuousCpuProfile(/*reset=*/true, &out, &dropped);
+  const string profile = out.str();
+  LOG(INFO) << profile;
+  ASSERT_STR_CONTAINS(profile, "spinner;tablet-0123;");
+  ASSERT_EQ(0, dropped);
+
+  // The samples were cleared.
+  std::ostringstream out2;
+  DumpContinuousCpuProfile(/*reset=*/false, &out2, &dropped);
+  ASSERT_EQ("", out2.str());
+}
+#endif
+
+TEST_F(CpuProfilerTest, TestInvalidFrequency) {
+  Status s = StartContinuousCpuProfiling(0);
+  ASSERT_FALSE(s.ok());
+  ASSERT_FALSE(IsContinuousCpuProfilingEnabled());
+}
+
+} // namespace kudu
@@ -0,0 +1,460 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/cpu_profiler.h"
+
+#include <signal.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/atomicops.h"
+#include "kudu/gutil/hash/city.h"
+#include "kudu/gutil/once.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/spinlock.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/atomic.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/debug-util.h"
+#include "kudu/util/errno.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/scoped_cleanup.h"
+#include "kudu/util/thread.h"
+
+// GLog already implements symbolization. Just import their hidden symbol.
+namespace google {
+bool Symbolize(void *pc, char *out, size_t out_size);
+}
+
+using base::SpinLock;
+using base::SpinLockHolder;
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+
+namespace {
+
+// The tag of the current thread, if any. See ScopedCpuProfileTag.
+__thread const char* tls_cpu_profile_tag = nullptr;
+
+// Copies the NUL-terminated 'src' into 'dst' of 'size' bytes, truncating it if
+// necessary. Returns the length of the copy.
+//
+// Async-safe.
+size_t CopyTruncated(const char* src, char* dst, size_t size) {
+  size_t len = 0;
+  if (src) {
+    while (len < size - 1 && src[len] != '\0') {
+      dst[len] = src[len];
+      len++;
+    }
+  }
+  dst[len] = '\0';
+  return len;
+}
+
+// A fixed-size linear-probing hashtable of the samples collected since it was
+// last drained, as for the lock contention profiles in spinlock_profiling.cc.
+//
+// The signal handler records a sample by claiming an entry, or incrementing
+// an entry with the same stack, thread name and tag. An entry it fails to
+// lock is skipped, so a sample can be spread over multiple entries, which
+// only get aggregated when drained.
+class SampleBuffer {
+ public:
+  enum {
+    kMaxThreadNameLength = 32,
+    kMaxTagLength = 64,
+  };
+
+  struct Sample {
+    StackTrace trace;
+    char thread[kMaxThreadNameLength];
+    char tag[kMaxTagLength];
+  };
+
+  SampleBuffer() : dropped_samples_(0) {}
+
+  // Record 'sample'.
+  //
+  // Async-safe.
+  void Add(const Sample& sample);
+
+  // Call 'f(sample, count)' for each of the samples recorded since the last
+  // call, and clear them. Returns the number of samples dropped since the last
+  // call.
+  template<class F>
+  int64_t Drain(const F& f);
+
+ private:
+  struct Entry {
+    // Protects all other fields.
+    SpinLock lock;
+
+    // The number of samples recorded into this entry. If this is 0, then the
+    // entry is "unclaimed" and the other fields are not considered valid.
+    int64_t count = 0;
+
+    // A cached hashcode of the sample.
+    uint64_t hash;
+
+    Sample sample;
+  };
+
+  static uint64_t HashSample(const Sample& sample) {
+    uint64_t hash = sample.trace.HashCode();
+    hash = util_hash::CityHash64WithSeed(sample.thread, strlen(sample.thread), hash);
+    return util_hash::CityHash64WithSeed(sample.tag, strlen(sample.tag), hash);
+  }
+
+  static bool Equals(const Sample& a, const Sample& b) {
+    return a.trace == b.trace &&
+        strcmp(a.thread, b.thread) == 0 &&
+        strcmp(a.tag, b.tag) == 0;
+  }
+
+  enum {
+    kNumEntries = 2048,
+    kNumLinearProbeAttempts = 4
+  };
+  Entry entries_[kNumEntries];
+
+  // The number of samples which were dropped due to contention on this
+  // structure or due to the hashtable being too full.
+  AtomicInt<int64_t> dropped_samples_;
+};
+
+void SampleBuffer::Add(const Sample& sample) {
+  const uint64_t hash = HashSample(sample);
+  for (int i = 0; i < kNumLinearProbeAttempts; i++) {
+    Entry& e = entries_[(hash + i) % kNumEntries];
+    if (!e.lock.TryLock()) {
+      // The entry is being drained, or the signal interrupted a thread
+      // recording into it: use another one.
+      continue;
+    }
+    if (e.count == 0) {
+      e.hash = hash;
+      e.sample.trace.CopyFrom(sample.trace);
+      memcpy(e.sample.thread, sample.thread, sizeof(sample.thread));
+      memcpy(e.sample.tag, sample.tag, sizeof(sample.tag));
+    } else if (e.hash != hash || !Equals(e.sample, sample)) {
+      e.lock.Unlock();
+      continue;
+    }
+    ++e.count;
+    e.lock.Unlock();
+    return;
+  }
+  dropped_samples_.Increment();
+}
+
+template<class F>
+int64_t SampleBuffer::Drain(const F& f) {
+  for (auto& e : entries_) {
+    Sample sample;
+    int64_t count;
+    {
+      SpinLockHolder l(&e.lock);
+      if (e.count == 0) continue;
+      count = e.count;
+      sample.trace.CopyFrom(e.sample.trace);
+      memcpy(sample.thread, e.sample.thread, sizeof(sample.thread));
+      memcpy(sample.tag, e.sample.tag, sizeof(sample.tag));
+      e.count = 0;
+    }
+    f(sample, count);
+  }
+  return dropped_samples_.Exchange(0);
+}
+
+// Replaces the characters with a special meaning in the collapsed stacks
+// format.
+string SanitizeFrame(string s) {
+  std::replace(s.begin(), s.end(), ';', ':');
+  std::replace(s.begin(), s.end(), '\n', ' ');
+  return s;
+}
+
+class ContinuousCpuProfiler {
+ public:
+  ContinuousCpuProfiler()
+      : enabled_(0),
+        stop_latch_(0),
+        dropped_samples_(0) {
+  }
+
+  Status Start(int frequency_hz);
+  void Stop();
+  bool enabled() const {
+    return base::subtle::Acquire_Load(&enabled_);
+  }
+  void Dump(bool reset, std::ostream* out, int64_t* dropped_samples);
+
+  // Record a sample of the current thread. Not inlined so that the frames to
+  // skip are known.
+  //
+  // Async-safe.
+  void RecordSample() ATTRIBUTE_NOINLINE;
+
+ private:
+  // Aggregate the samples of 'buffer_' into 'samples_'.
+  void Drain();
+
+  void DrainThread();
+
+  // The maximum number of distinct stacks to aggregate. Samples with other
+  // stacks are dropped.
+  static constexpr size_t kMaxDistinctStacks = 100000;
+
+  Atomic32 enabled_;
+  SampleBuffer buffer_;
+
+  // Protects the fields below, and serializes Start() and Stop().
+  Mutex start_stop_lock_;
+#if defined(__linux__)
+  timer_t timer_;
+#endif
+  scoped_refptr<Thread> drain_thread_;
+  CountDownLatch stop_latch_;
+
+  // Protects the fields below.
+  Mutex samples_lock_;
+
+  // The number of samples of each collapsed stack.
+  std::unordered_map<string, int64_t> samples_;
+
+  // The symbols of the program counters seen so far.
+  std::unordered_map<void*, string> symbols_;
+
+  int64_t dropped_samples_;
+};
+
+ContinuousCpuProfiler* g_profiler = nullptr;
+
+void DoInit() {
+  g_profiler = new ContinuousCpuProfiler();
+}
+
+ContinuousCpuProfiler* GetProfiler() {
+  static GoogleOnceType once = GOOGLE_ONCE_INIT;
+  GoogleOnceInit(&once, DoInit);
+  return g_profiler;
+}
+
+void HandleProfilingSignal(int /*signum*/, siginfo_t* /*info*/, void* /*ucontext*/) {
+  // Unwinding may clobber errno, which is visible to the interrupted code.
+  int saved_errno = errno;
+  SCOPED_CLEANUP({ errno = saved_errno; });
+
+  // The signal may be delivered after the profiler was stopped.
+  if (g_profiler && g_profiler->enabled()) {
+    g_profiler->RecordSample();
+  }
+}
+
+void ContinuousCpuProfiler::RecordSample() {
+  SampleBuffer::Sample sample;
+  // Skip this function, the signal handler and the signal trampoline.
+  sample.trace.Collect(/*skip_frames=*/3);
+  const Thread* thread = Thread::current_thread();
+  CopyTruncated(thread ? thread->name().c_str() : "(unknown thread)",
+                sample.thread, sizeof(sample.thread));
+  CopyTruncated(tls_cpu_profile_tag, sample.tag, sizeof(sample.tag));
+  buffer_.Add(sample);
+}
+
+Status ContinuousCpuProfiler::Start(int frequency_hz) {
+#if !defined(__linux__)
+  return Status::NotSupported("continuous CPU profiling is only supported on Linux");
+#else
+  if (frequency_hz <= 0 || frequency_hz > 1000) {
+    return Status::InvalidArgument(Substitute(
+        "invalid CPU profiling frequency $0: must be within 1 and 1000", frequency_hz));
+  }
+  std::lock_guard<Mutex> l(start_stop_lock_);
+  if (enabled()) {
+    return Status::AlreadyPresent("continuous CPU profiling is already enabled");
+  }
+
+  // SIGPROF is used by the gperftools CPU profiler: sample on the first
+  // real-time signal instead, if no one else uses it. The handler is never
+  // uninstalled, since signals may still be pending when stopping.
+  const int signum = SIGRTMIN;
+  struct sigaction old_act;
+  PCHECK(sigaction(signum, nullptr, &old_act) == 0);
+  if (old_act.sa_sigaction != &HandleProfilingSignal) {
+    if (old_act.sa_handler != SIG_DFL && old_act.sa_handler != SIG_IGN) {
+      return Status::IllegalState(Substitute(
+          "signal handler for CPU profiling signal $0 is already in use", signum));
+    }
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = &HandleProfilingSignal;
+    act.sa_flags = SA_SIGINFO | SA_RESTART;
+    PCHECK(sigaction(signum, &act, nullptr) == 0);
+  }
+
+  // The timer counts the CPU time of all the threads of the process and the
+  // kernel delivers its signal to a thread which is running, so that the
+  // samples are proportional to the CPU time consumed.
+  struct sigevent sev;
+  memset(&sev, 0, sizeof(sev));
+  sev.sigev_notify = SIGEV_SIGNAL;
+  sev.sigev_signo = signum;
+  if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &sev, &timer_) != 0) {
+    int err = errno;
+    return Status::IOError("timer_create() failed", ErrnoToString(err), err);
+  }
+
+  stop_latch_.Reset(1);
+  Status s = Thread::Create("cpu profiler", "cpu profile drainer",
+                            [this]() { this->DrainThread(); }, &drain_thread_);
+  if (!s.ok()) {
+    PCHECK(timer_delete(timer_) == 0);
+    return s;
+  }
+
+  base::subtle::Release_Store(&enabled_, 1);
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  spec.it_interval.tv_nsec = 1000000000L / frequency_hz;
+  spec.it_value = spec.it_interval;
+  PCHECK(timer_settime(timer_, 0, &spec, nullptr) == 0);
+  LOG(INFO) << Substitute("started continuous CPU profiling at $0Hz", frequency_hz);
+  return Status::OK();
+#endif
+}
+
+void ContinuousCpuProfiler::Stop() {
+#if defined(__linux__)
+  std::lock_guard<Mutex> l(start_stop_lock_);
+  if (!enabled()) {
+    return;
+  }
+  PCHECK(timer_delete(timer_) == 0);
+  base::subtle::Release_Store(&enabled_, 0);
+  stop_latch_.CountDown();
+  drain_thread_->Join();
+  drain_thread_.reset();
+  Drain();
+#endif
+}
+
+void ContinuousCpuProfiler::DrainThread() {
+  while (!stop_latch_.WaitFor(MonoDelta::FromSeconds(1))) {
+    Drain();
+  }
+}
+
+void ContinuousCpuProfiler::Drain() {
+  std::lock_guard<Mutex> l(samples_lock_);
+  dropped_samples_ += buffer_.Drain([&](const SampleBuffer::Sample& sample, int64_t count) {
+    string stack = SanitizeFrame(sample.thread);
+    if (sample.tag[0] != '\0') {
+      stack += ';';
+      stack += SanitizeFrame(sample.tag);
+    }
+    for (int i = sample.trace.num_frames() - 1; i >= 0; i--) {
+      void* pc = sample.trace.frame(i);
+      auto it = symbols_.find(pc);
+      if (it == symbols_.end()) {
+        // See StackTrace::Symbolize() about why we subtract 1 from the address.
+        char symbol[1024];
+        string frame;
+        if (pc && google::Symbolize(reinterpret_cast<char*>(pc) - 1, symbol, sizeof(symbol))) {
+          frame = SanitizeFrame(symbol);
+        } else {
+          frame = Substitute("$0", pc);
+        }
+        it = symbols_.emplace(pc, std::move(frame)).first;
+      }
+      stack += ';';
+      stack += it->second;
+    }
+    auto sample_it = samples_.find(stack);
+    if (sample_it != samples_.end()) {
+      sample_it->second += count;
+    } else if (samples_.size() < kMaxDistinctStacks) {
+      samples_.emplace(std::move(stack), count);
+    } else {
+      dropped_samples_ += count;
+    }
+  });
+}
+
+void ContinuousCpuProfiler::Dump(bool reset, std::ostream* out, int64_t* dropped_samples) {
+  Drain();
+  std::lock_guard<Mutex> l(samples_lock_);
+  // Sort the stacks so that the output is stable.
+  std::map<string, int64_t> sorted(samples_.begin(), samples_.end());
+  for (const auto& elem : sorted) {
+    *out << elem.first << " " << elem.second << "\n";
+  }
+  *dropped_samples = dropped_samples_;
+  if (reset) {
+    samples_.clear();
+    dropped_samples_ = 0;
+  }
+}
+
+} // anonymous namespace
+
+Status StartContinuousCpuProfiling(int frequency_hz) {
+  return GetProfiler()->Start(frequency_hz);
+}
+
+void StopContinuousCpuProfiling() {
+  GetProfiler()->Stop();
+}
+
+bool IsContinuousCpuProfilingEnabled() {
+  return GetProfiler()->enabled();
+}
+
+void DumpContinuousCpuProfile(bool reset, std::ostream* out, int64_t* dropped_samples) {
+  GetProfiler()->Dump(reset, out, dropped_samples);
+}
+
+ScopedCpuProfileTag::ScopedCpuProfileTag(const char* tag)
+    : prev_tag_(tls_cpu_profile_tag) {
+  tls_cpu_profile_tag = tag;
+  // Prevent the compiler from reordering the store with respect to the code
+  // the signal handler may interrupt.
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+ScopedCpuProfileTag::~ScopedCpuProfileTag() {
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  tls_cpu_profile_tag = prev_tag_;
+}
+
+} // namespace kudu
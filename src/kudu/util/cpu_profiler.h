@@ -0,0 +1,82 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+// Continuous, low-frequency CPU profiling of the whole process.
+//
+// While enabled, a timer counting the CPU time of the process fires a signal
+// 'frequency_hz' times per CPU-second, and the thread which consumed the CPU
+// records its stack, its name and its current tag (see ScopedCpuProfileTag)
+// into a fixed-size buffer. A background thread periodically symbolizes the
+// samples and aggregates them until they are dumped. Unlike the gperftools
+// CPU profiler behind /pprof/profile, which uses SIGPROF, this uses a
+// real-time signal, so both can run at the same time.
+//
+// Returns AlreadyPresent if profiling is already enabled, and NotSupported
+// on platforms other than Linux.
+Status StartContinuousCpuProfiling(int frequency_hz);
+
+// Stop sampling. The samples collected so far can still be dumped.
+void StopContinuousCpuProfiling();
+
+bool IsContinuousCpuProfilingEnabled();
+
+// Write the samples aggregated so far to 'out' in the "collapsed stacks"
+// format consumed by flame graph tools, one line per distinct stack:
+//
+//   <thread name>;[<tag>;]<outermost frame>;...;<innermost frame> <count>
+//
+// Only the innermost 16 frames of each stack are collected. If 'reset' is
+// true, the aggregated samples are cleared. '*dropped_samples' is set to the
+// number of samples which were dropped since the last reset, because the
+// buffer was full or contended.
+void DumpContinuousCpuProfile(bool reset, std::ostream* out, int64_t* dropped_samples);
+
+// Tags the CPU profile samples of the current thread with 'tag' for the
+// lifetime of this object, e.g. with the identifier of the tablet the thread
+// works on. Tags don't nest: an inner tag replaces the outer one until it
+// goes out of scope.
+//
+// 'tag' isn't copied, and must outlive this object. Setting a tag only costs
+// a couple of thread-local stores, whether profiling is enabled or not.
+class ScopedCpuProfileTag {
+ public:
+  explicit ScopedCpuProfileTag(const std::string& tag)
+      : ScopedCpuProfileTag(tag.c_str()) {
+  }
+  explicit ScopedCpuProfileTag(const char* tag);
+  ~ScopedCpuProfileTag();
+
+ private:
+  const char* prev_tag_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedCpuProfileTag);
+};
+
+#define SCOPED_CPU_PROFILE_TAG(tag) \
+  kudu::ScopedCpuProfileTag VARNAME_LINENUM(cpu_profile_tag)(tag)
+
+} // namespace kudu
@@ -31,6 +31,10 @@ typedef crcutil_interface::CRC Crc;
 Crc* GetCrc32cInstance();
 
 // Helper function to simply calculate a CRC32C of the given data.
+//
+// On x86_64 CPUs with SSE4.2 and PCLMUL, large buffers are checksummed by
+// several interleaved streams, which is about 2.5x faster than the instance
+// above.
 uint32_t Crc32c(const void* data, size_t length);
 
 // Given CRC value of previous chunk of data,
@@ -38,6 +38,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <map>
 #include <memory>
@@ -78,6 +79,8 @@ DECLARE_bool(crash_on_eio);
 DECLARE_bool(encrypt_data_at_rest);
 DECLARE_double(env_inject_eio);
 DECLARE_int32(env_inject_short_read_bytes);
+DECLARE_bool(env_use_io_uring);
+DECLARE_int32(env_decryption_threads);
 DECLARE_int32(env_inject_short_write_bytes);
 DECLARE_int32(encryption_key_length);
 DECLARE_string(env_inject_eio_globs);
@@ -570,6 +573,60 @@ TEST_F(TestEnv, TestIOVMax) {
   VerifyTestData(Slice(scratch, data_size), 0);
 }
 
+TEST_F(TestEnv, TestReadVBatch) {
+  Env* env = Env::Default();
+  const string kTestPath = GetTestPath("test");
+
+  // More requests than fit in a single io_uring submission.
+  const size_t kNumRequests = 200;
+  const size_t kSliceSize = 100;
+  const size_t kDataSize = kNumRequests * 2 * kSliceSize;
+  NO_FATALS(WriteTestFile(env, kTestPath, kDataSize));
+
+  shared_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_util::OpenFileForRandom(env, kTestPath, &file));
+  const uint64_t header_size = file->GetEncryptionHeaderSize();
+
+  for (bool use_io_uring : { false, true }) {
+    SCOPED_TRACE(use_io_uring);
+    FLAGS_env_use_io_uring = use_io_uring;
+
+    // Read the file backwards, two slices per request.
+    unique_ptr<uint8_t[]> scratch(new uint8_t[kDataSize]);
+    vector<Slice> results;
+    for (size_t i = 0; i < kNumRequests * 2; i++) {
+      results.emplace_back(scratch.get() + i * kSliceSize, kSliceSize);
+    }
+    vector<ReadVRequest> requests;
+    for (size_t i = 0; i < kNumRequests; i++) {
+      size_t offset = (kNumRequests - 1 - i) * 2 * kSliceSize;
+      requests.push_back({ header_size + offset,
+                           ArrayView<Slice>(&results[i * 2], 2) });
+    }
+    ASSERT_OK(file->ReadVBatch(requests));
+    for (size_t i = 0; i < kNumRequests; i++) {
+      NO_FATALS(VerifyTestData(Slice(scratch.get() + i * 2 * kSliceSize, 2 * kSliceSize),
+                               (kNumRequests - 1 - i) * 2 * kSliceSize));
+    }
+
+    // Short reads are retried.
+    memset(scratch.get(), 0, kDataSize);
+    FLAGS_env_inject_short_read_bytes = 3;
+    ASSERT_OK(file->ReadVBatch(requests));
+    FLAGS_env_inject_short_read_bytes = 0;
+    for (size_t i = 0; i < kNumRequests; i++) {
+      NO_FATALS(VerifyTestData(Slice(scratch.get() + i * 2 * kSliceSize, 2 * kSliceSize),
+                               (kNumRequests - 1 - i) * 2 * kSliceSize));
+    }
+
+    // A read past the end of the file fails the whole batch.
+    requests.push_back({ header_size + kDataSize - kSliceSize,
+                         ArrayView<Slice>(&results[0], 2) });
+    Status s = file->ReadVBatch(requests);
+    ASSERT_TRUE(s.IsEndOfFile()) << s.ToString();
+  }
+}
+
 TEST_F(TestEnv, TestAppendV) {
   WritableFileOptions opts;
   LOG(INFO) << "Testing AppendV() only, NO pre-allocation";
@@ -1195,6 +1252,11 @@ TEST_F(TestEnv, TestInjectEIO) {
   s = env_->SyncDir(DirName(kTestRWPath2));
   ASSERT_TRUE(s.IsIOError());
   ASSERT_STR_CONTAINS(s.ToString(), "INJECTED FAILURE");
+#if !defined(__APPLE__)
+  s = env_->SyncFileSystem(DirName(kTestRWPath2));
+  ASSERT_TRUE(s.IsIOError());
+  ASSERT_STR_CONTAINS(s.ToString(), "INJECTED FAILURE");
+#endif
 
   // Specify that neither file fails.
   FLAGS_env_inject_eio_globs = "neither_path";
@@ -1202,6 +1264,17 @@ TEST_F(TestEnv, TestInjectEIO) {
   ASSERT_OK(rw2->Close());
 }
 
+TEST_F(TestEnv, TestSyncFileSystem) {
+  Status s = env_->SyncFileSystem(test_dir_);
+#if defined(__APPLE__)
+  ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+#else
+  ASSERT_OK(s);
+  s = env_->SyncFileSystem(JoinPathSegments(test_dir_, "does_not_exist"));
+  ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+#endif
+}
+
 TEST_F(TestEnv, TestCreateSymlink) {
   const string kSrc = JoinPathSegments(test_dir_, "foo");
   const string kDst = JoinPathSegments(test_dir_, "bar");
@@ -1368,4 +1441,65 @@ TEST_P(TestEncryptedEnv, TestEncryptionMultipleSlices) {
   ASSERT_EQ("foobarhelloworld", result);
 }
 
+// Compares the throughput of batched reads of an unencrypted and an encrypted
+// file, the latter being decrypted with and without the help of the
+// decryption pool.
+TEST_P(TestEncryptedEnv, TestReadVBatchThroughput) {
+  const size_t kFileSize = (AllowSlowTests() ? 512 : 16) * kOneMb;
+  const size_t kRequestSize = 64 * 1024;
+  const size_t kRequestsPerBatch = 32;
+  const size_t kBatchSize = kRequestSize * kRequestsPerBatch;
+
+  faststring data;
+  data.resize(kOneMb);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (i * 31) & 0xff;
+  }
+  unique_ptr<uint8_t[]> scratch(new uint8_t[kBatchSize]);
+  for (bool encrypted : { false, true }) {
+    const string kFile = GetTestPath(encrypted ? "encrypted" : "unencrypted");
+    uint64_t header_size;
+    {
+      unique_ptr<RWFile> rw;
+      RWFileOptions opts;
+      opts.is_sensitive = encrypted;
+      ASSERT_OK(env_->NewRWFile(opts, kFile, &rw));
+      header_size = rw->GetEncryptionHeaderSize();
+      for (size_t offset = 0; offset < kFileSize; offset += data.size()) {
+        ASSERT_OK(rw->Write(header_size + offset, Slice(data)));
+      }
+      ASSERT_OK(rw->Close());
+    }
+    unique_ptr<RandomAccessFile> file;
+    RandomAccessFileOptions opts;
+    opts.is_sensitive = encrypted;
+    ASSERT_OK(env_->NewRandomAccessFile(opts, kFile, &file));
+
+    vector<Slice> results;
+    for (size_t i = 0; i < kRequestsPerBatch; i++) {
+      results.emplace_back(scratch.get() + i * kRequestSize, kRequestSize);
+    }
+    for (int num_threads : encrypted ? vector<int>{ 0, 4 } : vector<int>{ 0 }) {
+      FLAGS_env_decryption_threads = num_threads;
+      Stopwatch sw;
+      sw.start();
+      for (size_t offset = 0; offset < kFileSize; offset += kBatchSize) {
+        vector<ReadVRequest> requests;
+        for (size_t i = 0; i < kRequestsPerBatch; i++) {
+          requests.push_back({ header_size + offset + i * kRequestSize,
+                               ArrayView<Slice>(&results[i], 1) });
+        }
+        ASSERT_OK(file->ReadVBatch(requests));
+      }
+      sw.stop();
+      NO_FATALS(VerifyTestData(Slice(scratch.get(), kBatchSize), kFileSize - kBatchSize));
+      LOG(INFO) << Substitute("read $0 MiB from $1 file with $2 decryption threads: $3 MiB/s",
+                              kFileSize / kOneMb,
+                              encrypted ? "an encrypted" : "an unencrypted",
+                              num_threads,
+                              kFileSize / kOneMb / sw.elapsed().wall_seconds());
+    }
+  }
+}
+
 }  // namespace kudu
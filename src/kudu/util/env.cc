@@ -8,6 +8,7 @@
 
 #include <glog/logging.h>
 
+#include "kudu/util/array_view.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/slice.h"
 
@@ -24,6 +25,20 @@ File::~File() {
 FileLock::~FileLock() {
 }
 
+Status RandomAccessFile::ReadVBatch(ArrayView<const ReadVRequest> requests) const {
+  for (const auto& r : requests) {
+    RETURN_NOT_OK(ReadV(r.offset, r.results));
+  }
+  return Status::OK();
+}
+
+Status RWFile::ReadVBatch(ArrayView<const ReadVRequest> requests) const {
+  for (const auto& r : requests) {
+    RETURN_NOT_OK(ReadV(r.offset, r.results));
+  }
+  return Status::OK();
+}
+
 static Status DoWriteStringToFile(Env* env, const Slice& data,
                                   const std::string& fname,
                                   bool should_sync,
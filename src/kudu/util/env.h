@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "kudu/gutil/macros.h"
+#include "kudu/util/array_view.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -39,9 +40,6 @@ struct RWFileOptions;
 struct WritableFileOptions;
 struct SequentialFileOptions;
 
-template <typename T>
-class ArrayView;
-
 // Returned by Env::GetSpaceInfo().
 struct SpaceInfo {
   int64_t capacity_bytes; // Capacity of a filesystem, in bytes.
@@ -49,6 +47,13 @@ struct SpaceInfo {
   uint64_t filesystem_id; // FilesystemID returned by statvfs()
 };
 
+// One of the reads of RandomAccessFile::ReadVBatch() and RWFile::ReadVBatch():
+// fills the buffers of 'results' with the file data starting at 'offset'.
+struct ReadVRequest {
+  uint64_t offset;
+  ArrayView<Slice> results;
+};
+
 class Env {
  public:
   // Governs if/how the file is created.
@@ -193,6 +198,13 @@ class Env {
   // Synchronize the entry for a specific directory.
   virtual Status SyncDir(const std::string& dirname) = 0;
 
+  // Synchronize all of the files of the filesystem containing 'path', as
+  // syncfs(2) does.
+  //
+  // Returns Status::NotSupported if the platform can't synchronize a whole
+  // filesystem at once.
+  virtual Status SyncFileSystem(const std::string& path) = 0;
+
   // Recursively delete the specified directory.
   // This should operate safely, not following any symlinks, etc.
   virtual Status DeleteRecursively(const std::string &dirname) = 0;
@@ -503,6 +515,17 @@ class RandomAccessFile : public File {
   // Safe for concurrent use by multiple threads.
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const = 0;
 
+  // Performs each of 'requests' as ReadV() would, allowing the implementation
+  // to issue them to the device concurrently rather than one after the other.
+  //
+  // Returns the first error encountered, if any, in which case the contents
+  // of the buffers of all the requests are undefined.
+  //
+  // The default implementation calls ReadV() for each request in turn.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual Status ReadVBatch(ArrayView<const ReadVRequest> requests) const;
+
   // Returns the size of the file
   virtual Status Size(uint64_t *size) const = 0;
 
@@ -647,6 +670,17 @@ class RWFile : public File {
   // Safe for concurrent use by multiple threads.
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const = 0;
 
+  // Performs each of 'requests' as ReadV() would, allowing the implementation
+  // to issue them to the device concurrently rather than one after the other.
+  //
+  // Returns the first error encountered, if any, in which case the contents
+  // of the buffers of all the requests are undefined.
+  //
+  // The default implementation calls ReadV() for each request in turn.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual Status ReadVBatch(ArrayView<const ReadVRequest> requests) const;
+
   // Writes 'data' to the file position given by 'offset'.
   virtual Status Write(uint64_t offset, const Slice& data) = 0;
 
@@ -688,6 +722,13 @@ class RWFile : public File {
   // Filesystems that don't implement this will return an error.
   virtual Status PunchHole(uint64_t offset, size_t length) = 0;
 
+  // Advises the OS to drop the clean pages of the range given by 'offset' and
+  // 'length' from the page cache, e.g. because the range isn't expected to be
+  // read again soon. If length is 0, the range extends to the end of the file.
+  //
+  // This is only a hint: it's a no-op on platforms which don't support it.
+  virtual Status DropPageCache(uint64_t offset, size_t length) = 0;
+
   // Flushes the range of dirty data (not metadata) given by 'offset' and
   // 'length' to disk. If length is 0, all bytes from 'offset' to the end
   // of the file are flushed.
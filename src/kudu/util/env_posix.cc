@@ -29,11 +29,13 @@
 #include <ctime>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -50,8 +52,10 @@
 #include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/strings/util.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/util/array_view.h"
 #include "kudu/util/coding-inl.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/errno.h"
@@ -59,16 +63,17 @@
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
 #include "kudu/util/flags.h"
+#include "kudu/util/io_uring.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/malloc.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/openssl_util.h"
 #include "kudu/util/path_util.h"
-#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/thread_restrictions.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 
 #if defined(__APPLE__)
@@ -169,6 +174,25 @@ DEFINE_bool(env_use_ioctl_hole_punch_on_xfs, true,
 TAG_FLAG(env_use_ioctl_hole_punch_on_xfs, advanced);
 TAG_FLAG(env_use_ioctl_hole_punch_on_xfs, experimental);
 
+DEFINE_bool(env_use_io_uring, false,
+            "Submit batches of reads, e.g. of several blocks read at once, "
+            "through io_uring so that the device services them concurrently. "
+            "Has no effect if io_uring isn't supported by the kernel, in which "
+            "case the reads are issued one after another with preadv(2).");
+TAG_FLAG(env_use_io_uring, advanced);
+TAG_FLAG(env_use_io_uring, experimental);
+TAG_FLAG(env_use_io_uring, runtime);
+
+DEFINE_int32(env_decryption_threads, 0,
+             "Number of threads of a shared pool that help decrypting the batches "
+             "of reads of encrypted files (see --encrypt_data_at_rest) that are "
+             "large enough to be worth splitting, i.e. of at least 1 MiB. The "
+             "reading thread decrypts its share of each batch too. If 0, the "
+             "reading threads decrypt their batches by themselves.");
+TAG_FLAG(env_decryption_threads, advanced);
+TAG_FLAG(env_decryption_threads, experimental);
+TAG_FLAG(env_decryption_threads, runtime);
+
 DEFINE_bool(crash_on_eio, false,
             "Kill the process if an I/O operation results in EIO. If false, "
             "I/O resulting in EIOs will return the status IOError and leave "
@@ -211,6 +235,8 @@ TAG_FLAG(encryption_key_length, advanced);
 
 DEFINE_validator(encryption_key_length,
                  [](const char* /*n*/, int32 v) { return v == 128 || v == 192 || v == 256; });
+DEFINE_validator(env_decryption_threads,
+                 [](const char* /*n*/, int32 v) { return v >= 0; });
 
 DEFINE_bool(enable_multi_tenancy, false,
             "Whether enable the multi tenancy feature."
@@ -466,6 +492,79 @@ Status DoOpen(const string& filename, int flags, const string& reason, int* fd)
   return Status::OK();
 }
 
+// The cipher context of a thread, reused across its encryptions and
+// decryptions: allocating a context and setting up its cipher and key for
+// every call costs about as much as processing the few blocks read or written
+// by most calls. The key schedule is kept as long as the thread keeps using
+// the same key, e.g. while it reads the blocks of a file.
+//
+// The ciphers are OpenSSL's, which use AES-NI where the CPU supports it.
+class ThreadCipherContext {
+ public:
+  ~ThreadCipherContext() {
+    OPENSSL_cleanse(key_, sizeof(key_));
+  }
+
+  // Returns into 'ctx' the cipher context of the calling thread, set up to
+  // encrypt (or decrypt) with the algorithm and key of 'eh', starting from
+  // the counter 'iv'.
+  static Status Get(const EncryptionHeader* eh,
+                    const uint8_t* iv,
+                    bool encrypt,
+                    EVP_CIPHER_CTX** ctx) {
+    static thread_local ThreadCipherContext context;
+    RETURN_NOT_OK(context.Init(eh, iv, encrypt));
+    *ctx = context.ctx_.get();
+    return Status::OK();
+  }
+
+ private:
+  ThreadCipherContext() = default;
+
+  Status Init(const EncryptionHeader* eh, const uint8_t* iv, bool encrypt) {
+    const auto* cipher = GetEVPCipher(eh->algorithm);
+    if (PREDICT_FALSE(!cipher)) {
+      return Status::RuntimeError(
+          StringPrintf("no cipher for algorithm 0x%02x",
+                       static_cast<uint16_t>(eh->algorithm)));
+    }
+    const int key_size = EVP_CIPHER_key_length(cipher);
+    DCHECK_LE(key_size, sizeof(key_));
+    if (initialized_ && algorithm_ == eh->algorithm && encrypt_ == encrypt &&
+        memcmp(key_, eh->key, key_size) == 0) {
+      // Only reset the counter.
+      OPENSSL_RET_NOT_OK(EVP_CipherInit_ex(ctx_.get(), nullptr, nullptr, nullptr, iv, -1),
+                         "Failed to reset cipher");
+      return Status::OK();
+    }
+    if (!ctx_) {
+      ctx_ = ssl_make_unique(EVP_CIPHER_CTX_new());
+      OPENSSL_RET_IF_NULL(ctx_, "failed to create cipher context");
+    }
+    // Don't reuse the context if its initialization fails midway.
+    initialized_ = false;
+    OPENSSL_RET_NOT_OK(EVP_CipherInit_ex(ctx_.get(), cipher, nullptr, eh->key, iv,
+                                         encrypt ? 1 : 0),
+                       encrypt ? "Failed to initialize encryption"
+                               : "Failed to initialize decryption");
+    OPENSSL_RET_NOT_OK(EVP_CIPHER_CTX_set_padding(ctx_.get(), 0),
+                       "failed to disable padding");
+    algorithm_ = eh->algorithm;
+    encrypt_ = encrypt;
+    memcpy(key_, eh->key, key_size);
+    initialized_ = true;
+    return Status::OK();
+  }
+
+  security::c_unique_ptr<EVP_CIPHER_CTX> ctx_;
+  bool initialized_ = false;
+  EncryptionAlgorithm algorithm_;
+  bool encrypt_ = false;
+  uint8_t key_[sizeof(EncryptionHeader::key)] = {};
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadCipherContext);
+};
+
 // Encrypts the data in 'cleartext' and writes it to 'ciphertext'. It requires
 // 'offset' to be set in the file as it's used to set the initialization vector.
 Status DoEncryptV(const EncryptionHeader* eh,
@@ -478,31 +577,21 @@ Status DoEncryptV(const EncryptionHeader* eh,
   InlineBigEndianEncodeFixed64(&iv[0], 0);
   InlineBigEndianEncodeFixed64(&iv[8], offset / kEncryptionBlockSize);
 
-  const auto* cipher = GetEVPCipher(eh->algorithm);
-  if (PREDICT_FALSE(!cipher)) {
-    return Status::RuntimeError(
-        StringPrintf("no cipher for algorithm 0x%02x",
-                     static_cast<uint16_t>(eh->algorithm)));
-  }
-  auto ctx = ssl_make_unique(EVP_CIPHER_CTX_new());
-  OPENSSL_RET_IF_NULL(ctx, "failed to create cipher context");
-  OPENSSL_RET_NOT_OK(EVP_EncryptInit_ex(ctx.get(), cipher, nullptr, eh->key, iv),
-                     "Failed to initialize encryption");
-  OPENSSL_RET_NOT_OK(EVP_CIPHER_CTX_set_padding(ctx.get(), 0),
-                     "failed to disable padding");
+  EVP_CIPHER_CTX* ctx;
+  RETURN_NOT_OK(ThreadCipherContext::Get(eh, iv, /*encrypt=*/true, &ctx));
   const size_t offset_mod = offset % kEncryptionBlockSize;
   if (offset_mod) {
     unsigned char scratch_clear[kEncryptionBlockSize];
     unsigned char scratch_cipher[kEncryptionBlockSize];
     int out_length;
-    OPENSSL_RET_NOT_OK(EVP_EncryptUpdate(ctx.get(), scratch_cipher, &out_length,
+    OPENSSL_RET_NOT_OK(EVP_EncryptUpdate(ctx, scratch_cipher, &out_length,
                                          scratch_clear, offset_mod),
                        "Failed to encrypt scratch data");
     DCHECK_LE(out_length, kEncryptionBlockSize);
   }
   for (auto i = 0; i < cleartext.size(); ++i) {
     int out_length;
-    OPENSSL_RET_NOT_OK(EVP_EncryptUpdate(ctx.get(),
+    OPENSSL_RET_NOT_OK(EVP_EncryptUpdate(ctx,
                                          ciphertext[i].mutable_data(),
                                          &out_length,
                                          cleartext[i].data(),
@@ -528,24 +617,14 @@ Status DoDecryptV(const EncryptionHeader* eh, uint64_t offset, ArrayView<Slice>
   InlineBigEndianEncodeFixed64(&iv[0], 0);
   InlineBigEndianEncodeFixed64(&iv[8], offset / kEncryptionBlockSize);
 
-  const auto* cipher = GetEVPCipher(eh->algorithm);
-  if (PREDICT_FALSE(!cipher)) {
-    return Status::RuntimeError(
-        StringPrintf("no cipher for algorithm 0x%02x",
-                     static_cast<uint16_t>(eh->algorithm)));
-  }
-  auto ctx = ssl_make_unique(EVP_CIPHER_CTX_new());
-  OPENSSL_RET_IF_NULL(ctx, "failed to create cipher context");
-  OPENSSL_RET_NOT_OK(EVP_DecryptInit_ex(ctx.get(), cipher, nullptr, eh->key, iv),
-                     "Failed to initialize decryption");
-  OPENSSL_RET_NOT_OK(EVP_CIPHER_CTX_set_padding(ctx.get(), 0),
-                     "failed to disable padding");
+  EVP_CIPHER_CTX* ctx;
+  RETURN_NOT_OK(ThreadCipherContext::Get(eh, iv, /*encrypt=*/false, &ctx));
   const size_t offset_mod = offset % kEncryptionBlockSize;
   if (offset_mod) {
     unsigned char scratch_clear[kEncryptionBlockSize];
     unsigned char scratch_cipher[kEncryptionBlockSize];
     int out_length;
-    OPENSSL_RET_NOT_OK(EVP_DecryptUpdate(ctx.get(),
+    OPENSSL_RET_NOT_OK(EVP_DecryptUpdate(ctx,
                                          scratch_clear,
                                          &out_length,
                                          scratch_cipher,
@@ -558,7 +637,7 @@ Status DoDecryptV(const EncryptionHeader* eh, uint64_t offset, ArrayView<Slice>
     int in_length = ciphertext_slice.size();
     if (!in_length || IsAllZeros(ciphertext_slice)) continue;
     int out_length;
-    OPENSSL_RET_NOT_OK(EVP_DecryptUpdate(ctx.get(),
+    OPENSSL_RET_NOT_OK(EVP_DecryptUpdate(ctx,
                                          data[i].mutable_data(),
                                          &out_length,
                                          ciphertext_slice.data(),
@@ -573,6 +652,89 @@ Status DoDecryptV(const EncryptionHeader* eh, uint64_t offset, ArrayView<Slice>
   return Status::OK();
 }
 
+// The minimum number of bytes of a batch of reads for its decryption to be
+// split across the threads of the decryption pool.
+constexpr size_t kMinParallelDecryptionBytes = 1024 * 1024;
+
+// Returns the pool helping to decrypt batches of reads, created on first use.
+ThreadPool* DecryptionPool() {
+  static std::once_flag once;
+  static ThreadPool* pool = nullptr;
+  std::call_once(once, []() {
+    unique_ptr<ThreadPool> p;
+    CHECK_OK(ThreadPoolBuilder("decrypt")
+             .set_min_threads(0)
+             .set_max_threads(base::NumCPUs())
+             .Build(&p));
+    pool = p.release();
+  });
+  return pool;
+}
+
+// Decrypts the results of 'requests', i.e. of a batch of reads, splitting
+// them across the decryption pool if they're large enough.
+Status DoDecryptVBatch(const EncryptionHeader* eh, ArrayView<const ReadVRequest> requests) {
+  size_t total_bytes = 0;
+  for (const auto& r : requests) {
+    for (const auto& result : r.results) {
+      total_bytes += result.size();
+    }
+  }
+  const int num_helpers = std::min<int>(FLAGS_env_decryption_threads, requests.size() - 1);
+  if (num_helpers <= 0 || total_bytes < kMinParallelDecryptionBytes) {
+    for (const auto& r : requests) {
+      RETURN_NOT_OK(DoDecryptV(eh, r.offset, r.results));
+    }
+    return Status::OK();
+  }
+
+  // Split the requests into ranges of about the same number of bytes.
+  const size_t bytes_per_range = total_bytes / (num_helpers + 1);
+  vector<std::pair<size_t, size_t>> ranges;
+  size_t start = 0;
+  size_t range_bytes = 0;
+  for (size_t i = 0; i < requests.size(); i++) {
+    for (const auto& result : requests[i].results) {
+      range_bytes += result.size();
+    }
+    if (range_bytes >= bytes_per_range && ranges.size() < num_helpers) {
+      ranges.emplace_back(start, i + 1);
+      start = i + 1;
+      range_bytes = 0;
+    }
+  }
+  if (start < requests.size()) {
+    ranges.emplace_back(start, requests.size());
+  }
+  auto decrypt_range = [eh, requests](const std::pair<size_t, size_t>& range) {
+    for (size_t i = range.first; i < range.second; i++) {
+      RETURN_NOT_OK(DoDecryptV(eh, requests[i].offset, requests[i].results));
+    }
+    return Status::OK();
+  };
+
+  // The calling thread decrypts the first range.
+  vector<Status> statuses(ranges.size());
+  CountDownLatch latch(ranges.size() - 1);
+  ThreadPool* pool = DecryptionPool();
+  for (size_t i = 1; i < ranges.size(); i++) {
+    Status s = pool->Submit([&, i]() {
+      statuses[i] = decrypt_range(ranges[i]);
+      latch.CountDown();
+    });
+    if (PREDICT_FALSE(!s.ok())) {
+      statuses[i] = decrypt_range(ranges[i]);
+      latch.CountDown();
+    }
+  }
+  statuses[0] = decrypt_range(ranges[0]);
+  latch.Wait();
+  for (const auto& s : statuses) {
+    RETURN_NOT_OK(s);
+  }
+  return Status::OK();
+}
+
 Status DoOpen(const string& filename, Env::OpenMode mode, int* fd) {
   MAYBE_RETURN_EIO(filename, IOError(Env::kInjectedFailureStatusMsg, EIO));
   ThreadRestrictions::AssertIOAllowed();
@@ -684,6 +846,104 @@ Status DoReadV(
   return Status::OK();
 }
 
+Status DoReadVBatch(
+    int fd,
+    const string& filename,
+    ArrayView<const ReadVRequest> requests,
+    const EncryptionHeader* eh) {
+  // The kernel rejects reads into more than IOV_MAX buffers outright, rather
+  // than performing them short as preadv() does.
+  IoUring* ring = nullptr;
+  if (FLAGS_env_use_io_uring && requests.size() > 1 &&
+      std::all_of(requests.begin(), requests.end(), [](const ReadVRequest& r) {
+        return r.results.size() <= IOV_MAX;
+      })) {
+    ring = IoUring::ForThisThread();
+  }
+  if (!ring) {
+    // The requests are decrypted together once they're all read.
+    for (const auto& r : requests) {
+      RETURN_NOT_OK(DoReadV(fd, filename, r.offset, r.results, /*eh=*/nullptr));
+    }
+    return eh ? DoDecryptVBatch(eh, requests) : Status::OK();
+  }
+  MAYBE_RETURN_EIO(filename, IOError(Env::kInjectedFailureStatusMsg, EIO));
+  ThreadRestrictions::AssertIOAllowed();
+
+  size_t total_iovs = 0;
+  for (const auto& r : requests) {
+    total_iovs += r.results.size();
+  }
+  // Reserved up front: the ops point into 'iovs'.
+  vector<struct iovec> iovs;
+  iovs.reserve(total_iovs);
+  vector<IoUring::ReadOp> ops;
+  ops.reserve(requests.size());
+  vector<size_t> bytes_req;
+  bytes_req.reserve(requests.size());
+  for (const auto& r : requests) {
+    size_t iov_start = iovs.size();
+    size_t bytes = 0;
+    for (Slice& result : r.results) {
+      bytes += result.size();
+      iovs.push_back({result.mutable_data(), result.size()});
+    }
+    ops.push_back({fd, r.offset, iovs.data() + iov_start,
+                   static_cast<int>(r.results.size()), 0});
+    bytes_req.push_back(bytes);
+  }
+  RETURN_NOT_OK_PREPEND(ring->SubmitAndWait(ops), filename);
+
+  // The requests read in full, to decrypt.
+  vector<ReadVRequest> to_decrypt;
+  if (eh) {
+    to_decrypt.reserve(requests.size());
+  }
+  for (size_t i = 0; i < requests.size(); i++) {
+    const ReadVRequest& r = requests[i];
+    int64_t res = ops[i].result;
+    // Fake a short read for testing
+    if (PREDICT_FALSE(FLAGS_env_inject_short_read_bytes > 0 && res > 0)) {
+      DCHECK_LT(FLAGS_env_inject_short_read_bytes, res);
+      res -= FLAGS_env_inject_short_read_bytes;
+    }
+    if (PREDICT_FALSE(res < 0)) {
+      return IOError(filename, static_cast<int>(-res));
+    }
+    if (PREDICT_FALSE(static_cast<size_t>(res) != bytes_req[i])) {
+      // A short read, e.g. because of EOF. These are rare enough to simply
+      // read the whole request again, letting DoReadV() handle them.
+      RETURN_NOT_OK(DoReadV(fd, filename, r.offset, r.results, eh));
+      continue;
+    }
+    if (eh) {
+      to_decrypt.push_back(r);
+    }
+  }
+  if (eh) {
+    RETURN_NOT_OK(DoDecryptVBatch(eh, to_decrypt));
+  }
+  return Status::OK();
+}
+
+// Returns a buffer of at least 'size' bytes to encrypt data into before
+// writing it. The buffer of the calling thread is reused unless 'size' is too
+// large to keep around, in which case the buffer is allocated into 'owned'.
+uint8_t* GetEncryptionBuffer(size_t size, unique_ptr<uint8_t[]>* owned) {
+  constexpr size_t kMaxThreadBufferSize = 1024 * 1024;
+  static thread_local unique_ptr<uint8_t[]> thread_buf;
+  static thread_local size_t thread_buf_size = 0;
+  if (size > kMaxThreadBufferSize) {
+    owned->reset(new uint8_t[size]);
+    return owned->get();
+  }
+  if (size > thread_buf_size) {
+    thread_buf_size = std::min(std::max(size, 2 * thread_buf_size), kMaxThreadBufferSize);
+    thread_buf.reset(new uint8_t[thread_buf_size]);
+  }
+  return thread_buf.get();
+}
+
 Status DoWriteV(
     int fd,
     const string& filename,
@@ -699,16 +959,12 @@ Status DoWriteV(
   size_t iov_size = data.size();
   struct iovec iov[iov_size];
   std::vector<Slice> encrypted_data(iov_size);
-  SCOPED_CLEANUP({
-    if (eh) {
-      delete[] encrypted_data[0].mutable_data();
-    }
-  });
+  unique_ptr<uint8_t[]> owned_encryption_buf;
   if (eh) {
     for (size_t i = 0; i < iov_size; i++) {
       bytes_req += data[i].size();
     }
-    unique_ptr<unsigned char[]> encrypted_buf(new unsigned char[bytes_req]);
+    uint8_t* encrypted_buf = GetEncryptionBuffer(bytes_req, &owned_encryption_buf);
     size_t buffer_offset = 0;
     for (size_t i = 0; i < iov_size; i++) {
       size_t size = data[i].size();
@@ -717,7 +973,6 @@ Status DoWriteV(
       iov[i] = {const_cast<uint8_t*>(encrypted_data[i].data()), size};
     }
     RETURN_NOT_OK(DoEncryptV(eh, offset, data, encrypted_data));
-    encrypted_buf.release();
   } else {
     for (size_t i = 0; i < iov_size; i++) {
       const Slice& result = data[i];
@@ -1066,6 +1321,14 @@ class PosixRandomAccessFile: public RandomAccessFile {
                    encrypted_ ? &encryption_header_ : nullptr);
   }
 
+  Status ReadVBatch(ArrayView<const ReadVRequest> requests) const override {
+    DCHECK(std::all_of(requests.begin(), requests.end(), [this](const ReadVRequest& r) {
+      return r.offset >= GetEncryptionHeaderSize();
+    }));
+    return DoReadVBatch(fd_, filename_, requests,
+                        encrypted_ ? &encryption_header_ : nullptr);
+  }
+
   Status Size(uint64_t *size) const override {
     MAYBE_RETURN_EIO(filename_, IOError(Env::kInjectedFailureStatusMsg, EIO));
     TRACE_EVENT1("io", "PosixRandomAccessFile::Size", "path", filename_);
@@ -1276,6 +1539,14 @@ class PosixRWFile : public RWFile {
                    encrypted_ ? &encryption_header_ : nullptr);
   }
 
+  Status ReadVBatch(ArrayView<const ReadVRequest> requests) const override {
+    DCHECK(std::all_of(requests.begin(), requests.end(), [this](const ReadVRequest& r) {
+      return r.offset >= GetEncryptionHeaderSize();
+    }));
+    return DoReadVBatch(fd_, filename_, requests,
+                        encrypted_ ? &encryption_header_ : nullptr);
+  }
+
   Status Write(uint64_t offset, const Slice& data) override {
     return WriteV(offset, ArrayView<const Slice>(&data, 1));
   }
@@ -1365,6 +1636,18 @@ class PosixRWFile : public RWFile {
 #endif
   }
 
+  Status DropPageCache(uint64_t offset, size_t length) override {
+#if defined(__linux__)
+    TRACE_EVENT1("io", "PosixRWFile::DropPageCache", "path", filename_);
+    ThreadRestrictions::AssertIOAllowed();
+    int ret = posix_fadvise(fd_, offset, length, POSIX_FADV_DONTNEED);
+    if (ret != 0) {
+      return IOError(filename_, ret);
+    }
+#endif
+    return Status::OK();
+  }
+
   Status Flush(FlushMode mode, uint64_t offset, size_t length) override {
     TRACE_EVENT1("io", "PosixRWFile::Flush", "path", filename_);
     MAYBE_RETURN_EIO(filename_, IOError(Env::kInjectedFailureStatusMsg, EIO));
@@ -1833,6 +2116,29 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  Status SyncFileSystem(const string& path) override {
+    TRACE_EVENT1("io", "SyncFileSystem", "path", path);
+#if defined(__APPLE__)
+    return Status::NotSupported("syncfs() is not supported on macOS");
+#else
+    MAYBE_RETURN_EIO(path, IOError(Env::kInjectedFailureStatusMsg, EIO));
+    ThreadRestrictions::AssertIOAllowed();
+    if (FLAGS_never_fsync) return Status::OK();
+    int fd;
+    RETRY_ON_EINTR(fd, open(path.c_str(), O_RDONLY));
+    if (fd < 0) {
+      return IOError(path, errno);
+    }
+    ScopedFdCloser fd_closer(fd);
+    TRACE_COUNTER_INCREMENT("syncfs", 1);
+    TRACE_COUNTER_SCOPE_LATENCY_US("syncfs_us");
+    if (syncfs(fd) != 0) {
+      return IOError(path, errno);
+    }
+    return Status::OK();
+#endif
+  }
+
   Status DeleteRecursively(const string &name) override {
     return Walk(
         name, POST_ORDER,
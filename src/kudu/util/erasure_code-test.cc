@@ -0,0 +1,109 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/erasure_code.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "kudu/util/random.h"
+#include "kudu/util/random_util.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+using std::pair;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+
+class ErasureCodeTest : public KuduTest {
+ protected:
+  ErasureCodeTest() : rng_(SeedRandom()) {}
+
+  // Encodes random data into the shards of 'code'.
+  vector<string> MakeShards(const ReedSolomonCode& code, int shard_size) {
+    vector<string> shards(code.data_shards());
+    vector<Slice> data;
+    for (auto& shard : shards) {
+      shard = RandomString(shard_size, &rng_);
+      data.emplace_back(shard);
+    }
+    vector<string> parity;
+    CHECK_OK(code.Encode(data, &parity));
+    shards.insert(shards.end(), parity.begin(), parity.end());
+    return shards;
+  }
+
+  Random rng_;
+};
+
+TEST_F(ErasureCodeTest, TestInvalidCodes) {
+  unique_ptr<ReedSolomonCode> code;
+  ASSERT_TRUE(ReedSolomonCode::Create(0, 3, &code).IsInvalidArgument());
+  ASSERT_TRUE(ReedSolomonCode::Create(6, -1, &code).IsInvalidArgument());
+  ASSERT_TRUE(ReedSolomonCode::Create(200, 57, &code).IsInvalidArgument());
+  ASSERT_OK(ReedSolomonCode::Create(200, 56, &code));
+
+  // The data shards must be as many as configured and of equal size.
+  ASSERT_OK(ReedSolomonCode::Create(2, 1, &code));
+  const string a = "abc";
+  const string b = "de";
+  vector<string> parity;
+  ASSERT_TRUE(code->Encode({ Slice(a) }, &parity).IsInvalidArgument());
+  ASSERT_TRUE(code->Encode({ Slice(a), Slice(b) }, &parity).IsInvalidArgument());
+}
+
+// Test that, for various codes, any combination of up to 'parity_shards'
+// lost shards is rebuilt, and that losing more is reported.
+TEST_F(ErasureCodeTest, TestReconstruct) {
+  for (const auto& params : vector<pair<int, int>>{ {1, 1}, {4, 2}, {6, 3}, {10, 4} }) {
+    SCOPED_TRACE(params.first);
+    unique_ptr<ReedSolomonCode> code;
+    ASSERT_OK(ReedSolomonCode::Create(params.first, params.second, &code));
+    const vector<string> shards = MakeShards(*code, 1 + rng_.Uniform(1024));
+    // Every subset of the shards, as a bitmap of the missing ones.
+    for (int missing = 0; missing < (1 << code->total_shards()); missing++) {
+      vector<bool> present(code->total_shards());
+      vector<string> damaged = shards;
+      int num_missing = 0;
+      for (int i = 0; i < code->total_shards(); i++) {
+        present[i] = !(missing & (1 << i));
+        if (!present[i]) {
+          damaged[i] = "lost";
+          num_missing++;
+        }
+      }
+      Status s = code->Reconstruct(present, &damaged);
+      if (num_missing > code->parity_shards()) {
+        ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+        continue;
+      }
+      ASSERT_OK(s);
+      ASSERT_EQ(shards, damaged);
+    }
+  }
+}
+
+} // namespace kudu
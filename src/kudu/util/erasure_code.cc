@@ -0,0 +1,271 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/erasure_code.h"
+
+#include <cstring>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/strings/substitute.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+namespace {
+
+// Log and antilog tables of GF(2^8) with the generator polynomial
+// x^8 + x^4 + x^3 + x^2 + 1.
+class GaloisField {
+ public:
+  GaloisField() {
+    int x = 1;
+    for (int i = 0; i < 255; i++) {
+      exp_[i] = x;
+      exp_[i + 255] = x;
+      log_[x] = i;
+      x <<= 1;
+      if (x & 0x100) {
+        x ^= 0x11d;
+      }
+    }
+    log_[0] = 0;
+  }
+
+  uint8_t Mul(uint8_t a, uint8_t b) const {
+    if (a == 0 || b == 0) {
+      return 0;
+    }
+    return exp_[log_[a] + log_[b]];
+  }
+
+  uint8_t Inv(uint8_t a) const {
+    DCHECK_NE(0, a);
+    return exp_[255 - log_[a]];
+  }
+
+ private:
+  uint8_t exp_[510];
+  int log_[256];
+};
+
+const GaloisField& GF() {
+  static const GaloisField kField;
+  return kField;
+}
+
+// Inverts the n x n matrix 'm' in place by Gauss-Jordan elimination. Returns
+// false if it is singular.
+bool InvertMatrix(int n, vector<uint8_t>* m) {
+  const auto& gf = GF();
+  vector<uint8_t> inv(n * n, 0);
+  for (int i = 0; i < n; i++) {
+    inv[i * n + i] = 1;
+  }
+  auto& a = *m;
+  for (int col = 0; col < n; col++) {
+    int pivot = col;
+    while (pivot < n && a[pivot * n + col] == 0) {
+      pivot++;
+    }
+    if (pivot == n) {
+      return false;
+    }
+    if (pivot != col) {
+      for (int j = 0; j < n; j++) {
+        std::swap(a[pivot * n + j], a[col * n + j]);
+        std::swap(inv[pivot * n + j], inv[col * n + j]);
+      }
+    }
+    const uint8_t scale = gf.Inv(a[col * n + col]);
+    for (int j = 0; j < n; j++) {
+      a[col * n + j] = gf.Mul(a[col * n + j], scale);
+      inv[col * n + j] = gf.Mul(inv[col * n + j], scale);
+    }
+    for (int row = 0; row < n; row++) {
+      const uint8_t factor = a[row * n + col];
+      if (row == col || factor == 0) {
+        continue;
+      }
+      for (int j = 0; j < n; j++) {
+        a[row * n + j] ^= gf.Mul(factor, a[col * n + j]);
+        inv[row * n + j] ^= gf.Mul(factor, inv[col * n + j]);
+      }
+    }
+  }
+  m->swap(inv);
+  return true;
+}
+
+} // anonymous namespace
+
+ReedSolomonCode::ReedSolomonCode(int data_shards, int parity_shards)
+    : data_shards_(data_shards),
+      parity_shards_(parity_shards),
+      parity_matrix_(parity_shards * data_shards) {
+  const auto& gf = GF();
+  for (int i = 0; i < parity_shards_; i++) {
+    for (int j = 0; j < data_shards_; j++) {
+      // x_i = data_shards + i and y_j = j are distinct, so x_i + y_j != 0.
+      parity_matrix_[i * data_shards_ + j] = gf.Inv((data_shards_ + i) ^ j);
+    }
+  }
+}
+
+Status ReedSolomonCode::Create(int data_shards, int parity_shards,
+                               unique_ptr<ReedSolomonCode>* code) {
+  if (data_shards <= 0 || parity_shards < 0 || data_shards + parity_shards > 256) {
+    return Status::InvalidArgument(Substitute(
+        "invalid erasure code RS($0,$1)", data_shards, parity_shards));
+  }
+  code->reset(new ReedSolomonCode(data_shards, parity_shards));
+  return Status::OK();
+}
+
+void ReedSolomonCode::MultiplyAdd(const uint8_t* coeffs,
+                                  const vector<const uint8_t*>& inputs,
+                                  size_t size, uint8_t* out) {
+  const auto& gf = GF();
+  memset(out, 0, size);
+  for (int j = 0; j < inputs.size(); j++) {
+    const uint8_t c = coeffs[j];
+    if (c == 0) {
+      continue;
+    }
+    const uint8_t* in = inputs[j];
+    for (size_t b = 0; b < size; b++) {
+      out[b] ^= gf.Mul(c, in[b]);
+    }
+  }
+}
+
+Status ReedSolomonCode::Encode(const vector<Slice>& data,
+                               vector<string>* parity) const {
+  if (data.size() != data_shards_) {
+    return Status::InvalidArgument(Substitute(
+        "expected $0 data shards, got $1", data_shards_, data.size()));
+  }
+  const size_t size = data[0].size();
+  vector<const uint8_t*> inputs;
+  inputs.reserve(data_shards_);
+  for (const auto& shard : data) {
+    if (shard.size() != size) {
+      return Status::InvalidArgument("data shards must be of equal size");
+    }
+    inputs.push_back(shard.data());
+  }
+  parity->resize(parity_shards_);
+  for (int i = 0; i < parity_shards_; i++) {
+    auto& out = (*parity)[i];
+    out.resize(size);
+    MultiplyAdd(&parity_matrix_[i * data_shards_], inputs, size,
+                reinterpret_cast<uint8_t*>(&out[0]));
+  }
+  return Status::OK();
+}
+
+Status ReedSolomonCode::Reconstruct(const vector<bool>& present,
+                                    vector<string>* shards) const {
+  if (present.size() != total_shards() || shards->size() != total_shards()) {
+    return Status::InvalidArgument(Substitute(
+        "expected $0 shards, got $1", total_shards(), shards->size()));
+  }
+  // Decode from the first data_shards_ shards present.
+  vector<int> rows;
+  rows.reserve(data_shards_);
+  for (int i = 0; i < total_shards() && rows.size() < data_shards_; i++) {
+    if (present[i]) {
+      rows.push_back(i);
+    }
+  }
+  if (rows.size() < data_shards_) {
+    return Status::Corruption(Substitute(
+        "only $0 of $1 shards present, at least $2 needed",
+        rows.size(), total_shards(), data_shards_));
+  }
+  const size_t size = (*shards)[rows[0]].size();
+  vector<const uint8_t*> inputs;
+  inputs.reserve(data_shards_);
+  for (int row : rows) {
+    const auto& shard = (*shards)[row];
+    if (shard.size() != size) {
+      return Status::InvalidArgument("shards must be of equal size");
+    }
+    inputs.push_back(reinterpret_cast<const uint8_t*>(shard.data()));
+  }
+
+  bool data_missing = false;
+  for (int i = 0; i < data_shards_; i++) {
+    data_missing |= !present[i];
+  }
+  if (data_missing) {
+    // The present shards are the product of the rows of the encoding matrix
+    // for them by the data, so the data is the product of the inverse of these
+    // rows by the present shards.
+    vector<uint8_t> decode(data_shards_ * data_shards_, 0);
+    for (int r = 0; r < data_shards_; r++) {
+      if (rows[r] < data_shards_) {
+        decode[r * data_shards_ + rows[r]] = 1;
+      } else {
+        memcpy(&decode[r * data_shards_],
+               &parity_matrix_[(rows[r] - data_shards_) * data_shards_],
+               data_shards_);
+      }
+    }
+    CHECK(InvertMatrix(data_shards_, &decode));
+    vector<string> rebuilt(data_shards_);
+    for (int i = 0; i < data_shards_; i++) {
+      if (present[i]) {
+        continue;
+      }
+      rebuilt[i].resize(size);
+      MultiplyAdd(&decode[i * data_shards_], inputs, size,
+                  reinterpret_cast<uint8_t*>(&rebuilt[i][0]));
+    }
+    // The inputs point into 'shards', so only move the rebuilt shards in once
+    // all of them are computed.
+    for (int i = 0; i < data_shards_; i++) {
+      if (!present[i]) {
+        (*shards)[i] = std::move(rebuilt[i]);
+      }
+    }
+  }
+
+  // Recompute the missing parity shards from the now complete data.
+  vector<const uint8_t*> data;
+  data.reserve(data_shards_);
+  for (int i = 0; i < data_shards_; i++) {
+    data.push_back(reinterpret_cast<const uint8_t*>((*shards)[i].data()));
+  }
+  for (int i = 0; i < parity_shards_; i++) {
+    if (present[data_shards_ + i]) {
+      continue;
+    }
+    auto& out = (*shards)[data_shards_ + i];
+    out.resize(size);
+    MultiplyAdd(&parity_matrix_[i * data_shards_], data, size,
+                reinterpret_cast<uint8_t*>(&out[0]));
+  }
+  return Status::OK();
+}
+
+} // namespace kudu
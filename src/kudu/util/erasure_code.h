@@ -0,0 +1,83 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+// A systematic Reed-Solomon erasure code over GF(2^8), e.g. RS(6,3).
+//
+// The data is split into 'data_shards' shards of equal size, from which
+// 'parity_shards' parity shards of the same size are computed. The data can
+// be reconstructed from any 'data_shards' of the resulting shards, so up to
+// 'parity_shards' of them may be lost.
+//
+// The encoding matrix stacks the identity on top of a Cauchy matrix, every
+// square submatrix of which is invertible.
+//
+// This class is immutable and thread-safe.
+class ReedSolomonCode {
+ public:
+  // Creates a code with the given numbers of shards, of which there may be
+  // at most 256 in total.
+  static Status Create(int data_shards, int parity_shards,
+                       std::unique_ptr<ReedSolomonCode>* code);
+
+  int data_shards() const { return data_shards_; }
+  int parity_shards() const { return parity_shards_; }
+  int total_shards() const { return data_shards_ + parity_shards_; }
+
+  // Computes into 'parity' the parity shards of 'data', which must consist of
+  // data_shards() shards of equal size.
+  Status Encode(const std::vector<Slice>& data,
+                std::vector<std::string>* parity) const;
+
+  // Rebuilds the missing shards among 'shards', which must hold
+  // total_shards() shards, data shards first. The shards for which 'present'
+  // is false are missing and get overwritten. Returns Corruption if fewer
+  // than data_shards() shards are present.
+  Status Reconstruct(const std::vector<bool>& present,
+                     std::vector<std::string>* shards) const;
+
+ private:
+  ReedSolomonCode(int data_shards, int parity_shards);
+
+  // Sets 'out' to the sum of the 'inputs' multiplied by the coefficients
+  // 'coeffs', byte by byte.
+  static void MultiplyAdd(const uint8_t* coeffs,
+                          const std::vector<const uint8_t*>& inputs,
+                          size_t size, uint8_t* out);
+
+  const int data_shards_;
+  const int parity_shards_;
+
+  // The parity rows of the encoding matrix, 'parity_shards_' rows of
+  // 'data_shards_' coefficients.
+  std::vector<uint8_t> parity_matrix_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReedSolomonCode);
+};
+
+} // namespace kudu
@@ -45,6 +45,8 @@
 
 DECLARE_bool(cache_force_single_shard);
 DECLARE_int32(file_cache_expiry_period_ms);
+DECLARE_int32(file_cache_max_pinned_files);
+DECLARE_int32(file_cache_pin_reopen_threshold);
 DECLARE_bool(encrypt_data_at_rest);
 
 using std::shared_ptr;
@@ -316,6 +318,53 @@ TYPED_TEST(FileCacheTest, TestHeavyReads) {
   }
 }
 
+TYPED_TEST(FileCacheTest, TestPinning) {
+  // One of the two files may be pinned, the other one being cached.
+  FLAGS_file_cache_max_pinned_files = 1;
+  FLAGS_file_cache_pin_reopen_threshold = 2;
+  ASSERT_OK(this->ReinitCache(2));
+
+  const string kFile1 = this->GetTestPath("foo");
+  const string kFile2 = this->GetTestPath("bar");
+  const string kFile3 = this->GetTestPath("baz");
+  ASSERT_OK(this->WriteTestFile(kFile1, "test data 1"));
+  ASSERT_OK(this->WriteTestFile(kFile2, "test data 2"));
+  ASSERT_OK(this->WriteTestFile(kFile3, "test data 3"));
+  {
+    shared_ptr<TypeParam> f1;
+    shared_ptr<TypeParam> f2;
+    shared_ptr<TypeParam> f3;
+    ASSERT_OK(this->cache_->template OpenFile<Env::MUST_EXIST>(kFile1, &f1));
+    ASSERT_OK(this->cache_->template OpenFile<Env::MUST_EXIST>(kFile2, &f2));
+    NO_FATALS(this->AssertFdsAndDescriptors(1, 2));
+
+    // Alternating between the files reopens them, until the first one to be
+    // reopened often enough is pinned.
+    uint64_t size;
+    ASSERT_OK(f1->Size(&size));
+    ASSERT_OK(f2->Size(&size));
+    ASSERT_EQ(0, this->cache_->num_pinned_files());
+    ASSERT_OK(f1->Size(&size));
+    ASSERT_EQ(1, this->cache_->num_pinned_files());
+    NO_FATALS(this->AssertFdsAndDescriptors(2, 2));
+    ASSERT_STR_CONTAINS(this->cache_->ToDebugString(), Substitute("$0 (SP)", kFile1));
+
+    // The files are no longer reopened, and the pinned files are bounded.
+    ASSERT_OK(this->cache_->template OpenFile<Env::MUST_EXIST>(kFile3, &f3));
+    for (int i = 0; i < 3; i++) {
+      ASSERT_OK(f1->Size(&size));
+      ASSERT_OK(f2->Size(&size));
+      ASSERT_OK(f3->Size(&size));
+    }
+    ASSERT_EQ(1, this->cache_->num_pinned_files());
+    NO_FATALS(this->AssertFdsAndDescriptors(2, 3));
+  }
+
+  // Dropping the descriptor of a pinned file closes it.
+  ASSERT_EQ(0, this->cache_->num_pinned_files());
+  NO_FATALS(this->AssertFdsAndDescriptors(0, 0));
+}
+
 TYPED_TEST(FileCacheTest, TestNoRecursiveDeadlock) {
   // This test triggered a deadlock in a previous implementation, when expired
   // weak_ptrs were removed from the descriptor map in the descriptor's
@@ -17,6 +17,7 @@
 
 #include "kudu/util/file_cache.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <cstring>
@@ -43,7 +44,9 @@
 #include "kudu/util/env.h"
 #include "kudu/util/file_cache_metrics.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/hash_util.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/once.h"
 #include "kudu/util/slice.h"
@@ -54,6 +57,45 @@ DEFINE_int32(file_cache_expiry_period_ms, 60 * 1000,
              "Period of time (in ms) between removing expired file cache descriptors");
 TAG_FLAG(file_cache_expiry_period_ms, advanced);
 
+DEFINE_int32(file_cache_max_pinned_files, 0,
+             "Maximum number of files kept open by a file cache outside of its LRU "
+             "cache because they're frequently reopened after their file descriptors "
+             "were evicted (see --file_cache_pin_reopen_threshold). The pinned files "
+             "count towards the capacity of the file cache, and at most half of it "
+             "may be pinned. If 0, no file is pinned.");
+TAG_FLAG(file_cache_max_pinned_files, experimental);
+
+DEFINE_int32(file_cache_pin_reopen_threshold, 3,
+             "Number of times a file must have been reopened by a file cache after "
+             "the eviction of its file descriptor to be pinned, i.e. kept open until "
+             "it's no longer in use. Only relevant if --file_cache_max_pinned_files "
+             "is positive.");
+TAG_FLAG(file_cache_pin_reopen_threshold, experimental);
+TAG_FLAG(file_cache_pin_reopen_threshold, runtime);
+
+namespace {
+
+bool ValidateMaxPinnedFiles(const char* flagname, int32_t value) {
+  if (value >= 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must not be negative: " << value;
+  return false;
+}
+
+bool ValidatePinReopenThreshold(const char* flagname, int32_t value) {
+  if (value > 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must be positive: " << value;
+  return false;
+}
+
+} // anonymous namespace
+
+DEFINE_validator(file_cache_max_pinned_files, &ValidateMaxPinnedFiles);
+DEFINE_validator(file_cache_pin_reopen_threshold, &ValidatePinReopenThreshold);
+
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -111,6 +153,11 @@ class BaseDescriptor {
     // than they are to want the resource to be quickly accessible should the
     // file be reopened.
     cache()->Erase(filename());
+    FileType* pinned = pinned_file_.load();
+    if (pinned) {
+      delete pinned;
+      file_cache_->ReleasePinnedFile();
+    }
 
     if (deleted()) {
       VLOG(1) << "Deleting file: " << filename();
@@ -139,6 +186,41 @@ class BaseDescriptor {
                               file_cache_->eviction_cb_.get()));
   }
 
+  // Takes ownership of 'file', just opened by this descriptor in
+  // 'open_latency', either inserting it into the file cache or pinning it if
+  // it was 'reopened' often enough.
+  //
+  // Returns a handle to the open file.
+  ScopedOpenedDescriptor<FileType> InsertOpenedFile(FileType* file,
+                                                    bool reopened,
+                                                    const MonoDelta& open_latency) const {
+    if (!reopened) {
+      return InsertIntoCache(file);
+    }
+    if (file_cache_->metrics_) {
+      file_cache_->metrics_->reopens->Increment();
+      file_cache_->metrics_->reopen_latency->Increment(open_latency.ToMicroseconds());
+    }
+    if (num_reopens_.fetch_add(1) + 1 < FLAGS_file_cache_pin_reopen_threshold ||
+        !file_cache_->TryReservePinnedFile()) {
+      return InsertIntoCache(file);
+    }
+    FileType* pinned = nullptr;
+    if (pinned_file_.compare_exchange_strong(pinned, file)) {
+      VLOG(1) << "Pinned file: " << filename();
+      return ScopedOpenedDescriptor<FileType>(this, file);
+    }
+
+    // The file was pinned by a concurrent reopen.
+    file_cache_->ReleasePinnedFile();
+    delete file;
+    return ScopedOpenedDescriptor<FileType>(this, pinned);
+  }
+
+  // Returns the file kept open by this descriptor, or nullptr if its file
+  // isn't pinned.
+  FileType* pinned_file() const { return pinned_file_.load(); }
+
   // Retrieves a pointer to an open file object from the file cache with the
   // filename as the cache key.
   //
@@ -186,6 +268,12 @@ class BaseDescriptor {
   };
   std::atomic<uint8_t> flags_ {0};
 
+  // The number of times the file was reopened after its eviction.
+  mutable std::atomic<int> num_reopens_ {0};
+
+  // Owned by the descriptor once pinned.
+  mutable std::atomic<FileType*> pinned_file_ {nullptr};
+
   DISALLOW_COPY_AND_ASSIGN(BaseDescriptor);
 };
 
@@ -209,16 +297,28 @@ class ScopedOpenedDescriptor {
         handle_(std::move(handle)) {
   }
 
-  bool opened() const { return handle_.get(); }
+  // A pinned descriptor, whose file is open outside of the cache.
+  ScopedOpenedDescriptor(const BaseDescriptor<FileType>* desc,
+                         FileType* pinned_file)
+      : desc_(desc),
+        handle_(nullptr, Cache::HandleDeleter(desc_->cache())),
+        pinned_file_(pinned_file) {
+  }
+
+  bool opened() const { return pinned_file_ || handle_.get(); }
 
   FileType* file() const {
     DCHECK(opened());
+    if (pinned_file_) {
+      return pinned_file_;
+    }
     return CacheValueToFileType<FileType>(desc_->cache()->Value(handle_));
   }
 
  private:
   const BaseDescriptor<FileType>* desc_;
   Cache::UniqueHandle handle_;
+  FileType* pinned_file_ = nullptr;
 };
 
 // Reference to an on-disk file that may or may not be opened (and thus
@@ -252,6 +352,12 @@ class Descriptor<RWFile> : public RWFile {
     return opened.file()->ReadV(offset, results);
   }
 
+  Status ReadVBatch(ArrayView<const ReadVRequest> requests) const override {
+    ScopedOpenedDescriptor<RWFile> opened(&base_);
+    RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
+    return opened.file()->ReadVBatch(requests);
+  }
+
   Status Write(uint64_t offset, const Slice& data) override {
     ScopedOpenedDescriptor<RWFile> opened(&base_);
     RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
@@ -282,6 +388,12 @@ class Descriptor<RWFile> : public RWFile {
     return opened.file()->PunchHole(offset, length);
   }
 
+  Status DropPageCache(uint64_t offset, size_t length) override {
+    ScopedOpenedDescriptor<RWFile> opened(&base_);
+    RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
+    return opened.file()->DropPageCache(offset, length);
+  }
+
   Status Flush(FlushMode mode, uint64_t offset, size_t length) override {
     ScopedOpenedDescriptor<RWFile> opened(&base_);
     RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
@@ -338,6 +450,14 @@ class Descriptor<RWFile> : public RWFile {
 
   template <Env::OpenMode Mode>
   Status ReopenFileIfNecessary(ScopedOpenedDescriptor<RWFile>* out) const {
+    RWFile* pinned = base_.pinned_file();
+    if (pinned) {
+      CHECK(!base_.invalidated());
+      if (out) {
+        *out = ScopedOpenedDescriptor<RWFile>(&base_, pinned);
+      }
+      return Status::OK();
+    }
     ScopedOpenedDescriptor<RWFile> found(base_.LookupFromCache());
     CHECK(!base_.invalidated());
     if (found.opened()) {
@@ -348,15 +468,19 @@ class Descriptor<RWFile> : public RWFile {
       return Status::OK();
     }
 
-    // The file was evicted, reopen it.
+    // The file was evicted (or was never opened, when initializing the
+    // descriptor), reopen it.
+    const MonoTime start = MonoTime::Now();
     RWFileOptions opts;
     opts.mode = Mode;
     opts.is_sensitive = true;
     unique_ptr<RWFile> f;
     RETURN_NOT_OK(base_.env()->NewRWFile(opts, base_.filename(), &f));
 
-    // The cache will take ownership of the newly opened file.
-    ScopedOpenedDescriptor<RWFile> opened(base_.InsertIntoCache(f.release()));
+    // The cache (or the descriptor, if pinned) will take ownership of the
+    // newly opened file.
+    ScopedOpenedDescriptor<RWFile> opened(base_.InsertOpenedFile(
+        f.release(), /*reopened=*/out != nullptr, MonoTime::Now() - start));
     if (out) {
       *out = std::move(opened);
     }
@@ -391,6 +515,12 @@ class Descriptor<RandomAccessFile> : public RandomAccessFile {
     return opened.file()->ReadV(offset, results);
   }
 
+  Status ReadVBatch(ArrayView<const ReadVRequest> requests) const override {
+    ScopedOpenedDescriptor<RandomAccessFile> opened(&base_);
+    RETURN_NOT_OK(ReopenFileIfNecessary(&opened));
+    return opened.file()->ReadVBatch(requests);
+  }
+
   Status Size(uint64_t *size) const override {
     ScopedOpenedDescriptor<RandomAccessFile> opened(&base_);
     RETURN_NOT_OK(ReopenFileIfNecessary(&opened));
@@ -442,6 +572,14 @@ class Descriptor<RandomAccessFile> : public RandomAccessFile {
 
   Status ReopenFileIfNecessary(
       ScopedOpenedDescriptor<RandomAccessFile>* out) const {
+    RandomAccessFile* pinned = base_.pinned_file();
+    if (pinned) {
+      CHECK(!base_.invalidated());
+      if (out) {
+        *out = ScopedOpenedDescriptor<RandomAccessFile>(&base_, pinned);
+      }
+      return Status::OK();
+    }
     ScopedOpenedDescriptor<RandomAccessFile> found(base_.LookupFromCache());
     CHECK(!base_.invalidated());
     if (found.opened()) {
@@ -452,15 +590,18 @@ class Descriptor<RandomAccessFile> : public RandomAccessFile {
       return Status::OK();
     }
 
-    // The file was evicted, reopen it.
+    // The file was evicted (or was never opened, when initializing the
+    // descriptor), reopen it.
+    const MonoTime start = MonoTime::Now();
     unique_ptr<RandomAccessFile> f;
     RandomAccessFileOptions opts;
     opts.is_sensitive = true;
     RETURN_NOT_OK(base_.env()->NewRandomAccessFile(opts, base_.filename(), &f));
 
-    // The cache will take ownership of the newly opened file.
-    ScopedOpenedDescriptor<RandomAccessFile> opened(
-        base_.InsertIntoCache(f.release()));
+    // The cache (or the descriptor, if pinned) will take ownership of the
+    // newly opened file.
+    ScopedOpenedDescriptor<RandomAccessFile> opened(base_.InsertOpenedFile(
+        f.release(), /*reopened=*/out != nullptr, MonoTime::Now() - start));
     if (out) {
       *out = std::move(opened);
     }
@@ -484,14 +625,17 @@ FileCache::FileCache(const string& cache_name,
     : env_(env),
       cache_name_(cache_name),
       eviction_cb_(new EvictionCallback()),
-      cache_(NewCache(max_open_files, cache_name)),
+      max_pinned_files_(std::min(FLAGS_file_cache_max_pinned_files, max_open_files / 2)),
+      num_pinned_files_(0),
+      cache_(NewCache(max_open_files - max_pinned_files_, cache_name)),
       running_(1) {
   if (entity) {
     unique_ptr<FileCacheMetrics> metrics(new FileCacheMetrics(entity));
     cache_->SetMetrics(std::move(metrics), Cache::ExistingMetricsPolicy::kKeep);
+    metrics_.reset(new FileCacheDescriptorMetrics(entity));
   }
-  LOG(INFO) << Substitute("Constructed file cache $0 with capacity $1",
-                          cache_name, max_open_files);
+  LOG(INFO) << Substitute("Constructed file cache $0 with capacity $1 ($2 pinned files at most)",
+                          cache_name, max_open_files, max_pinned_files_);
 }
 
 FileCache::~FileCache() {
@@ -514,9 +658,10 @@ Status FileCache::DoOpenFile(const string& file_name,
   shared_ptr<internal::Descriptor<RWFile>> d;
   bool cd;
   {
-    std::lock_guard<simple_spinlock> l(lock_);
+    DescriptorShard* s = shard(file_name);
+    std::lock_guard<simple_spinlock> l(s->lock);
     d = FindDescriptorUnlocked(file_name, FindMode::CREATE_IF_NOT_EXIST,
-                               &rwf_descs_, &cd);
+                               &s->rwf_descs, &cd);
     DCHECK(d);
 
 #ifndef NDEBUG
@@ -524,7 +669,7 @@ Status FileCache::DoOpenFile(const string& file_name,
     // descriptor at a time. This is expensive so it's only done in DEBUG mode.
     bool ignored;
     CHECK(!FindDescriptorUnlocked(file_name, FindMode::DONT_CREATE,
-                                  &raf_descs_, &ignored));
+                                  &s->raf_descs, &ignored));
 #endif
   }
   if (d->base_.deleted()) {
@@ -542,9 +687,10 @@ Status FileCache::DoOpenFile(const string& file_name,
   shared_ptr<internal::Descriptor<RandomAccessFile>> d;
   bool cd;
   {
-    std::lock_guard<simple_spinlock> l(lock_);
+    DescriptorShard* s = shard(file_name);
+    std::lock_guard<simple_spinlock> l(s->lock);
     d = FindDescriptorUnlocked(file_name, FindMode::CREATE_IF_NOT_EXIST,
-                               &raf_descs_, &cd);
+                               &s->raf_descs, &cd);
     DCHECK(d);
 
 #ifndef NDEBUG
@@ -552,7 +698,7 @@ Status FileCache::DoOpenFile(const string& file_name,
     // descriptor at a time. This is expensive so it's only done in DEBUG mode.
     bool ignored;
     CHECK(!FindDescriptorUnlocked(file_name, FindMode::DONT_CREATE,
-                                  &rwf_descs_, &ignored));
+                                  &s->rwf_descs, &ignored));
 #endif
   }
   if (d->base_.deleted()) {
@@ -624,11 +770,12 @@ Status FileCache::DeleteFile(const string& file_name) {
   // descriptor per file name, we can short circuit the search if we find a
   // descriptor in the first map.
   {
-    std::lock_guard<simple_spinlock> l(lock_);
+    DescriptorShard* s = shard(file_name);
+    std::lock_guard<simple_spinlock> l(s->lock);
     bool ignored;
     {
       auto d = FindDescriptorUnlocked(file_name, FindMode::DONT_CREATE,
-                                      &rwf_descs_, &ignored);
+                                      &s->rwf_descs, &ignored);
       if (d) {
         if (d->base_.deleted()) {
           return Status::NotFound(kAlreadyDeleted, file_name);
@@ -639,7 +786,7 @@ Status FileCache::DeleteFile(const string& file_name) {
     }
     {
       auto d = FindDescriptorUnlocked(file_name, FindMode::DONT_CREATE,
-                                      &raf_descs_, &ignored);
+                                      &s->raf_descs, &ignored);
       if (d) {
         if (d->base_.deleted()) {
           return Status::NotFound(kAlreadyDeleted, file_name);
@@ -668,16 +815,17 @@ void FileCache::Invalidate(const string& file_name) {
   // occurs before the client trips on the broken invariant.
   shared_ptr<internal::Descriptor<RWFile>> rwf_desc;
   shared_ptr<internal::Descriptor<RandomAccessFile>> raf_desc;
+  DescriptorShard* s = shard(file_name);
   {
-    std::lock_guard<simple_spinlock> l(lock_);
+    std::lock_guard<simple_spinlock> l(s->lock);
     bool ignored;
     rwf_desc = FindDescriptorUnlocked(file_name, FindMode::CREATE_IF_NOT_EXIST,
-                                      &rwf_descs_, &ignored);
+                                      &s->rwf_descs, &ignored);
     DCHECK(rwf_desc);
     rwf_desc->base_.MarkInvalidated();
 
     raf_desc = FindDescriptorUnlocked(file_name, FindMode::CREATE_IF_NOT_EXIST,
-                                      &raf_descs_, &ignored);
+                                      &s->raf_descs, &ignored);
     DCHECK(raf_desc);
     raf_desc->base_.MarkInvalidated();
   }
@@ -692,15 +840,19 @@ void FileCache::Invalidate(const string& file_name) {
   // duration of this method, and no other methods erase strong references from
   // the maps.
   {
-    std::lock_guard<simple_spinlock> l(lock_);
-    CHECK_EQ(1, rwf_descs_.erase(file_name));
-    CHECK_EQ(1, raf_descs_.erase(file_name));
+    std::lock_guard<simple_spinlock> l(s->lock);
+    CHECK_EQ(1, s->rwf_descs.erase(file_name));
+    CHECK_EQ(1, s->raf_descs.erase(file_name));
   }
 }
 
 size_t FileCache::NumDescriptorsForTests() const {
-  std::lock_guard<simple_spinlock> l(lock_);
-  return rwf_descs_.size() + raf_descs_.size();
+  size_t num_descriptors = 0;
+  for (const auto& s : shards_) {
+    std::lock_guard<simple_spinlock> l(s.lock);
+    num_descriptors += s.rwf_descs.size() + s.raf_descs.size();
+  }
+  return num_descriptors;
 }
 
 string FileCache::ToDebugString() const {
@@ -710,10 +862,10 @@ string FileCache::ToDebugString() const {
   // of them.
   DescriptorMap<RWFile> rwfs_copy;
   DescriptorMap<RandomAccessFile> rafs_copy;
-  {
-    std::lock_guard<simple_spinlock> l(lock_);
-    rwfs_copy = rwf_descs_;
-    rafs_copy = raf_descs_;
+  for (const auto& s : shards_) {
+    std::lock_guard<simple_spinlock> l(s.lock);
+    rwfs_copy.insert(s.rwf_descs.begin(), s.rwf_descs.end());
+    rafs_copy.insert(s.raf_descs.begin(), s.raf_descs.end());
   }
 
   // Dump the contents of the copies.
@@ -730,6 +882,7 @@ string FileCache::MapToDebugString(const DescriptorMap<FileType>& descs,
     bool strong = false;
     bool deleted = false;
     bool opened = false;
+    bool pinned = false;
     shared_ptr<internal::Descriptor<FileType>> d = e.second.lock();
     if (d) {
       strong = true;
@@ -740,10 +893,11 @@ string FileCache::MapToDebugString(const DescriptorMap<FileType>& descs,
       if (sod.opened()) {
         opened = true;
       }
+      pinned = d->base_.pinned_file() != nullptr;
     }
     if (strong) {
-      ret += Substitute("$0: $1 (S$2$3)\n", prefix, e.first,
-                        deleted ? "D" : "", opened ? "O" : "");
+      ret += Substitute("$0: $1 (S$2$3$4)\n", prefix, e.first,
+                        deleted ? "D" : "", opened ? "O" : "", pinned ? "P" : "");
     } else {
       ret += Substitute("$0: $1\n", prefix, e.first);
     }
@@ -757,7 +911,7 @@ shared_ptr<internal::Descriptor<FileType>> FileCache::FindDescriptorUnlocked(
     FindMode mode,
     DescriptorMap<FileType>* descs,
     bool* created_desc) {
-  DCHECK(lock_.is_locked());
+  DCHECK(shard(file_name)->lock.is_locked());
 
   shared_ptr<internal::Descriptor<FileType>> d;
   auto it = descs->find(file_name);
@@ -801,9 +955,42 @@ void FileCache::ExpireDescriptorsFromMap(DescriptorMap<FileType>* descs) {
 void FileCache::RunDescriptorExpiry() {
   while (!running_.WaitFor(MonoDelta::FromMilliseconds(
       FLAGS_file_cache_expiry_period_ms))) {
-    std::lock_guard<simple_spinlock> l(lock_);
-    ExpireDescriptorsFromMap(&rwf_descs_);
-    ExpireDescriptorsFromMap(&raf_descs_);
+    for (auto& s : shards_) {
+      std::lock_guard<simple_spinlock> l(s.lock);
+      ExpireDescriptorsFromMap(&s.rwf_descs);
+      ExpireDescriptorsFromMap(&s.raf_descs);
+    }
+  }
+}
+
+FileCache::DescriptorShard* FileCache::shard(const string& file_name) {
+  return &shards_[HashUtil::FastHash64(file_name.data(), file_name.size(), 0) %
+                  kNumDescriptorShards];
+}
+
+const FileCache::DescriptorShard* FileCache::shard(const string& file_name) const {
+  return &shards_[HashUtil::FastHash64(file_name.data(), file_name.size(), 0) %
+                  kNumDescriptorShards];
+}
+
+bool FileCache::TryReservePinnedFile() {
+  int num_pinned = num_pinned_files_.load();
+  do {
+    if (num_pinned >= max_pinned_files_) {
+      return false;
+    }
+  } while (!num_pinned_files_.compare_exchange_weak(num_pinned, num_pinned + 1));
+  if (metrics_) {
+    metrics_->pinned_files->Increment();
+  }
+  return true;
+}
+
+void FileCache::ReleasePinnedFile() {
+  DCHECK_GT(num_pinned_files_.load(), 0);
+  num_pinned_files_--;
+  if (metrics_) {
+    metrics_->pinned_files->Decrement();
   }
 }
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -25,6 +26,7 @@
 #include <gtest/gtest_prod.h>
 
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/cache.h"
 #include "kudu/util/countdown_latch.h"
@@ -43,6 +45,7 @@ class Descriptor;
 
 } // namespace internal
 
+struct FileCacheDescriptorMetrics;
 class MetricEntity;
 class Thread;
 
@@ -81,6 +84,21 @@ class Thread;
 // closed, so it is reopened and reinserted (possibly evicting a different open
 // file) before the file access is performed.
 //
+// Pinned files
+// ------------
+// A file evicted from the LRU cache while in use is reopened on its next
+// access, which costs an open(2) and, with encryption, a read of its header.
+// Files that keep being reopened (e.g. the containers that are the hottest
+// under scans reaching across many tablets) are "pinned": the descriptor keeps
+// its file open itself until it's dropped, bypassing the LRU cache. The pinned
+// files are bounded by --file_cache_max_pinned_files and are accounted for in
+// 'max_open_files', the capacity of the LRU cache being reduced accordingly.
+//
+// Descriptor maps
+// ---------------
+// The descriptor maps are sharded by file name, each shard having its own
+// lock, so that concurrent opens of different files rarely contend.
+//
 // Other notes
 // -----------
 // In a world where files are opened and closed transparently, file deletion
@@ -97,7 +115,7 @@ class FileCache {
   //
   // The 'cache_name' is used to disambiguate amongst other file cache
   // instances. The cache will use 'max_open_files' as a soft upper bound on
-  // the number of files open at any given time.
+  // the number of files open at any given time, pinned files included.
   FileCache(const std::string& cache_name,
             Env* env,
             int max_open_files,
@@ -172,6 +190,9 @@ class FileCache {
   // Only intended for unit tests.
   size_t NumDescriptorsForTests() const;
 
+  // Returns the number of files currently pinned.
+  int num_pinned_files() const { return num_pinned_files_.load(); }
+
   // Dumps the contents of the file cache. Intended for debugging.
   std::string ToDebugString() const;
 
@@ -183,6 +204,24 @@ class FileCache {
   using DescriptorMap = std::unordered_map<std::string,
                                            std::weak_ptr<internal::Descriptor<FileType>>>;
 
+  // The number of shards of the descriptor maps.
+  static constexpr int kNumDescriptorShards = 16;
+
+  // A shard of the descriptor maps, holding the descriptors of the file names
+  // hashing to it.
+  struct DescriptorShard {
+    // Protects the descriptor maps.
+    mutable simple_spinlock lock;
+
+    // Maps filenames to descriptors.
+    DescriptorMap<RWFile> rwf_descs;
+    DescriptorMap<RandomAccessFile> raf_descs;
+  } CACHELINE_ALIGNED;
+
+  // Returns the shard of the descriptors of 'file_name'.
+  DescriptorShard* shard(const std::string& file_name);
+  const DescriptorShard* shard(const std::string& file_name) const;
+
   template <class FileType>
   FRIEND_TEST(FileCacheTest, TestBasicOperations);
 
@@ -200,7 +239,7 @@ class FileCache {
   // The value of 'created_desc' will be set in accordance with whether a new
   // descriptor was created.
   //
-  // Must be called with 'lock_' held.
+  // Must be called with the lock of the shard of 'file_name' held.
   enum class FindMode {
     // Only return an existing descriptor from the map; don't create a new one.
     DONT_CREATE,
@@ -218,6 +257,13 @@ class FileCache {
   // Periodically removes expired descriptors from the descriptor maps.
   void RunDescriptorExpiry();
 
+  // Reserves a slot for a pinned file, returning false if the pinned files
+  // are already at their bound.
+  bool TryReservePinnedFile();
+
+  // Releases a slot reserved with TryReservePinnedFile().
+  void ReleasePinnedFile();
+
   // Actually opens the file as per OpenFile. Used to encapsulate the bulk of
   // OpenFile because C++ prohibits partial specialization of template functions.
   template <class FileType>
@@ -238,15 +284,19 @@ class FileCache {
   // removed from the cache and is no longer in use by any file operations).
   std::unique_ptr<Cache::EvictionCallback> eviction_cb_;
 
+  // The maximum number of pinned files, taken out of 'max_open_files'.
+  const int max_pinned_files_;
+
+  // The number of pinned files.
+  std::atomic<int> num_pinned_files_;
+
   // Underlying cache instance. Caches opened files.
   std::unique_ptr<Cache> cache_;
 
-  // Protects the descriptor map.
-  mutable simple_spinlock lock_;
+  // Not set if the cache was constructed without a metric entity.
+  std::unique_ptr<FileCacheDescriptorMetrics> metrics_;
 
-  // Maps filenames to descriptors.
-  DescriptorMap<RWFile> rwf_descs_;
-  DescriptorMap<RandomAccessFile> raf_descs_;
+  DescriptorShard shards_[kNumDescriptorShards];
 
   // Calls RunDescriptorExpiry() in a loop until 'running_' isn't set.
   scoped_refptr<Thread> descriptor_expiry_thread_;
@@ -58,6 +58,25 @@ METRIC_DEFINE_gauge_uint64(server, file_cache_usage, "File Cache Usage",
                            "Number of entries in the file cache",
                            kudu::MetricLevel::kInfo);
 
+METRIC_DEFINE_counter(server, file_cache_reopens,
+                      "File Cache Reopens", kudu::MetricUnit::kEntries,
+                      "Number of files reopened by the file cache after their "
+                      "file descriptors were evicted",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_histogram(server, file_cache_reopen_latency,
+                        "File Cache Reopen Latency",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Time spent reopening the files whose file descriptors "
+                        "were evicted from the file cache, including reading their "
+                        "encryption headers",
+                        kudu::MetricLevel::kInfo,
+                        60000000LU, 2);
+METRIC_DEFINE_gauge_int64(server, file_cache_pinned_files,
+                          "File Cache Pinned Files", kudu::MetricUnit::kEntries,
+                          "Number of frequently reopened files kept open by the "
+                          "file cache outside of its LRU cache",
+                          kudu::MetricLevel::kInfo);
+
 namespace kudu {
 
 #define MINIT(member, x) member = METRIC_##x.Instantiate(entity)
@@ -72,6 +91,13 @@ FileCacheMetrics::FileCacheMetrics(const scoped_refptr<MetricEntity>& entity) {
   MINIT(cache_misses_caching, file_cache_misses_caching);
   GINIT(cache_usage, file_cache_usage);
 }
+
+FileCacheDescriptorMetrics::FileCacheDescriptorMetrics(
+    const scoped_refptr<MetricEntity>& entity) {
+  MINIT(reopens, file_cache_reopens);
+  MINIT(reopen_latency, file_cache_reopen_latency);
+  GINIT(pinned_files, file_cache_pinned_files);
+}
 #undef MINIT
 #undef GINIT
 
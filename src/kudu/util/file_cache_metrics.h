@@ -17,15 +17,31 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/cache_metrics.h"
 
 namespace kudu {
 
+class Counter;
+class Histogram;
 class MetricEntity;
+template<typename T>
+class AtomicGauge;
 
 struct FileCacheMetrics : public CacheMetrics {
   explicit FileCacheMetrics(const scoped_refptr<MetricEntity>& entity);
 };
 
+// The metrics of the descriptors of a file cache, as opposed to those of its
+// LRU cache above.
+struct FileCacheDescriptorMetrics {
+  explicit FileCacheDescriptorMetrics(const scoped_refptr<MetricEntity>& entity);
+
+  scoped_refptr<Counter> reopens;
+  scoped_refptr<Histogram> reopen_latency;
+  scoped_refptr<AtomicGauge<int64_t>> pinned_files;
+};
+
 } // namespace kudu
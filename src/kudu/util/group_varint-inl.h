@@ -50,9 +50,7 @@
 #include <boost/preprocessor/variadic/elem.hpp>
 #include <glog/logging.h>
 
-#ifndef __linux__
 #include "kudu/gutil/port.h"
-#endif
 #include "kudu/util/faststring.h"
 
 namespace kudu {
@@ -210,6 +208,52 @@ inline const uint8_t *DecodeGroupVarInt32_SSE_Add(
 
 #endif //__aarch64__
 
+// Decode the 'n' group-varint encoded integers at 'src' into 'dst', which
+// must have enough space for 'n' uint32s. This is the inverse of
+// AppendGroupVarInt32Sequence() with a zero frame of reference.
+//
+// The groups which have at least 17 bytes remaining before 'limit' are
+// decoded with a single shuffle and stored straight into 'dst'; only the
+// last few groups take the slow path.
+//
+// Returns a pointer following the last decoded group, or nullptr if the
+// encoded integers run past 'limit'.
+inline const uint8_t *DecodeGroupVarInt32Sequence(
+  const uint8_t *src, const uint8_t *limit, uint32_t *dst, size_t n) {
+
+  DCHECK(SSE_TABLE_INITTED);
+
+  const uint8_t *p = src;
+  size_t rem = n;
+  while (rem >= 4 && PREDICT_TRUE(p + 17 <= limit)) {
+#ifndef __aarch64__
+    uint8_t sel_byte = *p++;
+    __m128i shuffle_mask = _mm_load_si128(
+      reinterpret_cast<const __m128i *>(&SSE_TABLE[sel_byte * 16]));
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_shuffle_epi8(data, shuffle_mask));
+    p += VARINT_SELECTOR_LENGTHS[sel_byte];
+#else
+    p = DecodeGroupVarInt32(p, &dst[0], &dst[1], &dst[2], &dst[3]);
+#endif //__aarch64__
+    dst += 4;
+    rem -= 4;
+  }
+
+  while (rem > 0) {
+    if (PREDICT_FALSE(p >= limit || p + DecodeGroupVarInt32_GetGroupSize(p) > limit)) {
+      return nullptr;
+    }
+    uint32_t ints[4];
+    p = DecodeGroupVarInt32_SlowButSafe(p, &ints[0], &ints[1], &ints[2], &ints[3]);
+    const size_t to_copy = rem < 4 ? rem : 4;
+    memcpy(dst, ints, to_copy * sizeof(uint32_t));
+    dst += to_copy;
+    rem -= to_copy;
+  }
+  return p;
+}
+
 // Append a set of group-varint encoded integers to the given faststring.
 inline void AppendGroupVarInt32(
   faststring *s,
@@ -19,9 +19,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <string>
-#ifdef NDEBUG
 #include <vector>
-#endif
 
 #include "kudu/util/group_varint-inl.h"
 
@@ -138,7 +136,60 @@ TEST(TestGroupVarInt, TestRoundTrip) {
   }
 }
 
+// Round-trip encode/decodes sequences of various lengths, and ensures that
+// the decoding of truncated sequences fails.
+TEST(TestGroupVarInt, TestRoundTripSequence) {
+  for (int n = 0; n < 100; n++) {
+    std::vector<uint32_t> ints(n);
+    for (auto& i : ints) {
+      // Vary the number of bytes per integer.
+      i = random() >> (random() % 32);
+    }
+    faststring buf;
+    AppendGroupVarInt32Sequence(&buf, 0, ints.data(), n);
+    const uint8_t* limit = buf.data() + buf.size();
+
+    std::vector<uint32_t> decoded(n);
+    ASSERT_EQ(limit, DecodeGroupVarInt32Sequence(buf.data(), limit, decoded.data(), n));
+    ASSERT_EQ(ints, decoded);
+
+    if (n > 0) {
+      ASSERT_EQ(nullptr, DecodeGroupVarInt32Sequence(buf.data(), limit - 1, decoded.data(), n));
+    }
+  }
+}
+
 #ifdef NDEBUG
+TEST(TestGroupVarInt, DecodingBenchmark) {
+  int n_ints = 1000000;
+
+  std::vector<uint32_t> ints;
+  ints.reserve(n_ints);
+  for (int i = 0; i < n_ints; i++) {
+    ints.push_back(i);
+  }
+  faststring s;
+  AppendGroupVarInt32Sequence(&s, 0, &ints[0], n_ints);
+  const uint8_t* limit = s.data() + s.size();
+  std::vector<uint32_t> decoded(n_ints);
+
+  LOG_TIMING(INFO, "Benchmark (one group at a time)") {
+    for (int i = 0; i < 100; i++) {
+      const uint8_t* p = s.data();
+      for (int j = 0; j < n_ints; j += 4) {
+        p = DecodeGroupVarInt32_SlowButSafe(
+            p, &decoded[j], &decoded[j + 1], &decoded[j + 2], &decoded[j + 3]);
+      }
+    }
+  }
+  LOG_TIMING(INFO, "Benchmark (sequence)") {
+    for (int i = 0; i < 100; i++) {
+      CHECK(DecodeGroupVarInt32Sequence(s.data(), limit, &decoded[0], n_ints));
+    }
+  }
+  ASSERT_EQ(ints, decoded);
+}
+
 TEST(TestGroupVarInt, EncodingBenchmark) {
   int n_ints = 1000000;
 
@@ -0,0 +1,86 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/hot_key_tracker.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/random.h"
+#include "kudu/util/test_util.h"
+
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+class HotKeyTrackerTest : public KuduTest {};
+
+TEST_F(HotKeyTrackerTest, TestEmpty) {
+  HotKeyTracker tracker(10, 1000);
+  ASSERT_TRUE(tracker.HotKeys().empty());
+  ASSERT_EQ(0, tracker.HottestKeyPermille());
+  ASSERT_EQ(0, tracker.total_count());
+}
+
+// The keys added the most often stand out among many cold keys.
+TEST_F(HotKeyTrackerTest, TestHotKeys) {
+  HotKeyTracker tracker(3, 1000000);
+  Random rng(SeedRandom());
+  for (int i = 0; i < 100000; i++) {
+    const int r = rng.Uniform(100);
+    if (r < 20) {
+      tracker.Add("hot-a");
+    } else if (r < 30) {
+      tracker.Add("hot-b");
+    } else {
+      tracker.Add(Substitute("cold-$0", rng.Uniform(100000)));
+    }
+  }
+  const vector<HotKeyTracker::HotKey> hot_keys = tracker.HotKeys();
+  ASSERT_EQ(3, hot_keys.size());
+  ASSERT_EQ("hot-a", hot_keys[0].key);
+  ASSERT_EQ("hot-b", hot_keys[1].key);
+  ASSERT_GE(hot_keys[0].count, 19000);
+  ASSERT_LE(hot_keys[0].count, 22000);
+  ASSERT_GE(tracker.HottestKeyPermille(), 190);
+  ASSERT_LE(tracker.HottestKeyPermille(), 220);
+  ASSERT_EQ(100000, tracker.total_count());
+}
+
+// The counts decay, so that a key which was hot earlier is overtaken by a
+// key which is hot now.
+TEST_F(HotKeyTrackerTest, TestDecay) {
+  HotKeyTracker tracker(2, 1000);
+  for (int i = 0; i < 1000; i++) {
+    tracker.Add("old");
+  }
+  ASSERT_EQ(500, tracker.total_count());
+  for (int i = 0; i < 1000; i++) {
+    tracker.Add(i % 4 ? "new" : Substitute("cold-$0", i));
+  }
+  const auto hot_keys = tracker.HotKeys();
+  ASSERT_FALSE(hot_keys.empty());
+  ASSERT_EQ("new", hot_keys[0].key);
+}
+
+} // namespace kudu
@@ -0,0 +1,127 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/hot_key_tracker.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+#include <glog/logging.h>
+
+#include "kudu/util/hash_util.h"
+
+using std::vector;
+
+namespace kudu {
+
+HotKeyTracker::HotKeyTracker(int num_hot_keys, uint64_t window, int depth, int width)
+    : num_hot_keys_(num_hot_keys),
+      window_(window),
+      depth_(depth),
+      width_(width),
+      counters_(depth * width, 0) {
+  CHECK_GT(num_hot_keys, 0);
+  CHECK_GT(window, 0);
+  CHECK_GT(depth, 0);
+  CHECK_GT(width, 0);
+  hot_keys_.reserve(num_hot_keys);
+}
+
+void HotKeyTracker::Add(Slice key) {
+  // The rows are indexed by h1 + i * h2, which is as good as independent
+  // hashes for a count-min sketch.
+  const uint64_t hash = HashUtil::FastHash64(key.data(), key.size(), 0);
+  const uint32_t h1 = hash;
+  const uint32_t h2 = (hash >> 32) | 1;
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  uint32_t estimate = std::numeric_limits<uint32_t>::max();
+  for (int i = 0; i < depth_; i++) {
+    uint32_t& counter = counters_[i * width_ + (h1 + i * h2) % width_];
+    if (counter < std::numeric_limits<uint32_t>::max()) {
+      counter++;
+    }
+    estimate = std::min(estimate, counter);
+  }
+  total_count_++;
+
+  auto it = std::find_if(hot_keys_.begin(), hot_keys_.end(),
+                         [&](const HotKey& k) { return Slice(k.key) == key; });
+  if (it != hot_keys_.end()) {
+    it->count = estimate;
+  } else if (hot_keys_.size() < num_hot_keys_) {
+    hot_keys_.push_back({ key.ToString(), estimate });
+  } else {
+    auto coldest = std::min_element(hot_keys_.begin(), hot_keys_.end(),
+                                    [](const HotKey& a, const HotKey& b) {
+                                      return a.count < b.count;
+                                    });
+    if (coldest->count < estimate) {
+      *coldest = { key.ToString(), estimate };
+    }
+  }
+
+  if (++added_since_decay_ >= window_) {
+    DecayUnlocked();
+  }
+}
+
+void HotKeyTracker::DecayUnlocked() {
+  for (auto& counter : counters_) {
+    counter >>= 1;
+  }
+  for (auto& k : hot_keys_) {
+    k.count >>= 1;
+  }
+  hot_keys_.erase(std::remove_if(hot_keys_.begin(), hot_keys_.end(),
+                                 [](const HotKey& k) { return k.count == 0; }),
+                  hot_keys_.end());
+  total_count_ >>= 1;
+  added_since_decay_ = 0;
+}
+
+vector<HotKeyTracker::HotKey> HotKeyTracker::HotKeys() const {
+  vector<HotKey> hot_keys;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    hot_keys = hot_keys_;
+  }
+  std::sort(hot_keys.begin(), hot_keys.end(), [](const HotKey& a, const HotKey& b) {
+    return a.count > b.count || (a.count == b.count && a.key < b.key);
+  });
+  return hot_keys;
+}
+
+uint64_t HotKeyTracker::HottestKeyPermille() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (total_count_ == 0) {
+    return 0;
+  }
+  uint64_t hottest = 0;
+  for (const auto& k : hot_keys_) {
+    hottest = std::max(hottest, k.count);
+  }
+  return std::min<uint64_t>(1000, hottest * 1000 / total_count_);
+}
+
+uint64_t HotKeyTracker::total_count() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return total_count_;
+}
+
+} // namespace kudu
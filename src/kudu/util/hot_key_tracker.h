@@ -0,0 +1,88 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/slice.h"
+
+namespace kudu {
+
+// Tracks the keys which are added the most often, e.g. the keys of the row
+// operations of a tablet, using a bounded amount of memory.
+//
+// The counts of the keys are estimated by a count-min sketch: 'depth' rows of
+// 'width' counters, each row indexed by a different hash of the key. A key's
+// count is the minimum of its counters, which overestimates it only by the
+// counts of the keys colliding with it in every row. The keys with the
+// highest estimates are kept along with them.
+//
+// Once 'window' keys are added, all the counts are halved, so that the
+// tracker reflects the recent load rather than its whole history.
+//
+// This class is thread-safe.
+class HotKeyTracker {
+ public:
+  struct HotKey {
+    std::string key;
+    // The estimated number of times the key was added, with decay.
+    uint64_t count;
+  };
+
+  HotKeyTracker(int num_hot_keys, uint64_t window, int depth = 4, int width = 1024);
+
+  // Adds an occurrence of 'key'.
+  void Add(Slice key);
+
+  // Returns the hottest keys, the hottest first.
+  std::vector<HotKey> HotKeys() const;
+
+  // Returns the count of the hottest key, in parts per thousand of the count
+  // of all the keys, or 0 if no key was added.
+  uint64_t HottestKeyPermille() const;
+
+  // Returns the number of times keys were added, with decay.
+  uint64_t total_count() const;
+
+ private:
+  // Halves all the counts.
+  void DecayUnlocked();
+
+  const int num_hot_keys_;
+  const uint64_t window_;
+  const int depth_;
+  const int width_;
+
+  mutable simple_spinlock lock_;
+
+  // 'depth_' rows of 'width_' counters.
+  std::vector<uint32_t> counters_;
+
+  // The hottest keys, unordered, at most 'num_hot_keys_' of them.
+  std::vector<HotKey> hot_keys_;
+
+  uint64_t total_count_ = 0;
+  uint64_t added_since_decay_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(HotKeyTracker);
+};
+
+} // namespace kudu
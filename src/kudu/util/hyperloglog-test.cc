@@ -0,0 +1,70 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/hyperloglog.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include <gtest/gtest.h>
+
+#include "kudu/util/hash_util.h"
+#include "kudu/util/test_util.h"
+
+namespace kudu {
+
+class HyperLogLogTest : public KuduTest {
+ protected:
+  static void AddValues(uint64_t first, uint64_t count, HyperLogLog* hll) {
+    for (uint64_t v = first; v < first + count; v++) {
+      hll->AddHash(HashUtil::FastHash64(&v, sizeof(v), 0));
+    }
+  }
+};
+
+TEST_F(HyperLogLogTest, TestEmpty) {
+  HyperLogLog hll;
+  ASSERT_EQ(0, hll.Estimate());
+}
+
+TEST_F(HyperLogLogTest, TestEstimates) {
+  for (uint64_t num_distinct : { 10, 100, 1000, 10000, 100000, 1000000 }) {
+    SCOPED_TRACE(num_distinct);
+    HyperLogLog hll;
+    // Adding the values again doesn't change the estimate.
+    AddValues(0, num_distinct, &hll);
+    AddValues(0, num_distinct, &hll);
+    // Allow for about three standard errors, or a collision of two of the
+    // smallest sets' values.
+    const int64_t error = static_cast<int64_t>(hll.Estimate()) - num_distinct;
+    ASSERT_LE(std::llabs(error), std::max<int64_t>(1, num_distinct * 5 / 100))
+        << hll.Estimate();
+  }
+}
+
+TEST_F(HyperLogLogTest, TestMerge) {
+  HyperLogLog a;
+  HyperLogLog b;
+  AddValues(0, 60000, &a);
+  AddValues(40000, 60000, &b);
+  a.Merge(b);
+  const int64_t error = static_cast<int64_t>(a.Estimate()) - 100000;
+  ASSERT_LE(std::llabs(error), 5000) << a.Estimate();
+}
+
+} // namespace kudu
@@ -0,0 +1,68 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/hyperloglog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <glog/logging.h>
+
+namespace kudu {
+
+HyperLogLog::HyperLogLog(int precision)
+    : precision_(precision),
+      registers_(1ULL << precision, 0) {
+  CHECK_GE(precision, 4);
+  CHECK_LE(precision, 18);
+}
+
+void HyperLogLog::Merge(const HyperLogLog& other) {
+  CHECK_EQ(precision_, other.precision_);
+  for (size_t i = 0; i < registers_.size(); i++) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+}
+
+uint64_t HyperLogLog::Estimate() const {
+  const double m = static_cast<double>(registers_.size());
+  double sum = 0;
+  size_t num_zeros = 0;
+  for (uint8_t reg : registers_) {
+    sum += std::ldexp(1.0, -reg);
+    if (reg == 0) {
+      num_zeros++;
+    }
+  }
+  double alpha;
+  switch (registers_.size()) {
+    case 16: alpha = 0.673; break;
+    case 32: alpha = 0.697; break;
+    case 64: alpha = 0.709; break;
+    default: alpha = 0.7213 / (1 + 1.079 / m); break;
+  }
+  double estimate = alpha * m * m / sum;
+  if (estimate <= 2.5 * m && num_zeros > 0) {
+    // Linear counting. There's no need for a large range correction: with
+    // 64-bit hashes, collisions are negligible at any realistic cardinality.
+    estimate = m * std::log(m / static_cast<double>(num_zeros));
+  }
+  return static_cast<uint64_t>(std::llround(estimate));
+}
+
+} // namespace kudu
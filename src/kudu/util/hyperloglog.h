@@ -0,0 +1,69 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace kudu {
+
+// A HyperLogLog sketch, estimating the number of distinct 64-bit hashes
+// added to it (see "HyperLogLog: the analysis of a near-optimal cardinality
+// estimation algorithm", Flajolet et al.).
+//
+// The sketch is made of 2^precision one-byte registers, and the standard
+// error of its estimates is about 1.04 / sqrt(2^precision): 1.6% with the
+// default precision of 12. Small cardinalities are estimated by linear
+// counting, which is much more accurate.
+//
+// This class is not thread-safe.
+class HyperLogLog {
+ public:
+  // REQUIRES: 4 <= precision <= 18.
+  explicit HyperLogLog(int precision = 12);
+
+  // Adds a hash to the sketch. The hashes must be uniformly distributed:
+  // values should be hashed with e.g. HashUtil::FastHash64().
+  void AddHash(uint64_t hash) {
+    const uint32_t idx = hash >> (64 - precision_);
+    // The rank of the hash is the position of the leftmost 1 bit among the
+    // remaining bits. A sentinel bit bounds it when they're all zeros.
+    const uint64_t rest = (hash << precision_) | (1ULL << (precision_ - 1));
+    const uint8_t rank = __builtin_clzll(rest) + 1;
+    if (rank > registers_[idx]) {
+      registers_[idx] = rank;
+    }
+  }
+
+  // Merges 'other' into this sketch, which then estimates the number of
+  // distinct hashes added to either of them.
+  //
+  // REQUIRES: 'other' has the same precision.
+  void Merge(const HyperLogLog& other);
+
+  // Returns the estimated number of distinct hashes added to the sketch.
+  uint64_t Estimate() const;
+
+  int precision() const { return precision_; }
+
+ private:
+  const int precision_;
+  std::vector<uint8_t> registers_;
+};
+
+} // namespace kudu
@@ -0,0 +1,293 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/io_uring.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define KUDU_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/util/errno.h"
+#include "kudu/util/logging.h"
+
+using std::unique_ptr;
+
+namespace kudu {
+
+#if defined(KUDU_HAVE_IO_URING)
+
+namespace {
+
+// The number of submission queue entries of each ring. Batches larger than
+// this are submitted in several rounds.
+constexpr unsigned kQueueDepth = 64;
+
+int SysIoUringSetup(unsigned entries, struct io_uring_params* p) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int SysIoUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                                  nullptr, 0));
+}
+
+// 'p' points into a ring shared with the kernel: the head and tail indexes
+// must be accessed with acquire and release semantics.
+inline unsigned LoadAcquire(const unsigned* p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+inline void StoreRelease(unsigned* p, unsigned v) {
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+T* RingPtr(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+} // anonymous namespace
+
+IoUring::IoUring()
+    : ring_fd_(-1),
+      sq_ring_(MAP_FAILED),
+      sq_ring_size_(0),
+      cq_ring_(MAP_FAILED),
+      cq_ring_size_(0),
+      sqes_(MAP_FAILED),
+      sqes_size_(0),
+      sq_entries_(0),
+      sq_tail_(nullptr),
+      sq_ring_mask_(0),
+      sq_array_(nullptr),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cq_ring_mask_(0),
+      cqes_(nullptr) {
+}
+
+IoUring::~IoUring() {
+  if (sqes_ != MAP_FAILED) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != MAP_FAILED) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+Status IoUring::Init(unsigned entries) {
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  ring_fd_ = SysIoUringSetup(entries, &p);
+  if (ring_fd_ < 0) {
+    return Status::IOError("io_uring_setup() failed", ErrnoToString(errno), errno);
+  }
+
+  sq_ring_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    return Status::IOError("unable to map the io_uring submission ring",
+                           ErrnoToString(errno), errno);
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return Status::IOError("unable to map the io_uring completion ring",
+                             ErrnoToString(errno), errno);
+    }
+  }
+  sqes_size_ = p.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    return Status::IOError("unable to map the io_uring submission entries",
+                           ErrnoToString(errno), errno);
+  }
+
+  sq_entries_ = p.sq_entries;
+  sq_tail_ = RingPtr<unsigned>(sq_ring_, p.sq_off.tail);
+  sq_ring_mask_ = *RingPtr<unsigned>(sq_ring_, p.sq_off.ring_mask);
+  sq_array_ = RingPtr<unsigned>(sq_ring_, p.sq_off.array);
+  cq_head_ = RingPtr<unsigned>(cq_ring_, p.cq_off.head);
+  cq_tail_ = RingPtr<unsigned>(cq_ring_, p.cq_off.tail);
+  cq_ring_mask_ = *RingPtr<unsigned>(cq_ring_, p.cq_off.ring_mask);
+  cqes_ = RingPtr<void>(cq_ring_, p.cq_off.cqes);
+  return Status::OK();
+}
+
+IoUring* IoUring::ForThisThread() {
+  static thread_local unique_ptr<IoUring> ring;
+  static thread_local bool init_failed = false;
+  if (!ring && !init_failed) {
+    unique_ptr<IoUring> r(new IoUring());
+    Status s = r->Init(kQueueDepth);
+    if (s.ok()) {
+      ring = std::move(r);
+    } else {
+      init_failed = true;
+      KLOG_FIRST_N(WARNING, 1) << "io_uring is not available, falling back to preadv(): "
+                               << s.ToString();
+    }
+  }
+  return ring.get();
+}
+
+Status IoUring::SubmitAndWait(ArrayView<ReadOp> ops) {
+  for (size_t start = 0; start < ops.size(); start += sq_entries_) {
+    size_t n = std::min<size_t>(sq_entries_, ops.size() - start);
+    RETURN_NOT_OK(SubmitAndWaitChunk(ArrayView<ReadOp>(ops.data() + start, n)));
+  }
+  return Status::OK();
+}
+
+Status IoUring::SubmitAndWaitChunk(ArrayView<ReadOp> ops) {
+  DCHECK_LE(ops.size(), sq_entries_);
+  auto* sqes = static_cast<struct io_uring_sqe*>(sqes_);
+  auto* cqes = static_cast<const struct io_uring_cqe*>(cqes_);
+
+  // Only this thread produces submissions, and the previous ones have all
+  // been consumed by the kernel: the whole submission ring is available.
+  unsigned tail = *sq_tail_;
+  for (size_t i = 0; i < ops.size(); i++) {
+    const ReadOp& op = ops[i];
+    unsigned idx = tail & sq_ring_mask_;
+    struct io_uring_sqe* sqe = &sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = op.fd;
+    sqe->off = op.offset;
+    sqe->addr = reinterpret_cast<uint64_t>(op.iov);
+    sqe->len = op.iov_count;
+    sqe->user_data = i;
+    sq_array_[idx] = idx;
+    tail++;
+  }
+  StoreRelease(sq_tail_, tail);
+
+  Status s;
+  unsigned to_submit = ops.size();
+  unsigned in_flight = 0;
+  while (to_submit > 0 || in_flight > 0) {
+    // Once everything is submitted, block until all of it completes.
+    unsigned min_complete = to_submit == 0 ? in_flight : 0;
+    int ret = SysIoUringEnter(ring_fd_, to_submit, min_complete,
+                              min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (ret < 0) {
+      int err = errno;
+      if (err != EINTR) {
+        if (to_submit == 0) {
+          // The buffers of the in-flight reads can't be handed back to the
+          // caller while the kernel may still write to them.
+          LOG(FATAL) << "unable to wait for in-flight io_uring reads: " << ErrnoToString(err);
+        }
+        // Take back the entries the kernel didn't consume so that they aren't
+        // submitted along with the next batch, and wait for the others.
+        tail -= to_submit;
+        StoreRelease(sq_tail_, tail);
+        to_submit = 0;
+        s = Status::IOError("io_uring_enter() failed", ErrnoToString(err), err);
+      }
+    } else {
+      DCHECK_LE(static_cast<unsigned>(ret), to_submit);
+      to_submit -= ret;
+      in_flight += ret;
+    }
+
+    unsigned head = *cq_head_;
+    const unsigned cq_tail = LoadAcquire(cq_tail_);
+    for (; head != cq_tail; head++) {
+      const struct io_uring_cqe& cqe = cqes[head & cq_ring_mask_];
+      DCHECK_LT(cqe.user_data, ops.size());
+      ops[cqe.user_data].result = cqe.res;
+      in_flight--;
+    }
+    StoreRelease(cq_head_, head);
+  }
+  return s;
+}
+
+#else
+
+IoUring::IoUring()
+    : ring_fd_(-1),
+      sq_ring_(nullptr),
+      sq_ring_size_(0),
+      cq_ring_(nullptr),
+      cq_ring_size_(0),
+      sqes_(nullptr),
+      sqes_size_(0),
+      sq_entries_(0),
+      sq_tail_(nullptr),
+      sq_ring_mask_(0),
+      sq_array_(nullptr),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cq_ring_mask_(0),
+      cqes_(nullptr) {
+}
+
+IoUring::~IoUring() {
+}
+
+IoUring* IoUring::ForThisThread() {
+  return nullptr;
+}
+
+Status IoUring::Init(unsigned /* entries */) {
+  return Status::NotSupported("io_uring is not supported on this platform");
+}
+
+Status IoUring::SubmitAndWait(ArrayView<ReadOp> /* ops */) {
+  return Status::NotSupported("io_uring is not supported on this platform");
+}
+
+Status IoUring::SubmitAndWaitChunk(ArrayView<ReadOp> /* ops */) {
+  return Status::NotSupported("io_uring is not supported on this platform");
+}
+
+#endif // #if defined(KUDU_HAVE_IO_URING)
+
+} // namespace kudu
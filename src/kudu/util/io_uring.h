@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/array_view.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+// A minimal wrapper around a Linux io_uring instance, used to hand batches of
+// reads to the kernel at once so that they're serviced concurrently by the
+// device, rather than one after the other as with preadv().
+//
+// The ring is driven through the raw system calls rather than liburing, and
+// only supports what the Env needs: vectored reads, submitted and waited upon
+// as a batch.
+//
+// Instances are not thread-safe: each thread uses its own ring, returned by
+// ForThisThread().
+class IoUring {
+ public:
+  // A vectored read of 'iov_count' buffers at 'iov' from 'fd', starting at
+  // 'offset'.
+  struct ReadOp {
+    int fd;
+    uint64_t offset;
+    const struct iovec* iov;
+    int iov_count;
+
+    // Set by SubmitAndWait(): the number of bytes read, or a negated errno.
+    int64_t result;
+  };
+
+  ~IoUring();
+
+  // Returns the ring of the calling thread, creating it on first use.
+  // Returns nullptr if io_uring isn't supported by the platform or the kernel.
+  static IoUring* ForThisThread();
+
+  // Submits all of 'ops' and waits until they have all completed, setting
+  // their 'result'. The errors of the individual reads are only reported in
+  // their 'result': a non-OK status means that the ring itself failed, and
+  // that the results of the ops are undefined.
+  Status SubmitAndWait(ArrayView<ReadOp> ops);
+
+ private:
+  IoUring();
+
+  // Sets up the ring with room for 'entries' submissions.
+  Status Init(unsigned entries);
+
+  // Submits and waits for up to 'sq_entries_' ops.
+  Status SubmitAndWaitChunk(ArrayView<ReadOp> ops);
+
+  int ring_fd_;
+
+  // The mappings of the submission and completion rings, and of the array of
+  // submission queue entries.
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  void* sqes_;
+  size_t sqes_size_;
+  unsigned sq_entries_;
+
+  // Pointers into the mapped rings.
+  unsigned* sq_tail_;
+  unsigned sq_ring_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  const unsigned* cq_tail_;
+  unsigned cq_ring_mask_;
+  void* cqes_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUring);
+};
+
+} // namespace kudu
@@ -45,6 +45,7 @@
 #include "kudu/util/maintenance_manager_metrics.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
 #include "kudu/util/scoped_cleanup.h"
@@ -80,6 +81,7 @@ DECLARE_double(run_non_memory_ops_prob);
 DECLARE_double(data_gc_prioritization_prob);
 DECLARE_int32(memory_pressure_percentage);
 DECLARE_int32(memory_limit_soft_percentage);
+DECLARE_int32(maintenance_manager_max_ops_per_data_dir);
 namespace kudu {
 
 // Set this a bit bigger so that the manager could keep track of all possible completed ops.
@@ -242,6 +244,16 @@ class TestMaintenanceOp : public MaintenanceOp {
     return priority_;
   }
 
+  vector<string> DataDirs() const override {
+    std::lock_guard<simple_spinlock> guard(lock_);
+    return data_dirs_;
+  }
+
+  void set_data_dirs(vector<string> data_dirs) {
+    std::lock_guard<simple_spinlock> guard(lock_);
+    data_dirs_ = std::move(data_dirs);
+  }
+
   int remaining_runs() const {
     std::lock_guard<simple_spinlock> guard(lock_);
     return remaining_runs_;
@@ -319,6 +331,8 @@ class TestMaintenanceOp : public MaintenanceOp {
   bool updated_;
   // Whether re-register itself after performing.
   bool register_self_;
+  // The data directories returned by DataDirs().
+  vector<string> data_dirs_;
 };
 
 class MaintenanceManagerTest : public KuduTest {
@@ -634,6 +648,27 @@ TEST_F(MaintenanceManagerTest, TestRunningInstances) {
   ASSERT_EQ(status_pb.running_operations_size(), 0);
 }
 
+// The threads reserved on behalf of a running op aren't used to schedule other
+// ops until they're released.
+TEST_F(MaintenanceManagerTest, TestAcquireExtraThreads) {
+  ASSERT_EQ(2, manager_->AcquireExtraThreads(3));
+  ASSERT_EQ(0, manager_->AcquireExtraThreads(1));
+
+  TestMaintenanceOp op("op", MaintenanceOp::HIGH_IO_USAGE);
+  op.set_perf_improvement(10);
+  manager_->RegisterOp(&op);
+  SleepFor(MonoDelta::FromMilliseconds(100));
+  ASSERT_EQ(1, op.remaining_runs());
+
+  manager_->ReleaseExtraThreads(2);
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(0, op.remaining_runs());
+  });
+  manager_->UnregisterOp(&op);
+  ASSERT_EQ(1, manager_->AcquireExtraThreads(1));
+  manager_->ReleaseExtraThreads(1);
+}
+
 // Test adding operations and make sure that the history of recently completed
 // operations is correct in that it wraps around and doesn't grow.
 TEST_F(MaintenanceManagerTest, TestCompletedOpsHistory) {
@@ -886,6 +921,65 @@ TEST_F(MaintenanceManagerTest, VerifyMetrics) {
 // This test scenario verifies that maintenance manager is able to process
 // operations with high enough level of concurrency, even if their UpdateStats()
 // method is computationally heavy.
+// Verify that the high IO ops using a data directory which runs as many ops as
+// allowed by --maintenance_manager_max_ops_per_data_dir are passed over in
+// favor of the ops using other directories.
+TEST_F(MaintenanceManagerTest, TestMaxOpsPerDataDir) {
+  FLAGS_maintenance_manager_max_ops_per_data_dir = 1;
+  StopManager();
+  StartManager(3);
+
+  TestMaintenanceOp op_a0("a0", MaintenanceOp::HIGH_IO_USAGE);
+  op_a0.set_perf_improvement(30);
+  op_a0.set_data_dirs({ "/data/a" });
+  op_a0.set_sleep_time(MonoDelta::FromSeconds(2));
+  TestMaintenanceOp op_a1("a1", MaintenanceOp::HIGH_IO_USAGE);
+  op_a1.set_perf_improvement(20);
+  op_a1.set_data_dirs({ "/data/a", "/data/b" });
+  TestMaintenanceOp op_b("b", MaintenanceOp::HIGH_IO_USAGE);
+  op_b.set_perf_improvement(10);
+  op_b.set_data_dirs({ "/data/b" });
+  // Low IO ops aren't limited.
+  TestMaintenanceOp op_low("low", MaintenanceOp::LOW_IO_USAGE);
+  op_low.set_perf_improvement(5);
+  op_low.set_data_dirs({ "/data/a" });
+
+  // The op with the best score runs first, in "/data/a".
+  manager_->RegisterOp(&op_a0);
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(1, op_a0.running());
+  });
+  manager_->RegisterOp(&op_a1);
+  manager_->RegisterOp(&op_b);
+  manager_->RegisterOp(&op_low);
+  SCOPED_CLEANUP({
+    manager_->UnregisterOp(&op_low);
+    manager_->UnregisterOp(&op_b);
+    manager_->UnregisterOp(&op_a1);
+    manager_->UnregisterOp(&op_a0);
+  });
+
+  // The ops which don't use "/data/a" run even though 'op_a1' scores better.
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(1, op_b.run_count());
+    ASSERT_EQ(1, op_low.run_count());
+  });
+  ASSERT_EQ(1, op_a0.running());
+  ASSERT_EQ(0, op_a1.run_count());
+  ASSERT_EQ(1, op_a1.remaining_runs());
+
+  // Once "/data/a" is free, 'op_a1' runs.
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(1, op_a1.run_count());
+  });
+  ASSERT_EQ(1, op_a0.run_count());
+
+  ASSERT_EVENTUALLY([&]() {
+    std::lock_guard<Mutex> guard(manager_->running_instances_lock_);
+    ASSERT_TRUE(manager_->running_ops_by_data_dir_.empty());
+  });
+}
+
 TEST_F(MaintenanceManagerTest, ManyOperationsHeavyUpdateStats) {
   SKIP_IF_SLOW_NOT_ALLOWED();
 
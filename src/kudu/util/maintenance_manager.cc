@@ -26,6 +26,7 @@
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -38,6 +39,7 @@
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/cpu_profiler.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/debug/trace_logging.h"
 #include "kudu/util/flag_tags.h"
@@ -55,6 +57,7 @@
 
 using std::pair;
 using std::string;
+using std::unordered_map;
 using std::vector;
 using strings::Split;
 using strings::Substitute;
@@ -67,6 +70,20 @@ TAG_FLAG(maintenance_manager_num_threads, stable);
 DEFINE_validator(maintenance_manager_num_threads,
                  [](const char* /*n*/, int32 v) { return v > 0; });
 
+DEFINE_int32(maintenance_manager_max_ops_per_data_dir, 0,
+             "Maximum number of high IO maintenance operations to run at a time "
+             "in each data directory, e.g. flushes and compactions of the tablets "
+             "whose data dir groups include the directory. When a directory runs "
+             "as many operations, the operations using it are passed over in favor "
+             "of operations using other directories, so that the threads of the "
+             "maintenance manager aren't all busy on the same disks. "
+             "If 0, the number of operations per data directory isn't limited.");
+TAG_FLAG(maintenance_manager_max_ops_per_data_dir, advanced);
+TAG_FLAG(maintenance_manager_max_ops_per_data_dir, experimental);
+TAG_FLAG(maintenance_manager_max_ops_per_data_dir, runtime);
+DEFINE_validator(maintenance_manager_max_ops_per_data_dir,
+                 [](const char* /*n*/, int32 v) { return v >= 0; });
+
 DEFINE_int32(maintenance_manager_polling_interval_ms, 250,
              "Polling interval for the maintenance manager scheduler, "
              "in milliseconds.");
@@ -181,6 +198,17 @@ void MaintenanceOp::Unregister() {
   manager_->UnregisterOp(this);
 }
 
+int32_t MaintenanceOp::AcquireExtraThreads(int32_t max_threads) {
+  // 'manager_' is only reset once the running instances are done.
+  return manager_ ? manager_->AcquireExtraThreads(max_threads) : 0;
+}
+
+void MaintenanceOp::ReleaseExtraThreads(int32_t num_threads) {
+  if (manager_) {
+    manager_->ReleaseExtraThreads(num_threads);
+  }
+}
+
 MaintenanceManagerStatusPB_OpInstancePB OpInstance::DumpToPB() const {
   MaintenanceManagerStatusPB_OpInstancePB pb;
   pb.set_thread_id(thread_id);
@@ -350,6 +378,7 @@ void MaintenanceManager::RunSchedulerThread() {
     }
     MaintenanceOp* op = nullptr;
     string op_note;
+    vector<string> op_data_dirs;
     {
       std::lock_guard<Mutex> guard(lock_);
       // Upon each iteration, we should have dropped and reacquired 'lock_'.
@@ -385,6 +414,9 @@ void MaintenanceManager::RunSchedulerThread() {
         op_note = std::move(best_op_and_why.second);
       }
       if (op) {
+        // The op can't be destroyed while 'lock_' is held, since it's still
+        // in 'ops_'.
+        op_data_dirs = LimitedDataDirs(op);
         // While 'running_instances_lock_' is held, check one more time for
         // whether the op is cancelled. This ensures that we don't attempt to
         // launch an op that has been destructed in UnregisterOp(). See
@@ -395,7 +427,7 @@ void MaintenanceManager::RunSchedulerThread() {
               << "picked maintenance operation that has been cancelled";
           continue;
         }
-        IncreaseOpCount(op);
+        IncreaseOpCount(op, op_data_dirs);
         prev_iter_found_no_work = false;
       } else {
         VLOG_AND_TRACE_WITH_PREFIX("maintenance", 2)
@@ -412,14 +444,16 @@ void MaintenanceManager::RunSchedulerThread() {
                             << ". Re-running scheduler.";
       metrics_.SubmitOpPrepareFailed();
       std::lock_guard<Mutex> guard(running_instances_lock_);
-      DecreaseOpCountAndNotifyWaiters(op);
+      DecreaseOpCountAndNotifyWaiters(op, op_data_dirs);
       continue;
     }
 
     LOG_AND_TRACE_WITH_PREFIX("maintenance", INFO)
         << Substitute("Scheduling $0: $1", op->name(), op_note);
     // Submit the maintenance operation to be run on the "MaintenanceMgr" pool.
-    CHECK_OK(thread_pool_->Submit([this, op]() { this->LaunchOp(op); }));
+    CHECK_OK(thread_pool_->Submit([this, op, data_dirs = std::move(op_data_dirs)]() {
+      this->LaunchOp(op, data_dirs);
+    }));
   }
 }
 
@@ -437,6 +471,9 @@ void MaintenanceManager::RunSchedulerThread() {
 // - Finally, if there's nothing else that we really need to do, we run the Op
 //   that will improve performance the most.
 //
+// High IO ops using a data directory which already runs as many ops as
+// allowed by --maintenance_manager_max_ops_per_data_dir aren't considered.
+//
 // In general, we want to prioritize limiting the amount of expensive resources
 // we hold onto. Low IO ops that free WAL disk space are preferred, followed by
 // ops that free memory, then ops that free data disk space, then ops that
@@ -466,6 +503,13 @@ pair<MaintenanceOp*, string> MaintenanceManager::FindBestOp() {
 
   double best_perf_improvement = 0;
   MaintenanceOp* best_perf_improvement_op = nullptr;
+
+  const bool limit_ops_per_data_dir = FLAGS_maintenance_manager_max_ops_per_data_dir > 0;
+  unordered_map<string, int32_t> running_ops_by_data_dir;
+  if (limit_ops_per_data_dir) {
+    std::lock_guard<Mutex> guard(running_instances_lock_);
+    running_ops_by_data_dir = running_ops_by_data_dir_;
+  }
   for (auto& val : ops_) {
     MaintenanceOp* op(val.first);
     MaintenanceOpStats& stats(val.second);
@@ -476,6 +520,12 @@ pair<MaintenanceOp*, string> MaintenanceManager::FindBestOp() {
     if (op->cancelled() || !stats.valid() || !stats.runnable()) {
       continue;
     }
+    if (limit_ops_per_data_dir && !running_ops_by_data_dir.empty() &&
+        AnyDataDirBusy(LimitedDataDirs(op), running_ops_by_data_dir)) {
+      VLOG_AND_TRACE_WITH_PREFIX("maintenance", 2)
+          << Substitute("Op $0 uses a busy data directory", op->name());
+      continue;
+    }
 
     const auto logs_retained_bytes = stats.logs_retained_bytes();
     if (op->io_usage() == MaintenanceOp::LOW_IO_USAGE &&
@@ -591,7 +641,7 @@ double MaintenanceManager::AdjustedPerfScore(double perf_improvement,
   return perf_score * std::pow(FLAGS_maintenance_op_multiplier, priority);
 }
 
-void MaintenanceManager::LaunchOp(MaintenanceOp* op) {
+void MaintenanceManager::LaunchOp(MaintenanceOp* op, const vector<string>& data_dirs) {
   const auto thread_id = Thread::CurrentThreadId();
   OpInstance op_instance;
   op_instance.thread_id = thread_id;
@@ -617,7 +667,7 @@ void MaintenanceManager::LaunchOp(MaintenanceOp* op) {
       op_instance.duration = now - op_instance.start_mono_time;
       op->DurationHistogram()->Increment(op_instance.duration.ToMilliseconds());
 
-      DecreaseOpCountAndNotifyWaiters(op);
+      DecreaseOpCountAndNotifyWaiters(op, data_dirs);
     }
     cond_.Signal(); // wake up the scheduler
 
@@ -637,6 +687,7 @@ void MaintenanceManager::LaunchOp(MaintenanceOp* op) {
     ADOPT_TRACE(trace.get());
     TRACE_EVENT1("maintenance", "MaintenanceManager::LaunchOp",
                  "name", op->name());
+    SCOPED_CPU_PROFILE_TAG(op->name());
     op->Perform();
     sw.stop();
   }
@@ -702,6 +753,25 @@ string MaintenanceManager::LogPrefix() const {
   return Substitute("P $0: ", server_uuid_);
 }
 
+int32_t MaintenanceManager::AcquireExtraThreads(int32_t max_threads) {
+  std::lock_guard<Mutex> lock(running_instances_lock_);
+  const int32_t num_threads = std::max(0, std::min(max_threads, num_threads_ - running_ops_));
+  running_ops_ += num_threads;
+  return num_threads;
+}
+
+void MaintenanceManager::ReleaseExtraThreads(int32_t num_threads) {
+  if (num_threads == 0) {
+    return;
+  }
+  {
+    std::lock_guard<Mutex> lock(running_instances_lock_);
+    running_ops_ -= num_threads;
+    DCHECK_GE(running_ops_, 0);
+  }
+  cond_.Signal(); // wake up the scheduler
+}
+
 bool MaintenanceManager::HasFreeThreads() {
   return num_threads_ > running_ops_;
 }
@@ -711,16 +781,46 @@ bool MaintenanceManager::CouldNotLaunchNewOp(bool prev_iter_found_no_work) {
   return (!HasFreeThreads() || prev_iter_found_no_work || disabled_for_tests()) && !shutdown_;
 }
 
-void MaintenanceManager::IncreaseOpCount(MaintenanceOp* op) {
+vector<string> MaintenanceManager::LimitedDataDirs(const MaintenanceOp* op) {
+  // Low IO ops barely use the data directories.
+  if (op->io_usage() == MaintenanceOp::LOW_IO_USAGE) {
+    return {};
+  }
+  return op->DataDirs();
+}
+
+bool MaintenanceManager::AnyDataDirBusy(
+    const vector<string>& data_dirs,
+    const unordered_map<string, int32_t>& running_ops_by_data_dir) {
+  const int32_t max_ops = FLAGS_maintenance_manager_max_ops_per_data_dir;
+  return std::any_of(data_dirs.begin(), data_dirs.end(), [&](const string& dir) {
+    const int32_t* running_ops = FindOrNull(running_ops_by_data_dir, dir);
+    return running_ops && *running_ops >= max_ops;
+  });
+}
+
+void MaintenanceManager::IncreaseOpCount(MaintenanceOp* op,
+                                         const vector<string>& data_dirs) {
   running_instances_lock_.AssertAcquired();
   ++running_ops_;
   ++op->running_;
+  for (const auto& dir : data_dirs) {
+    ++running_ops_by_data_dir_[dir];
+  }
 }
 
-void MaintenanceManager::DecreaseOpCountAndNotifyWaiters(MaintenanceOp* op) {
+void MaintenanceManager::DecreaseOpCountAndNotifyWaiters(MaintenanceOp* op,
+                                                         const vector<string>& data_dirs) {
   running_instances_lock_.AssertAcquired();
   --running_ops_;
   --op->running_;
+  for (const auto& dir : data_dirs) {
+    auto it = running_ops_by_data_dir_.find(dir);
+    DCHECK(it != running_ops_by_data_dir_.end());
+    if (--it->second == 0) {
+      running_ops_by_data_dir_.erase(it);
+    }
+  }
   op->cond_->Signal();
 }
 
@@ -231,6 +231,13 @@ class MaintenanceOp {
   // Returns the gauge for this op that tracks when this op is running. Cannot be NULL.
   virtual scoped_refptr<AtomicGauge<uint32_t>> RunningGauge() const = 0;
 
+  // Returns the data directories the op reads from and writes to, e.g. those
+  // of the data dir group of a tablet. This is used to limit the number of
+  // high IO ops running in each directory, see
+  // --maintenance_manager_max_ops_per_data_dir. The ops which don't return
+  // any directory aren't limited.
+  virtual std::vector<std::string> DataDirs() const { return {}; }
+
   uint32_t running() const { return running_; }
 
   const std::string& name() const { return name_; }
@@ -255,6 +262,16 @@ class MaintenanceOp {
 
   virtual int32_t priority() const = 0;
 
+  // Reserves up to 'max_threads' of the maintenance manager's idle threads on
+  // behalf of the running instance of this op, e.g. to parallelize its work
+  // without exceeding the manager's thread budget. Returns the number of
+  // threads reserved, which must be released with ReleaseExtraThreads() once
+  // done. Must only be called from Perform().
+  int32_t AcquireExtraThreads(int32_t max_threads);
+
+  // Returns 'num_threads' threads reserved by AcquireExtraThreads().
+  void ReleaseExtraThreads(int32_t num_threads);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(MaintenanceOp);
 
@@ -329,6 +346,14 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
   // registration in case any exist.
   void GetMaintenanceManagerStatusDump(MaintenanceManagerStatusPB* out_pb);
 
+  // Reserves up to 'max_threads' threads out of those not running any op, so
+  // that no new op is scheduled on them until they're released with
+  // ReleaseExtraThreads(). Returns the number of threads reserved.
+  int32_t AcquireExtraThreads(int32_t max_threads);
+
+  // Releases 'num_threads' threads reserved by AcquireExtraThreads().
+  void ReleaseExtraThreads(int32_t num_threads);
+
   void set_memory_pressure_func_for_tests(std::function<bool(double*)> f) {
     std::lock_guard<Mutex> guard(lock_);
     memory_pressure_func_ = std::move(f);
@@ -341,6 +366,7 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
   FRIEND_TEST(MaintenanceManagerTest, TestPrioritizeLogRetentionUnderMemoryPressure);
   FRIEND_TEST(MaintenanceManagerTest, TestOpFactors);
   FRIEND_TEST(MaintenanceManagerTest, VerifyMetrics);
+  FRIEND_TEST(MaintenanceManagerTest, TestMaxOpsPerDataDir);
 
   typedef std::map<MaintenanceOp*, MaintenanceOpStats,
           MaintenanceOpComparator> OpMapType;
@@ -361,7 +387,9 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
   // and the table's priority.
   static double AdjustedPerfScore(double perf_improvement, double workload_score, int32_t priority);
 
-  void LaunchOp(MaintenanceOp* op);
+  // Runs 'op', which was counted as running in 'data_dirs' by
+  // IncreaseOpCount().
+  void LaunchOp(MaintenanceOp* op, const std::vector<std::string>& data_dirs);
 
   std::string LogPrefix() const;
 
@@ -369,8 +397,20 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
 
   bool CouldNotLaunchNewOp(bool prev_iter_found_no_work);
 
-  void IncreaseOpCount(MaintenanceOp *op);
-  void DecreaseOpCountAndNotifyWaiters(MaintenanceOp *op);
+  // Returns the data directories in which 'op' counts against the limit of
+  // --maintenance_manager_max_ops_per_data_dir.
+  static std::vector<std::string> LimitedDataDirs(const MaintenanceOp* op);
+
+  // Returns true if one of the 'data_dirs' already runs as many ops as
+  // allowed by --maintenance_manager_max_ops_per_data_dir, according to
+  // 'running_ops_by_data_dir'.
+  static bool AnyDataDirBusy(
+      const std::vector<std::string>& data_dirs,
+      const std::unordered_map<std::string, int32_t>& running_ops_by_data_dir);
+
+  void IncreaseOpCount(MaintenanceOp* op, const std::vector<std::string>& data_dirs);
+  void DecreaseOpCountAndNotifyWaiters(MaintenanceOp* op,
+                                       const std::vector<std::string>& data_dirs);
 
   // Adds ops in 'ops_pending_registration_' to 'ops_'. Must be called while
   // 'lock_' is held.
@@ -418,6 +458,12 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
   // and read when the latter lock isn't held.
   std::atomic<int32_t> running_ops_;
 
+  // The number of running high IO ops in each data directory, as returned by
+  // their DataDirs(). Directories without running ops aren't in the map.
+  //
+  // Protected by 'running_instances_lock_'.
+  std::unordered_map<std::string, int32_t> running_ops_by_data_dir_;
+
   // Lock to guard access to 'completed_ops_' and 'completed_ops_count_'.
   simple_spinlock completed_ops_lock_;
   // Vector used as a circular buffer for recently completed ops. Elements need to be added at
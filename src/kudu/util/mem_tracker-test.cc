@@ -28,6 +28,7 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -38,6 +39,8 @@
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_int64(mem_tracker_thread_batch_bytes);
+
 namespace kudu {
 
 using std::equal_to;
@@ -426,4 +429,111 @@ TEST(MemTrackerTest, TestMultiThreadedCreateFind) {
   }
 }
 
+TEST(MemTrackerTest, TestBatchedConsumption) {
+  gflags::FlagSaver s;
+  FLAGS_mem_tracker_thread_batch_bytes = 1024;
+  shared_ptr<MemTracker> p = MemTracker::CreateTracker(-1, "p");
+  shared_ptr<MemTracker> c1 = MemTracker::CreateTracker(-1, "c1", p);
+  shared_ptr<MemTracker> c2 = MemTracker::CreateTracker(-1, "c2", p);
+
+  // The consumption below the threshold is batched.
+  c1->Consume(100);
+  ASSERT_EQ(0, c1->consumption());
+  ASSERT_EQ(0, p->consumption());
+  ASSERT_EQ(100, c1->ExactConsumption());
+  ASSERT_EQ(100, p->consumption());
+
+  // Past the threshold, it's applied.
+  c1->Consume(1000);
+  c1->Consume(100);
+  ASSERT_EQ(1200, c1->consumption());
+  ASSERT_EQ(1200, p->consumption());
+
+  // Using another tracker applies the batch of the previous one.
+  c1->Release(200);
+  ASSERT_EQ(1200, c1->consumption());
+  c2->Consume(10);
+  ASSERT_EQ(1000, c1->consumption());
+  ASSERT_EQ(0, c2->consumption());
+  ASSERT_EQ(10, c2->ExactConsumption());
+  ASSERT_EQ(1010, p->consumption());
+
+  // TryConsume() isn't batched.
+  ASSERT_TRUE(c1->TryConsume(5));
+  ASSERT_EQ(1005, c1->consumption());
+
+  c1->Release(1005);
+  c2->Release(10);
+  ASSERT_EQ(0, c1->ExactConsumption());
+  ASSERT_EQ(0, c2->ExactConsumption());
+  ASSERT_EQ(0, p->consumption());
+
+  // The batch of a destroyed tracker is applied, and the thread doesn't refer
+  // to the tracker anymore.
+  shared_ptr<MemTracker> c3 = MemTracker::CreateTracker(-1, "c3", p);
+  c3->Consume(20);
+  ASSERT_EQ(0, p->consumption());
+  c3->Release(20);
+  c3.reset();
+  c1->Consume(1);
+  ASSERT_EQ(1, c1->ExactConsumption());
+  c1->Release(1);
+  ASSERT_EQ(0, p->ExactConsumption());
+}
+
+TEST(MemTrackerTest, TestMultiThreadedBatchedConsumption) {
+  gflags::FlagSaver s;
+  FLAGS_mem_tracker_thread_batch_bytes = 4096;
+  constexpr int kNumThreads = 8;
+  constexpr int kNumIterations = 10000;
+  shared_ptr<MemTracker> p = MemTracker::CreateTracker(-1, "p");
+  vector<shared_ptr<MemTracker>> children;
+  for (int i = 0; i < kNumThreads; i++) {
+    children.emplace_back(MemTracker::CreateTracker(-1, Substitute("c$0", i), p));
+  }
+  std::atomic<int> num_done(0);
+  std::atomic<bool> stop(false);
+  vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&, i]{
+      for (int j = 0; j < kNumIterations; j++) {
+        // Alternate between two trackers to flush the batches as they switch.
+        children[(i + j % 2) % kNumThreads]->Consume(j % 100 + 1);
+      }
+      num_done++;
+      // Keep the thread, and its batch, alive until the exact consumption is
+      // checked below.
+      while (!stop.load()) {
+        SleepFor(MonoDelta::FromMilliseconds(1));
+      }
+    });
+  }
+  while (num_done.load() < kNumThreads) {
+    SleepFor(MonoDelta::FromMilliseconds(1));
+  }
+  const int64_t consumption = p->consumption();
+  const int64_t exact_consumption = p->ExactConsumption();
+  stop.store(true);
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  int64_t expected = 0;
+  for (int j = 0; j < kNumIterations; j++) {
+    expected += j % 100 + 1;
+  }
+  expected *= kNumThreads;
+  ASSERT_GE(expected, consumption);
+  ASSERT_LT(expected - consumption, kNumThreads * FLAGS_mem_tracker_thread_batch_bytes);
+  ASSERT_EQ(expected, exact_consumption);
+
+  // The batches of the exited threads were applied.
+  int64_t total = 0;
+  for (auto& c : children) {
+    total += c->consumption();
+    c->Release(c->consumption());
+  }
+  ASSERT_EQ(expected, total);
+}
+
 } // namespace kudu
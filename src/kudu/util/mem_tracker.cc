@@ -19,21 +19,47 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdlib>
 #include <deque>
 #include <limits>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <stack>
 #include <type_traits>
+#include <unordered_set>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
 
 #include "kudu/gutil/once.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/mem_tracker.pb.h"
 #include "kudu/util/mutex.h"
 #include "kudu/util/process_memory.h"
 
+DEFINE_int64(mem_tracker_thread_batch_bytes, 0,
+             "If positive, the memory consumed and released by each thread is "
+             "batched locally, and only applied to the memory trackers once it "
+             "reaches this many bytes either way, or when the thread uses another "
+             "tracker. This makes the allocations tracked by memory trackers with "
+             "many ancestors, such as the arenas of the tablets, cheaper, while the "
+             "consumption and the limits of the trackers may be off by up to this "
+             "many bytes per thread. If 0, the consumption is applied right away.");
+TAG_FLAG(mem_tracker_thread_batch_bytes, advanced);
+TAG_FLAG(mem_tracker_thread_batch_bytes, experimental);
+DEFINE_validator(mem_tracker_thread_batch_bytes, [](const char* flagname, int64_t value) {
+  if (value >= 0) {
+    return true;
+  }
+  LOG(ERROR) << "--" << flagname << " must not be negative: " << value;
+  return false;
+});
+
 namespace kudu {
 
 // NOTE: this class has been adapted from Impala, so the code style varies
@@ -47,6 +73,7 @@ using std::string;
 using std::vector;
 using std::weak_ptr;
 
+using std::unordered_set;
 using strings::Substitute;
 
 // The ancestor for all trackers. Every tracker is visible from the root down.
@@ -83,8 +110,60 @@ MemTracker::MemTracker(int64_t byte_limit, const string& id, shared_ptr<MemTrack
   VLOG(1) << "Creating tracker " << ToString();
 }
 
+// The consumption batched by a thread, registered for the duration of the
+// thread so that ExactConsumption() and the destructors of the trackers can
+// apply it. The owning thread takes the lock uncontended, except with the
+// rare flushes by the other threads.
+struct MemTracker::PendingConsumption {
+  PendingConsumption() {
+    std::lock_guard<simple_spinlock> l(registry_lock());
+    registry()->insert(this);
+  }
+
+  ~PendingConsumption() {
+    {
+      std::lock_guard<simple_spinlock> l(lock);
+      FlushPendingUnlocked(this);
+    }
+    std::lock_guard<simple_spinlock> l(registry_lock());
+    registry()->erase(this);
+  }
+
+  static simple_spinlock& registry_lock() {
+    static simple_spinlock lock;
+    return lock;
+  }
+
+  // The batches of all the threads. Protected by 'registry_lock()'.
+  static unordered_set<PendingConsumption*>* registry() {
+    static auto* registry = new unordered_set<PendingConsumption*>();
+    return registry;
+  }
+
+  // Protects the members below.
+  simple_spinlock lock;
+
+  // The tracker the consumption is batched for, or nullptr.
+  MemTracker* tracker = nullptr;
+
+  // The batched consumption, which may be negative.
+  int64_t bytes = 0;
+};
+
 MemTracker::~MemTracker() {
   VLOG(1) << "Destroying tracker " << ToString();
+  // Apply the consumption the threads batched for this tracker, which mustn't
+  // outlive it.
+  {
+    std::lock_guard<simple_spinlock> l(PendingConsumption::registry_lock());
+    for (auto* pending : *PendingConsumption::registry()) {
+      std::lock_guard<simple_spinlock> pl(pending->lock);
+      if (pending->tracker == this) {
+        FlushPendingUnlocked(pending);
+        pending->tracker = nullptr;
+      }
+    }
+  }
   if (parent_) {
     DCHECK(consumption() == 0) << "Memory tracker " << ToString()
         << " has unreleased consumption " << consumption();
@@ -194,6 +273,7 @@ void MemTracker::ListTrackers(vector<shared_ptr<MemTracker>>* trackers) {
 
 void MemTracker::TrackersToPb(MemTrackerPB* pb) {
   CHECK(pb);
+  FlushAllPendingConsumption();
   stack<std::pair<shared_ptr<MemTracker>, MemTrackerPB*>> to_process;
   to_process.emplace(std::make_pair(GetRootTracker(), pb));
   while (!to_process.empty()) {
@@ -230,11 +310,57 @@ void MemTracker::Consume(int64_t bytes) {
   if (bytes == 0) {
     return;
   }
+  if (FLAGS_mem_tracker_thread_batch_bytes > 0) {
+    ConsumeBatched(bytes);
+    return;
+  }
+  ApplyConsumption(bytes);
+}
+
+void MemTracker::ApplyConsumption(int64_t bytes) {
   for (auto& tracker : all_trackers_) {
     tracker->consumption_.IncrementBy(bytes);
   }
 }
 
+void MemTracker::ConsumeBatched(int64_t bytes) {
+  static thread_local PendingConsumption pending;
+  std::lock_guard<simple_spinlock> l(pending.lock);
+  if (pending.tracker != this) {
+    FlushPendingUnlocked(&pending);
+    pending.tracker = this;
+  }
+  pending.bytes += bytes;
+  if (std::abs(pending.bytes) >= FLAGS_mem_tracker_thread_batch_bytes) {
+    FlushPendingUnlocked(&pending);
+  }
+}
+
+void MemTracker::FlushPendingUnlocked(PendingConsumption* pending) {
+  if (pending->bytes == 0) {
+    return;
+  }
+  DCHECK(pending->tracker);
+  pending->tracker->ApplyConsumption(pending->bytes);
+  if (pending->bytes < 0) {
+    process_memory::MaybeGCAfterRelease(-pending->bytes);
+  }
+  pending->bytes = 0;
+}
+
+void MemTracker::FlushAllPendingConsumption() {
+  std::lock_guard<simple_spinlock> l(PendingConsumption::registry_lock());
+  for (auto* pending : *PendingConsumption::registry()) {
+    std::lock_guard<simple_spinlock> pl(pending->lock);
+    FlushPendingUnlocked(pending);
+  }
+}
+
+int64_t MemTracker::ExactConsumption() {
+  FlushAllPendingConsumption();
+  return consumption();
+}
+
 bool MemTracker::TryConsume(int64_t bytes) {
   if (bytes <= 0) {
     Release(-bytes);
@@ -285,10 +411,11 @@ void MemTracker::Release(int64_t bytes) {
   if (bytes == 0) {
     return;
   }
-
-  for (auto& tracker : all_trackers_) {
-    tracker->consumption_.IncrementBy(-bytes);
+  if (FLAGS_mem_tracker_thread_batch_bytes > 0) {
+    ConsumeBatched(-bytes);
+    return;
   }
+  ApplyConsumption(-bytes);
   process_memory::MaybeGCAfterRelease(bytes);
 }
 
@@ -56,6 +56,14 @@ class MemTrackerPB;
 // Memory consumption is tracked via calls to Consume()/Release(), either to
 // the tracker itself or to one of its descendants.
 //
+// With --mem_tracker_thread_batch_bytes, the consumption of each thread is
+// batched locally and only applied to the tracker and its ancestors once it
+// reaches that many bytes, or when the thread consumes from another tracker.
+// This spares the updates of the shared counters of the ancestors on the
+// allocation-heavy paths, at the price of consumption() figures which may be
+// off by up to that many bytes per thread. TryConsume() isn't batched, and
+// ExactConsumption() accounts for the batched consumption.
+//
 // This class is thread-safe.
 class MemTracker : public std::enable_shared_from_this<MemTracker> {
  public:
@@ -144,11 +152,17 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
   bool has_limit() const { return limit_ >= 0; }
   const std::string& id() const { return id_; }
 
-  // Returns the memory consumed in bytes.
+  // Returns the memory consumed in bytes, not counting the consumption still
+  // batched by the threads.
   int64_t consumption() const {
     return consumption_.current_value();
   }
 
+  // Returns the memory consumed in bytes, including the consumption batched by
+  // the threads, which this applies to all the trackers. Unlike consumption(),
+  // this takes a lock per thread batching consumption.
+  int64_t ExactConsumption();
+
   int64_t peak_consumption() const { return consumption_.max_value(); }
 
   // Retrieve the parent tracker, or NULL If one is not set.
@@ -159,6 +173,9 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
   std::string ToString() const;
 
  private:
+  // The consumption batched by a thread. Defined in mem_tracker.cc.
+  struct PendingConsumption;
+
   // byte_limit < 0 means no limit
   // 'id' is the label for LogUsage() and web UI.
   MemTracker(int64_t byte_limit, const std::string& id, std::shared_ptr<MemTracker> parent);
@@ -178,6 +195,21 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
   // Creates the root tracker.
   static void CreateRootTracker();
 
+  // Adds 'bytes', which may be negative, to the consumption of this tracker
+  // and its ancestors.
+  void ApplyConsumption(int64_t bytes);
+
+  // Adds 'bytes', which may be negative, to the consumption batched by the
+  // calling thread, applying the batch if it reaches
+  // --mem_tracker_thread_batch_bytes.
+  void ConsumeBatched(int64_t bytes);
+
+  // Applies the consumption batched in 'pending', whose lock must be held.
+  static void FlushPendingUnlocked(PendingConsumption* pending);
+
+  // Applies the consumption batched by all the threads.
+  static void FlushAllPendingConsumption();
+
   int64_t limit_;
   const std::string id_;
   const std::string descr_;
@@ -40,6 +40,8 @@ DEFINE_int32(num_threads, 16, "Number of threads to test");
 DEFINE_int32(allocs_per_thread, 10000, "Number of allocations each thread should do");
 DEFINE_int32(alloc_size, 4, "number of bytes in each allocation");
 
+DECLARE_int32(huge_page_allocator_max_free_mb);
+
 namespace kudu {
 
 using std::shared_ptr;
@@ -260,6 +262,91 @@ TEST(TestArena, TestMemoryTrackingEnforced) {
   ASSERT_EQ(256, mem_tracker->consumption());
 }
 
+// Test that the large components of an arena allocating from the
+// HugePageBufferAllocator are chunks, which go back to the pool once the arena
+// is destroyed.
+TEST(TestArena, TestHugePageChunks) {
+  constexpr size_t kChunkSize = HugePageBufferAllocator::kChunkSize;
+  HugePageBufferAllocator* huge_page_allocator = HugePageBufferAllocator::Get();
+  shared_ptr<MemTracker> mem_tracker = MemTracker::CreateTracker(-1, "arena-test-tracker");
+  shared_ptr<MemoryTrackingBufferAllocator> allocator(
+      new MemoryTrackingBufferAllocator(huge_page_allocator, mem_tracker));
+  const size_t used_chunks =
+      huge_page_allocator->num_chunks() - huge_page_allocator->num_free_chunks();
+  {
+    ThreadSafeMemoryTrackingArena arena(16, allocator);
+    arena.SetMaxBufferSize(kChunkSize);
+    for (int i = 0; i < 128; i++) {
+      void* allocated = arena.AllocateBytes(64 * 1024);
+      ASSERT_NE(nullptr, allocated);
+      memset(allocated, 0xff, 64 * 1024);
+    }
+    // 8MiB in components which double in size up to a chunk: the components
+    // after the first of 1MiB are chunks.
+    ASSERT_EQ(used_chunks + 4, huge_page_allocator->num_chunks() -
+              huge_page_allocator->num_free_chunks());
+    ASSERT_EQ(arena.memory_footprint(), mem_tracker->consumption());
+  }
+  ASSERT_EQ(used_chunks, huge_page_allocator->num_chunks() -
+            huge_page_allocator->num_free_chunks());
+  ASSERT_GE(huge_page_allocator->num_free_chunks(), 4);
+  ASSERT_EQ(0, mem_tracker->consumption());
+
+  // Chunks freed beyond the size of the pool are unmapped.
+  google::FlagSaver saver;
+  FLAGS_huge_page_allocator_max_free_mb = 0;
+  {
+    ThreadSafeMemoryTrackingArena arena(kChunkSize, allocator);
+    // The free chunks are reused first.
+    ASSERT_EQ(used_chunks + 1, huge_page_allocator->num_chunks() -
+              huge_page_allocator->num_free_chunks());
+  }
+  ASSERT_EQ(used_chunks, huge_page_allocator->num_chunks() -
+            huge_page_allocator->num_free_chunks());
+}
+
+// Test that the buffers of arenas allocating from a PooledBufferAllocator go
+// back to the pool once the arena is destroyed, and are reused by the next
+// arena, up to the size of the pool.
+TEST(TestArena, TestPooledBuffers) {
+  PooledBufferAllocator allocator(8 * 1024);
+  {
+    Arena arena(&allocator, 1024);
+    ASSERT_NE(nullptr, arena.AllocateBytes(1000));
+    ASSERT_NE(nullptr, arena.AllocateBytes(1500));
+    ASSERT_NE(nullptr, arena.AllocateBytes(3000));
+    ASSERT_EQ(7 * 1024, arena.memory_footprint());
+    ASSERT_EQ(0, allocator.pooled_bytes());
+  }
+  // The components of 1, 2 and 4KiB are pooled.
+  ASSERT_EQ(7 * 1024, allocator.pooled_bytes());
+  {
+    Arena arena(&allocator, 1024);
+    ASSERT_EQ(6 * 1024, allocator.pooled_bytes());
+    ASSERT_NE(nullptr, arena.AllocateBytes(1000));
+    ASSERT_NE(nullptr, arena.AllocateBytes(1500));
+    ASSERT_EQ(4 * 1024, allocator.pooled_bytes());
+    ASSERT_NE(nullptr, arena.AllocateBytes(3000));
+    ASSERT_EQ(0, allocator.pooled_bytes());
+    // The next component has to be larger than 8KiB, so its size isn't a
+    // power of two, and it isn't pooled when freed.
+    ASSERT_NE(nullptr, arena.AllocateBytes(10000));
+    ASSERT_EQ(7 * 1024 + 10000, arena.memory_footprint());
+  }
+  ASSERT_EQ(7 * 1024, allocator.pooled_bytes());
+
+  // Buffers freed beyond the size of the pool go back to the heap.
+  PooledBufferAllocator small_allocator(2 * 1024);
+  {
+    Arena arena(&small_allocator, 1024);
+    ASSERT_NE(nullptr, arena.AllocateBytes(1000));
+    ASSERT_NE(nullptr, arena.AllocateBytes(1500));
+    ASSERT_NE(nullptr, arena.AllocateBytes(3000));
+  }
+  ASSERT_GT(small_allocator.pooled_bytes(), 0);
+  ASSERT_LE(small_allocator.pooled_bytes(), 2 * 1024);
+}
+
 TEST(TestArena, TestSTLAllocator) {
   Arena a(256);
   typedef vector<int, ArenaAllocator<int, false> > ArenaVector;
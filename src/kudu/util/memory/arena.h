@@ -97,6 +97,8 @@ class ArenaBase {
 
   // Set the maximum buffer size allocated for this arena.
   // The maximum buffer size allowed is slightly less than ~1MB (8192 * 127 bytes).
+  // Arenas allocating from the HugePageBufferAllocator may set it to the
+  // allocator's chunk size.
   //
   // Consider the following pros/cons of large buffer sizes:
   //
@@ -296,6 +298,10 @@ class Arena : public ArenaBase<false> {
   explicit Arena(size_t initial_buffer_size) :
     ArenaBase<false>(initial_buffer_size)
   {}
+
+  Arena(BufferAllocator* buffer_allocator, size_t initial_buffer_size) :
+    ArenaBase<false>(buffer_allocator, initial_buffer_size)
+  {}
 };
 
 class ThreadSafeArena : public ArenaBase<true> {
@@ -26,17 +26,24 @@
 #else
 #include <mm_malloc.h>
 #endif //__aarch64__
+#include <sys/mman.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 
 #include <gflags/gflags.h>
 
+#include "kudu/gutil/basictypes.h"
+#include "kudu/gutil/bits.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/util/alignment.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/memory/overwrite.h"
+#include "kudu/util/trace.h"
 
 using std::copy;
 using std::min;
@@ -49,6 +56,13 @@ DEFINE_bool(allocator_aligned_mode, false,
             "unless explicitly specified otherwise - to boost SIMD");
 TAG_FLAG(allocator_aligned_mode, hidden);
 
+DEFINE_int32(huge_page_allocator_max_free_mb, 256,
+             "Maximum amount of memory, in MiB, kept mapped in the pool of free huge page "
+             "chunks for reuse by the in-memory stores. Chunks freed beyond that are "
+             "returned to the operating system.");
+TAG_FLAG(huge_page_allocator_max_free_mb, advanced);
+TAG_FLAG(huge_page_allocator_max_free_mb, runtime);
+
 namespace kudu {
 
 namespace {
@@ -173,6 +187,216 @@ void* HeapBufferAllocator::Realloc(void* previous_data, size_t previous_size,
   }
 }
 
+HugePageBufferAllocator::HugePageBufferAllocator()
+    : use_hugetlb_(true) {
+}
+
+size_t HugePageBufferAllocator::num_chunks() const {
+  std::lock_guard<Mutex> l(mutex_);
+  return chunks_.size();
+}
+
+size_t HugePageBufferAllocator::num_free_chunks() const {
+  std::lock_guard<Mutex> l(mutex_);
+  return free_chunks_.size();
+}
+
+Buffer* HugePageBufferAllocator::AllocateInternal(
+    const size_t requested,
+    const size_t minimal,
+    BufferAllocator* const originator) {
+  DCHECK_LE(minimal, requested);
+  if (minimal <= kChunkSize && requested >= kChunkSize) {
+    void* data = AllocateChunk();
+    if (data != nullptr) {
+      return CreateBuffer(data, kChunkSize, originator);
+    }
+  }
+  return DelegateAllocate(HeapBufferAllocator::Get(), requested, minimal, originator);
+}
+
+bool HugePageBufferAllocator::ReallocateInternal(
+    const size_t requested,
+    const size_t minimal,
+    Buffer* const buffer,
+    BufferAllocator* const originator) {
+  DCHECK_LE(minimal, requested);
+  if (IsChunk(buffer)) {
+    return minimal <= kChunkSize && requested >= kChunkSize;
+  }
+  return DelegateReallocate(HeapBufferAllocator::Get(), requested, minimal, buffer, originator);
+}
+
+void HugePageBufferAllocator::FreeInternal(Buffer* buffer) {
+  void* data = buffer->data();
+  {
+    std::lock_guard<Mutex> l(mutex_);
+    if (!ContainsKey(chunks_, data)) {
+      DelegateFree(HeapBufferAllocator::Get(), buffer);
+      return;
+    }
+    const size_t max_free_chunks =
+        static_cast<size_t>(FLAGS_huge_page_allocator_max_free_mb) * 1024 * 1024 / kChunkSize;
+    if (free_chunks_.size() < max_free_chunks) {
+      free_chunks_.push_back(data);
+      return;
+    }
+    chunks_.erase(data);
+  }
+  PCHECK(munmap(data, kChunkSize) == 0);
+}
+
+void* HugePageBufferAllocator::AllocateChunk() {
+  {
+    std::lock_guard<Mutex> l(mutex_);
+    if (!free_chunks_.empty()) {
+      void* data = free_chunks_.back();
+      free_chunks_.pop_back();
+      return data;
+    }
+  }
+  void* data = MapChunk();
+  if (data != nullptr) {
+    std::lock_guard<Mutex> l(mutex_);
+    InsertOrDie(&chunks_, data);
+  }
+  return data;
+}
+
+void* HugePageBufferAllocator::MapChunk() {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+  if (use_hugetlb_.load(std::memory_order_relaxed)) {
+    void* data = mmap(nullptr, kChunkSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      return data;
+    }
+    // No huge pages are reserved, or they're all in use.
+    use_hugetlb_.store(false, std::memory_order_relaxed);
+  }
+#endif
+  // Map twice the size of a chunk, and unmap what's around the aligned chunk
+  // in the middle.
+  void* region = mmap(nullptr, 2 * kChunkSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    return nullptr;
+  }
+  const uintptr_t start = reinterpret_cast<uintptr_t>(region);
+  const uintptr_t aligned = KUDU_ALIGN_UP(start, kChunkSize);
+  if (aligned > start) {
+    PCHECK(munmap(region, aligned - start) == 0);
+  }
+  const size_t tail = start + kChunkSize - aligned;
+  if (tail > 0) {
+    PCHECK(munmap(reinterpret_cast<void*>(aligned + kChunkSize), tail) == 0);
+  }
+  void* data = reinterpret_cast<void*>(aligned);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  // Fails if transparent huge pages are disabled, in which case the chunk
+  // just uses regular pages.
+  ignore_result(madvise(data, kChunkSize, MADV_HUGEPAGE));
+#endif
+  return data;
+}
+
+bool HugePageBufferAllocator::IsChunk(const Buffer* buffer) const {
+  std::lock_guard<Mutex> l(mutex_);
+  return ContainsKey(chunks_, buffer->data());
+}
+
+PooledBufferAllocator::PooledBufferAllocator(size_t max_pooled_bytes)
+    : max_pooled_bytes_(max_pooled_bytes),
+      pooled_bytes_(0) {
+}
+
+PooledBufferAllocator::~PooledBufferAllocator() {
+  for (const auto& free_list : free_buffers_) {
+    for (void* data : free_list) {
+      free(data);
+    }
+  }
+}
+
+size_t PooledBufferAllocator::pooled_bytes() const {
+  std::lock_guard<Mutex> l(mutex_);
+  return pooled_bytes_;
+}
+
+int PooledBufferAllocator::SizeClass(size_t size) {
+  if (size < kMinPooledSize || size > kMaxPooledSize || (size & (size - 1)) != 0) {
+    return -1;
+  }
+  return Bits::Log2FloorNonZero64(size) - Bits::Log2FloorNonZero64(kMinPooledSize);
+}
+
+Buffer* PooledBufferAllocator::AllocateInternal(
+    const size_t requested,
+    const size_t minimal,
+    BufferAllocator* const originator) {
+  DCHECK_LE(minimal, requested);
+  // Shrink the request to a pooled size if that's still enough.
+  size_t size = requested;
+  if (requested >= kMinPooledSize) {
+    const size_t pooled_size =
+        size_t{1} << Bits::Log2FloorNonZero64(std::min(requested, kMaxPooledSize));
+    if (pooled_size >= minimal) {
+      size = pooled_size;
+    }
+  }
+  void* data = nullptr;
+  const int size_class = SizeClass(size);
+  if (size_class >= 0) {
+    std::lock_guard<Mutex> l(mutex_);
+    auto& free_list = free_buffers_[size_class];
+    if (!free_list.empty()) {
+      data = free_list.back();
+      free_list.pop_back();
+      pooled_bytes_ -= size;
+    }
+  }
+  if (data != nullptr) {
+    TRACE_COUNTER_INCREMENT("arena_buffer_pool_hits", 1);
+  } else {
+    // Allocate at least a byte, so that the data pointer of an empty buffer
+    // isn't NULL.
+    data = malloc(std::max<size_t>(size, 1));
+    if (data == nullptr) {
+      return nullptr;
+    }
+    TRACE_COUNTER_INCREMENT("arena_buffer_allocs", 1);
+  }
+  return CreateBuffer(data, size, originator);
+}
+
+bool PooledBufferAllocator::ReallocateInternal(
+    const size_t requested,
+    const size_t minimal,
+    Buffer* const buffer,
+    BufferAllocator* const /* originator */) {
+  DCHECK_LE(minimal, requested);
+  void* data = realloc(buffer->data(), std::max<size_t>(requested, 1));
+  if (data == nullptr) {
+    return false;
+  }
+  UpdateBuffer(data, requested, buffer);
+  return true;
+}
+
+void PooledBufferAllocator::FreeInternal(Buffer* buffer) {
+  const size_t size = buffer->size();
+  const int size_class = SizeClass(size);
+  if (size_class >= 0) {
+    std::lock_guard<Mutex> l(mutex_);
+    if (pooled_bytes_ + size <= max_pooled_bytes_) {
+      free_buffers_[size_class].push_back(buffer->data());
+      pooled_bytes_ += size;
+      return;
+    }
+  }
+  free(buffer->data());
+}
+
 Buffer* ClearingBufferAllocator::AllocateInternal(size_t requested,
                                                   size_t minimal,
                                                   BufferAllocator* originator) {
@@ -31,11 +31,13 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <memory>
 #include <ostream>
+#include <unordered_set>
 #include <vector>
 
 #include <glog/logging.h>
@@ -282,6 +284,131 @@ class HeapBufferAllocator : public BufferAllocator {
   DISALLOW_COPY_AND_ASSIGN(HeapBufferAllocator);
 };
 
+// Allocates the buffers of exactly kChunkSize bytes as chunks mapped apart
+// from the heap, aligned to huge pages and backed by them where the system
+// supports it: by the huge pages reserved with hugetlbfs if there are any left,
+// or else by transparent huge pages (MADV_HUGEPAGE). Freed chunks are kept in
+// a process-wide pool for reuse, of up to --huge_page_allocator_max_free_mb.
+// Other buffers are allocated by the HeapBufferAllocator.
+//
+// Arenas allocating from it should set their maximum buffer size to
+// kChunkSize, so that their large components are chunks. This helps the
+// long-lived arenas of the in-memory stores: their memory is returned in whole
+// chunks when they're flushed rather than fragmenting the heap, and the trees
+// they hold take fewer TLB misses.
+//
+// Chunks aren't reallocated to other sizes. Thread-safe.
+class HugePageBufferAllocator : public BufferAllocator {
+ public:
+  static constexpr size_t kChunkSize = 2 * 1024 * 1024;
+
+  ~HugePageBufferAllocator() override = default;
+
+  // Returns a singleton instance of the huge page allocator.
+  static HugePageBufferAllocator* Get() {
+    return Singleton<HugePageBufferAllocator>::get();
+  }
+
+  size_t Available() const override {
+    return std::numeric_limits<size_t>::max();
+  }
+
+  // Returns the number of chunks currently mapped, and how many of them are
+  // free in the pool.
+  size_t num_chunks() const;
+  size_t num_free_chunks() const;
+
+ private:
+  friend class Singleton<HugePageBufferAllocator>;
+
+  HugePageBufferAllocator();
+
+  Buffer* AllocateInternal(size_t requested,
+                           size_t minimal,
+                           BufferAllocator* originator) override;
+
+  bool ReallocateInternal(size_t requested,
+                          size_t minimal,
+                          Buffer* buffer,
+                          BufferAllocator* originator) override;
+
+  void FreeInternal(Buffer* buffer) override;
+
+  // Returns a chunk from the pool, or a newly mapped one. Returns NULL if
+  // a chunk can't be mapped.
+  void* AllocateChunk();
+
+  // Maps a new chunk, or returns NULL on failure.
+  void* MapChunk();
+
+  bool IsChunk(const Buffer* buffer) const;
+
+  // Cleared once a chunk can't be mapped from the reserved huge pages, after
+  // which only transparent huge pages are used.
+  std::atomic<bool> use_hugetlb_;
+
+  mutable Mutex mutex_;
+  // All the chunks mapped, whether in use or not.
+  std::unordered_set<void*> chunks_;
+  // The chunks free for reuse.
+  std::vector<void*> free_chunks_;
+
+  DISALLOW_COPY_AND_ASSIGN(HugePageBufferAllocator);
+};
+
+// Allocates buffers on the heap, keeping the freed buffers whose size is a
+// power of two between kMinPooledSize and kMaxPooledSize in a pool for reuse,
+// of up to 'max_pooled_bytes' bytes in total.
+//
+// This suits the many short-lived arenas that all grow through the same
+// sizes, such as the arenas of the write ops of a tablet: once the pool is
+// warm, creating and destroying such an arena doesn't go to the heap for its
+// buffers. Each allocation increments the 'arena_buffer_pool_hits' or
+// 'arena_buffer_allocs' counter of the current trace, if any.
+//
+// Thread-safe.
+class PooledBufferAllocator : public BufferAllocator {
+ public:
+  static constexpr size_t kMinPooledSize = 1024;
+  static constexpr size_t kMaxPooledSize = 64 * 1024;
+
+  explicit PooledBufferAllocator(size_t max_pooled_bytes);
+  ~PooledBufferAllocator() override;
+
+  // Returns the total size of the buffers currently in the pool.
+  size_t pooled_bytes() const;
+
+ private:
+  // The number of distinct sizes of pooled buffers.
+  static constexpr int kNumSizeClasses = 7;
+  static_assert(kMinPooledSize << (kNumSizeClasses - 1) == kMaxPooledSize,
+                "one size class per power of two");
+
+  // Returns the size class of buffers of exactly 'size' bytes, or -1 if such
+  // buffers aren't pooled.
+  static int SizeClass(size_t size);
+
+  Buffer* AllocateInternal(size_t requested,
+                           size_t minimal,
+                           BufferAllocator* originator) override;
+
+  bool ReallocateInternal(size_t requested,
+                          size_t minimal,
+                          Buffer* buffer,
+                          BufferAllocator* originator) override;
+
+  void FreeInternal(Buffer* buffer) override;
+
+  const size_t max_pooled_bytes_;
+
+  mutable Mutex mutex_;
+  // The free buffers of each size class, and their total size.
+  std::vector<void*> free_buffers_[kNumSizeClasses];
+  size_t pooled_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(PooledBufferAllocator);
+};
+
 // Wrapper around the delegate allocator, that clears all newly allocated
 // (and reallocated) memory.
 class ClearingBufferAllocator : public BufferAllocator {
@@ -147,6 +147,43 @@ TEST_F(MetricsTest, CounterPrometheusTest) {
   ASSERT_EQ(expected_output, output.str());
 }
 
+METRIC_DEFINE_counter(server, test_server_debug_counter, "Test Server Debug Counter",
+                      MetricUnit::kRequests, "Description of server debug counter",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, test_server_warn_counter, "Test Server Warn Counter",
+                      MetricUnit::kRequests, "Description of server warn counter",
+                      kudu::MetricLevel::kWarn);
+
+// The metrics of the registry written in the Prometheus format are filtered
+// by level and by name.
+TEST_F(MetricsTest, RegistryPrometheusFilterTest) {
+  auto server_entity = METRIC_ENTITY_server.Instantiate(&registry_, "kudu.tabletserver");
+  METRIC_test_server_debug_counter.Instantiate(server_entity)->Increment();
+  METRIC_test_server_warn_counter.Instantiate(server_entity)->Increment();
+
+  const auto write = [&](const string& level, const vector<string>& names) {
+    MetricFilters filters;
+    filters.entity_level = level;
+    filters.entity_metrics = names;
+    ostringstream output;
+    PrometheusWriter writer(&output);
+    CHECK_OK(registry_.WriteAsPrometheus(&writer, filters));
+    return output.str();
+  };
+
+  string output = write("debug", {});
+  ASSERT_STR_CONTAINS(output, "kudu_tserver_test_server_debug_counter");
+  ASSERT_STR_CONTAINS(output, "kudu_tserver_test_server_warn_counter");
+
+  output = write("warn", {});
+  ASSERT_STR_NOT_CONTAINS(output, "kudu_tserver_test_server_debug_counter");
+  ASSERT_STR_CONTAINS(output, "kudu_tserver_test_server_warn_counter");
+
+  output = write("debug", { "test_server_debug_counter" });
+  ASSERT_STR_CONTAINS(output, "kudu_tserver_test_server_debug_counter");
+  ASSERT_STR_NOT_CONTAINS(output, "kudu_tserver_test_server_warn_counter");
+}
+
 METRIC_DEFINE_gauge_string(test_entity, test_string_gauge, "Test string Gauge",
                            MetricUnit::kState, "Description of string Gauge",
                            kudu::MetricLevel::kInfo);
@@ -17,12 +17,14 @@
 #include "kudu/util/metrics.h"
 
 #include <iostream>
+#include <map>
 #include <tuple>
 #include <utility>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/gutil/casts.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/singleton.h"
 #include "kudu/gutil/strings/join.h"
@@ -39,11 +41,21 @@ DEFINE_int32(metrics_retirement_age_ms, 120 * 1000,
 TAG_FLAG(metrics_retirement_age_ms, runtime);
 TAG_FLAG(metrics_retirement_age_ms, advanced);
 
+DEFINE_bool(metrics_prometheus_table_counters, true,
+            "Whether to output the counters of the tablets summed by table, labeled "
+            "with the identifier and the name of the table, in the Prometheus format "
+            "metrics. These include the CPU time and the IO of the tablets, so that "
+            "the resource usage can be attributed to tables.");
+TAG_FLAG(metrics_prometheus_table_counters, runtime);
+TAG_FLAG(metrics_prometheus_table_counters, advanced);
+
 // Process/server-wide metrics should go into the 'server' entity.
 // More complex applications will define other entities.
 METRIC_DEFINE_entity(server);
 
+using std::map;
 using std::string;
+using std::unordered_map;
 using std::unordered_set;
 using std::vector;
 using strings::Substitute;
@@ -404,7 +416,8 @@ Status MetricEntity::WriteAsJson(JsonWriter* writer, const MetricJsonOptions& op
   return Status::OK();
 }
 
-Status MetricEntity::WriteAsPrometheus(PrometheusWriter* writer) const {
+Status MetricEntity::WriteAsPrometheus(PrometheusWriter* writer,
+                                       const MetricFilters& filters) const {
   static const string kIdMaster = "kudu.master";
   static const string kIdTabletServer = "kudu.tabletserver";
 
@@ -416,12 +429,6 @@ Status MetricEntity::WriteAsPrometheus(PrometheusWriter* writer) const {
     return Status::OK();
   }
 
-  // Empty filters result in getting all the metrics for this MetricEntity.
-  //
-  // TODO(aserbin): instead of hard-coding, pass MetricFilters as a parameter
-  MetricFilters filters;
-  filters.entity_level = "debug";
-
   MetricMap metrics;
   AttributeMap attrs;
   const auto s = GetMetricsAndAttrs(filters, &metrics, &attrs);
@@ -597,22 +604,91 @@ Status MetricRegistry::WriteAsJson(JsonWriter* writer, const MetricJsonOptions&
   return Status::OK();
 }
 
-Status MetricRegistry::WriteAsPrometheus(PrometheusWriter* writer) const {
+Status MetricRegistry::WriteAsPrometheus(PrometheusWriter* writer,
+                                         const MetricFilters& filters) const {
   EntityMap entities;
   {
     std::lock_guard<simple_spinlock> l(lock_);
     entities = entities_;
   }
   for (const auto& e : entities) {
-    WARN_NOT_OK(e.second->WriteAsPrometheus(writer),
+    WARN_NOT_OK(e.second->WriteAsPrometheus(writer, filters),
                 Substitute("Failed to write entity $0 as Prometheus", e.second->id()));
   }
+  if (FLAGS_metrics_prometheus_table_counters) {
+    WriteTableCountersAsPrometheus(entities, filters, writer);
+  }
 
   entities.clear(); // necessary to deref metrics we just dumped before doing retirement scan.
   const_cast<MetricRegistry*>(this)->RetireOldMetrics();
   return Status::OK();
 }
 
+namespace {
+// Escapes a Prometheus label value.
+string EscapePrometheusLabelValue(const string& value) {
+  string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    switch (c) {
+      case '\\': escaped += "\\\\"; break;
+      case '"': escaped += "\\\""; break;
+      case '\n': escaped += "\\n"; break;
+      default: escaped += c; break;
+    }
+  }
+  return escaped;
+}
+} // anonymous namespace
+
+void MetricRegistry::WriteTableCountersAsPrometheus(const EntityMap& entities,
+                                                    const MetricFilters& filters,
+                                                    PrometheusWriter* writer) {
+  static const string kTablePrefix = "kudu_table_";
+
+  // The counters by name, and their values summed by table, sorted so that
+  // the samples of a counter are output together, as Prometheus expects.
+  map<string, std::pair<const MetricPrototype*, map<string, int64_t>>> counters;
+  unordered_map<string, string> table_names;
+  for (const auto& e : entities) {
+    const auto& entity = e.second;
+    if (strcmp(entity->prototype_->name(), "tablet") != 0) {
+      continue;
+    }
+    MetricEntity::MetricMap metrics;
+    MetricEntity::AttributeMap attrs;
+    if (!entity->GetMetricsAndAttrs(filters, &metrics, &attrs).ok()) {
+      continue;
+    }
+    const string* table_id = FindOrNull(attrs, "table_id");
+    if (!table_id) {
+      continue;
+    }
+    table_names[*table_id] = FindWithDefault(attrs, "table_name", "");
+    for (const auto& m : metrics) {
+      const MetricPrototype* prototype = m.first;
+      if (prototype->type() != MetricType::kCounter) {
+        continue;
+      }
+      auto& counter = counters[prototype->name()];
+      counter.first = prototype;
+      counter.second[*table_id] += down_cast<const Counter*>(m.second.get())->value();
+    }
+  }
+
+  for (const auto& [name, counter] : counters) {
+    const MetricPrototype* prototype = counter.first;
+    prototype->WriteHelpAndType(writer, kTablePrefix);
+    for (const auto& [table_id, value] : counter.second) {
+      writer->WriteEntry(Substitute(
+          "$0$1{table_id=\"$2\",table_name=\"$3\",unit_type=\"$4\"} $5\n",
+          kTablePrefix, name, EscapePrometheusLabelValue(table_id),
+          EscapePrometheusLabelValue(FindOrDie(table_names, table_id)),
+          MetricUnit::Name(prototype->unit()), value));
+    }
+  }
+}
+
 void MetricRegistry::RetireOldMetrics() {
   std::lock_guard<simple_spinlock> l(lock_);
   for (auto it = entities_.begin(); it != entities_.end();) {
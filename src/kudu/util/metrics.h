@@ -668,7 +668,8 @@ class MetricEntity : public RefCountedThreadSafe<MetricEntity> {
   // See MetricRegistry::WriteAsJson()
   Status WriteAsJson(JsonWriter* writer, const MetricJsonOptions& opts) const;
 
-  Status WriteAsPrometheus(PrometheusWriter* writer) const;
+  // See MetricRegistry::WriteAsPrometheus()
+  Status WriteAsPrometheus(PrometheusWriter* writer, const MetricFilters& filters) const;
 
   // Collect metrics of this entity to 'collections'. Metrics will be filtered by 'filters',
   // and will be merged under the rule of 'merge_rules'.
@@ -885,7 +886,15 @@ class MetricRegistry {
   Status WriteAsJson(JsonWriter* writer, const MetricJsonOptions& opts) const;
 
   // Writes metrics in this registry to given Prometheus 'writer'.
-  Status WriteAsPrometheus(PrometheusWriter* writer) const;
+  //
+  // Besides the server-level metrics, the counters of the tablets are written
+  // summed by table, with the 'kudu_table_' prefix and labeled with the
+  // identifier and the name of the table, unless
+  // --metrics_prometheus_table_counters is false.
+  //
+  // The metrics are filtered by 'filters', see MetricFilters for details.
+  Status WriteAsPrometheus(PrometheusWriter* writer,
+                           const MetricFilters& filters = MetricFilters()) const;
   // For each registered entity, retires orphaned metrics. If an entity has no more
   // metrics and there are no external references, entities are removed as well.
   //
@@ -900,6 +909,13 @@ class MetricRegistry {
 
  private:
   typedef std::unordered_map<std::string, scoped_refptr<MetricEntity> > EntityMap;
+
+  // Writes the counters of the 'tablet' entities among 'entities' which pass
+  // 'filters' to 'writer', summed by table.
+  static void WriteTableCountersAsPrometheus(const EntityMap& entities,
+                                             const MetricFilters& filters,
+                                             PrometheusWriter* writer);
+
   EntityMap entities_;
 
   mutable simple_spinlock lock_;
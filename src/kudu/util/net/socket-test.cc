@@ -17,6 +17,7 @@
 
 #include "kudu/util/net/socket.h"
 
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <cstddef>
@@ -209,6 +210,16 @@ TEST_F(SocketTest, TestRecvEOF) {
   DoTestServerDisconnects(true, "recv got EOF from 127.0.0.1:[0-9]+");
 }
 
+#if defined(__linux__)
+TEST_F(SocketTest, TestBusyPoll) {
+  Socket sock;
+  ASSERT_OK(sock.Init(AF_INET, 0));
+  // Disabling busy polling never requires any privilege.
+  ASSERT_OK(sock.SetBusyPoll(0));
+  ASSERT_OK(sock.Close());
+}
+#endif
+
 // Apple does not support abstract namespaces in sockets.
 #if !defined(__APPLE__)
 TEST_F(SocketTest, TestUnixSocketAbstractNamespace) {
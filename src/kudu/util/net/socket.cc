@@ -452,6 +452,16 @@ Status Socket::SetReusePort(bool flag) {
   #endif
 }
 
+Status Socket::SetBusyPoll(int usec) {
+  #ifdef SO_BUSY_POLL
+    RETURN_NOT_OK_PREPEND(SetSockOpt(SOL_SOCKET, SO_BUSY_POLL, usec),
+                          "failed to set SO_BUSY_POLL");
+    return Status::OK();
+  #else
+    return Status::NotSupported("failed to set SO_BUSY_POLL: protocol not available");
+  #endif
+}
+
 Status Socket::BindAndListen(const Sockaddr& sockaddr,
                              int listen_queue_size) {
   RETURN_NOT_OK(SetReuseAddr(true));
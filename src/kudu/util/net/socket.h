@@ -98,6 +98,12 @@ class Socket {
   // Sets SO_REUSEPORT to 'flag'. Should be used prior to Bind().
   Status SetReusePort(bool flag);
 
+  // Sets SO_BUSY_POLL to 'usec': reads from the socket then busy poll the
+  // receive queue of the device for up to 'usec' microseconds rather than
+  // wait for an interrupt. Values above the net.core.busy_read sysctl require
+  // CAP_NET_ADMIN.
+  Status SetBusyPoll(int usec);
+
   // Convenience method to invoke the common sequence:
   // 1) SetReuseAddr(true)
   // 2) Bind()
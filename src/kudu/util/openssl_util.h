@@ -50,6 +50,7 @@ typedef struct bio_st BIO;
 typedef struct evp_pkey_st EVP_PKEY;
 typedef struct ssl_ctx_st SSL_CTX;
 typedef struct ssl_st SSL;
+typedef struct ssl_session_st SSL_SESSION;
 typedef struct x509_st X509;
 
 #define OPENSSL_CHECK_OK(call) \
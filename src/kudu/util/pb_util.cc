@@ -529,7 +529,7 @@ Status WritePBToPath(Env* env, const std::string& path,
     return Status::IOError("Unable to serialize PB to file");
   }
 
-  if (sync == pb_util::SYNC) {
+  if (sync != pb_util::NO_SYNC) {
     RETURN_NOT_OK_PREPEND(file->Sync(), "Failed to Sync() " + tmp_path);
   }
   RETURN_NOT_OK_PREPEND(file->Close(), "Failed to Close() " + tmp_path);
@@ -1085,7 +1085,7 @@ Status WritePBContainerToPath(Env* env, const std::string& path,
   WritablePBContainerFile pb_file(std::move(file));
   RETURN_NOT_OK(pb_file.CreateNew(msg));
   RETURN_NOT_OK(pb_file.Append(msg));
-  if (sync == pb_util::SYNC) {
+  if (sync != pb_util::NO_SYNC) {
     RETURN_NOT_OK(pb_file.Sync());
   }
   RETURN_NOT_OK(pb_file.Close());
@@ -57,7 +57,10 @@ namespace pb_util {
 
 enum SyncMode {
   SYNC,
-  NO_SYNC
+  NO_SYNC,
+  // Like SYNC, but doesn't fsync() the parent directory of the file: the
+  // caller is responsible for doing so before relying on the file's presence.
+  SYNC_FILE_ONLY
 };
 
 enum CreateMode {
@@ -17,6 +17,10 @@
 #ifndef IMPALA_RLE_ENCODING_H
 #define IMPALA_RLE_ENCODING_H
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
 #include <glog/logging.h>
 
 #include "kudu/gutil/port.h"
@@ -116,6 +120,12 @@ class RleDecoder {
   // GetNextRun will return more from the same run.
   size_t GetNextRun(T* val, size_t max_run);
 
+  // Gets the next 'batch_size' values into 'values', decoding the repeated
+  // runs and the literal runs a run at a time rather than a value at a time.
+  // Returns the number of values read, which is less than 'batch_size' only if
+  // there is no more data to be decoded.
+  size_t GetValues(T* values, size_t batch_size);
+
  private:
   bool ReadHeader();
 
@@ -352,6 +362,33 @@ inline size_t RleDecoder<T>::GetNextRun(T* val, size_t max_run) {
   return ret;
  }
 
+template<typename T>
+inline size_t RleDecoder<T>::GetValues(T* values, size_t batch_size) {
+  DCHECK(bit_reader_.is_initialized());
+  size_t num_read = 0;
+  while (num_read < batch_size && ReadHeader()) {
+    const size_t rem = batch_size - num_read;
+    if (PREDICT_TRUE(repeat_count_ > 0)) {
+      const size_t n = std::min<size_t>(repeat_count_, rem);
+      std::fill_n(values + num_read, n, static_cast<T>(current_value_));
+      repeat_count_ -= n;
+      num_read += n;
+      rewind_state_ = REWIND_RUN;
+    } else {
+      DCHECK(literal_count_ > 0);
+      const size_t n = std::min<size_t>(literal_count_, rem);
+      const size_t n_literal = bit_reader_.GetValues(bit_width_, values + num_read, n);
+      literal_count_ -= n_literal;
+      num_read += n_literal;
+      rewind_state_ = REWIND_LITERAL;
+      if (PREDICT_FALSE(n_literal < n)) {
+        break;
+      }
+    }
+  }
+  return num_read;
+}
+
 template<typename T>
 inline size_t RleDecoder<T>::Skip(size_t to_skip) {
   DCHECK(bit_reader_.is_initialized());
@@ -45,6 +45,7 @@
 #include "kudu/gutil/mathlimits.h"
 #include "kudu/util/bit-stream-utils.h"
 #include "kudu/util/bit-stream-utils.inline.h"
+#include "kudu/util/bit-unpack.h"
 #include "kudu/util/bit-util.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/hexdump.h"
@@ -154,6 +155,60 @@ TEST(BitArray, TestValues) {
   }
 }
 
+// Test that GetValues() reads the same values as GetValue(), starting from
+// both byte-aligned and unaligned positions, and up to the end of the stream.
+TEST(BitArray, TestGetValues) {
+  constexpr int kNumVals = 1000;
+  for (int width = 1; width <= kMaxWidth; ++width) {
+    SCOPED_TRACE(width);
+    const uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    faststring buffer(BitUtil::Ceil<3>(width * kNumVals));
+    BitWriter writer(&buffer);
+    vector<uint64_t> expected;
+    for (int i = 0; i < kNumVals; ++i) {
+      expected.emplace_back((static_cast<uint64_t>(random()) << 32 | random()) & mask);
+      writer.PutValue(expected.back(), width);
+    }
+    writer.Flush();
+
+    for (int start = 0; start < 9; ++start) {
+      BitReader reader(buffer.data(), writer.bytes_written());
+      vector<uint64_t> vals(kNumVals);
+      for (int i = 0; i < start; ++i) {
+        ASSERT_TRUE(reader.GetValue(width, &vals[i]));
+      }
+      int num_read = start;
+      while (num_read < kNumVals) {
+        const int n = reader.GetValues(width, &vals[num_read], random() % 100 + 1);
+        ASSERT_GT(n, 0);
+        num_read += n;
+      }
+      ASSERT_EQ(kNumVals, num_read);
+      ASSERT_EQ(expected, vals);
+      uint64_t val;
+      ASSERT_FALSE(reader.GetValue(width, &val));
+      ASSERT_EQ(0, reader.GetValues(width, &val, 1));
+    }
+  }
+}
+
+// Test UnpackBits1() against unpacking the bits one at a time, for all the
+// lengths covering the different code paths.
+TEST(BitArray, TestUnpackBits1) {
+  for (int num_vals = 0; num_vals < 300; ++num_vals) {
+    vector<uint8_t> in(BitUtil::Ceil<3>(num_vals));
+    for (auto& b : in) {
+      b = random();
+    }
+    vector<uint8_t> out(num_vals + 1, 0xff);
+    UnpackBits1(in.data(), num_vals, out.data());
+    for (int i = 0; i < num_vals; ++i) {
+      ASSERT_EQ((in[i / 8] >> (i % 8)) & 1, out[i]) << num_vals << " values, value " << i;
+    }
+    ASSERT_EQ(0xff, out[num_vals]) << "overrun with " << num_vals << " values";
+  }
+}
+
 // Test some mixed values
 TEST(BitArray, TestMixed) {
   const int kTestLenBits = 1024;
@@ -556,6 +611,48 @@ TEST_F(TestRle, TestSkip) {
   encoder.Flush();
 }
 
+// Test that GetValues() decodes the same values as Get() across repeated and
+// literal runs, interleaved with Get() and RewindOne().
+TEST_F(TestRle, TestGetValues) {
+  for (int width : { 1, 3, 8, 13, 32 }) {
+    SCOPED_TRACE(width);
+    const uint32_t mask = width == 32 ? ~0U : (1U << width) - 1;
+    faststring buffer;
+    RleEncoder<uint32_t> encoder(&buffer, width);
+    vector<uint32_t> expected;
+    while (expected.size() < 10000) {
+      const int run_length = random() % 30 + 1;
+      const bool repeated = random() % 2;
+      const uint32_t repeated_val = random() & mask;
+      for (int i = 0; i < run_length; ++i) {
+        expected.emplace_back(repeated ? repeated_val : random() & mask);
+        encoder.Put(expected.back());
+      }
+    }
+    encoder.Flush();
+
+    RleDecoder<uint32_t> decoder(buffer.data(), encoder.len(), width);
+    vector<uint32_t> vals(expected.size());
+    size_t num_read = 0;
+    while (num_read < expected.size()) {
+      if (random() % 4 == 0) {
+        ASSERT_TRUE(decoder.Get(&vals[num_read]));
+        num_read++;
+        continue;
+      }
+      const size_t n = decoder.GetValues(&vals[num_read], random() % 200 + 1);
+      ASSERT_GT(n, 0);
+      num_read += n;
+      if (random() % 2 == 0) {
+        decoder.RewindOne();
+        num_read--;
+      }
+    }
+    ASSERT_EQ(expected.size(), num_read);
+    ASSERT_EQ(expected, vals);
+  }
+}
+
 // RLE encoding groups values and decides whether to run-length encode or simply bit-pack
 // (literal encoding). This test verifies correctness of the RLE decoding when literal
 // encoding is used irrespective of the size of the group and the number of values encoded.
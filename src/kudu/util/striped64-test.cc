@@ -28,6 +28,7 @@
 #include <gtest/gtest.h>
 
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/util/atomic.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/test_util.h"
@@ -155,6 +156,15 @@ TEST(Striped64Test, TestMultiIncrDecr) {
   RunMultiTest(FLAGS_num_operations, FLAGS_num_threads);
 }
 
+// Compare a workload with a thread per CPU, like the updates of the hot
+// server-level counters.
+TEST(Striped64Test, TestPerCpuIncrDecr) {
+  OverrideFlagForSlowTests(
+      "num_operations",
+      strings::Substitute("$0", (FLAGS_num_operations * 100)));
+  RunMultiTest(FLAGS_num_operations, base::NumCPUs());
+}
+
 TEST(Striped64Test, TestSize) {
   ASSERT_EQ(16, sizeof(LongAdder));
 }
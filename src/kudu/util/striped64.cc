@@ -24,6 +24,7 @@
 #include <mm_malloc.h>
 #endif //__aarch64__
 
+#include <sched.h>
 #include <unistd.h>
 
 #include <cstdlib>
@@ -86,6 +87,16 @@ uint64_t Striped64::get_tls_hashcode() {
   return tls_hashcode_;
 }
 
+uint64_t Striped64::get_cell_index() {
+#if defined(__linux__)
+  // sched_getcpu() is served by the vDSO, without a system call.
+  const int cpu = sched_getcpu();
+  if (PREDICT_TRUE(cpu >= 0)) {
+    return cpu;
+  }
+#endif
+  return get_tls_hashcode();
+}
 
 Striped64::~Striped64() {
   // Cell is a POD, so no need to destruct each one.
@@ -157,18 +168,16 @@ void Striped64::InternalReset(int64_t initial_value) {
   }
 }
 void LongAdder::IncrementBy(int64_t x) {
-  // Use hash table if present. If that fails, call RetryUpdate to rehash and retry.
-  // If no hash table, try to CAS the base counter. If that fails, RetryUpdate to init the table.
+  // Use hash table if present. If no hash table, try to CAS the base counter. If that fails,
+  // RetryUpdate to init the table.
   Cell* cells = cells_.load(std::memory_order_acquire);
   if (cells && cells != kCellsLocked) {
-    Cell *cell = &(cells[get_tls_hashcode() & kCellMask]);
+    Cell *cell = &(cells[get_cell_index() & kCellMask]);
     DCHECK_EQ(0, reinterpret_cast<const uintptr_t>(cell) & (sizeof(Cell) - 1))
         << " unaligned Cell not allowed for Striped64" << std::endl;
-    const int64_t old = cell->value_.load(std::memory_order_relaxed);
-    if (!cell->CompareAndSet(old, old + x)) {
-      // When we hit a hash table contention, signal RetryUpdate to rehash.
-      RetryUpdate(kRehash, [x](int64_t old) { return old + x; });
-    }
+    // The threads updating the Cell of a CPU mostly run on it: unlike a CAS,
+    // the atomic add doesn't need to rehash when they interleave.
+    cell->value_.fetch_add(x, std::memory_order_relaxed);
   } else {
     int64_t b = base_.load(std::memory_order_relaxed);
     if (!CasBase(b, b + x)) {
@@ -84,6 +84,11 @@ class Cell {
 // function. Due to the random rehashing, the threads should eventually converge to this function.
 // In practice, this scheme has shown to be sufficient.
 //
+// LongAdder departs from this scheme once its table exists: on Linux, its updates go to the
+// Cell of the CPU running the thread, with an atomic add rather than a CAS. An update only
+// contends with the updates of the threads which ran on the same CPU in the meantime, and
+// never needs to retry. See LongAdder::IncrementBy().
+//
 // The biggest simplification of this implementation compared to JSR166e is that we do not
 // dynamically grow the table, instead immediately allocating it to the full size.
 // We also do not lazily allocate each Cell, instead allocating the entire array at once.
@@ -130,6 +135,11 @@ class Striped64 {
  protected:
   static uint64_t get_tls_hashcode();
 
+  // Returns the index of the Cell to update for the calling thread: the index
+  // of its CPU on Linux, its hashcode elsewhere. May be any value: it's masked
+  // with the size of the table.
+  static uint64_t get_cell_index();
+
  private:
   DISALLOW_COPY_AND_ASSIGN(Striped64);
 
@@ -91,6 +91,10 @@ class ThreadPoolTest : public KuduTest {
         .Build(&pool_);
   }
 
+  // Runs a random sequence of submissions, waits and shutdowns against
+  // 'pool_' and its tokens.
+  void RunFuzz();
+
   Status RebuildPoolWithScheduler(int min_threads, int max_threads, int period_ms = 100) {
     return ThreadPoolBuilder(kDefaultPoolName)
         .set_min_threads(min_threads)
@@ -953,6 +957,64 @@ TEST_P(ThreadPoolPerformanceTest, ConcurrentAndSerialTasksMix) {
           time_elapsed.wall_seconds());
 }
 
+// A scenario comparing the throughput of the classic and the work-stealing
+// pools, with many submitters running short tasks of each kind of tokens.
+TEST_F(ThreadPoolTest, WorkStealingThroughput) {
+  SKIP_IF_SLOW_NOT_ALLOWED();
+
+  constexpr auto kNumTasksPerSubmitter = 50000;
+  const auto kNumCPUs = base::NumCPUs();
+  const auto kMaxThreads = std::max(2, kNumCPUs);
+  const auto kNumSubmitters = std::max(2, kNumCPUs / 2);
+
+  for (auto mode : { ThreadPool::ExecutionMode::SERIAL,
+                     ThreadPool::ExecutionMode::CONCURRENT }) {
+    for (bool work_stealing : { false, true }) {
+      ASSERT_OK(RebuildPoolWithBuilder(ThreadPoolBuilder(kDefaultPoolName)
+                                       .set_min_threads(kMaxThreads)
+                                       .set_max_threads(kMaxThreads)
+                                       .set_work_stealing(work_stealing)));
+      atomic<int64_t> sum(0);
+      {
+        vector<unique_ptr<ThreadPoolToken>> tokens;
+        for (auto i = 0; i < kNumSubmitters; ++i) {
+          tokens.emplace_back(pool_->NewToken(mode));
+        }
+        vector<thread> threads;
+        Barrier b(kNumSubmitters + 1);
+        for (auto si = 0; si < kNumSubmitters; ++si) {
+          threads.emplace_back([&, si]() {
+            b.Wait();
+            for (auto i = 0; i < kNumTasksPerSubmitter; ++i) {
+              CHECK_OK(tokens[si]->Submit([&sum, i]() { sum += i; }));
+            }
+          });
+        }
+
+        Stopwatch sw(Stopwatch::ALL_THREADS);
+        b.Wait();
+        sw.start();
+        for (auto& t : threads) {
+          t.join();
+        }
+        pool_->Wait();
+        sw.stop();
+
+        const auto num_tasks = kNumSubmitters * kNumTasksPerSubmitter;
+        LOG(INFO) << Substitute(
+            "$0 tokens, $1 pool: $2 tasks/sec ($3)",
+            mode == ThreadPool::ExecutionMode::SERIAL ? "SERIAL" : "CONCURRENT",
+            work_stealing ? "work-stealing" : "classic",
+            static_cast<double>(num_tasks) / sw.elapsed().wall_seconds(),
+            sw.elapsed().ToString());
+      }
+      ASSERT_EQ(static_cast<int64_t>(kNumSubmitters) *
+                kNumTasksPerSubmitter * (kNumTasksPerSubmitter - 1) / 2, sum);
+      pool_->Shutdown();
+    }
+  }
+}
+
 // Test that a thread pool will crash if asked to run its own blocking
 // functions in a pool thread.
 //
@@ -1168,6 +1230,17 @@ TEST_P(ThreadPoolTestTokenTypes, TestTokenWaitForAll) {
 }
 
 TEST_F(ThreadPoolTest, TestFuzz) {
+  NO_FATALS(RunFuzz());
+}
+
+TEST_F(ThreadPoolTest, TestWorkStealingFuzz) {
+  ASSERT_OK(RebuildPoolWithBuilder(ThreadPoolBuilder(kDefaultPoolName)
+                                   .set_max_threads(4)
+                                   .set_work_stealing(true)));
+  NO_FATALS(RunFuzz());
+}
+
+void ThreadPoolTest::RunFuzz() {
   const int kNumOperations = 1000;
   Random r(SeedRandom());
   vector<unique_ptr<ThreadPoolToken>> tokens;
@@ -1246,6 +1319,90 @@ TEST_F(ThreadPoolTest, TestFuzz) {
   }
 }
 
+TEST_F(ThreadPoolTest, TestWorkStealingRejectsQueueOverloadThreshold) {
+  Status s = RebuildPoolWithBuilder(ThreadPoolBuilder(kDefaultPoolName)
+                                    .set_work_stealing(true)
+                                    .set_queue_overload_threshold(
+                                        MonoDelta::FromMilliseconds(10)));
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+}
+
+// Tasks of SERIAL tokens must run one at a time and in order even though their
+// tokens move between the queues of the worker threads.
+TEST_F(ThreadPoolTest, TestWorkStealingSerialTokens) {
+  constexpr int kNumTokens = 8;
+  constexpr int kNumSubmissions = 2000;
+  ASSERT_OK(RebuildPoolWithBuilder(ThreadPoolBuilder(kDefaultPoolName)
+                                   .set_max_threads(4)
+                                   .set_work_stealing(true)));
+  vector<unique_ptr<ThreadPoolToken>> tokens;
+  vector<vector<int>> results(kNumTokens);
+  vector<atomic<int>> running(kNumTokens);
+  for (int i = 0; i < kNumTokens; i++) {
+    tokens.emplace_back(pool_->NewToken(ThreadPool::ExecutionMode::SERIAL));
+  }
+
+  vector<thread> threads;
+  for (int t = 0; t < kNumTokens; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kNumSubmissions; i++) {
+        CHECK_OK(tokens[t]->Submit([&, t, i]() {
+          CHECK_EQ(1, ++running[t]);
+          results[t].push_back(i);
+          // Also submit tasks from within the pool, which go to the queue of
+          // the worker thread.
+          if (i % 100 == 0) {
+            CHECK_OK(pool_->Submit([](){}));
+          }
+          CHECK_EQ(0, --running[t]);
+        }));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  pool_->Wait();
+  for (int t = 0; t < kNumTokens; t++) {
+    ASSERT_EQ(kNumSubmissions, static_cast<int>(results[t].size()));
+    for (int i = 0; i < kNumSubmissions; i++) {
+      ASSERT_EQ(i, results[t][i]);
+    }
+  }
+}
+
+TEST_P(ThreadPoolTestTokenTypes, TestWorkStealingTokenShutdown) {
+  ASSERT_OK(RebuildPoolWithBuilder(ThreadPoolBuilder(kDefaultPoolName)
+                                   .set_max_threads(4)
+                                   .set_work_stealing(true)));
+  alarm(60);
+  SCOPED_CLEANUP({
+      alarm(0); // Disable alarm on test exit.
+  });
+
+  for (int iter = 0; iter < 100; iter++) {
+    unique_ptr<ThreadPoolToken> t1(pool_->NewToken(GetParam()));
+    unique_ptr<ThreadPoolToken> t2(pool_->NewToken(GetParam()));
+    CountDownLatch l2(1);
+    atomic<int> ran(0);
+    for (int i = 0; i < 10; i++) {
+      ASSERT_OK(t1->Submit([&]() { ran++; }));
+      ASSERT_OK(t2->Submit([&]() { l2.Wait(); }));
+    }
+
+    // Some of t1's tasks may be dropped, but none may run once it's shut down.
+    t1->Shutdown();
+    int ran_at_shutdown = ran;
+    ASSERT_TRUE(t1->Submit([](){}).IsServiceUnavailable());
+    ASSERT_OK(t2->Submit([](){}));
+    t1.reset();
+    ASSERT_EQ(ran_at_shutdown, ran);
+
+    l2.CountDown();
+    t2->Wait();
+  }
+}
+
 TEST_P(ThreadPoolTestTokenTypes, TestTokenSubmissionsAdhereToMaxQueueSize) {
   ASSERT_OK(RebuildPoolWithBuilder(ThreadPoolBuilder(kDefaultPoolName)
                                    .set_min_threads(1)
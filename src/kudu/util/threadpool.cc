@@ -103,6 +103,11 @@ ThreadPoolBuilder& ThreadPoolBuilder::set_schedule_period_ms(uint32_t schedule_p
   return *this;
 }
 
+ThreadPoolBuilder& ThreadPoolBuilder::set_work_stealing(bool work_stealing) {
+  work_stealing_ = work_stealing;
+  return *this;
+}
+
 ThreadPoolBuilder& ThreadPoolBuilder::set_queue_overload_threshold(
     const MonoDelta& threshold) {
   queue_overload_threshold_ = threshold;
@@ -110,6 +115,11 @@ ThreadPoolBuilder& ThreadPoolBuilder::set_queue_overload_threshold(
 }
 
 Status ThreadPoolBuilder::Build(unique_ptr<ThreadPool>* pool) const {
+  if (work_stealing_ && queue_overload_threshold_.Initialized() &&
+      queue_overload_threshold_.ToNanoseconds() > 0) {
+    return Status::InvalidArgument(
+        "queue overload threshold is not supported by work-stealing thread pools");
+  }
   pool->reset(new ThreadPool(*this));
   return (*pool)->Init();
 }
@@ -186,7 +196,8 @@ ThreadPoolToken::ThreadPoolToken(ThreadPool* pool,
       pool_(pool),
       state_(State::IDLE),
       not_running_cond_(&pool->lock_),
-      active_threads_(0) {
+      active_threads_(0),
+      ws_refs_(0) {
 }
 
 ThreadPoolToken::~ThreadPoolToken() {
@@ -199,6 +210,10 @@ Status ThreadPoolToken::Submit(std::function<void()> f) {
 }
 
 void ThreadPoolToken::Shutdown() {
+  if (pool_->work_stealing_) {
+    ShutdownWorkStealing();
+    return;
+  }
   std::unique_lock lock(pool_->lock_);
   pool_->CheckNotPoolThreadUnlocked();
 
@@ -207,7 +222,7 @@ void ThreadPoolToken::Shutdown() {
   // the ThreadPool. The task's destructors may acquire locks, etc, so this
   // also prevents lock inversions.
   std::deque<ThreadPool::Task> to_release = std::move(entries_);
-  pool_->total_queued_tasks_ -= to_release.size();
+  pool_->total_queued_tasks_ -= static_cast<int>(to_release.size());
 
   switch (state()) {
     case State::IDLE:
@@ -258,6 +273,49 @@ void ThreadPoolToken::Shutdown() {
   }
 }
 
+void ThreadPoolToken::ShutdownWorkStealing() {
+  std::unique_lock lock(pool_->lock_);
+  pool_->CheckNotPoolThreadUnlocked();
+
+  std::deque<ThreadPool::Task> to_release;
+  {
+    std::lock_guard l(ws_lock_);
+    to_release = std::move(entries_);
+    pool_->total_queued_tasks_ -= static_cast<int>(to_release.size());
+    ws_refs_ -= pool_->RemoveFromWorkerQueues(this);
+    switch (state()) {
+      case State::IDLE:
+        Transition(State::QUIESCED);
+        break;
+      case State::RUNNING:
+        Transition(active_threads_ == 0 ? State::QUIESCED : State::QUIESCING);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Besides waiting for the running tasks, wait for the worker threads which
+  // popped references to the token before they were removed above to drop
+  // them: the token may be destroyed once this returns.
+  while (true) {
+    {
+      std::lock_guard l(ws_lock_);
+      if (state() == State::QUIESCED && ws_refs_ == 0) {
+        break;
+      }
+    }
+    not_running_cond_.Wait();
+  }
+
+  lock.unlock();
+  for (auto& t : to_release) {
+    if (t.trace) {
+      t.trace->Release();
+    }
+  }
+}
+
 // Submit a task, running after delay_ms delay some time
 Status ThreadPoolToken::Schedule(std::function<void()> f, int64_t delay_ms) {
   CHECK(mode() == ThreadPool::ExecutionMode::SERIAL);
@@ -269,7 +327,7 @@ Status ThreadPoolToken::Schedule(std::function<void()> f, int64_t delay_ms) {
 void ThreadPoolToken::Wait() {
   std::lock_guard unique_lock(pool_->lock_);
   pool_->CheckNotPoolThreadUnlocked();
-  while (IsActive()) {
+  while (IsActiveSynchronized()) {
     not_running_cond_.Wait();
   }
 }
@@ -277,7 +335,7 @@ void ThreadPoolToken::Wait() {
 bool ThreadPoolToken::WaitUntil(const MonoTime& until) {
   std::lock_guard unique_lock(pool_->lock_);
   pool_->CheckNotPoolThreadUnlocked();
-  while (IsActive()) {
+  while (IsActiveSynchronized()) {
     if (!not_running_cond_.WaitUntil(until)) {
       return false;
     }
@@ -354,7 +412,8 @@ const char* ThreadPoolToken::StateToString(State s) {
 
 ThreadPool::ThreadPool(const ThreadPoolBuilder& builder)
     : name_(builder.name_),
-      min_threads_(builder.min_threads_),
+      // The threads of work-stealing pools are all permanent.
+      min_threads_(builder.work_stealing_ ? builder.max_threads_ : builder.min_threads_),
       max_threads_(builder.max_threads_),
       max_queue_size_(builder.max_queue_size_),
       idle_timeout_(builder.idle_timeout_),
@@ -365,6 +424,11 @@ ThreadPool::ThreadPool(const ThreadPoolBuilder& builder)
       num_threads_pending_start_(0),
       active_threads_(0),
       total_queued_tasks_(0),
+      work_stealing_(builder.work_stealing_),
+      num_worker_queues_claimed_(0),
+      next_worker_queue_(0),
+      num_idle_threads_(0),
+      accepting_tasks_(false),
       tokenless_(NewToken(ExecutionMode::CONCURRENT)),
       metrics_(builder.metrics_),
       scheduler_(nullptr),
@@ -380,6 +444,13 @@ ThreadPool::ThreadPool(const ThreadPoolBuilder& builder)
   run_cpu_time_trace_metric_name_ = TraceMetrics::InternName(
       prefix + ".run_cpu_time_us");
 
+  if (work_stealing_) {
+    worker_queues_.reserve(max_threads_);
+    for (int i = 0; i < max_threads_; ++i) {
+      worker_queues_.emplace_back(new WorkerQueue);
+    }
+  }
+
   const auto& ovt = builder.queue_overload_threshold_;
   if (ovt.Initialized() && ovt.ToNanoseconds() > 0) {
     load_meter_.reset(new QueueLoadMeter(*this, ovt, max_threads_));
@@ -399,6 +470,7 @@ Status ThreadPool::Init() {
     return Status::NotSupported("The thread pool is already initialized");
   }
   pool_status_ = Status::OK();
+  accepting_tasks_ = true;
   num_threads_pending_start_ = min_threads_;
   for (int i = 0; i < min_threads_; i++) {
     Status status = CreateThread();
@@ -430,14 +502,28 @@ void ThreadPool::Shutdown() {
   // concern though because shutting down a pool typically requires clients to
   // be quiesced first, so there's no danger of a client getting confused.
   pool_status_ = Status::ServiceUnavailable("The pool has been shut down.");
+  accepting_tasks_ = false;
 
   // Clear the various queues under the lock, but defer the releasing
   // of the tasks outside the lock, in case there are concurrent threads
   // wanting to access the ThreadPool. The task's destructors may acquire
   // locks, etc, so this also prevents lock inversions.
   queue_.clear();
+  vector<ThreadPoolToken*> worker_queued_tokens;
+  for (auto& q : worker_queues_) {
+    std::lock_guard l(q->lock);
+    worker_queued_tokens.insert(worker_queued_tokens.end(), q->tokens.begin(), q->tokens.end());
+    q->tokens.clear();
+  }
+  for (auto* t : worker_queued_tokens) {
+    std::lock_guard l(t->ws_lock_);
+    --t->ws_refs_;
+  }
   std::deque<std::deque<Task>> to_release;
   for (auto* t : tokens_) {
+    // Only needed by work-stealing pools, whose threads access the tokens
+    // without lock_.
+    std::lock_guard l(t->ws_lock_);
     if (!t->entries_.empty()) {
       to_release.emplace_back(std::move(t->entries_));
     }
@@ -516,7 +602,7 @@ bool ThreadPool::QueueOverloaded(MonoDelta* overloaded_time,
 
 void ThreadPool::ReleaseToken(ThreadPoolToken* t) {
   std::lock_guard guard(lock_);
-  CHECK(!t->IsActive()) << Substitute("Token with state $0 may not be released",
+  CHECK(!t->IsActiveSynchronized()) << Substitute("Token with state $0 may not be released",
                                       ThreadPoolToken::StateToString(t->state()));
   CHECK_EQ(1, tokens_.erase(t));
 }
@@ -538,6 +624,9 @@ Status ThreadPool::Schedule(ThreadPoolToken* token,
 
 Status ThreadPool::DoSubmit(std::function<void()> f, ThreadPoolToken* token) {
   DCHECK(token);
+  if (work_stealing_) {
+    return DoSubmitWorkStealing(std::move(f), token);
+  }
   const MonoTime submit_time = MonoTime::Now();
 
   std::unique_lock guard(lock_);
@@ -556,7 +645,7 @@ Status ThreadPool::DoSubmit(std::function<void()> f, ThreadPoolToken* token) {
     return Status::ServiceUnavailable(
         Substitute("Thread pool is at capacity ($0/$1 tasks running, $2/$3 tasks queued)",
                    num_threads_ + num_threads_pending_start_, max_threads_,
-                   total_queued_tasks_, max_queue_size_));
+                   total_queued_tasks_.load(), max_queue_size_));
   }
 
   // Should we create another thread?
@@ -751,49 +840,7 @@ void ThreadPool::DispatchThread() {
     NotifyLoadMeterUnlocked(queue_time);
 
     lock.unlock();
-
-    // Release the reference which was held by the queued item.
-    ADOPT_TRACE(task.trace);
-    if (task.trace) {
-      task.trace->Release();
-    }
-
-    // Update metrics.
-    const int64_t queue_time_us = queue_time.ToMicroseconds();
-    TRACE_COUNTER_INCREMENT(queue_time_trace_metric_name_, queue_time_us);
-    if (metrics_.queue_time_us_histogram) {
-      metrics_.queue_time_us_histogram->Increment(queue_time_us);
-    }
-    if (token->metrics_.queue_time_us_histogram) {
-      token->metrics_.queue_time_us_histogram->Increment(queue_time_us);
-    }
-
-    // Execute the task
-    {
-      MicrosecondsInt64 start_wall_us = GetMonoTimeMicros();
-      MicrosecondsInt64 start_cpu_us = GetThreadCpuTimeMicros();
-
-      task.func();
-
-      int64_t wall_us = GetMonoTimeMicros() - start_wall_us;
-      int64_t cpu_us = GetThreadCpuTimeMicros() - start_cpu_us;
-
-      if (metrics_.run_time_us_histogram) {
-        metrics_.run_time_us_histogram->Increment(wall_us);
-      }
-      if (token->metrics_.run_time_us_histogram) {
-        token->metrics_.run_time_us_histogram->Increment(wall_us);
-      }
-      TRACE_COUNTER_INCREMENT(run_wall_time_trace_metric_name_, wall_us);
-      TRACE_COUNTER_INCREMENT(run_cpu_time_trace_metric_name_, cpu_us);
-    }
-    // Destruct the task while we do not hold the lock.
-    //
-    // The task's destructor may be expensive if it has a lot of bound
-    // objects, and we don't want to block submission of the threadpool.
-    // In the worst case, the destructor might even try to do something
-    // with this threadpool, and produce a deadlock.
-    task.func = nullptr;
+    RunTask(token, &task, queue_time);
     lock.lock();
 
     // Possible states:
@@ -840,13 +887,346 @@ void ThreadPool::DispatchThread() {
     // Sanity check: if we're the last thread exiting, the queue ought to be
     // empty. Otherwise it will never get processed.
     CHECK(queue_.empty());
-    DCHECK_EQ(0, total_queued_tasks_);
+    DCHECK_EQ(0, total_queued_tasks_.load());
+  }
+}
+
+void ThreadPool::RunTask(ThreadPoolToken* token, Task* task, const MonoDelta& queue_time) {
+  // Release the reference which was held by the queued item.
+  ADOPT_TRACE(task->trace);
+  if (task->trace) {
+    task->trace->Release();
+  }
+
+  // Update metrics.
+  const int64_t queue_time_us = queue_time.ToMicroseconds();
+  TRACE_COUNTER_INCREMENT(queue_time_trace_metric_name_, queue_time_us);
+  if (metrics_.queue_time_us_histogram) {
+    metrics_.queue_time_us_histogram->Increment(queue_time_us);
+  }
+  if (token->metrics_.queue_time_us_histogram) {
+    token->metrics_.queue_time_us_histogram->Increment(queue_time_us);
+  }
+
+  // Execute the task
+  {
+    MicrosecondsInt64 start_wall_us = GetMonoTimeMicros();
+    MicrosecondsInt64 start_cpu_us = GetThreadCpuTimeMicros();
+
+    task->func();
+
+    int64_t wall_us = GetMonoTimeMicros() - start_wall_us;
+    int64_t cpu_us = GetThreadCpuTimeMicros() - start_cpu_us;
+
+    if (metrics_.run_time_us_histogram) {
+      metrics_.run_time_us_histogram->Increment(wall_us);
+    }
+    if (token->metrics_.run_time_us_histogram) {
+      token->metrics_.run_time_us_histogram->Increment(wall_us);
+    }
+    TRACE_COUNTER_INCREMENT(run_wall_time_trace_metric_name_, wall_us);
+    TRACE_COUNTER_INCREMENT(run_cpu_time_trace_metric_name_, cpu_us);
+  }
+  // Destruct the task while we do not hold the lock.
+  //
+  // The task's destructor may be expensive if it has a lot of bound
+  // objects, and we don't want to block submission of the threadpool.
+  // In the worst case, the destructor might even try to do something
+  // with this threadpool, and produce a deadlock.
+  task->func = nullptr;
+}
+
+////////////////////////////////////////////////////////
+// ThreadPool (work stealing)
+////////////////////////////////////////////////////////
+
+namespace {
+
+// The work-stealing pool the current thread belongs to, if any, and the index
+// of its worker queue.
+__thread ThreadPool* tls_work_stealing_pool = nullptr;
+__thread size_t tls_worker_queue_idx = 0;
+
+} // anonymous namespace
+
+Status ThreadPool::DoSubmitWorkStealing(std::function<void()> f, ThreadPoolToken* token) {
+  const MonoTime submit_time = MonoTime::Now();
+  if (PREDICT_FALSE(!accepting_tasks_)) {
+    return Status::ServiceUnavailable("The pool has been shut down.");
+  }
+
+  // Size limit check. The counters are read without synchronization, so the
+  // limit is approximate under concurrent submissions.
+  int64_t capacity_remaining = static_cast<int64_t>(max_threads_) - active_threads_ +
+                               static_cast<int64_t>(max_queue_size_) - total_queued_tasks_;
+  if (capacity_remaining < 1) {
+    return Status::ServiceUnavailable(
+        Substitute("Thread pool is at capacity ($0/$1 tasks running, $2/$3 tasks queued)",
+                   active_threads_.load(), max_threads_,
+                   total_queued_tasks_.load(), max_queue_size_));
+  }
+
+  bool push_token = false;
+  int length_at_submit;
+  {
+    std::lock_guard l(token->ws_lock_);
+    if (PREDICT_FALSE(!token->MaySubmitNewTasks())) {
+      return Status::ServiceUnavailable("Thread pool token was shut down");
+    }
+
+    Task task;
+    task.func = std::move(f);
+    task.trace = Trace::CurrentTrace();
+    if (task.trace) {
+      task.trace->AddRef();
+    }
+    task.submit_time = submit_time;
+
+    // Like in DoSubmit(), a SERIAL token with queued or running tasks is
+    // already referenced, either by a worker queue or by the worker thread
+    // running its task, which pushes it back once done.
+    ThreadPoolToken::State state = token->state();
+    token->entries_.emplace_back(std::move(task));
+    if (state == ThreadPoolToken::State::IDLE ||
+        token->mode() == ExecutionMode::CONCURRENT) {
+      ++token->ws_refs_;
+      push_token = true;
+      if (state == ThreadPoolToken::State::IDLE) {
+        token->Transition(ThreadPoolToken::State::RUNNING);
+      }
+    }
+    length_at_submit = total_queued_tasks_++;
+
+    // See DoSubmit() regarding updating this under the token's lock.
+    if (token->metrics_.queue_length_histogram) {
+      token->metrics_.queue_length_histogram->Increment(length_at_submit);
+    }
+  }
+
+  if (push_token) {
+    PushTokenWorkStealing(token);
+  }
+  if (metrics_.queue_length_histogram) {
+    metrics_.queue_length_histogram->Increment(length_at_submit);
+  }
+  return Status::OK();
+}
+
+void ThreadPool::PushTokenWorkStealing(ThreadPoolToken* token) {
+  const size_t idx = tls_work_stealing_pool == this ?
+      tls_worker_queue_idx :
+      next_worker_queue_.fetch_add(1, std::memory_order_relaxed) % worker_queues_.size();
+  {
+    WorkerQueue* q = worker_queues_[idx].get();
+    std::lock_guard l(q->lock);
+    q->tokens.push_back(token);
+  }
+
+  // Pairs with the fence in DispatchThreadWorkStealing(): either the thread
+  // going idle sees the token in the queue, or this sees the thread idle.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_idle_threads_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard l(lock_);
+    if (!idle_threads_.empty()) {
+      idle_threads_.front().not_empty.Signal();
+      idle_threads_.pop_front();
+    }
+  }
+}
+
+ThreadPoolToken* ThreadPool::PopTokenWorkStealing(size_t idx) {
+  {
+    WorkerQueue* q = worker_queues_[idx].get();
+    std::lock_guard l(q->lock);
+    if (!q->tokens.empty()) {
+      ThreadPoolToken* token = q->tokens.front();
+      q->tokens.pop_front();
+      return token;
+    }
+  }
+  const size_t num_queues = worker_queues_.size();
+  for (size_t i = 1; i < num_queues; ++i) {
+    WorkerQueue* q = worker_queues_[(idx + i) % num_queues].get();
+    std::lock_guard l(q->lock);
+    if (!q->tokens.empty()) {
+      ThreadPoolToken* token = q->tokens.back();
+      q->tokens.pop_back();
+      return token;
+    }
+  }
+  return nullptr;
+}
+
+bool ThreadPool::HasQueuedTokensWorkStealing() {
+  for (auto& q : worker_queues_) {
+    std::lock_guard l(q->lock);
+    if (!q->tokens.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int ThreadPool::RemoveFromWorkerQueues(ThreadPoolToken* t) {
+  int removed = 0;
+  for (auto& q : worker_queues_) {
+    std::lock_guard l(q->lock);
+    for (auto it = q->tokens.begin(); it != q->tokens.end();) {
+      if (*it == t) {
+        it = q->tokens.erase(it);
+        ++removed;
+      } else {
+        ++it;
+      }
+    }
+  }
+  return removed;
+}
+
+bool ThreadPool::DequeueTaskWorkStealing(ThreadPoolToken* token, Task* task) {
+  std::unique_lock l(token->ws_lock_);
+  if (PREDICT_FALSE(!token->MaySubmitNewTasks())) {
+    // The token was shut down after the reference was popped, and its
+    // tasks were dropped. If this is its last reference, ShutdownWorkStealing()
+    // may be waiting for it to be dropped, which requires lock_ to notify.
+    DCHECK(token->entries_.empty());
+    if (token->ws_refs_ == 1) {
+      l.unlock();
+      std::lock_guard pool_lock(lock_);
+      l.lock();
+      --token->ws_refs_;
+      token->not_running_cond_.Broadcast();
+    } else {
+      --token->ws_refs_;
+    }
+    return false;
+  }
+  --token->ws_refs_;
+  DCHECK_EQ(ThreadPoolToken::State::RUNNING, token->state());
+  DCHECK(!token->entries_.empty());
+  *task = std::move(token->entries_.front());
+  token->entries_.pop_front();
+  token->active_threads_++;
+  ++active_threads_;
+  --total_queued_tasks_;
+  return true;
+}
+
+void ThreadPool::FinishTaskWorkStealing(ThreadPoolToken* token) {
+  bool push_token = false;
+  {
+    std::unique_lock l(token->ws_lock_);
+    // In the common cases, the token stays RUNNING and only its lock is
+    // needed. Otherwise, it transitions the same way as in DispatchThread(),
+    // which requires lock_ too: the active thread count is only decremented
+    // then, so that the token isn't quiesced and destroyed in the meantime.
+    if (token->active_threads_ == 1 &&
+        (token->state() != ThreadPoolToken::State::RUNNING || token->entries_.empty())) {
+      l.unlock();
+      std::lock_guard pool_lock(lock_);
+      l.lock();
+      ThreadPoolToken::State state = token->state();
+      DCHECK(state == ThreadPoolToken::State::RUNNING ||
+             state == ThreadPoolToken::State::QUIESCING);
+      if (--token->active_threads_ == 0) {
+        if (state == ThreadPoolToken::State::QUIESCING) {
+          DCHECK(token->entries_.empty());
+          token->Transition(ThreadPoolToken::State::QUIESCED);
+        } else if (token->entries_.empty()) {
+          token->Transition(ThreadPoolToken::State::IDLE);
+        } else if (token->mode() == ExecutionMode::SERIAL) {
+          ++token->ws_refs_;
+          push_token = true;
+        }
+      }
+    } else if (--token->active_threads_ == 0 &&
+               token->mode() == ExecutionMode::SERIAL) {
+      // The token is RUNNING and has more tasks.
+      ++token->ws_refs_;
+      push_token = true;
+    }
+  }
+  // The token may have been destroyed by now, unless it was pushed back.
+  if (push_token) {
+    PushTokenWorkStealing(token);
+  }
+
+  if (--active_threads_ == 0 && total_queued_tasks_ == 0) {
+    std::lock_guard l(lock_);
+    idle_cond_.Broadcast();
+  }
+}
+
+void ThreadPool::DispatchThreadWorkStealing() {
+  size_t idx;
+  {
+    std::lock_guard l(lock_);
+    InsertOrDie(&threads_, Thread::current_thread());
+    DCHECK_GT(num_threads_pending_start_, 0);
+    num_threads_++;
+    num_threads_pending_start_--;
+    idx = num_worker_queues_claimed_++;
+  }
+  CHECK_LT(idx, worker_queues_.size());
+  tls_work_stealing_pool = this;
+  tls_worker_queue_idx = idx;
+
+  // Owned by this worker thread and added/removed from idle_threads_ as needed.
+  IdleThread me(&lock_);
+
+  while (true) {
+    ThreadPoolToken* token = PopTokenWorkStealing(idx);
+    if (token == nullptr) {
+      std::lock_guard l(lock_);
+      // Note: Status::Aborted() is used to indicate normal shutdown.
+      if (!pool_status_.ok()) {
+        VLOG(2) << "DispatchThreadWorkStealing exiting: " << pool_status_.ToString();
+        break;
+      }
+      // There's no work to do, let's go idle, unless a token was pushed
+      // since the queues were checked: its submitter may not have seen this
+      // thread idle.
+      idle_threads_.push_front(me);
+      num_idle_threads_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!HasQueuedTokensWorkStealing()) {
+        me.not_empty.Wait();
+      }
+      if (me.is_linked()) {
+        idle_threads_.erase(idle_threads_.iterator_to(me));
+      }
+      num_idle_threads_.fetch_sub(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    Task task;
+    if (!DequeueTaskWorkStealing(token, &task)) {
+      continue;
+    }
+    RunTask(token, &task, MonoTime::Now() - task.submit_time);
+    FinishTaskWorkStealing(token);
+  }
+
+  std::lock_guard l(lock_);
+  tls_work_stealing_pool = nullptr;
+  CHECK_EQ(threads_.erase(Thread::current_thread()), 1);
+  num_threads_--;
+  if (num_threads_ + num_threads_pending_start_ == 0) {
+    no_threads_cond_.Broadcast();
+    DCHECK(!HasQueuedTokensWorkStealing());
+    DCHECK_EQ(0, total_queued_tasks_.load());
   }
 }
 
 Status ThreadPool::CreateThread() {
   return kudu::Thread::Create("thread pool", strings::Substitute("$0 [worker]", name_),
-                              [this]() { this->DispatchThread(); }, nullptr);
+                              [this]() {
+                                if (work_stealing_) {
+                                  this->DispatchThreadWorkStealing();
+                                } else {
+                                  this->DispatchThread();
+                                }
+                              }, nullptr);
 }
 
 void ThreadPool::CheckNotPoolThreadUnlocked() {
@@ -871,7 +1251,7 @@ void ThreadPool::NotifyLoadMeterUnlocked(const MonoDelta& queue_time) {
   }
   load_meter_->UpdateQueueInfoUnlocked(queue_time,
                                        queue_head_submit_time,
-                                       active_threads_ < max_threads_);
+                                       active_threads_.load() < max_threads_);
 }
 
 ////////////////////////////////////////////////////////
@@ -29,6 +29,7 @@
 #include <string>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/list_hook.hpp>
@@ -39,6 +40,7 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/condition_variable.h"
 #include "kudu/util/countdown_latch.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/mutex.h"
@@ -110,6 +112,15 @@ struct ThreadPoolMetrics {
 // metrics: Histograms, counters, etc. to update on various threadpool events.
 //    Default: not set.
 //
+// work_stealing: Whether each worker thread has a queue of its own, taking
+//    tasks from the queues of the other threads when it runs out of them,
+//    rather than all the threads sharing one queue under the pool's lock.
+//    This scales better to many threads running short tasks. The tasks of
+//    SERIAL tokens still run one at a time, in submission order. All
+//    'max_threads' threads are started upfront and never time out, and the
+//    queue overload threshold isn't supported.
+//    Default: false.
+//
 class ThreadPoolBuilder {
  public:
   explicit ThreadPoolBuilder(std::string name);
@@ -125,6 +136,7 @@ class ThreadPoolBuilder {
   ThreadPoolBuilder& set_metrics(ThreadPoolMetrics metrics);
   ThreadPoolBuilder& set_enable_scheduler();
   ThreadPoolBuilder& set_schedule_period_ms(uint32_t schedule_period_ms);
+  ThreadPoolBuilder& set_work_stealing(bool work_stealing);
 
   // Instantiate a new ThreadPool with the existing builder arguments.
   Status Build(std::unique_ptr<ThreadPool>* pool) const;
@@ -141,6 +153,7 @@ class ThreadPoolBuilder {
   ThreadPoolMetrics metrics_;
   bool enable_scheduler_;
   uint32_t schedule_period_ms_ = 100;
+  bool work_stealing_ = false;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadPoolBuilder);
 };
@@ -480,6 +493,13 @@ class ThreadPool {
   // Dispatcher responsible for dequeueing and executing the tasks
   void DispatchThread();
 
+  // Like DispatchThread(), for work-stealing pools.
+  void DispatchThreadWorkStealing();
+
+  // Runs 'task' of 'token' and updates the metrics, after it waited in the
+  // queue for 'queue_time'. Called without holding any lock.
+  void RunTask(ThreadPoolToken* token, Task* task, const MonoDelta& queue_time);
+
   // Create new thread.
   //
   // REQUIRES: caller has incremented 'num_threads_pending_start_' ahead of this call.
@@ -492,6 +512,38 @@ class ThreadPool {
   // Submits a task to be run via token.
   Status DoSubmit(std::function<void()> f, ThreadPoolToken* token);
 
+  // Like DoSubmit(), for work-stealing pools.
+  Status DoSubmitWorkStealing(std::function<void()> f, ThreadPoolToken* token);
+
+  // Work-stealing pools only: pushes 'token', which already accounts for
+  // the reference, to the back of the queue of the current worker thread, or
+  // of the next queue in round-robin order if called from outside the pool,
+  // and wakes up an idle thread.
+  //
+  // lock_ must not be held.
+  void PushTokenWorkStealing(ThreadPoolToken* token);
+
+  // Work-stealing pools only: pops a token from the front of the queue of
+  // worker 'idx', or steals one from the back of the queue of another
+  // worker. Returns nullptr if all the queues are empty.
+  ThreadPoolToken* PopTokenWorkStealing(size_t idx);
+
+  // Work-stealing pools only: dequeues the next task of 'token', which was
+  // just popped from a worker queue, into 'task'. Returns false if there is
+  // none, e.g. because the token was shut down.
+  bool DequeueTaskWorkStealing(ThreadPoolToken* token, Task* task);
+
+  // Work-stealing pools only: updates the state of 'token' once a worker
+  // thread finished running one of its tasks.
+  void FinishTaskWorkStealing(ThreadPoolToken* token);
+
+  // Work-stealing pools only: returns whether any worker queue is non-empty.
+  bool HasQueuedTokensWorkStealing();
+
+  // Work-stealing pools only: removes all the references to 't' from the
+  // worker queues, returning how many there were.
+  int RemoveFromWorkerQueues(ThreadPoolToken* t);
+
   // Releases token 't' and invalidates it.
   void ReleaseToken(ThreadPoolToken* t);
 
@@ -515,7 +567,7 @@ class ThreadPool {
   // Used by tests to avoid tsan test case down.
   int num_active_threads() {
     std::lock_guard l(lock_);
-    return active_threads_;
+    return active_threads_.load();
   }
 
   const std::string name_;
@@ -555,14 +607,14 @@ class ThreadPool {
 
   // Number of threads currently running and executing client tasks.
   //
-  // Protected by lock_.
-  int active_threads_;
+  // Modified under lock_, except in work-stealing pools.
+  std::atomic<int> active_threads_;
 
   // Total number of client tasks queued, either directly (queue_) or
   // indirectly (tokens_).
   //
-  // Protected by lock_.
-  int total_queued_tasks_;
+  // Modified under lock_, except in work-stealing pools.
+  std::atomic<int> total_queued_tasks_;
 
   // All allocated tokens.
   //
@@ -601,6 +653,38 @@ class ThreadPool {
   };
   boost::intrusive::list<IdleThread> idle_threads_; // NOLINT(build/include_what_you_use)
 
+  // Whether the pool was built with ThreadPoolBuilder::set_work_stealing().
+  //
+  // In work-stealing pools, the tokens with queued tasks are referenced by
+  // the worker queues rather than by queue_: a SERIAL token by at most one
+  // of them at a time, which keeps its tasks in order, a CONCURRENT token
+  // once per queued task.
+  const bool work_stealing_;
+
+  // The queue of each worker thread of a work-stealing pool. Its owner pops
+  // tokens from the front, other threads steal from the back.
+  struct WorkerQueue {
+    simple_spinlock lock;
+    std::deque<ThreadPoolToken*> tokens;
+  };
+  std::vector<std::unique_ptr<WorkerQueue>> worker_queues_;
+
+  // Number of worker queues claimed by the threads of a work-stealing pool.
+  //
+  // Protected by lock_.
+  size_t num_worker_queues_claimed_;
+
+  // The worker queue to which the next task submitted from outside a
+  // work-stealing pool is pushed, modulo the number of queues.
+  std::atomic<uint32_t> next_worker_queue_;
+
+  // Number of threads of a work-stealing pool in idle_threads_, read by
+  // submitters to skip taking lock_ when no thread needs to be woken up.
+  std::atomic<int> num_idle_threads_;
+
+  // Whether a work-stealing pool accepts new tasks, i.e. pool_status_ is OK.
+  std::atomic<bool> accepting_tasks_;
+
   // ExecutionMode::CONCURRENT token used by the pool for tokenless submission.
   std::shared_ptr<ThreadPoolToken> tokenless_;
 
@@ -633,7 +717,7 @@ class ThreadPool {
 // thread pool. Tokens can only be created via ThreadPool::NewToken().
 //
 // All functions are thread-safe. Mutable members are protected via the
-// ThreadPool's lock.
+// ThreadPool's lock, or by ws_lock_ in work-stealing pools.
 class ThreadPoolToken {
  public:
   // Destroys the token.
@@ -714,6 +798,15 @@ class ThreadPoolToken {
   // Changes this token's state to 'new_state' taking actions as needed.
   void Transition(State new_state);
 
+  // Like Shutdown(), for the tokens of work-stealing pools.
+  void ShutdownWorkStealing();
+
+  // Like IsActive(), taking ws_lock_. Requires the pool's lock.
+  bool IsActiveSynchronized() const {
+    std::lock_guard l(ws_lock_);
+    return IsActive();
+  }
+
   // Returns true if this token has a task queued and ready to run, or if a
   // task belonging to this token is already running.
   bool IsActive() const {
@@ -753,6 +846,19 @@ class ThreadPoolToken {
   // token.
   int active_threads_;
 
+  // In work-stealing pools, protects state_, entries_, active_threads_ and
+  // ws_refs_, which the worker threads access without the pool's lock.
+  // Transitions to IDLE and QUIESCED, which waiters on not_running_cond_
+  // wait for, additionally require the pool's lock.
+  //
+  // Acquired after the pool's lock and before the locks of worker queues.
+  mutable simple_spinlock ws_lock_;
+
+  // In work-stealing pools, the number of references to this token which
+  // are in the worker queues or being processed by a worker thread which
+  // popped them. The token may not be destroyed until there are none.
+  int ws_refs_;
+
   DISALLOW_COPY_AND_ASSIGN(ThreadPoolToken);
 };
 
@@ -73,4 +73,45 @@ TEST_F(ThrottlerTest, TestBurst) {
   ASSERT_FALSE(t0.Take(now, 1, 1));
 }
 
+TEST_F(ThrottlerTest, TestTakeBytes) {
+  MonoTime now = MonoTime::Now();
+  Throttler t0(now, 0, 1000*1000, 1);
+  // Fill up bucket
+  now += MonoDelta::FromMilliseconds(2000);
+  // An IO larger than the burst rate is let through piece by piece.
+  ASSERT_FALSE(t0.Take(now, 0, 500*1000));
+  ASSERT_EQ(100*1000, t0.TakeBytes(now, 500*1000));
+  ASSERT_EQ(0, t0.TakeBytes(now, 1));
+  now += MonoDelta::FromMilliseconds(100);
+  ASSERT_EQ(1000, t0.TakeBytes(now, 1000));
+  ASSERT_EQ(99*1000, t0.TakeBytes(now, 500*1000));
+
+  // Without IO throttling, everything is let through.
+  Throttler t1(now, 0, 0, 1);
+  ASSERT_EQ(500*1000, t1.TakeBytes(now, 500*1000));
+}
+
+TEST_F(ThrottlerTest, TestSetRate) {
+  MonoTime now = MonoTime::Now();
+  Throttler t0(now, 0, 1000*1000, 2);
+  // Fill up bucket
+  now += MonoDelta::FromMilliseconds(2000);
+
+  // Lowering the rate drops the tokens above the new burst rate.
+  t0.SetRate(0, 100*1000);
+  ASSERT_EQ(20*1000, t0.TakeBytes(now, 1000*1000));
+  now += MonoDelta::FromMilliseconds(100);
+  ASSERT_EQ(10*1000, t0.TakeBytes(now, 1000*1000));
+
+  // Raising the rate takes effect with the next refill.
+  t0.SetRate(0, 1000*1000);
+  ASSERT_EQ(0, t0.TakeBytes(now, 1000*1000));
+  now += MonoDelta::FromMilliseconds(100);
+  ASSERT_EQ(100*1000, t0.TakeBytes(now, 1000*1000));
+
+  // Disabling throttling lets everything through.
+  t0.SetRate(0, 0);
+  ASSERT_TRUE(t0.Take(now, 1, 1000*1000*1000));
+}
+
 } // namespace kudu
@@ -23,20 +23,18 @@
 namespace kudu {
 
 Throttler::Throttler(MonoTime now, uint64_t op_rate, uint64_t byte_rate, double burst_factor) :
-    next_refill_(now) {
-  op_refill_ = op_rate / (MonoTime::kMicrosecondsPerSecond / kRefillPeriodMicros);
-  op_token_ = 0;
-  op_token_max_ = static_cast<uint64_t>(op_refill_ * burst_factor);
-  byte_refill_ = byte_rate / (MonoTime::kMicrosecondsPerSecond / kRefillPeriodMicros);
-  byte_token_ = 0;
-  byte_token_max_ = static_cast<uint64_t>(byte_refill_ * burst_factor);
+    burst_factor_(burst_factor),
+    next_refill_(now),
+    op_token_(0),
+    byte_token_(0) {
+  SetRateUnlocked(op_rate, byte_rate);
 }
 
 bool Throttler::Take(MonoTime now, uint64_t op, uint64_t byte) {
+  std::lock_guard<simple_spinlock> lock(lock_);
   if (op_refill_ == 0 && byte_refill_ == 0) {
     return true;
   }
-  std::lock_guard<simple_spinlock> lock(lock_);
   Refill(now);
   if ((op_refill_ == 0 || op <= op_token_) &&
       (byte_refill_ == 0 || byte <= byte_token_)) {
@@ -51,6 +49,31 @@ bool Throttler::Take(MonoTime now, uint64_t op, uint64_t byte) {
   return false;
 }
 
+uint64_t Throttler::TakeBytes(MonoTime now, uint64_t max_byte) {
+  std::lock_guard<simple_spinlock> lock(lock_);
+  if (byte_refill_ == 0) {
+    return max_byte;
+  }
+  Refill(now);
+  uint64_t taken = std::min(max_byte, byte_token_);
+  byte_token_ -= taken;
+  return taken;
+}
+
+void Throttler::SetRate(uint64_t op_rate, uint64_t byte_rate) {
+  std::lock_guard<simple_spinlock> lock(lock_);
+  SetRateUnlocked(op_rate, byte_rate);
+  op_token_ = std::min(op_token_, op_token_max_);
+  byte_token_ = std::min(byte_token_, byte_token_max_);
+}
+
+void Throttler::SetRateUnlocked(uint64_t op_rate, uint64_t byte_rate) {
+  op_refill_ = op_rate / (MonoTime::kMicrosecondsPerSecond / kRefillPeriodMicros);
+  op_token_max_ = static_cast<uint64_t>(op_refill_ * burst_factor_);
+  byte_refill_ = byte_rate / (MonoTime::kMicrosecondsPerSecond / kRefillPeriodMicros);
+  byte_token_max_ = static_cast<uint64_t>(byte_refill_ * burst_factor_);
+}
+
 void Throttler::Refill(MonoTime now) {
   int64_t d = (now - next_refill_).ToMicroseconds();
   if (d < 0) {
@@ -44,9 +44,26 @@ class Throttler {
   // Return false if there are not enough tokens, and operation is throttled.
   bool Take(MonoTime now, uint64_t op, uint64_t byte);
 
+  // Take up to 'max_byte' byte tokens, but no operation tokens.
+  // Return the number of byte tokens taken, which is 0 if the IO is throttled,
+  // and 'max_byte' if IO bytes throttling is disabled. Unlike Take(), this
+  // lets operations larger than the burst rate eventually proceed, piece by
+  // piece.
+  uint64_t TakeBytes(MonoTime now, uint64_t max_byte);
+
+  // Change the max operation per second and max IO bytes per second, keeping
+  // the burst factor. The tokens above the new burst rate are dropped.
+  // Set a rate to 0 to disable the corresponding throttling.
+  void SetRate(uint64_t op_per_sec, uint64_t byte_per_sec);
+
  private:
   void Refill(MonoTime now);
 
+  // Set the refill and maximum number of tokens from the rates.
+  // Must be called with 'lock_' held, unless from the constructor.
+  void SetRateUnlocked(uint64_t op_rate, uint64_t byte_rate);
+
+  const double burst_factor_;
   MonoTime next_refill_;
   uint64_t op_refill_;
   uint64_t op_token_;
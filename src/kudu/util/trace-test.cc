@@ -128,6 +128,49 @@ TEST_F(TraceTest, TestChildTrace) {
             XOutDigits(traceA->DumpToString(Trace::NO_FLAGS)));
 }
 
+TEST_F(TraceTest, TestSpans) {
+  scoped_refptr<Trace> traceA(new Trace);
+  scoped_refptr<Trace> traceB(new Trace);
+  {
+    ADOPT_TRACE(traceA.get());
+    TRACE_SPAN("outer");
+    {
+      TRACE_SPAN("inner");
+      SleepFor(MonoDelta::FromMilliseconds(1));
+    }
+    const MicrosecondsInt64 now = GetCurrentTimeMicros();
+    traceA->AddSpan("added", now - 100, now);
+    {
+      // Spans aren't nested across traces.
+      ADOPT_TRACE(traceB.get());
+      TRACE_SPAN("other");
+    }
+    {
+      ADOPT_TRACE(nullptr);
+      TRACE_SPAN("nowhere");
+    }
+  }
+
+  const auto spans = traceA->Spans();
+  ASSERT_EQ(3, spans.size());
+  ASSERT_STREQ("outer", spans[0].name);
+  ASSERT_EQ(TraceSpan::kNoParent, spans[0].parent);
+  ASSERT_STREQ("inner", spans[1].name);
+  ASSERT_EQ(0, spans[1].parent);
+  ASSERT_GE(spans[1].end_micros - spans[1].start_micros, 1000);
+  ASSERT_LE(spans[0].start_micros, spans[1].start_micros);
+  ASSERT_GE(spans[0].end_micros, spans[1].end_micros);
+  ASSERT_STREQ("added", spans[2].name);
+  ASSERT_EQ(0, spans[2].parent);
+  ASSERT_EQ(100, spans[2].end_micros - spans[2].start_micros);
+
+  const auto other_spans = traceB->Spans();
+  ASSERT_EQ(1, other_spans.size());
+  ASSERT_STREQ("other", other_spans[0].name);
+  ASSERT_EQ(TraceSpan::kNoParent, other_spans[0].parent);
+  ASSERT_GT(other_spans[0].end_micros, 0);
+}
+
 static void GenerateTraceEvents(int thread_id,
                                 int num_events) {
   for (int i = 0; i < num_events; i++) {
@@ -17,6 +17,7 @@
 
 #include "kudu/util/trace.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iomanip>
@@ -43,6 +44,16 @@ using strings::internal::SubstituteArg;
 namespace kudu {
 
 __thread Trace* Trace::threadlocal_trace_;
+__thread const Trace* Trace::threadlocal_span_trace_;
+__thread int Trace::threadlocal_span_ = TraceSpan::kNoParent;
+
+namespace {
+
+// The maximum number of spans of a trace, so that a long-running request
+// adding spans in a loop doesn't grow its trace without bounds.
+const size_t kMaxSpans = 256;
+
+} // anonymous namespace
 
 Trace::Trace()
     : arena_(new ThreadSafeArena(1024)),
@@ -251,6 +262,48 @@ void Trace::AddChildTrace(StringPiece label, Trace* child_trace) {
   child_traces_.emplace_back(label, ptr);
 }
 
+int Trace::CurrentSpanParent() const {
+  return threadlocal_span_trace_ == this ? threadlocal_span_ : TraceSpan::kNoParent;
+}
+
+int Trace::StartSpan(const char* name) {
+  const int parent = CurrentSpanParent();
+  const MicrosecondsInt64 now = GetCurrentTimeMicros();
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (spans_.size() >= kMaxSpans) {
+    return TraceSpan::kNoParent;
+  }
+  spans_.push_back({ name, now, 0, parent });
+  return static_cast<int>(spans_.size() - 1);
+}
+
+void Trace::EndSpan(int span_id) {
+  if (span_id == TraceSpan::kNoParent) {
+    return;
+  }
+  const MicrosecondsInt64 now = GetCurrentTimeMicros();
+  std::lock_guard<simple_spinlock> l(lock_);
+  DCHECK_LT(span_id, static_cast<int>(spans_.size()));
+  DCHECK_EQ(0, spans_[span_id].end_micros);
+  spans_[span_id].end_micros = now;
+}
+
+void Trace::AddSpan(const char* name,
+                    MicrosecondsInt64 start_micros,
+                    MicrosecondsInt64 end_micros) {
+  DCHECK_LE(start_micros, end_micros);
+  const int parent = CurrentSpanParent();
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (spans_.size() < kMaxSpans) {
+    spans_.push_back({ name, start_micros, end_micros, parent });
+  }
+}
+
+vector<TraceSpan> Trace::Spans() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return spans_;
+}
+
 std::vector<std::pair<StringPiece, scoped_refptr<Trace>>> Trace::ChildTraces() const {
   std::lock_guard<simple_spinlock> l(lock_);
   return child_traces_;
@@ -96,6 +96,21 @@ class Trace;
 #define TRACE_COUNTER_SCOPE_LATENCY_US(counter_name) \
   ::kudu::ScopedTraceLatencyCounter _scoped_latency(counter_name)
 
+// Record a span for the wall time spent in the current scope, nested under
+// the innermost span of the current trace open on this thread, if any.
+// For example:
+//
+//  Status AcquireLocks() {
+//    TRACE_SPAN("acquire_locks");
+//    ... wait for the locks
+//  }
+//
+// As for counters, the 'span_name' MUST be a string which stays alive forever.
+//
+// If no trace is active, this does nothing.
+#define TRACE_SPAN(span_name) \
+  ::kudu::ScopedTraceSpan _scoped_trace_span(span_name)
+
 // Construct a constant C string counter name which acts as a sort of
 // coarse-grained histogram for trace metrics.
 #define BUCKETED_COUNTER_NAME(prefix, duration_us)      \
@@ -117,6 +132,23 @@ class JsonWriter;
 class ThreadSafeArena;
 struct TraceEntry;
 
+// A timed stage of the request or process of a trace, e.g. waiting for a lock
+// or replicating an op. The spans of a trace form a tree.
+struct TraceSpan {
+  static constexpr int kNoParent = -1;
+
+  // The name of the span, which stays alive forever.
+  const char* name;
+
+  // The wall time at which the span started and ended, in microseconds since
+  // the epoch. 'end_micros' is 0 while the span is open.
+  MicrosecondsInt64 start_micros;
+  MicrosecondsInt64 end_micros;
+
+  // The index of the parent span among the spans of the trace, or kNoParent.
+  int parent;
+};
+
 // A trace for a request or other process. This supports collecting trace entries
 // from a number of threads, and later dumping the results to a stream.
 //
@@ -187,6 +219,25 @@ class Trace : public RefCountedThreadSafe<Trace> {
   // Return a copy of the current set of related "child" traces.
   std::vector<std::pair<StringPiece, scoped_refptr<Trace>>> ChildTraces() const;
 
+  // Opens a span named 'name' starting now, nested under the innermost span of
+  // this trace open on the current thread, if any. Returns the identifier of
+  // the span, to be passed to EndSpan(), or TraceSpan::kNoParent if the trace
+  // already holds too many spans.
+  //
+  // Callers should generally use TRACE_SPAN(...) instead.
+  int StartSpan(const char* name);
+
+  // Closes the span identified by 'span_id'.
+  void EndSpan(int span_id);
+
+  // Adds a span which already ended, e.g. for a stage which started on
+  // another thread. It's nested as if it was opened by StartSpan().
+  void AddSpan(const char* name, MicrosecondsInt64 start_micros, MicrosecondsInt64 end_micros);
+
+  // Return a copy of the spans of this trace, not including the spans of the
+  // child traces.
+  std::vector<TraceSpan> Spans() const;
+
   // Return the current trace attached to this thread, if there is one.
   static Trace* CurrentTrace() {
     return threadlocal_trace_;
@@ -206,6 +257,7 @@ class Trace : public RefCountedThreadSafe<Trace> {
 
  private:
   friend class ScopedAdoptTrace;
+  friend class ScopedTraceSpan;
   friend class RefCountedThreadSafe<Trace>;
   ~Trace();
 
@@ -214,6 +266,14 @@ class Trace : public RefCountedThreadSafe<Trace> {
   // object.
   static __thread Trace* threadlocal_trace_;
 
+  // The innermost span open on this thread, and the trace it belongs to.
+  // Managed by ScopedTraceSpan.
+  static __thread const Trace* threadlocal_span_trace_;
+  static __thread int threadlocal_span_;
+
+  // Returns the innermost span of this trace open on the current thread.
+  int CurrentSpanParent() const;
+
   // Allocate a new entry from the arena, with enough space to hold a
   // message of length 'len'.
   TraceEntry* NewEntry(int len, const char* file_path, int line_number);
@@ -234,6 +294,9 @@ class Trace : public RefCountedThreadSafe<Trace> {
 
   std::vector<std::pair<StringPiece, scoped_refptr<Trace>>> child_traces_;
 
+  // Protected by 'lock_'.
+  std::vector<TraceSpan> spans_;
+
   TraceMetrics metrics_;
 
   DISALLOW_COPY_AND_ASSIGN(Trace);
@@ -287,4 +350,35 @@ class ScopedTraceLatencyCounter {
   DISALLOW_COPY_AND_ASSIGN(ScopedTraceLatencyCounter);
 };
 
+// Implementation for TRACE_SPAN(...) macro above.
+class ScopedTraceSpan {
+ public:
+  explicit ScopedTraceSpan(const char* name)
+      : trace_(Trace::CurrentTrace()),
+        span_id_(TraceSpan::kNoParent),
+        prev_span_trace_(Trace::threadlocal_span_trace_),
+        prev_span_(Trace::threadlocal_span_) {
+    if (trace_) {
+      span_id_ = trace_->StartSpan(name);
+      Trace::threadlocal_span_trace_ = trace_.get();
+      Trace::threadlocal_span_ = span_id_;
+    }
+  }
+
+  ~ScopedTraceSpan() {
+    if (trace_) {
+      trace_->EndSpan(span_id_);
+      Trace::threadlocal_span_trace_ = prev_span_trace_;
+      Trace::threadlocal_span_ = prev_span_;
+    }
+  }
+
+ private:
+  const scoped_refptr<Trace> trace_;
+  int span_id_;
+  const Trace* const prev_span_trace_;
+  const int prev_span_;
+  DISALLOW_COPY_AND_ASSIGN(ScopedTraceSpan);
+};
+
 } // namespace kudu
@@ -347,6 +347,12 @@ fetch_and_patch \
  $LZ4_SOURCE \
  $LZ4_PATCHLEVEL
 
+ZSTD_PATCHLEVEL=0
+fetch_and_patch \
+ zstd-$ZSTD_VERSION.tar.gz \
+ $ZSTD_SOURCE \
+ $ZSTD_PATCHLEVEL
+
 BITSHUFFLE_PATCHLEVEL=0
 fetch_and_patch \
  bitshuffle-${BITSHUFFLE_VERSION}.tar.gz \